@@ -0,0 +1,374 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <darshan-runtime-config.h>
+#endif
+
+#define _XOPEN_SOURCE 500
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "darshan.h"
+#include "darshan-attrib.h"
+
+/* The attrib_record_ref structure tracks an ATTRIB record, which shares
+ * the id of the upper-layer record it attributes lower-layer I/O to.
+ */
+struct attrib_record_ref
+{
+    struct darshan_attrib_record *rec;
+};
+
+/* The attrib_runtime structure maintains necessary state for storing
+ * ATTRIB records and for coordinating with darshan-core at shutdown time.
+ */
+struct attrib_runtime
+{
+    void *rec_id_hash;
+    int rec_count;
+    int frozen; /* flag to indicate that the counters should no longer be modified */
+};
+
+static struct attrib_runtime *attrib_runtime = NULL;
+static pthread_mutex_t attrib_runtime_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int attrib_runtime_init_attempted = 0;
+static int my_rank = -1;
+
+__thread struct darshan_attrib_context darshan_attrib_ctx = {0};
+
+static void attrib_runtime_initialize(
+    void);
+static struct attrib_record_ref *attrib_track_new_record(
+    darshan_record_id rec_id, int mod_id);
+static void attrib_record_merge(
+    struct darshan_attrib_record *infile,
+    struct darshan_attrib_record *inoutfile);
+#ifdef HAVE_MPI
+static void attrib_record_reduction_op(
+    void* infile_v, void* inoutfile_v, int *len, MPI_Datatype *datatype);
+static void attrib_mpi_redux(
+    void *attrib_buf, MPI_Comm mod_comm,
+    darshan_record_id *shared_recs, int shared_rec_count);
+#endif
+static void attrib_output(
+    void **attrib_buf, int *attrib_buf_sz);
+static void attrib_cleanup(
+    void);
+
+#define ATTRIB_LOCK() pthread_mutex_lock(&attrib_runtime_mutex)
+#define ATTRIB_UNLOCK() pthread_mutex_unlock(&attrib_runtime_mutex)
+
+/**********************************************************
+ *      Hooks called by the upper-layer modules            *
+ **********************************************************/
+
+void attrib_charge(darshan_record_id rec_id)
+{
+    struct attrib_record_ref *rec_ref;
+    struct darshan_attrib_record *rec;
+    int i;
+
+    ATTRIB_LOCK();
+    if(!attrib_runtime && !attrib_runtime_init_attempted)
+        attrib_runtime_initialize();
+    if(!attrib_runtime || attrib_runtime->frozen)
+    {
+        ATTRIB_UNLOCK();
+        attrib_reset();
+        return;
+    }
+
+    rec_ref = darshan_lookup_record_ref(attrib_runtime->rec_id_hash,
+        &rec_id, sizeof(darshan_record_id));
+    if(!rec_ref)
+        rec_ref = attrib_track_new_record(rec_id, darshan_attrib_ctx.mod_id);
+    if(rec_ref)
+    {
+        rec = rec_ref->rec;
+        rec->counters[ATTRIB_CALLS] += 1;
+        for(i = ATTRIB_MPIIO_READS; i < ATTRIB_NUM_INDICES; i++)
+            rec->counters[i] += darshan_attrib_ctx.counters[i];
+        for(i = 0; i < ATTRIB_F_NUM_INDICES; i++)
+            rec->fcounters[i] += darshan_attrib_ctx.fcounters[i];
+    }
+    ATTRIB_UNLOCK();
+
+    attrib_reset();
+    return;
+}
+
+void attrib_reset()
+{
+    memset(darshan_attrib_ctx.counters, 0,
+        sizeof(darshan_attrib_ctx.counters));
+    memset(darshan_attrib_ctx.fcounters, 0,
+        sizeof(darshan_attrib_ctx.fcounters));
+    darshan_attrib_ctx.dirty = 0;
+
+    return;
+}
+
+/**********************************************************
+ * Internal functions for manipulating ATTRIB module state *
+ **********************************************************/
+
+/* registers the ATTRIB module with darshan-core the first time lower-layer
+ * I/O is charged; must be called with the ATTRIB lock held
+ */
+static void attrib_runtime_initialize()
+{
+    int ret;
+    size_t attrib_rec_count;
+    darshan_module_funcs mod_funcs = {
+#ifdef HAVE_MPI
+    .mod_redux_func = &attrib_mpi_redux,
+#endif
+    .mod_output_func = &attrib_output,
+    .mod_cleanup_func = &attrib_cleanup
+    };
+
+    attrib_runtime_init_attempted = 1;
+
+    attrib_rec_count = DARSHAN_DEF_MOD_REC_COUNT;
+
+    /* register the ATTRIB module with darshan core */
+    ret = darshan_core_register_module(
+        DARSHAN_ATTRIB_MOD,
+        mod_funcs,
+        sizeof(struct darshan_attrib_record),
+        &attrib_rec_count,
+        &my_rank,
+        NULL);
+    if(ret < 0)
+        return;
+
+    attrib_runtime = malloc(sizeof(*attrib_runtime));
+    if(!attrib_runtime)
+    {
+        darshan_core_unregister_module(DARSHAN_ATTRIB_MOD);
+        return;
+    }
+    memset(attrib_runtime, 0, sizeof(*attrib_runtime));
+
+    return;
+}
+
+static struct attrib_record_ref *attrib_track_new_record(
+    darshan_record_id rec_id, int mod_id)
+{
+    struct darshan_attrib_record *record_p = NULL;
+    struct attrib_record_ref *rec_ref = NULL;
+    int ret;
+
+    rec_ref = malloc(sizeof(*rec_ref));
+    if(!rec_ref)
+        return(NULL);
+    memset(rec_ref, 0, sizeof(*rec_ref));
+
+    /* add a reference to this record */
+    ret = darshan_add_record_ref(&(attrib_runtime->rec_id_hash), &rec_id,
+        sizeof(darshan_record_id), rec_ref);
+    if(ret == 0)
+    {
+        free(rec_ref);
+        return(NULL);
+    }
+
+    /* register the actual record with darshan-core so it is persisted in
+     * the log file; the upper-layer record already registered its name
+     */
+    record_p = darshan_core_register_record(
+        rec_id,
+        NULL,
+        DARSHAN_ATTRIB_MOD,
+        sizeof(struct darshan_attrib_record),
+        NULL);
+
+    if(!record_p)
+    {
+        darshan_delete_record_ref(&(attrib_runtime->rec_id_hash),
+            &rec_id, sizeof(darshan_record_id));
+        free(rec_ref);
+        return(NULL);
+    }
+
+    /* registering this record was successful, so initialize some fields */
+    record_p->base_rec.id = rec_id;
+    record_p->base_rec.rank = my_rank;
+    record_p->counters[ATTRIB_UPPER_MODULE] = mod_id;
+    rec_ref->rec = record_p;
+    attrib_runtime->rec_count++;
+
+    return(rec_ref);
+}
+
+/* combine the counters of 'infile' into 'inoutfile' */
+static void attrib_record_merge(struct darshan_attrib_record *infile,
+    struct darshan_attrib_record *inoutfile)
+{
+    int i;
+
+    for(i = ATTRIB_CALLS; i < ATTRIB_NUM_INDICES; i++)
+        inoutfile->counters[i] += infile->counters[i];
+    for(i = 0; i < ATTRIB_F_NUM_INDICES; i++)
+        inoutfile->fcounters[i] += infile->fcounters[i];
+
+    return;
+}
+
+#ifdef HAVE_MPI
+static void attrib_record_reduction_op(void* infile_v, void* inoutfile_v,
+    int *len, MPI_Datatype *datatype)
+{
+    struct darshan_attrib_record *infile = infile_v;
+    struct darshan_attrib_record *inoutfile = inoutfile_v;
+    int i;
+
+    for(i=0; i<*len; i++)
+    {
+        attrib_record_merge(infile, inoutfile);
+        inoutfile->base_rec.rank = -1;
+        infile++;
+        inoutfile++;
+    }
+
+    return;
+}
+#endif
+
+/********************************************************************************
+ * Functions exported by this module for coordinating with darshan-core *
+ ********************************************************************************/
+
+#ifdef HAVE_MPI
+static void attrib_mpi_redux(
+    void *attrib_buf,
+    MPI_Comm mod_comm,
+    darshan_record_id *shared_recs,
+    int shared_rec_count)
+{
+    int attrib_rec_count;
+    struct attrib_record_ref *rec_ref;
+    struct darshan_attrib_record *attrib_rec_buf =
+        (struct darshan_attrib_record *)attrib_buf;
+    struct darshan_attrib_record *red_send_buf = NULL;
+    struct darshan_attrib_record *red_recv_buf = NULL;
+    int ret;
+    int i;
+
+    ATTRIB_LOCK();
+    assert(attrib_runtime);
+
+    attrib_runtime->frozen = 1;
+    attrib_rec_count = attrib_runtime->rec_count;
+
+    /* necessary initialization of shared records */
+    for(i = 0; i < shared_rec_count; i++)
+    {
+        rec_ref = darshan_lookup_record_ref(attrib_runtime->rec_id_hash,
+            &shared_recs[i], sizeof(darshan_record_id));
+        assert(rec_ref);
+
+        rec_ref->rec->base_rec.rank = -1;
+    }
+
+    /* sort the array of records descending by rank so that we get all of
+     * the shared records (marked by rank -1) in a contiguous portion at end
+     * of the array
+     */
+    darshan_record_sort(attrib_rec_buf, attrib_rec_count,
+        sizeof(struct darshan_attrib_record));
+
+    /* make *send_buf point to the shared records at the end of sorted array */
+    red_send_buf = &(attrib_rec_buf[attrib_rec_count-shared_rec_count]);
+
+    /* allocate memory for the reduction output on rank 0 */
+    if(my_rank == 0)
+    {
+        red_recv_buf = malloc(shared_rec_count *
+            sizeof(struct darshan_attrib_record));
+        if(!red_recv_buf)
+        {
+            ATTRIB_UNLOCK();
+            return;
+        }
+    }
+
+    /* reduce shared ATTRIB records */
+    ret = darshan_shared_record_reduce(mod_comm, red_send_buf, red_recv_buf,
+        shared_rec_count, sizeof(struct darshan_attrib_record),
+        attrib_record_reduction_op, NULL, 0);
+
+    /* update module state to account for shared record reduction */
+    if(ret < 0)
+    {
+        free(red_recv_buf);
+    }
+    else if(my_rank == 0)
+    {
+        /* overwrite local shared records with globally reduced records */
+        int tmp_ndx = attrib_rec_count - shared_rec_count;
+        memcpy(&(attrib_rec_buf[tmp_ndx]), red_recv_buf,
+            shared_rec_count * sizeof(struct darshan_attrib_record));
+        free(red_recv_buf);
+    }
+    else
+    {
+        /* drop shared records on non-zero ranks */
+        attrib_runtime->rec_count -= shared_rec_count;
+    }
+
+    ATTRIB_UNLOCK();
+    return;
+}
+#endif
+
+static void attrib_output(
+    void **attrib_buf,
+    int *attrib_buf_sz)
+{
+    ATTRIB_LOCK();
+    assert(attrib_runtime);
+
+    attrib_runtime->frozen = 1;
+
+    *attrib_buf_sz = attrib_runtime->rec_count *
+        sizeof(struct darshan_attrib_record);
+
+    ATTRIB_UNLOCK();
+    return;
+}
+
+static void attrib_cleanup()
+{
+    ATTRIB_LOCK();
+    assert(attrib_runtime);
+
+    darshan_clear_record_refs(&(attrib_runtime->rec_id_hash), 1);
+
+    free(attrib_runtime);
+    attrib_runtime = NULL;
+    attrib_runtime_init_attempted = 0;
+
+    ATTRIB_UNLOCK();
+    return;
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifndef __DARSHAN_ATTRIB_H
+#define __DARSHAN_ATTRIB_H
+
+#include <stdint.h>
+
+#include "darshan-log-format.h"
+
+/* Per-thread context of the outermost instrumented upper-layer (H5D,
+ * PNETCDF_VAR, or MPI-IO) read or write call in progress.  While a call is
+ * in progress, the MPI-IO and POSIX operations it issues are accumulated
+ * here without locking, in the layout of an ATTRIB record, and the upper
+ * module charges them to its record once it knows the record id.
+ */
+struct darshan_attrib_context
+{
+    int depth;   /* nesting of upper-layer calls in progress */
+    int own_api; /* TIMESERIES_API_* of the outermost call, or -1 */
+    int mod_id;  /* module of the outermost call */
+    int dirty;   /* set once lower-layer I/O has been accumulated */
+    int64_t counters[ATTRIB_NUM_INDICES];
+    double fcounters[ATTRIB_F_NUM_INDICES];
+};
+
+extern __thread struct darshan_attrib_context darshan_attrib_ctx;
+
+/* attrib_charge()
+ *
+ * adds the lower-layer I/O accumulated in this thread's context to the
+ * ATTRIB record 'rec_id', and resets the context
+ */
+void attrib_charge(darshan_record_id rec_id);
+
+/* attrib_reset()
+ *
+ * discards the lower-layer I/O accumulated in this thread's context
+ */
+void attrib_reset(void);
+
+/* called by upper layers around the real read or write call; '__api' is
+ * the TIMESERIES_API_* of the upper layer itself, or -1 if it has none
+ */
+#define DARSHAN_ATTRIB_BEGIN(__mod_id, __api) do { \
+    if(darshan_attrib_ctx.depth++ == 0) { \
+        if(darshan_attrib_ctx.dirty) \
+            attrib_reset(); \
+        darshan_attrib_ctx.mod_id = (__mod_id); \
+        darshan_attrib_ctx.own_api = (__api); \
+    } \
+} while(0)
+
+#define DARSHAN_ATTRIB_LEAVE() do { \
+    darshan_attrib_ctx.depth--; \
+} while(0)
+
+/* called by upper layers once the record of a completed call is known;
+ * only does anything for the outermost call
+ */
+#define DARSHAN_ATTRIB_CHARGE(__rec_id) do { \
+    if(!darshan_attrib_ctx.depth && darshan_attrib_ctx.dirty) \
+        attrib_charge(__rec_id); \
+} while(0)
+
+/* called by lower layers for each operation, with the same arguments as
+ * TIMESERIES_RECORD_N()
+ */
+#define ATTRIB_RECORD_N(__api, __op, __count, __bytes, __elapsed) do { \
+    int __base; \
+    if(!darshan_attrib_ctx.depth || (__api) == darshan_attrib_ctx.own_api) \
+        break; \
+    if((__api) == TIMESERIES_API_MPIIO) \
+        __base = 0; \
+    else if((__api) == TIMESERIES_API_POSIX) \
+        __base = 1; \
+    else \
+        break; \
+    if((__op) == TIMESERIES_OP_READ) { \
+        darshan_attrib_ctx.counters[ATTRIB_MPIIO_READS + \
+            __base * ATTRIB_LAYER_COUNTERS] += (__count); \
+        darshan_attrib_ctx.counters[ATTRIB_MPIIO_BYTES_READ + \
+            __base * ATTRIB_LAYER_COUNTERS] += (__bytes); \
+    } \
+    else if((__op) == TIMESERIES_OP_WRITE) { \
+        darshan_attrib_ctx.counters[ATTRIB_MPIIO_WRITES + \
+            __base * ATTRIB_LAYER_COUNTERS] += (__count); \
+        darshan_attrib_ctx.counters[ATTRIB_MPIIO_BYTES_WRITTEN + \
+            __base * ATTRIB_LAYER_COUNTERS] += (__bytes); \
+    } \
+    else \
+        darshan_attrib_ctx.counters[ATTRIB_MPIIO_META_OPS + \
+            __base * ATTRIB_LAYER_COUNTERS] += (__count); \
+    darshan_attrib_ctx.fcounters[ATTRIB_F_MPIIO_READ_TIME + \
+        __base * ATTRIB_LAYER_F_COUNTERS + (__op)] += (__elapsed); \
+    darshan_attrib_ctx.dirty = 1; \
+} while(0)
+
+#endif /* __DARSHAN_ATTRIB_H */
@@ -0,0 +1,677 @@
+/*
+ * Copyright (C) 2015 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <darshan-runtime-config.h>
+#endif
+
+#define _XOPEN_SOURCE 500
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "darshan.h"
+#include "darshan-batchio.h"
+#include "uthash.h"
+
+/* maximum number of asynchronous requests tracked in flight at once.  If an
+ * application reaps completions without going through a wrapped function
+ * (e.g., by reading the libaio completion ring directly), tracked requests
+ * are never retired, so this bounds the memory spent on them.
+ */
+#define BATCHIO_MAX_INFLIGHT 65536
+
+/* The batchio_record_ref structure maintains necessary runtime metadata
+ * for each BATCHIO record.  A record exists for each file accessed through
+ * vectored or asynchronous requests (indexed by its POSIX record id) and
+ * for each submission interface that has been used.
+ */
+struct batchio_record_ref
+{
+    struct darshan_batchio_record *record_p;
+    int64_t inflight; /* requests currently in flight for this record */
+};
+
+/* struct to track an asynchronous request from submission until its
+ * completion is reaped, indexed by the address of the request (e.g., the
+ * libaio iocb) in the application
+ */
+struct batchio_inflight
+{
+    const void *req;
+    double submit_time;
+    int iface;
+    /* records whose in-flight count includes this request */
+    struct batchio_record_ref *refs[2];
+    int nrefs;
+    struct batchio_inflight *next_free;
+    UT_hash_handle hlink;
+};
+
+/* The batchio_runtime structure maintains necessary state for storing
+ * BATCHIO records and for coordinating with darshan-core at shutdown time.
+ */
+struct batchio_runtime
+{
+    void *rec_id_hash;
+    struct batchio_record_ref *iface_refs[BATCHIO_NUM_IFACES];
+    struct batchio_inflight *inflight_hash;
+    struct batchio_inflight *inflight_free;
+    int inflight_count;
+    int rec_count;
+    int frozen; /* flag to indicate that the counters should no longer be modified */
+};
+
+static struct batchio_runtime *batchio_runtime = NULL;
+static pthread_mutex_t batchio_runtime_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int batchio_runtime_init_attempted = 0;
+static int my_rank = -1;
+
+static void batchio_runtime_initialize(
+    void);
+static struct batchio_record_ref *batchio_track_new_record(
+    darshan_record_id rec_id, const char *name);
+static struct batchio_record_ref *batchio_file_ref(
+    darshan_record_id rec_id);
+static struct batchio_record_ref *batchio_iface_ref(
+    int iface);
+static void batchio_record_iovcnt(
+    struct darshan_batchio_record *rec, int iovcnt);
+static void batchio_record_merge(
+    struct darshan_batchio_record *infile,
+    struct darshan_batchio_record *inoutfile);
+#ifdef HAVE_MPI
+static void batchio_record_reduction_op(
+    void* infile_v, void* inoutfile_v, int *len, MPI_Datatype *datatype);
+static void batchio_mpi_redux(
+    void *batchio_buf, MPI_Comm mod_comm,
+    darshan_record_id *shared_recs, int shared_rec_count);
+#endif
+static void batchio_output(
+    void **batchio_buf, int *batchio_buf_sz);
+static void batchio_cleanup(
+    void);
+
+#define BATCHIO_LOCK() pthread_mutex_lock(&batchio_runtime_mutex)
+#define BATCHIO_UNLOCK() pthread_mutex_unlock(&batchio_runtime_mutex)
+
+/* the hooks below are called from the wrappers of other modules, so they
+ * only need to check whether this module is initialized and not frozen
+ * (darshan-core has already been consulted by the caller)
+ */
+#define BATCHIO_PRE_RECORD() do { \
+    BATCHIO_LOCK(); \
+    if(!batchio_runtime && !batchio_runtime_init_attempted) \
+        batchio_runtime_initialize(); \
+    if(batchio_runtime && !batchio_runtime->frozen) break; \
+    BATCHIO_UNLOCK(); \
+    return; \
+} while(0)
+
+#define BATCHIO_POST_RECORD() do { \
+    BATCHIO_UNLOCK(); \
+} while(0)
+
+/* increment the histogram bucket of a value in the 1, 2-7, 8-31 and 32+
+ * ranges used for both iovec counts and batch sizes
+ */
+#define BATCHIO_BUCKET_INC(__bucket_base, __value) do { \
+    if((__value) <= 1) \
+        *(__bucket_base) += 1; \
+    else if((__value) < 8) \
+        *((__bucket_base) + 1) += 1; \
+    else if((__value) < 32) \
+        *((__bucket_base) + 2) += 1; \
+    else \
+        *((__bucket_base) + 3) += 1; \
+} while(0)
+
+/**********************************************************
+ *    Hooks for recording vectored and batched requests   *
+ **********************************************************/
+
+void batchio_vector(darshan_record_id rec_id, int rw_flag, int iovcnt)
+{
+    struct batchio_record_ref *rec_ref;
+
+    BATCHIO_PRE_RECORD();
+    rec_ref = batchio_file_ref(rec_id);
+    if(rec_ref)
+    {
+        if(rw_flag == BATCHIO_READ)
+            rec_ref->record_p->counters[BATCHIO_VEC_READS] += 1;
+        else
+            rec_ref->record_p->counters[BATCHIO_VEC_WRITES] += 1;
+        batchio_record_iovcnt(rec_ref->record_p, iovcnt);
+    }
+    BATCHIO_POST_RECORD();
+
+    return;
+}
+
+void batchio_submit(int iface, int64_t nr, int64_t ret,
+    double start_time, double end_time)
+{
+    struct batchio_record_ref *rec_ref;
+    int64_t *counters;
+
+    BATCHIO_PRE_RECORD();
+    rec_ref = batchio_iface_ref(iface);
+    if(rec_ref)
+    {
+        counters = rec_ref->record_p->counters;
+        counters[BATCHIO_SUBMITS] += 1;
+        if(ret < nr)
+            counters[BATCHIO_SHORT_SUBMITS] += 1;
+        if(ret > 0)
+        {
+            counters[BATCHIO_SUBMITTED] += ret;
+            if(counters[BATCHIO_MAX_BATCH] < ret)
+                counters[BATCHIO_MAX_BATCH] = ret;
+            BATCHIO_BUCKET_INC(&counters[BATCHIO_BATCH_1], ret);
+        }
+        rec_ref->record_p->fcounters[BATCHIO_F_SUBMIT_TIME] +=
+            end_time - start_time;
+    }
+    BATCHIO_POST_RECORD();
+
+    return;
+}
+
+void batchio_wait(int iface, double start_time, double end_time)
+{
+    struct batchio_record_ref *rec_ref;
+
+    BATCHIO_PRE_RECORD();
+    rec_ref = batchio_iface_ref(iface);
+    if(rec_ref)
+    {
+        rec_ref->record_p->counters[BATCHIO_WAITS] += 1;
+        rec_ref->record_p->fcounters[BATCHIO_F_WAIT_TIME] +=
+            end_time - start_time;
+    }
+    BATCHIO_POST_RECORD();
+
+    return;
+}
+
+void batchio_async_start(int iface, const void *req, darshan_record_id rec_id,
+    int rw_flag, int iovcnt, double submit_time)
+{
+    struct batchio_record_ref *refs[2];
+    struct batchio_inflight *tracker;
+    int64_t *counters;
+    int nrefs = 0;
+    int i;
+
+    BATCHIO_PRE_RECORD();
+    refs[nrefs] = batchio_iface_ref(iface);
+    if(refs[nrefs])
+        nrefs++;
+    if(rec_id)
+    {
+        refs[nrefs] = batchio_file_ref(rec_id);
+        if(refs[nrefs])
+            nrefs++;
+    }
+
+    /* if the application resubmits a request whose completion we never
+     * saw, retire the stale entry rather than tracking the address twice
+     */
+    HASH_FIND(hlink, batchio_runtime->inflight_hash, &req, sizeof(req),
+        tracker);
+    if(tracker)
+    {
+        HASH_DELETE(hlink, batchio_runtime->inflight_hash, tracker);
+        for(i = 0; i < tracker->nrefs; i++)
+            tracker->refs[i]->inflight--;
+    }
+    else if(batchio_runtime->inflight_free)
+    {
+        tracker = batchio_runtime->inflight_free;
+        batchio_runtime->inflight_free = tracker->next_free;
+    }
+    else if(batchio_runtime->inflight_count < BATCHIO_MAX_INFLIGHT)
+    {
+        tracker = malloc(sizeof(*tracker));
+        if(tracker)
+            batchio_runtime->inflight_count++;
+    }
+    if(tracker)
+    {
+        tracker->req = req;
+        tracker->submit_time = submit_time;
+        tracker->iface = iface;
+        tracker->nrefs = nrefs;
+        for(i = 0; i < nrefs; i++)
+            tracker->refs[i] = refs[i];
+        HASH_ADD(hlink, batchio_runtime->inflight_hash, req, sizeof(req),
+            tracker);
+    }
+
+    for(i = 0; i < nrefs; i++)
+    {
+        counters = refs[i]->record_p->counters;
+        if(rw_flag == BATCHIO_READ)
+            counters[BATCHIO_ASYNC_READS] += 1;
+        else if(rw_flag == BATCHIO_WRITE)
+            counters[BATCHIO_ASYNC_WRITES] += 1;
+        else
+            counters[BATCHIO_ASYNC_OTHER] += 1;
+        if(iovcnt > 0)
+            batchio_record_iovcnt(refs[i]->record_p, iovcnt);
+        /* queue depth only covers requests we can see retire */
+        if(tracker)
+        {
+            refs[i]->inflight++;
+            counters[BATCHIO_QUEUE_DEPTH_SUM] += refs[i]->inflight;
+            if(counters[BATCHIO_MAX_QUEUE_DEPTH] < refs[i]->inflight)
+                counters[BATCHIO_MAX_QUEUE_DEPTH] = refs[i]->inflight;
+        }
+    }
+    BATCHIO_POST_RECORD();
+
+    return;
+}
+
+void batchio_async_complete(int iface, const void *req, double end_time)
+{
+    struct batchio_record_ref *rec_ref;
+    struct batchio_inflight *tracker;
+    double latency;
+    int i;
+
+    BATCHIO_PRE_RECORD();
+    HASH_FIND(hlink, batchio_runtime->inflight_hash, &req, sizeof(req),
+        tracker);
+    if(!tracker || tracker->iface != iface)
+    {
+        BATCHIO_POST_RECORD();
+        return;
+    }
+    HASH_DELETE(hlink, batchio_runtime->inflight_hash, tracker);
+
+    latency = end_time - tracker->submit_time;
+    for(i = 0; i < tracker->nrefs; i++)
+    {
+        rec_ref = tracker->refs[i];
+        rec_ref->inflight--;
+        rec_ref->record_p->counters[BATCHIO_COMPLETIONS] += 1;
+        rec_ref->record_p->fcounters[BATCHIO_F_COMPLETION_LATENCY] += latency;
+        if(rec_ref->record_p->fcounters[BATCHIO_F_MAX_COMPLETION_LATENCY] <
+            latency)
+            rec_ref->record_p->fcounters[BATCHIO_F_MAX_COMPLETION_LATENCY] =
+                latency;
+    }
+
+    tracker->next_free = batchio_runtime->inflight_free;
+    batchio_runtime->inflight_free = tracker;
+    BATCHIO_POST_RECORD();
+
+    return;
+}
+
+/**********************************************************
+ * Internal functions for manipulating BATCHIO module state *
+ **********************************************************/
+
+static void batchio_runtime_initialize()
+{
+    int ret;
+    size_t batchio_rec_count;
+    darshan_module_funcs mod_funcs = {
+#ifdef HAVE_MPI
+    .mod_redux_func = &batchio_mpi_redux,
+#endif
+    .mod_output_func = &batchio_output,
+    .mod_cleanup_func = &batchio_cleanup
+    };
+
+    /* don't do anything if already initialized */
+    if(batchio_runtime || batchio_runtime_init_attempted)
+        return;
+    batchio_runtime_init_attempted = 1;
+
+    /* try and store a default number of records for this module */
+    batchio_rec_count = DARSHAN_DEF_MOD_REC_COUNT;
+
+    /* register the BATCHIO module with darshan core */
+    ret = darshan_core_register_module(
+        DARSHAN_BATCHIO_MOD,
+        mod_funcs,
+        sizeof(struct darshan_batchio_record),
+        &batchio_rec_count,
+        &my_rank,
+        NULL);
+    if(ret < 0)
+        return;
+
+    batchio_runtime = malloc(sizeof(*batchio_runtime));
+    if(!batchio_runtime)
+    {
+        darshan_core_unregister_module(DARSHAN_BATCHIO_MOD);
+        return;
+    }
+    memset(batchio_runtime, 0, sizeof(*batchio_runtime));
+
+    return;
+}
+
+static struct batchio_record_ref *batchio_track_new_record(
+    darshan_record_id rec_id, const char *name)
+{
+    struct darshan_batchio_record *record_p = NULL;
+    struct batchio_record_ref *rec_ref = NULL;
+    int ret;
+
+    rec_ref = malloc(sizeof(*rec_ref));
+    if(!rec_ref)
+        return(NULL);
+    memset(rec_ref, 0, sizeof(*rec_ref));
+
+    /* add a reference to this record */
+    ret = darshan_add_record_ref(&(batchio_runtime->rec_id_hash), &rec_id,
+        sizeof(darshan_record_id), rec_ref);
+    if(ret == 0)
+    {
+        free(rec_ref);
+        return(NULL);
+    }
+
+    /* register the actual record with darshan-core so it is persisted in
+     * the log file.  File records pass a NULL name, since the POSIX module
+     * has already registered the name for this record id.
+     */
+    record_p = darshan_core_register_record(
+        rec_id,
+        name,
+        DARSHAN_BATCHIO_MOD,
+        sizeof(struct darshan_batchio_record),
+        NULL);
+
+    if(!record_p)
+    {
+        darshan_delete_record_ref(&(batchio_runtime->rec_id_hash),
+            &rec_id, sizeof(darshan_record_id));
+        free(rec_ref);
+        return(NULL);
+    }
+
+    /* registering this record was successful, so initialize some fields */
+    record_p->base_rec.id = rec_id;
+    record_p->base_rec.rank = my_rank;
+    rec_ref->record_p = record_p;
+    batchio_runtime->rec_count++;
+
+    return(rec_ref);
+}
+
+/* find or create the record for the file with POSIX record id 'rec_id' */
+static struct batchio_record_ref *batchio_file_ref(darshan_record_id rec_id)
+{
+    struct batchio_record_ref *rec_ref;
+
+    rec_ref = darshan_lookup_record_ref(batchio_runtime->rec_id_hash,
+        &rec_id, sizeof(darshan_record_id));
+    if(!rec_ref)
+        rec_ref = batchio_track_new_record(rec_id, NULL);
+
+    return(rec_ref);
+}
+
+/* find or create the summary record for submission interface 'iface' */
+static struct batchio_record_ref *batchio_iface_ref(int iface)
+{
+    const char *name;
+    darshan_record_id rec_id;
+
+    if(iface < 0 || iface >= BATCHIO_NUM_IFACES)
+        return(NULL);
+    if(!batchio_runtime->iface_refs[iface])
+    {
+        if(iface == BATCHIO_LIBAIO)
+            name = BATCHIO_LIBAIO_NAME;
+        else
+            name = BATCHIO_IO_URING_NAME;
+        rec_id = darshan_core_gen_record_id(name);
+        batchio_runtime->iface_refs[iface] =
+            batchio_track_new_record(rec_id, name);
+    }
+
+    return(batchio_runtime->iface_refs[iface]);
+}
+
+static void batchio_record_iovcnt(struct darshan_batchio_record *rec,
+    int iovcnt)
+{
+    rec->counters[BATCHIO_IOVECS] += iovcnt;
+    if(rec->counters[BATCHIO_MAX_IOVCNT] < iovcnt)
+        rec->counters[BATCHIO_MAX_IOVCNT] = iovcnt;
+    BATCHIO_BUCKET_INC(&rec->counters[BATCHIO_IOVCNT_1], iovcnt);
+
+    return;
+}
+
+/* combine the counters of 'infile' into 'inoutfile' */
+static void batchio_record_merge(struct darshan_batchio_record *infile,
+    struct darshan_batchio_record *inoutfile)
+{
+    int i;
+
+    for(i = 0; i < BATCHIO_NUM_INDICES; i++)
+    {
+        switch(i)
+        {
+            case BATCHIO_MAX_IOVCNT:
+            case BATCHIO_MAX_QUEUE_DEPTH:
+            case BATCHIO_MAX_BATCH:
+                /* max */
+                if(inoutfile->counters[i] < infile->counters[i])
+                    inoutfile->counters[i] = infile->counters[i];
+                break;
+            default:
+                /* sum */
+                inoutfile->counters[i] += infile->counters[i];
+                break;
+        }
+    }
+
+    for(i = 0; i < BATCHIO_F_NUM_INDICES; i++)
+    {
+        switch(i)
+        {
+            case BATCHIO_F_MAX_COMPLETION_LATENCY:
+                /* max */
+                if(inoutfile->fcounters[i] < infile->fcounters[i])
+                    inoutfile->fcounters[i] = infile->fcounters[i];
+                break;
+            default:
+                /* sum */
+                inoutfile->fcounters[i] += infile->fcounters[i];
+                break;
+        }
+    }
+
+    return;
+}
+
+#ifdef HAVE_MPI
+static void batchio_record_reduction_op(void* infile_v, void* inoutfile_v,
+    int *len, MPI_Datatype *datatype)
+{
+    struct darshan_batchio_record *infile = infile_v;
+    struct darshan_batchio_record *inoutfile = inoutfile_v;
+    int i;
+
+    for(i=0; i<*len; i++)
+    {
+        batchio_record_merge(infile, inoutfile);
+        inoutfile->base_rec.rank = -1;
+        infile++;
+        inoutfile++;
+    }
+
+    return;
+}
+#endif
+
+/********************************************************************************
+ * Functions exported by this module for coordinating with darshan-core *
+ ********************************************************************************/
+
+#ifdef HAVE_MPI
+static void batchio_mpi_redux(
+    void *batchio_buf,
+    MPI_Comm mod_comm,
+    darshan_record_id *shared_recs,
+    int shared_rec_count)
+{
+    int batchio_rec_count;
+    struct batchio_record_ref *rec_ref;
+    struct darshan_batchio_record *batchio_rec_buf =
+        (struct darshan_batchio_record *)batchio_buf;
+    struct darshan_batchio_record *red_send_buf = NULL;
+    struct darshan_batchio_record *red_recv_buf = NULL;
+    MPI_Datatype red_type;
+    MPI_Op red_op;
+    int i;
+
+    BATCHIO_LOCK();
+    assert(batchio_runtime);
+
+    /* no more updates once the records are rearranged below */
+    batchio_runtime->frozen = 1;
+
+    batchio_rec_count = batchio_runtime->rec_count;
+
+    /* necessary initialization of shared records */
+    for(i = 0; i < shared_rec_count; i++)
+    {
+        rec_ref = darshan_lookup_record_ref(batchio_runtime->rec_id_hash,
+            &shared_recs[i], sizeof(darshan_record_id));
+        assert(rec_ref);
+
+        rec_ref->record_p->base_rec.rank = -1;
+    }
+
+    /* sort the array of records descending by rank so that we get all of
+     * the shared records (marked by rank -1) in a contiguous portion at end
+     * of the array
+     */
+    darshan_record_sort(batchio_rec_buf, batchio_rec_count,
+        sizeof(struct darshan_batchio_record));
+
+    /* make *send_buf point to the shared records at the end of sorted array */
+    red_send_buf = &(batchio_rec_buf[batchio_rec_count-shared_rec_count]);
+
+    /* allocate memory for the reduction output on rank 0 */
+    if(my_rank == 0)
+    {
+        red_recv_buf = malloc(shared_rec_count *
+            sizeof(struct darshan_batchio_record));
+        if(!red_recv_buf)
+        {
+            BATCHIO_UNLOCK();
+            return;
+        }
+    }
+
+    /* construct a datatype for a BATCHIO record.  This is serving no
+     * purpose except to make sure we can do a reduction on proper boundaries
+     */
+    PMPI_Type_contiguous(sizeof(struct darshan_batchio_record),
+        MPI_BYTE, &red_type);
+    PMPI_Type_commit(&red_type);
+
+    /* register a BATCHIO record reduction operator */
+    PMPI_Op_create(batchio_record_reduction_op, 1, &red_op);
+
+    /* reduce shared BATCHIO records */
+    PMPI_Reduce(red_send_buf, red_recv_buf,
+        shared_rec_count, red_type, red_op, 0, mod_comm);
+
+    /* update module state to account for shared record reduction */
+    if(my_rank == 0)
+    {
+        /* overwrite local shared records with globally reduced records */
+        int tmp_ndx = batchio_rec_count - shared_rec_count;
+        memcpy(&(batchio_rec_buf[tmp_ndx]), red_recv_buf,
+            shared_rec_count * sizeof(struct darshan_batchio_record));
+        free(red_recv_buf);
+    }
+    else
+    {
+        /* drop shared records on non-zero ranks */
+        batchio_runtime->rec_count -= shared_rec_count;
+    }
+
+    PMPI_Type_free(&red_type);
+    PMPI_Op_free(&red_op);
+
+    BATCHIO_UNLOCK();
+    return;
+}
+#endif
+
+static void batchio_output(
+    void **batchio_buf,
+    int *batchio_buf_sz)
+{
+    BATCHIO_LOCK();
+    assert(batchio_runtime);
+
+    *batchio_buf_sz = batchio_runtime->rec_count *
+        sizeof(struct darshan_batchio_record);
+
+    batchio_runtime->frozen = 1;
+
+    BATCHIO_UNLOCK();
+    return;
+}
+
+static void batchio_cleanup()
+{
+    struct batchio_inflight *tracker, *tmp;
+
+    BATCHIO_LOCK();
+    assert(batchio_runtime);
+
+    /* free requests still in flight, then the free list */
+    HASH_ITER(hlink, batchio_runtime->inflight_hash, tracker, tmp)
+    {
+        HASH_DELETE(hlink, batchio_runtime->inflight_hash, tracker);
+        free(tracker);
+    }
+    while(batchio_runtime->inflight_free)
+    {
+        tracker = batchio_runtime->inflight_free;
+        batchio_runtime->inflight_free = tracker->next_free;
+        free(tracker);
+    }
+
+    /* cleanup internal structures used for instrumenting */
+    darshan_clear_record_refs(&(batchio_runtime->rec_id_hash), 1);
+
+    free(batchio_runtime);
+    batchio_runtime = NULL;
+    batchio_runtime_init_attempted = 0;
+
+    BATCHIO_UNLOCK();
+    return;
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
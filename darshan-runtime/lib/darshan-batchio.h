@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2015 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifndef __DARSHAN_BATCHIO_H
+#define __DARSHAN_BATCHIO_H
+
+#include <stdint.h>
+
+#define BATCHIO_READ 1
+#define BATCHIO_WRITE 2
+#define BATCHIO_OTHER 3
+
+/* submission interfaces that have their own summary record */
+#define BATCHIO_LIBAIO 0
+#define BATCHIO_IO_URING 1
+#define BATCHIO_NUM_IFACES 2
+
+#ifdef DARSHAN_BATCHIO
+
+/* batchio_vector()
+ *
+ * records a vectored read or write of 'iovcnt' segments to the file with
+ * POSIX record id 'rec_id'
+ */
+void batchio_vector(darshan_record_id rec_id, int rw_flag, int iovcnt);
+
+/* batchio_submit()
+ *
+ * records a submission call on interface 'iface' that was given 'nr'
+ * requests and returned 'ret' (the number accepted, or < 0 on error)
+ */
+void batchio_submit(int iface, int64_t nr, int64_t ret,
+    double start_time, double end_time);
+
+/* batchio_wait()
+ *
+ * records a call on interface 'iface' that waited for or reaped completions
+ */
+void batchio_wait(int iface, double start_time, double end_time);
+
+/* batchio_async_start(), batchio_async_complete()
+ *
+ * track an accepted asynchronous request 'req' from submission until its
+ * completion is reaped.  'rec_id' is the POSIX record id of the target file,
+ * or 0 if the file is not instrumented, and 'iovcnt' is the segment count of
+ * vectored requests (0 otherwise).
+ */
+void batchio_async_start(int iface, const void *req, darshan_record_id rec_id,
+    int rw_flag, int iovcnt, double submit_time);
+void batchio_async_complete(int iface, const void *req, double end_time);
+
+#else
+
+/* as with the heatmap module, provide stubs when the BATCHIO module is
+ * disabled so that the POSIX wrappers do not need preprocessor guards
+ */
+
+static inline void batchio_vector(darshan_record_id rec_id, int rw_flag,
+    int iovcnt) {
+}
+
+static inline void batchio_submit(int iface, int64_t nr, int64_t ret,
+    double start_time, double end_time) {
+}
+
+static inline void batchio_wait(int iface, double start_time,
+    double end_time) {
+}
+
+static inline void batchio_async_start(int iface, const void *req,
+    darshan_record_id rec_id, int rw_flag, int iovcnt, double submit_time) {
+}
+
+static inline void batchio_async_complete(int iface, const void *req,
+    double end_time) {
+}
+
+#endif
+
+#endif /* __DARSHAN_BATCHIO_H */
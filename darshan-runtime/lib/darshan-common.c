@@ -14,15 +14,165 @@
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
-#include <search.h>
 #include <assert.h>
+#include <pthread.h>
 
 #include "uthash.h"
 
 #include "darshan.h"
 
-int darshan_add_record_ref(void **hash_head_p, void *handle, size_t handle_sz,
-    void *rec_ref_p)
+#ifdef HAVE_MPI
+/* target size of each chunk of a shared record reduction */
+#define DARSHAN_SHARED_REDUX_CHUNK_SIZE (1024*1024)
+#endif
+
+/* slab arena parameters: objects are rounded up to a multiple of the
+ * alignment and grouped into size classes, each with its own free list.
+ * objects larger than the biggest size class get a dedicated chunk.
+ */
+#define DARSHAN_ARENA_ALIGN 16
+#define DARSHAN_ARENA_NUM_CLASSES 32
+#define DARSHAN_ARENA_CHUNK_SIZE (64*1024)
+
+struct darshan_arena_chunk
+{
+    struct darshan_arena_chunk *next;
+};
+
+struct darshan_arena_free_obj
+{
+    struct darshan_arena_free_obj *next;
+};
+
+struct darshan_slab_arena
+{
+    struct darshan_arena_chunk *chunks;
+    char *chunk_p;
+    size_t chunk_avail;
+    struct darshan_arena_free_obj *free_lists[DARSHAN_ARENA_NUM_CLASSES];
+};
+
+/* chunks keep their header in the first DARSHAN_ARENA_ALIGN bytes */
+static void *darshan_arena_new_chunk(struct darshan_slab_arena *arena,
+    size_t size)
+{
+    struct darshan_arena_chunk *chunk;
+
+    chunk = malloc(DARSHAN_ARENA_ALIGN + size);
+    if(!chunk)
+        return(NULL);
+    chunk->next = arena->chunks;
+    arena->chunks = chunk;
+
+    return((char *)chunk + DARSHAN_ARENA_ALIGN);
+}
+
+void *darshan_arena_alloc(void **arena_p, size_t size)
+{
+    struct darshan_slab_arena *arena = *(struct darshan_slab_arena **)arena_p;
+    struct darshan_arena_free_obj *obj;
+    size_t obj_size;
+    int size_class;
+    void *ptr;
+
+    if(!arena)
+    {
+        arena = malloc(sizeof(*arena));
+        if(!arena)
+            return(NULL);
+        memset(arena, 0, sizeof(*arena));
+        *arena_p = arena;
+    }
+
+    if(size == 0)
+        size = 1;
+    obj_size = (size + DARSHAN_ARENA_ALIGN - 1) & ~(size_t)(DARSHAN_ARENA_ALIGN - 1);
+    size_class = (obj_size / DARSHAN_ARENA_ALIGN) - 1;
+
+    if(size_class >= DARSHAN_ARENA_NUM_CLASSES)
+    {
+        /* too big to be worth pooling */
+        ptr = darshan_arena_new_chunk(arena, obj_size);
+    }
+    else if(arena->free_lists[size_class])
+    {
+        /* reuse a previously freed object of this size */
+        obj = arena->free_lists[size_class];
+        arena->free_lists[size_class] = obj->next;
+        ptr = obj;
+    }
+    else
+    {
+        /* carve a new object out of the current chunk */
+        if(arena->chunk_avail < obj_size)
+        {
+            arena->chunk_p = darshan_arena_new_chunk(arena,
+                DARSHAN_ARENA_CHUNK_SIZE);
+            if(!arena->chunk_p)
+            {
+                arena->chunk_avail = 0;
+                return(NULL);
+            }
+            arena->chunk_avail = DARSHAN_ARENA_CHUNK_SIZE;
+        }
+        ptr = arena->chunk_p;
+        arena->chunk_p += obj_size;
+        arena->chunk_avail -= obj_size;
+    }
+
+    if(ptr)
+        memset(ptr, 0, size);
+    return(ptr);
+}
+
+void darshan_arena_free(void *arena_v, void *ptr, size_t size)
+{
+    struct darshan_slab_arena *arena = (struct darshan_slab_arena *)arena_v;
+    struct darshan_arena_free_obj *obj = (struct darshan_arena_free_obj *)ptr;
+    size_t obj_size;
+    int size_class;
+
+    if(!arena || !ptr)
+        return;
+
+    if(size == 0)
+        size = 1;
+    obj_size = (size + DARSHAN_ARENA_ALIGN - 1) & ~(size_t)(DARSHAN_ARENA_ALIGN - 1);
+    size_class = (obj_size / DARSHAN_ARENA_ALIGN) - 1;
+
+    /* large objects are simply released when the arena is destroyed */
+    if(size_class >= DARSHAN_ARENA_NUM_CLASSES)
+        return;
+
+    obj->next = arena->free_lists[size_class];
+    arena->free_lists[size_class] = obj;
+
+    return;
+}
+
+void darshan_arena_destroy(void **arena_p)
+{
+    struct darshan_slab_arena *arena = *(struct darshan_slab_arena **)arena_p;
+    struct darshan_arena_chunk *chunk, *tmp;
+
+    if(!arena)
+        return;
+
+    chunk = arena->chunks;
+    while(chunk)
+    {
+        tmp = chunk->next;
+        free(chunk);
+        chunk = tmp;
+    }
+    free(arena);
+    *arena_p = NULL;
+
+    return;
+}
+
+static int darshan_add_record_ref_common(void **arena_p, void **hash_head_p,
+    void *handle, size_t handle_sz, void *rec_ref_p)
 {
     struct darshan_record_ref_tracker *ref_tracker;
     struct darshan_record_ref_tracker *ref_tracker_head =
@@ -30,7 +180,10 @@ int darshan_add_record_ref(void **hash_head_p, void *handle, size_t handle_sz,
     void *handle_p;
 
     /* allocate a reference tracker, with room to store the handle at the end */
-    ref_tracker = malloc(sizeof(*ref_tracker) + handle_sz);
+    if(arena_p)
+        ref_tracker = darshan_arena_alloc(arena_p, sizeof(*ref_tracker) + handle_sz);
+    else
+        ref_tracker = malloc(sizeof(*ref_tracker) + handle_sz);
     if(!ref_tracker)
         return(0);
     memset(ref_tracker, 0, sizeof(*ref_tracker) + handle_sz);
@@ -44,27 +197,84 @@ int darshan_add_record_ref(void **hash_head_p, void *handle, size_t handle_sz,
     return(1);
 }
 
-void *darshan_delete_record_ref(void **hash_head_p, void *handle, size_t handle_sz)
+static struct darshan_record_ref_tracker *darshan_unlink_record_ref(
+    void **hash_head_p, void *handle, size_t handle_sz)
 {
     struct darshan_record_ref_tracker *ref_tracker;
     struct darshan_record_ref_tracker *ref_tracker_head =
         *(struct darshan_record_ref_tracker **)hash_head_p;
-    void *rec_ref_p;
 
     /* find the reference tracker for this handle */
     HASH_FIND(hlink, ref_tracker_head, handle, handle_sz, ref_tracker);
     if(!ref_tracker)
         return(NULL);
 
-    /* if found, delete from hash table and return the record reference pointer */
+    /* if found, delete from hash table */
     HASH_DELETE(hlink, ref_tracker_head, ref_tracker);
     *hash_head_p = ref_tracker_head;
+
+    return(ref_tracker);
+}
+
+int darshan_add_record_ref(void **hash_head_p, void *handle, size_t handle_sz,
+    void *rec_ref_p)
+{
+    return(darshan_add_record_ref_common(NULL, hash_head_p, handle, handle_sz,
+        rec_ref_p));
+}
+
+void *darshan_delete_record_ref(void **hash_head_p, void *handle, size_t handle_sz)
+{
+    struct darshan_record_ref_tracker *ref_tracker;
+    void *rec_ref_p;
+
+    ref_tracker = darshan_unlink_record_ref(hash_head_p, handle, handle_sz);
+    if(!ref_tracker)
+        return(NULL);
+
+    /* return the record reference pointer */
     rec_ref_p = ref_tracker->rec_ref_p;
     free(ref_tracker);
 
     return(rec_ref_p);
 }
 
+int darshan_arena_add_record_ref(void **arena_p, void **hash_head_p,
+    void *handle, size_t handle_sz, void *rec_ref_p)
+{
+    return(darshan_add_record_ref_common(arena_p, hash_head_p, handle,
+        handle_sz, rec_ref_p));
+}
+
+void *darshan_arena_delete_record_ref(void *arena, void **hash_head_p,
+    void *handle, size_t handle_sz)
+{
+    struct darshan_record_ref_tracker *ref_tracker;
+    void *rec_ref_p;
+
+    ref_tracker = darshan_unlink_record_ref(hash_head_p, handle, handle_sz);
+    if(!ref_tracker)
+        return(NULL);
+
+    /* return the record reference pointer */
+    rec_ref_p = ref_tracker->rec_ref_p;
+    darshan_arena_free(arena, ref_tracker, sizeof(*ref_tracker) + handle_sz);
+
+    return(rec_ref_p);
+}
+
+void darshan_arena_clear_record_refs(void **hash_head_p)
+{
+    struct darshan_record_ref_tracker *ref_tracker_head =
+        *(struct darshan_record_ref_tracker **)hash_head_p;
+
+    /* drop the hash table itself; entries are owned by the arena */
+    HASH_CLEAR(hlink, ref_tracker_head);
+    *hash_head_p = ref_tracker_head;
+
+    return;
+}
+
 void darshan_clear_record_refs(void **hash_head_p, int free_flag)
 {
     struct darshan_record_ref_tracker *ref_tracker, *tmp;
@@ -102,65 +312,306 @@ void darshan_iter_record_refs(void *hash_head, void (*iter_action)(void *, void
     return;
 }
 
-char* darshan_clean_file_path(const char* path)
+/* initial number of entries in an fd reference table */
+#define DARSHAN_FD_REF_TABLE_INIT_SIZE 64
+
+int darshan_add_fd_ref(void **fd_table_p, int fd, void *rec_ref_p)
 {
-    char* newpath = NULL;
-    char* cwd = NULL;
-    char* filter = NULL;
+    struct darshan_fd_ref_table *table =
+        *(struct darshan_fd_ref_table **)fd_table_p;
+    struct darshan_fd_ref_table *new_table;
+    int old_size = table ? table->size : 0;
+    int new_size;
+
+    if(fd < 0)
+        return(0);
+
+    if(fd >= old_size)
+    {
+        /* grow the table by doubling until it can hold this fd */
+        new_size = old_size ? old_size : DARSHAN_FD_REF_TABLE_INIT_SIZE;
+        while(new_size <= fd)
+        {
+            if(new_size > INT_MAX / 2)
+                return(0);
+            new_size *= 2;
+        }
+
+        new_table = realloc(table,
+            sizeof(*new_table) + (size_t)new_size * sizeof(void *));
+        if(!new_table)
+            return(0);
+        memset(&new_table->rec_refs[old_size], 0,
+            (size_t)(new_size - old_size) * sizeof(void *));
+        new_table->size = new_size;
+        table = new_table;
+        *fd_table_p = table;
+    }
+
+    table->rec_refs[fd] = rec_ref_p;
+    return(1);
+}
+
+void *darshan_delete_fd_ref(void **fd_table_p, int fd)
+{
+    struct darshan_fd_ref_table *table =
+        *(struct darshan_fd_ref_table **)fd_table_p;
+    void *rec_ref_p;
+
+    if(!table || fd < 0 || fd >= table->size)
+        return(NULL);
+
+    rec_ref_p = table->rec_refs[fd];
+    table->rec_refs[fd] = NULL;
+
+    return(rec_ref_p);
+}
+
+void darshan_clear_fd_refs(void **fd_table_p, int free_flag)
+{
+    struct darshan_fd_ref_table *table =
+        *(struct darshan_fd_ref_table **)fd_table_p;
+    int i;
+
+    if(!table)
+        return;
+
+    if(free_flag)
+    {
+        for(i = 0; i < table->size; i++)
+            free(table->rec_refs[i]);
+    }
+    free(table);
+    *fd_table_p = NULL;
+
+    return;
+}
+
+/* cached copy of the process working directory, used to resolve relative
+ * paths without calling getcwd() on every open/stat. The cache is refilled
+ * lazily and invalidated by the chdir()/fchdir() wrappers.
+ */
+static pthread_mutex_t darshan_cwd_mutex = PTHREAD_MUTEX_INITIALIZER;
+static char darshan_cwd_cache[__DARSHAN_PATH_MAX];
+static size_t darshan_cwd_len = 0;
+
+/* bumped whenever the working directory changes, so that record ids
+ * memoized for relative paths under the old working directory are ignored
+ */
+static uint64_t darshan_cwd_gen = 0;
+
+void darshan_invalidate_cwd_cache()
+{
+    pthread_mutex_lock(&darshan_cwd_mutex);
+    darshan_cwd_len = 0;
+    __atomic_add_fetch(&darshan_cwd_gen, 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&darshan_cwd_mutex);
+    return;
+}
+
+/* append 'src' to the 'len' characters already in 'buf', dropping any
+ * redundant '/' and './' that follow a '/'; returns the new length, or -1
+ * if the result (plus terminator) does not fit in 'buf_sz' characters
+ */
+static ssize_t darshan_append_clean_path(char *buf, size_t len, size_t buf_sz,
+    const char *src)
+{
+    while(*src)
+    {
+        if(len > 0 && buf[len-1] == '/')
+        {
+            if(src[0] == '/')
+            {
+                src++;
+                continue;
+            }
+            if(src[0] == '.' && src[1] == '/')
+            {
+                src += 2;
+                continue;
+            }
+        }
+        if(len + 1 >= buf_sz)
+            return(-1);
+        buf[len++] = *src++;
+    }
+    buf[len] = '\0';
+
+    return(len);
+}
+
+char* darshan_clean_file_path_buf(const char *path, char *buf, size_t buf_sz)
+{
+    ssize_t len = 0;
 
     /* NOTE: the last check in this if statement is for path strings that
      * begin with the '<' character.  We assume that these are special
      * reserved paths used by Darshan, like <STDIN>.
      */
-    if(!path || strlen(path) < 1 || path[0] == '<')
+    if(!path || path[0] == '\0' || path[0] == '<' || buf_sz < 2)
         return(NULL);
 
-    if(path[0] == '/')
+    if(path[0] != '/')
     {
-        /* it is already an absolute path */
-        newpath = malloc(strlen(path)+1);
-        if(newpath)
+        /* handle relative path by prefixing the cached working directory */
+        pthread_mutex_lock(&darshan_cwd_mutex);
+        if(darshan_cwd_len == 0 &&
+            getcwd(darshan_cwd_cache, sizeof(darshan_cwd_cache)))
+            darshan_cwd_len = strlen(darshan_cwd_cache);
+        if(darshan_cwd_len == 0 || darshan_cwd_len + 1 >= buf_sz)
         {
-            strcpy(newpath, path);
+            pthread_mutex_unlock(&darshan_cwd_mutex);
+            return(NULL);
         }
+        memcpy(buf, darshan_cwd_cache, darshan_cwd_len);
+        len = darshan_cwd_len;
+        pthread_mutex_unlock(&darshan_cwd_mutex);
+
+        len = darshan_append_clean_path(buf, len, buf_sz, "/");
+        if(len < 0)
+            return(NULL);
     }
-    else
+
+    len = darshan_append_clean_path(buf, len, buf_sz, path);
+    if(len < 0)
+        return(NULL);
+
+    return(buf);
+}
+
+char* darshan_clean_file_path(const char* path)
+{
+    char* newpath = NULL;
+    char* tmp;
+    size_t newpath_sz;
+
+    if(!path)
+        return(NULL);
+
+    /* leave room for the working directory in case the path is relative */
+    newpath_sz = strlen(path) + __DARSHAN_PATH_MAX + 2;
+    newpath = malloc(newpath_sz);
+    if(!newpath)
+        return(NULL);
+
+    if(!darshan_clean_file_path_buf(path, newpath, newpath_sz))
+    {
+        free(newpath);
+        return(NULL);
+    }
+
+    /* trim the allocation down to the cleaned path */
+    tmp = realloc(newpath, strlen(newpath) + 1);
+    if(tmp)
+        newpath = tmp;
+
+    /* return result */
+    return(newpath);
+}
+
+/* per-thread memo of path string -> record id, so that reopening or
+ * restating a path does not have to clean and hash it again. Entries are
+ * direct-mapped by a fingerprint of the raw path string; the fingerprint is
+ * kept as a whole so that a hit does not need a copy of the path to verify.
+ */
+#define DARSHAN_PATH_ID_CACHE_SIZE 1024 /* must be a power of two */
+
+struct darshan_path_id_entry
+{
+    uint64_t fp;            /* path fingerprint, 0 if unused */
+    uint64_t cwd_gen;       /* darshan_cwd_gen, for relative paths */
+    darshan_record_id rec_id;
+};
+
+static pthread_once_t darshan_path_id_once = PTHREAD_ONCE_INIT;
+static pthread_key_t darshan_path_id_key;
+static int darshan_path_id_key_ok = 0;
+static __thread struct darshan_path_id_entry *darshan_path_id_cache = NULL;
+
+static void darshan_path_id_key_init(void)
+{
+    /* the key only serves to free each thread's cache when it exits */
+    if(pthread_key_create(&darshan_path_id_key, free) == 0)
+        darshan_path_id_key_ok = 1;
+    return;
+}
+
+static uint64_t darshan_path_fingerprint(const char *path, size_t len)
+{
+    uint64_t h = (len + 1) * 0x9E3779B97F4A7C15ULL;
+    uint64_t w;
+    size_t i;
+
+    for(i = 0; i + 8 <= len; i += 8)
+    {
+        memcpy(&w, path + i, 8);
+        h = (h ^ w) * 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 32;
+    }
+    if(i < len)
+    {
+        w = 0;
+        memcpy(&w, path + i, len - i);
+        h = (h ^ w) * 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 32;
+    }
+    h ^= h >> 29;
+
+    /* 0 marks an unused entry */
+    return(h ? h : 1);
+}
+
+darshan_record_id darshan_path_record_id(const char *path, char *buf,
+    size_t buf_sz, char **newpath)
+{
+    struct darshan_path_id_entry *cache = darshan_path_id_cache;
+    struct darshan_path_id_entry *ent = NULL;
+    darshan_record_id rec_id;
+    uint64_t fp = 0, gen = 0;
+    char *clean;
+
+    if(!cache)
     {
-        /* handle relative path */
-        cwd = malloc(__DARSHAN_PATH_MAX);
-        if(cwd)
+        pthread_once(&darshan_path_id_once, darshan_path_id_key_init);
+        if(darshan_path_id_key_ok)
         {
-            if(getcwd(cwd, __DARSHAN_PATH_MAX))
+            cache = calloc(DARSHAN_PATH_ID_CACHE_SIZE, sizeof(*cache));
+            if(cache)
             {
-                newpath = malloc(strlen(path) + strlen(cwd) + 2);
-                if(newpath)
-                {
-                    sprintf(newpath, "%s/%s", cwd, path);
-                }
+                pthread_setspecific(darshan_path_id_key, cache);
+                darshan_path_id_cache = cache;
             }
-            free(cwd);
         }
     }
 
-    if(!newpath)
-        return(NULL);
-
-    /* filter out any double slashes */
-    while((filter = strstr(newpath, "//")))
+    if(cache && path)
     {
-        /* shift down one character */
-        memmove(filter, &filter[1], (strlen(&filter[1]) + 1));
+        fp = darshan_path_fingerprint(path, strlen(path));
+        ent = &cache[fp & (DARSHAN_PATH_ID_CACHE_SIZE - 1)];
+        /* read before cleaning, so an entry filled in while the working
+         * directory changed is never used
+         */
+        if(path[0] != '/')
+            gen = __atomic_load_n(&darshan_cwd_gen, __ATOMIC_ACQUIRE);
+        if(ent->fp == fp && ent->cwd_gen == gen)
+        {
+            *newpath = NULL;
+            return(ent->rec_id);
+        }
     }
 
-    /* filter out any /./ instances */
-    while((filter = strstr(newpath, "/./")))
+    clean = darshan_clean_file_path_buf(path, buf, buf_sz);
+    *newpath = clean ? clean : (char *)path;
+    rec_id = darshan_core_gen_record_id(*newpath);
+
+    if(ent)
     {
-        /* shift down two characters */
-        memmove(filter, &filter[2], (strlen(&filter[2]) + 1));
+        ent->fp = fp;
+        ent->cwd_gen = gen;
+        ent->rec_id = rec_id;
     }
 
-    /* return result */
-    return(newpath);
+    return(rec_id);
 }
 
 /* compare function for sorting file records according to their 
@@ -188,64 +639,241 @@ static int darshan_base_record_compare(const void* a_p, const void* b_p)
     return(0);
 }
 
+/* buffers with fewer records than this are sorted with qsort(), as the
+ * radix sort below only pays off for larger buffers. The radix sort also
+ * falls back to qsort() for buffers holding more distinct ranks than
+ * DARSHAN_RECORD_SORT_MAX_RANKS, which local record buffers (holding this
+ * process's records and shared records) never do.
+ */
+#define DARSHAN_RECORD_SORT_RADIX_MIN 256
+#define DARSHAN_RECORD_SORT_MAX_RANKS 256
+
+struct darshan_record_sort_key
+{
+    uint64_t id;
+    uint32_t rank_ord; /* position of the record's rank, in descending order */
+    uint32_t ndx;      /* position of the record in the unsorted buffer */
+};
+
+/* one counting sort pass of the radix sort on the given byte of the key
+ * (0-7 for bytes of the record id, 8 for the rank ordinal); returns 0 if
+ * the pass was skipped because all keys have the same value for the byte
+ */
+static int darshan_record_sort_pass(struct darshan_record_sort_key *in,
+    struct darshan_record_sort_key *out, int rec_count, int byte)
+{
+    size_t counts[256] = {0};
+    size_t total = 0, tmp;
+    int i;
+
+#define SORT_KEY_BYTE(__key) ((byte < 8) ? \
+    (((__key)->id >> (byte * 8)) & 0xff) : (__key)->rank_ord)
+
+    for(i = 0; i < rec_count; i++)
+        counts[SORT_KEY_BYTE(&in[i])]++;
+    if(counts[SORT_KEY_BYTE(&in[0])] == (size_t)rec_count)
+        return(0);
+    for(i = 0; i < 256; i++)
+    {
+        tmp = counts[i];
+        counts[i] = total;
+        total += tmp;
+    }
+    for(i = 0; i < rec_count; i++)
+        out[counts[SORT_KEY_BYTE(&in[i])]++] = in[i];
+
+#undef SORT_KEY_BYTE
+
+    return(1);
+}
+
+/* records are radix sorted through an index of their keys, so that each
+ * record is then moved only once, rather than swapped repeatedly by qsort()
+ */
 void darshan_record_sort(void *rec_buf, int rec_count, int rec_size)
 {
+    struct darshan_base_record *rec;
+    struct darshan_record_sort_key *keys = NULL, *tmp_keys, *swap;
+    int64_t ranks[DARSHAN_RECORD_SORT_MAX_RANKS];
+    int rank_cnt = 0;
+    char *buf = rec_buf;
+    char *tmp_rec = NULL;
+    int lo, hi, mid;
+    int i, j, k;
+
+    if(rec_count < DARSHAN_RECORD_SORT_RADIX_MIN)
+        goto fallback;
+
+    /* collect the distinct ranks, in descending order */
+    for(i = 0; i < rec_count; i++)
+    {
+        rec = (struct darshan_base_record *)(buf + (size_t)i * rec_size);
+        for(j = 0; j < rank_cnt && ranks[j] > rec->rank; j++);
+        if(j < rank_cnt && ranks[j] == rec->rank)
+            continue;
+        if(rank_cnt == DARSHAN_RECORD_SORT_MAX_RANKS)
+            goto fallback;
+        memmove(&ranks[j + 1], &ranks[j], (rank_cnt - j) * sizeof(*ranks));
+        ranks[j] = rec->rank;
+        rank_cnt++;
+    }
+
+    keys = malloc(2 * (size_t)rec_count * sizeof(*keys));
+    tmp_rec = malloc(rec_size);
+    if(!keys || !tmp_rec)
+        goto fallback;
+    tmp_keys = keys + rec_count;
+
+    for(i = 0; i < rec_count; i++)
+    {
+        rec = (struct darshan_base_record *)(buf + (size_t)i * rec_size);
+        lo = 0;
+        hi = rank_cnt - 1;
+        while(lo < hi)
+        {
+            mid = (lo + hi) / 2;
+            if(ranks[mid] > rec->rank)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        keys[i].id = rec->id;
+        keys[i].rank_ord = lo;
+        keys[i].ndx = i;
+    }
+
+    /* least significant byte first: the id, then the rank */
+    for(i = 0; i < 9; i++)
+    {
+        if(darshan_record_sort_pass(keys, tmp_keys, rec_count, i))
+        {
+            swap = keys;
+            keys = tmp_keys;
+            tmp_keys = swap;
+        }
+    }
+
+    /* move the records into place, following each cycle of the
+     * permutation and marking positions done as they are filled
+     */
+    for(i = 0; i < rec_count; i++)
+    {
+        if(keys[i].ndx == (uint32_t)i)
+            continue;
+        memcpy(tmp_rec, buf + (size_t)i * rec_size, rec_size);
+        j = i;
+        while((k = keys[j].ndx) != i)
+        {
+            memcpy(buf + (size_t)j * rec_size, buf + (size_t)k * rec_size,
+                rec_size);
+            keys[j].ndx = j;
+            j = k;
+        }
+        memcpy(buf + (size_t)j * rec_size, tmp_rec, rec_size);
+        keys[j].ndx = j;
+    }
+
+    free((keys < tmp_keys) ? keys : tmp_keys);
+    free(tmp_rec);
+    return;
+
+fallback:
+    free(keys);
+    free(tmp_rec);
     qsort(rec_buf, rec_count, rec_size, darshan_base_record_compare);
     return;
 }
 
-static int darshan_common_vals_compare(const void *a_p, const void *b_p)
+/* number of index slots in a common value table; kept at twice the
+ * number of counters so that linear probes stay short
+ */
+#define DARSHAN_COMMON_VAL_INDEX_SIZE (2 * DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT)
+
+/* fixed-capacity table of common value counters. 'index' is an open-addressed
+ * hash index mapping values to counters (storing counter index + 1, with 0
+ * marking an empty slot), and 'counters' holds up to
+ * DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT variable-sized counters in insertion
+ * order.
+ */
+struct darshan_common_val_table
+{
+    int nvals;
+    unsigned char index[DARSHAN_COMMON_VAL_INDEX_SIZE];
+    char counters[];
+};
+
+#define DARSHAN_COMMON_VAL_COUNTER_SIZE(__nvals) \
+    (sizeof(struct darshan_common_val_counter) + (__nvals) * sizeof(int64_t))
+
+static inline unsigned int darshan_common_vals_hash(int64_t *vals, int nvals)
 {
-    const struct darshan_common_val_counter* a = a_p;
-    const struct darshan_common_val_counter* b = b_p;
+    uint64_t h = 0;
+    int i;
 
-    return(memcmp(a->vals, b->vals, sizeof(*(a->vals)) * a->nvals));
+    for(i = 0; i < nvals; i++)
+    {
+        h ^= (uint64_t)vals[i];
+        h *= 0x9E3779B97F4A7C15ULL;
+        h ^= h >> 32;
+    }
+
+    return((unsigned int)(h % DARSHAN_COMMON_VAL_INDEX_SIZE));
 }
 
 struct darshan_common_val_counter *darshan_track_common_val_counters(
     void **common_val_root, int64_t *vals, int nvals, int *common_val_count)
 {
-    struct darshan_common_val_counter* counter;
-    struct darshan_common_val_counter* found = NULL;
-    struct darshan_common_val_counter tmp_counter;
-    void* tmp;
+    struct darshan_common_val_table *table = *common_val_root;
+    struct darshan_common_val_counter *counter;
+    size_t counter_size = DARSHAN_COMMON_VAL_COUNTER_SIZE(nvals);
+    unsigned int slot;
+    int i;
 
     assert(nvals <= DARSHAN_COMMON_VAL_MAX_NCOUNTERS);
 
-    /* check to see if this val is already recorded */
-    memcpy(tmp_counter.vals, vals, sizeof(*vals) * nvals);
-    tmp_counter.nvals = nvals;
-    tmp_counter.freq = 1;
-    tmp = tfind(&tmp_counter, common_val_root, darshan_common_vals_compare);
-    if(tmp)
+    if(!table)
     {
-        found = *(struct darshan_common_val_counter**)tmp;
-        found->freq++;
+        /* allocate the entire table up front, it never grows */
+        table = malloc(sizeof(*table) +
+            DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT * counter_size);
+        if(!table)
+            return(NULL);
+        memset(table->index, 0, sizeof(table->index));
+        table->nvals = nvals;
+        *common_val_root = table;
     }
-    else if(*common_val_count < DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT)
+    assert(table->nvals == nvals);
+
+    /* check to see if this val is already recorded */
+    slot = darshan_common_vals_hash(vals, nvals);
+    for(i = 0; i < DARSHAN_COMMON_VAL_INDEX_SIZE; i++)
     {
-        /* we can add a new one as long as we haven't hit the limit */
-        counter = malloc(sizeof(*counter));
-        if(!counter)
+        if(table->index[slot] == 0)
+            break;
+
+        counter = (struct darshan_common_val_counter *)
+            &table->counters[(table->index[slot] - 1) * counter_size];
+        if(!memcmp(counter->vals, vals, sizeof(*vals) * nvals))
         {
-            return(NULL);
+            counter->freq++;
+            return(counter);
         }
+        slot = (slot + 1) % DARSHAN_COMMON_VAL_INDEX_SIZE;
+    }
 
-        memcpy(counter->vals, vals, sizeof(*vals) * nvals);
-        counter->nvals = nvals;
-        counter->freq = 1;
-
-        tmp = tsearch(counter, common_val_root, darshan_common_vals_compare);
-        found = *(struct darshan_common_val_counter**)tmp;
-        /* if we get a new answer out here we are in trouble; this was
-         * already checked with the tfind()
-         */
-        assert(found == counter);
+    /* we can add a new one as long as we haven't hit the limit */
+    if(*common_val_count >= DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT)
+        return(NULL);
 
-        (*common_val_count)++;
-    }
+    counter = (struct darshan_common_val_counter *)
+        &table->counters[*common_val_count * counter_size];
+    memcpy(counter->vals, vals, sizeof(*vals) * nvals);
+    counter->nvals = nvals;
+    counter->freq = 1;
+    (*common_val_count)++;
+    table->index[slot] = *common_val_count;
 
-    return(found);
+    return(counter);
 }
 
 #ifdef HAVE_MPI
@@ -269,6 +897,168 @@ void darshan_variance_reduce(void *invec, void *inoutvec, int *len,
 
     return;
 }
+
+/* layout of the elements reduced by darshan_shared_record_reduce(): a
+ * record followed by its variance state, if any. Set for the duration of
+ * the reduction, which is only issued by one module at a time.
+ */
+static MPI_User_function *shared_redux_rec_op;
+static size_t shared_redux_rec_size;
+static int shared_redux_var_count;
+
+static void darshan_shared_record_reduce_op(void *invec, void *inoutvec,
+    int *len, MPI_Datatype *dt)
+{
+    size_t elem_size = shared_redux_rec_size +
+        shared_redux_var_count * sizeof(struct darshan_variance_dt);
+    char *in = invec;
+    char *inout = inoutvec;
+    int one = 1;
+    int i;
+
+    for(i = 0; i < *len; i++)
+    {
+        shared_redux_rec_op(in, inout, &one, dt);
+        if(shared_redux_var_count)
+            darshan_variance_reduce(in + shared_redux_rec_size,
+                inout + shared_redux_rec_size, &shared_redux_var_count, dt);
+        in += elem_size;
+        inout += elem_size;
+    }
+
+    return;
+}
+
+int darshan_shared_record_reduce(MPI_Comm comm, void *recs, void *out_recs,
+    int count, size_t rec_size, MPI_User_function *rec_op, double *var_vals,
+    int var_count)
+{
+    size_t elem_size = rec_size + var_count * sizeof(struct darshan_variance_dt);
+    struct darshan_variance_dt *var;
+    char *send_buf;
+    char *recv_buf = NULL;
+    char *chunk_buf;
+    MPI_Datatype elem_dt;
+    MPI_Op elem_op;
+    MPI_Request *reqs;
+    int rank, nprocs;
+    int chunk_recs, chunk_cnt, chunk_first, chunk_len;
+    int my_chunk_cnt = 0;
+    int req_cnt = 0;
+    int root;
+    int i, j, k;
+
+    PMPI_Comm_rank(comm, &rank);
+    PMPI_Comm_size(comm, &nprocs);
+
+    chunk_recs = DARSHAN_SHARED_REDUX_CHUNK_SIZE / elem_size;
+    if(chunk_recs < 1)
+        chunk_recs = 1;
+    chunk_cnt = (count + chunk_recs - 1) / chunk_recs;
+
+    /* chunk i is reduced at rank (i % nprocs); rank 0 receives the whole
+     * result, and every other rank only the chunks it reduces
+     */
+    if(rank == 0)
+        my_chunk_cnt = chunk_cnt;
+    else if(rank < chunk_cnt)
+        my_chunk_cnt = (chunk_cnt - rank + nprocs - 1) / nprocs;
+
+    send_buf = malloc(count * elem_size);
+    if(my_chunk_cnt)
+        recv_buf = malloc(my_chunk_cnt * chunk_recs * elem_size);
+    reqs = malloc(2 * chunk_cnt * sizeof(*reqs));
+    if(!send_buf || (my_chunk_cnt && !recv_buf) || (chunk_cnt && !reqs))
+    {
+        free(send_buf);
+        free(recv_buf);
+        free(reqs);
+        return(-1);
+    }
+
+    /* pair each record with the initial state of its variances */
+    for(i = 0; i < count; i++)
+    {
+        memcpy(send_buf + i * elem_size, (char *)recs + i * rec_size, rec_size);
+        var = (struct darshan_variance_dt *)(send_buf + i * elem_size + rec_size);
+        for(j = 0; j < var_count; j++)
+        {
+            var[j].n = 1;
+            var[j].T = var_vals[i * var_count + j];
+            var[j].S = 0;
+        }
+    }
+
+    PMPI_Type_contiguous(elem_size, MPI_BYTE, &elem_dt);
+    PMPI_Type_commit(&elem_dt);
+    shared_redux_rec_op = rec_op;
+    shared_redux_rec_size = rec_size;
+    shared_redux_var_count = var_count;
+    PMPI_Op_create(darshan_shared_record_reduce_op, 1, &elem_op);
+
+    /* start the reduction of every chunk, with rank 0 also receiving the
+     * chunks reduced at other ranks
+     */
+    for(i = 0, k = 0; i < chunk_cnt; i++)
+    {
+        chunk_first = i * chunk_recs;
+        chunk_len = count - chunk_first;
+        if(chunk_len > chunk_recs)
+            chunk_len = chunk_recs;
+        root = i % nprocs;
+
+        chunk_buf = NULL;
+        if(rank == 0)
+            chunk_buf = recv_buf + chunk_first * elem_size;
+        else if(rank == root)
+            chunk_buf = recv_buf + (k++) * chunk_recs * elem_size;
+
+#if MPI_VERSION >= 3
+        PMPI_Ireduce(send_buf + chunk_first * elem_size, chunk_buf, chunk_len,
+            elem_dt, elem_op, root, comm, &reqs[req_cnt++]);
+#else
+        PMPI_Reduce(send_buf + chunk_first * elem_size, chunk_buf, chunk_len,
+            elem_dt, elem_op, root, comm);
+#endif
+        if(rank == 0 && root != 0)
+            PMPI_Irecv(chunk_buf, chunk_len, elem_dt, root, 0, comm,
+                &reqs[req_cnt++]);
+    }
+    PMPI_Waitall(req_cnt, reqs, MPI_STATUSES_IGNORE);
+
+    /* forward the chunks reduced here to rank 0, in order */
+    if(rank != 0)
+    {
+        for(i = rank, k = 0; i < chunk_cnt; i += nprocs, k++)
+        {
+            chunk_len = count - i * chunk_recs;
+            if(chunk_len > chunk_recs)
+                chunk_len = chunk_recs;
+            PMPI_Send(recv_buf + k * chunk_recs * elem_size, chunk_len,
+                elem_dt, 0, 0, comm);
+        }
+    }
+    else
+    {
+        for(i = 0; i < count; i++)
+        {
+            memcpy((char *)out_recs + i * rec_size, recv_buf + i * elem_size,
+                rec_size);
+            var = (struct darshan_variance_dt *)(recv_buf + i * elem_size +
+                rec_size);
+            for(j = 0; j < var_count; j++)
+                var_vals[i * var_count + j] = var[j].S / var[j].n;
+        }
+    }
+
+    PMPI_Type_free(&elem_dt);
+    PMPI_Op_free(&elem_op);
+    free(send_buf);
+    free(recv_buf);
+    free(reqs);
+
+    return(0);
+}
 #endif
 
 /*
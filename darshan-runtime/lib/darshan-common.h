@@ -15,13 +15,19 @@
  * the operation, and __last is the timestamp of the end of the previous
  * I/O operation (which we don't want to overlap with).
  */
-#define DARSHAN_TIMER_INC_NO_OVERLAP(__timer, __tm1, __tm2, __last) do{ \
+#define DARSHAN_TIMER_INC_NO_OVERLAP(__timer, __tm1, __tm2, __last) \
+    DARSHAN_TIMER_INC_NO_OVERLAP_SCALED(__timer, __tm1, __tm2, __last, 1)
+
+/* as above, but for an operation sampled from about __scale operations,
+ * each of which is assumed to take as long
+ */
+#define DARSHAN_TIMER_INC_NO_OVERLAP_SCALED(__timer, __tm1, __tm2, __last, __scale) do{ \
     if (__tm1 == 0.0 || __tm2 == 0.0) \
         break; \
     if(__tm1 > __last) \
-        __timer += (__tm2 - __tm1); \
+        __timer += (__tm2 - __tm1) * (__scale); \
     else \
-        __timer += (__tm2 - __last); \
+        __timer += (__tm2 - __last) * (__scale); \
     if(__tm2 > __last) \
         __last = __tm2; \
 } while(0)
@@ -137,9 +143,9 @@
 
 struct darshan_common_val_counter
 {
-    int64_t vals[DARSHAN_COMMON_VAL_MAX_NCOUNTERS];
     int nvals;
     int freq;
+    int64_t vals[];
 };
 
 /* i/o type (read or write) */
@@ -242,6 +248,134 @@ void darshan_iter_record_refs(
     void (*iter_action)(void *, void *),
     void *user_ptr);
 
+/* darshan_arena_alloc()
+ *
+ * Allocate 'size' bytes of zeroed memory from the slab arena whose address
+ * is stored in the 'arena_p' pointer, creating the arena if needed. Arenas
+ * are intended for the many small, fixed-size structures a module keeps for
+ * each record (e.g., record references and their hash table entries): these
+ * are carved out of large chunks, and freed objects are recycled through
+ * per-size free lists, so the instrumented application's heap sees only an
+ * occasional chunk-sized allocation. Arenas are not thread safe; callers
+ * are expected to serialize access (e.g., with their module lock).
+ * Returns a pointer to the allocated memory on success, NULL on failure.
+ */
+void *darshan_arena_alloc(
+    void **arena_p,
+    size_t size);
+
+/* darshan_arena_free()
+ *
+ * Return memory at 'ptr' of size 'size' (as passed to darshan_arena_alloc)
+ * to the slab arena 'arena' so that it can be reused by later allocations.
+ */
+void darshan_arena_free(
+    void *arena,
+    void *ptr,
+    size_t size);
+
+/* darshan_arena_destroy()
+ *
+ * Free all memory allocated from the slab arena whose address is stored
+ * in the 'arena_p' pointer in a single pass, then free the arena itself.
+ */
+void darshan_arena_destroy(
+    void **arena_p);
+
+/* darshan_arena_add_record_ref()
+ *
+ * Same as darshan_add_record_ref(), but the hash table entry is allocated
+ * from the slab arena whose address is stored in 'arena_p'.
+ */
+int darshan_arena_add_record_ref(
+    void **arena_p,
+    void **hash_head_p,
+    void *handle,
+    size_t handle_sz,
+    void *rec_ref_p);
+
+/* darshan_arena_delete_record_ref()
+ *
+ * Same as darshan_delete_record_ref(), for record references that were
+ * added using darshan_arena_add_record_ref() with slab arena 'arena'.
+ */
+void *darshan_arena_delete_record_ref(
+    void *arena,
+    void **hash_head_p,
+    void *handle,
+    size_t handle_sz);
+
+/* darshan_arena_clear_record_refs()
+ *
+ * Clear all record references from the hash table stored in the
+ * 'hash_head_p' pointer, for record references that were added using
+ * darshan_arena_add_record_ref(). Neither the hash table entries nor
+ * the record reference pointers are freed; that memory is released
+ * when the corresponding arena is destroyed.
+ */
+void darshan_arena_clear_record_refs(
+    void **hash_head_p);
+
+/* track opaque record references directly indexed by file descriptor */
+struct darshan_fd_ref_table
+{
+    int size;
+    void *rec_refs[];
+};
+
+/* darshan_lookup_fd_ref()
+ *
+ * Lookup a record reference pointer using the given file descriptor 'fd'
+ * in the fd reference table 'fd_table'. Unlike the hash-based record
+ * reference interface above, this is a single array access, which makes
+ * it suitable for the read/write paths of fd-based modules.
+ * If a reference is found, the corresponding record reference pointer
+ * is returned, otherwise NULL is returned.
+ */
+static inline void *darshan_lookup_fd_ref(void *fd_table, int fd)
+{
+    struct darshan_fd_ref_table *table = (struct darshan_fd_ref_table *)fd_table;
+
+    if(!table || fd < 0 || fd >= table->size)
+        return(NULL);
+    return(table->rec_refs[fd]);
+}
+
+/* darshan_add_fd_ref()
+ *
+ * Add the given record reference pointer, 'rec_ref_p', to the fd reference
+ * table whose address is stored in the 'fd_table_p' pointer, indexed by
+ * file descriptor 'fd'. Any existing reference for 'fd' is replaced. The
+ * table is grown as needed to accommodate 'fd'.
+ * If the record reference is successfully added, 1 is returned,
+ * otherwise, 0 is returned.
+ */
+int darshan_add_fd_ref(
+    void **fd_table_p,
+    int fd,
+    void *rec_ref_p);
+
+/* darshan_delete_fd_ref()
+ *
+ * Delete the record reference for file descriptor 'fd' from the fd
+ * reference table whose address is stored in the 'fd_table_p' pointer.
+ * On success deletion, the corresponding record reference pointer
+ * is returned, otherwise NULL is returned.
+ */
+void *darshan_delete_fd_ref(
+    void **fd_table_p,
+    int fd);
+
+/* darshan_clear_fd_refs()
+ *
+ * Clear all record references from the fd reference table stored in the
+ * 'fd_table_p' pointer and free the table. If 'free_flag' is set, the
+ * corresponding record reference pointers are also freed.
+ */
+void darshan_clear_fd_refs(
+    void **fd_table_p,
+    int free_flag);
+
 /* darshan_clean_file_path()
  *
  * Allocate a new string that contains a new cleaned-up version of
@@ -252,6 +386,42 @@ void darshan_iter_record_refs(
 char* darshan_clean_file_path(
     const char *path);
 
+/* darshan_clean_file_path_buf()
+ *
+ * Same as darshan_clean_file_path(), but writes the cleaned-up path into
+ * the caller-provided buffer 'buf' of size 'buf_sz' rather than allocating
+ * it. Returns 'buf' on success, or NULL if the path can not be cleaned or
+ * does not fit in the buffer. Relative paths are resolved against a cached
+ * copy of the working directory.
+ */
+char* darshan_clean_file_path_buf(
+    const char *path,
+    char *buf,
+    size_t buf_sz);
+
+/* darshan_invalidate_cwd_cache()
+ *
+ * Discard the cached working directory used to resolve relative paths.
+ * Must be called whenever the process changes its working directory.
+ */
+void darshan_invalidate_cwd_cache(void);
+
+/* darshan_path_record_id()
+ *
+ * Returns the record id of the file path 'path', the same as
+ * darshan_core_gen_record_id() would for its cleaned-up form. Ids are
+ * memoized per thread, so that repeated opens of a path skip cleaning and
+ * hashing it. On a memo miss the path is cleaned into 'buf' (of size
+ * 'buf_sz') and '*newpath' is set to the cleaned path, or to 'path' if it
+ * could not be cleaned; on a hit '*newpath' is set to NULL, and callers
+ * that need the record name must clean the path themselves.
+ */
+darshan_record_id darshan_path_record_id(
+    const char *path,
+    char *buf,
+    size_t buf_sz,
+    char **newpath);
+
 /* darshan_record_sort()
  *
  * Sort the records in 'rec_buf' by descending rank to get all
@@ -268,15 +438,21 @@ void darshan_record_sort(
 
 /* darshan_track_common_val_counters()
  *
- * Potentially increment an existing common value counter or allocate
+ * Potentially increment an existing common value counter or add
  * a new one to keep track of commonly occuring values. Example use
  * cases would be to track the most frequent access sizes or strides
  * used by a specific module, for instance. 'common_val_root' is the
- * root pointer for the tree which stores common value info,
- * 'common_val_count' is a pointer to the number of nodes in the
- * tree (i.e., the number of allocated common value counters), 'vals'
+ * root pointer for the table which stores common value info,
+ * 'common_val_count' is a pointer to the number of counters in the
+ * table (i.e., the number of distinct values tracked so far), 'vals'
  * is the set of new values to attempt to add, and 'nvals' is the
  * total number of values in the 'vals' pointer.
+ *
+ * NOTE: the table is a fixed-capacity, open-addressed hash table holding
+ * the first DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT distinct values seen. It
+ * is allocated in a single block on first use (so callers simply free()
+ * 'common_val_root' when done) and never grows afterwards. 'nvals' must
+ * be the same for every call on a given table.
  */
 struct darshan_common_val_counter *darshan_track_common_val_counters(
     void **common_val_root,
@@ -301,6 +477,29 @@ void darshan_variance_reduce(
     void *inoutvec,
     int *len,
     MPI_Datatype *dt);
+
+/* darshan_shared_record_reduce()
+ *
+ * Reduce the given array of 'count' shared records, each 'rec_size' bytes
+ * long, across all processes in 'comm' into 'out_recs' on rank 0, merging
+ * records with 'rec_op' (the reduction operation a module would otherwise
+ * pass to MPI_Op_create). If 'var_count' is nonzero, 'var_vals' holds
+ * 'var_count' values for each record whose variance across processes is
+ * computed in the same pass (using darshan_variance_reduce()) and returned
+ * in 'var_vals' on rank 0. The records are reduced in chunks, each to a
+ * different process, and the chunks are then gathered on rank 0, so that
+ * large reductions are pipelined and their work is spread across
+ * processes. Returns 0 on success, or -1 if unable to allocate memory.
+ */
+int darshan_shared_record_reduce(
+    MPI_Comm comm,
+    void *recs,
+    void *out_recs,
+    int count,
+    size_t rec_size,
+    MPI_User_function *rec_op,
+    double *var_vals,
+    int var_count);
 #endif
 
 #endif /* __DARSHAN_COMMON_H */
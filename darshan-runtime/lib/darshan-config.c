@@ -79,6 +79,55 @@ static uint64_t darshan_module_csv_to_flags(char *mod_csv)
     return(mod_flags);
 }
 
+/* map a compression method name to the corresponding log compression type;
+ * zstd falls back to zlib if this library was built without it
+ */
+static int darshan_comp_str_to_type(const char *comp_str, int *comp_type)
+{
+    if(strcmp(comp_str, "zlib") == 0)
+        *comp_type = DARSHAN_ZLIB_COMP;
+    else if(strcmp(comp_str, "zstd") == 0)
+    {
+#ifdef HAVE_LIBZSTD
+        *comp_type = DARSHAN_ZSTD_COMP;
+#else
+        darshan_core_fprintf(stderr, "darshan library warning: "\
+            "zstd compression not available, using zlib\n");
+        *comp_type = DARSHAN_ZLIB_COMP;
+#endif
+    }
+    else
+        return(-1);
+
+    return(0);
+}
+
+/* map a huge page policy name to the corresponding DARSHAN_HUGEPAGES_* */
+static int darshan_hugepages_str_to_policy(const char *str, int *policy)
+{
+    if(strcmp(str, "thp") == 0)
+        *policy = DARSHAN_HUGEPAGES_THP;
+    else if(strcmp(str, "hugetlb") == 0)
+        *policy = DARSHAN_HUGEPAGES_HUGETLB;
+    else
+        return(-1);
+
+    return(0);
+}
+
+/* map a heatmap reduction name to the corresponding DARSHAN_HEATMAP_REDUCE_* */
+static int darshan_heatmap_str_to_reduce(const char *str, int *reduce)
+{
+    if(strcmp(str, "node") == 0)
+        *reduce = DARSHAN_HEATMAP_REDUCE_NODE;
+    else if(strcmp(str, "job") == 0)
+        *reduce = DARSHAN_HEATMAP_REDUCE_JOB;
+    else
+        return(-1);
+
+    return(0);
+}
+
 void darshan_init_config(struct darshan_config *cfg)
 {
     cfg->mod_mem = DARSHAN_MOD_MEM_MAX;
@@ -86,15 +135,20 @@ void darshan_init_config(struct darshan_config *cfg)
     cfg->mem_alignment = __DARSHAN_MEM_ALIGNMENT;
     cfg->jobid_env = strdup(__DARSHAN_JOBID);
     cfg->log_hints = strdup(__DARSHAN_LOG_HINTS);
+    cfg->log_comp_type = DARSHAN_ZLIB_COMP;
 #ifdef __DARSHAN_LOG_PATH
     cfg->log_path = strdup(__DARSHAN_LOG_PATH);
 #endif
 #ifdef __DARSHAN_ENABLE_MMAP_LOGS
     cfg->mmap_log_path = strdup(DARSHAN_DEF_MMAP_LOG_PATH);
 #endif
-    /* enable all modules except DXT by default */
+    /* enable all modules except DXT, LATENCY, TIMESERIES and MMAP by default */
     DARSHAN_MOD_FLAG_SET(cfg->mod_disabled, DXT_POSIX_MOD);
     DARSHAN_MOD_FLAG_SET(cfg->mod_disabled, DXT_MPIIO_MOD);
+    DARSHAN_MOD_FLAG_SET(cfg->mod_disabled, DXT_STDIO_MOD);
+    DARSHAN_MOD_FLAG_SET(cfg->mod_disabled, DARSHAN_LATENCY_MOD);
+    DARSHAN_MOD_FLAG_SET(cfg->mod_disabled, DARSHAN_TIMESERIES_MOD);
+    DARSHAN_MOD_FLAG_SET(cfg->mod_disabled, DARSHAN_MMAP_MOD);
 #ifndef DARSHAN_BGQ
     DARSHAN_MOD_FLAG_SET(cfg->mod_disabled, DARSHAN_BGQ_MOD);
 #endif
@@ -139,6 +193,14 @@ void darshan_parse_config_env(struct darshan_config *cfg)
         if(success)
             cfg->mod_mem *= (1024 * 1024); /* convert from MiB */
     }
+    /* allow module memory to grow on demand, up to the given cap */
+    envstr = getenv(DARSHAN_MOD_MEM_GROW_OVERRIDE);
+    if(envstr)
+    {
+        DARSHAN_PARSE_NUMBER_FROM_STR(envstr, size_t, cfg->mod_mem_grow, success);
+        if(success)
+            cfg->mod_mem_grow *= (1024 * 1024); /* convert from MiB */
+    }
     /* allow override of memory quota for darshan name records */
     envstr = getenv(DARSHAN_NAME_MEM_OVERRIDE);
     if(envstr)
@@ -175,8 +237,44 @@ void darshan_parse_config_env(struct darshan_config *cfg)
     {
         /* free current log hints and allocate a new one */
         free(cfg->log_hints);
+    free(cfg->log_comp_dict);
         cfg->log_hints = strdup(envstr);
     }
+    /* allow override of log file compression method */
+    envstr = getenv(DARSHAN_LOG_COMP_OVERRIDE);
+    if(envstr)
+    {
+        ret = darshan_comp_str_to_type(envstr, &cfg->log_comp_type);
+        if(ret < 0)
+            darshan_core_fprintf(stderr, "darshan library warning: "\
+                "invalid %s value %s\n", DARSHAN_LOG_COMP_OVERRIDE, envstr);
+    }
+    /* allow a trained zstd dictionary to be used for log file compression */
+    envstr = getenv(DARSHAN_LOG_COMP_DICT_OVERRIDE);
+    if(envstr)
+    {
+        free(cfg->log_comp_dict);
+        cfg->log_comp_dict = strdup(envstr);
+    }
+    /* allow darshan's buffers to be backed by huge pages */
+    envstr = getenv(DARSHAN_HUGEPAGES_OVERRIDE);
+    if(envstr)
+    {
+        ret = darshan_hugepages_str_to_policy(envstr, &cfg->mem_hugepages);
+        if(ret < 0)
+            darshan_core_fprintf(stderr, "darshan library warning: "\
+                "invalid %s value %s\n", DARSHAN_HUGEPAGES_OVERRIDE, envstr);
+    }
+    /* allow heatmaps to be summed across ranks */
+    envstr = getenv(DARSHAN_HEATMAP_REDUCE_OVERRIDE);
+    if(envstr)
+    {
+        ret = darshan_heatmap_str_to_reduce(envstr, &cfg->heatmap_reduce);
+        if(ret < 0)
+            darshan_core_fprintf(stderr, "darshan library warning: "\
+                "invalid %s value %s\n", DARSHAN_HEATMAP_REDUCE_OVERRIDE,
+                envstr);
+    }
     /* allow override of darshan log file directory */
     envstr = getenv(DARSHAN_LOG_PATH_OVERRIDE);
     if(envstr)
@@ -442,12 +540,130 @@ void darshan_parse_config_env(struct darshan_config *cfg)
             }
         }
     }
+    envstr = getenv("DARSHAN_DXT_TRIGGER_WARMUP");
+    if(envstr)
+    {
+        double warmup;
+        DARSHAN_PARSE_NUMBER_FROM_STR(envstr, double, warmup, success);
+        if(success && warmup >= 0)
+            cfg->dxt_trigger_warmup = (size_t)warmup;
+    }
+    envstr = getenv("DARSHAN_DXT_RING_SEGMENTS");
+    if(envstr)
+    {
+        double ring_segs;
+        DARSHAN_PARSE_NUMBER_FROM_STR(envstr, double, ring_segs, success);
+        if(success && ring_segs >= 0)
+            cfg->dxt_ring_segments = (size_t)ring_segs;
+    }
+    envstr = getenv("DARSHAN_STDIO_BATCH_SMALL");
+    if(envstr)
+    {
+        double sample;
+        DARSHAN_PARSE_NUMBER_FROM_STR(envstr, double, sample, success);
+        if(success && sample >= 0)
+            cfg->stdio_batch_small = (size_t)sample;
+    }
+    envstr = getenv("DARSHAN_SAMPLE_RATE");
+    if(envstr)
+    {
+        double rate;
+        DARSHAN_PARSE_NUMBER_FROM_STR(envstr, double, rate, success);
+        if(success && rate >= 0)
+        {
+            /* applies to every module, overriding the config file */
+            for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+                cfg->mod_sample_rate[i] = (size_t)rate;
+        }
+    }
+    envstr = getenv("DARSHAN_TIMESERIES_INTERVAL");
+    if(envstr)
+    {
+        double interval;
+        DARSHAN_PARSE_NUMBER_FROM_STR(envstr, double, interval, success);
+        if(success && interval > 0)
+            cfg->timeseries_interval = interval;
+    }
+    envstr = getenv("DARSHAN_MMAP_SAMPLE_INTERVAL");
+    if(envstr)
+    {
+        double interval;
+        DARSHAN_PARSE_NUMBER_FROM_STR(envstr, double, interval, success);
+        if(success && interval > 0)
+            cfg->mmap_sample_interval = interval;
+    }
+    envstr = getenv("DARSHAN_DIR_ROLLUP_THRESHOLD");
+    if(envstr)
+    {
+        double threshold;
+        DARSHAN_PARSE_NUMBER_FROM_STR(envstr, double, threshold, success);
+        if(success && threshold >= 0)
+            cfg->dir_rollup_threshold = (size_t)threshold;
+    }
+    envstr = getenv("DARSHAN_PHASE_BARRIERS");
+    if(envstr)
+    {
+        double barriers;
+        DARSHAN_PARSE_NUMBER_FROM_STR(envstr, double, barriers, success);
+        if(success && barriers >= 0)
+            cfg->phase_barriers = (size_t)barriers;
+    }
+    envstr = getenv("DARSHAN_RECORD_RETIRE_TIME");
+    if(envstr)
+    {
+        double retire_time;
+        DARSHAN_PARSE_NUMBER_FROM_STR(envstr, double, retire_time, success);
+        if(success && retire_time >= 0)
+            cfg->record_retire_time = retire_time;
+    }
+    envstr = getenv("DARSHAN_SHUTDOWN_DEADLINE");
+    if(envstr)
+    {
+        double deadline;
+        DARSHAN_PARSE_NUMBER_FROM_STR(envstr, double, deadline, success);
+        if(success && deadline >= 0)
+            cfg->shutdown_deadline = deadline;
+    }
+    envstr = getenv("DARSHAN_LOG_INDEX_BLOCK_RECS");
+    if(envstr)
+    {
+        double block_recs;
+        DARSHAN_PARSE_NUMBER_FROM_STR(envstr, double, block_recs, success);
+        if(success && block_recs >= 0)
+            cfg->log_index_block_recs = (size_t)block_recs;
+    }
+    if(getenv("DARSHAN_LOG_COLUMNAR"))
+        cfg->log_columnar_flag = 1;
     if(getenv("DARSHAN_DUMP_CONFIG"))
         cfg->dump_config_flag = 1;
     if(getenv("DARSHAN_INTERNAL_TIMING"))
         cfg->internal_timing_flag = 1;
     if(getenv("DARSHAN_DISABLE_SHARED_REDUCTION"))
         cfg->disable_shared_redux_flag = 1;
+    if(getenv("DARSHAN_DISABLE_SPARSE_SHUTDOWN"))
+        cfg->disable_sparse_shutdown_flag = 1;
+    if(getenv("DARSHAN_THREAD_SHARDS"))
+        cfg->thread_shards_flag = 1;
+    if(getenv("DARSHAN_PIPELINED_SHUTDOWN"))
+        cfg->pipelined_shutdown_flag = 1;
+    if(getenv("DARSHAN_NODE_AGGREGATION"))
+        cfg->node_agg_flag = 1;
+    if(getenv("DARSHAN_NODE_MOUNTS"))
+        cfg->node_mounts_flag = 1;
+    if(getenv("DARSHAN_COLLECT_CHILDREN"))
+        cfg->collect_children_flag = 1;
+    if(getenv("DARSHAN_MEM_FIRST_TOUCH"))
+        cfg->mem_first_touch_flag = 1;
+    if(getenv("DARSHAN_DXT_SPILL"))
+        cfg->dxt_spill_flag = 1;
+    if(getenv("DARSHAN_HEATMAP_OPS"))
+        cfg->heatmap_ops_flag = 1;
+    if(getenv("DARSHAN_MPIIO_COLL_WAIT"))
+        cfg->mpiio_coll_wait_flag = 1;
+    if(getenv("DARSHAN_LUSTRE_LAYOUT_CACHE"))
+        cfg->lustre_layout_cache_flag = 1;
+    if(getenv("DARSHAN_LUSTRE_OST_TRAFFIC"))
+        cfg->lustre_ost_traffic_flag = 1;
 
     /* apply disabled/enabled module flags */
     cfg->mod_disabled |= cfg->mod_disabled_flags;
@@ -456,12 +672,76 @@ void darshan_parse_config_env(struct darshan_config *cfg)
     return;
 }
 
-void darshan_parse_config_file(struct darshan_config *cfg)
+char *darshan_read_config_file(size_t *len)
 {
     char *darshan_conf;
+    FILE *fp;
+    char *buf = NULL;
+    size_t max = 0;
+    size_t nread;
+
+    *len = 0;
+
+    /* get log filters file */
+    darshan_conf = getenv("DARSHAN_CONFIG_PATH");
+    if(!darshan_conf)
+        return(NULL);
+
+    fp = fopen(darshan_conf, "r");
+    if(!fp)
+    {
+        darshan_core_fprintf(stderr, "darshan library warning: "\
+            "unable to open Darshan config at path %s\n", darshan_conf);
+        return(NULL);
+    }
+
+    do
+    {
+        if(*len == max)
+        {
+            char *tmp_buf;
+
+            max = max ? max * 2 : 4096;
+            tmp_buf = realloc(buf, max + 1);
+            if(!tmp_buf)
+            {
+                free(buf);
+                fclose(fp);
+                *len = 0;
+                return(NULL);
+            }
+            buf = tmp_buf;
+        }
+        nread = fread(buf + *len, 1, max - *len, fp);
+        *len += nread;
+    } while(nread > 0);
+    buf[*len] = '\0';
+
+    fclose(fp);
+    return(buf);
+}
+
+void darshan_parse_config_file(struct darshan_config *cfg)
+{
+    char *buf;
+    size_t len;
+
+    buf = darshan_read_config_file(&len);
+    if(buf)
+    {
+        darshan_parse_config_buf(cfg, buf, len);
+        free(buf);
+    }
+
+    return;
+}
+
+void darshan_parse_config_buf(struct darshan_config *cfg, char *buf,
+    size_t len)
+{
     FILE *fp;
     char *line = NULL;
-    size_t len = 0;
+    size_t line_len = 0;
     char *key, *val, *mods;
     char *token;
     uint64_t tmp_mod_flags;
@@ -471,19 +751,14 @@ void darshan_parse_config_file(struct darshan_config *cfg)
     int ret;
     int success;
 
-    /* get log filters file */
-    darshan_conf = getenv("DARSHAN_CONFIG_PATH");
-    if(darshan_conf)
+    /* parse the file contents line by line, as if reading the file */
+    if(len > 0)
     {
-        fp = fopen(darshan_conf, "r");
+        fp = fmemopen(buf, len, "r");
         if(!fp)
-        {
-            darshan_core_fprintf(stderr, "darshan library warning: "\
-                "unable to open Darshan config at path %s\n", darshan_conf);
             return;
-        }
 
-        while(getline(&line, &len, fp) != -1)
+        while(getline(&line, &line_len, fp) != -1)
         {
             const char *c = line;
             while(isspace((unsigned char)*c))
@@ -506,6 +781,13 @@ void darshan_parse_config_file(struct darshan_config *cfg)
                 if(success)
                     cfg->mod_mem *= (1024 * 1024); /* convert from MiB */
             }
+            else if(strcmp(key, "MODMEM_GROW") == 0)
+            {
+                val = strtok(NULL, " \t");
+                DARSHAN_PARSE_NUMBER_FROM_STR(val, size_t, cfg->mod_mem_grow, success);
+                if(success)
+                    cfg->mod_mem_grow *= (1024 * 1024); /* convert from MiB */
+            }
             else if(strcmp(key, "NAMEMEM") == 0)
             {
                 val = strtok(NULL, " \t");
@@ -544,6 +826,39 @@ void darshan_parse_config_file(struct darshan_config *cfg)
                 else
                     cfg->log_hints = strdup("");
             }
+            else if(strcmp(key, "LOGCOMP") == 0)
+            {
+                val = strtok(NULL, " \t");
+                if(!val || darshan_comp_str_to_type(val, &cfg->log_comp_type) < 0)
+                {
+                    darshan_core_fprintf(stderr, "darshan library warning: "\
+                        "invalid LOGCOMP value %s\n", val ? val : "(null)");
+                    continue;
+                }
+            }
+            else if(strcmp(key, "LOGCOMP_DICT") == 0)
+            {
+                val = strtok(NULL, " \t");
+                if(!val)
+                {
+                    darshan_core_fprintf(stderr, "darshan library warning: "\
+                        "invalid LOGCOMP_DICT value (null)\n");
+                    continue;
+                }
+                free(cfg->log_comp_dict);
+                cfg->log_comp_dict = strdup(val);
+            }
+            else if(strcmp(key, "HUGEPAGES") == 0)
+            {
+                val = strtok(NULL, " \t");
+                if(!val || darshan_hugepages_str_to_policy(val,
+                    &cfg->mem_hugepages) < 0)
+                {
+                    darshan_core_fprintf(stderr, "darshan library warning: "\
+                        "invalid HUGEPAGES value %s\n", val ? val : "(null)");
+                    continue;
+                }
+            }
             else if(strcmp(key, "LOGPATH") == 0)
             {
                 val = strtok(NULL, " \t");
@@ -709,6 +1024,24 @@ void darshan_parse_config_file(struct darshan_config *cfg)
                     }
                 }
             }
+            else if(strcmp(key, "SAMPLE_RATE") == 0)
+            {
+                val = strtok(NULL, " \t");
+                DARSHAN_PARSE_NUMBER_FROM_STR(val, size_t, tmpmax, success);
+                if(success)
+                {
+                    mods = strtok(NULL, " \t");
+                    if(mods)
+                    {
+                        tmp_mod_flags = darshan_module_csv_to_flags(mods);
+                        for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+                        {
+                            if(DARSHAN_MOD_FLAG_ISSET(tmp_mod_flags, i))
+                                cfg->mod_sample_rate[i] = tmpmax;
+                        }
+                    }
+                }
+            }
             else if(strcmp(key, "NAME_EXCLUDE") == 0)
             {
                 val = strtok(NULL, " \t");
@@ -823,12 +1156,130 @@ void darshan_parse_config_file(struct darshan_config *cfg)
                     }
                 }
             }
+            else if(strcmp(key, "DXT_TRIGGER_WARMUP") == 0)
+            {
+                double warmup;
+                val = strtok(NULL, " \t");
+                DARSHAN_PARSE_NUMBER_FROM_STR(val, double, warmup, success);
+                if(success && warmup >= 0)
+                    cfg->dxt_trigger_warmup = (size_t)warmup;
+            }
+            else if(strcmp(key, "DXT_RING_SEGMENTS") == 0)
+            {
+                double ring_segs;
+                val = strtok(NULL, " \t");
+                DARSHAN_PARSE_NUMBER_FROM_STR(val, double, ring_segs, success);
+                if(success && ring_segs >= 0)
+                    cfg->dxt_ring_segments = (size_t)ring_segs;
+            }
+            else if(strcmp(key, "STDIO_BATCH_SMALL") == 0)
+            {
+                double sample;
+                val = strtok(NULL, " \t");
+                DARSHAN_PARSE_NUMBER_FROM_STR(val, double, sample, success);
+                if(success && sample >= 0)
+                    cfg->stdio_batch_small = (size_t)sample;
+            }
+            else if(strcmp(key, "TIMESERIES_INTERVAL") == 0)
+            {
+                double interval;
+                val = strtok(NULL, " \t");
+                DARSHAN_PARSE_NUMBER_FROM_STR(val, double, interval, success);
+                if(success && interval > 0)
+                    cfg->timeseries_interval = interval;
+            }
+            else if(strcmp(key, "MMAP_SAMPLE_INTERVAL") == 0)
+            {
+                double interval;
+                val = strtok(NULL, " \t");
+                DARSHAN_PARSE_NUMBER_FROM_STR(val, double, interval, success);
+                if(success && interval > 0)
+                    cfg->mmap_sample_interval = interval;
+            }
+            else if(strcmp(key, "DIR_ROLLUP_THRESHOLD") == 0)
+            {
+                double threshold;
+                val = strtok(NULL, " \t");
+                DARSHAN_PARSE_NUMBER_FROM_STR(val, double, threshold, success);
+                if(success && threshold >= 0)
+                    cfg->dir_rollup_threshold = (size_t)threshold;
+            }
+            else if(strcmp(key, "PHASE_BARRIERS") == 0)
+            {
+                double barriers;
+                val = strtok(NULL, " \t");
+                DARSHAN_PARSE_NUMBER_FROM_STR(val, double, barriers, success);
+                if(success && barriers >= 0)
+                    cfg->phase_barriers = (size_t)barriers;
+            }
+            else if(strcmp(key, "RECORD_RETIRE_TIME") == 0)
+            {
+                double retire_time;
+                val = strtok(NULL, " \t");
+                DARSHAN_PARSE_NUMBER_FROM_STR(val, double, retire_time, success);
+                if(success && retire_time >= 0)
+                    cfg->record_retire_time = retire_time;
+            }
+            else if(strcmp(key, "SHUTDOWN_DEADLINE") == 0)
+            {
+                double deadline;
+                val = strtok(NULL, " \t");
+                DARSHAN_PARSE_NUMBER_FROM_STR(val, double, deadline, success);
+                if(success && deadline >= 0)
+                    cfg->shutdown_deadline = deadline;
+            }
+            else if(strcmp(key, "LOG_INDEX_BLOCK_RECS") == 0)
+            {
+                double block_recs;
+                val = strtok(NULL, " \t");
+                DARSHAN_PARSE_NUMBER_FROM_STR(val, double, block_recs, success);
+                if(success && block_recs >= 0)
+                    cfg->log_index_block_recs = (size_t)block_recs;
+            }
+            else if(strcmp(key, "LOG_COLUMNAR") == 0)
+                cfg->log_columnar_flag = 1;
             else if(strcmp(key, "DUMP_CONFIG") == 0)
                 cfg->dump_config_flag = 1;
             else if(strcmp(key, "INTERNAL_TIMING") == 0)
                 cfg->internal_timing_flag = 1;
             else if(strcmp(key, "DISABLE_SHARED_REDUCTION") == 0)
                 cfg->disable_shared_redux_flag = 1;
+            else if(strcmp(key, "DISABLE_SPARSE_SHUTDOWN") == 0)
+                cfg->disable_sparse_shutdown_flag = 1;
+            else if(strcmp(key, "THREAD_SHARDS") == 0)
+                cfg->thread_shards_flag = 1;
+            else if(strcmp(key, "PIPELINED_SHUTDOWN") == 0)
+                cfg->pipelined_shutdown_flag = 1;
+            else if(strcmp(key, "NODE_AGGREGATION") == 0)
+                cfg->node_agg_flag = 1;
+            else if(strcmp(key, "NODE_MOUNTS") == 0)
+                cfg->node_mounts_flag = 1;
+            else if(strcmp(key, "COLLECT_CHILDREN") == 0)
+                cfg->collect_children_flag = 1;
+            else if(strcmp(key, "MEM_FIRST_TOUCH") == 0)
+                cfg->mem_first_touch_flag = 1;
+            else if(strcmp(key, "DXT_SPILL") == 0)
+                cfg->dxt_spill_flag = 1;
+            else if(strcmp(key, "HEATMAP_OPS") == 0)
+                cfg->heatmap_ops_flag = 1;
+            else if(strcmp(key, "HEATMAP_REDUCE") == 0)
+            {
+                val = strtok(NULL, " \t");
+                if(!val || darshan_heatmap_str_to_reduce(val,
+                    &cfg->heatmap_reduce) < 0)
+                {
+                    darshan_core_fprintf(stderr, "darshan library warning: "\
+                        "invalid HEATMAP_REDUCE value %s\n",
+                        val ? val : "(null)");
+                    continue;
+                }
+            }
+            else if(strcmp(key, "MPIIO_COLL_WAIT") == 0)
+                cfg->mpiio_coll_wait_flag = 1;
+            else if(strcmp(key, "LUSTRE_LAYOUT_CACHE") == 0)
+                cfg->lustre_layout_cache_flag = 1;
+            else if(strcmp(key, "LUSTRE_OST_TRAFFIC") == 0)
+                cfg->lustre_ost_traffic_flag = 1;
             else
             {
                 darshan_core_fprintf(stderr, "darshan library warning: "\
@@ -857,11 +1308,21 @@ void darshan_dump_config(struct darshan_config *cfg)
     fprintf(stderr, "##### DARSHAN CONFIG #####\n");
     fprintf(stderr, "##########################\n");
     fprintf(stderr, "# MODMEM = %ld MiB\n", cfg->mod_mem / 1024 / 1024);
+    if(cfg->mod_mem_grow)
+        fprintf(stderr, "# MODMEM_GROW = %ld MiB\n",
+            cfg->mod_mem_grow / 1024 / 1024);
     fprintf(stderr, "# NAMEMEM = %ld KiB\n", cfg->name_mem / 1024);
     fprintf(stderr, "# MEM_ALIGNMENT = %d bytes\n", cfg->mem_alignment);
+    fprintf(stderr, "# HUGEPAGES = %s\n",
+        (cfg->mem_hugepages == DARSHAN_HUGEPAGES_HUGETLB) ? "hugetlb" :
+        (cfg->mem_hugepages == DARSHAN_HUGEPAGES_THP) ? "thp" : "NONE");
     fprintf(stderr, "# JOBID = %s\n", cfg->jobid_env);
     fprintf(stderr, "# LOGHINTS = %s\n", (strlen(cfg->log_hints) > 0) ?
         cfg->log_hints : "NONE");
+    fprintf(stderr, "# LOGCOMP = %s\n",
+        (cfg->log_comp_type == DARSHAN_ZSTD_COMP) ? "zstd" : "zlib");
+    fprintf(stderr, "# LOGCOMP_DICT = %s\n", cfg->log_comp_dict ?
+        cfg->log_comp_dict : "NONE");
     fprintf(stderr, "# LOGPATH = %s\n", cfg->log_path ? cfg->log_path : "NONE");
     fprintf(stderr, "# LOGPATH_BYENV = %s\n", cfg->log_path_byenv ?
         cfg->log_path_byenv : "NONE");
@@ -925,6 +1386,47 @@ void darshan_dump_config(struct darshan_config *cfg)
         fprintf(stderr, "# DXT_UNALIGNED_IO_TRIGGER = %.2lf\n",
             cfg->unaligned_io_trigger->u.unaligned_io.thresh_pct);
     }
+    if(cfg->dxt_trigger_warmup)
+        fprintf(stderr, "# DXT_TRIGGER_WARMUP = %zu\n", cfg->dxt_trigger_warmup);
+    if(cfg->dxt_spill_flag)
+        fprintf(stderr, "# DXT_SPILL = 1\n");
+    if(cfg->dxt_ring_segments)
+        fprintf(stderr, "# DXT_RING_SEGMENTS = %zu\n", cfg->dxt_ring_segments);
+    if(cfg->heatmap_ops_flag)
+        fprintf(stderr, "# HEATMAP_OPS = 1\n");
+    if(cfg->heatmap_reduce)
+        fprintf(stderr, "# HEATMAP_REDUCE = %s\n",
+            (cfg->heatmap_reduce == DARSHAN_HEATMAP_REDUCE_NODE) ?
+            "node" : "job");
+    if(cfg->mpiio_coll_wait_flag)
+        fprintf(stderr, "# MPIIO_COLL_WAIT = 1\n");
+    if(cfg->lustre_layout_cache_flag)
+        fprintf(stderr, "# LUSTRE_LAYOUT_CACHE = 1\n");
+    if(cfg->lustre_ost_traffic_flag)
+        fprintf(stderr, "# LUSTRE_OST_TRAFFIC = 1\n");
+    if(cfg->stdio_batch_small)
+        fprintf(stderr, "# STDIO_BATCH_SMALL = %zu\n", cfg->stdio_batch_small);
+    if(cfg->timeseries_interval > 0)
+        fprintf(stderr, "# TIMESERIES_INTERVAL = %.6f\n", cfg->timeseries_interval);
+    if(cfg->mmap_sample_interval > 0)
+        fprintf(stderr, "# MMAP_SAMPLE_INTERVAL = %.6f\n",
+            cfg->mmap_sample_interval);
+    if(cfg->dir_rollup_threshold)
+        fprintf(stderr, "# DIR_ROLLUP_THRESHOLD = %zu\n",
+            cfg->dir_rollup_threshold);
+    if(cfg->phase_barriers)
+        fprintf(stderr, "# PHASE_BARRIERS = %zu\n", cfg->phase_barriers);
+    if(cfg->record_retire_time > 0)
+        fprintf(stderr, "# RECORD_RETIRE_TIME = %.6f\n",
+            cfg->record_retire_time);
+    if(cfg->shutdown_deadline > 0)
+        fprintf(stderr, "# SHUTDOWN_DEADLINE = %.6f\n",
+            cfg->shutdown_deadline);
+    if(cfg->log_index_block_recs)
+        fprintf(stderr, "# LOG_INDEX_BLOCK_RECS = %zu\n",
+            cfg->log_index_block_recs);
+    if(cfg->log_columnar_flag)
+        fprintf(stderr, "# LOG_COLUMNAR = 1\n");
     for(i = 1; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
     {
         fprintf(stderr, "# %s MODULE CONFIG:\n", darshan_module_names[i]);
@@ -937,6 +1439,9 @@ void darshan_dump_config(struct darshan_config *cfg)
         if(cfg->mod_max_records_override[i] > 0)
             fprintf(stderr, "#      - MAX_RECORDS = %lu\n",
                 cfg->mod_max_records_override[i]);
+        if(cfg->mod_sample_rate[i] > 1)
+            fprintf(stderr, "#      - SAMPLE_RATE = %zu\n",
+                cfg->mod_sample_rate[i]);
         if(cfg->rec_exclusion_list)
         {
             first = 1;
@@ -977,6 +1482,109 @@ void darshan_dump_config(struct darshan_config *cfg)
     fprintf(stderr, "##########################\n");
 }
 
+static void darshan_path_trie_insert(
+    struct darshan_path_trie *root, const char *prefix)
+{
+    struct darshan_path_trie *node = root;
+    struct darshan_path_trie *child;
+
+    for(; *prefix; prefix++)
+    {
+        for(child = node->child; child; child = child->sibling)
+        {
+            if(child->c == *prefix)
+                break;
+        }
+        if(!child)
+        {
+            child = calloc(1, sizeof(*child));
+            assert(child);
+            child->c = *prefix;
+            child->sibling = node->child;
+            node->child = child;
+        }
+        node = child;
+    }
+    node->terminal = 1;
+
+    return;
+}
+
+static struct darshan_path_trie *darshan_path_trie_build(char **prefixes)
+{
+    struct darshan_path_trie *root;
+    int tmp_index = 0;
+
+    if(!prefixes || !prefixes[0])
+        return(NULL);
+
+    root = calloc(1, sizeof(*root));
+    assert(root);
+    while(prefixes[tmp_index])
+        darshan_path_trie_insert(root, prefixes[tmp_index++]);
+
+    return(root);
+}
+
+static void darshan_path_trie_free(struct darshan_path_trie *node)
+{
+    struct darshan_path_trie *sibling;
+
+    while(node)
+    {
+        sibling = node->sibling;
+        darshan_path_trie_free(node->child);
+        free(node);
+        node = sibling;
+    }
+
+    return;
+}
+
+void darshan_compile_config_paths(struct darshan_config *cfg)
+{
+    /* user-provided exclusions override both the default exclusions and
+     * the default inclusions
+     */
+    if(cfg->user_exclude_dirs)
+    {
+        cfg->exclude_trie = darshan_path_trie_build(cfg->user_exclude_dirs);
+        cfg->include_trie = NULL;
+    }
+    else
+    {
+        cfg->exclude_trie = darshan_path_trie_build(cfg->exclude_dirs);
+        cfg->include_trie = darshan_path_trie_build(cfg->include_dirs);
+    }
+
+    return;
+}
+
+int darshan_config_path_match(struct darshan_path_trie *trie, const char *name)
+{
+    struct darshan_path_trie *node = trie;
+
+    if(!node)
+        return(0);
+    if(node->terminal)
+        return(1);
+
+    for(; *name; name++)
+    {
+        for(node = node->child; node; node = node->sibling)
+        {
+            if(node->c == *name)
+                break;
+        }
+        if(!node)
+            return(0);
+        if(node->terminal)
+            return(1);
+    }
+
+    return(0);
+}
+
 void darshan_free_config(
     struct darshan_config *cfg)
 {
@@ -996,6 +1604,8 @@ void darshan_free_config(
             free(path);
         free(cfg->user_exclude_dirs);
     }
+    darshan_path_trie_free(cfg->exclude_trie);
+    darshan_path_trie_free(cfg->include_trie);
     LL_FOREACH_SAFE(cfg->app_exclusion_list, regex, tmp_regex)
     {
         LL_DELETE(cfg->app_exclusion_list, regex);
@@ -9,16 +9,32 @@
 
 #include "darshan.h"
 
+/* character trie used to match record names against a set of path
+ * prefixes in a single pass; each node's children form a sibling list
+ */
+struct darshan_path_trie
+{
+    char c;
+    int terminal;
+    struct darshan_path_trie *child;
+    struct darshan_path_trie *sibling;
+};
+
 /* configuration parameters for Darshan runtime */
 struct darshan_config
 {
     size_t mod_mem;
+    size_t mod_mem_grow;
     size_t name_mem;
     int mem_alignment;
+    int mem_hugepages;
+    int mem_first_touch_flag;
     char *jobid_env;
     char *log_hints;
     char *log_path;
     char *log_path_byenv;
+    int log_comp_type;
+    char *log_comp_dict;
 #ifdef __DARSHAN_ENABLE_MMAP_LOGS
     char *mmap_log_path;
 #endif
@@ -26,9 +42,12 @@ struct darshan_config
     uint64_t mod_enabled_flags;
     uint64_t mod_disabled;
     size_t mod_max_records_override[DARSHAN_KNOWN_MODULE_COUNT];
+    size_t mod_sample_rate[DARSHAN_KNOWN_MODULE_COUNT];
     char **exclude_dirs;
     char **user_exclude_dirs;
     char **include_dirs;
+    struct darshan_path_trie *exclude_trie;
+    struct darshan_path_trie *include_trie;
     struct darshan_core_regex *rec_exclusion_list;
     struct darshan_core_regex *rec_inclusion_list;
     struct darshan_core_regex *app_exclusion_list;
@@ -37,8 +56,31 @@ struct darshan_config
     char *rank_inclusions;
     struct dxt_trigger *small_io_trigger;
     struct dxt_trigger *unaligned_io_trigger;
+    size_t dxt_ring_segments;
+    size_t dxt_trigger_warmup;
+    size_t stdio_batch_small;
+    double timeseries_interval;
+    double mmap_sample_interval;
+    size_t dir_rollup_threshold;
+    size_t phase_barriers;
+    double record_retire_time;
+    double shutdown_deadline;
+    size_t log_index_block_recs;
     int internal_timing_flag;
     int disable_shared_redux_flag;
+    int disable_sparse_shutdown_flag;
+    int thread_shards_flag;
+    int pipelined_shutdown_flag;
+    int node_agg_flag;
+    int node_mounts_flag;
+    int collect_children_flag;
+    int log_columnar_flag;
+    int dxt_spill_flag;
+    int heatmap_ops_flag;
+    int heatmap_reduce;
+    int mpiio_coll_wait_flag;
+    int lustre_layout_cache_flag;
+    int lustre_ost_traffic_flag;
     int dump_config_flag;
 };
 
@@ -48,9 +90,27 @@ void darshan_init_config(
 /* parse Darshan configuraiton from a file */
 void darshan_parse_config_file(
     struct darshan_config *cfg);
+/* read the config file named by DARSHAN_CONFIG_PATH into a NUL-terminated
+ * buffer that the caller frees, storing its length in 'len'; returns NULL
+ * if no config file is set or it cannot be read
+ */
+char *darshan_read_config_file(
+    size_t *len);
+/* parse Darshan configuration from the 'len' byte contents of a file */
+void darshan_parse_config_buf(
+    struct darshan_config *cfg,
+    char *buf,
+    size_t len);
 /* parse Darshan configuraiton from user environment */
 void darshan_parse_config_env(
     struct darshan_config *cfg);
+/* compile path exclusion/inclusion lists into tries for fast matching */
+void darshan_compile_config_paths(
+    struct darshan_config *cfg);
+/* check whether 'name' starts with any prefix stored in 'trie' */
+int darshan_config_path_match(
+    struct darshan_path_trie *trie,
+    const char *name);
 /* print final Darshan configuration to stderr */
 void darshan_dump_config(
     struct darshan_config *cfg);
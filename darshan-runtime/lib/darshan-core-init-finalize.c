@@ -24,6 +24,7 @@
 DARSHAN_FORWARD_DECL(PMPI_Finalize, int, ());
 DARSHAN_FORWARD_DECL(PMPI_Init, int, (int *argc, char ***argv));
 DARSHAN_FORWARD_DECL(PMPI_Init_thread, int, (int *argc, char ***argv, int required, int *provided));
+DARSHAN_FORWARD_DECL(MPI_Barrier, int, (MPI_Comm comm));
 
 int DARSHAN_DECL(MPI_Init)(int *argc, char ***argv)
 {
@@ -92,6 +93,25 @@ int DARSHAN_DECL(MPI_Finalize)(void)
     return(ret);
 }
 DARSHAN_WRAPPER_MAP(PMPI_Finalize, int, (void), MPI_Finalize)
+
+/* MPI_Barrier() calls delimit the automatic phases of the PHASE module.
+ * Unlike the wrappers above, there is deliberately no PMPI_Barrier()
+ * variant, so that the barriers darshan itself issues through the PMPI
+ * interface are not counted.
+ */
+int DARSHAN_DECL(MPI_Barrier)(MPI_Comm comm)
+{
+    int ret;
+
+    MAP_OR_FAIL(MPI_Barrier);
+    (void)__darshan_disabled;
+
+    ret = __real_MPI_Barrier(comm);
+
+    PHASE_BARRIER();
+
+    return(ret);
+}
 #endif
 
 /*
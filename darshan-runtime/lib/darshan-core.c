@@ -22,6 +22,8 @@
 #include <string.h>
 #include <limits.h>
 #include <pthread.h>
+#include <sched.h>
+#include <signal.h>
 #include <fcntl.h>
 #include <stdarg.h>
 #include <dirent.h>
@@ -33,12 +35,18 @@
 #include <ctype.h>
 #include <regex.h>
 #include <zlib.h>
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
 #include <errno.h>
 #include <assert.h>
 
 #ifdef HAVE_MPI
 #include <mpi.h>
 #endif
+#ifdef __DARSHAN_RDTSCP_CALIBRATE
+#include <cpuid.h>
+#endif
 
 #include "uthash.h"
 #include "utlist.h"
@@ -56,6 +64,12 @@ extern char* __progname;
 extern char* __progname_full;
 struct darshan_core_runtime *__darshan_core = NULL;
 double __darshan_core_wtime_offset = 0;
+__thread struct darshan_layer_wtime darshan_layer_wtime = {0};
+#ifdef __DARSHAN_RDTSCP_CALIBRATE
+double __darshan_core_tsc_scale = 0;
+uint64_t __darshan_core_tsc_start = 0;
+double __darshan_core_tsc_base = 0;
+#endif
 #ifdef HAVE_STDATOMIC_H
 atomic_flag __darshan_core_mutex = ATOMIC_FLAG_INIT;
 #else
@@ -64,14 +78,142 @@ pthread_mutex_t __darshan_core_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 /* internal variable delcarations */
 static int using_mpi = 0;
+#ifdef HAVE_LIBZSTD
+/* trained zstd dictionary the log is compressed with, if any */
+static ZSTD_CDict *zstd_cdict = NULL;
+#endif
 static int my_rank = 0;
 static int nprocs = 1;
 static int orig_parent_pid = 0;
 static int parent_pid;
 
+/* durations (in seconds) of the phases of the last log shutdown.  these are
+ * always collected, since the OVERHEAD module records them in the log; when
+ * internal timing is enabled, rank 0 additionally reduces the maximum of
+ * each phase across ranks and prints them. compress is summed over every buffer
+ * compressed during shutdown and write over the writes of module data, so
+ * both overlap the other phases.
+ */
+struct darshan_core_shutdown_timing
+{
+    double shared_recs;  /* shared record detection */
+    double open;
+    double job;
+    double name_hash;
+    double compress;
+    double write;        /* collective writes of module data */
+    double header;
+    double total;
+    double mod_redux[DARSHAN_KNOWN_MODULE_COUNT];
+    double mod_total[DARSHAN_KNOWN_MODULE_COUNT]; /* redux, output and append */
+};
+#define DARSHAN_SHUTDOWN_TIMING_COUNT \
+    (int)(sizeof(struct darshan_core_shutdown_timing) / sizeof(double))
+static struct darshan_core_shutdown_timing shutdown_tm;
+static int shutdown_timing_flag = 0;
+static double shutdown_start_time = 0;
+
+/* steps a deadline-bounded shutdown (SHUTDOWN_DEADLINE) can degrade, in
+ * the order they are taken, and the names they are noted by in the job
+ * metadata
+ */
+#define DARSHAN_DEGRADE_SHARED_REDUX (1 << 0)
+#define DARSHAN_DEGRADE_TRACES       (1 << 1)
+#define DARSHAN_DEGRADE_FAST_COMP    (1 << 2)
+#define DARSHAN_DEGRADE_INDEP_WRITE  (1 << 3)
+#define DARSHAN_DEGRADE_STEP_COUNT 4
+static const char *darshan_degrade_names[DARSHAN_DEGRADE_STEP_COUNT] =
+    {"shared_redux", "traces", "fast_comp", "indep_write"};
+/* set to compress the log at the fastest level */
+static int log_comp_fast = 0;
+
+/* darshan-core costs outside of shutdown, reported by the OVERHEAD module */
+static double core_init_time = 0;
+static double core_register_time = 0; /* core lock held registering records */
+static int64_t core_register_calls = 0;
+
+/* number of threads using the core runtime without holding the core lock
+ * (see darshan_core_enter()); shutdown waits for them to leave once it has
+ * detached the runtime
+ */
+static int core_active = 0;
+
 static struct darshan_core_mnt_data mnt_data_array[DARSHAN_MAX_MNTS];
 static int mnt_data_count = 0;
 
+/* memory policy for darshan's buffers (DARSHAN_HUGEPAGES_* and first-touch
+ * flag), kept outside of the core runtime so that buffers can still be
+ * freed according to it while the runtime is being torn down
+ */
+static int mem_hugepages = 0;
+static int mem_first_touch = 0;
+
+/* DARSHAN_DIR_ROLLUP_THRESHOLD, kept outside of the core runtime so that
+ * generating record ids only pays for a test while rollup is disabled
+ */
+static size_t dir_rollup_threshold = 0;
+
+/* pipelined shutdown relies on nonblocking collective I/O (MPI 3.1) */
+#if defined(HAVE_MPI) && \
+    (MPI_VERSION > 3 || (MPI_VERSION == 3 && MPI_SUBVERSION >= 1))
+#define __DARSHAN_PIPELINED_SHUTDOWN
+
+/* state for overlapping compression of one module's data with the
+ * collective write of the previous module's data
+ */
+struct darshan_core_log_pipe
+{
+    char *comp_buf[2];
+    MPI_Request write_req[2];
+    int cur;
+    int err;
+    double comp_tm;
+    double wait_tm;
+};
+#endif
+
+/* environment variable through which a collecting parent passes the path of
+ * its control file to the processes it executes
+ */
+#define DARSHAN_COLLECT_CTL_ENV "DARSHAN_COLLECT_CTL"
+/* environment variable through which a child keeps its rank across exec */
+#define DARSHAN_COLLECT_RANK_ENV "DARSHAN_COLLECT_RANK"
+#define DARSHAN_COLLECT_MAGIC 0x6473686e636f6c6cULL
+
+/* control file shared by a collecting parent and its child processes. ranks
+ * are handed out from next_rank; once the parent sets closed, children no
+ * longer spool their data and write their own logs instead.
+ */
+struct darshan_collect_ctl
+{
+    uint64_t magic;
+    pthread_mutex_t mutex;
+    int owner_pid;
+    int closed;
+    int next_rank;
+};
+
+/* header of the spool file a child leaves for the collecting parent; it is
+ * followed by the child's name records and the output buffer of each module,
+ * all uncompressed
+ */
+struct darshan_collect_hdr
+{
+    uint64_t magic;
+    int32_t rank;
+    int32_t pid;
+    int64_t name_len;
+    int64_t mod_len[DARSHAN_KNOWN_MODULE_COUNT];
+};
+
+/* a child's spool file contents, as loaded by the collecting parent */
+struct darshan_collect_child
+{
+    struct darshan_collect_hdr *hdr;
+    char *name_p;
+    char *mod_p[DARSHAN_KNOWN_MODULE_COUNT];
+};
+
 #ifdef DARSHAN_BGQ
 extern void bgq_runtime_initialize();
 #endif
@@ -80,6 +222,14 @@ extern void bgq_runtime_initialize();
 extern void apxc_runtime_initialize();
 #endif
 
+#ifdef DARSHAN_TIMESERIES
+extern void timeseries_runtime_initialize();
+#endif
+
+#ifdef DARSHAN_MMAP
+extern void mmap_runtime_initialize();
+#endif
+
 /* array of init functions for modules which need to be statically
  * initialized by darshan at startup time
  */
@@ -90,6 +240,12 @@ void (*mod_static_init_fns[])(void) =
 #endif
 #ifdef DARSHAN_USE_APXC
     &apxc_runtime_initialize,
+#endif
+#ifdef DARSHAN_TIMESERIES
+    &timeseries_runtime_initialize,
+#endif
+#ifdef DARSHAN_MMAP
+    &mmap_runtime_initialize,
 #endif
     NULL
 };
@@ -99,10 +255,31 @@ void (*mod_static_init_fns[])(void) =
  * since modules have no way of providing this to darshan-core
  */
 extern void darshan_instrument_lustre_file(darshan_record_id rec_id, int fd);
+extern void darshan_instrument_lustre_io(darshan_record_id rec_id,
+    int64_t offset, int64_t length, int rw_flag);
+extern void darshan_lustre_finish_layouts(void);
 #endif
 
+/* directories deeper than this below the deepest one a name shares with
+ * previously registered names are stored as part of a single entry
+ */
+#define DARSHAN_NAME_MAX_DEPTH 64
+
 /* prototypes for internal helper functions */
 #ifdef __DARSHAN_ENABLE_MMAP_LOGS
+/* bracket a change to the extent of a region of the mmap log, so that
+ * live readers can detect it (see struct darshan_mmap_live); only called
+ * with the core lock held, or before other threads can reach the core
+ */
+#define __DARSHAN_MMAP_GEN_BEGIN(__core, __gen) do { \
+    (__core)->mmap_live_p->__gen++; \
+    atomic_thread_fence(memory_order_release); \
+} while(0)
+#define __DARSHAN_MMAP_GEN_END(__core, __gen) do { \
+    atomic_thread_fence(memory_order_release); \
+    (__core)->mmap_live_p->__gen++; \
+} while(0)
+
 static void *darshan_init_mmap_log(
     struct darshan_core_runtime* core, int jobid);
 #endif
@@ -110,8 +287,18 @@ static void darshan_log_record_hints_and_ver(
     struct darshan_core_runtime* core);
 static void darshan_get_exe_and_mounts(
     struct darshan_core_runtime *core, int argc, char **argv);
+#ifdef HAVE_MPI
+static void darshan_bcast_config_file(
+    struct darshan_core_runtime *core);
+#endif
 static int darshan_should_instrument_app(
     struct darshan_core_runtime *core);
+static void darshan_collect_init(
+    struct darshan_core_runtime *core);
+static int darshan_collect_send(
+    struct darshan_core_runtime *core);
+static void darshan_collect_recv(
+    struct darshan_core_runtime *core);
 static int darshan_should_instrument_rank(
     struct darshan_core_runtime *core);
 static void darshan_fs_info_from_path(
@@ -142,16 +329,85 @@ static int darshan_log_write_header(
 static int darshan_log_append(
     darshan_core_log_fh log_fh, struct darshan_core_runtime *core,
     void *buf, int count, uint64_t *inout_off);
+static int darshan_log_append_collected(
+    darshan_core_log_fh log_fh, struct darshan_core_runtime *core,
+    int mod_id, void *buf, int count, uint64_t *inout_off);
+static int darshan_log_append_retired(
+    darshan_core_log_fh log_fh, struct darshan_core_runtime *core,
+    struct darshan_core_module *mod, void *buf, int count,
+    uint64_t *inout_off);
+static void darshan_core_drop_retired_chunk(
+    struct darshan_core_module *mod, struct darshan_core_retired_chunk *chunk);
+static void darshan_core_free_retired(
+    struct darshan_core_module *mod);
+static int darshan_log_write_chunk(
+    darshan_core_log_fh log_fh, struct darshan_core_runtime *core,
+    char *comp_buf, int comp_buf_sz, int comp_ret, uint64_t *inout_off,
+    uint64_t *out_off);
+static int darshan_log_append_indexed(
+    darshan_core_log_fh log_fh, struct darshan_core_runtime *core,
+    darshan_module_id mod_id, void *buf, int count, uint64_t *inout_off);
+static void darshan_log_write_index(
+    darshan_core_log_fh log_fh, struct darshan_core_runtime *core,
+    uint64_t *inout_off);
+static int darshan_log_index_columnar(
+    struct darshan_core_runtime *core, darshan_module_id mod_id);
+static int darshan_log_compress_columns(
+    int comp_type, char *rec_buf, size_t nrecs, size_t rec_size,
+    uint64_t *col_buf, char *comp_buf, int *comp_buf_length);
 void darshan_log_close(
     darshan_core_log_fh log_fh);
 void darshan_log_finalize(
     char *logfile_name, double start_log_time);
+#ifdef __DARSHAN_PIPELINED_SHUTDOWN
+static int darshan_log_append_pipelined(
+    darshan_core_log_fh log_fh, struct darshan_core_runtime *core,
+    struct darshan_core_log_pipe *pipe, void *buf, int count,
+    uint64_t *inout_off);
+static int darshan_log_pipe_drain(
+    struct darshan_core_log_pipe *pipe);
+#endif
+#ifdef HAVE_MPI
+static void darshan_node_agg_init(
+    struct darshan_core_runtime *core);
+static int darshan_log_append_node_agg(
+    darshan_core_log_fh log_fh, struct darshan_core_runtime *core,
+    void *buf, int count, uint64_t *inout_off);
+static uint64_t *darshan_sparse_init(
+    struct darshan_core_runtime *core, int *active_mods);
+static void darshan_sparse_comm_create(
+    struct darshan_core_runtime *core, uint64_t *rank_mods, int mod_id);
+#endif
+static void darshan_shutdown_degrade(
+    struct darshan_core_runtime *core, double entry_time, int *active_mods);
+static int darshan_compress_buffer(
+    int comp_type, void **pointers, int *lengths, int count,
+    char *comp_buf, int *comp_buf_length);
 static int darshan_deflate_buffer(
     void **pointers, int *lengths, int count, char *comp_buf,
     int *comp_buf_length);
+#ifdef HAVE_LIBZSTD
+static int darshan_zstd_buffer(
+    void **pointers, int *lengths, int count, char *comp_buf,
+    int *comp_buf_length);
+static void darshan_zstd_load_dict(
+    struct darshan_core_runtime *core);
+#endif
 static void darshan_core_cleanup(
     struct darshan_core_runtime* core);
+static int darshan_core_grow_module(
+    struct darshan_core_runtime *core, struct darshan_core_module *mod,
+    size_t rec_size);
+static int darshan_core_id_map_init(
+    struct darshan_core_id_map *map, size_t min_slots);
+static void *darshan_core_id_map_find(
+    struct darshan_core_id_map *map, uint64_t id);
+static void darshan_core_id_map_free(
+    struct darshan_core_id_map *map);
 static void darshan_core_fork_child_cb(void);
+#ifdef __DARSHAN_RDTSCP_CALIBRATE
+static void darshan_core_tsc_calibrate(void);
+#endif
 #ifdef HAVE_MPI
 static void darshan_core_reduce_min_time(
     void* in_time_v, void* inout_time_v,
@@ -212,7 +468,14 @@ void darshan_core_initialize(int argc, char **argv)
     if (__darshan_core != NULL || getenv("DARSHAN_DISABLE"))
         return;
 
+#ifdef __DARSHAN_RDTSCP_CALIBRATE
+    /* switch timers to rdtscp, if usable, before taking any timestamps */
+    darshan_core_tsc_calibrate();
+#endif
+
     init_start = darshan_core_wtime_absolute();
+    core_register_time = 0;
+    core_register_calls = 0;
 
     /* allocate structure to track darshan core runtime information */
     init_core = malloc(sizeof(*init_core));
@@ -238,8 +501,17 @@ void darshan_core_initialize(int argc, char **argv)
          *       config file parameters
          */
         darshan_init_config(&init_core->config);
-        darshan_parse_config_file(&init_core->config);
+#ifdef HAVE_MPI
+        if(using_mpi)
+            darshan_bcast_config_file(init_core);
+        else
+#endif
+            darshan_parse_config_file(&init_core->config);
         darshan_parse_config_env(&init_core->config);
+        darshan_compile_config_paths(&init_core->config);
+        mem_hugepages = init_core->config.mem_hugepages;
+        mem_first_touch = init_core->config.mem_first_touch_flag;
+        dir_rollup_threshold = init_core->config.dir_rollup_threshold;
         if(my_rank == 0 && init_core->config.dump_config_flag)
             darshan_dump_config(&init_core->config);
 
@@ -263,23 +535,45 @@ void darshan_core_initialize(int argc, char **argv)
         init_core->log_hdr_p = malloc(sizeof(struct darshan_header));
         init_core->log_job_p = malloc(sizeof(struct darshan_job));
         init_core->log_exemnt_p = malloc(DARSHAN_EXE_LEN+1);
-        init_core->log_name_p = malloc(init_core->config.name_mem);
-        init_core->log_mod_p = malloc(init_core->config.mod_mem);
+        /* growing modules reserve their own record memory instead */
+        if(darshan_core_mem_policy_enabled())
+        {
+            init_core->log_name_p =
+                darshan_core_mem_alloc(init_core->config.name_mem);
+            if(!init_core->config.mod_mem_grow)
+                init_core->log_mod_p =
+                    darshan_core_mem_alloc(init_core->config.mod_mem);
+        }
+        else
+        {
+            init_core->log_name_p = malloc(init_core->config.name_mem);
+            if(!init_core->config.mod_mem_grow)
+                init_core->log_mod_p = malloc(init_core->config.mod_mem);
+        }
 
         if(!(init_core->log_hdr_p) || !(init_core->log_job_p) ||
            !(init_core->log_exemnt_p) || !(init_core->log_name_p) ||
-           !(init_core->log_mod_p))
+           (!(init_core->log_mod_p) && !init_core->config.mod_mem_grow))
         {
             free(init_core);
             return;
         }
-        /* if allocation succeeds, zero fill memory regions */
+        /* if allocation succeeds, zero fill memory regions (memory
+         * allocated according to a memory policy already is)
+         */
         memset(init_core->log_hdr_p, 0, sizeof(struct darshan_header));
         memset(init_core->log_job_p, 0, sizeof(struct darshan_job));
         memset(init_core->log_exemnt_p, 0, DARSHAN_EXE_LEN+1);
-        memset(init_core->log_name_p, 0, init_core->config.name_mem);
-        memset(init_core->log_mod_p, 0, init_core->config.mod_mem);
+        if(!darshan_core_mem_policy_enabled())
+        {
+            memset(init_core->log_name_p, 0, init_core->config.name_mem);
+            if(init_core->log_mod_p)
+                memset(init_core->log_mod_p, 0, init_core->config.mod_mem);
+        }
 #else
+        /* module records have to live in the mmap log region */
+        init_core->config.mod_mem_grow = 0;
+
         /* if mmap logs are enabled, we need to initialize the mmap region
          * before setting the corresponding log file region pointers
          */
@@ -307,6 +601,21 @@ void darshan_core_initialize(int argc, char **argv)
             ((char *)init_core->log_name_p - (char *)init_core->log_hdr_p);
 #endif
 
+        /* maps of registered names and directories, sized so that they
+         * can not fill up before name memory does, and of cached exclusion
+         * verdicts
+         */
+        if(darshan_core_id_map_init(&init_core->name_map,
+            init_core->config.name_mem / 16) < 0 ||
+           darshan_core_id_map_init(&init_core->name_dir_map,
+            init_core->config.name_mem / 16) < 0 ||
+           darshan_core_id_map_init(&init_core->excluded_map,
+            2 * DARSHAN_EXCLUDED_CACHE_MAX) < 0)
+        {
+            darshan_core_cleanup(init_core);
+            return;
+        }
+
         /* set known header fields for the log file */
         strcpy(init_core->log_hdr_p->version_string, DARSHAN_LOG_VERSION);
         init_core->log_hdr_p->magic_nr = DARSHAN_MAGIC_NR;
@@ -347,6 +656,10 @@ void darshan_core_initialize(int argc, char **argv)
             init_core->config.mod_disabled = ~(init_core->config.mod_disabled & 0);
         }
 
+        /* join the collecting parent's log, or start collecting children */
+        if(!using_mpi && init_core->config.collect_children_flag)
+            darshan_collect_init(init_core);
+
         /* setup fork handlers if not using MPI */
         if(!using_mpi && !orig_parent_pid)
         {
@@ -364,10 +677,23 @@ void darshan_core_initialize(int argc, char **argv)
          * relative times with this as a reference point.
          */
         __DARSHAN_CORE_LOCK();
-        __darshan_core = init_core;
         __darshan_core_wtime_offset = init_start;
+        __atomic_store_n(&__darshan_core, init_core, __ATOMIC_SEQ_CST);
         __DARSHAN_CORE_UNLOCK();
 
+        /* start accounting for Darshan's own costs before any other module
+         * registers, so that each module gets an OVERHEAD record
+         */
+        darshan_overhead_runtime_initialize();
+
+        /* directory rollup records are created by darshan-core as other
+         * modules generate record ids, so register before any of them
+         */
+        darshan_rollup_runtime_initialize();
+
+        /* the first automatic phase starts with the application */
+        darshan_phase_runtime_initialize();
+
         /* bootstrap any modules with static initialization routines */
         i = 0;
         while(mod_static_init_fns[i])
@@ -375,6 +701,8 @@ void darshan_core_initialize(int argc, char **argv)
             (*mod_static_init_fns[i])();
             i++;
         }
+
+        core_init_time = darshan_core_wtime_absolute() - init_start;
     }
 
     if(__darshan_core->config.internal_timing_flag)
@@ -407,24 +735,21 @@ void darshan_core_initialize(int argc, char **argv)
 void darshan_core_shutdown(int write_log)
 {
     struct darshan_core_runtime *final_core;
+    double entry_time;
     double start_log_time;
     struct timespec end_ts;
     int internal_timing_flag;
-    double open1 = 0, open2 = 0;
-    double job1 = 0, job2 = 0;
-    double rec1 = 0, rec2 = 0;
-    double mod1[DARSHAN_KNOWN_MODULE_COUNT] = {0};
-    double mod2[DARSHAN_KNOWN_MODULE_COUNT] = {0};
-    double header1 = 0, header2 = 0;
-    double tm_end;
+    double tm1 = 0;
     int active_mods[DARSHAN_KNOWN_MODULE_COUNT] = {0};
     uint64_t gz_fp = 0;
     char *logfile_name = NULL;
     darshan_core_log_fh log_fh;
     int log_created = 0;
+    int use_index = 0;
+    int use_retired;
     int meta_remain = 0;
     char *m;
-    int i;
+    int i, j;
     int ret;
 #ifdef HAVE_MPI
     MPI_Datatype ts_type;
@@ -432,6 +757,27 @@ void darshan_core_shutdown(int write_log)
     darshan_record_id *shared_recs = NULL;
     darshan_record_id *mod_shared_recs = NULL;
     int shared_rec_cnt = 0;
+    uint64_t *rank_mods = NULL;
+    int use_sparse;
+    int sparse_err = 0;
+#endif
+#ifdef __DARSHAN_PIPELINED_SHUTDOWN
+    struct darshan_core_log_pipe log_pipe;
+    int use_pipe = 0;
+    int mod_err = 0;
+#endif
+
+#ifdef HAVE_LDMS
+    /* publish queued LDMS events while record names can still be looked up */
+    darshan_ldms_connector_finalize();
+#endif
+
+#ifdef DARSHAN_LUSTRE
+    /* the Lustre module registers the records of layouts still being
+     * collected in the background, which has to happen before the set of
+     * records is fixed
+     */
+    darshan_lustre_finish_layouts();
 #endif
 
     /* disable darhan-core while we shutdown */
@@ -442,9 +788,24 @@ void darshan_core_shutdown(int write_log)
         return;
     }
     final_core = __darshan_core;
-    __darshan_core = NULL;
+    __atomic_store_n(&__darshan_core, NULL, __ATOMIC_SEQ_CST);
     __DARSHAN_CORE_UNLOCK();
 
+    /* wait for threads still registering records, yielding the CPU in case
+     * they have been descheduled
+     */
+    while(__atomic_load_n(&core_active, __ATOMIC_ACQUIRE))
+        sched_yield();
+
+    /* a shutdown deadline counts from here, before waiting on other ranks */
+    entry_time = darshan_core_wtime_absolute();
+
+#ifdef __DARSHAN_ENABLE_MMAP_LOGS
+    /* stop live readers before modules start reorganizing their records */
+    final_core->mmap_live_p->state = DARSHAN_MMAP_LIVE_SHUTDOWN;
+    atomic_thread_fence(memory_order_release);
+#endif
+
     /* skip to cleanup if not writing a log */
     if(!write_log)
         goto cleanup;
@@ -468,6 +829,9 @@ void darshan_core_shutdown(int write_log)
     final_core->log_job_p->end_time_nsec = (int64_t)end_ts.tv_nsec;
 
     internal_timing_flag = final_core->config.internal_timing_flag;
+    memset(&shutdown_tm, 0, sizeof(shutdown_tm));
+    shutdown_timing_flag = 1;
+    shutdown_start_time = start_log_time;
 
 #ifdef __DARSHAN_ENABLE_MMAP_LOGS
     /* remove the temporary mmap log files */
@@ -491,6 +855,49 @@ void darshan_core_shutdown(int write_log)
             active_mods[i] = 1;
     }
 
+    /* give DXT modules a chance to filter trace records according to user config */
+    if(final_core->config.small_io_trigger)
+    {
+        dxt_posix_apply_trace_filter(final_core->config.small_io_trigger);
+        dxt_stdio_apply_trace_filter(final_core->config.small_io_trigger);
+    }
+    if(final_core->config.unaligned_io_trigger)
+    {
+        dxt_posix_apply_trace_filter(final_core->config.unaligned_io_trigger);
+        dxt_stdio_apply_trace_filter(final_core->config.unaligned_io_trigger);
+    }
+
+    if(final_core->collect_ctl)
+    {
+        if(final_core->collect_rank > 0)
+        {
+            /* leave our data to the collecting parent, unless it has
+             * already written its log
+             */
+            if(darshan_collect_send(final_core) == 0)
+                goto cleanup;
+        }
+        else
+        {
+            /* pick up the data of the children that have exited, adding
+             * the modules that only they used
+             */
+            darshan_collect_recv(final_core);
+            for(j = 0; j < final_core->collect_cnt; j++)
+            {
+                for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+                {
+                    if(!final_core->collect_children[j].hdr->mod_len[i])
+                        continue;
+                    active_mods[i] = 1;
+                    if(!final_core->log_hdr_p->mod_ver[i])
+                        final_core->log_hdr_p->mod_ver[i] =
+                            darshan_module_versions[i];
+                }
+            }
+        }
+    }
+
 #ifdef HAVE_MPI
     if(using_mpi)
     {
@@ -525,7 +932,9 @@ void darshan_core_shutdown(int write_log)
         PMPI_Op_free(&ts_max_op);
 
         /* get a list of records which are shared across all processes */
+        tm1 = darshan_core_wtime_absolute();
         darshan_get_shared_records(final_core, &shared_recs, &shared_rec_cnt);
+        shutdown_tm.shared_recs = darshan_core_wtime_absolute() - tm1;
 
         mod_shared_recs = malloc(shared_rec_cnt * sizeof(darshan_record_id));
         assert(mod_shared_recs);
@@ -558,41 +967,106 @@ void darshan_core_shutdown(int write_log)
         goto cleanup;
     }
 
-    if(internal_timing_flag)
-        open1 = darshan_core_wtime_absolute();
+#ifdef HAVE_MPI
+    /* optionally funnel log data through one leader rank per node */
+    if(using_mpi && final_core->config.node_agg_flag)
+        darshan_node_agg_init(final_core);
+#endif
+
+    /* the block index requires that each rank writes its own log data */
+    use_index = (final_core->config.log_index_block_recs > 0) &&
+        !final_core->collect_cnt;
+#ifdef HAVE_MPI
+    if(using_mpi && final_core->node_agg)
+        use_index = 0;
+#endif
+
+    tm1 = darshan_core_wtime_absolute();
     /* open the darshan log file */
     ret = darshan_log_open(logfile_name, final_core, &log_fh);
-    if(internal_timing_flag)
-        open2 = darshan_core_wtime_absolute();
+    shutdown_tm.open = darshan_core_wtime_absolute() - tm1;
     /* error out if unable to open log file */
     DARSHAN_CHECK_ERR(ret, "unable to create log file %s", logfile_name);
     log_created = 1;
 
-    if(internal_timing_flag)
-        job1 = darshan_core_wtime_absolute();
+#ifdef HAVE_LIBZSTD
+    darshan_zstd_load_dict(final_core);
+#endif
+
+    /* cut back on the rest of shutdown if running out of time; this has to
+     * be settled before the job record (which notes it) is written
+     */
+    if(final_core->config.shutdown_deadline > 0)
+        darshan_shutdown_degrade(final_core, entry_time, active_mods);
+
+    tm1 = darshan_core_wtime_absolute();
     /* write the the compressed darshan job information */
     ret = darshan_log_write_job_record(log_fh, final_core, &gz_fp);
-    if(internal_timing_flag)
-        job2 = darshan_core_wtime_absolute();
+    shutdown_tm.job = darshan_core_wtime_absolute() - tm1;
     /* error out if unable to write job information */
     DARSHAN_CHECK_ERR(ret, "unable to write job record to file %s", logfile_name);
 
-    if(internal_timing_flag)
-        rec1 = darshan_core_wtime_absolute();
+    tm1 = darshan_core_wtime_absolute();
     /* write the record name->id hash to the log file */
     final_core->log_hdr_p->name_map.off = gz_fp;
     ret = darshan_log_write_name_record_hash(log_fh, final_core, &gz_fp);
-    if(internal_timing_flag)
-        rec2 = darshan_core_wtime_absolute();
+    shutdown_tm.name_hash = darshan_core_wtime_absolute() - tm1;
     final_core->log_hdr_p->name_map.len = gz_fp - final_core->log_hdr_p->name_map.off;
     /* error out if unable to write name records */
     DARSHAN_CHECK_ERR(ret, "unable to write name records to log file %s", logfile_name);
 
-    /* give DXT module a chance to filter trace records according to user config */
-    if(final_core->config.small_io_trigger)
-        dxt_posix_apply_trace_filter(final_core->config.small_io_trigger);
-    if(final_core->config.unaligned_io_trigger)
-        dxt_posix_apply_trace_filter(final_core->config.unaligned_io_trigger);
+#ifdef __DARSHAN_PIPELINED_SHUTDOWN
+    /* set up a second compression buffer if using pipelined shutdown;
+     * all ranks must agree, since the two modes issue different collectives.
+     * node-local aggregation and the block index take precedence over
+     * pipelining, which also can not handle module data larger than the
+     * compression buffer (as with DXT spilling or growing module memory).
+     */
+    if(using_mpi && final_core->config.pipelined_shutdown_flag &&
+       !final_core->node_agg && !final_core->indep_write &&
+       !final_core->config.dxt_spill_flag &&
+       !final_core->config.mod_mem_grow && !use_index)
+    {
+        memset(&log_pipe, 0, sizeof(log_pipe));
+        log_pipe.comp_buf[0] = final_core->comp_buf;
+        log_pipe.comp_buf[1] = malloc(final_core->config.mod_mem);
+        log_pipe.write_req[0] = MPI_REQUEST_NULL;
+        log_pipe.write_req[1] = MPI_REQUEST_NULL;
+        use_pipe = (log_pipe.comp_buf[1] != NULL);
+        PMPI_Allreduce(MPI_IN_PLACE, &use_pipe, 1, MPI_INT, MPI_LAND,
+            final_core->mpi_comm);
+        if(!use_pipe)
+            free(log_pipe.comp_buf[1]);
+    }
+#endif
+
+    /* records retired during the run are written as already compressed
+     * streams, which only the plain per-rank log regions can hold
+     */
+    use_retired = !use_index && !final_core->collect_cnt;
+#ifdef HAVE_MPI
+    if(using_mpi && final_core->node_agg)
+        use_retired = 0;
+#endif
+#ifdef __DARSHAN_PIPELINED_SHUTDOWN
+    if(use_pipe)
+        use_retired = 0;
+#endif
+
+#ifdef HAVE_MPI
+    /* find out which ranks used each module, if some modules were only used
+     * by some ranks; node-local aggregation, pipelining and the block index
+     * all issue collectives on every rank for every module
+     */
+    use_sparse = using_mpi && !final_core->config.disable_sparse_shutdown_flag &&
+        !final_core->node_agg && !use_index;
+#ifdef __DARSHAN_PIPELINED_SHUTDOWN
+    if(use_pipe)
+        use_sparse = 0;
+#endif
+    if(use_sparse)
+        rank_mods = darshan_sparse_init(final_core, active_mods);
+#endif
 
     /* loop over globally used darshan modules and:
      *      - get final output buffer
@@ -614,14 +1088,28 @@ void darshan_core_shutdown(int write_log)
             continue;
         }
 
-        if(internal_timing_flag)
-            mod1[i] = darshan_core_wtime_absolute();
+        tm1 = darshan_core_wtime_absolute();
+
+#ifdef HAVE_MPI
+        /* a module only some ranks used is written by just those ranks, plus
+         * rank 0 (which tracks the log offset); such a module can't have
+         * shared records, so there is no reduction to take part in either
+         */
+        if(rank_mods && active_mods[i] < nprocs)
+        {
+            if(!this_mod && my_rank != 0)
+                continue;
+            darshan_sparse_comm_create(final_core, rank_mods, i);
+        }
+#endif
 
         /* if module is registered locally, perform module shutdown operations */
         if(this_mod)
         {
             mod_buf = final_core->mod_array[i]->rec_buf_start;
             mod_buf_sz = final_core->mod_array[i]->rec_buf_p - mod_buf;
+            if(!use_retired)
+                darshan_core_free_retired(this_mod);
 
 #ifdef HAVE_MPI
             if(using_mpi)
@@ -633,8 +1121,8 @@ void darshan_core_shutdown(int write_log)
                 /* set the shared record list for this module */
                 for(j = 0; j < shared_rec_cnt; j++)
                 {
-                    HASH_FIND(hlink, final_core->name_hash, &shared_recs[j],
-                        sizeof(darshan_record_id), ref);
+                    ref = darshan_core_id_map_find(&final_core->name_map,
+                        shared_recs[j]);
                     assert(ref);
 
                     if(DARSHAN_MOD_FLAG_ISSET(ref->global_mod_flags, i))
@@ -643,6 +1131,21 @@ void darshan_core_shutdown(int write_log)
                     }
                 }
 
+                /* shared records are reduced across ranks, so any copies
+                 * of them staged at retirement are stale
+                 */
+                for(j = 0; j < mod_shared_rec_cnt && this_mod->retired_live; j++)
+                {
+                    struct darshan_core_retired_ref *retired_ref;
+
+                    HASH_FIND(hlink, this_mod->retired_hash,
+                        &mod_shared_recs[j], sizeof(darshan_record_id),
+                        retired_ref);
+                    if(retired_ref)
+                        darshan_core_drop_retired_chunk(this_mod,
+                            retired_ref->chunk);
+                }
+
                 /* allow the module an opportunity to reduce shared files */
                 if(this_mod->mod_funcs.mod_redux_func && (mod_shared_rec_cnt > 0))
                 {
@@ -654,8 +1157,12 @@ void darshan_core_shutdown(int write_log)
                     if(!final_core->config.disable_shared_redux_flag ||
                        (i == DARSHAN_HEATMAP_MOD))
                     {
+                        double redux1 = darshan_core_wtime_absolute();
+
                         this_mod->mod_funcs.mod_redux_func(mod_buf, final_core->mpi_comm,
                             mod_shared_recs, mod_shared_rec_cnt);
+                        shutdown_tm.mod_redux[i] =
+                            darshan_core_wtime_absolute() - redux1;
                     }
                 }
             }
@@ -667,23 +1174,89 @@ void darshan_core_shutdown(int write_log)
 
         /* append this module's data to the darshan log */
         final_core->log_hdr_p->mod_map[i].off = gz_fp;
-        ret = darshan_log_append(log_fh, final_core, mod_buf, mod_buf_sz, &gz_fp);
+#ifdef __DARSHAN_PIPELINED_SHUTDOWN
+        if(use_pipe)
+        {
+            /* the write is left in flight while the next module is
+             * reduced and compressed; errors are checked once all
+             * writes have drained
+             */
+            ret = darshan_log_append_pipelined(log_fh, final_core, &log_pipe,
+                mod_buf, mod_buf_sz, &gz_fp);
+            final_core->log_hdr_p->mod_map[i].len =
+                gz_fp - final_core->log_hdr_p->mod_map[i].off;
+            if(ret != 0)
+                mod_err = ret;
+            shutdown_tm.mod_total[i] = darshan_core_wtime_absolute() - tm1;
+            continue;
+        }
+#endif
+        if(use_index)
+            ret = darshan_log_append_indexed(log_fh, final_core, i, mod_buf,
+                mod_buf_sz, &gz_fp);
+        else if(final_core->collect_cnt)
+            ret = darshan_log_append_collected(log_fh, final_core, i,
+                mod_buf, mod_buf_sz, &gz_fp);
+        else if(this_mod && this_mod->retired_live)
+            ret = darshan_log_append_retired(log_fh, final_core, this_mod,
+                mod_buf, mod_buf_sz, &gz_fp);
+        else
+            ret = darshan_log_append(log_fh, final_core, mod_buf, mod_buf_sz,
+                &gz_fp);
         final_core->log_hdr_p->mod_map[i].len =
             gz_fp - final_core->log_hdr_p->mod_map[i].off;
 
-        if(internal_timing_flag)
-            mod2[i] = darshan_core_wtime_absolute();
+        shutdown_tm.mod_total[i] = darshan_core_wtime_absolute() - tm1;
+
+#ifdef HAVE_MPI
+        if(final_core->sparse_write)
+        {
+            /* the other ranks aren't taking part in this module, so write
+             * errors are checked once all modules have been written
+             */
+            PMPI_Comm_free(&final_core->sparse_comm);
+            final_core->sparse_write = 0;
+            if(ret != 0)
+                sparse_err = ret;
+            continue;
+        }
+#endif
 
         /* error out if unable to write module data */
         DARSHAN_CHECK_ERR(ret, "unable to write %s module data to log file %s",
             darshan_module_names[i], logfile_name);
+
+        /* flag modules written in the columnar layout in the header */
+        if(use_index && darshan_log_index_columnar(final_core, i) &&
+           final_core->log_hdr_p->mod_ver[i])
+            final_core->log_hdr_p->mod_ver[i] |= DARSHAN_LOG_COLUMNAR_FLAG;
     }
 
-    if(internal_timing_flag)
-        header1 = darshan_core_wtime_absolute();
+#ifdef __DARSHAN_PIPELINED_SHUTDOWN
+    if(use_pipe)
+    {
+        /* wait for the last module writes to complete */
+        ret = darshan_log_pipe_drain(&log_pipe);
+        if(ret == 0)
+            ret = mod_err;
+        DARSHAN_CHECK_ERR(ret, "unable to write module data to log file %s",
+            logfile_name);
+    }
+#endif
+
+#ifdef HAVE_MPI
+    if(rank_mods)
+        DARSHAN_CHECK_ERR(sparse_err, "unable to write module data to log file %s",
+            logfile_name);
+#endif
+
+    /* append the block index, if enabled, after all log regions */
+    if(use_index)
+        darshan_log_write_index(log_fh, final_core, &gz_fp);
+
+    tm1 = darshan_core_wtime_absolute();
     ret = darshan_log_write_header(log_fh, final_core);
-    if(internal_timing_flag)
-        header2 = darshan_core_wtime_absolute();
+    shutdown_tm.header = darshan_core_wtime_absolute() - tm1;
     DARSHAN_CHECK_ERR(ret, "unable to write header to file %s", logfile_name);
 
     /* done writing data, close the log file */
@@ -694,57 +1267,40 @@ void darshan_core_shutdown(int write_log)
 
     if(internal_timing_flag)
     {
-        double open_tm;
-        double header_tm;
-        double job_tm;
-        double rec_tm;
-        double mod_tm[DARSHAN_KNOWN_MODULE_COUNT];
-        double all_tm;
-
-        tm_end = darshan_core_wtime_absolute();
-
-        open_tm = open2 - open1;
-        header_tm = header2 - header1;
-        job_tm = job2 - job1;
-        rec_tm = rec2 - rec1;
-        all_tm = tm_end - start_log_time;
-        for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
-        {
-            mod_tm[i] = mod2[i] - mod1[i];
-        }
+        shutdown_tm.total = darshan_core_wtime_absolute() - start_log_time;
 
 #ifdef HAVE_MPI
         if(using_mpi)
         {
             if(my_rank == 0)
             {
-                PMPI_Reduce(MPI_IN_PLACE, &open_tm, 1,
-                    MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
-                PMPI_Reduce(MPI_IN_PLACE, &header_tm, 1,
-                    MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
-                PMPI_Reduce(MPI_IN_PLACE, &job_tm, 1,
-                    MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
-                PMPI_Reduce(MPI_IN_PLACE, &rec_tm, 1,
-                    MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
-                PMPI_Reduce(MPI_IN_PLACE, &all_tm, 1,
-                    MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
-                PMPI_Reduce(MPI_IN_PLACE, mod_tm, DARSHAN_KNOWN_MODULE_COUNT,
-                    MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
+                PMPI_Reduce(MPI_IN_PLACE, &shutdown_tm,
+                    DARSHAN_SHUTDOWN_TIMING_COUNT, MPI_DOUBLE, MPI_MAX, 0,
+                    final_core->mpi_comm);
+#ifdef __DARSHAN_PIPELINED_SHUTDOWN
+                if(use_pipe)
+                {
+                    PMPI_Reduce(MPI_IN_PLACE, &log_pipe.comp_tm, 1,
+                        MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
+                    PMPI_Reduce(MPI_IN_PLACE, &log_pipe.wait_tm, 1,
+                        MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
+                }
+#endif
             }
             else
             {
-                PMPI_Reduce(&open_tm, &open_tm, 1,
-                    MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
-                PMPI_Reduce(&header_tm, &header_tm, 1,
-                    MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
-                PMPI_Reduce(&job_tm, &job_tm, 1,
-                    MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
-                PMPI_Reduce(&rec_tm, &rec_tm, 1,
-                    MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
-                PMPI_Reduce(&all_tm, &all_tm, 1,
-                    MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
-                PMPI_Reduce(mod_tm, mod_tm, DARSHAN_KNOWN_MODULE_COUNT,
-                    MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
+                PMPI_Reduce(&shutdown_tm, &shutdown_tm,
+                    DARSHAN_SHUTDOWN_TIMING_COUNT, MPI_DOUBLE, MPI_MAX, 0,
+                    final_core->mpi_comm);
+#ifdef __DARSHAN_PIPELINED_SHUTDOWN
+                if(use_pipe)
+                {
+                    PMPI_Reduce(&log_pipe.comp_tm, &log_pipe.comp_tm, 1,
+                        MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
+                    PMPI_Reduce(&log_pipe.wait_tm, &log_pipe.wait_tm, 1,
+                        MPI_DOUBLE, MPI_MAX, 0, final_core->mpi_comm);
+                }
+#endif
 
                 /* let rank 0 report the timing info */
                 goto cleanup;
@@ -753,20 +1309,55 @@ void darshan_core_shutdown(int write_log)
 #endif
 
         darshan_core_fprintf(stderr, "#darshan:<op>\t<nprocs>\t<time>\n");
-        darshan_core_fprintf(stderr, "darshan:log_open\t%d\t%f\n", nprocs, open_tm);
-        darshan_core_fprintf(stderr, "darshan:job_write\t%d\t%f\n", nprocs, job_tm);
-        darshan_core_fprintf(stderr, "darshan:hash_write\t%d\t%f\n", nprocs, rec_tm);
-        darshan_core_fprintf(stderr, "darshan:header_write\t%d\t%f\n", nprocs, header_tm);
+        darshan_core_fprintf(stderr, "darshan:log_open\t%d\t%f\n", nprocs,
+            shutdown_tm.open);
+        darshan_core_fprintf(stderr, "darshan:job_write\t%d\t%f\n", nprocs,
+            shutdown_tm.job);
+        darshan_core_fprintf(stderr, "darshan:hash_write\t%d\t%f\n", nprocs,
+            shutdown_tm.name_hash);
+        darshan_core_fprintf(stderr, "darshan:header_write\t%d\t%f\n", nprocs,
+            shutdown_tm.header);
+        if(using_mpi)
+            darshan_core_fprintf(stderr, "darshan:shared_recs\t%d\t%f\n", nprocs,
+                shutdown_tm.shared_recs);
         for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
         {
-            if(active_mods[i])
-                darshan_core_fprintf(stderr, "darshan:%s_shutdown\t%d\t%f\n",
-                    darshan_module_names[i], nprocs, mod_tm[i]);
+            if(!active_mods[i])
+                continue;
+            if(shutdown_tm.mod_redux[i] > 0)
+                darshan_core_fprintf(stderr, "darshan:%s_redux\t%d\t%f\n",
+                    darshan_module_names[i], nprocs, shutdown_tm.mod_redux[i]);
+            darshan_core_fprintf(stderr, "darshan:%s_shutdown\t%d\t%f\n",
+                darshan_module_names[i], nprocs, shutdown_tm.mod_total[i]);
+        }
+        darshan_core_fprintf(stderr, "darshan:compress\t%d\t%f\n", nprocs,
+            shutdown_tm.compress);
+        darshan_core_fprintf(stderr, "darshan:mod_write\t%d\t%f\n", nprocs,
+            shutdown_tm.write);
+#ifdef __DARSHAN_PIPELINED_SHUTDOWN
+        if(use_pipe)
+        {
+            darshan_core_fprintf(stderr, "darshan:pipeline_compress\t%d\t%f\n",
+                nprocs, log_pipe.comp_tm);
+            darshan_core_fprintf(stderr, "darshan:pipeline_write_wait\t%d\t%f\n",
+                nprocs, log_pipe.wait_tm);
         }
-        darshan_core_fprintf(stderr, "darshan:core_shutdown\t%d\t%f\n", nprocs, all_tm);
+#endif
+        darshan_core_fprintf(stderr, "darshan:core_shutdown\t%d\t%f\n", nprocs,
+            shutdown_tm.total);
     }
 
 cleanup:
+    shutdown_timing_flag = 0;
+    log_comp_fast = 0;
+#ifdef __DARSHAN_PIPELINED_SHUTDOWN
+    if(use_pipe)
+    {
+        /* comp_buf[0] is the core's comp_buf, freed with the core below */
+        (void)darshan_log_pipe_drain(&log_pipe);
+        free(log_pipe.comp_buf[1]);
+    }
+#endif
     for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
         if(final_core->mod_array[i])
             final_core->mod_array[i]->mod_funcs.mod_cleanup_func();
@@ -776,6 +1367,7 @@ cleanup:
     {
         free(shared_recs);
         free(mod_shared_recs);
+        free(rank_mods);
     }
 #endif
     free(logfile_name);
@@ -802,7 +1394,8 @@ static void *darshan_init_mmap_log(struct darshan_core_runtime* core, int jobid)
     assert(sys_page_size > 0);
 
     mmap_size = sizeof(struct darshan_header) + DARSHAN_JOB_RECORD_SIZE +
-        + core->config.name_mem + core->config.mod_mem;
+        + core->config.name_mem + core->config.mod_mem +
+        sizeof(struct darshan_mmap_live);
     if(mmap_size % sys_page_size)
         mmap_size = ((mmap_size / sys_page_size) + 1) * sys_page_size;
 
@@ -868,6 +1461,29 @@ static void *darshan_init_mmap_log(struct darshan_core_runtime* core, int jobid)
     /* close darshan log file (this does *not* unmap the log file) */
     close(mmap_fd);
 
+    /* apply the memory policy to the log's pages; huge pages are only
+     * used if the file system holding the log supports them (e.g., tmpfs
+     * mounted with huge=advise)
+     */
+#ifdef MADV_HUGEPAGE
+    if(mem_hugepages)
+        madvise(mmap_p, mmap_size, MADV_HUGEPAGE);
+#endif
+    if(mem_first_touch)
+        memset(mmap_p, 0, mmap_size);
+
+    /* describe the mapping in its trailer for tools sampling it live; the
+     * magic number is set last so that they never see a partial trailer
+     */
+    core->mmap_live_p = (struct darshan_mmap_live *)
+        ((char *)mmap_p + mmap_size - sizeof(struct darshan_mmap_live));
+    core->mmap_live_p->version = DARSHAN_MMAP_LIVE_VER;
+    core->mmap_live_p->state = DARSHAN_MMAP_LIVE_RUNNING;
+    core->mmap_live_p->pid = getpid();
+    core->mmap_live_p->rank = my_rank;
+    atomic_thread_fence(memory_order_release);
+    core->mmap_live_p->magic_nr = DARSHAN_MMAP_LIVE_MAGIC_NR;
+
     return(mmap_p);
 }
 #endif
@@ -921,11 +1537,10 @@ static int mnt_data_cmp(const void* a, const void* b)
 }
 
 /* adds an entry to table of mounted file systems */
-static void add_entry(char* buf, int* space_left, struct mntent* entry)
+static void add_entry(struct mntent* entry)
 {
     int i;
     int ret;
-    char tmp_mnt[256];
     struct statfs statfsbuf;
 
     /* avoid adding the same mount points multiple times -- to limit
@@ -958,36 +1573,37 @@ static void add_entry(char* buf, int* space_left, struct mntent* entry)
     else
         mnt_data_array[mnt_data_count].fs_info.block_size = 4096;
 
-    /* store mount information with the job-level metadata in darshan log */
-    ret = snprintf(tmp_mnt, 256, "\n%s\t%s",
-        entry->mnt_type, entry->mnt_dir);
+    mnt_data_count++;
+    return;
+}
+
+/* store mount information with the job-level metadata in darshan log */
+static void add_entry_text(char* buf, int* space_left,
+    struct darshan_core_mnt_data *mnt)
+{
+    int ret;
+    char tmp_mnt[256];
+
+    ret = snprintf(tmp_mnt, 256, "\n%s\t%s", mnt->type, mnt->path);
     if(ret < 256 && strlen(tmp_mnt) <= (*space_left))
     {
         strcat(buf, tmp_mnt);
         (*space_left) -= strlen(tmp_mnt);
     }
 
-    mnt_data_count++;
     return;
 }
 
-/* darshan_get_exe_and_mounts()
+/* darshan_scan_mounts()
  *
- * collects command line and list of mounted file systems into a string that
- * will be stored with the job-level metadata
+ * reads the table of mounted file systems into mnt_data_array, in mount
+ * table order
  */
-static void darshan_get_exe_and_mounts(struct darshan_core_runtime *core,
-    int argc, char **argv)
+static void darshan_scan_mounts(void)
 {
     FILE* tab;
     struct mntent *entry;
     char* exclude;
-    char* truncate_string = "<TRUNCATED>";
-    int truncate_offset;
-    int space_left = DARSHAN_EXE_LEN;
-    FILE *fh;
-    int i, ii;
-    char cmdl[DARSHAN_EXE_LEN];
     int tmp_index = 0;
     int skip = 0;
 
@@ -1009,6 +1625,147 @@ static void darshan_get_exe_and_mounts(struct darshan_core_runtime *core,
         NULL
     };
 
+    /* we make two passes through mounted file systems; in the first pass we
+     * grab any non-nfs mount points, then on the second pass we grab nfs
+     * mount points
+     */
+    mnt_data_count = 0;
+
+    tab = setmntent("/etc/mtab", "r");
+    if(!tab)
+        return;
+    /* loop through list of mounted file systems */
+    while(mnt_data_count<DARSHAN_MAX_MNTS && (entry = getmntent(tab)) != NULL)
+    {
+        /* filter out excluded fs types */
+        tmp_index = 0;
+        skip = 0;
+        while((exclude = fs_exclusions[tmp_index]))
+        {
+            if(!(strcmp(exclude, entry->mnt_type)))
+            {
+                skip =1;
+                break;
+            }
+            tmp_index++;
+        }
+
+        if(skip || (strcmp(entry->mnt_type, "nfs") == 0))
+            continue;
+
+        add_entry(entry);
+    }
+    endmntent(tab);
+
+    tab = setmntent("/etc/mtab", "r");
+    if(!tab)
+        return;
+    /* loop through list of mounted file systems */
+    while(mnt_data_count<DARSHAN_MAX_MNTS && (entry = getmntent(tab)) != NULL)
+    {
+        if(strcmp(entry->mnt_type, "nfs") != 0)
+            continue;
+
+        add_entry(entry);
+    }
+    endmntent(tab);
+
+    return;
+}
+
+#ifdef HAVE_MPI
+/* darshan_scan_node_mounts()
+ *
+ * reads the table of mounted file systems on the lowest rank of each node
+ * only, and broadcasts it to the other ranks of the node. Falls back to
+ * reading it on every rank if the MPI library lacks shared memory
+ * communicators.
+ */
+static void darshan_scan_node_mounts(struct darshan_core_runtime *core)
+{
+#if MPI_VERSION >= 3
+    MPI_Comm node_comm;
+    int node_rank;
+
+    PMPI_Comm_split_type(core->mpi_comm, MPI_COMM_TYPE_SHARED, my_rank,
+        MPI_INFO_NULL, &node_comm);
+    PMPI_Comm_rank(node_comm, &node_rank);
+
+    if(node_rank == 0)
+        darshan_scan_mounts();
+    PMPI_Bcast(&mnt_data_count, 1, MPI_INT, 0, node_comm);
+    PMPI_Bcast(mnt_data_array, mnt_data_count * sizeof(mnt_data_array[0]),
+        MPI_BYTE, 0, node_comm);
+
+    PMPI_Comm_free(&node_comm);
+#else
+    darshan_scan_mounts();
+#endif
+    return;
+}
+#endif
+
+#ifdef HAVE_MPI
+/* darshan_bcast_config_file()
+ *
+ * reads the config file on rank 0 only, and broadcasts its contents to
+ * every rank, which then parses them from memory. This keeps large jobs
+ * from opening the same (likely shared) file on every rank.
+ */
+static void darshan_bcast_config_file(struct darshan_core_runtime *core)
+{
+    char *buf = NULL;
+    size_t len = 0;
+    int64_t len64 = 0;
+    int ok;
+
+    if(my_rank == 0)
+    {
+        buf = darshan_read_config_file(&len);
+        len64 = buf ? (int64_t)len : -1;
+    }
+    PMPI_Bcast(&len64, 1, MPI_INT64_T, 0, core->mpi_comm);
+    if(len64 < 0)
+        return;
+
+    len = len64;
+    if(my_rank != 0)
+        buf = malloc(len + 1);
+
+    /* if any rank cannot hold the contents, every rank reads the file */
+    ok = (buf != NULL);
+    PMPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_LAND, core->mpi_comm);
+    if(!ok)
+    {
+        free(buf);
+        darshan_parse_config_file(&core->config);
+        return;
+    }
+
+    PMPI_Bcast(buf, (int)len, MPI_BYTE, 0, core->mpi_comm);
+    buf[len] = '\0';
+    darshan_parse_config_buf(&core->config, buf, len);
+    free(buf);
+
+    return;
+}
+#endif
+
+/* darshan_get_exe_and_mounts()
+ *
+ * collects command line and list of mounted file systems into a string that
+ * will be stored with the job-level metadata
+ */
+static void darshan_get_exe_and_mounts(struct darshan_core_runtime *core,
+    int argc, char **argv)
+{
+    char* truncate_string = "<TRUNCATED>";
+    int truncate_offset;
+    int space_left = DARSHAN_EXE_LEN;
+    FILE *fh;
+    int i, ii;
+    char cmdl[DARSHAN_EXE_LEN];
+
     /* record exe and arguments */
     for(i=0; i<argc; i++)
     {
@@ -1064,50 +1821,15 @@ static void darshan_get_exe_and_mounts(struct darshan_core_runtime *core,
             truncate_string);
     }
 
-    /* we make two passes through mounted file systems; in the first pass we
-     * grab any non-nfs mount points, then on the second pass we grab nfs
-     * mount points
-     */
-    mnt_data_count = 0;
-
-    tab = setmntent("/etc/mtab", "r");
-    if(!tab)
-        return;
-    /* loop through list of mounted file systems */
-    while(mnt_data_count<DARSHAN_MAX_MNTS && (entry = getmntent(tab)) != NULL)
-    {
-        /* filter out excluded fs types */
-        tmp_index = 0;
-        skip = 0;
-        while((exclude = fs_exclusions[tmp_index]))
-        {
-            if(!(strcmp(exclude, entry->mnt_type)))
-            {
-                skip =1;
-                break;
-            }
-            tmp_index++;
-        }
-
-        if(skip || (strcmp(entry->mnt_type, "nfs") == 0))
-            continue;
-
-        add_entry(core->log_exemnt_p, &space_left, entry);
-    }
-    endmntent(tab);
-
-    tab = setmntent("/etc/mtab", "r");
-    if(!tab)
-        return;
-    /* loop through list of mounted file systems */
-    while(mnt_data_count<DARSHAN_MAX_MNTS && (entry = getmntent(tab)) != NULL)
-    {
-        if(strcmp(entry->mnt_type, "nfs") != 0)
-            continue;
-
-        add_entry(core->log_exemnt_p, &space_left, entry);
-    }
-    endmntent(tab);
+    /* collect the mounted file systems, on one rank per node if requested */
+#ifdef HAVE_MPI
+    if(using_mpi && core->config.node_mounts_flag)
+        darshan_scan_node_mounts(core);
+    else
+#endif
+        darshan_scan_mounts();
+    for(i = 0; i < mnt_data_count; i++)
+        add_entry_text(core->log_exemnt_p, &space_left, &mnt_data_array[i]);
 
     /* sort mount points in order of longest path to shortest path.  This is
      * necessary so that if we try to match file paths to mount points later
@@ -1283,1422 +2005,4467 @@ static int darshan_should_instrument_rank(struct darshan_core_runtime *core)
     return(1);
 }
 
-static void darshan_fs_info_from_path(const char *path, struct darshan_fs_info *fs_info)
+/* lock a collection control file, recovering the lock if its holder died;
+ * spool files are only renamed into place once complete, so a dead holder
+ * leaves nothing half-written behind
+ */
+static void darshan_collect_lock(struct darshan_collect_ctl *ctl)
 {
-    int i;
-    fs_info->fs_type = -1;
-    fs_info->block_size = -1;
+    if(pthread_mutex_lock(&ctl->mutex) == EOWNERDEAD)
+        pthread_mutex_consistent(&ctl->mutex);
+}
 
-    for(i=0; i<mnt_data_count; i++)
+/* join the collection of the parent whose control file is named in the
+ * environment, or, if there is none, create a control file and become the
+ * collecting parent of the processes this one forks or executes
+ */
+static void darshan_collect_init(struct darshan_core_runtime *core)
+{
+    struct darshan_collect_ctl *ctl;
+    pthread_mutexattr_t attr;
+    struct stat sbuf;
+    char *ctl_name;
+    char *spool_dir;
+    char *rank_str;
+    char rank_buf[32];
+    int pid, rank;
+    int fd;
+
+    ctl_name = getenv(DARSHAN_COLLECT_CTL_ENV);
+    if(ctl_name)
     {
-        if(!(strncmp(mnt_data_array[i].path, path, strlen(mnt_data_array[i].path))))
+        fd = open(ctl_name, O_RDWR);
+        if(fd < 0)
+            return;
+        ctl = MAP_FAILED;
+        if(fstat(fd, &sbuf) == 0 && sbuf.st_size >= (off_t)sizeof(*ctl))
+            ctl = mmap(NULL, sizeof(*ctl), PROT_READ|PROT_WRITE, MAP_SHARED,
+                fd, 0);
+        close(fd);
+        if(ctl == MAP_FAILED)
+            return;
+        if(ctl->magic != DARSHAN_COLLECT_MAGIC)
         {
-            *fs_info = mnt_data_array[i].fs_info;
+            munmap(ctl, sizeof(*ctl));
             return;
         }
+
+        /* processes keep their rank across exec; in particular, the
+         * collecting parent is still the parent if it exec'd itself
+         */
+        rank_str = getenv(DARSHAN_COLLECT_RANK_ENV);
+        darshan_collect_lock(ctl);
+        if(!ctl->closed && ctl->owner_pid != core->pid)
+        {
+            if(rank_str && sscanf(rank_str, "%d:%d", &pid, &rank) == 2 &&
+               pid == core->pid && rank > 0 && rank < ctl->next_rank)
+                core->collect_rank = rank;
+            else
+                core->collect_rank = ctl->next_rank++;
+        }
+        pthread_mutex_unlock(&ctl->mutex);
+
+        if(!ctl->closed)
+        {
+            core->collect_ctl = ctl;
+            core->collect_ctl_name = strdup(ctl_name);
+            if(core->collect_rank > 0)
+            {
+                snprintf(rank_buf, sizeof(rank_buf), "%d:%d", core->pid,
+                    core->collect_rank);
+                setenv(DARSHAN_COLLECT_RANK_ENV, rank_buf, 1);
+            }
+        }
+        else
+        {
+            /* too late to join, this process writes its own log */
+            munmap(ctl, sizeof(*ctl));
+        }
+        return;
+    }
+
+    /* the control file lives next to the mmap logs */
+#ifdef __DARSHAN_ENABLE_MMAP_LOGS
+    spool_dir = core->config.mmap_log_path;
+#else
+    spool_dir = getenv(DARSHAN_MMAP_LOG_PATH_OVERRIDE);
+    if(!spool_dir)
+        spool_dir = DARSHAN_DEF_MMAP_LOG_PATH;
+#endif
+    ctl_name = malloc(__DARSHAN_PATH_MAX);
+    if(!ctl_name)
+        return;
+    snprintf(ctl_name, __DARSHAN_PATH_MAX, "%s/darshan_collect_%d_%" PRId64,
+        spool_dir, core->pid, core->log_job_p->start_time_sec);
+
+    fd = open(ctl_name, O_CREAT|O_RDWR|O_EXCL, 0600);
+    if(fd < 0)
+    {
+        free(ctl_name);
+        return;
     }
+    ctl = MAP_FAILED;
+    if(ftruncate(fd, sizeof(*ctl)) == 0)
+        ctl = mmap(NULL, sizeof(*ctl), PROT_READ|PROT_WRITE, MAP_SHARED,
+            fd, 0);
+    close(fd);
+    if(ctl == MAP_FAILED)
+    {
+        unlink(ctl_name);
+        free(ctl_name);
+        return;
+    }
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&ctl->mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+    ctl->owner_pid = core->pid;
+    ctl->closed = 0;
+    ctl->next_rank = 1;
+    ctl->magic = DARSHAN_COLLECT_MAGIC;
+
+    /* forked children inherit this, and executed ones get it too */
+    setenv(DARSHAN_COLLECT_CTL_ENV, ctl_name, 1);
+
+    core->collect_ctl = ctl;
+    core->collect_ctl_name = ctl_name;
+    core->collect_rank = 0;
 
     return;
 }
 
-static int darshan_add_name_record_ref(struct darshan_core_runtime *core,
-    darshan_record_id rec_id, const char *name, darshan_module_id mod_id)
+static int darshan_collect_write(int fd, void *buf, int64_t len)
 {
-    struct darshan_core_name_record_ref *ref;
-    struct darshan_core_name_record_ref *check_ref;
-    int record_size = sizeof(darshan_record_id) + strlen(name) + 1;
-
-    if((record_size + core->name_mem_used) > core->config.name_mem)
-        return(0);
+    char *p = buf;
+    ssize_t ret;
 
-    /* drop core lock while we allocate reference.  Note that
-     * this means we must check for existence again in hash table once we
-     * re-acquire the lock, but this code path will only happen once per
-     * file.
-     */
-    __DARSHAN_CORE_UNLOCK();
-    ref = malloc(sizeof(*ref));
-    __DARSHAN_CORE_LOCK();
-    if(!ref)
+    while(len > 0)
     {
-        return(0);
+        ret = write(fd, p, len);
+        if(ret < 0 && errno == EINTR)
+            continue;
+        if(ret <= 0)
+            return(-1);
+        p += ret;
+        len -= ret;
     }
-    memset(ref, 0, sizeof(*ref));
 
-    /* make sure no one else added it while we dropped the lock */
-    HASH_FIND(hlink, core->name_hash, &rec_id,
-        sizeof(darshan_record_id), check_ref);
-    if(check_ref)
-        return(1);
+    return(0);
+}
 
-    /* initialize the name record */
-    ref->name_record = (struct darshan_name_record *)
-        ((char *)core->log_name_p + core->name_mem_used);
-    memset(ref->name_record, 0, record_size);
-    ref->name_record->id = rec_id;
-    strcpy(ref->name_record->name, name);
-    DARSHAN_MOD_FLAG_SET(ref->mod_flags, mod_id);
-
-    HASH_ADD(hlink, core->name_hash, name_record->id,
-        sizeof(darshan_record_id), ref);
-    core->name_mem_used += record_size;
-#ifdef __DARSHAN_ENABLE_MMAP_LOGS
-    core->log_hdr_p->name_map.len += record_size;
-#endif
+static int darshan_collect_read(int fd, void *buf, int64_t len)
+{
+    char *p = buf;
+    ssize_t ret;
 
-    return(1);
+    while(len > 0)
+    {
+        ret = read(fd, p, len);
+        if(ret < 0 && errno == EINTR)
+            continue;
+        if(ret <= 0)
+            return(-1);
+        p += ret;
+        len -= ret;
+    }
+
+    return(0);
 }
 
-static void darshan_get_user_name(char *cuser)
+/* leave this child's name records and module data in a spool file for the
+ * collecting parent. returns 0 if the data was handed off (or lost to a
+ * write error, after the modules produced their output), or -1 if the
+ * parent is no longer collecting and this process must write its own log.
+ */
+static int darshan_collect_send(struct darshan_core_runtime *core)
 {
-    char* logname_string;
+    struct darshan_collect_ctl *ctl = core->collect_ctl;
+    struct darshan_collect_hdr hdr;
+    void *mod_bufs[DARSHAN_KNOWN_MODULE_COUNT] = {0};
+    char spool_name[__DARSHAN_PATH_MAX];
+    char tmp_name[__DARSHAN_PATH_MAX];
+    int mod_buf_sz;
+    int fd;
+    int i;
+    int ret;
 
-    /* get the username for this job.  In order we will try each of the
-     * following until one of them succeeds:
-     *
-     * - cuserid() -- if enabled at configure time (disabled by default)
-     * - getenv("LOGNAME")
-     * - snprintf(..., geteuid());
-     *
-     * Note that we do not use getpwuid() because it generally will not
-     * work in statically compiled binaries.
+    /* hold the lock throughout, so that the parent waits for this spool
+     * file to be complete before reading the spool files
      */
-
-#ifdef __DARSHAN_USERNAME_ENV
-    logname_string = getenv(__DARSHAN_USERNAME_ENV);
-    if(logname_string)
+    darshan_collect_lock(ctl);
+    if(ctl->closed || (kill(ctl->owner_pid, 0) < 0 && errno == ESRCH))
     {
-        strncpy(cuser, logname_string, (L_cuserid-1));
+        pthread_mutex_unlock(&ctl->mutex);
+        return(-1);
     }
-#endif
 
-#ifdef __DARSHAN_ENABLE_CUSERID
-    if(strcmp(cuser, "") == 0)
+    /* a truncated name would spool to the wrong file, so this process
+     * writes its own log instead
+     */
+    ret = snprintf(spool_name, __DARSHAN_PATH_MAX, "%s.%d",
+        core->collect_ctl_name, core->collect_rank);
+    if(ret >= 0 && ret < __DARSHAN_PATH_MAX)
+        ret = snprintf(tmp_name, __DARSHAN_PATH_MAX, "%s.tmp", spool_name);
+    if(ret < 0 || ret >= __DARSHAN_PATH_MAX)
     {
-        cuserid(cuser);
+        DARSHAN_WARN("spool file path for %s is too long",
+            core->collect_ctl_name);
+        pthread_mutex_unlock(&ctl->mutex);
+        return(-1);
+    }
+    fd = open(tmp_name, O_CREAT|O_WRONLY|O_TRUNC, 0600);
+    if(fd < 0)
+    {
+        pthread_mutex_unlock(&ctl->mutex);
+        return(-1);
     }
-#endif
 
-    /* if cuserid() didn't work, then check the environment */
-    if(strcmp(cuser, "") == 0)
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = DARSHAN_COLLECT_MAGIC;
+    hdr.rank = core->collect_rank;
+    hdr.pid = core->pid;
+    hdr.name_len = core->name_mem_used;
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
     {
-        logname_string = getenv("LOGNAME");
-        if(logname_string)
-        {
-            strncpy(cuser, logname_string, (L_cuserid-1));
-        }
+        if(!core->mod_array[i])
+            continue;
+
+        mod_bufs[i] = core->mod_array[i]->rec_buf_start;
+        mod_buf_sz = core->mod_array[i]->rec_buf_p - mod_bufs[i];
+        core->mod_array[i]->mod_funcs.mod_output_func(&mod_bufs[i],
+            &mod_buf_sz);
+        hdr.mod_len[i] = mod_buf_sz;
     }
 
-    /* if cuserid() and environment both fail, then fall back to uid */
-    if(strcmp(cuser, "") == 0)
+    ret = darshan_collect_write(fd, &hdr, sizeof(hdr));
+    if(ret == 0)
+        ret = darshan_collect_write(fd, core->log_name_p, hdr.name_len);
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT && ret == 0; i++)
+        ret = darshan_collect_write(fd, mod_bufs[i], hdr.mod_len[i]);
+    close(fd);
+    if(ret == 0)
+        ret = rename(tmp_name, spool_name);
+    if(ret != 0)
     {
-        uid_t uid = geteuid();
-        snprintf(cuser, L_cuserid, "%u", uid);
+        DARSHAN_WARN("unable to write spool file %s", spool_name);
+        unlink(tmp_name);
     }
+    pthread_mutex_unlock(&ctl->mutex);
 
-    return;
+    return(0);
 }
 
-#ifdef HAVE_MPI
-static void darshan_get_shared_records(struct darshan_core_runtime *core,
-    darshan_record_id **shared_recs, int *shared_rec_cnt)
+/* stop collecting and load the spool files of all children that have
+ * exited, setting the job's process count to cover every rank handed out
+ */
+static void darshan_collect_recv(struct darshan_core_runtime *core)
 {
-    int i, j;
-    int tmp_cnt = HASH_CNT(hlink, core->name_hash);
-    struct darshan_core_name_record_ref *tmp, *ref;
-    darshan_record_id *id_array;
-    uint64_t *mod_flags;
-    uint64_t *global_mod_flags;
-
-    /* broadcast root's number of records to all other processes */
-    PMPI_Bcast(&tmp_cnt, 1, MPI_INT, 0, core->mpi_comm);
-
-    /* use root record count to allocate data structures */
-    id_array = malloc(tmp_cnt * sizeof(darshan_record_id));
-    mod_flags = malloc(tmp_cnt * sizeof(uint64_t));
-    global_mod_flags = malloc(tmp_cnt * sizeof(uint64_t));
-    *shared_recs = malloc(tmp_cnt * sizeof(darshan_record_id));
-    assert(id_array && mod_flags && global_mod_flags && *shared_recs);
-
-    memset(mod_flags, 0, tmp_cnt * sizeof(uint64_t));
-    memset(global_mod_flags, 0, tmp_cnt * sizeof(uint64_t));
-    memset(*shared_recs, 0, tmp_cnt * sizeof(darshan_record_id));
-
-    /* first, determine list of records root process has opened */
-    if(my_rank == 0)
+    struct darshan_collect_ctl *ctl = core->collect_ctl;
+    struct darshan_collect_child *child;
+    struct darshan_collect_hdr *hdr;
+    char spool_name[__DARSHAN_PATH_MAX];
+    struct stat sbuf;
+    int64_t len;
+    char *buf;
+    char *p;
+    int nranks;
+    int fd;
+    int r;
+    int i;
+
+    /* NOTE: this waits for children that are writing their spool files */
+    darshan_collect_lock(ctl);
+    ctl->closed = 1;
+    nranks = ctl->next_rank;
+    pthread_mutex_unlock(&ctl->mutex);
+    unlink(core->collect_ctl_name);
+
+    core->collect_children = calloc(nranks, sizeof(*core->collect_children));
+    for(r = 1; r < nranks; r++)
     {
-        i = 0;
-        HASH_ITER(hlink, core->name_hash, ref, tmp)
+        /* remove the partial spool file of a child that died writing it */
+        snprintf(spool_name, __DARSHAN_PATH_MAX, "%s.%d.tmp",
+            core->collect_ctl_name, r);
+        unlink(spool_name);
+
+        /* children that are still running, or that were not instrumented,
+         * have no spool file
+         */
+        snprintf(spool_name, __DARSHAN_PATH_MAX, "%s.%d",
+            core->collect_ctl_name, r);
+        fd = open(spool_name, O_RDONLY);
+        if(fd < 0)
+            continue;
+        unlink(spool_name);
+
+        buf = NULL;
+        if(core->collect_children && fstat(fd, &sbuf) == 0 &&
+           sbuf.st_size >= (off_t)sizeof(*hdr))
+            buf = malloc(sbuf.st_size);
+        if(buf && darshan_collect_read(fd, buf, sbuf.st_size) != 0)
         {
-            id_array[i++] = ref->name_record->id;
+            free(buf);
+            buf = NULL;
         }
-    }
+        close(fd);
+        if(!buf)
+            continue;
 
-    /* broadcast root's list of records to all other processes */
-    PMPI_Bcast(id_array, (tmp_cnt * sizeof(darshan_record_id)),
-        MPI_BYTE, 0, core->mpi_comm);
+        /* make sure the regions add up before trusting them */
+        hdr = (struct darshan_collect_hdr *)buf;
+        len = sizeof(*hdr);
+        i = 0;
+        if(hdr->magic == DARSHAN_COLLECT_MAGIC && hdr->name_len >= 0 &&
+           hdr->name_len <= INT_MAX)
+        {
+            len += hdr->name_len;
+            for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+            {
+                if(hdr->mod_len[i] < 0 || hdr->mod_len[i] > INT_MAX)
+                    break;
+                len += hdr->mod_len[i];
+            }
+        }
+        if(hdr->magic != DARSHAN_COLLECT_MAGIC ||
+           i < DARSHAN_KNOWN_MODULE_COUNT || len != sbuf.st_size)
+        {
+            DARSHAN_WARN("ignoring invalid spool file %s", spool_name);
+            free(buf);
+            continue;
+        }
 
-    /* everyone looks to see if they opened the same records as root */
-    for(i=0; i<tmp_cnt; i++)
-    {
-        HASH_FIND(hlink, core->name_hash, &id_array[i], sizeof(darshan_record_id), ref);
-        if(ref)
+        child = &core->collect_children[core->collect_cnt++];
+        child->hdr = hdr;
+        p = buf + sizeof(*hdr);
+        child->name_p = p;
+        p += hdr->name_len;
+        for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
         {
-            /* we opened that record too, save the mod_flags */
-            mod_flags[i] = ref->mod_flags;
+            child->mod_p[i] = p;
+            p += hdr->mod_len[i];
         }
     }
 
-    /* now allreduce so everyone agrees which records are shared and
-     * which modules accessed them collectively
-     */
-    PMPI_Allreduce(mod_flags, global_mod_flags, tmp_cnt,
-        MPI_UINT64_T, MPI_BAND, core->mpi_comm);
+    core->log_job_p->nprocs = nranks;
+
+    return;
+}
+
+static void darshan_fs_info_from_path(const char *path, struct darshan_fs_info *fs_info)
+{
+    int i;
+    fs_info->fs_type = -1;
+    fs_info->block_size = -1;
 
-    j = 0;
-    for(i=0; i<tmp_cnt; i++)
+    for(i=0; i<mnt_data_count; i++)
     {
-        if(global_mod_flags[i] != 0)
+        if(!(strncmp(mnt_data_array[i].path, path, strlen(mnt_data_array[i].path))))
         {
-            (*shared_recs)[j++] = id_array[i];
-
-            /* set global_mod_flags so we know which modules collectively
-             * accessed this module. we need this info to support shared
-             * record reductions
-             */
-            HASH_FIND(hlink, core->name_hash, &id_array[i], sizeof(darshan_record_id), ref);
-            assert(ref);
-            ref->global_mod_flags = global_mod_flags[i];
+            *fs_info = mnt_data_array[i].fs_info;
+            return;
         }
     }
-    *shared_rec_cnt = j;
 
-    free(id_array);
-    free(mod_flags);
-    free(global_mod_flags);
     return;
 }
-#endif
 
-/* construct the darshan log file name */
-/* NOTE: logfile_name argument is assumed to have already been allocated
- * with size __DARSHAN_PATH_MAX; length will be safety checked in this
- * function.
+/* multiplier spreading ids over the slots of an id map (Fibonacci hashing),
+ * since directory ids all have the low bit clear
  */
-static void darshan_get_logfile_name(
-    char* logfile_name, struct darshan_core_runtime* core)
-{
-    char* user_logfile_name;
-    uint64_t hlevel;
-    char hname[HOST_NAME_MAX];
-    uint64_t logmod;
-    char cuser[L_cuserid] = {0};
-    struct tm *start_tm;
-    int jobid;
-    int pid;
-    time_t start_time;
-    int ret;
+#define DARSHAN_ID_MAP_MULT 0x9e3779b97f4a7c15ULL
 
-#ifdef HAVE_MPI
-    if (using_mpi && my_rank > 0)
-        goto bcast;
-#endif
+/* states of name and directory references */
+#define DARSHAN_CORE_REF_BUILDING 0
+#define DARSHAN_CORE_REF_READY 1
+#define DARSHAN_CORE_REF_FAILED 2
 
-    jobid = core->log_job_p->jobid;
-    pid = core->pid;
+/* allocate an id map of at least 'min_slots' slots, returning -1 on failure */
+static int darshan_core_id_map_init(struct darshan_core_id_map *map,
+    size_t min_slots)
+{
+    size_t slots = 256;
 
-    /* first, check if user specifies a complete logpath to use */
-    user_logfile_name = getenv("DARSHAN_LOGFILE");
-    if(user_logfile_name)
+    map->shift = 64 - 8;
+    while(slots < min_slots)
     {
-        if(strlen(user_logfile_name) >= (__DARSHAN_PATH_MAX-1))
-        {
-            DARSHAN_WARN("user log file name too long");
-            logfile_name[0] = '\0';
-        }
-        else
-        {
-            strcpy(logfile_name, user_logfile_name);
-        }
+        slots *= 2;
+        map->shift--;
     }
-    else
-    {
-        /* otherwise, generate the log path automatically */
+    map->mask = slots - 1;
+    map->slots = calloc(slots, sizeof(*map->slots));
+    if(!map->slots)
+        return(-1);
 
-        darshan_get_user_name(cuser);
+    return(0);
+}
 
-        /* generate a random number to help differentiate the log */
-        hlevel = darshan_core_wtime_absolute() * 1000000;
-        (void)gethostname(hname, sizeof(hname));
-        logmod = darshan_hash((void*)hname,strlen(hname),hlevel);
+/* return the reference stored under 'id', or NULL if there is none */
+static void *darshan_core_id_map_find(struct darshan_core_id_map *map,
+    uint64_t id)
+{
+    uint64_t i, n;
+    void *ref;
 
-        /* use human readable start time format in log filename */
-        start_time = (time_t)core->log_job_p->start_time_sec;
-        start_tm = localtime(&start_time);
+    i = (id * DARSHAN_ID_MAP_MULT) >> map->shift;
+    for(n = 0; n <= map->mask; n++, i = (i + 1) & map->mask)
+    {
+        ref = __atomic_load_n(&map->slots[i], __ATOMIC_ACQUIRE);
+        if(!ref)
+            break;
+        if(*(uint64_t *)ref == id)
+            return(ref);
+    }
 
-        if(core->config.log_path_byenv)
-        {
-            /* Darshan log file is stored in an unformatted directory given
-             * by the user via environment variables specified at configure
-             * time (--with-log-path-by-env configure argument)
-             */
-            ret = snprintf(logfile_name, __DARSHAN_PATH_MAX,
-                "%s/%s_%s_id%d-%d_%d-%d-%d-%" PRIu64 ".darshan_partial",
-                core->config.log_path_byenv,
-                cuser, __progname, jobid, pid,
-                (start_tm->tm_mon+1),
-                start_tm->tm_mday,
-                (start_tm->tm_hour*60*60 + start_tm->tm_min*60 + start_tm->tm_sec),
-                logmod);
-            if(ret == (__DARSHAN_PATH_MAX-1))
-            {
-                /* file name was too big; squish it down */
-                snprintf(logfile_name, __DARSHAN_PATH_MAX,
-                    "%s/id%d.darshan_partial",
-                    core->config.log_path_byenv, jobid);
-            }
-        }
-        else if(core->config.log_path)
-        {
-            /* Darshan log file is stored in an date-formatted directory given
-             * by the user either at configure time (--with-log-path configure
-             * argument) or at runtime using DARSHAN_LOGPATH env var
-             */
-            ret = snprintf(logfile_name, __DARSHAN_PATH_MAX,
-                "%s/%d/%d/%d/%s_%s_id%d-%d_%d-%d-%d-%" PRIu64 ".darshan_partial",
-                core->config.log_path, (start_tm->tm_year+1900),
-                (start_tm->tm_mon+1), start_tm->tm_mday,
-                cuser, __progname, jobid, pid,
-                (start_tm->tm_mon+1),
-                start_tm->tm_mday,
-                (start_tm->tm_hour*60*60 + start_tm->tm_min*60 + start_tm->tm_sec),
-                logmod);
-            if(ret == (__DARSHAN_PATH_MAX-1))
-            {
-                /* file name was too big; squish it down */
-                snprintf(logfile_name, __DARSHAN_PATH_MAX,
-                    "%s/id%d.darshan_partial",
-                    core->config.log_path, jobid);
-            }
-        }
-        else
+    return(NULL);
+}
+
+/* publish 'new_ref' under the id it starts with, unless another reference
+ * already is; returns the reference stored under the id, or NULL if the
+ * map is full
+ */
+static void *darshan_core_id_map_add(struct darshan_core_id_map *map,
+    void *new_ref)
+{
+    uint64_t id = *(uint64_t *)new_ref;
+    uint64_t i, n;
+    void *ref;
+
+    i = (id * DARSHAN_ID_MAP_MULT) >> map->shift;
+    for(n = 0; n <= map->mask; n++, i = (i + 1) & map->mask)
+    {
+        ref = __atomic_load_n(&map->slots[i], __ATOMIC_ACQUIRE);
+        if(!ref)
         {
-            logfile_name[0] = '\0';
+            if(__atomic_compare_exchange_n(&map->slots[i], &ref, new_ref,
+                0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                return(new_ref);
+            /* another reference took the slot first, now in 'ref' */
         }
+        if(*(uint64_t *)ref == id)
+            return(ref);
     }
 
-#ifdef HAVE_MPI
-bcast:
-    if(using_mpi)
-    {
-        PMPI_Bcast(logfile_name, __DARSHAN_PATH_MAX, MPI_CHAR, 0, core->mpi_comm);
-        if(my_rank > 0)
-            return;
-    }
-#endif
+    return(NULL);
+}
 
-    if(strlen(logfile_name) == 0)
-        DARSHAN_WARN("unable to determine log file path");
+/* free an id map and the references stored in it */
+static void darshan_core_id_map_free(struct darshan_core_id_map *map)
+{
+    uint64_t i;
+
+    if(!map->slots)
+        return;
+    for(i = 0; i <= map->mask; i++)
+        free(map->slots[i]);
+    free(map->slots);
+    map->slots = NULL;
 
     return;
 }
 
-static int darshan_log_open(char *logfile_name, struct darshan_core_runtime *core,
-    darshan_core_log_fh *log_fh)
+/* wait for the thread that added a name or directory reference to finish
+ * building it, returning its final state
+ */
+static int darshan_core_ref_wait(int *state)
 {
-#ifdef HAVE_MPI
-    int ret;
-    char *hints;
-    char *tok_str;
-    char *orig_tok_str;
-    char *key;
-    char *value;
-    char *saveptr = NULL;
-    MPI_Info info;
+    int s;
 
-    if(using_mpi)
-    {
-        /* set any log file hints darshan has been configured to use */
-        MPI_Info_create(&info);
+    while((s = __atomic_load_n(state, __ATOMIC_ACQUIRE)) ==
+        DARSHAN_CORE_REF_BUILDING)
+        sched_yield();
 
-        hints = core->config.log_hints;
-        if(hints && strlen(hints) > 0)
-        {
-            tok_str = strdup(hints);
-            if(tok_str)
-            {
-                orig_tok_str = tok_str;
-                do
-                {
-                    /* split string on semicolon */
-                    key = strtok_r(tok_str, ";", &saveptr);
-                    if(key)
-                    {
-                        tok_str = NULL;
-                        /* look for = sign splitting key/value pairs */
-                        value = index(key, '=');
-                        if(value)
-                        {
-                            /* break key and value into separate null terminated strings */
-                            value[0] = '\0';
-                            value++;
-                            if(strlen(key) > 0)
-                                MPI_Info_set(info, key, value);
-                        }
-                    }
-                }while(key != NULL);
-                free(orig_tok_str);
-            }
-        }
+    return(s);
+}
 
-        /* open the darshan log file for writing using MPI */
-        ret = MPI_File_open(core->mpi_comm, logfile_name,
-            MPI_MODE_CREATE | MPI_MODE_WRONLY | MPI_MODE_EXCL, info, &log_fh->mpi_fh);
-        MPI_Info_free(&info);
-        if(ret != MPI_SUCCESS)
-            return(-1);
-        return(0);
+/* returns the length of the directory that the first 'len' characters of
+ * a name are stored relative to, or -1 if they are stored in full
+ */
+static int darshan_name_dir_len(const char *name, int len)
+{
+    int i;
+
+    for(i = len - 1; i > 0; i--)
+    {
+        if(name[i] == '/')
+            return(i);
     }
-#endif
 
-    /* open the darshan log file for writing */
-    log_fh->nompi_fd = open(logfile_name, O_CREAT | O_WRONLY | O_EXCL, S_IRUSR);
-    if(log_fh->nompi_fd < 0)
-        return(-1);
-    return(0);
+    return(-1);
 }
 
-static int darshan_log_write_job_record(darshan_core_log_fh log_fh,
-    struct darshan_core_runtime *core, uint64_t *inout_off)
+static uint64_t darshan_name_dir_id(const char *name, int len)
 {
-    /* prepare to write two contiguous elements in file: the job structure
-     * and a trailing string that contains the command line and mount table
-     * information. Include a trailing null byte in the latter.
-     */
-    void *pointers[2] = {core->log_job_p, core->log_exemnt_p};
-    int lengths[2] = {sizeof(struct darshan_job), strlen(core->log_exemnt_p)+1};
-    int comp_buf_sz = core->config.mod_mem;
-    int ret;
+    uint64_t dir_id;
 
-#ifdef HAVE_MPI
-    /* only rank 0 writes the job record */
-    if (using_mpi && my_rank > 0)
-        return(0);
-#endif
+    dir_id = darshan_hash((const unsigned char *)name, len, 0) &
+        ~DARSHAN_NAME_DIR_FLAG;
+    if(dir_id == 0)
+        dir_id = DARSHAN_NAME_DIR_FLAG << 1;
 
-    /* compress the job info and the trailing mount/exe data */
-    ret = darshan_deflate_buffer(pointers, lengths, 2,
-        core->comp_buf, &comp_buf_sz);
-    if(ret)
+    return(dir_id);
+}
+
+/* find the directories of a name that do not have a directory entry yet,
+ * storing their lengths (deepest first) in 'dir_lens'. On return, 'parent'
+ * and 'parent_len' give the deepest directory that does have an entry (0
+ * if there is none), and 'size' the name memory needed to store the name.
+ * Returns -1 if that directory could not be stored.
+ */
+static int darshan_name_dirs_missing(struct darshan_core_runtime *core,
+    const char *name, int name_len, int *dir_lens, uint64_t *parent,
+    int *parent_len, size_t *size)
+{
+    struct darshan_core_name_dir_ref *dir_ref;
+    uint64_t dir_id;
+    int len;
+    int cnt = 0;
+    int i;
+
+    *parent = 0;
+    *parent_len = -1;
+    len = darshan_name_dir_len(name, name_len);
+    while(len > 0 && cnt < DARSHAN_NAME_MAX_DEPTH)
     {
-        DARSHAN_WARN("error compressing job record");
+        dir_id = darshan_name_dir_id(name, len);
+        dir_ref = darshan_core_id_map_find(&core->name_dir_map, dir_id);
+        if(dir_ref)
+        {
+            if(darshan_core_ref_wait(&dir_ref->state) != DARSHAN_CORE_REF_READY)
+                return(-1);
+            *parent = dir_id;
+            *parent_len = len;
+            break;
+        }
+        dir_lens[cnt++] = len;
+        len = darshan_name_dir_len(name, len);
     }
-    else
-    {
-        /* write the job information, preallocing space for the log header */
-        *inout_off += sizeof(struct darshan_header);
-
-#ifdef HAVE_MPI
-        MPI_Status status;
-        if(using_mpi)
-        {
-            ret = PMPI_File_write_at(log_fh.mpi_fh, *inout_off, core->comp_buf,
-                comp_buf_sz, MPI_BYTE, &status);
-            if(ret != MPI_SUCCESS)
-            {
-                DARSHAN_WARN("error writing job record");
-                ret = -1;
-            }
-            else
-            {
-                *inout_off += comp_buf_sz;
-                ret = 0;
-            }
-
-            return(ret);
-        }
-#endif
 
-        ret = pwrite(log_fh.nompi_fd, core->comp_buf, comp_buf_sz, *inout_off);
-        if(ret != comp_buf_sz)
-        {
-            DARSHAN_WARN("error writing job record");
-            ret = -1;
-        }
-        else
-        {
-            *inout_off += comp_buf_sz;
-            ret = 0;
-        }
+    /* each entry is stored relative to the next shallower one */
+    len = *parent_len;
+    *size = 0;
+    for(i = cnt - 1; i >= 0; i--)
+    {
+        *size += DARSHAN_NAME_ENTRY_SIZE(dir_lens[i] - (len + 1));
+        len = dir_lens[i];
     }
+    *size += DARSHAN_NAME_ENTRY_SIZE(name_len - (len + 1));
 
-    return(ret);
+    return(cnt);
 }
 
-static int darshan_log_write_name_record_hash(darshan_core_log_fh log_fh,
-    struct darshan_core_runtime *core, uint64_t *inout_off)
+/* append a name entry to the name memory, returning NULL if it is full.
+ * Space is claimed with an atomic bump of name_mem_used, so that entries
+ * are appended concurrently; an entry always follows the entries of the
+ * directories it refers to, as those are complete before it is appended.
+ */
+static struct darshan_name_entry *darshan_name_entry_append(
+    struct darshan_core_runtime *core, uint64_t id, uint64_t dir,
+    const char *name, int len)
 {
-    int name_rec_buf_len;
-    int ret;
+    struct darshan_name_entry *entry;
+    size_t size = DARSHAN_NAME_ENTRY_SIZE(len);
+    size_t used;
 
-    name_rec_buf_len = core->name_mem_used;
-#ifdef HAVE_MPI
-    if(using_mpi && (my_rank > 0))
+#ifdef __DARSHAN_ENABLE_MMAP_LOGS
+    /* live readers of the mmap log parse the name region up to its extent
+     * in the header, so entries are appended one at a time
+     */
+    __DARSHAN_CORE_LOCK();
+#endif
+    used = __atomic_load_n(&core->name_mem_used, __ATOMIC_RELAXED);
+    do
     {
-        struct darshan_core_name_record_ref *ref;
-        struct darshan_name_record *name_rec;
-        char *my_buf, *shared_buf;
-        char *tmp_p;
-        int rec_len;
-        int shared_buf_len;
-
-        /* remove globally shared name records from non-zero ranks */
-
-        name_rec = core->log_name_p;
-        my_buf = core->log_name_p;
-        shared_buf = core->comp_buf;
-        shared_buf_len = 0;
-        while(name_rec_buf_len > 0)
+        if(used + size > core->config.name_mem)
         {
-            HASH_FIND(hlink, core->name_hash, &(name_rec->id),
-                sizeof(darshan_record_id), ref);
-            assert(ref);
-            rec_len = sizeof(darshan_record_id) + strlen(name_rec->name) + 1;
-
-            if(ref->global_mod_flags)
-            {
-                /* this record is shared globally, move to the temporary
-                 * shared record buffer and update hash references
-                 */
-                HASH_DELETE(hlink, core->name_hash, ref);
-                memcpy(shared_buf, name_rec, rec_len);
-                ref->name_record = (struct darshan_name_record *)shared_buf;
-                HASH_ADD(hlink, core->name_hash, name_record->id,
-                    sizeof(darshan_record_id), ref);
-
-                shared_buf += rec_len;
-                shared_buf_len += rec_len;
-            }
-            else
-            {
-                /* this record is not shared, but we still may need to
-                 * move it forward in our buffer and update hash references
-                 */
-                if(my_buf != (char *)name_rec)
-                {
-                    HASH_DELETE(hlink, core->name_hash, ref);
-                    memcpy(my_buf, name_rec, rec_len);
-                    ref->name_record =(struct darshan_name_record *)my_buf;
-                    HASH_ADD(hlink, core->name_hash, name_record->id,
-                        sizeof(darshan_record_id), ref);
-                }
-                my_buf += rec_len;
-            }
-
-            tmp_p = (char *)name_rec + rec_len;
-            name_rec = (struct darshan_name_record *)tmp_p;
-            name_rec_buf_len -= rec_len;
+#ifdef __DARSHAN_ENABLE_MMAP_LOGS
+            __DARSHAN_CORE_UNLOCK();
+#endif
+            return(NULL);
         }
-        name_rec_buf_len = core->name_mem_used - shared_buf_len;
-
-        /* append the shared records back to the end of the name record
-         * buffer and update hash table references so we can still
-         * reference these records as modules shutdown
-         */
-        name_rec = (struct darshan_name_record *)core->comp_buf;
-        while(shared_buf_len > 0)
-        {
-            HASH_FIND(hlink, core->name_hash, &(name_rec->id),
-                sizeof(darshan_record_id), ref);
-            assert(ref);
-            rec_len = sizeof(darshan_record_id) + strlen(name_rec->name) + 1;
+    } while(!__atomic_compare_exchange_n(&core->name_mem_used, &used,
+        used + size, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
 
-            HASH_DELETE(hlink, core->name_hash, ref);
-            memcpy(my_buf, name_rec, rec_len);
-            ref->name_record = (struct darshan_name_record *)my_buf;
-            HASH_ADD(hlink, core->name_hash, name_record->id,
-                sizeof(darshan_record_id), ref);
+    entry = (struct darshan_name_entry *)((char *)core->log_name_p + used);
+    entry->id = id;
+    entry->dir = dir;
+    memcpy(entry->name, name, len);
+    entry->name[len] = '\0';
 
-            tmp_p = (char *)name_rec + rec_len;
-            name_rec = (struct darshan_name_record *)tmp_p;
-            my_buf += rec_len;
-            shared_buf_len -= rec_len;
-        }
-    }
+#ifdef __DARSHAN_ENABLE_MMAP_LOGS
+    __DARSHAN_MMAP_GEN_BEGIN(core, name_gen);
+    core->log_hdr_p->name_map.len += size;
+    __DARSHAN_MMAP_GEN_END(core, name_gen);
+    __DARSHAN_CORE_UNLOCK();
 #endif
 
-    /* collectively write out the record hash to the darshan log */
-    ret = darshan_log_append(log_fh, core, core->log_name_p,
-        name_rec_buf_len, inout_off);
-    return(ret);
+    return(entry);
 }
 
-static int darshan_log_write_header(darshan_core_log_fh log_fh,
-    struct darshan_core_runtime *core)
+/* add the entry of directory 'dir_id', the first 'len' characters of 'name'
+ * stored relative to directory 'parent', unless another thread already
+ * did; returns its reference, or NULL if it could not be stored
+ */
+static struct darshan_core_name_dir_ref *darshan_name_dir_add(
+    struct darshan_core_runtime *core, uint64_t dir_id, uint64_t parent,
+    const char *name, int len)
 {
-    int ret;
+    struct darshan_core_name_dir_ref *new_ref, *dir_ref;
+    struct darshan_name_entry *entry;
 
-    core->log_hdr_p->comp_type = DARSHAN_ZLIB_COMP;
+    new_ref = calloc(1, sizeof(*new_ref));
+    if(!new_ref)
+        return(NULL);
+    new_ref->id = dir_id;
+    new_ref->state = DARSHAN_CORE_REF_BUILDING;
 
-#ifdef HAVE_MPI
-    MPI_Status status;
-    if(using_mpi)
+    dir_ref = darshan_core_id_map_add(&core->name_dir_map, new_ref);
+    if(dir_ref != new_ref)
     {
-        /* write out log header, after running 2 reductions on header variables:
-         *  1) reduce 'partial_flag' variable to determine which modules ran out
-         *     of memory for storing data
-         *  2) reduce 'mod_ver' array to determine which log format version each
-         *     module used for this output log
-         */
-        if(my_rank == 0)
-        {
-            PMPI_Reduce(
-                MPI_IN_PLACE, &(core->log_hdr_p->partial_flag),
-                1, MPI_UINT32_T, MPI_BOR, 0, core->mpi_comm);
-            PMPI_Reduce(
-                MPI_IN_PLACE, &(core->log_hdr_p->mod_ver),
-                DARSHAN_KNOWN_MODULE_COUNT, MPI_UINT32_T, MPI_MAX, 0, core->mpi_comm);
-        }
-        else
-        {
-            PMPI_Reduce(
-                &(core->log_hdr_p->partial_flag), &(core->log_hdr_p->partial_flag),
-                1, MPI_UINT32_T, MPI_BOR, 0, core->mpi_comm);
-            PMPI_Reduce(
-                &(core->log_hdr_p->mod_ver), &(core->log_hdr_p->mod_ver),
-                DARSHAN_KNOWN_MODULE_COUNT, MPI_UINT32_T, MPI_MAX, 0, core->mpi_comm);
-            return(0); /* only rank 0 writes the header */
-        }
-
-        /* write the header using MPI */
-        ret = PMPI_File_write_at(log_fh.mpi_fh, 0, core->log_hdr_p,
-            sizeof(struct darshan_header), MPI_BYTE, &status);
-        if(ret != MPI_SUCCESS)
-        {
-            DARSHAN_WARN("error writing darshan log header");
-            ret = -1;
-        }
-        else
-        {
-            ret = 0;
-        }
-        return(ret);
+        free(new_ref);
+        if(!dir_ref ||
+           darshan_core_ref_wait(&dir_ref->state) != DARSHAN_CORE_REF_READY)
+            return(NULL);
+        return(dir_ref);
     }
-#endif
 
-    /* write log header */
-    ret = pwrite(log_fh.nompi_fd, core->log_hdr_p, sizeof(struct darshan_header), 0);
-    if(ret != sizeof(struct darshan_header))
-    {
-        DARSHAN_WARN("error writing darshan log header");
-        ret = -1;
-    }
-    else
+    entry = darshan_name_entry_append(core, dir_id,
+        parent | DARSHAN_NAME_DIR_FLAG, name, len);
+    if(!entry)
     {
-        ret = 0;
+        __atomic_store_n(&dir_ref->state, DARSHAN_CORE_REF_FAILED,
+            __ATOMIC_RELEASE);
+        return(NULL);
     }
+    dir_ref->dir_entry = entry;
+    __atomic_store_n(&dir_ref->state, DARSHAN_CORE_REF_READY, __ATOMIC_RELEASE);
 
-    return(ret);
+    return(dir_ref);
 }
 
-/* NOTE: inout_off contains the starting offset of this append at the beginning
- *       of the call, and contains the ending offset at the end of the call.
- *       This variable is only valid on the root rank (rank 0).
+/* NOTE: names are stored as a tree of directory entries, so that a
+ * directory prefix shared by many names only consumes name memory once.
+ * The thread that publishes the reference of a name in the name map adds
+ * its entry (and those of its missing directories); a thread registering
+ * the same name meanwhile waits for it. A name that could not be stored
+ * keeps a failed reference, so later registrations of it fail right away.
  */
-static int darshan_log_append(darshan_core_log_fh log_fh, struct darshan_core_runtime *core,
-    void *buf, int count, uint64_t *inout_off)
+static int darshan_add_name_record_ref(struct darshan_core_runtime *core,
+    darshan_record_id rec_id, const char *name, darshan_module_id mod_id)
 {
-    int comp_buf_sz = core->config.mod_mem;
-    int ret;
+    struct darshan_core_name_record_ref *new_ref, *ref;
+    int dir_lens[DARSHAN_NAME_MAX_DEPTH];
+    int name_len = strlen(name);
+    int dir_cnt;
+    uint64_t parent, dir_id;
+    int parent_len;
+    size_t record_size;
+    int i;
 
-    /* compress the input buffer */
-    ret = darshan_deflate_buffer((void **)&buf, &count, 1,
-        core->comp_buf, &comp_buf_sz);
-    if(ret < 0)
-        comp_buf_sz = 0;
+    /* do not claim names that will not fit */
+    dir_cnt = darshan_name_dirs_missing(core, name, name_len, dir_lens,
+        &parent, &parent_len, &record_size);
+    if(dir_cnt < 0 || (record_size +
+       __atomic_load_n(&core->name_mem_used, __ATOMIC_RELAXED)) >
+       core->config.name_mem)
+        return(0);
 
-#ifdef HAVE_MPI
-    MPI_Offset send_off, my_off;
-    MPI_Status status;
+    new_ref = calloc(1, sizeof(*new_ref));
+    if(!new_ref)
+        return(0);
+    new_ref->id = rec_id;
+    new_ref->state = DARSHAN_CORE_REF_BUILDING;
+    DARSHAN_MOD_FLAG_SET(new_ref->mod_flags, mod_id);
 
-    if(using_mpi)
+    ref = darshan_core_id_map_add(&core->name_map, new_ref);
+    if(ref != new_ref)
     {
-        /* figure out where everyone is writing using scan */
-        send_off = comp_buf_sz;
-        if(my_rank == 0)
-        {
-            send_off += *inout_off; /* rank 0 knows the beginning offset */
-        }
-
-        PMPI_Scan(&send_off, &my_off, 1, MPI_OFFSET, MPI_SUM, core->mpi_comm);
-        /* scan is inclusive; subtract local size back out */
-        my_off -= comp_buf_sz;
-
-        if(ret == 0)
-        {
-            /* no compression errors, proceed with the collective write */
-            ret = PMPI_File_write_at_all(log_fh.mpi_fh, my_off,
-                core->comp_buf, comp_buf_sz, MPI_BYTE, &status);
-            if(ret != MPI_SUCCESS)
-                ret = -1;
-        }
-        else
-        {
-            /* error during compression. preserve and return error to caller,
-             * but participate in collective write to avoid deadlock.
-             */
-            (void)PMPI_File_write_at_all(log_fh.mpi_fh, my_off,
-                core->comp_buf, comp_buf_sz, MPI_BYTE, &status);
-        }
-
-        if(nprocs > 1)
-        {
-            /* send the ending offset from rank (n-1) to rank 0 */
-            if(my_rank == (nprocs-1))
-            {
-                my_off += comp_buf_sz;
-                PMPI_Send(&my_off, 1, MPI_OFFSET, 0, 0, core->mpi_comm);
-            }
-            if(my_rank == 0)
-            {
-                PMPI_Recv(&my_off, 1, MPI_OFFSET, (nprocs-1), 0, core->mpi_comm, &status);
+        /* someone else added it first */
+        free(new_ref);
+        if(!ref ||
+           darshan_core_ref_wait(&ref->state) != DARSHAN_CORE_REF_READY)
+            return(0);
+        __atomic_fetch_or(&ref->mod_flags, 1ULL << mod_id, __ATOMIC_RELAXED);
+        return(1);
+    }
 
-                *inout_off = my_off;
-            }
-        }
-        else
-        {
-            *inout_off = my_off + comp_buf_sz;
-        }
+    /* add entries for missing directories, shallowest first; others may
+     * add some of them meanwhile
+     */
+    for(i = dir_cnt - 1; i >= 0; i--)
+    {
+        dir_id = darshan_name_dir_id(name, dir_lens[i]);
+        if(!darshan_name_dir_add(core, dir_id, parent, name + parent_len + 1,
+            dir_lens[i] - (parent_len + 1)))
+            break;
+        parent = dir_id;
+        parent_len = dir_lens[i];
+    }
 
-        return(ret);
+    /* initialize the name record */
+    if(i < 0)
+        ref->name_record = darshan_name_entry_append(core, rec_id, parent,
+            name + parent_len + 1, name_len - (parent_len + 1));
+    if(!ref->name_record)
+    {
+        __atomic_store_n(&ref->state, DARSHAN_CORE_REF_FAILED,
+            __ATOMIC_RELEASE);
+        return(0);
     }
-#endif
+    __atomic_store_n(&ref->state, DARSHAN_CORE_REF_READY, __ATOMIC_RELEASE);
 
-    ret = pwrite(log_fh.nompi_fd, core->comp_buf, comp_buf_sz, *inout_off);
-    if(ret != comp_buf_sz)
-        return(-1);
-    *inout_off += comp_buf_sz;
-    return(0);
+    return(1);
 }
 
-void darshan_log_close(darshan_core_log_fh log_fh)
+/* copy the full name of a name entry to 'buf', returning 1 on success or
+ * 0 if it does not fit
+ */
+static int darshan_name_entry_expand(struct darshan_core_runtime *core,
+    struct darshan_name_entry *entry, char *buf, size_t buf_len)
 {
-#ifdef HAVE_MPI
-    if(using_mpi)
+    struct darshan_core_name_dir_ref *dir_ref;
+    struct darshan_name_entry *e;
+    uint64_t dir;
+    size_t len, pos;
+
+    /* first find the full length, then fill the buffer back to front */
+    len = strlen(entry->name);
+    for(e = entry; (dir = (e->dir & ~DARSHAN_NAME_DIR_FLAG)); e = dir_ref->dir_entry)
     {
-        PMPI_File_close(&log_fh.mpi_fh);
-        return;
+        dir_ref = darshan_core_id_map_find(&core->name_dir_map, dir);
+        if(!dir_ref)
+            return(0);
+        len += strlen(dir_ref->dir_entry->name) + 1;
     }
-#endif
-
-    close(log_fh.nompi_fd);
-    return;
-}
+    if(len >= buf_len)
+        return(0);
 
-void darshan_log_finalize(char *logfile_name, double start_log_time)
+    buf[len] = '\0';
+    pos = len;
+    e = entry;
+    while(1)
+    {
+        len = strlen(e->name);
+        pos -= len;
+        memcpy(&buf[pos], e->name, len);
+        dir = e->dir & ~DARSHAN_NAME_DIR_FLAG;
+        if(!dir)
+            break;
+        buf[--pos] = '/';
+        dir_ref = darshan_core_id_map_find(&core->name_dir_map, dir);
+        e = dir_ref->dir_entry;
+    }
+
+    return(1);
+}
+
+static void darshan_get_user_name(char *cuser)
+{
+    char* logname_string;
+
+    /* get the username for this job.  In order we will try each of the
+     * following until one of them succeeds:
+     *
+     * - cuserid() -- if enabled at configure time (disabled by default)
+     * - getenv("LOGNAME")
+     * - snprintf(..., geteuid());
+     *
+     * Note that we do not use getpwuid() because it generally will not
+     * work in statically compiled binaries.
+     */
+
+#ifdef __DARSHAN_USERNAME_ENV
+    logname_string = getenv(__DARSHAN_USERNAME_ENV);
+    if(logname_string)
+    {
+        strncpy(cuser, logname_string, (L_cuserid-1));
+    }
+#endif
+
+#ifdef __DARSHAN_ENABLE_CUSERID
+    if(strcmp(cuser, "") == 0)
+    {
+        cuserid(cuser);
+    }
+#endif
+
+    /* if cuserid() didn't work, then check the environment */
+    if(strcmp(cuser, "") == 0)
+    {
+        logname_string = getenv("LOGNAME");
+        if(logname_string)
+        {
+            strncpy(cuser, logname_string, (L_cuserid-1));
+        }
+    }
+
+    /* if cuserid() and environment both fail, then fall back to uid */
+    if(strcmp(cuser, "") == 0)
+    {
+        uid_t uid = geteuid();
+        snprintf(cuser, L_cuserid, "%u", uid);
+    }
+
+    return;
+}
+
+#ifdef HAVE_MPI
+/* record id and module flags pair exchanged when detecting shared records */
+struct darshan_core_shared_rec
+{
+    darshan_record_id id;
+    uint64_t mod_flags;
+};
+
+static int darshan_core_shared_rec_cmp(const void *a_p, const void *b_p)
+{
+    const struct darshan_core_shared_rec *a = a_p;
+    const struct darshan_core_shared_rec *b = b_p;
+
+    if(a->id < b->id)
+        return(-1);
+    if(a->id > b->id)
+        return(1);
+    return(0);
+}
+
+/* NOTE: record ids are hash-partitioned across processes, so that each
+ * process only has to examine the ids that hash to it. A record is shared
+ * if every process reports it; the owners then allgather the (typically
+ * short) list of shared records so that every process agrees.
+ */
+static void darshan_get_shared_records(struct darshan_core_runtime *core,
+    darshan_record_id **shared_recs, int *shared_rec_cnt)
+{
+    int i, j;
+    int tmp_cnt = 0;
+    uint64_t slot;
+    struct darshan_core_name_record_ref *ref;
+    struct darshan_core_shared_rec *send_recs, *recv_recs, *owned_recs;
+    struct darshan_core_shared_rec *all_shared_recs;
+    int *send_cnts, *send_displs, *recv_cnts, *recv_displs;
+    int recv_cnt = 0, owned_cnt = 0, all_cnt = 0;
+    MPI_Datatype rec_type;
+
+    /* names that could not be stored are not registered */
+    for(slot = 0; slot <= core->name_map.mask; slot++)
+    {
+        ref = core->name_map.slots[slot];
+        if(ref && ref->state == DARSHAN_CORE_REF_READY)
+            tmp_cnt++;
+    }
+
+    send_cnts = calloc(nprocs, sizeof(int));
+    send_displs = malloc(nprocs * sizeof(int));
+    recv_cnts = malloc(nprocs * sizeof(int));
+    recv_displs = malloc(nprocs * sizeof(int));
+    send_recs = malloc(tmp_cnt * sizeof(*send_recs));
+    assert(send_cnts && send_displs && recv_cnts && recv_displs &&
+        (send_recs || !tmp_cnt));
+
+    PMPI_Type_contiguous(2, MPI_UINT64_T, &rec_type);
+    PMPI_Type_commit(&rec_type);
+
+    /* bucket local records by owning process */
+    for(slot = 0; slot <= core->name_map.mask; slot++)
+    {
+        ref = core->name_map.slots[slot];
+        if(ref && ref->state == DARSHAN_CORE_REF_READY)
+            send_cnts[ref->id % nprocs]++;
+    }
+    for(i = 0, j = 0; i < nprocs; i++)
+    {
+        send_displs[i] = j;
+        j += send_cnts[i];
+    }
+    for(slot = 0; slot <= core->name_map.mask; slot++)
+    {
+        ref = core->name_map.slots[slot];
+        if(!ref || ref->state != DARSHAN_CORE_REF_READY)
+            continue;
+        i = ref->name_record->id % nprocs;
+        send_recs[send_displs[i]].id = ref->name_record->id;
+        send_recs[send_displs[i]].mod_flags = ref->mod_flags;
+        send_displs[i]++;
+    }
+    for(i = 0; i < nprocs; i++)
+        send_displs[i] -= send_cnts[i];
+
+    /* send each record to its owner */
+    PMPI_Alltoall(send_cnts, 1, MPI_INT, recv_cnts, 1, MPI_INT, core->mpi_comm);
+    for(i = 0; i < nprocs; i++)
+    {
+        recv_displs[i] = recv_cnt;
+        recv_cnt += recv_cnts[i];
+    }
+    recv_recs = malloc(recv_cnt * sizeof(*recv_recs));
+    assert(recv_recs || !recv_cnt);
+    PMPI_Alltoallv(send_recs, send_cnts, send_displs, rec_type,
+        recv_recs, recv_cnts, recv_displs, rec_type, core->mpi_comm);
+    free(send_recs);
+
+    /* owned records reported by every process (each process reports a given
+     * id at most once) are shared; combine the module flags of each
+     */
+    qsort(recv_recs, recv_cnt, sizeof(*recv_recs), darshan_core_shared_rec_cmp);
+    owned_recs = recv_recs;
+    for(i = 0; i < recv_cnt; i = j)
+    {
+        uint64_t flags = recv_recs[i].mod_flags;
+
+        for(j = i + 1; j < recv_cnt && recv_recs[j].id == recv_recs[i].id; j++)
+            flags &= recv_recs[j].mod_flags;
+
+        if((j - i) == nprocs && flags != 0)
+        {
+            owned_recs[owned_cnt].id = recv_recs[i].id;
+            owned_recs[owned_cnt].mod_flags = flags;
+            owned_cnt++;
+        }
+    }
+
+    /* gather the full list of shared records everywhere */
+    PMPI_Allgather(&owned_cnt, 1, MPI_INT, recv_cnts, 1, MPI_INT, core->mpi_comm);
+    for(i = 0; i < nprocs; i++)
+    {
+        recv_displs[i] = all_cnt;
+        all_cnt += recv_cnts[i];
+    }
+    all_shared_recs = malloc(all_cnt * sizeof(*all_shared_recs));
+    *shared_recs = malloc(all_cnt * sizeof(darshan_record_id));
+    assert((all_shared_recs && *shared_recs) || !all_cnt);
+    PMPI_Allgatherv(owned_recs, owned_cnt, rec_type, all_shared_recs,
+        recv_cnts, recv_displs, rec_type, core->mpi_comm);
+
+    for(i = 0; i < all_cnt; i++)
+    {
+        (*shared_recs)[i] = all_shared_recs[i].id;
+
+        /* set global_mod_flags so we know which modules collectively
+         * accessed this module. we need this info to support shared
+         * record reductions
+         */
+        ref = darshan_core_id_map_find(&core->name_map, all_shared_recs[i].id);
+        assert(ref);
+        ref->global_mod_flags = all_shared_recs[i].mod_flags;
+    }
+    *shared_rec_cnt = all_cnt;
+
+    PMPI_Type_free(&rec_type);
+    free(recv_recs);
+    free(all_shared_recs);
+    free(send_cnts);
+    free(send_displs);
+    free(recv_cnts);
+    free(recv_displs);
+    return;
+}
+#endif
+
+/* construct the darshan log file name */
+/* NOTE: logfile_name argument is assumed to have already been allocated
+ * with size __DARSHAN_PATH_MAX; length will be safety checked in this
+ * function.
+ */
+static void darshan_get_logfile_name(
+    char* logfile_name, struct darshan_core_runtime* core)
+{
+    char* user_logfile_name;
+    uint64_t hlevel;
+    char hname[HOST_NAME_MAX];
+    uint64_t logmod;
+    char cuser[L_cuserid] = {0};
+    struct tm *start_tm;
+    int jobid;
+    int pid;
+    time_t start_time;
+    int ret;
+
+#ifdef HAVE_MPI
+    if (using_mpi && my_rank > 0)
+        goto bcast;
+#endif
+
+    jobid = core->log_job_p->jobid;
+    pid = core->pid;
+
+    /* first, check if user specifies a complete logpath to use */
+    user_logfile_name = getenv("DARSHAN_LOGFILE");
+    if(user_logfile_name)
+    {
+        if(strlen(user_logfile_name) >= (__DARSHAN_PATH_MAX-1))
+        {
+            DARSHAN_WARN("user log file name too long");
+            logfile_name[0] = '\0';
+        }
+        else
+        {
+            strcpy(logfile_name, user_logfile_name);
+        }
+    }
+    else
+    {
+        /* otherwise, generate the log path automatically */
+
+        darshan_get_user_name(cuser);
+
+        /* generate a random number to help differentiate the log */
+        hlevel = darshan_core_wtime_absolute() * 1000000;
+        (void)gethostname(hname, sizeof(hname));
+        logmod = darshan_hash((void*)hname,strlen(hname),hlevel);
+
+        /* use human readable start time format in log filename */
+        start_time = (time_t)core->log_job_p->start_time_sec;
+        start_tm = localtime(&start_time);
+
+        if(core->config.log_path_byenv)
+        {
+            /* Darshan log file is stored in an unformatted directory given
+             * by the user via environment variables specified at configure
+             * time (--with-log-path-by-env configure argument)
+             */
+            ret = snprintf(logfile_name, __DARSHAN_PATH_MAX,
+                "%s/%s_%s_id%d-%d_%d-%d-%d-%" PRIu64 ".darshan_partial",
+                core->config.log_path_byenv,
+                cuser, __progname, jobid, pid,
+                (start_tm->tm_mon+1),
+                start_tm->tm_mday,
+                (start_tm->tm_hour*60*60 + start_tm->tm_min*60 + start_tm->tm_sec),
+                logmod);
+            if(ret == (__DARSHAN_PATH_MAX-1))
+            {
+                /* file name was too big; squish it down */
+                snprintf(logfile_name, __DARSHAN_PATH_MAX,
+                    "%s/id%d.darshan_partial",
+                    core->config.log_path_byenv, jobid);
+            }
+        }
+        else if(core->config.log_path)
+        {
+            /* Darshan log file is stored in an date-formatted directory given
+             * by the user either at configure time (--with-log-path configure
+             * argument) or at runtime using DARSHAN_LOGPATH env var
+             */
+            ret = snprintf(logfile_name, __DARSHAN_PATH_MAX,
+                "%s/%d/%d/%d/%s_%s_id%d-%d_%d-%d-%d-%" PRIu64 ".darshan_partial",
+                core->config.log_path, (start_tm->tm_year+1900),
+                (start_tm->tm_mon+1), start_tm->tm_mday,
+                cuser, __progname, jobid, pid,
+                (start_tm->tm_mon+1),
+                start_tm->tm_mday,
+                (start_tm->tm_hour*60*60 + start_tm->tm_min*60 + start_tm->tm_sec),
+                logmod);
+            if(ret == (__DARSHAN_PATH_MAX-1))
+            {
+                /* file name was too big; squish it down */
+                snprintf(logfile_name, __DARSHAN_PATH_MAX,
+                    "%s/id%d.darshan_partial",
+                    core->config.log_path, jobid);
+            }
+        }
+        else
+        {
+            logfile_name[0] = '\0';
+        }
+    }
+
+#ifdef HAVE_MPI
+bcast:
+    if(using_mpi)
+    {
+        PMPI_Bcast(logfile_name, __DARSHAN_PATH_MAX, MPI_CHAR, 0, core->mpi_comm);
+        if(my_rank > 0)
+            return;
+    }
+#endif
+
+    if(strlen(logfile_name) == 0)
+        DARSHAN_WARN("unable to determine log file path");
+
+    return;
+}
+
+static int darshan_log_open(char *logfile_name, struct darshan_core_runtime *core,
+    darshan_core_log_fh *log_fh)
+{
+#ifdef HAVE_MPI
+    int ret;
+    char *hints;
+    char *tok_str;
+    char *orig_tok_str;
+    char *key;
+    char *value;
+    char *saveptr = NULL;
+    MPI_Info info;
+
+    if(using_mpi)
+    {
+        /* set any log file hints darshan has been configured to use */
+        MPI_Info_create(&info);
+
+        hints = core->config.log_hints;
+        if(hints && strlen(hints) > 0)
+        {
+            tok_str = strdup(hints);
+            if(tok_str)
+            {
+                orig_tok_str = tok_str;
+                do
+                {
+                    /* split string on semicolon */
+                    key = strtok_r(tok_str, ";", &saveptr);
+                    if(key)
+                    {
+                        tok_str = NULL;
+                        /* look for = sign splitting key/value pairs */
+                        value = index(key, '=');
+                        if(value)
+                        {
+                            /* break key and value into separate null terminated strings */
+                            value[0] = '\0';
+                            value++;
+                            if(strlen(key) > 0)
+                                MPI_Info_set(info, key, value);
+                        }
+                    }
+                }while(key != NULL);
+                free(orig_tok_str);
+            }
+        }
+
+        /* open the darshan log file for writing using MPI; with node-local
+         * aggregation, only the node leaders write to (and open) the log
+         */
+        if(core->node_agg)
+        {
+            log_fh->mpi_fh = MPI_FILE_NULL;
+            if(core->leader_comm == MPI_COMM_NULL)
+            {
+                MPI_Info_free(&info);
+                return(0);
+            }
+            ret = MPI_File_open(core->leader_comm, logfile_name,
+                MPI_MODE_CREATE | MPI_MODE_WRONLY | MPI_MODE_EXCL, info,
+                &log_fh->mpi_fh);
+        }
+        else
+            ret = MPI_File_open(core->mpi_comm, logfile_name,
+                MPI_MODE_CREATE | MPI_MODE_WRONLY | MPI_MODE_EXCL, info,
+                &log_fh->mpi_fh);
+        MPI_Info_free(&info);
+        if(ret != MPI_SUCCESS)
+            return(-1);
+        return(0);
+    }
+#endif
+
+    /* open the darshan log file for writing */
+    log_fh->nompi_fd = open(logfile_name, O_CREAT | O_WRONLY | O_EXCL, S_IRUSR);
+    if(log_fh->nompi_fd < 0)
+        return(-1);
+    return(0);
+}
+
+static int darshan_log_write_job_record(darshan_core_log_fh log_fh,
+    struct darshan_core_runtime *core, uint64_t *inout_off)
+{
+    /* prepare to write two contiguous elements in file: the job structure
+     * and a trailing string that contains the command line and mount table
+     * information. Include a trailing null byte in the latter.
+     */
+    void *pointers[2] = {core->log_job_p, core->log_exemnt_p};
+    int lengths[2] = {sizeof(struct darshan_job), strlen(core->log_exemnt_p)+1};
+    int comp_buf_sz = core->config.mod_mem;
+    int ret;
+
+#ifdef HAVE_MPI
+    /* only rank 0 writes the job record */
+    if (using_mpi && my_rank > 0)
+        return(0);
+#endif
+
+    /* compress the job info and the trailing mount/exe data */
+    ret = darshan_compress_buffer(core->config.log_comp_type, pointers,
+        lengths, 2, core->comp_buf, &comp_buf_sz);
+    if(ret)
+    {
+        DARSHAN_WARN("error compressing job record");
+    }
+    else
+    {
+        /* write the job information, preallocing space for the log header */
+        *inout_off += sizeof(struct darshan_header);
+
+#ifdef HAVE_MPI
+        MPI_Status status;
+        if(using_mpi)
+        {
+            ret = PMPI_File_write_at(log_fh.mpi_fh, *inout_off, core->comp_buf,
+                comp_buf_sz, MPI_BYTE, &status);
+            if(ret != MPI_SUCCESS)
+            {
+                DARSHAN_WARN("error writing job record");
+                ret = -1;
+            }
+            else
+            {
+                *inout_off += comp_buf_sz;
+                ret = 0;
+            }
+
+            return(ret);
+        }
+#endif
+
+        ret = pwrite(log_fh.nompi_fd, core->comp_buf, comp_buf_sz, *inout_off);
+        if(ret != comp_buf_sz)
+        {
+            DARSHAN_WARN("error writing job record");
+            ret = -1;
+        }
+        else
+        {
+            *inout_off += comp_buf_sz;
+            ret = 0;
+        }
+    }
+
+    return(ret);
+}
+
+static int darshan_log_write_name_record_hash(darshan_core_log_fh log_fh,
+    struct darshan_core_runtime *core, uint64_t *inout_off)
+{
+    int name_rec_buf_len;
+    int ret;
+
+    name_rec_buf_len = core->name_mem_used;
+#ifdef HAVE_MPI
+    if(using_mpi && (my_rank > 0))
+    {
+        struct darshan_core_name_record_ref *ref;
+        struct darshan_core_name_dir_ref *dir_ref;
+        struct darshan_name_entry *name_rec;
+        char *my_buf, *shared_buf;
+        char *tmp_p;
+        int rec_len;
+        int shared_buf_len;
+
+        /* remove globally shared name records from non-zero ranks */
+        /* NOTE: directory entries are kept, as non-shared records may
+         * refer to them
+         */
+
+        name_rec = core->log_name_p;
+        my_buf = core->log_name_p;
+        shared_buf = core->comp_buf;
+        shared_buf_len = 0;
+        while(name_rec_buf_len > 0)
+        {
+            rec_len = DARSHAN_NAME_ENTRY_SIZE(strlen(name_rec->name));
+
+            if(name_rec->dir & DARSHAN_NAME_DIR_FLAG)
+            {
+                /* move directory entries forward in our buffer and update
+                 * hash references
+                 */
+                if(my_buf != (char *)name_rec)
+                {
+                    dir_ref = darshan_core_id_map_find(&core->name_dir_map,
+                        name_rec->id);
+                    assert(dir_ref);
+                    memmove(my_buf, name_rec, rec_len);
+                    dir_ref->dir_entry = (struct darshan_name_entry *)my_buf;
+                }
+                my_buf += rec_len;
+                tmp_p = (char *)name_rec + rec_len;
+                name_rec = (struct darshan_name_entry *)tmp_p;
+                name_rec_buf_len -= rec_len;
+                continue;
+            }
+
+            ref = darshan_core_id_map_find(&core->name_map, name_rec->id);
+            assert(ref);
+
+            if(ref->global_mod_flags)
+            {
+                /* this record is shared globally, move to the temporary
+                 * shared record buffer and update hash references
+                 */
+                memcpy(shared_buf, name_rec, rec_len);
+                ref->name_record = (struct darshan_name_entry *)shared_buf;
+
+                shared_buf += rec_len;
+                shared_buf_len += rec_len;
+            }
+            else
+            {
+                /* this record is not shared, but we still may need to
+                 * move it forward in our buffer and update hash references
+                 */
+                if(my_buf != (char *)name_rec)
+                {
+                    memmove(my_buf, name_rec, rec_len);
+                    ref->name_record = (struct darshan_name_entry *)my_buf;
+                }
+                my_buf += rec_len;
+            }
+
+            tmp_p = (char *)name_rec + rec_len;
+            name_rec = (struct darshan_name_entry *)tmp_p;
+            name_rec_buf_len -= rec_len;
+        }
+        name_rec_buf_len = core->name_mem_used - shared_buf_len;
+
+        /* append the shared records back to the end of the name record
+         * buffer and update hash table references so we can still
+         * reference these records as modules shutdown
+         */
+        name_rec = (struct darshan_name_entry *)core->comp_buf;
+        while(shared_buf_len > 0)
+        {
+            ref = darshan_core_id_map_find(&core->name_map, name_rec->id);
+            assert(ref);
+            rec_len = DARSHAN_NAME_ENTRY_SIZE(strlen(name_rec->name));
+
+            memcpy(my_buf, name_rec, rec_len);
+            ref->name_record = (struct darshan_name_entry *)my_buf;
+
+            tmp_p = (char *)name_rec + rec_len;
+            name_rec = (struct darshan_name_entry *)tmp_p;
+            my_buf += rec_len;
+            shared_buf_len -= rec_len;
+        }
+    }
+#endif
+
+    /* collectively write out the record hash to the darshan log */
+    if(core->collect_cnt)
+        ret = darshan_log_append_collected(log_fh, core, -1,
+            core->log_name_p, name_rec_buf_len, inout_off);
+    else
+        ret = darshan_log_append(log_fh, core, core->log_name_p,
+            name_rec_buf_len, inout_off);
+    return(ret);
+}
+
+static int darshan_log_write_header(darshan_core_log_fh log_fh,
+    struct darshan_core_runtime *core)
+{
+    int ret;
+
+    core->log_hdr_p->comp_type = core->config.log_comp_type;
+
+#ifdef HAVE_MPI
+    MPI_Status status;
+    if(using_mpi)
+    {
+        /* write out log header, after running 2 reductions on header variables:
+         *  1) reduce 'partial_flag' variable to determine which modules ran out
+         *     of memory for storing data
+         *  2) reduce 'mod_ver' array to determine which log format version each
+         *     module used for this output log
+         */
+        if(my_rank == 0)
+        {
+            PMPI_Reduce(
+                MPI_IN_PLACE, &(core->log_hdr_p->partial_flag),
+                1, MPI_UINT32_T, MPI_BOR, 0, core->mpi_comm);
+            PMPI_Reduce(
+                MPI_IN_PLACE, &(core->log_hdr_p->mod_ver),
+                DARSHAN_KNOWN_MODULE_COUNT, MPI_UINT32_T, MPI_MAX, 0, core->mpi_comm);
+        }
+        else
+        {
+            PMPI_Reduce(
+                &(core->log_hdr_p->partial_flag), &(core->log_hdr_p->partial_flag),
+                1, MPI_UINT32_T, MPI_BOR, 0, core->mpi_comm);
+            PMPI_Reduce(
+                &(core->log_hdr_p->mod_ver), &(core->log_hdr_p->mod_ver),
+                DARSHAN_KNOWN_MODULE_COUNT, MPI_UINT32_T, MPI_MAX, 0, core->mpi_comm);
+            return(0); /* only rank 0 writes the header */
+        }
+
+        /* write the header using MPI */
+        ret = PMPI_File_write_at(log_fh.mpi_fh, 0, core->log_hdr_p,
+            sizeof(struct darshan_header), MPI_BYTE, &status);
+        if(ret != MPI_SUCCESS)
+        {
+            DARSHAN_WARN("error writing darshan log header");
+            ret = -1;
+        }
+        else
+        {
+            ret = 0;
+        }
+        return(ret);
+    }
+#endif
+
+    /* write log header */
+    ret = pwrite(log_fh.nompi_fd, core->log_hdr_p, sizeof(struct darshan_header), 0);
+    if(ret != sizeof(struct darshan_header))
+    {
+        DARSHAN_WARN("error writing darshan log header");
+        ret = -1;
+    }
+    else
+    {
+        ret = 0;
+    }
+
+    return(ret);
+}
+
+/* NOTE: inout_off contains the starting offset of this append at the beginning
+ *       of the call, and contains the ending offset at the end of the call.
+ *       This variable is only valid on the root rank (rank 0).
+ */
+static int darshan_log_append(darshan_core_log_fh log_fh, struct darshan_core_runtime *core,
+    void *buf, int count, uint64_t *inout_off)
+{
+    int comp_buf_sz = core->config.mod_mem;
+    char *comp_buf;
+    char *big_comp_buf = NULL;
+    int ret;
+
+#ifdef HAVE_MPI
+    if(using_mpi && core->node_agg)
+        return(darshan_log_append_node_agg(log_fh, core, buf, count,
+            inout_off));
+#endif
+
+    /* compress the input buffer */
+    ret = darshan_compress_buffer(core->config.log_comp_type, (void **)&buf,
+        &count, 1, core->comp_buf, &comp_buf_sz);
+    if(ret < 0 && count > core->config.mod_mem)
+    {
+        /* module output (e.g., spilled DXT traces) may be larger than the
+         * module memory budget; retry with a buffer sized for the input
+         */
+        comp_buf_sz = count + (count / 8) + 1024;
+        big_comp_buf = malloc(comp_buf_sz);
+        if(big_comp_buf)
+            ret = darshan_compress_buffer(core->config.log_comp_type,
+                (void **)&buf, &count, 1, big_comp_buf, &comp_buf_sz);
+    }
+    if(ret < 0)
+        comp_buf_sz = 0;
+    comp_buf = big_comp_buf ? big_comp_buf : core->comp_buf;
+
+    ret = darshan_log_write_chunk(log_fh, core, comp_buf, comp_buf_sz, ret,
+        inout_off, NULL);
+    free(big_comp_buf);
+    return(ret);
+}
+
+/* like darshan_log_append(), but follows the given buffer with the name
+ * records (if mod_id is negative) or the given module's data of each
+ * collected child, compressing them all as a single stream
+ */
+static int darshan_log_append_collected(darshan_core_log_fh log_fh,
+    struct darshan_core_runtime *core, int mod_id, void *buf, int count,
+    uint64_t *inout_off)
+{
+    struct darshan_collect_child *child;
+    void **pointers;
+    int *lengths;
+    int64_t total = count;
+    int comp_buf_sz = core->config.mod_mem;
+    char *comp_buf;
+    char *big_comp_buf = NULL;
+    int n = 1;
+    int i;
+    int ret = -1;
+
+    pointers = malloc((core->collect_cnt + 1) * sizeof(*pointers));
+    lengths = malloc((core->collect_cnt + 1) * sizeof(*lengths));
+    if(pointers && lengths)
+    {
+        pointers[0] = buf;
+        lengths[0] = count;
+        for(i = 0; i < core->collect_cnt; i++)
+        {
+            child = &core->collect_children[i];
+            if(mod_id < 0)
+            {
+                pointers[n] = child->name_p;
+                lengths[n] = child->hdr->name_len;
+            }
+            else
+            {
+                pointers[n] = child->mod_p[mod_id];
+                lengths[n] = child->hdr->mod_len[mod_id];
+            }
+            if(lengths[n] > 0)
+                total += lengths[n++];
+        }
+
+        ret = darshan_compress_buffer(core->config.log_comp_type, pointers,
+            lengths, n, core->comp_buf, &comp_buf_sz);
+        if(ret < 0 && total > core->config.mod_mem && total < INT_MAX / 2)
+        {
+            /* as in darshan_log_append(), retry with a buffer sized for
+             * the input
+             */
+            comp_buf_sz = total + (total / 8) + 1024;
+            big_comp_buf = malloc(comp_buf_sz);
+            if(big_comp_buf)
+                ret = darshan_compress_buffer(core->config.log_comp_type,
+                    pointers, lengths, n, big_comp_buf, &comp_buf_sz);
+        }
+    }
+    if(ret < 0)
+        comp_buf_sz = 0;
+    comp_buf = big_comp_buf ? big_comp_buf : core->comp_buf;
+
+    ret = darshan_log_write_chunk(log_fh, core, comp_buf, comp_buf_sz, ret,
+        inout_off, NULL);
+    free(big_comp_buf);
+    free(pointers);
+    free(lengths);
+    return(ret);
+}
+
+/* like darshan_log_append(), but leaves the records the module retired out
+ * of the given buffer, and instead follows its compressed data with the
+ * staged copies of those records, as concatenated compressed streams
+ */
+static int darshan_log_append_retired(darshan_core_log_fh log_fh,
+    struct darshan_core_runtime *core, struct darshan_core_module *mod,
+    void *buf, int count, uint64_t *inout_off)
+{
+    struct darshan_core_retired_chunk *chunk;
+    struct darshan_core_retired_ref *ref;
+    darshan_record_id rec_id;
+    size_t rec_size = 0;
+    int64_t retired_len = 0;
+    int64_t needed;
+    char *rec, *out;
+    int comp_buf_sz = core->config.mod_mem;
+    int avail;
+    char *comp_buf = core->comp_buf;
+    char *big_comp_buf = NULL;
+    int ret;
+
+    LL_FOREACH(mod->retired_chunks, chunk)
+    {
+        if(!chunk->live)
+            continue;
+        rec_size = chunk->rec_size;
+        retired_len += chunk->comp_len;
+    }
+
+    /* compact the records that are still written from the buffer */
+    out = buf;
+    for(rec = buf; rec + rec_size <= (char *)buf + count; rec += rec_size)
+    {
+        rec_id = ((struct darshan_base_record *)rec)->id;
+        HASH_FIND(hlink, mod->retired_hash, &rec_id,
+            sizeof(darshan_record_id), ref);
+        if(ref)
+            continue;
+        if(out != rec)
+            memmove(out, rec, rec_size);
+        out += rec_size;
+    }
+    count = out - (char *)buf;
+
+    needed = (int64_t)count + (count / 8) + 1024 + retired_len;
+    if(needed > comp_buf_sz && needed < INT_MAX)
+    {
+        big_comp_buf = malloc(needed);
+        if(big_comp_buf)
+        {
+            comp_buf = big_comp_buf;
+            comp_buf_sz = needed;
+        }
+    }
+
+    avail = comp_buf_sz - retired_len;
+    ret = -1;
+    if(avail > 0)
+        ret = darshan_compress_buffer(core->config.log_comp_type,
+            (void **)&buf, &count, 1, comp_buf, &avail);
+    if(ret == 0)
+    {
+        comp_buf_sz = avail;
+        LL_FOREACH(mod->retired_chunks, chunk)
+        {
+            if(!chunk->live)
+                continue;
+            memcpy(comp_buf + comp_buf_sz, chunk->comp_buf, chunk->comp_len);
+            comp_buf_sz += chunk->comp_len;
+        }
+    }
+    else
+        comp_buf_sz = 0;
+
+    ret = darshan_log_write_chunk(log_fh, core, comp_buf, comp_buf_sz, ret,
+        inout_off, NULL);
+    free(big_comp_buf);
+    return(ret);
+}
+
+/* write this rank's compressed chunk of a log region following the chunks
+ * of all lower ranks. 'comp_ret' is the status of compressing the chunk;
+ * on error, this rank still participates in the collective write (with no
+ * data) to avoid deadlock, and the error is returned. If 'out_off' is
+ * non-NULL, it is set to the file offset this rank's chunk was written at.
+ * The same rules for inout_off apply as for darshan_log_append().
+ */
+static int darshan_log_write_chunk(darshan_core_log_fh log_fh,
+    struct darshan_core_runtime *core, char *comp_buf, int comp_buf_sz,
+    int comp_ret, uint64_t *inout_off, uint64_t *out_off)
+{
+    int ret = comp_ret;
+    double tm1 = 0;
+
+#ifdef HAVE_MPI
+    MPI_Offset send_off, my_off;
+    MPI_Status status;
+#endif
+
+    if(shutdown_timing_flag)
+        tm1 = darshan_core_wtime_absolute();
+
+#ifdef HAVE_MPI
+    if(using_mpi)
+    {
+        MPI_Comm comm = core->mpi_comm;
+        int rank = my_rank;
+        int size = nprocs;
+
+        /* only the ranks in the sparse communicator take part, if set */
+        if(core->sparse_write)
+        {
+            comm = core->sparse_comm;
+            PMPI_Comm_rank(comm, &rank);
+            PMPI_Comm_size(comm, &size);
+        }
+
+        /* figure out where everyone is writing using scan */
+        send_off = comp_buf_sz;
+        if(rank == 0)
+        {
+            send_off += *inout_off; /* rank 0 knows the beginning offset */
+        }
+
+        PMPI_Scan(&send_off, &my_off, 1, MPI_OFFSET, MPI_SUM, comm);
+        /* scan is inclusive; subtract local size back out */
+        my_off -= comp_buf_sz;
+        if(out_off)
+            *out_off = my_off;
+
+        if(core->sparse_write || core->indep_write)
+        {
+            /* the file was opened by all ranks, so write independently */
+            if(ret == 0 && comp_buf_sz > 0)
+            {
+                ret = PMPI_File_write_at(log_fh.mpi_fh, my_off,
+                    comp_buf, comp_buf_sz, MPI_BYTE, &status);
+                if(ret != MPI_SUCCESS)
+                    ret = -1;
+            }
+        }
+        else if(ret == 0)
+        {
+            /* no compression errors, proceed with the collective write */
+            ret = PMPI_File_write_at_all(log_fh.mpi_fh, my_off,
+                comp_buf, comp_buf_sz, MPI_BYTE, &status);
+            if(ret != MPI_SUCCESS)
+                ret = -1;
+        }
+        else
+        {
+            /* error during compression. preserve and return error to caller,
+             * but participate in collective write to avoid deadlock.
+             */
+            (void)PMPI_File_write_at_all(log_fh.mpi_fh, my_off,
+                comp_buf, comp_buf_sz, MPI_BYTE, &status);
+        }
+
+        if(size > 1)
+        {
+            /* send the ending offset from rank (n-1) to rank 0 */
+            if(rank == (size-1))
+            {
+                my_off += comp_buf_sz;
+                PMPI_Send(&my_off, 1, MPI_OFFSET, 0, 0, comm);
+            }
+            if(rank == 0)
+            {
+                PMPI_Recv(&my_off, 1, MPI_OFFSET, (size-1), 0, comm, &status);
+
+                *inout_off = my_off;
+            }
+        }
+        else
+        {
+            *inout_off = my_off + comp_buf_sz;
+        }
+
+        if(shutdown_timing_flag)
+            shutdown_tm.write += darshan_core_wtime_absolute() - tm1;
+        return(ret);
+    }
+#endif
+
+    if(out_off)
+        *out_off = *inout_off;
+    ret = pwrite(log_fh.nompi_fd, comp_buf, comp_buf_sz, *inout_off);
+    if(shutdown_timing_flag)
+        shutdown_tm.write += darshan_core_wtime_absolute() - tm1;
+    if(ret != comp_buf_sz)
+        return(-1);
+    *inout_off += comp_buf_sz;
+    return(0);
+}
+
+/* size of the records in a module's output buffer, for modules whose
+ * output is an array of fixed-size records that start with a
+ * darshan_base_record; 0 for all other modules
+ */
+static size_t darshan_log_index_rec_size(darshan_module_id mod_id)
+{
+    switch(mod_id)
+    {
+        case DARSHAN_POSIX_MOD:
+            return(sizeof(struct darshan_posix_file));
+        case DARSHAN_MPIIO_MOD:
+            return(sizeof(struct darshan_mpiio_file));
+        case DARSHAN_H5F_MOD:
+            return(sizeof(struct darshan_hdf5_file));
+        case DARSHAN_H5D_MOD:
+            return(sizeof(struct darshan_hdf5_dataset));
+        case DARSHAN_PNETCDF_FILE_MOD:
+            return(sizeof(struct darshan_pnetcdf_file));
+        case DARSHAN_PNETCDF_VAR_MOD:
+            return(sizeof(struct darshan_pnetcdf_var));
+        case DARSHAN_STDIO_MOD:
+            return(sizeof(struct darshan_stdio_file));
+        case DARSHAN_BATCHIO_MOD:
+            return(sizeof(struct darshan_batchio_record));
+        default:
+            return(0);
+    }
+}
+
+static int darshan_log_index_rec_cmp(const void *a, const void *b)
+{
+    darshan_record_id id_a = ((const struct darshan_base_record *)a)->id;
+    darshan_record_id id_b = ((const struct darshan_base_record *)b)->id;
+
+    return((id_a > id_b) - (id_a < id_b));
+}
+
+/* whether the module's blocks are written in the columnar layout, which
+ * requires records made up entirely of 8-byte fields
+ */
+static int darshan_log_index_columnar(struct darshan_core_runtime *core,
+    darshan_module_id mod_id)
+{
+    size_t rec_size = darshan_log_index_rec_size(mod_id);
+
+    return(core->config.log_columnar_flag && rec_size &&
+        (rec_size % sizeof(uint64_t)) == 0);
+}
+
+/* compress a block of 'nrecs' records in the columnar layout: the records
+ * are transposed into 'col_buf' so that each 8-byte field is contiguous
+ * across records, then each column is compressed as its own stream after
+ * the number of columns and the compressed column lengths
+ */
+static int darshan_log_compress_columns(int comp_type, char *rec_buf,
+    size_t nrecs, size_t rec_size, uint64_t *col_buf, char *comp_buf,
+    int *comp_buf_length)
+{
+    uint64_t ncols = rec_size / sizeof(uint64_t);
+    int used = (ncols + 1) * sizeof(uint64_t);
+    uint64_t col_len;
+    void *col_p;
+    int col_sz;
+    int tmp_sz;
+    size_t r, c;
+    int ret;
+
+    if(used > *comp_buf_length)
+        return(-1);
+    memcpy(comp_buf, &ncols, sizeof(ncols));
+
+    for(r = 0; r < nrecs; r++)
+        for(c = 0; c < ncols; c++)
+            memcpy(&col_buf[(c * nrecs) + r],
+                rec_buf + (r * rec_size) + (c * sizeof(uint64_t)),
+                sizeof(uint64_t));
+
+    for(c = 0; c < ncols; c++)
+    {
+        col_p = &col_buf[c * nrecs];
+        col_sz = nrecs * sizeof(uint64_t);
+        tmp_sz = *comp_buf_length - used;
+        ret = darshan_compress_buffer(comp_type, &col_p, &col_sz, 1,
+            comp_buf + used, &tmp_sz);
+        if(ret < 0)
+            return(ret);
+        col_len = tmp_sz;
+        memcpy(comp_buf + ((c + 1) * sizeof(uint64_t)), &col_len,
+            sizeof(col_len));
+        used += tmp_sz;
+    }
+
+    *comp_buf_length = used;
+    return(0);
+}
+
+/* variant of darshan_log_append() used for module data when the block
+ * index is enabled: fixed-size records are sorted by record id and
+ * compressed as independent streams of at most LOG_INDEX_BLOCK_RECS
+ * records each (or in the columnar layout, if enabled), while other
+ * modules' data is compressed as a single block. Index entries for this
+ * rank's blocks are appended to the core's log_index. The same rules for
+ * inout_off apply as for darshan_log_append().
+ */
+static int darshan_log_append_indexed(darshan_core_log_fh log_fh,
+    struct darshan_core_runtime *core, darshan_module_id mod_id,
+    void *buf, int count, uint64_t *inout_off)
+{
+    size_t rec_size = darshan_log_index_rec_size(mod_id);
+    size_t block_recs = core->config.log_index_block_recs;
+    size_t nrecs = 0;
+    size_t blk_nrecs;
+    int nblocks = 0;
+    int comp_buf_sz = core->config.mod_mem;
+    char *comp_buf = core->comp_buf;
+    char *big_comp_buf = NULL;
+    struct darshan_log_block *blk;
+    struct darshan_log_block *tmp_index;
+    int columnar = darshan_log_index_columnar(core, mod_id);
+    uint64_t *col_buf = NULL;
+    uint64_t my_off = 0;
+    char *blk_buf;
+    int blk_sz;
+    int tmp_sz;
+    int used = 0;
+    int attempt;
+    int new_max;
+    int i;
+    int ret = 0;
+
+    if(rec_size && count > 0 && (count % rec_size) == 0)
+    {
+        /* sort records so that blocks cover disjoint record id ranges */
+        nrecs = count / rec_size;
+        qsort(buf, nrecs, rec_size, darshan_log_index_rec_cmp);
+        nblocks = (nrecs + block_recs - 1) / block_recs;
+    }
+    else
+    {
+        rec_size = 0;
+        if(count > 0)
+            nblocks = 1;
+        /* the header marks every block of a columnar module as columnar */
+        if(columnar && count > 0)
+            ret = -1;
+    }
+
+    if(ret == 0 && columnar && nrecs)
+    {
+        col_buf = malloc(((nrecs < block_recs) ? nrecs : block_recs) * rec_size);
+        if(!col_buf)
+            ret = -1;
+    }
+
+    /* make room for this module's index entries */
+    if(core->log_index_cnt + nblocks > core->log_index_max)
+    {
+        new_max = 2 * (core->log_index_cnt + nblocks);
+        tmp_index = realloc(core->log_index, new_max * sizeof(*tmp_index));
+        if(tmp_index)
+        {
+            core->log_index = tmp_index;
+            core->log_index_max = new_max;
+        }
+        else
+            ret = -1;
+    }
+
+    /* compress each block into consecutive regions of the compression
+     * buffer, retrying once with a larger buffer like darshan_log_append()
+     */
+    for(attempt = 0; ret == 0 && attempt < 2; attempt++)
+    {
+        used = 0;
+        for(i = 0; ret == 0 && i < nblocks; i++)
+        {
+            blk = &core->log_index[core->log_index_cnt + i];
+            if(rec_size)
+            {
+                blk_nrecs = nrecs - (i * block_recs);
+                if(blk_nrecs > block_recs)
+                    blk_nrecs = block_recs;
+                blk_buf = (char *)buf + (i * block_recs * rec_size);
+                blk_sz = blk_nrecs * rec_size;
+                blk->first_id = ((struct darshan_base_record *)blk_buf)->id;
+                blk->last_id = ((struct darshan_base_record *)
+                    (blk_buf + blk_sz - rec_size))->id;
+                blk->nrecs = blk_nrecs;
+            }
+            else
+            {
+                /* only fixed-size records are ever laid out by column */
+                assert(!col_buf);
+                blk_nrecs = 0;
+                blk_buf = buf;
+                blk_sz = count;
+                blk->first_id = 0;
+                blk->last_id = UINT64_MAX;
+                blk->nrecs = blk_nrecs;
+            }
+
+            tmp_sz = comp_buf_sz - used;
+            if(col_buf)
+                ret = darshan_log_compress_columns(core->config.log_comp_type,
+                    blk_buf, blk_nrecs, rec_size, col_buf, comp_buf + used,
+                    &tmp_sz);
+            else
+                ret = darshan_compress_buffer(core->config.log_comp_type,
+                    (void **)&blk_buf, &blk_sz, 1, comp_buf + used, &tmp_sz);
+            blk->rank = my_rank;
+            blk->mod_id = mod_id;
+            blk->off = used;
+            blk->len = tmp_sz;
+            used += tmp_sz;
+        }
+        if(ret == 0 || big_comp_buf)
+            break;
+
+        /* leave headroom for incompressible data and per-block framing */
+        comp_buf_sz = count + (count / 8) + (1024 * nblocks);
+        if(col_buf)
+            comp_buf_sz += nblocks * (rec_size / sizeof(uint64_t)) * 128;
+        big_comp_buf = malloc(comp_buf_sz);
+        if(!big_comp_buf)
+            break;
+        comp_buf = big_comp_buf;
+        ret = 0;
+    }
+    if(ret < 0)
+        used = 0;
+
+    ret = darshan_log_write_chunk(log_fh, core, comp_buf, used, ret,
+        inout_off, &my_off);
+    if(ret == 0)
+    {
+        /* block offsets are relative to this rank's chunk until now */
+        for(i = 0; i < nblocks; i++)
+            core->log_index[core->log_index_cnt + i].off += my_off;
+        core->log_index_cnt += nblocks;
+    }
+
+    free(big_comp_buf);
+    free(col_buf);
+    return(ret);
+}
+
+/* gather all ranks' block index entries to rank 0, which appends them to
+ * the log followed by the index trailer. The index is optional, so on
+ * failure it is simply left out of the log.
+ */
+static void darshan_log_write_index(darshan_core_log_fh log_fh,
+    struct darshan_core_runtime *core, uint64_t *inout_off)
+{
+    struct darshan_log_block *index = core->log_index;
+    struct darshan_log_index_trailer trailer;
+    int64_t index_sz = core->log_index_cnt * sizeof(*index);
+    int ok = 1;
+    int ret;
+
+#ifdef HAVE_MPI
+    int my_sz = (int)index_sz;
+    int *counts = NULL;
+    int *displs = NULL;
+    MPI_Status status;
+    int i;
+
+    if(using_mpi)
+    {
+        index = NULL;
+        if(my_rank == 0)
+        {
+            counts = malloc(nprocs * sizeof(*counts));
+            displs = malloc(nprocs * sizeof(*displs));
+            if(!counts || !displs)
+                ok = 0;
+        }
+        PMPI_Bcast(&ok, 1, MPI_INT, 0, core->mpi_comm);
+        if(ok)
+        {
+            PMPI_Gather(&my_sz, 1, MPI_INT, counts, 1, MPI_INT, 0,
+                core->mpi_comm);
+            if(my_rank == 0)
+            {
+                index_sz = 0;
+                for(i = 0; i < nprocs; i++)
+                {
+                    displs[i] = (int)index_sz;
+                    index_sz += counts[i];
+                }
+                if(index_sz > INT_MAX)
+                    ok = 0;
+                else
+                {
+                    index = malloc(index_sz ? index_sz : 1);
+                    if(!index)
+                        ok = 0;
+                }
+            }
+            PMPI_Bcast(&ok, 1, MPI_INT, 0, core->mpi_comm);
+            if(ok)
+                PMPI_Gatherv(core->log_index, my_sz, MPI_BYTE, index,
+                    counts, displs, MPI_BYTE, 0, core->mpi_comm);
+        }
+        free(counts);
+        free(displs);
+        if(my_rank != 0)
+            return;
+        if(!ok)
+        {
+            DARSHAN_WARN("unable to gather log block index");
+            free(index);
+            return;
+        }
+
+        trailer.off = *inout_off;
+        trailer.count = index_sz / sizeof(*index);
+        trailer.magic_nr = DARSHAN_LOG_INDEX_MAGIC_NR;
+        ret = PMPI_File_write_at(log_fh.mpi_fh, *inout_off, index,
+            (int)index_sz, MPI_BYTE, &status);
+        if(ret == MPI_SUCCESS)
+            ret = PMPI_File_write_at(log_fh.mpi_fh, *inout_off + index_sz,
+                &trailer, sizeof(trailer), MPI_BYTE, &status);
+        if(ret != MPI_SUCCESS)
+            DARSHAN_WARN("error writing log block index");
+        else
+            *inout_off += index_sz + sizeof(trailer);
+        free(index);
+        return;
+    }
+#endif
+
+    trailer.off = *inout_off;
+    trailer.count = core->log_index_cnt;
+    trailer.magic_nr = DARSHAN_LOG_INDEX_MAGIC_NR;
+    ret = pwrite(log_fh.nompi_fd, index, index_sz, *inout_off);
+    if(ret == index_sz)
+        ret = pwrite(log_fh.nompi_fd, &trailer, sizeof(trailer),
+            *inout_off + index_sz);
+    else
+        ret = -1;
+    if(ret != (int)sizeof(trailer))
+        DARSHAN_WARN("error writing log block index");
+    else
+        *inout_off += index_sz + sizeof(trailer);
+
+    return;
+}
+
+#ifdef __DARSHAN_PIPELINED_SHUTDOWN
+/* pipelined variant of darshan_log_append(), used in MPI mode only: the
+ * input buffer is compressed into whichever staging buffer is not in use by
+ * an in-flight write, and the collective write is started but not waited
+ * on. The same rules for inout_off apply as for darshan_log_append().
+ */
+static int darshan_log_append_pipelined(darshan_core_log_fh log_fh,
+    struct darshan_core_runtime *core, struct darshan_core_log_pipe *pipe,
+    void *buf, int count, uint64_t *inout_off)
+{
+    int comp_buf_sz = core->config.mod_mem;
+    char *comp_buf = pipe->comp_buf[pipe->cur];
+    MPI_Offset send_off, my_off, end_off;
+    MPI_Request off_reqs[2];
+    double tm1, tm2;
+    int ret;
+
+    /* wait for the write that last used this staging buffer */
+    tm1 = darshan_core_wtime_absolute();
+    if(pipe->write_req[pipe->cur] != MPI_REQUEST_NULL &&
+        PMPI_Wait(&pipe->write_req[pipe->cur], MPI_STATUS_IGNORE) != MPI_SUCCESS)
+        pipe->err = -1;
+    tm2 = darshan_core_wtime_absolute();
+    pipe->wait_tm += tm2 - tm1;
+
+    /* compress the input buffer */
+    ret = darshan_compress_buffer(core->config.log_comp_type, &buf, &count, 1,
+        comp_buf, &comp_buf_sz);
+    if(ret < 0)
+        comp_buf_sz = 0;
+    tm1 = darshan_core_wtime_absolute();
+    pipe->comp_tm += tm1 - tm2;
+
+    /* figure out where everyone is writing, and where this region ends */
+    send_off = comp_buf_sz;
+    if(my_rank == 0)
+    {
+        send_off += *inout_off; /* rank 0 knows the beginning offset */
+    }
+    PMPI_Iscan(&send_off, &my_off, 1, MPI_OFFSET, MPI_SUM, core->mpi_comm,
+        &off_reqs[0]);
+    PMPI_Iallreduce(&send_off, &end_off, 1, MPI_OFFSET, MPI_SUM,
+        core->mpi_comm, &off_reqs[1]);
+    PMPI_Waitall(2, off_reqs, MPI_STATUSES_IGNORE);
+    /* scan is inclusive; subtract local size back out */
+    my_off -= comp_buf_sz;
+
+    /* start the collective write; on compression errors we still
+     * participate (with no data) so other ranks don't deadlock
+     */
+    if(PMPI_File_iwrite_at_all(log_fh.mpi_fh, my_off, comp_buf, comp_buf_sz,
+        MPI_BYTE, &pipe->write_req[pipe->cur]) != MPI_SUCCESS)
+    {
+        pipe->write_req[pipe->cur] = MPI_REQUEST_NULL;
+        ret = -1;
+    }
+    pipe->wait_tm += darshan_core_wtime_absolute() - tm1;
+    pipe->cur = !pipe->cur;
+
+    if(my_rank == 0)
+        *inout_off = end_off;
+
+    return(ret);
+}
+
+/* wait for all in-flight pipelined writes, returning any write errors */
+static int darshan_log_pipe_drain(struct darshan_core_log_pipe *pipe)
+{
+    double tm1;
+
+    tm1 = darshan_core_wtime_absolute();
+    if(PMPI_Waitall(2, pipe->write_req, MPI_STATUSES_IGNORE) != MPI_SUCCESS)
+        pipe->err = -1;
+    pipe->wait_tm += darshan_core_wtime_absolute() - tm1;
+
+    return(pipe->err);
+}
+#endif
+
+void darshan_log_close(darshan_core_log_fh log_fh)
+{
+#ifdef HAVE_MPI
+    if(using_mpi)
+    {
+        /* non-leader ranks never open the log with node-local aggregation */
+        if(log_fh.mpi_fh != MPI_FILE_NULL)
+            PMPI_File_close(&log_fh.mpi_fh);
+        return;
+    }
+#endif
+
+    close(log_fh.nompi_fd);
+    return;
+}
+
+void darshan_log_finalize(char *logfile_name, double start_log_time)
+{
+#ifdef HAVE_MPI
+    if(using_mpi && (my_rank > 0))
+        return;
+#endif
+
+    /* finalize the darshan log file by renaming from *.darshan_partial
+     * to *-<logwritetime>.darshan, indicating that this log file is complete
+     * and ready for analysis
+     */
+        mode_t chmod_mode = S_IRUSR;
+#ifdef __DARSHAN_GROUP_READABLE_LOGS
+        chmod_mode |= S_IRGRP;
+#endif
+
+    if(getenv("DARSHAN_LOGFILE"))
+    {
+        chmod(logfile_name, chmod_mode);
+    }
+    else
+    {
+        char* tmp_index;
+        double end_log_time;
+        char* new_logfile_name;
+        int available_bytes = 0;
+
+        /* allocate string to hold final log file name */
+        new_logfile_name = malloc(__DARSHAN_PATH_MAX);
+        if(new_logfile_name)
+        {
+            /* copy partial log file name over to new string */
+            strncpy(new_logfile_name, logfile_name, __DARSHAN_PATH_MAX);
+            /* retrieve current time stamp */
+            end_log_time = darshan_core_wtime_absolute();
+            /* find location of .darshan_partial extension */
+            tmp_index = strstr(new_logfile_name, ".darshan_partial");
+            /* calculate how much room is in the string, considering the
+             * length of the temporary extension (which we will overwrite)
+             * and any other spare buffer space in the string
+             */
+            available_bytes = __DARSHAN_PATH_MAX - strlen(logfile_name) + strlen(".darshan_partial");
+            /* use snprintf with above limit to make sure we don't overflow */
+            snprintf(tmp_index, available_bytes, "_%d.darshan", (int)(end_log_time-start_log_time+1));
+            /* rename to new target name */
+            rename(logfile_name, new_logfile_name);
+            /* set permissions on log file */
+            chmod(new_logfile_name, chmod_mode);
+            free(new_logfile_name);
+        }
+    }
+
+    return;
+}
+
+#ifdef HAVE_MPI
+/* set up node-local aggregation of log data: ranks sharing a node are
+ * grouped into a node communicator, and the lowest rank on each node (which
+ * always includes rank 0) joins a communicator of node leaders that write
+ * the log. Aggregation is only enabled if every rank succeeds and at least
+ * one node hosts more than one rank.
+ */
+static void darshan_node_agg_init(struct darshan_core_runtime *core)
+{
+#if MPI_VERSION >= 3
+    int node_rank, node_nprocs;
+    int max_node_nprocs = 0;
+    int ok = 1;
+
+    PMPI_Comm_split_type(core->mpi_comm, MPI_COMM_TYPE_SHARED, my_rank,
+        MPI_INFO_NULL, &core->node_comm);
+    PMPI_Comm_rank(core->node_comm, &node_rank);
+    PMPI_Comm_size(core->node_comm, &node_nprocs);
+    PMPI_Comm_split(core->mpi_comm, (node_rank == 0) ? 0 : MPI_UNDEFINED,
+        my_rank, &core->leader_comm);
+
+    if(node_rank == 0)
+    {
+        core->node_counts = malloc(node_nprocs * sizeof(*core->node_counts));
+        core->node_displs = malloc(node_nprocs * sizeof(*core->node_displs));
+        if(!core->node_counts || !core->node_displs)
+            ok = 0;
+    }
+
+    PMPI_Allreduce(MPI_IN_PLACE, &ok, 1, MPI_INT, MPI_LAND, core->mpi_comm);
+    PMPI_Allreduce(&node_nprocs, &max_node_nprocs, 1, MPI_INT, MPI_MAX,
+        core->mpi_comm);
+    if(ok && max_node_nprocs > 1)
+    {
+        core->node_agg = 1;
+        return;
+    }
+
+    PMPI_Comm_free(&core->node_comm);
+    if(core->leader_comm != MPI_COMM_NULL)
+        PMPI_Comm_free(&core->leader_comm);
+    free(core->node_counts);
+    free(core->node_displs);
+    core->node_counts = NULL;
+    core->node_displs = NULL;
+#endif
+
+    return;
+}
+
+/* if any module was used by some but not all ranks, gather the set of
+ * modules each rank used, so that those modules can be written by just the
+ * ranks that used them (see darshan_sparse_comm_create()). Returns the
+ * per-rank module flags, or NULL if every module is written by all ranks.
+ */
+static uint64_t *darshan_sparse_init(struct darshan_core_runtime *core,
+    int *active_mods)
+{
+    uint64_t *rank_mods = NULL;
+#if MPI_VERSION >= 3
+    uint64_t my_mods = 0;
+    int sparse = 0;
+    int i;
+
+    /* active_mods holds the number of ranks using each module, so all
+     * ranks agree on whether this is needed
+     */
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+    {
+        if(active_mods[i] && active_mods[i] < nprocs)
+            sparse = 1;
+        if(core->mod_array[i])
+            DARSHAN_MOD_FLAG_SET(my_mods, i);
+    }
+    if(!sparse)
+        return(NULL);
+
+    rank_mods = malloc(nprocs * sizeof(*rank_mods));
+    assert(rank_mods);
+    PMPI_Allgather(&my_mods, 1, MPI_UINT64_T, rank_mods, 1, MPI_UINT64_T,
+        core->mpi_comm);
+#endif
+
+    return(rank_mods);
+}
+
+/* create the communicator of the ranks that used the given module, plus
+ * rank 0, as the sparse communicator used to write its data. This is only
+ * collective over those ranks.
+ */
+static void darshan_sparse_comm_create(struct darshan_core_runtime *core,
+    uint64_t *rank_mods, int mod_id)
+{
+#if MPI_VERSION >= 3
+    MPI_Group all_group, mod_group;
+    int *ranks;
+    int cnt = 0;
+    int i;
+
+    ranks = malloc(nprocs * sizeof(*ranks));
+    assert(ranks);
+    for(i = 0; i < nprocs; i++)
+    {
+        if(i == 0 || DARSHAN_MOD_FLAG_ISSET(rank_mods[i], mod_id))
+            ranks[cnt++] = i;
+    }
+
+    PMPI_Comm_group(core->mpi_comm, &all_group);
+    PMPI_Group_incl(all_group, cnt, ranks, &mod_group);
+    PMPI_Comm_create_group(core->mpi_comm, mod_group, mod_id,
+        &core->sparse_comm);
+    PMPI_Group_free(&mod_group);
+    PMPI_Group_free(&all_group);
+    free(ranks);
+    core->sparse_write = 1;
+#endif
+
+    return;
+}
+
+/* node-aggregated variant of darshan_log_append(): each rank's uncompressed
+ * buffer is gathered to its node leader, which compresses the node's data
+ * as a single stream and appends it to the log in a collective write among
+ * node leaders only. The same rules for inout_off apply as for
+ * darshan_log_append().
+ */
+static int darshan_log_append_node_agg(darshan_core_log_fh log_fh,
+    struct darshan_core_runtime *core, void *buf, int count, uint64_t *inout_off)
+{
+    int node_rank, node_nprocs;
+    int leader_rank, leader_nprocs;
+    char *agg_buf = NULL;
+    char *agg_comp_buf = NULL;
+    int64_t total = 0;
+    int agg_sz = 0;
+    int comp_buf_sz = 0;
+    MPI_Offset send_off, my_off;
+    MPI_Status status;
+    int ret = 0;
+    int i;
+
+    PMPI_Comm_rank(core->node_comm, &node_rank);
+    PMPI_Comm_size(core->node_comm, &node_nprocs);
+
+    /* the leader sizes its gather buffer from everyone's buffer size */
+    PMPI_Gather(&count, 1, MPI_INT, core->node_counts, 1, MPI_INT, 0,
+        core->node_comm);
+    if(node_rank == 0)
+    {
+        for(i = 0; i < node_nprocs; i++)
+        {
+            core->node_displs[i] = (int)total;
+            total += core->node_counts[i];
+        }
+
+        /* leave headroom for incompressible data and compressor framing */
+        if(total + (total / 8) + 1024 > INT_MAX)
+        {
+            DARSHAN_WARN("node-aggregated log data too large");
+            ret = -1;
+        }
+        else
+        {
+            agg_sz = (int)total;
+            comp_buf_sz = agg_sz + (agg_sz / 8) + 1024;
+            agg_buf = malloc(agg_sz ? agg_sz : 1);
+            agg_comp_buf = malloc(comp_buf_sz);
+            if(!agg_buf || !agg_comp_buf)
+                ret = -1;
+        }
+    }
+
+    /* skip the gather on all node ranks if the leader can't hold the data */
+    PMPI_Bcast(&ret, 1, MPI_INT, 0, core->node_comm);
+    if(ret == 0)
+        PMPI_Gatherv(buf, count, MPI_BYTE, agg_buf, core->node_counts,
+            core->node_displs, MPI_BYTE, 0, core->node_comm);
+    if(node_rank != 0)
+        return(ret);
+
+    /* compress the node's data as one stream */
+    if(ret == 0)
+        ret = darshan_compress_buffer(core->config.log_comp_type,
+            (void **)&agg_buf, &agg_sz, 1, agg_comp_buf, &comp_buf_sz);
+    if(ret < 0)
+        comp_buf_sz = 0;
+    free(agg_buf);
+
+    PMPI_Comm_rank(core->leader_comm, &leader_rank);
+    PMPI_Comm_size(core->leader_comm, &leader_nprocs);
+
+    /* figure out where each leader is writing using scan */
+    send_off = comp_buf_sz;
+    if(my_rank == 0)
+        send_off += *inout_off; /* rank 0 knows the beginning offset */
+    PMPI_Scan(&send_off, &my_off, 1, MPI_OFFSET, MPI_SUM, core->leader_comm);
+    /* scan is inclusive; subtract local size back out */
+    my_off -= comp_buf_sz;
+
+    /* as in darshan_log_append(), participate in the collective write even
+     * after an error to avoid deadlock, but preserve the error
+     */
+    if(core->indep_write)
+    {
+        if(ret == 0 && comp_buf_sz > 0)
+        {
+            ret = PMPI_File_write_at(log_fh.mpi_fh, my_off, agg_comp_buf,
+                comp_buf_sz, MPI_BYTE, &status);
+            if(ret != MPI_SUCCESS)
+                ret = -1;
+        }
+    }
+    else if(ret == 0)
+    {
+        ret = PMPI_File_write_at_all(log_fh.mpi_fh, my_off, agg_comp_buf,
+            comp_buf_sz, MPI_BYTE, &status);
+        if(ret != MPI_SUCCESS)
+            ret = -1;
+    }
+    else
+    {
+        (void)PMPI_File_write_at_all(log_fh.mpi_fh, my_off, agg_comp_buf,
+            comp_buf_sz, MPI_BYTE, &status);
+    }
+    free(agg_comp_buf);
+
+    if(leader_nprocs > 1)
+    {
+        /* send the ending offset from the last leader to rank 0 */
+        if(leader_rank == (leader_nprocs-1))
+        {
+            my_off += comp_buf_sz;
+            PMPI_Send(&my_off, 1, MPI_OFFSET, 0, 0, core->leader_comm);
+        }
+        if(leader_rank == 0)
+        {
+            PMPI_Recv(&my_off, 1, MPI_OFFSET, (leader_nprocs-1), 0,
+                core->leader_comm, &status);
+            *inout_off = my_off;
+        }
+    }
+    else
+    {
+        *inout_off = my_off + comp_buf_sz;
+    }
+
+    return(ret);
+}
+#endif
+
+/* picks which shutdown steps to degrade so that a log can still be written
+ * within the SHUTDOWN_DEADLINE budget, applies them, and notes them in the
+ * job metadata. Each further eighth of the budget already spent (by the
+ * rank that began shutting down first) takes the next step in order:
+ * skipping the shared record reduction, dropping DXT traces and heatmaps,
+ * compressing at the fastest level, and writing the log independently
+ * rather than collectively. The steps are settled once, before the job
+ * record is written, and all ranks agree on them since some change which
+ * collectives are issued.
+ */
+static void darshan_shutdown_degrade(struct darshan_core_runtime *core,
+    double entry_time, int *active_mods)
+{
+    static const int trace_mods[] = {DXT_POSIX_MOD, DXT_MPIIO_MOD,
+        DXT_STDIO_MOD, DARSHAN_HEATMAP_MOD};
+    char meta[128] = "shutdown_degraded=";
+    int meta_remain;
+    double spent;
+    int steps = 0;
+    int dropped = 0;
+    int i;
+
+    spent = darshan_core_wtime_absolute() - entry_time;
+#ifdef HAVE_MPI
+    if(using_mpi)
+        PMPI_Allreduce(MPI_IN_PLACE, &spent, 1, MPI_DOUBLE, MPI_MAX,
+            core->mpi_comm);
+#endif
+    for(i = 0; i < DARSHAN_DEGRADE_STEP_COUNT; i++)
+    {
+        if(spent >= core->config.shutdown_deadline * (i + 1) / 8)
+            steps |= (1 << i);
+    }
+
+    /* only take (and note) the steps that change anything */
+    if(!using_mpi || core->config.disable_shared_redux_flag)
+        steps &= ~DARSHAN_DEGRADE_SHARED_REDUX;
+    if(!using_mpi)
+        steps &= ~DARSHAN_DEGRADE_INDEP_WRITE;
+    if(steps & DARSHAN_DEGRADE_TRACES)
+    {
+        for(i = 0; i < (int)(sizeof(trace_mods) / sizeof(*trace_mods)); i++)
+        {
+            if(!active_mods[trace_mods[i]])
+                continue;
+            active_mods[trace_mods[i]] = 0;
+            core->log_hdr_p->mod_ver[trace_mods[i]] = 0;
+            dropped = 1;
+        }
+        if(!dropped)
+            steps &= ~DARSHAN_DEGRADE_TRACES;
+    }
+    if(!steps)
+        return;
+
+    if(steps & DARSHAN_DEGRADE_SHARED_REDUX)
+        core->config.disable_shared_redux_flag = 1;
+    if(steps & DARSHAN_DEGRADE_FAST_COMP)
+        log_comp_fast = 1;
+#ifdef HAVE_MPI
+    if(steps & DARSHAN_DEGRADE_INDEP_WRITE)
+        core->indep_write = 1;
+#endif
+
+    for(i = 0; i < DARSHAN_DEGRADE_STEP_COUNT; i++)
+    {
+        if(!(steps & (1 << i)))
+            continue;
+        strcat(meta, darshan_degrade_names[i]);
+        strcat(meta, ",");
+    }
+    meta[strlen(meta) - 1] = '\n';
+
+    meta_remain = DARSHAN_JOB_METADATA_LEN -
+        strlen(core->log_job_p->metadata) - 1;
+    if(meta_remain >= (int)strlen(meta))
+        strcat(core->log_job_p->metadata, meta);
+
+    return;
+}
+
+/* compress the given input buffers into 'comp_buf' using the configured
+ * log compression method
+ */
+static int darshan_compress_buffer(int comp_type, void **pointers,
+    int *lengths, int count, char *comp_buf, int *comp_buf_length)
+{
+    double tm1 = 0;
+    int ret;
+
+    if(shutdown_timing_flag)
+        tm1 = darshan_core_wtime_absolute();
+
+#ifdef HAVE_LIBZSTD
+    if(comp_type == DARSHAN_ZSTD_COMP)
+        ret = darshan_zstd_buffer(pointers, lengths, count, comp_buf,
+            comp_buf_length);
+    else
+#endif
+    ret = darshan_deflate_buffer(pointers, lengths, count, comp_buf,
+        comp_buf_length);
+
+    if(shutdown_timing_flag)
+        shutdown_tm.compress += darshan_core_wtime_absolute() - tm1;
+    return(ret);
+}
+
+static int darshan_deflate_buffer(void **pointers, int *lengths, int count,
+    char *comp_buf, int *comp_buf_length)
+{
+    int ret = 0;
+    int i;
+    int total_target = 0;
+    z_stream tmp_stream;
+
+    /* just return if there is no data */
+    for(i = 0; i < count; i++)
+    {
+        total_target += lengths[i];
+    }
+    if(total_target)
+    {
+        total_target = 0;
+    }
+    else
+    {
+        *comp_buf_length = 0;
+        return(0);
+    }
+
+    memset(&tmp_stream, 0, sizeof(tmp_stream));
+    tmp_stream.zalloc = Z_NULL;
+    tmp_stream.zfree = Z_NULL;
+    tmp_stream.opaque = Z_NULL;
+
+    /* initialize the zlib compression parameters */
+    /* TODO: check these parameters? */
+//    ret = deflateInit2(&tmp_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+//        15 + 16, 8, Z_DEFAULT_STRATEGY);
+    ret = deflateInit(&tmp_stream,
+        log_comp_fast ? Z_BEST_SPEED : Z_DEFAULT_COMPRESSION);
+    if(ret != Z_OK)
+    {
+        return(-1);
+    }
+
+    tmp_stream.next_out = (unsigned char *)comp_buf;
+    tmp_stream.avail_out = (size_t)(*comp_buf_length);
+
+    /* loop over the input pointers */
+    for(i = 0; i < count; i++)
+    {
+        total_target += lengths[i];
+        tmp_stream.next_in = pointers[i];
+        tmp_stream.avail_in = lengths[i];
+        /* while we have not finished consuming all of the data available to
+         * this point in the loop
+         */
+        while(tmp_stream.total_in < total_target)
+        {
+            if(tmp_stream.avail_out == 0)
+            {
+                /* We ran out of buffer space for compression.  In theory,
+                 * we could start using some of the file_array buffer space
+                 * without having to malloc again.  In practice, this case
+                 * is going to be practically impossible to hit.
+                 */
+                deflateEnd(&tmp_stream);
+                return(-1);
+            }
+
+            /* compress data */
+            ret = deflate(&tmp_stream, Z_NO_FLUSH);
+            if(ret != Z_OK)
+            {
+                deflateEnd(&tmp_stream);
+                return(-1);
+            }
+        }
+    }
+
+    /* flush compression and end */
+    ret = deflate(&tmp_stream, Z_FINISH);
+    if(ret != Z_STREAM_END)
+    {
+        deflateEnd(&tmp_stream);
+        return(-1);
+    }
+    deflateEnd(&tmp_stream);
+
+    *comp_buf_length = tmp_stream.total_out;
+    return(0);
+}
+
+#ifdef HAVE_LIBZSTD
+static int darshan_zstd_buffer(void **pointers, int *lengths, int count,
+    char *comp_buf, int *comp_buf_length)
+{
+    int i;
+    int total_target = 0;
+    size_t ret;
+    ZSTD_CCtx *cctx;
+    ZSTD_inBuffer in_buf;
+    ZSTD_outBuffer out_buf;
+
+    /* just return if there is no data */
+    for(i = 0; i < count; i++)
+    {
+        total_target += lengths[i];
+    }
+    if(!total_target)
+    {
+        *comp_buf_length = 0;
+        return(0);
+    }
+
+    cctx = ZSTD_createCCtx();
+    if(!cctx)
+        return(-1);
+    if(zstd_cdict)
+        ZSTD_CCtx_refCDict(cctx, zstd_cdict);
+    else if(log_comp_fast)
+        ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, 1);
+
+    out_buf.dst = comp_buf;
+    out_buf.size = (size_t)(*comp_buf_length);
+    out_buf.pos = 0;
+
+    /* loop over the input pointers */
+    for(i = 0; i < count; i++)
+    {
+        in_buf.src = pointers[i];
+        in_buf.size = lengths[i];
+        in_buf.pos = 0;
+        while(in_buf.pos < in_buf.size)
+        {
+            /* see darshan_deflate_buffer() on running out of buffer space */
+            if(out_buf.pos == out_buf.size)
+            {
+                ZSTD_freeCCtx(cctx);
+                return(-1);
+            }
+
+            ret = ZSTD_compressStream2(cctx, &out_buf, &in_buf,
+                ZSTD_e_continue);
+            if(ZSTD_isError(ret))
+            {
+                ZSTD_freeCCtx(cctx);
+                return(-1);
+            }
+        }
+    }
+
+    /* flush compression and end the frame */
+    in_buf.src = NULL;
+    in_buf.size = 0;
+    in_buf.pos = 0;
+    do
+    {
+        ret = ZSTD_compressStream2(cctx, &out_buf, &in_buf, ZSTD_e_end);
+        if(ZSTD_isError(ret) || (ret && out_buf.pos == out_buf.size))
+        {
+            ZSTD_freeCCtx(cctx);
+            return(-1);
+        }
+    } while(ret);
+    ZSTD_freeCCtx(cctx);
+
+    *comp_buf_length = out_buf.pos;
+    return(0);
+}
+
+/* prepares the trained zstd dictionary named by the LOGCOMP_DICT setting
+ * and records its id in the log header.  Rank 0 reads the dictionary and
+ * broadcasts it, so that large jobs do not all read it from a shared file
+ * system.  The log is compressed without a dictionary if it can not be
+ * read or is not a trained dictionary (which carries a nonzero id).
+ */
+static void darshan_zstd_load_dict(struct darshan_core_runtime *core)
+{
+    char *dict = NULL;
+    int64_t dict_len = 0;
+    struct stat st;
+    ssize_t ret;
+    int fd;
+
+    if(core->config.log_comp_type != DARSHAN_ZSTD_COMP ||
+        !core->config.log_comp_dict)
+        return;
+
+    if(my_rank == 0)
+    {
+        fd = open(core->config.log_comp_dict, O_RDONLY);
+        if(fd >= 0)
+        {
+            if(fstat(fd, &st) == 0 && st.st_size > 0)
+            {
+                dict = malloc(st.st_size);
+                if(dict)
+                {
+                    ret = pread(fd, dict, st.st_size, 0);
+                    if(ret == st.st_size &&
+                        ZSTD_getDictID_fromDict(dict, st.st_size) != 0)
+                        dict_len = st.st_size;
+                }
+            }
+            close(fd);
+        }
+        if(!dict_len)
+            darshan_core_fprintf(stderr, "darshan library warning: "\
+                "unable to load zstd dictionary %s, compressing without it\n",
+                core->config.log_comp_dict);
+    }
+
+#ifdef HAVE_MPI
+    if(using_mpi)
+    {
+        PMPI_Bcast(&dict_len, 1, MPI_INT64_T, 0, core->mpi_comm);
+        if(dict_len && my_rank != 0)
+        {
+            dict = malloc(dict_len);
+            assert(dict);
+        }
+        if(dict_len)
+            PMPI_Bcast(dict, dict_len, MPI_BYTE, 0, core->mpi_comm);
+    }
+#endif
+
+    if(dict_len)
+    {
+        zstd_cdict = ZSTD_createCDict(dict, dict_len, ZSTD_CLEVEL_DEFAULT);
+        if(zstd_cdict)
+            core->log_hdr_p->comp_dict_id =
+                ZSTD_getDictID_fromDict(dict, dict_len);
+    }
+    free(dict);
+
+    return;
+}
+#endif
+
+/* free darshan core data structures to shutdown */
+static void darshan_core_cleanup(struct darshan_core_runtime* core)
+{
+    int i;
+
+    darshan_core_id_map_free(&core->name_map);
+    darshan_core_id_map_free(&core->name_dir_map);
+    darshan_core_id_map_free(&core->excluded_map);
+
+#ifdef HAVE_LIBZSTD
+    ZSTD_freeCDict(zstd_cdict);
+    zstd_cdict = NULL;
+#endif
+
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+    {
+        if(core->mod_array[i])
+        {
+            if(core->mod_array[i]->rec_mem_max)
+                munmap(core->mod_array[i]->rec_buf_start,
+                    core->mod_array[i]->rec_mem_max);
+            darshan_core_free_retired(core->mod_array[i]);
+            free(core->mod_array[i]);
+            core->mod_array[i] = NULL;
+        }
+    }
+
+#ifndef __DARSHAN_ENABLE_MMAP_LOGS
+    free(core->log_hdr_p);
+    free(core->log_job_p);
+    free(core->log_exemnt_p);
+    if(darshan_core_mem_policy_enabled())
+    {
+        darshan_core_mem_free(core->log_name_p, core->config.name_mem);
+        if(core->log_mod_p)
+            darshan_core_mem_free(core->log_mod_p, core->config.mod_mem);
+    }
+    else
+    {
+        free(core->log_name_p);
+        free(core->log_mod_p);
+    }
+#endif
+
+#ifdef HAVE_MPI
+    if(using_mpi)
+    {
+        if(core->node_agg)
+        {
+            PMPI_Comm_free(&core->node_comm);
+            if(core->leader_comm != MPI_COMM_NULL)
+                PMPI_Comm_free(&core->leader_comm);
+            free(core->node_counts);
+            free(core->node_displs);
+        }
+        if(core->sparse_write)
+            PMPI_Comm_free(&core->sparse_comm);
+        PMPI_Comm_free(&core->mpi_comm);
+    }
+#endif
+
+    if(core->collect_ctl)
+        munmap(core->collect_ctl, sizeof(struct darshan_collect_ctl));
+    free(core->collect_ctl_name);
+    for(i = 0; i < core->collect_cnt; i++)
+        free(core->collect_children[i].hdr);
+    free(core->collect_children);
+
+    darshan_free_config(&core->config);
+
+    if(core->comp_buf)
+        free(core->comp_buf);
+    free(core->log_index);
+    free(core);
+
+    return;
+}
+
+static void darshan_core_fork_child_cb(void)
+{
+    if(__darshan_core)
+    {
+        /* hold onto the original parent PID, which we will use as jobid if the user didn't
+         * provide a jobid env variable
+         */
+        parent_pid = __darshan_core->pid;
+        if(!orig_parent_pid)
+            orig_parent_pid = parent_pid;
+
+        /* threads of the parent that were registering records do not
+         * exist in the child
+         */
+        core_active = 0;
+
+        /* shutdown and re-init darshan, making sure to not write out a log file */
+        darshan_core_shutdown(0);
+        darshan_core_initialize(0, NULL);
+    }
+
+    return;
+}
+
+#ifdef __DARSHAN_RDTSCP_CALIBRATE
+/* busy wait for this long (in seconds) per TSC frequency measurement */
+#define DARSHAN_TSC_CALIBRATION_TIME 0.002
+
+/* measures the TSC frequency (ticks per second) against CLOCK_MONOTONIC,
+ * returning 0 if the TSC did not advance
+ */
+static double darshan_core_tsc_measure(void)
+{
+    struct timespec t0, t1;
+    uint64_t tsc0, tsc1;
+    double elapsed;
+    unsigned flag;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    tsc0 = __rdtscp(&flag);
+    do
+    {
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        elapsed = (double)(t1.tv_sec - t0.tv_sec) +
+            1.0e-9 * (double)(t1.tv_nsec - t0.tv_nsec);
+    } while(elapsed < DARSHAN_TSC_CALIBRATION_TIME);
+    tsc1 = __rdtscp(&flag);
+
+    if(tsc1 <= tsc0)
+        return(0);
+    return((double)(tsc1 - tsc0) / elapsed);
+}
+
+/* enables rdtscp timing if the CPU has an invariant TSC (one that ticks at
+ * a constant rate across frequency scaling and sleep states) whose
+ * frequency measures consistently; otherwise timing stays on
+ * clock_gettime().  The frequency is only measured once per process, as
+ * forked children share their parent's TSC.
+ */
+static void darshan_core_tsc_calibrate(void)
+{
+    static int calibrated = 0;
+    unsigned int eax, ebx, ecx, edx;
+    struct timespec tp;
+    double hz1, hz2, diff;
+    unsigned flag;
+
+    if(calibrated)
+        return;
+    calibrated = 1;
+
+    /* rdtscp support is CPUID leaf 0x80000001 EDX bit 27, and invariant
+     * TSC is CPUID leaf 0x80000007 EDX bit 8
+     */
+    if(!__get_cpuid(0x80000001, &eax, &ebx, &ecx, &edx) ||
+       !(edx & (1U << 27)))
+        return;
+    if(!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) ||
+       !(edx & (1U << 8)))
+        return;
+
+    /* two measurements must agree within 0.1%, which rules out ones
+     * disturbed by preemption or a virtualized TSC
+     */
+    hz1 = darshan_core_tsc_measure();
+    hz2 = darshan_core_tsc_measure();
+    diff = (hz1 > hz2) ? (hz1 - hz2) : (hz2 - hz1);
+    if(hz1 <= 0 || hz2 <= 0 || diff > 1.0e-3 * hz1)
+        return;
+
+    /* anchor the TSC to the realtime clock, so that timestamps remain
+     * absolute times like those of clock_gettime()
+     */
+    clock_gettime(CLOCK_REALTIME, &tp);
+    __darshan_core_tsc_start = __rdtscp(&flag);
+    __darshan_core_tsc_base = ((double)tp.tv_sec) + 1.0e-9 * ((double)tp.tv_nsec);
+    __darshan_core_tsc_scale = 2.0 / (hz1 + hz2);
+
+    return;
+}
+#endif
+
+static int darshan_core_name_is_excluded(struct darshan_core_runtime *core,
+    const char *name, darshan_module_id mod_id)
+{
+    int name_is_path;
+    int name_excluded = 0, name_included = 0;
+    struct darshan_core_regex *regex;
+
+    /* set flag if this module's record names are based on file paths */
+    name_is_path = 1;
+    if((mod_id == DARSHAN_APMPI_MOD) || (mod_id == DARSHAN_APXC_MOD) ||
+       (mod_id == DARSHAN_HEATMAP_MOD) || (mod_id == DARSHAN_MDHIM_MOD) ||
+       (mod_id == DARSHAN_BATCHIO_MOD) || (mod_id == DARSHAN_OVERHEAD_MOD) ||
+       (mod_id == DARSHAN_TIMESERIES_MOD) || (mod_id == DARSHAN_PHASE_MOD))
+        name_is_path = 0;
+
+    /* if record name is a path, check against either default or
+     * user-provided path exclusions (the latter override the defaults)
+     */
+    if(name_is_path)
+        name_excluded = darshan_config_path_match(
+            core->config.exclude_trie, name);
+
+    if(!name_excluded)
+    {
+        /* check to see if this name is in the module exclusion list provided to
+         * Darshan config
+         */
+        LL_FOREACH(core->config.rec_exclusion_list, regex)
+        {
+            if(DARSHAN_MOD_FLAG_ISSET(regex->mod_flags, mod_id) &&
+                (regexec(&regex->regex, name, 0, NULL, 0) == 0))
+            {
+                name_excluded = 1;
+                break;
+            }
+        }
+    }
+
+    /* if record name is a path, check against default path inclusions,
+     * which are only compiled when the user hasn't overridden exclusions
+     */
+    if(name_is_path && name_excluded)
+        name_included = darshan_config_path_match(
+            core->config.include_trie, name);
+
+    if(name_excluded && !name_included)
+    {
+        /* if marked as excluded, make sure there's not a superseding inclusion
+         * associated with this module from Darshan config
+         */
+        LL_FOREACH(core->config.rec_inclusion_list, regex)
+        {
+            if(DARSHAN_MOD_FLAG_ISSET(regex->mod_flags, mod_id) &&
+                (regexec(&regex->regex, name, 0, NULL, 0) == 0))
+            {
+                name_included = 1;
+                break;
+            }
+        }
+
+        if(!name_included)
+            return(1);
+    }
+
+    return(0);
+}
+
+/* check a record against the exclusion rules, consulting (and updating) the
+ * cache of previously excluded record ids first
+ */
+static int darshan_core_record_is_excluded(struct darshan_core_runtime *core,
+    darshan_record_id rec_id, const char *name, darshan_module_id mod_id)
+{
+    struct darshan_core_excluded_ref *ref, *new_ref;
+
+    ref = darshan_core_id_map_find(&core->excluded_map, rec_id);
+    if(ref && DARSHAN_MOD_FLAG_ISSET(
+        __atomic_load_n(&ref->mod_flags, __ATOMIC_RELAXED), mod_id))
+        return(1);
+
+    if(!darshan_core_name_is_excluded(core, name, mod_id))
+        return(0);
+
+    /* remember the verdict, up to a fixed number of distinct records */
+    if(!ref && __atomic_fetch_add(&core->excluded_cnt, 1, __ATOMIC_RELAXED) <
+       DARSHAN_EXCLUDED_CACHE_MAX)
+    {
+        new_ref = calloc(1, sizeof(*new_ref));
+        if(new_ref)
+        {
+            new_ref->rec_id = rec_id;
+            ref = darshan_core_id_map_add(&core->excluded_map, new_ref);
+            if(ref != new_ref)
+                free(new_ref);
+        }
+    }
+    if(ref)
+        __atomic_fetch_or(&ref->mod_flags, 1ULL << mod_id, __ATOMIC_RELAXED);
+
+    return(1);
+}
+
+#ifdef HAVE_MPI
+static void darshan_core_reduce_min_time(void* in_time_v, void* inout_time_v,
+    int *len, MPI_Datatype *datatype)
+{
+    int64_t tmp_sec, tmp_nsec;
+    int64_t *in_sec = in_time_v;
+    int64_t *in_nsec = in_sec+1;
+    int64_t *inout_sec = inout_time_v;
+    int64_t *inout_nsec = inout_sec+1;
+    int i;
+
+    for(i=0; i<*len; i++)
+    {
+        /* min */
+        if((*in_sec < *inout_sec) ||
+            ((*in_sec == *inout_sec) &&
+             (*in_nsec < *inout_nsec)))
+        {
+            tmp_sec = *in_sec;
+            tmp_nsec = *in_nsec;
+        }
+        else
+        {
+            tmp_sec = *inout_sec;
+            tmp_nsec = *inout_nsec;
+        }
+
+        /* update pointers */
+        *inout_sec = tmp_sec;
+        *inout_nsec = tmp_nsec;
+        inout_sec+=2;
+        inout_nsec+=2;
+        in_sec+=2;
+        in_nsec+=2;
+    }
+
+    return;
+}
+
+static void darshan_core_reduce_max_time(void* in_time_v, void* inout_time_v,
+    int *len, MPI_Datatype *datatype)
+{
+    int64_t tmp_sec, tmp_nsec;
+    int64_t *in_sec = in_time_v;
+    int64_t *in_nsec = in_sec+1;
+    int64_t *inout_sec = inout_time_v;
+    int64_t *inout_nsec = inout_sec+1;
+    int i;
+
+    for(i=0; i<*len; i++)
+    {
+        /* max */
+        if((*in_sec > *inout_sec) ||
+            ((*in_sec == *inout_sec) &&
+             (*in_nsec > *inout_nsec)))
+        {
+            tmp_sec = *in_sec;
+            tmp_nsec = *in_nsec;
+        }
+        else
+        {
+            tmp_sec = *inout_sec;
+            tmp_nsec = *inout_nsec;
+        }
+
+        /* update pointers */
+        *inout_sec = tmp_sec;
+        *inout_nsec = tmp_nsec;
+        inout_sec+=2;
+        inout_nsec+=2;
+        in_sec+=2;
+        in_nsec+=2;
+    }
+
+    return;
+}
+#endif
+
+/* crude benchmarking hook into darshan-core to benchmark Darshan
+ * shutdown overhead using a variety of application I/O workloads
+ */
+extern void darshan_posix_shutdown_bench_setup(int nfiles, int nshared,
+    int nwrites);
+extern void darshan_mpiio_shutdown_bench_setup(int nfiles, int nshared,
+    int nwrites);
+#ifdef HAVE_MPI
+struct darshan_shutdown_bench_params
+{
+    int files;          /* records per rank in each module */
+    double shared_frac; /* fraction of those files opened by every rank */
+    int dxt_segments;   /* DXT segments per file, 0 to disable DXT */
+    int heatmap;        /* enable the heatmap module */
+    int posix;          /* generate POSIX records */
+    int mpiio;          /* generate MPI-IO records */
+    char *output;       /* JSON output path, NULL for stdout */
+};
+
+/* parses the optional benchmark parameters; returns the number of
+ * parameters found, or -1 on error
+ */
+static int darshan_shutdown_bench_parse(int argc, char **argv,
+    struct darshan_shutdown_bench_params *p)
+{
+    int count = 0;
+    int i;
+
+    p->files = 1;
+    p->shared_frac = 0;
+    p->dxt_segments = 0;
+    p->heatmap = 1;
+    p->posix = 1;
+    p->mpiio = 1;
+    p->output = NULL;
+
+    for(i = 1; i < argc; i++)
+    {
+        if(i + 1 >= argc)
+            return(-1);
+        if(strcmp(argv[i], "--files") == 0)
+            p->files = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--shared") == 0)
+            p->shared_frac = atof(argv[++i]);
+        else if(strcmp(argv[i], "--dxt-segments") == 0)
+            p->dxt_segments = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--heatmap") == 0)
+            p->heatmap = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--modules") == 0)
+        {
+            i++;
+            p->posix = (strstr(argv[i], "POSIX") != NULL);
+            p->mpiio = (strstr(argv[i], "MPI-IO") != NULL);
+            if(!p->posix && !p->mpiio)
+                return(-1);
+        }
+        else if(strcmp(argv[i], "--output") == 0)
+            p->output = argv[++i];
+        else
+            return(-1);
+        count++;
+    }
+    if(p->files < 1 || p->shared_frac < 0 || p->shared_frac > 1 ||
+       p->dxt_segments < 0)
+        return(-1);
+
+    return(count);
+}
+
+/* writes the phase timings of the last shutdown as one JSON object */
+static void darshan_shutdown_bench_json(FILE *out,
+    struct darshan_shutdown_bench_params *p)
+{
+    int first = 1;
+    int i;
+
+    fprintf(out, "{\"nprocs\": %d, ", nprocs);
+    fprintf(out, "\"params\": {\"files_per_rank\": %d, \"shared_fraction\": %g, "
+        "\"dxt_segments\": %d, \"heatmap\": %s, \"modules\": [%s%s%s]}, ",
+        p->files, p->shared_frac, p->dxt_segments,
+        p->heatmap ? "true" : "false", p->posix ? "\"POSIX\"" : "",
+        (p->posix && p->mpiio) ? ", " : "", p->mpiio ? "\"MPI-IO\"" : "");
+    fprintf(out, "\"phases\": {\"shared_recs\": %f, \"log_open\": %f, "
+        "\"job_write\": %f, \"hash_write\": %f, \"compress\": %f, "
+        "\"mod_write\": %f, \"header_write\": %f, \"core_shutdown\": %f}, ",
+        shutdown_tm.shared_recs, shutdown_tm.open, shutdown_tm.job,
+        shutdown_tm.name_hash, shutdown_tm.compress, shutdown_tm.write,
+        shutdown_tm.header, shutdown_tm.total);
+    fprintf(out, "\"modules\": {");
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+    {
+        if(shutdown_tm.mod_total[i] == 0)
+            continue;
+        fprintf(out, "%s\"%s\": {\"redux\": %f, \"shutdown\": %f}",
+            first ? "" : ", ", darshan_module_names[i],
+            shutdown_tm.mod_redux[i], shutdown_tm.mod_total[i]);
+        first = 0;
+    }
+    fprintf(out, "}}\n");
+
+    return;
+}
+
+/* runs one shutdown of the workload described by the benchmark parameters
+ * and reports its phase timings as JSON
+ */
+static void darshan_shutdown_bench_scaled(int argc, char **argv,
+    struct darshan_shutdown_bench_params *p)
+{
+    FILE *out = stdout;
+    int nshared = (int)(p->files * p->shared_frac + 0.5);
+    int nwrites = p->dxt_segments > 0 ? p->dxt_segments : 1;
+
+    darshan_core_initialize(argc, argv);
+    if(!__darshan_core)
+        return;
+
+    /* the modules read these when they register with the core below */
+    __darshan_core->config.internal_timing_flag = 1;
+    if(p->dxt_segments > 0)
+    {
+        DARSHAN_MOD_FLAG_UNSET(__darshan_core->config.mod_disabled, DXT_POSIX_MOD);
+        DARSHAN_MOD_FLAG_UNSET(__darshan_core->config.mod_disabled, DXT_MPIIO_MOD);
+    }
+    else
+    {
+        DARSHAN_MOD_FLAG_SET(__darshan_core->config.mod_disabled, DXT_POSIX_MOD);
+        DARSHAN_MOD_FLAG_SET(__darshan_core->config.mod_disabled, DXT_MPIIO_MOD);
+    }
+    if(p->heatmap)
+        DARSHAN_MOD_FLAG_UNSET(__darshan_core->config.mod_disabled, DARSHAN_HEATMAP_MOD);
+    else
+        DARSHAN_MOD_FLAG_SET(__darshan_core->config.mod_disabled, DARSHAN_HEATMAP_MOD);
+
+    if(p->posix)
+        darshan_posix_shutdown_bench_setup(p->files, nshared, nwrites);
+    if(p->mpiio)
+        darshan_mpiio_shutdown_bench_setup(p->files, nshared, nwrites);
+
+    PMPI_Barrier(MPI_COMM_WORLD);
+    darshan_core_shutdown(1);
+    __darshan_core = NULL;
+
+    if(my_rank == 0)
+    {
+        if(p->output)
+        {
+            out = fopen(p->output, "a");
+            if(!out)
+            {
+                darshan_core_fprintf(stderr, "darshan library warning: "
+                    "unable to open %s\n", p->output);
+                return;
+            }
+        }
+        darshan_shutdown_bench_json(out, p);
+        if(out != stdout)
+            fclose(out);
+        else
+            fflush(out);
+    }
+
+    return;
+}
+
+void darshan_shutdown_bench(int argc, char **argv)
 {
-#ifdef HAVE_MPI
-    if(using_mpi && (my_rank > 0))
+    struct darshan_shutdown_bench_params params;
+    int ret;
+
+    /* clear out existing core runtime structure */
+    if(__darshan_core)
+    {
+        darshan_core_cleanup(__darshan_core);
+        __darshan_core = NULL;
+    }
+
+    ret = darshan_shutdown_bench_parse(argc, argv, &params);
+    if(ret < 0)
+    {
+        if(my_rank == 0)
+            fprintf(stderr, "Usage: %s [--files <per_rank>] [--shared <fraction>]"
+                " [--dxt-segments <per_file>] [--heatmap <0|1>]"
+                " [--modules <POSIX,MPI-IO>] [--output <json_file>]\n", argv[0]);
+        return;
+    }
+    if(ret > 0)
+    {
+        darshan_shutdown_bench_scaled(argc, argv, &params);
         return;
+    }
+
+    /***********************************************************/
+    /* restart darshan */
+    darshan_core_initialize(argc, argv);
+
+    darshan_posix_shutdown_bench_setup(1, 0, 1);
+    darshan_mpiio_shutdown_bench_setup(1, 0, 1);
+
+    if(my_rank == 0)
+        fprintf(stderr, "# 1 unique file per proc\n");
+    PMPI_Barrier(MPI_COMM_WORLD);
+    darshan_core_shutdown(1);
+    __darshan_core = NULL;
+
+    sleep(1);
+
+    /***********************************************************/
+    /* restart darshan */
+    darshan_core_initialize(argc, argv);
+
+    darshan_posix_shutdown_bench_setup(1, 1, 1);
+    darshan_mpiio_shutdown_bench_setup(1, 1, 1);
+
+    if(my_rank == 0)
+        fprintf(stderr, "# 1 shared file per proc\n");
+    PMPI_Barrier(MPI_COMM_WORLD);
+    darshan_core_shutdown(1);
+    __darshan_core = NULL;
+
+    sleep(1);
+
+    /***********************************************************/
+    /* restart darshan */
+    darshan_core_initialize(argc, argv);
+
+    darshan_posix_shutdown_bench_setup(1024, 0, 1);
+    darshan_mpiio_shutdown_bench_setup(1024, 0, 1);
+
+    if(my_rank == 0)
+        fprintf(stderr, "# 1024 unique files per proc\n");
+    PMPI_Barrier(MPI_COMM_WORLD);
+    darshan_core_shutdown(1);
+    __darshan_core = NULL;
+
+    sleep(1);
+
+    /***********************************************************/
+    /* restart darshan */
+    darshan_core_initialize(argc, argv);
+
+    darshan_posix_shutdown_bench_setup(1024, 1024, 1);
+    darshan_mpiio_shutdown_bench_setup(1024, 1024, 1);
+
+    if(my_rank == 0)
+        fprintf(stderr, "# 1024 shared files per proc\n");
+    PMPI_Barrier(MPI_COMM_WORLD);
+    darshan_core_shutdown(1);
+    __darshan_core = NULL;
+
+    sleep(1);
+
+    /***********************************************************/
+
+    return;
+}
+#else
+void darshan_shutdown_bench(int argc, char **argv)
+{
+    fprintf(stderr, "Error: darshan_shutdown_bench() not implemented for non-mpi builds.\n");
+    assert(0);
+    return;
+}
 #endif
 
-    /* finalize the darshan log file by renaming from *.darshan_partial
-     * to *-<logwritetime>.darshan, indicating that this log file is complete
-     * and ready for analysis
+/* ********************************************************* */
+
+int darshan_core_register_module(
+    darshan_module_id mod_id,
+    darshan_module_funcs mod_funcs,
+    size_t rec_size,
+    size_t *inout_rec_count,
+    int *rank,
+    int *sys_mem_alignment)
+{
+    struct darshan_core_module* mod;
+    size_t mod_recs_req = *inout_rec_count;
+    size_t mod_mem_avail, mod_mem_req;
+    size_t mod_mem_grow = 0;
+    void *rec_mem_rsv = MAP_FAILED;
+
+    *inout_rec_count = 0;
+
+    /* do this early before acquiring lock */
+    mod = malloc(sizeof(*mod));
+    if(!mod) return(-1);
+    memset(mod, 0, sizeof(*mod));
+
+    /* reserve address space for the records of growing modules, also
+     * before acquiring the lock, as mmap may be instrumented. nothing is
+     * accessible (or committed) until darshan_core_grow_module()
      */
-        mode_t chmod_mode = S_IRUSR;
-#ifdef __DARSHAN_GROUP_READABLE_LOGS
-        chmod_mode |= S_IRGRP;
+    __DARSHAN_CORE_LOCK();
+    if(__darshan_core)
+        mod_mem_grow = __darshan_core->config.mod_mem_grow;
+    __DARSHAN_CORE_UNLOCK();
+    if(mod_mem_grow && (mod_id != DXT_POSIX_MOD) &&
+       (mod_id != DXT_MPIIO_MOD) && (mod_id != DXT_STDIO_MOD))
+    {
+        rec_mem_rsv = mmap(NULL, mod_mem_grow, PROT_NONE,
+            MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+#ifdef MADV_HUGEPAGE
+        if(rec_mem_rsv != MAP_FAILED && mem_hugepages)
+            madvise(rec_mem_rsv, mod_mem_grow, MADV_HUGEPAGE);
+#endif
+    }
+
+    __DARSHAN_CORE_LOCK();
+    if((__darshan_core == NULL) ||
+       (mod_id >= DARSHAN_KNOWN_MODULE_COUNT) ||
+       (__darshan_core->mod_array[mod_id] != NULL) ||
+       (DARSHAN_MOD_FLAG_ISSET(__darshan_core->config.mod_disabled, mod_id)))
+    {
+        /* fail if:
+         *   - Darshan is not currently instrumenting
+         *   - the module ID is invalid
+         *   - the module is already registered
+         *   - the module is set as disabled at runtime
+         */
+        __DARSHAN_CORE_UNLOCK();
+        if(rec_mem_rsv != MAP_FAILED)
+            munmap(rec_mem_rsv, mod_mem_grow);
+        free(mod);
+        return(-1);
+    }
+
+    /* allow user overrides of module record counts */
+    if(__darshan_core->config.mod_max_records_override[mod_id])
+    {
+        /* ignore overrides for modules with static record counts
+         * (i.e., HEATMAP, APMPI, APXC modules)
+         */
+        if((mod_id != DARSHAN_HEATMAP_MOD) && (mod_id != DARSHAN_APXC_MOD) &&
+            (mod_id != DARSHAN_APMPI_MOD))
+            mod_recs_req = __darshan_core->config.mod_max_records_override[mod_id];
+    }
+
+    mod_mem_req = mod_recs_req * rec_size;
+    mod_mem_avail = __darshan_core->config.mod_mem - __darshan_core->mod_mem_used;
+
+    /* set module structure to register with Darshan core */
+    mod->mod_funcs = mod_funcs;
+    if(mod_mem_grow && (mod_id != DXT_POSIX_MOD) &&
+       (mod_id != DXT_MPIIO_MOD) && (mod_id != DXT_STDIO_MOD))
+    {
+        /* growing modules start out empty and are only limited by the
+         * global cap, and any user override of their record count, so
+         * report the largest count they could reach
+         */
+        if(rec_mem_rsv != MAP_FAILED)
+        {
+            mod->rec_buf_start = rec_mem_rsv;
+            mod->rec_mem_max = mod_mem_grow;
+            if(__darshan_core->config.mod_max_records_override[mod_id])
+                mod->rec_max_count = mod_recs_req;
+            *inout_rec_count = mod->rec_max_count ? mod->rec_max_count :
+                mod_mem_grow / rec_size;
+        }
+        mod->rec_buf_p = mod->rec_buf_start;
+    }
+    else if((mod_id != DXT_POSIX_MOD) && (mod_id != DXT_MPIIO_MOD) &&
+       (mod_id != DXT_STDIO_MOD))
+    {
+        /* for traditional (non-DXT) modules, calculate how many module records
+         * we can satisfy given our current global memory usage and set up
+         * module memory pointers
+         */
+        if(mod_mem_avail >= mod_mem_req)
+        {
+            mod->rec_mem_avail = mod_mem_req;
+            *inout_rec_count = mod_recs_req;
+        }
+        else
+        {
+            int tmp_rec_count = mod_mem_avail / rec_size;
+            mod->rec_mem_avail = tmp_rec_count * rec_size;
+            *inout_rec_count = tmp_rec_count;
+        }
+        mod->rec_buf_start = __darshan_core->log_mod_p + __darshan_core->mod_mem_used;
+        mod->rec_buf_p = mod->rec_buf_start;
+
+        __darshan_core->mod_mem_used += mod->rec_mem_avail;
+#ifdef __DARSHAN_ENABLE_MMAP_LOGS
+        __DARSHAN_MMAP_GEN_BEGIN(__darshan_core, mod_gen[mod_id]);
+        __darshan_core->log_hdr_p->mod_map[mod_id].off =
+            ((char *)mod->rec_buf_start - (char *)__darshan_core->log_hdr_p);
+        __DARSHAN_MMAP_GEN_END(__darshan_core, mod_gen[mod_id]);
+#endif
+    }
+    else
+    {
+        /* DXT modules allocate their own memory and do not use the global
+         * module memory pool managed by Darshan core, so we just grant
+         * however much they request and hold onto this value for tracking
+         */
+        mod->rec_mem_avail = mod_mem_req;
+        *inout_rec_count = mod_recs_req;
+    }
+
+    /* register module with darshan */
+    __darshan_core->mod_array[mod_id] = mod;
+    __darshan_core->log_hdr_p->mod_ver[mod_id] = darshan_module_versions[mod_id];
+
+    /* set the memory alignment and calling process's rank, if desired */
+    if(sys_mem_alignment)
+        *sys_mem_alignment = __darshan_core->config.mem_alignment;
+    if(rank)
+        *rank = using_mpi ? my_rank : __darshan_core->collect_rank;
+
+    __DARSHAN_CORE_UNLOCK();
+
+    /* account for this module's costs in the OVERHEAD module */
+    if(mod_id != DARSHAN_OVERHEAD_MOD)
+        darshan_overhead_track_module(mod_id);
+
+    return(0);
+}
+
+/* NOTE: we currently don't really have a simple way of returning the
+ * memory allocated to this module back to darshan to hand out to
+ * other modules, so all we do is disable the module so darshan does
+ * not attempt to call into it at shutdown time
+ */
+void darshan_core_unregister_module(
+    darshan_module_id mod_id)
+{
+    struct darshan_core_module* mod;
+
+    __DARSHAN_CORE_LOCK();
+    if(!__darshan_core)
+    {
+        __DARSHAN_CORE_UNLOCK();
+        return;
+    }
+
+    /* update darshan internal structures and header */
+    /* NOTE: save pointer to free module after lock is released */
+    mod = __darshan_core->mod_array[mod_id];
+    __darshan_core->mod_array[mod_id] = NULL;
+    __darshan_core->log_hdr_p->mod_ver[mod_id] = 0;
+#ifdef __DARSHAN_ENABLE_MMAP_LOGS
+    __DARSHAN_MMAP_GEN_BEGIN(__darshan_core, mod_gen[mod_id]);
+    __darshan_core->log_hdr_p->mod_map[mod_id].off =
+        __darshan_core->log_hdr_p->mod_map[mod_id].len = 0;
+    __DARSHAN_MMAP_GEN_END(__darshan_core, mod_gen[mod_id]);
 #endif
+    __DARSHAN_CORE_UNLOCK();
+    if(mod)
+        darshan_core_free_retired(mod);
+    free(mod);
 
-    if(getenv("DARSHAN_LOGFILE"))
-    {
-        chmod(logfile_name, chmod_mode);
-    }
-    else
-    {
-        char* tmp_index;
-        double end_log_time;
-        char* new_logfile_name;
-        int available_bytes = 0;
+    return;
+}
 
-        /* allocate string to hold final log file name */
-        new_logfile_name = malloc(__DARSHAN_PATH_MAX);
-        if(new_logfile_name)
-        {
-            /* copy partial log file name over to new string */
-            strncpy(new_logfile_name, logfile_name, __DARSHAN_PATH_MAX);
-            /* retrieve current time stamp */
-            end_log_time = darshan_core_wtime_absolute();
-            /* find location of .darshan_partial extension */
-            tmp_index = strstr(new_logfile_name, ".darshan_partial");
-            /* calculate how much room is in the string, considering the
-             * length of the temporary extension (which we will overwrite)
-             * and any other spare buffer space in the string
-             */
-            available_bytes = __DARSHAN_PATH_MAX - strlen(logfile_name) + strlen(".darshan_partial");
-            /* use snprintf with above limit to make sure we don't overflow */
-            snprintf(tmp_index, available_bytes, "_%d.darshan", (int)(end_log_time-start_log_time+1));
-            /* rename to new target name */
-            rename(logfile_name, new_logfile_name);
-            /* set permissions on log file */
-            chmod(new_logfile_name, chmod_mode);
-            free(new_logfile_name);
-        }
-    }
+/* start using the core runtime without holding the core lock, returning
+ * it, or NULL if darshan-core is not instrumenting; a non-NULL runtime
+ * stays valid until darshan_core_leave()
+ */
+static struct darshan_core_runtime *darshan_core_enter(void)
+{
+    struct darshan_core_runtime *core;
 
-    return;
+    __atomic_add_fetch(&core_active, 1, __ATOMIC_SEQ_CST);
+    core = __atomic_load_n(&__darshan_core, __ATOMIC_SEQ_CST);
+    if(!core)
+        __atomic_sub_fetch(&core_active, 1, __ATOMIC_RELEASE);
+
+    return(core);
 }
 
-static int darshan_deflate_buffer(void **pointers, int *lengths, int count,
-    char *comp_buf, int *comp_buf_length)
+static void darshan_core_leave(void)
 {
-    int ret = 0;
-    int i;
-    int total_target = 0;
-    z_stream tmp_stream;
+    __atomic_sub_fetch(&core_active, 1, __ATOMIC_RELEASE);
 
-    /* just return if there is no data */
-    for(i = 0; i < count; i++)
-    {
-        total_target += lengths[i];
-    }
-    if(total_target)
-    {
-        total_target = 0;
-    }
-    else
-    {
-        *comp_buf_length = 0;
-        return(0);
-    }
+    return;
+}
 
-    memset(&tmp_stream, 0, sizeof(tmp_stream));
-    tmp_stream.zalloc = Z_NULL;
-    tmp_stream.zfree = Z_NULL;
-    tmp_stream.opaque = Z_NULL;
+/* build the name of the rollup record of the directory that is the first
+ * 'dir_len' characters of 'name' in 'buf', returning its length, or -1 if
+ * it does not fit
+ */
+static int darshan_rollup_name(const char *name, int dir_len, char *buf,
+    size_t buf_len)
+{
+    size_t suffix_len = strlen(ROLLUP_NAME_SUFFIX);
 
-    /* initialize the zlib compression parameters */
-    /* TODO: check these parameters? */
-//    ret = deflateInit2(&tmp_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
-//        15 + 16, 8, Z_DEFAULT_STRATEGY);
-    ret = deflateInit(&tmp_stream, Z_DEFAULT_COMPRESSION);
-    if(ret != Z_OK)
-    {
+    if(dir_len + suffix_len + 1 > buf_len)
         return(-1);
-    }
+    memcpy(buf, name, dir_len);
+    memcpy(buf + dir_len, ROLLUP_NAME_SUFFIX, suffix_len + 1);
 
-    tmp_stream.next_out = (unsigned char *)comp_buf;
-    tmp_stream.avail_out = (size_t)(*comp_buf_length);
+    return(dir_len + suffix_len);
+}
 
-    /* loop over the input pointers */
-    for(i = 0; i < count; i++)
+/* return the id of the rollup record that the path 'name' (with record id
+ * 'rec_id') is collapsed into, or 'rec_id' if the path keeps its own record
+ */
+static darshan_record_id darshan_core_rollup_record_id(const char *name,
+    int name_len, darshan_record_id rec_id)
+{
+    struct darshan_core_runtime *core;
+    struct darshan_core_name_dir_ref *dir_ref;
+    darshan_record_id rollup_id = 0;
+    char rollup_name[__DARSHAN_PATH_MAX];
+    uint64_t dir_id;
+    int dir_len, len;
+
+    dir_len = darshan_name_dir_len(name, name_len);
+    if(dir_len <= 0)
+        return(rec_id);
+    dir_id = darshan_name_dir_id(name, dir_len);
+
+    core = darshan_core_enter();
+    if(core)
     {
-        total_target += lengths[i];
-        tmp_stream.next_in = pointers[i];
-        tmp_stream.avail_in = lengths[i];
-        /* while we have not finished consuming all of the data available to
-         * this point in the loop
+        /* paths that were registered before the directory reached the
+         * threshold keep their records
          */
-        while(tmp_stream.total_in < total_target)
+        dir_ref = darshan_core_id_map_find(&core->name_dir_map, dir_id);
+        if(dir_ref && !darshan_core_id_map_find(&core->name_map, rec_id) &&
+           __atomic_load_n(&dir_ref->file_count, __ATOMIC_RELAXED) >=
+           dir_rollup_threshold)
         {
-            if(tmp_stream.avail_out == 0)
-            {
-                /* We ran out of buffer space for compression.  In theory,
-                 * we could start using some of the file_array buffer space
-                 * without having to malloc again.  In practice, this case
-                 * is going to be practically impossible to hit.
-                 */
-                deflateEnd(&tmp_stream);
-                return(-1);
-            }
-
-            /* compress data */
-            ret = deflate(&tmp_stream, Z_NO_FLUSH);
-            if(ret != Z_OK)
+            /* racing threads all store the same id */
+            rollup_id = __atomic_load_n(&dir_ref->rollup_id, __ATOMIC_RELAXED);
+            if(!rollup_id)
             {
-                deflateEnd(&tmp_stream);
-                return(-1);
+                len = darshan_rollup_name(name, dir_len, rollup_name,
+                    sizeof(rollup_name));
+                if(len > 0)
+                {
+                    rollup_id = darshan_hash(
+                        (unsigned char *)rollup_name, len, 0);
+                    __atomic_store_n(&dir_ref->rollup_id, rollup_id,
+                        __ATOMIC_RELAXED);
+                }
             }
         }
+        darshan_core_leave();
     }
 
-    /* flush compression and end */
-    ret = deflate(&tmp_stream, Z_FINISH);
-    if(ret != Z_STREAM_END)
-    {
-        deflateEnd(&tmp_stream);
-        return(-1);
-    }
-    deflateEnd(&tmp_stream);
+    if(!rollup_id)
+        return(rec_id);
 
-    *comp_buf_length = tmp_stream.total_out;
-    return(0);
+    darshan_rollup_note_file(rollup_id, name, rec_id);
+    return(rollup_id);
 }
 
-/* free darshan core data structures to shutdown */
-static void darshan_core_cleanup(struct darshan_core_runtime* core)
+darshan_record_id darshan_core_gen_record_id(
+    const char *name)
 {
-    int i;
-    struct darshan_core_name_record_ref *tmp, *ref;
+    darshan_record_id rec_id;
+    int name_len = strlen(name);
 
-    HASH_ITER(hlink, core->name_hash, ref, tmp)
-    {
-        HASH_DELETE(hlink, core->name_hash, ref);
-        free(ref);
-    }
+    /* hash the input name to get a unique id for this record */
+    rec_id = darshan_hash((unsigned char *)name, name_len, 0);
 
-    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
-    {
-        if(core->mod_array[i])
-        {
-            free(core->mod_array[i]);
-            core->mod_array[i] = NULL;
-        }
-    }
+    /* paths may be collapsed into the rollup record of their directory */
+    if(dir_rollup_threshold && name[0] == '/')
+        rec_id = darshan_core_rollup_record_id(name, name_len, rec_id);
 
-#ifndef __DARSHAN_ENABLE_MMAP_LOGS
-    free(core->log_hdr_p);
-    free(core->log_job_p);
-    free(core->log_exemnt_p);
-    free(core->log_name_p);
-    free(core->log_mod_p);
-#endif
+    return(rec_id);
+}
 
-#ifdef HAVE_MPI
-    if(using_mpi)
-        PMPI_Comm_free(&core->mpi_comm);
-#endif
+/* make another chunk of a growing module's reservation accessible, so that
+ * it can store at least one more record of size 'rec_size', as long as the
+ * global cap and the module's record limit allow. returns 1 if the module
+ * has room for the record, 0 otherwise. must be called with the core lock
+ * held.
+ */
+static int darshan_core_grow_module(struct darshan_core_runtime *core,
+    struct darshan_core_module *mod, size_t rec_size)
+{
+    size_t avail = __atomic_load_n(&mod->rec_mem_avail, __ATOMIC_RELAXED);
+    size_t grown = mod->rec_mem_grown;
+    size_t used = grown - avail;
+    size_t chunk = DARSHAN_MOD_MEM_GROW_CHUNK;
 
-    darshan_free_config(&core->config);
+    /* another thread may have grown the module meanwhile */
+    if(avail >= rec_size)
+        return(1);
+    if(mod->rec_max_count && (used / rec_size) >= mod->rec_max_count)
+        return(0);
 
-    if(core->comp_buf)
-        free(core->comp_buf);
-    free(core);
+    /* grow by whole chunks, and never past the cap; the reservation is
+     * as large as the cap, so it can not be exceeded either
+     */
+    if(chunk < rec_size)
+        chunk = ((rec_size / DARSHAN_MOD_MEM_GROW_CHUNK) + 1) *
+            DARSHAN_MOD_MEM_GROW_CHUNK;
+    if(core->mod_mem_used + chunk > core->config.mod_mem_grow)
+        chunk = core->config.mod_mem_grow - core->mod_mem_used;
+    if(avail + chunk < rec_size)
+        return(0);
 
-    return;
+    if(mprotect((char *)mod->rec_buf_start + grown, chunk,
+        PROT_READ|PROT_WRITE) < 0)
+        return(0);
+    if(mem_first_touch)
+        memset((char *)mod->rec_buf_start + grown, 0, chunk);
+    mod->rec_mem_grown += chunk;
+    __atomic_add_fetch(&mod->rec_mem_avail, chunk, __ATOMIC_RELEASE);
+    core->mod_mem_used += chunk;
+
+    return(1);
 }
 
-static void darshan_core_fork_child_cb(void)
+/* claim 'rec_size' bytes of a module's record memory, returning 0 if not
+ * enough is left
+ */
+static int darshan_core_reserve_record(struct darshan_core_module *mod,
+    size_t rec_size)
 {
-    if(__darshan_core)
-    {
-        /* hold onto the original parent PID, which we will use as jobid if the user didn't
-         * provide a jobid env variable
-         */
-        parent_pid = __darshan_core->pid;
-        if(!orig_parent_pid)
-            orig_parent_pid = parent_pid;
+    size_t avail = __atomic_load_n(&mod->rec_mem_avail, __ATOMIC_RELAXED);
 
-        /* shutdown and re-init darshan, making sure to not write out a log file */
-        darshan_core_shutdown(0);
-        darshan_core_initialize(0, NULL);
-    }
+    do
+    {
+        if(avail < rec_size)
+            return(0);
+    } while(!__atomic_compare_exchange_n(&mod->rec_mem_avail, &avail,
+        avail - rec_size, 1, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
 
-    return;
+    return(1);
 }
 
-static int darshan_core_name_is_excluded(const char *name, darshan_module_id mod_id)
+/* NOTE: records are registered without the core lock, so that threads
+ * opening many files at once do not queue up behind each other: record
+ * memory is claimed from each module with atomics, and names are added to
+ * lock-free maps with atomic bump allocation of name memory. The core lock
+ * is only taken to grow a module's record memory.
+ */
+void *darshan_core_register_record(
+    darshan_record_id rec_id,
+    const char *name,
+    darshan_module_id mod_id,
+    size_t rec_size,
+    struct darshan_fs_info *fs_info)
 {
-    int name_is_path;
-    int name_excluded = 0, name_included = 0;
-    char *path_exclusion, *path_inclusion;
-    int tmp_index = 0;
-    struct darshan_core_regex *regex;
-
-    /* set flag if this module's record names are based on file paths */
-    name_is_path = 1;
-    if((mod_id == DARSHAN_APMPI_MOD) || (mod_id == DARSHAN_APXC_MOD) ||
-       (mod_id == DARSHAN_HEATMAP_MOD) || (mod_id == DARSHAN_MDHIM_MOD))
-        name_is_path = 0;
+    struct darshan_core_runtime *core;
+    struct darshan_core_module *mod;
+    struct darshan_core_name_record_ref *ref;
+    struct darshan_core_name_dir_ref *dir_ref;
+    char rollup_name[__DARSHAN_PATH_MAX];
+    void *rec_buf;
+    double lock_start;
+    int name_len, dir_len = 0;
+    uint64_t dir_id;
+    int reserved;
+    int ret;
 
-    if(name_is_path)
+    /* records of paths collapsed into a directory rollup are named after
+     * the rollup, which is only recognized by its id
+     */
+    if(dir_rollup_threshold && name && name[0] == '/')
     {
-        /* if record name is a path, check against either default or
-         * user-provided path exclusions
-         */
-
-        /* if user has set DARSHAN_EXCLUDE_DIRS, override the default ones */
-        if (__darshan_core->config.user_exclude_dirs != NULL) {
-            while((path_exclusion = __darshan_core->config.user_exclude_dirs[tmp_index++])) {
-                if(!(strncmp(path_exclusion, name, strlen(path_exclusion)))) {
-                    name_excluded = 1;
-                    break;
-                }
-            }
-        }
-        else {
-            /* scan default exclusion list for paths to exclude */
-            while((path_exclusion = __darshan_core->config.exclude_dirs[tmp_index++])) {
-                if(!(strncmp(path_exclusion, name, strlen(path_exclusion)))) {
-                    name_excluded = 1;
-                    break;
-                }
+        name_len = strlen(name);
+        dir_len = darshan_name_dir_len(name, name_len);
+        if(dir_len > 0 &&
+           rec_id != darshan_hash((unsigned char *)name, name_len, 0))
+        {
+            name_len = darshan_rollup_name(name, dir_len, rollup_name,
+                sizeof(rollup_name));
+            if(name_len > 0 && rec_id ==
+               darshan_hash((unsigned char *)rollup_name, name_len, 0))
+            {
+                name = rollup_name;
+                dir_len = 0;
             }
         }
     }
 
-    if(!name_excluded)
+    core = darshan_core_enter();
+    if(!core)
+        return(NULL);
+    mod = core->mod_array[mod_id];
+
+    /* check to see if this module has enough space to store a new record */
+    reserved = darshan_core_reserve_record(mod, rec_size);
+    while(!reserved && mod->rec_mem_max)
     {
-        /* check to see if this name is in the module exclusion list provided to
-         * Darshan config
-         */
-        LL_FOREACH(__darshan_core->config.rec_exclusion_list, regex)
+        __DARSHAN_CORE_LOCK();
+        lock_start = darshan_core_wtime_absolute();
+        ret = darshan_core_grow_module(core, mod, rec_size);
+        core_register_time += darshan_core_wtime_absolute() - lock_start;
+        __DARSHAN_CORE_UNLOCK();
+        if(!ret)
+            break;
+        reserved = darshan_core_reserve_record(mod, rec_size);
+    }
+    if(!reserved)
+    {
+        __atomic_fetch_or(&core->log_hdr_p->partial_flag, 1ULL << mod_id,
+            __ATOMIC_RELAXED);
+        darshan_core_leave();
+        return(NULL);
+    }
+
+    /* register a name record if a name is given for this record */
+    if(name)
+    {
+        if(darshan_core_record_is_excluded(core, rec_id, name, mod_id))
         {
-            if(DARSHAN_MOD_FLAG_ISSET(regex->mod_flags, mod_id) &&
-                (regexec(&regex->regex, name, 0, NULL, 0) == 0))
-            {
-                name_excluded = 1;
-                break;
-            }
+            /* do not register record if name matches any exclusion rules */
+            __atomic_add_fetch(&mod->rec_mem_avail, rec_size,
+                __ATOMIC_RELAXED);
+            darshan_core_leave();
+            return(NULL);
         }
     }
 
-    if(name_is_path && name_excluded && !__darshan_core->config.user_exclude_dirs)
+    /* check to see if we've already stored the id->name mapping for
+     * this record, and add a new name record if not
+     */
+    ref = darshan_core_id_map_find(&core->name_map, rec_id);
+    if(!ref)
     {
-        /* if record name is a path, check against default path inclusions */
-        tmp_index = 0;
-        while((path_inclusion = __darshan_core->config.include_dirs[tmp_index++])) {
-            if(!(strncmp(path_inclusion, name, strlen(path_inclusion)))) {
-                name_included = 1;
-                break;
-            }
+        ret = darshan_add_name_record_ref(core, rec_id, name, mod_id);
+
+        /* count the files of the directory toward its rollup threshold */
+        if(ret && dir_len > 0)
+        {
+            dir_id = darshan_name_dir_id(name, dir_len);
+            dir_ref = darshan_core_id_map_find(&core->name_dir_map, dir_id);
+            if(dir_ref)
+                __atomic_add_fetch(&dir_ref->file_count, 1, __ATOMIC_RELAXED);
         }
     }
-
-    if(name_excluded && !name_included)
+    else
+    {
+        ret = (darshan_core_ref_wait(&ref->state) == DARSHAN_CORE_REF_READY);
+        if(ret)
+            __atomic_fetch_or(&ref->mod_flags, 1ULL << mod_id,
+                __ATOMIC_RELAXED);
+    }
+    if(!ret)
+    {
+        __atomic_add_fetch(&mod->rec_mem_avail, rec_size, __ATOMIC_RELAXED);
+        __atomic_fetch_or(&core->log_hdr_p->partial_flag, 1ULL << mod_id,
+            __ATOMIC_RELAXED);
+        darshan_core_leave();
+        return(NULL);
+    }
+
+    if((mod_id != DXT_POSIX_MOD) && (mod_id != DXT_MPIIO_MOD) &&
+       (mod_id != DXT_STDIO_MOD))
+    {
+        /* traditional (non-DXT) modules need to provide a record
+         * pointer back to caller and update internal module structures.
+         * the space was claimed above, so the record is always within
+         * the module's memory.
+         */
+        rec_buf = __atomic_fetch_add(&mod->rec_buf_p, rec_size,
+            __ATOMIC_RELAXED);
+#ifdef __DARSHAN_ENABLE_MMAP_LOGS
+        __DARSHAN_CORE_LOCK();
+        __DARSHAN_MMAP_GEN_BEGIN(core, mod_gen[mod_id]);
+        core->log_hdr_p->mod_map[mod_id].len += rec_size;
+        __DARSHAN_MMAP_GEN_END(core, mod_gen[mod_id]);
+        __DARSHAN_CORE_UNLOCK();
+#endif
+    }
+    else
     {
-        /* if marked as excluded, make sure there's not a superseding inclusion
-         * associated with this module from Darshan config
+        /* NOTE: Darshan does not provide record pointers back for
+         * DXT modules, but we do return a non-NULL value so DXT
+         * modules can determine whether the record was registered
+         * successfully
          */
-        LL_FOREACH(__darshan_core->config.rec_inclusion_list, regex)
-        {
-            if(DARSHAN_MOD_FLAG_ISSET(regex->mod_flags, mod_id) &&
-                (regexec(&regex->regex, name, 0, NULL, 0) == 0))
-            {
-                name_included = 1;
-                break;
-            }
-        }
-
-        if(!name_included)
-            return(1);
+        rec_buf = (void *)1;
     }
 
-    return(0);
+    __atomic_add_fetch(&core_register_calls, 1, __ATOMIC_RELAXED);
+    darshan_core_leave();
+
+    if(fs_info)
+        darshan_fs_info_from_path(name, fs_info);
+
+    return(rec_buf);
 }
 
-#ifdef HAVE_MPI
-static void darshan_core_reduce_min_time(void* in_time_v, void* inout_time_v,
-    int *len, MPI_Datatype *datatype)
+/* drop the staged copy of the records retired in 'chunk', which are then
+ * written from the module's output buffer
+ */
+static void darshan_core_drop_retired_chunk(struct darshan_core_module *mod,
+    struct darshan_core_retired_chunk *chunk)
 {
-    int64_t tmp_sec, tmp_nsec;
-    int64_t *in_sec = in_time_v;
-    int64_t *in_nsec = in_sec+1;
-    int64_t *inout_sec = inout_time_v;
-    int64_t *inout_nsec = inout_sec+1;
+    struct darshan_core_retired_ref *ref;
     int i;
 
-    for(i=0; i<*len; i++)
+    if(!chunk->live)
+        return;
+
+    for(i = 0; i < chunk->rec_count; i++)
     {
-        /* min */
-        if((*in_sec < *inout_sec) ||
-            ((*in_sec == *inout_sec) &&
-             (*in_nsec < *inout_nsec)))
-        {
-            tmp_sec = *in_sec;
-            tmp_nsec = *in_nsec;
-        }
-        else
-        {
-            tmp_sec = *inout_sec;
-            tmp_nsec = *inout_nsec;
-        }
+        ref = &chunk->refs[i];
+        HASH_DELETE(hlink, mod->retired_hash, ref);
+    }
+    free(chunk->refs);
+    free(chunk->comp_buf);
+    chunk->refs = NULL;
+    chunk->comp_buf = NULL;
+    chunk->live = 0;
+    mod->retired_live--;
 
-        /* update pointers */
-        *inout_sec = tmp_sec;
-        *inout_nsec = tmp_nsec;
-        inout_sec+=2;
-        inout_nsec+=2;
-        in_sec+=2;
-        in_nsec+=2;
+    return;
+}
+
+static void darshan_core_free_retired(struct darshan_core_module *mod)
+{
+    struct darshan_core_retired_chunk *chunk, *tmp;
+
+    LL_FOREACH_SAFE(mod->retired_chunks, chunk, tmp)
+    {
+        darshan_core_drop_retired_chunk(mod, chunk);
+        free(chunk);
     }
+    mod->retired_chunks = NULL;
 
     return;
 }
 
-static void darshan_core_reduce_max_time(void* in_time_v, void* inout_time_v,
-    int *len, MPI_Datatype *datatype)
+int darshan_core_retire_records(darshan_module_id mod_id, void **recs,
+    int count, size_t rec_size)
 {
-    int64_t tmp_sec, tmp_nsec;
-    int64_t *in_sec = in_time_v;
-    int64_t *in_nsec = in_sec+1;
-    int64_t *inout_sec = inout_time_v;
-    int64_t *inout_nsec = inout_sec+1;
+    struct darshan_core_module *mod;
+    struct darshan_core_retired_chunk *chunk;
+    struct darshan_core_retired_ref *ref, *new_ref;
+    int *lengths;
+    int comp_type;
     int i;
+    int ret;
 
-    for(i=0; i<*len; i++)
+    if(count <= 0 || rec_size < sizeof(struct darshan_base_record) ||
+       (size_t)count > INT_MAX / 2 / rec_size)
+        return(-1);
+
+    __DARSHAN_CORE_LOCK();
+    if(!__darshan_core || !__darshan_core->mod_array[mod_id])
     {
-        /* max */
-        if((*in_sec > *inout_sec) ||
-            ((*in_sec == *inout_sec) &&
-             (*in_nsec > *inout_nsec)))
-        {
-            tmp_sec = *in_sec;
-            tmp_nsec = *in_nsec;
-        }
-        else
+        __DARSHAN_CORE_UNLOCK();
+        return(-1);
+    }
+    comp_type = __darshan_core->config.log_comp_type;
+    __DARSHAN_CORE_UNLOCK();
+
+    /* compress outside of the core lock; the caller keeps the records from
+     * changing in the meantime
+     */
+    chunk = calloc(1, sizeof(*chunk));
+    lengths = malloc(count * sizeof(*lengths));
+    if(chunk)
+    {
+        chunk->refs = malloc(count * sizeof(*chunk->refs));
+        chunk->comp_len = count * rec_size + (count * rec_size) / 8 + 1024;
+        chunk->comp_buf = malloc(chunk->comp_len);
+    }
+    if(!chunk || !lengths || !chunk->refs || !chunk->comp_buf)
+    {
+        if(chunk)
         {
-            tmp_sec = *inout_sec;
-            tmp_nsec = *inout_nsec;
+            free(chunk->refs);
+            free(chunk->comp_buf);
         }
+        free(chunk);
+        free(lengths);
+        return(-1);
+    }
+    for(i = 0; i < count; i++)
+        lengths[i] = rec_size;
+    ret = darshan_compress_buffer(comp_type, recs, lengths, count,
+        chunk->comp_buf, &chunk->comp_len);
+    free(lengths);
+    if(ret < 0)
+    {
+        free(chunk->refs);
+        free(chunk->comp_buf);
+        free(chunk);
+        return(-1);
+    }
+    chunk->comp_buf = realloc(chunk->comp_buf, chunk->comp_len);
+    chunk->rec_count = count;
+    chunk->rec_size = rec_size;
+    chunk->live = 1;
 
-        /* update pointers */
-        *inout_sec = tmp_sec;
-        *inout_nsec = tmp_nsec;
-        inout_sec+=2;
-        inout_nsec+=2;
-        in_sec+=2;
-        in_nsec+=2;
+    __DARSHAN_CORE_LOCK();
+    mod = __darshan_core ? __darshan_core->mod_array[mod_id] : NULL;
+    if(!mod)
+    {
+        __DARSHAN_CORE_UNLOCK();
+        free(chunk->refs);
+        free(chunk->comp_buf);
+        free(chunk);
+        return(-1);
+    }
+    for(i = 0; i < count; i++)
+    {
+        new_ref = &chunk->refs[i];
+        new_ref->rec_id = ((struct darshan_base_record *)recs[i])->id;
+        new_ref->chunk = chunk;
+
+        /* a record retired again supersedes its earlier copy */
+        HASH_FIND(hlink, mod->retired_hash, &new_ref->rec_id,
+            sizeof(darshan_record_id), ref);
+        if(ref)
+            darshan_core_drop_retired_chunk(mod, ref->chunk);
+        HASH_ADD(hlink, mod->retired_hash, rec_id, sizeof(darshan_record_id),
+            new_ref);
     }
+    LL_PREPEND(mod->retired_chunks, chunk);
+    mod->retired_live++;
+    __DARSHAN_CORE_UNLOCK();
 
-    return;
+    return(0);
 }
-#endif
 
-/* crude benchmarking hook into darshan-core to benchmark Darshan
- * shutdown overhead using a variety of application I/O workloads
- */
-extern void darshan_posix_shutdown_bench_setup();
-extern void darshan_mpiio_shutdown_bench_setup();
-#ifdef HAVE_MPI
-void darshan_shutdown_bench(int argc, char **argv)
+void darshan_core_revive_record(darshan_module_id mod_id,
+    darshan_record_id rec_id)
 {
-    /* clear out existing core runtime structure */
-    if(__darshan_core)
-    {
-        darshan_core_cleanup(__darshan_core);
-        __darshan_core = NULL;
-    }
-
-    /***********************************************************/
-    /* restart darshan */
-    darshan_core_initialize(argc, argv);
+    struct darshan_core_module *mod;
+    struct darshan_core_retired_ref *ref = NULL;
 
-    darshan_posix_shutdown_bench_setup(1);
-    darshan_mpiio_shutdown_bench_setup(1);
+    __DARSHAN_CORE_LOCK();
+    mod = __darshan_core ? __darshan_core->mod_array[mod_id] : NULL;
+    if(mod)
+        HASH_FIND(hlink, mod->retired_hash, &rec_id,
+            sizeof(darshan_record_id), ref);
+    if(ref)
+        darshan_core_drop_retired_chunk(mod, ref->chunk);
+    __DARSHAN_CORE_UNLOCK();
 
-    if(my_rank == 0)
-        fprintf(stderr, "# 1 unique file per proc\n");
-    PMPI_Barrier(MPI_COMM_WORLD);
-    darshan_core_shutdown(1);
-    __darshan_core = NULL;
+    return;
+}
 
-    sleep(1);
+int darshan_core_lookup_record_name(darshan_record_id rec_id, char *name,
+    size_t name_len)
+{
+    struct darshan_core_runtime *core;
+    struct darshan_core_name_record_ref *ref;
+    int ret = 0;
 
-    /***********************************************************/
-    /* restart darshan */
-    darshan_core_initialize(argc, argv);
+    core = darshan_core_enter();
+    if(!core)
+        return(0);
+    ref = darshan_core_id_map_find(&core->name_map, rec_id);
+    if(ref && darshan_core_ref_wait(&ref->state) == DARSHAN_CORE_REF_READY)
+        ret = darshan_name_entry_expand(core, ref->name_record,
+            name, name_len);
+    darshan_core_leave();
 
-    darshan_posix_shutdown_bench_setup(2);
-    darshan_mpiio_shutdown_bench_setup(2);
+    return(ret);
+}
 
-    if(my_rank == 0)
-        fprintf(stderr, "# 1 shared file per proc\n");
-    PMPI_Barrier(MPI_COMM_WORLD);
-    darshan_core_shutdown(1);
-    __darshan_core = NULL;
+int darshan_core_thread_shards_enabled()
+{
+    int ret = 0;
 
-    sleep(1);
+    __DARSHAN_CORE_LOCK();
+    if(__darshan_core)
+        ret = __darshan_core->config.thread_shards_flag;
+    __DARSHAN_CORE_UNLOCK();
 
-    /***********************************************************/
-    /* restart darshan */
-    darshan_core_initialize(argc, argv);
+    return(ret);
+}
 
-    darshan_posix_shutdown_bench_setup(3);
-    darshan_mpiio_shutdown_bench_setup(3);
+int darshan_core_heatmap_ops_enabled()
+{
+    int ret = 0;
 
-    if(my_rank == 0)
-        fprintf(stderr, "# 1024 unique files per proc\n");
-    PMPI_Barrier(MPI_COMM_WORLD);
-    darshan_core_shutdown(1);
-    __darshan_core = NULL;
+    __DARSHAN_CORE_LOCK();
+    if(__darshan_core)
+        ret = __darshan_core->config.heatmap_ops_flag;
+    __DARSHAN_CORE_UNLOCK();
 
-    sleep(1);
+    return(ret);
+}
 
-    /***********************************************************/
-    /* restart darshan */
-    darshan_core_initialize(argc, argv);
+int darshan_core_heatmap_reduce()
+{
+    int ret = 0;
 
-    darshan_posix_shutdown_bench_setup(4);
-    darshan_mpiio_shutdown_bench_setup(4);
+    __DARSHAN_CORE_LOCK();
+    if(__darshan_core)
+        ret = __darshan_core->config.heatmap_reduce;
+    __DARSHAN_CORE_UNLOCK();
 
-    if(my_rank == 0)
-        fprintf(stderr, "# 1024 shared files per proc\n");
-    PMPI_Barrier(MPI_COMM_WORLD);
-    darshan_core_shutdown(1);
-    __darshan_core = NULL;
+    return(ret);
+}
 
-    sleep(1);
+int darshan_core_mpiio_coll_wait_enabled()
+{
+    int ret = 0;
 
-    /***********************************************************/
+    __DARSHAN_CORE_LOCK();
+    if(__darshan_core)
+        ret = __darshan_core->config.mpiio_coll_wait_flag;
+    __DARSHAN_CORE_UNLOCK();
 
-    return;
+    return(ret);
 }
-#else
-void darshan_shutdown_bench(int argc, char **argv)
+
+int darshan_core_lustre_layout_cache_enabled()
 {
-    fprintf(stderr, "Error: darshan_shutdown_bench() not implemented for non-mpi builds.\n");
-    assert(0);
-    return;
+    int ret = 0;
+
+    __DARSHAN_CORE_LOCK();
+    if(__darshan_core)
+        ret = __darshan_core->config.lustre_layout_cache_flag;
+    __DARSHAN_CORE_UNLOCK();
+
+    return(ret);
 }
-#endif
 
-/* ********************************************************* */
+int darshan_core_lustre_ost_traffic_enabled()
+{
+    int ret = 0;
 
-int darshan_core_register_module(
-    darshan_module_id mod_id,
-    darshan_module_funcs mod_funcs,
-    size_t rec_size,
-    size_t *inout_rec_count,
-    int *rank,
-    int *sys_mem_alignment)
+    __DARSHAN_CORE_LOCK();
+    if(__darshan_core)
+        ret = __darshan_core->config.lustre_ost_traffic_flag;
+    __DARSHAN_CORE_UNLOCK();
+
+    return(ret);
+}
+
+size_t darshan_core_stdio_batch_small()
 {
-    struct darshan_core_module* mod;
-    size_t mod_recs_req = *inout_rec_count;
-    size_t mod_mem_avail, mod_mem_req;
+    size_t ret = 0;
 
-    *inout_rec_count = 0;
+    __DARSHAN_CORE_LOCK();
+    if(__darshan_core)
+        ret = __darshan_core->config.stdio_batch_small;
+    __DARSHAN_CORE_UNLOCK();
+
+    return(ret);
+}
 
-    /* do this early before acquiring lock */
-    mod = malloc(sizeof(*mod));
-    if(!mod) return(-1);
-    memset(mod, 0, sizeof(*mod));
+size_t darshan_core_sample_rate(darshan_module_id mod_id)
+{
+    size_t ret = 1;
+    int meta_remain;
+    char *m;
 
     __DARSHAN_CORE_LOCK();
-    if((__darshan_core == NULL) ||
-       (mod_id >= DARSHAN_KNOWN_MODULE_COUNT) ||
-       (__darshan_core->mod_array[mod_id] != NULL) ||
-       (DARSHAN_MOD_FLAG_ISSET(__darshan_core->config.mod_disabled, mod_id)))
+    if(__darshan_core && mod_id < DARSHAN_KNOWN_MODULE_COUNT &&
+        __darshan_core->config.mod_sample_rate[mod_id] > 1)
     {
-        /* fail if:
-         *   - Darshan is not currently instrumenting
-         *   - the module ID is invalid
-         *   - the module is already registered
-         *   - the module is set as disabled at runtime
-         */
-        __DARSHAN_CORE_UNLOCK();
-        free(mod);
-        return(-1);
-    }
+        ret = __darshan_core->config.mod_sample_rate[mod_id];
 
-    /* allow user overrides of module record counts */
-    if(__darshan_core->config.mod_max_records_override[mod_id])
-    {
-        /* ignore overrides for modules with static record counts
-         * (i.e., HEATMAP, APMPI, APXC modules)
-         */
-        if((mod_id != DARSHAN_HEATMAP_MOD) && (mod_id != DARSHAN_APXC_MOD) &&
-            (mod_id != DARSHAN_APMPI_MOD))
-            mod_recs_req = __darshan_core->config.mod_max_records_override[mod_id];
+        /* mark the module's sampled counters as estimates in the log */
+        meta_remain = DARSHAN_JOB_METADATA_LEN -
+            strlen(__darshan_core->log_job_p->metadata) - 1;
+        if(meta_remain >= (strlen(darshan_module_names[mod_id]) + 34))
+        {
+            m = __darshan_core->log_job_p->metadata +
+                strlen(__darshan_core->log_job_p->metadata);
+            sprintf(m, "%s_sample_rate=%zu\n",
+                darshan_module_names[mod_id], ret);
+        }
     }
+    __DARSHAN_CORE_UNLOCK();
 
-    mod_mem_req = mod_recs_req * rec_size;
-    mod_mem_avail = __darshan_core->config.mod_mem - __darshan_core->mod_mem_used;
+    return(ret);
+}
 
-    /* set module structure to register with Darshan core */
-    mod->mod_funcs = mod_funcs;
-    if((mod_id != DXT_POSIX_MOD) && (mod_id != DXT_MPIIO_MOD))
-    {
-        /* for traditional (non-DXT) modules, calculate how many module records
-         * we can satisfy given our current global memory usage and set up
-         * module memory pointers
-         */
-        if(mod_mem_avail >= mod_mem_req)
-        {
-            mod->rec_mem_avail = mod_mem_req;
-            *inout_rec_count = mod_recs_req;
-        }
-        else
-        {
-            int tmp_rec_count = mod_mem_avail / rec_size;
-            mod->rec_mem_avail = tmp_rec_count * rec_size;
-            *inout_rec_count = tmp_rec_count;
-        }
-        mod->rec_buf_start = __darshan_core->log_mod_p + __darshan_core->mod_mem_used;
-        mod->rec_buf_p = mod->rec_buf_start;
+double darshan_core_timeseries_interval()
+{
+    double ret = 0;
 
-        __darshan_core->mod_mem_used += mod->rec_mem_avail;
-#ifdef __DARSHAN_ENABLE_MMAP_LOGS
-        __darshan_core->log_hdr_p->mod_map[mod_id].off =
-            ((char *)mod->rec_buf_start - (char *)__darshan_core->log_hdr_p);
-#endif
-    }
-    else
-    {
-        /* DXT modules allocate their own memory and do not use the global
-         * module memory pool managed by Darshan core, so we just grant
-         * however much they request and hold onto this value for tracking
-         */
-        mod->rec_mem_avail = mod_mem_req;
-        *inout_rec_count = mod_recs_req;
-    }
+    __DARSHAN_CORE_LOCK();
+    if(__darshan_core)
+        ret = __darshan_core->config.timeseries_interval;
+    __DARSHAN_CORE_UNLOCK();
 
-    /* register module with darshan */
-    __darshan_core->mod_array[mod_id] = mod;
-    __darshan_core->log_hdr_p->mod_ver[mod_id] = darshan_module_versions[mod_id];
+    return(ret);
+}
 
-    /* set the memory alignment and calling process's rank, if desired */
-    if(sys_mem_alignment)
-        *sys_mem_alignment = __darshan_core->config.mem_alignment;
-    if(rank)
-        *rank = my_rank;
+size_t darshan_core_dir_rollup_threshold()
+{
+    size_t ret = 0;
 
+    __DARSHAN_CORE_LOCK();
+    if(__darshan_core)
+        ret = __darshan_core->config.dir_rollup_threshold;
     __DARSHAN_CORE_UNLOCK();
 
-    return(0);
+    return(ret);
 }
 
-/* NOTE: we currently don't really have a simple way of returning the
- * memory allocated to this module back to darshan to hand out to
- * other modules, so all we do is disable the module so darshan does
- * not attempt to call into it at shutdown time
- */
-void darshan_core_unregister_module(
-    darshan_module_id mod_id)
+size_t darshan_core_phase_barriers()
 {
-    struct darshan_core_module* mod;
+    size_t ret = 0;
 
     __DARSHAN_CORE_LOCK();
-    if(!__darshan_core)
-    {
-        __DARSHAN_CORE_UNLOCK();
-        return;
-    }
+    if(__darshan_core)
+        ret = __darshan_core->config.phase_barriers;
+    __DARSHAN_CORE_UNLOCK();
 
-    /* update darshan internal structures and header */
-    /* NOTE: save pointer to free module after lock is released */
-    mod = __darshan_core->mod_array[mod_id];
-    __darshan_core->mod_array[mod_id] = NULL;
-    __darshan_core->log_hdr_p->mod_ver[mod_id] = 0;
-#ifdef __DARSHAN_ENABLE_MMAP_LOGS
-    __darshan_core->log_hdr_p->mod_map[mod_id].off =
-        __darshan_core->log_hdr_p->mod_map[mod_id].len = 0;
-#endif
+    return(ret);
+}
+
+double darshan_core_record_retire_time()
+{
+    double ret = 0;
+
+    __DARSHAN_CORE_LOCK();
+    if(__darshan_core)
+        ret = __darshan_core->config.record_retire_time;
     __DARSHAN_CORE_UNLOCK();
-    free(mod);
 
-    return;
+    return(ret);
 }
 
-darshan_record_id darshan_core_gen_record_id(
-    const char *name)
+double darshan_core_mmap_sample_interval()
 {
-    /* hash the input name to get a unique id for this record */
-    return darshan_hash((unsigned char *)name, strlen(name), 0);
+    double ret = 0;
+
+    __DARSHAN_CORE_LOCK();
+    if(__darshan_core)
+        ret = __darshan_core->config.mmap_sample_interval;
+    __DARSHAN_CORE_UNLOCK();
+
+    return(ret);
 }
 
-void *darshan_core_register_record(
-    darshan_record_id rec_id,
-    const char *name,
-    darshan_module_id mod_id,
-    size_t rec_size,
-    struct darshan_fs_info *fs_info)
+size_t darshan_core_dxt_ring_segments()
 {
-    struct darshan_core_name_record_ref *ref;
-    void *rec_buf;
-    int ret;
+    size_t ret = 0;
 
     __DARSHAN_CORE_LOCK();
-    if(!__darshan_core)
-    {
-        __DARSHAN_CORE_UNLOCK();
-        return(NULL);
-    }
+    if(__darshan_core)
+        ret = __darshan_core->config.dxt_ring_segments;
+    __DARSHAN_CORE_UNLOCK();
 
-    /* check to see if this module has enough space to store a new record */
-    if(__darshan_core->mod_array[mod_id]->rec_mem_avail < rec_size)
-    {
-        DARSHAN_MOD_FLAG_SET(__darshan_core->log_hdr_p->partial_flag, mod_id);
-        __DARSHAN_CORE_UNLOCK();
-        return(NULL);
-    }
+    return(ret);
+}
 
-    /* register a name record if a name is given for this record */
-    if(name)
-    {
-        if(darshan_core_name_is_excluded(name, mod_id))
-        {
-            /* do not register record if name matches any exclusion rules */
-            __DARSHAN_CORE_UNLOCK();
-            return(NULL);
-        }
-    }
+char *darshan_core_dxt_spill_dir()
+{
+    char *ret = NULL;
 
-    /* check to see if we've already stored the id->name mapping for
-     * this record, and add a new name record if not
-     */
-    HASH_FIND(hlink, __darshan_core->name_hash, &rec_id,
-        sizeof(darshan_record_id), ref);
-    if(!ref)
+    __DARSHAN_CORE_LOCK();
+    if(__darshan_core && __darshan_core->config.dxt_spill_flag)
     {
-        ret = darshan_add_name_record_ref(__darshan_core, rec_id, name, mod_id);
-        if(ret == 0)
-        {
-            DARSHAN_MOD_FLAG_SET(__darshan_core->log_hdr_p->partial_flag, mod_id);
-            __DARSHAN_CORE_UNLOCK();
-            return(NULL);
-        }
+#ifdef __DARSHAN_ENABLE_MMAP_LOGS
+        ret = strdup(__darshan_core->config.mmap_log_path);
+#else
+        /* honor the mmap log path override even without mmap log support */
+        char *envstr = getenv(DARSHAN_MMAP_LOG_PATH_OVERRIDE);
+        ret = strdup(envstr ? envstr : DARSHAN_DEF_MMAP_LOG_PATH);
+#endif
     }
+    __DARSHAN_CORE_UNLOCK();
+
+    return(ret);
+}
+
+int darshan_core_mem_policy_enabled()
+{
+    return(mem_hugepages || mem_first_touch);
+}
+
+/* sizes are rounded up to whole huge pages when using them, so that
+ * darshan_core_mem_free() unmaps the same length whether or not an
+ * allocation fell back to regular pages
+ */
+static size_t darshan_core_mem_size(size_t size)
+{
+    size_t page_size;
+
+    if(mem_hugepages)
+        page_size = DARSHAN_HUGE_PAGE_SIZE;
     else
-    {
-        DARSHAN_MOD_FLAG_SET(ref->mod_flags, mod_id);
-    }
+        page_size = sysconf(_SC_PAGESIZE);
 
-    __darshan_core->mod_array[mod_id]->rec_mem_avail -= rec_size;
-    if((mod_id != DXT_POSIX_MOD) && (mod_id != DXT_MPIIO_MOD))
+    return(((size + page_size - 1) / page_size) * page_size);
+}
+
+void *darshan_core_mem_alloc(size_t size)
+{
+    void *ptr = MAP_FAILED;
+    char *map_p, *aligned_p;
+
+    size = darshan_core_mem_size(size);
+#ifdef MAP_HUGETLB
+    if(mem_hugepages == DARSHAN_HUGEPAGES_HUGETLB)
+        ptr = mmap(NULL, size, PROT_READ|PROT_WRITE,
+            MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+#endif
+    if(ptr == MAP_FAILED && mem_hugepages)
     {
-        /* traditional (non-DXT) modules need to provide a record
-         * pointer back to caller and update internal module structures
+        /* no preallocated huge pages, use transparent ones instead; these
+         * need the mapping to be aligned to the huge page size, so
+         * over-allocate and trim the ends
          */
-        rec_buf = __darshan_core->mod_array[mod_id]->rec_buf_p;
-        __darshan_core->mod_array[mod_id]->rec_buf_p += rec_size;
-#ifdef __DARSHAN_ENABLE_MMAP_LOGS
-        __darshan_core->log_hdr_p->mod_map[mod_id].len += rec_size;
+        map_p = mmap(NULL, size + DARSHAN_HUGE_PAGE_SIZE,
+            PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+        if(map_p == MAP_FAILED)
+            return(NULL);
+        aligned_p = (char *)(((uintptr_t)map_p + DARSHAN_HUGE_PAGE_SIZE - 1) &
+            ~((uintptr_t)DARSHAN_HUGE_PAGE_SIZE - 1));
+        if(aligned_p > map_p)
+            munmap(map_p, aligned_p - map_p);
+        munmap(aligned_p + size, DARSHAN_HUGE_PAGE_SIZE - (aligned_p - map_p));
+        ptr = aligned_p;
+#ifdef MADV_HUGEPAGE
+        madvise(ptr, size, MADV_HUGEPAGE);
 #endif
     }
-    else
+    else if(ptr == MAP_FAILED)
     {
-        /* NOTE: Darshan does not provide record pointers back for
-         * DXT modules, but we do return a non-NULL value so DXT
-         * modules can determine whether the record was registered
-         * successfully
-         */
-        rec_buf = (void *)1;
+        ptr = mmap(NULL, size, PROT_READ|PROT_WRITE,
+            MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+        if(ptr == MAP_FAILED)
+            return(NULL);
     }
 
-    __DARSHAN_CORE_UNLOCK();
+    /* fault the memory in from this thread, so that the kernel's default
+     * first-touch placement puts it on this thread's NUMA node
+     */
+    if(mem_first_touch)
+        memset(ptr, 0, size);
 
-    if(fs_info)
-        darshan_fs_info_from_path(name, fs_info);
+    return(ptr);
+}
 
-    return(rec_buf);;
+void darshan_core_mem_free(void *ptr, size_t size)
+{
+    if(ptr)
+        munmap(ptr, darshan_core_mem_size(size));
+
+    return;
 }
 
-char *darshan_core_lookup_record_name(darshan_record_id rec_id)
+size_t darshan_core_dxt_online_triggers(struct dxt_trigger *triggers,
+    int *trigger_count)
 {
-    struct darshan_core_name_record_ref *ref;
-    char *name = NULL;
+    size_t ret = 0;
+
+    *trigger_count = 0;
 
     __DARSHAN_CORE_LOCK();
-    HASH_FIND(hlink, __darshan_core->name_hash, &rec_id,
-        sizeof(darshan_record_id), ref);
-    if(ref)
-        name = ref->name_record->name;
+    if(__darshan_core)
+    {
+        if(__darshan_core->config.small_io_trigger)
+            triggers[(*trigger_count)++] = *__darshan_core->config.small_io_trigger;
+        if(__darshan_core->config.unaligned_io_trigger)
+            triggers[(*trigger_count)++] = *__darshan_core->config.unaligned_io_trigger;
+        if(*trigger_count > 0)
+            ret = __darshan_core->config.dxt_trigger_warmup;
+    }
+    __DARSHAN_CORE_UNLOCK();
+
+    return(ret);
+}
+
+void darshan_core_mark_partial(darshan_module_id mod_id)
+{
+    /* records are registered without the core lock, which may also set
+     * the flag
+     */
+    __DARSHAN_CORE_LOCK();
+    if(__darshan_core)
+        __atomic_fetch_or(&__darshan_core->log_hdr_p->partial_flag,
+            1ULL << mod_id, __ATOMIC_RELAXED);
     __DARSHAN_CORE_UNLOCK();
 
-    return(name);
+    return;
+}
+
+void darshan_core_get_overhead(struct darshan_overhead_record *core_rec,
+    double *mod_shutdown_times)
+{
+    core_rec->counters[OVERHEAD_REGISTER_CALLS] = core_register_calls;
+    core_rec->fcounters[OVERHEAD_F_INIT_TIME] = core_init_time;
+    core_rec->fcounters[OVERHEAD_F_REGISTER_LOCK_TIME] = core_register_time;
+
+    /* shutdown phases are only available while a log is being written */
+    if(shutdown_timing_flag)
+    {
+        core_rec->fcounters[OVERHEAD_F_SHUTDOWN_TIME] =
+            darshan_core_wtime_absolute() - shutdown_start_time;
+        core_rec->fcounters[OVERHEAD_F_SHARED_RECS_TIME] =
+            shutdown_tm.shared_recs;
+        core_rec->fcounters[OVERHEAD_F_COMPRESS_TIME] = shutdown_tm.compress;
+        core_rec->fcounters[OVERHEAD_F_WRITE_TIME] = shutdown_tm.write;
+        memcpy(mod_shutdown_times, shutdown_tm.mod_total,
+            sizeof(shutdown_tm.mod_total));
+    }
+    else
+    {
+        memset(mod_shutdown_times, 0, sizeof(shutdown_tm.mod_total));
+    }
+
+    return;
 }
 
 void darshan_instrument_fs_data(int fs_type, darshan_record_id rec_id, int fd)
@@ -2722,6 +6489,30 @@ void darshan_instrument_fs_data(int fs_type, darshan_record_id rec_id, int fd)
     return;
 }
 
+void darshan_instrument_fs_open(int fs_type, darshan_record_id rec_id, int fd)
+{
+#ifdef DARSHAN_LUSTRE
+    /* per-OST traffic accounting needs the file layout before the first
+     * access rather than at close
+     */
+    if(darshan_core_lustre_ost_traffic_enabled())
+        darshan_instrument_fs_data(fs_type, rec_id, fd);
+#endif
+    return;
+}
+
+void darshan_instrument_fs_io(int fs_type, darshan_record_id rec_id,
+    int64_t offset, int64_t length, int rw_flag)
+{
+#ifdef DARSHAN_LUSTRE
+    /* the Lustre module ignores files it holds no layout for, so there is
+     * no file system check here (see darshan_instrument_fs_data)
+     */
+    darshan_instrument_lustre_io(rec_id, offset, length, rw_flag);
+#endif
+    return;
+}
+
 #ifdef DARSHAN_PRELOAD
 extern int (*__real_vfprintf)(FILE *stream, const char *format, va_list);
 #else
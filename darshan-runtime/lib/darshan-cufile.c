@@ -0,0 +1,944 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <darshan-runtime-config.h>
+#endif
+
+#define _XOPEN_SOURCE 500
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+#include <assert.h>
+#include <time.h>
+
+#include <cufile.h>
+
+#include "darshan.h"
+#include "darshan-dynamic.h"
+#include "uthash.h"
+
+/* maximum number of registered buffers and batch handles tracked at once,
+ * which bounds the memory spent on applications that never deregister them.
+ * I/O on buffers beyond the limit is counted as unregistered.
+ */
+#define CUFILE_MAX_TRACKED 65536
+
+#define CUFILE_WTIME() \
+    __darshan_disabled ? 0 : darshan_core_wtime();
+
+DARSHAN_FORWARD_DECL(cuFileHandleRegister, CUfileError_t, (CUfileHandle_t *fh, CUfileDescr_t *descr));
+DARSHAN_FORWARD_DECL(cuFileHandleDeregister, void, (CUfileHandle_t fh));
+DARSHAN_FORWARD_DECL(cuFileBufRegister, CUfileError_t, (const void *bufPtr_base, size_t length, int flags));
+DARSHAN_FORWARD_DECL(cuFileBufDeregister, CUfileError_t, (const void *bufPtr_base));
+DARSHAN_FORWARD_DECL(cuFileRead, ssize_t, (CUfileHandle_t fh, void *bufPtr_base, size_t size, off_t file_offset, off_t bufPtr_offset));
+DARSHAN_FORWARD_DECL(cuFileWrite, ssize_t, (CUfileHandle_t fh, const void *bufPtr_base, size_t size, off_t file_offset, off_t bufPtr_offset));
+#if HAVE_DECL_CUFILEBATCHIOSUBMIT
+DARSHAN_FORWARD_DECL(cuFileBatchIOSubmit, CUfileError_t, (CUfileBatchHandle_t batch_idp, unsigned nr, CUfileIOParams_t *iocbp, unsigned int flags));
+DARSHAN_FORWARD_DECL(cuFileBatchIOGetStatus, CUfileError_t, (CUfileBatchHandle_t batch_idp, unsigned min_nr, unsigned *nr, CUfileIOEvents_t *iocbp, struct timespec *timeout));
+DARSHAN_FORWARD_DECL(cuFileBatchIODestroy, void, (CUfileBatchHandle_t batch_idp));
+#endif
+
+/* The cufile_record_ref structure maintains necessary runtime metadata
+ * for each CUFILE record.  File records are indexed both by record id and
+ * by each cuFile handle registered for the file.
+ */
+struct cufile_record_ref
+{
+    struct darshan_cufile_record *record_p;
+};
+
+/* a device buffer registered with cuFileBufRegister, indexed by its base
+ * address (which cuFile I/O calls must pass for registered buffers)
+ */
+struct cufile_buf
+{
+    const void *base;
+    UT_hash_handle hlink;
+};
+
+/* a batch handle with requests in flight, indexed by the handle; batch
+ * latencies are measured from the latest submission on the handle
+ */
+struct cufile_batch
+{
+    void *batch;
+    double submit_time;
+    UT_hash_handle hlink;
+};
+
+/* The cufile_runtime structure maintains necessary state for storing
+ * CUFILE records and for coordinating with darshan-core at shutdown time.
+ */
+struct cufile_runtime
+{
+    void *rec_id_hash;
+    void *fh_hash;
+    struct cufile_record_ref *summary_ref;
+    struct cufile_buf *buf_hash;
+    struct cufile_batch *batch_hash;
+    int buf_count;
+    int batch_count;
+    int rec_count;
+    int frozen; /* flag to indicate that the counters should no longer be modified */
+};
+
+static struct cufile_runtime *cufile_runtime = NULL;
+static pthread_mutex_t cufile_runtime_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int cufile_runtime_init_attempted = 0;
+static int my_rank = -1;
+
+static void cufile_runtime_initialize(
+    void);
+static struct cufile_record_ref *cufile_track_new_record(
+    darshan_record_id rec_id, const char *name);
+static struct cufile_record_ref *cufile_summary_ref(
+    void);
+static struct cufile_record_ref *cufile_handle_ref(
+    CUfileHandle_t fh);
+static void cufile_record_access(
+    struct darshan_cufile_record *rec, int rw_flag, const void *buf,
+    int64_t bytes, int64_t offset);
+static void cufile_record_merge(
+    struct darshan_cufile_record *infile,
+    struct darshan_cufile_record *inoutfile);
+#ifdef HAVE_MPI
+static void cufile_record_reduction_op(
+    void* infile_v, void* inoutfile_v, int *len, MPI_Datatype *datatype);
+static void cufile_mpi_redux(
+    void *cufile_buf, MPI_Comm mod_comm,
+    darshan_record_id *shared_recs, int shared_rec_count);
+#endif
+static void cufile_output(
+    void **cufile_buf, int *cufile_buf_sz);
+static void cufile_cleanup(
+    void);
+
+#define CUFILE_LOCK() pthread_mutex_lock(&cufile_runtime_mutex)
+#define CUFILE_UNLOCK() pthread_mutex_unlock(&cufile_runtime_mutex)
+
+#define CUFILE_PRE_RECORD() do { \
+    DARSHAN_OVERHEAD_ENTER(); \
+    if(!__darshan_disabled) { \
+        CUFILE_LOCK(); \
+        if(!cufile_runtime && !cufile_runtime_init_attempted) \
+            cufile_runtime_initialize(); \
+        if(cufile_runtime && !cufile_runtime->frozen) break; \
+        CUFILE_UNLOCK(); \
+    } \
+    return(ret); \
+} while(0)
+
+#define CUFILE_POST_RECORD() do { \
+    CUFILE_UNLOCK(); \
+    DARSHAN_OVERHEAD_EXIT(DARSHAN_CUFILE_MOD); \
+} while(0)
+
+/* variant of the above for wrappers that return nothing, which only tear
+ * down state and so have nothing to record unless the module is running
+ */
+#define CUFILE_PRE_RECORD_VOID() do { \
+    if(!__darshan_disabled) { \
+        CUFILE_LOCK(); \
+        if(cufile_runtime && !cufile_runtime->frozen) break; \
+        CUFILE_UNLOCK(); \
+    } \
+    return; \
+} while(0)
+
+#define CUFILE_RECORD_RW(__ret, __fh, __buf, __off, __rw, __tm1, __tm2) do { \
+    struct cufile_record_ref *__rec_ref; \
+    struct darshan_cufile_record *__rec; \
+    double __elapsed = (__tm2) - (__tm1); \
+    __rec_ref = cufile_handle_ref(__fh); \
+    if(!__rec_ref) break; \
+    __rec = __rec_ref->record_p; \
+    if((__ret) < 0) { \
+        __rec->counters[CUFILE_ERRORS] += 1; \
+        break; \
+    } \
+    cufile_record_access(__rec, __rw, __buf, __ret, __off); \
+    if((__rw) == CUFILE_READ) { \
+        __rec->counters[CUFILE_READS] += 1; \
+        __rec->counters[CUFILE_BYTES_READ] += (__ret); \
+        if(__rec->fcounters[CUFILE_F_READ_START_TIMESTAMP] == 0 || \
+            __rec->fcounters[CUFILE_F_READ_START_TIMESTAMP] > (__tm1)) \
+            __rec->fcounters[CUFILE_F_READ_START_TIMESTAMP] = (__tm1); \
+        __rec->fcounters[CUFILE_F_READ_END_TIMESTAMP] = (__tm2); \
+        __rec->fcounters[CUFILE_F_READ_TIME] += __elapsed; \
+        if(__rec->fcounters[CUFILE_F_MAX_READ_TIME] < __elapsed) \
+            __rec->fcounters[CUFILE_F_MAX_READ_TIME] = __elapsed; \
+    } \
+    else { \
+        __rec->counters[CUFILE_WRITES] += 1; \
+        __rec->counters[CUFILE_BYTES_WRITTEN] += (__ret); \
+        if(__rec->fcounters[CUFILE_F_WRITE_START_TIMESTAMP] == 0 || \
+            __rec->fcounters[CUFILE_F_WRITE_START_TIMESTAMP] > (__tm1)) \
+            __rec->fcounters[CUFILE_F_WRITE_START_TIMESTAMP] = (__tm1); \
+        __rec->fcounters[CUFILE_F_WRITE_END_TIMESTAMP] = (__tm2); \
+        __rec->fcounters[CUFILE_F_WRITE_TIME] += __elapsed; \
+        if(__rec->fcounters[CUFILE_F_MAX_WRITE_TIME] < __elapsed) \
+            __rec->fcounters[CUFILE_F_MAX_WRITE_TIME] = __elapsed; \
+    } \
+} while(0)
+
+/**********************************************************
+ *        Wrappers for cuFile functions of interest       *
+ **********************************************************/
+
+CUfileError_t DARSHAN_DECL(cuFileHandleRegister)(CUfileHandle_t *fh,
+    CUfileDescr_t *descr)
+{
+    CUfileError_t ret;
+    double tm1, tm2;
+    char fdpath[64];
+    char linkbuf[__DARSHAN_PATH_MAX];
+    char pathbuf[__DARSHAN_PATH_MAX];
+    char *newpath;
+    ssize_t len;
+    darshan_record_id rec_id;
+    struct cufile_record_ref *rec_ref;
+
+    MAP_OR_FAIL(cuFileHandleRegister);
+
+    tm1 = CUFILE_WTIME();
+    ret = __real_cuFileHandleRegister(fh, descr);
+    tm2 = CUFILE_WTIME();
+
+    if(ret.err != CU_FILE_SUCCESS ||
+        descr->type != CU_FILE_HANDLE_TYPE_OPAQUE_FD)
+        return(ret);
+
+    CUFILE_PRE_RECORD();
+    /* cuFile handles wrap a descriptor the application opened itself, so
+     * the file name is recovered from the descriptor
+     */
+    snprintf(fdpath, sizeof(fdpath), "/proc/self/fd/%d", descr->handle.fd);
+    len = readlink(fdpath, linkbuf, sizeof(linkbuf) - 1);
+    if(len > 0)
+    {
+        linkbuf[len] = '\0';
+        rec_id = darshan_path_record_id(linkbuf, pathbuf, sizeof(pathbuf),
+            &newpath);
+        rec_ref = darshan_lookup_record_ref(cufile_runtime->rec_id_hash,
+            &rec_id, sizeof(darshan_record_id));
+        if(!rec_ref)
+        {
+            if(!newpath)
+                newpath = darshan_clean_file_path_buf(linkbuf, pathbuf,
+                    sizeof(pathbuf));
+            if(!newpath)
+                newpath = linkbuf;
+            rec_ref = cufile_track_new_record(rec_id, newpath);
+        }
+        if(rec_ref)
+        {
+            /* handle values may be reused once deregistered */
+            darshan_delete_record_ref(&(cufile_runtime->fh_hash), fh,
+                sizeof(CUfileHandle_t));
+            darshan_add_record_ref(&(cufile_runtime->fh_hash), fh,
+                sizeof(CUfileHandle_t), rec_ref);
+            rec_ref->record_p->counters[CUFILE_HANDLE_REGISTERS] += 1;
+            rec_ref->record_p->fcounters[CUFILE_F_META_TIME] += tm2 - tm1;
+        }
+    }
+    CUFILE_POST_RECORD();
+
+    return(ret);
+}
+
+void DARSHAN_DECL(cuFileHandleDeregister)(CUfileHandle_t fh)
+{
+    double tm1, tm2;
+    struct cufile_record_ref *rec_ref;
+
+    MAP_OR_FAIL(cuFileHandleDeregister);
+
+    tm1 = CUFILE_WTIME();
+    __real_cuFileHandleDeregister(fh);
+    tm2 = CUFILE_WTIME();
+
+    CUFILE_PRE_RECORD_VOID();
+    rec_ref = darshan_delete_record_ref(&(cufile_runtime->fh_hash), &fh,
+        sizeof(CUfileHandle_t));
+    if(rec_ref)
+        rec_ref->record_p->fcounters[CUFILE_F_META_TIME] += tm2 - tm1;
+    CUFILE_UNLOCK();
+
+    return;
+}
+
+CUfileError_t DARSHAN_DECL(cuFileBufRegister)(const void *bufPtr_base,
+    size_t length, int flags)
+{
+    CUfileError_t ret;
+    double tm1, tm2;
+    struct cufile_record_ref *rec_ref;
+    struct cufile_buf *buf;
+
+    MAP_OR_FAIL(cuFileBufRegister);
+
+    tm1 = CUFILE_WTIME();
+    ret = __real_cuFileBufRegister(bufPtr_base, length, flags);
+    tm2 = CUFILE_WTIME();
+
+    CUFILE_PRE_RECORD();
+    rec_ref = cufile_summary_ref();
+    if(rec_ref)
+    {
+        rec_ref->record_p->fcounters[CUFILE_F_META_TIME] += tm2 - tm1;
+        if(ret.err != CU_FILE_SUCCESS)
+            rec_ref->record_p->counters[CUFILE_ERRORS] += 1;
+        else
+        {
+            rec_ref->record_p->counters[CUFILE_BUF_REGISTERS] += 1;
+            rec_ref->record_p->counters[CUFILE_BUF_REGISTERED_BYTES] += length;
+        }
+    }
+    if(ret.err == CU_FILE_SUCCESS)
+    {
+        HASH_FIND(hlink, cufile_runtime->buf_hash, &bufPtr_base,
+            sizeof(bufPtr_base), buf);
+        if(!buf && cufile_runtime->buf_count < CUFILE_MAX_TRACKED)
+        {
+            buf = malloc(sizeof(*buf));
+            if(buf)
+            {
+                buf->base = bufPtr_base;
+                HASH_ADD(hlink, cufile_runtime->buf_hash, base,
+                    sizeof(buf->base), buf);
+                cufile_runtime->buf_count++;
+            }
+        }
+    }
+    CUFILE_POST_RECORD();
+
+    return(ret);
+}
+
+CUfileError_t DARSHAN_DECL(cuFileBufDeregister)(const void *bufPtr_base)
+{
+    CUfileError_t ret;
+    double tm1, tm2;
+    struct cufile_record_ref *rec_ref;
+    struct cufile_buf *buf;
+
+    MAP_OR_FAIL(cuFileBufDeregister);
+
+    tm1 = CUFILE_WTIME();
+    ret = __real_cuFileBufDeregister(bufPtr_base);
+    tm2 = CUFILE_WTIME();
+
+    CUFILE_PRE_RECORD();
+    rec_ref = cufile_summary_ref();
+    if(rec_ref)
+        rec_ref->record_p->fcounters[CUFILE_F_META_TIME] += tm2 - tm1;
+    HASH_FIND(hlink, cufile_runtime->buf_hash, &bufPtr_base,
+        sizeof(bufPtr_base), buf);
+    if(buf)
+    {
+        HASH_DELETE(hlink, cufile_runtime->buf_hash, buf);
+        free(buf);
+        cufile_runtime->buf_count--;
+    }
+    CUFILE_POST_RECORD();
+
+    return(ret);
+}
+
+ssize_t DARSHAN_DECL(cuFileRead)(CUfileHandle_t fh, void *bufPtr_base,
+    size_t size, off_t file_offset, off_t bufPtr_offset)
+{
+    ssize_t ret;
+    double tm1, tm2;
+
+    MAP_OR_FAIL(cuFileRead);
+
+    tm1 = CUFILE_WTIME();
+    ret = __real_cuFileRead(fh, bufPtr_base, size, file_offset, bufPtr_offset);
+    tm2 = CUFILE_WTIME();
+
+    CUFILE_PRE_RECORD();
+    CUFILE_RECORD_RW(ret, fh, bufPtr_base, file_offset, CUFILE_READ,
+        tm1, tm2);
+    CUFILE_POST_RECORD();
+
+    return(ret);
+}
+
+ssize_t DARSHAN_DECL(cuFileWrite)(CUfileHandle_t fh, const void *bufPtr_base,
+    size_t size, off_t file_offset, off_t bufPtr_offset)
+{
+    ssize_t ret;
+    double tm1, tm2;
+
+    MAP_OR_FAIL(cuFileWrite);
+
+    tm1 = CUFILE_WTIME();
+    ret = __real_cuFileWrite(fh, bufPtr_base, size, file_offset, bufPtr_offset);
+    tm2 = CUFILE_WTIME();
+
+    CUFILE_PRE_RECORD();
+    CUFILE_RECORD_RW(ret, fh, bufPtr_base, file_offset, CUFILE_WRITE,
+        tm1, tm2);
+    CUFILE_POST_RECORD();
+
+    return(ret);
+}
+
+#if HAVE_DECL_CUFILEBATCHIOSUBMIT
+CUfileError_t DARSHAN_DECL(cuFileBatchIOSubmit)(CUfileBatchHandle_t batch_idp,
+    unsigned nr, CUfileIOParams_t *iocbp, unsigned int flags)
+{
+    CUfileError_t ret;
+    double tm1, tm2;
+    struct cufile_record_ref *sum_ref, *rec_ref;
+    struct darshan_cufile_record *rec;
+    struct cufile_batch *batch;
+    int64_t *counters;
+    unsigned i;
+
+    MAP_OR_FAIL(cuFileBatchIOSubmit);
+
+    tm1 = CUFILE_WTIME();
+    ret = __real_cuFileBatchIOSubmit(batch_idp, nr, iocbp, flags);
+    tm2 = CUFILE_WTIME();
+
+    CUFILE_PRE_RECORD();
+    sum_ref = cufile_summary_ref();
+    if(sum_ref)
+    {
+        counters = sum_ref->record_p->counters;
+        counters[CUFILE_BATCH_SUBMITS] += 1;
+        sum_ref->record_p->fcounters[CUFILE_F_BATCH_SUBMIT_TIME] += tm2 - tm1;
+        if(ret.err != CU_FILE_SUCCESS)
+            counters[CUFILE_ERRORS] += 1;
+        else
+        {
+            counters[CUFILE_BATCH_SUBMITTED] += nr;
+            if(counters[CUFILE_MAX_BATCH] < nr)
+                counters[CUFILE_MAX_BATCH] = nr;
+            if(nr <= 1)
+                counters[CUFILE_BATCH_1] += 1;
+            else if(nr < 8)
+                counters[CUFILE_BATCH_2_7] += 1;
+            else if(nr < 32)
+                counters[CUFILE_BATCH_8_31] += 1;
+            else
+                counters[CUFILE_BATCH_32_PLUS] += 1;
+        }
+    }
+    if(ret.err == CU_FILE_SUCCESS)
+    {
+        for(i = 0; i < nr; i++)
+        {
+            rec_ref = cufile_handle_ref(iocbp[i].fh);
+            if(!rec_ref)
+                continue;
+            rec = rec_ref->record_p;
+            if(iocbp[i].opcode == CUFILE_READ)
+            {
+                rec->counters[CUFILE_BATCH_READS] += 1;
+                rec->counters[CUFILE_BATCH_BYTES_READ] +=
+                    iocbp[i].u.batch.size;
+            }
+            else
+            {
+                rec->counters[CUFILE_BATCH_WRITES] += 1;
+                rec->counters[CUFILE_BATCH_BYTES_WRITTEN] +=
+                    iocbp[i].u.batch.size;
+            }
+            cufile_record_access(rec, iocbp[i].opcode,
+                iocbp[i].u.batch.devPtr_base, iocbp[i].u.batch.size,
+                iocbp[i].u.batch.file_offset);
+        }
+
+        HASH_FIND(hlink, cufile_runtime->batch_hash, &batch_idp,
+            sizeof(batch_idp), batch);
+        if(!batch && cufile_runtime->batch_count < CUFILE_MAX_TRACKED)
+        {
+            batch = malloc(sizeof(*batch));
+            if(batch)
+            {
+                batch->batch = batch_idp;
+                HASH_ADD(hlink, cufile_runtime->batch_hash, batch,
+                    sizeof(batch->batch), batch);
+                cufile_runtime->batch_count++;
+            }
+        }
+        if(batch)
+            batch->submit_time = tm1;
+    }
+    CUFILE_POST_RECORD();
+
+    return(ret);
+}
+
+CUfileError_t DARSHAN_DECL(cuFileBatchIOGetStatus)(CUfileBatchHandle_t batch_idp,
+    unsigned min_nr, unsigned *nr, CUfileIOEvents_t *iocbp,
+    struct timespec *timeout)
+{
+    CUfileError_t ret;
+    double tm1, tm2;
+    double latency;
+    struct cufile_record_ref *sum_ref;
+    struct darshan_cufile_record *rec;
+    struct cufile_batch *batch;
+    unsigned i;
+
+    MAP_OR_FAIL(cuFileBatchIOGetStatus);
+
+    tm1 = CUFILE_WTIME();
+    ret = __real_cuFileBatchIOGetStatus(batch_idp, min_nr, nr, iocbp, timeout);
+    tm2 = CUFILE_WTIME();
+
+    CUFILE_PRE_RECORD();
+    sum_ref = cufile_summary_ref();
+    if(sum_ref)
+    {
+        rec = sum_ref->record_p;
+        rec->counters[CUFILE_BATCH_POLLS] += 1;
+        rec->fcounters[CUFILE_F_BATCH_POLL_TIME] += tm2 - tm1;
+        if(ret.err != CU_FILE_SUCCESS)
+            rec->counters[CUFILE_ERRORS] += 1;
+        else
+        {
+            HASH_FIND(hlink, cufile_runtime->batch_hash, &batch_idp,
+                sizeof(batch_idp), batch);
+            for(i = 0; i < *nr; i++)
+            {
+                if(iocbp[i].status == CUFILE_FAILED)
+                {
+                    rec->counters[CUFILE_ERRORS] += 1;
+                    continue;
+                }
+                if(iocbp[i].status != CUFILE_COMPLETE)
+                    continue;
+                rec->counters[CUFILE_BATCH_COMPLETIONS] += 1;
+                if(!batch)
+                    continue;
+                latency = tm2 - batch->submit_time;
+                rec->fcounters[CUFILE_F_BATCH_LATENCY] += latency;
+                if(rec->fcounters[CUFILE_F_MAX_BATCH_LATENCY] < latency)
+                    rec->fcounters[CUFILE_F_MAX_BATCH_LATENCY] = latency;
+            }
+        }
+    }
+    CUFILE_POST_RECORD();
+
+    return(ret);
+}
+
+void DARSHAN_DECL(cuFileBatchIODestroy)(CUfileBatchHandle_t batch_idp)
+{
+    struct cufile_batch *batch;
+
+    MAP_OR_FAIL(cuFileBatchIODestroy);
+
+    __real_cuFileBatchIODestroy(batch_idp);
+
+    CUFILE_PRE_RECORD_VOID();
+    HASH_FIND(hlink, cufile_runtime->batch_hash, &batch_idp,
+        sizeof(batch_idp), batch);
+    if(batch)
+    {
+        HASH_DELETE(hlink, cufile_runtime->batch_hash, batch);
+        free(batch);
+        cufile_runtime->batch_count--;
+    }
+    CUFILE_UNLOCK();
+
+    return;
+}
+#endif /* HAVE_DECL_CUFILEBATCHIOSUBMIT */
+
+/**********************************************************
+ * Internal functions for manipulating CUFILE module state *
+ **********************************************************/
+
+static void cufile_runtime_initialize()
+{
+    int ret;
+    size_t cufile_rec_count;
+    darshan_module_funcs mod_funcs = {
+#ifdef HAVE_MPI
+    .mod_redux_func = &cufile_mpi_redux,
+#endif
+    .mod_output_func = &cufile_output,
+    .mod_cleanup_func = &cufile_cleanup
+    };
+
+    /* don't do anything if already initialized */
+    if(cufile_runtime || cufile_runtime_init_attempted)
+        return;
+    cufile_runtime_init_attempted = 1;
+
+    /* try and store a default number of records for this module */
+    cufile_rec_count = DARSHAN_DEF_MOD_REC_COUNT;
+
+    /* register the CUFILE module with darshan core */
+    ret = darshan_core_register_module(
+        DARSHAN_CUFILE_MOD,
+        mod_funcs,
+        sizeof(struct darshan_cufile_record),
+        &cufile_rec_count,
+        &my_rank,
+        NULL);
+    if(ret < 0)
+        return;
+
+    cufile_runtime = malloc(sizeof(*cufile_runtime));
+    if(!cufile_runtime)
+    {
+        darshan_core_unregister_module(DARSHAN_CUFILE_MOD);
+        return;
+    }
+    memset(cufile_runtime, 0, sizeof(*cufile_runtime));
+
+    return;
+}
+
+static struct cufile_record_ref *cufile_track_new_record(
+    darshan_record_id rec_id, const char *name)
+{
+    struct darshan_cufile_record *record_p = NULL;
+    struct cufile_record_ref *rec_ref = NULL;
+    int ret;
+
+    rec_ref = malloc(sizeof(*rec_ref));
+    if(!rec_ref)
+        return(NULL);
+    memset(rec_ref, 0, sizeof(*rec_ref));
+
+    /* add a reference to this record */
+    ret = darshan_add_record_ref(&(cufile_runtime->rec_id_hash), &rec_id,
+        sizeof(darshan_record_id), rec_ref);
+    if(ret == 0)
+    {
+        free(rec_ref);
+        return(NULL);
+    }
+
+    /* register the actual record with darshan-core so it is persisted in
+     * the log file
+     */
+    record_p = darshan_core_register_record(
+        rec_id,
+        name,
+        DARSHAN_CUFILE_MOD,
+        sizeof(struct darshan_cufile_record),
+        NULL);
+
+    if(!record_p)
+    {
+        darshan_delete_record_ref(&(cufile_runtime->rec_id_hash),
+            &rec_id, sizeof(darshan_record_id));
+        free(rec_ref);
+        return(NULL);
+    }
+
+    /* registering this record was successful, so initialize some fields */
+    record_p->base_rec.id = rec_id;
+    record_p->base_rec.rank = my_rank;
+    rec_ref->record_p = record_p;
+    cufile_runtime->rec_count++;
+
+    return(rec_ref);
+}
+
+/* find or create the summary record */
+static struct cufile_record_ref *cufile_summary_ref()
+{
+    darshan_record_id rec_id;
+
+    if(!cufile_runtime->summary_ref)
+    {
+        rec_id = darshan_core_gen_record_id(CUFILE_SUMMARY_NAME);
+        cufile_runtime->summary_ref =
+            cufile_track_new_record(rec_id, CUFILE_SUMMARY_NAME);
+    }
+
+    return(cufile_runtime->summary_ref);
+}
+
+/* find the record of the file behind cuFile handle 'fh', falling back to
+ * the summary record for handles registered before Darshan was watching
+ * (or whose file was excluded)
+ */
+static struct cufile_record_ref *cufile_handle_ref(CUfileHandle_t fh)
+{
+    struct cufile_record_ref *rec_ref;
+
+    rec_ref = darshan_lookup_record_ref(cufile_runtime->fh_hash, &fh,
+        sizeof(CUfileHandle_t));
+    if(!rec_ref)
+        rec_ref = cufile_summary_ref();
+
+    return(rec_ref);
+}
+
+/* account an access of 'bytes' bytes at 'offset' through buffer 'buf' in
+ * the size histograms, offset extents and buffer path counters of 'rec'
+ */
+static void cufile_record_access(struct darshan_cufile_record *rec,
+    int rw_flag, const void *buf, int64_t bytes, int64_t offset)
+{
+    struct cufile_buf *reg_buf;
+
+    if(rw_flag == CUFILE_READ)
+    {
+        DARSHAN_BUCKET_INC(&(rec->counters[CUFILE_SIZE_READ_0_100]), bytes);
+        if(bytes > 0 && rec->counters[CUFILE_MAX_BYTE_READ] < offset + bytes - 1)
+            rec->counters[CUFILE_MAX_BYTE_READ] = offset + bytes - 1;
+    }
+    else
+    {
+        DARSHAN_BUCKET_INC(&(rec->counters[CUFILE_SIZE_WRITE_0_100]), bytes);
+        if(bytes > 0 && rec->counters[CUFILE_MAX_BYTE_WRITTEN] < offset + bytes - 1)
+            rec->counters[CUFILE_MAX_BYTE_WRITTEN] = offset + bytes - 1;
+    }
+
+    HASH_FIND(hlink, cufile_runtime->buf_hash, &buf, sizeof(buf), reg_buf);
+    if(reg_buf)
+    {
+        rec->counters[CUFILE_REG_BUF_OPS] += 1;
+        rec->counters[CUFILE_REG_BUF_BYTES] += bytes;
+    }
+    else
+    {
+        rec->counters[CUFILE_UNREG_BUF_OPS] += 1;
+        rec->counters[CUFILE_UNREG_BUF_BYTES] += bytes;
+    }
+
+    return;
+}
+
+/* combine the counters of 'infile' into 'inoutfile' */
+static void cufile_record_merge(struct darshan_cufile_record *infile,
+    struct darshan_cufile_record *inoutfile)
+{
+    int i;
+
+    for(i = 0; i < CUFILE_NUM_INDICES; i++)
+    {
+        switch(i)
+        {
+            case CUFILE_MAX_BYTE_READ:
+            case CUFILE_MAX_BYTE_WRITTEN:
+            case CUFILE_MAX_BATCH:
+                /* max */
+                if(inoutfile->counters[i] < infile->counters[i])
+                    inoutfile->counters[i] = infile->counters[i];
+                break;
+            default:
+                /* sum */
+                inoutfile->counters[i] += infile->counters[i];
+                break;
+        }
+    }
+
+    for(i = 0; i < CUFILE_F_NUM_INDICES; i++)
+    {
+        switch(i)
+        {
+            case CUFILE_F_READ_START_TIMESTAMP:
+            case CUFILE_F_WRITE_START_TIMESTAMP:
+                /* min non-zero */
+                if(infile->fcounters[i] > 0 &&
+                    (inoutfile->fcounters[i] == 0 ||
+                    inoutfile->fcounters[i] > infile->fcounters[i]))
+                    inoutfile->fcounters[i] = infile->fcounters[i];
+                break;
+            case CUFILE_F_READ_END_TIMESTAMP:
+            case CUFILE_F_WRITE_END_TIMESTAMP:
+            case CUFILE_F_MAX_READ_TIME:
+            case CUFILE_F_MAX_WRITE_TIME:
+            case CUFILE_F_MAX_BATCH_LATENCY:
+                /* max */
+                if(inoutfile->fcounters[i] < infile->fcounters[i])
+                    inoutfile->fcounters[i] = infile->fcounters[i];
+                break;
+            default:
+                /* sum */
+                inoutfile->fcounters[i] += infile->fcounters[i];
+                break;
+        }
+    }
+
+    return;
+}
+
+#ifdef HAVE_MPI
+static void cufile_record_reduction_op(void* infile_v, void* inoutfile_v,
+    int *len, MPI_Datatype *datatype)
+{
+    struct darshan_cufile_record *infile = infile_v;
+    struct darshan_cufile_record *inoutfile = inoutfile_v;
+    int i;
+
+    for(i=0; i<*len; i++)
+    {
+        cufile_record_merge(infile, inoutfile);
+        inoutfile->base_rec.rank = -1;
+        infile++;
+        inoutfile++;
+    }
+
+    return;
+}
+#endif
+
+/********************************************************************************
+ * Functions exported by this module for coordinating with darshan-core *
+ ********************************************************************************/
+
+#ifdef HAVE_MPI
+static void cufile_mpi_redux(
+    void *cufile_buf,
+    MPI_Comm mod_comm,
+    darshan_record_id *shared_recs,
+    int shared_rec_count)
+{
+    int cufile_rec_count;
+    struct cufile_record_ref *rec_ref;
+    struct darshan_cufile_record *cufile_rec_buf =
+        (struct darshan_cufile_record *)cufile_buf;
+    struct darshan_cufile_record *red_send_buf = NULL;
+    struct darshan_cufile_record *red_recv_buf = NULL;
+    int ret;
+    int i;
+
+    CUFILE_LOCK();
+    assert(cufile_runtime);
+
+    /* no more updates once the records are rearranged below */
+    cufile_runtime->frozen = 1;
+
+    cufile_rec_count = cufile_runtime->rec_count;
+
+    /* necessary initialization of shared records */
+    for(i = 0; i < shared_rec_count; i++)
+    {
+        rec_ref = darshan_lookup_record_ref(cufile_runtime->rec_id_hash,
+            &shared_recs[i], sizeof(darshan_record_id));
+        assert(rec_ref);
+
+        rec_ref->record_p->base_rec.rank = -1;
+    }
+
+    /* sort the array of records descending by rank so that we get all of
+     * the shared records (marked by rank -1) in a contiguous portion at end
+     * of the array
+     */
+    darshan_record_sort(cufile_rec_buf, cufile_rec_count,
+        sizeof(struct darshan_cufile_record));
+
+    /* make *send_buf point to the shared records at the end of sorted array */
+    red_send_buf = &(cufile_rec_buf[cufile_rec_count-shared_rec_count]);
+
+    /* allocate memory for the reduction output on rank 0 */
+    if(my_rank == 0)
+    {
+        red_recv_buf = malloc(shared_rec_count *
+            sizeof(struct darshan_cufile_record));
+        if(!red_recv_buf)
+        {
+            CUFILE_UNLOCK();
+            return;
+        }
+    }
+
+    /* reduce shared CUFILE records */
+    ret = darshan_shared_record_reduce(mod_comm, red_send_buf, red_recv_buf,
+        shared_rec_count, sizeof(struct darshan_cufile_record),
+        cufile_record_reduction_op, NULL, 0);
+
+    /* update module state to account for shared record reduction */
+    if(ret < 0)
+    {
+        free(red_recv_buf);
+    }
+    else if(my_rank == 0)
+    {
+        /* overwrite local shared records with globally reduced records */
+        int tmp_ndx = cufile_rec_count - shared_rec_count;
+        memcpy(&(cufile_rec_buf[tmp_ndx]), red_recv_buf,
+            shared_rec_count * sizeof(struct darshan_cufile_record));
+        free(red_recv_buf);
+    }
+    else
+    {
+        /* drop shared records on non-zero ranks */
+        cufile_runtime->rec_count -= shared_rec_count;
+    }
+
+    CUFILE_UNLOCK();
+    return;
+}
+#endif
+
+static void cufile_output(
+    void **cufile_buf,
+    int *cufile_buf_sz)
+{
+    CUFILE_LOCK();
+    assert(cufile_runtime);
+
+    *cufile_buf_sz = cufile_runtime->rec_count *
+        sizeof(struct darshan_cufile_record);
+
+    cufile_runtime->frozen = 1;
+
+    CUFILE_UNLOCK();
+    return;
+}
+
+static void cufile_cleanup()
+{
+    struct cufile_buf *buf, *tmp_buf;
+    struct cufile_batch *batch, *tmp_batch;
+
+    CUFILE_LOCK();
+    assert(cufile_runtime);
+
+    HASH_ITER(hlink, cufile_runtime->buf_hash, buf, tmp_buf)
+    {
+        HASH_DELETE(hlink, cufile_runtime->buf_hash, buf);
+        free(buf);
+    }
+    HASH_ITER(hlink, cufile_runtime->batch_hash, batch, tmp_batch)
+    {
+        HASH_DELETE(hlink, cufile_runtime->batch_hash, batch);
+        free(batch);
+    }
+
+    /* cleanup internal structures used for instrumenting; the handle
+     * references share the record references freed with the id hash
+     */
+    darshan_clear_record_refs(&(cufile_runtime->fh_hash), 0);
+    darshan_clear_record_refs(&(cufile_runtime->rec_id_hash), 1);
+
+    free(cufile_runtime);
+    cufile_runtime = NULL;
+    cufile_runtime_init_attempted = 0;
+
+    CUFILE_UNLOCK();
+    return;
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
@@ -23,11 +23,13 @@
 #include <errno.h>
 #include <sys/uio.h>
 #include <sys/mman.h>
+#include <sys/syscall.h>
 #include <search.h>
 #include <assert.h>
 #include <libgen.h>
 #include <pthread.h>
 #include <regex.h>
+#include <limits.h>
 
 #include "utlist.h"
 #include "uthash.h"
@@ -54,9 +56,166 @@ typedef int64_t off64_t;
  */
 #define DXT_DEF_RECORD_SIZE 1024
 
-/* initial size of read/write trace buffer (in number of segments) */
-/* NOTE: when this size is exceeded, the buffer size is doubled */
-#define IO_TRACE_BUF_SIZE       64
+/* number of trace segments held by each chunk of a read/write trace */
+#define DXT_SEG_CHUNK_SEGS      64
+
+/* A file's read or write trace is held in a linked list of fixed-size
+ * segment chunks. Chunks are allocated from a per-module pool, which DXT
+ * accounts against its memory budget itself, and are returned to the pool
+ * (rather than freed) when a trace is discarded or spilled.
+ */
+struct dxt_seg_chunk
+{
+    struct dxt_seg_chunk *next;
+    segment_info segs[DXT_SEG_CHUNK_SEGS];
+};
+
+/* with a memory policy set for Darshan's buffers (see
+ * darshan_core_mem_alloc()), segment chunks are carved from slabs of this
+ * size rather than allocated individually, and are only released along
+ * with their slabs when the module is cleaned up. the first
+ * DXT_SEG_SLAB_HDR bytes of each slab link it into its module's list.
+ */
+#define DXT_SEG_SLAB_SIZE DARSHAN_HUGE_PAGE_SIZE
+#define DXT_SEG_SLAB_HDR 64
+
+struct dxt_seg_slab
+{
+    struct dxt_seg_slab *next;
+};
+
+/* maximum size of a read/write trace (in number of segments) held in memory
+ * in spill mode; full traces are appended to the spill file and their chunks
+ * reused instead of being grown past this size
+ */
+#define DXT_SPILL_CHUNK_SEGS    1024
+
+/* maximum number of spilled buffers queued for the spill thread; past this,
+ * the tracing thread writes buffers to the spill file itself
+ */
+#define DXT_SPILL_MAX_PENDING   16
+
+/* location of a run of a file's trace segments in the spill file */
+struct dxt_spill_chunk
+{
+    int64_t off;
+    int64_t count;
+    struct dxt_spill_chunk *prev;
+    struct dxt_spill_chunk *next;
+};
+
+/* a spilled trace waiting to be written by the spill thread, after which
+ * its chunks are returned to the pool of 'runtime'
+ */
+struct dxt_spill_job
+{
+    struct dxt_seg_chunk *chunks;
+    int64_t count;
+    int64_t off;
+    struct dxt_runtime *runtime;
+    struct dxt_spill_job *next;
+};
+
+/* a file's read or write trace. 'cur' is the chunk that holds (or, if 'pos'
+ * is at a chunk boundary, precedes) the segment at logical index 'pos',
+ * where the next segment is stored. in ring buffer mode, 'pos' wraps back to
+ * the first chunk once the ring is full, and then also indexes the oldest
+ * segment.
+ */
+struct dxt_trace
+{
+    struct dxt_seg_chunk *chunks;
+    struct dxt_seg_chunk *cur;
+    int64_t pos;
+
+    /* segments already appended to the spill file (spill mode) */
+    struct dxt_spill_chunk *spilled;
+    int64_t spill_count;
+};
+
+/* per-process spill file state, shared by all DXT modules. 'size' is only
+ * modified with the DXT lock held, while the job queue and error flag are
+ * protected by 'mutex'.
+ */
+struct dxt_spill
+{
+    char *dir;
+    int fd;
+    int64_t size;
+    int err;
+    pid_t pid;
+    pthread_t thread;
+    int thread_running;
+    int shutdown;
+    struct dxt_spill_job *jobs;
+    int pending;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    segment_info *read_buf;
+};
+
+/* a single thread's private trace of a file's POSIX operations, used when
+ * DXT-POSIX traces into per-thread buffers. thread traces are linked to the
+ * file's dxt_file_record_ref, and are merged by start time with the file's
+ * shared trace (holding any operations traced before a thread started using
+ * its own buffers, or after they were frozen) at output time.
+ */
+struct dxt_thread_trace
+{
+    darshan_record_id rec_id;
+    struct dxt_trace write_trace;
+    struct dxt_trace read_trace;
+    int64_t write_count;
+    int64_t read_count;
+    struct dxt_thread_trace *next; /* next thread trace of the same file */
+};
+
+/* The dxt_thread_state structure holds per-thread DXT state: the thread id
+ * that segments recorded by the thread are tagged with and, for DXT-POSIX
+ * per-thread tracing, the thread's private traces (indexed by record id in
+ * 'trace_hash', with the most recently used one cached in 'last').
+ *
+ * RATIONALE: the POSIX module already serializes operations on its records
+ * (with its module lock, or a thread's shard mutex when thread sharding is
+ * enabled), so tracing each POSIX operation into the file's shared trace
+ * needlessly adds a second, module-wide lock and hash lookup on every
+ * operation of a multithreaded rank. With per-thread traces, each thread
+ * only takes its own uncontended 'mutex', and the DXT lock is only taken
+ * when a trace starts using a new segment chunk.
+ *
+ * NOTE: thread states are never freed, as threads may hold references to
+ * them across module cleanup and reinitialization.
+ */
+struct dxt_thread_state
+{
+    pthread_mutex_t mutex;
+    int64_t tid;
+    void *trace_hash;
+    struct dxt_thread_trace *last;
+    int frozen; /* flag to indicate the thread's traces have been frozen */
+    struct dxt_thread_state *next;
+};
+
+/* state of the compact encoding of a record's trace segments: the
+ * previous segment of the write or read list being encoded, and the time
+ * range (in ticks) of all of the record's segments encoded so far
+ */
+struct dxt_enc_state
+{
+    int64_t prev_end;
+    int64_t prev_start;
+    int64_t prev_thread;
+    int64_t first_start;
+    int64_t last_end;
+};
+
+/* position of the next segment to merge from one of a file's traces */
+struct dxt_seg_cursor
+{
+    struct dxt_seg_chunk *chunk;
+    int64_t pos;
+    int64_t left;
+};
 
 /* The dxt_file_record_ref structure maintains necessary runtime metadata
  * for the DXT file record (dxt_file_record structure, defined in
@@ -75,11 +234,21 @@ struct dxt_file_record_ref
 {
     struct dxt_file_record *file_rec;
 
-    int64_t write_available_buf;
-    int64_t read_available_buf;
+    struct dxt_trace write_trace;
+    struct dxt_trace read_trace;
 
-    segment_info *write_traces;
-    segment_info *read_traces;
+    /* number of POSIX operations traced before online trigger evaluation */
+    int64_t trigger_ops;
+    /* set once a file fails the online triggers and is no longer traced */
+    int untraced;
+    /* number of STDIO operations traced, and how many of those were small
+     * accesses; the STDIO module has no access size counters to evaluate
+     * triggers against, so DXT-STDIO keeps its own
+     */
+    int64_t total_ops;
+    int64_t small_ops;
+    /* private traces of this file recorded by individual threads */
+    struct dxt_thread_trace *thread_traces;
 };
 
 /* The dxt_runtime structure maintains necessary state for storing
@@ -89,46 +258,163 @@ struct dxt_file_record_ref
 struct dxt_runtime
 {
     void *rec_id_hash;
+    void *arena;
     int file_rec_count;
     size_t mem_allocated;
     size_t mem_used;
+    struct dxt_seg_chunk *free_chunks; /* pool of unused segment chunks */
+    struct dxt_seg_slab *slabs; /* slabs the pool's chunks are carved from */
+    char *slab_p;
+    size_t slab_avail;
+    int partial; /* flag to indicate that trace segments were lost */
     char *record_buf;
     int record_buf_size;
+    int ring_segs; /* per-file trace buffer size in ring buffer mode, or 0 */
+    size_t trigger_warmup; /* ops per file before online trigger evaluation, or 0 */
+    struct dxt_trigger triggers[2];
+    int trigger_count;
+    int spill; /* flag to indicate that full trace buffers are spilled */
+    int64_t spill_segs; /* number of segments currently held in the spill file */
+    size_t spill_enc_left; /* output space left for encoding spilled segments */
     int frozen; /* flag to indicate that the counters should no longer be modified */
 };
 
 /* internal helper routines */
-static void check_wr_trace_buf(
-    struct dxt_file_record_ref *rec_ref, darshan_module_id mod_id,
+static segment_info *dxt_trace_next_seg(
+    struct dxt_trace *trace, int64_t *count, int64_t *dropped,
+    darshan_module_id mod_id, struct dxt_runtime *runtime);
+static struct dxt_seg_chunk *dxt_chunk_alloc(
+    struct dxt_runtime *runtime);
+static void dxt_chunk_release(
+    struct dxt_runtime *runtime, struct dxt_seg_chunk *chunks);
+static void dxt_chunk_free(
+    struct dxt_seg_chunk *chunks);
+static struct dxt_seg_chunk *dxt_slab_chunk_alloc(
     struct dxt_runtime *runtime);
-static void check_rd_trace_buf(
-    struct dxt_file_record_ref *rec_ref, darshan_module_id mod_id,
+static void dxt_slabs_free(
     struct dxt_runtime *runtime);
+static int dxt_ring_segs(
+    size_t mem_allocated);
+static unsigned char *dxt_encode_seg(
+    unsigned char *buf, segment_info *seg, struct dxt_enc_state *st);
+static unsigned char *dxt_encode_trace_segs(
+    unsigned char *buf, struct dxt_trace *trace, int64_t count,
+    int64_t ring_segs, struct dxt_enc_state *st);
+static unsigned char *dxt_encode_merged_segs(
+    unsigned char *buf, struct dxt_trace *trace, int64_t count,
+    struct dxt_thread_trace *thread_traces, int write_flag,
+    struct dxt_enc_state *st);
+static unsigned char *dxt_encode_spilled_segs(
+    unsigned char *buf, struct dxt_spill_chunk *spilled, int64_t *count,
+    int64_t *dropped, struct dxt_runtime *runtime, struct dxt_enc_state *st);
+static size_t dxt_record_buf_bound(
+    struct dxt_runtime *runtime);
+static int dxt_posix_trigger_satisfied(
+    struct dxt_trigger *trigger, struct darshan_posix_file *psx_file);
+static void dxt_posix_check_online_triggers(
+    struct dxt_file_record_ref *rec_ref);
+static int dxt_stdio_trigger_satisfied(
+    struct dxt_trigger *trigger, struct dxt_file_record_ref *rec_ref);
+static void dxt_stdio_count_op(
+    struct dxt_file_record_ref *rec_ref, int64_t length);
+static void dxt_release_trace_bufs(
+    struct dxt_file_record_ref *rec_ref, struct dxt_runtime *runtime);
+static void dxt_spill_init(
+    struct dxt_runtime *runtime);
+static int dxt_spill_open(
+    void);
+static void dxt_spill_trace(
+    struct dxt_trace *trace, int64_t *count, struct dxt_runtime *runtime);
+static void *dxt_spill_thread(
+    void *arg);
+static void dxt_spill_write_job(
+    struct dxt_spill_job *job);
+static void dxt_spill_drain(
+    void);
+static void dxt_spill_finalize(
+    void);
+static void dxt_free_spill_chunks(
+    struct dxt_spill_chunk **spilled);
+static void dxt_thread_init(
+    void);
+static int64_t dxt_gettid(
+    void);
+static struct dxt_thread_state *dxt_thread_get_state(
+    void);
+static int64_t dxt_thread_id(
+    void);
+static int dxt_posix_thread_trace(
+    darshan_record_id rec_id, int write_flag, int64_t offset,
+    int64_t length, double start_time, double end_time);
+static struct dxt_thread_trace *dxt_posix_track_thread_trace(
+    struct dxt_thread_state *state, darshan_record_id rec_id);
+static void dxt_posix_freeze_thread_traces(
+    void);
 static struct dxt_file_record_ref *dxt_posix_track_new_file_record(
     darshan_record_id rec_id);
 static struct dxt_file_record_ref *dxt_mpiio_track_new_file_record(
     darshan_record_id rec_id);
+static struct dxt_file_record_ref *dxt_stdio_track_new_file_record(
+    darshan_record_id rec_id);
+static void dxt_free_record_data(
+    void *rec_ref_p, void *user_ptr);
+static void dxt_serialize_record(
+    struct dxt_file_record_ref *rec_ref, struct dxt_runtime *runtime);
 
 /* DXT output/cleanup routines for darshan-core */
 static void dxt_posix_output(
     void **dxt_buf, int *dxt_buf_sz);
 static void dxt_mpiio_output(
     void **dxt_buf, int *dxt_buf_sz);
+static void dxt_stdio_output(
+    void **dxt_buf, int *dxt_buf_sz);
 static void dxt_posix_cleanup(
     void);
 static void dxt_mpiio_cleanup(
     void);
+static void dxt_stdio_cleanup(
+    void);
 
 /* POSIX module helper for filtering DXT trace records */
 extern struct darshan_posix_file *darshan_posix_rec_id_to_file(
     darshan_record_id rec_id);
 
+/* we need access to the underlying POSIX calls (defined in POSIX module) to
+ * manage the spill file without instrumenting it
+ */
+#ifdef DARSHAN_PRELOAD
+extern int (*__real_open)(const char *path, int flags, ...);
+extern ssize_t (*__real_pread)(int fd, void *buf, size_t count, off_t offset);
+extern ssize_t (*__real_pwrite)(int fd, const void *buf, size_t count, off_t offset);
+extern int (*__real_close)(int fd);
+#else
+extern int __real_open(const char *path, int flags, ...);
+extern ssize_t __real_pread(int fd, void *buf, size_t count, off_t offset);
+extern ssize_t __real_pwrite(int fd, const void *buf, size_t count, off_t offset);
+extern int __real_close(int fd);
+#endif
+
 static struct dxt_runtime *dxt_posix_runtime = NULL;
 static struct dxt_runtime *dxt_mpiio_runtime = NULL;
+static struct dxt_runtime *dxt_stdio_runtime = NULL;
+int dxt_posix_runtime_enabled = 0;
+int dxt_mpiio_runtime_enabled = 0;
+int dxt_stdio_runtime_enabled = 0;
+static struct dxt_spill *dxt_spill = NULL;
 static pthread_mutex_t dxt_runtime_mutex =
             PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
 
 static int dxt_my_rank = -1;
+/* carve segment chunks from slabs (see DXT_SEG_SLAB_SIZE) */
+static int dxt_use_slabs = 0;
+
+/* per-thread state is kept outside of the module runtimes, as threads may
+ * hold references to their state across module cleanup and reinitialization
+ */
+static int dxt_thread_key_created = 0;
+static pthread_key_t dxt_thread_key;
+static struct dxt_thread_state *dxt_thread_list = NULL;
+static int dxt_posix_thread_traces = 0;
 
 #define DXT_LOCK() pthread_mutex_lock(&dxt_runtime_mutex)
 #define DXT_UNLOCK() pthread_mutex_unlock(&dxt_runtime_mutex)
@@ -175,6 +461,24 @@ void dxt_posix_runtime_initialize()
     memset(dxt_posix_runtime, 0, sizeof(*dxt_posix_runtime));
     dxt_posix_runtime->mem_used = 0;
     dxt_posix_runtime->mem_allocated = dxt_psx_rec_count * DXT_DEF_RECORD_SIZE;
+    dxt_posix_runtime->ring_segs = dxt_ring_segs(dxt_posix_runtime->mem_allocated);
+    dxt_use_slabs = darshan_core_mem_policy_enabled();
+    dxt_spill_init(dxt_posix_runtime);
+    dxt_thread_init();
+    /* POSIX counters are split across per-thread shards until shutdown, so
+     * triggers can only be evaluated online when sharding is disabled
+     */
+    if(!darshan_core_thread_shards_enabled())
+        dxt_posix_runtime->trigger_warmup = darshan_core_dxt_online_triggers(
+            dxt_posix_runtime->triggers, &dxt_posix_runtime->trigger_count);
+    /* with thread sharding, POSIX operations are also traced into per-thread
+     * buffers, unless the traces need to be bounded (ring buffer mode) or
+     * spilled as a whole
+     */
+    dxt_posix_thread_traces = darshan_core_thread_shards_enabled() &&
+        dxt_thread_key_created && !dxt_posix_runtime->ring_segs &&
+        !dxt_posix_runtime->spill;
+    dxt_posix_runtime_enabled = 1;
     DXT_UNLOCK();
 
     return;
@@ -217,6 +521,63 @@ void dxt_mpiio_runtime_initialize()
     memset(dxt_mpiio_runtime, 0, sizeof(*dxt_mpiio_runtime));
     dxt_mpiio_runtime->mem_used = 0;
     dxt_mpiio_runtime->mem_allocated = dxt_mpiio_rec_count * DXT_DEF_RECORD_SIZE;
+    dxt_mpiio_runtime->ring_segs = dxt_ring_segs(dxt_mpiio_runtime->mem_allocated);
+    dxt_use_slabs = darshan_core_mem_policy_enabled();
+    dxt_spill_init(dxt_mpiio_runtime);
+    dxt_thread_init();
+    dxt_mpiio_runtime_enabled = 1;
+    DXT_UNLOCK();
+
+    return;
+}
+
+void dxt_stdio_runtime_initialize()
+{
+    /* calculate how many "records" to request from Darshan core using DXT's
+     * configured max memory consumption and the default record size
+     */
+    size_t dxt_stdio_rec_count = DXT_IO_TRACE_MEM_MAX / DXT_DEF_RECORD_SIZE;
+    darshan_module_funcs mod_funcs = {
+#ifdef HAVE_MPI
+    .mod_redux_func = NULL,
+#endif
+    .mod_output_func = &dxt_stdio_output,
+    .mod_cleanup_func = &dxt_stdio_cleanup
+    };
+    int ret;
+
+    /* register the DXT module with darshan core */
+    ret = darshan_core_register_module(
+        DXT_STDIO_MOD,
+        mod_funcs,
+        DXT_DEF_RECORD_SIZE,
+        &dxt_stdio_rec_count,
+        &dxt_my_rank,
+        NULL);
+    if(ret < 0)
+        return;
+
+    DXT_LOCK();
+    dxt_stdio_runtime = malloc(sizeof(*dxt_stdio_runtime));
+    if(!dxt_stdio_runtime)
+    {
+        darshan_core_unregister_module(DXT_STDIO_MOD);
+        DXT_UNLOCK();
+        return;
+    }
+    memset(dxt_stdio_runtime, 0, sizeof(*dxt_stdio_runtime));
+    dxt_stdio_runtime->mem_used = 0;
+    dxt_stdio_runtime->mem_allocated = dxt_stdio_rec_count * DXT_DEF_RECORD_SIZE;
+    dxt_stdio_runtime->ring_segs = dxt_ring_segs(dxt_stdio_runtime->mem_allocated);
+    dxt_use_slabs = darshan_core_mem_policy_enabled();
+    dxt_spill_init(dxt_stdio_runtime);
+    dxt_thread_init();
+    /* STDIO triggers are evaluated against counters kept by DXT itself, so
+     * unlike POSIX they can be evaluated online even with sharding enabled
+     */
+    dxt_stdio_runtime->trigger_warmup = darshan_core_dxt_online_triggers(
+        dxt_stdio_runtime->triggers, &dxt_stdio_runtime->trigger_count);
+    dxt_stdio_runtime_enabled = 1;
     DXT_UNLOCK();
 
     return;
@@ -227,6 +588,11 @@ void dxt_posix_write(darshan_record_id rec_id, int64_t offset,
 {
     struct dxt_file_record_ref* rec_ref = NULL;
     struct dxt_file_record *file_rec;
+    segment_info *seg;
+
+    if(dxt_posix_thread_traces && dxt_posix_thread_trace(rec_id, 1, offset,
+        length, start_time, end_time))
+        return;
 
     DXT_LOCK();
 
@@ -249,20 +615,38 @@ void dxt_posix_write(darshan_record_id rec_id, int64_t offset,
         }
     }
 
+    if(rec_ref->untraced)
+    {
+        DXT_UNLOCK();
+        return;
+    }
+
+    if(dxt_posix_runtime->trigger_warmup &&
+        ++rec_ref->trigger_ops == dxt_posix_runtime->trigger_warmup)
+    {
+        dxt_posix_check_online_triggers(rec_ref);
+        if(rec_ref->untraced)
+        {
+            DXT_UNLOCK();
+            return;
+        }
+    }
+
     file_rec = rec_ref->file_rec;
-    check_wr_trace_buf(rec_ref, DXT_POSIX_MOD, dxt_posix_runtime);
-    if(file_rec->write_count == rec_ref->write_available_buf)
+    seg = dxt_trace_next_seg(&rec_ref->write_trace, &file_rec->write_count,
+        &file_rec->write_dropped, DXT_POSIX_MOD, dxt_posix_runtime);
+    if(!seg)
     {
         /* no more memory for i/o segments ... back out */
         DXT_UNLOCK();
         return;
     }
 
-    rec_ref->write_traces[file_rec->write_count].offset = offset;
-    rec_ref->write_traces[file_rec->write_count].length = length;
-    rec_ref->write_traces[file_rec->write_count].start_time = start_time;
-    rec_ref->write_traces[file_rec->write_count].end_time = end_time;
-    file_rec->write_count += 1;
+    seg->offset = offset;
+    seg->length = length;
+    seg->start_time = start_time;
+    seg->end_time = end_time;
+    seg->thread_id = dxt_thread_id();
 
     DXT_UNLOCK();
 }
@@ -272,6 +656,11 @@ void dxt_posix_read(darshan_record_id rec_id, int64_t offset,
 {
     struct dxt_file_record_ref* rec_ref = NULL;
     struct dxt_file_record *file_rec;
+    segment_info *seg;
+
+    if(dxt_posix_thread_traces && dxt_posix_thread_trace(rec_id, 0, offset,
+        length, start_time, end_time))
+        return;
 
     DXT_LOCK();
 
@@ -294,20 +683,38 @@ void dxt_posix_read(darshan_record_id rec_id, int64_t offset,
         }
     }
 
+    if(rec_ref->untraced)
+    {
+        DXT_UNLOCK();
+        return;
+    }
+
+    if(dxt_posix_runtime->trigger_warmup &&
+        ++rec_ref->trigger_ops == dxt_posix_runtime->trigger_warmup)
+    {
+        dxt_posix_check_online_triggers(rec_ref);
+        if(rec_ref->untraced)
+        {
+            DXT_UNLOCK();
+            return;
+        }
+    }
+
     file_rec = rec_ref->file_rec;
-    check_rd_trace_buf(rec_ref, DXT_POSIX_MOD, dxt_posix_runtime);
-    if(file_rec->read_count == rec_ref->read_available_buf)
+    seg = dxt_trace_next_seg(&rec_ref->read_trace, &file_rec->read_count,
+        &file_rec->read_dropped, DXT_POSIX_MOD, dxt_posix_runtime);
+    if(!seg)
     {
         /* no more memory for i/o segments ... back out */
         DXT_UNLOCK();
         return;
     }
 
-    rec_ref->read_traces[file_rec->read_count].offset = offset;
-    rec_ref->read_traces[file_rec->read_count].length = length;
-    rec_ref->read_traces[file_rec->read_count].start_time = start_time;
-    rec_ref->read_traces[file_rec->read_count].end_time = end_time;
-    file_rec->read_count += 1;
+    seg->offset = offset;
+    seg->length = length;
+    seg->start_time = start_time;
+    seg->end_time = end_time;
+    seg->thread_id = dxt_thread_id();
 
     DXT_UNLOCK();
 }
@@ -317,6 +724,7 @@ void dxt_mpiio_write(darshan_record_id rec_id, int64_t offset,
 {
     struct dxt_file_record_ref* rec_ref = NULL;
     struct dxt_file_record *file_rec;
+    segment_info *seg;
 
     DXT_LOCK();
 
@@ -339,20 +747,27 @@ void dxt_mpiio_write(darshan_record_id rec_id, int64_t offset,
         }
     }
 
+    if(rec_ref->untraced)
+    {
+        DXT_UNLOCK();
+        return;
+    }
+
     file_rec = rec_ref->file_rec;
-    check_wr_trace_buf(rec_ref, DXT_MPIIO_MOD, dxt_mpiio_runtime);
-    if(file_rec->write_count == rec_ref->write_available_buf)
+    seg = dxt_trace_next_seg(&rec_ref->write_trace, &file_rec->write_count,
+        &file_rec->write_dropped, DXT_MPIIO_MOD, dxt_mpiio_runtime);
+    if(!seg)
     {
         /* no more memory for i/o segments ... back out */
         DXT_UNLOCK();
         return;
     }
 
-    rec_ref->write_traces[file_rec->write_count].length = length;
-    rec_ref->write_traces[file_rec->write_count].offset = offset;
-    rec_ref->write_traces[file_rec->write_count].start_time = start_time;
-    rec_ref->write_traces[file_rec->write_count].end_time = end_time;
-    file_rec->write_count += 1;
+    seg->offset = offset;
+    seg->length = length;
+    seg->start_time = start_time;
+    seg->end_time = end_time;
+    seg->thread_id = dxt_thread_id();
 
     DXT_UNLOCK();
 }
@@ -362,6 +777,7 @@ void dxt_mpiio_read(darshan_record_id rec_id, int64_t offset,
 {
     struct dxt_file_record_ref* rec_ref = NULL;
     struct dxt_file_record *file_rec;
+    segment_info *seg;
 
     DXT_LOCK();
 
@@ -384,35 +800,156 @@ void dxt_mpiio_read(darshan_record_id rec_id, int64_t offset,
         }
     }
 
+    if(rec_ref->untraced)
+    {
+        DXT_UNLOCK();
+        return;
+    }
+
     file_rec = rec_ref->file_rec;
-    check_rd_trace_buf(rec_ref, DXT_MPIIO_MOD, dxt_mpiio_runtime);
-    if(file_rec->read_count == rec_ref->read_available_buf)
+    seg = dxt_trace_next_seg(&rec_ref->read_trace, &file_rec->read_count,
+        &file_rec->read_dropped, DXT_MPIIO_MOD, dxt_mpiio_runtime);
+    if(!seg)
     {
         /* no more memory for i/o segments ... back out */
         DXT_UNLOCK();
         return;
     }
 
-    rec_ref->read_traces[file_rec->read_count].length = length;
-    rec_ref->read_traces[file_rec->read_count].offset = offset;
-    rec_ref->read_traces[file_rec->read_count].start_time = start_time;
-    rec_ref->read_traces[file_rec->read_count].end_time = end_time;
-    file_rec->read_count += 1;
+    seg->offset = offset;
+    seg->length = length;
+    seg->start_time = start_time;
+    seg->end_time = end_time;
+    seg->thread_id = dxt_thread_id();
 
     DXT_UNLOCK();
 }
 
-static void dxt_posix_filter_traces_iterator(void *rec_ref_p, void *user_ptr)
+void dxt_stdio_write(darshan_record_id rec_id, int64_t offset,
+        int64_t length, double start_time, double end_time)
 {
-    struct dxt_file_record_ref *psx_rec_ref, *mpiio_rec_ref;
-    struct darshan_posix_file *psx_file;
-    struct dxt_trigger *trigger = (struct dxt_trigger *)user_ptr;
-    int should_keep = 0;
+    struct dxt_file_record_ref* rec_ref = NULL;
+    struct dxt_file_record *file_rec;
+    segment_info *seg;
 
-    psx_rec_ref = (struct dxt_file_record_ref *)rec_ref_p;
-    psx_file = darshan_posix_rec_id_to_file(psx_rec_ref->file_rec->base_rec.id);
+    DXT_LOCK();
+
+    if(!dxt_stdio_runtime || dxt_stdio_runtime->frozen)
+    {
+        DXT_UNLOCK();
+        return;
+    }
+
+    rec_ref = darshan_lookup_record_ref(dxt_stdio_runtime->rec_id_hash,
+                &rec_id, sizeof(darshan_record_id));
+    if(!rec_ref)
+    {
+        /* track new dxt file record */
+        rec_ref = dxt_stdio_track_new_file_record(rec_id);
+        if(!rec_ref)
+        {
+            DXT_UNLOCK();
+            return;
+        }
+    }
+
+    if(rec_ref->untraced)
+    {
+        DXT_UNLOCK();
+        return;
+    }
+
+    dxt_stdio_count_op(rec_ref, length);
+    if(rec_ref->untraced)
+    {
+        DXT_UNLOCK();
+        return;
+    }
+
+    file_rec = rec_ref->file_rec;
+    seg = dxt_trace_next_seg(&rec_ref->write_trace, &file_rec->write_count,
+        &file_rec->write_dropped, DXT_STDIO_MOD, dxt_stdio_runtime);
+    if(!seg)
+    {
+        /* no more memory for i/o segments ... back out */
+        DXT_UNLOCK();
+        return;
+    }
+
+    seg->offset = offset;
+    seg->length = length;
+    seg->start_time = start_time;
+    seg->end_time = end_time;
+    seg->thread_id = dxt_thread_id();
+
+    DXT_UNLOCK();
+}
+
+void dxt_stdio_read(darshan_record_id rec_id, int64_t offset,
+        int64_t length, double start_time, double end_time)
+{
+    struct dxt_file_record_ref* rec_ref = NULL;
+    struct dxt_file_record *file_rec;
+    segment_info *seg;
+
+    DXT_LOCK();
+
+    if(!dxt_stdio_runtime || dxt_stdio_runtime->frozen)
+    {
+        DXT_UNLOCK();
+        return;
+    }
+
+    rec_ref = darshan_lookup_record_ref(dxt_stdio_runtime->rec_id_hash,
+                &rec_id, sizeof(darshan_record_id));
+    if(!rec_ref)
+    {
+        /* track new dxt file record */
+        rec_ref = dxt_stdio_track_new_file_record(rec_id);
+        if(!rec_ref)
+        {
+            DXT_UNLOCK();
+            return;
+        }
+    }
+
+    if(rec_ref->untraced)
+    {
+        DXT_UNLOCK();
+        return;
+    }
+
+    dxt_stdio_count_op(rec_ref, length);
+    if(rec_ref->untraced)
+    {
+        DXT_UNLOCK();
+        return;
+    }
+
+    file_rec = rec_ref->file_rec;
+    seg = dxt_trace_next_seg(&rec_ref->read_trace, &file_rec->read_count,
+        &file_rec->read_dropped, DXT_STDIO_MOD, dxt_stdio_runtime);
+    if(!seg)
+    {
+        /* no more memory for i/o segments ... back out */
+        DXT_UNLOCK();
+        return;
+    }
+
+    seg->offset = offset;
+    seg->length = length;
+    seg->start_time = start_time;
+    seg->end_time = end_time;
+    seg->thread_id = dxt_thread_id();
+
+    DXT_UNLOCK();
+}
+
+static int dxt_posix_trigger_satisfied(struct dxt_trigger *trigger,
+    struct darshan_posix_file *psx_file)
+{
+    int should_keep = 0;
 
-    /* analyze dynamic triggers to determine whether we should keep the record */
     switch(trigger->type)
     {
         case DXT_SMALL_IO_TRIGGER:
@@ -442,178 +979,1110 @@ static void dxt_posix_filter_traces_iterator(void *rec_ref_p, void *user_ptr)
         }
     }
 
-    /* drop the record if no dynamic trace triggers occurred */
-    if(!should_keep)
-    {
-        if(dxt_mpiio_runtime && dxt_mpiio_runtime->rec_id_hash)
-        {
-            /* first check the MPI-IO traces to see if we should drop there */
-            mpiio_rec_ref = darshan_delete_record_ref(&dxt_mpiio_runtime->rec_id_hash,
-                &psx_file->base_rec.id, sizeof(darshan_record_id));
-            if(mpiio_rec_ref)
-            {
-                free(mpiio_rec_ref->write_traces);
-                free(mpiio_rec_ref->read_traces);
-                free(mpiio_rec_ref->file_rec);
-                free(mpiio_rec_ref);
-            }
-        }
-
-        if(dxt_posix_runtime && dxt_posix_runtime->rec_id_hash)
-        {
-            /* then delete the POSIX trace records */
-            psx_rec_ref = darshan_delete_record_ref(&dxt_posix_runtime->rec_id_hash,
-                &psx_file->base_rec.id, sizeof(darshan_record_id));
-            if(psx_rec_ref)
-            {
-                free(psx_rec_ref->write_traces);
-                free(psx_rec_ref->read_traces);
-                free(psx_rec_ref->file_rec);
-                free(psx_rec_ref);
-            }
-        }
-    }
-
-    return;
+    return(should_keep);
 }
 
-void dxt_posix_apply_trace_filter(
+/* evaluate the configured triggers against the live POSIX counters of a
+ * file once its warm-up window has been traced, and stop tracing the file
+ * (in both DXT modules) if any trigger is not satisfied
+ */
+static void dxt_posix_check_online_triggers(struct dxt_file_record_ref *rec_ref)
+{
+    struct dxt_file_record_ref *mpiio_rec_ref;
+    struct darshan_posix_file *psx_file;
+    darshan_record_id rec_id = rec_ref->file_rec->base_rec.id;
+    int i;
+
+    /* NOTE: the caller holds the POSIX module lock, so its counters are
+     * safe to read here
+     */
+    psx_file = darshan_posix_rec_id_to_file(rec_id);
+    if(!psx_file)
+        return;
+
+    for(i = 0; i < dxt_posix_runtime->trigger_count; i++)
+    {
+        if(!dxt_posix_trigger_satisfied(&dxt_posix_runtime->triggers[i], psx_file))
+            break;
+    }
+    if(i == dxt_posix_runtime->trigger_count)
+        return;
+
+    dxt_release_trace_bufs(rec_ref, dxt_posix_runtime);
+
+    if(dxt_mpiio_runtime && dxt_mpiio_runtime->rec_id_hash)
+    {
+        mpiio_rec_ref = darshan_lookup_record_ref(dxt_mpiio_runtime->rec_id_hash,
+            &rec_id, sizeof(darshan_record_id));
+        if(mpiio_rec_ref)
+            dxt_release_trace_bufs(mpiio_rec_ref, dxt_mpiio_runtime);
+    }
+
+    return;
+}
+
+static int dxt_stdio_trigger_satisfied(struct dxt_trigger *trigger,
+    struct dxt_file_record_ref *rec_ref)
+{
+    int should_keep = 0;
+
+    switch(trigger->type)
+    {
+        case DXT_SMALL_IO_TRIGGER:
+        {
+            double small_pct = (rec_ref->small_ops / (double)(rec_ref->total_ops));
+            if(small_pct >= trigger->u.small_io.thresh_pct)
+                should_keep = 1;
+            break;
+        }
+        case DXT_UNALIGNED_IO_TRIGGER:
+        {
+            /* buffered STDIO accesses have no meaningful file alignment, so
+             * this trigger never filters STDIO traces
+             */
+            should_keep = 1;
+            break;
+        }
+    }
+
+    return(should_keep);
+}
+
+/* count a traced STDIO operation of size 'length' against the triggers of
+ * its file, and stop tracing the file if any trigger is not satisfied once
+ * its warm-up window has been traced
+ */
+static void dxt_stdio_count_op(struct dxt_file_record_ref *rec_ref,
+    int64_t length)
+{
+    int i;
+
+    /* same bound as the POSIX module's small access size bins (<= 10 KiB) */
+    rec_ref->total_ops++;
+    if(length <= 10240)
+        rec_ref->small_ops++;
+
+    if(!dxt_stdio_runtime->trigger_warmup ||
+        rec_ref->total_ops != dxt_stdio_runtime->trigger_warmup)
+        return;
+
+    for(i = 0; i < dxt_stdio_runtime->trigger_count; i++)
+    {
+        if(!dxt_stdio_trigger_satisfied(&dxt_stdio_runtime->triggers[i], rec_ref))
+        {
+            dxt_release_trace_bufs(rec_ref, dxt_stdio_runtime);
+            break;
+        }
+    }
+
+    return;
+}
+
+/* discard the traces of a file that is no longer traced, returning their
+ * chunks to the module's pool for use by other files
+ */
+static void dxt_release_trace_bufs(struct dxt_file_record_ref *rec_ref,
+    struct dxt_runtime *runtime)
+{
+    struct dxt_file_record *file_rec = rec_ref->file_rec;
+
+    dxt_chunk_release(runtime, rec_ref->write_trace.chunks);
+    dxt_chunk_release(runtime, rec_ref->read_trace.chunks);
+    dxt_free_spill_chunks(&rec_ref->write_trace.spilled);
+    dxt_free_spill_chunks(&rec_ref->read_trace.spilled);
+    runtime->spill_segs -= rec_ref->write_trace.spill_count +
+        rec_ref->read_trace.spill_count;
+    memset(&rec_ref->write_trace, 0, sizeof(rec_ref->write_trace));
+    memset(&rec_ref->read_trace, 0, sizeof(rec_ref->read_trace));
+    file_rec->write_count = 0;
+    file_rec->read_count = 0;
+    file_rec->write_dropped = 0;
+    file_rec->read_dropped = 0;
+    rec_ref->untraced = 1;
+
+    return;
+}
+
+static void dxt_posix_filter_traces_iterator(void *rec_ref_p, void *user_ptr)
+{
+    struct dxt_file_record_ref *psx_rec_ref, *mpiio_rec_ref;
+    struct darshan_posix_file *psx_file;
+    struct dxt_trigger *trigger = (struct dxt_trigger *)user_ptr;
+    int should_keep;
+
+    psx_rec_ref = (struct dxt_file_record_ref *)rec_ref_p;
+    psx_file = darshan_posix_rec_id_to_file(psx_rec_ref->file_rec->base_rec.id);
+
+    /* analyze dynamic triggers to determine whether we should keep the record */
+    should_keep = dxt_posix_trigger_satisfied(trigger, psx_file);
+
+    /* drop the record if no dynamic trace triggers occurred */
+    if(!should_keep)
+    {
+        if(dxt_mpiio_runtime && dxt_mpiio_runtime->rec_id_hash)
+        {
+            /* first check the MPI-IO traces to see if we should drop there */
+            mpiio_rec_ref = darshan_arena_delete_record_ref(dxt_mpiio_runtime->arena,
+                &dxt_mpiio_runtime->rec_id_hash, &psx_file->base_rec.id,
+                sizeof(darshan_record_id));
+            if(mpiio_rec_ref)
+            {
+                dxt_free_record_data(mpiio_rec_ref, NULL);
+                darshan_arena_free(dxt_mpiio_runtime->arena, mpiio_rec_ref,
+                    sizeof(*mpiio_rec_ref));
+            }
+        }
+
+        if(dxt_posix_runtime && dxt_posix_runtime->rec_id_hash)
+        {
+            /* then delete the POSIX trace records */
+            psx_rec_ref = darshan_arena_delete_record_ref(dxt_posix_runtime->arena,
+                &dxt_posix_runtime->rec_id_hash, &psx_file->base_rec.id,
+                sizeof(darshan_record_id));
+            if(psx_rec_ref)
+            {
+                dxt_free_record_data(psx_rec_ref, NULL);
+                darshan_arena_free(dxt_posix_runtime->arena, psx_rec_ref,
+                    sizeof(*psx_rec_ref));
+            }
+        }
+    }
+
+    return;
+}
+
+void dxt_posix_apply_trace_filter(
     struct dxt_trigger *trigger)
 {
+    /* thread traces are discarded along with filtered records */
+    dxt_posix_freeze_thread_traces();
+
+    DXT_LOCK();
+
+    if(!dxt_posix_runtime)
+    {
+        DXT_UNLOCK();
+        return;
+    }
+
+    darshan_iter_record_refs(dxt_posix_runtime->rec_id_hash,
+        dxt_posix_filter_traces_iterator, trigger);
+
+    DXT_UNLOCK();
+
+    return;
+}
+
+static void dxt_stdio_filter_traces_iterator(void *rec_ref_p, void *user_ptr)
+{
+    struct dxt_file_record_ref *rec_ref = (struct dxt_file_record_ref *)rec_ref_p;
+    struct dxt_trigger *trigger = (struct dxt_trigger *)user_ptr;
+    darshan_record_id rec_id = rec_ref->file_rec->base_rec.id;
+
+    /* drop the record if no dynamic trace triggers occurred */
+    if(!dxt_stdio_trigger_satisfied(trigger, rec_ref))
+    {
+        rec_ref = darshan_arena_delete_record_ref(dxt_stdio_runtime->arena,
+            &dxt_stdio_runtime->rec_id_hash, &rec_id, sizeof(darshan_record_id));
+        if(rec_ref)
+        {
+            dxt_free_record_data(rec_ref, NULL);
+            darshan_arena_free(dxt_stdio_runtime->arena, rec_ref,
+                sizeof(*rec_ref));
+        }
+    }
+
+    return;
+}
+
+void dxt_stdio_apply_trace_filter(
+    struct dxt_trigger *trigger)
+{
+    DXT_LOCK();
+
+    if(!dxt_stdio_runtime)
+    {
+        DXT_UNLOCK();
+        return;
+    }
+
+    darshan_iter_record_refs(dxt_stdio_runtime->rec_id_hash,
+        dxt_stdio_filter_traces_iterator, trigger);
+
+    DXT_UNLOCK();
+
+    return;
+}
+
+/***********************************
+ *  internal DXT helper routines   *
+ ***********************************/
+
+/* return the trace segment to fill in for the next operation on a trace,
+ * or NULL if no more memory is available for it. in ring buffer mode, a full
+ * trace instead hands back its oldest segment and counts it as dropped, and
+ * in spill mode, a full trace is first moved to the spill file.
+ */
+static segment_info *dxt_trace_next_seg(struct dxt_trace *trace,
+    int64_t *count, int64_t *dropped, darshan_module_id mod_id,
+    struct dxt_runtime *runtime)
+{
+    struct dxt_seg_chunk *chunk;
+    segment_info *seg;
+
+    if(runtime->ring_segs && *count == runtime->ring_segs)
+    {
+        /* the ring is full, so overwrite its oldest segment */
+        seg = &trace->cur->segs[trace->pos % DXT_SEG_CHUNK_SEGS];
+        if(++trace->pos == runtime->ring_segs)
+        {
+            trace->pos = 0;
+            trace->cur = trace->chunks;
+        }
+        else if(trace->pos % DXT_SEG_CHUNK_SEGS == 0)
+            trace->cur = trace->cur->next;
+        *dropped += 1;
+        return(seg);
+    }
+
+    if(runtime->spill && *count == DXT_SPILL_CHUNK_SEGS)
+        dxt_spill_trace(trace, count, runtime);
+
+    if(trace->pos % DXT_SEG_CHUNK_SEGS == 0)
+    {
+        /* the last chunk is full (or there is none yet), so add another */
+        chunk = dxt_chunk_alloc(runtime);
+        if(!chunk && runtime->spill && *count > 0)
+        {
+            /* out of memory: spill this trace and start over in a reused chunk */
+            dxt_spill_trace(trace, count, runtime);
+            chunk = dxt_chunk_alloc(runtime);
+        }
+        if(!chunk)
+        {
+            /* let Darshan core know that this module ran out of memory */
+            if(!runtime->partial)
+            {
+                darshan_core_mark_partial(mod_id);
+                runtime->partial = 1;
+            }
+            return(NULL);
+        }
+
+        chunk->next = NULL;
+        if(trace->cur)
+            trace->cur->next = chunk;
+        else
+            trace->chunks = chunk;
+        trace->cur = chunk;
+    }
+
+    seg = &trace->cur->segs[trace->pos % DXT_SEG_CHUNK_SEGS];
+    *count += 1;
+    if(++trace->pos == runtime->ring_segs)
+    {
+        /* the ring just filled up; its oldest segment is at the start */
+        trace->pos = 0;
+        trace->cur = trace->chunks;
+    }
+    return(seg);
+}
+
+/* get a segment chunk from the module's pool, allocating a new one if the
+ * pool is empty and the module's memory budget allows it
+ */
+static struct dxt_seg_chunk *dxt_chunk_alloc(struct dxt_runtime *runtime)
+{
+    struct dxt_seg_chunk *chunk;
+
+    chunk = runtime->free_chunks;
+    if(chunk)
+    {
+        runtime->free_chunks = chunk->next;
+        return(chunk);
+    }
+
+    if(runtime->mem_used + sizeof(*chunk) > runtime->mem_allocated)
+        return(NULL);
+    if(dxt_use_slabs)
+        chunk = dxt_slab_chunk_alloc(runtime);
+    else
+        chunk = malloc(sizeof(*chunk));
+    if(chunk)
+        runtime->mem_used += sizeof(*chunk);
+    return(chunk);
+}
+
+/* return a list of segment chunks to the module's pool */
+static void dxt_chunk_release(struct dxt_runtime *runtime,
+    struct dxt_seg_chunk *chunks)
+{
+    struct dxt_seg_chunk *chunk, *tmp;
+
+    LL_FOREACH_SAFE(chunks, chunk, tmp)
+        LL_PREPEND(runtime->free_chunks, chunk);
+
+    return;
+}
+
+static void dxt_chunk_free(struct dxt_seg_chunk *chunks)
+{
+    struct dxt_seg_chunk *chunk, *tmp;
+
+    /* chunks carved from slabs go away with their slabs */
+    if(dxt_use_slabs)
+        return;
+
+    LL_FOREACH_SAFE(chunks, chunk, tmp)
+        free(chunk);
+
+    return;
+}
+
+static struct dxt_seg_chunk *dxt_slab_chunk_alloc(struct dxt_runtime *runtime)
+{
+    struct dxt_seg_slab *slab;
+    struct dxt_seg_chunk *chunk;
+
+    if(runtime->slab_avail < sizeof(*chunk))
+    {
+        slab = darshan_core_mem_alloc(DXT_SEG_SLAB_SIZE);
+        if(!slab)
+            return(NULL);
+        LL_PREPEND(runtime->slabs, slab);
+        runtime->slab_p = (char *)slab + DXT_SEG_SLAB_HDR;
+        runtime->slab_avail = DXT_SEG_SLAB_SIZE - DXT_SEG_SLAB_HDR;
+    }
+
+    chunk = (struct dxt_seg_chunk *)runtime->slab_p;
+    runtime->slab_p += sizeof(*chunk);
+    runtime->slab_avail -= sizeof(*chunk);
+    return(chunk);
+}
+
+static void dxt_slabs_free(struct dxt_runtime *runtime)
+{
+    struct dxt_seg_slab *slab, *tmp;
+
+    LL_FOREACH_SAFE(runtime->slabs, slab, tmp)
+        darshan_core_mem_free(slab, DXT_SEG_SLAB_SIZE);
+    runtime->slabs = NULL;
+
+    return;
+}
+
+/* per-file ring buffer size (in segments) configured by the user, capped
+ * to what the module's memory budget could ever hold
+ */
+static int dxt_ring_segs(size_t mem_allocated)
+{
+    size_t ring_segs = darshan_core_dxt_ring_segments();
+    size_t max_segs = mem_allocated / sizeof(segment_info);
+
+    if(ring_segs > max_segs)
+        ring_segs = max_segs;
+    return((int)ring_segs);
+}
+
+/* encode one trace segment to 'buf' using the compact segment encoding
+ * described in darshan-dxt-log-format.h, relative to the previous segment
+ * in 'st', and extend the record's time range in 'st' to cover it.
+ * returns the end of the encoded data.
+ */
+static unsigned char *dxt_encode_seg(unsigned char *buf, segment_info *seg,
+    struct dxt_enc_state *st)
+{
+    int64_t start = DXT_SEG_TIME_TO_TICKS(seg->start_time);
+    int64_t end = DXT_SEG_TIME_TO_TICKS(seg->end_time);
+
+    DXT_VARINT_PUT(buf, DXT_ZIGZAG_ENC(seg->offset - st->prev_end));
+    DXT_VARINT_PUT(buf, DXT_ZIGZAG_ENC(seg->length));
+    DXT_VARINT_PUT(buf, DXT_ZIGZAG_ENC(start - st->prev_start));
+    DXT_VARINT_PUT(buf, DXT_ZIGZAG_ENC(end - start));
+    DXT_VARINT_PUT(buf, DXT_ZIGZAG_ENC(seg->thread_id - st->prev_thread));
+    st->prev_end = seg->offset + seg->length;
+    st->prev_start = start;
+    st->prev_thread = seg->thread_id;
+    if(start < st->first_start)
+        st->first_start = start;
+    if(end > st->last_end)
+        st->last_end = end;
+
+    return(buf);
+}
+
+/* encode the 'count' segments of a trace to 'buf' in chronological order,
+ * walking its chunks directly. a full ring (of 'ring_segs' segments) starts
+ * at its oldest segment. returns the end of the encoded data.
+ */
+static unsigned char *dxt_encode_trace_segs(unsigned char *buf,
+    struct dxt_trace *trace, int64_t count, int64_t ring_segs,
+    struct dxt_enc_state *st)
+{
+    struct dxt_seg_chunk *chunk = trace->chunks;
+    int64_t pos = 0;
+    int64_t i;
+
+    if(ring_segs && count == ring_segs)
+    {
+        chunk = trace->cur;
+        pos = trace->pos;
+    }
+
+    for(i = 0; i < count; i++)
+    {
+        buf = dxt_encode_seg(buf, &chunk->segs[pos % DXT_SEG_CHUNK_SEGS],
+            st);
+        if(++pos == ring_segs)
+        {
+            pos = 0;
+            chunk = trace->chunks;
+        }
+        else if(pos % DXT_SEG_CHUNK_SEGS == 0)
+            chunk = chunk->next;
+    }
+
+    return(buf);
+}
+
+/* encode a file's shared trace of 'count' segments and the write or read
+ * traces (per 'write_flag') recorded by individual threads in
+ * 'thread_traces' to 'buf', merged in order of start time. returns the end
+ * of the encoded data.
+ */
+static unsigned char *dxt_encode_merged_segs(unsigned char *buf,
+    struct dxt_trace *trace, int64_t count,
+    struct dxt_thread_trace *thread_traces, int write_flag,
+    struct dxt_enc_state *st)
+{
+    struct dxt_thread_trace *ttrace;
+    struct dxt_seg_cursor *cursors;
+    struct dxt_seg_cursor *cursor;
+    segment_info *seg, *min_seg = NULL;
+    int ncursors = 1;
+    int min;
+    int i;
+
+    LL_FOREACH(thread_traces, ttrace)
+        ncursors++;
+
+    cursors = malloc(ncursors * sizeof(*cursors));
+    if(!cursors)
+    {
+        /* fall back to encoding each trace in turn */
+        buf = dxt_encode_trace_segs(buf, trace, count, 0, st);
+        LL_FOREACH(thread_traces, ttrace)
+            buf = dxt_encode_trace_segs(buf,
+                write_flag ? &ttrace->write_trace : &ttrace->read_trace,
+                write_flag ? ttrace->write_count : ttrace->read_count, 0,
+                st);
+        return(buf);
+    }
+
+    cursors[0].chunk = trace->chunks;
+    cursors[0].pos = 0;
+    cursors[0].left = count;
+    i = 1;
+    LL_FOREACH(thread_traces, ttrace)
+    {
+        cursors[i].chunk = write_flag ? ttrace->write_trace.chunks :
+            ttrace->read_trace.chunks;
+        cursors[i].pos = 0;
+        cursors[i].left = write_flag ? ttrace->write_count :
+            ttrace->read_count;
+        i++;
+    }
+
+    /* each trace is already in order, so repeatedly take the earliest of
+     * their next segments
+     */
+    while(1)
+    {
+        min = -1;
+        for(i = 0; i < ncursors; i++)
+        {
+            if(!cursors[i].left)
+                continue;
+            seg = &cursors[i].chunk->segs[cursors[i].pos % DXT_SEG_CHUNK_SEGS];
+            if(min < 0 || seg->start_time < min_seg->start_time)
+            {
+                min = i;
+                min_seg = seg;
+            }
+        }
+        if(min < 0)
+            break;
+
+        buf = dxt_encode_seg(buf, min_seg, st);
+        cursor = &cursors[min];
+        cursor->left--;
+        if(++cursor->pos % DXT_SEG_CHUNK_SEGS == 0)
+            cursor->chunk = cursor->chunk->next;
+    }
+
+    free(cursors);
+    return(buf);
+}
+
+/* read back a file's spilled trace segments in order and encode them to
+ * 'buf', continuing the encoding state in 'st'.
+ * chunks that can't be read back (or that would not fit in the output
+ * buffer) are removed from 'count' and accounted for in 'dropped'.
+ */
+static unsigned char *dxt_encode_spilled_segs(unsigned char *buf,
+    struct dxt_spill_chunk *spilled, int64_t *count, int64_t *dropped,
+    struct dxt_runtime *runtime, struct dxt_enc_state *st)
+{
+    struct dxt_spill_chunk *chunk;
+    size_t size, enc_size;
+    ssize_t ret;
+    int64_t i;
+
+    if(!spilled)
+        return(buf);
+
+    MAP_OR_FAIL(pread);
+    (void)__darshan_disabled;
+
+    if(!dxt_spill->read_buf)
+        dxt_spill->read_buf = malloc(DXT_SPILL_CHUNK_SEGS * sizeof(segment_info));
+
+    DL_FOREACH(spilled, chunk)
+    {
+        size = chunk->count * sizeof(segment_info);
+        enc_size = chunk->count * DXT_SEG_MAX_ENCODED_SIZE;
+        ret = -1;
+        if(dxt_spill->read_buf && !dxt_spill->err &&
+           enc_size <= runtime->spill_enc_left)
+            ret = __real_pread(dxt_spill->fd, dxt_spill->read_buf, size,
+                chunk->off);
+        if(ret != (ssize_t)size)
+        {
+            *count -= chunk->count;
+            *dropped += chunk->count;
+            continue;
+        }
+
+        runtime->spill_enc_left -= enc_size;
+        for(i = 0; i < chunk->count; i++)
+            buf = dxt_encode_seg(buf, &dxt_spill->read_buf[i], st);
+    }
+
+    return(buf);
+}
+
+/* upper bound on the serialized size of all of a DXT module's records:
+ * each segment (sizeof(segment_info) bytes of the module's memory) may
+ * encode to DXT_SEG_MAX_ENCODED_SIZE bytes, and each record carries an
+ * additional encoded length and time range
+ */
+static size_t dxt_record_buf_bound(struct dxt_runtime *runtime)
+{
+    size_t bound;
+    size_t spill_bound;
+
+    bound = (runtime->mem_allocated / sizeof(segment_info)) *
+        DXT_SEG_MAX_ENCODED_SIZE + runtime->file_rec_count *
+        (sizeof(struct dxt_file_record) + 3 * sizeof(int64_t));
+
+    /* spilled segments are added on top of the in-memory ones, but only
+     * up to what darshan-core can accept as a single output buffer
+     */
+    spill_bound = runtime->spill_segs * DXT_SEG_MAX_ENCODED_SIZE;
+    if(bound + spill_bound > INT_MAX)
+        spill_bound = (bound < INT_MAX) ? INT_MAX - bound : 0;
+    runtime->spill_enc_left = spill_bound;
+
+    return(bound + spill_bound);
+}
+
+/* enable spill mode for a DXT module if requested by the user. the spill
+ * file itself is only created once a trace buffer is first spilled.
+ */
+static void dxt_spill_init(struct dxt_runtime *runtime)
+{
+    char *dir;
+
+    if(runtime->ring_segs)
+        return;
+
+    if(!dxt_spill)
+    {
+        dir = darshan_core_dxt_spill_dir();
+        if(!dir)
+            return;
+
+        dxt_spill = malloc(sizeof(*dxt_spill));
+        if(!dxt_spill)
+        {
+            free(dir);
+            return;
+        }
+        memset(dxt_spill, 0, sizeof(*dxt_spill));
+        dxt_spill->dir = dir;
+        dxt_spill->fd = -1;
+        pthread_mutex_init(&dxt_spill->mutex, NULL);
+        pthread_cond_init(&dxt_spill->cond, NULL);
+    }
+
+    runtime->spill = 1;
+
+    return;
+}
+
+/* create the spill file and start the thread that writes to it, if not
+ * done already. returns 0 if the spill file is usable, -1 otherwise.
+ */
+static int dxt_spill_open()
+{
+    char path[PATH_MAX];
+
+    if(dxt_spill->fd >= 0)
+        return(0);
+    if(dxt_spill->err)
+        return(-1);
+
+    MAP_OR_FAIL(open);
+    (void)__darshan_disabled;
+
+    snprintf(path, sizeof(path), "%s/darshan-dxt-spill.%d.%d.%ld",
+        dxt_spill->dir, dxt_my_rank, getpid(), (long)time(NULL));
+    dxt_spill->fd = __real_open(path, O_CREAT|O_RDWR|O_EXCL, 0600);
+    if(dxt_spill->fd < 0)
+    {
+        dxt_spill->err = 1;
+        return(-1);
+    }
+    /* the spill file is only accessed through the open descriptor */
+    unlink(path);
+
+    dxt_spill->pid = getpid();
+    if(pthread_create(&dxt_spill->thread, NULL, dxt_spill_thread, NULL) == 0)
+        dxt_spill->thread_running = 1;
+
+    return(0);
+}
+
+/* move the 'count' segments of a trace to the spill file, leaving the trace
+ * empty. the trace's chunks are handed off to the spill thread if possible,
+ * as long as the pool can still supply chunks to continue tracing with;
+ * otherwise they are written out right away and reused.
+ */
+static void dxt_spill_trace(struct dxt_trace *trace, int64_t *count,
+    struct dxt_runtime *runtime)
+{
+    struct dxt_spill_chunk *chunk;
+    struct dxt_spill_job *job;
+    int can_alloc;
+    int queued = 0;
+
+    if(!dxt_spill || dxt_spill_open() < 0)
+        return;
+
+    chunk = malloc(sizeof(*chunk));
+    job = malloc(sizeof(*job));
+    if(!chunk || !job)
+    {
+        free(chunk);
+        free(job);
+        return;
+    }
+
+    /* reserve space in the spill file for these segments */
+    chunk->off = dxt_spill->size;
+    chunk->count = *count;
+    dxt_spill->size += *count * sizeof(segment_info);
+    DL_APPEND(trace->spilled, chunk);
+    trace->spill_count += *count;
+    runtime->spill_segs += *count;
+
+    job->chunks = trace->chunks;
+    job->count = *count;
+    job->off = chunk->off;
+    job->runtime = runtime;
+    job->next = NULL;
+    trace->chunks = NULL;
+    trace->cur = NULL;
+    trace->pos = 0;
+    *count = 0;
+
+    can_alloc = runtime->free_chunks ||
+        runtime->mem_used + sizeof(struct dxt_seg_chunk) <= runtime->mem_allocated;
+
+    pthread_mutex_lock(&dxt_spill->mutex);
+    if(can_alloc && dxt_spill->thread_running && !dxt_spill->shutdown &&
+       dxt_spill->pending < DXT_SPILL_MAX_PENDING)
+    {
+        LL_APPEND(dxt_spill->jobs, job);
+        dxt_spill->pending++;
+        pthread_cond_signal(&dxt_spill->cond);
+        queued = 1;
+    }
+    pthread_mutex_unlock(&dxt_spill->mutex);
+
+    if(!queued)
+        dxt_spill_write_job(job);
+
+    return;
+}
+
+static void *dxt_spill_thread(void *arg)
+{
+    struct dxt_spill_job *job;
+
+    pthread_mutex_lock(&dxt_spill->mutex);
+    while(1)
+    {
+        while(!dxt_spill->jobs && !dxt_spill->shutdown)
+            pthread_cond_wait(&dxt_spill->cond, &dxt_spill->mutex);
+        job = dxt_spill->jobs;
+        if(!job)
+            break;
+        LL_DELETE(dxt_spill->jobs, job);
+        dxt_spill->pending--;
+        pthread_mutex_unlock(&dxt_spill->mutex);
+
+        dxt_spill_write_job(job);
+
+        pthread_mutex_lock(&dxt_spill->mutex);
+    }
+    pthread_mutex_unlock(&dxt_spill->mutex);
+
+    return(NULL);
+}
+
+static void dxt_spill_write_job(struct dxt_spill_job *job)
+{
+    struct dxt_seg_chunk *seg_chunk;
+    int64_t left_segs = job->count;
+    off_t off = job->off;
+    size_t left;
+    char *buf;
+    ssize_t ret;
+
+    MAP_OR_FAIL(pwrite);
+    (void)__darshan_disabled;
+
+    LL_FOREACH(job->chunks, seg_chunk)
+    {
+        if(left_segs <= 0)
+            break;
+        buf = (char *)seg_chunk->segs;
+        left = ((left_segs < DXT_SEG_CHUNK_SEGS) ? left_segs :
+            DXT_SEG_CHUNK_SEGS) * sizeof(segment_info);
+        left_segs -= left / sizeof(segment_info);
+
+        while(left > 0)
+        {
+            ret = __real_pwrite(dxt_spill->fd, buf, left, off);
+            if(ret < 0 && errno == EINTR)
+                continue;
+            if(ret <= 0)
+            {
+                pthread_mutex_lock(&dxt_spill->mutex);
+                dxt_spill->err = 1;
+                pthread_mutex_unlock(&dxt_spill->mutex);
+                break;
+            }
+            buf += ret;
+            off += ret;
+            left -= ret;
+        }
+    }
+
+    /* the chunks can now be reused by the module this trace belongs to */
     DXT_LOCK();
+    dxt_chunk_release(job->runtime, job->chunks);
+    DXT_UNLOCK();
+    free(job);
 
-    if(!dxt_posix_runtime)
+    return;
+}
+
+/* wait for the spill thread to write out all queued trace buffers */
+static void dxt_spill_drain()
+{
+    if(!dxt_spill || !dxt_spill->thread_running)
+        return;
+
+    /* the spill thread does not survive a fork */
+    if(dxt_spill->pid == getpid())
     {
-        DXT_UNLOCK();
+        pthread_mutex_lock(&dxt_spill->mutex);
+        dxt_spill->shutdown = 1;
+        pthread_cond_signal(&dxt_spill->cond);
+        pthread_mutex_unlock(&dxt_spill->mutex);
+        pthread_join(dxt_spill->thread, NULL);
+    }
+    dxt_spill->thread_running = 0;
+
+    return;
+}
+
+static void dxt_spill_finalize()
+{
+    struct dxt_spill_job *job, *tmp;
+
+    MAP_OR_FAIL(close);
+    (void)__darshan_disabled;
+
+    if(!dxt_spill)
         return;
+
+    dxt_spill_drain();
+    LL_FOREACH_SAFE(dxt_spill->jobs, job, tmp)
+    {
+        LL_DELETE(dxt_spill->jobs, job);
+        dxt_chunk_free(job->chunks);
+        free(job);
     }
+    if(dxt_spill->fd >= 0)
+        __real_close(dxt_spill->fd);
+    pthread_mutex_destroy(&dxt_spill->mutex);
+    pthread_cond_destroy(&dxt_spill->cond);
+    free(dxt_spill->read_buf);
+    free(dxt_spill->dir);
+    free(dxt_spill);
+    dxt_spill = NULL;
 
-    darshan_iter_record_refs(dxt_posix_runtime->rec_id_hash,
-        dxt_posix_filter_traces_iterator, trigger);
+    return;
+}
 
-    DXT_UNLOCK();
+static void dxt_free_spill_chunks(struct dxt_spill_chunk **spilled)
+{
+    struct dxt_spill_chunk *chunk, *tmp;
+
+    DL_FOREACH_SAFE(*spilled, chunk, tmp)
+    {
+        DL_DELETE(*spilled, chunk);
+        free(chunk);
+    }
 
     return;
 }
 
-/***********************************
- *  internal DXT helper routines   *
- ***********************************/
+/* create the key used to look up per-thread DXT state, if not done
+ * already. must be called holding the DXT lock.
+ */
+static void dxt_thread_init()
+{
+    if(!dxt_thread_key_created &&
+        pthread_key_create(&dxt_thread_key, NULL) == 0)
+        dxt_thread_key_created = 1;
+
+    return;
+}
 
-static void check_wr_trace_buf(struct dxt_file_record_ref *rec_ref,
-    darshan_module_id mod_id, struct dxt_runtime *runtime)
+/* returns the kernel id of the calling thread, or -1 if unknown */
+static int64_t dxt_gettid()
 {
-    struct dxt_file_record *file_rec = rec_ref->file_rec;
+#ifdef SYS_gettid
+    return((int64_t)syscall(SYS_gettid));
+#else
+    return(-1);
+#endif
+}
+
+/* returns the calling thread's DXT state, allocating and registering a new
+ * one if needed, or NULL if no state can be used
+ */
+static struct dxt_thread_state *dxt_thread_get_state()
+{
+    struct dxt_thread_state *state;
 
-    int write_count = file_rec->write_count;
-    int write_available_buf = rec_ref->write_available_buf;
+    if(!dxt_thread_key_created)
+        return(NULL);
+
+    state = pthread_getspecific(dxt_thread_key);
+    if(state)
+        return(state);
 
-    if (write_count >= write_available_buf)
+    state = malloc(sizeof(*state));
+    if(!state)
+        return(NULL);
+    memset(state, 0, sizeof(*state));
+    pthread_mutex_init(&state->mutex, NULL);
+    state->tid = dxt_gettid();
+    if(pthread_setspecific(dxt_thread_key, state) != 0)
     {
-        int write_count_inc;
-        if(write_available_buf == 0)
-            write_count_inc = IO_TRACE_BUF_SIZE;
-        else
-            write_count_inc = write_available_buf;
+        pthread_mutex_destroy(&state->mutex);
+        free(state);
+        return(NULL);
+    }
+
+    DXT_LOCK();
+    LL_PREPEND(dxt_thread_list, state);
+    DXT_UNLOCK();
+
+    return(state);
+}
+
+/* returns the id that segments recorded by the calling thread are tagged
+ * with
+ */
+static int64_t dxt_thread_id()
+{
+    struct dxt_thread_state *state;
+
+    state = dxt_thread_get_state();
+    if(state)
+        return(state->tid);
+    return(dxt_gettid());
+}
 
-        size_t mem_left = runtime->mem_allocated - runtime->mem_used;
-        size_t mem_req = write_count_inc * sizeof(segment_info);
-        if(mem_req > mem_left)
+/* records a POSIX operation into the calling thread's private trace of the
+ * file. returns 1 if the operation was handled, 0 if the caller should
+ * record it into the file's shared trace instead.
+ */
+static int dxt_posix_thread_trace(darshan_record_id rec_id, int write_flag,
+    int64_t offset, int64_t length, double start_time, double end_time)
+{
+    struct dxt_thread_state *state;
+    struct dxt_thread_trace *ttrace;
+    struct dxt_trace *trace;
+    int64_t *count;
+    int64_t dropped = 0;
+    segment_info *seg;
+    int new_chunk;
+
+    state = dxt_thread_get_state();
+    if(!state)
+        return(0);
+
+    pthread_mutex_lock(&state->mutex);
+    if(state->frozen)
+    {
+        pthread_mutex_unlock(&state->mutex);
+        return(0);
+    }
+
+    ttrace = state->last;
+    if(!ttrace || ttrace->rec_id != rec_id)
+    {
+        ttrace = darshan_lookup_record_ref(state->trace_hash, &rec_id,
+            sizeof(darshan_record_id));
+        if(!ttrace)
+            ttrace = dxt_posix_track_thread_trace(state, rec_id);
+        if(!ttrace)
         {
-            write_count_inc = mem_left / sizeof(segment_info);
-            if(write_count_inc == 0)
-            {
-                /* we need to request at least one record, even if we
-                 * know there is not enough memory left, so that Darshan
-                 * core can mark this module as having ran out of data
-                 */
-                write_count_inc = 1;
-            }
-            mem_req = write_count_inc * sizeof(segment_info);
+            pthread_mutex_unlock(&state->mutex);
+            return(0);
         }
+        state->last = ttrace;
+    }
 
-        /* register the increased write buffer size with Darshan core */
-        /* NOTE: register_record() does not handle DXT memory allocations,
-         * it just checks that there is enough memory for the record -- if
-         * there is not enough memory, this function will return NULL
-         */
-        if(darshan_core_register_record(
-             file_rec->base_rec.id,
-             NULL, /* no name registration needed, handled in initial record alloc */
-             mod_id,
-             mem_req,
-             NULL))
-        {
-            /* there is enough memory for these additional trace segments,
-             * but we have to (re)allocate them ourselves
-             */
-            write_available_buf += write_count_inc;
-            rec_ref->write_traces =
-                (segment_info *)realloc(rec_ref->write_traces,
-                        write_available_buf * sizeof(segment_info));
+    if(write_flag)
+    {
+        trace = &ttrace->write_trace;
+        count = &ttrace->write_count;
+    }
+    else
+    {
+        trace = &ttrace->read_trace;
+        count = &ttrace->read_count;
+    }
 
-            rec_ref->write_available_buf = write_available_buf;
-        }
-        runtime->mem_used += mem_req;
+    /* thread traces are never rings or spilled, so the module's state is
+     * only needed (under the DXT lock) to get a new chunk from its pool
+     */
+    new_chunk = (trace->pos % DXT_SEG_CHUNK_SEGS == 0);
+    if(new_chunk)
+        DXT_LOCK();
+    seg = dxt_trace_next_seg(trace, count, &dropped, DXT_POSIX_MOD,
+        dxt_posix_runtime);
+    if(new_chunk)
+        DXT_UNLOCK();
+
+    if(seg)
+    {
+        seg->offset = offset;
+        seg->length = length;
+        seg->start_time = start_time;
+        seg->end_time = end_time;
+        seg->thread_id = state->tid;
     }
+
+    pthread_mutex_unlock(&state->mutex);
+
+    return(1);
 }
 
-static void check_rd_trace_buf(struct dxt_file_record_ref *rec_ref,
-    darshan_module_id mod_id, struct dxt_runtime *runtime)
+/* allocates the calling thread's private trace of a file, which must not
+ * already exist in 'state', tracking a new DXT record for the file if
+ * needed. must be called holding the thread's state mutex.
+ */
+static struct dxt_thread_trace *dxt_posix_track_thread_trace(
+    struct dxt_thread_state *state, darshan_record_id rec_id)
 {
-    struct dxt_file_record *file_rec = rec_ref->file_rec;
+    struct dxt_file_record_ref *rec_ref;
+    struct dxt_thread_trace *ttrace = NULL;
+    int ret;
 
-    int read_count = file_rec->read_count;
-    int read_available_buf = rec_ref->read_available_buf;
+    DXT_LOCK();
 
-    if (read_count >= read_available_buf)
+    /* thread traces may no longer be created once they have been frozen */
+    if(!dxt_posix_runtime || dxt_posix_runtime->frozen ||
+        !dxt_posix_thread_traces)
     {
-        int read_count_inc;
-        if(read_available_buf == 0)
-            read_count_inc = IO_TRACE_BUF_SIZE;
-        else
-            read_count_inc = read_available_buf;
+        DXT_UNLOCK();
+        return(NULL);
+    }
 
-        size_t mem_left = runtime->mem_allocated - runtime->mem_used;
-        size_t mem_req = read_count_inc * sizeof(segment_info);
-        if(mem_req > mem_left)
+    rec_ref = darshan_lookup_record_ref(dxt_posix_runtime->rec_id_hash,
+        &rec_id, sizeof(darshan_record_id));
+    if(!rec_ref)
+        rec_ref = dxt_posix_track_new_file_record(rec_id);
+    if(rec_ref)
+        ttrace = darshan_arena_alloc(&(dxt_posix_runtime->arena),
+            sizeof(*ttrace));
+    if(ttrace)
+    {
+        ttrace->rec_id = rec_id;
+        ret = darshan_add_record_ref(&(state->trace_hash), &rec_id,
+            sizeof(darshan_record_id), ttrace);
+        if(ret == 0)
         {
-            read_count_inc = mem_left / sizeof(segment_info);
-            if(read_count_inc == 0)
-            {
-                /* we need to request at least one record, even if we
-                 * know there is not enough memory left, so that Darshan
-                 * core can mark this module as having ran out of data
-                 */
-                read_count_inc = 1;
-            }
-            mem_req = read_count_inc * sizeof(segment_info);
+            darshan_arena_free(dxt_posix_runtime->arena, ttrace,
+                sizeof(*ttrace));
+            ttrace = NULL;
         }
+        else
+            LL_PREPEND(rec_ref->thread_traces, ttrace);
+    }
 
-        /* register the increased read buffer size with Darshan core */
-        /* NOTE: register_record() does not handle DXT memory allocations,
-         * it just checks that there is enough memory for the record -- if
-         * there is not enough memory, this function will return NULL
-         */
-        if(darshan_core_register_record(
-             file_rec->base_rec.id,
-             NULL, /* no name registration needed, handled in initial record alloc */
-             mod_id,
-             mem_req,
-             NULL))
-        {
-            /* there is enough memory for these additional trace segments,
-             * but we have to (re)allocate them ourselves
-             */
-            read_available_buf += read_count_inc;
-            rec_ref->read_traces =
-                (segment_info *)realloc(rec_ref->read_traces,
-                        read_available_buf * sizeof(segment_info));
+    DXT_UNLOCK();
 
-            rec_ref->read_available_buf = read_available_buf;
-        }
-        runtime->mem_used += mem_req;
+    return(ttrace);
+}
+
+/* stops all threads from recording into their private DXT-POSIX traces,
+ * which remain linked to their files' records. this must be called without
+ * holding the DXT lock.
+ */
+static void dxt_posix_freeze_thread_traces()
+{
+    struct dxt_thread_state *state;
+    struct dxt_thread_state *state_list;
+
+    /* prevent new thread traces from being created */
+    DXT_LOCK();
+    dxt_posix_thread_traces = 0;
+    state_list = dxt_thread_list;
+    DXT_UNLOCK();
+
+    /* states are only ever prepended to the list, so it is safe to
+     * traverse it without the DXT lock
+     */
+    LL_FOREACH(state_list, state)
+    {
+        pthread_mutex_lock(&state->mutex);
+        darshan_clear_record_refs(&(state->trace_hash), 0);
+        state->last = NULL;
+        state->frozen = 1;
+        pthread_mutex_unlock(&state->mutex);
     }
+
+    return;
 }
 
 static struct dxt_file_record_ref *dxt_posix_track_new_file_record(
@@ -621,24 +2090,24 @@ static struct dxt_file_record_ref *dxt_posix_track_new_file_record(
 {
     struct dxt_file_record_ref *rec_ref = NULL;
     struct dxt_file_record *file_rec = NULL;
+    char rec_name[__DARSHAN_PATH_MAX];
     int ret;
 
     DXT_LOCK();
 
-    rec_ref = malloc(sizeof(*rec_ref));
+    rec_ref = darshan_arena_alloc(&(dxt_posix_runtime->arena), sizeof(*rec_ref));
     if(!rec_ref)
     {
         DXT_UNLOCK();
         return(NULL);
     }
-    memset(rec_ref, 0, sizeof(*rec_ref));
 
     /* add a reference to this file record based on record id */
-    ret = darshan_add_record_ref(&(dxt_posix_runtime->rec_id_hash), &rec_id,
-            sizeof(darshan_record_id), rec_ref);
+    ret = darshan_arena_add_record_ref(&(dxt_posix_runtime->arena),
+            &(dxt_posix_runtime->rec_id_hash), &rec_id, sizeof(darshan_record_id), rec_ref);
     if(ret == 0)
     {
-        free(rec_ref);
+        darshan_arena_free(dxt_posix_runtime->arena, rec_ref, sizeof(*rec_ref));
         DXT_UNLOCK();
         return(NULL);
     }
@@ -650,14 +2119,15 @@ static struct dxt_file_record_ref *dxt_posix_track_new_file_record(
      */
     if(darshan_core_register_record(
          rec_id,
-         darshan_core_lookup_record_name(rec_id),
+         darshan_core_lookup_record_name(rec_id, rec_name, sizeof(rec_name)) ?
+             rec_name : NULL,
          DXT_POSIX_MOD,
          sizeof(*file_rec),
          NULL) == NULL)
     {
-        darshan_delete_record_ref(&(dxt_posix_runtime->rec_id_hash),
-            &rec_id, sizeof(darshan_record_id));
-        free(rec_ref);
+        darshan_arena_delete_record_ref(dxt_posix_runtime->arena,
+            &(dxt_posix_runtime->rec_id_hash), &rec_id, sizeof(darshan_record_id));
+        darshan_arena_free(dxt_posix_runtime->arena, rec_ref, sizeof(*rec_ref));
         DXT_UNLOCK();
         return(NULL);
     }
@@ -666,9 +2136,9 @@ static struct dxt_file_record_ref *dxt_posix_track_new_file_record(
     file_rec = malloc(sizeof(*file_rec));
     if(!file_rec)
     {
-        darshan_delete_record_ref(&(dxt_posix_runtime->rec_id_hash),
-            &rec_id, sizeof(darshan_record_id));
-        free(rec_ref);
+        darshan_arena_delete_record_ref(dxt_posix_runtime->arena,
+            &(dxt_posix_runtime->rec_id_hash), &rec_id, sizeof(darshan_record_id));
+        darshan_arena_free(dxt_posix_runtime->arena, rec_ref, sizeof(*rec_ref));
         DXT_UNLOCK();
         return(NULL);
     }
@@ -693,24 +2163,24 @@ static struct dxt_file_record_ref *dxt_mpiio_track_new_file_record(
 {
     struct dxt_file_record *file_rec = NULL;
     struct dxt_file_record_ref *rec_ref = NULL;
+    char rec_name[__DARSHAN_PATH_MAX];
     int ret;
 
     DXT_LOCK();
 
-    rec_ref = malloc(sizeof(*rec_ref));
+    rec_ref = darshan_arena_alloc(&(dxt_mpiio_runtime->arena), sizeof(*rec_ref));
     if(!rec_ref)
     {
         DXT_UNLOCK();
         return(NULL);
     }
-    memset(rec_ref, 0, sizeof(*rec_ref));
 
     /* add a reference to this file record based on record id */
-    ret = darshan_add_record_ref(&(dxt_mpiio_runtime->rec_id_hash), &rec_id,
-            sizeof(darshan_record_id), rec_ref);
+    ret = darshan_arena_add_record_ref(&(dxt_mpiio_runtime->arena),
+            &(dxt_mpiio_runtime->rec_id_hash), &rec_id, sizeof(darshan_record_id), rec_ref);
     if(ret == 0)
     {
-        free(rec_ref);
+        darshan_arena_free(dxt_mpiio_runtime->arena, rec_ref, sizeof(*rec_ref));
         DXT_UNLOCK();
         return(NULL);
     }
@@ -722,14 +2192,15 @@ static struct dxt_file_record_ref *dxt_mpiio_track_new_file_record(
      */
     if(darshan_core_register_record(
          rec_id,
-         darshan_core_lookup_record_name(rec_id),
+         darshan_core_lookup_record_name(rec_id, rec_name, sizeof(rec_name)) ?
+             rec_name : NULL,
          DXT_MPIIO_MOD,
          sizeof(*file_rec),
          NULL) == NULL)
     {
-        darshan_delete_record_ref(&(dxt_mpiio_runtime->rec_id_hash),
-            &rec_id, sizeof(darshan_record_id));
-        free(rec_ref);
+        darshan_arena_delete_record_ref(dxt_mpiio_runtime->arena,
+            &(dxt_mpiio_runtime->rec_id_hash), &rec_id, sizeof(darshan_record_id));
+        darshan_arena_free(dxt_mpiio_runtime->arena, rec_ref, sizeof(*rec_ref));
         DXT_UNLOCK();
         return(NULL);
     }
@@ -738,9 +2209,9 @@ static struct dxt_file_record_ref *dxt_mpiio_track_new_file_record(
     file_rec = malloc(sizeof(*file_rec));
     if(!file_rec)
     {
-        darshan_delete_record_ref(&(dxt_mpiio_runtime->rec_id_hash),
-            &rec_id, sizeof(darshan_record_id));
-        free(rec_ref);
+        darshan_arena_delete_record_ref(dxt_mpiio_runtime->arena,
+            &(dxt_mpiio_runtime->rec_id_hash), &rec_id, sizeof(darshan_record_id));
+        darshan_arena_free(dxt_mpiio_runtime->arena, rec_ref, sizeof(*rec_ref));
         DXT_UNLOCK();
         return(NULL);
     }
@@ -760,78 +2231,210 @@ static struct dxt_file_record_ref *dxt_mpiio_track_new_file_record(
     return(rec_ref);
 }
 
+static struct dxt_file_record_ref *dxt_stdio_track_new_file_record(
+    darshan_record_id rec_id)
+{
+    struct dxt_file_record *file_rec = NULL;
+    struct dxt_file_record_ref *rec_ref = NULL;
+    char rec_name[__DARSHAN_PATH_MAX];
+    int ret;
+
+    DXT_LOCK();
+
+    rec_ref = darshan_arena_alloc(&(dxt_stdio_runtime->arena), sizeof(*rec_ref));
+    if(!rec_ref)
+    {
+        DXT_UNLOCK();
+        return(NULL);
+    }
+
+    /* add a reference to this file record based on record id */
+    ret = darshan_arena_add_record_ref(&(dxt_stdio_runtime->arena),
+            &(dxt_stdio_runtime->rec_id_hash), &rec_id, sizeof(darshan_record_id), rec_ref);
+    if(ret == 0)
+    {
+        darshan_arena_free(dxt_stdio_runtime->arena, rec_ref, sizeof(*rec_ref));
+        DXT_UNLOCK();
+        return(NULL);
+    }
+
+    /* register base DXT record with with darshan core for now */
+    /* NOTE: register_record() does not handle DXT memory allocations,
+     * it just checks that there is enough memory for the record -- if
+     * there is not enough memory, this function will return NULL
+     */
+    if(darshan_core_register_record(
+         rec_id,
+         darshan_core_lookup_record_name(rec_id, rec_name, sizeof(rec_name)) ?
+             rec_name : NULL,
+         DXT_STDIO_MOD,
+         sizeof(*file_rec),
+         NULL) == NULL)
+    {
+        darshan_arena_delete_record_ref(dxt_stdio_runtime->arena,
+            &(dxt_stdio_runtime->rec_id_hash), &rec_id, sizeof(darshan_record_id));
+        darshan_arena_free(dxt_stdio_runtime->arena, rec_ref, sizeof(*rec_ref));
+        DXT_UNLOCK();
+        return(NULL);
+    }
+
+    /* allocate DXT record ourselves if Darshan core registration succeeded */
+    file_rec = malloc(sizeof(*file_rec));
+    if(!file_rec)
+    {
+        darshan_arena_delete_record_ref(dxt_stdio_runtime->arena,
+            &(dxt_stdio_runtime->rec_id_hash), &rec_id, sizeof(darshan_record_id));
+        darshan_arena_free(dxt_stdio_runtime->arena, rec_ref, sizeof(*rec_ref));
+        DXT_UNLOCK();
+        return(NULL);
+    }
+    memset(file_rec, 0, sizeof(*file_rec));
+
+    dxt_stdio_runtime->file_rec_count++;
+    dxt_stdio_runtime->mem_used += sizeof(*file_rec);
+    DXT_UNLOCK();
+
+    /* initialize record and record reference fields */
+    file_rec->base_rec.id = rec_id;
+    file_rec->base_rec.rank = dxt_my_rank;
+    gethostname(file_rec->hostname, HOSTNAME_SIZE);
+
+    rec_ref->file_rec = file_rec;
+
+    return(rec_ref);
+}
+
 static void dxt_free_record_data(void *rec_ref_p, void *user_ptr)
 {
     struct dxt_file_record_ref *dxt_rec_ref = (struct dxt_file_record_ref *)rec_ref_p;
+    struct dxt_thread_trace *ttrace;
 
-    free(dxt_rec_ref->write_traces);
-    free(dxt_rec_ref->read_traces);
+    dxt_chunk_free(dxt_rec_ref->write_trace.chunks);
+    dxt_chunk_free(dxt_rec_ref->read_trace.chunks);
+    /* thread traces themselves are allocated from the module's arena */
+    LL_FOREACH(dxt_rec_ref->thread_traces, ttrace)
+    {
+        dxt_chunk_free(ttrace->write_trace.chunks);
+        dxt_chunk_free(ttrace->read_trace.chunks);
+    }
     free(dxt_rec_ref->file_rec);
+    dxt_free_spill_chunks(&dxt_rec_ref->write_trace.spilled);
+    dxt_free_spill_chunks(&dxt_rec_ref->read_trace.spilled);
 }
 
 /********************************************************************************
  *     functions exported by this module for coordinating with darshan-core     *
  ********************************************************************************/
 
-static void dxt_serialize_posix_records(void *rec_ref_p, void *user_ptr)
+static void dxt_serialize_record(struct dxt_file_record_ref *rec_ref,
+    struct dxt_runtime *runtime)
 {
-    struct dxt_file_record_ref *rec_ref = (struct dxt_file_record_ref *)rec_ref_p;
     struct dxt_file_record *file_rec;
-    int64_t record_size = 0;
-    int64_t record_write_count = 0;
-    int64_t record_read_count = 0;
-    void *tmp_buf_ptr;
+    struct dxt_file_record rec_hdr;
+    struct dxt_thread_trace *ttrace;
+    struct dxt_enc_state st;
+    int64_t enc_size;
+    int64_t range[2];
+    unsigned char *rec_start;
+    unsigned char *enc_size_ptr;
+    unsigned char *tmp_buf_ptr;
 
     assert(rec_ref);
     file_rec = rec_ref->file_rec;
     assert(file_rec);
 
-    record_write_count = file_rec->write_count;
-    record_read_count = file_rec->read_count;
-    if (record_write_count == 0 && record_read_count == 0)
+    /* spilled segments precede the ones still held in memory */
+    rec_hdr = *file_rec;
+    rec_hdr.write_count += rec_ref->write_trace.spill_count;
+    rec_hdr.read_count += rec_ref->read_trace.spill_count;
+    LL_FOREACH(rec_ref->thread_traces, ttrace)
+    {
+        rec_hdr.write_count += ttrace->write_count;
+        rec_hdr.read_count += ttrace->read_count;
+    }
+    if (rec_hdr.write_count == 0 && rec_hdr.read_count == 0)
         return;
 
     /*
      * Buffer format:
-     * dxt_file_record + write_traces + read_traces
+     * dxt_file_record + encoded size + time range + encoded write trace +
+     * read trace
+     */
+    rec_start = (unsigned char *)(runtime->record_buf +
+        runtime->record_buf_size);
+    enc_size_ptr = rec_start + sizeof(struct dxt_file_record);
+    tmp_buf_ptr = enc_size_ptr + sizeof(int64_t) + sizeof(range);
+    st.first_start = INT64_MAX;
+    st.last_end = INT64_MIN;
+
+    /* NOTE: thread traces are only used without ring buffer and spill
+     * modes, so they never need to be merged with a ring or spilled segments
      */
-    record_size = sizeof(struct dxt_file_record) +
-            (record_write_count + record_read_count) * sizeof(segment_info);
 
-    tmp_buf_ptr = (void *)(dxt_posix_runtime->record_buf +
-        dxt_posix_runtime->record_buf_size);
+    /*Encode write record */
+    st.prev_end = st.prev_start = st.prev_thread = 0;
+    tmp_buf_ptr = dxt_encode_spilled_segs(tmp_buf_ptr,
+        rec_ref->write_trace.spilled, &rec_hdr.write_count,
+        &rec_hdr.write_dropped, runtime, &st);
+    if(rec_ref->thread_traces)
+        tmp_buf_ptr = dxt_encode_merged_segs(tmp_buf_ptr, &rec_ref->write_trace,
+            file_rec->write_count, rec_ref->thread_traces, 1, &st);
+    else
+        tmp_buf_ptr = dxt_encode_trace_segs(tmp_buf_ptr, &rec_ref->write_trace,
+            file_rec->write_count, runtime->ring_segs, &st);
+
+    /*Encode read record */
+    st.prev_end = st.prev_start = st.prev_thread = 0;
+    tmp_buf_ptr = dxt_encode_spilled_segs(tmp_buf_ptr,
+        rec_ref->read_trace.spilled, &rec_hdr.read_count,
+        &rec_hdr.read_dropped, runtime, &st);
+    if(rec_ref->thread_traces)
+        tmp_buf_ptr = dxt_encode_merged_segs(tmp_buf_ptr, &rec_ref->read_trace,
+            file_rec->read_count, rec_ref->thread_traces, 0, &st);
+    else
+        tmp_buf_ptr = dxt_encode_trace_segs(tmp_buf_ptr, &rec_ref->read_trace,
+            file_rec->read_count, runtime->ring_segs, &st);
 
     /*Copy struct dxt_file_record */
-    memcpy(tmp_buf_ptr, (void *)file_rec, sizeof(struct dxt_file_record));
-    tmp_buf_ptr = (void *)(tmp_buf_ptr + sizeof(struct dxt_file_record));
-
-    /*Copy write record */
-    memcpy(tmp_buf_ptr, (void *)(rec_ref->write_traces),
-            record_write_count * sizeof(segment_info));
-    tmp_buf_ptr = (void *)(tmp_buf_ptr +
-                record_write_count * sizeof(segment_info));
-
-    /*Copy read record */
-    memcpy(tmp_buf_ptr, (void *)(rec_ref->read_traces),
-            record_read_count * sizeof(segment_info));
-    tmp_buf_ptr = (void *)(tmp_buf_ptr +
-                record_read_count * sizeof(segment_info));
+    memcpy(rec_start, &rec_hdr, sizeof(struct dxt_file_record));
+    enc_size = tmp_buf_ptr - (enc_size_ptr + sizeof(int64_t) + sizeof(range));
+    memcpy(enc_size_ptr, &enc_size, sizeof(int64_t));
+    if(st.first_start > st.last_end)
+        st.first_start = st.last_end = 0; /* all segments were dropped */
+    range[0] = st.first_start;
+    range[1] = st.last_end;
+    memcpy(enc_size_ptr + sizeof(int64_t), range, sizeof(range));
+
+    runtime->record_buf_size += tmp_buf_ptr - rec_start;
+}
 
-    dxt_posix_runtime->record_buf_size += record_size;
+static void dxt_serialize_posix_records(void *rec_ref_p, void *user_ptr)
+{
+    dxt_serialize_record((struct dxt_file_record_ref *)rec_ref_p,
+        dxt_posix_runtime);
 }
 
 static void dxt_posix_output(
     void **dxt_posix_buf,
     int *dxt_posix_buf_sz)
 {
+    size_t buf_bound;
+
     assert(dxt_posix_runtime);
 
     *dxt_posix_buf_sz = 0;
 
-    dxt_posix_runtime->record_buf = malloc(dxt_posix_runtime->mem_allocated);
+    /* stop threads from modifying their traces while we serialize them */
+    dxt_posix_freeze_thread_traces();
+
+    /* make sure all spilled trace segments have reached the spill file */
+    dxt_spill_drain();
+
+    buf_bound = dxt_record_buf_bound(dxt_posix_runtime);
+    dxt_posix_runtime->record_buf = malloc(buf_bound);
     if(!(dxt_posix_runtime->record_buf))
         return;
-    memset(dxt_posix_runtime->record_buf, 0, dxt_posix_runtime->mem_allocated);
+    memset(dxt_posix_runtime->record_buf, 0, buf_bound);
     dxt_posix_runtime->record_buf_size = 0;
 
     /* iterate all dxt posix records and serialize them to the output buffer */
@@ -851,78 +2454,56 @@ static void dxt_posix_cleanup()
 {
     assert(dxt_posix_runtime);
 
+    /* make sure no thread references its traces past this point */
+    dxt_posix_freeze_thread_traces();
+
+    /* queued spill jobs hand their chunks back to this module's pool */
+    dxt_spill_drain();
+
     free(dxt_posix_runtime->record_buf);
 
     /* cleanup internal structures used for instrumenting */
     darshan_iter_record_refs(dxt_posix_runtime->rec_id_hash,
         dxt_free_record_data, NULL);
-    darshan_clear_record_refs(&(dxt_posix_runtime->rec_id_hash), 1);
+    darshan_arena_clear_record_refs(&(dxt_posix_runtime->rec_id_hash));
+    darshan_arena_destroy(&(dxt_posix_runtime->arena));
+    dxt_chunk_free(dxt_posix_runtime->free_chunks);
+    dxt_slabs_free(dxt_posix_runtime);
 
     free(dxt_posix_runtime);
     dxt_posix_runtime = NULL;
+    dxt_posix_runtime_enabled = 0;
+
+    if(!dxt_posix_runtime && !dxt_mpiio_runtime && !dxt_stdio_runtime)
+        dxt_spill_finalize();
 
     return;
 }
 
 static void dxt_serialize_mpiio_records(void *rec_ref_p, void *user_ptr)
 {
-    struct dxt_file_record_ref *rec_ref = (struct dxt_file_record_ref *)rec_ref_p;
-    struct dxt_file_record *file_rec;
-    int64_t record_size = 0;
-    int64_t record_write_count = 0;
-    int64_t record_read_count = 0;
-    void *tmp_buf_ptr;
-
-    assert(rec_ref);
-    file_rec = rec_ref->file_rec;
-    assert(file_rec);
-
-    record_write_count = file_rec->write_count;
-    record_read_count = file_rec->read_count;
-    if (record_write_count == 0 && record_read_count == 0)
-        return;
-
-    /*
-     * Buffer format:
-     * dxt_file_record + write_traces + read_traces
-     */
-    record_size = sizeof(struct dxt_file_record) +
-            (record_write_count + record_read_count) * sizeof(segment_info);
-
-    tmp_buf_ptr = (void *)(dxt_mpiio_runtime->record_buf +
-        dxt_mpiio_runtime->record_buf_size);
-
-    /*Copy struct dxt_file_record */
-    memcpy(tmp_buf_ptr, (void *)file_rec, sizeof(struct dxt_file_record));
-    tmp_buf_ptr = (void *)(tmp_buf_ptr + sizeof(struct dxt_file_record));
-
-    /*Copy write record */
-    memcpy(tmp_buf_ptr, (void *)(rec_ref->write_traces),
-            record_write_count * sizeof(segment_info));
-    tmp_buf_ptr = (void *)(tmp_buf_ptr +
-                record_write_count * sizeof(segment_info));
-
-    /*Copy read record */
-    memcpy(tmp_buf_ptr, (void *)(rec_ref->read_traces),
-            record_read_count * sizeof(segment_info));
-    tmp_buf_ptr = (void *)(tmp_buf_ptr +
-                record_read_count * sizeof(segment_info));
-
-    dxt_mpiio_runtime->record_buf_size += record_size;
+    dxt_serialize_record((struct dxt_file_record_ref *)rec_ref_p,
+        dxt_mpiio_runtime);
 }
 
 static void dxt_mpiio_output(
     void **dxt_mpiio_buf,
     int *dxt_mpiio_buf_sz)
 {
+    size_t buf_bound;
+
     assert(dxt_mpiio_runtime);
 
     *dxt_mpiio_buf_sz = 0;
 
-    dxt_mpiio_runtime->record_buf = malloc(dxt_mpiio_runtime->mem_allocated);
+    /* make sure all spilled trace segments have reached the spill file */
+    dxt_spill_drain();
+
+    buf_bound = dxt_record_buf_bound(dxt_mpiio_runtime);
+    dxt_mpiio_runtime->record_buf = malloc(buf_bound);
     if(!(dxt_mpiio_runtime->record_buf))
         return;
-    memset(dxt_mpiio_runtime->record_buf, 0, dxt_mpiio_runtime->mem_allocated);
+    memset(dxt_mpiio_runtime->record_buf, 0, buf_bound);
     dxt_mpiio_runtime->record_buf_size = 0;
 
     /* iterate all dxt posix records and serialize them to the output buffer */
@@ -942,15 +2523,91 @@ static void dxt_mpiio_cleanup()
 {
     assert(dxt_mpiio_runtime);
 
+    /* queued spill jobs hand their chunks back to this module's pool */
+    dxt_spill_drain();
+
     free(dxt_mpiio_runtime->record_buf);
 
     /* cleanup internal structures used for instrumenting */
     darshan_iter_record_refs(dxt_mpiio_runtime->rec_id_hash,
         dxt_free_record_data, NULL);
-    darshan_clear_record_refs(&(dxt_mpiio_runtime->rec_id_hash), 1);
+    darshan_arena_clear_record_refs(&(dxt_mpiio_runtime->rec_id_hash));
+    darshan_arena_destroy(&(dxt_mpiio_runtime->arena));
+    dxt_chunk_free(dxt_mpiio_runtime->free_chunks);
+    dxt_slabs_free(dxt_mpiio_runtime);
 
     free(dxt_mpiio_runtime);
     dxt_mpiio_runtime = NULL;
+    dxt_mpiio_runtime_enabled = 0;
+
+    if(!dxt_posix_runtime && !dxt_mpiio_runtime && !dxt_stdio_runtime)
+        dxt_spill_finalize();
+
+    return;
+}
+
+static void dxt_serialize_stdio_records(void *rec_ref_p, void *user_ptr)
+{
+    dxt_serialize_record((struct dxt_file_record_ref *)rec_ref_p,
+        dxt_stdio_runtime);
+}
+
+static void dxt_stdio_output(
+    void **dxt_stdio_buf,
+    int *dxt_stdio_buf_sz)
+{
+    size_t buf_bound;
+
+    assert(dxt_stdio_runtime);
+
+    *dxt_stdio_buf_sz = 0;
+
+    /* make sure all spilled trace segments have reached the spill file */
+    dxt_spill_drain();
+
+    buf_bound = dxt_record_buf_bound(dxt_stdio_runtime);
+    dxt_stdio_runtime->record_buf = malloc(buf_bound);
+    if(!(dxt_stdio_runtime->record_buf))
+        return;
+    memset(dxt_stdio_runtime->record_buf, 0, buf_bound);
+    dxt_stdio_runtime->record_buf_size = 0;
+
+    /* iterate all dxt stdio records and serialize them to the output buffer */
+    darshan_iter_record_refs(dxt_stdio_runtime->rec_id_hash,
+        dxt_serialize_stdio_records, NULL);
+
+    /* set output */
+    *dxt_stdio_buf = dxt_stdio_runtime->record_buf;
+    *dxt_stdio_buf_sz = dxt_stdio_runtime->record_buf_size;
+
+    dxt_stdio_runtime->frozen = 1;
+
+    return;
+}
+
+static void dxt_stdio_cleanup()
+{
+    assert(dxt_stdio_runtime);
+
+    /* queued spill jobs hand their chunks back to this module's pool */
+    dxt_spill_drain();
+
+    free(dxt_stdio_runtime->record_buf);
+
+    /* cleanup internal structures used for instrumenting */
+    darshan_iter_record_refs(dxt_stdio_runtime->rec_id_hash,
+        dxt_free_record_data, NULL);
+    darshan_arena_clear_record_refs(&(dxt_stdio_runtime->rec_id_hash));
+    darshan_arena_destroy(&(dxt_stdio_runtime->arena));
+    dxt_chunk_free(dxt_stdio_runtime->free_chunks);
+    dxt_slabs_free(dxt_stdio_runtime);
+
+    free(dxt_stdio_runtime);
+    dxt_stdio_runtime = NULL;
+    dxt_stdio_runtime_enabled = 0;
+
+    if(!dxt_posix_runtime && !dxt_mpiio_runtime && !dxt_stdio_runtime)
+        dxt_spill_finalize();
 
     return;
 }
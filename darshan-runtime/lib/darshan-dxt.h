@@ -36,6 +36,16 @@ struct dxt_trigger
     } u;
 };
 
+#ifdef DARSHAN_DXT
+
+/* set while the corresponding DXT runtime is initialized, so that the
+ * record macros of the POSIX, MPI-IO and STDIO modules only pay for a flag
+ * test while tracing is disabled (the default)
+ */
+extern int dxt_posix_runtime_enabled;
+extern int dxt_mpiio_runtime_enabled;
+extern int dxt_stdio_runtime_enabled;
+
 /* dxt_posix_runtime_initialize()
  *
  * DXT function exposed to POSIX module for initializing DXT-POSIX runtime.
@@ -48,6 +58,12 @@ void dxt_posix_runtime_initialize(void);
  */
 void dxt_mpiio_runtime_initialize(void);
 
+/* dxt_stdio_runtime_initialize()
+ *
+ * DXT function exposed to STDIO module for initializing DXT-STDIO runtime.
+ */
+void dxt_stdio_runtime_initialize(void);
+
 /* dxt_posix_write(), dxt_posix_read()
  *
  * DXT function to trace a POSIX write/read call to file record 'rec_id',
@@ -70,6 +86,45 @@ void dxt_mpiio_write(darshan_record_id rec_id, int64_t offset,
 void dxt_mpiio_read(darshan_record_id rec_id, int64_t offset,
         int64_t length, double start_time, double end_time);
 
+/* dxt_stdio_write(), dxt_stdio_read()
+ *
+ * DXT function to trace a STDIO write/read call to file record 'rec_id',
+ * at offset 'offset' and with 'length' size. 'start_time' and 'end_time'
+ * are starting and ending timestamps for the operation, respectively.
+ */
+void dxt_stdio_write(darshan_record_id rec_id, int64_t offset,
+        int64_t length, double start_time, double end_time);
+void dxt_stdio_read(darshan_record_id rec_id, int64_t offset,
+        int64_t length, double start_time, double end_time);
+
 void dxt_posix_apply_trace_filter(struct dxt_trigger *trigger);
+void dxt_stdio_apply_trace_filter(struct dxt_trigger *trigger);
+
+#define DXT_RECORD(__mod, __op, __rec_id, __offset, __length, __tm1, __tm2) do { \
+    if(dxt_##__mod##_runtime_enabled) \
+        dxt_##__mod##_##__op(__rec_id, __offset, __length, __tm1, __tm2); \
+} while(0)
+
+#else
+
+/* as with the heatmap module, provide stubs when the DXT module is not
+ * built so that the other modules do not need preprocessor guards
+ */
+
+static inline void dxt_posix_runtime_initialize(void) {
+}
+static inline void dxt_mpiio_runtime_initialize(void) {
+}
+static inline void dxt_stdio_runtime_initialize(void) {
+}
+static inline void dxt_posix_apply_trace_filter(struct dxt_trigger *trigger) {
+}
+static inline void dxt_stdio_apply_trace_filter(struct dxt_trigger *trigger) {
+}
+
+#define DXT_RECORD(__mod, __op, __rec_id, __offset, __length, __tm1, __tm2) \
+    do { } while(0)
+
+#endif
 
 #endif /* __DARSHAN_DXT_H */
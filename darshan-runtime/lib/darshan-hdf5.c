@@ -56,6 +56,26 @@ DARSHAN_FORWARD_DECL(H5Oopen_by_idx, hid_t, (hid_t loc_id, const char * group_na
 #ifdef HAVE_H5OOPEN_BY_TOKEN
 DARSHAN_FORWARD_DECL(H5Oopen_by_token, hid_t, (hid_t loc_id, H5O_token_t token));
 #endif
+
+/* H5S prototypes -- only wrapped to invalidate memoized selection analysis */
+DARSHAN_FORWARD_DECL(H5Sselect_hyperslab, herr_t, (hid_t space_id, H5S_seloper_t op, const hsize_t start[], const hsize_t stride[], const hsize_t count[], const hsize_t block[]));
+DARSHAN_FORWARD_DECL(H5Sselect_elements, herr_t, (hid_t space_id, H5S_seloper_t op, size_t num_elem, const hsize_t *coord));
+DARSHAN_FORWARD_DECL(H5Sselect_all, herr_t, (hid_t spaceid));
+DARSHAN_FORWARD_DECL(H5Sselect_none, herr_t, (hid_t spaceid));
+DARSHAN_FORWARD_DECL(H5Soffset_simple, herr_t, (hid_t space_id, const hssize_t *offset));
+DARSHAN_FORWARD_DECL(H5Sset_extent_simple, herr_t, (hid_t space_id, int rank, const hsize_t dims[], const hsize_t max[]));
+DARSHAN_FORWARD_DECL(H5Sset_extent_none, herr_t, (hid_t space_id));
+DARSHAN_FORWARD_DECL(H5Sextent_copy, herr_t, (hid_t dst_id, hid_t src_id));
+DARSHAN_FORWARD_DECL(H5Sclose, herr_t, (hid_t space_id));
+#ifdef HAVE_H5SMODIFY_SELECT
+DARSHAN_FORWARD_DECL(H5Smodify_select, herr_t, (hid_t space1_id, H5S_seloper_t op, hid_t space2_id));
+#endif
+#ifdef HAVE_H5SSELECT_ADJUST
+DARSHAN_FORWARD_DECL(H5Sselect_adjust, herr_t, (hid_t spaceid, const hssize_t *offset));
+#endif
+#ifdef HAVE_H5SSELECT_COPY
+DARSHAN_FORWARD_DECL(H5Sselect_copy, herr_t, (hid_t dst_id, hid_t src_id));
+#endif
 DARSHAN_FORWARD_DECL(H5Oclose, herr_t, (hid_t object_id));
 
 /* structure that can track i/o stats for a given HDF5 file record at runtime */
@@ -83,11 +103,48 @@ struct hdf5_dataset_record_ref
 #endif
 };
 
+/* number of entries in the direct-mapped hid_t -> record ref cache in front
+ * of each runtime's hid_hash (must be a power of 2)
+ */
+#define HDF5_HID_CACHE_SIZE 64
+/* HDF5 identifiers of a given type differ in their low bits */
+#define HDF5_HID_CACHE_SLOT(__hid) ((size_t)(__hid) & (HDF5_HID_CACHE_SIZE - 1))
+
+/* number of dataspaces whose selection analysis is memoized for H5Dread()
+ * and H5Dwrite() (must be a power of 2)
+ */
+#define H5D_SEL_MEMO_SIZE 16
+#define H5D_SEL_MEMO_SLOT(__hid) ((size_t)(__hid) & (H5D_SEL_MEMO_SIZE - 1))
+
+/* hid_t -> record ref mapping cached from the hid_hash, including misses
+ * (a NULL rec_ref); a slot with hid 0 is empty, as 0 is never a valid id
+ */
+struct hdf5_hid_cache_entry
+{
+    hid_t hid;
+    void *rec_ref;
+};
+
+/* the result of inspecting the selection of a file dataspace passed to
+ * H5Dread() or H5Dwrite(), which stays valid until the dataspace is
+ * modified by one of the wrapped H5S functions
+ */
+struct hdf5_sel_memo
+{
+    hid_t space_id;
+    hssize_t npoints;
+    H5S_sel_type sel_type;
+    int regular;
+    int64_t access_vals[H5D_MAX_NDIMS+H5D_MAX_NDIMS];
+};
+
 /* struct to encapsulate runtime state for the HDF5 module */
 struct hdf5_runtime
 {
     void *rec_id_hash;
     void *hid_hash;
+    struct hdf5_hid_cache_entry hid_cache[HDF5_HID_CACHE_SIZE];
+    struct hdf5_sel_memo sel_memo[H5D_SEL_MEMO_SIZE]; /* H5D only */
     int rec_count;
     int frozen; /* flag to indicate that the counters should no longer be modified */
 };
@@ -102,14 +159,20 @@ static struct hdf5_dataset_record_ref *hdf5_track_new_dataset_record(
     darshan_record_id rec_id, const char *rec_name);
 static void hdf5_finalize_dataset_records(
     void *rec_ref_p, void *user_ptr);
+static void *hdf5_lookup_hid_ref(
+    struct hdf5_runtime *runtime, hid_t hid);
+static void hdf5_add_hid_ref(
+    struct hdf5_runtime *runtime, hid_t hid, void *rec_ref);
+static void hdf5_delete_hid_ref(
+    struct hdf5_runtime *runtime, hid_t hid);
+static hssize_t hdf5_dataset_record_selection(
+    struct hdf5_dataset_record_ref *rec_ref, hid_t file_space_id,
+    int64_t *common_access_vals);
 #ifdef HAVE_MPI
 static void hdf5_file_record_reduction_op(
     void* inrec_v, void* inoutrec_v, int *len, MPI_Datatype *datatype);
 static void hdf5_dataset_record_reduction_op(
     void* inrec_v, void* inoutrec_v, int *len, MPI_Datatype *datatype);
-static void hdf5_shared_dataset_record_variance(
-    MPI_Comm mod_comm, struct darshan_hdf5_dataset *inrec_array,
-    struct darshan_hdf5_dataset *outrec_array, int shared_rec_count);
 static void hdf5_file_mpi_redux(
     void *hdf5_buf, MPI_Comm mod_comm,
     darshan_record_id *shared_recs, int shared_rec_count);
@@ -149,6 +212,7 @@ static int my_rank = -1;
  * return immediately without reaching the POST_RECORD() macro.
  */
 #define H5F_PRE_RECORD() do { \
+    DARSHAN_OVERHEAD_ENTER(); \
     if(!__darshan_disabled) { \
         HDF5_LOCK(); \
         if(!hdf5_file_runtime && !h5f_runtime_init_attempted) \
@@ -161,6 +225,7 @@ static int my_rank = -1;
 
 #define H5F_POST_RECORD() do { \
     HDF5_UNLOCK(); \
+    DARSHAN_OVERHEAD_EXIT(DARSHAN_H5F_MOD); \
 } while(0)
 
 #define H5F_RECORD_OPEN(__ret, __path, __use_mpio, __tm1, __tm2) do { \
@@ -184,7 +249,7 @@ static int my_rank = -1;
     __rec_ref->file_rec->fcounters[H5F_F_OPEN_END_TIMESTAMP] = __tm2; \
     DARSHAN_TIMER_INC_NO_OVERLAP(__rec_ref->file_rec->fcounters[H5F_F_META_TIME], \
         __tm1, __tm2, __rec_ref->last_meta_end); \
-    darshan_add_record_ref(&(hdf5_file_runtime->hid_hash), &__ret, sizeof(hid_t), __rec_ref); \
+    hdf5_add_hid_ref(hdf5_file_runtime, __ret, __rec_ref); \
     if(__newpath != __path) free(__newpath); \
     /* LDMS to publish realtime open tracing information to daemon*/ \
     if(dC.ldms_lib)\
@@ -397,8 +462,7 @@ herr_t DARSHAN_DECL(H5Fflush)(hid_t object_id, H5F_scope_t scope)
         if(file_id > 0)
         {
             H5F_PRE_RECORD();
-            rec_ref = darshan_lookup_record_ref(hdf5_file_runtime->hid_hash,
-                &file_id, sizeof(hid_t));
+            rec_ref = hdf5_lookup_hid_ref(hdf5_file_runtime, file_id);
             if(rec_ref)
             {
                 rec_ref->file_rec->counters[H5F_FLUSHES] += 1;
@@ -431,8 +495,7 @@ herr_t DARSHAN_DECL(H5Fclose)(hid_t file_id)
     if(ret >= 0)
     {
         H5F_PRE_RECORD();
-        rec_ref = darshan_lookup_record_ref(hdf5_file_runtime->hid_hash,
-            &file_id, sizeof(hid_t));
+        rec_ref = hdf5_lookup_hid_ref(hdf5_file_runtime, file_id);
         if(rec_ref)
         {
             if(rec_ref->file_rec->fcounters[H5F_F_CLOSE_START_TIMESTAMP] == 0 ||
@@ -442,8 +505,7 @@ herr_t DARSHAN_DECL(H5Fclose)(hid_t file_id)
             DARSHAN_TIMER_INC_NO_OVERLAP(
                 rec_ref->file_rec->fcounters[H5F_F_META_TIME],
                 tm1, tm2, rec_ref->last_meta_end);
-            darshan_delete_record_ref(&(hdf5_file_runtime->hid_hash),
-                &file_id, sizeof(hid_t));
+            hdf5_delete_hid_ref(hdf5_file_runtime, file_id);
 
 #ifdef HAVE_LDMS
             rec_ref->close_counts++;
@@ -473,6 +535,7 @@ herr_t DARSHAN_DECL(H5Fclose)(hid_t file_id)
  * return immediately without reaching the POST_RECORD() macro.
  */
 #define H5D_PRE_RECORD() do { \
+    DARSHAN_OVERHEAD_ENTER(); \
     if(!__darshan_disabled) { \
         HDF5_LOCK(); \
         if(!hdf5_dataset_runtime && !h5d_runtime_init_attempted) \
@@ -485,6 +548,7 @@ herr_t DARSHAN_DECL(H5Fclose)(hid_t file_id)
 
 #define H5D_POST_RECORD() do { \
     HDF5_UNLOCK(); \
+    DARSHAN_OVERHEAD_EXIT(DARSHAN_H5D_MOD); \
 } while(0)
 
 #define H5D_RECORD_OPEN(__ret, __loc_id, __name, __type_id, __space_id, __dcpl_id, __use_depr,  __tm1, __tm2) do { \
@@ -541,7 +605,7 @@ herr_t DARSHAN_DECL(H5Fclose)(hid_t file_id)
     } \
     __rec_ref->dataset_rec->counters[H5D_DATATYPE_SIZE] = H5Tget_size(__type_id); \
     __rec_ref->dataset_rec->file_rec_id = __file_rec_id; \
-    darshan_add_record_ref(&(hdf5_dataset_runtime->hid_hash), &__ret, sizeof(hid_t), __rec_ref); \
+    hdf5_add_hid_ref(hdf5_dataset_runtime, __ret, __rec_ref); \
     /* LDMS to publish runtime h5d tracing information to daemon*/ \
     if(dC.ldms_lib)\
         if(dC.hdf5_enable_ldms)\
@@ -689,74 +753,35 @@ herr_t DARSHAN_DECL(H5Dread)(hid_t dataset_id, hid_t mem_type_id, hid_t mem_spac
     struct hdf5_dataset_record_ref *rec_ref;
     size_t access_size;
     size_t type_size;
-    ssize_t file_sel_npoints;
-    H5S_sel_type file_sel_type;
+    hssize_t file_sel_npoints;
     int64_t common_access_vals[H5D_MAX_NDIMS+H5D_MAX_NDIMS+1] = {0};
     struct darshan_common_val_counter *cvc;
-    int i;
     double tm1, tm2, elapsed;
     herr_t ret;
 
     MAP_OR_FAIL(H5Dread);
 
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_H5D_MOD, -1);
     tm1 = HDF5_WTIME();
     ret = __real_H5Dread(dataset_id, mem_type_id, mem_space_id, file_space_id,
         xfer_plist_id, buf);
     tm2 = HDF5_WTIME();
+    DARSHAN_ATTRIB_LEAVE();
 
     if(ret >= 0)
     {
         H5D_PRE_RECORD();
-        rec_ref = darshan_lookup_record_ref(hdf5_dataset_runtime->hid_hash,
-            &dataset_id, sizeof(hid_t));
+        rec_ref = hdf5_lookup_hid_ref(hdf5_dataset_runtime, dataset_id);
         if(rec_ref)
         {
+            /* ATTRIB to charge the MPI-IO and POSIX I/O issued by this call */
+            DARSHAN_ATTRIB_CHARGE(rec_ref->dataset_rec->base_rec.id);
             rec_ref->dataset_rec->counters[H5D_READS] += 1;
             if(rec_ref->last_io_type == DARSHAN_IO_WRITE)
                 rec_ref->dataset_rec->counters[H5D_RW_SWITCHES] += 1;
             rec_ref->last_io_type = DARSHAN_IO_READ;
-            if(file_space_id == H5S_ALL)
-            {
-                file_sel_npoints = rec_ref->dataset_rec->counters[H5D_DATASPACE_NPOINTS];
-                file_sel_type = H5S_SEL_ALL;
-            }
-            else
-            {
-                file_sel_npoints = H5Sget_select_npoints(file_space_id);
-                file_sel_type = H5Sget_select_type(file_space_id);
-            }
-            if(file_sel_type == H5S_SEL_POINTS)
-                rec_ref->dataset_rec->counters[H5D_POINT_SELECTS] += 1;
-            else if (file_sel_type == H5S_SEL_HYPERSLABS)
-            {
-#ifdef HAVE_H5SGET_REGULAR_HYPERSLAB
-                if(H5Sis_regular_hyperslab(file_space_id))
-                {
-                    hsize_t start_dims[H5D_MAX_NDIMS] = {0};
-                    hsize_t stride_dims[H5D_MAX_NDIMS] = {0};
-                    hsize_t count_dims[H5D_MAX_NDIMS] = {0};
-                    hsize_t block_dims[H5D_MAX_NDIMS] = {0};
-                    rec_ref->dataset_rec->counters[H5D_REGULAR_HYPERSLAB_SELECTS] += 1;
-                    H5Sget_regular_hyperslab(file_space_id,
-                        start_dims, stride_dims, count_dims, block_dims);
-                    for(i = 0; i < H5D_MAX_NDIMS; i++)
-                    {
-                        common_access_vals[1+i] = count_dims[H5D_MAX_NDIMS - i - 1] *
-                            block_dims[H5D_MAX_NDIMS - i - 1];
-                        common_access_vals[1+i+H5D_MAX_NDIMS] =
-                            stride_dims[H5D_MAX_NDIMS - i - 1];
-                    }
-                }
-                else
-                    rec_ref->dataset_rec->counters[H5D_IRREGULAR_HYPERSLAB_SELECTS] += 1;
-#else
-                for(i = 0; i < H5D_MAX_NDIMS; i++)
-                {
-                    common_access_vals[1+i] = -1;
-                    common_access_vals[1+i+H5D_MAX_NDIMS] = -1;
-                }
-#endif
-            }
+            file_sel_npoints = hdf5_dataset_record_selection(rec_ref,
+                file_space_id, common_access_vals);
             type_size = rec_ref->dataset_rec->counters[H5D_DATATYPE_SIZE];
             access_size = file_sel_npoints * type_size;
             rec_ref->dataset_rec->counters[H5D_BYTES_READ] += access_size;
@@ -820,74 +845,35 @@ herr_t DARSHAN_DECL(H5Dwrite)(hid_t dataset_id, hid_t mem_type_id, hid_t mem_spa
     struct hdf5_dataset_record_ref *rec_ref;
     size_t access_size;
     size_t type_size;
-    ssize_t file_sel_npoints;
-    H5S_sel_type file_sel_type;
+    hssize_t file_sel_npoints;
     int64_t common_access_vals[H5D_MAX_NDIMS+H5D_MAX_NDIMS+1] = {0};
     struct darshan_common_val_counter *cvc;
-    int i;
     double tm1, tm2, elapsed;
     herr_t ret;
 
     MAP_OR_FAIL(H5Dwrite);
 
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_H5D_MOD, -1);
     tm1 = HDF5_WTIME();
     ret = __real_H5Dwrite(dataset_id, mem_type_id, mem_space_id, file_space_id,
         xfer_plist_id, buf);
     tm2 = HDF5_WTIME();
+    DARSHAN_ATTRIB_LEAVE();
 
     if(ret >= 0)
     {
         H5D_PRE_RECORD();
-        rec_ref = darshan_lookup_record_ref(hdf5_dataset_runtime->hid_hash,
-            &dataset_id, sizeof(hid_t));
+        rec_ref = hdf5_lookup_hid_ref(hdf5_dataset_runtime, dataset_id);
         if(rec_ref)
         {
+            /* ATTRIB to charge the MPI-IO and POSIX I/O issued by this call */
+            DARSHAN_ATTRIB_CHARGE(rec_ref->dataset_rec->base_rec.id);
             rec_ref->dataset_rec->counters[H5D_WRITES] += 1;
             if(rec_ref->last_io_type == DARSHAN_IO_READ)
                 rec_ref->dataset_rec->counters[H5D_RW_SWITCHES] += 1;
             rec_ref->last_io_type = DARSHAN_IO_WRITE;
-            if(file_space_id == H5S_ALL)
-            {
-                file_sel_npoints = rec_ref->dataset_rec->counters[H5D_DATASPACE_NPOINTS];
-                file_sel_type = H5S_SEL_ALL;
-            }
-            else
-            {
-                file_sel_npoints = H5Sget_select_npoints(file_space_id);
-                file_sel_type = H5Sget_select_type(file_space_id);
-            }
-            if(file_sel_type == H5S_SEL_POINTS)
-                rec_ref->dataset_rec->counters[H5D_POINT_SELECTS] += 1;
-            else if (file_sel_type == H5S_SEL_HYPERSLABS)
-            {
-#ifdef HAVE_H5SGET_REGULAR_HYPERSLAB
-                if(H5Sis_regular_hyperslab(file_space_id))
-                {
-                    hsize_t start_dims[H5D_MAX_NDIMS] = {0};
-                    hsize_t stride_dims[H5D_MAX_NDIMS] = {0};
-                    hsize_t count_dims[H5D_MAX_NDIMS] = {0};
-                    hsize_t block_dims[H5D_MAX_NDIMS] = {0};
-                    rec_ref->dataset_rec->counters[H5D_REGULAR_HYPERSLAB_SELECTS] += 1;
-                    H5Sget_regular_hyperslab(file_space_id,
-                        start_dims, stride_dims, count_dims, block_dims);
-                    for(i = 0; i < H5D_MAX_NDIMS; i++)
-                    {
-                        common_access_vals[1+i] = count_dims[H5D_MAX_NDIMS - i - 1] *
-                            block_dims[H5D_MAX_NDIMS - i - 1];
-                        common_access_vals[1+i+H5D_MAX_NDIMS] =
-                            stride_dims[H5D_MAX_NDIMS - i - 1];
-                    }
-                }
-                else
-                    rec_ref->dataset_rec->counters[H5D_IRREGULAR_HYPERSLAB_SELECTS] += 1;
-#else
-                for(i = 0; i < H5D_MAX_NDIMS; i++)
-                {
-                    common_access_vals[1+i] = -1;
-                    common_access_vals[1+i+H5D_MAX_NDIMS] = -1;
-                }
-#endif
-            }
+            file_sel_npoints = hdf5_dataset_record_selection(rec_ref,
+                file_space_id, common_access_vals);
             type_size = rec_ref->dataset_rec->counters[H5D_DATATYPE_SIZE];
             access_size = file_sel_npoints * type_size;
             rec_ref->dataset_rec->counters[H5D_BYTES_WRITTEN] += access_size;
@@ -961,8 +947,7 @@ herr_t DARSHAN_DECL(H5Dflush)(hid_t dataset_id)
     if(ret >= 0)
     {
         H5D_PRE_RECORD();
-        rec_ref = darshan_lookup_record_ref(hdf5_dataset_runtime->hid_hash,
-            &dataset_id, sizeof(hid_t));
+        rec_ref = hdf5_lookup_hid_ref(hdf5_dataset_runtime, dataset_id);
         if(rec_ref)
         {
             rec_ref->dataset_rec->counters[H5D_FLUSHES] += 1;
@@ -992,8 +977,7 @@ herr_t DARSHAN_DECL(H5Dclose)(hid_t dataset_id)
     if(ret >= 0)
     {
         H5D_PRE_RECORD();
-        rec_ref = darshan_lookup_record_ref(hdf5_dataset_runtime->hid_hash,
-            &dataset_id, sizeof(hid_t));
+        rec_ref = hdf5_lookup_hid_ref(hdf5_dataset_runtime, dataset_id);
         if(rec_ref)
         {
             if(rec_ref->dataset_rec->fcounters[H5D_F_CLOSE_START_TIMESTAMP] == 0 ||
@@ -1002,7 +986,7 @@ herr_t DARSHAN_DECL(H5Dclose)(hid_t dataset_id)
             rec_ref->dataset_rec->fcounters[H5D_F_CLOSE_END_TIMESTAMP] = tm2;
             DARSHAN_TIMER_INC_NO_OVERLAP(rec_ref->dataset_rec->fcounters[H5D_F_META_TIME],
                 tm1, tm2, rec_ref->last_meta_end);
-            darshan_delete_record_ref(&(hdf5_dataset_runtime->hid_hash), &dataset_id, sizeof(hid_t));
+            hdf5_delete_hid_ref(hdf5_dataset_runtime, dataset_id);
 
 #ifdef HAVE_LDMS
             rec_ref->close_counts++;
@@ -1278,8 +1262,7 @@ herr_t DARSHAN_DECL(H5Oclose)(hid_t object_id)
         /* no need to check if object is a dataset, we just look for it
          * in our hash of open dataset IDs
          */
-        rec_ref = darshan_lookup_record_ref(hdf5_dataset_runtime->hid_hash,
-            &object_id, sizeof(hid_t));
+        rec_ref = hdf5_lookup_hid_ref(hdf5_dataset_runtime, object_id);
         if(rec_ref)
         {
             if(rec_ref->dataset_rec->fcounters[H5D_F_CLOSE_START_TIMESTAMP] == 0 ||
@@ -1288,7 +1271,7 @@ herr_t DARSHAN_DECL(H5Oclose)(hid_t object_id)
             rec_ref->dataset_rec->fcounters[H5D_F_CLOSE_END_TIMESTAMP] = tm2;
             DARSHAN_TIMER_INC_NO_OVERLAP(rec_ref->dataset_rec->fcounters[H5D_F_META_TIME],
                 tm1, tm2, rec_ref->last_meta_end);
-            darshan_delete_record_ref(&(hdf5_dataset_runtime->hid_hash), &object_id, sizeof(hid_t));
+            hdf5_delete_hid_ref(hdf5_dataset_runtime, object_id);
         }
         H5D_POST_RECORD();
     }
@@ -1296,6 +1279,179 @@ herr_t DARSHAN_DECL(H5Oclose)(hid_t object_id)
     return(ret);
 }
 
+/*********************************************************
+ *        Wrappers for H5S functions of interest         *
+ *********************************************************/
+
+/* drop the memoized selection analysis of a dataspace that may have been
+ * modified, whether or not the modifying call succeeded
+ */
+#define H5S_INVALIDATE_SEL_MEMO(__space_id) do { \
+    struct hdf5_sel_memo *__memo; \
+    if(__darshan_disabled) break; \
+    HDF5_LOCK(); \
+    if(hdf5_dataset_runtime) { \
+        __memo = &hdf5_dataset_runtime->sel_memo[H5D_SEL_MEMO_SLOT(__space_id)]; \
+        if(__memo->space_id == __space_id) __memo->space_id = 0; \
+    } \
+    HDF5_UNLOCK(); \
+} while(0)
+
+herr_t DARSHAN_DECL(H5Sselect_hyperslab)(hid_t space_id, H5S_seloper_t op,
+    const hsize_t start[], const hsize_t stride[], const hsize_t count[],
+    const hsize_t block[])
+{
+    herr_t ret;
+
+    MAP_OR_FAIL(H5Sselect_hyperslab);
+
+    ret = __real_H5Sselect_hyperslab(space_id, op, start, stride, count, block);
+    H5S_INVALIDATE_SEL_MEMO(space_id);
+
+    return(ret);
+}
+
+herr_t DARSHAN_DECL(H5Sselect_elements)(hid_t space_id, H5S_seloper_t op,
+    size_t num_elem, const hsize_t *coord)
+{
+    herr_t ret;
+
+    MAP_OR_FAIL(H5Sselect_elements);
+
+    ret = __real_H5Sselect_elements(space_id, op, num_elem, coord);
+    H5S_INVALIDATE_SEL_MEMO(space_id);
+
+    return(ret);
+}
+
+herr_t DARSHAN_DECL(H5Sselect_all)(hid_t spaceid)
+{
+    herr_t ret;
+
+    MAP_OR_FAIL(H5Sselect_all);
+
+    ret = __real_H5Sselect_all(spaceid);
+    H5S_INVALIDATE_SEL_MEMO(spaceid);
+
+    return(ret);
+}
+
+herr_t DARSHAN_DECL(H5Sselect_none)(hid_t spaceid)
+{
+    herr_t ret;
+
+    MAP_OR_FAIL(H5Sselect_none);
+
+    ret = __real_H5Sselect_none(spaceid);
+    H5S_INVALIDATE_SEL_MEMO(spaceid);
+
+    return(ret);
+}
+
+herr_t DARSHAN_DECL(H5Soffset_simple)(hid_t space_id, const hssize_t *offset)
+{
+    herr_t ret;
+
+    MAP_OR_FAIL(H5Soffset_simple);
+
+    ret = __real_H5Soffset_simple(space_id, offset);
+    H5S_INVALIDATE_SEL_MEMO(space_id);
+
+    return(ret);
+}
+
+herr_t DARSHAN_DECL(H5Sset_extent_simple)(hid_t space_id, int rank,
+    const hsize_t dims[], const hsize_t max[])
+{
+    herr_t ret;
+
+    MAP_OR_FAIL(H5Sset_extent_simple);
+
+    ret = __real_H5Sset_extent_simple(space_id, rank, dims, max);
+    H5S_INVALIDATE_SEL_MEMO(space_id);
+
+    return(ret);
+}
+
+herr_t DARSHAN_DECL(H5Sset_extent_none)(hid_t space_id)
+{
+    herr_t ret;
+
+    MAP_OR_FAIL(H5Sset_extent_none);
+
+    ret = __real_H5Sset_extent_none(space_id);
+    H5S_INVALIDATE_SEL_MEMO(space_id);
+
+    return(ret);
+}
+
+herr_t DARSHAN_DECL(H5Sextent_copy)(hid_t dst_id, hid_t src_id)
+{
+    herr_t ret;
+
+    MAP_OR_FAIL(H5Sextent_copy);
+
+    ret = __real_H5Sextent_copy(dst_id, src_id);
+    H5S_INVALIDATE_SEL_MEMO(dst_id);
+
+    return(ret);
+}
+
+herr_t DARSHAN_DECL(H5Sclose)(hid_t space_id)
+{
+    herr_t ret;
+
+    MAP_OR_FAIL(H5Sclose);
+
+    ret = __real_H5Sclose(space_id);
+    H5S_INVALIDATE_SEL_MEMO(space_id);
+
+    return(ret);
+}
+
+#ifdef HAVE_H5SMODIFY_SELECT
+herr_t DARSHAN_DECL(H5Smodify_select)(hid_t space1_id, H5S_seloper_t op,
+    hid_t space2_id)
+{
+    herr_t ret;
+
+    MAP_OR_FAIL(H5Smodify_select);
+
+    ret = __real_H5Smodify_select(space1_id, op, space2_id);
+    H5S_INVALIDATE_SEL_MEMO(space1_id);
+
+    return(ret);
+}
+#endif
+
+#ifdef HAVE_H5SSELECT_ADJUST
+herr_t DARSHAN_DECL(H5Sselect_adjust)(hid_t spaceid, const hssize_t *offset)
+{
+    herr_t ret;
+
+    MAP_OR_FAIL(H5Sselect_adjust);
+
+    ret = __real_H5Sselect_adjust(spaceid, offset);
+    H5S_INVALIDATE_SEL_MEMO(spaceid);
+
+    return(ret);
+}
+#endif
+
+#ifdef HAVE_H5SSELECT_COPY
+herr_t DARSHAN_DECL(H5Sselect_copy)(hid_t dst_id, hid_t src_id)
+{
+    herr_t ret;
+
+    MAP_OR_FAIL(H5Sselect_copy);
+
+    ret = __real_H5Sselect_copy(dst_id, src_id);
+    H5S_INVALIDATE_SEL_MEMO(dst_id);
+
+    return(ret);
+}
+#endif
+
 /*********************************************************
  * Internal functions for manipulating HDF5 module state *
  *********************************************************/
@@ -1381,6 +1537,118 @@ static void hdf5_dataset_runtime_initialize()
     return;
 }
 
+/* look up the record ref for an HDF5 identifier in the given runtime,
+ * going through its direct-mapped cache before the hid_hash
+ */
+static void *hdf5_lookup_hid_ref(struct hdf5_runtime *runtime, hid_t hid)
+{
+    struct hdf5_hid_cache_entry *ent = &runtime->hid_cache[HDF5_HID_CACHE_SLOT(hid)];
+
+    if(ent->hid == hid)
+        return(ent->rec_ref);
+
+    ent->hid = hid;
+    ent->rec_ref = darshan_lookup_record_ref(runtime->hid_hash, &hid, sizeof(hid_t));
+    return(ent->rec_ref);
+}
+
+static void hdf5_add_hid_ref(struct hdf5_runtime *runtime, hid_t hid,
+    void *rec_ref)
+{
+    struct hdf5_hid_cache_entry *ent = &runtime->hid_cache[HDF5_HID_CACHE_SLOT(hid)];
+
+    darshan_add_record_ref(&(runtime->hid_hash), &hid, sizeof(hid_t), rec_ref);
+    /* refilled from the hid_hash on the next lookup */
+    if(ent->hid == hid)
+        ent->hid = 0;
+
+    return;
+}
+
+static void hdf5_delete_hid_ref(struct hdf5_runtime *runtime, hid_t hid)
+{
+    struct hdf5_hid_cache_entry *ent = &runtime->hid_cache[HDF5_HID_CACHE_SLOT(hid)];
+
+    darshan_delete_record_ref(&(runtime->hid_hash), &hid, sizeof(hid_t));
+    if(ent->hid == hid)
+        ent->hid = 0;
+
+    return;
+}
+
+/* inspect the file dataspace selection of an H5Dread() or H5Dwrite() call,
+ * updating the selection counters of the dataset and filling in the access
+ * dimensions of 'common_access_vals'. Returns the number of selected points.
+ * The inspection is memoized per dataspace, so reusing an unmodified
+ * dataspace across calls costs no HDF5 calls.
+ */
+static hssize_t hdf5_dataset_record_selection(
+    struct hdf5_dataset_record_ref *rec_ref, hid_t file_space_id,
+    int64_t *common_access_vals)
+{
+    struct hdf5_sel_memo *memo;
+    int i;
+
+    if(file_space_id == H5S_ALL)
+        return(rec_ref->dataset_rec->counters[H5D_DATASPACE_NPOINTS]);
+
+    memo = &hdf5_dataset_runtime->sel_memo[H5D_SEL_MEMO_SLOT(file_space_id)];
+    if(memo->space_id != file_space_id)
+    {
+        memset(memo, 0, sizeof(*memo));
+        memo->space_id = file_space_id;
+        memo->npoints = H5Sget_select_npoints(file_space_id);
+        memo->sel_type = H5Sget_select_type(file_space_id);
+#ifdef HAVE_H5SGET_REGULAR_HYPERSLAB
+        if(memo->sel_type == H5S_SEL_HYPERSLABS &&
+            H5Sis_regular_hyperslab(file_space_id))
+        {
+            /* sized for any rank, though only H5D_MAX_NDIMS are kept */
+            hsize_t start_dims[H5S_MAX_RANK] = {0};
+            hsize_t stride_dims[H5S_MAX_RANK] = {0};
+            hsize_t count_dims[H5S_MAX_RANK] = {0};
+            hsize_t block_dims[H5S_MAX_RANK] = {0};
+            memo->regular = 1;
+            H5Sget_regular_hyperslab(file_space_id,
+                start_dims, stride_dims, count_dims, block_dims);
+            for(i = 0; i < H5D_MAX_NDIMS; i++)
+            {
+                memo->access_vals[i] = count_dims[H5D_MAX_NDIMS - i - 1] *
+                    block_dims[H5D_MAX_NDIMS - i - 1];
+                memo->access_vals[i+H5D_MAX_NDIMS] =
+                    stride_dims[H5D_MAX_NDIMS - i - 1];
+            }
+        }
+#else
+        if(memo->sel_type == H5S_SEL_HYPERSLABS)
+        {
+            for(i = 0; i < H5D_MAX_NDIMS+H5D_MAX_NDIMS; i++)
+                memo->access_vals[i] = -1;
+        }
+#endif
+    }
+
+    if(memo->sel_type == H5S_SEL_POINTS)
+        rec_ref->dataset_rec->counters[H5D_POINT_SELECTS] += 1;
+    else if(memo->sel_type == H5S_SEL_HYPERSLABS)
+    {
+#ifdef HAVE_H5SGET_REGULAR_HYPERSLAB
+        if(memo->regular)
+            rec_ref->dataset_rec->counters[H5D_REGULAR_HYPERSLAB_SELECTS] += 1;
+        else
+            rec_ref->dataset_rec->counters[H5D_IRREGULAR_HYPERSLAB_SELECTS] += 1;
+#endif
+        memcpy(&common_access_vals[1], memo->access_vals,
+            sizeof(memo->access_vals));
+    }
+
+    /* don't keep the result of a failed inspection */
+    if(memo->npoints < 0)
+        memo->space_id = 0;
+
+    return(memo->npoints);
+}
+
 static struct hdf5_file_record_ref *hdf5_track_new_file_record(
     darshan_record_id rec_id, const char *path)
 {
@@ -1490,7 +1758,7 @@ static void hdf5_finalize_dataset_records(void *rec_ref_p, void *user_ptr)
     struct hdf5_dataset_record_ref *rec_ref =
         (struct hdf5_dataset_record_ref *)rec_ref_p;
 
-    tdestroy(rec_ref->access_root, free);
+    free(rec_ref->access_root);
     return;
 }
 
@@ -1743,89 +2011,6 @@ static void hdf5_dataset_record_reduction_op(void* inrec_v, void* inoutrec_v,
     return;
 }
 
-static void hdf5_shared_dataset_record_variance(
-    MPI_Comm mod_comm, struct darshan_hdf5_dataset *inrec_array,
-    struct darshan_hdf5_dataset *outrec_array, int shared_rec_count)
-{
-    MPI_Datatype var_dt;
-    MPI_Op var_op;
-    int i;
-    struct darshan_variance_dt *var_send_buf = NULL;
-    struct darshan_variance_dt *var_recv_buf = NULL;
-
-    PMPI_Type_contiguous(sizeof(struct darshan_variance_dt),
-        MPI_BYTE, &var_dt);
-    PMPI_Type_commit(&var_dt);
-
-    PMPI_Op_create(darshan_variance_reduce, 1, &var_op);
-
-    var_send_buf = malloc(shared_rec_count * sizeof(struct darshan_variance_dt));
-    if(!var_send_buf)
-        return;
-
-    if(my_rank == 0)
-    {
-        var_recv_buf = malloc(shared_rec_count * sizeof(struct darshan_variance_dt));
-
-        if(!var_recv_buf)
-            return;
-    }
-
-    /* get total i/o time variances for shared records */
-
-    /* get total i/o time variances for shared records */
-
-    for(i=0; i<shared_rec_count; i++)
-    {
-        var_send_buf[i].n = 1;
-        var_send_buf[i].S = 0;
-        var_send_buf[i].T = inrec_array[i].fcounters[H5D_F_READ_TIME] +
-                            inrec_array[i].fcounters[H5D_F_WRITE_TIME] +
-                            inrec_array[i].fcounters[H5D_F_META_TIME];
-    }
-
-    PMPI_Reduce(var_send_buf, var_recv_buf, shared_rec_count,
-        var_dt, var_op, 0, mod_comm);
-
-    if(my_rank == 0)
-    {
-        for(i=0; i<shared_rec_count; i++)
-        {
-            outrec_array[i].fcounters[H5D_F_VARIANCE_RANK_TIME] =
-                (var_recv_buf[i].S / var_recv_buf[i].n);
-        }
-    }
-
-    /* get total bytes moved variances for shared records */
-
-    for(i=0; i<shared_rec_count; i++)
-    {
-        var_send_buf[i].n = 1;
-        var_send_buf[i].S = 0;
-        var_send_buf[i].T = (double)
-                            inrec_array[i].counters[H5D_BYTES_READ] +
-                            inrec_array[i].counters[H5D_BYTES_WRITTEN];
-    }
-
-    PMPI_Reduce(var_send_buf, var_recv_buf, shared_rec_count,
-        var_dt, var_op, 0, mod_comm);
-
-    if(my_rank == 0)
-    {
-        for(i=0; i<shared_rec_count; i++)
-        {
-            outrec_array[i].fcounters[H5D_F_VARIANCE_RANK_BYTES] =
-                (var_recv_buf[i].S / var_recv_buf[i].n);
-        }
-    }
-
-    PMPI_Type_free(&var_dt);
-    PMPI_Op_free(&var_op);
-    free(var_send_buf);
-    free(var_recv_buf);
-
-    return;
-}
 #endif
 
 /************************************************************************
@@ -1844,8 +2029,7 @@ static void hdf5_file_mpi_redux(
     struct darshan_hdf5_file *hdf5_rec_buf = (struct darshan_hdf5_file *)hdf5_buf;
     struct darshan_hdf5_file *red_send_buf = NULL;
     struct darshan_hdf5_file *red_recv_buf = NULL;
-    MPI_Datatype red_type;
-    MPI_Op red_op;
+    int ret;
     int i;
 
     HDF5_LOCK();
@@ -1883,21 +2067,17 @@ static void hdf5_file_mpi_redux(
         }
     }
 
-    /* construct a datatype for a HDF5 dataset record.  This is serving no purpose
-     * except to make sure we can do a reduction on proper boundaries
-     */
-    PMPI_Type_contiguous(sizeof(struct darshan_hdf5_file), MPI_BYTE, &red_type);
-    PMPI_Type_commit(&red_type);
-
-    /* register a HDF5 dataset record reduction operator */
-    PMPI_Op_create(hdf5_file_record_reduction_op, 1, &red_op);
-
-    /* reduce shared HDF5 dataset records */
-    PMPI_Reduce(red_send_buf, red_recv_buf,
-        shared_rec_count, red_type, red_op, 0, mod_comm);
+    /* reduce shared HDF5 file records */
+    ret = darshan_shared_record_reduce(mod_comm, red_send_buf, red_recv_buf,
+        shared_rec_count, sizeof(struct darshan_hdf5_file),
+        hdf5_file_record_reduction_op, NULL, 0);
 
     /* update module state to account for shared file reduction */
-    if(my_rank == 0)
+    if(ret < 0)
+    {
+        free(red_recv_buf);
+    }
+    else if(my_rank == 0)
     {
         /* overwrite local shared records with globally reduced records */
         int tmp_ndx = rec_count - shared_rec_count;
@@ -1911,9 +2091,6 @@ static void hdf5_file_mpi_redux(
         hdf5_file_runtime->rec_count -= shared_rec_count;
     }
 
-    PMPI_Type_free(&red_type);
-    PMPI_Op_free(&red_op);
-
     HDF5_UNLOCK();
     return;
 }
@@ -1930,8 +2107,8 @@ static void hdf5_dataset_mpi_redux(
     double hdf5_time;
     struct darshan_hdf5_dataset *red_send_buf = NULL;
     struct darshan_hdf5_dataset *red_recv_buf = NULL;
-    MPI_Datatype red_type;
-    MPI_Op red_op;
+    double *var_vals = NULL;
+    int ret;
     int i;
 
     HDF5_LOCK();
@@ -1982,40 +2159,51 @@ static void hdf5_dataset_mpi_redux(
     /* make *send_buf point to the shared records at the end of sorted array */
     red_send_buf = &(hdf5_rec_buf[rec_count-shared_rec_count]);
 
-    /* allocate memory for the reduction output on rank 0 */
+    /* allocate memory for the reduction output on rank 0, and for the
+     * time and byte totals whose variances are computed along with it
+     */
+    var_vals = malloc(shared_rec_count * 2 * sizeof(double));
     if(my_rank == 0)
-    {
         red_recv_buf = malloc(shared_rec_count * sizeof(struct darshan_hdf5_dataset));
-        if(!red_recv_buf)
-        {
-            HDF5_UNLOCK();
-            return;
-        }
+    if(!var_vals || (my_rank == 0 && !red_recv_buf))
+    {
+        free(var_vals);
+        free(red_recv_buf);
+        HDF5_UNLOCK();
+        return;
+    }
+    for(i = 0; i < shared_rec_count; i++)
+    {
+        var_vals[2*i] = red_send_buf[i].fcounters[H5D_F_READ_TIME] +
+            red_send_buf[i].fcounters[H5D_F_WRITE_TIME] +
+            red_send_buf[i].fcounters[H5D_F_META_TIME];
+        var_vals[2*i+1] = (double)red_send_buf[i].counters[H5D_BYTES_READ] +
+            red_send_buf[i].counters[H5D_BYTES_WRITTEN];
     }
 
-    /* construct a datatype for a HDF5 dataset record.  This is serving no purpose
-     * except to make sure we can do a reduction on proper boundaries
+    /* reduce shared HDF5 dataset records, along with their time and byte
+     * variances
      */
-    PMPI_Type_contiguous(sizeof(struct darshan_hdf5_dataset),
-        MPI_BYTE, &red_type);
-    PMPI_Type_commit(&red_type);
-
-    /* register a HDF5 dataset record reduction operator */
-    PMPI_Op_create(hdf5_dataset_record_reduction_op, 1, &red_op);
-
-    /* reduce shared HDF5 dataset records */
-    PMPI_Reduce(red_send_buf, red_recv_buf,
-        shared_rec_count, red_type, red_op, 0, mod_comm);
-
-    /* get the time and byte variances for shared files */
-    hdf5_shared_dataset_record_variance(mod_comm, red_send_buf, red_recv_buf,
-        shared_rec_count);
+    ret = darshan_shared_record_reduce(mod_comm, red_send_buf, red_recv_buf,
+        shared_rec_count, sizeof(struct darshan_hdf5_dataset),
+        hdf5_dataset_record_reduction_op, var_vals, 2);
 
     /* update module state to account for shared file reduction */
-    if(my_rank == 0)
+    if(ret < 0)
+    {
+        free(red_recv_buf);
+    }
+    else if(my_rank == 0)
     {
         /* overwrite local shared records with globally reduced records */
         int tmp_ndx = rec_count - shared_rec_count;
+        for(i = 0; i < shared_rec_count; i++)
+        {
+            red_recv_buf[i].fcounters[H5D_F_VARIANCE_RANK_TIME] =
+                var_vals[2*i];
+            red_recv_buf[i].fcounters[H5D_F_VARIANCE_RANK_BYTES] =
+                var_vals[2*i+1];
+        }
         memcpy(&(hdf5_rec_buf[tmp_ndx]), red_recv_buf,
             shared_rec_count * sizeof(struct darshan_hdf5_dataset));
         free(red_recv_buf);
@@ -2025,9 +2213,7 @@ static void hdf5_dataset_mpi_redux(
         /* drop shared records on non-zero ranks */
         hdf5_dataset_runtime->rec_count -= shared_rec_count;
     }
-
-    PMPI_Type_free(&red_type);
-    PMPI_Op_free(&red_op);
+    free(var_vals);
 
     HDF5_UNLOCK();
     return;
@@ -50,19 +50,49 @@ double g_end_timestamp = 0;
 /* TODO: make this tunable at runtime */
 #define DARSHAN_MAX_HEATMAPS 8
 
-/* structure to track heatmaps at runtime */
+/* maximum number of epochs a heatmap can be extended by.  Each one doubles
+ * the time range covered, so this is not reached in practice; later
+ * accesses are counted in the last bin.
+ */
+#define DARSHAN_MAX_HEATMAP_EPOCHS 40
+
+/* number of bins in each epoch after the first */
+#define DARSHAN_HEATMAP_EPOCH_BINS (DARSHAN_MAX_HEATMAP_BINS/2)
+
+/* structure to track heatmaps at runtime.  Rather than collapsing the
+ * record's bins whenever an access lands beyond the time range they cover,
+ * the range is extended by epochs: epoch k (from 1) holds
+ * DARSHAN_HEATMAP_EPOCH_BINS bins of 2^k times the record's bin width,
+ * covering the time from 2^(k-1) to 2^k times the record's range, while
+ * the record's own bins are epoch 0.  Updates thus never move bins, and
+ * the epochs are folded into the record by heatmap_compact() at shutdown.
+ */
 struct heatmap_record_ref
 {
     struct darshan_heatmap_record* heatmap_rec;
+    darshan_record_id rec_id;
+    /* cached from the record's current bin width, so that updates can
+     * locate bins without dividing
+     */
+    double inv_bin_width; /* 1 / bin width */
+    double max_time; /* end of the last bin of the last epoch */
+    int nepochs; /* number of epochs after the first */
+    /* bin arrays of each epoch, back to back in heatmap_bin_arrays() order */
+    int64_t *epoch_bins[DARSHAN_MAX_HEATMAP_EPOCHS+1];
 };
 
 /* The heatmap_runtime structure maintains necessary state for storing
  * heatmap records and for coordinating with darshan-core at shutdown time.
+ * 'rec_refs' holds the first 'rec_count' tracked records, so that updates
+ * can find their record with a short scan instead of a hash lookup.
  */
 struct heatmap_runtime
 {
     void *rec_id_hash;
+    struct heatmap_record_ref *rec_refs[DARSHAN_MAX_HEATMAPS];
     int rec_count;
+    int64_t flags; /* DARSHAN_HEATMAP_F_* flags given to each record */
+    int reduce; /* DARSHAN_HEATMAP_REDUCE_* setting, or 0 */
     int frozen; /* flag to indicate that the counters should no longer be modified */
 };
 
@@ -71,11 +101,23 @@ static int my_rank = -1;
 
 static struct heatmap_record_ref *heatmap_track_new_record(
     darshan_record_id rec_id, const char *name);
-static void collapse_heatmap(struct darshan_heatmap_record *rec);
+static void heatmap_compact(struct heatmap_record_ref *rec_ref,
+    double end_timestamp);
+static void heatmap_free_epochs(struct heatmap_record_ref *rec_ref);
+static void heatmap_set_bin_width(struct heatmap_record_ref *rec_ref);
+static size_t heatmap_rec_size(int64_t flags, int64_t nbins);
+static void heatmap_set_bin_ptrs(struct darshan_heatmap_record *rec,
+    int64_t nbins);
+static int heatmap_bin_arrays(struct darshan_heatmap_record *rec,
+    int64_t **arrays);
+static size_t heatmap_encode_sparse(struct darshan_heatmap_record *rec,
+    int64_t *buf);
 #ifdef HAVE_MPI
 static void heatmap_mpi_redux(
     void *stdio_buf, MPI_Comm mod_comm,
     darshan_record_id *shared_recs, int shared_rec_count);
+static void heatmap_reduce_bins(
+    MPI_Comm mod_comm, darshan_record_id *shared_recs, int shared_rec_count);
 #endif
 
 #ifdef HAVE_STDATOMIC_H
@@ -127,9 +169,16 @@ static void heatmap_output(
     struct darshan_heatmap_record* rec;
     struct darshan_heatmap_record* next_rec;
     void* contig_buf_ptr;
-    int i,j;
+    int64_t *arrays[DARSHAN_HEATMAP_NARRAYS(DARSHAN_HEATMAP_F_OP_BINS)];
+    /* large enough to sparsely encode a record with every bin nonzero */
+    int64_t sparse_buf[1 + DARSHAN_MAX_HEATMAP_BINS *
+        (1 + DARSHAN_HEATMAP_NARRAYS(DARSHAN_HEATMAP_F_OP_BINS))];
+    int narrays;
+    int i,j,k;
     double end_timestamp;
     unsigned long this_size;
+    size_t rec_size;
+    size_t sparse_size;
     int tmp_nbins;
     int empty;
 
@@ -147,6 +196,16 @@ static void heatmap_output(
     else
         end_timestamp = darshan_core_wtime();
 
+    /* every record is allocated with room for the maximum number of bins */
+    rec_size = heatmap_rec_size(heatmap_runtime->flags,
+        DARSHAN_MAX_HEATMAP_BINS);
+
+    /* fold the epochs of each record into it, at the bin width that
+     * extends to the end of execution time, so that all of the heatmap
+     * records have a consistent size
+     */
+    for(i=0; i<heatmap_runtime->rec_count; i++)
+        heatmap_compact(heatmap_runtime->rec_refs[i], end_timestamp);
 
     /* iterate through records (heatmap histograms) to drop any that contain
      * no data
@@ -154,15 +213,19 @@ static void heatmap_output(
     for(i=0; i<heatmap_runtime->rec_count; i++)
     {
         do {
-            rec = (struct darshan_heatmap_record*)((uintptr_t)*heatmap_buf + i*(sizeof(*rec) + DARSHAN_MAX_HEATMAP_BINS*2*sizeof(int64_t)));
-            next_rec = (struct darshan_heatmap_record*)((uintptr_t)*heatmap_buf + (i+1)*(sizeof(*rec) + DARSHAN_MAX_HEATMAP_BINS*2*sizeof(int64_t)));
+            rec = (struct darshan_heatmap_record*)((uintptr_t)*heatmap_buf + i*rec_size);
+            next_rec = (struct darshan_heatmap_record*)((uintptr_t)*heatmap_buf + (i+1)*rec_size);
 
             empty = 1;
-            for(j=0; j<DARSHAN_MAX_HEATMAP_BINS; j++)
+            narrays = heatmap_bin_arrays(rec, arrays);
+            for(k=0; k<narrays && empty; k++)
             {
-                if(rec->write_bins[j] > 0 || rec->read_bins[j] > 0) {
-                    empty = 0;
-                    break;
+                for(j=0; j<DARSHAN_MAX_HEATMAP_BINS; j++)
+                {
+                    if(arrays[k][j] > 0) {
+                        empty = 0;
+                        break;
+                    }
                 }
             }
             /* reduce record count if this heatmap is empty */
@@ -171,19 +234,13 @@ static void heatmap_output(
                 /* if there are more heatmaps after this one, shift them all down */
                 if (i < heatmap_runtime->rec_count) {
                     memmove(rec, next_rec,
-                            (heatmap_runtime->rec_count - i) *
-                            (sizeof(*rec) + DARSHAN_MAX_HEATMAP_BINS * 2 * sizeof(int64_t)));
+                            (heatmap_runtime->rec_count - i) * rec_size);
                     /* fix pointers in any heatmaps that were compacted */
                     for (j = 0; j < heatmap_runtime->rec_count - i; j++) {
-                        rec->write_bins
-                            = (int64_t*)((uintptr_t)rec + sizeof(*rec));
-                        rec->read_bins
-                            = (int64_t*)((uintptr_t)rec + sizeof(*rec)
-                              + DARSHAN_MAX_HEATMAP_BINS * sizeof(int64_t));
+                        heatmap_set_bin_ptrs(rec, DARSHAN_MAX_HEATMAP_BINS);
                         rec = (struct
                               darshan_heatmap_record*)((uintptr_t)rec
-                              + (sizeof(*rec) + DARSHAN_MAX_HEATMAP_BINS
-                              * 2 * sizeof(int64_t)));
+                              + rec_size);
                     }
                 }
             }
@@ -197,14 +254,7 @@ static void heatmap_output(
     contig_buf_ptr = *heatmap_buf;
     for(i=0; i<heatmap_runtime->rec_count; i++)
     {
-        rec = (struct darshan_heatmap_record*)((uintptr_t)*heatmap_buf + i*(sizeof(*rec) + DARSHAN_MAX_HEATMAP_BINS*2*sizeof(int64_t)));
-
-        /* Collapse records if needed until the total histogram time range
-         * extends to end of execution time.  This will ensure that all of
-         * the heatmap records have a consistent size
-         */
-        while(end_timestamp > rec->bin_width_seconds * DARSHAN_MAX_HEATMAP_BINS)
-            collapse_heatmap(rec);
+        rec = (struct darshan_heatmap_record*)((uintptr_t)*heatmap_buf + i*rec_size);
 
         tmp_nbins= ceil(end_timestamp/rec->bin_width_seconds);
 
@@ -215,18 +265,32 @@ static void heatmap_output(
              * instrumentation stopped
              */
             rec->nbins = tmp_nbins;
-            /* shift read_bins down so that memory remains contiguous even
-             * if nbins has been reduced
+            /* shift the bin arrays following write_bins down so that memory
+             * remains contiguous even if nbins has been reduced
              */
-            memmove(&rec->write_bins[rec->nbins], rec->read_bins,
-                rec->nbins*sizeof(int64_t));
-            rec->read_bins = &rec->write_bins[rec->nbins];
+            narrays = heatmap_bin_arrays(rec, arrays);
+            for(k=1; k<narrays; k++)
+                memmove(&rec->write_bins[k*rec->nbins], arrays[k],
+                    rec->nbins*sizeof(int64_t));
+            heatmap_set_bin_ptrs(rec, rec->nbins);
         }
 
         /* now shift the entire record + bins as a contiguous block down in
          * the buffer so that the entire buffer is contiguous
          */
-        this_size = sizeof(*rec) + rec->nbins * 2 * sizeof(uint64_t);
+        this_size = heatmap_rec_size(rec->flags, rec->nbins);
+
+        /* most ranks only do I/O in a few bins, so store the bins sparsely
+         * whenever that is smaller than storing them densely
+         */
+        sparse_size = heatmap_encode_sparse(rec, sparse_buf);
+        if(sizeof(*rec) + sparse_size < this_size)
+        {
+            rec->flags |= DARSHAN_HEATMAP_F_SPARSE;
+            memcpy((void *)((uintptr_t)rec + sizeof(*rec)), sparse_buf,
+                sparse_size);
+            this_size = sizeof(*rec) + sparse_size;
+        }
         memmove(contig_buf_ptr, rec, this_size);
         contig_buf_ptr += this_size;
         *heatmap_buf_sz += this_size;
@@ -239,10 +303,17 @@ static void heatmap_output(
 
 static void heatmap_cleanup()
 {
+    int i;
+
     HEATMAP_LOCK();
     assert(heatmap_runtime);
 
     /* cleanup internal structures used for instrumenting */
+    for(i=0; i<DARSHAN_MAX_HEATMAPS; i++)
+    {
+        if(heatmap_runtime->rec_refs[i])
+            heatmap_free_epochs(heatmap_runtime->rec_refs[i]);
+    }
     darshan_clear_record_refs(&(heatmap_runtime->rec_id_hash), 1);
 
     free(heatmap_runtime);
@@ -256,10 +327,8 @@ struct heatmap_runtime* heatmap_runtime_initialize(void)
 {
     struct heatmap_runtime* tmp_runtime;
     int ret;
-    /* NOTE: this module generates one record per module that uses it, so
-     * the memory requirements should be modest
-     */
-    size_t heatmap_buf_size = sizeof(struct darshan_heatmap_record) + 2*DARSHAN_MAX_HEATMAP_BINS*sizeof(int64_t);
+    int64_t flags = 0;
+    size_t heatmap_buf_size;
     size_t heatmap_rec_count = DARSHAN_MAX_HEATMAPS;
 
     darshan_module_funcs mod_funcs = {
@@ -270,6 +339,13 @@ struct heatmap_runtime* heatmap_runtime_initialize(void)
         .mod_cleanup_func = heatmap_cleanup
     };
 
+    if(darshan_core_heatmap_ops_enabled())
+        flags |= DARSHAN_HEATMAP_F_OP_BINS;
+    /* NOTE: this module generates one record per module that uses it, so
+     * the memory requirements should be modest
+     */
+    heatmap_buf_size = heatmap_rec_size(flags, DARSHAN_MAX_HEATMAP_BINS);
+
     /* register the heatmap module with darshan core */
     /* note that we aren't holding a lock in this module at this point, but
      * the core will serialize internally and return if this module is
@@ -291,6 +367,8 @@ struct heatmap_runtime* heatmap_runtime_initialize(void)
         return(NULL);
     }
     memset(tmp_runtime, 0, sizeof(*tmp_runtime));
+    tmp_runtime->flags = flags;
+    tmp_runtime->reduce = darshan_core_heatmap_reduce();
 
     return(tmp_runtime);
 }
@@ -339,30 +417,309 @@ darshan_record_id heatmap_register(const char* name)
     return(ret);
 }
 
-static void collapse_heatmap(struct darshan_heatmap_record *rec)
+/* fold the epochs of a heatmap into its record, widening the record's bins
+ * to the smallest width that covers both the epochs and 'end_timestamp'.
+ * This is the only place bins are merged, so updates never have to.
+ */
+static void heatmap_compact(struct heatmap_record_ref *rec_ref,
+    double end_timestamp)
+{
+    struct darshan_heatmap_record *rec = rec_ref->heatmap_rec;
+    int64_t *arrays[DARSHAN_HEATMAP_NARRAYS(DARSHAN_HEATMAP_F_OP_BINS)];
+    int64_t *bins, *epoch;
+    int64_t val;
+    double range;
+    int narrays;
+    int shift;
+    int i,j,k;
+
+    /* every doubling of the bin width doubles the time range */
+    shift = rec_ref->nepochs;
+    range = rec_ref->max_time;
+    while(end_timestamp > range)
+    {
+        shift++;
+        range *= 2.0;
+    }
+    if(shift == 0)
+        return;
+
+    narrays = heatmap_bin_arrays(rec, arrays);
+    for(k=0; k<narrays; k++)
+    {
+        /* merge the record's own bins in place; each bin moves down */
+        bins = arrays[k];
+        for(i=0; i<DARSHAN_MAX_HEATMAP_BINS; i++)
+        {
+            val = bins[i];
+            bins[i] = 0;
+            bins[i >> shift] += val;
+        }
+        /* bin j of epoch e starts at (DARSHAN_HEATMAP_EPOCH_BINS + j)
+         * times its width of 2^e record bins
+         */
+        for(j=1; j<=rec_ref->nepochs; j++)
+        {
+            epoch = rec_ref->epoch_bins[j] + k*DARSHAN_HEATMAP_EPOCH_BINS;
+            for(i=0; i<DARSHAN_HEATMAP_EPOCH_BINS; i++)
+                bins[(DARSHAN_HEATMAP_EPOCH_BINS + i) >> (shift - j)] += epoch[i];
+        }
+    }
+    heatmap_free_epochs(rec_ref);
+
+    rec->bin_width_seconds = ldexp(rec->bin_width_seconds, shift);
+    heatmap_set_bin_width(rec_ref);
+
+    return;
+}
+
+static void heatmap_free_epochs(struct heatmap_record_ref *rec_ref)
+{
+    int i;
+
+    for(i=1; i<=rec_ref->nepochs; i++)
+    {
+        free(rec_ref->epoch_bins[i]);
+        rec_ref->epoch_bins[i] = NULL;
+    }
+    rec_ref->nepochs = 0;
+
+    return;
+}
+
+/* add epochs to a heatmap until it covers 'end_time', or no more can be
+ * added.  Returns -1 if memory for an epoch could not be allocated.
+ */
+static int heatmap_add_epochs(struct heatmap_record_ref *rec_ref,
+    double end_time)
+{
+    int64_t *bins;
+
+    while(end_time > rec_ref->max_time &&
+        rec_ref->nepochs < DARSHAN_MAX_HEATMAP_EPOCHS)
+    {
+        bins = calloc(DARSHAN_HEATMAP_NARRAYS(rec_ref->heatmap_rec->flags) *
+            DARSHAN_HEATMAP_EPOCH_BINS, sizeof(*bins));
+        if(!bins)
+            return(-1);
+        rec_ref->nepochs++;
+        rec_ref->epoch_bins[rec_ref->nepochs] = bins;
+        rec_ref->max_time *= 2.0;
+    }
+
+    return(0);
+}
+
+/* find the bin holding the time 'u', in units of the record's bin width,
+ * returning its index within its epoch.  The epoch, and the bin's start
+ * and width in the same units, are stored in the remaining arguments.
+ * Times beyond the last epoch are counted in its last bin.
+ */
+static inline int heatmap_find_bin(struct heatmap_record_ref *rec_ref,
+    double u, int *epoch, double *bottom, double *width)
+{
+    int index;
+    int k;
+
+    if(u < DARSHAN_MAX_HEATMAP_BINS)
+    {
+        index = (u > 0) ? u : 0;
+        *epoch = 0;
+        *width = 1.0;
+        *bottom = index;
+        return(index);
+    }
+
+    /* epoch k covers [2^(k-1), 2^k) times the record's range */
+    frexp(u / DARSHAN_MAX_HEATMAP_BINS, &k);
+    if(k > rec_ref->nepochs)
+    {
+        /* an access ending exactly at the end of the last bin belongs to
+         * it, as does any later one
+         */
+        k = rec_ref->nepochs;
+        u = ldexp(DARSHAN_MAX_HEATMAP_BINS, k) - 1;
+        if(k == 0)
+        {
+            *epoch = 0;
+            *width = 1.0;
+            *bottom = DARSHAN_MAX_HEATMAP_BINS - 1;
+            return(DARSHAN_MAX_HEATMAP_BINS - 1);
+        }
+    }
+    *epoch = k;
+    *width = ldexp(1.0, k);
+    index = (int)(u / *width) - DARSHAN_HEATMAP_EPOCH_BINS;
+    if(index >= DARSHAN_HEATMAP_EPOCH_BINS)
+        index = DARSHAN_HEATMAP_EPOCH_BINS - 1;
+    *bottom = (DARSHAN_HEATMAP_EPOCH_BINS + index) * *width;
+
+    return(index);
+}
+
+/* the bin array 'k' (in heatmap_bin_arrays() order) of an epoch */
+static inline int64_t *heatmap_epoch_array(struct heatmap_record_ref *rec_ref,
+    int epoch, int k)
+{
+    if(epoch == 0)
+        return(rec_ref->heatmap_rec->write_bins + k*DARSHAN_MAX_HEATMAP_BINS);
+    return(rec_ref->epoch_bins[epoch] + k*DARSHAN_HEATMAP_EPOCH_BINS);
+}
+
+/* refresh the values cached from the record's bin width */
+static void heatmap_set_bin_width(struct heatmap_record_ref *rec_ref)
+{
+    rec_ref->inv_bin_width = 1.0 / rec_ref->heatmap_rec->bin_width_seconds;
+    rec_ref->max_time = ldexp(rec_ref->heatmap_rec->bin_width_seconds *
+        DARSHAN_MAX_HEATMAP_BINS, rec_ref->nepochs);
+
+    return;
+}
+
+/* size of a heatmap record whose bin arrays each hold 'nbins' bins */
+static size_t heatmap_rec_size(int64_t flags, int64_t nbins)
+{
+    return(sizeof(struct darshan_heatmap_record) +
+        DARSHAN_HEATMAP_NARRAYS(flags)*nbins*sizeof(int64_t));
+}
+
+/* point a record's bin arrays at the 'nbins' sized arrays trailing it */
+static void heatmap_set_bin_ptrs(struct darshan_heatmap_record *rec,
+    int64_t nbins)
+{
+    int64_t *bins = (int64_t*)((uintptr_t)rec + sizeof(*rec));
+
+    rec->write_bins = bins;
+    rec->read_bins = bins + nbins;
+    if(rec->flags & DARSHAN_HEATMAP_F_OP_BINS)
+    {
+        rec->write_op_bins = bins + 2*nbins;
+        rec->read_op_bins = bins + 3*nbins;
+        rec->meta_op_bins = bins + 4*nbins;
+    }
+    else
+    {
+        rec->write_op_bins = NULL;
+        rec->read_op_bins = NULL;
+        rec->meta_op_bins = NULL;
+    }
+
+    return;
+}
+
+/* store a record's bin arrays in 'arrays' in the order they trail the
+ * record, returning how many there are
+ */
+static int heatmap_bin_arrays(struct darshan_heatmap_record *rec,
+    int64_t **arrays)
+{
+    int narrays = 0;
+
+    arrays[narrays++] = rec->write_bins;
+    arrays[narrays++] = rec->read_bins;
+    if(rec->flags & DARSHAN_HEATMAP_F_OP_BINS)
+    {
+        arrays[narrays++] = rec->write_op_bins;
+        arrays[narrays++] = rec->read_op_bins;
+        arrays[narrays++] = rec->meta_op_bins;
+    }
+
+    return(narrays);
+}
+
+/* encode the bins of 'rec' in the sparse log layout (see
+ * darshan-heatmap-log-format.h) into 'buf', returning the encoded size in
+ * bytes
+ */
+static size_t heatmap_encode_sparse(struct darshan_heatmap_record *rec,
+    int64_t *buf)
+{
+    int64_t *arrays[DARSHAN_HEATMAP_NARRAYS(DARSHAN_HEATMAP_F_OP_BINS)];
+    int64_t *entry = &buf[1];
+    int64_t nnz = 0;
+    int narrays;
+    int i,k;
+
+    narrays = heatmap_bin_arrays(rec, arrays);
+    for(i=0; i<rec->nbins; i++)
+    {
+        for(k=0; k<narrays; k++)
+        {
+            if(arrays[k][i])
+                break;
+        }
+        if(k == narrays)
+            continue;
+
+        *entry++ = i;
+        for(k=0; k<narrays; k++)
+            *entry++ = arrays[k][i];
+        nnz++;
+    }
+    buf[0] = nnz;
+
+    return(DARSHAN_HEATMAP_SPARSE_SIZE(rec->flags, nnz));
+}
+
+/* find the heatmap with the given id and extend it by epochs as needed so
+ * that it can hold an update ending at 'end_time'.  Must be called with the
+ * heatmap lock held.
+ */
+static struct heatmap_record_ref *heatmap_prepare_update(
+    darshan_record_id heatmap_id, double end_time)
 {
+    struct heatmap_record_ref *rec_ref = NULL;
     int i;
 
-    /* collapse write bins */
-    for(i=0; i<DARSHAN_MAX_HEATMAP_BINS; i+=2)
+    for(i = 0; i < heatmap_runtime->rec_count; i++)
     {
-        rec->write_bins[i] += rec->write_bins[i+1]; /* accumulate adjacent bins */
-        rec->write_bins[i/2] = rec->write_bins[i];  /* shift down */
+        if(heatmap_runtime->rec_refs[i]->rec_id == heatmap_id)
+        {
+            rec_ref = heatmap_runtime->rec_refs[i];
+            break;
+        }
     }
-    /* zero out second half of heatmap */
-    memset(&rec->write_bins[DARSHAN_MAX_HEATMAP_BINS/2], 0, (DARSHAN_MAX_HEATMAP_BINS/2)*sizeof(int64_t));
+    /* the heatmap should have already been instantiated in the register
+     * function; something is wrong if we can't find it now
+     */
+    if(!rec_ref)
+        return(NULL);
+
+    /* is current update out of bounds with histogram size?  if so, add
+     * epochs; the bins already recorded are left where they are
+     */
+    if(end_time > rec_ref->max_time &&
+        heatmap_add_epochs(rec_ref, end_time) < 0)
+        return(NULL);
 
-    /* collapse read bins */
-    for(i=0; i<DARSHAN_MAX_HEATMAP_BINS; i+=2)
+    return(rec_ref);
+}
+
+void heatmap_update_meta(darshan_record_id heatmap_id,
+    double start_time, double end_time)
+{
+    struct heatmap_record_ref *rec_ref;
+    int bin_index;
+    int epoch;
+    double bottom, width;
+
+    HEATMAP_PRE_RECORD_VOID();
+
+    if(!(heatmap_runtime->flags & DARSHAN_HEATMAP_F_OP_BINS))
     {
-        rec->read_bins[i] += rec->read_bins[i+1]; /* accumulate adjacent bins */
-        rec->read_bins[i/2] = rec->read_bins[i];  /* shift down */
+        HEATMAP_POST_RECORD();
+        return;
     }
-    /* zero out second half of heatmap */
-    memset(&rec->read_bins[DARSHAN_MAX_HEATMAP_BINS/2], 0, (DARSHAN_MAX_HEATMAP_BINS/2)*sizeof(int64_t));
 
-    /* double bin width */
-    rec->bin_width_seconds *= 2.0;
+    rec_ref = heatmap_prepare_update(heatmap_id, end_time);
+    if(!rec_ref) { HEATMAP_POST_RECORD(); return; }
+
+    /* like data operations, count the operation in the bin it started in */
+    bin_index = heatmap_find_bin(rec_ref, start_time * rec_ref->inv_bin_width,
+        &epoch, &bottom, &width);
+    heatmap_epoch_array(rec_ref, epoch, 4)[bin_index]++;
+
+    HEATMAP_POST_RECORD();
 
     return;
 }
@@ -370,9 +727,15 @@ static void collapse_heatmap(struct darshan_heatmap_record *rec)
 void heatmap_update(darshan_record_id heatmap_id, int rw_flag,
     int64_t size, double start_time, double end_time)
 {
-    struct heatmap_record_ref *rec_ref;
+    struct heatmap_record_ref *rec_ref = NULL;
+    int64_t *bins;
     int bin_index = 0;
-    double top_boundary, bottom_boundary, seconds_in_bin;
+    int end_bin;
+    int epoch, end_epoch;
+    int array;
+    double start, end;
+    double bottom, width, end_bottom, end_width;
+    double units_in_bin;
     int64_t intermediate_bytes;
 
     /* if size is zero, we have no work to do here */
@@ -380,41 +743,59 @@ void heatmap_update(darshan_record_id heatmap_id, int rw_flag,
 
     HEATMAP_PRE_RECORD_VOID();
 
-    rec_ref = darshan_lookup_record_ref(heatmap_runtime->rec_id_hash, &heatmap_id, sizeof(darshan_record_id));
-    /* the heatmap should have already been instantiated in the register
-     * function; something is wrong if we can't find it now
-     */
+    rec_ref = heatmap_prepare_update(heatmap_id, end_time);
     if(!rec_ref) { HEATMAP_POST_RECORD(); return; }
 
-    /* is current update out of bounds with histogram size?  if so, collapse */
-    while(end_time > rec_ref->heatmap_rec->bin_width_seconds * DARSHAN_MAX_HEATMAP_BINS)
-        collapse_heatmap(rec_ref->heatmap_rec);
-
     /* once we fall through to this point, we know that the current heatmap
-     * granularity is sufficiently large to hold this update
+     * epochs are sufficient to hold this update
+     */
+    array = (rw_flag == HEATMAP_WRITE) ? 0 : 1;
+
+    /* locate the bins in units of the record's bin width */
+    start = start_time * rec_ref->inv_bin_width;
+    end = end_time * rec_ref->inv_bin_width;
+    bin_index = heatmap_find_bin(rec_ref, start, &epoch, &bottom, &width);
+    end_bin = heatmap_find_bin(rec_ref, end, &end_epoch, &end_bottom,
+        &end_width);
+    if(epoch > end_epoch || (epoch == end_epoch && bin_index > end_bin))
+    {
+        bin_index = end_bin;
+        epoch = end_epoch;
+        bottom = end_bottom;
+        width = end_width;
+    }
+
+    /* operations are counted in the bin that they started in */
+    if(rec_ref->heatmap_rec->flags & DARSHAN_HEATMAP_F_OP_BINS)
+        heatmap_epoch_array(rec_ref, epoch, array + 2)[bin_index]++;
+
+    /* most accesses start and end within a single bin, which then gets all
+     * of their bytes
      */
+    bins = heatmap_epoch_array(rec_ref, epoch, array);
+    if(end_bin == bin_index && end_epoch == epoch)
+    {
+        bins[bin_index] += size;
+        HEATMAP_POST_RECORD();
+        return;
+    }
 
-    /* loop through bins to be updated (a given access may cross bin
-     * boundaries) */
-    /* note: counting on the below type conversion to round down to lower
-     * integer */
-    for(bin_index = start_time/rec_ref->heatmap_rec->bin_width_seconds; bin_index < (int)(end_time/rec_ref->heatmap_rec->bin_width_seconds + 1); bin_index++)
+    /* otherwise loop through bins to be updated, proportionally assigning
+     * bytes to the bins that the access crosses
+     */
+    while(1)
     {
         /* starting assumption about how much time this update spent in
-         * current bin
+         * current bin, truncated if the update started after its bottom
+         * boundary or ended before its top boundary
          */
-        seconds_in_bin = rec_ref->heatmap_rec->bin_width_seconds;
-        /* calculate where bin starts and stops */
-        bottom_boundary = bin_index * rec_ref->heatmap_rec->bin_width_seconds;
-        top_boundary = bottom_boundary + rec_ref->heatmap_rec->bin_width_seconds;
-        /* truncate if update started after bottom boundary */
-        if(start_time > bottom_boundary)
-            seconds_in_bin -= start_time-bottom_boundary;
-        /* truncate if update ended before top boundary */
-        if(end_time < top_boundary)
-            seconds_in_bin -= top_boundary-end_time;
-
-        if(seconds_in_bin < 0){
+        units_in_bin = width;
+        if(start > bottom)
+            units_in_bin -= start-bottom;
+        if(end < bottom + width)
+            units_in_bin -= bottom+width-end;
+
+        if(units_in_bin < 0){
             /* this should never happen; really this is an assertion
              * condition but here we just bail out to avoid disrupting the
              * application.
@@ -423,18 +804,27 @@ void heatmap_update(darshan_record_id heatmap_id, int rw_flag,
             return;
         }
 
-        if(end_time > start_time)
-            intermediate_bytes = round(size * (seconds_in_bin/(end_time-start_time)));
+        if(end > start)
+            intermediate_bytes = round(size * (units_in_bin/(end-start)));
         else
             intermediate_bytes = size;
 
         /* proportionally assign bytes to this bin */
-        if(rw_flag == HEATMAP_WRITE)
-            rec_ref->heatmap_rec->write_bins[bin_index] +=
-                intermediate_bytes;
-        else
-            rec_ref->heatmap_rec->read_bins[bin_index] +=
-                intermediate_bytes;
+        bins[bin_index] += intermediate_bytes;
+
+        if(bin_index == end_bin && epoch == end_epoch)
+            break;
+
+        /* move to the next bin, which may start the next epoch */
+        bottom += width;
+        bin_index++;
+        if(bin_index == (epoch ? DARSHAN_HEATMAP_EPOCH_BINS : DARSHAN_MAX_HEATMAP_BINS))
+        {
+            epoch++;
+            bin_index = 0;
+            width *= 2.0;
+            bins = heatmap_epoch_array(rec_ref, epoch, array);
+        }
     }
 
     HEATMAP_POST_RECORD();
@@ -464,12 +854,14 @@ static struct heatmap_record_ref *heatmap_track_new_record(
     }
 
     /* register with darshan-core so it is persisted in the log file */
-    /* include enough space for 2x number of heatmap bins (read and write) */
+    /* include enough space for each array of heatmap bins (read and write,
+     * plus op counts if enabled)
+     */
     heatmap_rec = darshan_core_register_record(
         rec_id,
         name,
         DARSHAN_HEATMAP_MOD,
-        sizeof(struct darshan_heatmap_record)+(2*DARSHAN_MAX_HEATMAP_BINS*sizeof(int64_t)),
+        heatmap_rec_size(heatmap_runtime->flags, DARSHAN_MAX_HEATMAP_BINS),
         NULL);
 
     if(!heatmap_rec)
@@ -485,9 +877,12 @@ static struct heatmap_record_ref *heatmap_track_new_record(
     heatmap_rec->base_rec.rank = my_rank;
     heatmap_rec->bin_width_seconds = DARSHAN_INITIAL_BIN_WIDTH_SECONDS;
     heatmap_rec->nbins = DARSHAN_MAX_HEATMAP_BINS;
-    heatmap_rec->write_bins = (int64_t*)((uintptr_t)heatmap_rec + sizeof(*heatmap_rec));
-    heatmap_rec->read_bins = (int64_t*)((uintptr_t)heatmap_rec + sizeof(*heatmap_rec) + heatmap_rec->nbins*sizeof(int64_t));
+    heatmap_rec->flags = heatmap_runtime->flags;
+    heatmap_set_bin_ptrs(heatmap_rec, heatmap_rec->nbins);
     rec_ref->heatmap_rec = heatmap_rec;
+    rec_ref->rec_id = rec_id;
+    heatmap_set_bin_width(rec_ref);
+    heatmap_runtime->rec_refs[heatmap_runtime->rec_count] = rec_ref;
     heatmap_runtime->rec_count++;
 
     return(rec_ref);
@@ -501,7 +896,9 @@ static void heatmap_mpi_redux(
     double end_timestamp;
 
     /* NOTE: no actual record reduction here.  We are just using this as an
-     * opportunity to agree on shutdown times.
+     * opportunity to agree on shutdown times, so that every rank compacts
+     * and truncates all of its bin arrays (bytes and op counts alike) to
+     * the same timeline.
      */
 
     HEATMAP_LOCK();
@@ -517,6 +914,66 @@ static void heatmap_mpi_redux(
      */
     PMPI_Allreduce(&end_timestamp, &g_end_timestamp, 1, MPI_DOUBLE,
         MPI_MAX, mod_comm);
+
+    if(heatmap_runtime->reduce)
+        heatmap_reduce_bins(mod_comm, shared_recs, shared_rec_count);
+}
+
+/* sum the bins of the heatmaps shared by all ranks onto the lowest rank of
+ * each node, or onto rank 0, according to the HEATMAP_REDUCE setting.  The
+ * heatmaps are first compacted to the bin width the agreed end timestamp
+ * calls for, which is the same on every rank, so that their bins line up.
+ * The bins of the other ranks are zeroed, so heatmap_output() drops their
+ * copies as empty.
+ */
+static void heatmap_reduce_bins(MPI_Comm mod_comm,
+    darshan_record_id *shared_recs, int shared_rec_count)
+{
+    struct heatmap_record_ref *rec_ref;
+    struct darshan_heatmap_record *rec;
+    MPI_Comm red_comm = mod_comm;
+    int red_rank;
+    int nvals;
+    int i;
+
+    if(heatmap_runtime->reduce == DARSHAN_HEATMAP_REDUCE_NODE)
+    {
+        PMPI_Comm_rank(mod_comm, &red_rank);
+        PMPI_Comm_split_type(mod_comm, MPI_COMM_TYPE_SHARED, red_rank,
+            MPI_INFO_NULL, &red_comm);
+    }
+    PMPI_Comm_rank(red_comm, &red_rank);
+
+    /* shared records are listed in the same order on every rank */
+    for(i = 0; i < shared_rec_count; i++)
+    {
+        rec_ref = darshan_lookup_record_ref(heatmap_runtime->rec_id_hash,
+            &shared_recs[i], sizeof(darshan_record_id));
+        assert(rec_ref);
+        rec = rec_ref->heatmap_rec;
+
+        heatmap_compact(rec_ref, g_end_timestamp);
+
+        /* the bin arrays trail the record back to back */
+        nvals = DARSHAN_HEATMAP_NARRAYS(rec->flags) * DARSHAN_MAX_HEATMAP_BINS;
+        if(red_rank == 0)
+        {
+            PMPI_Reduce(MPI_IN_PLACE, rec->write_bins, nvals, MPI_INT64_T,
+                MPI_SUM, 0, red_comm);
+            rec->flags |= DARSHAN_HEATMAP_F_REDUCED;
+            if(heatmap_runtime->reduce == DARSHAN_HEATMAP_REDUCE_JOB)
+                rec->base_rec.rank = -1;
+        }
+        else
+        {
+            PMPI_Reduce(rec->write_bins, NULL, nvals, MPI_INT64_T, MPI_SUM,
+                0, red_comm);
+            memset(rec->write_bins, 0, nvals * sizeof(int64_t));
+        }
+    }
+
+    if(red_comm != mod_comm)
+        PMPI_Comm_free(&red_comm);
 }
 #endif
 /*
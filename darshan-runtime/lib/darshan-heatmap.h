@@ -28,6 +28,28 @@ darshan_record_id heatmap_register(const char* name);
 void heatmap_update(darshan_record_id heatmap_id, int rw_flag,
     int64_t size, double start_time, double end_time);
 
+/* heatmap_update_meta()
+ *
+ * function to record a metadata operation (e.g., open, stat, or close);
+ * only counted if heatmap op counts are enabled
+ */
+void heatmap_update_meta(darshan_record_id heatmap_id,
+    double start_time, double end_time);
+
+/* heatmap_register() returns 0 when the heatmap is disabled at runtime, so
+ * modules record through these macros to skip the call entirely in that
+ * case
+ */
+#define HEATMAP_UPDATE(__heatmap_id, __rw_flag, __size, __tm1, __tm2) do { \
+    if(__heatmap_id) \
+        heatmap_update(__heatmap_id, __rw_flag, __size, __tm1, __tm2); \
+} while(0)
+
+#define HEATMAP_UPDATE_META(__heatmap_id, __tm1, __tm2) do { \
+    if(__heatmap_id) \
+        heatmap_update_meta(__heatmap_id, __tm1, __tm2); \
+} while(0)
+
 #else
 
 /* The heatmap API functions are often invoked from within large macros in
@@ -43,6 +65,15 @@ static inline darshan_record_id heatmap_register(const char* name) {
 #define heatmap_update(heatmap_id, rw_flag, size, start_time, end_time) \
 do {} while(0)
 
+#define heatmap_update_meta(heatmap_id, start_time, end_time) \
+do {} while(0)
+
+#define HEATMAP_UPDATE(__heatmap_id, __rw_flag, __size, __tm1, __tm2) \
+do {} while(0)
+
+#define HEATMAP_UPDATE_META(__heatmap_id, __tm1, __tm2) \
+do {} while(0)
+
 #endif
 
 #endif /* __DARSHAN_HEATMAP_H */
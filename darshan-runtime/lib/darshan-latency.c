@@ -0,0 +1,367 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <darshan-runtime-config.h>
+#endif
+
+#define _XOPEN_SOURCE 500
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "darshan.h"
+#include "darshan-latency.h"
+
+/* The latency_record_ref structure maintains necessary runtime metadata
+ * for each LATENCY record, indexed by the POSIX or MPI-IO record id of the
+ * file it describes.
+ */
+struct latency_record_ref
+{
+    struct darshan_latency_record *record_p;
+};
+
+/* The latency_runtime structure maintains necessary state for storing
+ * LATENCY records and for coordinating with darshan-core at shutdown time.
+ */
+struct latency_runtime
+{
+    void *rec_id_hash;
+    int rec_count;
+    int frozen; /* flag to indicate that the counters should no longer be modified */
+};
+
+int latency_runtime_enabled = 0;
+
+static struct latency_runtime *latency_runtime = NULL;
+static pthread_mutex_t latency_runtime_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int my_rank = -1;
+
+static struct latency_record_ref *latency_track_new_record(
+    darshan_record_id rec_id);
+#ifdef HAVE_MPI
+static void latency_record_reduction_op(
+    void* infile_v, void* inoutfile_v, int *len, MPI_Datatype *datatype);
+static void latency_mpi_redux(
+    void *latency_buf, MPI_Comm mod_comm,
+    darshan_record_id *shared_recs, int shared_rec_count);
+#endif
+static void latency_output(
+    void **latency_buf, int *latency_buf_sz);
+static void latency_cleanup(
+    void);
+
+#define LATENCY_LOCK() pthread_mutex_lock(&latency_runtime_mutex)
+#define LATENCY_UNLOCK() pthread_mutex_unlock(&latency_runtime_mutex)
+
+/**********************************************************
+ *       Hook for recording POSIX and MPI-IO latencies    *
+ **********************************************************/
+
+void latency_update(darshan_record_id rec_id, int op, int64_t us)
+{
+    struct latency_record_ref *rec_ref;
+
+    if(op < 0 || op >= LATENCY_OP_COUNT)
+        return;
+
+    LATENCY_LOCK();
+    if(!latency_runtime || latency_runtime->frozen)
+    {
+        LATENCY_UNLOCK();
+        return;
+    }
+
+    rec_ref = darshan_lookup_record_ref(latency_runtime->rec_id_hash,
+        &rec_id, sizeof(darshan_record_id));
+    if(!rec_ref)
+        rec_ref = latency_track_new_record(rec_id);
+    if(rec_ref)
+    {
+        rec_ref->record_p->counters[op * LATENCY_NUM_BUCKETS +
+            latency_bucket(us)] += 1;
+        rec_ref->record_p->fcounters[op] += us / 1e6;
+    }
+    LATENCY_UNLOCK();
+
+    return;
+}
+
+/**********************************************************
+ * Internal functions for manipulating LATENCY module state *
+ **********************************************************/
+
+void latency_runtime_initialize()
+{
+    int ret;
+    size_t latency_rec_count;
+    darshan_module_funcs mod_funcs = {
+#ifdef HAVE_MPI
+    .mod_redux_func = &latency_mpi_redux,
+#endif
+    .mod_output_func = &latency_output,
+    .mod_cleanup_func = &latency_cleanup
+    };
+
+    /* both the POSIX and MPI-IO modules call this, so only the first call
+     * registers the module
+     */
+    LATENCY_LOCK();
+    if(latency_runtime)
+    {
+        LATENCY_UNLOCK();
+        return;
+    }
+
+    /* try and store a default number of records for this module */
+    latency_rec_count = DARSHAN_DEF_MOD_REC_COUNT;
+
+    /* register the LATENCY module with darshan core; this fails while the
+     * module is disabled, which it is by default
+     */
+    ret = darshan_core_register_module(
+        DARSHAN_LATENCY_MOD,
+        mod_funcs,
+        sizeof(struct darshan_latency_record),
+        &latency_rec_count,
+        &my_rank,
+        NULL);
+    if(ret < 0)
+    {
+        LATENCY_UNLOCK();
+        return;
+    }
+
+    latency_runtime = malloc(sizeof(*latency_runtime));
+    if(!latency_runtime)
+    {
+        darshan_core_unregister_module(DARSHAN_LATENCY_MOD);
+        LATENCY_UNLOCK();
+        return;
+    }
+    memset(latency_runtime, 0, sizeof(*latency_runtime));
+    latency_runtime_enabled = 1;
+
+    LATENCY_UNLOCK();
+    return;
+}
+
+static struct latency_record_ref *latency_track_new_record(
+    darshan_record_id rec_id)
+{
+    struct darshan_latency_record *record_p = NULL;
+    struct latency_record_ref *rec_ref = NULL;
+    int ret;
+
+    rec_ref = malloc(sizeof(*rec_ref));
+    if(!rec_ref)
+        return(NULL);
+    memset(rec_ref, 0, sizeof(*rec_ref));
+
+    /* add a reference to this record */
+    ret = darshan_add_record_ref(&(latency_runtime->rec_id_hash), &rec_id,
+        sizeof(darshan_record_id), rec_ref);
+    if(ret == 0)
+    {
+        free(rec_ref);
+        return(NULL);
+    }
+
+    /* register the actual record with darshan-core so it is persisted in
+     * the log file.  The name is NULL, since the POSIX or MPI-IO module has
+     * already registered the name for this record id.
+     */
+    record_p = darshan_core_register_record(
+        rec_id,
+        NULL,
+        DARSHAN_LATENCY_MOD,
+        sizeof(struct darshan_latency_record),
+        NULL);
+
+    if(!record_p)
+    {
+        darshan_delete_record_ref(&(latency_runtime->rec_id_hash),
+            &rec_id, sizeof(darshan_record_id));
+        free(rec_ref);
+        return(NULL);
+    }
+
+    /* registering this record was successful, so initialize some fields */
+    record_p->base_rec.id = rec_id;
+    record_p->base_rec.rank = my_rank;
+    rec_ref->record_p = record_p;
+    latency_runtime->rec_count++;
+
+    return(rec_ref);
+}
+
+#ifdef HAVE_MPI
+static void latency_record_reduction_op(void* infile_v, void* inoutfile_v,
+    int *len, MPI_Datatype *datatype)
+{
+    struct darshan_latency_record *infile = infile_v;
+    struct darshan_latency_record *inoutfile = inoutfile_v;
+    int i, j;
+
+    for(i=0; i<*len; i++)
+    {
+        /* every counter sums */
+        for(j = 0; j < LATENCY_NUM_INDICES; j++)
+            inoutfile->counters[j] += infile->counters[j];
+        for(j = 0; j < LATENCY_F_NUM_INDICES; j++)
+            inoutfile->fcounters[j] += infile->fcounters[j];
+        inoutfile->base_rec.rank = -1;
+        infile++;
+        inoutfile++;
+    }
+
+    return;
+}
+#endif
+
+/********************************************************************************
+ * Functions exported by this module for coordinating with darshan-core *
+ ********************************************************************************/
+
+#ifdef HAVE_MPI
+static void latency_mpi_redux(
+    void *latency_buf,
+    MPI_Comm mod_comm,
+    darshan_record_id *shared_recs,
+    int shared_rec_count)
+{
+    int latency_rec_count;
+    struct latency_record_ref *rec_ref;
+    struct darshan_latency_record *latency_rec_buf =
+        (struct darshan_latency_record *)latency_buf;
+    struct darshan_latency_record *red_send_buf = NULL;
+    struct darshan_latency_record *red_recv_buf = NULL;
+    MPI_Datatype red_type;
+    MPI_Op red_op;
+    int i;
+
+    LATENCY_LOCK();
+    assert(latency_runtime);
+
+    /* no more updates once the records are rearranged below */
+    latency_runtime->frozen = 1;
+
+    latency_rec_count = latency_runtime->rec_count;
+
+    /* necessary initialization of shared records */
+    for(i = 0; i < shared_rec_count; i++)
+    {
+        rec_ref = darshan_lookup_record_ref(latency_runtime->rec_id_hash,
+            &shared_recs[i], sizeof(darshan_record_id));
+        assert(rec_ref);
+
+        rec_ref->record_p->base_rec.rank = -1;
+    }
+
+    /* sort the array of records descending by rank so that we get all of
+     * the shared records (marked by rank -1) in a contiguous portion at end
+     * of the array
+     */
+    darshan_record_sort(latency_rec_buf, latency_rec_count,
+        sizeof(struct darshan_latency_record));
+
+    /* make *send_buf point to the shared records at the end of sorted array */
+    red_send_buf = &(latency_rec_buf[latency_rec_count-shared_rec_count]);
+
+    /* allocate memory for the reduction output on rank 0 */
+    if(my_rank == 0)
+    {
+        red_recv_buf = malloc(shared_rec_count *
+            sizeof(struct darshan_latency_record));
+        if(!red_recv_buf)
+        {
+            LATENCY_UNLOCK();
+            return;
+        }
+    }
+
+    /* construct a datatype for a LATENCY record.  This is serving no
+     * purpose except to make sure we can do a reduction on proper boundaries
+     */
+    PMPI_Type_contiguous(sizeof(struct darshan_latency_record),
+        MPI_BYTE, &red_type);
+    PMPI_Type_commit(&red_type);
+
+    /* register a LATENCY record reduction operator */
+    PMPI_Op_create(latency_record_reduction_op, 1, &red_op);
+
+    /* reduce shared LATENCY records */
+    PMPI_Reduce(red_send_buf, red_recv_buf,
+        shared_rec_count, red_type, red_op, 0, mod_comm);
+
+    /* update module state to account for shared record reduction */
+    if(my_rank == 0)
+    {
+        /* overwrite local shared records with globally reduced records */
+        int tmp_ndx = latency_rec_count - shared_rec_count;
+        memcpy(&(latency_rec_buf[tmp_ndx]), red_recv_buf,
+            shared_rec_count * sizeof(struct darshan_latency_record));
+        free(red_recv_buf);
+    }
+    else
+    {
+        /* drop shared records on non-zero ranks */
+        latency_runtime->rec_count -= shared_rec_count;
+    }
+
+    PMPI_Type_free(&red_type);
+    PMPI_Op_free(&red_op);
+
+    LATENCY_UNLOCK();
+    return;
+}
+#endif
+
+static void latency_output(
+    void **latency_buf,
+    int *latency_buf_sz)
+{
+    LATENCY_LOCK();
+    assert(latency_runtime);
+
+    *latency_buf_sz = latency_runtime->rec_count *
+        sizeof(struct darshan_latency_record);
+
+    latency_runtime->frozen = 1;
+
+    LATENCY_UNLOCK();
+    return;
+}
+
+static void latency_cleanup()
+{
+    LATENCY_LOCK();
+    assert(latency_runtime);
+
+    /* cleanup internal structures used for instrumenting */
+    darshan_clear_record_refs(&(latency_runtime->rec_id_hash), 1);
+
+    free(latency_runtime);
+    latency_runtime = NULL;
+    latency_runtime_enabled = 0;
+
+    LATENCY_UNLOCK();
+    return;
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifndef __DARSHAN_LATENCY_H
+#define __DARSHAN_LATENCY_H
+
+#include <stdint.h>
+
+#ifdef DARSHAN_LATENCY
+
+/* set once the LATENCY module has registered with darshan-core, so that the
+ * record macros of other modules only pay for a flag test while the module
+ * is disabled (the default)
+ */
+extern int latency_runtime_enabled;
+
+/* latency_runtime_initialize()
+ *
+ * registers the LATENCY module, if it is enabled; called by the POSIX and
+ * MPI-IO modules when they initialize
+ */
+void latency_runtime_initialize(void);
+
+/* latency_update()
+ *
+ * records an operation of class 'op' (LATENCY_OP_*) on the file with record
+ * id 'rec_id' that took 'us' microseconds
+ */
+void latency_update(darshan_record_id rec_id, int op, int64_t us);
+
+/* histogram bucket of an operation that took 'us' microseconds: 0 below
+ * 1 us, then one bucket per power of 2
+ */
+static inline int latency_bucket(int64_t us)
+{
+    int bucket = 0;
+
+    if(us <= 0)
+        return(0);
+#ifdef __GNUC__
+    bucket = 64 - __builtin_clzll((unsigned long long)us);
+#else
+    while(us)
+    {
+        bucket++;
+        us >>= 1;
+    }
+#endif
+    if(bucket >= LATENCY_NUM_BUCKETS)
+        bucket = LATENCY_NUM_BUCKETS - 1;
+
+    return(bucket);
+}
+
+#define LATENCY_RECORD(__rec_id, __op, __tm1, __tm2) do { \
+    if(latency_runtime_enabled) \
+        latency_update(__rec_id, __op, (int64_t)(((__tm2) - (__tm1)) * 1e6)); \
+} while(0)
+
+#else
+
+/* as with the heatmap module, provide stubs when the LATENCY module is
+ * disabled so that the POSIX and MPI-IO modules do not need preprocessor
+ * guards
+ */
+
+static inline void latency_runtime_initialize(void) {
+}
+
+#define LATENCY_RECORD(__rec_id, __op, __tm1, __tm2) do { } while(0)
+
+#endif
+
+#endif /* __DARSHAN_LATENCY_H */
@@ -14,8 +14,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include "darshan-ldms.h"
 #include "darshan.h"
+#include "darshan-common.h"
 
 /* Check for LDMS libraries if Darshan is built --with-ldms */
 #ifdef HAVE_LDMS
@@ -24,8 +30,110 @@ struct darshanConnector dC = {
      .ldms_darsh = NULL,
      .ldms_lib = 1,
      .jobid = 0,
+     .ln_lock = PTHREAD_MUTEX_INITIALIZER,
      };
 
+/* defaults for the event queues and the background publisher */
+#define DARSHAN_LDMS_DEF_QUEUE_SIZE 1024
+#define DARSHAN_LDMS_DEF_BATCH_SIZE 1
+#define DARSHAN_LDMS_MAX_BATCH_SIZE 1024
+#define DARSHAN_LDMS_PUBLISH_INTERVAL_NS 10000000
+/* upper bound on the size of one JSON-formatted event */
+#define DARSHAN_LDMS_EVENT_MAX (1024 + __DARSHAN_PATH_MAX)
+
+/* a single I/O event, captured on the application thread and formatted
+ * and published later by the publisher thread. the string arguments of
+ * darshan_ldms_connector_send() are all literals, so only pointers to
+ * them are kept
+ */
+struct darshan_ldms_event
+{
+    uint64_t record_id;
+    int64_t rank;
+    int64_t record_count;
+    int64_t offset;
+    int64_t length;
+    int64_t max_byte;
+    int64_t rw_switch;
+    int64_t flushes;
+    int64_t hdf5_data[5];
+    double start_time;
+    double end_time;
+    double total_time;
+    const char *rwo;
+    const char *mod_name;
+    const char *data_type;
+};
+
+/* single-producer/single-consumer ring of events for one application
+ * thread; only the owning thread advances head and only the publisher
+ * thread advances tail, so neither side takes a lock
+ */
+struct darshan_ldms_queue
+{
+    struct darshan_ldms_event *events;
+    unsigned int mask;
+    atomic_uint head;
+    atomic_uint tail;
+    struct darshan_ldms_queue *next;
+};
+
+/* JSON message under construction on the publisher thread */
+struct darshan_ldms_batch
+{
+    char *buf;
+    size_t len;
+    size_t cap;
+    int count;
+};
+
+/* per-file, per-operation summary for the current window, keyed by record
+ * id, module and operation
+ */
+struct darshan_ldms_window_key
+{
+    uint64_t record_id;
+    char mod_name[8];
+    char rwo[8];
+};
+
+struct darshan_ldms_window_ref
+{
+    struct darshan_ldms_window_key key;
+    const char *data_type;
+    int64_t rank;
+    /* deltas accumulated over the current window */
+    int64_t ops;
+    int64_t bytes;
+    int64_t max_offset;
+    double time;
+    /* latest cumulative counters of the record */
+    int64_t record_count;
+    int64_t max_byte;
+    int64_t rw_switch;
+    int64_t flushes;
+    double total_time;
+};
+
+typedef int (*darshan_ldms_format_fn)(void *item, char *buf, size_t size);
+
+static __thread struct darshan_ldms_queue *ldms_thread_queue = NULL;
+/* list of all thread queues, prepended to under dC.ln_lock and never
+ * shortened
+ */
+static struct darshan_ldms_queue *ldms_queues = NULL;
+static pthread_t ldms_publisher;
+static atomic_int ldms_publisher_running = 0;
+static atomic_int ldms_publisher_stop = 0;
+static atomic_llong ldms_dropped = 0;
+static struct darshan_ldms_batch ldms_batch;
+static void *ldms_window_hash = NULL;
+static double ldms_window_start = 0;
+
+static void *darshan_ldms_publisher_main(void *arg);
+static int darshan_ldms_drain_queues(void);
+static void darshan_ldms_window_flush(void);
+
 static void event_cb(ldms_t x, ldms_xprt_event_t e, void *cb_arg)
 {
 	switch (e->type) {
@@ -183,6 +291,33 @@ void darshan_ldms_connector_initialize(struct darshan_core_runtime *init_core)
 	darshan_core_fprintf(stderr, "LDMS library: darshanConnector - stream name for LDMS streams deamon connection is not set. Setting to default value \"darshanConnector\".\n");
 	dC.env_ldms_stream = "darshanConnector";}
 
+    dC.verbose = (getenv("DARSHAN_LDMS_VERBOSE") != NULL);
+
+    /* event queue and batching parameters */
+    dC.queue_size = DARSHAN_LDMS_DEF_QUEUE_SIZE;
+    if (getenv("DARSHAN_LDMS_QUEUE_SIZE") && atoi(getenv("DARSHAN_LDMS_QUEUE_SIZE")) > 0){
+	/* round up to a power of two so ring indices can be masked */
+	dC.queue_size = 1;
+	while (dC.queue_size < atoi(getenv("DARSHAN_LDMS_QUEUE_SIZE")))
+	    dC.queue_size <<= 1;
+	}
+    dC.batch_size = DARSHAN_LDMS_DEF_BATCH_SIZE;
+    if (getenv("DARSHAN_LDMS_BATCH") && atoi(getenv("DARSHAN_LDMS_BATCH")) > 0){
+	dC.batch_size = atoi(getenv("DARSHAN_LDMS_BATCH"));
+	if (dC.batch_size > DARSHAN_LDMS_MAX_BATCH_SIZE)
+	    dC.batch_size = DARSHAN_LDMS_MAX_BATCH_SIZE;
+	}
+    dC.block_when_full = 0;
+    if (getenv("DARSHAN_LDMS_QUEUE_FULL")){
+	if (strcmp(getenv("DARSHAN_LDMS_QUEUE_FULL"), "block") == 0)
+	    dC.block_when_full = 1;
+	else if (strcmp(getenv("DARSHAN_LDMS_QUEUE_FULL"), "drop") != 0)
+	    darshan_core_fprintf(stderr, "LDMS library: darshanConnector - unknown DARSHAN_LDMS_QUEUE_FULL policy \"%s\". Setting to default value \"drop\".\n", getenv("DARSHAN_LDMS_QUEUE_FULL"));
+	}
+    dC.window = 0;
+    if (getenv("DARSHAN_LDMS_WINDOW") && atof(getenv("DARSHAN_LDMS_WINDOW")) > 0)
+	dC.window = atof(getenv("DARSHAN_LDMS_WINDOW"));
+
 
     pthread_mutex_lock(&dC.ln_lock);
 
@@ -198,67 +333,422 @@ void darshan_ldms_connector_initialize(struct darshan_core_runtime *init_core)
         return;
     }
     pthread_mutex_unlock(&dC.ln_lock);
+
+    /* start the publisher thread; if it can't be started, events are
+     * published synchronously by the application threads instead (and
+     * summary windows are not available)
+     */
+    ldms_batch.cap = (size_t)dC.batch_size * DARSHAN_LDMS_EVENT_MAX + 2;
+    ldms_batch.buf = malloc(ldms_batch.cap);
+    if (!ldms_batch.buf)
+        return;
+    ldms_window_start = darshan_core_wtime();
+    atomic_store(&ldms_publisher_stop, 0);
+    if (pthread_create(&ldms_publisher, NULL, darshan_ldms_publisher_main, NULL) != 0){
+        darshan_core_fprintf(stderr, "LDMS library: darshanConnector - unable to start publisher thread, publishing synchronously.\n");
+        free(ldms_batch.buf);
+        ldms_batch.buf = NULL;
+        return;
+    }
+    atomic_store(&ldms_publisher_running, 1);
     return;
 }
 
-void darshan_ldms_connector_send(uint64_t record_id, int64_t rank, int64_t record_count, char *rwo, int64_t offset, int64_t length, int64_t max_byte, int64_t rw_switch, int64_t flushes,  double start_time, double end_time, double total_time, char *mod_name, char *data_type)
+void darshan_ldms_connector_finalize()
 {
-    char jb11[1024];
-    int rc, ret, i, size, exists, found;
-    struct timespec tspec_start, tspec_end;
-    uint64_t micro_s;
+    if (!atomic_load(&ldms_publisher_running))
+        return;
 
-    pthread_mutex_lock(&dC.ln_lock);
-    if (dC.ldms_darsh != NULL)
-	exists = 1;
-    else
-	exists = 0;
-    pthread_mutex_unlock(&dC.ln_lock);
+    /* events sent from here on are published synchronously; the publisher
+     * drains the queues once more before exiting, and anything queued
+     * while it did so is published here
+     */
+    atomic_store(&ldms_publisher_running, 0);
+    atomic_store(&ldms_publisher_stop, 1);
+    pthread_join(ldms_publisher, NULL);
+    darshan_ldms_drain_queues();
+    /* publish the final, partial window */
+    if (dC.window > 0)
+        darshan_ldms_window_flush();
+    darshan_clear_record_refs(&ldms_window_hash, 1);
+
+    if (atomic_load(&ldms_dropped) > 0)
+        darshan_core_fprintf(stderr, "LDMS library: darshanConnector - dropped %lld events on full queues (see DARSHAN_LDMS_QUEUE_SIZE).\n", (long long)atomic_load(&ldms_dropped));
+
+    /* NOTE: the thread queues are kept for the life of the process, since
+     * application threads hold references to them
+     */
+    free(ldms_batch.buf);
+    ldms_batch.buf = NULL;
 
-    if (!exists){
-	return;
-    }
+    return;
+}
+
+/* format one event as a JSON object into 'buf', returning its length, or -1
+ * if it does not fit in 'size' bytes
+ */
+static int darshan_ldms_format_event(void *item, char *buf, size_t size)
+{
+    struct darshan_ldms_event *ev = item;
+    struct timespec tspec_end;
+    uint64_t micro_s;
+    const char *schema, *exepath, *filepath;
+    char rec_name[__DARSHAN_PATH_MAX];
+    int len;
 
     /* Current schema name used to query darshan data stored in DSOS.
     * If not storing to DSOS, then this can be ignored.*/
-    dC.schema = "darshan_data";
-
-    /* get the full file path from record ID */
-    dC.filepath = darshan_core_lookup_record_name(record_id);
-
-    /* set all hdf5 related fields to -1 for all other modules*/
-    if (strcmp(mod_name, "H5D") != 0){
-	size = sizeof(dC.hdf5_data)/sizeof(dC.hdf5_data[0]);
-	for (i=0; i < size; i++)
-	    dC.hdf5_data[i] = -1;
-    }
+    schema = "darshan_data";
+    exepath = dC.exe_tmp;
 
     /* set following fields for module data to N/A to reduce message size */
-    if (strcmp(data_type, "MOD") == 0)
+    if (strcmp(ev->data_type, "MOD") == 0)
+    {
+	filepath = "N/A";
+	exepath = "N/A";
+	schema = "N/A";
+    }
+    else
     {
-	dC.filepath = "N/A";
-	dC.exepath = "N/A";
-	dC.schema = "N/A";
+	/* get the full file path from record ID */
+	if (darshan_core_lookup_record_name(ev->record_id, rec_name, sizeof(rec_name)))
+	    filepath = rec_name;
+	else
+	    filepath = "N/A";
     }
+
+    /* convert the end time to a timespec and report absolute timestamps */
+    tspec_end = darshan_core_abs_timespec_from_wtime(ev->end_time);
+    micro_s = tspec_end.tv_nsec/1.0e3;
+
+    len = snprintf(buf, size, "{\"schema\":\"%s\", \"uid\":%ld, \"exe\":\"%s\",\"job_id\":%ld,\"rank\":%ld,\"ProducerName\":\"%s\",\"file\":\"%s\",\"record_id\":%"PRIu64",\"module\":\"%s\",\"type\":\"%s\",\"max_byte\":%ld,\"switches\":%ld,\"flushes\":%ld,\"cnt\":%ld,\"op\":\"%s\",\"seg\":[{\"pt_sel\":%ld,\"irreg_hslab\":%ld,\"reg_hslab\":%ld,\"ndims\":%ld,\"npoints\":%ld,\"off\":%ld,\"len\":%ld,\"start\":%0.6f,\"dur\":%0.6f,\"total\":%0.6f,\"timestamp\":%lu.%.6lu}]}", schema, dC.uid, exepath, dC.jobid, ev->rank, dC.hname, filepath, ev->record_id, ev->mod_name, ev->data_type, ev->max_byte, ev->rw_switch, ev->flushes, ev->record_count, ev->rwo, ev->hdf5_data[0], ev->hdf5_data[1], ev->hdf5_data[2], ev->hdf5_data[3], ev->hdf5_data[4], ev->offset, ev->length, ev->start_time, ev->end_time-ev->start_time, ev->total_time, tspec_end.tv_sec, micro_s);
+    if (len < 0 || (size_t)len >= size)
+	return(-1);
+
+    return(len);
+}
+
+/* format one window summary as a JSON object, like
+ * darshan_ldms_format_event()
+ */
+static int darshan_ldms_format_window(void *item, char *buf, size_t size)
+{
+    struct darshan_ldms_window_ref *ref = item;
+    struct timespec tspec_end;
+    uint64_t micro_s;
+    const char *filepath;
+    char rec_name[__DARSHAN_PATH_MAX];
+    int len;
+
+    if (darshan_core_lookup_record_name(ref->key.record_id, rec_name, sizeof(rec_name)))
+	filepath = rec_name;
     else
-	dC.exepath = dC.exe_tmp;
+	filepath = "N/A";
 
-    /* convert the start and end times to timespecs and report absolute timestamps */
-    tspec_start = darshan_core_abs_timespec_from_wtime(start_time);
-    tspec_end = darshan_core_abs_timespec_from_wtime(end_time);
+    /* summaries are stamped with the end of their window */
+    tspec_end = darshan_core_abs_timespec_from_wtime(ldms_window_start + dC.window);
     micro_s = tspec_end.tv_nsec/1.0e3;
 
-    sprintf(jb11,"{\"schema\":\"%s\", \"uid\":%ld, \"exe\":\"%s\",\"job_id\":%ld,\"rank\":%ld,\"ProducerName\":\"%s\",\"file\":\"%s\",\"record_id\":%"PRIu64",\"module\":\"%s\",\"type\":\"%s\",\"max_byte\":%ld,\"switches\":%ld,\"flushes\":%ld,\"cnt\":%ld,\"op\":\"%s\",\"seg\":[{\"pt_sel\":%ld,\"irreg_hslab\":%ld,\"reg_hslab\":%ld,\"ndims\":%ld,\"npoints\":%ld,\"off\":%ld,\"len\":%ld,\"start\":%0.6f,\"dur\":%0.6f,\"total\":%0.6f,\"timestamp\":%lu.%.6lu}]}", dC.schema, dC.uid, dC.exepath, dC.jobid, rank, dC.hname, dC.filepath, record_id, mod_name, data_type, max_byte, rw_switch, flushes, record_count, rwo, dC.hdf5_data[0], dC.hdf5_data[1], dC.hdf5_data[2], dC.hdf5_data[3], dC.hdf5_data[4], offset, length, start_time, end_time-start_time, total_time, tspec_end.tv_sec, micro_s);
+    len = snprintf(buf, size, "{\"schema\":\"darshan_window\", \"uid\":%ld, \"exe\":\"%s\",\"job_id\":%ld,\"rank\":%ld,\"ProducerName\":\"%s\",\"file\":\"%s\",\"record_id\":%"PRIu64",\"module\":\"%s\",\"type\":\"WIN\",\"data_type\":\"%s\",\"op\":\"%s\",\"window\":%0.6f,\"ops\":%ld,\"bytes\":%ld,\"dur\":%0.6f,\"max_off\":%ld,\"max_byte\":%ld,\"switches\":%ld,\"flushes\":%ld,\"cnt\":%ld,\"total\":%0.6f,\"timestamp\":%lu.%.6lu}", dC.uid, dC.exe_tmp, dC.jobid, ref->rank, dC.hname, filepath, ref->key.record_id, ref->key.mod_name, ref->data_type, ref->key.rwo, dC.window, ref->ops, ref->bytes, ref->time, ref->max_offset, ref->max_byte, ref->rw_switch, ref->flushes, ref->record_count, ref->total_time, tspec_end.tv_sec, micro_s);
+    if (len < 0 || (size_t)len >= size)
+	return(-1);
+
+    return(len);
+}
+
+static void darshan_ldms_publish(char *msg, size_t len)
+{
+    int rc;
 
-    if (getenv("DARSHAN_LDMS_VERBOSE"))
-       darshan_core_fprintf(stderr, "JSON Message: %s\n", jb11);
+    if (dC.verbose)
+       darshan_core_fprintf(stderr, "JSON Message: %s\n", msg);
 
-    rc = ldmsd_stream_publish(dC.ldms_darsh, dC.env_ldms_stream, LDMSD_STREAM_JSON, jb11, strlen(jb11) + 1);
+    rc = ldmsd_stream_publish(dC.ldms_darsh, dC.env_ldms_stream, LDMSD_STREAM_JSON, msg, len + 1);
     if (rc)
        darshan_core_fprintf(stderr, "LDMS library: darshanConnector - error %d publishing stream data.\n", rc);
 
-    out_1:
-	 return;
+    return;
+}
+
+/* publish the events collected in the current batch, as a single JSON
+ * object or, when batching more than one event per message, as a JSON
+ * array of objects
+ */
+static void darshan_ldms_batch_flush(struct darshan_ldms_batch *batch)
+{
+    if (batch->count == 0)
+	return;
+
+    if (dC.batch_size > 1)
+	batch->buf[batch->len++] = ']';
+    batch->buf[batch->len] = '\0';
+    darshan_ldms_publish(batch->buf, batch->len);
+
+    batch->len = 0;
+    batch->count = 0;
+    return;
+}
+
+static void darshan_ldms_batch_add(struct darshan_ldms_batch *batch,
+    darshan_ldms_format_fn format, void *item)
+{
+    int len;
+
+    if (dC.batch_size > 1)
+	batch->buf[batch->len++] = (batch->count == 0) ? '[' : ',';
+
+    /* leave room for the closing bracket and terminator */
+    len = format(item, batch->buf + batch->len, batch->cap - batch->len - 2);
+    if (len < 0)
+    {
+	/* drop events that can't be formatted, keeping the message valid */
+	if (dC.batch_size > 1)
+	    batch->len--;
+	atomic_fetch_add(&ldms_dropped, 1);
+	return;
+    }
+    batch->len += len;
+    batch->count++;
+
+    if (batch->count == dC.batch_size)
+	darshan_ldms_batch_flush(batch);
+
+    return;
+}
+
+/* fold an event into the summary of its file and operation for the
+ * current window
+ */
+static void darshan_ldms_window_add(struct darshan_ldms_event *ev)
+{
+    struct darshan_ldms_window_key key;
+    struct darshan_ldms_window_ref *ref;
+
+    memset(&key, 0, sizeof(key));
+    key.record_id = ev->record_id;
+    strncpy(key.mod_name, ev->mod_name, sizeof(key.mod_name) - 1);
+    strncpy(key.rwo, ev->rwo, sizeof(key.rwo) - 1);
+
+    ref = darshan_lookup_record_ref(ldms_window_hash, &key, sizeof(key));
+    if (!ref)
+    {
+	ref = calloc(1, sizeof(*ref));
+	if (!ref)
+	{
+	    atomic_fetch_add(&ldms_dropped, 1);
+	    return;
+	}
+	ref->key = key;
+	ref->max_offset = -1;
+	if (darshan_add_record_ref(&ldms_window_hash, &ref->key, sizeof(ref->key), ref) != 1)
+	{
+	    free(ref);
+	    atomic_fetch_add(&ldms_dropped, 1);
+	    return;
+	}
+    }
+
+    ref->ops++;
+    if (ev->length > 0)
+    {
+	ref->bytes += ev->length;
+	if (ev->offset + ev->length - 1 > ref->max_offset)
+	    ref->max_offset = ev->offset + ev->length - 1;
+    }
+    ref->time += ev->end_time - ev->start_time;
+
+    ref->data_type = ev->data_type;
+    ref->rank = ev->rank;
+    ref->record_count = ev->record_count;
+    ref->max_byte = ev->max_byte;
+    ref->rw_switch = ev->rw_switch;
+    ref->flushes = ev->flushes;
+    ref->total_time = ev->total_time;
+
+    return;
+}
+
+static void darshan_ldms_window_publish_ref(void *ref_p, void *user_ptr)
+{
+    struct darshan_ldms_window_ref *ref = ref_p;
+
+    /* only files active in this window are reported */
+    if (ref->ops == 0)
+	return;
+
+    darshan_ldms_batch_add(&ldms_batch, darshan_ldms_format_window, ref);
+
+    ref->ops = 0;
+    ref->bytes = 0;
+    ref->max_offset = -1;
+    ref->time = 0;
+    return;
+}
+
+/* publish the summaries of the current window and start the next one */
+static void darshan_ldms_window_flush(void)
+{
+    darshan_iter_record_refs(ldms_window_hash, darshan_ldms_window_publish_ref, NULL);
+    darshan_ldms_batch_flush(&ldms_batch);
+    ldms_window_start += dC.window;
+    return;
+}
+
+/* publish all queued events, or add them to the current window, returning
+ * how many were found
+ */
+static int darshan_ldms_drain_queues(void)
+{
+    struct darshan_ldms_queue *queue;
+    unsigned int head, tail;
+    int count = 0;
+
+    pthread_mutex_lock(&dC.ln_lock);
+    queue = ldms_queues;
+    pthread_mutex_unlock(&dC.ln_lock);
+
+    /* queues are only ever prepended, so the list can be walked from the
+     * head taken above without the lock
+     */
+    for (; queue; queue = queue->next)
+    {
+	tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+	head = atomic_load_explicit(&queue->head, memory_order_acquire);
+	for (; tail != head; tail++)
+	{
+	    if (dC.window > 0)
+		darshan_ldms_window_add(&queue->events[tail & queue->mask]);
+	    else
+		darshan_ldms_batch_add(&ldms_batch, darshan_ldms_format_event,
+		    &queue->events[tail & queue->mask]);
+	    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+	    count++;
+	}
+    }
+    darshan_ldms_batch_flush(&ldms_batch);
+
+    return(count);
+}
+
+static void *darshan_ldms_publisher_main(void *arg)
+{
+    struct timespec interval = {0, DARSHAN_LDMS_PUBLISH_INTERVAL_NS};
+    int stop;
+
+    /* only sleep once the queues have been found empty */
+    do {
+	stop = atomic_load(&ldms_publisher_stop);
+	if (darshan_ldms_drain_queues() == 0 && !stop)
+	    nanosleep(&interval, NULL);
+	/* the final, partial window is published at finalization */
+	while (dC.window > 0 && !stop &&
+	    darshan_core_wtime() >= ldms_window_start + dC.window)
+	    darshan_ldms_window_flush();
+    } while (!stop);
+
+    return(NULL);
+}
+
+static struct darshan_ldms_queue *darshan_ldms_thread_queue(void)
+{
+    struct darshan_ldms_queue *queue;
+
+    if (ldms_thread_queue)
+	return(ldms_thread_queue);
+
+    queue = malloc(sizeof(*queue));
+    if (!queue)
+	return(NULL);
+    queue->events = malloc(dC.queue_size * sizeof(*queue->events));
+    if (!queue->events)
+    {
+	free(queue);
+	return(NULL);
+    }
+    queue->mask = dC.queue_size - 1;
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+
+    pthread_mutex_lock(&dC.ln_lock);
+    queue->next = ldms_queues;
+    ldms_queues = queue;
+    pthread_mutex_unlock(&dC.ln_lock);
+
+    ldms_thread_queue = queue;
+    return(queue);
+}
+
+/* queue an event for the publisher thread. returns 0 if the event was
+ * queued or dropped, and -1 if the caller should publish it itself
+ */
+static int darshan_ldms_enqueue(struct darshan_ldms_event *ev)
+{
+    struct darshan_ldms_queue *queue;
+    unsigned int head;
+
+    queue = darshan_ldms_thread_queue();
+    if (!queue)
+	return(-1);
+
+    head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    while (head - atomic_load_explicit(&queue->tail, memory_order_acquire) > queue->mask)
+    {
+	/* the queue is full: wait for the publisher, or drop the event */
+	if (!dC.block_when_full)
+	{
+	    atomic_fetch_add(&ldms_dropped, 1);
+	    return(0);
+	}
+	if (!atomic_load(&ldms_publisher_running))
+	    return(-1);
+	sched_yield();
+    }
+
+    queue->events[head & queue->mask] = *ev;
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+
+    return(0);
+}
+
+void darshan_ldms_connector_send(uint64_t record_id, int64_t rank, int64_t record_count, char *rwo, int64_t offset, int64_t length, int64_t max_byte, int64_t rw_switch, int64_t flushes,  double start_time, double end_time, double total_time, char *mod_name, char *data_type)
+{
+    struct darshan_ldms_event ev;
+    char jb11[DARSHAN_LDMS_EVENT_MAX];
+    int i, size, len;
+
+    /* the connection is only set up at initialization */
+    if (dC.ldms_darsh == NULL)
+	return;
+
+    ev.record_id = record_id;
+    ev.rank = rank;
+    ev.record_count = record_count;
+    ev.offset = offset;
+    ev.length = length;
+    ev.max_byte = max_byte;
+    ev.rw_switch = rw_switch;
+    ev.flushes = flushes;
+    ev.start_time = start_time;
+    ev.end_time = end_time;
+    ev.total_time = total_time;
+    ev.rwo = rwo;
+    ev.mod_name = mod_name;
+    ev.data_type = data_type;
+
+    /* set all hdf5 related fields to -1 for all other modules*/
+    size = sizeof(dC.hdf5_data)/sizeof(dC.hdf5_data[0]);
+    for (i=0; i < size; i++)
+	ev.hdf5_data[i] = (strcmp(mod_name, "H5D") == 0) ? dC.hdf5_data[i] : -1;
+
+    if (atomic_load(&ldms_publisher_running) && darshan_ldms_enqueue(&ev) == 0)
+	return;
+
+    /* no publisher thread: format and publish on this thread */
+    len = darshan_ldms_format_event(&ev, jb11, sizeof(jb11));
+    if (len > 0)
+	darshan_ldms_publish(jb11, len);
+
+    return;
 }
 
 #else
@@ -272,6 +762,11 @@ void darshan_ldms_connector_initialize(struct darshan_core_runtime *init_core)
     return;
 }
 
+void darshan_ldms_connector_finalize(void)
+{
+    return;
+}
+
 void darshan_ldms_connector_send(uint64_t record_id, int64_t rank, int64_t record_count, char *rwo, int64_t offset, int64_t length, int64_t max_byte, int64_t rw_switch, int64_t flushes,  double start_time, double end_time, double total_time, char *mod_name, char *data_type)
 {
     return;
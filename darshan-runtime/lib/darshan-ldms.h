@@ -36,6 +36,11 @@ typedef struct darshanConnector {
         int64_t open_count;
         int64_t write_count;
         int conn_status;
+        int verbose;
+        int queue_size; /* events queued per application thread */
+        int batch_size; /* events published per message */
+        int block_when_full; /* wait for the publisher rather than drop */
+        double window; /* seconds per summary window, 0 for per-event mode */
         struct timespec ts;
         pthread_mutex_t ln_lock;
         ldms_t ldms_darsh;
@@ -59,18 +64,35 @@ typedef struct darshanConnector {
 
 extern struct darshanConnector dC;
 
-/* darshan_ldms_connector_initialize(), darshan_ldms_connector_send()
+/* test whether module '__mod' (posix, mpiio, stdio or hdf5) publishes its
+ * events to LDMS; without LDMS support this is constant, so that the record
+ * macros of the modules compile the publishing out altogether
+ */
+#ifdef HAVE_LDMS
+#define DARSHAN_LDMS_ENABLED(__mod) (dC.ldms_lib && dC.__mod##_enable_ldms)
+#else
+#define DARSHAN_LDMS_ENABLED(__mod) 0
+#endif
+
+/* darshan_ldms_connector_initialize(), darshan_ldms_connector_send(),
+ * darshan_ldms_connector_finalize()
  *
  * LDMS related function to intialize LDMSD streams plugin for realtime data
- * output of the Darshan modules.
+ * output of the Darshan modules, and to start the thread that publishes it.
  *
  * LDMS related function to retrieve and send the realitme data output of the Darshan
  * specified module from the set environment variables (i.e. *MODULENAME*_ENABLE_LDMS)
- * to LDMSD streams plugin.
+ * to LDMSD streams plugin. Events are queued per thread and published in the
+ * background.
+ *
+ * LDMS related function to publish any queued events and stop the publisher
+ * thread before Darshan shuts down.
  *
  */
 void darshan_ldms_connector_initialize(struct darshan_core_runtime *);
 
+void darshan_ldms_connector_finalize(void);
+
 void darshan_ldms_connector_send(uint64_t record_id, int64_t rank, int64_t record_count, char *rwo, int64_t offset, int64_t length, int64_t max_byte, int64_t rw_switch, int64_t flushes, double start_time, double end_time, double total_time, char *mod_name, char *data_type);
 
 #endif /* __DARSHAN_LDMS_H */
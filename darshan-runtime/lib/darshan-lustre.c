@@ -17,15 +17,19 @@
 #include <sys/stat.h>
 #include <time.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <pthread.h>
 #include <limits.h>
 #include <sys/xattr.h>
+#include <fcntl.h>
 
 #include <lustre/lustreapi.h>
 
 #include "darshan.h"
+#include "darshan-common.h"
 #include "darshan-dynamic.h"
+#include "utlist.h"
 
 static void lustre_runtime_initialize(
     void);
@@ -42,11 +46,46 @@ static void lustre_cleanup(
 struct lustre_record_ref
 {
     struct darshan_lustre_record *record;
+    int plain_layout; /* set if the record holds a single, non-composite layout */
 };
 
+/* default layout of a directory, as taken from the first file instrumented
+ * in it; only plain (non-composite) layouts are cached
+ */
+struct lustre_dir_layout
+{
+    struct darshan_lustre_component comp;
+};
+
+/* a file whose layout is to be collected by the helper thread */
+struct lustre_layout_req
+{
+    darshan_record_id rec_id;
+    int fd; /* duplicate of the application's descriptor, owned by the request */
+    struct lustre_layout_req *next;
+};
+
+/* bound on the requests queued to the helper thread, each of which holds a
+ * descriptor open; files closed while the queue is full are queried directly
+ */
+#define LUSTRE_LAYOUT_QUEUE_MAX 256
+
 struct lustre_runtime
 {
     void *record_id_hash;
+    void *dir_layout_hash; /* directory record ids -> struct lustre_dir_layout */
+    int layout_cache; /* flag to indicate directory layouts should be cached */
+    /* per-OST traffic record, indexed by OST index + 1 (entry 0 is OST -1) */
+    struct lustre_record_ref *ost_traffic_ref;
+    /* layout queries handed off by the application threads */
+    struct lustre_layout_req *layout_reqs;
+    void *layout_req_hash; /* record ids of the queued requests */
+    int layout_req_count;
+    pthread_t helper;
+    pthread_cond_t helper_cond;
+    pid_t helper_pid;
+    int helper_running;
+    int helper_stop;
     int frozen; /* flag to indicate that the counters should no longer be modified */
 };
 
@@ -54,10 +93,29 @@ struct lustre_runtime *lustre_runtime = NULL;
 static pthread_mutex_t lustre_runtime_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
 static int lustre_runtime_init_attempted = 0;
 static int my_rank = -1;
+/* checked without the module lock on every POSIX read and write */
+static int lustre_ost_traffic = 0;
 
 #define LUSTRE_LOCK() pthread_mutex_lock(&lustre_runtime_mutex)
 #define LUSTRE_UNLOCK() pthread_mutex_unlock(&lustre_runtime_mutex)
 
+/* descriptors duplicated for the helper thread are closed without being
+ * instrumented, using the underlying call (defined in POSIX module)
+ */
+#ifdef DARSHAN_PRELOAD
+extern int (*__real_close)(int fd);
+#else
+extern int __real_close(int fd);
+#endif
+
+static int lustre_real_close(int fd)
+{
+    MAP_OR_FAIL(close);
+    (void)__darshan_disabled;
+
+    return(__real_close(fd));
+}
+
 static void darshan_get_lustre_layout_size(struct llapi_layout *lustre_layout,
     int *num_comps, int *num_stripes)
 {
@@ -192,124 +250,697 @@ static void darshan_get_lustre_layout_components(struct llapi_layout *lustre_lay
     return;
 }
 
-void darshan_instrument_lustre_file(darshan_record_id rec_id, int fd)
+/* generate the record id of the directory containing a file record, returns
+ * 0 if the record name has no parent directory component
+ */
+static int lustre_parent_dir_id(darshan_record_id rec_id,
+    darshan_record_id *dir_id)
+{
+    char rec_name[__DARSHAN_PATH_MAX];
+    char *slash;
+
+    if(!darshan_core_lookup_record_name(rec_id, rec_name, sizeof(rec_name)))
+        return(0);
+    slash = strrchr(rec_name, '/');
+    if(!slash || slash == rec_name)
+        return(0);
+
+    *slash = '\0';
+    *dir_id = darshan_core_gen_record_id(rec_name);
+
+    return(1);
+}
+
+static struct lustre_record_ref *lustre_track_new_file_record(
+    darshan_record_id rec_id, int num_comps, int num_stripes)
 {
-    void *lustre_xattr_val;
-    size_t lustre_xattr_size = XATTR_SIZE_MAX;
-    struct llapi_layout *lustre_layout;
-    int num_comps, num_stripes;
-    size_t rec_size;
     struct darshan_lustre_record *rec;
     struct lustre_record_ref *rec_ref;
     int ret;
 
-    LUSTRE_LOCK();
-
-    /* try to init module if not already */
-    if(!lustre_runtime && !lustre_runtime_init_attempted)
-        lustre_runtime_initialize();
+    /* allocate and add a new record reference */
+    rec_ref = malloc(sizeof(*rec_ref));
+    if(!rec_ref)
+        return(NULL);
+    memset(rec_ref, 0, sizeof(*rec_ref));
 
-    /* if we aren't initialized, just back out */
-    if(!lustre_runtime || lustre_runtime->frozen)
+    ret = darshan_add_record_ref(&(lustre_runtime->record_id_hash),
+        &rec_id, sizeof(darshan_record_id), rec_ref);
+    if(ret == 0)
     {
-        LUSTRE_UNLOCK();
-        return;
+        free(rec_ref);
+        return(NULL);
     }
 
-    if ((lustre_xattr_val = calloc(1, lustre_xattr_size)) == NULL)
+    /* register a Lustre file record with Darshan */
+    rec = darshan_core_register_record(
+            rec_id,
+            NULL, /* either POSIX or STDIO already registered the name */
+            DARSHAN_LUSTRE_MOD,
+            LUSTRE_RECORD_SIZE(num_comps, num_stripes),
+            NULL);
+    if(rec == NULL)
     {
-        LUSTRE_UNLOCK();
+        /* if NULL, darshan has no more memory for instrumenting */
+        darshan_delete_record_ref(&(lustre_runtime->record_id_hash),
+            &rec_id, sizeof(darshan_record_id));
+        free(rec_ref);
+        return(NULL);
+    }
+
+    /* set base record */
+    rec->base_rec.id = rec_id;
+    rec->base_rec.rank = my_rank;
+    rec_ref->record = rec;
+    rec_ref->record->num_comps = num_comps;
+    rec_ref->record->num_stripes = num_stripes;
+
+    return(rec_ref);
+}
+
+/* fill in a new record from the cached default layout of its directory;
+ * OST indices are not known without querying the file itself
+ */
+static void lustre_record_from_dir_layout(darshan_record_id rec_id,
+    struct lustre_dir_layout *dir_layout)
+{
+    struct lustre_record_ref *rec_ref;
+    struct darshan_lustre_component *comps;
+    OST_ID *osts;
+    int num_stripes;
+    int i;
+
+    num_stripes = dir_layout->comp.counters[LUSTRE_COMP_STRIPE_COUNT];
+    rec_ref = lustre_track_new_file_record(rec_id, 1, num_stripes);
+    if(!rec_ref)
+        return;
+
+    comps = (struct darshan_lustre_component *)&(rec_ref->record->comps);
+    osts = (OST_ID *)(comps + 1);
+    comps[0] = dir_layout->comp;
+    for(i = 0; i < num_stripes; i++)
+        osts[i] = -1;
+    rec_ref->plain_layout = 1;
+
+    return;
+}
+
+/* cache the layout of a fully queried record as the default layout of its
+ * directory, if it is a plain layout and the directory has none cached yet
+ */
+static void lustre_cache_dir_layout(darshan_record_id dir_id,
+    struct lustre_record_ref *rec_ref)
+{
+    struct lustre_dir_layout *dir_layout;
+    struct darshan_lustre_component *comps =
+        (struct darshan_lustre_component *)&(rec_ref->record->comps);
+    int ret;
+
+    if(darshan_lookup_record_ref(lustre_runtime->dir_layout_hash,
+        &dir_id, sizeof(darshan_record_id)))
         return;
+
+    dir_layout = malloc(sizeof(*dir_layout));
+    if(!dir_layout)
+        return;
+    dir_layout->comp = comps[0];
+
+    ret = darshan_add_record_ref(&(lustre_runtime->dir_layout_hash),
+        &dir_id, sizeof(darshan_record_id), dir_layout);
+    if(ret == 0)
+        free(dir_layout);
+
+    return;
+}
+
+/* fill in the record of 'rec_id' from what the module already knows, if
+ * layout caching is enabled, returning 1 if the file need not be queried;
+ * otherwise the id of the file's directory is returned in 'dir_id' when it
+ * can be determined.  Must be called with the module lock held.
+ */
+static int lustre_layout_from_cache(darshan_record_id rec_id,
+    int *have_dir_id, darshan_record_id *dir_id)
+{
+    struct lustre_record_ref *rec_ref;
+    struct lustre_dir_layout *dir_layout;
+
+    *have_dir_id = 0;
+    if(!lustre_runtime->layout_cache)
+        return(0);
+
+    rec_ref = darshan_lookup_record_ref(lustre_runtime->record_id_hash,
+        &rec_id, sizeof(darshan_record_id));
+
+    /* plain layouts are not re-fetched at every close of the file */
+    if(rec_ref)
+        return(rec_ref->plain_layout);
+
+    /* new files take the cached default layout of their directory */
+    *have_dir_id = lustre_parent_dir_id(rec_id, dir_id);
+    if(*have_dir_id)
+    {
+        dir_layout = darshan_lookup_record_ref(lustre_runtime->dir_layout_hash,
+            dir_id, sizeof(darshan_record_id));
+        if(dir_layout)
+        {
+            lustre_record_from_dir_layout(rec_id, dir_layout);
+            return(1);
+        }
     }
 
+    return(0);
+}
+
+/* query the layout of the file open at 'fd', returning NULL if it has none;
+ * this talks to the MDS, so it is called without the module lock held
+ */
+static struct llapi_layout *lustre_query_layout(int fd)
+{
+    void *lustre_xattr_val;
+    size_t lustre_xattr_size = XATTR_SIZE_MAX;
+    struct llapi_layout *lustre_layout;
+
+    if ((lustre_xattr_val = calloc(1, lustre_xattr_size)) == NULL)
+        return(NULL);
+
     /* -1 means fgetxattr failed, likely because file isn't on Lustre, but maybe because
      * the Lustre version doesn't support this method of obtaining striping info
      */
     if ((lustre_xattr_size = fgetxattr(fd, "lustre.lov", lustre_xattr_val, lustre_xattr_size)) == -1)
     {
         free(lustre_xattr_val);
-        LUSTRE_UNLOCK();
-        return;
+        return(NULL);
     }
 
-    /* get corresponding Lustre file layout, then extract stripe params */
-    if ((lustre_layout = llapi_layout_get_by_xattr(lustre_xattr_val, lustre_xattr_size, 0)) == NULL)
+    /* get corresponding Lustre file layout */
+    lustre_layout = llapi_layout_get_by_xattr(lustre_xattr_val, lustre_xattr_size, 0);
+    free(lustre_xattr_val);
+
+    return(lustre_layout);
+}
+
+/* store a queried layout in the record of 'rec_id' and free it; must be
+ * called with the module lock held
+ */
+static void lustre_record_layout(darshan_record_id rec_id,
+    struct llapi_layout *lustre_layout, int have_dir_id,
+    darshan_record_id dir_id)
+{
+    int num_comps, num_stripes;
+    struct lustre_record_ref *rec_ref;
+    struct darshan_lustre_component *comps;
+
+    if(lustre_runtime->frozen)
     {
-        free(lustre_xattr_val);
-        LUSTRE_UNLOCK();
+        llapi_layout_free(lustre_layout);
         return;
     }
-    free(lustre_xattr_val);
 
-    /* search the hash table for this file record, and initialize if not found */
     rec_ref = darshan_lookup_record_ref(lustre_runtime->record_id_hash,
         &rec_id, sizeof(darshan_record_id));
     if(!rec_ref)
     {
-
         /* iterate file layout components to determine total record size */
         darshan_get_lustre_layout_size(lustre_layout, &num_comps, &num_stripes);
         if(num_comps == 0)
         {
             llapi_layout_free(lustre_layout);
-            LUSTRE_UNLOCK();
             return;
         }
-        rec_size = LUSTRE_RECORD_SIZE(num_comps, num_stripes);
 
-        /* allocate and add a new record reference */
-        rec_ref = malloc(sizeof(*rec_ref));
+        rec_ref = lustre_track_new_file_record(rec_id, num_comps, num_stripes);
         if(!rec_ref)
         {
             llapi_layout_free(lustre_layout);
-            LUSTRE_UNLOCK();
             return;
         }
-    
-        ret = darshan_add_record_ref(&(lustre_runtime->record_id_hash),
-            &rec_id, sizeof(darshan_record_id), rec_ref);
-        if(ret == 0)
-        {
-            free(rec_ref);
+    }
+
+    /* fill in record buffer with component info and OST list */
+    darshan_get_lustre_layout_components(lustre_layout, rec_ref);
+
+    comps = (struct darshan_lustre_component *)&(rec_ref->record->comps);
+    if(lustre_runtime->layout_cache &&
+        !llapi_layout_is_composite(lustre_layout) &&
+        rec_ref->record->num_comps == 1 &&
+        comps[0].counters[LUSTRE_COMP_STRIPE_SIZE] != -1)
+    {
+        rec_ref->plain_layout = 1;
+        if(have_dir_id)
+            lustre_cache_dir_layout(dir_id, rec_ref);
+    }
+    llapi_layout_free(lustre_layout);
+
+    return;
+}
+
+/* collect the layout of one queued file and release its descriptor */
+static void lustre_process_layout_req(struct lustre_layout_req *req)
+{
+    struct llapi_layout *lustre_layout = NULL;
+    darshan_record_id dir_id;
+    int have_dir_id = 0;
+    int query;
+
+    /* an earlier request may have since cached this file's layout */
+    LUSTRE_LOCK();
+    query = lustre_runtime && !lustre_runtime->frozen &&
+        !lustre_layout_from_cache(req->rec_id, &have_dir_id, &dir_id);
+    LUSTRE_UNLOCK();
+
+    if(query)
+        lustre_layout = lustre_query_layout(req->fd);
+    if(lustre_layout)
+    {
+        LUSTRE_LOCK();
+        if(lustre_runtime)
+            lustre_record_layout(req->rec_id, lustre_layout, have_dir_id,
+                dir_id);
+        else
             llapi_layout_free(lustre_layout);
-            LUSTRE_UNLOCK();
-            return;
+        LUSTRE_UNLOCK();
+    }
+
+    lustre_real_close(req->fd);
+    free(req);
+
+    return;
+}
+
+/* detach the queued requests; must be called with the module lock held */
+static struct lustre_layout_req *lustre_take_layout_reqs()
+{
+    struct lustre_layout_req *reqs = lustre_runtime->layout_reqs;
+
+    lustre_runtime->layout_reqs = NULL;
+    lustre_runtime->layout_req_count = 0;
+    darshan_clear_record_refs(&(lustre_runtime->layout_req_hash), 0);
+
+    return(reqs);
+}
+
+static void *lustre_layout_helper_main(void *arg)
+{
+    struct lustre_layout_req *reqs, *req, *tmp;
+
+    LUSTRE_LOCK();
+    while(1)
+    {
+        while(!lustre_runtime->layout_reqs && !lustre_runtime->helper_stop)
+            pthread_cond_wait(&lustre_runtime->helper_cond,
+                &lustre_runtime_mutex);
+        /* requests still queued when asked to stop are completed first */
+        if(!lustre_runtime->layout_reqs)
+            break;
+
+        reqs = lustre_take_layout_reqs();
+        LUSTRE_UNLOCK();
+        LL_FOREACH_SAFE(reqs, req, tmp)
+            lustre_process_layout_req(req);
+        LUSTRE_LOCK();
+    }
+    LUSTRE_UNLOCK();
+
+    return(NULL);
+}
+
+/* start the layout helper thread, if not already running; called with the
+ * module lock held
+ */
+static void lustre_start_helper()
+{
+    if(lustre_runtime->helper_running || lustre_runtime->helper_stop)
+        return;
+
+    lustre_runtime->helper_pid = getpid();
+    if(pthread_create(&lustre_runtime->helper, NULL,
+        lustre_layout_helper_main, NULL) == 0)
+        lustre_runtime->helper_running = 1;
+    else
+        /* layouts are then queried by the application threads */
+        lustre_runtime->helper_stop = 1;
+
+    return;
+}
+
+/* stop the layout helper thread, if running, once it has completed the
+ * queued requests; called with the module lock held, which is released
+ * while waiting for the thread to exit
+ */
+static void lustre_stop_helper()
+{
+    int running = lustre_runtime->helper_running;
+
+    lustre_runtime->helper_stop = 1;
+    lustre_runtime->helper_running = 0;
+
+    /* the helper thread does not survive a fork */
+    if(running && lustre_runtime->helper_pid == getpid())
+    {
+        pthread_cond_signal(&lustre_runtime->helper_cond);
+        LUSTRE_UNLOCK();
+        pthread_join(lustre_runtime->helper, NULL);
+        LUSTRE_LOCK();
+    }
+
+    return;
+}
+
+/* hand the layout query for the file open at 'fd' to the helper thread,
+ * returning 0 if the caller has to query it itself; called with the module
+ * lock held
+ */
+static int lustre_queue_layout_req(darshan_record_id rec_id, int fd)
+{
+    struct lustre_layout_req *req;
+    int ret;
+
+    /* the layout has to be known before the first access for OST traffic
+     * accounting, and every queued request holds a descriptor open
+     */
+    if(lustre_ost_traffic ||
+        lustre_runtime->layout_req_count >= LUSTRE_LAYOUT_QUEUE_MAX)
+        return(0);
+
+    lustre_start_helper();
+    if(!lustre_runtime->helper_running ||
+        lustre_runtime->helper_pid != getpid())
+        return(0);
+
+    /* a file closed again before its layout was collected is queried once */
+    if(darshan_lookup_record_ref(lustre_runtime->layout_req_hash,
+        &rec_id, sizeof(darshan_record_id)))
+        return(1);
+
+    req = malloc(sizeof(*req));
+    if(!req)
+        return(0);
+    req->rec_id = rec_id;
+
+    /* the application may close its descriptor before the helper gets to
+     * the request, so the helper works on its own duplicate; fcntl() is
+     * used since dup() is instrumented by the POSIX module
+     */
+    req->fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if(req->fd < 0)
+    {
+        free(req);
+        return(0);
+    }
+
+    ret = darshan_add_record_ref(&(lustre_runtime->layout_req_hash),
+        &rec_id, sizeof(darshan_record_id), req);
+    if(ret == 0)
+    {
+        lustre_real_close(req->fd);
+        free(req);
+        return(0);
+    }
+    LL_PREPEND(lustre_runtime->layout_reqs, req);
+    lustre_runtime->layout_req_count++;
+    pthread_cond_signal(&lustre_runtime->helper_cond);
+
+    return(1);
+}
+
+void darshan_instrument_lustre_file(darshan_record_id rec_id, int fd)
+{
+    struct llapi_layout *lustre_layout;
+    darshan_record_id dir_id;
+    int have_dir_id;
+
+    LUSTRE_LOCK();
+
+    /* try to init module if not already */
+    if(!lustre_runtime && !lustre_runtime_init_attempted)
+        lustre_runtime_initialize();
+
+    /* if we aren't initialized, just back out */
+    if(!lustre_runtime || lustre_runtime->frozen)
+    {
+        LUSTRE_UNLOCK();
+        return;
+    }
+
+    if(lustre_layout_from_cache(rec_id, &have_dir_id, &dir_id) ||
+        lustre_queue_layout_req(rec_id, fd))
+    {
+        LUSTRE_UNLOCK();
+        return;
+    }
+
+    lustre_layout = lustre_query_layout(fd);
+    if(lustre_layout)
+        lustre_record_layout(rec_id, lustre_layout, have_dir_id, dir_id);
+
+    LUSTRE_UNLOCK();
+    return;
+}
+
+void darshan_lustre_finish_layouts()
+{
+    struct lustre_layout_req *reqs, *req, *tmp;
+
+    LUSTRE_LOCK();
+    if(!lustre_runtime)
+    {
+        LUSTRE_UNLOCK();
+        return;
+    }
+
+    lustre_stop_helper();
+
+    /* requests queued in the parent of a forked process, whose helper
+     * thread did not carry over, are completed here
+     */
+    reqs = lustre_take_layout_reqs();
+    LL_FOREACH_SAFE(reqs, req, tmp)
+        lustre_process_layout_req(req);
+
+    LUSTRE_UNLOCK();
+    return;
+}
+
+/* account 'bytes' of a read or write to OST 'ost' */
+static void lustre_ost_traffic_add(struct darshan_lustre_ost_traffic *traffic,
+    OST_ID ost, int64_t bytes, int rw_flag)
+{
+    struct darshan_lustre_ost_traffic *entry;
+
+    if(ost >= 0 && ost < LUSTRE_OST_TRAFFIC_MAX_OSTS)
+        entry = &traffic[ost + 1];
+    else
+        entry = &traffic[0];
+
+    if(rw_flag == DARSHAN_IO_READ)
+    {
+        entry->counters[LUSTRE_OST_BYTES_READ] += bytes;
+        entry->counters[LUSTRE_OST_READS] += 1;
+    }
+    else
+    {
+        entry->counters[LUSTRE_OST_BYTES_WRITTEN] += bytes;
+        entry->counters[LUSTRE_OST_WRITES] += 1;
+    }
+
+    return;
+}
+
+/* number of bytes below file offset 'off' that RAID0 striping maps to stripe
+ * 'stripe' of a component
+ */
+static int64_t lustre_stripe_bytes_below(int64_t off, int64_t stripe,
+    int64_t stripe_size, int64_t stripe_count)
+{
+    int64_t width = stripe_size * stripe_count;
+    int64_t rem = (off % width) - (stripe * stripe_size);
+
+    if(rem < 0)
+        rem = 0;
+    else if(rem > stripe_size)
+        rem = stripe_size;
+
+    return(((off / width) * stripe_size) + rem);
+}
+
+/* map the access [offset, offset+length) of a file to the OSTs in its
+ * layout. only components of the file's first mirror are considered, and
+ * bytes that no instantiated component covers are accounted to OST -1
+ */
+static void lustre_ost_traffic_update(struct lustre_record_ref *rec_ref,
+    int64_t offset, int64_t length, int rw_flag)
+{
+    struct darshan_lustre_ost_traffic *traffic =
+        (struct darshan_lustre_ost_traffic *)
+        &(lustre_runtime->ost_traffic_ref->record->comps);
+    struct darshan_lustre_component *comps =
+        (struct darshan_lustre_component *)&(rec_ref->record->comps);
+    OST_ID *osts = (OST_ID *)(comps + rec_ref->record->num_comps);
+    int64_t end = offset + length;
+    int64_t covered = 0;
+    int64_t seg_start, seg_end;
+    int64_t stripe_size, stripe_count;
+    int64_t first_unit, last_unit, unit;
+    int64_t unit_start, unit_end;
+    int64_t bytes;
+    int64_t mirror_id = comps[0].counters[LUSTRE_COMP_MIRROR_ID];
+    int ost_idx = 0;
+    int i;
+    int64_t j;
+
+    if(length <= 0)
+        return;
+
+    for(i = 0; i < rec_ref->record->num_comps; i++)
+    {
+        /* inactive components have stripe size set to -1 when instrumenting */
+        if(comps[i].counters[LUSTRE_COMP_STRIPE_SIZE] == -1)
+            break;
+
+        stripe_size = comps[i].counters[LUSTRE_COMP_STRIPE_SIZE];
+        stripe_count = comps[i].counters[LUSTRE_COMP_STRIPE_COUNT];
+        if(comps[i].counters[LUSTRE_COMP_MIRROR_ID] != mirror_id ||
+            stripe_size <= 0 || stripe_count <= 0)
+        {
+            ost_idx += stripe_count;
+            continue;
         }
 
-        /* register a Lustre file record with Darshan */
-        rec = darshan_core_register_record(
-                rec_id,
-                NULL, /* either POSIX or STDIO already registered the name */
-                DARSHAN_LUSTRE_MOD,
-                rec_size,
-                NULL);
-        if(rec == NULL)
+        /* an ending extent of -1 means EOF */
+        seg_start = comps[i].counters[LUSTRE_COMP_EXT_START];
+        seg_end = comps[i].counters[LUSTRE_COMP_EXT_END];
+        if(seg_start < offset)
+            seg_start = offset;
+        if(seg_end < 0 || seg_end > end)
+            seg_end = end;
+        if(seg_start >= seg_end)
         {
-            /* if NULL, darshan has no more memory for instrumenting */
-            darshan_delete_record_ref(&(lustre_runtime->record_id_hash),
-                &rec_id, sizeof(darshan_record_id));
-            free(rec_ref);
-            llapi_layout_free(lustre_layout);
-            LUSTRE_UNLOCK();
-            return;
+            ost_idx += stripe_count;
+            continue;
         }
+        covered += seg_end - seg_start;
 
-        /* set base record */
-        rec->base_rec.id = rec_id;
-        rec->base_rec.rank = my_rank;
-        rec_ref->record = rec;
-        rec_ref->record->num_comps = num_comps;
-        rec_ref->record->num_stripes = num_stripes;
+        first_unit = seg_start / stripe_size;
+        last_unit = (seg_end - 1) / stripe_size;
+        if(last_unit - first_unit + 1 < stripe_count)
+        {
+            /* access covers less than a full stripe width, so each stripe
+             * unit it touches is on a different stripe
+             */
+            for(unit = first_unit; unit <= last_unit; unit++)
+            {
+                unit_start = unit * stripe_size;
+                unit_end = unit_start + stripe_size;
+                if(unit_start < seg_start)
+                    unit_start = seg_start;
+                if(unit_end > seg_end)
+                    unit_end = seg_end;
+                lustre_ost_traffic_add(traffic,
+                    osts[ost_idx + (unit % stripe_count)],
+                    unit_end - unit_start, rw_flag);
+            }
+        }
+        else
+        {
+            for(j = 0; j < stripe_count; j++)
+            {
+                bytes = lustre_stripe_bytes_below(seg_end, j, stripe_size,
+                    stripe_count) - lustre_stripe_bytes_below(seg_start, j,
+                    stripe_size, stripe_count);
+                if(bytes > 0)
+                    lustre_ost_traffic_add(traffic, osts[ost_idx + j], bytes,
+                        rw_flag);
+            }
+        }
+        ost_idx += stripe_count;
     }
 
-    /* fill in record buffer with component info and OST list */
-    darshan_get_lustre_layout_components(lustre_layout, rec_ref);
-    llapi_layout_free(lustre_layout);
+    if(covered < length)
+        lustre_ost_traffic_add(traffic, -1, length - covered, rw_flag);
+
+    return;
+}
+
+void darshan_instrument_lustre_io(darshan_record_id rec_id, int64_t offset,
+    int64_t length, int rw_flag)
+{
+    struct lustre_record_ref *rec_ref;
+
+    if(!lustre_ost_traffic)
+        return;
+
+    LUSTRE_LOCK();
+
+    if(!lustre_runtime || lustre_runtime->frozen ||
+        !lustre_runtime->ost_traffic_ref)
+    {
+        LUSTRE_UNLOCK();
+        return;
+    }
+
+    /* files without a Lustre record are not on Lustre */
+    rec_ref = darshan_lookup_record_ref(lustre_runtime->record_id_hash,
+        &rec_id, sizeof(darshan_record_id));
+    if(rec_ref && rec_ref != lustre_runtime->ost_traffic_ref)
+        lustre_ost_traffic_update(rec_ref, offset, length, rw_flag);
 
     LUSTRE_UNLOCK();
     return;
 }
 
+static void lustre_track_ost_traffic_record()
+{
+    struct lustre_record_ref *rec_ref;
+    struct darshan_lustre_record *rec;
+    struct darshan_lustre_ost_traffic *traffic;
+    darshan_record_id rec_id;
+    int num_osts = LUSTRE_OST_TRAFFIC_MAX_OSTS + 1;
+    int ret;
+    int i;
+
+    rec_ref = malloc(sizeof(*rec_ref));
+    if(!rec_ref)
+        return;
+    memset(rec_ref, 0, sizeof(*rec_ref));
+
+    rec_id = darshan_core_gen_record_id(LUSTRE_OST_TRAFFIC_REC_NAME);
+    ret = darshan_add_record_ref(&(lustre_runtime->record_id_hash),
+        &rec_id, sizeof(darshan_record_id), rec_ref);
+    if(ret == 0)
+    {
+        free(rec_ref);
+        return;
+    }
+
+    rec = darshan_core_register_record(
+            rec_id,
+            LUSTRE_OST_TRAFFIC_REC_NAME,
+            DARSHAN_LUSTRE_MOD,
+            LUSTRE_OST_TRAFFIC_RECORD_SIZE(num_osts),
+            NULL);
+    if(rec == NULL)
+    {
+        darshan_delete_record_ref(&(lustre_runtime->record_id_hash),
+            &rec_id, sizeof(darshan_record_id));
+        free(rec_ref);
+        return;
+    }
+
+    rec->base_rec.id = rec_id;
+    rec->base_rec.rank = my_rank;
+    rec->num_comps = LUSTRE_OST_TRAFFIC_COMPS;
+    rec->num_stripes = num_osts;
+    traffic = (struct darshan_lustre_ost_traffic *)&(rec->comps);
+    memset(traffic, 0, num_osts * sizeof(*traffic));
+    for(i = 0; i < num_osts; i++)
+        traffic[i].ost_id = i - 1;
+    rec_ref->record = rec;
+    lustre_runtime->ost_traffic_ref = rec_ref;
+    lustre_ost_traffic = 1;
+
+    return;
+}
+
 static void lustre_runtime_initialize()
 {
     int ret;
@@ -354,6 +985,10 @@ static void lustre_runtime_initialize()
         return;
     }
     memset(lustre_runtime, 0, sizeof(*lustre_runtime));
+    pthread_cond_init(&lustre_runtime->helper_cond, NULL);
+    lustre_runtime->layout_cache = darshan_core_lustre_layout_cache_enabled();
+    if(darshan_core_lustre_ost_traffic_enabled())
+        lustre_track_ost_traffic_record();
 
     return;
 }
@@ -370,6 +1005,7 @@ static void lustre_mpi_redux(
     int shared_rec_count)
 {
     struct lustre_record_ref *rec_ref;
+    struct darshan_lustre_ost_traffic *traffic;
     int i;
 
     LUSTRE_LOCK();
@@ -390,6 +1026,24 @@ static void lustre_mpi_redux(
             rec_ref->record->base_rec.rank = -1;
         else
             darshan_core_fprintf(stderr, "WARNING: unexpected condition in Darshan, possibly triggered by memory corruption.  Darshan log may be incorrect.\n");
+
+        /* if every process accounted OST traffic, sum it on rank 0 */
+        if(rec_ref && rec_ref == lustre_runtime->ost_traffic_ref)
+        {
+            traffic = (struct darshan_lustre_ost_traffic *)
+                &(rec_ref->record->comps);
+            if(my_rank == 0)
+                PMPI_Reduce(MPI_IN_PLACE, traffic,
+                    rec_ref->record->num_stripes * (sizeof(*traffic) / sizeof(int64_t)),
+                    MPI_INT64_T, MPI_SUM, 0, mod_comm);
+            else
+                PMPI_Reduce(traffic, NULL,
+                    rec_ref->record->num_stripes * (sizeof(*traffic) / sizeof(int64_t)),
+                    MPI_INT64_T, MPI_SUM, 0, mod_comm);
+            /* the reduction summed the OST IDs as well */
+            for(i = 0; i < rec_ref->record->num_stripes; i++)
+                traffic[i].ost_id = i - 1;
+        }
     }
 
     LUSTRE_UNLOCK();
@@ -402,6 +1056,29 @@ struct lustre_buf_state
     void *buf;
     size_t buf_size;
 };
+/* drop entries for OSTs that served no traffic from the OST traffic record,
+ * returning its final size
+ */
+static size_t lustre_compact_ost_traffic(struct darshan_lustre_record *rec)
+{
+    struct darshan_lustre_ost_traffic *traffic =
+        (struct darshan_lustre_ost_traffic *)&(rec->comps);
+    int num_osts = 0;
+    int i, j;
+
+    for (i = 0; i < rec->num_stripes; i++)
+    {
+        for (j = 0; j < LUSTRE_OST_NUM_INDICES; j++)
+            if (traffic[i].counters[j] != 0)
+                break;
+        if (j < LUSTRE_OST_NUM_INDICES)
+            traffic[num_osts++] = traffic[i];
+    }
+    rec->num_stripes = num_osts;
+
+    return(LUSTRE_OST_TRAFFIC_RECORD_SIZE(num_osts));
+}
+
 static void lustre_serialize_records(void *rec_ref_p, void *user_ptr)
 {
     struct lustre_record_ref *rec_ref = (struct lustre_record_ref *)rec_ref_p;
@@ -418,23 +1095,30 @@ static void lustre_serialize_records(void *rec_ref_p, void *user_ptr)
     if (my_rank > 0 && rec_ref->record->base_rec.rank == -1)
         return;
 
-    /* update record size to reflect final number of components/stripes */
-    for (i = 0; i < rec_ref->record->num_comps; i++)
+    if (rec_ref == lustre_runtime->ost_traffic_ref)
+    {
+        record_size = lustre_compact_ost_traffic(rec_ref->record);
+    }
+    else
     {
-        /* inactive components have strip size set to -1 when instrumenting */
-        if (comps[i].counters[LUSTRE_COMP_STRIPE_SIZE] == -1)
+        /* update record size to reflect final number of components/stripes */
+        for (i = 0; i < rec_ref->record->num_comps; i++)
         {
-            /* truncate components and set final component and stripe count */
-            rec_ref->record->num_comps = i;
-            /* move OST list up in record buffer to overwrite unused components */
-            memmove(comps + i, osts, num_stripes * sizeof(*osts));
-            break;
+            /* inactive components have strip size set to -1 when instrumenting */
+            if (comps[i].counters[LUSTRE_COMP_STRIPE_SIZE] == -1)
+            {
+                /* truncate components and set final component and stripe count */
+                rec_ref->record->num_comps = i;
+                /* move OST list up in record buffer to overwrite unused components */
+                memmove(comps + i, osts, num_stripes * sizeof(*osts));
+                break;
+            }
+            num_stripes += comps[i].counters[LUSTRE_COMP_STRIPE_COUNT];
         }
-        num_stripes += comps[i].counters[LUSTRE_COMP_STRIPE_COUNT];
-    }
-    rec_ref->record->num_stripes = num_stripes;
+        rec_ref->record->num_stripes = num_stripes;
 
-    record_size = LUSTRE_RECORD_SIZE(rec_ref->record->num_comps, rec_ref->record->num_stripes);
+        record_size = LUSTRE_RECORD_SIZE(rec_ref->record->num_comps, rec_ref->record->num_stripes);
+    }
 
     /* determine whether this record needs to be shifted back in the final record buffer */
     /* NOTE: this happens when preceding records in the output buffer have been shifted
@@ -474,12 +1158,39 @@ static void lustre_output(
 
 static void lustre_cleanup()
 {
+    struct lustre_layout_req *reqs, *req, *tmp;
+    pthread_mutexattr_t attr;
+
+    /* after a fork, the child's lock is left as the parent's helper
+     * thread held it, and that thread is gone
+     */
+    if(lustre_runtime && lustre_runtime->helper_running &&
+        lustre_runtime->helper_pid != getpid())
+    {
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init(&lustre_runtime_mutex, &attr);
+        pthread_mutexattr_destroy(&attr);
+    }
+
     LUSTRE_LOCK();
     assert(lustre_runtime);
 
+    /* drop any requests left when no log was written */
+    lustre_stop_helper();
+    reqs = lustre_take_layout_reqs();
+    LL_FOREACH_SAFE(reqs, req, tmp)
+    {
+        lustre_real_close(req->fd);
+        free(req);
+    }
+    pthread_cond_destroy(&lustre_runtime->helper_cond);
+
     /* cleanup data structures */
     darshan_clear_record_refs(&(lustre_runtime->record_id_hash), 1);
+    darshan_clear_record_refs(&(lustre_runtime->dir_layout_hash), 1);
     free(lustre_runtime);
+    lustre_ost_traffic = 0;
     lustre_runtime = NULL;
     lustre_runtime_init_attempted = 0;
 
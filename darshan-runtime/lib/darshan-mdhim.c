@@ -37,6 +37,14 @@ DARSHAN_FORWARD_DECL(mdhimPut, mdhim_rm_t *, (mdhim_t *md,
 DARSHAN_FORWARD_DECL(mdhimGet, mdhim_grm_t *, (mdhim_t *md,
         index_t *index, void *key, size_t key_len, int op));
 
+DARSHAN_FORWARD_DECL(mdhimBPut, mdhim_brm_t *, (mdhim_t *md,
+        index_t *index, void **primary_keys, size_t *primary_key_lens,
+        void **primary_values, size_t *primary_value_lens, int num_records));
+
+DARSHAN_FORWARD_DECL(mdhimBGet, mdhim_bgrm_t *, (mdhim_t *md,
+        index_t *index, void **keys, size_t *key_lens, int num_keys,
+        enum TransportGetMessageOp op));
+
 DARSHAN_FORWARD_DECL(mdhimInit, int, (mdhim_t *md, mdhim_options_t *opts));
 
 /* The mdhim_record_ref structure maintains necessary runtime metadata
@@ -125,6 +133,41 @@ static int my_rank = -1;
 #define MDHIM_WTIME() \
     __darshan_disabled ? 0 : darshan_core_wtime();
 
+/* index of the latency histogram bucket for an operation taking 'elapsed'
+ * seconds; buckets grow by a factor of 10 from 10us up to 1s
+ */
+static int mdhim_latency_bucket(double elapsed)
+{
+    double bound = 1e-5;
+    int i;
+
+    for(i = 0; i < MDHIM_PUT_LAT_1S_PLUS - MDHIM_PUT_LAT_0_10US; i++)
+    {
+        if(elapsed < bound)
+            break;
+        bound *= 10;
+    }
+
+    return(i);
+}
+
+/* index of the batch size histogram bucket for a bulk operation on
+ * 'num_keys' keys
+ */
+static int mdhim_batch_bucket(int num_keys)
+{
+    if(num_keys <= 1)
+        return(0);
+    else if(num_keys <= 10)
+        return(1);
+    else if(num_keys <= 100)
+        return(2);
+    else if(num_keys <= 1000)
+        return(3);
+    else
+        return(4);
+}
+
 /* the MDHIM_PRE_RECORD macro is executed before performing MDHIM
  * module instrumentation of a call. It obtains a lock for updating
  * module data strucutres, and ensure the MDHIM module has been properly
@@ -176,8 +219,12 @@ static int my_rank = -1;
     if(rec_ref->record_p->fcounters[MDHIM_F_PUT_TIMESTAMP] == 0 || \
      rec_ref->record_p->fcounters[MDHIM_F_PUT_TIMESTAMP] > __tm1) \
         rec_ref->record_p->fcounters[MDHIM_F_PUT_TIMESTAMP] = __tm1; \
-    /* record which server gets this request */ \
+    rec_ref->record_p->fcounters[MDHIM_F_PUT_TIME] += __elapsed; \
+    rec_ref->record_p->counters[MDHIM_PUT_LAT_0_10US + \
+        mdhim_latency_bucket(__elapsed)] += 1; \
+    /* record which server gets this request, and for how long */ \
     rec_ref->record_p->server_histogram[(__id)]++; \
+    MDHIM_SERVER_TIMES(rec_ref->record_p)[(__id)] += __elapsed; \
 } while(0)
 
 /* macro for instrumenting the "MDHIM" module's get function */
@@ -205,8 +252,40 @@ static int my_rank = -1;
     if(rec_ref->record_p->fcounters[MDHIM_F_GET_TIMESTAMP] == 0 || \
      rec_ref->record_p->fcounters[MDHIM_F_GET_TIMESTAMP] > __tm1) \
         rec_ref->record_p->fcounters[MDHIM_F_GET_TIMESTAMP] = __tm1; \
+    rec_ref->record_p->fcounters[MDHIM_F_GET_TIME] += __elapsed; \
+    rec_ref->record_p->counters[MDHIM_GET_LAT_0_10US + \
+        mdhim_latency_bucket(__elapsed)] += 1; \
     /* server distribution */ \
     rec_ref->record_p->server_histogram[(__id)]++; \
+    MDHIM_SERVER_TIMES(rec_ref->record_p)[(__id)] += __elapsed; \
+} while(0)
+
+/* macro for instrumenting the "MDHIM" module's bulk put and get functions;
+ * '__op' is BPUT or BGET.  Each key counts as an operation sent to its
+ * server, and the time of the call is split evenly over the keys.
+ */
+#define MDHIM_RECORD_BULK(__op, __ret, __md, __index, __keys, __key_lens, __num, __tm1, __tm2) do{ \
+    darshan_record_id rec_id; \
+    struct mdhim_record_ref *rec_ref; \
+    double __elapsed = __tm2 - __tm1; \
+    double *__server_times; \
+    int __i, __id; \
+    if(__ret == NULL || __num < 1) break; \
+    rec_id = darshan_core_gen_record_id(RECORD_STRING); \
+    rec_ref = darshan_lookup_record_ref(mdhim_runtime->rec_id_hash, &rec_id, sizeof(darshan_record_id)); \
+    if(!rec_ref) break; \
+    rec_ref->record_p->counters[MDHIM_##__op##S] += 1; \
+    rec_ref->record_p->counters[MDHIM_##__op##_KEYS] += __num; \
+    rec_ref->record_p->counters[MDHIM_##__op##_BATCH_1 + \
+        mdhim_batch_bucket(__num)] += 1; \
+    rec_ref->record_p->fcounters[MDHIM_F_##__op##_TIME] += __elapsed; \
+    __server_times = MDHIM_SERVER_TIMES(rec_ref->record_p); \
+    for(__i = 0; __i < __num; __i++) { \
+        __id = mdhimWhichDB(__md, (__keys)[__i], (__key_lens)[__i]); \
+        if(__id < 0 || __id >= rec_ref->record_p->counters[MDHIM_SERVERS]) continue; \
+        rec_ref->record_p->server_histogram[__id]++; \
+        __server_times[__id] += __elapsed / __num; \
+    } \
 } while(0)
 
 /**********************************************************
@@ -228,6 +307,8 @@ int DARSHAN_DECL(mdhimInit)(mdhim_t *md, mdhim_options_t *opts)
     struct mdhim_record_ref *rec_ref;
     int nr_servers;
 
+    MAP_OR_FAIL(mdhimInit);
+
     MPI_Comm_size(opts->comm, &nr_servers);
 
     MDHIM_PRE_RECORD();
@@ -247,7 +328,6 @@ int DARSHAN_DECL(mdhimInit)(mdhim_t *md, mdhim_options_t *opts)
 
     MDHIM_POST_RECORD();
 
-    MAP_OR_FAIL(mdhimInit);
     ret = __real_mdhimInit(md, opts);
     return ret;
 
@@ -287,6 +367,30 @@ mdhim_rm_t *DARSHAN_DECL(mdhimPut)(mdhim_t *md,
     return(ret);
 }
 
+mdhim_brm_t *DARSHAN_DECL(mdhimBPut)(mdhim_t *md,
+        index_t *index,
+        void **primary_keys, size_t *primary_key_lens,
+        void **primary_values, size_t *primary_value_lens,
+        int num_records)
+{
+    mdhim_brm_t *ret;
+    double tm1, tm2;
+
+    MAP_OR_FAIL(mdhimBPut);
+
+    tm1 = MDHIM_WTIME();
+    ret = __real_mdhimBPut(md, index, primary_keys, primary_key_lens,
+        primary_values, primary_value_lens, num_records);
+    tm2 = MDHIM_WTIME();
+
+    MDHIM_PRE_RECORD();
+    MDHIM_RECORD_BULK(BPUT, ret, md, index, primary_keys, primary_key_lens,
+        num_records, tm1, tm2);
+    MDHIM_POST_RECORD();
+
+    return(ret);
+}
+
 mdhim_grm_t * DARSHAN_DECL(mdhimGet)(mdhim_t *md,
         index_t *index, void *key, size_t key_len,
         enum TransportGetMessageOp op)
@@ -312,6 +416,27 @@ mdhim_grm_t * DARSHAN_DECL(mdhimGet)(mdhim_t *md,
     return ret;
 }
 
+mdhim_bgrm_t *DARSHAN_DECL(mdhimBGet)(mdhim_t *md,
+        index_t *index, void **keys, size_t *key_lens, int num_keys,
+        enum TransportGetMessageOp op)
+{
+    mdhim_bgrm_t *ret;
+    double tm1, tm2;
+
+    MAP_OR_FAIL(mdhimBGet);
+
+    tm1 = MDHIM_WTIME();
+    ret = __real_mdhimBGet(md, index, keys, key_lens, num_keys, op);
+    tm2 = MDHIM_WTIME();
+
+    MDHIM_PRE_RECORD();
+    MDHIM_RECORD_BULK(BGET, ret, md, index, keys, key_lens, num_keys,
+        tm1, tm2);
+    MDHIM_POST_RECORD();
+
+    return(ret);
+}
+
 /**********************************************************
  * Internal functions for manipulating MDHIM module state *
  **********************************************************/
@@ -321,7 +446,7 @@ mdhim_grm_t * DARSHAN_DECL(mdhimGet)(mdhim_t *md,
 static void mdhim_runtime_initialize()
 {
     int ret;
-    size_t mdhim_rec_count
+    size_t mdhim_rec_count;
     darshan_module_funcs mod_funcs = {
     .mod_redux_func = &mdhim_mpi_redux,
     .mod_output_func = &mdhim_output,
@@ -403,8 +528,10 @@ static struct mdhim_record_ref *mdhim_track_new_record(
     /* registering this file record was successful, so initialize some fields */
     record_p->base_rec.id = rec_id;
     record_p->base_rec.rank = my_rank;
+    record_p->counters[MDHIM_SERVERS] = nr_servers;
     rec_ref->record_p = record_p;
     mdhim_runtime->rec_count++;
+    mdhim_runtime->record_size = rec_size;
 
 
     /* return pointer to the record reference */
@@ -415,14 +542,19 @@ static void mdhim_record_reduction_op(void *infile_v, void *inoutfile_v,
         int *len, MPI_Datatype *datatype)
 {
     struct darshan_mdhim_record *tmp_rec;
-    struct darshan_mdhim_record *inrec = infile_v;
-    struct darshan_mdhim_record *inoutrec = inoutfile_v;
+    struct darshan_mdhim_record *inrec;
+    struct darshan_mdhim_record *inoutrec;
+    double *in_times, *tmp_times, *inout_times;
+    size_t rec_size;
     int i, j;
 
     for (i=0; i< *len; i++) {
+        inrec = infile_v;
+        inoutrec = inoutfile_v;
+        rec_size = MDHIM_RECORD_SIZE(inrec->counters[MDHIM_SERVERS]);
+
         /* can't use 'sizeof': server count historgram */
-        tmp_rec = calloc(1,
-                MDHIM_RECORD_SIZE(inrec->counters[MDHIM_SERVERS]));
+        tmp_rec = calloc(1, rec_size);
         tmp_rec->base_rec.id = inrec->base_rec.id;
         tmp_rec->base_rec.rank = -1;
 
@@ -439,6 +571,12 @@ static void mdhim_record_reduction_op(void *infile_v, void *inoutfile_v,
         }
         tmp_rec->counters[MDHIM_SERVERS] = inrec->counters[MDHIM_SERVERS];
 
+        /* sum bulk operation counts and the latency and batch histograms */
+        for (j=MDHIM_BPUTS; j<MDHIM_NUM_INDICES; j++) {
+            tmp_rec->counters[j] = inrec->counters[j] +
+                inoutrec->counters[j];
+        }
+
         /* min non-zero value */
         for (j=MDHIM_F_PUT_TIMESTAMP; j<=MDHIM_F_GET_TIMESTAMP; j++)
         {
@@ -457,23 +595,31 @@ static void mdhim_record_reduction_op(void *infile_v, void *inoutfile_v,
                         inrec->fcounters[j] :
                         inoutrec->fcounters[j]);
         }
+        /* sum */
+        for (j=MDHIM_F_PUT_TIME; j<MDHIM_F_NUM_INDICES; j++)
+        {
+            tmp_rec->fcounters[j] = inrec->fcounters[j] +
+                inoutrec->fcounters[j];
+        }
         /* dealing with server histogram a little odd.  Every client kept track
          * of which servers it sent to, so we'll simply sum them all up.  The
          * data lives at the end of the struct (remember, alocated based on
-         * MDHIM_RECORD_SIZE macro)  */
+         * MDHIM_RECORD_SIZE macro).  The same goes for the time spent on
+         * each server. */
+        in_times = MDHIM_SERVER_TIMES(inrec);
+        inout_times = MDHIM_SERVER_TIMES(inoutrec);
+        tmp_times = MDHIM_SERVER_TIMES(tmp_rec);
         for (j=0; j< tmp_rec->counters[MDHIM_SERVERS]; j++) {
             tmp_rec->server_histogram[j] = inrec->server_histogram[j] +
                 inoutrec->server_histogram[j];
+            tmp_times[j] = in_times[j] + inout_times[j];
         }
-        memcpy(inoutrec, tmp_rec,
-                MDHIM_RECORD_SIZE(tmp_rec->counters[MDHIM_SERVERS]));
+        memcpy(inoutrec, tmp_rec, rec_size);
         free(tmp_rec);
 
         /* updating not as simple as incrementing, unfortunately */
-        infile_v = (char *) infile_v +
-            MDHIM_RECORD_SIZE(tmp_rec->counters[MDHIM_SERVERS]);
-        inoutfile_v = (char *)inoutfile_v +
-            MDHIM_RECORD_SIZE(tmp_rec->counters[MDHIM_SERVERS]);
+        infile_v = (char *) infile_v + rec_size;
+        inoutfile_v = (char *)inoutfile_v + rec_size;
     }
     return;
 }
@@ -494,7 +640,7 @@ static void mdhim_mpi_redux(
     /* walking through these arrays will be awkward if there is more than one
      * record: the 'server_histogram' field is variable */
     struct darshan_mdhim_record *mdhim_rec_buf =
-        *(struct darshan_mdhim_record **)mdhim_buf;
+        (struct darshan_mdhim_record *)mdhim_buf;
     int mdhim_rec_count;
 
     MDHIM_LOCK();
@@ -535,7 +681,9 @@ static void mdhim_mpi_redux(
                 MDHIM_RECORD_SIZE(nr_servers));
 
         /* make send_buf point to shared files at end */
-        red_send_buf = &(mdhim_rec_buf[mdhim_rec_count-shared_rec_count]);
+        red_send_buf = (struct darshan_mdhim_record *)((char *)mdhim_rec_buf +
+                (mdhim_rec_count-shared_rec_count) *
+                MDHIM_RECORD_SIZE(nr_servers));
 
         if (my_rank == 0)
         {
@@ -0,0 +1,1047 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <darshan-runtime-config.h>
+#endif
+
+#define _XOPEN_SOURCE 500
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <pthread.h>
+#include <assert.h>
+#include <sys/mman.h>
+
+#include "uthash.h"
+#include "darshan.h"
+#include "darshan-mmap.h"
+
+/* default time, in seconds, between residency samples */
+#define MMAP_DEF_SAMPLE_INTERVAL 1.0
+/* most mappings sampled at once; later mappings are only counted */
+#define MMAP_MAX_REGIONS 1024
+/* most bits in the bitmap of blocks seen resident of one mapping; mappings
+ * of more pages than this are tracked in blocks of several pages
+ */
+#define MMAP_MAX_BLOCKS (1 << 20)
+/* most pages queried by one mincore() call */
+#define MMAP_VEC_PAGES 65536
+
+#define MMAP_BIT_TEST(__map, __bit) \
+    ((__map)[(__bit) >> 6] & (UINT64_C(1) << ((__bit) & 63)))
+#define MMAP_BIT_SET(__map, __bit) \
+    ((__map)[(__bit) >> 6] |= (UINT64_C(1) << ((__bit) & 63)))
+
+/* The mmap_record_ref structure maintains necessary runtime metadata
+ * for each MMAP record, indexed by the POSIX record id of the mapped file.
+ */
+struct mmap_record_ref
+{
+    struct darshan_mmap_record *record_p;
+};
+
+/* a live mapping of a file, indexed by its start address, and the blocks
+ * of its pages that have been seen resident so far
+ */
+struct mmap_region
+{
+    char *start;
+    size_t length;
+    size_t npages;
+    int block_shift;
+    int sampled;
+    uint64_t *seen;
+    struct mmap_record_ref *rec_ref;
+#ifndef DARSHAN_WRAP_MMAP
+    unsigned long scan_gen;
+#endif
+    UT_hash_handle hlink;
+};
+
+/* The mmap_runtime structure maintains necessary state for storing
+ * MMAP records, for sampling the tracked mappings, and for coordinating
+ * with darshan-core at shutdown time.
+ */
+struct mmap_runtime
+{
+    void *rec_id_hash;
+    int rec_count;
+    struct mmap_region *region_hash;
+    int region_count;
+    size_t page_size;
+    double interval;
+    unsigned char *vec;
+#ifndef DARSHAN_WRAP_MMAP
+    void *skip_hash; /* ids of mapped files that are not instrumented */
+    char *maps_buf;
+    size_t maps_buf_sz;
+    unsigned long scan_gen;
+#endif
+    pthread_t sampler;
+    pthread_cond_t sampler_cond;
+    pid_t sampler_pid;
+    int sampler_running;
+    int sampler_stop;
+    int frozen; /* flag to indicate that the counters should no longer be modified */
+};
+
+int mmap_runtime_enabled = 0;
+
+static struct mmap_runtime *mmap_runtime = NULL;
+static pthread_mutex_t mmap_runtime_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int my_rank = -1;
+
+static struct mmap_record_ref *mmap_track_new_record(
+    darshan_record_id rec_id, const char *path);
+static struct mmap_region *mmap_add_region(
+    struct mmap_record_ref *rec_ref, void *addr, size_t length,
+    int prot, int flags);
+static int mmap_sample_region(
+    struct mmap_region *region);
+static void mmap_drop_region(
+    struct mmap_region *region, int mapped);
+static void mmap_start_sampler(
+    void);
+static void mmap_stop_sampler(
+    void);
+static void *mmap_sampler_main(
+    void *arg);
+static void mmap_finish_sampling(
+    void);
+#ifndef DARSHAN_WRAP_MMAP
+static void mmap_scan_maps(
+    void);
+#endif
+static void mmap_record_merge(
+    struct darshan_mmap_record *infile,
+    struct darshan_mmap_record *inoutfile);
+#ifdef HAVE_MPI
+static void mmap_record_reduction_op(
+    void* infile_v, void* inoutfile_v, int *len, MPI_Datatype *datatype);
+static void mmap_mpi_redux(
+    void *mmap_buf, MPI_Comm mod_comm,
+    darshan_record_id *shared_recs, int shared_rec_count);
+#endif
+static void mmap_output(
+    void **mmap_buf, int *mmap_buf_sz);
+static void mmap_cleanup(
+    void);
+
+#define MMAP_LOCK() pthread_mutex_lock(&mmap_runtime_mutex)
+#define MMAP_UNLOCK() pthread_mutex_unlock(&mmap_runtime_mutex)
+
+/**********************************************************
+ *      Hooks for tracking mappings made through POSIX    *
+ **********************************************************/
+
+void mmap_track_region(darshan_record_id rec_id, void *addr, size_t length,
+    int prot, int flags)
+{
+    struct mmap_record_ref *rec_ref;
+
+    MMAP_LOCK();
+    if(!mmap_runtime || mmap_runtime->frozen)
+    {
+        MMAP_UNLOCK();
+        return;
+    }
+
+    rec_ref = darshan_lookup_record_ref(mmap_runtime->rec_id_hash,
+        &rec_id, sizeof(darshan_record_id));
+    if(!rec_ref)
+        rec_ref = mmap_track_new_record(rec_id, NULL);
+    if(rec_ref && mmap_add_region(rec_ref, addr, length, prot, flags))
+        mmap_start_sampler();
+    MMAP_UNLOCK();
+
+    return;
+}
+
+void mmap_untrack_region(void *addr, size_t length)
+{
+    struct mmap_region *region, *tmp;
+    char *start = addr;
+    char *end = start + length;
+
+    MMAP_LOCK();
+    if(!mmap_runtime || mmap_runtime->frozen || !mmap_runtime->region_count)
+    {
+        MMAP_UNLOCK();
+        return;
+    }
+
+    /* mappings are usually unmapped whole, but any tracked mapping that
+     * the range overlaps is going away at least in part
+     */
+    HASH_FIND(hlink, mmap_runtime->region_hash, &start, sizeof(char *), region);
+    if(region && region->length <= length)
+        mmap_drop_region(region, 1);
+    else
+    {
+        HASH_ITER(hlink, mmap_runtime->region_hash, region, tmp)
+        {
+            if(region->start < end && start < region->start + region->length)
+                mmap_drop_region(region, 1);
+        }
+    }
+    MMAP_UNLOCK();
+
+    return;
+}
+
+/**********************************************************
+ * Internal functions for manipulating MMAP module state *
+ **********************************************************/
+
+void mmap_runtime_initialize()
+{
+    int ret;
+    long page_size;
+    size_t mmap_rec_count;
+    darshan_module_funcs mod_funcs = {
+#ifdef HAVE_MPI
+    .mod_redux_func = &mmap_mpi_redux,
+#endif
+    .mod_output_func = &mmap_output,
+    .mod_cleanup_func = &mmap_cleanup
+    };
+
+    MMAP_LOCK();
+
+    /* don't do anything if already initialized */
+    if(mmap_runtime)
+    {
+        MMAP_UNLOCK();
+        return;
+    }
+
+    /* try and store a default number of records for this module */
+    mmap_rec_count = DARSHAN_DEF_MOD_REC_COUNT;
+
+    /* register the MMAP module with darshan core; this fails while the
+     * module is disabled, which it is by default
+     */
+    ret = darshan_core_register_module(
+        DARSHAN_MMAP_MOD,
+        mod_funcs,
+        sizeof(struct darshan_mmap_record),
+        &mmap_rec_count,
+        &my_rank,
+        NULL);
+    if(ret < 0)
+    {
+        MMAP_UNLOCK();
+        return;
+    }
+
+    page_size = sysconf(_SC_PAGESIZE);
+    mmap_runtime = malloc(sizeof(*mmap_runtime));
+    if(mmap_runtime)
+    {
+        memset(mmap_runtime, 0, sizeof(*mmap_runtime));
+        mmap_runtime->vec = malloc(MMAP_VEC_PAGES);
+    }
+    if(!mmap_runtime || !mmap_runtime->vec || page_size <= 0)
+    {
+        if(mmap_runtime)
+            free(mmap_runtime->vec);
+        free(mmap_runtime);
+        mmap_runtime = NULL;
+        darshan_core_unregister_module(DARSHAN_MMAP_MOD);
+        MMAP_UNLOCK();
+        return;
+    }
+    mmap_runtime->page_size = page_size;
+    mmap_runtime->interval = darshan_core_mmap_sample_interval();
+    if(mmap_runtime->interval <= 0)
+        mmap_runtime->interval = MMAP_DEF_SAMPLE_INTERVAL;
+    pthread_cond_init(&mmap_runtime->sampler_cond, NULL);
+    mmap_runtime_enabled = 1;
+
+#ifndef DARSHAN_WRAP_MMAP
+    /* without mmap wrappers, the sampler finds the mappings on its own */
+    mmap_start_sampler();
+#endif
+
+    MMAP_UNLOCK();
+    return;
+}
+
+static struct mmap_record_ref *mmap_track_new_record(
+    darshan_record_id rec_id, const char *path)
+{
+    struct darshan_mmap_record *record_p = NULL;
+    struct mmap_record_ref *rec_ref = NULL;
+    int ret;
+
+    rec_ref = malloc(sizeof(*rec_ref));
+    if(!rec_ref)
+        return(NULL);
+    memset(rec_ref, 0, sizeof(*rec_ref));
+
+    /* add a reference to this record */
+    ret = darshan_add_record_ref(&(mmap_runtime->rec_id_hash), &rec_id,
+        sizeof(darshan_record_id), rec_ref);
+    if(ret == 0)
+    {
+        free(rec_ref);
+        return(NULL);
+    }
+
+    /* register the actual record with darshan-core so it is persisted in
+     * the log file.  The path is NULL for mappings made through the POSIX
+     * module, which has already registered the name for this record id.
+     */
+    record_p = darshan_core_register_record(
+        rec_id,
+        path,
+        DARSHAN_MMAP_MOD,
+        sizeof(struct darshan_mmap_record),
+        NULL);
+
+    if(!record_p)
+    {
+        darshan_delete_record_ref(&(mmap_runtime->rec_id_hash),
+            &rec_id, sizeof(darshan_record_id));
+        free(rec_ref);
+        return(NULL);
+    }
+
+    /* registering this record was successful, so initialize some fields */
+    record_p->base_rec.id = rec_id;
+    record_p->base_rec.rank = my_rank;
+    record_p->counters[MMAP_PAGE_SIZE] = mmap_runtime->page_size;
+    rec_ref->record_p = record_p;
+    mmap_runtime->rec_count++;
+
+    return(rec_ref);
+}
+
+/* start tracking a mapping of the file of 'rec_ref', returning the new
+ * region, or NULL if the mapping is not tracked
+ */
+static struct mmap_region *mmap_add_region(
+    struct mmap_record_ref *rec_ref, void *addr, size_t length,
+    int prot, int flags)
+{
+    struct darshan_mmap_record *rec = rec_ref->record_p;
+    struct mmap_region *region;
+    char *start = addr;
+    size_t nblocks;
+
+    if(!length)
+        return(NULL);
+
+    /* a mapping made over a tracked one with MAP_FIXED replaces it */
+    HASH_FIND(hlink, mmap_runtime->region_hash, &start, sizeof(char *), region);
+    if(region)
+        mmap_drop_region(region, 0);
+
+    region = NULL;
+    if(mmap_runtime->region_count < MMAP_MAX_REGIONS)
+        region = malloc(sizeof(*region));
+    if(region)
+    {
+        memset(region, 0, sizeof(*region));
+        region->npages = (length + mmap_runtime->page_size - 1) /
+            mmap_runtime->page_size;
+        while((region->npages >> region->block_shift) > MMAP_MAX_BLOCKS)
+            region->block_shift++;
+        nblocks = ((region->npages - 1) >> region->block_shift) + 1;
+        region->seen = calloc((nblocks + 63) / 64, sizeof(uint64_t));
+        if(!region->seen)
+        {
+            free(region);
+            region = NULL;
+        }
+    }
+    if(!region)
+    {
+        rec->counters[MMAP_UNTRACKED_MAPS] += 1;
+        return(NULL);
+    }
+    region->start = start;
+    region->length = length;
+    region->rec_ref = rec_ref;
+    HASH_ADD(hlink, mmap_runtime->region_hash, start, sizeof(char *), region);
+    mmap_runtime->region_count++;
+
+    rec->counters[MMAP_MAPS] += 1;
+    rec->counters[MMAP_MAPPED_BYTES] += length;
+    if((int64_t)length > rec->counters[MMAP_MAX_MAPPED_BYTES])
+        rec->counters[MMAP_MAX_MAPPED_BYTES] = length;
+    if((prot & PROT_WRITE) && (flags & MAP_SHARED))
+        rec->counters[MMAP_WRITE_MAPS] += 1;
+    if(rec->fcounters[MMAP_F_MAP_START_TIMESTAMP] == 0)
+        rec->fcounters[MMAP_F_MAP_START_TIMESTAMP] = darshan_core_wtime();
+
+    /* the first sample separates pages that were already resident, e.g.
+     * in the page cache, from those faulted in through this mapping
+     */
+    if(mmap_sample_region(region) < 0)
+    {
+        mmap_drop_region(region, 0);
+        return(NULL);
+    }
+
+    return(region);
+}
+
+/* sample the residency of a mapping's pages with mincore(), accounting the
+ * pages seen resident for the first time to the mapping's record. Returns
+ * -1 if the mapping no longer exists, 0 otherwise.
+ */
+static int mmap_sample_region(struct mmap_region *region)
+{
+    struct darshan_mmap_record *rec = region->rec_ref->record_p;
+    size_t page_size = mmap_runtime->page_size;
+    size_t page, n, i;
+    size_t blk, prev_blk;
+    size_t new_blk = (size_t)-1;
+    int64_t resident = 0;
+    double tm1, tm2;
+
+    tm1 = darshan_core_wtime();
+    for(page = 0; page < region->npages; page += n)
+    {
+        n = region->npages - page;
+        if(n > MMAP_VEC_PAGES)
+            n = MMAP_VEC_PAGES;
+        if(mincore(region->start + page * page_size, n * page_size,
+            mmap_runtime->vec) < 0)
+            return(-1);
+
+        for(i = 0; i < n; i++)
+        {
+            if(!(mmap_runtime->vec[i] & 1))
+                continue;
+            resident++;
+
+            /* pages of a block count as new in the sample that first finds
+             * any of them resident
+             */
+            blk = (page + i) >> region->block_shift;
+            if(blk != new_blk)
+            {
+                if(MMAP_BIT_TEST(region->seen, blk))
+                    continue;
+                MMAP_BIT_SET(region->seen, blk);
+                new_blk = blk;
+            }
+
+            if(!region->sampled)
+            {
+                rec->counters[MMAP_INITIAL_RESIDENT_BYTES] += page_size;
+                continue;
+            }
+            rec->counters[MMAP_FAULTED_BYTES] += page_size;
+
+            /* pages are visited in order, so a page directly following one
+             * found resident earlier in this sample is also sequential
+             */
+            prev_blk = (page + i - 1) >> region->block_shift;
+            if(page + i == 0 || prev_blk == blk ||
+                MMAP_BIT_TEST(region->seen, prev_blk))
+                rec->counters[MMAP_SEQ_PAGES] += 1;
+            else
+                rec->counters[MMAP_RANDOM_PAGES] += 1;
+        }
+    }
+    tm2 = darshan_core_wtime();
+
+    region->sampled = 1;
+    rec->counters[MMAP_SAMPLES] += 1;
+    if(resident * (int64_t)page_size > rec->counters[MMAP_MAX_RESIDENT_BYTES])
+        rec->counters[MMAP_MAX_RESIDENT_BYTES] = resident * page_size;
+    rec->fcounters[MMAP_F_SAMPLE_TIME] += tm2 - tm1;
+    rec->fcounters[MMAP_F_SAMPLE_END_TIMESTAMP] = tm2;
+
+    return(0);
+}
+
+/* stop tracking a mapping, taking a last sample first if it is still
+ * 'mapped', and account the extents of the blocks seen resident
+ */
+static void mmap_drop_region(struct mmap_region *region, int mapped)
+{
+    size_t nblocks = ((region->npages - 1) >> region->block_shift) + 1;
+    size_t nwords = (nblocks + 63) / 64;
+    uint64_t carry = 0;
+    uint64_t word;
+    int64_t extents = 0;
+    size_t i;
+
+    if(mapped)
+        mmap_sample_region(region);
+
+    /* count the blocks that are seen but whose predecessor is not */
+    for(i = 0; i < nwords; i++)
+    {
+        word = region->seen[i];
+        if(word)
+        {
+            word &= ~((word << 1) | carry);
+#ifdef __GNUC__
+            extents += __builtin_popcountll(word);
+#else
+            for(; word; word &= word - 1)
+                extents++;
+#endif
+        }
+        carry = region->seen[i] >> 63;
+    }
+    region->rec_ref->record_p->counters[MMAP_RESIDENT_EXTENTS] += extents;
+
+    HASH_DELETE(hlink, mmap_runtime->region_hash, region);
+    mmap_runtime->region_count--;
+    free(region->seen);
+    free(region);
+
+    return;
+}
+
+/* start the sampler thread, if not already running; called with the
+ * module lock held
+ */
+static void mmap_start_sampler()
+{
+    if(mmap_runtime->sampler_running || mmap_runtime->sampler_stop)
+        return;
+
+    mmap_runtime->sampler_pid = getpid();
+    if(pthread_create(&mmap_runtime->sampler, NULL, mmap_sampler_main,
+        NULL) == 0)
+        mmap_runtime->sampler_running = 1;
+    else
+        /* mappings are then only sampled when made and unmapped */
+        mmap_runtime->sampler_stop = 1;
+
+    return;
+}
+
+/* stop the sampler thread, if running; called with the module lock held,
+ * which is released while waiting for the thread to exit
+ */
+static void mmap_stop_sampler()
+{
+    int running = mmap_runtime->sampler_running;
+
+    mmap_runtime->sampler_stop = 1;
+    mmap_runtime->sampler_running = 0;
+
+    /* the sampler thread does not survive a fork */
+    if(running && mmap_runtime->sampler_pid == getpid())
+    {
+        pthread_cond_signal(&mmap_runtime->sampler_cond);
+        MMAP_UNLOCK();
+        pthread_join(mmap_runtime->sampler, NULL);
+        MMAP_LOCK();
+    }
+
+    return;
+}
+
+static void *mmap_sampler_main(void *arg)
+{
+    struct mmap_region *region, *tmp;
+    struct timespec ts;
+    double next;
+
+    MMAP_LOCK();
+    while(!mmap_runtime->sampler_stop)
+    {
+        clock_gettime(CLOCK_REALTIME, &ts);
+        next = ts.tv_sec + ts.tv_nsec / 1e9 + mmap_runtime->interval;
+        ts.tv_sec = (time_t)next;
+        ts.tv_nsec = (long)((next - ts.tv_sec) * 1e9);
+        pthread_cond_timedwait(&mmap_runtime->sampler_cond,
+            &mmap_runtime_mutex, &ts);
+        if(mmap_runtime->sampler_stop)
+            break;
+
+#ifndef DARSHAN_WRAP_MMAP
+        mmap_scan_maps();
+#endif
+        HASH_ITER(hlink, mmap_runtime->region_hash, region, tmp)
+        {
+            if(mmap_sample_region(region) < 0)
+                mmap_drop_region(region, 0);
+        }
+    }
+    MMAP_UNLOCK();
+
+    return(NULL);
+}
+
+/* stop sampling and take a last sample of the mappings that are still
+ * live; called with the module lock held at shutdown
+ */
+static void mmap_finish_sampling()
+{
+    struct mmap_region *region, *tmp;
+
+    if(mmap_runtime->frozen)
+        return;
+
+    mmap_stop_sampler();
+#ifndef DARSHAN_WRAP_MMAP
+    mmap_scan_maps();
+#endif
+    HASH_ITER(hlink, mmap_runtime->region_hash, region, tmp)
+        mmap_drop_region(region, 1);
+
+    /* no more updates once the records are output */
+    mmap_runtime->frozen = 1;
+
+    return;
+}
+
+#ifndef DARSHAN_WRAP_MMAP
+
+/* we need access to the underlying POSIX calls (defined in POSIX module) to
+ * read the process's memory map without instrumenting it
+ */
+#ifdef DARSHAN_PRELOAD
+extern int (*__real_open)(const char *path, int flags, ...);
+extern ssize_t (*__real_read)(int fd, void *buf, size_t count);
+extern int (*__real_close)(int fd);
+#else
+extern int __real_open(const char *path, int flags, ...);
+extern ssize_t __real_read(int fd, void *buf, size_t count);
+extern int __real_close(int fd);
+#endif
+
+static ssize_t mmap_real_read(int fd, void *buf, size_t count)
+{
+    MAP_OR_FAIL(read);
+    (void)__darshan_disabled;
+
+    return(__real_read(fd, buf, count));
+}
+
+static int mmap_real_close(int fd)
+{
+    MAP_OR_FAIL(close);
+    (void)__darshan_disabled;
+
+    return(__real_close(fd));
+}
+
+/* read /proc/self/maps into the runtime's buffer, returning the number of
+ * bytes read, or -1 on failure
+ */
+static ssize_t mmap_read_maps()
+{
+    size_t len = 0;
+    ssize_t ret;
+    char *tmp_buf;
+    int fd;
+
+    MAP_OR_FAIL(open);
+    (void)__darshan_disabled;
+
+    fd = __real_open("/proc/self/maps", O_RDONLY);
+    if(fd < 0)
+        return(-1);
+
+    while(1)
+    {
+        if(len + 1 >= mmap_runtime->maps_buf_sz)
+        {
+            tmp_buf = realloc(mmap_runtime->maps_buf,
+                mmap_runtime->maps_buf_sz ? mmap_runtime->maps_buf_sz * 2 : 65536);
+            if(!tmp_buf)
+            {
+                mmap_real_close(fd);
+                return(-1);
+            }
+            mmap_runtime->maps_buf = tmp_buf;
+            mmap_runtime->maps_buf_sz = mmap_runtime->maps_buf_sz ?
+                mmap_runtime->maps_buf_sz * 2 : 65536;
+        }
+        ret = mmap_real_read(fd, mmap_runtime->maps_buf + len,
+            mmap_runtime->maps_buf_sz - len - 1);
+        if(ret <= 0)
+            break;
+        len += ret;
+    }
+    mmap_real_close(fd);
+    if(ret < 0)
+        return(-1);
+    mmap_runtime->maps_buf[len] = '\0';
+
+    return(len);
+}
+
+static int mmap_id_cmp(const void *a, const void *b)
+{
+    darshan_record_id id_a = *(const darshan_record_id *)a;
+    darshan_record_id id_b = *(const darshan_record_id *)b;
+
+    return((id_a > id_b) - (id_a < id_b));
+}
+
+/* find the file mappings of the process from /proc/self/maps, which is
+ * how mappings are discovered when mmap() is not wrapped (in LD_PRELOAD
+ * builds), starting to track new ones and dropping those that are gone
+ */
+static void mmap_scan_maps()
+{
+    struct mmap_region *region, *tmp;
+    struct mmap_record_ref *rec_ref;
+    darshan_record_id *exec_ids = NULL;
+    darshan_record_id *tmp_ids;
+    darshan_record_id rec_id;
+    int exec_count = 0;
+    int exec_max = 0;
+    unsigned long start, end, inode;
+    char perms[5];
+    char *line, *path, *addr;
+    char *maps_end;
+    ssize_t maps_len;
+    size_t len;
+    int pass;
+    int pos;
+
+    maps_len = mmap_read_maps();
+    if(maps_len < 0)
+        return;
+    maps_end = mmap_runtime->maps_buf + maps_len;
+    for(line = mmap_runtime->maps_buf; line < maps_end; line++)
+    {
+        if(*line == '\n')
+            *line = '\0';
+    }
+    mmap_runtime->scan_gen++;
+
+    /* the first pass collects the files with executable mappings, i.e.
+     * the program and its shared libraries, whose other mappings are
+     * skipped by the second pass
+     */
+    for(pass = 0; pass < 2; pass++)
+    {
+        for(line = mmap_runtime->maps_buf; line < maps_end;
+            line += strlen(line) + 1)
+        {
+            pos = 0;
+            if(sscanf(line, "%lx-%lx %4s %*s %*s %lu %n", &start, &end, perms,
+                &inode, &pos) < 4 || !inode || !pos || line[pos] != '/')
+                continue;
+            path = line + pos;
+            len = strlen(path);
+
+            if(pass == 0)
+            {
+                if(perms[2] != 'x')
+                    continue;
+                if(exec_count == exec_max)
+                {
+                    tmp_ids = realloc(exec_ids,
+                        (exec_max ? exec_max * 2 : 64) * sizeof(*exec_ids));
+                    if(!tmp_ids)
+                        continue;
+                    exec_ids = tmp_ids;
+                    exec_max = exec_max ? exec_max * 2 : 64;
+                }
+                exec_ids[exec_count++] = darshan_core_gen_record_id(path);
+                continue;
+            }
+
+            /* skip deleted files and Darshan's own (mmap) logs */
+            if(perms[2] == 'x' ||
+                (len > 10 && strcmp(path + len - 10, " (deleted)") == 0) ||
+                (len > 8 && strcmp(path + len - 8, ".darshan") == 0))
+                continue;
+            rec_id = darshan_core_gen_record_id(path);
+            if(exec_count && bsearch(&rec_id, exec_ids, exec_count,
+                sizeof(*exec_ids), mmap_id_cmp))
+                continue;
+
+            addr = (char *)start;
+            HASH_FIND(hlink, mmap_runtime->region_hash, &addr, sizeof(char *),
+                region);
+            if(region && region->length == end - start &&
+                region->rec_ref->record_p->base_rec.id == rec_id)
+            {
+                region->scan_gen = mmap_runtime->scan_gen;
+                continue;
+            }
+            if(region)
+                mmap_drop_region(region, 0);
+
+            /* mappings over the limit are not counted as untracked here, as
+             * they would be counted again by every scan
+             */
+            if(mmap_runtime->region_count >= MMAP_MAX_REGIONS ||
+                darshan_lookup_record_ref(mmap_runtime->skip_hash, &rec_id,
+                sizeof(darshan_record_id)))
+                continue;
+
+            rec_ref = darshan_lookup_record_ref(mmap_runtime->rec_id_hash,
+                &rec_id, sizeof(darshan_record_id));
+            if(!rec_ref)
+                rec_ref = mmap_track_new_record(rec_id, path);
+            if(!rec_ref)
+            {
+                /* excluded, or out of memory; remember not to try again
+                 * (the runtime only serves as a non-NULL value)
+                 */
+                darshan_add_record_ref(&(mmap_runtime->skip_hash), &rec_id,
+                    sizeof(darshan_record_id), mmap_runtime);
+                continue;
+            }
+
+            region = mmap_add_region(rec_ref, addr, end - start,
+                (perms[1] == 'w' ? PROT_WRITE : 0) | PROT_READ,
+                perms[3] == 's' ? MAP_SHARED : MAP_PRIVATE);
+            if(region)
+                region->scan_gen = mmap_runtime->scan_gen;
+        }
+
+        if(pass == 0 && exec_count)
+            qsort(exec_ids, exec_count, sizeof(*exec_ids), mmap_id_cmp);
+    }
+    free(exec_ids);
+
+    /* mappings that are gone can no longer be sampled */
+    HASH_ITER(hlink, mmap_runtime->region_hash, region, tmp)
+    {
+        if(region->scan_gen != mmap_runtime->scan_gen)
+            mmap_drop_region(region, 0);
+    }
+
+    return;
+}
+
+#endif /* undefined DARSHAN_WRAP_MMAP */
+
+static void mmap_record_merge(struct darshan_mmap_record *infile,
+    struct darshan_mmap_record *inoutfile)
+{
+    int i;
+
+    for(i = 0; i < MMAP_NUM_INDICES; i++)
+    {
+        switch(i)
+        {
+            case MMAP_MAX_MAPPED_BYTES:
+            case MMAP_PAGE_SIZE:
+            case MMAP_MAX_RESIDENT_BYTES:
+                /* max */
+                if(infile->counters[i] > inoutfile->counters[i])
+                    inoutfile->counters[i] = infile->counters[i];
+                break;
+            default:
+                /* sum */
+                inoutfile->counters[i] += infile->counters[i];
+                break;
+        }
+    }
+
+    for(i = 0; i < MMAP_F_NUM_INDICES; i++)
+    {
+        switch(i)
+        {
+            case MMAP_F_MAP_START_TIMESTAMP:
+                /* min non-zero */
+                if(infile->fcounters[i] > 0 &&
+                    (inoutfile->fcounters[i] == 0 ||
+                    infile->fcounters[i] < inoutfile->fcounters[i]))
+                    inoutfile->fcounters[i] = infile->fcounters[i];
+                break;
+            case MMAP_F_SAMPLE_END_TIMESTAMP:
+                /* max */
+                if(infile->fcounters[i] > inoutfile->fcounters[i])
+                    inoutfile->fcounters[i] = infile->fcounters[i];
+                break;
+            default:
+                /* sum */
+                inoutfile->fcounters[i] += infile->fcounters[i];
+                break;
+        }
+    }
+
+    return;
+}
+
+#ifdef HAVE_MPI
+static void mmap_record_reduction_op(void* infile_v, void* inoutfile_v,
+    int *len, MPI_Datatype *datatype)
+{
+    struct darshan_mmap_record *infile = infile_v;
+    struct darshan_mmap_record *inoutfile = inoutfile_v;
+    int i;
+
+    for(i=0; i<*len; i++)
+    {
+        mmap_record_merge(infile, inoutfile);
+        inoutfile->base_rec.rank = -1;
+        infile++;
+        inoutfile++;
+    }
+
+    return;
+}
+#endif
+
+/********************************************************************************
+ * Functions exported by this module for coordinating with darshan-core *
+ ********************************************************************************/
+
+#ifdef HAVE_MPI
+static void mmap_mpi_redux(
+    void *mmap_buf,
+    MPI_Comm mod_comm,
+    darshan_record_id *shared_recs,
+    int shared_rec_count)
+{
+    int mmap_rec_count;
+    struct mmap_record_ref *rec_ref;
+    struct darshan_mmap_record *mmap_rec_buf =
+        (struct darshan_mmap_record *)mmap_buf;
+    struct darshan_mmap_record *red_send_buf = NULL;
+    struct darshan_mmap_record *red_recv_buf = NULL;
+    int ret;
+    int i;
+
+    MMAP_LOCK();
+    assert(mmap_runtime);
+
+    /* take the last samples before the records are rearranged below */
+    mmap_finish_sampling();
+
+    mmap_rec_count = mmap_runtime->rec_count;
+
+    /* necessary initialization of shared records */
+    for(i = 0; i < shared_rec_count; i++)
+    {
+        rec_ref = darshan_lookup_record_ref(mmap_runtime->rec_id_hash,
+            &shared_recs[i], sizeof(darshan_record_id));
+        assert(rec_ref);
+
+        rec_ref->record_p->base_rec.rank = -1;
+    }
+
+    /* sort the array of records descending by rank so that we get all of
+     * the shared records (marked by rank -1) in a contiguous portion at end
+     * of the array
+     */
+    darshan_record_sort(mmap_rec_buf, mmap_rec_count,
+        sizeof(struct darshan_mmap_record));
+
+    /* make *send_buf point to the shared records at the end of sorted array */
+    red_send_buf = &(mmap_rec_buf[mmap_rec_count-shared_rec_count]);
+
+    /* allocate memory for the reduction output on rank 0 */
+    if(my_rank == 0)
+    {
+        red_recv_buf = malloc(shared_rec_count *
+            sizeof(struct darshan_mmap_record));
+        if(!red_recv_buf)
+        {
+            MMAP_UNLOCK();
+            return;
+        }
+    }
+
+    /* reduce shared MMAP records */
+    ret = darshan_shared_record_reduce(mod_comm, red_send_buf, red_recv_buf,
+        shared_rec_count, sizeof(struct darshan_mmap_record),
+        mmap_record_reduction_op, NULL, 0);
+
+    /* update module state to account for shared record reduction */
+    if(ret < 0)
+    {
+        free(red_recv_buf);
+    }
+    else if(my_rank == 0)
+    {
+        /* overwrite local shared records with globally reduced records */
+        int tmp_ndx = mmap_rec_count - shared_rec_count;
+        memcpy(&(mmap_rec_buf[tmp_ndx]), red_recv_buf,
+            shared_rec_count * sizeof(struct darshan_mmap_record));
+        free(red_recv_buf);
+    }
+    else
+    {
+        /* drop shared records on non-zero ranks */
+        mmap_runtime->rec_count -= shared_rec_count;
+    }
+
+    MMAP_UNLOCK();
+    return;
+}
+#endif
+
+static void mmap_output(
+    void **mmap_buf,
+    int *mmap_buf_sz)
+{
+    MMAP_LOCK();
+    assert(mmap_runtime);
+
+    mmap_finish_sampling();
+
+    *mmap_buf_sz = mmap_runtime->rec_count *
+        sizeof(struct darshan_mmap_record);
+
+    MMAP_UNLOCK();
+    return;
+}
+
+static void mmap_cleanup()
+{
+    struct mmap_region *region, *tmp;
+
+    /* after a fork, the child's lock is left as the parent's sampler
+     * thread held it, and that thread is gone
+     */
+    if(mmap_runtime && mmap_runtime->sampler_running &&
+        mmap_runtime->sampler_pid != getpid())
+        pthread_mutex_init(&mmap_runtime_mutex, NULL);
+
+    MMAP_LOCK();
+    assert(mmap_runtime);
+
+    mmap_stop_sampler();
+
+    /* cleanup internal structures used for instrumenting */
+    HASH_ITER(hlink, mmap_runtime->region_hash, region, tmp)
+    {
+        HASH_DELETE(hlink, mmap_runtime->region_hash, region);
+        free(region->seen);
+        free(region);
+    }
+    darshan_clear_record_refs(&(mmap_runtime->rec_id_hash), 1);
+#ifndef DARSHAN_WRAP_MMAP
+    darshan_clear_record_refs(&(mmap_runtime->skip_hash), 0);
+    free(mmap_runtime->maps_buf);
+#endif
+    free(mmap_runtime->vec);
+    pthread_cond_destroy(&mmap_runtime->sampler_cond);
+
+    free(mmap_runtime);
+    mmap_runtime = NULL;
+    mmap_runtime_enabled = 0;
+
+    MMAP_UNLOCK();
+    return;
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifndef __DARSHAN_MMAP_H
+#define __DARSHAN_MMAP_H
+
+#include <stddef.h>
+
+#ifdef DARSHAN_MMAP
+
+/* set once the MMAP module has registered with darshan-core, so that the
+ * POSIX mmap wrappers only pay for a flag test while the module is
+ * disabled (the default)
+ */
+extern int mmap_runtime_enabled;
+
+/* mmap_runtime_initialize()
+ *
+ * registers the MMAP module, if it is enabled; called by darshan-core at
+ * startup
+ */
+void mmap_runtime_initialize(void);
+
+/* mmap_track_region()
+ *
+ * starts sampling the residency of the 'length' bytes mapped at 'addr'
+ * from the file with POSIX record id 'rec_id', mapped with the given
+ * mmap() 'prot' and 'flags'
+ */
+void mmap_track_region(darshan_record_id rec_id, void *addr, size_t length,
+    int prot, int flags);
+
+/* mmap_untrack_region()
+ *
+ * takes a final sample of the tracked mappings overlapping the 'length'
+ * bytes at 'addr', and stops tracking them; must be called before the
+ * range is unmapped
+ */
+void mmap_untrack_region(void *addr, size_t length);
+
+#define MMAP_TRACK(__rec_id, __addr, __length, __prot, __flags) do { \
+    if(mmap_runtime_enabled) \
+        mmap_track_region(__rec_id, __addr, __length, __prot, __flags); \
+} while(0)
+
+#define MMAP_UNTRACK(__addr, __length) do { \
+    if(mmap_runtime_enabled) \
+        mmap_untrack_region(__addr, __length); \
+} while(0)
+
+#else
+
+/* as with the heatmap module, provide stubs when the MMAP module is
+ * disabled so that the POSIX module does not need preprocessor guards
+ */
+
+#define MMAP_TRACK(__rec_id, __addr, __length, __prot, __flags) do { } while(0)
+#define MMAP_UNTRACK(__addr, __length) do { } while(0)
+
+#endif
+
+#endif /* __DARSHAN_MMAP_H */
@@ -29,6 +29,8 @@
 #include "darshan-dynamic.h"
 #include "darshan-dxt.h"
 #include "darshan-heatmap.h"
+#include "darshan-latency.h"
+#include "darshan-timeseries.h"
 #include "darshan-ldms.h"
 
 DARSHAN_FORWARD_DECL(PMPI_File_close, int, (MPI_File *fh));
@@ -115,6 +117,16 @@ DARSHAN_FORWARD_DECL(PMPI_File_write_shared, int, (MPI_File fh, const void *buf,
 #else
 DARSHAN_FORWARD_DECL(PMPI_File_write_shared, int, (MPI_File fh, void *buf, int count, MPI_Datatype datatype, MPI_Status *status));
 #endif
+DARSHAN_FORWARD_DECL(PMPI_Wait, int, (MPI_Request *request, MPI_Status *status));
+DARSHAN_FORWARD_DECL(PMPI_Waitall, int, (int count, MPI_Request array_of_requests[], MPI_Status array_of_statuses[]));
+DARSHAN_FORWARD_DECL(PMPI_Waitany, int, (int count, MPI_Request array_of_requests[], int *index, MPI_Status *status));
+DARSHAN_FORWARD_DECL(PMPI_Waitsome, int, (int incount, MPI_Request array_of_requests[], int *outcount, int array_of_indices[], MPI_Status array_of_statuses[]));
+DARSHAN_FORWARD_DECL(PMPI_Test, int, (MPI_Request *request, int *flag, MPI_Status *status));
+DARSHAN_FORWARD_DECL(PMPI_Testall, int, (int count, MPI_Request array_of_requests[], int *flag, MPI_Status array_of_statuses[]));
+DARSHAN_FORWARD_DECL(PMPI_Testany, int, (int count, MPI_Request array_of_requests[], int *index, int *flag, MPI_Status *status));
+DARSHAN_FORWARD_DECL(PMPI_Testsome, int, (int incount, MPI_Request array_of_requests[], int *outcount, int array_of_indices[], MPI_Status array_of_statuses[]));
+DARSHAN_FORWARD_DECL(PMPI_Request_free, int, (MPI_Request *request));
+DARSHAN_FORWARD_DECL(PMPI_Type_free, int, (MPI_Datatype *datatype));
 
 /* The mpiio_file_record_ref structure maintains necessary runtime metadata
  * for the MPIIO file record (darshan_mpiio_file structure, defined in
@@ -145,6 +157,9 @@ struct mpiio_file_record_ref
     double last_meta_end;
     double last_read_end;
     double last_write_end;
+    double last_nb_read_end;
+    double last_nb_write_end;
+    double last_nb_wait_end;
     void *access_root;
     int access_count;
 #ifdef HAVE_LDMS
@@ -160,23 +175,91 @@ struct mpiio_runtime
 {
     void *rec_id_hash;
     void *fh_hash;
+    void *nb_req_hash;
+    void *view_hash;
+    void *arena;
     int file_rec_count;
     darshan_record_id heatmap_id;
     int frozen; /* flag to indicate that the counters should no longer be modified */
 };
 
+/* private duplicate of the communicator a file was opened on, used to
+ * measure how long ranks wait for each other to enter collectives on the
+ * file. Indexed by MPI file handle, and only present if every rank that
+ * opened the file is instrumenting it.
+ */
+struct mpiio_coll_comm
+{
+    MPI_Comm comm;
+};
+
+/* an outstanding nonblocking MPI-IO read or write, indexed by its request
+ * handle until one of the MPI_Wait/MPI_Test family of calls completes it
+ */
+struct mpiio_nb_req
+{
+    struct mpiio_file_record_ref *rec_ref;
+    enum darshan_io_type io_type;
+    double issue_time;
+};
+
+/* number of request handles saved on the stack by completion wrappers */
+#define MPIIO_NB_REQ_STACK_COUNT 16
+
+/* the file view last set on a file handle, indexed by handle in
+ * mpiio_runtime->view_hash. Handles without an entry have the default
+ * view (no displacement, with MPI_BYTE as etype and filetype).
+ */
+struct mpiio_file_view
+{
+    MPI_Offset disp;
+    int etype_size;
+    int ftype_size;
+    MPI_Aint ftype_extent;
+    MPI_Aint ftype_true_lb;
+    int ftype_dense;
+};
+
+/* number of entries in the direct-mapped cache of datatype sizes; must be
+ * a power of two
+ */
+#define MPIIO_TYPE_CACHE_SIZE 64
+
+struct mpiio_type_cache_entry
+{
+    MPI_Datatype type;
+    int size;
+    int valid;
+};
+
 static void mpiio_runtime_initialize(
     void);
+static MPI_Request *mpiio_nb_req_save(
+    MPI_Request *reqs, int count, MPI_Request *stack_reqs);
+static void mpiio_nb_req_complete(
+    MPI_Request *saved_reqs, MPI_Request *reqs, int count,
+    MPI_Request *stack_reqs, double tm1, double tm2);
+static void mpiio_coll_wait_open(
+    MPI_Comm comm, MPI_File fh, int open_ret);
+static void mpiio_coll_wait_close(
+    MPI_File fh);
+static double mpiio_coll_wait_sync(
+    MPI_File fh);
 static struct mpiio_file_record_ref *mpiio_track_new_file_record(
     darshan_record_id rec_id, const char *path);
+static int mpiio_type_size(
+    MPI_Datatype type);
+static void mpiio_type_cache_evict(
+    MPI_Datatype type);
+static void mpiio_set_file_view(
+    MPI_File fh, MPI_Offset disp, MPI_Datatype etype, MPI_Datatype filetype);
+static MPI_Offset mpiio_byte_offset(
+    MPI_File fh, MPI_Offset offset);
 static void mpiio_finalize_file_records(
     void *rec_ref_p, void *user_ptr);
 #ifdef HAVE_MPI
 static void mpiio_record_reduction_op(
     void* infile_v, void* inoutfile_v, int *len, MPI_Datatype *datatype);
-static void mpiio_shared_record_variance(
-    MPI_Comm mod_comm, struct darshan_mpiio_file *inrec_array,
-    struct darshan_mpiio_file *outrec_array, int shared_rec_count);
 static void mpiio_mpi_redux(
     void *mpiio_buf, MPI_Comm mod_comm,
     darshan_record_id *shared_recs, int shared_rec_count);
@@ -190,6 +273,22 @@ static struct mpiio_runtime *mpiio_runtime = NULL;
 static pthread_mutex_t mpiio_runtime_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
 static int mpiio_runtime_init_attempted = 0;
 static int my_rank = -1;
+/* kept outside of mpiio_runtime so that whether a collective is measured
+ * never depends on per-rank module state once the file is open
+ */
+static void *mpiio_coll_comm_hash = NULL;
+/* number of entries in mpiio_runtime->nb_req_hash; completion wrappers read
+ * it without the lock to skip requests that can't be MPI-IO requests, which
+ * is safe as a request must be issued before any thread can complete it
+ */
+static int mpiio_nb_req_count = 0;
+/* sizes of the datatypes most recently passed to reads and writes, so
+ * that they are not looked up with PMPI_Type_size on every access (which
+ * walks derived datatypes in some MPI implementations).  Kept outside of
+ * mpiio_runtime as datatype handles outlive the runtime, and entries are
+ * evicted by the MPI_Type_free wrapper before a handle can be reused.
+ */
+static struct mpiio_type_cache_entry mpiio_type_cache[MPIIO_TYPE_CACHE_SIZE];
 
 #define MPIIO_LOCK() pthread_mutex_lock(&mpiio_runtime_mutex)
 #define MPIIO_UNLOCK() pthread_mutex_unlock(&mpiio_runtime_mutex)
@@ -197,12 +296,23 @@ static int my_rank = -1;
 #define MPIIO_WTIME() \
     __darshan_disabled ? 0 : darshan_core_wtime();
 
+/* blocking independent reads and writes usually pass straight through to a
+ * single POSIX operation, so they share its timestamps rather than reading
+ * the clock again (see darshan_layer_wtime_enter())
+ */
+#define MPIIO_WTIME_ENTER(__seq) \
+    __darshan_disabled ? 0 : darshan_layer_wtime_enter(&(__seq));
+
+#define MPIIO_WTIME_LEAVE(__seq) \
+    __darshan_disabled ? 0 : darshan_layer_wtime_leave(__seq);
+
 /* note that if the break condition is triggered in this macro, then it
  * will exit the do/while loop holding a lock that will be released in
  * POST_RECORD().  Otherwise it will release the lock here (if held) and
  * return immediately without reaching the POST_RECORD() macro.
  */
 #define MPIIO_PRE_RECORD() do { \
+    DARSHAN_OVERHEAD_ENTER(); \
     if(!__darshan_disabled) { \
         MPIIO_LOCK(); \
         if(!mpiio_runtime && !mpiio_runtime_init_attempted) \
@@ -215,6 +325,7 @@ static int my_rank = -1;
 
 #define MPIIO_POST_RECORD() do { \
     MPIIO_UNLOCK(); \
+    DARSHAN_OVERHEAD_EXIT(DARSHAN_MPIIO_MOD); \
 } while(0)
 
 #define MPIIO_RECORD_OPEN(__ret, __path, __fh, __comm, __mode, __info, __tm1, __tm2) do { \
@@ -246,17 +357,23 @@ static int my_rank = -1;
     rec_ref->file_rec->fcounters[MPIIO_F_OPEN_END_TIMESTAMP] = __tm2; \
     DARSHAN_TIMER_INC_NO_OVERLAP(rec_ref->file_rec->fcounters[MPIIO_F_META_TIME], \
         __tm1, __tm2, rec_ref->last_meta_end); \
-    darshan_add_record_ref(&(mpiio_runtime->fh_hash), &__fh, sizeof(MPI_File), rec_ref); \
+    LATENCY_RECORD(rec_ref->file_rec->base_rec.id, LATENCY_OP_MPIIO_META, \
+        __tm1, __tm2); \
+    TIMESERIES_RECORD(TIMESERIES_API_MPIIO, TIMESERIES_OP_META, 0, __tm1, __tm2); \
+    darshan_arena_add_record_ref(&(mpiio_runtime->arena), \
+        &(mpiio_runtime->fh_hash), &__fh, sizeof(MPI_File), rec_ref); \
+    /* a reused handle starts out with the default view */ \
+    free(darshan_delete_record_ref(&(mpiio_runtime->view_hash), &__fh, sizeof(MPI_File))); \
     if(newpath != __path) free(newpath); \
     /* LDMS to publish realtime open tracing information to daemon*/ \
-    if(dC.ldms_lib)\
-        if(dC.mpiio_enable_ldms)\
-            darshan_ldms_connector_send(rec_ref->file_rec->base_rec.id, rec_ref->file_rec->base_rec.rank, rec_ref->file_rec->counters[MPIIO_COLL_OPENS] + rec_ref->file_rec->counters[MPIIO_INDEP_OPENS], "open", -1, -1, -1, -1, -1, __tm1, __tm2, rec_ref->file_rec->fcounters[MPIIO_F_META_TIME], "MPIIO", "MET");\
+    if(DARSHAN_LDMS_ENABLED(mpiio))\
+        darshan_ldms_connector_send(rec_ref->file_rec->base_rec.id, rec_ref->file_rec->base_rec.rank, rec_ref->file_rec->counters[MPIIO_COLL_OPENS] + rec_ref->file_rec->counters[MPIIO_INDEP_OPENS], "open", -1, -1, -1, -1, -1, __tm1, __tm2, rec_ref->file_rec->fcounters[MPIIO_F_META_TIME], "MPIIO", "MET");\
 } while(0)
 
 /* XXX: this check is needed to work around an OpenMPI bug that is triggered by
  * Darshan's MPI-IO read/write wrappers usage of 'MPI_File_get_byte_offset()'
  * for some workloads. For more details, see comments in 'darshan-runtime/configure.in'.
+ * Offsets that can be derived from the cached file view are still reported.
  */
 #ifndef HAVE_OPEN_MPI
 static int get_byte_offset = 1;
@@ -267,22 +384,27 @@ static int get_byte_offset = 0;
 #define MPIIO_RECORD_READ(__ret, __fh, __count, __datatype, __offset, __counter, __tm1, __tm2) do { \
     struct mpiio_file_record_ref *rec_ref; \
     int size = 0; \
-    MPI_Offset displacement=-1;\
+    MPI_Offset displacement; \
     int64_t size_ll; \
     struct darshan_common_val_counter *cvc; \
     double __elapsed = __tm2-__tm1; \
     if(__ret != MPI_SUCCESS) break; \
     rec_ref = darshan_lookup_record_ref(mpiio_runtime->fh_hash, &(__fh), sizeof(MPI_File)); \
     if(!rec_ref) break; \
-    if((__count > 0) && (__datatype != MPI_DATATYPE_NULL)) { \
-        PMPI_Type_size(__datatype, &size);  \
-        size = size * __count; \
-    } \
-    if(get_byte_offset) MPI_File_get_byte_offset(__fh, __offset, &displacement);\
+    /* ATTRIB to charge the POSIX I/O issued by this call */ \
+    DARSHAN_ATTRIB_CHARGE(rec_ref->file_rec->base_rec.id); \
+    if((__count > 0) && (__datatype != MPI_DATATYPE_NULL)) \
+        size = mpiio_type_size(__datatype) * __count; \
+    displacement = mpiio_byte_offset(__fh, __offset); \
     /* DXT to record detailed read tracing information */ \
-    dxt_mpiio_read(rec_ref->file_rec->base_rec.id, displacement, size, __tm1, __tm2); \
+    DXT_RECORD(mpiio, read, rec_ref->file_rec->base_rec.id, displacement, size, __tm1, __tm2); \
     /* heatmap to record traffic summary */ \
-    heatmap_update(mpiio_runtime->heatmap_id, HEATMAP_READ, size, __tm1, __tm2); \
+    HEATMAP_UPDATE(mpiio_runtime->heatmap_id, HEATMAP_READ, size, __tm1, __tm2); \
+    /* LATENCY to record the latency distribution */ \
+    LATENCY_RECORD(rec_ref->file_rec->base_rec.id, LATENCY_OP_MPIIO_READ, \
+        __tm1, __tm2); \
+    /* TIMESERIES to record the job's activity over time */ \
+    TIMESERIES_RECORD(TIMESERIES_API_MPIIO, TIMESERIES_OP_READ, size, __tm1, __tm2); \
     DARSHAN_BUCKET_INC(&(rec_ref->file_rec->counters[MPIIO_SIZE_READ_AGG_0_100]), size); \
     size_ll = size; \
     cvc = darshan_track_common_val_counters(&rec_ref->access_root, &size_ll, 1, \
@@ -306,30 +428,34 @@ static int get_byte_offset = 0;
     DARSHAN_TIMER_INC_NO_OVERLAP(rec_ref->file_rec->fcounters[MPIIO_F_READ_TIME], \
         __tm1, __tm2, rec_ref->last_read_end); \
     /* LDMS to publish realtime read tracing information to daemon*/ \
-    if(dC.ldms_lib)\
-        if(dC.mpiio_enable_ldms)\
-            darshan_ldms_connector_send(rec_ref->file_rec->base_rec.id, rec_ref->file_rec->base_rec.rank, rec_ref->file_rec->counters[__counter], "read", displacement, size, -1, rec_ref->file_rec->counters[MPIIO_RW_SWITCHES], -1, __tm1, __tm2, rec_ref->file_rec->fcounters[MPIIO_F_READ_TIME], "MPIIO", "MOD");\
+    if(DARSHAN_LDMS_ENABLED(mpiio))\
+        darshan_ldms_connector_send(rec_ref->file_rec->base_rec.id, rec_ref->file_rec->base_rec.rank, rec_ref->file_rec->counters[__counter], "read", displacement, size, -1, rec_ref->file_rec->counters[MPIIO_RW_SWITCHES], -1, __tm1, __tm2, rec_ref->file_rec->fcounters[MPIIO_F_READ_TIME], "MPIIO", "MOD");\
 } while(0)
 
 #define MPIIO_RECORD_WRITE(__ret, __fh, __count, __datatype, __offset, __counter, __tm1, __tm2) do { \
     struct mpiio_file_record_ref *rec_ref; \
     int size = 0; \
-    MPI_Offset displacement=-1; \
+    MPI_Offset displacement; \
     int64_t size_ll; \
     struct darshan_common_val_counter *cvc; \
     double __elapsed = __tm2-__tm1; \
     if(__ret != MPI_SUCCESS) break; \
     rec_ref = darshan_lookup_record_ref(mpiio_runtime->fh_hash, &(__fh), sizeof(MPI_File)); \
     if(!rec_ref) break; \
-    if((__count > 0) && (__datatype != MPI_DATATYPE_NULL)) { \
-        PMPI_Type_size(__datatype, &size);  \
-        size = size * __count; \
-    } \
-    if(get_byte_offset) MPI_File_get_byte_offset(__fh, __offset, &displacement); \
+    /* ATTRIB to charge the POSIX I/O issued by this call */ \
+    DARSHAN_ATTRIB_CHARGE(rec_ref->file_rec->base_rec.id); \
+    if((__count > 0) && (__datatype != MPI_DATATYPE_NULL)) \
+        size = mpiio_type_size(__datatype) * __count; \
+    displacement = mpiio_byte_offset(__fh, __offset); \
     /* DXT to record detailed write tracing information */ \
-    dxt_mpiio_write(rec_ref->file_rec->base_rec.id, displacement, size, __tm1, __tm2); \
+    DXT_RECORD(mpiio, write, rec_ref->file_rec->base_rec.id, displacement, size, __tm1, __tm2); \
     /* heatmap to record traffic summary */ \
-    heatmap_update(mpiio_runtime->heatmap_id, HEATMAP_WRITE, size, __tm1, __tm2); \
+    HEATMAP_UPDATE(mpiio_runtime->heatmap_id, HEATMAP_WRITE, size, __tm1, __tm2); \
+    /* LATENCY to record the latency distribution */ \
+    LATENCY_RECORD(rec_ref->file_rec->base_rec.id, LATENCY_OP_MPIIO_WRITE, \
+        __tm1, __tm2); \
+    /* TIMESERIES to record the job's activity over time */ \
+    TIMESERIES_RECORD(TIMESERIES_API_MPIIO, TIMESERIES_OP_WRITE, size, __tm1, __tm2); \
     DARSHAN_BUCKET_INC(&(rec_ref->file_rec->counters[MPIIO_SIZE_WRITE_AGG_0_100]), size); \
     size_ll = size; \
     cvc = darshan_track_common_val_counters(&rec_ref->access_root, &size_ll, 1, \
@@ -353,9 +479,45 @@ static int get_byte_offset = 0;
     DARSHAN_TIMER_INC_NO_OVERLAP(rec_ref->file_rec->fcounters[MPIIO_F_WRITE_TIME], \
         __tm1, __tm2, rec_ref->last_write_end); \
     /* LDMS to publish realtime write tracing information to daemon*/ \
-    if(dC.ldms_lib)\
-        if(dC.mpiio_enable_ldms)\
-            darshan_ldms_connector_send(rec_ref->file_rec->base_rec.id, rec_ref->file_rec->base_rec.rank, rec_ref->file_rec->counters[__counter], "write", displacement, size, -1, rec_ref->file_rec->counters[MPIIO_RW_SWITCHES], -1,  __tm1, __tm2, rec_ref->file_rec->fcounters[MPIIO_F_WRITE_TIME], "MPIIO", "MOD");\
+    if(DARSHAN_LDMS_ENABLED(mpiio))\
+        darshan_ldms_connector_send(rec_ref->file_rec->base_rec.id, rec_ref->file_rec->base_rec.rank, rec_ref->file_rec->counters[__counter], "write", displacement, size, -1, rec_ref->file_rec->counters[MPIIO_RW_SWITCHES], -1,  __tm1, __tm2, rec_ref->file_rec->fcounters[MPIIO_F_WRITE_TIME], "MPIIO", "MOD");\
+} while(0)
+
+/* start tracking the request returned by a nonblocking read or write */
+#define MPIIO_RECORD_NB_REQ(__ret, __fh, __request, __io_type, __tm1) do { \
+    struct mpiio_file_record_ref *rec_ref; \
+    struct mpiio_nb_req *nb_req; \
+    if(__ret != MPI_SUCCESS || *(__request) == MPI_REQUEST_NULL) break; \
+    rec_ref = darshan_lookup_record_ref(mpiio_runtime->fh_hash, &(__fh), sizeof(MPI_File)); \
+    if(!rec_ref) break; \
+    /* a stale entry may be left by a request that was freed elsewhere */ \
+    nb_req = darshan_lookup_record_ref(mpiio_runtime->nb_req_hash, __request, sizeof(MPI_Request)); \
+    if(!nb_req) { \
+        nb_req = malloc(sizeof(*nb_req)); \
+        if(!nb_req) break; \
+        if(darshan_add_record_ref(&(mpiio_runtime->nb_req_hash), __request, \
+            sizeof(MPI_Request), nb_req) != 1) { \
+            free(nb_req); \
+            break; \
+        } \
+        mpiio_nb_req_count++; \
+    } \
+    nb_req->rec_ref = rec_ref; \
+    nb_req->io_type = __io_type; \
+    nb_req->issue_time = __tm1; \
+} while(0)
+
+/* split the time of a collective into time spent waiting for all ranks to
+ * enter it (tm1 to __tm_sync) and time spent performing it; __tm_sync is
+ * negative if the collective was not synchronized
+ */
+#define MPIIO_RECORD_COLL_WAIT(__ret, __fh, __tm1, __tm_sync, __tm2) do { \
+    struct mpiio_file_record_ref *rec_ref; \
+    if(__ret != MPI_SUCCESS || __tm_sync < 0) break; \
+    rec_ref = darshan_lookup_record_ref(mpiio_runtime->fh_hash, &(__fh), sizeof(MPI_File)); \
+    if(!rec_ref) break; \
+    rec_ref->file_rec->fcounters[MPIIO_F_COLL_WAIT_TIME] += __tm_sync - __tm1; \
+    rec_ref->file_rec->fcounters[MPIIO_F_COLL_IO_TIME] += __tm2 - __tm_sync; \
 } while(0)
 
 /**********************************************************
@@ -389,6 +551,9 @@ int DARSHAN_DECL(MPI_File_open)(MPI_Comm comm, char *filename, int amode, MPI_In
         filename = tmp + 1;
     }
 
+    if(!__darshan_disabled)
+        mpiio_coll_wait_open(comm, *fh, ret);
+
     MPIIO_PRE_RECORD();
     tmp_fh = *fh;
     MPIIO_RECORD_OPEN(ret, filename, tmp_fh, comm, amode, info, tm1, tm2);
@@ -407,14 +572,17 @@ int DARSHAN_DECL(MPI_File_read)(MPI_File fh, void *buf, int count,
 {
     int ret;
     double tm1, tm2;
+    unsigned long seq;
     MPI_Offset offset;
 
     MAP_OR_FAIL(PMPI_File_read);
 
     MPI_File_get_position(fh, &offset);
-    tm1 = MPIIO_WTIME();
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_MPIIO_MOD, TIMESERIES_API_MPIIO);
+    tm1 = MPIIO_WTIME_ENTER(seq);
     ret = __real_PMPI_File_read(fh, buf, count, datatype, status);
-    tm2 = MPIIO_WTIME();
+    tm2 = MPIIO_WTIME_LEAVE(seq);
+    DARSHAN_ATTRIB_LEAVE();
 
     MPIIO_PRE_RECORD();
     MPIIO_RECORD_READ(ret, fh, count, datatype, offset, MPIIO_INDEP_READS, tm1, tm2);
@@ -435,14 +603,17 @@ int DARSHAN_DECL(MPI_File_write)(MPI_File fh, void *buf, int count,
 {
     int ret;
     double tm1, tm2;
+    unsigned long seq;
     MPI_Offset offset;
 
     MAP_OR_FAIL(PMPI_File_write);
 
     MPI_File_get_position(fh, &offset);
-    tm1 = MPIIO_WTIME();
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_MPIIO_MOD, TIMESERIES_API_MPIIO);
+    tm1 = MPIIO_WTIME_ENTER(seq);
     ret = __real_PMPI_File_write(fh, buf, count, datatype, status);
-    tm2 = MPIIO_WTIME();
+    tm2 = MPIIO_WTIME_LEAVE(seq);
+    DARSHAN_ATTRIB_LEAVE();
 
     MPIIO_PRE_RECORD();
     MPIIO_RECORD_WRITE(ret, fh, count, datatype, offset, MPIIO_INDEP_WRITES, tm1, tm2);
@@ -463,13 +634,16 @@ int DARSHAN_DECL(MPI_File_read_at)(MPI_File fh, MPI_Offset offset, void *buf,
 {
     int ret;
     double tm1, tm2;
+    unsigned long seq;
 
     MAP_OR_FAIL(PMPI_File_read_at);
 
-    tm1 = MPIIO_WTIME();
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_MPIIO_MOD, TIMESERIES_API_MPIIO);
+    tm1 = MPIIO_WTIME_ENTER(seq);
     ret = __real_PMPI_File_read_at(fh, offset, buf,
         count, datatype, status);
-    tm2 = MPIIO_WTIME();
+    tm2 = MPIIO_WTIME_LEAVE(seq);
+    DARSHAN_ATTRIB_LEAVE();
 
     MPIIO_PRE_RECORD();
     MPIIO_RECORD_READ(ret, fh, count, datatype, offset, MPIIO_INDEP_READS, tm1, tm2);
@@ -490,13 +664,16 @@ int DARSHAN_DECL(MPI_File_write_at)(MPI_File fh, MPI_Offset offset, void *buf,
 {
     int ret;
     double tm1, tm2;
+    unsigned long seq;
 
     MAP_OR_FAIL(PMPI_File_write_at);
 
-    tm1 = MPIIO_WTIME();
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_MPIIO_MOD, TIMESERIES_API_MPIIO);
+    tm1 = MPIIO_WTIME_ENTER(seq);
     ret = __real_PMPI_File_write_at(fh, offset, buf,
         count, datatype, status);
-    tm2 = MPIIO_WTIME();
+    tm2 = MPIIO_WTIME_LEAVE(seq);
+    DARSHAN_ATTRIB_LEAVE();
 
     MPIIO_PRE_RECORD();
     MPIIO_RECORD_WRITE(ret, fh, count, datatype, offset, MPIIO_INDEP_WRITES, tm1, tm2);
@@ -515,19 +692,23 @@ DARSHAN_WRAPPER_MAP(PMPI_File_write_at, int, (MPI_File fh, MPI_Offset offset, vo
 int DARSHAN_DECL(MPI_File_read_all)(MPI_File fh, void * buf, int count, MPI_Datatype datatype, MPI_Status *status)
 {
     int ret;
-    double tm1, tm2;
+    double tm1, tm2, tm_sync;
     MPI_Offset offset;
 
     MAP_OR_FAIL(PMPI_File_read_all);
 
     MPI_File_get_position(fh, &offset);
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_MPIIO_MOD, TIMESERIES_API_MPIIO);
     tm1 = MPIIO_WTIME();
+    tm_sync = mpiio_coll_wait_sync(fh);
     ret = __real_PMPI_File_read_all(fh, buf, count,
         datatype, status);
     tm2 = MPIIO_WTIME();
+    DARSHAN_ATTRIB_LEAVE();
 
     MPIIO_PRE_RECORD();
     MPIIO_RECORD_READ(ret, fh, count, datatype, offset, MPIIO_COLL_READS, tm1, tm2);
+    MPIIO_RECORD_COLL_WAIT(ret, fh, tm1, tm_sync, tm2);
     MPIIO_POST_RECORD();
 
     return(ret);
@@ -542,19 +723,23 @@ int DARSHAN_DECL(MPI_File_write_all)(MPI_File fh, void * buf, int count, MPI_Dat
 #endif
 {
     int ret;
-    double tm1, tm2;
+    double tm1, tm2, tm_sync;
     MPI_Offset offset;
 
     MAP_OR_FAIL(PMPI_File_write_all);
 
     MPI_File_get_position(fh, &offset);
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_MPIIO_MOD, TIMESERIES_API_MPIIO);
     tm1 = MPIIO_WTIME();
+    tm_sync = mpiio_coll_wait_sync(fh);
     ret = __real_PMPI_File_write_all(fh, buf, count,
         datatype, status);
     tm2 = MPIIO_WTIME();
+    DARSHAN_ATTRIB_LEAVE();
 
     MPIIO_PRE_RECORD();
     MPIIO_RECORD_WRITE(ret, fh, count, datatype, offset, MPIIO_COLL_WRITES, tm1, tm2);
+    MPIIO_RECORD_COLL_WAIT(ret, fh, tm1, tm_sync, tm2);
     MPIIO_POST_RECORD();
 
     return(ret);
@@ -571,17 +756,21 @@ int DARSHAN_DECL(MPI_File_read_at_all)(MPI_File fh, MPI_Offset offset, void * bu
     int count, MPI_Datatype datatype, MPI_Status * status)
 {
     int ret;
-    double tm1, tm2;
+    double tm1, tm2, tm_sync;
 
     MAP_OR_FAIL(PMPI_File_read_at_all);
 
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_MPIIO_MOD, TIMESERIES_API_MPIIO);
     tm1 = MPIIO_WTIME();
+    tm_sync = mpiio_coll_wait_sync(fh);
     ret = __real_PMPI_File_read_at_all(fh, offset, buf,
         count, datatype, status);
     tm2 = MPIIO_WTIME();
+    DARSHAN_ATTRIB_LEAVE();
 
     MPIIO_PRE_RECORD();
     MPIIO_RECORD_READ(ret, fh, count, datatype, offset, MPIIO_COLL_READS, tm1, tm2);
+    MPIIO_RECORD_COLL_WAIT(ret, fh, tm1, tm_sync, tm2);
     MPIIO_POST_RECORD();
 
     return(ret);
@@ -599,17 +788,21 @@ int DARSHAN_DECL(MPI_File_write_at_all)(MPI_File fh, MPI_Offset offset, void * b
 #endif
 {
     int ret;
-    double tm1, tm2;
+    double tm1, tm2, tm_sync;
 
     MAP_OR_FAIL(PMPI_File_write_at_all);
 
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_MPIIO_MOD, TIMESERIES_API_MPIIO);
     tm1 = MPIIO_WTIME();
+    tm_sync = mpiio_coll_wait_sync(fh);
     ret = __real_PMPI_File_write_at_all(fh, offset, buf,
         count, datatype, status);
     tm2 = MPIIO_WTIME();
+    DARSHAN_ATTRIB_LEAVE();
 
     MPIIO_PRE_RECORD();
     MPIIO_RECORD_WRITE(ret, fh, count, datatype, offset, MPIIO_COLL_WRITES, tm1, tm2);
+    MPIIO_RECORD_COLL_WAIT(ret, fh, tm1, tm_sync, tm2);
     MPIIO_POST_RECORD();
 
     return(ret);
@@ -633,10 +826,12 @@ int DARSHAN_DECL(MPI_File_read_shared)(MPI_File fh, void * buf, int count, MPI_D
     MAP_OR_FAIL(PMPI_File_read_shared);
 
     MPI_File_get_position_shared(fh, &offset);
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_MPIIO_MOD, TIMESERIES_API_MPIIO);
     tm1 = MPIIO_WTIME();
     ret = __real_PMPI_File_read_shared(fh, buf, count,
         datatype, status);
     tm2 = MPIIO_WTIME();
+    DARSHAN_ATTRIB_LEAVE();
 
     MPIIO_PRE_RECORD();
     MPIIO_RECORD_READ(ret, fh, count, datatype, offset, MPIIO_INDEP_READS, tm1, tm2);
@@ -660,10 +855,12 @@ int DARSHAN_DECL(MPI_File_write_shared)(MPI_File fh, void * buf, int count, MPI_
     MAP_OR_FAIL(PMPI_File_write_shared);
 
     MPI_File_get_position_shared(fh, &offset);
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_MPIIO_MOD, TIMESERIES_API_MPIIO);
     tm1 = MPIIO_WTIME();
     ret = __real_PMPI_File_write_shared(fh, buf, count,
         datatype, status);
     tm2 = MPIIO_WTIME();
+    DARSHAN_ATTRIB_LEAVE();
 
     MPIIO_PRE_RECORD();
     MPIIO_RECORD_WRITE(ret, fh, count, datatype, offset, MPIIO_INDEP_WRITES, tm1, tm2);
@@ -684,19 +881,23 @@ int DARSHAN_DECL(MPI_File_read_ordered)(MPI_File fh, void * buf, int count,
     MPI_Datatype datatype, MPI_Status * status)
 {
     int ret;
-    double tm1, tm2;
+    double tm1, tm2, tm_sync;
     MPI_Offset offset;
 
     MAP_OR_FAIL(PMPI_File_read_ordered);
 
     MPI_File_get_position_shared(fh, &offset);
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_MPIIO_MOD, TIMESERIES_API_MPIIO);
     tm1 = MPIIO_WTIME();
+    tm_sync = mpiio_coll_wait_sync(fh);
     ret = __real_PMPI_File_read_ordered(fh, buf, count,
         datatype, status);
     tm2 = MPIIO_WTIME();
+    DARSHAN_ATTRIB_LEAVE();
 
     MPIIO_PRE_RECORD();
     MPIIO_RECORD_READ(ret, fh, count, datatype, offset, MPIIO_COLL_READS, tm1, tm2);
+    MPIIO_RECORD_COLL_WAIT(ret, fh, tm1, tm_sync, tm2);
     MPIIO_POST_RECORD();
 
     return(ret);
@@ -714,19 +915,23 @@ int DARSHAN_DECL(MPI_File_write_ordered)(MPI_File fh, void * buf, int count,
 #endif
 {
     int ret;
-    double tm1, tm2;
+    double tm1, tm2, tm_sync;
     MPI_Offset offset;
 
     MAP_OR_FAIL(PMPI_File_write_ordered);
     MPI_File_get_position_shared(fh, &offset);
 
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_MPIIO_MOD, TIMESERIES_API_MPIIO);
     tm1 = MPIIO_WTIME();
+    tm_sync = mpiio_coll_wait_sync(fh);
     ret = __real_PMPI_File_write_ordered(fh, buf, count,
          datatype, status);
     tm2 = MPIIO_WTIME();
+    DARSHAN_ATTRIB_LEAVE();
 
     MPIIO_PRE_RECORD();
     MPIIO_RECORD_WRITE(ret, fh, count, datatype, offset, MPIIO_COLL_WRITES, tm1, tm2);
+    MPIIO_RECORD_COLL_WAIT(ret, fh, tm1, tm_sync, tm2);
     MPIIO_POST_RECORD();
 
     return(ret);
@@ -744,18 +949,22 @@ DARSHAN_WRAPPER_MAP(PMPI_File_write_ordered, int, (MPI_File fh, void * buf, int
 int DARSHAN_DECL(MPI_File_read_all_begin)(MPI_File fh, void * buf, int count, MPI_Datatype datatype)
 {
     int ret;
-    double tm1, tm2;
+    double tm1, tm2, tm_sync;
     MPI_Offset offset;
 
     MAP_OR_FAIL(PMPI_File_read_all_begin);
 
     MPI_File_get_position_shared(fh, &offset);
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_MPIIO_MOD, TIMESERIES_API_MPIIO);
     tm1 = MPIIO_WTIME();
+    tm_sync = mpiio_coll_wait_sync(fh);
     ret = __real_PMPI_File_read_all_begin(fh, buf, count, datatype);
     tm2 = MPIIO_WTIME();
+    DARSHAN_ATTRIB_LEAVE();
 
     MPIIO_PRE_RECORD();
     MPIIO_RECORD_READ(ret, fh, count, datatype, offset, MPIIO_SPLIT_READS, tm1, tm2);
+    MPIIO_RECORD_COLL_WAIT(ret, fh, tm1, tm_sync, tm2);
     MPIIO_POST_RECORD();
 
     return(ret);
@@ -770,19 +979,23 @@ int DARSHAN_DECL(MPI_File_write_all_begin)(MPI_File fh, void * buf, int count, M
 #endif
 {
     int ret;
-    double tm1, tm2;
+    double tm1, tm2, tm_sync;
     MPI_Offset offset;
 
     MAP_OR_FAIL(PMPI_File_write_all_begin);
 
     MPI_File_get_position_shared(fh, &offset);
 
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_MPIIO_MOD, TIMESERIES_API_MPIIO);
     tm1 = MPIIO_WTIME();
+    tm_sync = mpiio_coll_wait_sync(fh);
     ret = __real_PMPI_File_write_all_begin(fh, buf, count, datatype);
     tm2 = MPIIO_WTIME();
+    DARSHAN_ATTRIB_LEAVE();
 
     MPIIO_PRE_RECORD();
     MPIIO_RECORD_WRITE(ret, fh, count, datatype, offset, MPIIO_SPLIT_WRITES, tm1, tm2);
+    MPIIO_RECORD_COLL_WAIT(ret, fh, tm1, tm_sync, tm2);
     MPIIO_POST_RECORD();
 
     return(ret);
@@ -799,17 +1012,21 @@ int DARSHAN_DECL(MPI_File_read_at_all_begin)(MPI_File fh, MPI_Offset offset, voi
     int count, MPI_Datatype datatype)
 {
     int ret;
-    double tm1, tm2;
+    double tm1, tm2, tm_sync;
 
     MAP_OR_FAIL(PMPI_File_read_at_all_begin);
 
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_MPIIO_MOD, TIMESERIES_API_MPIIO);
     tm1 = MPIIO_WTIME();
+    tm_sync = mpiio_coll_wait_sync(fh);
     ret = __real_PMPI_File_read_at_all_begin(fh, offset, buf,
         count, datatype);
     tm2 = MPIIO_WTIME();
+    DARSHAN_ATTRIB_LEAVE();
 
     MPIIO_PRE_RECORD();
     MPIIO_RECORD_READ(ret, fh, count, datatype, offset, MPIIO_SPLIT_READS, tm1, tm2);
+    MPIIO_RECORD_COLL_WAIT(ret, fh, tm1, tm_sync, tm2);
     MPIIO_POST_RECORD();
 
     return(ret);
@@ -826,17 +1043,21 @@ int DARSHAN_DECL(MPI_File_write_at_all_begin)(MPI_File fh, MPI_Offset offset, vo
 #endif
 {
     int ret;
-    double tm1, tm2;
+    double tm1, tm2, tm_sync;
 
     MAP_OR_FAIL(PMPI_File_write_at_all_begin);
 
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_MPIIO_MOD, TIMESERIES_API_MPIIO);
     tm1 = MPIIO_WTIME();
+    tm_sync = mpiio_coll_wait_sync(fh);
     ret = __real_PMPI_File_write_at_all_begin(fh, offset,
         buf, count, datatype);
     tm2 = MPIIO_WTIME();
+    DARSHAN_ATTRIB_LEAVE();
 
     MPIIO_PRE_RECORD();
     MPIIO_RECORD_WRITE(ret, fh, count, datatype, offset, MPIIO_SPLIT_WRITES, tm1, tm2);
+    MPIIO_RECORD_COLL_WAIT(ret, fh, tm1, tm_sync, tm2);
     MPIIO_POST_RECORD();
 
     return(ret);
@@ -852,19 +1073,23 @@ DARSHAN_WRAPPER_MAP(PMPI_File_write_at_all_begin, int, (MPI_File fh, MPI_Offset
 int DARSHAN_DECL(MPI_File_read_ordered_begin)(MPI_File fh, void * buf, int count, MPI_Datatype datatype)
 {
     int ret;
-    double tm1, tm2;
+    double tm1, tm2, tm_sync;
     MPI_Offset offset;
 
     MAP_OR_FAIL(PMPI_File_read_ordered_begin);
 
     MPI_File_get_position_shared(fh, &offset);
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_MPIIO_MOD, TIMESERIES_API_MPIIO);
     tm1 = MPIIO_WTIME();
+    tm_sync = mpiio_coll_wait_sync(fh);
     ret = __real_PMPI_File_read_ordered_begin(fh, buf, count,
         datatype);
     tm2 = MPIIO_WTIME();
+    DARSHAN_ATTRIB_LEAVE();
 
     MPIIO_PRE_RECORD();
     MPIIO_RECORD_READ(ret, fh, count, datatype, offset, MPIIO_SPLIT_READS, tm1, tm2);
+    MPIIO_RECORD_COLL_WAIT(ret, fh, tm1, tm_sync, tm2);
     MPIIO_POST_RECORD();
 
     return(ret);
@@ -879,19 +1104,23 @@ int DARSHAN_DECL(MPI_File_write_ordered_begin)(MPI_File fh, void * buf, int coun
 #endif
 {
     int ret;
-    double tm1, tm2;
+    double tm1, tm2, tm_sync;
     MPI_Offset offset;
 
     MAP_OR_FAIL(PMPI_File_write_ordered_begin);
 
     MPI_File_get_position_shared(fh, &offset);
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_MPIIO_MOD, TIMESERIES_API_MPIIO);
     tm1 = MPIIO_WTIME();
+    tm_sync = mpiio_coll_wait_sync(fh);
     ret = __real_PMPI_File_write_ordered_begin(fh, buf, count,
         datatype);
     tm2 = MPIIO_WTIME();
+    DARSHAN_ATTRIB_LEAVE();
 
     MPIIO_PRE_RECORD();
     MPIIO_RECORD_WRITE(ret, fh, count, datatype, offset, MPIIO_SPLIT_WRITES, tm1, tm2);
+    MPIIO_RECORD_COLL_WAIT(ret, fh, tm1, tm_sync, tm2);
     MPIIO_POST_RECORD();
 
     return(ret);
@@ -913,12 +1142,15 @@ int DARSHAN_DECL(MPI_File_iread)(MPI_File fh, void * buf, int count, MPI_Datatyp
     MAP_OR_FAIL(PMPI_File_iread);
 
     MPI_File_get_position_shared(fh, &offset);
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_MPIIO_MOD, TIMESERIES_API_MPIIO);
     tm1 = MPIIO_WTIME();
     ret = __real_PMPI_File_iread(fh, buf, count, datatype, request);
     tm2 = MPIIO_WTIME();
+    DARSHAN_ATTRIB_LEAVE();
 
     MPIIO_PRE_RECORD();
     MPIIO_RECORD_READ(ret, fh, count, datatype, offset, MPIIO_NB_READS, tm1, tm2);
+    MPIIO_RECORD_NB_REQ(ret, fh, request, DARSHAN_IO_READ, tm1);
     MPIIO_POST_RECORD();
 
     return(ret);
@@ -941,12 +1173,15 @@ int DARSHAN_DECL(MPI_File_iwrite)(MPI_File fh, void * buf, int count,
     MAP_OR_FAIL(PMPI_File_iwrite);
 
     MPI_File_get_position(fh, &offset);
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_MPIIO_MOD, TIMESERIES_API_MPIIO);
     tm1 = MPIIO_WTIME();
     ret = __real_PMPI_File_iwrite(fh, buf, count, datatype, request);
     tm2 = MPIIO_WTIME();
+    DARSHAN_ATTRIB_LEAVE();
 
     MPIIO_PRE_RECORD();
     MPIIO_RECORD_WRITE(ret, fh, count, datatype, offset, MPIIO_NB_WRITES, tm1, tm2);
+    MPIIO_RECORD_NB_REQ(ret, fh, request, DARSHAN_IO_WRITE, tm1);
     MPIIO_POST_RECORD();
 
     return(ret);
@@ -969,13 +1204,16 @@ int DARSHAN_DECL(MPI_File_iread_at)(MPI_File fh, MPI_Offset offset, void * buf,
 
     MAP_OR_FAIL(PMPI_File_iread_at);
 
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_MPIIO_MOD, TIMESERIES_API_MPIIO);
     tm1 = MPIIO_WTIME();
     ret = __real_PMPI_File_iread_at(fh, offset, buf, count,
         datatype, request);
     tm2 = MPIIO_WTIME();
+    DARSHAN_ATTRIB_LEAVE();
 
     MPIIO_PRE_RECORD();
     MPIIO_RECORD_READ(ret, fh, count, datatype, offset, MPIIO_NB_READS, tm1, tm2);
+    MPIIO_RECORD_NB_REQ(ret, fh, request, DARSHAN_IO_READ, tm1);
     MPIIO_POST_RECORD();
 
     return(ret);
@@ -997,13 +1235,16 @@ int DARSHAN_DECL(MPI_File_iwrite_at)(MPI_File fh, MPI_Offset offset, void * buf,
 
     MAP_OR_FAIL(PMPI_File_iwrite_at);
 
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_MPIIO_MOD, TIMESERIES_API_MPIIO);
     tm1 = MPIIO_WTIME();
     ret = __real_PMPI_File_iwrite_at(fh, offset, buf,
         count, datatype, request);
     tm2 = MPIIO_WTIME();
+    DARSHAN_ATTRIB_LEAVE();
 
     MPIIO_PRE_RECORD();
     MPIIO_RECORD_WRITE(ret, fh, count, datatype, offset, MPIIO_NB_WRITES, tm1, tm2);
+    MPIIO_RECORD_NB_REQ(ret, fh, request, DARSHAN_IO_WRITE, tm1);
     MPIIO_POST_RECORD();
 
     return(ret);
@@ -1028,13 +1269,16 @@ int DARSHAN_DECL(MPI_File_iread_shared)(MPI_File fh, void * buf, int count,
     MAP_OR_FAIL(PMPI_File_iread_shared);
 
     MPI_File_get_position_shared(fh, &offset);
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_MPIIO_MOD, TIMESERIES_API_MPIIO);
     tm1 = MPIIO_WTIME();
     ret = __real_PMPI_File_iread_shared(fh, buf, count,
         datatype, request);
     tm2 = MPIIO_WTIME();
+    DARSHAN_ATTRIB_LEAVE();
 
     MPIIO_PRE_RECORD();
     MPIIO_RECORD_READ(ret, fh, count, datatype, offset, MPIIO_NB_READS, tm1, tm2);
+    MPIIO_RECORD_NB_REQ(ret, fh, request, DARSHAN_IO_READ, tm1);
     MPIIO_POST_RECORD();
 
     return(ret);
@@ -1058,13 +1302,16 @@ int DARSHAN_DECL(MPI_File_iwrite_shared)(MPI_File fh, void * buf, int count,
     MAP_OR_FAIL(PMPI_File_iwrite_shared);
 
     MPI_File_get_position_shared(fh, &offset);
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_MPIIO_MOD, TIMESERIES_API_MPIIO);
     tm1 = MPIIO_WTIME();
     ret = __real_PMPI_File_iwrite_shared(fh, buf, count,
         datatype, request);
     tm2 = MPIIO_WTIME();
+    DARSHAN_ATTRIB_LEAVE();
 
     MPIIO_PRE_RECORD();
     MPIIO_RECORD_WRITE(ret, fh, count, datatype, offset, MPIIO_NB_WRITES, tm1, tm2);
+    MPIIO_RECORD_NB_REQ(ret, fh, request, DARSHAN_IO_WRITE, tm1);
     MPIIO_POST_RECORD();
 
     return(ret);
@@ -1137,6 +1384,7 @@ int DARSHAN_DECL(MPI_File_set_view)(MPI_File fh, MPI_Offset disp, MPI_Datatype e
         if(rec_ref)
         {
             rec_ref->file_rec->counters[MPIIO_VIEWS] += 1;
+            mpiio_set_file_view(fh, disp, etype, filetype);
             if(info != MPI_INFO_NULL)
             {
                 rec_ref->file_rec->counters[MPIIO_HINTS] += 1;
@@ -1171,6 +1419,9 @@ int DARSHAN_DECL(MPI_File_close)(MPI_File *fh)
     ret = __real_PMPI_File_close(fh);
     tm2 = MPIIO_WTIME();
 
+    if(ret == MPI_SUCCESS)
+        mpiio_coll_wait_close(tmp_fh);
+
     MPIIO_PRE_RECORD();
     rec_ref = darshan_lookup_record_ref(mpiio_runtime->fh_hash,
         &tmp_fh, sizeof(MPI_File));
@@ -1183,15 +1434,20 @@ int DARSHAN_DECL(MPI_File_close)(MPI_File *fh)
         DARSHAN_TIMER_INC_NO_OVERLAP(
             rec_ref->file_rec->fcounters[MPIIO_F_META_TIME],
             tm1, tm2, rec_ref->last_meta_end);
-        darshan_delete_record_ref(&(mpiio_runtime->fh_hash),
-            &tmp_fh, sizeof(MPI_File));
+        LATENCY_RECORD(rec_ref->file_rec->base_rec.id, LATENCY_OP_MPIIO_META,
+            tm1, tm2);
+        TIMESERIES_RECORD(TIMESERIES_API_MPIIO, TIMESERIES_OP_META, 0,
+            tm1, tm2);
+        darshan_arena_delete_record_ref(mpiio_runtime->arena,
+            &(mpiio_runtime->fh_hash), &tmp_fh, sizeof(MPI_File));
+        free(darshan_delete_record_ref(&(mpiio_runtime->view_hash),
+            &tmp_fh, sizeof(MPI_File)));
 
 #ifdef HAVE_LDMS
         rec_ref->close_counts++;
         /* publish close information for mpiio */
-        if(dC.ldms_lib)
-            if(dC.mpiio_enable_ldms)
-                darshan_ldms_connector_send(rec_ref->file_rec->base_rec.id, rec_ref->file_rec->base_rec.rank, rec_ref->close_counts, "close", -1, -1, -1, -1, -1, tm1, tm2, rec_ref->file_rec->fcounters[MPIIO_F_META_TIME], "MPIIO", "MOD");
+        if(DARSHAN_LDMS_ENABLED(mpiio))
+            darshan_ldms_connector_send(rec_ref->file_rec->base_rec.id, rec_ref->file_rec->base_rec.rank, rec_ref->close_counts, "close", -1, -1, -1, -1, -1, tm1, tm2, rec_ref->file_rec->fcounters[MPIIO_F_META_TIME], "MPIIO", "MOD");
 #endif
     }
     MPIIO_POST_RECORD();
@@ -1200,6 +1456,253 @@ int DARSHAN_DECL(MPI_File_close)(MPI_File *fh)
 }
 DARSHAN_WRAPPER_MAP(PMPI_File_close, int, (MPI_File *fh), MPI_File_close)
 
+/* The MPI_Wait/MPI_Test family of wrappers complete the accounting for
+ * nonblocking MPI-IO requests. A completed request handle is reset to
+ * MPI_REQUEST_NULL, so saving the handles before the call and comparing
+ * them afterwards finds the completed requests the same way for every
+ * variant.
+ */
+int DARSHAN_DECL(MPI_Wait)(MPI_Request *request, MPI_Status *status)
+{
+    int ret;
+    double tm1, tm2;
+    MPI_Request stack_reqs[MPIIO_NB_REQ_STACK_COUNT];
+    MPI_Request *saved_reqs;
+
+    MAP_OR_FAIL(PMPI_Wait);
+
+    saved_reqs = mpiio_nb_req_save(request, 1, stack_reqs);
+    tm1 = MPIIO_WTIME();
+    ret = __real_PMPI_Wait(request, status);
+    tm2 = MPIIO_WTIME();
+
+    if(saved_reqs)
+        mpiio_nb_req_complete(saved_reqs, request, 1, stack_reqs, tm1, tm2);
+
+    return(ret);
+}
+DARSHAN_WRAPPER_MAP(PMPI_Wait, int, (MPI_Request *request, MPI_Status *status), MPI_Wait)
+
+int DARSHAN_DECL(MPI_Waitall)(int count, MPI_Request array_of_requests[],
+    MPI_Status array_of_statuses[])
+{
+    int ret;
+    double tm1, tm2;
+    MPI_Request stack_reqs[MPIIO_NB_REQ_STACK_COUNT];
+    MPI_Request *saved_reqs;
+
+    MAP_OR_FAIL(PMPI_Waitall);
+
+    saved_reqs = mpiio_nb_req_save(array_of_requests, count, stack_reqs);
+    tm1 = MPIIO_WTIME();
+    ret = __real_PMPI_Waitall(count, array_of_requests, array_of_statuses);
+    tm2 = MPIIO_WTIME();
+
+    if(saved_reqs)
+        mpiio_nb_req_complete(saved_reqs, array_of_requests, count,
+            stack_reqs, tm1, tm2);
+
+    return(ret);
+}
+DARSHAN_WRAPPER_MAP(PMPI_Waitall, int, (int count, MPI_Request array_of_requests[],
+    MPI_Status array_of_statuses[]), MPI_Waitall)
+
+int DARSHAN_DECL(MPI_Waitany)(int count, MPI_Request array_of_requests[],
+    int *index, MPI_Status *status)
+{
+    int ret;
+    double tm1, tm2;
+    MPI_Request stack_reqs[MPIIO_NB_REQ_STACK_COUNT];
+    MPI_Request *saved_reqs;
+
+    MAP_OR_FAIL(PMPI_Waitany);
+
+    saved_reqs = mpiio_nb_req_save(array_of_requests, count, stack_reqs);
+    tm1 = MPIIO_WTIME();
+    ret = __real_PMPI_Waitany(count, array_of_requests, index, status);
+    tm2 = MPIIO_WTIME();
+
+    if(saved_reqs)
+        mpiio_nb_req_complete(saved_reqs, array_of_requests, count,
+            stack_reqs, tm1, tm2);
+
+    return(ret);
+}
+DARSHAN_WRAPPER_MAP(PMPI_Waitany, int, (int count, MPI_Request array_of_requests[],
+    int *index, MPI_Status *status), MPI_Waitany)
+
+int DARSHAN_DECL(MPI_Waitsome)(int incount, MPI_Request array_of_requests[],
+    int *outcount, int array_of_indices[], MPI_Status array_of_statuses[])
+{
+    int ret;
+    double tm1, tm2;
+    MPI_Request stack_reqs[MPIIO_NB_REQ_STACK_COUNT];
+    MPI_Request *saved_reqs;
+
+    MAP_OR_FAIL(PMPI_Waitsome);
+
+    saved_reqs = mpiio_nb_req_save(array_of_requests, incount, stack_reqs);
+    tm1 = MPIIO_WTIME();
+    ret = __real_PMPI_Waitsome(incount, array_of_requests, outcount,
+        array_of_indices, array_of_statuses);
+    tm2 = MPIIO_WTIME();
+
+    if(saved_reqs)
+        mpiio_nb_req_complete(saved_reqs, array_of_requests, incount,
+            stack_reqs, tm1, tm2);
+
+    return(ret);
+}
+DARSHAN_WRAPPER_MAP(PMPI_Waitsome, int, (int incount, MPI_Request array_of_requests[],
+    int *outcount, int array_of_indices[], MPI_Status array_of_statuses[]),
+        MPI_Waitsome)
+
+int DARSHAN_DECL(MPI_Test)(MPI_Request *request, int *flag, MPI_Status *status)
+{
+    int ret;
+    double tm1, tm2;
+    MPI_Request stack_reqs[MPIIO_NB_REQ_STACK_COUNT];
+    MPI_Request *saved_reqs;
+
+    MAP_OR_FAIL(PMPI_Test);
+
+    saved_reqs = mpiio_nb_req_save(request, 1, stack_reqs);
+    tm1 = MPIIO_WTIME();
+    ret = __real_PMPI_Test(request, flag, status);
+    tm2 = MPIIO_WTIME();
+
+    if(saved_reqs)
+        mpiio_nb_req_complete(saved_reqs, request, 1, stack_reqs, tm1, tm2);
+
+    return(ret);
+}
+DARSHAN_WRAPPER_MAP(PMPI_Test, int, (MPI_Request *request, int *flag, MPI_Status *status), MPI_Test)
+
+int DARSHAN_DECL(MPI_Testall)(int count, MPI_Request array_of_requests[],
+    int *flag, MPI_Status array_of_statuses[])
+{
+    int ret;
+    double tm1, tm2;
+    MPI_Request stack_reqs[MPIIO_NB_REQ_STACK_COUNT];
+    MPI_Request *saved_reqs;
+
+    MAP_OR_FAIL(PMPI_Testall);
+
+    saved_reqs = mpiio_nb_req_save(array_of_requests, count, stack_reqs);
+    tm1 = MPIIO_WTIME();
+    ret = __real_PMPI_Testall(count, array_of_requests, flag, array_of_statuses);
+    tm2 = MPIIO_WTIME();
+
+    if(saved_reqs)
+        mpiio_nb_req_complete(saved_reqs, array_of_requests, count,
+            stack_reqs, tm1, tm2);
+
+    return(ret);
+}
+DARSHAN_WRAPPER_MAP(PMPI_Testall, int, (int count, MPI_Request array_of_requests[],
+    int *flag, MPI_Status array_of_statuses[]), MPI_Testall)
+
+int DARSHAN_DECL(MPI_Testany)(int count, MPI_Request array_of_requests[],
+    int *index, int *flag, MPI_Status *status)
+{
+    int ret;
+    double tm1, tm2;
+    MPI_Request stack_reqs[MPIIO_NB_REQ_STACK_COUNT];
+    MPI_Request *saved_reqs;
+
+    MAP_OR_FAIL(PMPI_Testany);
+
+    saved_reqs = mpiio_nb_req_save(array_of_requests, count, stack_reqs);
+    tm1 = MPIIO_WTIME();
+    ret = __real_PMPI_Testany(count, array_of_requests, index, flag, status);
+    tm2 = MPIIO_WTIME();
+
+    if(saved_reqs)
+        mpiio_nb_req_complete(saved_reqs, array_of_requests, count,
+            stack_reqs, tm1, tm2);
+
+    return(ret);
+}
+DARSHAN_WRAPPER_MAP(PMPI_Testany, int, (int count, MPI_Request array_of_requests[],
+    int *index, int *flag, MPI_Status *status), MPI_Testany)
+
+int DARSHAN_DECL(MPI_Testsome)(int incount, MPI_Request array_of_requests[],
+    int *outcount, int array_of_indices[], MPI_Status array_of_statuses[])
+{
+    int ret;
+    double tm1, tm2;
+    MPI_Request stack_reqs[MPIIO_NB_REQ_STACK_COUNT];
+    MPI_Request *saved_reqs;
+
+    MAP_OR_FAIL(PMPI_Testsome);
+
+    saved_reqs = mpiio_nb_req_save(array_of_requests, incount, stack_reqs);
+    tm1 = MPIIO_WTIME();
+    ret = __real_PMPI_Testsome(incount, array_of_requests, outcount,
+        array_of_indices, array_of_statuses);
+    tm2 = MPIIO_WTIME();
+
+    if(saved_reqs)
+        mpiio_nb_req_complete(saved_reqs, array_of_requests, incount,
+            stack_reqs, tm1, tm2);
+
+    return(ret);
+}
+DARSHAN_WRAPPER_MAP(PMPI_Testsome, int, (int incount, MPI_Request array_of_requests[],
+    int *outcount, int array_of_indices[], MPI_Status array_of_statuses[]),
+        MPI_Testsome)
+
+int DARSHAN_DECL(MPI_Request_free)(MPI_Request *request)
+{
+    int ret;
+    struct mpiio_nb_req *nb_req;
+    MPI_Request tmp_req = *request;
+
+    MAP_OR_FAIL(PMPI_Request_free);
+
+    ret = __real_PMPI_Request_free(request);
+
+    /* a freed request can no longer be completed, so stop tracking it */
+    if(__darshan_disabled || !mpiio_nb_req_count)
+        return(ret);
+    MPIIO_LOCK();
+    if(mpiio_runtime)
+    {
+        nb_req = darshan_delete_record_ref(&(mpiio_runtime->nb_req_hash),
+            &tmp_req, sizeof(MPI_Request));
+        if(nb_req)
+        {
+            free(nb_req);
+            mpiio_nb_req_count--;
+        }
+    }
+    MPIIO_UNLOCK();
+
+    return(ret);
+}
+DARSHAN_WRAPPER_MAP(PMPI_Request_free, int, (MPI_Request *request), MPI_Request_free)
+
+int DARSHAN_DECL(MPI_Type_free)(MPI_Datatype *datatype)
+{
+    int ret;
+    MPI_Datatype tmp_type = *datatype;
+
+    MAP_OR_FAIL(PMPI_Type_free);
+
+    /* the handle may be reused as soon as it is freed, so evict its cached
+     * size under the lock that readers of the cache hold
+     */
+    (void)__darshan_disabled;
+    MPIIO_LOCK();
+    ret = __real_PMPI_Type_free(datatype);
+    if(ret == MPI_SUCCESS)
+        mpiio_type_cache_evict(tmp_type);
+    MPIIO_UNLOCK();
+
+    return(ret);
+}
+DARSHAN_WRAPPER_MAP(PMPI_Type_free, int, (MPI_Datatype *datatype), MPI_Type_free)
+
 /***********************************************************
  * Internal functions for manipulating MPI-IO module state *
  ***********************************************************/
@@ -1242,8 +1745,9 @@ static void mpiio_runtime_initialize()
     }
     memset(mpiio_runtime, 0, sizeof(*mpiio_runtime));
 
-    /* allow DXT module to initialize if needed */
+    /* allow DXT and LATENCY modules to initialize if needed */
     dxt_mpiio_runtime_initialize();
+    latency_runtime_initialize();
 
     /* register a heatmap */
     mpiio_runtime->heatmap_id = heatmap_register("heatmap:MPIIO");
@@ -1251,6 +1755,164 @@ static void mpiio_runtime_initialize()
     return;
 }
 
+/* save the request handles passed to a completion call, returning NULL if
+ * none of them can be an outstanding MPI-IO request
+ */
+static MPI_Request *mpiio_nb_req_save(MPI_Request *reqs, int count,
+    MPI_Request *stack_reqs)
+{
+    MPI_Request *saved_reqs;
+
+    if(!mpiio_nb_req_count || count <= 0 ||
+        darshan_core_disabled_instrumentation())
+        return(NULL);
+
+    if(count <= MPIIO_NB_REQ_STACK_COUNT)
+        saved_reqs = stack_reqs;
+    else
+    {
+        saved_reqs = malloc(count * sizeof(*saved_reqs));
+        if(!saved_reqs)
+            return(NULL);
+    }
+    memcpy(saved_reqs, reqs, count * sizeof(*saved_reqs));
+
+    return(saved_reqs);
+}
+
+/* attribute the requests completed by a completion call spanning tm1 to
+ * tm2 to their files: the time from issuing each request to its completion,
+ * and the time blocked in the call
+ */
+static void mpiio_nb_req_complete(MPI_Request *saved_reqs, MPI_Request *reqs,
+    int count, MPI_Request *stack_reqs, double tm1, double tm2)
+{
+    struct mpiio_nb_req *nb_req;
+    struct mpiio_file_record_ref *rec_ref;
+    int i;
+
+    MPIIO_LOCK();
+    for(i = 0; mpiio_runtime && i < count; i++)
+    {
+        if(saved_reqs[i] == MPI_REQUEST_NULL || reqs[i] != MPI_REQUEST_NULL)
+            continue;
+        nb_req = darshan_delete_record_ref(&(mpiio_runtime->nb_req_hash),
+            &saved_reqs[i], sizeof(MPI_Request));
+        if(!nb_req)
+            continue;
+        mpiio_nb_req_count--;
+
+        rec_ref = nb_req->rec_ref;
+        if(!mpiio_runtime->frozen)
+        {
+            /* overlapping requests on a file are only counted once */
+            if(nb_req->io_type == DARSHAN_IO_READ &&
+                tm2 > rec_ref->last_nb_read_end)
+                DARSHAN_TIMER_INC_NO_OVERLAP(
+                    rec_ref->file_rec->fcounters[MPIIO_F_NB_READ_TIME],
+                    nb_req->issue_time, tm2, rec_ref->last_nb_read_end);
+            else if(nb_req->io_type == DARSHAN_IO_WRITE &&
+                tm2 > rec_ref->last_nb_write_end)
+                DARSHAN_TIMER_INC_NO_OVERLAP(
+                    rec_ref->file_rec->fcounters[MPIIO_F_NB_WRITE_TIME],
+                    nb_req->issue_time, tm2, rec_ref->last_nb_write_end);
+            if(tm2 > rec_ref->last_nb_wait_end)
+                DARSHAN_TIMER_INC_NO_OVERLAP(
+                    rec_ref->file_rec->fcounters[MPIIO_F_NB_WAIT_TIME],
+                    tm1, tm2, rec_ref->last_nb_wait_end);
+        }
+        free(nb_req);
+    }
+    MPIIO_UNLOCK();
+
+    if(saved_reqs != stack_reqs)
+        free(saved_reqs);
+
+    return;
+}
+
+/* decide whether collectives on a newly opened file are measured for
+ * collective wait time, which is only the case if every rank of the
+ * communicator opened it successfully and is instrumenting it
+ */
+static void mpiio_coll_wait_open(MPI_Comm comm, MPI_File fh, int open_ret)
+{
+    struct mpiio_coll_comm *coll_comm;
+    int comm_size;
+    int ok = 0, all_ok;
+
+    if(!darshan_core_mpiio_coll_wait_enabled())
+        return;
+
+    PMPI_Comm_size(comm, &comm_size);
+    if(comm_size == 1)
+        return;
+
+    coll_comm = malloc(sizeof(*coll_comm));
+
+    MPIIO_LOCK();
+    if(!mpiio_runtime && !mpiio_runtime_init_attempted)
+        mpiio_runtime_initialize();
+    if(open_ret == MPI_SUCCESS && coll_comm && mpiio_runtime &&
+        !mpiio_runtime->frozen)
+        ok = 1;
+    MPIIO_UNLOCK();
+
+    /* every rank must agree, or the barriers in collectives would not match */
+    PMPI_Allreduce(&ok, &all_ok, 1, MPI_INT, MPI_MIN, comm);
+    if(!all_ok)
+    {
+        free(coll_comm);
+        return;
+    }
+
+    PMPI_Comm_dup(comm, &coll_comm->comm);
+    MPIIO_LOCK();
+    darshan_add_record_ref(&mpiio_coll_comm_hash, &fh, sizeof(MPI_File),
+        coll_comm);
+    MPIIO_UNLOCK();
+
+    return;
+}
+
+static void mpiio_coll_wait_close(MPI_File fh)
+{
+    struct mpiio_coll_comm *coll_comm;
+
+    MPIIO_LOCK();
+    coll_comm = darshan_delete_record_ref(&mpiio_coll_comm_hash, &fh,
+        sizeof(MPI_File));
+    MPIIO_UNLOCK();
+    if(!coll_comm)
+        return;
+
+    PMPI_Comm_free(&coll_comm->comm);
+    free(coll_comm);
+
+    return;
+}
+
+/* wait for all ranks to enter a collective on the given file, returning the
+ * time they all had, or -1 if collectives on the file are not measured
+ */
+static double mpiio_coll_wait_sync(MPI_File fh)
+{
+    struct mpiio_coll_comm *coll_comm;
+    MPI_Comm comm;
+
+    MPIIO_LOCK();
+    coll_comm = darshan_lookup_record_ref(mpiio_coll_comm_hash, &fh,
+        sizeof(MPI_File));
+    if(coll_comm)
+        comm = coll_comm->comm;
+    MPIIO_UNLOCK();
+    if(!coll_comm)
+        return(-1);
+
+    PMPI_Barrier(comm);
+    return(darshan_core_wtime());
+}
+
 static struct mpiio_file_record_ref *mpiio_track_new_file_record(
     darshan_record_id rec_id, const char *path)
 {
@@ -1258,17 +1920,16 @@ static struct mpiio_file_record_ref *mpiio_track_new_file_record(
     struct mpiio_file_record_ref *rec_ref = NULL;
     int ret;
 
-    rec_ref = malloc(sizeof(*rec_ref));
+    rec_ref = darshan_arena_alloc(&(mpiio_runtime->arena), sizeof(*rec_ref));
     if(!rec_ref)
         return(NULL);
-    memset(rec_ref, 0, sizeof(*rec_ref));
 
     /* add a reference to this file record based on record id */
-    ret = darshan_add_record_ref(&(mpiio_runtime->rec_id_hash), &rec_id,
-        sizeof(darshan_record_id), rec_ref);
+    ret = darshan_arena_add_record_ref(&(mpiio_runtime->arena),
+        &(mpiio_runtime->rec_id_hash), &rec_id, sizeof(darshan_record_id), rec_ref);
     if(ret == 0)
     {
-        free(rec_ref);
+        darshan_arena_free(mpiio_runtime->arena, rec_ref, sizeof(*rec_ref));
         return(NULL);
     }
 
@@ -1284,9 +1945,9 @@ static struct mpiio_file_record_ref *mpiio_track_new_file_record(
 
     if(!file_rec)
     {
-        darshan_delete_record_ref(&(mpiio_runtime->rec_id_hash),
-            &rec_id, sizeof(darshan_record_id));
-        free(rec_ref);
+        darshan_arena_delete_record_ref(mpiio_runtime->arena,
+            &(mpiio_runtime->rec_id_hash), &rec_id, sizeof(darshan_record_id));
+        darshan_arena_free(mpiio_runtime->arena, rec_ref, sizeof(*rec_ref));
         return(NULL);
     }
 
@@ -1299,12 +1960,120 @@ static struct mpiio_file_record_ref *mpiio_track_new_file_record(
     return(rec_ref);
 }
 
+static inline int mpiio_type_cache_index(MPI_Datatype type)
+{
+    uint64_t key = 0;
+
+    /* handles are integers in some MPI implementations and pointers in
+     * others, so hash whatever bytes make up the handle
+     */
+    memcpy(&key, &type, sizeof(type) < sizeof(key) ? sizeof(type) : sizeof(key));
+    return((int)(((key * 0x9E3779B97F4A7C15ULL) >> 32) & (MPIIO_TYPE_CACHE_SIZE - 1)));
+}
+
+static int mpiio_type_size(MPI_Datatype type)
+{
+    struct mpiio_type_cache_entry *entry;
+    int size = 0;
+
+    entry = &mpiio_type_cache[mpiio_type_cache_index(type)];
+    if(entry->valid && entry->type == type)
+        return(entry->size);
+
+    PMPI_Type_size(type, &size);
+    entry->type = type;
+    entry->size = size;
+    entry->valid = 1;
+
+    return(size);
+}
+
+static void mpiio_type_cache_evict(MPI_Datatype type)
+{
+    struct mpiio_type_cache_entry *entry;
+
+    entry = &mpiio_type_cache[mpiio_type_cache_index(type)];
+    if(entry->valid && entry->type == type)
+        entry->valid = 0;
+
+    return;
+}
+
+static void mpiio_set_file_view(MPI_File fh, MPI_Offset disp,
+    MPI_Datatype etype, MPI_Datatype filetype)
+{
+    struct mpiio_file_view *view;
+    MPI_Aint lb, true_extent;
+
+    view = darshan_lookup_record_ref(mpiio_runtime->view_hash, &fh,
+        sizeof(MPI_File));
+    if(!view)
+    {
+        view = malloc(sizeof(*view));
+        if(!view)
+            return;
+        if(darshan_add_record_ref(&(mpiio_runtime->view_hash), &fh,
+            sizeof(MPI_File), view) != 1)
+        {
+            free(view);
+            return;
+        }
+    }
+
+    view->disp = disp;
+    view->etype_size = mpiio_type_size(etype);
+    view->ftype_size = mpiio_type_size(filetype);
+    PMPI_Type_get_extent(filetype, &lb, &(view->ftype_extent));
+    PMPI_Type_get_true_extent(filetype, &(view->ftype_true_lb), &true_extent);
+    view->ftype_dense = (view->ftype_extent == view->ftype_size &&
+        true_extent == view->ftype_size);
+
+    return;
+}
+
+/* translate an offset in etypes, relative to the view of the given file
+ * handle, to an absolute byte offset in the file, or -1 if it can't be
+ * determined
+ */
+static MPI_Offset mpiio_byte_offset(MPI_File fh, MPI_Offset offset)
+{
+    struct mpiio_file_view *view;
+    MPI_Offset bytes;
+    MPI_Offset byte_offset = -1;
+
+    view = darshan_lookup_record_ref(mpiio_runtime->view_hash, &fh,
+        sizeof(MPI_File));
+    if(!view)
+        return(offset);
+
+    bytes = offset * view->etype_size;
+    if(view->ftype_size > 0)
+    {
+        /* copies of the filetype tile the file starting at the
+         * displacement, and filetype displacements must be nondecreasing,
+         * so an offset at the start of a tile maps to the true lower bound
+         * of the tile.  Dense filetypes leave no holes between tiles.
+         */
+        if(view->ftype_dense)
+            return(view->disp + view->ftype_true_lb + bytes);
+        if(bytes % view->ftype_size == 0)
+            return(view->disp + (bytes / view->ftype_size) *
+                view->ftype_extent + view->ftype_true_lb);
+    }
+
+    /* otherwise ask MPI to walk the filetype */
+    if(get_byte_offset)
+        MPI_File_get_byte_offset(fh, offset, &byte_offset);
+
+    return(byte_offset);
+}
+
 static void mpiio_finalize_file_records(void *rec_ref_p, void *user_ptr)
 {
     struct mpiio_file_record_ref *rec_ref =
         (struct mpiio_file_record_ref *)rec_ref_p;
 
-    tdestroy(rec_ref->access_root, free);
+    free(rec_ref->access_root);
     return;
 }
 
@@ -1400,6 +2169,10 @@ static void mpiio_record_reduction_op(void* infile_v, void* inoutfile_v,
         {
             tmp_file.fcounters[j] = infile->fcounters[j] + inoutfile->fcounters[j];
         }
+        for(j=MPIIO_F_COLL_WAIT_TIME; j<=MPIIO_F_NB_WAIT_TIME; j++)
+        {
+            tmp_file.fcounters[j] = infile->fcounters[j] + inoutfile->fcounters[j];
+        }
 
         /* max (special case) */
         if(infile->fcounters[MPIIO_F_MAX_READ_TIME] >
@@ -1485,98 +2258,19 @@ static void mpiio_record_reduction_op(void* infile_v, void* inoutfile_v,
     return;
 }
 
-static void mpiio_shared_record_variance(MPI_Comm mod_comm,
-    struct darshan_mpiio_file *inrec_array, struct darshan_mpiio_file *outrec_array,
-    int shared_rec_count)
-{
-    MPI_Datatype var_dt;
-    MPI_Op var_op;
-    int i;
-    struct darshan_variance_dt *var_send_buf = NULL;
-    struct darshan_variance_dt *var_recv_buf = NULL;
-
-    PMPI_Type_contiguous(sizeof(struct darshan_variance_dt),
-        MPI_BYTE, &var_dt);
-    PMPI_Type_commit(&var_dt);
-
-    PMPI_Op_create(darshan_variance_reduce, 1, &var_op);
-
-    var_send_buf = malloc(shared_rec_count * sizeof(struct darshan_variance_dt));
-    if(!var_send_buf)
-        return;
-
-    if(my_rank == 0)
-    {
-        var_recv_buf = malloc(shared_rec_count * sizeof(struct darshan_variance_dt));
-
-        if(!var_recv_buf)
-            return;
-    }
-
-    /* get total i/o time variances for shared records */
-
-    for(i=0; i<shared_rec_count; i++)
-    {
-        var_send_buf[i].n = 1;
-        var_send_buf[i].S = 0;
-        var_send_buf[i].T = inrec_array[i].fcounters[MPIIO_F_READ_TIME] +
-                            inrec_array[i].fcounters[MPIIO_F_WRITE_TIME] +
-                            inrec_array[i].fcounters[MPIIO_F_META_TIME];
-    }
-
-    PMPI_Reduce(var_send_buf, var_recv_buf, shared_rec_count,
-        var_dt, var_op, 0, mod_comm);
-
-    if(my_rank == 0)
-    {
-        for(i=0; i<shared_rec_count; i++)
-        {
-            outrec_array[i].fcounters[MPIIO_F_VARIANCE_RANK_TIME] =
-                (var_recv_buf[i].S / var_recv_buf[i].n);
-        }
-    }
-
-    /* get total bytes moved variances for shared records */
-
-    for(i=0; i<shared_rec_count; i++)
-    {
-        var_send_buf[i].n = 1;
-        var_send_buf[i].S = 0;
-        var_send_buf[i].T = (double)
-                            inrec_array[i].counters[MPIIO_BYTES_READ] +
-                            inrec_array[i].counters[MPIIO_BYTES_WRITTEN];
-    }
-
-    PMPI_Reduce(var_send_buf, var_recv_buf, shared_rec_count,
-        var_dt, var_op, 0, mod_comm);
-
-    if(my_rank == 0)
-    {
-        for(i=0; i<shared_rec_count; i++)
-        {
-            outrec_array[i].fcounters[MPIIO_F_VARIANCE_RANK_BYTES] =
-                (var_recv_buf[i].S / var_recv_buf[i].n);
-        }
-    }
-
-    PMPI_Type_free(&var_dt);
-    PMPI_Op_free(&var_op);
-    free(var_send_buf);
-    free(var_recv_buf);
-
-    return;
-}
 #endif
 
-/* mpiio module shutdown benchmark routine */
-void darshan_mpiio_shutdown_bench_setup(int test_case)
+/* mpiio module shutdown benchmark routine: creates records for 'nfiles'
+ * files on this rank, the first 'nshared' of which are opened by every rank,
+ * with 'nwrites' writes (and DXT segments, if DXT is enabled) per file
+ */
+void darshan_mpiio_shutdown_bench_setup(int nfiles, int nshared, int nwrites)
 {
     char filepath[256];
-    MPI_File *fh_array;
+    MPI_File fh;
     MPI_Offset *offset_array;
     int64_t *size_array;
-    int i;
-    intptr_t j;
+    int i, j, k;
 
     if(mpiio_runtime)
         mpiio_cleanup();
@@ -1584,73 +2278,45 @@ void darshan_mpiio_shutdown_bench_setup(int test_case)
     mpiio_runtime_initialize();
 
     srand(my_rank);
-    fh_array = malloc(1024 * sizeof(MPI_File));
     size_array = malloc(DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT * sizeof(int64_t));
     offset_array = malloc(DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT *sizeof(MPI_Offset));
-    assert(fh_array && size_array);
+    assert(size_array && offset_array);
 
-    for(j = 0; j < 1024; j++)
-        fh_array[j] = (MPI_File)j;
     for(i = 0; i < DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT; i++) {
         offset_array[i] = rand();
         size_array[i] = rand();
     }
 
-    switch(test_case)
+    /* every file is "closed" before the next is opened, so one handle
+     * value is reused for all of them
+     */
+    fh = (MPI_File)(intptr_t)1;
+    for(i = 0; i < nfiles; i++)
     {
-        case 1: /* single file-per-process */
-            snprintf(filepath, 256, "fpp-0_rank-%d", my_rank);
-
-            MPIIO_RECORD_OPEN(MPI_SUCCESS, filepath, fh_array[0], MPI_COMM_SELF,
+        if(i < nshared)
+        {
+            snprintf(filepath, 256, "shared-%d", i);
+            MPIIO_RECORD_OPEN(MPI_SUCCESS, filepath, fh, MPI_COMM_WORLD,
                 2, MPI_INFO_NULL, 0, 1);
-            MPIIO_RECORD_WRITE(MPI_SUCCESS, fh_array[0], size_array[0], MPI_BYTE,
-                offset_array[0], MPIIO_INDEP_WRITES, 1, 2);
-
-            break;
-        case 2: /* single shared file */
-            snprintf(filepath, 256, "shared-0");
-
-            MPIIO_RECORD_OPEN(MPI_SUCCESS, filepath, fh_array[0], MPI_COMM_WORLD,
+        }
+        else
+        {
+            snprintf(filepath, 256, "fpp-%d_rank-%d", i, my_rank);
+            MPIIO_RECORD_OPEN(MPI_SUCCESS, filepath, fh, MPI_COMM_SELF,
                 2, MPI_INFO_NULL, 0, 1);
-            MPIIO_RECORD_WRITE(MPI_SUCCESS, fh_array[0], size_array[0], MPI_BYTE,
-                offset_array[0], MPIIO_COLL_WRITES, 1, 2);
-
-            break;
-        case 3: /* 1024 unique files per proc */
-            for(i = 0; i < 1024; i++)
-            {
-                snprintf(filepath, 256, "fpp-%d_rank-%d", i , my_rank);
-
-                MPIIO_RECORD_OPEN(MPI_SUCCESS, filepath, fh_array[i], MPI_COMM_SELF,
-                    2, MPI_INFO_NULL, 0, 1);
-                MPIIO_RECORD_WRITE(MPI_SUCCESS, fh_array[i],
-                    size_array[i % DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT],
-                    MPI_BYTE,
-                    offset_array[i % DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT],
-                    MPIIO_INDEP_WRITES, 1, 2);
-            }
-
-            break;
-        case 4: /* 1024 shared files per proc */
-            for(i = 0; i < 1024; i++)
-            {
-                snprintf(filepath, 256, "shared-%d", i);
-
-                MPIIO_RECORD_OPEN(MPI_SUCCESS, filepath, fh_array[i], MPI_COMM_WORLD,
-                    2, MPI_INFO_NULL, 0, 1);
-                MPIIO_RECORD_WRITE(MPI_SUCCESS, fh_array[i],
-                    size_array[i % DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT],
-                    MPI_BYTE,
-                    offset_array[i % DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT],
-                    MPIIO_COLL_WRITES, 1, 2);
-            }
-            break;
-        default:
-            fprintf(stderr, "Error: invalid Darshan benchmark test case.\n");
-            return;
+        }
+        for(j = 0; j < nwrites; j++)
+        {
+            k = (i + j) % DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT;
+            MPIIO_RECORD_WRITE(MPI_SUCCESS, fh, size_array[k], MPI_BYTE,
+                offset_array[k],
+                (i < nshared) ? MPIIO_COLL_WRITES : MPIIO_INDEP_WRITES, 1, 2);
+        }
+        darshan_arena_delete_record_ref(mpiio_runtime->arena,
+            &(mpiio_runtime->fh_hash), &fh, sizeof(MPI_File));
     }
 
-    free(fh_array);
+    free(offset_array);
     free(size_array);
 
     return;
@@ -1673,8 +2339,8 @@ static void mpiio_mpi_redux(
     double mpiio_time;
     struct darshan_mpiio_file *red_send_buf = NULL;
     struct darshan_mpiio_file *red_recv_buf = NULL;
-    MPI_Datatype red_type;
-    MPI_Op red_op;
+    double *var_vals = NULL;
+    int ret;
     int i;
 
     MPIIO_LOCK();
@@ -1726,40 +2392,51 @@ static void mpiio_mpi_redux(
     /* make send_buf point to the shared files at the end of sorted array */
     red_send_buf = &(mpiio_rec_buf[mpiio_rec_count-shared_rec_count]);
 
-    /* allocate memory for the reduction output on rank 0 */
+    /* allocate memory for the reduction output on rank 0, and for the
+     * time and byte totals whose variances are computed along with it
+     */
+    var_vals = malloc(shared_rec_count * 2 * sizeof(double));
     if(my_rank == 0)
-    {
         red_recv_buf = malloc(shared_rec_count * sizeof(struct darshan_mpiio_file));
-        if(!red_recv_buf)
-        {
-            MPIIO_UNLOCK();
-            return;
-        }
+    if(!var_vals || (my_rank == 0 && !red_recv_buf))
+    {
+        free(var_vals);
+        free(red_recv_buf);
+        MPIIO_UNLOCK();
+        return;
+    }
+    for(i = 0; i < shared_rec_count; i++)
+    {
+        var_vals[2*i] = red_send_buf[i].fcounters[MPIIO_F_READ_TIME] +
+            red_send_buf[i].fcounters[MPIIO_F_WRITE_TIME] +
+            red_send_buf[i].fcounters[MPIIO_F_META_TIME];
+        var_vals[2*i+1] = (double)red_send_buf[i].counters[MPIIO_BYTES_READ] +
+            red_send_buf[i].counters[MPIIO_BYTES_WRITTEN];
     }
 
-    /* construct a datatype for a MPIIO file record.  This is serving no purpose
-     * except to make sure we can do a reduction on proper boundaries
+    /* reduce shared MPIIO file records, along with their time and byte
+     * variances
      */
-    PMPI_Type_contiguous(sizeof(struct darshan_mpiio_file),
-        MPI_BYTE, &red_type);
-    PMPI_Type_commit(&red_type);
-
-    /* register a MPIIO file record reduction operator */
-    PMPI_Op_create(mpiio_record_reduction_op, 1, &red_op);
-
-    /* reduce shared MPIIO file records */
-    PMPI_Reduce(red_send_buf, red_recv_buf,
-        shared_rec_count, red_type, red_op, 0, mod_comm);
-
-    /* get the time and byte variances for shared files */
-    mpiio_shared_record_variance(mod_comm, red_send_buf, red_recv_buf,
-        shared_rec_count);
+    ret = darshan_shared_record_reduce(mod_comm, red_send_buf, red_recv_buf,
+        shared_rec_count, sizeof(struct darshan_mpiio_file),
+        mpiio_record_reduction_op, var_vals, 2);
 
     /* update module state to account for shared file reduction */
-    if(my_rank == 0)
+    if(ret < 0)
+    {
+        free(red_recv_buf);
+    }
+    else if(my_rank == 0)
     {
         /* overwrite local shared records with globally reduced records */
         int tmp_ndx = mpiio_rec_count - shared_rec_count;
+        for(i = 0; i < shared_rec_count; i++)
+        {
+            red_recv_buf[i].fcounters[MPIIO_F_VARIANCE_RANK_TIME] =
+                var_vals[2*i];
+            red_recv_buf[i].fcounters[MPIIO_F_VARIANCE_RANK_BYTES] =
+                var_vals[2*i+1];
+        }
         memcpy(&(mpiio_rec_buf[tmp_ndx]), red_recv_buf,
             shared_rec_count * sizeof(struct darshan_mpiio_file));
         free(red_recv_buf);
@@ -1769,9 +2446,7 @@ static void mpiio_mpi_redux(
         /* drop shared records on non-zero ranks */
         mpiio_runtime->file_rec_count -= shared_rec_count;
     }
-
-    PMPI_Type_free(&red_type);
-    PMPI_Op_free(&red_op);
+    free(var_vals);
 
     MPIIO_UNLOCK();
     return;
@@ -1805,8 +2480,12 @@ static void mpiio_cleanup()
     /* cleanup internal structures used for instrumenting */
     darshan_iter_record_refs(mpiio_runtime->rec_id_hash,
         &mpiio_finalize_file_records, NULL);
-    darshan_clear_record_refs(&(mpiio_runtime->fh_hash), 0);
-    darshan_clear_record_refs(&(mpiio_runtime->rec_id_hash), 1);
+    darshan_arena_clear_record_refs(&(mpiio_runtime->fh_hash));
+    darshan_arena_clear_record_refs(&(mpiio_runtime->rec_id_hash));
+    darshan_clear_record_refs(&(mpiio_runtime->nb_req_hash), 1);
+    darshan_clear_record_refs(&(mpiio_runtime->view_hash), 1);
+    mpiio_nb_req_count = 0;
+    darshan_arena_destroy(&(mpiio_runtime->arena));
 
     free(mpiio_runtime);
     mpiio_runtime = NULL;
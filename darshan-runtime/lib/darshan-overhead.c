@@ -0,0 +1,444 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <darshan-runtime-config.h>
+#endif
+
+#define _XOPEN_SOURCE 500
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "darshan.h"
+
+/* The overhead_runtime structure maintains necessary state for storing
+ * OVERHEAD records and for coordinating with darshan-core at shutdown time.
+ * There is one record for darshan-core and one for each module that
+ * registers with darshan-core.
+ */
+struct overhead_runtime
+{
+    struct darshan_overhead_record *core_rec;
+    struct darshan_overhead_record *mod_recs[DARSHAN_KNOWN_MODULE_COUNT];
+    int rec_count;
+    int frozen; /* flag to indicate that the counters should no longer be modified */
+};
+
+static struct overhead_runtime *overhead_runtime = NULL;
+static pthread_mutex_t overhead_runtime_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int my_rank = -1;
+
+__thread uint64_t darshan_overhead_tick = 0;
+__thread double darshan_overhead_start = 0;
+
+static struct darshan_overhead_record *overhead_track_new_record(
+    const char *name);
+static void overhead_finalize_records(
+    void);
+static void overhead_record_merge(
+    struct darshan_overhead_record *infile,
+    struct darshan_overhead_record *inoutfile);
+#ifdef HAVE_MPI
+static void overhead_record_reduction_op(
+    void* infile_v, void* inoutfile_v, int *len, MPI_Datatype *datatype);
+static void overhead_mpi_redux(
+    void *overhead_buf, MPI_Comm mod_comm,
+    darshan_record_id *shared_recs, int shared_rec_count);
+#endif
+static void overhead_output(
+    void **overhead_buf, int *overhead_buf_sz);
+static void overhead_cleanup(
+    void);
+
+#define OVERHEAD_LOCK() pthread_mutex_lock(&overhead_runtime_mutex)
+#define OVERHEAD_UNLOCK() pthread_mutex_unlock(&overhead_runtime_mutex)
+
+/**********************************************************
+ *  Hooks called by darshan-core and instrumented modules  *
+ **********************************************************/
+
+void darshan_overhead_runtime_initialize()
+{
+    int ret;
+    size_t overhead_rec_count;
+    darshan_module_funcs mod_funcs = {
+#ifdef HAVE_MPI
+    .mod_redux_func = &overhead_mpi_redux,
+#endif
+    .mod_output_func = &overhead_output,
+    .mod_cleanup_func = &overhead_cleanup
+    };
+
+    OVERHEAD_LOCK();
+
+    /* don't do anything if already initialized */
+    if(overhead_runtime)
+    {
+        OVERHEAD_UNLOCK();
+        return;
+    }
+
+    /* one record for darshan-core and one for each other module */
+    overhead_rec_count = DARSHAN_KNOWN_MODULE_COUNT;
+
+    /* register the OVERHEAD module with darshan core */
+    ret = darshan_core_register_module(
+        DARSHAN_OVERHEAD_MOD,
+        mod_funcs,
+        sizeof(struct darshan_overhead_record),
+        &overhead_rec_count,
+        &my_rank,
+        NULL);
+    if(ret < 0)
+    {
+        OVERHEAD_UNLOCK();
+        return;
+    }
+
+    overhead_runtime = malloc(sizeof(*overhead_runtime));
+    if(!overhead_runtime)
+    {
+        darshan_core_unregister_module(DARSHAN_OVERHEAD_MOD);
+        OVERHEAD_UNLOCK();
+        return;
+    }
+    memset(overhead_runtime, 0, sizeof(*overhead_runtime));
+
+    overhead_runtime->core_rec = overhead_track_new_record(OVERHEAD_CORE_NAME);
+
+    OVERHEAD_UNLOCK();
+    return;
+}
+
+void darshan_overhead_track_module(darshan_module_id mod_id)
+{
+    char name[64];
+
+    OVERHEAD_LOCK();
+    if(overhead_runtime && !overhead_runtime->frozen &&
+       !overhead_runtime->mod_recs[mod_id])
+    {
+        snprintf(name, sizeof(name), "%s%s", OVERHEAD_NAME_PREFIX,
+            darshan_module_names[mod_id]);
+        overhead_runtime->mod_recs[mod_id] = overhead_track_new_record(name);
+    }
+    OVERHEAD_UNLOCK();
+
+    return;
+}
+
+void darshan_overhead_sample(darshan_module_id mod_id, double start_time)
+{
+    double elapsed = darshan_core_wtime_absolute() - start_time;
+    struct darshan_overhead_record *rec;
+
+    OVERHEAD_LOCK();
+    if(overhead_runtime && !overhead_runtime->frozen)
+    {
+        rec = overhead_runtime->mod_recs[mod_id];
+        if(rec)
+        {
+            rec->counters[OVERHEAD_SAMPLED_CALLS] += 1;
+            rec->fcounters[OVERHEAD_F_SAMPLED_TIME] += elapsed;
+        }
+    }
+    OVERHEAD_UNLOCK();
+
+    return;
+}
+
+/**********************************************************
+ * Internal functions for manipulating OVERHEAD module state *
+ **********************************************************/
+
+static struct darshan_overhead_record *overhead_track_new_record(
+    const char *name)
+{
+    struct darshan_overhead_record *record_p;
+    darshan_record_id rec_id;
+
+    /* register the actual record with darshan-core so it is persisted in
+     * the log file
+     */
+    rec_id = darshan_core_gen_record_id(name);
+    record_p = darshan_core_register_record(
+        rec_id,
+        name,
+        DARSHAN_OVERHEAD_MOD,
+        sizeof(struct darshan_overhead_record),
+        NULL);
+    if(!record_p)
+        return(NULL);
+
+    /* registering this record was successful, so initialize some fields */
+    record_p->base_rec.id = rec_id;
+    record_p->base_rec.rank = my_rank;
+    overhead_runtime->rec_count++;
+
+    return(record_p);
+}
+
+/* fill in the estimated and shutdown costs of this process's records; this
+ * happens once, as late as possible in shutdown, so that every module
+ * written before the OVERHEAD module is accounted for
+ */
+static void overhead_finalize_records()
+{
+    double mod_shutdown_times[DARSHAN_KNOWN_MODULE_COUNT];
+    struct darshan_overhead_record *core_rec = overhead_runtime->core_rec;
+    struct darshan_overhead_record *rec;
+    int i;
+
+    if(overhead_runtime->frozen)
+        return;
+    overhead_runtime->frozen = 1;
+
+    if(core_rec)
+        darshan_core_get_overhead(core_rec, mod_shutdown_times);
+    else
+        memset(mod_shutdown_times, 0, sizeof(mod_shutdown_times));
+
+    for(i = 0; i <= DARSHAN_KNOWN_MODULE_COUNT; i++)
+    {
+        /* the core record is finalized last, as it totals the others */
+        if(i < DARSHAN_KNOWN_MODULE_COUNT)
+        {
+            rec = overhead_runtime->mod_recs[i];
+            if(!rec)
+                continue;
+            rec->fcounters[OVERHEAD_F_SHUTDOWN_TIME] = mod_shutdown_times[i];
+        }
+        else
+        {
+            rec = core_rec;
+            if(!rec)
+                break;
+        }
+
+        rec->counters[OVERHEAD_PROCS] = 1;
+        rec->counters[OVERHEAD_SAMPLE_INTERVAL] =
+            DARSHAN_OVERHEAD_SAMPLE_INTERVAL;
+        rec->fcounters[OVERHEAD_F_EST_TIME] =
+            rec->fcounters[OVERHEAD_F_SAMPLED_TIME] *
+            DARSHAN_OVERHEAD_SAMPLE_INTERVAL;
+        rec->fcounters[OVERHEAD_F_MAX_EST_TIME] =
+            rec->fcounters[OVERHEAD_F_EST_TIME];
+
+        if(core_rec && rec != core_rec)
+        {
+            core_rec->counters[OVERHEAD_SAMPLED_CALLS] +=
+                rec->counters[OVERHEAD_SAMPLED_CALLS];
+            core_rec->fcounters[OVERHEAD_F_SAMPLED_TIME] +=
+                rec->fcounters[OVERHEAD_F_SAMPLED_TIME];
+        }
+    }
+
+    return;
+}
+
+/* combine the counters of 'infile' into 'inoutfile' */
+static void overhead_record_merge(struct darshan_overhead_record *infile,
+    struct darshan_overhead_record *inoutfile)
+{
+    int i;
+
+    for(i = 0; i < OVERHEAD_NUM_INDICES; i++)
+    {
+        switch(i)
+        {
+            case OVERHEAD_SAMPLE_INTERVAL:
+                /* same value */
+                inoutfile->counters[i] = infile->counters[i];
+                break;
+            default:
+                /* sum */
+                inoutfile->counters[i] += infile->counters[i];
+                break;
+        }
+    }
+
+    for(i = 0; i < OVERHEAD_F_NUM_INDICES; i++)
+    {
+        switch(i)
+        {
+            case OVERHEAD_F_SAMPLED_TIME:
+            case OVERHEAD_F_EST_TIME:
+                /* sum */
+                inoutfile->fcounters[i] += infile->fcounters[i];
+                break;
+            default:
+                /* max */
+                if(inoutfile->fcounters[i] < infile->fcounters[i])
+                    inoutfile->fcounters[i] = infile->fcounters[i];
+                break;
+        }
+    }
+
+    return;
+}
+
+#ifdef HAVE_MPI
+static void overhead_record_reduction_op(void* infile_v, void* inoutfile_v,
+    int *len, MPI_Datatype *datatype)
+{
+    struct darshan_overhead_record *infile = infile_v;
+    struct darshan_overhead_record *inoutfile = inoutfile_v;
+    int i;
+
+    for(i=0; i<*len; i++)
+    {
+        overhead_record_merge(infile, inoutfile);
+        inoutfile->base_rec.rank = -1;
+        infile++;
+        inoutfile++;
+    }
+
+    return;
+}
+#endif
+
+/********************************************************************************
+ * Functions exported by this module for coordinating with darshan-core *
+ ********************************************************************************/
+
+#ifdef HAVE_MPI
+static void overhead_mpi_redux(
+    void *overhead_buf,
+    MPI_Comm mod_comm,
+    darshan_record_id *shared_recs,
+    int shared_rec_count)
+{
+    int overhead_rec_count;
+    struct darshan_overhead_record *overhead_rec_buf =
+        (struct darshan_overhead_record *)overhead_buf;
+    struct darshan_overhead_record *red_send_buf = NULL;
+    struct darshan_overhead_record *red_recv_buf = NULL;
+    MPI_Datatype red_type;
+    MPI_Op red_op;
+    int i, j;
+
+    OVERHEAD_LOCK();
+    assert(overhead_runtime);
+
+    overhead_finalize_records();
+
+    overhead_rec_count = overhead_runtime->rec_count;
+
+    /* necessary initialization of shared records */
+    for(i = 0; i < shared_rec_count; i++)
+    {
+        for(j = 0; j < overhead_rec_count; j++)
+        {
+            if(overhead_rec_buf[j].base_rec.id == shared_recs[i])
+            {
+                overhead_rec_buf[j].base_rec.rank = -1;
+                break;
+            }
+        }
+        assert(j < overhead_rec_count);
+    }
+
+    /* sort the array of records descending by rank so that we get all of
+     * the shared records (marked by rank -1) in a contiguous portion at end
+     * of the array
+     */
+    darshan_record_sort(overhead_rec_buf, overhead_rec_count,
+        sizeof(struct darshan_overhead_record));
+
+    /* make *send_buf point to the shared records at the end of sorted array */
+    red_send_buf = &(overhead_rec_buf[overhead_rec_count-shared_rec_count]);
+
+    /* allocate memory for the reduction output on rank 0 */
+    if(my_rank == 0)
+    {
+        red_recv_buf = malloc(shared_rec_count *
+            sizeof(struct darshan_overhead_record));
+        if(!red_recv_buf)
+        {
+            OVERHEAD_UNLOCK();
+            return;
+        }
+    }
+
+    /* construct a datatype for a OVERHEAD record.  This is serving no
+     * purpose except to make sure we can do a reduction on proper boundaries
+     */
+    PMPI_Type_contiguous(sizeof(struct darshan_overhead_record),
+        MPI_BYTE, &red_type);
+    PMPI_Type_commit(&red_type);
+
+    /* register a OVERHEAD record reduction operator */
+    PMPI_Op_create(overhead_record_reduction_op, 1, &red_op);
+
+    /* reduce shared OVERHEAD records */
+    PMPI_Reduce(red_send_buf, red_recv_buf,
+        shared_rec_count, red_type, red_op, 0, mod_comm);
+
+    /* update module state to account for shared record reduction */
+    if(my_rank == 0)
+    {
+        /* overwrite local shared records with globally reduced records */
+        int tmp_ndx = overhead_rec_count - shared_rec_count;
+        memcpy(&(overhead_rec_buf[tmp_ndx]), red_recv_buf,
+            shared_rec_count * sizeof(struct darshan_overhead_record));
+        free(red_recv_buf);
+    }
+    else
+    {
+        /* drop shared records on non-zero ranks */
+        overhead_runtime->rec_count -= shared_rec_count;
+    }
+
+    PMPI_Type_free(&red_type);
+    PMPI_Op_free(&red_op);
+
+    OVERHEAD_UNLOCK();
+    return;
+}
+#endif
+
+static void overhead_output(
+    void **overhead_buf,
+    int *overhead_buf_sz)
+{
+    OVERHEAD_LOCK();
+    assert(overhead_runtime);
+
+    /* a no-op if shared records were already reduced */
+    overhead_finalize_records();
+
+    *overhead_buf_sz = overhead_runtime->rec_count *
+        sizeof(struct darshan_overhead_record);
+
+    OVERHEAD_UNLOCK();
+    return;
+}
+
+static void overhead_cleanup()
+{
+    OVERHEAD_LOCK();
+    assert(overhead_runtime);
+
+    free(overhead_runtime);
+    overhead_runtime = NULL;
+
+    OVERHEAD_UNLOCK();
+    return;
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
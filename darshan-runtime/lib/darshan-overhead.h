@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifndef __DARSHAN_OVERHEAD_H
+#define __DARSHAN_OVERHEAD_H
+
+/* one in this many instrumented calls made by each thread is timed; must be
+ * a power of 2
+ */
+#define DARSHAN_OVERHEAD_SAMPLE_INTERVAL 64
+
+/* per-thread count of instrumented calls and start time of the call being
+ * timed, if any
+ */
+extern __thread uint64_t darshan_overhead_tick;
+extern __thread double darshan_overhead_start;
+
+/* DARSHAN_OVERHEAD_ENTER() and DARSHAN_OVERHEAD_EXIT() bracket the record
+ * macros of an instrumentation module.  Calls that return before reaching
+ * DARSHAN_OVERHEAD_EXIT() (e.g., because the module is disabled) are not
+ * counted, and entering twice for a single call just restarts its timer.
+ */
+#define DARSHAN_OVERHEAD_ENTER() do { \
+    if(((darshan_overhead_tick + 1) & \
+        (DARSHAN_OVERHEAD_SAMPLE_INTERVAL - 1)) == 0) \
+        darshan_overhead_start = darshan_core_wtime_absolute(); \
+} while(0)
+
+#define DARSHAN_OVERHEAD_EXIT(__mod_id) do { \
+    if((++darshan_overhead_tick & \
+        (DARSHAN_OVERHEAD_SAMPLE_INTERVAL - 1)) == 0) \
+        darshan_overhead_sample(__mod_id, darshan_overhead_start); \
+} while(0)
+
+/* darshan_overhead_runtime_initialize()
+ *
+ * Registers the OVERHEAD module and its darshan-core record; called by
+ * darshan-core at startup, before any other module registers.
+ */
+void darshan_overhead_runtime_initialize(void);
+
+/* darshan_overhead_track_module()
+ *
+ * Creates the OVERHEAD record for module 'mod_id'; called by darshan-core
+ * when the module registers.
+ */
+void darshan_overhead_track_module(darshan_module_id mod_id);
+
+/* darshan_overhead_sample()
+ *
+ * Accounts a timed call to module 'mod_id' that entered its record macros
+ * at 'start_time' (an absolute wtime).
+ */
+void darshan_overhead_sample(darshan_module_id mod_id, double start_time);
+
+#endif /* __DARSHAN_OVERHEAD_H */
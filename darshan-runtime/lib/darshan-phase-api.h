@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifndef __DARSHAN_PHASE_API_H
+#define __DARSHAN_PHASE_API_H
+
+/* Application interface for marking phases of execution, whose I/O
+ * Darshan then reports separately in PHASE records.
+ *
+ * The functions are declared weak so that applications can be built and
+ * run without Darshan; guard calls with a test of the function address:
+ *
+ *     if(darshan_phase_begin) darshan_phase_begin("checkpoint");
+ *
+ * Fortran programs can call the equivalent subroutines directly:
+ *
+ *     call darshan_phase_begin('checkpoint')
+ *     call darshan_phase_end()
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef __GNUC__
+#pragma weak darshan_phase_begin
+#pragma weak darshan_phase_end
+#endif
+
+/* darshan_phase_begin()
+ *
+ * begins a phase named 'name'; phases are process-wide, and may nest up to
+ * a depth of 8, in which case I/O is accounted to every open phase
+ */
+void darshan_phase_begin(const char *name);
+
+/* darshan_phase_end()
+ *
+ * ends the most recently begun phase
+ */
+void darshan_phase_end(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DARSHAN_PHASE_API_H */
@@ -0,0 +1,691 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <darshan-runtime-config.h>
+#endif
+
+#define _XOPEN_SOURCE 500
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "darshan.h"
+#include "darshan-phase.h"
+#include "darshan-timeseries.h"
+
+/* maximum nesting depth of phases begun with darshan_phase_begin() */
+#define PHASE_MAX_DEPTH 8
+
+/* maximum length of a phase record name, including PHASE_NAME_PREFIX */
+#define PHASE_MAX_NAME 256
+
+/* the counters of each API are laid out in this order, starting at
+ * PHASE_<API>_READS and PHASE_F_<API>_READ_TIME
+ */
+#define PHASE_CTR_READS 0
+#define PHASE_CTR_WRITES 1
+#define PHASE_CTR_META_OPS 2
+#define PHASE_CTR_BYTES_READ 3
+#define PHASE_CTR_BYTES_WRITTEN 4
+
+/* The phase_record_ref structure tracks a PHASE record, which accumulates
+ * all occurrences of the phase of the same name.
+ */
+struct phase_record_ref
+{
+    struct darshan_phase_record *rec;
+};
+
+/* An open phase; 'ref' is NULL if the phase could not be given a record,
+ * in which case it is still kept so that darshan_phase_end() calls pair up.
+ */
+struct phase_slot
+{
+    struct phase_record_ref *ref;
+    double start;
+};
+
+/* The phase_runtime structure maintains necessary state for storing PHASE
+ * records and for coordinating with darshan-core at shutdown time.
+ * slots[0] holds the current automatic phase, and slots[1..depth] the
+ * phases begun with darshan_phase_begin(), innermost last.
+ */
+struct phase_runtime
+{
+    void *rec_id_hash;
+    int rec_count;
+    struct phase_slot slots[PHASE_MAX_DEPTH + 1];
+    int depth;
+    int overflow; /* phases begun beyond PHASE_MAX_DEPTH, and ignored */
+    int auto_open;
+    uint64_t barriers;
+    uint64_t auto_seq;
+    int frozen; /* flag to indicate that the counters should no longer be modified */
+};
+
+static struct phase_runtime *phase_runtime = NULL;
+static pthread_mutex_t phase_runtime_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int my_rank = -1;
+
+int phase_runtime_active = 0;
+size_t phase_barrier_period = 0;
+
+static int phase_runtime_initialize(
+    void);
+static struct phase_record_ref *phase_track_new_record(
+    darshan_record_id rec_id, const char *name);
+static void phase_open_slot(
+    struct phase_slot *slot, const char *name, double tm);
+static void phase_close_slot(
+    int slot_ndx, double tm);
+static void phase_close_all(
+    void);
+static void phase_finalize_record(
+    void *rec_ref_p, void *user_ptr);
+static void phase_record_merge(
+    struct darshan_phase_record *infile,
+    struct darshan_phase_record *inoutfile);
+#ifdef HAVE_MPI
+static void phase_record_reduction_op(
+    void* infile_v, void* inoutfile_v, int *len, MPI_Datatype *datatype);
+static void phase_mpi_redux(
+    void *phase_buf, MPI_Comm mod_comm,
+    darshan_record_id *shared_recs, int shared_rec_count);
+#endif
+static void phase_output(
+    void **phase_buf, int *phase_buf_sz);
+static void phase_cleanup(
+    void);
+
+#define PHASE_LOCK() pthread_mutex_lock(&phase_runtime_mutex)
+#define PHASE_UNLOCK() pthread_mutex_unlock(&phase_runtime_mutex)
+
+#define PHASE_SET_ACTIVE() \
+    phase_runtime_active = (phase_runtime->auto_open || phase_runtime->depth)
+
+/**********************************************************
+ *      Public API for marking phases of the application   *
+ **********************************************************/
+
+void darshan_phase_begin(const char *name)
+{
+    PHASE_LOCK();
+    if(!phase_runtime && phase_runtime_initialize() < 0)
+    {
+        PHASE_UNLOCK();
+        return;
+    }
+    if(phase_runtime->frozen)
+    {
+        PHASE_UNLOCK();
+        return;
+    }
+
+    if(phase_runtime->depth == PHASE_MAX_DEPTH)
+        phase_runtime->overflow++;
+    else
+    {
+        phase_runtime->depth++;
+        phase_open_slot(&phase_runtime->slots[phase_runtime->depth],
+            name ? name : "", darshan_core_wtime());
+        PHASE_SET_ACTIVE();
+    }
+
+    PHASE_UNLOCK();
+    return;
+}
+
+void darshan_phase_end(void)
+{
+    PHASE_LOCK();
+    if(!phase_runtime || phase_runtime->frozen)
+    {
+        PHASE_UNLOCK();
+        return;
+    }
+
+    if(phase_runtime->overflow)
+        phase_runtime->overflow--;
+    else if(phase_runtime->depth)
+    {
+        phase_close_slot(phase_runtime->depth, darshan_core_wtime());
+        phase_runtime->depth--;
+        PHASE_SET_ACTIVE();
+    }
+
+    PHASE_UNLOCK();
+    return;
+}
+
+/* Fortran bindings, for the common name mangling conventions; character
+ * arguments are passed with a hidden length and padded with blanks
+ */
+static void phase_begin_fortran(const char *name, int name_len)
+{
+    char buf[PHASE_MAX_NAME];
+
+    while(name_len > 0 && name[name_len-1] == ' ')
+        name_len--;
+    if(name_len >= (int)sizeof(buf))
+        name_len = sizeof(buf) - 1;
+    if(name_len < 0)
+        name_len = 0;
+    memcpy(buf, name, name_len);
+    buf[name_len] = '\0';
+
+    darshan_phase_begin(buf);
+    return;
+}
+
+void darshan_phase_begin_(const char *name, int name_len)
+{
+    phase_begin_fortran(name, name_len);
+}
+
+void darshan_phase_begin__(const char *name, int name_len)
+{
+    phase_begin_fortran(name, name_len);
+}
+
+void DARSHAN_PHASE_BEGIN(const char *name, int name_len)
+{
+    phase_begin_fortran(name, name_len);
+}
+
+void darshan_phase_end_(void)
+{
+    darshan_phase_end();
+}
+
+void darshan_phase_end__(void)
+{
+    darshan_phase_end();
+}
+
+void DARSHAN_PHASE_END(void)
+{
+    darshan_phase_end();
+}
+
+/**********************************************************
+ *  Hooks called by darshan-core and instrumented modules  *
+ **********************************************************/
+
+void darshan_phase_runtime_initialize()
+{
+    size_t period;
+
+    /* phases are otherwise only tracked once the application begins one */
+    period = darshan_core_phase_barriers();
+    if(!period)
+        return;
+
+    PHASE_LOCK();
+    if(!phase_runtime && phase_runtime_initialize() < 0)
+    {
+        PHASE_UNLOCK();
+        return;
+    }
+
+    if(!phase_runtime->auto_open)
+    {
+        phase_open_slot(&phase_runtime->slots[0], PHASE_BARRIER_PREFIX "0",
+            darshan_core_wtime());
+        phase_runtime->auto_open = 1;
+        PHASE_SET_ACTIVE();
+        phase_barrier_period = period;
+    }
+
+    PHASE_UNLOCK();
+    return;
+}
+
+void phase_update(int api, int op, int64_t count, int64_t bytes,
+    double elapsed)
+{
+    struct phase_record_ref *ref;
+    int64_t *counters;
+    int first, i, j;
+
+    PHASE_LOCK();
+    if(!phase_runtime || phase_runtime->frozen)
+    {
+        PHASE_UNLOCK();
+        return;
+    }
+
+    first = phase_runtime->auto_open ? 0 : 1;
+    for(i = first; i <= phase_runtime->depth; i++)
+    {
+        ref = phase_runtime->slots[i].ref;
+        if(!ref)
+            continue;
+        /* only account once to a phase that is open more than once */
+        for(j = first; j < i; j++)
+            if(phase_runtime->slots[j].ref == ref)
+                break;
+        if(j < i)
+            continue;
+
+        counters = &ref->rec->counters[PHASE_POSIX_READS +
+            api * PHASE_API_COUNTERS];
+        if(op == TIMESERIES_OP_READ)
+        {
+            counters[PHASE_CTR_READS] += count;
+            counters[PHASE_CTR_BYTES_READ] += bytes;
+        }
+        else if(op == TIMESERIES_OP_WRITE)
+        {
+            counters[PHASE_CTR_WRITES] += count;
+            counters[PHASE_CTR_BYTES_WRITTEN] += bytes;
+        }
+        else
+            counters[PHASE_CTR_META_OPS] += count;
+        ref->rec->fcounters[PHASE_F_POSIX_READ_TIME +
+            api * PHASE_API_F_COUNTERS + op] += elapsed;
+    }
+
+    PHASE_UNLOCK();
+    return;
+}
+
+void phase_barrier()
+{
+    char name[PHASE_MAX_NAME];
+    double tm;
+
+    PHASE_LOCK();
+    if(!phase_runtime || phase_runtime->frozen || !phase_runtime->auto_open)
+    {
+        PHASE_UNLOCK();
+        return;
+    }
+
+    phase_runtime->barriers++;
+    if(phase_runtime->barriers % phase_barrier_period == 0)
+    {
+        tm = darshan_core_wtime();
+        phase_close_slot(0, tm);
+        phase_runtime->auto_seq++;
+        snprintf(name, sizeof(name), "%s%llu", PHASE_BARRIER_PREFIX,
+            (unsigned long long)phase_runtime->auto_seq);
+        phase_open_slot(&phase_runtime->slots[0], name, tm);
+    }
+
+    PHASE_UNLOCK();
+    return;
+}
+
+/**********************************************************
+ * Internal functions for manipulating PHASE module state  *
+ **********************************************************/
+
+/* registers the PHASE module with darshan-core; must be called with the
+ * PHASE lock held
+ */
+static int phase_runtime_initialize()
+{
+    int ret;
+    size_t phase_rec_count;
+    darshan_module_funcs mod_funcs = {
+#ifdef HAVE_MPI
+    .mod_redux_func = &phase_mpi_redux,
+#endif
+    .mod_output_func = &phase_output,
+    .mod_cleanup_func = &phase_cleanup
+    };
+
+    phase_rec_count = DARSHAN_DEF_MOD_REC_COUNT;
+
+    /* register the PHASE module with darshan core */
+    ret = darshan_core_register_module(
+        DARSHAN_PHASE_MOD,
+        mod_funcs,
+        sizeof(struct darshan_phase_record),
+        &phase_rec_count,
+        &my_rank,
+        NULL);
+    if(ret < 0)
+        return(-1);
+
+    phase_runtime = malloc(sizeof(*phase_runtime));
+    if(!phase_runtime)
+    {
+        darshan_core_unregister_module(DARSHAN_PHASE_MOD);
+        return(-1);
+    }
+    memset(phase_runtime, 0, sizeof(*phase_runtime));
+
+    return(0);
+}
+
+static struct phase_record_ref *phase_track_new_record(
+    darshan_record_id rec_id, const char *name)
+{
+    struct darshan_phase_record *record_p = NULL;
+    struct phase_record_ref *rec_ref = NULL;
+    int ret;
+
+    rec_ref = malloc(sizeof(*rec_ref));
+    if(!rec_ref)
+        return(NULL);
+    memset(rec_ref, 0, sizeof(*rec_ref));
+
+    /* add a reference to this record */
+    ret = darshan_add_record_ref(&(phase_runtime->rec_id_hash), &rec_id,
+        sizeof(darshan_record_id), rec_ref);
+    if(ret == 0)
+    {
+        free(rec_ref);
+        return(NULL);
+    }
+
+    /* register the actual record with darshan-core so it is persisted in
+     * the log file
+     */
+    record_p = darshan_core_register_record(
+        rec_id,
+        name,
+        DARSHAN_PHASE_MOD,
+        sizeof(struct darshan_phase_record),
+        NULL);
+
+    if(!record_p)
+    {
+        darshan_delete_record_ref(&(phase_runtime->rec_id_hash),
+            &rec_id, sizeof(darshan_record_id));
+        free(rec_ref);
+        return(NULL);
+    }
+
+    /* registering this record was successful, so initialize some fields */
+    record_p->base_rec.id = rec_id;
+    record_p->base_rec.rank = my_rank;
+    record_p->counters[PHASE_PROCS] = 1;
+    rec_ref->rec = record_p;
+    phase_runtime->rec_count++;
+
+    return(rec_ref);
+}
+
+static void phase_open_slot(struct phase_slot *slot, const char *name,
+    double tm)
+{
+    char rec_name[PHASE_MAX_NAME];
+    darshan_record_id rec_id;
+    struct phase_record_ref *ref;
+
+    snprintf(rec_name, sizeof(rec_name), "%s%s", PHASE_NAME_PREFIX, name);
+    rec_id = darshan_core_gen_record_id(rec_name);
+    ref = darshan_lookup_record_ref(phase_runtime->rec_id_hash,
+        &rec_id, sizeof(darshan_record_id));
+    if(!ref)
+        ref = phase_track_new_record(rec_id, rec_name);
+
+    slot->ref = ref;
+    slot->start = tm;
+    if(ref)
+    {
+        ref->rec->counters[PHASE_OCCURRENCES] += 1;
+        if(ref->rec->fcounters[PHASE_F_START_TIMESTAMP] == 0 ||
+           ref->rec->fcounters[PHASE_F_START_TIMESTAMP] > tm)
+            ref->rec->fcounters[PHASE_F_START_TIMESTAMP] = tm;
+    }
+
+    return;
+}
+
+static void phase_close_slot(int slot_ndx, double tm)
+{
+    struct phase_slot *slot = &phase_runtime->slots[slot_ndx];
+    int i;
+
+    if(!slot->ref)
+        return;
+
+    if(slot->ref->rec->fcounters[PHASE_F_END_TIMESTAMP] < tm)
+        slot->ref->rec->fcounters[PHASE_F_END_TIMESTAMP] = tm;
+
+    /* a phase open more than once is only timed by its outermost slot */
+    for(i = phase_runtime->auto_open ? 0 : 1; i <= phase_runtime->depth; i++)
+        if(i != slot_ndx && phase_runtime->slots[i].ref == slot->ref &&
+           phase_runtime->slots[i].start <= slot->start)
+            break;
+    if(i > phase_runtime->depth)
+        slot->ref->rec->fcounters[PHASE_F_TIME] += tm - slot->start;
+
+    slot->ref = NULL;
+    return;
+}
+
+/* ends any phases still open when darshan shuts down, and stops tracking
+ * further phases
+ */
+static void phase_close_all()
+{
+    double tm;
+
+    if(phase_runtime->frozen)
+        return;
+
+    tm = darshan_core_wtime();
+    for(; phase_runtime->depth > 0; phase_runtime->depth--)
+        phase_close_slot(phase_runtime->depth, tm);
+    if(phase_runtime->auto_open)
+    {
+        phase_close_slot(0, tm);
+        phase_runtime->auto_open = 0;
+    }
+    PHASE_SET_ACTIVE();
+    phase_barrier_period = 0;
+
+    darshan_iter_record_refs(phase_runtime->rec_id_hash,
+        &phase_finalize_record, NULL);
+    phase_runtime->frozen = 1;
+
+    return;
+}
+
+static void phase_finalize_record(void *rec_ref_p, void *user_ptr)
+{
+    struct phase_record_ref *rec_ref = rec_ref_p;
+
+    rec_ref->rec->fcounters[PHASE_F_SLOWEST_RANK_TIME] =
+        rec_ref->rec->fcounters[PHASE_F_TIME];
+
+    return;
+}
+
+/* combine the counters of 'infile' into 'inoutfile' */
+static void phase_record_merge(struct darshan_phase_record *infile,
+    struct darshan_phase_record *inoutfile)
+{
+    int i;
+
+    for(i = 0; i < PHASE_NUM_INDICES; i++)
+        inoutfile->counters[i] += infile->counters[i];
+
+    for(i = 0; i < PHASE_F_NUM_INDICES; i++)
+    {
+        switch(i)
+        {
+            case PHASE_F_START_TIMESTAMP:
+                /* min non-zero */
+                if(infile->fcounters[i] > 0 &&
+                   (inoutfile->fcounters[i] == 0 ||
+                    inoutfile->fcounters[i] > infile->fcounters[i]))
+                    inoutfile->fcounters[i] = infile->fcounters[i];
+                break;
+            case PHASE_F_END_TIMESTAMP:
+            case PHASE_F_SLOWEST_RANK_TIME:
+                /* max */
+                if(inoutfile->fcounters[i] < infile->fcounters[i])
+                    inoutfile->fcounters[i] = infile->fcounters[i];
+                break;
+            default:
+                /* sum */
+                inoutfile->fcounters[i] += infile->fcounters[i];
+                break;
+        }
+    }
+
+    return;
+}
+
+#ifdef HAVE_MPI
+static void phase_record_reduction_op(void* infile_v, void* inoutfile_v,
+    int *len, MPI_Datatype *datatype)
+{
+    struct darshan_phase_record *infile = infile_v;
+    struct darshan_phase_record *inoutfile = inoutfile_v;
+    int i;
+
+    for(i=0; i<*len; i++)
+    {
+        phase_record_merge(infile, inoutfile);
+        inoutfile->base_rec.rank = -1;
+        infile++;
+        inoutfile++;
+    }
+
+    return;
+}
+#endif
+
+/********************************************************************************
+ * Functions exported by this module for coordinating with darshan-core *
+ ********************************************************************************/
+
+#ifdef HAVE_MPI
+static void phase_mpi_redux(
+    void *phase_buf,
+    MPI_Comm mod_comm,
+    darshan_record_id *shared_recs,
+    int shared_rec_count)
+{
+    int phase_rec_count;
+    struct phase_record_ref *rec_ref;
+    struct darshan_phase_record *phase_rec_buf =
+        (struct darshan_phase_record *)phase_buf;
+    struct darshan_phase_record *red_send_buf = NULL;
+    struct darshan_phase_record *red_recv_buf = NULL;
+    int ret;
+    int i;
+
+    PHASE_LOCK();
+    assert(phase_runtime);
+
+    phase_close_all();
+    phase_rec_count = phase_runtime->rec_count;
+
+    /* necessary initialization of shared records */
+    for(i = 0; i < shared_rec_count; i++)
+    {
+        rec_ref = darshan_lookup_record_ref(phase_runtime->rec_id_hash,
+            &shared_recs[i], sizeof(darshan_record_id));
+        assert(rec_ref);
+
+        rec_ref->rec->base_rec.rank = -1;
+    }
+
+    /* sort the array of records descending by rank so that we get all of
+     * the shared records (marked by rank -1) in a contiguous portion at end
+     * of the array
+     */
+    darshan_record_sort(phase_rec_buf, phase_rec_count,
+        sizeof(struct darshan_phase_record));
+
+    /* make *send_buf point to the shared records at the end of sorted array */
+    red_send_buf = &(phase_rec_buf[phase_rec_count-shared_rec_count]);
+
+    /* allocate memory for the reduction output on rank 0 */
+    if(my_rank == 0)
+    {
+        red_recv_buf = malloc(shared_rec_count *
+            sizeof(struct darshan_phase_record));
+        if(!red_recv_buf)
+        {
+            PHASE_UNLOCK();
+            return;
+        }
+    }
+
+    /* reduce shared PHASE records */
+    ret = darshan_shared_record_reduce(mod_comm, red_send_buf, red_recv_buf,
+        shared_rec_count, sizeof(struct darshan_phase_record),
+        phase_record_reduction_op, NULL, 0);
+
+    /* update module state to account for shared record reduction */
+    if(ret < 0)
+    {
+        free(red_recv_buf);
+    }
+    else if(my_rank == 0)
+    {
+        /* overwrite local shared records with globally reduced records */
+        int tmp_ndx = phase_rec_count - shared_rec_count;
+        memcpy(&(phase_rec_buf[tmp_ndx]), red_recv_buf,
+            shared_rec_count * sizeof(struct darshan_phase_record));
+        free(red_recv_buf);
+    }
+    else
+    {
+        /* drop shared records on non-zero ranks */
+        phase_runtime->rec_count -= shared_rec_count;
+    }
+
+    PHASE_UNLOCK();
+    return;
+}
+#endif
+
+static void phase_output(
+    void **phase_buf,
+    int *phase_buf_sz)
+{
+    PHASE_LOCK();
+    assert(phase_runtime);
+
+    /* phases were already closed if shared records were reduced */
+    phase_close_all();
+
+    *phase_buf_sz = phase_runtime->rec_count *
+        sizeof(struct darshan_phase_record);
+
+    PHASE_UNLOCK();
+    return;
+}
+
+static void phase_cleanup()
+{
+    PHASE_LOCK();
+    assert(phase_runtime);
+
+    darshan_clear_record_refs(&(phase_runtime->rec_id_hash), 1);
+
+    free(phase_runtime);
+    phase_runtime = NULL;
+    phase_runtime_active = 0;
+    phase_barrier_period = 0;
+
+    PHASE_UNLOCK();
+    return;
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
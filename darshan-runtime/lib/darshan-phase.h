@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifndef __DARSHAN_PHASE_H
+#define __DARSHAN_PHASE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* set while at least one phase is open, so that the record macros of the
+ * instrumented modules only pay for a flag test otherwise
+ */
+extern int phase_runtime_active;
+
+/* number of MPI_Barrier() calls delimiting automatic phases, or 0 if
+ * automatic phases are disabled (the default)
+ */
+extern size_t phase_barrier_period;
+
+/* darshan_phase_runtime_initialize()
+ *
+ * registers the PHASE module and opens the first automatic phase, if
+ * automatic phases are enabled; called by darshan-core at startup.  The
+ * module is otherwise registered by the first darshan_phase_begin().
+ */
+void darshan_phase_runtime_initialize(void);
+
+/* phase_update()
+ *
+ * accounts 'count' operations of class 'op' (TIMESERIES_OP_*) through API
+ * 'api' (TIMESERIES_API_*), moving 'bytes' bytes in 'elapsed' seconds, to
+ * each open phase
+ */
+void phase_update(int api, int op, int64_t count, int64_t bytes,
+    double elapsed);
+
+/* phase_barrier()
+ *
+ * counts an MPI_Barrier() call made by the application, ending the current
+ * automatic phase and beginning the next one every phase_barrier_period
+ * calls
+ */
+void phase_barrier(void);
+
+#define PHASE_RECORD_N(__api, __op, __count, __bytes, __elapsed) do { \
+    if(phase_runtime_active) \
+        phase_update(__api, __op, __count, __bytes, __elapsed); \
+} while(0)
+
+#define PHASE_BARRIER() do { \
+    if(phase_barrier_period) \
+        phase_barrier(); \
+} while(0)
+
+#endif /* __DARSHAN_PHASE_H */
@@ -232,15 +232,18 @@ int DARSHAN_DECL(APINAME($1,$2,$3,$4))(int ncid, int varid, ArgKind($2)BufArgs($
 
     MAP_OR_FAIL(APINAME($1,$2,$3,$4));
 
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_PNETCDF_VAR_MOD, -1);
     tm1 = PNETCDF_WTIME();
     ret = `__real_'APINAME($1,$2,$3,$4)(ncid, varid, ArgKindName($2) buf ifelse($3,`',`, bufcount, buftype'));
     tm2 = PNETCDF_WTIME();
+    DARSHAN_ATTRIB_LEAVE();
 
     if (ret == NC_NOERR) {
         PNETCDF_VAR_PRE_RECORD();
         struct pnetcdf_var_record_ref *rec_ref;
         rec_ref = darshan_lookup_record_ref(pnetcdf_var_runtime->varid_hash, &varid, sizeof(int));
         if (rec_ref) {
+            DARSHAN_ATTRIB_CHARGE(rec_ref->var_rec->base_rec.id);
             struct darshan_common_val_counter *cvc;
             int64_t common_access_vals[PNETCDF_VAR_MAX_NDIMS+PNETCDF_VAR_MAX_NDIMS+1] = {0};
             size_t access_size;
@@ -275,15 +278,18 @@ int DARSHAN_DECL(APINAME($1,n,$2,$3))(int ncid, int varid, int num, MPI_Offset*
 
     MAP_OR_FAIL(APINAME($1,n,$2,$3));
 
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_PNETCDF_VAR_MOD, -1);
     tm1 = PNETCDF_WTIME();
     ret = `__real_'APINAME($1,n,$2,$3)(ncid, varid, num, starts, counts, buf ifelse($2,`',`, bufcount, buftype'));
     tm2 = PNETCDF_WTIME();
+    DARSHAN_ATTRIB_LEAVE();
 
     if (ret == NC_NOERR) {
         PNETCDF_VAR_PRE_RECORD();
         struct pnetcdf_var_record_ref *rec_ref;
         rec_ref = darshan_lookup_record_ref(pnetcdf_var_runtime->varid_hash, &varid, sizeof(int));
         if (rec_ref) {
+            DARSHAN_ATTRIB_CHARGE(rec_ref->var_rec->base_rec.id);
             struct darshan_common_val_counter *cvc;
             int64_t common_access_vals[PNETCDF_VAR_MAX_NDIMS+PNETCDF_VAR_MAX_NDIMS+1] = {0};
             size_t access_size;
@@ -317,15 +323,18 @@ int DARSHAN_DECL(ncmpi_$1_vard$2)(int ncid, int varid, MPI_Datatype filetype, if
 
     MAP_OR_FAIL(ncmpi_$1_vard$2);
 
+    DARSHAN_ATTRIB_BEGIN(DARSHAN_PNETCDF_VAR_MOD, -1);
     tm1 = PNETCDF_WTIME();
     ret = __real_ncmpi_$1_vard$2(ncid, varid, filetype, buf, bufcount, buftype);
     tm2 = PNETCDF_WTIME();
+    DARSHAN_ATTRIB_LEAVE();
 
     if (ret == NC_NOERR) {
         PNETCDF_VAR_PRE_RECORD();
         struct pnetcdf_var_record_ref *rec_ref;
         rec_ref = darshan_lookup_record_ref(pnetcdf_var_runtime->varid_hash, &varid, sizeof(int));
         if (rec_ref) {
+            DARSHAN_ATTRIB_CHARGE(rec_ref->var_rec->base_rec.id);
             struct darshan_common_val_counter *cvc;
             int64_t common_access_vals[PNETCDF_VAR_MAX_NDIMS+PNETCDF_VAR_MAX_NDIMS+1] = {0};
             size_t access_size;
@@ -373,8 +382,10 @@ int DARSHAN_DECL(APINAME($1,$2,$3))(int ncid, int varid, ArgKind($2)BufArgs($1,$
             CALC_ACCESS_INFO($2,ncid,access_size)
             UPDATE_GETPUT_COUNTERS($1,$2,access_size)
             ifelse($1,`iget',
-            `rec_ref->var_rec->counters[PNETCDF_VAR_NB_READS] += 1;',
-            `rec_ref->var_rec->counters[PNETCDF_VAR_NB_WRITES] += 1;')
+            `rec_ref->var_rec->counters[PNETCDF_VAR_NB_READS] += 1;
+            if (reqid) pnetcdf_nb_req_track(ncid, *reqid, rec_ref, DARSHAN_IO_READ, access_size);',
+            `rec_ref->var_rec->counters[PNETCDF_VAR_NB_WRITES] += 1;
+            if (reqid) pnetcdf_nb_req_track(ncid, *reqid, rec_ref, DARSHAN_IO_WRITE, access_size);')
         }
         PNETCDF_VAR_POST_RECORD();
     }
@@ -417,8 +428,10 @@ int DARSHAN_DECL(APINAME($1,n,$2))(int ncid, int varid, int num, MPI_Offset* con
             CALC_ACCESS_INFO(n,ncid,access_size)
             UPDATE_GETPUT_COUNTERS($1,n,access_size)
             ifelse($1,`iget',
-            `rec_ref->var_rec->counters[PNETCDF_VAR_NB_READS] += 1;',
-            `rec_ref->var_rec->counters[PNETCDF_VAR_NB_WRITES] += 1;')
+            `rec_ref->var_rec->counters[PNETCDF_VAR_NB_READS] += 1;
+            if (reqid) pnetcdf_nb_req_track(ncid, *reqid, rec_ref, DARSHAN_IO_READ, access_size);',
+            `rec_ref->var_rec->counters[PNETCDF_VAR_NB_WRITES] += 1;
+            if (reqid) pnetcdf_nb_req_track(ncid, *reqid, rec_ref, DARSHAN_IO_WRITE, access_size);')
         }
         PNETCDF_VAR_POST_RECORD();
     }
@@ -542,6 +555,8 @@ int DARSHAN_DECL(ncmpi_close)(int ncid)
     tm2 = PNETCDF_WTIME();
 
     if (ret == NC_NOERR) {
+        /* the file's request ids may be reused once it is closed */
+        pnetcdf_nb_req_drop(ncid, NC_REQ_ALL, NULL);
         PNETCDF_FILE_PRE_RECORD();
         rec_ref = darshan_lookup_record_ref(pnetcdf_file_runtime->ncid_hash,
             &ncid, sizeof(int));
@@ -632,13 +647,20 @@ int DARSHAN_DECL(ncmpi_wait)(int ncid, int num, int array_of_requests[],
 {
     int ret;
     double tm1, tm2;
+    int stack_reqs[PNETCDF_NB_REQ_STACK_COUNT];
+    int *saved_reqs;
+    int64_t nreqs, nbytes;
 
     MAP_OR_FAIL(ncmpi_wait);
 
+    saved_reqs = pnetcdf_nb_req_save(num, array_of_requests, stack_reqs);
     tm1 = PNETCDF_WTIME();
     ret = __real_ncmpi_wait(ncid, num, array_of_requests, array_of_statuses);
     tm2 = PNETCDF_WTIME();
 
+    nreqs = pnetcdf_nb_req_complete(ncid, num, saved_reqs, array_of_statuses,
+        stack_reqs, ret, tm1, tm2, &nbytes);
+
     PNETCDF_FILE_PRE_RECORD();
     struct pnetcdf_file_record_ref *rec_ref;
     rec_ref = darshan_lookup_record_ref(pnetcdf_file_runtime->ncid_hash, &ncid, sizeof(int));
@@ -649,6 +671,10 @@ int DARSHAN_DECL(ncmpi_wait)(int ncid, int num, int array_of_requests[],
         else {
             rec_ref->file_rec->counters[PNETCDF_FILE_WAIT_FAILURES] += 1;
         }
+        rec_ref->file_rec->counters[PNETCDF_FILE_WAIT_REQS] += nreqs;
+        rec_ref->file_rec->counters[PNETCDF_FILE_WAIT_BYTES] += nbytes;
+        PNETCDF_FILE_WAIT_REQS_INC(
+            &(rec_ref->file_rec->counters[PNETCDF_FILE_WAIT_REQS_0]), nreqs);
         if (rec_ref->file_rec->fcounters[PNETCDF_FILE_F_WAIT_START_TIMESTAMP] == 0 ||
             rec_ref->file_rec->fcounters[PNETCDF_FILE_F_WAIT_START_TIMESTAMP] > tm1)
             rec_ref->file_rec->fcounters[PNETCDF_FILE_F_WAIT_START_TIMESTAMP] = tm1;
@@ -668,13 +694,20 @@ int DARSHAN_DECL(ncmpi_wait_all)(int ncid, int num, int array_of_requests[],
 {
     int ret;
     double tm1, tm2;
+    int stack_reqs[PNETCDF_NB_REQ_STACK_COUNT];
+    int *saved_reqs;
+    int64_t nreqs, nbytes;
 
     MAP_OR_FAIL(ncmpi_wait_all);
 
+    saved_reqs = pnetcdf_nb_req_save(num, array_of_requests, stack_reqs);
     tm1 = PNETCDF_WTIME();
     ret = __real_ncmpi_wait_all(ncid, num, array_of_requests, array_of_statuses);
     tm2 = PNETCDF_WTIME();
 
+    nreqs = pnetcdf_nb_req_complete(ncid, num, saved_reqs, array_of_statuses,
+        stack_reqs, ret, tm1, tm2, &nbytes);
+
     PNETCDF_FILE_PRE_RECORD();
     struct pnetcdf_file_record_ref *rec_ref;
     rec_ref = darshan_lookup_record_ref(pnetcdf_file_runtime->ncid_hash, &ncid, sizeof(int));
@@ -685,6 +718,10 @@ int DARSHAN_DECL(ncmpi_wait_all)(int ncid, int num, int array_of_requests[],
         else {
             rec_ref->file_rec->counters[PNETCDF_FILE_WAIT_FAILURES] += 1;
         }
+        rec_ref->file_rec->counters[PNETCDF_FILE_WAIT_REQS] += nreqs;
+        rec_ref->file_rec->counters[PNETCDF_FILE_WAIT_BYTES] += nbytes;
+        PNETCDF_FILE_WAIT_REQS_INC(
+            &(rec_ref->file_rec->counters[PNETCDF_FILE_WAIT_REQS_0]), nreqs);
         if (rec_ref->file_rec->fcounters[PNETCDF_FILE_F_WAIT_START_TIMESTAMP] == 0 ||
             rec_ref->file_rec->fcounters[PNETCDF_FILE_F_WAIT_START_TIMESTAMP] > tm1)
             rec_ref->file_rec->fcounters[PNETCDF_FILE_F_WAIT_START_TIMESTAMP] = tm1;
@@ -697,6 +734,28 @@ int DARSHAN_DECL(ncmpi_wait_all)(int ncid, int num, int array_of_requests[],
     return(ret);
 }
 
+DARSHAN_FORWARD_DECL(ncmpi_cancel, int, (int ncid, int num, int *req_ids, int *statuses));
+
+int DARSHAN_DECL(ncmpi_cancel)(int ncid, int num, int *req_ids, int *statuses)
+{
+    int ret;
+    int stack_reqs[PNETCDF_NB_REQ_STACK_COUNT];
+    int *saved_reqs;
+
+    MAP_OR_FAIL(ncmpi_cancel);
+
+    saved_reqs = pnetcdf_nb_req_save(num, req_ids, stack_reqs);
+    ret = __real_ncmpi_cancel(ncid, num, req_ids, statuses);
+
+    /* cancelled requests are never flushed by a wait */
+    if (!__darshan_disabled && (num < 0 || saved_reqs))
+        pnetcdf_nb_req_drop(ncid, num, saved_reqs);
+    if (saved_reqs != stack_reqs)
+        free(saved_reqs);
+
+    return(ret);
+}
+
 DARSHAN_FORWARD_DECL(ncmpi_sync, int, (int ncid));
 
 int DARSHAN_DECL(ncmpi_sync)(int ncid)
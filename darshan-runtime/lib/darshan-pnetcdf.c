@@ -45,6 +45,8 @@ struct pnetcdf_var_record_ref
     double last_read_end;
     double last_write_end;
     double last_meta_end;
+    double last_nb_read_end;
+    double last_nb_write_end;
     void *access_root;
     int access_count;
     int unlimdimid;
@@ -64,12 +66,44 @@ struct pnetcdf_var_runtime
 {
     void *rec_id_hash;
     void *varid_hash;
+    void *nb_req_hash;
     int rec_count;
     int frozen; /* flag to indicate that the counters should no longer be modified */
 };
 
+/* a nonblocking PnetCDF request is identified by its file and request id */
+struct pnetcdf_nb_req_key
+{
+    int ncid;
+    int reqid;
+};
+
+/* an outstanding nonblocking get/put posted through an iget/iput/bput call,
+ * indexed by its request id until a file wait flushes it
+ */
+struct pnetcdf_nb_req
+{
+    struct pnetcdf_nb_req_key key;
+    struct pnetcdf_var_record_ref *rec_ref;
+    enum darshan_io_type io_type;
+    int64_t bytes;
+};
+
+/* number of request ids saved on the stack by wait wrappers */
+#define PNETCDF_NB_REQ_STACK_COUNT 64
+
 static void pnetcdf_file_runtime_initialize(void);
 static void pnetcdf_var_runtime_initialize(void);
+static void pnetcdf_nb_req_track(
+    int ncid, int reqid, struct pnetcdf_var_record_ref *rec_ref,
+    enum darshan_io_type io_type, int64_t bytes);
+static int *pnetcdf_nb_req_save(
+    int num, int *reqs, int *stack_reqs);
+static int64_t pnetcdf_nb_req_complete(
+    int ncid, int num, int *saved_reqs, int *statuses, int *stack_reqs,
+    int wait_ret, double tm1, double tm2, int64_t *bytes);
+static void pnetcdf_nb_req_drop(
+    int ncid, int num, int *reqs);
 static struct pnetcdf_file_record_ref *pnetcdf_file_track_new_record(
     darshan_record_id rec_id, const char *path);
 static struct pnetcdf_var_record_ref *pnetcdf_var_track_new_record(
@@ -80,9 +114,6 @@ static void pnetcdf_file_record_reduction_op(
     void* infile_v, void* inoutfile_v, int *len, MPI_Datatype *datatype);
 static void pnetcdf_var_record_reduction_op(
     void* inrec_v, void* inoutrec_v, int *len, MPI_Datatype *datatype);
-static void pnetcdf_var_shared_record_variance(
-    MPI_Comm mod_comm, struct darshan_pnetcdf_var *inrec_array,
-    struct darshan_pnetcdf_var *outrec_array, int shared_rec_count);
 static void pnetcdf_file_mpi_redux(
     void *pnetcdf_buf, MPI_Comm mod_comm,
     darshan_record_id *shared_recs, int shared_rec_count);
@@ -116,6 +147,7 @@ static int my_rank = -1;
  * return immediately without reaching the POST_RECORD() macro.
  */
 #define PNETCDF_FILE_PRE_RECORD() do { \
+    DARSHAN_OVERHEAD_ENTER(); \
     if(!__darshan_disabled) { \
         PNETCDF_LOCK(); \
         if(!pnetcdf_file_runtime && !pnetcdf_file_runtime_init_attempted) \
@@ -128,6 +160,7 @@ static int my_rank = -1;
 
 #define PNETCDF_FILE_POST_RECORD() do { \
     PNETCDF_UNLOCK(); \
+    DARSHAN_OVERHEAD_EXIT(DARSHAN_PNETCDF_FILE_MOD); \
 } while(0)
 
 #define DARSHAN_PNETCDF_VAR_DELIM ":"
@@ -138,6 +171,7 @@ static int my_rank = -1;
  * return immediately without reaching the POST_RECORD() macro.
  */
 #define PNETCDF_VAR_PRE_RECORD() do { \
+    DARSHAN_OVERHEAD_ENTER(); \
     if(!__darshan_disabled) { \
         PNETCDF_LOCK(); \
         if(!pnetcdf_var_runtime && !pnetcdf_var_runtime_init_attempted) \
@@ -150,6 +184,27 @@ static int my_rank = -1;
 
 #define PNETCDF_VAR_POST_RECORD() do { \
     PNETCDF_UNLOCK(); \
+    DARSHAN_OVERHEAD_EXIT(DARSHAN_PNETCDF_VAR_MOD); \
+} while(0)
+
+/* update the batching histogram of a file record for a wait that flushed
+ * __nreqs nonblocking requests
+ */
+#define PNETCDF_FILE_WAIT_REQS_INC(__bucket_base_p, __nreqs) do {\
+    if(__nreqs < 1) \
+        *(__bucket_base_p) += 1; \
+    else if(__nreqs < 2) \
+        *(__bucket_base_p + 1) += 1; \
+    else if(__nreqs < 5) \
+        *(__bucket_base_p + 2) += 1; \
+    else if(__nreqs < 17) \
+        *(__bucket_base_p + 3) += 1; \
+    else if(__nreqs < 65) \
+        *(__bucket_base_p + 4) += 1; \
+    else if(__nreqs < 257) \
+        *(__bucket_base_p + 5) += 1; \
+    else \
+        *(__bucket_base_p + 6) += 1; \
 } while(0)
 
 /*********************************************************
@@ -336,7 +391,246 @@ static void pnetcdf_var_finalize_records(void *rec_ref_p, void *user_ptr)
     struct pnetcdf_var_record_ref *rec_ref =
         (struct pnetcdf_var_record_ref *)rec_ref_p;
 
-    tdestroy(rec_ref->access_root, free);
+    free(rec_ref->access_root);
+    return;
+}
+
+/* remember which variable a newly posted nonblocking request belongs to, so
+ * the wait that flushes it can be charged to the variable
+ */
+static void pnetcdf_nb_req_track(int ncid, int reqid,
+    struct pnetcdf_var_record_ref *rec_ref, enum darshan_io_type io_type,
+    int64_t bytes)
+{
+    struct pnetcdf_nb_req *nb_req;
+    struct pnetcdf_nb_req_key key;
+
+    /* zero-length requests are never posted */
+    if(reqid == NC_REQ_NULL)
+        return;
+
+    key.ncid = ncid;
+    key.reqid = reqid;
+    nb_req = darshan_lookup_record_ref(pnetcdf_var_runtime->nb_req_hash,
+        &key, sizeof(key));
+    if(!nb_req)
+    {
+        nb_req = malloc(sizeof(*nb_req));
+        if(!nb_req)
+            return;
+        nb_req->key = key;
+        if(darshan_add_record_ref(&(pnetcdf_var_runtime->nb_req_hash),
+            &nb_req->key, sizeof(nb_req->key), nb_req) != 1)
+        {
+            free(nb_req);
+            return;
+        }
+    }
+    nb_req->rec_ref = rec_ref;
+    nb_req->io_type = io_type;
+    nb_req->bytes = bytes;
+
+    return;
+}
+
+/* save the request ids passed to a wait, which PnetCDF resets to
+ * NC_REQ_NULL as it flushes them
+ */
+static int *pnetcdf_nb_req_save(int num, int *reqs, int *stack_reqs)
+{
+    int *saved_reqs;
+
+    if(num <= 0 || !reqs || darshan_core_disabled_instrumentation())
+        return(NULL);
+
+    if(num <= PNETCDF_NB_REQ_STACK_COUNT)
+        saved_reqs = stack_reqs;
+    else
+    {
+        saved_reqs = malloc(num * sizeof(*saved_reqs));
+        if(!saved_reqs)
+            return(NULL);
+    }
+    memcpy(saved_reqs, reqs, num * sizeof(*saved_reqs));
+
+    return(saved_reqs);
+}
+
+struct pnetcdf_nb_req_match
+{
+    int ncid;
+    int num;
+    struct pnetcdf_nb_req **nb_reqs;
+    int count;
+    int size;
+};
+
+static void pnetcdf_nb_req_match_iterator(void *nb_req_p, void *user_ptr)
+{
+    struct pnetcdf_nb_req *nb_req = (struct pnetcdf_nb_req *)nb_req_p;
+    struct pnetcdf_nb_req_match *match = (struct pnetcdf_nb_req_match *)user_ptr;
+    struct pnetcdf_nb_req **tmp;
+
+    if(nb_req->key.ncid != match->ncid ||
+        (match->num == NC_GET_REQ_ALL && nb_req->io_type != DARSHAN_IO_READ) ||
+        (match->num == NC_PUT_REQ_ALL && nb_req->io_type != DARSHAN_IO_WRITE))
+        return;
+
+    if(match->count == match->size)
+    {
+        tmp = realloc(match->nb_reqs, 2 * (match->size + 1) * sizeof(*tmp));
+        if(!tmp)
+            return;
+        match->nb_reqs = tmp;
+        match->size = 2 * (match->size + 1);
+    }
+    match->nb_reqs[match->count++] = nb_req;
+
+    return;
+}
+
+/* find the tracked requests of file ncid that a wait or cancel with the
+ * given num/request id arguments applies to, removing them from the table;
+ * num may be NC_REQ_ALL, NC_GET_REQ_ALL or NC_PUT_REQ_ALL to select all
+ * pending (get, put) requests of the file
+ */
+static struct pnetcdf_nb_req **pnetcdf_nb_req_take(int ncid, int num,
+    int *reqs, int *count)
+{
+    struct pnetcdf_nb_req_match match = {ncid, num, NULL, 0, 0};
+    struct pnetcdf_nb_req_key key;
+    int i;
+
+    *count = 0;
+    if(!pnetcdf_var_runtime || !pnetcdf_var_runtime->nb_req_hash)
+        return(NULL);
+
+    if(num < 0)
+    {
+        darshan_iter_record_refs(pnetcdf_var_runtime->nb_req_hash,
+            &pnetcdf_nb_req_match_iterator, &match);
+        for(i = 0; i < match.count; i++)
+            darshan_delete_record_ref(&(pnetcdf_var_runtime->nb_req_hash),
+                &match.nb_reqs[i]->key, sizeof(match.nb_reqs[i]->key));
+    }
+    else
+    {
+        match.nb_reqs = malloc(num * sizeof(*match.nb_reqs));
+        if(!match.nb_reqs)
+            return(NULL);
+        key.ncid = ncid;
+        for(i = 0; i < num; i++)
+        {
+            if(reqs[i] == NC_REQ_NULL)
+                continue;
+            key.reqid = reqs[i];
+            match.nb_reqs[match.count] = darshan_delete_record_ref(
+                &(pnetcdf_var_runtime->nb_req_hash), &key, sizeof(key));
+            if(match.nb_reqs[match.count])
+                match.count++;
+        }
+    }
+
+    *count = match.count;
+    return(match.nb_reqs);
+}
+
+/* charge the requests flushed by a wait spanning tm1 to tm2 to their
+ * variables, returning the number of requests the wait flushed and the
+ * number of bytes they moved
+ */
+static int64_t pnetcdf_nb_req_complete(int ncid, int num, int *saved_reqs,
+    int *statuses, int *stack_reqs, int wait_ret, double tm1, double tm2,
+    int64_t *bytes)
+{
+    struct pnetcdf_nb_req **nb_reqs;
+    struct pnetcdf_var_record_ref *rec_ref;
+    int64_t nreqs = 0;
+    int count;
+    int ok;
+    int i, j;
+
+    *bytes = 0;
+    if(darshan_core_disabled_instrumentation())
+        return(0);
+
+    /* with explicit request ids every non-null id is flushed, whether or not
+     * Darshan saw it being posted
+     */
+    for(i = 0; saved_reqs && i < num; i++)
+    {
+        if(saved_reqs[i] != NC_REQ_NULL)
+            nreqs++;
+    }
+
+    PNETCDF_LOCK();
+    if(num < 0 || saved_reqs)
+    {
+        nb_reqs = pnetcdf_nb_req_take(ncid, num, saved_reqs, &count);
+        if(num < 0)
+            nreqs = count;
+        for(i = 0, j = 0; i < count; i++)
+        {
+            rec_ref = nb_reqs[i]->rec_ref;
+
+            /* per-request status is only available for explicit ids */
+            ok = (wait_ret == NC_NOERR);
+            if(num >= 0 && statuses)
+            {
+                while(saved_reqs[j] != nb_reqs[i]->key.reqid)
+                    j++;
+                ok = (statuses[j] == NC_NOERR);
+            }
+            if(ok)
+                *bytes += nb_reqs[i]->bytes;
+
+            /* the wait moves the data of all its requests at once, so its
+             * time is charged once to each variable with requests in it
+             */
+            if(!pnetcdf_var_runtime->frozen)
+            {
+                if(nb_reqs[i]->io_type == DARSHAN_IO_READ &&
+                    tm2 > rec_ref->last_nb_read_end)
+                    DARSHAN_TIMER_INC_NO_OVERLAP(
+                        rec_ref->var_rec->fcounters[PNETCDF_VAR_F_NB_READ_TIME],
+                        tm1, tm2, rec_ref->last_nb_read_end);
+                else if(nb_reqs[i]->io_type == DARSHAN_IO_WRITE &&
+                    tm2 > rec_ref->last_nb_write_end)
+                    DARSHAN_TIMER_INC_NO_OVERLAP(
+                        rec_ref->var_rec->fcounters[PNETCDF_VAR_F_NB_WRITE_TIME],
+                        tm1, tm2, rec_ref->last_nb_write_end);
+            }
+            free(nb_reqs[i]);
+        }
+        free(nb_reqs);
+    }
+    PNETCDF_UNLOCK();
+
+    if(saved_reqs != stack_reqs)
+        free(saved_reqs);
+
+    return(nreqs);
+}
+
+/* forget the tracked requests of file ncid that are cancelled, or that are
+ * discarded when the file is closed (num of NC_REQ_ALL)
+ */
+static void pnetcdf_nb_req_drop(int ncid, int num, int *reqs)
+{
+    struct pnetcdf_nb_req **nb_reqs;
+    int count;
+    int i;
+
+    if(darshan_core_disabled_instrumentation() || (num > 0 && !reqs))
+        return;
+
+    PNETCDF_LOCK();
+    nb_reqs = pnetcdf_nb_req_take(ncid, num, reqs, &count);
+    for(i = 0; i < count; i++)
+        free(nb_reqs[i]);
+    free(nb_reqs);
+    PNETCDF_UNLOCK();
+
     return;
 }
 
@@ -497,6 +791,12 @@ static void pnetcdf_var_record_reduction_op(void* inrec_v, void* inoutrec_v,
             tmp_var.fcounters[j] = inrec->fcounters[j] + inoutrec->fcounters[j];
         }
 
+        /* sum */
+        for(j=PNETCDF_VAR_F_NB_READ_TIME; j<=PNETCDF_VAR_F_NB_WRITE_TIME; j++)
+        {
+            tmp_var.fcounters[j] = inrec->fcounters[j] + inoutrec->fcounters[j];
+        }
+
         /* max (special case) */
         if(inrec->fcounters[PNETCDF_VAR_F_MAX_READ_TIME] >
             inoutrec->fcounters[PNETCDF_VAR_F_MAX_READ_TIME])
@@ -582,88 +882,6 @@ static void pnetcdf_var_record_reduction_op(void* inrec_v, void* inoutrec_v,
     return;
 }
 
-static void pnetcdf_var_shared_record_variance(
-    MPI_Comm mod_comm, struct darshan_pnetcdf_var *inrec_array,
-    struct darshan_pnetcdf_var *outrec_array, int shared_rec_count)
-{
-    MPI_Datatype var_dt;
-    MPI_Op var_op;
-    int i;
-    struct darshan_variance_dt *var_send_buf = NULL;
-    struct darshan_variance_dt *var_recv_buf = NULL;
-
-    PMPI_Type_contiguous(sizeof(struct darshan_variance_dt),
-        MPI_BYTE, &var_dt);
-    PMPI_Type_commit(&var_dt);
-
-    PMPI_Op_create(darshan_variance_reduce, 1, &var_op);
-
-    var_send_buf = malloc(shared_rec_count * sizeof(struct darshan_variance_dt));
-    if(!var_send_buf)
-        return;
-
-    if(my_rank == 0)
-    {
-        var_recv_buf = malloc(shared_rec_count * sizeof(struct darshan_variance_dt));
-
-        if(!var_recv_buf)
-            return;
-    }
-
-    /* get total i/o time variances for shared records */
-
-    for(i=0; i<shared_rec_count; i++)
-    {
-        var_send_buf[i].n = 1;
-        var_send_buf[i].S = 0;
-        var_send_buf[i].T = inrec_array[i].fcounters[PNETCDF_VAR_F_READ_TIME] +
-                            inrec_array[i].fcounters[PNETCDF_VAR_F_WRITE_TIME] +
-                            inrec_array[i].fcounters[PNETCDF_VAR_F_META_TIME];
-    }
-
-    PMPI_Reduce(var_send_buf, var_recv_buf, shared_rec_count,
-        var_dt, var_op, 0, mod_comm);
-
-    if(my_rank == 0)
-    {
-        for(i=0; i<shared_rec_count; i++)
-        {
-            outrec_array[i].fcounters[PNETCDF_VAR_F_VARIANCE_RANK_TIME] =
-                (var_recv_buf[i].S / var_recv_buf[i].n);
-        }
-    }
-
-    /* get total bytes moved variances for shared records */
-
-    for(i=0; i<shared_rec_count; i++)
-    {
-        var_send_buf[i].n = 1;
-        var_send_buf[i].S = 0;
-        var_send_buf[i].T = (double)
-                            inrec_array[i].counters[PNETCDF_VAR_BYTES_READ] +
-                            inrec_array[i].counters[PNETCDF_VAR_BYTES_WRITTEN];
-    }
-
-    PMPI_Reduce(var_send_buf, var_recv_buf, shared_rec_count,
-        var_dt, var_op, 0, mod_comm);
-
-    if(my_rank == 0)
-    {
-        for(i=0; i<shared_rec_count; i++)
-        {
-            outrec_array[i].fcounters[PNETCDF_VAR_F_VARIANCE_RANK_BYTES] =
-                (var_recv_buf[i].S / var_recv_buf[i].n);
-        }
-    }
-
-    PMPI_Type_free(&var_dt);
-    PMPI_Op_free(&var_op);
-    free(var_send_buf);
-    free(var_recv_buf);
-
-    return;
-}
-
 /***************************************************************************
  * Functions exported by PnetCDF module for coordinating with darshan-core *
  ***************************************************************************/
@@ -679,8 +897,7 @@ static void pnetcdf_file_mpi_redux(
     struct darshan_pnetcdf_file *pnetcdf_rec_buf = (struct darshan_pnetcdf_file *)pnetcdf_buf;
     struct darshan_pnetcdf_file *red_send_buf = NULL;
     struct darshan_pnetcdf_file *red_recv_buf = NULL;
-    MPI_Datatype red_type;
-    MPI_Op red_op;
+    int ret;
     int i;
 
     PNETCDF_LOCK();
@@ -718,21 +935,17 @@ static void pnetcdf_file_mpi_redux(
         }
     }
 
-    /* construct a datatype for a PnetCDF file record.  This is serving no
-     * purpose except to make sure we can do a reduction on proper boundaries
-     */
-    PMPI_Type_contiguous(sizeof(struct darshan_pnetcdf_file), MPI_BYTE, &red_type);
-    PMPI_Type_commit(&red_type);
-
-    /* register a PnetCDF file record reduction operator */
-    PMPI_Op_create(pnetcdf_file_record_reduction_op, 1, &red_op);
-
-    /* reduce shared PnetCDF file records */
-    PMPI_Reduce(red_send_buf, red_recv_buf,
-        shared_rec_count, red_type, red_op, 0, mod_comm);
+    /* reduce shared PNETCDF file records */
+    ret = darshan_shared_record_reduce(mod_comm, red_send_buf, red_recv_buf,
+        shared_rec_count, sizeof(struct darshan_pnetcdf_file),
+        pnetcdf_file_record_reduction_op, NULL, 0);
 
     /* update module state to account for shared file reduction */
-    if(my_rank == 0)
+    if(ret < 0)
+    {
+        free(red_recv_buf);
+    }
+    else if(my_rank == 0)
     {
         /* overwrite local shared records with globally reduced records */
         int tmp_ndx = rec_count - shared_rec_count;
@@ -746,9 +959,6 @@ static void pnetcdf_file_mpi_redux(
         pnetcdf_file_runtime->rec_count -= shared_rec_count;
     }
 
-    PMPI_Type_free(&red_type);
-    PMPI_Op_free(&red_op);
-
     PNETCDF_UNLOCK();
     return;
 }
@@ -765,8 +975,8 @@ static void pnetcdf_var_mpi_redux(
     double pnetcdf_time;
     struct darshan_pnetcdf_var *red_send_buf = NULL;
     struct darshan_pnetcdf_var *red_recv_buf = NULL;
-    MPI_Datatype red_type;
-    MPI_Op red_op;
+    double *var_vals = NULL;
+    int ret;
     int i;
 
     PNETCDF_LOCK();
@@ -818,40 +1028,51 @@ static void pnetcdf_var_mpi_redux(
      * array */
     red_send_buf = &(pnetcdf_rec_buf[rec_count-shared_rec_count]);
 
-    /* allocate memory for the reduction output on rank 0 */
+    /* allocate memory for the reduction output on rank 0, and for the
+     * time and byte totals whose variances are computed along with it
+     */
+    var_vals = malloc(shared_rec_count * 2 * sizeof(double));
     if(my_rank == 0)
-    {
         red_recv_buf = malloc(shared_rec_count * sizeof(struct darshan_pnetcdf_var));
-        if(!red_recv_buf)
-        {
-            PNETCDF_UNLOCK();
-            return;
-        }
+    if(!var_vals || (my_rank == 0 && !red_recv_buf))
+    {
+        free(var_vals);
+        free(red_recv_buf);
+        PNETCDF_UNLOCK();
+        return;
+    }
+    for(i = 0; i < shared_rec_count; i++)
+    {
+        var_vals[2*i] = red_send_buf[i].fcounters[PNETCDF_VAR_F_READ_TIME] +
+            red_send_buf[i].fcounters[PNETCDF_VAR_F_WRITE_TIME] +
+            red_send_buf[i].fcounters[PNETCDF_VAR_F_META_TIME];
+        var_vals[2*i+1] = (double)red_send_buf[i].counters[PNETCDF_VAR_BYTES_READ] +
+            red_send_buf[i].counters[PNETCDF_VAR_BYTES_WRITTEN];
     }
 
-    /* construct a datatype for a PNETCDF variable record.  This is serving no
-     * purpose except to make sure we can do a reduction on proper boundaries
+    /* reduce shared PNETCDF variable records, along with their time and byte
+     * variances
      */
-    PMPI_Type_contiguous(sizeof(struct darshan_pnetcdf_var),
-        MPI_BYTE, &red_type);
-    PMPI_Type_commit(&red_type);
-
-    /* register a PNETCDF variable record reduction operator */
-    PMPI_Op_create(pnetcdf_var_record_reduction_op, 1, &red_op);
-
-    /* reduce shared PNETCDF variable records */
-    PMPI_Reduce(red_send_buf, red_recv_buf,
-        shared_rec_count, red_type, red_op, 0, mod_comm);
-
-    /* get the time and byte variances for shared files */
-    pnetcdf_var_shared_record_variance(mod_comm, red_send_buf, red_recv_buf,
-        shared_rec_count);
+    ret = darshan_shared_record_reduce(mod_comm, red_send_buf, red_recv_buf,
+        shared_rec_count, sizeof(struct darshan_pnetcdf_var),
+        pnetcdf_var_record_reduction_op, var_vals, 2);
 
     /* update module state to account for shared file reduction */
-    if(my_rank == 0)
+    if(ret < 0)
+    {
+        free(red_recv_buf);
+    }
+    else if(my_rank == 0)
     {
         /* overwrite local shared records with globally reduced records */
         int tmp_ndx = rec_count - shared_rec_count;
+        for(i = 0; i < shared_rec_count; i++)
+        {
+            red_recv_buf[i].fcounters[PNETCDF_VAR_F_VARIANCE_RANK_TIME] =
+                var_vals[2*i];
+            red_recv_buf[i].fcounters[PNETCDF_VAR_F_VARIANCE_RANK_BYTES] =
+                var_vals[2*i+1];
+        }
         memcpy(&(pnetcdf_rec_buf[tmp_ndx]), red_recv_buf,
             shared_rec_count * sizeof(struct darshan_pnetcdf_var));
         free(red_recv_buf);
@@ -861,9 +1082,7 @@ static void pnetcdf_var_mpi_redux(
         /* drop shared records on non-zero ranks */
         pnetcdf_var_runtime->rec_count -= shared_rec_count;
     }
-
-    PMPI_Type_free(&red_type);
-    PMPI_Op_free(&red_op);
+    free(var_vals);
 
     PNETCDF_UNLOCK();
     return;
@@ -937,6 +1156,7 @@ static void pnetcdf_var_cleanup(void)
 
     /* cleanup internal structures used for instrumenting */
     darshan_clear_record_refs(&(pnetcdf_var_runtime->varid_hash), 0);
+    darshan_clear_record_refs(&(pnetcdf_var_runtime->nb_req_hash), 1);
     darshan_clear_record_refs(&(pnetcdf_var_runtime->rec_id_hash), 1);
 
     free(pnetcdf_var_runtime);
@@ -29,12 +29,20 @@
 #include <aio.h>
 #include <pthread.h>
 #include <limits.h>
+#include <signal.h>
+#ifdef HAVE_LINUX_AIO_ABI_H
+#include <linux/aio_abi.h>
+#endif
 
 #include "utlist.h"
 #include "darshan.h"
 #include "darshan-dynamic.h"
 #include "darshan-dxt.h"
 #include "darshan-heatmap.h"
+#include "darshan-batchio.h"
+#include "darshan-latency.h"
+#include "darshan-timeseries.h"
+#include "darshan-mmap.h"
 #include "darshan-ldms.h"
 
 #ifndef HAVE_OFF64_T
@@ -43,6 +51,9 @@ typedef int64_t off64_t;
 #ifndef HAVE_STRUCT_AIOCB64
 #define aiocb64 aiocb
 #endif
+#ifndef IORING_ENTER_GETEVENTS
+#define IORING_ENTER_GETEVENTS (1U << 0)
+#endif
 
 
 DARSHAN_FORWARD_DECL(open, int, (const char *path, int flags, ...));
@@ -95,6 +106,7 @@ DARSHAN_FORWARD_DECL(__fxstat64, int, (int vers, int fd, struct stat64 *buf));
 #ifdef DARSHAN_WRAP_MMAP
 DARSHAN_FORWARD_DECL(mmap, void*, (void *addr, size_t length, int prot, int flags, int fd, off_t offset));
 DARSHAN_FORWARD_DECL(mmap64, void*, (void *addr, size_t length, int prot, int flags, int fd, off64_t offset));
+DARSHAN_FORWARD_DECL(munmap, int, (void *addr, size_t length));
 #endif /* DARSHAN_WRAP_MMAP */
 DARSHAN_FORWARD_DECL(fsync, int, (int fd));
 DARSHAN_FORWARD_DECL(fdatasync, int, (int fd));
@@ -107,7 +119,27 @@ DARSHAN_FORWARD_DECL(aio_return, ssize_t, (struct aiocb *aiocbp));
 DARSHAN_FORWARD_DECL(aio_return64, ssize_t, (struct aiocb64 *aiocbp));
 DARSHAN_FORWARD_DECL(lio_listio, int, (int mode, struct aiocb *const aiocb_list[], int nitems, struct sigevent *sevp));
 DARSHAN_FORWARD_DECL(lio_listio64, int, (int mode, struct aiocb64 *const aiocb_list[], int nitems, struct sigevent *sevp));
+/* the libaio and liburing entry points are only wrapped when preloading,
+ * since wrapping them at link time would require every statically linked
+ * application to link both libraries
+ */
+#ifdef DARSHAN_PRELOAD
+#ifdef HAVE_LINUX_AIO_ABI_H
+DARSHAN_FORWARD_DECL(io_submit, int, (aio_context_t ctx, long nr, struct iocb **ios));
+DARSHAN_FORWARD_DECL(io_getevents, int, (aio_context_t ctx, long min_nr, long nr, struct io_event *events, struct timespec *timeout));
+#endif
+struct io_uring;
+struct io_uring_cqe;
+struct __kernel_timespec;
+DARSHAN_FORWARD_DECL(io_uring_enter, int, (unsigned int fd, unsigned int to_submit, unsigned int min_complete, unsigned int flags, sigset_t *sig));
+DARSHAN_FORWARD_DECL(io_uring_submit, int, (struct io_uring *ring));
+DARSHAN_FORWARD_DECL(io_uring_submit_and_wait, int, (struct io_uring *ring, unsigned wait_nr));
+DARSHAN_FORWARD_DECL(io_uring_wait_cqes, int, (struct io_uring *ring, struct io_uring_cqe **cqe_ptr, unsigned wait_nr, struct __kernel_timespec *ts, sigset_t *sigmask));
+DARSHAN_FORWARD_DECL(__io_uring_get_cqe, int, (struct io_uring *ring, struct io_uring_cqe **cqe_ptr, unsigned submit, unsigned wait_nr, sigset_t *sigmask));
+#endif
 DARSHAN_FORWARD_DECL(rename, int, (const char *oldpath, const char *newpath));
+DARSHAN_FORWARD_DECL(chdir, int, (const char *path));
+DARSHAN_FORWARD_DECL(fchdir, int, (int fd));
 
 /* The posix_file_record_ref structure maintains necessary runtime metadata
  * for the POSIX file record (darshan_posix_file structure, defined in
@@ -123,13 +155,15 @@ DARSHAN_FORWARD_DECL(rename, int, (const char *oldpath, const char *newpath));
  * (i.e., the mapping between posix_file_record_ref structs to darshan_posix_file
  * structs is one-to-one).
  *
- * NOTE: we use the 'darshan_record_ref' interface (in darshan-common) to
- * associate different types of handles with this posix_file_record_ref struct.
- * This allows us to index this struct (and the underlying file record) by using
- * either the corresponding Darshan record identifier (derived from the filename)
- * or by a generated file descriptor, for instance. Note that, while there should
- * only be a single Darshan record identifier that indexes a posix_file_record_ref,
- * there could be multiple open file descriptors that index it.
+ * NOTE: we use the 'darshan_record_ref' and 'darshan_fd_ref' interfaces (in
+ * darshan-common) to associate different types of handles with this
+ * posix_file_record_ref struct. This allows us to index this struct (and the
+ * underlying file record) by using either the corresponding Darshan record
+ * identifier (derived from the filename) or by a file descriptor, for instance.
+ * The fd table is directly indexed by descriptor, so lookups on the
+ * read/write paths avoid hashing. Note that, while there should only be a
+ * single Darshan record identifier that indexes a posix_file_record_ref, there
+ * could be multiple open file descriptors that index it.
  */
 struct posix_file_record_ref
 {
@@ -147,6 +181,8 @@ struct posix_file_record_ref
     int stride_count;
     struct posix_aio_tracker* aio_list;
     int fs_type; /* same as darshan_fs_info->fs_type */
+    int retired; /* record staged with darshan_core_retire_records() */
+    uint64_t open_scan; /* last retirement scan that found it open */
 #ifdef HAVE_LDMS
     int64_t close_counts;
 #endif
@@ -159,10 +195,59 @@ struct posix_file_record_ref
 struct posix_runtime
 {
     void *rec_id_hash;
-    void *fd_hash;
+    void *fd_table;
+    void *arena;
     int file_rec_count;
     darshan_record_id heatmap_id;
     int frozen; /* flag to indicate that the counters should no longer be modified */
+    int shards_merged; /* flag to indicate that no new thread shards may be created */
+    /* background retirement of the records of closed files */
+    double retire_time;
+    uint64_t retire_scan;
+    pthread_t retirer;
+    pthread_cond_t retirer_cond;
+    pid_t retirer_pid;
+    int retirer_running;
+    int retirer_stop;
+};
+
+/* number of records retired (and compressed) together */
+#define POSIX_RETIRE_BATCH 128
+
+/* The posix_thread_shard structure holds a single thread's private view of
+ * the POSIX records touched by positional data operations (pread, pwrite,
+ * preadv, pwritev, and their variants) when thread sharding is enabled.
+ *
+ * RATIONALE: positional operations carry their own file offset, so the only
+ * shared state they need is the fd -> record mapping. Each thread caches that
+ * mapping in its own 'fd_table' and accumulates counters into thread-private
+ * posix_file_record_ref structs (indexed by record id in 'rec_id_hash'), taking
+ * only its own uncontended shard mutex rather than the module-wide lock.
+ * Shards are folded into the global records at shutdown, before any MPI
+ * reduction, using the same merge logic as the shared record reduction.
+ *
+ * NOTE: operations that depend on or modify the implicit file offset (read,
+ * write, lseek, etc.) and all metadata operations continue to use the global
+ * records under the module lock.
+ */
+struct posix_thread_shard
+{
+    pthread_mutex_t mutex;
+    void *rec_id_hash;
+    void *fd_table;
+    int active; /* flag to indicate the owning thread is recording into the shard */
+    int frozen; /* flag to indicate the shard has been merged */
+    struct posix_thread_shard *next;
+};
+
+/* cached fd -> thread-private record mapping, which is only valid as long as
+ * 'fd_epoch' matches the global epoch (bumped whenever a tracked fd is closed
+ * or remapped to a different record)
+ */
+struct posix_shard_fd_ref
+{
+    struct posix_file_record_ref *rec_ref;
+    uint64_t fd_epoch;
 };
 
 /* struct to track information about aio operations in flight */
@@ -183,12 +268,25 @@ static struct posix_aio_tracker* posix_aio_tracker_del(
     int fd, void *aiocbp);
 static void posix_finalize_file_records(
     void *rec_ref_p, void *user_ptr);
+static int posix_thread_shard_enter(
+    void);
+static int posix_thread_shard_exit(
+    void);
+static struct posix_file_record_ref *posix_lookup_io_rec_ref(
+    int fd);
+static void posix_merge_thread_shards(
+    void);
+static void posix_start_retirer(
+    void);
+static void posix_stop_retirer(
+    void);
+static void *posix_retirer_main(
+    void *arg);
+static void posix_record_merge(
+    struct darshan_posix_file *infile, struct darshan_posix_file *inoutfile);
 #ifdef HAVE_MPI
 static void posix_record_reduction_op(
     void* infile_v, void* inoutfile_v, int *len, MPI_Datatype *datatype);
-static void posix_shared_record_variance(
-    MPI_Comm mod_comm, struct darshan_posix_file *inrec_array,
-    struct darshan_posix_file *outrec_array, int shared_rec_count);
 static void posix_mpi_redux(
     void *posix_buf, MPI_Comm mod_comm,
     darshan_record_id *shared_recs, int shared_rec_count);
@@ -199,7 +297,8 @@ static void posix_cleanup(
     void);
 
 /* extern function def for querying record name from a STDIO stream */
-extern char *darshan_stdio_lookup_record_name(FILE *stream);
+extern int darshan_stdio_lookup_record_name(FILE *stream, char *rec_name,
+    size_t len);
 
 static struct posix_runtime *posix_runtime = NULL;
 static pthread_mutex_t posix_runtime_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
@@ -207,11 +306,123 @@ static int posix_runtime_init_attempted = 0;
 static int my_rank = -1;
 static int darshan_mem_alignment = 1;
 
+/* thread shard state is kept outside of posix_runtime, as threads may hold
+ * references to their shard across module cleanup and reinitialization
+ */
+static int posix_thread_shards = 0;
+static int posix_shard_key_created = 0;
+static pthread_key_t posix_shard_key;
+static struct posix_thread_shard *posix_shard_list = NULL;
+static atomic_uint_fast64_t posix_fd_epoch = 0;
+
+/* bitmap of descriptors known not to refer to a tracked record (excluded
+ * paths, sockets, pipes, etc.), so that operations on them skip timing and
+ * locking altogether. Bits are only set and cleared under the module lock:
+ * set when an open is not tracked or an operation misses in 'fd_table', and
+ * cleared whenever a record is mapped to the descriptor.
+ */
+#define POSIX_UNTRACKED_FD_MAX 65536
+static atomic_uint_fast64_t posix_untracked_fds[POSIX_UNTRACKED_FD_MAX / 64];
+
+static inline int posix_fd_untracked(int fd)
+{
+    if(fd < 0 || fd >= POSIX_UNTRACKED_FD_MAX)
+        return(0);
+    return((atomic_load_explicit(&posix_untracked_fds[fd / 64],
+        memory_order_relaxed) >> (fd % 64)) & 1);
+}
+
+static inline void posix_fd_set_untracked(int fd, int untracked)
+{
+    uint64_t bit;
+
+    if(fd < 0 || fd >= POSIX_UNTRACKED_FD_MAX)
+        return;
+    bit = 1ULL << (fd % 64);
+    if(untracked)
+        atomic_fetch_or_explicit(&posix_untracked_fds[fd / 64], bit,
+            memory_order_relaxed);
+    else if(atomic_load_explicit(&posix_untracked_fds[fd / 64],
+        memory_order_relaxed) & bit)
+        atomic_fetch_and_explicit(&posix_untracked_fds[fd / 64], ~bit,
+            memory_order_relaxed);
+    return;
+}
+
+/* sampling of data operations: only about one in every 'posix_sample_rate'
+ * reads and writes (chosen per thread, at randomized intervals so that
+ * periodic access patterns are not aliased) is timed and passed to common
+ * value tracking, DXT, LDMS, and the heatmap, LATENCY and TIMESERIES
+ * modules, with results scaled by the rate.  Operation, byte and other
+ * cheap counters are always exact.
+ */
+static size_t posix_sample_rate = 1;
+static __thread uint32_t posix_sample_countdown = 0;
+static __thread uint32_t posix_sample_seed = 0;
+
+/* returns 0 if the calling thread's next data operation is not sampled,
+ * and otherwise the number of operations that it stands for
+ */
+static inline int posix_sample(void)
+{
+    uint32_t x;
+
+    if(posix_sample_rate <= 1)
+        return(1);
+    if(posix_sample_countdown > 1)
+    {
+        posix_sample_countdown--;
+        return(0);
+    }
+
+    /* xorshift32 */
+    x = posix_sample_seed;
+    if(!x)
+        x = (uint32_t)(uintptr_t)&posix_sample_seed | 1;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    posix_sample_seed = x;
+    posix_sample_countdown = 1 + (x % (2 * posix_sample_rate - 1));
+
+    return((int)posix_sample_rate);
+}
+
 #define POSIX_LOCK() pthread_mutex_lock(&posix_runtime_mutex)
 #define POSIX_UNLOCK() pthread_mutex_unlock(&posix_runtime_mutex)
 
+/* looks up the record of 'rec_id' for updating, reviving it first if it
+ * was retired; called with the module lock held
+ */
+static inline struct posix_file_record_ref *posix_lookup_rec_ref(
+    darshan_record_id rec_id)
+{
+    struct posix_file_record_ref *rec_ref;
+
+    rec_ref = darshan_lookup_record_ref(posix_runtime->rec_id_hash,
+        &rec_id, sizeof(darshan_record_id));
+    if(rec_ref && rec_ref->retired)
+    {
+        darshan_core_revive_record(DARSHAN_POSIX_MOD, rec_id);
+        rec_ref->retired = 0;
+    }
+
+    return(rec_ref);
+}
+
 #define POSIX_WTIME() \
-    __darshan_disabled ? 0 : darshan_core_wtime();
+    __darshan_disabled ? 0 : (darshan_layer_wtime_other(), darshan_core_wtime());
+
+/* data operations are the lowest layer of layered I/O, so they take their
+ * start time from an enclosing pass-through call (e.g., an independent
+ * MPI-IO or STDIO write) if there is one, and hand it their end time
+ */
+#define POSIX_SAMPLED_WTIME_START(__weight) \
+    (__darshan_disabled ? 0 : (__weight) ? darshan_layer_wtime_start() : \
+        (darshan_layer_wtime_other(), 0))
+
+#define POSIX_SAMPLED_WTIME_END(__weight) \
+    ((__weight) && !__darshan_disabled ? darshan_layer_wtime_end() : 0)
 
 /* note that if the break condition is triggered in this macro, then it
  * will exit the do/while loop holding a lock that will be released in
@@ -219,6 +430,7 @@ static int darshan_mem_alignment = 1;
  * return immediately without reaching the POST_RECORD() macro.
  */
 #define POSIX_PRE_RECORD() do { \
+    DARSHAN_OVERHEAD_ENTER(); \
     if(!__darshan_disabled) { \
         POSIX_LOCK(); \
         if(!posix_runtime && !posix_runtime_init_attempted) \
@@ -231,28 +443,55 @@ static int darshan_mem_alignment = 1;
 
 #define POSIX_POST_RECORD() do { \
     POSIX_UNLOCK(); \
+    DARSHAN_OVERHEAD_EXIT(DARSHAN_POSIX_MOD); \
+} while(0)
+
+/* returns the result of '__call' straight away if '__fd' is known not to
+ * refer to a tracked record
+ */
+#define POSIX_UNTRACKED_FD_PASSTHRU(__fd, __call) do { \
+    if(posix_fd_untracked(__fd)) return(__call); \
+} while(0)
+
+/* variants of the above macros for positional data operations, which record
+ * into the calling thread's private shard (holding only the shard mutex) if
+ * thread sharding is enabled, and otherwise fall back to the global records
+ */
+#define POSIX_PRE_RECORD_IO() do { \
+    DARSHAN_OVERHEAD_ENTER(); \
+    if(!__darshan_disabled && posix_thread_shards && \
+        posix_thread_shard_enter()) break; \
+    POSIX_PRE_RECORD(); \
+} while(0)
+
+#define POSIX_POST_RECORD_IO() do { \
+    if(!posix_thread_shards || !posix_thread_shard_exit()) \
+        POSIX_UNLOCK(); \
+    DARSHAN_OVERHEAD_EXIT(DARSHAN_POSIX_MOD); \
 } while(0)
 
 #define POSIX_RECORD_OPEN(__ret, __path, __mode, __tm1, __tm2) do { \
     darshan_record_id __rec_id; \
     struct posix_file_record_ref *__rec_ref; \
+    char __pathbuf[__DARSHAN_PATH_MAX]; \
     char *__newpath; \
     if(__ret < 0) break; \
-    __newpath = darshan_clean_file_path(__path); \
-    if(!__newpath) __newpath = (char *)__path; \
-    __rec_id = darshan_core_gen_record_id(__newpath); \
-    __rec_ref = darshan_lookup_record_ref(posix_runtime->rec_id_hash, &__rec_id, sizeof(darshan_record_id)); \
-    if(!__rec_ref) __rec_ref = posix_track_new_file_record(__rec_id, __newpath); \
+    __rec_id = darshan_path_record_id(__path, __pathbuf, sizeof(__pathbuf), &__newpath); \
+    __rec_ref = posix_lookup_rec_ref(__rec_id); \
+    if(!__rec_ref) { \
+        if(!__newpath) __newpath = darshan_clean_file_path_buf(__path, __pathbuf, sizeof(__pathbuf)); \
+        if(!__newpath) __newpath = (char *)__path; \
+        __rec_ref = posix_track_new_file_record(__rec_id, __newpath); \
+    } \
     if(!__rec_ref) { \
-        if(__newpath != __path) free(__newpath); \
+        posix_fd_set_untracked(__ret, 1); \
         break; \
     } \
     _POSIX_RECORD_OPEN(__ret, __rec_ref, __mode, __tm1, __tm2, 1, -1); \
-    if(__newpath != __path) free(__newpath); \
+    darshan_instrument_fs_open(__rec_ref->fs_type, __rec_id, __ret); \
     /* LDMS to publish realtime open tracing information to daemon*/ \
-    if(dC.ldms_lib)\
-        if(dC.posix_enable_ldms)\
-            darshan_ldms_connector_send(__rec_ref->file_rec->base_rec.id, __rec_ref->file_rec->base_rec.rank, __rec_ref->file_rec->counters[POSIX_OPENS], "open", -1, -1, -1, -1, -1, __tm1, __tm2, __rec_ref->file_rec->fcounters[POSIX_F_META_TIME], "POSIX", "MET");\
+    if(DARSHAN_LDMS_ENABLED(posix))\
+        darshan_ldms_connector_send(__rec_ref->file_rec->base_rec.id, __rec_ref->file_rec->base_rec.rank, __rec_ref->file_rec->counters[POSIX_OPENS], "open", -1, -1, -1, -1, -1, __tm1, __tm2, __rec_ref->file_rec->fcounters[POSIX_F_META_TIME], "POSIX", "MET");\
 } while(0)
 
 #define POSIX_RECORD_REFOPEN(__ret, __rec_ref, __tm1, __tm2, __ref_counter) do { \
@@ -275,10 +514,18 @@ static int darshan_mem_alignment = 1;
     __rec_ref->file_rec->fcounters[POSIX_F_OPEN_END_TIMESTAMP] = __tm2; \
     DARSHAN_TIMER_INC_NO_OVERLAP(__rec_ref->file_rec->fcounters[POSIX_F_META_TIME], \
         __tm1, __tm2, __rec_ref->last_meta_end); \
-    darshan_add_record_ref(&(posix_runtime->fd_hash), &__ret, sizeof(int), __rec_ref); \
+    HEATMAP_UPDATE_META(posix_runtime->heatmap_id, __tm1, __tm2); \
+    LATENCY_RECORD(__rec_ref->file_rec->base_rec.id, LATENCY_OP_POSIX_META, \
+        __tm1, __tm2); \
+    TIMESERIES_RECORD(TIMESERIES_API_POSIX, TIMESERIES_OP_META, 0, __tm1, __tm2); \
+    if(posix_thread_shards && \
+        darshan_lookup_fd_ref(posix_runtime->fd_table, __ret)) \
+        atomic_fetch_add(&posix_fd_epoch, 1); \
+    darshan_add_fd_ref(&(posix_runtime->fd_table), __ret, __rec_ref); \
+    posix_fd_set_untracked(__ret, 0); \
 } while(0)
 
-#define POSIX_RECORD_READ(__ret, __fd, __pread_flag, __pread_offset, __aligned, __tm1, __tm2) do { \
+#define POSIX_RECORD_READ(__ret, __fd, __pread_flag, __pread_offset, __aligned, __tm1, __tm2, __weight) do { \
     struct posix_file_record_ref* rec_ref; \
     int64_t stride; \
     int64_t this_offset; \
@@ -286,20 +533,19 @@ static int darshan_mem_alignment = 1;
     struct darshan_common_val_counter *cvc; \
     double __elapsed = __tm2-__tm1; \
     if(__ret < 0) break; \
-    rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash, &(__fd), sizeof(int)); \
+    rec_ref = posix_lookup_io_rec_ref(__fd); \
     if(!rec_ref) break; \
     if(__pread_flag) \
         this_offset = __pread_offset; \
     else \
         this_offset = rec_ref->offset; \
-    /* DXT to record detailed read tracing information */ \
-    dxt_posix_read(rec_ref->file_rec->base_rec.id, this_offset, __ret, __tm1, __tm2); \
-    /* heatmap to record traffic summary */ \
-    heatmap_update(posix_runtime->heatmap_id, HEATMAP_READ, __ret, __tm1, __tm2); \
+    /* file system modules to record traffic to storage targets */ \
+    darshan_instrument_fs_io(rec_ref->fs_type, rec_ref->file_rec->base_rec.id, \
+        this_offset, __ret, DARSHAN_IO_READ); \
     if(this_offset > rec_ref->last_byte_read) \
-        rec_ref->file_rec->counters[POSIX_SEQ_READS] += 1;  \
+        rec_ref->file_rec->counters[POSIX_SEQ_READS] += 1; \
     if(this_offset == (rec_ref->last_byte_read + 1)) \
-        rec_ref->file_rec->counters[POSIX_CONSEC_READS] += 1;  \
+        rec_ref->file_rec->counters[POSIX_CONSEC_READS] += 1; \
     if(this_offset > 0 && this_offset > rec_ref->last_byte_read \
         && rec_ref->last_byte_read != 0) \
         stride = this_offset - rec_ref->last_byte_read - 1; \
@@ -312,26 +558,40 @@ static int darshan_mem_alignment = 1;
     rec_ref->file_rec->counters[POSIX_BYTES_READ] += __ret; \
     rec_ref->file_rec->counters[POSIX_READS] += 1; \
     DARSHAN_BUCKET_INC(&(rec_ref->file_rec->counters[POSIX_SIZE_READ_0_100]), __ret); \
+    if(!__aligned) \
+        rec_ref->file_rec->counters[POSIX_MEM_NOT_ALIGNED] += 1; \
+    file_alignment = rec_ref->file_rec->counters[POSIX_FILE_ALIGNMENT]; \
+    if(file_alignment > 0 && (this_offset % file_alignment) != 0) \
+        rec_ref->file_rec->counters[POSIX_FILE_NOT_ALIGNED] += 1; \
+    if(rec_ref->last_io_type == DARSHAN_IO_WRITE) \
+        rec_ref->file_rec->counters[POSIX_RW_SWITCHES] += 1; \
+    rec_ref->last_io_type = DARSHAN_IO_READ; \
+    /* the rest is only done for sampled operations, scaled by the number \
+     * of operations that each stands for */ \
+    if(!(__weight)) break; \
+    /* DXT to record detailed read tracing information */ \
+    DXT_RECORD(posix, read, rec_ref->file_rec->base_rec.id, this_offset, __ret, __tm1, __tm2); \
+    /* heatmap to record traffic summary */ \
+    HEATMAP_UPDATE(posix_runtime->heatmap_id, HEATMAP_READ, \
+        __ret * (__weight), __tm1, __tm2); \
+    /* LATENCY to record the latency distribution */ \
+    LATENCY_RECORD(rec_ref->file_rec->base_rec.id, LATENCY_OP_POSIX_READ, \
+        __tm1, __tm2); \
+    /* TIMESERIES to record the job's activity over time */ \
+    TIMESERIES_RECORD_N(TIMESERIES_API_POSIX, TIMESERIES_OP_READ, __weight, \
+        __ret * (__weight), __elapsed * (__weight), __tm2); \
     cvc = darshan_track_common_val_counters(&rec_ref->access_root, &__ret, 1, \
         &rec_ref->access_count); \
     if(cvc) DARSHAN_UPDATE_COMMON_VAL_COUNTERS( \
         &(rec_ref->file_rec->counters[POSIX_ACCESS1_ACCESS]), \
         &(rec_ref->file_rec->counters[POSIX_ACCESS1_COUNT]), \
-        cvc->vals, 1, cvc->freq, 0); \
+        cvc->vals, 1, cvc->freq * (__weight), 0); \
     cvc = darshan_track_common_val_counters(&rec_ref->stride_root, &stride, 1, \
         &rec_ref->stride_count); \
     if(cvc) DARSHAN_UPDATE_COMMON_VAL_COUNTERS( \
         &(rec_ref->file_rec->counters[POSIX_STRIDE1_STRIDE]), \
         &(rec_ref->file_rec->counters[POSIX_STRIDE1_COUNT]), \
-        cvc->vals, 1, cvc->freq, 0); \
-    if(!__aligned) \
-        rec_ref->file_rec->counters[POSIX_MEM_NOT_ALIGNED] += 1; \
-    file_alignment = rec_ref->file_rec->counters[POSIX_FILE_ALIGNMENT]; \
-    if(file_alignment > 0 && (this_offset % file_alignment) != 0) \
-        rec_ref->file_rec->counters[POSIX_FILE_NOT_ALIGNED] += 1; \
-    if(rec_ref->last_io_type == DARSHAN_IO_WRITE) \
-        rec_ref->file_rec->counters[POSIX_RW_SWITCHES] += 1; \
-    rec_ref->last_io_type = DARSHAN_IO_READ; \
+        cvc->vals, 1, cvc->freq * (__weight), 0); \
     if(rec_ref->file_rec->fcounters[POSIX_F_READ_START_TIMESTAMP] == 0 || \
      rec_ref->file_rec->fcounters[POSIX_F_READ_START_TIMESTAMP] > __tm1) \
         rec_ref->file_rec->fcounters[POSIX_F_READ_START_TIMESTAMP] = __tm1; \
@@ -339,15 +599,14 @@ static int darshan_mem_alignment = 1;
     if(rec_ref->file_rec->fcounters[POSIX_F_MAX_READ_TIME] < __elapsed) { \
         rec_ref->file_rec->fcounters[POSIX_F_MAX_READ_TIME] = __elapsed; \
         rec_ref->file_rec->counters[POSIX_MAX_READ_TIME_SIZE] = __ret; } \
-    DARSHAN_TIMER_INC_NO_OVERLAP(rec_ref->file_rec->fcounters[POSIX_F_READ_TIME], \
-        __tm1, __tm2, rec_ref->last_read_end); \
+    DARSHAN_TIMER_INC_NO_OVERLAP_SCALED(rec_ref->file_rec->fcounters[POSIX_F_READ_TIME], \
+        __tm1, __tm2, rec_ref->last_read_end, __weight); \
     /* LDMS to publish realtime read tracing information to daemon*/ \
-    if(dC.ldms_lib)\
-        if(dC.posix_enable_ldms)\
-            darshan_ldms_connector_send(rec_ref->file_rec->base_rec.id, rec_ref->file_rec->base_rec.rank, rec_ref->file_rec->counters[POSIX_READS], "read", this_offset, __ret, rec_ref->file_rec->counters[POSIX_MAX_BYTE_READ],rec_ref->file_rec->counters[POSIX_RW_SWITCHES], -1,  __tm1, __tm2, rec_ref->file_rec->fcounters[POSIX_F_READ_TIME], "POSIX", "MOD");\
+    if(DARSHAN_LDMS_ENABLED(posix))\
+        darshan_ldms_connector_send(rec_ref->file_rec->base_rec.id, rec_ref->file_rec->base_rec.rank, rec_ref->file_rec->counters[POSIX_READS], "read", this_offset, __ret, rec_ref->file_rec->counters[POSIX_MAX_BYTE_READ],rec_ref->file_rec->counters[POSIX_RW_SWITCHES], -1,  __tm1, __tm2, rec_ref->file_rec->fcounters[POSIX_F_READ_TIME], "POSIX", "MOD");\
 } while(0)
 
-#define POSIX_RECORD_WRITE(__ret, __fd, __pwrite_flag, __pwrite_offset, __aligned, __tm1, __tm2) do { \
+#define POSIX_RECORD_WRITE(__ret, __fd, __pwrite_flag, __pwrite_offset, __aligned, __tm1, __tm2, __weight) do { \
     struct posix_file_record_ref* rec_ref; \
     int64_t stride; \
     int64_t this_offset; \
@@ -355,16 +614,15 @@ static int darshan_mem_alignment = 1;
     struct darshan_common_val_counter *cvc; \
     double __elapsed = __tm2-__tm1; \
     if(__ret < 0) break; \
-    rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash, &__fd, sizeof(int)); \
+    rec_ref = posix_lookup_io_rec_ref(__fd); \
     if(!rec_ref) break; \
     if(__pwrite_flag) \
         this_offset = __pwrite_offset; \
     else \
         this_offset = rec_ref->offset; \
-    /* DXT to record detailed write tracing information */ \
-    dxt_posix_write(rec_ref->file_rec->base_rec.id, this_offset, __ret, __tm1, __tm2); \
-    /* heatmap to record traffic summary */ \
-    heatmap_update(posix_runtime->heatmap_id, HEATMAP_WRITE, __ret, __tm1, __tm2); \
+    /* file system modules to record traffic to storage targets */ \
+    darshan_instrument_fs_io(rec_ref->fs_type, rec_ref->file_rec->base_rec.id, \
+        this_offset, __ret, DARSHAN_IO_WRITE); \
     if(this_offset > rec_ref->last_byte_written) \
         rec_ref->file_rec->counters[POSIX_SEQ_WRITES] += 1; \
     if(this_offset == (rec_ref->last_byte_written + 1)) \
@@ -381,26 +639,40 @@ static int darshan_mem_alignment = 1;
     rec_ref->file_rec->counters[POSIX_BYTES_WRITTEN] += __ret; \
     rec_ref->file_rec->counters[POSIX_WRITES] += 1; \
     DARSHAN_BUCKET_INC(&(rec_ref->file_rec->counters[POSIX_SIZE_WRITE_0_100]), __ret); \
+    if(!__aligned) \
+        rec_ref->file_rec->counters[POSIX_MEM_NOT_ALIGNED] += 1; \
+    file_alignment = rec_ref->file_rec->counters[POSIX_FILE_ALIGNMENT]; \
+    if(file_alignment > 0 && (this_offset % file_alignment) != 0) \
+        rec_ref->file_rec->counters[POSIX_FILE_NOT_ALIGNED] += 1; \
+    if(rec_ref->last_io_type == DARSHAN_IO_READ) \
+        rec_ref->file_rec->counters[POSIX_RW_SWITCHES] += 1; \
+    rec_ref->last_io_type = DARSHAN_IO_WRITE; \
+    /* the rest is only done for sampled operations, scaled by the number \
+     * of operations that each stands for */ \
+    if(!(__weight)) break; \
+    /* DXT to record detailed write tracing information */ \
+    DXT_RECORD(posix, write, rec_ref->file_rec->base_rec.id, this_offset, __ret, __tm1, __tm2); \
+    /* heatmap to record traffic summary */ \
+    HEATMAP_UPDATE(posix_runtime->heatmap_id, HEATMAP_WRITE, \
+        __ret * (__weight), __tm1, __tm2); \
+    /* LATENCY to record the latency distribution */ \
+    LATENCY_RECORD(rec_ref->file_rec->base_rec.id, LATENCY_OP_POSIX_WRITE, \
+        __tm1, __tm2); \
+    /* TIMESERIES to record the job's activity over time */ \
+    TIMESERIES_RECORD_N(TIMESERIES_API_POSIX, TIMESERIES_OP_WRITE, __weight, \
+        __ret * (__weight), __elapsed * (__weight), __tm2); \
     cvc = darshan_track_common_val_counters(&rec_ref->access_root, &__ret, 1, \
         &rec_ref->access_count); \
     if(cvc) DARSHAN_UPDATE_COMMON_VAL_COUNTERS( \
         &(rec_ref->file_rec->counters[POSIX_ACCESS1_ACCESS]), \
         &(rec_ref->file_rec->counters[POSIX_ACCESS1_COUNT]), \
-        cvc->vals, 1, cvc->freq, 0); \
+        cvc->vals, 1, cvc->freq * (__weight), 0); \
     cvc = darshan_track_common_val_counters(&rec_ref->stride_root, &stride, 1, \
         &rec_ref->stride_count); \
     if(cvc) DARSHAN_UPDATE_COMMON_VAL_COUNTERS( \
         &(rec_ref->file_rec->counters[POSIX_STRIDE1_STRIDE]), \
         &(rec_ref->file_rec->counters[POSIX_STRIDE1_COUNT]), \
-        cvc->vals, 1, cvc->freq, 0); \
-    if(!__aligned) \
-        rec_ref->file_rec->counters[POSIX_MEM_NOT_ALIGNED] += 1; \
-    file_alignment = rec_ref->file_rec->counters[POSIX_FILE_ALIGNMENT]; \
-    if(file_alignment > 0 && (this_offset % file_alignment) != 0) \
-        rec_ref->file_rec->counters[POSIX_FILE_NOT_ALIGNED] += 1; \
-    if(rec_ref->last_io_type == DARSHAN_IO_READ) \
-        rec_ref->file_rec->counters[POSIX_RW_SWITCHES] += 1; \
-    rec_ref->last_io_type = DARSHAN_IO_WRITE; \
+        cvc->vals, 1, cvc->freq * (__weight), 0); \
     if(rec_ref->file_rec->fcounters[POSIX_F_WRITE_START_TIMESTAMP] == 0 || \
      rec_ref->file_rec->fcounters[POSIX_F_WRITE_START_TIMESTAMP] > __tm1) \
         rec_ref->file_rec->fcounters[POSIX_F_WRITE_START_TIMESTAMP] = __tm1; \
@@ -408,23 +680,34 @@ static int darshan_mem_alignment = 1;
     if(rec_ref->file_rec->fcounters[POSIX_F_MAX_WRITE_TIME] < __elapsed) { \
         rec_ref->file_rec->fcounters[POSIX_F_MAX_WRITE_TIME] = __elapsed; \
         rec_ref->file_rec->counters[POSIX_MAX_WRITE_TIME_SIZE] = __ret; } \
-    DARSHAN_TIMER_INC_NO_OVERLAP(rec_ref->file_rec->fcounters[POSIX_F_WRITE_TIME], \
-        __tm1, __tm2, rec_ref->last_write_end); \
+    DARSHAN_TIMER_INC_NO_OVERLAP_SCALED(rec_ref->file_rec->fcounters[POSIX_F_WRITE_TIME], \
+        __tm1, __tm2, rec_ref->last_write_end, __weight); \
     /* LDMS to publish realtime write tracing information to daemon*/ \
-    if(dC.ldms_lib)\
-        if(dC.posix_enable_ldms)\
-            darshan_ldms_connector_send(rec_ref->file_rec->base_rec.id, rec_ref->file_rec->base_rec.rank, rec_ref->file_rec->counters[POSIX_WRITES], "write", this_offset, __ret, rec_ref->file_rec->counters[POSIX_MAX_BYTE_WRITTEN], rec_ref->file_rec->counters[POSIX_RW_SWITCHES], -1, __tm1, __tm2, rec_ref->file_rec->fcounters[POSIX_F_WRITE_TIME], "POSIX", "MOD");\
+    if(DARSHAN_LDMS_ENABLED(posix))\
+        darshan_ldms_connector_send(rec_ref->file_rec->base_rec.id, rec_ref->file_rec->base_rec.rank, rec_ref->file_rec->counters[POSIX_WRITES], "write", this_offset, __ret, rec_ref->file_rec->counters[POSIX_MAX_BYTE_WRITTEN], rec_ref->file_rec->counters[POSIX_RW_SWITCHES], -1, __tm1, __tm2, rec_ref->file_rec->fcounters[POSIX_F_WRITE_TIME], "POSIX", "MOD");\
+} while(0)
+
+/* BATCHIO to record the iovec count of a vectored read or write */
+#define POSIX_RECORD_VECTOR(__ret, __fd, __rw_flag, __iovcnt) do { \
+    struct posix_file_record_ref* rec_ref; \
+    if(__ret < 0) break; \
+    rec_ref = posix_lookup_io_rec_ref(__fd); \
+    if(!rec_ref) break; \
+    batchio_vector(rec_ref->file_rec->base_rec.id, __rw_flag, __iovcnt); \
 } while(0)
 
 #define POSIX_LOOKUP_RECORD_STAT(__path, __statbuf, __tm1, __tm2) do { \
     darshan_record_id rec_id; \
     struct posix_file_record_ref* rec_ref; \
-    char *newpath = darshan_clean_file_path(__path); \
-    if(!newpath) newpath = (char *)__path; \
-    rec_id = darshan_core_gen_record_id(newpath); \
-    rec_ref = darshan_lookup_record_ref(posix_runtime->rec_id_hash, &rec_id, sizeof(darshan_record_id)); \
-    if(!rec_ref) rec_ref = posix_track_new_file_record(rec_id, newpath); \
-    if(newpath != __path) free(newpath); \
+    char pathbuf[__DARSHAN_PATH_MAX]; \
+    char *newpath; \
+    rec_id = darshan_path_record_id(__path, pathbuf, sizeof(pathbuf), &newpath); \
+    rec_ref = posix_lookup_rec_ref(rec_id); \
+    if(!rec_ref) { \
+        if(!newpath) newpath = darshan_clean_file_path_buf(__path, pathbuf, sizeof(pathbuf)); \
+        if(!newpath) newpath = (char *)__path; \
+        rec_ref = posix_track_new_file_record(rec_id, newpath); \
+    } \
     if(rec_ref) { \
         POSIX_RECORD_STAT(rec_ref, __statbuf, __tm1, __tm2); \
     } \
@@ -434,6 +717,10 @@ static int darshan_mem_alignment = 1;
     (__rec_ref)->file_rec->counters[POSIX_STATS] += 1; \
     DARSHAN_TIMER_INC_NO_OVERLAP((__rec_ref)->file_rec->fcounters[POSIX_F_META_TIME], \
         __tm1, __tm2, (__rec_ref)->last_meta_end); \
+    HEATMAP_UPDATE_META(posix_runtime->heatmap_id, __tm1, __tm2); \
+    LATENCY_RECORD((__rec_ref)->file_rec->base_rec.id, LATENCY_OP_POSIX_META, \
+        __tm1, __tm2); \
+    TIMESERIES_RECORD(TIMESERIES_API_POSIX, TIMESERIES_OP_META, 0, __tm1, __tm2); \
 } while(0)
 
 
@@ -566,18 +853,18 @@ int DARSHAN_DECL(openat)(int dirfd, const char *pathname, int flags, ...)
     else
     {
         /* construct path relative to dirfd */
-        rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash,
-            &dirfd, sizeof(dirfd));
+        rec_ref = darshan_lookup_fd_ref(posix_runtime->fd_table, dirfd);
         if(rec_ref)
         {
-            dirpath = darshan_core_lookup_record_name(rec_ref->file_rec->base_rec.id);
+            if(darshan_core_lookup_record_name(rec_ref->file_rec->base_rec.id,
+                    tmp_path, sizeof(tmp_path)))
+                dirpath = tmp_path;
             /* Safety check path length against temporary buffer.  If the
              * combined path is too long, then we set dirpath to NULL to fall
              * through to using relative path below.
              */
             if(dirpath && (strlen(dirpath) + strlen(pathname) + 2) < __DARSHAN_PATH_MAX)
             {
-                strcat(tmp_path, dirpath);
                 if(dirpath[strlen(dirpath)-1] != '/')
                     strcat(tmp_path, "/");
                 strcat(tmp_path, pathname);
@@ -643,18 +930,18 @@ int DARSHAN_DECL(openat64)(int dirfd, const char *pathname, int flags, ...)
     else
     {
         /* construct path relative to dirfd */
-        rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash,
-            &dirfd, sizeof(dirfd));
+        rec_ref = darshan_lookup_fd_ref(posix_runtime->fd_table, dirfd);
         if(rec_ref)
         {
-            dirpath = darshan_core_lookup_record_name(rec_ref->file_rec->base_rec.id);
+            if(darshan_core_lookup_record_name(rec_ref->file_rec->base_rec.id,
+                    tmp_path, sizeof(tmp_path)))
+                dirpath = tmp_path;
             /* Safety check path length against temporary buffer.  If the
              * combined path is too long then, we set dirpath to NULL to fall
              * through to using relative path below.
              */
             if(dirpath && (strlen(dirpath) + strlen(pathname) + 2) < __DARSHAN_PATH_MAX)
             {
-                strcat(tmp_path, dirpath);
                 if(dirpath[strlen(dirpath)-1] != '/')
                     strcat(tmp_path, "/");
                 strcat(tmp_path, pathname);
@@ -730,8 +1017,7 @@ int DARSHAN_DECL(dup)(int oldfd)
     if(ret >= 0)
     {
         POSIX_PRE_RECORD();
-        rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash,
-            &oldfd, sizeof(oldfd));
+        rec_ref = darshan_lookup_fd_ref(posix_runtime->fd_table, oldfd);
         POSIX_RECORD_REFOPEN(ret, rec_ref, tm1, tm2, POSIX_DUPS);
         POSIX_POST_RECORD();
     }
@@ -754,8 +1040,7 @@ int DARSHAN_DECL(dup2)(int oldfd, int newfd)
     if(ret >=0)
     {
         POSIX_PRE_RECORD();
-        rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash,
-            &oldfd, sizeof(oldfd));
+        rec_ref = darshan_lookup_fd_ref(posix_runtime->fd_table, oldfd);
         POSIX_RECORD_REFOPEN(ret, rec_ref, tm1, tm2, POSIX_DUPS);
         POSIX_POST_RECORD();
     }
@@ -778,8 +1063,7 @@ int DARSHAN_DECL(dup3)(int oldfd, int newfd, int flags)
     if(ret >=0)
     {
         POSIX_PRE_RECORD();
-        rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash,
-            &oldfd, sizeof(oldfd));
+        rec_ref = darshan_lookup_fd_ref(posix_runtime->fd_table, oldfd);
         POSIX_RECORD_REFOPEN(ret, rec_ref, tm1, tm2, POSIX_DUPS);
         POSIX_POST_RECORD();
     }
@@ -802,14 +1086,13 @@ int DARSHAN_DECL(fileno)(FILE *stream)
 
     if(ret >= 0)
     {
-        char *rec_name = darshan_stdio_lookup_record_name(stream);
-        if(rec_name)
+        char rec_name[__DARSHAN_PATH_MAX];
+        if(darshan_stdio_lookup_record_name(stream, rec_name, sizeof(rec_name)))
         {
             rec_id = darshan_core_gen_record_id(rec_name);
 
             POSIX_PRE_RECORD();
-            rec_ref = darshan_lookup_record_ref(posix_runtime->rec_id_hash,
-                &rec_id, sizeof(darshan_record_id));
+            rec_ref = posix_lookup_rec_ref(rec_id);
             if(!rec_ref)
                 rec_ref = posix_track_new_file_record(rec_id, rec_name);
             POSIX_RECORD_REFOPEN(ret, rec_ref, tm1, tm2, POSIX_FILENOS);
@@ -897,17 +1180,20 @@ ssize_t DARSHAN_DECL(read)(int fd, void *buf, size_t count)
     ssize_t ret;
     int aligned_flag = 0;
     double tm1, tm2;
+    int sample_weight;
 
     MAP_OR_FAIL(read);
+    POSIX_UNTRACKED_FD_PASSTHRU(fd, __real_read(fd, buf, count));
 
     if((unsigned long)buf % darshan_mem_alignment == 0) aligned_flag = 1;
 
-    tm1 = POSIX_WTIME();
+    sample_weight = posix_sample();
+    tm1 = POSIX_SAMPLED_WTIME_START(sample_weight);
     ret = __real_read(fd, buf, count);
-    tm2 = POSIX_WTIME();
+    tm2 = POSIX_SAMPLED_WTIME_END(sample_weight);
 
     POSIX_PRE_RECORD();
-    POSIX_RECORD_READ(ret, fd, 0, 0, aligned_flag, tm1, tm2);
+    POSIX_RECORD_READ(ret, fd, 0, 0, aligned_flag, tm1, tm2, sample_weight);
     POSIX_POST_RECORD();
 
     return(ret);
@@ -918,17 +1204,20 @@ ssize_t DARSHAN_DECL(write)(int fd, const void *buf, size_t count)
     ssize_t ret;
     int aligned_flag = 0;
     double tm1, tm2;
+    int sample_weight;
 
     MAP_OR_FAIL(write);
+    POSIX_UNTRACKED_FD_PASSTHRU(fd, __real_write(fd, buf, count));
 
     if((unsigned long)buf % darshan_mem_alignment == 0) aligned_flag = 1;
 
-    tm1 = POSIX_WTIME();
+    sample_weight = posix_sample();
+    tm1 = POSIX_SAMPLED_WTIME_START(sample_weight);
     ret = __real_write(fd, buf, count);
-    tm2 = POSIX_WTIME();
+    tm2 = POSIX_SAMPLED_WTIME_END(sample_weight);
 
     POSIX_PRE_RECORD();
-    POSIX_RECORD_WRITE(ret, fd, 0, 0, aligned_flag, tm1, tm2);
+    POSIX_RECORD_WRITE(ret, fd, 0, 0, aligned_flag, tm1, tm2, sample_weight);
     POSIX_POST_RECORD();
 
     return(ret);
@@ -939,18 +1228,21 @@ ssize_t DARSHAN_DECL(pread)(int fd, void *buf, size_t count, off_t offset)
     ssize_t ret;
     int aligned_flag = 0;
     double tm1, tm2;
+    int sample_weight;
 
     MAP_OR_FAIL(pread);
+    POSIX_UNTRACKED_FD_PASSTHRU(fd, __real_pread(fd, buf, count, offset));
 
     if((unsigned long)buf % darshan_mem_alignment == 0) aligned_flag = 1;
 
-    tm1 = POSIX_WTIME();
+    sample_weight = posix_sample();
+    tm1 = POSIX_SAMPLED_WTIME_START(sample_weight);
     ret = __real_pread(fd, buf, count, offset);
-    tm2 = POSIX_WTIME();
+    tm2 = POSIX_SAMPLED_WTIME_END(sample_weight);
 
-    POSIX_PRE_RECORD();
-    POSIX_RECORD_READ(ret, fd, 1, offset, aligned_flag, tm1, tm2);
-    POSIX_POST_RECORD();
+    POSIX_PRE_RECORD_IO();
+    POSIX_RECORD_READ(ret, fd, 1, offset, aligned_flag, tm1, tm2, sample_weight);
+    POSIX_POST_RECORD_IO();
 
     return(ret);
 }
@@ -960,18 +1252,21 @@ ssize_t DARSHAN_DECL(pwrite)(int fd, const void *buf, size_t count, off_t offset
     ssize_t ret;
     int aligned_flag = 0;
     double tm1, tm2;
+    int sample_weight;
 
     MAP_OR_FAIL(pwrite);
+    POSIX_UNTRACKED_FD_PASSTHRU(fd, __real_pwrite(fd, buf, count, offset));
 
     if((unsigned long)buf % darshan_mem_alignment == 0) aligned_flag = 1;
 
-    tm1 = POSIX_WTIME();
+    sample_weight = posix_sample();
+    tm1 = POSIX_SAMPLED_WTIME_START(sample_weight);
     ret = __real_pwrite(fd, buf, count, offset);
-    tm2 = POSIX_WTIME();
+    tm2 = POSIX_SAMPLED_WTIME_END(sample_weight);
 
-    POSIX_PRE_RECORD();
-    POSIX_RECORD_WRITE(ret, fd, 1, offset, aligned_flag, tm1, tm2);
-    POSIX_POST_RECORD();
+    POSIX_PRE_RECORD_IO();
+    POSIX_RECORD_WRITE(ret, fd, 1, offset, aligned_flag, tm1, tm2, sample_weight);
+    POSIX_POST_RECORD_IO();
 
     return(ret);
 }
@@ -981,18 +1276,21 @@ ssize_t DARSHAN_DECL(pread64)(int fd, void *buf, size_t count, off64_t offset)
     ssize_t ret;
     int aligned_flag = 0;
     double tm1, tm2;
+    int sample_weight;
 
     MAP_OR_FAIL(pread64);
+    POSIX_UNTRACKED_FD_PASSTHRU(fd, __real_pread64(fd, buf, count, offset));
 
     if((unsigned long)buf % darshan_mem_alignment == 0) aligned_flag = 1;
 
-    tm1 = POSIX_WTIME();
+    sample_weight = posix_sample();
+    tm1 = POSIX_SAMPLED_WTIME_START(sample_weight);
     ret = __real_pread64(fd, buf, count, offset);
-    tm2 = POSIX_WTIME();
+    tm2 = POSIX_SAMPLED_WTIME_END(sample_weight);
 
-    POSIX_PRE_RECORD();
-    POSIX_RECORD_READ(ret, fd, 1, offset, aligned_flag, tm1, tm2);
-    POSIX_POST_RECORD();
+    POSIX_PRE_RECORD_IO();
+    POSIX_RECORD_READ(ret, fd, 1, offset, aligned_flag, tm1, tm2, sample_weight);
+    POSIX_POST_RECORD_IO();
 
     return(ret);
 }
@@ -1002,18 +1300,21 @@ ssize_t DARSHAN_DECL(pwrite64)(int fd, const void *buf, size_t count, off64_t of
     ssize_t ret;
     int aligned_flag = 0;
     double tm1, tm2;
+    int sample_weight;
 
     MAP_OR_FAIL(pwrite64);
+    POSIX_UNTRACKED_FD_PASSTHRU(fd, __real_pwrite64(fd, buf, count, offset));
 
     if((unsigned long)buf % darshan_mem_alignment == 0) aligned_flag = 1;
 
-    tm1 = POSIX_WTIME();
+    sample_weight = posix_sample();
+    tm1 = POSIX_SAMPLED_WTIME_START(sample_weight);
     ret = __real_pwrite64(fd, buf, count, offset);
-    tm2 = POSIX_WTIME();
+    tm2 = POSIX_SAMPLED_WTIME_END(sample_weight);
 
-    POSIX_PRE_RECORD();
-    POSIX_RECORD_WRITE(ret, fd, 1, offset, aligned_flag, tm1, tm2);
-    POSIX_POST_RECORD();
+    POSIX_PRE_RECORD_IO();
+    POSIX_RECORD_WRITE(ret, fd, 1, offset, aligned_flag, tm1, tm2, sample_weight);
+    POSIX_POST_RECORD_IO();
 
     return(ret);
 }
@@ -1024,8 +1325,10 @@ ssize_t DARSHAN_DECL(readv)(int fd, const struct iovec *iov, int iovcnt)
     int aligned_flag = 1;
     int i;
     double tm1, tm2;
+    int sample_weight;
 
     MAP_OR_FAIL(readv);
+    POSIX_UNTRACKED_FD_PASSTHRU(fd, __real_readv(fd, iov, iovcnt));
 
     for(i=0; i<iovcnt; i++)
     {
@@ -1033,12 +1336,14 @@ ssize_t DARSHAN_DECL(readv)(int fd, const struct iovec *iov, int iovcnt)
             aligned_flag = 0;
     }
 
-    tm1 = POSIX_WTIME();
+    sample_weight = posix_sample();
+    tm1 = POSIX_SAMPLED_WTIME_START(sample_weight);
     ret = __real_readv(fd, iov, iovcnt);
-    tm2 = POSIX_WTIME();
+    tm2 = POSIX_SAMPLED_WTIME_END(sample_weight);
 
     POSIX_PRE_RECORD();
-    POSIX_RECORD_READ(ret, fd, 0, 0, aligned_flag, tm1, tm2);
+    POSIX_RECORD_READ(ret, fd, 0, 0, aligned_flag, tm1, tm2, sample_weight);
+    POSIX_RECORD_VECTOR(ret, fd, BATCHIO_READ, iovcnt);
     POSIX_POST_RECORD();
 
     return(ret);
@@ -1051,8 +1356,10 @@ ssize_t DARSHAN_DECL(preadv)(int fd, const struct iovec *iov, int iovcnt, off_t
     int aligned_flag = 1;
     int i;
     double tm1, tm2;
+    int sample_weight;
 
     MAP_OR_FAIL(preadv);
+    POSIX_UNTRACKED_FD_PASSTHRU(fd, __real_preadv(fd, iov, iovcnt, offset));
 
     for(i=0; i<iovcnt; i++)
     {
@@ -1060,13 +1367,15 @@ ssize_t DARSHAN_DECL(preadv)(int fd, const struct iovec *iov, int iovcnt, off_t
             aligned_flag = 0;
     }
 
-    tm1 = POSIX_WTIME();
+    sample_weight = posix_sample();
+    tm1 = POSIX_SAMPLED_WTIME_START(sample_weight);
     ret = __real_preadv(fd, iov, iovcnt, offset);
-    tm2 = POSIX_WTIME();
+    tm2 = POSIX_SAMPLED_WTIME_END(sample_weight);
 
-    POSIX_PRE_RECORD();
-    POSIX_RECORD_READ(ret, fd, 1, offset, aligned_flag, tm1, tm2);
-    POSIX_POST_RECORD();
+    POSIX_PRE_RECORD_IO();
+    POSIX_RECORD_READ(ret, fd, 1, offset, aligned_flag, tm1, tm2, sample_weight);
+    POSIX_RECORD_VECTOR(ret, fd, BATCHIO_READ, iovcnt);
+    POSIX_POST_RECORD_IO();
 
     return(ret);
 }
@@ -1077,8 +1386,10 @@ ssize_t DARSHAN_DECL(preadv64)(int fd, const struct iovec *iov, int iovcnt, off6
     int aligned_flag = 1;
     int i;
     double tm1, tm2;
+    int sample_weight;
 
     MAP_OR_FAIL(preadv64);
+    POSIX_UNTRACKED_FD_PASSTHRU(fd, __real_preadv64(fd, iov, iovcnt, offset));
 
     for(i=0; i<iovcnt; i++)
     {
@@ -1086,13 +1397,15 @@ ssize_t DARSHAN_DECL(preadv64)(int fd, const struct iovec *iov, int iovcnt, off6
             aligned_flag = 0;
     }
 
-    tm1 = POSIX_WTIME();
+    sample_weight = posix_sample();
+    tm1 = POSIX_SAMPLED_WTIME_START(sample_weight);
     ret = __real_preadv64(fd, iov, iovcnt, offset);
-    tm2 = POSIX_WTIME();
+    tm2 = POSIX_SAMPLED_WTIME_END(sample_weight);
 
-    POSIX_PRE_RECORD();
-    POSIX_RECORD_READ(ret, fd, 1, offset, aligned_flag, tm1, tm2);
-    POSIX_POST_RECORD();
+    POSIX_PRE_RECORD_IO();
+    POSIX_RECORD_READ(ret, fd, 1, offset, aligned_flag, tm1, tm2, sample_weight);
+    POSIX_RECORD_VECTOR(ret, fd, BATCHIO_READ, iovcnt);
+    POSIX_POST_RECORD_IO();
 
     return(ret);
 }
@@ -1106,8 +1419,10 @@ ssize_t DARSHAN_DECL(preadv2)(int fd, const struct iovec *iov, int iovcnt, off_t
     int aligned_flag = 1;
     int i;
     double tm1, tm2;
+    int sample_weight;
 
     MAP_OR_FAIL(preadv2);
+    POSIX_UNTRACKED_FD_PASSTHRU(fd, __real_preadv2(fd, iov, iovcnt, offset, flags));
 
     for(i=0; i<iovcnt; i++)
     {
@@ -1115,13 +1430,15 @@ ssize_t DARSHAN_DECL(preadv2)(int fd, const struct iovec *iov, int iovcnt, off_t
             aligned_flag = 0;
     }
 
-    tm1 = POSIX_WTIME();
+    sample_weight = posix_sample();
+    tm1 = POSIX_SAMPLED_WTIME_START(sample_weight);
     ret = __real_preadv2(fd, iov, iovcnt, offset, flags);
-    tm2 = POSIX_WTIME();
+    tm2 = POSIX_SAMPLED_WTIME_END(sample_weight);
 
-    POSIX_PRE_RECORD();
-    POSIX_RECORD_READ(ret, fd, 1, offset, aligned_flag, tm1, tm2);
-    POSIX_POST_RECORD();
+    POSIX_PRE_RECORD_IO();
+    POSIX_RECORD_READ(ret, fd, 1, offset, aligned_flag, tm1, tm2, sample_weight);
+    POSIX_RECORD_VECTOR(ret, fd, BATCHIO_READ, iovcnt);
+    POSIX_POST_RECORD_IO();
 
     return(ret);
 }
@@ -1132,8 +1449,10 @@ ssize_t DARSHAN_DECL(preadv64v2)(int fd, const struct iovec *iov, int iovcnt, of
     int aligned_flag = 1;
     int i;
     double tm1, tm2;
+    int sample_weight;
 
     MAP_OR_FAIL(preadv64v2);
+    POSIX_UNTRACKED_FD_PASSTHRU(fd, __real_preadv64v2(fd, iov, iovcnt, offset, flags));
 
     for(i=0; i<iovcnt; i++)
     {
@@ -1141,13 +1460,15 @@ ssize_t DARSHAN_DECL(preadv64v2)(int fd, const struct iovec *iov, int iovcnt, of
             aligned_flag = 0;
     }
 
-    tm1 = POSIX_WTIME();
+    sample_weight = posix_sample();
+    tm1 = POSIX_SAMPLED_WTIME_START(sample_weight);
     ret = __real_preadv64v2(fd, iov, iovcnt, offset, flags);
-    tm2 = POSIX_WTIME();
+    tm2 = POSIX_SAMPLED_WTIME_END(sample_weight);
 
-    POSIX_PRE_RECORD();
-    POSIX_RECORD_READ(ret, fd, 1, offset, aligned_flag, tm1, tm2);
-    POSIX_POST_RECORD();
+    POSIX_PRE_RECORD_IO();
+    POSIX_RECORD_READ(ret, fd, 1, offset, aligned_flag, tm1, tm2, sample_weight);
+    POSIX_RECORD_VECTOR(ret, fd, BATCHIO_READ, iovcnt);
+    POSIX_POST_RECORD_IO();
 
     return(ret);
 }
@@ -1159,8 +1480,10 @@ ssize_t DARSHAN_DECL(writev)(int fd, const struct iovec *iov, int iovcnt)
     int aligned_flag = 1;
     int i;
     double tm1, tm2;
+    int sample_weight;
 
     MAP_OR_FAIL(writev);
+    POSIX_UNTRACKED_FD_PASSTHRU(fd, __real_writev(fd, iov, iovcnt));
 
     for(i=0; i<iovcnt; i++)
     {
@@ -1168,12 +1491,14 @@ ssize_t DARSHAN_DECL(writev)(int fd, const struct iovec *iov, int iovcnt)
             aligned_flag = 0;
     }
 
-    tm1 = POSIX_WTIME();
+    sample_weight = posix_sample();
+    tm1 = POSIX_SAMPLED_WTIME_START(sample_weight);
     ret = __real_writev(fd, iov, iovcnt);
-    tm2 = POSIX_WTIME();
+    tm2 = POSIX_SAMPLED_WTIME_END(sample_weight);
 
     POSIX_PRE_RECORD();
-    POSIX_RECORD_WRITE(ret, fd, 0, 0, aligned_flag, tm1, tm2);
+    POSIX_RECORD_WRITE(ret, fd, 0, 0, aligned_flag, tm1, tm2, sample_weight);
+    POSIX_RECORD_VECTOR(ret, fd, BATCHIO_WRITE, iovcnt);
     POSIX_POST_RECORD();
 
     return(ret);
@@ -1186,8 +1511,10 @@ ssize_t DARSHAN_DECL(pwritev)(int fd, const struct iovec *iov, int iovcnt, off_t
     int aligned_flag = 1;
     int i;
     double tm1, tm2;
+    int sample_weight;
 
     MAP_OR_FAIL(pwritev);
+    POSIX_UNTRACKED_FD_PASSTHRU(fd, __real_pwritev(fd, iov, iovcnt, offset));
 
     for(i=0; i<iovcnt; i++)
     {
@@ -1195,13 +1522,15 @@ ssize_t DARSHAN_DECL(pwritev)(int fd, const struct iovec *iov, int iovcnt, off_t
             aligned_flag = 0;
     }
 
-    tm1 = POSIX_WTIME();
+    sample_weight = posix_sample();
+    tm1 = POSIX_SAMPLED_WTIME_START(sample_weight);
     ret = __real_pwritev(fd, iov, iovcnt, offset);
-    tm2 = POSIX_WTIME();
+    tm2 = POSIX_SAMPLED_WTIME_END(sample_weight);
 
-    POSIX_PRE_RECORD();
-    POSIX_RECORD_WRITE(ret, fd, 1, offset, aligned_flag, tm1, tm2);
-    POSIX_POST_RECORD();
+    POSIX_PRE_RECORD_IO();
+    POSIX_RECORD_WRITE(ret, fd, 1, offset, aligned_flag, tm1, tm2, sample_weight);
+    POSIX_RECORD_VECTOR(ret, fd, BATCHIO_WRITE, iovcnt);
+    POSIX_POST_RECORD_IO();
 
     return(ret);
 }
@@ -1212,8 +1541,10 @@ ssize_t DARSHAN_DECL(pwritev64)(int fd, const struct iovec *iov, int iovcnt, off
     int aligned_flag = 1;
     int i;
     double tm1, tm2;
+    int sample_weight;
 
     MAP_OR_FAIL(pwritev64);
+    POSIX_UNTRACKED_FD_PASSTHRU(fd, __real_pwritev64(fd, iov, iovcnt, offset));
 
     for(i=0; i<iovcnt; i++)
     {
@@ -1221,13 +1552,15 @@ ssize_t DARSHAN_DECL(pwritev64)(int fd, const struct iovec *iov, int iovcnt, off
             aligned_flag = 0;
     }
 
-    tm1 = POSIX_WTIME();
+    sample_weight = posix_sample();
+    tm1 = POSIX_SAMPLED_WTIME_START(sample_weight);
     ret = __real_pwritev64(fd, iov, iovcnt, offset);
-    tm2 = POSIX_WTIME();
+    tm2 = POSIX_SAMPLED_WTIME_END(sample_weight);
 
-    POSIX_PRE_RECORD();
-    POSIX_RECORD_WRITE(ret, fd, 1, offset, aligned_flag, tm1, tm2);
-    POSIX_POST_RECORD();
+    POSIX_PRE_RECORD_IO();
+    POSIX_RECORD_WRITE(ret, fd, 1, offset, aligned_flag, tm1, tm2, sample_weight);
+    POSIX_RECORD_VECTOR(ret, fd, BATCHIO_WRITE, iovcnt);
+    POSIX_POST_RECORD_IO();
 
     return(ret);
 }
@@ -1240,8 +1573,10 @@ ssize_t DARSHAN_DECL(pwritev2)(int fd, const struct iovec *iov, int iovcnt, off_
     int aligned_flag = 1;
     int i;
     double tm1, tm2;
+    int sample_weight;
 
     MAP_OR_FAIL(pwritev2);
+    POSIX_UNTRACKED_FD_PASSTHRU(fd, __real_pwritev2(fd, iov, iovcnt, offset, flags));
 
     for(i=0; i<iovcnt; i++)
     {
@@ -1249,13 +1584,15 @@ ssize_t DARSHAN_DECL(pwritev2)(int fd, const struct iovec *iov, int iovcnt, off_
             aligned_flag = 0;
     }
 
-    tm1 = POSIX_WTIME();
+    sample_weight = posix_sample();
+    tm1 = POSIX_SAMPLED_WTIME_START(sample_weight);
     ret = __real_pwritev2(fd, iov, iovcnt, offset, flags);
-    tm2 = POSIX_WTIME();
+    tm2 = POSIX_SAMPLED_WTIME_END(sample_weight);
 
-    POSIX_PRE_RECORD();
-    POSIX_RECORD_WRITE(ret, fd, 1, offset, aligned_flag, tm1, tm2);
-    POSIX_POST_RECORD();
+    POSIX_PRE_RECORD_IO();
+    POSIX_RECORD_WRITE(ret, fd, 1, offset, aligned_flag, tm1, tm2, sample_weight);
+    POSIX_RECORD_VECTOR(ret, fd, BATCHIO_WRITE, iovcnt);
+    POSIX_POST_RECORD_IO();
 
     return(ret);
 }
@@ -1266,8 +1603,10 @@ ssize_t DARSHAN_DECL(pwritev64v2)(int fd, const struct iovec *iov, int iovcnt, o
     int aligned_flag = 1;
     int i;
     double tm1, tm2;
+    int sample_weight;
 
     MAP_OR_FAIL(pwritev64v2);
+    POSIX_UNTRACKED_FD_PASSTHRU(fd, __real_pwritev64v2(fd, iov, iovcnt, offset, flags));
 
     for(i=0; i<iovcnt; i++)
     {
@@ -1275,13 +1614,15 @@ ssize_t DARSHAN_DECL(pwritev64v2)(int fd, const struct iovec *iov, int iovcnt, o
             aligned_flag = 0;
     }
 
-    tm1 = POSIX_WTIME();
+    sample_weight = posix_sample();
+    tm1 = POSIX_SAMPLED_WTIME_START(sample_weight);
     ret = __real_pwritev64v2(fd, iov, iovcnt, offset, flags);
-    tm2 = POSIX_WTIME();
+    tm2 = POSIX_SAMPLED_WTIME_END(sample_weight);
 
-    POSIX_PRE_RECORD();
-    POSIX_RECORD_WRITE(ret, fd, 1, offset, aligned_flag, tm1, tm2);
-    POSIX_POST_RECORD();
+    POSIX_PRE_RECORD_IO();
+    POSIX_RECORD_WRITE(ret, fd, 1, offset, aligned_flag, tm1, tm2, sample_weight);
+    POSIX_RECORD_VECTOR(ret, fd, BATCHIO_WRITE, iovcnt);
+    POSIX_POST_RECORD_IO();
 
     return(ret);
 }
@@ -1295,6 +1636,7 @@ off_t DARSHAN_DECL(lseek)(int fd, off_t offset, int whence)
     double tm1, tm2;
 
     MAP_OR_FAIL(lseek);
+    POSIX_UNTRACKED_FD_PASSTHRU(fd, __real_lseek(fd, offset, whence));
 
     tm1 = POSIX_WTIME();
     ret = __real_lseek(fd, offset, whence);
@@ -1303,7 +1645,7 @@ off_t DARSHAN_DECL(lseek)(int fd, off_t offset, int whence)
     if(ret >= 0)
     {
         POSIX_PRE_RECORD();
-        rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash, &fd, sizeof(int));
+        rec_ref = darshan_lookup_fd_ref(posix_runtime->fd_table, fd);
         if(rec_ref)
         {
             rec_ref->offset = ret;
@@ -1325,6 +1667,7 @@ off64_t DARSHAN_DECL(lseek64)(int fd, off64_t offset, int whence)
     double tm1, tm2;
 
     MAP_OR_FAIL(lseek64);
+    POSIX_UNTRACKED_FD_PASSTHRU(fd, __real_lseek64(fd, offset, whence));
 
     tm1 = POSIX_WTIME();
     ret = __real_lseek64(fd, offset, whence);
@@ -1333,7 +1676,7 @@ off64_t DARSHAN_DECL(lseek64)(int fd, off64_t offset, int whence)
     if(ret >= 0)
     {
         POSIX_PRE_RECORD();
-        rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash, &fd, sizeof(int));
+        rec_ref = darshan_lookup_fd_ref(posix_runtime->fd_table, fd);
         if(rec_ref)
         {
             rec_ref->offset = ret;
@@ -1448,7 +1791,7 @@ int DARSHAN_DECL(__fxstat)(int vers, int fd, struct stat *buf)
         return(ret);
 
     POSIX_PRE_RECORD();
-    rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash, &fd, sizeof(int));
+    rec_ref = darshan_lookup_fd_ref(posix_runtime->fd_table, fd);
     if(rec_ref)
     {
         POSIX_RECORD_STAT(rec_ref, buf, tm1, tm2);
@@ -1474,7 +1817,7 @@ int DARSHAN_DECL(__fxstat64)(int vers, int fd, struct stat64 *buf)
         return(ret);
 
     POSIX_PRE_RECORD();
-    rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash, &fd, sizeof(int));
+    rec_ref = darshan_lookup_fd_ref(posix_runtime->fd_table, fd);
     if(rec_ref)
     {
         POSIX_RECORD_STAT(rec_ref, buf, tm1, tm2);
@@ -1490,6 +1833,7 @@ void* DARSHAN_DECL(mmap)(void *addr, size_t length, int prot, int flags,
 {
     void* ret;
     struct posix_file_record_ref *rec_ref;
+    darshan_record_id rec_id = 0;
 
     MAP_OR_FAIL(mmap);
     (void)__darshan_disabled;
@@ -1507,13 +1851,18 @@ void* DARSHAN_DECL(mmap)(void *addr, size_t length, int prot, int flags,
         return(ret);
 
     POSIX_PRE_RECORD();
-    rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash, &fd, sizeof(int));
+    rec_ref = darshan_lookup_fd_ref(posix_runtime->fd_table, fd);
     if(rec_ref)
     {
         rec_ref->file_rec->counters[POSIX_MMAPS] += 1;
+        rec_id = rec_ref->file_rec->base_rec.id;
     }
     POSIX_POST_RECORD();
 
+    /* the MMAP module samples the pages of the mapping that get used */
+    if(rec_id)
+        MMAP_TRACK(rec_id, ret, length, prot, flags);
+
     return(ret);
 }
 #endif /* DARSHAN_WRAP_MMAP */
@@ -1524,6 +1873,7 @@ void* DARSHAN_DECL(mmap64)(void *addr, size_t length, int prot, int flags,
 {
     void* ret;
     struct posix_file_record_ref *rec_ref;
+    darshan_record_id rec_id = 0;
 
     MAP_OR_FAIL(mmap64);
 
@@ -1540,17 +1890,35 @@ void* DARSHAN_DECL(mmap64)(void *addr, size_t length, int prot, int flags,
         return(ret);
 
     POSIX_PRE_RECORD();
-    rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash, &fd, sizeof(int));
+    rec_ref = darshan_lookup_fd_ref(posix_runtime->fd_table, fd);
     if(rec_ref)
     {
         rec_ref->file_rec->counters[POSIX_MMAPS] += 1;
+        rec_id = rec_ref->file_rec->base_rec.id;
     }
     POSIX_POST_RECORD();
 
+    /* the MMAP module samples the pages of the mapping that get used */
+    if(rec_id)
+        MMAP_TRACK(rec_id, ret, length, prot, flags);
+
     return(ret);
 }
 #endif /* DARSHAN_WRAP_MMAP */
 
+#ifdef DARSHAN_WRAP_MMAP
+int DARSHAN_DECL(munmap)(void *addr, size_t length)
+{
+    MAP_OR_FAIL(munmap);
+
+    /* the MMAP module takes a last sample of mappings being unmapped */
+    if(!__darshan_disabled)
+        MMAP_UNTRACK(addr, length);
+
+    return(__real_munmap(addr, length));
+}
+#endif /* DARSHAN_WRAP_MMAP */
+
 int DARSHAN_DECL(fsync)(int fd)
 {
     int ret;
@@ -1558,6 +1926,7 @@ int DARSHAN_DECL(fsync)(int fd)
     double tm1, tm2;
 
     MAP_OR_FAIL(fsync);
+    POSIX_UNTRACKED_FD_PASSTHRU(fd, __real_fsync(fd));
 
     tm1 = POSIX_WTIME();
     ret = __real_fsync(fd);
@@ -1567,7 +1936,7 @@ int DARSHAN_DECL(fsync)(int fd)
         return(ret);
 
     POSIX_PRE_RECORD();
-    rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash, &fd, sizeof(int));
+    rec_ref = darshan_lookup_fd_ref(posix_runtime->fd_table, fd);
     if(rec_ref)
     {
         DARSHAN_TIMER_INC_NO_OVERLAP(
@@ -1587,6 +1956,7 @@ int DARSHAN_DECL(fdatasync)(int fd)
     double tm1, tm2;
 
     MAP_OR_FAIL(fdatasync);
+    POSIX_UNTRACKED_FD_PASSTHRU(fd, __real_fdatasync(fd));
 
     tm1 = POSIX_WTIME();
     ret = __real_fdatasync(fd);
@@ -1596,7 +1966,7 @@ int DARSHAN_DECL(fdatasync)(int fd)
         return(ret);
 
     POSIX_PRE_RECORD();
-    rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash, &fd, sizeof(int));
+    rec_ref = darshan_lookup_fd_ref(posix_runtime->fd_table, fd);
     if(rec_ref)
     {
         DARSHAN_TIMER_INC_NO_OVERLAP(
@@ -1616,18 +1986,19 @@ int DARSHAN_DECL(close)(int fd)
     double tm1, tm2;
 
     MAP_OR_FAIL(close);
+    POSIX_UNTRACKED_FD_PASSTHRU(fd, __real_close(fd));
 
     if(!__darshan_disabled)
     {
         POSIX_LOCK();
         if(posix_runtime && !posix_runtime->frozen)
         {
-            rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash,
-                &fd, sizeof(int));
+            rec_ref = darshan_lookup_fd_ref(posix_runtime->fd_table, fd);
             if(rec_ref)
             {
                 darshan_instrument_fs_data(rec_ref->fs_type,
                     rec_ref->file_rec->base_rec.id, fd);
+                DARSHAN_ROLLUP_CLOSE(rec_ref->file_rec->base_rec.id, fd);
             }
         }
         POSIX_UNLOCK();
@@ -1638,7 +2009,7 @@ int DARSHAN_DECL(close)(int fd)
     tm2 = POSIX_WTIME();
 
     POSIX_PRE_RECORD();
-    rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash, &fd, sizeof(int));
+    rec_ref = darshan_lookup_fd_ref(posix_runtime->fd_table, fd);
     if(rec_ref)
     {
         rec_ref->last_byte_written = 0;
@@ -1650,14 +2021,21 @@ int DARSHAN_DECL(close)(int fd)
         DARSHAN_TIMER_INC_NO_OVERLAP(
             rec_ref->file_rec->fcounters[POSIX_F_META_TIME],
             tm1, tm2, rec_ref->last_meta_end);
-        darshan_delete_record_ref(&(posix_runtime->fd_hash), &fd, sizeof(int));
+        HEATMAP_UPDATE_META(posix_runtime->heatmap_id, tm1, tm2);
+        LATENCY_RECORD(rec_ref->file_rec->base_rec.id, LATENCY_OP_POSIX_META,
+            tm1, tm2);
+        TIMESERIES_RECORD(TIMESERIES_API_POSIX, TIMESERIES_OP_META, 0,
+            tm1, tm2);
+        darshan_delete_fd_ref(&(posix_runtime->fd_table), fd);
+        /* invalidate any thread shard mappings for this fd */
+        if(posix_thread_shards)
+            atomic_fetch_add(&posix_fd_epoch, 1);
 
 #ifdef HAVE_LDMS
         rec_ref->close_counts++;
         /* publish close information for posix */
-        if(dC.ldms_lib)
-            if(dC.posix_enable_ldms)
-                darshan_ldms_connector_send(rec_ref->file_rec->base_rec.id, rec_ref->file_rec->base_rec.rank, rec_ref->close_counts, "close", -1, -1, -1, -1, -1, tm1, tm2, rec_ref->file_rec->fcounters[POSIX_F_META_TIME], "POSIX", "MOD");
+        if(DARSHAN_LDMS_ENABLED(posix))
+            darshan_ldms_connector_send(rec_ref->file_rec->base_rec.id, rec_ref->file_rec->base_rec.rank, rec_ref->close_counts, "close", -1, -1, -1, -1, -1, tm1, tm2, rec_ref->file_rec->fcounters[POSIX_F_META_TIME], "POSIX", "MOD");
 #endif
     }
     POSIX_POST_RECORD();
@@ -1755,13 +2133,13 @@ ssize_t DARSHAN_DECL(aio_return)(struct aiocb *aiocbp)
         {
             POSIX_RECORD_WRITE(ret, aiocbp->aio_fildes,
                 1, aiocbp->aio_offset, aligned_flag,
-                tmp->tm1, tm2);
+                tmp->tm1, tm2, 1);
         }
         else if(aiocbp->aio_lio_opcode == LIO_READ)
         {
             POSIX_RECORD_READ(ret, aiocbp->aio_fildes,
                 1, aiocbp->aio_offset, aligned_flag,
-                tmp->tm1, tm2);
+                tmp->tm1, tm2, 1);
         }
         free(tmp);
     }
@@ -1792,13 +2170,13 @@ ssize_t DARSHAN_DECL(aio_return64)(struct aiocb64 *aiocbp)
         {
             POSIX_RECORD_WRITE(ret, aiocbp->aio_fildes,
                 1, aiocbp->aio_offset, aligned_flag,
-                tmp->tm1, tm2);
+                tmp->tm1, tm2, 1);
         }
         else if(aiocbp->aio_lio_opcode == LIO_READ)
         {
             POSIX_RECORD_READ(ret, aiocbp->aio_fildes,
                 1, aiocbp->aio_offset, aligned_flag,
-                tmp->tm1, tm2);
+                tmp->tm1, tm2, 1);
         }
         free(tmp);
     }
@@ -1851,95 +2229,371 @@ int DARSHAN_DECL(lio_listio64)(int mode, struct aiocb64 *const aiocb_list[],
     return(ret);
 }
 
-int DARSHAN_DECL(rename)(const char *oldpath, const char *newpath)
+#ifdef DARSHAN_PRELOAD
+#ifdef HAVE_LINUX_AIO_ABI_H
+/* NOTE: libaio's iocb and io_event structures share the layout of the
+ * kernel ABI structures, which are used here to avoid depending on libaio
+ * headers.  Requests are only tracked until their completion is reaped
+ * by io_getevents(); completions read directly from the user-space
+ * completion ring are not seen.
+ */
+int DARSHAN_DECL(io_submit)(aio_context_t ctx, long nr, struct iocb **ios)
 {
     int ret;
+    int i;
+    int rw_flag, iovcnt;
     double tm1, tm2;
-    char *oldpath_clean, *newpath_clean;
-    darshan_record_id old_rec_id, new_rec_id;
-    struct posix_file_record_ref *old_rec_ref, *new_rec_ref;
-    int disabled = 0;
-
-    /* This is a special case to avoid attempting to instrument final rename
-     * performed by darshan itself when finalizing
-     */
-    POSIX_LOCK();
-    disabled = darshan_core_disabled_instrumentation();
-    POSIX_UNLOCK();
+    struct posix_file_record_ref *rec_ref;
 
-    MAP_OR_FAIL(rename);
+    MAP_OR_FAIL(io_submit);
 
     tm1 = POSIX_WTIME();
-    ret = __real_rename(oldpath, newpath);
+    ret = __real_io_submit(ctx, nr, ios);
     tm2 = POSIX_WTIME();
 
-    if(disabled)
-        return(ret);
-
-    if(ret == 0)
+    POSIX_PRE_RECORD();
+    batchio_submit(BATCHIO_LIBAIO, nr, ret, tm1, tm2);
+    for(i = 0; i < ret; i++)
     {
-        oldpath_clean = darshan_clean_file_path(oldpath);
-        if(!oldpath_clean) oldpath_clean = (char *)oldpath;
-        old_rec_id = darshan_core_gen_record_id(oldpath_clean);
-
-        POSIX_PRE_RECORD();
-        old_rec_ref = darshan_lookup_record_ref(posix_runtime->rec_id_hash,
-            &old_rec_id, sizeof(darshan_record_id));
-        if(!old_rec_ref)
-        {
-            POSIX_POST_RECORD();
-            if(oldpath_clean != oldpath) free(oldpath_clean);
-            return(ret);
-        }
-        old_rec_ref->file_rec->counters[POSIX_RENAME_SOURCES] += 1;
-        DARSHAN_TIMER_INC_NO_OVERLAP(old_rec_ref->file_rec->fcounters[POSIX_F_META_TIME],
-            tm1, tm2, old_rec_ref->last_meta_end);
-
-        newpath_clean = darshan_clean_file_path(newpath);
-        if(!newpath_clean) newpath_clean = (char *)newpath;
-        new_rec_id = darshan_core_gen_record_id(newpath_clean);
-
-        new_rec_ref = darshan_lookup_record_ref(posix_runtime->rec_id_hash,
-            &new_rec_id, sizeof(darshan_record_id));
-        if(!new_rec_ref)
-            new_rec_ref = posix_track_new_file_record(new_rec_id, newpath_clean);
-        if(new_rec_ref)
+        iovcnt = 0;
+        switch(ios[i]->aio_lio_opcode)
         {
-            new_rec_ref->file_rec->counters[POSIX_RENAME_TARGETS] += 1;
-            if(new_rec_ref->file_rec->counters[POSIX_RENAMED_FROM] == 0)
-                new_rec_ref->file_rec->counters[POSIX_RENAMED_FROM] = old_rec_id;
+            case IOCB_CMD_PREADV:
+                iovcnt = ios[i]->aio_nbytes;
+                /* fall through */
+            case IOCB_CMD_PREAD:
+                rw_flag = BATCHIO_READ;
+                break;
+            case IOCB_CMD_PWRITEV:
+                iovcnt = ios[i]->aio_nbytes;
+                /* fall through */
+            case IOCB_CMD_PWRITE:
+                rw_flag = BATCHIO_WRITE;
+                break;
+            default:
+                rw_flag = BATCHIO_OTHER;
+                break;
         }
-
-        POSIX_POST_RECORD();
-        if(oldpath_clean != oldpath) free(oldpath_clean);
-        if(newpath_clean != newpath) free(newpath_clean);
+        rec_ref = darshan_lookup_fd_ref(posix_runtime->fd_table,
+            ios[i]->aio_fildes);
+        batchio_async_start(BATCHIO_LIBAIO, ios[i],
+            rec_ref ? rec_ref->file_rec->base_rec.id : 0, rw_flag, iovcnt, tm1);
+        if(rec_ref && rw_flag != BATCHIO_OTHER)
+            posix_aio_tracker_add(ios[i]->aio_fildes, ios[i]);
     }
+    POSIX_POST_RECORD();
 
     return(ret);
 }
 
-/**********************************************************
- * Internal functions for manipulating POSIX module state *
- **********************************************************/
-
-/* initialize internal POSIX module data structures and register with darshan-core */
-static void posix_runtime_initialize()
+int DARSHAN_DECL(io_getevents)(aio_context_t ctx, long min_nr, long nr,
+    struct io_event *events, struct timespec *timeout)
 {
     int ret;
-    size_t psx_rec_count;
-    darshan_module_funcs mod_funcs = {
-#ifdef HAVE_MPI
-        .mod_redux_func = &posix_mpi_redux,
-#endif
-        .mod_output_func = &posix_output,
-        .mod_cleanup_func = &posix_cleanup
-        };
-
-    /* if this attempt at initializing fails, we won't try again */
-    posix_runtime_init_attempted = 1;
+    int i;
+    unsigned long j;
+    int aligned_flag;
+    ssize_t res;
+    double tm1, tm2;
+    struct iocb *iocb;
+    struct iovec *iov;
+    struct posix_aio_tracker *tmp;
 
-    /* try and store a default number of records for this module */
-    psx_rec_count = DARSHAN_DEF_MOD_REC_COUNT;
+    MAP_OR_FAIL(io_getevents);
+
+    tm1 = POSIX_WTIME();
+    ret = __real_io_getevents(ctx, min_nr, nr, events, timeout);
+    tm2 = POSIX_WTIME();
+
+    POSIX_PRE_RECORD();
+    batchio_wait(BATCHIO_LIBAIO, tm1, tm2);
+    for(i = 0; i < ret; i++)
+    {
+        iocb = (struct iocb *)(uintptr_t)events[i].obj;
+        batchio_async_complete(BATCHIO_LIBAIO, iocb, tm2);
+
+        tmp = posix_aio_tracker_del(iocb->aio_fildes, iocb);
+        if(!tmp)
+            continue;
+        aligned_flag = 1;
+        if(iocb->aio_lio_opcode == IOCB_CMD_PREADV ||
+           iocb->aio_lio_opcode == IOCB_CMD_PWRITEV)
+        {
+            iov = (struct iovec *)(uintptr_t)iocb->aio_buf;
+            for(j = 0; j < iocb->aio_nbytes; j++)
+            {
+                if(((unsigned long)iov[j].iov_base % darshan_mem_alignment) != 0)
+                    aligned_flag = 0;
+            }
+        }
+        else if((iocb->aio_buf % darshan_mem_alignment) != 0)
+            aligned_flag = 0;
+        res = events[i].res;
+        if(iocb->aio_lio_opcode == IOCB_CMD_PWRITE ||
+           iocb->aio_lio_opcode == IOCB_CMD_PWRITEV)
+        {
+            POSIX_RECORD_WRITE(res, iocb->aio_fildes,
+                1, iocb->aio_offset, aligned_flag,
+                tmp->tm1, tm2, 1);
+        }
+        else
+        {
+            POSIX_RECORD_READ(res, iocb->aio_fildes,
+                1, iocb->aio_offset, aligned_flag,
+                tmp->tm1, tm2, 1);
+        }
+        free(tmp);
+    }
+    POSIX_POST_RECORD();
+
+    return(ret);
+}
+#endif /* HAVE_LINUX_AIO_ABI_H */
+
+/* NOTE: only the submission and wait calls that liburing exports are
+ * visible, so io_uring requests are not attributed to files and their
+ * queue depth and completion latency are not known.  Calls made while
+ * another wrapped liburing call is in progress on the same thread (e.g.,
+ * library-internal calls) are not counted twice.
+ */
+static __thread int posix_uring_nesting = 0;
+
+#define POSIX_URING_NESTED_CALL(__call) do { \
+    if(posix_uring_nesting) return(__call); \
+    posix_uring_nesting++; \
+    tm1 = POSIX_WTIME(); \
+    ret = __call; \
+    tm2 = POSIX_WTIME(); \
+    posix_uring_nesting--; \
+} while(0)
+
+int DARSHAN_DECL(io_uring_enter)(unsigned int fd, unsigned int to_submit,
+    unsigned int min_complete, unsigned int flags, sigset_t *sig)
+{
+    int ret;
+    int wait_flag;
+    double tm1, tm2;
+
+    MAP_OR_FAIL(io_uring_enter);
+
+    POSIX_URING_NESTED_CALL(
+        __real_io_uring_enter(fd, to_submit, min_complete, flags, sig));
+
+    /* calls that both submit and wait are charged as wait time */
+    wait_flag = (flags & IORING_ENTER_GETEVENTS) && min_complete > 0;
+    POSIX_PRE_RECORD();
+    if(to_submit > 0)
+        batchio_submit(BATCHIO_IO_URING, to_submit, ret, tm1,
+            wait_flag ? tm1 : tm2);
+    if(wait_flag)
+        batchio_wait(BATCHIO_IO_URING, tm1, tm2);
+    POSIX_POST_RECORD();
+
+    return(ret);
+}
+
+int DARSHAN_DECL(io_uring_submit)(struct io_uring *ring)
+{
+    int ret;
+    double tm1, tm2;
+
+    MAP_OR_FAIL(io_uring_submit);
+
+    POSIX_URING_NESTED_CALL(__real_io_uring_submit(ring));
+
+    /* the number of requests that were queued is not visible */
+    POSIX_PRE_RECORD();
+    batchio_submit(BATCHIO_IO_URING, ret > 0 ? ret : 0, ret, tm1, tm2);
+    POSIX_POST_RECORD();
+
+    return(ret);
+}
+
+int DARSHAN_DECL(io_uring_submit_and_wait)(struct io_uring *ring,
+    unsigned wait_nr)
+{
+    int ret;
+    double tm1, tm2;
+
+    MAP_OR_FAIL(io_uring_submit_and_wait);
+
+    POSIX_URING_NESTED_CALL(__real_io_uring_submit_and_wait(ring, wait_nr));
+
+    POSIX_PRE_RECORD();
+    batchio_submit(BATCHIO_IO_URING, ret > 0 ? ret : 0, ret, tm1,
+        wait_nr > 0 ? tm1 : tm2);
+    if(wait_nr > 0)
+        batchio_wait(BATCHIO_IO_URING, tm1, tm2);
+    POSIX_POST_RECORD();
+
+    return(ret);
+}
+
+int DARSHAN_DECL(io_uring_wait_cqes)(struct io_uring *ring,
+    struct io_uring_cqe **cqe_ptr, unsigned wait_nr,
+    struct __kernel_timespec *ts, sigset_t *sigmask)
+{
+    int ret;
+    double tm1, tm2;
+
+    MAP_OR_FAIL(io_uring_wait_cqes);
+
+    POSIX_URING_NESTED_CALL(
+        __real_io_uring_wait_cqes(ring, cqe_ptr, wait_nr, ts, sigmask));
+
+    POSIX_PRE_RECORD();
+    batchio_wait(BATCHIO_IO_URING, tm1, tm2);
+    POSIX_POST_RECORD();
+
+    return(ret);
+}
+
+/* liburing's inline io_uring_wait_cqe() and related functions call this
+ * when no completion is already available
+ */
+int DARSHAN_DECL(__io_uring_get_cqe)(struct io_uring *ring,
+    struct io_uring_cqe **cqe_ptr, unsigned submit, unsigned wait_nr,
+    sigset_t *sigmask)
+{
+    int ret;
+    double tm1, tm2;
+
+    MAP_OR_FAIL(__io_uring_get_cqe);
+
+    POSIX_URING_NESTED_CALL(
+        __real___io_uring_get_cqe(ring, cqe_ptr, submit, wait_nr, sigmask));
+
+    POSIX_PRE_RECORD();
+    if(submit > 0)
+        batchio_submit(BATCHIO_IO_URING, submit, ret < 0 ? ret : submit,
+            tm1, wait_nr > 0 ? tm1 : tm2);
+    if(wait_nr > 0)
+        batchio_wait(BATCHIO_IO_URING, tm1, tm2);
+    POSIX_POST_RECORD();
+
+    return(ret);
+}
+#endif /* DARSHAN_PRELOAD */
+
+int DARSHAN_DECL(rename)(const char *oldpath, const char *newpath)
+{
+    int ret;
+    double tm1, tm2;
+    char oldpath_buf[__DARSHAN_PATH_MAX], newpath_buf[__DARSHAN_PATH_MAX];
+    char *oldpath_clean, *newpath_clean;
+    darshan_record_id old_rec_id, new_rec_id;
+    struct posix_file_record_ref *old_rec_ref, *new_rec_ref;
+    int disabled = 0;
+
+    /* This is a special case to avoid attempting to instrument final rename
+     * performed by darshan itself when finalizing
+     */
+    POSIX_LOCK();
+    disabled = darshan_core_disabled_instrumentation();
+    POSIX_UNLOCK();
+
+    MAP_OR_FAIL(rename);
+
+    tm1 = POSIX_WTIME();
+    ret = __real_rename(oldpath, newpath);
+    tm2 = POSIX_WTIME();
+
+    if(disabled)
+        return(ret);
+
+    if(ret == 0)
+    {
+        oldpath_clean = darshan_clean_file_path_buf(oldpath, oldpath_buf,
+            sizeof(oldpath_buf));
+        if(!oldpath_clean) oldpath_clean = (char *)oldpath;
+        old_rec_id = darshan_core_gen_record_id(oldpath_clean);
+
+        POSIX_PRE_RECORD();
+        old_rec_ref = posix_lookup_rec_ref(old_rec_id);
+        if(!old_rec_ref)
+        {
+            POSIX_POST_RECORD();
+            return(ret);
+        }
+        old_rec_ref->file_rec->counters[POSIX_RENAME_SOURCES] += 1;
+        DARSHAN_TIMER_INC_NO_OVERLAP(old_rec_ref->file_rec->fcounters[POSIX_F_META_TIME],
+            tm1, tm2, old_rec_ref->last_meta_end);
+
+        newpath_clean = darshan_clean_file_path_buf(newpath, newpath_buf,
+            sizeof(newpath_buf));
+        if(!newpath_clean) newpath_clean = (char *)newpath;
+        new_rec_id = darshan_core_gen_record_id(newpath_clean);
+
+        new_rec_ref = posix_lookup_rec_ref(new_rec_id);
+        if(!new_rec_ref)
+            new_rec_ref = posix_track_new_file_record(new_rec_id, newpath_clean);
+        if(new_rec_ref)
+        {
+            new_rec_ref->file_rec->counters[POSIX_RENAME_TARGETS] += 1;
+            if(new_rec_ref->file_rec->counters[POSIX_RENAMED_FROM] == 0)
+                new_rec_ref->file_rec->counters[POSIX_RENAMED_FROM] = old_rec_id;
+        }
+
+        POSIX_POST_RECORD();
+    }
+
+    return(ret);
+}
+
+/* chdir()/fchdir() are not instrumented, but are wrapped so that the
+ * cached working directory used to clean relative paths stays current,
+ * even while instrumentation is disabled
+ */
+int DARSHAN_DECL(chdir)(const char *path)
+{
+    int ret;
+
+    MAP_OR_FAIL(chdir);
+    (void)__darshan_disabled;
+
+    ret = __real_chdir(path);
+    if(ret == 0)
+        darshan_invalidate_cwd_cache();
+
+    return(ret);
+}
+
+int DARSHAN_DECL(fchdir)(int fd)
+{
+    int ret;
+
+    MAP_OR_FAIL(fchdir);
+    (void)__darshan_disabled;
+
+    ret = __real_fchdir(fd);
+    if(ret == 0)
+        darshan_invalidate_cwd_cache();
+
+    return(ret);
+}
+
+/**********************************************************
+ * Internal functions for manipulating POSIX module state *
+ **********************************************************/
+
+/* initialize internal POSIX module data structures and register with darshan-core */
+static void posix_runtime_initialize()
+{
+    int ret;
+    size_t psx_rec_count;
+    darshan_module_funcs mod_funcs = {
+#ifdef HAVE_MPI
+        .mod_redux_func = &posix_mpi_redux,
+#endif
+        .mod_output_func = &posix_output,
+        .mod_cleanup_func = &posix_cleanup
+        };
+
+    /* if this attempt at initializing fails, we won't try again */
+    posix_runtime_init_attempted = 1;
+
+    /* try and store a default number of records for this module */
+    psx_rec_count = DARSHAN_DEF_MOD_REC_COUNT;
 
     /* register the POSIX module with darshan core */
     ret = darshan_core_register_module(
@@ -1960,12 +2614,37 @@ static void posix_runtime_initialize()
     }
     memset(posix_runtime, 0, sizeof(*posix_runtime));
 
-    /* allow DXT module to initialize if needed */
+    /* sample data operations, if requested */
+    posix_sample_rate = darshan_core_sample_rate(DARSHAN_POSIX_MOD);
+    if(posix_sample_rate > INT_MAX)
+        posix_sample_rate = INT_MAX;
+
+    /* set up per-thread record shards for positional I/O, if requested */
+    posix_thread_shards = 0;
+    if(darshan_core_thread_shards_enabled())
+    {
+        if(!posix_shard_key_created &&
+            pthread_key_create(&posix_shard_key, NULL) == 0)
+            posix_shard_key_created = 1;
+        posix_thread_shards = posix_shard_key_created;
+    }
+
+    /* allow DXT and LATENCY modules to initialize if needed */
     dxt_posix_runtime_initialize();
+    latency_runtime_initialize();
 
     /* register a heatmap */
     posix_runtime->heatmap_id = heatmap_register("heatmap:POSIX");
 
+    /* retire the records of closed files in the background, if requested;
+     * records in thread shards may hold updates not yet folded in, so
+     * retirement is not compatible with them
+     */
+    posix_runtime->retire_time = darshan_core_record_retire_time();
+    pthread_cond_init(&posix_runtime->retirer_cond, NULL);
+    if(posix_runtime->retire_time > 0 && !posix_thread_shards)
+        posix_start_retirer();
+
     return;
 }
 
@@ -1977,17 +2656,16 @@ static struct posix_file_record_ref *posix_track_new_file_record(
     struct darshan_fs_info fs_info;
     int ret;
 
-    rec_ref = malloc(sizeof(*rec_ref));
+    rec_ref = darshan_arena_alloc(&(posix_runtime->arena), sizeof(*rec_ref));
     if(!rec_ref)
         return(NULL);
-    memset(rec_ref, 0, sizeof(*rec_ref));
 
     /* add a reference to this file record based on record id */
-    ret = darshan_add_record_ref(&(posix_runtime->rec_id_hash), &rec_id,
-        sizeof(darshan_record_id), rec_ref);
+    ret = darshan_arena_add_record_ref(&(posix_runtime->arena),
+        &(posix_runtime->rec_id_hash), &rec_id, sizeof(darshan_record_id), rec_ref);
     if(ret == 0)
     {
-        free(rec_ref);
+        darshan_arena_free(posix_runtime->arena, rec_ref, sizeof(*rec_ref));
         return(NULL);
     }
 
@@ -2003,9 +2681,9 @@ static struct posix_file_record_ref *posix_track_new_file_record(
 
     if(!file_rec)
     {
-        darshan_delete_record_ref(&(posix_runtime->rec_id_hash),
-            &rec_id, sizeof(darshan_record_id));
-        free(rec_ref);
+        darshan_arena_delete_record_ref(posix_runtime->arena,
+            &(posix_runtime->rec_id_hash), &rec_id, sizeof(darshan_record_id));
+        darshan_arena_free(posix_runtime->arena, rec_ref, sizeof(*rec_ref));
         return(NULL);
     }
 
@@ -2035,390 +2713,726 @@ static struct posix_aio_tracker* posix_aio_tracker_del(int fd, void *aiocbp)
     struct posix_aio_tracker *tracker = NULL, *iter, *tmp;
     struct posix_file_record_ref *rec_ref;
 
-    rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash, &fd, sizeof(int));
+    rec_ref = darshan_lookup_fd_ref(posix_runtime->fd_table, fd);
+    if(rec_ref)
+    {
+        LL_FOREACH_SAFE(rec_ref->aio_list, iter, tmp)
+        {
+            if(iter->aiocbp == aiocbp)
+            {
+                LL_DELETE(rec_ref->aio_list, iter);
+                tracker = iter;
+                break;
+            }
+        }
+    }
+
+    return(tracker);
+}
+
+/* adds a tracker for the given aio operation */
+static void posix_aio_tracker_add(int fd, void *aiocbp)
+{
+    struct posix_aio_tracker* tracker;
+    struct posix_file_record_ref *rec_ref;
+
+    rec_ref = darshan_lookup_fd_ref(posix_runtime->fd_table, fd);
+    if(rec_ref)
+    {
+        tracker = malloc(sizeof(*tracker));
+        if(tracker)
+        {
+            tracker->tm1 = darshan_core_wtime();
+            tracker->aiocbp = aiocbp;
+            LL_PREPEND(rec_ref->aio_list, tracker);
+        }
+    }
+
+    return;
+}
+
+/* start the retirement thread; called with the module lock held */
+static void posix_start_retirer()
+{
+    if(posix_runtime->retirer_running || posix_runtime->retirer_stop)
+        return;
+
+    posix_runtime->retirer_pid = getpid();
+    if(pthread_create(&posix_runtime->retirer, NULL, posix_retirer_main,
+        NULL) == 0)
+        posix_runtime->retirer_running = 1;
+    else
+        posix_runtime->retirer_stop = 1;
+
+    return;
+}
+
+/* stop the retirement thread, if running; called with the module lock held,
+ * which is released while waiting for the thread to exit
+ */
+static void posix_stop_retirer()
+{
+    int running = posix_runtime->retirer_running;
+
+    posix_runtime->retirer_stop = 1;
+    posix_runtime->retirer_running = 0;
+
+    /* the retirement thread does not survive a fork */
+    if(running && posix_runtime->retirer_pid == getpid())
+    {
+        pthread_cond_signal(&posix_runtime->retirer_cond);
+        POSIX_UNLOCK();
+        pthread_join(posix_runtime->retirer, NULL);
+        POSIX_LOCK();
+    }
+
+    return;
+}
+
+struct posix_retire_batch
+{
+    double now;
+    int count;
+    void *recs[POSIX_RETIRE_BATCH];
+    struct posix_file_record_ref *refs[POSIX_RETIRE_BATCH];
+};
+
+static void posix_retire_flush(struct posix_retire_batch *batch)
+{
+    int i;
+
+    if(batch->count == 0)
+        return;
+
+    /* the records stay in place, so they are simply written as usual if
+     * they can not be staged
+     */
+    if(darshan_core_retire_records(DARSHAN_POSIX_MOD, batch->recs,
+        batch->count, sizeof(struct darshan_posix_file)) == 0)
+    {
+        for(i = 0; i < batch->count; i++)
+            batch->refs[i]->retired = 1;
+    }
+    batch->count = 0;
+
+    return;
+}
+
+static void posix_retire_record(void *rec_ref_p, void *user_ptr)
+{
+    struct posix_file_record_ref *rec_ref =
+        (struct posix_file_record_ref *)rec_ref_p;
+    struct posix_retire_batch *batch = (struct posix_retire_batch *)user_ptr;
+    double last;
+
+    /* only retire records of closed files that have been left untouched
+     * for the retirement time
+     */
+    if(rec_ref->retired || rec_ref->aio_list ||
+       rec_ref->open_scan == posix_runtime->retire_scan)
+        return;
+    last = rec_ref->last_meta_end;
+    if(rec_ref->last_read_end > last)
+        last = rec_ref->last_read_end;
+    if(rec_ref->last_write_end > last)
+        last = rec_ref->last_write_end;
+    if(batch->now - last < posix_runtime->retire_time)
+        return;
+
+    batch->recs[batch->count] = rec_ref->file_rec;
+    batch->refs[batch->count] = rec_ref;
+    if(++batch->count == POSIX_RETIRE_BATCH)
+        posix_retire_flush(batch);
+
+    return;
+}
+
+static void *posix_retirer_main(void *arg)
+{
+    struct darshan_fd_ref_table *fd_table;
+    struct posix_file_record_ref *rec_ref;
+    struct posix_retire_batch batch;
+    struct timespec ts;
+    double next;
+    int fd;
+
+    POSIX_LOCK();
+    while(!posix_runtime->retirer_stop)
+    {
+        /* scan twice per retirement time */
+        clock_gettime(CLOCK_REALTIME, &ts);
+        next = ts.tv_sec + ts.tv_nsec / 1e9 + posix_runtime->retire_time / 2;
+        ts.tv_sec = (time_t)next;
+        ts.tv_nsec = (long)((next - ts.tv_sec) * 1e9);
+        pthread_cond_timedwait(&posix_runtime->retirer_cond,
+            &posix_runtime_mutex, &ts);
+        if(posix_runtime->retirer_stop || posix_runtime->frozen)
+            break;
+
+        /* mark the records of files that are still open */
+        posix_runtime->retire_scan++;
+        fd_table = (struct darshan_fd_ref_table *)posix_runtime->fd_table;
+        for(fd = 0; fd_table && fd < fd_table->size; fd++)
+        {
+            rec_ref = fd_table->rec_refs[fd];
+            if(rec_ref)
+                rec_ref->open_scan = posix_runtime->retire_scan;
+        }
+
+        batch.now = darshan_core_wtime();
+        batch.count = 0;
+        darshan_iter_record_refs(posix_runtime->rec_id_hash,
+            &posix_retire_record, &batch);
+        posix_retire_flush(&batch);
+    }
+    POSIX_UNLOCK();
+
+    return(NULL);
+}
+
+static void posix_finalize_file_records(void *rec_ref_p, void *user_ptr)
+{
+    struct posix_file_record_ref *rec_ref =
+        (struct posix_file_record_ref *)rec_ref_p;
+
+    free(rec_ref->access_root);
+    free(rec_ref->stride_root);
+    return;
+}
+
+/* returns the calling thread's shard, allocating and registering a new one
+ * if needed. returns NULL if a shard can not be used (e.g., the POSIX module
+ * is not initialized, or shards have already been merged at shutdown).
+ */
+static struct posix_thread_shard *posix_thread_shard_get(void)
+{
+    struct posix_thread_shard *shard;
+
+    shard = pthread_getspecific(posix_shard_key);
+    if(shard)
+        return(shard);
+
+    POSIX_LOCK();
+    if(posix_runtime && !posix_runtime->frozen && !posix_runtime->shards_merged)
+    {
+        shard = malloc(sizeof(*shard));
+        if(shard)
+        {
+            memset(shard, 0, sizeof(*shard));
+            pthread_mutex_init(&shard->mutex, NULL);
+            if(pthread_setspecific(posix_shard_key, shard) == 0)
+                LL_PREPEND(posix_shard_list, shard);
+            else
+            {
+                pthread_mutex_destroy(&shard->mutex);
+                free(shard);
+                shard = NULL;
+            }
+        }
+    }
+    POSIX_UNLOCK();
+
+    return(shard);
+}
+
+/* acquires the calling thread's shard for recording a positional operation.
+ * returns 1 if the shard is held on return (released by exit), 0 if the
+ * caller should fall back to recording into the global records.
+ */
+static int posix_thread_shard_enter(void)
+{
+    struct posix_thread_shard *shard;
+
+    shard = posix_thread_shard_get();
+    if(!shard)
+        return(0);
+
+    pthread_mutex_lock(&shard->mutex);
+    if(shard->frozen)
+    {
+        pthread_mutex_unlock(&shard->mutex);
+        return(0);
+    }
+    shard->active = 1;
+
+    return(1);
+}
+
+/* releases the calling thread's shard, if held. returns 1 if the shard was
+ * held, 0 otherwise (i.e., the caller holds the module lock).
+ */
+static int posix_thread_shard_exit(void)
+{
+    struct posix_thread_shard *shard;
+
+    shard = pthread_getspecific(posix_shard_key);
+    if(!shard || !shard->active)
+        return(0);
+
+    shard->active = 0;
+    pthread_mutex_unlock(&shard->mutex);
+
+    return(1);
+}
+
+/* allocates a thread-private record mirroring the global record 'rec_ref'
+ * and adds it to the given shard. must be called holding the module lock.
+ */
+static struct posix_file_record_ref *posix_thread_shard_track_record(
+    struct posix_thread_shard *shard, struct posix_file_record_ref *rec_ref)
+{
+    struct posix_file_record_ref *shard_ref;
+    struct darshan_posix_file *file_rec;
+    int ret;
+
+    shard_ref = malloc(sizeof(*shard_ref));
+    file_rec = malloc(sizeof(*file_rec));
+    if(!shard_ref || !file_rec)
+    {
+        free(shard_ref);
+        free(file_rec);
+        return(NULL);
+    }
+    memset(shard_ref, 0, sizeof(*shard_ref));
+    memset(file_rec, 0, sizeof(*file_rec));
+
+    ret = darshan_add_record_ref(&(shard->rec_id_hash),
+        &(rec_ref->file_rec->base_rec.id), sizeof(darshan_record_id), shard_ref);
+    if(ret == 0)
+    {
+        free(shard_ref);
+        free(file_rec);
+        return(NULL);
+    }
+
+    /* copy over values that are consulted when instrumenting I/O */
+    file_rec->base_rec = rec_ref->file_rec->base_rec;
+    file_rec->counters[POSIX_MEM_ALIGNMENT] =
+        rec_ref->file_rec->counters[POSIX_MEM_ALIGNMENT];
+    file_rec->counters[POSIX_FILE_ALIGNMENT] =
+        rec_ref->file_rec->counters[POSIX_FILE_ALIGNMENT];
+    file_rec->counters[POSIX_MMAPS] = rec_ref->file_rec->counters[POSIX_MMAPS];
+    shard_ref->fs_type = rec_ref->fs_type;
+    shard_ref->file_rec = file_rec;
+
+    return(shard_ref);
+}
+
+/* maps 'fd' to the corresponding thread-private record in 'shard', which must
+ * be held by the calling thread. the global fd table is only consulted (under
+ * the module lock) if this thread has no valid cached mapping for 'fd'.
+ */
+static struct posix_file_record_ref *posix_thread_shard_lookup(
+    struct posix_thread_shard *shard, int fd)
+{
+    struct posix_shard_fd_ref *fd_ref;
+    struct posix_file_record_ref *rec_ref = NULL;
+    struct posix_file_record_ref *shard_ref = NULL;
+    uint64_t epoch;
+    int ret;
+
+    fd_ref = darshan_lookup_fd_ref(shard->fd_table, fd);
+    if(fd_ref && fd_ref->fd_epoch == atomic_load(&posix_fd_epoch))
+        return(fd_ref->rec_ref);
+
+    POSIX_LOCK();
+    epoch = atomic_load(&posix_fd_epoch);
+    if(posix_runtime && !posix_runtime->frozen)
+    {
+        rec_ref = darshan_lookup_fd_ref(posix_runtime->fd_table, fd);
+        if(!rec_ref)
+            posix_fd_set_untracked(fd, 1);
+    }
     if(rec_ref)
     {
-        LL_FOREACH_SAFE(rec_ref->aio_list, iter, tmp)
+        shard_ref = darshan_lookup_record_ref(shard->rec_id_hash,
+            &(rec_ref->file_rec->base_rec.id), sizeof(darshan_record_id));
+        if(!shard_ref)
+            shard_ref = posix_thread_shard_track_record(shard, rec_ref);
+    }
+    POSIX_UNLOCK();
+
+    if(!shard_ref)
+    {
+        /* drop any stale mapping for this fd */
+        if(fd_ref)
         {
-            if(iter->aiocbp == aiocbp)
-            {
-                LL_DELETE(rec_ref->aio_list, iter);
-                tracker = iter;
-                break;
-            }
+            darshan_delete_fd_ref(&(shard->fd_table), fd);
+            free(fd_ref);
         }
+        return(NULL);
     }
 
-    return(tracker);
+    if(!fd_ref)
+    {
+        fd_ref = malloc(sizeof(*fd_ref));
+        if(!fd_ref)
+            return(shard_ref);
+        ret = darshan_add_fd_ref(&(shard->fd_table), fd, fd_ref);
+        if(ret == 0)
+        {
+            free(fd_ref);
+            return(shard_ref);
+        }
+    }
+    fd_ref->rec_ref = shard_ref;
+    fd_ref->fd_epoch = epoch;
+
+    return(shard_ref);
 }
 
-/* adds a tracker for the given aio operation */
-static void posix_aio_tracker_add(int fd, void *aiocbp)
+/* maps 'fd' to the record that a data operation should be recorded into,
+ * which is either a thread-private record (if the calling thread holds its
+ * shard) or the global record
+ */
+static struct posix_file_record_ref *posix_lookup_io_rec_ref(int fd)
 {
-    struct posix_aio_tracker* tracker;
+    struct posix_thread_shard *shard = NULL;
     struct posix_file_record_ref *rec_ref;
 
-    rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash, &fd, sizeof(int));
+    if(posix_thread_shards)
+        shard = pthread_getspecific(posix_shard_key);
+    if(shard && shard->active)
+        return(posix_thread_shard_lookup(shard, fd));
+
+    rec_ref = darshan_lookup_fd_ref(posix_runtime->fd_table, fd);
+    if(!rec_ref)
+        posix_fd_set_untracked(fd, 1);
+    return(rec_ref);
+}
+
+/* folds a thread-private record into its global record and frees it */
+static void posix_thread_shard_fold_record(void *rec_ref_p, void *user_ptr)
+{
+    struct posix_file_record_ref *shard_ref =
+        (struct posix_file_record_ref *)rec_ref_p;
+    struct posix_file_record_ref *rec_ref = NULL;
+    struct darshan_posix_file tmp_rec;
+
+    if(posix_runtime)
+        rec_ref = darshan_lookup_record_ref(posix_runtime->rec_id_hash,
+            &(shard_ref->file_rec->base_rec.id), sizeof(darshan_record_id));
     if(rec_ref)
     {
-        tracker = malloc(sizeof(*tracker));
-        if(tracker)
-        {
-            tracker->tm1 = darshan_core_wtime();
-            tracker->aiocbp = aiocbp;
-            LL_PREPEND(rec_ref->aio_list, tracker);
-        }
+        /* the global record is passed as the first input so that it
+         * provides the mode, alignment, and rename values
+         */
+        tmp_rec = *(rec_ref->file_rec);
+        posix_record_merge(&tmp_rec, shard_ref->file_rec);
+        *(rec_ref->file_rec) = *(shard_ref->file_rec);
+        rec_ref->file_rec->base_rec.rank = tmp_rec.base_rec.rank;
     }
 
+    posix_finalize_file_records(shard_ref, NULL);
+    free(shard_ref->file_rec);
     return;
 }
 
-static void posix_finalize_file_records(void *rec_ref_p, void *user_ptr)
+/* merges all thread shards into the global records, after which the shards
+ * are frozen and all further instrumentation uses the global records. this
+ * must be called without holding the module lock.
+ */
+static void posix_merge_thread_shards()
 {
-    struct posix_file_record_ref *rec_ref =
-        (struct posix_file_record_ref *)rec_ref_p;
+    struct posix_thread_shard *shard;
+    struct posix_thread_shard *shard_list;
+
+    /* prevent new shards from being created while we merge */
+    POSIX_LOCK();
+    if(posix_runtime)
+        posix_runtime->shards_merged = 1;
+    shard_list = posix_shard_list;
+    POSIX_UNLOCK();
+
+    /* shards are only ever prepended to the list, so it is safe to
+     * traverse it without the module lock
+     */
+    LL_FOREACH(shard_list, shard)
+    {
+        pthread_mutex_lock(&shard->mutex);
+        POSIX_LOCK();
+        darshan_iter_record_refs(shard->rec_id_hash,
+            &posix_thread_shard_fold_record, NULL);
+        POSIX_UNLOCK();
+        darshan_clear_fd_refs(&(shard->fd_table), 1);
+        darshan_clear_record_refs(&(shard->rec_id_hash), 1);
+        shard->frozen = 1;
+        pthread_mutex_unlock(&shard->mutex);
+    }
 
-    tdestroy(rec_ref->access_root, free);
-    tdestroy(rec_ref->stride_root, free);
     return;
 }
 
-#ifdef HAVE_MPI
-static void posix_record_reduction_op(void* infile_v, void* inoutfile_v,
-    int *len, MPI_Datatype *datatype)
+/* merges POSIX record 'infile' into 'inoutfile', collapsing counters as
+ * appropriate (sums, min/max timestamps, common values, etc.). note that
+ * the rank of the resulting record is set to -1 (i.e., shared).
+ */
+static void posix_record_merge(struct darshan_posix_file *infile,
+    struct darshan_posix_file *inoutfile)
 {
     struct darshan_posix_file tmp_file;
-    struct darshan_posix_file *infile = infile_v;
-    struct darshan_posix_file *inoutfile = inoutfile_v;
-    int i, j, k;
+    int j, k;
 
-    for(i=0; i<*len; i++)
-    {
-        memset(&tmp_file, 0, sizeof(struct darshan_posix_file));
-        tmp_file.base_rec.id = infile->base_rec.id;
-        tmp_file.base_rec.rank = -1;
+    memset(&tmp_file, 0, sizeof(struct darshan_posix_file));
+    tmp_file.base_rec.id = infile->base_rec.id;
+    tmp_file.base_rec.rank = -1;
 
-        /* sum */
-        for(j=POSIX_OPENS; j<=POSIX_RENAME_TARGETS; j++)
-        {
-            tmp_file.counters[j] = infile->counters[j] + inoutfile->counters[j];
-            if(tmp_file.counters[j] < 0) /* make sure invalid counters are -1 exactly */
-                tmp_file.counters[j] = -1;
-        }
+    /* sum */
+    for(j=POSIX_OPENS; j<=POSIX_RENAME_TARGETS; j++)
+    {
+        tmp_file.counters[j] = infile->counters[j] + inoutfile->counters[j];
+        if(tmp_file.counters[j] < 0) /* make sure invalid counters are -1 exactly */
+            tmp_file.counters[j] = -1;
+    }
 
-        tmp_file.counters[POSIX_RENAMED_FROM] = infile->counters[POSIX_RENAMED_FROM];
-        tmp_file.counters[POSIX_MODE] = infile->counters[POSIX_MODE];
+    tmp_file.counters[POSIX_RENAMED_FROM] = infile->counters[POSIX_RENAMED_FROM];
+    tmp_file.counters[POSIX_MODE] = infile->counters[POSIX_MODE];
 
-        /* sum */
-        for(j=POSIX_BYTES_READ; j<=POSIX_BYTES_WRITTEN; j++)
-        {
-            tmp_file.counters[j] = infile->counters[j] + inoutfile->counters[j];
-        }
+    /* sum */
+    for(j=POSIX_BYTES_READ; j<=POSIX_BYTES_WRITTEN; j++)
+    {
+        tmp_file.counters[j] = infile->counters[j] + inoutfile->counters[j];
+    }
 
-        /* max */
-        for(j=POSIX_MAX_BYTE_READ; j<=POSIX_MAX_BYTE_WRITTEN; j++)
-        {
-            tmp_file.counters[j] = (
-                (infile->counters[j] > inoutfile->counters[j]) ?
-                infile->counters[j] :
-                inoutfile->counters[j]);
-        }
+    /* max */
+    for(j=POSIX_MAX_BYTE_READ; j<=POSIX_MAX_BYTE_WRITTEN; j++)
+    {
+        tmp_file.counters[j] = (
+            (infile->counters[j] > inoutfile->counters[j]) ?
+            infile->counters[j] :
+            inoutfile->counters[j]);
+    }
 
-        /* sum */
-        for(j=POSIX_CONSEC_READS; j<=POSIX_MEM_NOT_ALIGNED; j++)
-        {
-            tmp_file.counters[j] = infile->counters[j] + inoutfile->counters[j];
-        }
+    /* sum */
+    for(j=POSIX_CONSEC_READS; j<=POSIX_MEM_NOT_ALIGNED; j++)
+    {
+        tmp_file.counters[j] = infile->counters[j] + inoutfile->counters[j];
+    }
 
-        tmp_file.counters[POSIX_MEM_ALIGNMENT] = infile->counters[POSIX_MEM_ALIGNMENT];
+    tmp_file.counters[POSIX_MEM_ALIGNMENT] = infile->counters[POSIX_MEM_ALIGNMENT];
 
-        /* sum */
-        for(j=POSIX_FILE_NOT_ALIGNED; j<=POSIX_FILE_NOT_ALIGNED; j++)
-        {
-            tmp_file.counters[j] = infile->counters[j] + inoutfile->counters[j];
-        }
+    /* sum */
+    for(j=POSIX_FILE_NOT_ALIGNED; j<=POSIX_FILE_NOT_ALIGNED; j++)
+    {
+        tmp_file.counters[j] = infile->counters[j] + inoutfile->counters[j];
+    }
 
-        tmp_file.counters[POSIX_FILE_ALIGNMENT] = infile->counters[POSIX_FILE_ALIGNMENT];
+    tmp_file.counters[POSIX_FILE_ALIGNMENT] = infile->counters[POSIX_FILE_ALIGNMENT];
 
-        /* skip POSIX_MAX_*_TIME_SIZE; handled in floating point section */
+    /* skip POSIX_MAX_*_TIME_SIZE; handled in floating point section */
 
-        for(j=POSIX_SIZE_READ_0_100; j<=POSIX_SIZE_WRITE_1G_PLUS; j++)
-        {
-            tmp_file.counters[j] = infile->counters[j] + inoutfile->counters[j];
-        }
+    for(j=POSIX_SIZE_READ_0_100; j<=POSIX_SIZE_WRITE_1G_PLUS; j++)
+    {
+        tmp_file.counters[j] = infile->counters[j] + inoutfile->counters[j];
+    }
 
-        /* first collapse any duplicates */
-        for(j=POSIX_STRIDE1_STRIDE; j<=POSIX_STRIDE4_STRIDE; j++)
+    /* first collapse any duplicates */
+    for(j=POSIX_STRIDE1_STRIDE; j<=POSIX_STRIDE4_STRIDE; j++)
+    {
+        for(k=POSIX_STRIDE1_STRIDE; k<=POSIX_STRIDE4_STRIDE; k++)
         {
-            for(k=POSIX_STRIDE1_STRIDE; k<=POSIX_STRIDE4_STRIDE; k++)
+            if(infile->counters[j] == inoutfile->counters[k])
             {
-                if(infile->counters[j] == inoutfile->counters[k])
-                {
-                    infile->counters[j+4] += inoutfile->counters[k+4];
-                    inoutfile->counters[k] = 0;
-                    inoutfile->counters[k+4] = 0;
-                }
+                infile->counters[j+4] += inoutfile->counters[k+4];
+                inoutfile->counters[k] = 0;
+                inoutfile->counters[k+4] = 0;
             }
         }
+    }
 
-        /* first set */
-        for(j=POSIX_STRIDE1_STRIDE; j<=POSIX_STRIDE4_STRIDE; j++)
-        {
-            DARSHAN_UPDATE_COMMON_VAL_COUNTERS(
-                &(tmp_file.counters[POSIX_STRIDE1_STRIDE]),
-                &(tmp_file.counters[POSIX_STRIDE1_COUNT]),
-                &infile->counters[j], 1, infile->counters[j+4], 1);
-        }
-        /* second set */
-        for(j=POSIX_STRIDE1_STRIDE; j<=POSIX_STRIDE4_STRIDE; j++)
-        {
-            DARSHAN_UPDATE_COMMON_VAL_COUNTERS(
-                &(tmp_file.counters[POSIX_STRIDE1_STRIDE]),
-                &(tmp_file.counters[POSIX_STRIDE1_COUNT]),
-                &inoutfile->counters[j], 1, inoutfile->counters[j+4], 1);
-        }
+    /* first set */
+    for(j=POSIX_STRIDE1_STRIDE; j<=POSIX_STRIDE4_STRIDE; j++)
+    {
+        DARSHAN_UPDATE_COMMON_VAL_COUNTERS(
+            &(tmp_file.counters[POSIX_STRIDE1_STRIDE]),
+            &(tmp_file.counters[POSIX_STRIDE1_COUNT]),
+            &infile->counters[j], 1, infile->counters[j+4], 1);
+    }
+    /* second set */
+    for(j=POSIX_STRIDE1_STRIDE; j<=POSIX_STRIDE4_STRIDE; j++)
+    {
+        DARSHAN_UPDATE_COMMON_VAL_COUNTERS(
+            &(tmp_file.counters[POSIX_STRIDE1_STRIDE]),
+            &(tmp_file.counters[POSIX_STRIDE1_COUNT]),
+            &inoutfile->counters[j], 1, inoutfile->counters[j+4], 1);
+    }
 
-        /* same for access counts */
+    /* same for access counts */
 
-        /* first collapse any duplicates */
-        for(j=POSIX_ACCESS1_ACCESS; j<=POSIX_ACCESS4_ACCESS; j++)
+    /* first collapse any duplicates */
+    for(j=POSIX_ACCESS1_ACCESS; j<=POSIX_ACCESS4_ACCESS; j++)
+    {
+        for(k=POSIX_ACCESS1_ACCESS; k<=POSIX_ACCESS4_ACCESS; k++)
         {
-            for(k=POSIX_ACCESS1_ACCESS; k<=POSIX_ACCESS4_ACCESS; k++)
+            if(infile->counters[j] == inoutfile->counters[k])
             {
-                if(infile->counters[j] == inoutfile->counters[k])
-                {
-                    infile->counters[j+4] += inoutfile->counters[k+4];
-                    inoutfile->counters[k] = 0;
-                    inoutfile->counters[k+4] = 0;
-                }
+                infile->counters[j+4] += inoutfile->counters[k+4];
+                inoutfile->counters[k] = 0;
+                inoutfile->counters[k+4] = 0;
             }
         }
+    }
 
-        /* first set */
-        for(j=POSIX_ACCESS1_ACCESS; j<=POSIX_ACCESS4_ACCESS; j++)
-        {
-            DARSHAN_UPDATE_COMMON_VAL_COUNTERS(
-                &(tmp_file.counters[POSIX_ACCESS1_ACCESS]),
-                &(tmp_file.counters[POSIX_ACCESS1_COUNT]),
-                &infile->counters[j], 1, infile->counters[j+4], 1);
-        }
-        /* second set */
-        for(j=POSIX_ACCESS1_ACCESS; j<=POSIX_ACCESS4_ACCESS; j++)
-        {
-            DARSHAN_UPDATE_COMMON_VAL_COUNTERS(
-                &(tmp_file.counters[POSIX_ACCESS1_ACCESS]),
-                &(tmp_file.counters[POSIX_ACCESS1_COUNT]),
-                &inoutfile->counters[j], 1, inoutfile->counters[j+4], 1);
-        }
-
-        /* min non-zero (if available) value */
-        for(j=POSIX_F_OPEN_START_TIMESTAMP; j<=POSIX_F_CLOSE_START_TIMESTAMP; j++)
-        {
-            if((infile->fcounters[j] < inoutfile->fcounters[j] &&
-               infile->fcounters[j] > 0) || inoutfile->fcounters[j] == 0)
-                tmp_file.fcounters[j] = infile->fcounters[j];
-            else
-                tmp_file.fcounters[j] = inoutfile->fcounters[j];
-        }
-
-        /* max */
-        for(j=POSIX_F_OPEN_END_TIMESTAMP; j<=POSIX_F_CLOSE_END_TIMESTAMP; j++)
-        {
-            if(infile->fcounters[j] > inoutfile->fcounters[j])
-                tmp_file.fcounters[j] = infile->fcounters[j];
-            else
-                tmp_file.fcounters[j] = inoutfile->fcounters[j];
-        }
-
-        /* sum */
-        for(j=POSIX_F_READ_TIME; j<=POSIX_F_META_TIME; j++)
-        {
-            tmp_file.fcounters[j] = infile->fcounters[j] + inoutfile->fcounters[j];
-        }
-
-        /* max (special case) */
-        if(infile->fcounters[POSIX_F_MAX_READ_TIME] >
-            inoutfile->fcounters[POSIX_F_MAX_READ_TIME])
-        {
-            tmp_file.fcounters[POSIX_F_MAX_READ_TIME] =
-                infile->fcounters[POSIX_F_MAX_READ_TIME];
-            tmp_file.counters[POSIX_MAX_READ_TIME_SIZE] =
-                infile->counters[POSIX_MAX_READ_TIME_SIZE];
-        }
-        else
-        {
-            tmp_file.fcounters[POSIX_F_MAX_READ_TIME] =
-                inoutfile->fcounters[POSIX_F_MAX_READ_TIME];
-            tmp_file.counters[POSIX_MAX_READ_TIME_SIZE] =
-                inoutfile->counters[POSIX_MAX_READ_TIME_SIZE];
-        }
-
-        if(infile->fcounters[POSIX_F_MAX_WRITE_TIME] >
-            inoutfile->fcounters[POSIX_F_MAX_WRITE_TIME])
-        {
-            tmp_file.fcounters[POSIX_F_MAX_WRITE_TIME] =
-                infile->fcounters[POSIX_F_MAX_WRITE_TIME];
-            tmp_file.counters[POSIX_MAX_WRITE_TIME_SIZE] =
-                infile->counters[POSIX_MAX_WRITE_TIME_SIZE];
-        }
-        else
-        {
-            tmp_file.fcounters[POSIX_F_MAX_WRITE_TIME] =
-                inoutfile->fcounters[POSIX_F_MAX_WRITE_TIME];
-            tmp_file.counters[POSIX_MAX_WRITE_TIME_SIZE] =
-                inoutfile->counters[POSIX_MAX_WRITE_TIME_SIZE];
-        }
+    /* first set */
+    for(j=POSIX_ACCESS1_ACCESS; j<=POSIX_ACCESS4_ACCESS; j++)
+    {
+        DARSHAN_UPDATE_COMMON_VAL_COUNTERS(
+            &(tmp_file.counters[POSIX_ACCESS1_ACCESS]),
+            &(tmp_file.counters[POSIX_ACCESS1_COUNT]),
+            &infile->counters[j], 1, infile->counters[j+4], 1);
+    }
+    /* second set */
+    for(j=POSIX_ACCESS1_ACCESS; j<=POSIX_ACCESS4_ACCESS; j++)
+    {
+        DARSHAN_UPDATE_COMMON_VAL_COUNTERS(
+            &(tmp_file.counters[POSIX_ACCESS1_ACCESS]),
+            &(tmp_file.counters[POSIX_ACCESS1_COUNT]),
+            &inoutfile->counters[j], 1, inoutfile->counters[j+4], 1);
+    }
 
-        /* min (zeroes are ok here; some procs don't do I/O) */
-        if(infile->fcounters[POSIX_F_FASTEST_RANK_TIME] <
-           inoutfile->fcounters[POSIX_F_FASTEST_RANK_TIME])
-        {
-            tmp_file.counters[POSIX_FASTEST_RANK] =
-                infile->counters[POSIX_FASTEST_RANK];
-            tmp_file.counters[POSIX_FASTEST_RANK_BYTES] =
-                infile->counters[POSIX_FASTEST_RANK_BYTES];
-            tmp_file.fcounters[POSIX_F_FASTEST_RANK_TIME] =
-                infile->fcounters[POSIX_F_FASTEST_RANK_TIME];
-        }
+    /* min non-zero (if available) value */
+    for(j=POSIX_F_OPEN_START_TIMESTAMP; j<=POSIX_F_CLOSE_START_TIMESTAMP; j++)
+    {
+        if((infile->fcounters[j] < inoutfile->fcounters[j] &&
+           infile->fcounters[j] > 0) || inoutfile->fcounters[j] == 0)
+            tmp_file.fcounters[j] = infile->fcounters[j];
         else
-        {
-            tmp_file.counters[POSIX_FASTEST_RANK] =
-                inoutfile->counters[POSIX_FASTEST_RANK];
-            tmp_file.counters[POSIX_FASTEST_RANK_BYTES] =
-                inoutfile->counters[POSIX_FASTEST_RANK_BYTES];
-            tmp_file.fcounters[POSIX_F_FASTEST_RANK_TIME] =
-                inoutfile->fcounters[POSIX_F_FASTEST_RANK_TIME];
-        }
+            tmp_file.fcounters[j] = inoutfile->fcounters[j];
+    }
 
-        /* max */
-        if(infile->fcounters[POSIX_F_SLOWEST_RANK_TIME] >
-           inoutfile->fcounters[POSIX_F_SLOWEST_RANK_TIME])
-        {
-            tmp_file.counters[POSIX_SLOWEST_RANK] =
-                infile->counters[POSIX_SLOWEST_RANK];
-            tmp_file.counters[POSIX_SLOWEST_RANK_BYTES] =
-                infile->counters[POSIX_SLOWEST_RANK_BYTES];
-            tmp_file.fcounters[POSIX_F_SLOWEST_RANK_TIME] =
-                infile->fcounters[POSIX_F_SLOWEST_RANK_TIME];
-        }
+    /* max */
+    for(j=POSIX_F_OPEN_END_TIMESTAMP; j<=POSIX_F_CLOSE_END_TIMESTAMP; j++)
+    {
+        if(infile->fcounters[j] > inoutfile->fcounters[j])
+            tmp_file.fcounters[j] = infile->fcounters[j];
         else
-        {
-            tmp_file.counters[POSIX_SLOWEST_RANK] =
-                inoutfile->counters[POSIX_SLOWEST_RANK];
-            tmp_file.counters[POSIX_SLOWEST_RANK_BYTES] =
-                inoutfile->counters[POSIX_SLOWEST_RANK_BYTES];
-            tmp_file.fcounters[POSIX_F_SLOWEST_RANK_TIME] =
-                inoutfile->fcounters[POSIX_F_SLOWEST_RANK_TIME];
-        }
-
-        /* update pointers */
-        *inoutfile = tmp_file;
-        inoutfile++;
-        infile++;
+            tmp_file.fcounters[j] = inoutfile->fcounters[j];
     }
 
-    return;
-}
-
-static void posix_shared_record_variance(MPI_Comm mod_comm,
-    struct darshan_posix_file *inrec_array, struct darshan_posix_file *outrec_array,
-    int shared_rec_count)
-{
-    MPI_Datatype var_dt;
-    MPI_Op var_op;
-    int i;
-    struct darshan_variance_dt *var_send_buf = NULL;
-    struct darshan_variance_dt *var_recv_buf = NULL;
-
-    PMPI_Type_contiguous(sizeof(struct darshan_variance_dt),
-        MPI_BYTE, &var_dt);
-    PMPI_Type_commit(&var_dt);
-
-    PMPI_Op_create(darshan_variance_reduce, 1, &var_op);
-
-    var_send_buf = malloc(shared_rec_count * sizeof(struct darshan_variance_dt));
-    if(!var_send_buf)
-        return;
-
-    if(my_rank == 0)
+    /* sum */
+    for(j=POSIX_F_READ_TIME; j<=POSIX_F_META_TIME; j++)
     {
-        var_recv_buf = malloc(shared_rec_count * sizeof(struct darshan_variance_dt));
-
-        if(!var_recv_buf)
-            return;
+        tmp_file.fcounters[j] = infile->fcounters[j] + inoutfile->fcounters[j];
     }
 
-    /* get total i/o time variances for shared records */
-
-    for(i=0; i<shared_rec_count; i++)
+    /* max (special case) */
+    if(infile->fcounters[POSIX_F_MAX_READ_TIME] >
+        inoutfile->fcounters[POSIX_F_MAX_READ_TIME])
     {
-        var_send_buf[i].n = 1;
-        var_send_buf[i].S = 0;
-        var_send_buf[i].T = inrec_array[i].fcounters[POSIX_F_READ_TIME] +
-                            inrec_array[i].fcounters[POSIX_F_WRITE_TIME] +
-                            inrec_array[i].fcounters[POSIX_F_META_TIME];
+        tmp_file.fcounters[POSIX_F_MAX_READ_TIME] =
+            infile->fcounters[POSIX_F_MAX_READ_TIME];
+        tmp_file.counters[POSIX_MAX_READ_TIME_SIZE] =
+            infile->counters[POSIX_MAX_READ_TIME_SIZE];
+    }
+    else
+    {
+        tmp_file.fcounters[POSIX_F_MAX_READ_TIME] =
+            inoutfile->fcounters[POSIX_F_MAX_READ_TIME];
+        tmp_file.counters[POSIX_MAX_READ_TIME_SIZE] =
+            inoutfile->counters[POSIX_MAX_READ_TIME_SIZE];
     }
 
-    PMPI_Reduce(var_send_buf, var_recv_buf, shared_rec_count,
-        var_dt, var_op, 0, mod_comm);
-
-    if(my_rank == 0)
+    if(infile->fcounters[POSIX_F_MAX_WRITE_TIME] >
+        inoutfile->fcounters[POSIX_F_MAX_WRITE_TIME])
     {
-        for(i=0; i<shared_rec_count; i++)
-        {
-            outrec_array[i].fcounters[POSIX_F_VARIANCE_RANK_TIME] =
-                (var_recv_buf[i].S / var_recv_buf[i].n);
-        }
+        tmp_file.fcounters[POSIX_F_MAX_WRITE_TIME] =
+            infile->fcounters[POSIX_F_MAX_WRITE_TIME];
+        tmp_file.counters[POSIX_MAX_WRITE_TIME_SIZE] =
+            infile->counters[POSIX_MAX_WRITE_TIME_SIZE];
+    }
+    else
+    {
+        tmp_file.fcounters[POSIX_F_MAX_WRITE_TIME] =
+            inoutfile->fcounters[POSIX_F_MAX_WRITE_TIME];
+        tmp_file.counters[POSIX_MAX_WRITE_TIME_SIZE] =
+            inoutfile->counters[POSIX_MAX_WRITE_TIME_SIZE];
     }
 
-    /* get total bytes moved variances for shared records */
+    /* min (zeroes are ok here; some procs don't do I/O) */
+    if(infile->fcounters[POSIX_F_FASTEST_RANK_TIME] <
+       inoutfile->fcounters[POSIX_F_FASTEST_RANK_TIME])
+    {
+        tmp_file.counters[POSIX_FASTEST_RANK] =
+            infile->counters[POSIX_FASTEST_RANK];
+        tmp_file.counters[POSIX_FASTEST_RANK_BYTES] =
+            infile->counters[POSIX_FASTEST_RANK_BYTES];
+        tmp_file.fcounters[POSIX_F_FASTEST_RANK_TIME] =
+            infile->fcounters[POSIX_F_FASTEST_RANK_TIME];
+    }
+    else
+    {
+        tmp_file.counters[POSIX_FASTEST_RANK] =
+            inoutfile->counters[POSIX_FASTEST_RANK];
+        tmp_file.counters[POSIX_FASTEST_RANK_BYTES] =
+            inoutfile->counters[POSIX_FASTEST_RANK_BYTES];
+        tmp_file.fcounters[POSIX_F_FASTEST_RANK_TIME] =
+            inoutfile->fcounters[POSIX_F_FASTEST_RANK_TIME];
+    }
 
-    for(i=0; i<shared_rec_count; i++)
+    /* max */
+    if(infile->fcounters[POSIX_F_SLOWEST_RANK_TIME] >
+       inoutfile->fcounters[POSIX_F_SLOWEST_RANK_TIME])
     {
-        var_send_buf[i].n = 1;
-        var_send_buf[i].S = 0;
-        var_send_buf[i].T = (double)
-                            inrec_array[i].counters[POSIX_BYTES_READ] +
-                            inrec_array[i].counters[POSIX_BYTES_WRITTEN];
+        tmp_file.counters[POSIX_SLOWEST_RANK] =
+            infile->counters[POSIX_SLOWEST_RANK];
+        tmp_file.counters[POSIX_SLOWEST_RANK_BYTES] =
+            infile->counters[POSIX_SLOWEST_RANK_BYTES];
+        tmp_file.fcounters[POSIX_F_SLOWEST_RANK_TIME] =
+            infile->fcounters[POSIX_F_SLOWEST_RANK_TIME];
+    }
+    else
+    {
+        tmp_file.counters[POSIX_SLOWEST_RANK] =
+            inoutfile->counters[POSIX_SLOWEST_RANK];
+        tmp_file.counters[POSIX_SLOWEST_RANK_BYTES] =
+            inoutfile->counters[POSIX_SLOWEST_RANK_BYTES];
+        tmp_file.fcounters[POSIX_F_SLOWEST_RANK_TIME] =
+            inoutfile->fcounters[POSIX_F_SLOWEST_RANK_TIME];
     }
 
-    PMPI_Reduce(var_send_buf, var_recv_buf, shared_rec_count,
-        var_dt, var_op, 0, mod_comm);
+    *inoutfile = tmp_file;
 
-    if(my_rank == 0)
+    return;
+}
+
+#ifdef HAVE_MPI
+static void posix_record_reduction_op(void* infile_v, void* inoutfile_v,
+    int *len, MPI_Datatype *datatype)
+{
+    struct darshan_posix_file *infile = infile_v;
+    struct darshan_posix_file *inoutfile = inoutfile_v;
+    int i;
+
+    for(i=0; i<*len; i++)
     {
-        for(i=0; i<shared_rec_count; i++)
-        {
-            outrec_array[i].fcounters[POSIX_F_VARIANCE_RANK_BYTES] =
-                (var_recv_buf[i].S / var_recv_buf[i].n);
-        }
-    }
+        posix_record_merge(infile, inoutfile);
 
-    PMPI_Type_free(&var_dt);
-    PMPI_Op_free(&var_op);
-    free(var_send_buf);
-    free(var_recv_buf);
+        /* update pointers */
+        inoutfile++;
+        infile++;
+    }
 
     return;
 }
+
 #endif
 
-char *darshan_posix_lookup_record_name(int fd)
+int darshan_posix_lookup_record_name(int fd, char *rec_name, size_t len)
 {
     struct posix_file_record_ref *rec_ref;
-    char *rec_name = NULL;
+    int ret = 0;
 
     POSIX_LOCK();
     if(posix_runtime)
     {
-        rec_ref = darshan_lookup_record_ref(posix_runtime->fd_hash,
-            &fd, sizeof(fd));
+        rec_ref = darshan_lookup_fd_ref(posix_runtime->fd_table, fd);
         if(rec_ref)
-            rec_name = darshan_core_lookup_record_name(rec_ref->file_rec->base_rec.id);
+            ret = darshan_core_lookup_record_name(
+                rec_ref->file_rec->base_rec.id, rec_name, len);
     }
     POSIX_UNLOCK();
 
-    return(rec_name);
+    return(ret);
 }
 
 struct darshan_posix_file *darshan_posix_rec_id_to_file(darshan_record_id rec_id)
@@ -2433,13 +3447,16 @@ struct darshan_posix_file *darshan_posix_rec_id_to_file(darshan_record_id rec_id
         return(NULL);
 }
 
-/* posix module shutdown benchmark routine */
-void darshan_posix_shutdown_bench_setup(int test_case)
+/* posix module shutdown benchmark routine: creates records for 'nfiles'
+ * files on this rank, the first 'nshared' of which are opened by every rank,
+ * with 'nwrites' writes (and DXT segments, if DXT is enabled) per file
+ */
+void darshan_posix_shutdown_bench_setup(int nfiles, int nshared, int nwrites)
 {
     char filepath[256];
-    int *fd_array;
     int64_t *size_array;
-    int i;
+    int fd;
+    int i, j;
 
     if(posix_runtime)
         posix_cleanup();
@@ -2447,59 +3464,29 @@ void darshan_posix_shutdown_bench_setup(int test_case)
     posix_runtime_initialize();
 
     srand(my_rank);
-    fd_array = malloc(1024 * sizeof(int));
     size_array = malloc(DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT * sizeof(int64_t));
-    assert(fd_array && size_array);
+    assert(size_array);
 
-    for(i = 0; i < 1024; i++)
-        fd_array[i] = i;
     for(i = 0; i < DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT; i++)
         size_array[i] = rand();
 
-    switch(test_case)
+    for(i = 0; i < nfiles; i++)
     {
-        case 1: /* single file-per-process */
-            snprintf(filepath, 256, "fpp-0_rank-%d", my_rank);
-
-            POSIX_RECORD_OPEN(fd_array[0], filepath, 777, 0, 1);
-            POSIX_RECORD_WRITE(size_array[0], fd_array[0], 0, 0, 1, 1, 2);
-
-            break;
-        case 2: /* single shared file */
-            snprintf(filepath, 256, "shared-0");
-
-            POSIX_RECORD_OPEN(fd_array[0], filepath, 777, 0, 1);
-            POSIX_RECORD_WRITE(size_array[0], fd_array[0], 0, 0, 1, 1, 2);
-
-            break;
-        case 3: /* 1024 unique files per proc */
-            for(i = 0; i < 1024; i++)
-            {
-                snprintf(filepath, 256, "fpp-%d_rank-%d", i , my_rank);
-
-                POSIX_RECORD_OPEN(fd_array[i], filepath, 777, 0, 1);
-                POSIX_RECORD_WRITE(size_array[i % DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT],
-                    fd_array[i], 0, 0, 1, 1, 2);
-            }
-
-            break;
-        case 4: /* 1024 shared files per proc */
-            for(i = 0; i < 1024; i++)
-            {
-                snprintf(filepath, 256, "shared-%d", i);
-
-                POSIX_RECORD_OPEN(fd_array[i], filepath, 777, 0, 1);
-                POSIX_RECORD_WRITE(size_array[i % DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT],
-                    fd_array[i], 0, 0, 1, 1, 2);
-            }
+        if(i < nshared)
+            snprintf(filepath, 256, "shared-%d", i);
+        else
+            snprintf(filepath, 256, "fpp-%d_rank-%d", i, my_rank);
 
-            break;
-        default:
-            fprintf(stderr, "Error: invalid Darshan benchmark test case.\n");
-            return;
+        /* a file is done with before the next one is opened, so a small
+         * set of descriptors is reused to keep the fd table small
+         */
+        fd = i % 1024;
+        POSIX_RECORD_OPEN(fd, filepath, 777, 0, 1);
+        for(j = 0; j < nwrites; j++)
+            POSIX_RECORD_WRITE(size_array[(i + j) % DARSHAN_COMMON_VAL_MAX_RUNTIME_COUNT],
+                fd, 0, 0, 1, 1, 2, 1);
     }
 
-    free(fd_array);
     free(size_array);
 
     return;
@@ -2522,13 +3509,18 @@ static void posix_mpi_redux(
     double posix_time;
     struct darshan_posix_file *red_send_buf = NULL;
     struct darshan_posix_file *red_recv_buf = NULL;
-    MPI_Datatype red_type;
-    MPI_Op red_op;
+    double *var_vals = NULL;
+    int ret;
     int i;
 
+    /* fold any per-thread records in before reducing */
+    if(posix_thread_shards)
+        posix_merge_thread_shards();
+
     POSIX_LOCK();
     assert(posix_runtime);
 
+    posix_stop_retirer();
     posix_rec_count = posix_runtime->file_rec_count;
 
     /* necessary initialization of shared records */
@@ -2575,40 +3567,51 @@ static void posix_mpi_redux(
     /* make send_buf point to the shared files at the end of sorted array */
     red_send_buf = &(posix_rec_buf[posix_rec_count-shared_rec_count]);
 
-    /* allocate memory for the reduction output on rank 0 */
+    /* allocate memory for the reduction output on rank 0, and for the
+     * time and byte totals whose variances are computed along with it
+     */
+    var_vals = malloc(shared_rec_count * 2 * sizeof(double));
     if(my_rank == 0)
-    {
         red_recv_buf = malloc(shared_rec_count * sizeof(struct darshan_posix_file));
-        if(!red_recv_buf)
-        {
-            POSIX_UNLOCK();
-            return;
-        }
+    if(!var_vals || (my_rank == 0 && !red_recv_buf))
+    {
+        free(var_vals);
+        free(red_recv_buf);
+        POSIX_UNLOCK();
+        return;
+    }
+    for(i = 0; i < shared_rec_count; i++)
+    {
+        var_vals[2*i] = red_send_buf[i].fcounters[POSIX_F_READ_TIME] +
+            red_send_buf[i].fcounters[POSIX_F_WRITE_TIME] +
+            red_send_buf[i].fcounters[POSIX_F_META_TIME];
+        var_vals[2*i+1] = (double)red_send_buf[i].counters[POSIX_BYTES_READ] +
+            red_send_buf[i].counters[POSIX_BYTES_WRITTEN];
     }
 
-    /* construct a datatype for a POSIX file record.  This is serving no purpose
-     * except to make sure we can do a reduction on proper boundaries
+    /* reduce shared POSIX file records, along with their time and byte
+     * variances
      */
-    PMPI_Type_contiguous(sizeof(struct darshan_posix_file),
-        MPI_BYTE, &red_type);
-    PMPI_Type_commit(&red_type);
-
-    /* register a POSIX file record reduction operator */
-    PMPI_Op_create(posix_record_reduction_op, 1, &red_op);
-
-    /* reduce shared POSIX file records */
-    PMPI_Reduce(red_send_buf, red_recv_buf,
-        shared_rec_count, red_type, red_op, 0, mod_comm);
-
-    /* get the time and byte variances for shared files */
-    posix_shared_record_variance(mod_comm, red_send_buf, red_recv_buf,
-        shared_rec_count);
+    ret = darshan_shared_record_reduce(mod_comm, red_send_buf, red_recv_buf,
+        shared_rec_count, sizeof(struct darshan_posix_file),
+        posix_record_reduction_op, var_vals, 2);
 
     /* update module state to account for shared file reduction */
-    if(my_rank == 0)
+    if(ret < 0)
+    {
+        free(red_recv_buf);
+    }
+    else if(my_rank == 0)
     {
         /* overwrite local shared records with globally reduced records */
         int tmp_ndx = posix_rec_count - shared_rec_count;
+        for(i = 0; i < shared_rec_count; i++)
+        {
+            red_recv_buf[i].fcounters[POSIX_F_VARIANCE_RANK_TIME] =
+                var_vals[2*i];
+            red_recv_buf[i].fcounters[POSIX_F_VARIANCE_RANK_BYTES] =
+                var_vals[2*i+1];
+        }
         memcpy(&(posix_rec_buf[tmp_ndx]), red_recv_buf,
             shared_rec_count * sizeof(struct darshan_posix_file));
         free(red_recv_buf);
@@ -2618,9 +3621,7 @@ static void posix_mpi_redux(
         /* drop shared records on non-zero ranks */
         posix_runtime->file_rec_count -= shared_rec_count;
     }
-
-    PMPI_Type_free(&red_type);
-    PMPI_Op_free(&red_op);
+    free(var_vals);
 
     POSIX_UNLOCK();
     return;
@@ -2633,9 +3634,15 @@ static void posix_output(
 {
     int posix_rec_count;
 
+    /* fold any per-thread records in (a no-op if already done in redux) */
+    if(posix_thread_shards)
+        posix_merge_thread_shards();
+
     POSIX_LOCK();
     assert(posix_runtime);
 
+    posix_stop_retirer();
+
     /* just pass back our updated total buffer size -- no need to update buffer */
     posix_rec_count = posix_runtime->file_rec_count;
     *posix_buf_sz = posix_rec_count * sizeof(struct darshan_posix_file);
@@ -2648,18 +3655,37 @@ static void posix_output(
 
 static void posix_cleanup()
 {
+    /* after a fork, the child's lock is left as the parent's retirement
+     * thread held it, and that thread is gone
+     */
+    if(posix_runtime && posix_runtime->retirer_running &&
+        posix_runtime->retirer_pid != getpid())
+    {
+        pthread_mutex_t init_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+        posix_runtime_mutex = init_mutex;
+    }
+
+    /* drop any per-thread records that were not yet merged */
+    if(posix_thread_shards)
+        posix_merge_thread_shards();
+
     POSIX_LOCK();
     assert(posix_runtime);
 
+    posix_stop_retirer();
+
     /* cleanup internal structures used for instrumenting */
     darshan_iter_record_refs(posix_runtime->rec_id_hash,
         &posix_finalize_file_records, NULL);
-    darshan_clear_record_refs(&(posix_runtime->fd_hash), 0);
-    darshan_clear_record_refs(&(posix_runtime->rec_id_hash), 1);
+    darshan_clear_fd_refs(&(posix_runtime->fd_table), 0);
+    darshan_arena_clear_record_refs(&(posix_runtime->rec_id_hash));
+    darshan_arena_destroy(&(posix_runtime->arena));
+    pthread_cond_destroy(&posix_runtime->retirer_cond);
 
     free(posix_runtime);
     posix_runtime = NULL;
     posix_runtime_init_attempted = 0;
+    posix_sample_rate = 1;
 
     POSIX_UNLOCK();
     return;
@@ -0,0 +1,554 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <darshan-runtime-config.h>
+#endif
+
+#define _XOPEN_SOURCE 500
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <pthread.h>
+#include <assert.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "darshan.h"
+#include "darshan-rollup.h"
+
+/* number of bits of a file's record id that select a HyperLogLog register,
+ * and the resulting number of registers kept for each rollup record; the
+ * standard error of the file count estimate is 1.04/sqrt(registers)
+ */
+#define ROLLUP_HLL_BITS 8
+#define ROLLUP_HLL_REGISTERS (1 << ROLLUP_HLL_BITS)
+
+/* The rollup_record_ref structure tracks a ROLLUP record along with the
+ * HyperLogLog registers that distinct files collapsed into it are counted
+ * in.  Files are identified by the record id they would otherwise have had.
+ */
+struct rollup_record_ref
+{
+    struct darshan_rollup_record *rec;
+    uint8_t hll[ROLLUP_HLL_REGISTERS];
+};
+
+/* The rollup_runtime structure maintains necessary state for storing
+ * ROLLUP records and for coordinating with darshan-core at shutdown time.
+ */
+struct rollup_runtime
+{
+    void *rec_id_hash;
+    int rec_count;
+    int64_t threshold;
+    int frozen; /* flag to indicate that the counters should no longer be modified */
+};
+
+static struct rollup_runtime *rollup_runtime = NULL;
+static pthread_mutex_t rollup_runtime_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int my_rank = -1;
+
+int darshan_rollup_enabled = 0;
+
+static struct rollup_record_ref *rollup_track_new_record(
+    darshan_record_id rec_id, const char *path);
+static void rollup_hll_add(
+    uint8_t *hll, uint64_t hash);
+static int64_t rollup_hll_estimate(
+    const uint8_t *hll);
+static void rollup_finalize_record(
+    void *rec_ref_p, void *user_ptr);
+static void rollup_record_merge(
+    struct darshan_rollup_record *infile,
+    struct darshan_rollup_record *inoutfile);
+#ifdef HAVE_MPI
+static void rollup_record_reduction_op(
+    void* infile_v, void* inoutfile_v, int *len, MPI_Datatype *datatype);
+static void rollup_mpi_redux(
+    void *rollup_buf, MPI_Comm mod_comm,
+    darshan_record_id *shared_recs, int shared_rec_count);
+#endif
+static void rollup_output(
+    void **rollup_buf, int *rollup_buf_sz);
+static void rollup_cleanup(
+    void);
+
+#define ROLLUP_LOCK() pthread_mutex_lock(&rollup_runtime_mutex)
+#define ROLLUP_UNLOCK() pthread_mutex_unlock(&rollup_runtime_mutex)
+
+/**********************************************************
+ *  Hooks called by darshan-core and instrumented modules  *
+ **********************************************************/
+
+void darshan_rollup_runtime_initialize()
+{
+    int ret;
+    size_t rollup_rec_count;
+    size_t threshold;
+    darshan_module_funcs mod_funcs = {
+#ifdef HAVE_MPI
+    .mod_redux_func = &rollup_mpi_redux,
+#endif
+    .mod_output_func = &rollup_output,
+    .mod_cleanup_func = &rollup_cleanup
+    };
+
+    /* directory rollup is off unless a threshold is given */
+    threshold = darshan_core_dir_rollup_threshold();
+    if(!threshold)
+        return;
+
+    ROLLUP_LOCK();
+
+    /* don't do anything if already initialized */
+    if(rollup_runtime)
+    {
+        ROLLUP_UNLOCK();
+        return;
+    }
+
+    rollup_rec_count = DARSHAN_DEF_MOD_REC_COUNT;
+
+    /* register the ROLLUP module with darshan core */
+    ret = darshan_core_register_module(
+        DARSHAN_ROLLUP_MOD,
+        mod_funcs,
+        sizeof(struct darshan_rollup_record),
+        &rollup_rec_count,
+        &my_rank,
+        NULL);
+    if(ret < 0)
+    {
+        ROLLUP_UNLOCK();
+        return;
+    }
+
+    rollup_runtime = malloc(sizeof(*rollup_runtime));
+    if(!rollup_runtime)
+    {
+        darshan_core_unregister_module(DARSHAN_ROLLUP_MOD);
+        ROLLUP_UNLOCK();
+        return;
+    }
+    memset(rollup_runtime, 0, sizeof(*rollup_runtime));
+    rollup_runtime->threshold = threshold;
+    darshan_rollup_enabled = 1;
+
+    ROLLUP_UNLOCK();
+    return;
+}
+
+void darshan_rollup_note_file(darshan_record_id rollup_id, const char *path,
+    darshan_record_id file_id)
+{
+    struct rollup_record_ref *rec_ref;
+    double tm;
+
+    ROLLUP_LOCK();
+    if(!rollup_runtime || rollup_runtime->frozen)
+    {
+        ROLLUP_UNLOCK();
+        return;
+    }
+
+    rec_ref = darshan_lookup_record_ref(rollup_runtime->rec_id_hash,
+        &rollup_id, sizeof(darshan_record_id));
+    if(!rec_ref)
+        rec_ref = rollup_track_new_record(rollup_id, path);
+    if(rec_ref)
+    {
+        rollup_hll_add(rec_ref->hll, file_id);
+        tm = darshan_core_wtime();
+        if(rec_ref->rec->fcounters[ROLLUP_F_START_TIMESTAMP] == 0 ||
+           rec_ref->rec->fcounters[ROLLUP_F_START_TIMESTAMP] > tm)
+            rec_ref->rec->fcounters[ROLLUP_F_START_TIMESTAMP] = tm;
+        rec_ref->rec->fcounters[ROLLUP_F_END_TIMESTAMP] = tm;
+    }
+    ROLLUP_UNLOCK();
+
+    return;
+}
+
+void darshan_rollup_close(darshan_record_id rec_id, int fd)
+{
+    struct rollup_record_ref *rec_ref;
+    struct stat sbuf;
+    int64_t size;
+    int64_t *counters;
+
+    ROLLUP_LOCK();
+    if(!rollup_runtime || rollup_runtime->frozen)
+    {
+        ROLLUP_UNLOCK();
+        return;
+    }
+
+    rec_ref = darshan_lookup_record_ref(rollup_runtime->rec_id_hash,
+        &rec_id, sizeof(darshan_record_id));
+    if(rec_ref && fstat(fd, &sbuf) == 0)
+    {
+        counters = rec_ref->rec->counters;
+        size = sbuf.st_size;
+        counters[ROLLUP_CLOSES] += 1;
+        counters[ROLLUP_CLOSE_BYTES] += size;
+        if(counters[ROLLUP_MAX_SIZE] < size)
+            counters[ROLLUP_MAX_SIZE] = size;
+        if(size < 4096)
+            counters[ROLLUP_SIZE_0_4K] += 1;
+        else if(size < 65536)
+            counters[ROLLUP_SIZE_4K_64K] += 1;
+        else if(size < 1048576)
+            counters[ROLLUP_SIZE_64K_1M] += 1;
+        else if(size < 16777216)
+            counters[ROLLUP_SIZE_1M_16M] += 1;
+        else
+            counters[ROLLUP_SIZE_16M_PLUS] += 1;
+    }
+    ROLLUP_UNLOCK();
+
+    return;
+}
+
+/**********************************************************
+ * Internal functions for manipulating ROLLUP module state *
+ **********************************************************/
+
+static struct rollup_record_ref *rollup_track_new_record(
+    darshan_record_id rec_id, const char *path)
+{
+    struct darshan_rollup_record *record_p = NULL;
+    struct rollup_record_ref *rec_ref = NULL;
+    int ret;
+
+    rec_ref = malloc(sizeof(*rec_ref));
+    if(!rec_ref)
+        return(NULL);
+    memset(rec_ref, 0, sizeof(*rec_ref));
+
+    /* add a reference to this record */
+    ret = darshan_add_record_ref(&(rollup_runtime->rec_id_hash), &rec_id,
+        sizeof(darshan_record_id), rec_ref);
+    if(ret == 0)
+    {
+        free(rec_ref);
+        return(NULL);
+    }
+
+    /* register the actual record with darshan-core so it is persisted in
+     * the log file.  darshan-core recognizes the record id as the rollup of
+     * the directory of 'path', and names the record accordingly.
+     */
+    record_p = darshan_core_register_record(
+        rec_id,
+        path,
+        DARSHAN_ROLLUP_MOD,
+        sizeof(struct darshan_rollup_record),
+        NULL);
+
+    if(!record_p)
+    {
+        darshan_delete_record_ref(&(rollup_runtime->rec_id_hash),
+            &rec_id, sizeof(darshan_record_id));
+        free(rec_ref);
+        return(NULL);
+    }
+
+    /* registering this record was successful, so initialize some fields */
+    record_p->base_rec.id = rec_id;
+    record_p->base_rec.rank = my_rank;
+    record_p->counters[ROLLUP_THRESHOLD] = rollup_runtime->threshold;
+    rec_ref->rec = record_p;
+    rollup_runtime->rec_count++;
+
+    return(rec_ref);
+}
+
+static void rollup_hll_add(uint8_t *hll, uint64_t hash)
+{
+    uint64_t rest = hash << ROLLUP_HLL_BITS;
+    uint8_t rank;
+
+    /* the register is picked by the top bits of the hash, and tracks the
+     * longest run of leading zeros seen in the remaining bits
+     */
+    rank = rest ? __builtin_clzll(rest) + 1 : 64 - ROLLUP_HLL_BITS + 1;
+    if(hll[hash >> (64 - ROLLUP_HLL_BITS)] < rank)
+        hll[hash >> (64 - ROLLUP_HLL_BITS)] = rank;
+
+    return;
+}
+
+static int64_t rollup_hll_estimate(const uint8_t *hll)
+{
+    double m = ROLLUP_HLL_REGISTERS;
+    double sum = 0;
+    double est;
+    int zeros = 0;
+    int i;
+
+    for(i = 0; i < ROLLUP_HLL_REGISTERS; i++)
+    {
+        sum += ldexp(1.0, -hll[i]);
+        if(!hll[i])
+            zeros++;
+    }
+
+    est = (0.7213 / (1 + 1.079 / m)) * m * m / sum;
+    /* small counts are better estimated by the number of empty registers */
+    if(est <= 2.5 * m && zeros)
+        est = m * log(m / zeros);
+
+    return((int64_t)(est + 0.5));
+}
+
+static void rollup_finalize_record(void *rec_ref_p, void *user_ptr)
+{
+    struct rollup_record_ref *rec_ref = rec_ref_p;
+
+    rec_ref->rec->counters[ROLLUP_FILES] = rollup_hll_estimate(rec_ref->hll);
+
+    return;
+}
+
+/* combine the counters of 'infile' into 'inoutfile' */
+static void rollup_record_merge(struct darshan_rollup_record *infile,
+    struct darshan_rollup_record *inoutfile)
+{
+    int i;
+
+    for(i = 0; i < ROLLUP_NUM_INDICES; i++)
+    {
+        switch(i)
+        {
+            case ROLLUP_THRESHOLD:
+            case ROLLUP_MAX_SIZE:
+            /* estimates can't be summed, as ranks may have collapsed the
+             * same files; shared records are estimated again on rank 0
+             * from the merged registers
+             */
+            case ROLLUP_FILES:
+                /* max */
+                if(inoutfile->counters[i] < infile->counters[i])
+                    inoutfile->counters[i] = infile->counters[i];
+                break;
+            default:
+                /* sum */
+                inoutfile->counters[i] += infile->counters[i];
+                break;
+        }
+    }
+
+    /* min non-zero */
+    if(infile->fcounters[ROLLUP_F_START_TIMESTAMP] > 0 &&
+       (inoutfile->fcounters[ROLLUP_F_START_TIMESTAMP] == 0 ||
+        inoutfile->fcounters[ROLLUP_F_START_TIMESTAMP] >
+        infile->fcounters[ROLLUP_F_START_TIMESTAMP]))
+        inoutfile->fcounters[ROLLUP_F_START_TIMESTAMP] =
+            infile->fcounters[ROLLUP_F_START_TIMESTAMP];
+    /* max */
+    if(inoutfile->fcounters[ROLLUP_F_END_TIMESTAMP] <
+       infile->fcounters[ROLLUP_F_END_TIMESTAMP])
+        inoutfile->fcounters[ROLLUP_F_END_TIMESTAMP] =
+            infile->fcounters[ROLLUP_F_END_TIMESTAMP];
+
+    return;
+}
+
+#ifdef HAVE_MPI
+static void rollup_record_reduction_op(void* infile_v, void* inoutfile_v,
+    int *len, MPI_Datatype *datatype)
+{
+    struct darshan_rollup_record *infile = infile_v;
+    struct darshan_rollup_record *inoutfile = inoutfile_v;
+    int i;
+
+    for(i=0; i<*len; i++)
+    {
+        rollup_record_merge(infile, inoutfile);
+        inoutfile->base_rec.rank = -1;
+        infile++;
+        inoutfile++;
+    }
+
+    return;
+}
+#endif
+
+/********************************************************************************
+ * Functions exported by this module for coordinating with darshan-core *
+ ********************************************************************************/
+
+#ifdef HAVE_MPI
+static void rollup_mpi_redux(
+    void *rollup_buf,
+    MPI_Comm mod_comm,
+    darshan_record_id *shared_recs,
+    int shared_rec_count)
+{
+    int rollup_rec_count;
+    struct rollup_record_ref *rec_ref;
+    struct darshan_rollup_record *rollup_rec_buf =
+        (struct darshan_rollup_record *)rollup_buf;
+    struct darshan_rollup_record *red_send_buf = NULL;
+    struct darshan_rollup_record *red_recv_buf = NULL;
+    uint8_t *hll_buf = NULL;
+    int ret;
+    int i;
+
+    ROLLUP_LOCK();
+    assert(rollup_runtime);
+
+    rollup_rec_count = rollup_runtime->rec_count;
+
+    /* merge the registers of shared records on rank 0, so that a file
+     * collapsed on several ranks is only counted once; shared_recs is in
+     * the same order on every rank
+     */
+    hll_buf = malloc(shared_rec_count * ROLLUP_HLL_REGISTERS);
+    if(!hll_buf)
+    {
+        ROLLUP_UNLOCK();
+        return;
+    }
+    for(i = 0; i < shared_rec_count; i++)
+    {
+        rec_ref = darshan_lookup_record_ref(rollup_runtime->rec_id_hash,
+            &shared_recs[i], sizeof(darshan_record_id));
+        assert(rec_ref);
+
+        rec_ref->rec->base_rec.rank = -1;
+        memcpy(&hll_buf[i * ROLLUP_HLL_REGISTERS], rec_ref->hll,
+            ROLLUP_HLL_REGISTERS);
+    }
+    PMPI_Reduce(my_rank == 0 ? MPI_IN_PLACE : hll_buf, hll_buf,
+        shared_rec_count * ROLLUP_HLL_REGISTERS, MPI_UNSIGNED_CHAR, MPI_MAX,
+        0, mod_comm);
+    if(my_rank == 0)
+    {
+        for(i = 0; i < shared_rec_count; i++)
+        {
+            rec_ref = darshan_lookup_record_ref(rollup_runtime->rec_id_hash,
+                &shared_recs[i], sizeof(darshan_record_id));
+            memcpy(rec_ref->hll, &hll_buf[i * ROLLUP_HLL_REGISTERS],
+                ROLLUP_HLL_REGISTERS);
+        }
+    }
+    free(hll_buf);
+
+    /* estimate file counts before the records are rearranged below */
+    darshan_iter_record_refs(rollup_runtime->rec_id_hash,
+        &rollup_finalize_record, NULL);
+    rollup_runtime->frozen = 1;
+
+    /* sort the array of records descending by rank so that we get all of
+     * the shared records (marked by rank -1) in a contiguous portion at end
+     * of the array
+     */
+    darshan_record_sort(rollup_rec_buf, rollup_rec_count,
+        sizeof(struct darshan_rollup_record));
+
+    /* make *send_buf point to the shared records at the end of sorted array */
+    red_send_buf = &(rollup_rec_buf[rollup_rec_count-shared_rec_count]);
+
+    /* allocate memory for the reduction output on rank 0 */
+    if(my_rank == 0)
+    {
+        red_recv_buf = malloc(shared_rec_count *
+            sizeof(struct darshan_rollup_record));
+        if(!red_recv_buf)
+        {
+            ROLLUP_UNLOCK();
+            return;
+        }
+    }
+
+    /* reduce shared ROLLUP records */
+    ret = darshan_shared_record_reduce(mod_comm, red_send_buf, red_recv_buf,
+        shared_rec_count, sizeof(struct darshan_rollup_record),
+        rollup_record_reduction_op, NULL, 0);
+
+    /* update module state to account for shared record reduction */
+    if(ret < 0)
+    {
+        free(red_recv_buf);
+    }
+    else if(my_rank == 0)
+    {
+        /* overwrite local shared records with globally reduced records */
+        int tmp_ndx = rollup_rec_count - shared_rec_count;
+        memcpy(&(rollup_rec_buf[tmp_ndx]), red_recv_buf,
+            shared_rec_count * sizeof(struct darshan_rollup_record));
+        free(red_recv_buf);
+
+        for(i = tmp_ndx; i < rollup_rec_count; i++)
+        {
+            rec_ref = darshan_lookup_record_ref(rollup_runtime->rec_id_hash,
+                &(rollup_rec_buf[i].base_rec.id), sizeof(darshan_record_id));
+            rollup_rec_buf[i].counters[ROLLUP_FILES] =
+                rollup_hll_estimate(rec_ref->hll);
+        }
+    }
+    else
+    {
+        /* drop shared records on non-zero ranks */
+        rollup_runtime->rec_count -= shared_rec_count;
+    }
+
+    ROLLUP_UNLOCK();
+    return;
+}
+#endif
+
+static void rollup_output(
+    void **rollup_buf,
+    int *rollup_buf_sz)
+{
+    ROLLUP_LOCK();
+    assert(rollup_runtime);
+
+    /* records were already finalized if shared records were reduced */
+    if(!rollup_runtime->frozen)
+    {
+        darshan_iter_record_refs(rollup_runtime->rec_id_hash,
+            &rollup_finalize_record, NULL);
+        rollup_runtime->frozen = 1;
+    }
+
+    *rollup_buf_sz = rollup_runtime->rec_count *
+        sizeof(struct darshan_rollup_record);
+
+    ROLLUP_UNLOCK();
+    return;
+}
+
+static void rollup_cleanup()
+{
+    ROLLUP_LOCK();
+    assert(rollup_runtime);
+
+    darshan_clear_record_refs(&(rollup_runtime->rec_id_hash), 1);
+
+    free(rollup_runtime);
+    rollup_runtime = NULL;
+    darshan_rollup_enabled = 0;
+
+    ROLLUP_UNLOCK();
+    return;
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifndef __DARSHAN_ROLLUP_H
+#define __DARSHAN_ROLLUP_H
+
+/* set while the ROLLUP module is registered, i.e., while directory rollup
+ * is enabled, so that the POSIX close wrapper only pays for a flag test
+ * otherwise
+ */
+extern int darshan_rollup_enabled;
+
+/* darshan_rollup_runtime_initialize()
+ *
+ * Registers the ROLLUP module if directory rollup is enabled; called by
+ * darshan-core at startup.
+ */
+void darshan_rollup_runtime_initialize(void);
+
+/* darshan_rollup_note_file()
+ *
+ * Accounts the file at 'path', whose own record id would be 'file_id', to
+ * the rollup record 'rollup_id'; called by darshan-core each time it
+ * hands out the rollup id in place of the file's.
+ */
+void darshan_rollup_note_file(darshan_record_id rollup_id, const char *path,
+    darshan_record_id file_id);
+
+/* darshan_rollup_close()
+ *
+ * Samples the size of the file open at 'fd', if 'rec_id' is a rollup
+ * record; must be called before the descriptor is closed.
+ */
+void darshan_rollup_close(darshan_record_id rec_id, int fd);
+
+#define DARSHAN_ROLLUP_CLOSE(__rec_id, __fd) do { \
+    if(darshan_rollup_enabled) \
+        darshan_rollup_close(__rec_id, __fd); \
+} while(0)
+
+#endif /* __DARSHAN_ROLLUP_H */
@@ -83,10 +83,13 @@
 #include <pthread.h>
 #include <stdint.h>
 #include <limits.h>
+#include <stdatomic.h>
 
 #include "darshan.h"
 #include "darshan-dynamic.h"
 #include "darshan-heatmap.h"
+#include "darshan-timeseries.h"
+#include "darshan-dxt.h"
 #include "darshan-ldms.h"
 
 #ifndef HAVE_OFF64_T
@@ -149,16 +152,65 @@ struct stdio_runtime
 {
     void *rec_id_hash;
     void *stream_hash;
+    void *arena;
     int file_rec_count;
     darshan_record_id heatmap_id;
     int frozen; /* flag to indicate that the counters should no longer be modified */
 };
 
+/* per-thread batch of single character and word calls on one stream,
+ * folded into the stream's record when needed. only the owning thread
+ * adds to a batch, but batches are folded by other threads at shutdown,
+ * so the owner holds the 'busy' flag while updating it
+ */
+struct stdio_small_batch
+{
+    atomic_flag busy;
+    uint32_t sample_seed;
+    int64_t sample_countdown; /* calls left until the next timed call */
+    FILE *stream;
+    struct stdio_file_record_ref *rec_ref; /* NULL if stream isn't tracked */
+    unsigned int generation;
+    int64_t calls;
+    int64_t reads;
+    int64_t writes;
+    int64_t bytes_read;
+    int64_t bytes_written;
+    /* the first call in each direction is always timed, to bound the
+     * batch's timestamps. later calls are sampled
+     */
+    double read_first_time;
+    double write_first_time;
+    int64_t read_samples;
+    int64_t write_samples;
+    double read_time;
+    double write_time;
+    double read_start;
+    double read_end;
+    double write_start;
+    double write_end;
+    struct stdio_small_batch *next;
+};
+
+/* number of calls batched before they are folded into the record */
+#define STDIO_SMALL_BATCH_MAX 4096
+
 static struct stdio_runtime *stdio_runtime = NULL;
 static pthread_mutex_t stdio_runtime_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
 static int stdio_runtime_init_attempted = 0;
 static int darshan_mem_alignment = 1;
 static int my_rank = -1;
+/* time one in every 'stdio_batch_sample' batched calls, 0 if disabled */
+static size_t stdio_batch_sample = 0;
+/* list of all thread batches, kept for the life of the process since
+ * threads hold references to them
+ */
+static struct stdio_small_batch *stdio_small_batches = NULL;
+static __thread struct stdio_small_batch *stdio_thread_batch = NULL;
+/* bumped whenever a stream is opened or closed, so that batches
+ * re-resolve the record of their stream
+ */
+static atomic_uint stdio_stream_generation;
 
 static void stdio_runtime_initialize(
     void);
@@ -167,9 +219,6 @@ static struct stdio_file_record_ref *stdio_track_new_file_record(
 #ifdef HAVE_MPI
 static void stdio_record_reduction_op(void* infile_v, void* inoutfile_v,
     int *len, MPI_Datatype *datatype);
-static void stdio_shared_record_variance(
-    MPI_Comm mod_comm, struct darshan_stdio_file *inrec_array,
-    struct darshan_stdio_file *outrec_array, int shared_rec_count);
 static void stdio_mpi_redux(
     void *stdio_buf, MPI_Comm mod_comm,
     darshan_record_id *shared_recs, int shared_rec_count);
@@ -178,9 +227,19 @@ static void stdio_output(
     void **stdio_buf, int *stdio_buf_sz);
 static void stdio_cleanup(
     void);
+static struct stdio_small_batch *stdio_small_batch_get(
+    FILE *stream, int write_flag, int *timed);
+static void stdio_small_batch_put(
+    struct stdio_small_batch *batch, FILE *stream, int success,
+    int64_t bytes, int write_flag, int timed, double tm1, double tm2);
+static void stdio_small_batch_fold(
+    struct stdio_small_batch *batch);
+static void stdio_small_batch_fold_all(
+    void);
 
 /* extern function def for querying record name from a POSIX fd */
-extern char *darshan_posix_lookup_record_name(int fd);
+extern int darshan_posix_lookup_record_name(int fd, char *rec_name,
+    size_t len);
 
 /* we need access to fileno (defined in POSIX module) for instrumenting fopen calls */
 #ifdef DARSHAN_PRELOAD
@@ -195,12 +254,23 @@ extern int __real_fileno(FILE *stream);
 #define STDIO_WTIME() \
     __darshan_disabled ? 0 : darshan_core_wtime();
 
+/* fread, fwrite and fflush issue at most a few POSIX operations around
+ * their buffering, so they share timestamps with them rather than reading
+ * the clock again (see darshan_layer_wtime_enter())
+ */
+#define STDIO_WTIME_ENTER(__seq) \
+    __darshan_disabled ? 0 : darshan_layer_wtime_enter(&(__seq));
+
+#define STDIO_WTIME_LEAVE(__seq) \
+    __darshan_disabled ? 0 : darshan_layer_wtime_leave(__seq);
+
 /* note that if the break condition is triggered in this macro, then it
  * will exit the do/while loop holding a lock that will be released in
  * POST_RECORD().  Otherwise it will release the lock here (if held) and
  * return immediately without reaching the POST_RECORD() macro.
  */
 #define STDIO_PRE_RECORD() do { \
+    DARSHAN_OVERHEAD_ENTER(); \
     if(!__darshan_disabled) { \
         STDIO_LOCK(); \
         if(!stdio_runtime && !stdio_runtime_init_attempted) \
@@ -213,30 +283,54 @@ extern int __real_fileno(FILE *stream);
 
 #define STDIO_POST_RECORD() do { \
     STDIO_UNLOCK(); \
+    DARSHAN_OVERHEAD_EXIT(DARSHAN_STDIO_MOD); \
+} while(0)
+
+/* fold this thread's batched calls on the given stream into its record
+ * before recording any other call on it
+ */
+#define STDIO_SMALL_BATCH_FOLD(__fp) do { \
+    if(stdio_thread_batch && stdio_thread_batch->stream == (__fp)) \
+        stdio_small_batch_fold(stdio_thread_batch); \
+} while(0)
+
+/* issue a single character or word call and add it to the calling
+ * thread's batch, returning from the wrapper, if batching is enabled
+ */
+#define STDIO_SMALL_CALL(__ret, __call, __stream, __success, __bytes, __write_flag) do { \
+    struct stdio_small_batch *__batch; \
+    int __timed; \
+    double __tm1 = 0, __tm2 = 0; \
+    if(__darshan_disabled) break; \
+    __batch = stdio_small_batch_get(__stream, __write_flag, &__timed); \
+    if(!__batch) break; \
+    if(__timed) __tm1 = darshan_core_wtime(); \
+    __ret = __call; \
+    if(__timed) __tm2 = darshan_core_wtime(); \
+    stdio_small_batch_put(__batch, __stream, (__success), __bytes, __write_flag, __timed, __tm1, __tm2); \
+    return(__ret); \
 } while(0)
 
 #define STDIO_RECORD_OPEN(__ret, __path, __tm1, __tm2) do { \
     darshan_record_id __rec_id; \
     struct stdio_file_record_ref *__rec_ref; \
+    char __pathbuf[__DARSHAN_PATH_MAX]; \
     char *__newpath; \
     MAP_OR_FAIL(fileno); \
     (void)__darshan_disabled; \
     if(!__ret || !__path) break; \
-    __newpath = darshan_clean_file_path(__path); \
-    if(!__newpath) __newpath = (char*)__path; \
-    __rec_id = darshan_core_gen_record_id(__newpath); \
+    __rec_id = darshan_path_record_id(__path, __pathbuf, sizeof(__pathbuf), &__newpath); \
     __rec_ref = darshan_lookup_record_ref(stdio_runtime->rec_id_hash, &__rec_id, sizeof(darshan_record_id)); \
-    if(!__rec_ref) __rec_ref = stdio_track_new_file_record(__rec_id, __newpath); \
     if(!__rec_ref) { \
-        if(__newpath != (char*)__path) free(__newpath); \
-        break; \
+        if(!__newpath) __newpath = darshan_clean_file_path_buf(__path, __pathbuf, sizeof(__pathbuf)); \
+        if(!__newpath) __newpath = (char*)__path; \
+        __rec_ref = stdio_track_new_file_record(__rec_id, __newpath); \
     } \
+    if(!__rec_ref) break; \
     _STDIO_RECORD_OPEN(__ret, __rec_ref, __tm1, __tm2, 1, -1); \
-    if(__newpath != (char*)__path) free(__newpath); \
     /* LDMS to publish realtime open tracing information to daemon*/ \
-    if(dC.ldms_lib)\
-        if(dC.stdio_enable_ldms)\
-            darshan_ldms_connector_send(__rec_ref->file_rec->base_rec.id, __rec_ref->file_rec->base_rec.rank,__rec_ref->file_rec->counters[STDIO_OPENS], "open", -1, -1, -1, -1, -1, __tm1, __tm2, __rec_ref->file_rec->fcounters[STDIO_F_META_TIME], "STDIO", "MET");\
+    if(DARSHAN_LDMS_ENABLED(stdio))\
+        darshan_ldms_connector_send(__rec_ref->file_rec->base_rec.id, __rec_ref->file_rec->base_rec.rank,__rec_ref->file_rec->counters[STDIO_OPENS], "open", -1, -1, -1, -1, -1, __tm1, __tm2, __rec_ref->file_rec->fcounters[STDIO_F_META_TIME], "STDIO", "MET");\
 } while(0)
 
 #define STDIO_RECORD_REFOPEN(__ret, __rec_ref, __tm1, __tm2, __ref_counter) do { \
@@ -253,19 +347,27 @@ extern int __real_fileno(FILE *stream);
         __rec_ref->file_rec->fcounters[STDIO_F_OPEN_START_TIMESTAMP] = __tm1; \
     __rec_ref->file_rec->fcounters[STDIO_F_OPEN_END_TIMESTAMP] = __tm2; \
     DARSHAN_TIMER_INC_NO_OVERLAP(__rec_ref->file_rec->fcounters[STDIO_F_META_TIME], __tm1, __tm2, __rec_ref->last_meta_end); \
-    darshan_add_record_ref(&(stdio_runtime->stream_hash), &(__ret), sizeof(__ret), __rec_ref); \
+    TIMESERIES_RECORD(TIMESERIES_API_STDIO, TIMESERIES_OP_META, 0, __tm1, __tm2); \
+    darshan_arena_add_record_ref(&(stdio_runtime->arena), \
+        &(stdio_runtime->stream_hash), &(__ret), sizeof(__ret), __rec_ref); \
+    atomic_fetch_add(&stdio_stream_generation, 1); \
 } while(0)
 
 
 #define STDIO_RECORD_READ(__fp, __bytes,  __tm1, __tm2) do{ \
     struct stdio_file_record_ref* rec_ref; \
     int64_t this_offset; \
+    STDIO_SMALL_BATCH_FOLD(__fp); \
     rec_ref = darshan_lookup_record_ref(stdio_runtime->stream_hash, &(__fp), sizeof(__fp)); \
     if(!rec_ref) break; \
     this_offset = rec_ref->offset; \
     rec_ref->offset = this_offset + __bytes; \
+    /* DXT to record detailed read tracing information */ \
+    DXT_RECORD(stdio, read, rec_ref->file_rec->base_rec.id, this_offset, __bytes, __tm1, __tm2); \
     /* heatmap to record traffic summary */ \
-    heatmap_update(stdio_runtime->heatmap_id, HEATMAP_READ, __bytes, __tm1, __tm2); \
+    HEATMAP_UPDATE(stdio_runtime->heatmap_id, HEATMAP_READ, __bytes, __tm1, __tm2); \
+    /* TIMESERIES to record the job's activity over time */ \
+    TIMESERIES_RECORD(TIMESERIES_API_STDIO, TIMESERIES_OP_READ, __bytes, __tm1, __tm2); \
     if(rec_ref->file_rec->counters[STDIO_MAX_BYTE_READ] < (this_offset + __bytes - 1)) \
         rec_ref->file_rec->counters[STDIO_MAX_BYTE_READ] = (this_offset + __bytes - 1); \
     rec_ref->file_rec->counters[STDIO_BYTES_READ] += __bytes; \
@@ -276,20 +378,26 @@ extern int __real_fileno(FILE *stream);
     rec_ref->file_rec->fcounters[STDIO_F_READ_END_TIMESTAMP] = __tm2; \
     DARSHAN_TIMER_INC_NO_OVERLAP(rec_ref->file_rec->fcounters[STDIO_F_READ_TIME], __tm1, __tm2, rec_ref->last_read_end); \
     /* LDMS to publish realtime read tracing information to daemon*/ \
-    if(dC.ldms_lib)\
-        if(dC.stdio_enable_ldms) \
-            darshan_ldms_connector_send(rec_ref->file_rec->base_rec.id, rec_ref->file_rec->base_rec.rank, rec_ref->file_rec->counters[STDIO_READS], "read", this_offset, __bytes, rec_ref->file_rec->counters[STDIO_MAX_BYTE_READ], -1, -1, __tm1, __tm2, rec_ref->file_rec->fcounters[STDIO_F_READ_TIME],"STDIO", "MOD"); \
+    if(DARSHAN_LDMS_ENABLED(stdio)) \
+        darshan_ldms_connector_send(rec_ref->file_rec->base_rec.id, rec_ref->file_rec->base_rec.rank, rec_ref->file_rec->counters[STDIO_READS], "read", this_offset, __bytes, rec_ref->file_rec->counters[STDIO_MAX_BYTE_READ], -1, -1, __tm1, __tm2, rec_ref->file_rec->fcounters[STDIO_F_READ_TIME],"STDIO", "MOD"); \
 } while(0)
 
 #define STDIO_RECORD_WRITE(__fp, __bytes,  __tm1, __tm2, __fflush_flag) do{ \
     struct stdio_file_record_ref* rec_ref; \
     int64_t this_offset; \
+    STDIO_SMALL_BATCH_FOLD(__fp); \
     rec_ref = darshan_lookup_record_ref(stdio_runtime->stream_hash, &(__fp), sizeof(__fp)); \
     if(!rec_ref) break; \
     this_offset = rec_ref->offset; \
     rec_ref->offset = this_offset + __bytes; \
+    /* DXT to record detailed write tracing information (but not flushes) */ \
+    if(!(__fflush_flag)) \
+        DXT_RECORD(stdio, write, rec_ref->file_rec->base_rec.id, this_offset, __bytes, __tm1, __tm2); \
     /* heatmap to record traffic summary */ \
-    heatmap_update(stdio_runtime->heatmap_id, HEATMAP_WRITE, __bytes, __tm1, __tm2); \
+    HEATMAP_UPDATE(stdio_runtime->heatmap_id, HEATMAP_WRITE, __bytes, __tm1, __tm2); \
+    /* TIMESERIES to record the job's activity over time */ \
+    TIMESERIES_RECORD(TIMESERIES_API_STDIO, \
+        (__fflush_flag) ? TIMESERIES_OP_META : TIMESERIES_OP_WRITE, __bytes, __tm1, __tm2); \
     if(rec_ref->file_rec->counters[STDIO_MAX_BYTE_WRITTEN] < (this_offset + __bytes - 1)) \
         rec_ref->file_rec->counters[STDIO_MAX_BYTE_WRITTEN] = (this_offset + __bytes - 1); \
     rec_ref->file_rec->counters[STDIO_BYTES_WRITTEN] += __bytes; \
@@ -303,9 +411,8 @@ extern int __real_fileno(FILE *stream);
     rec_ref->file_rec->fcounters[STDIO_F_WRITE_END_TIMESTAMP] = __tm2; \
     DARSHAN_TIMER_INC_NO_OVERLAP(rec_ref->file_rec->fcounters[STDIO_F_WRITE_TIME], __tm1, __tm2, rec_ref->last_write_end); \
     /* LDMS to publish realtime write tracing information to daemon*/ \
-    if(dC.ldms_lib)\
-        if(dC.stdio_enable_ldms)\
-            darshan_ldms_connector_send(rec_ref->file_rec->base_rec.id, rec_ref->file_rec->base_rec.rank, rec_ref->file_rec->counters[STDIO_WRITES], "write", this_offset, __bytes, rec_ref->file_rec->counters[STDIO_MAX_BYTE_WRITTEN], -1, rec_ref->file_rec->counters[STDIO_FLUSHES], __tm1, __tm2,  rec_ref->file_rec->fcounters[STDIO_F_WRITE_TIME], "STDIO", "MOD"); \
+    if(DARSHAN_LDMS_ENABLED(stdio))\
+        darshan_ldms_connector_send(rec_ref->file_rec->base_rec.id, rec_ref->file_rec->base_rec.rank, rec_ref->file_rec->counters[STDIO_WRITES], "write", this_offset, __bytes, rec_ref->file_rec->counters[STDIO_MAX_BYTE_WRITTEN], -1, rec_ref->file_rec->counters[STDIO_FLUSHES], __tm1, __tm2,  rec_ref->file_rec->fcounters[STDIO_F_WRITE_TIME], "STDIO", "MOD"); \
 } while(0)
 
 FILE* DARSHAN_DECL(fopen)(const char *path, const char *mode)
@@ -359,8 +466,8 @@ FILE* DARSHAN_DECL(fdopen)(int fd, const char *mode)
 
     if(ret)
     {
-        char *rec_name = darshan_posix_lookup_record_name(fd);
-        if(rec_name)
+        char rec_name[__DARSHAN_PATH_MAX];
+        if(darshan_posix_lookup_record_name(fd, rec_name, sizeof(rec_name)))
         {
             rec_id = darshan_core_gen_record_id(rec_name);
 
@@ -418,13 +525,14 @@ FILE* DARSHAN_DECL(freopen64)(const char *path, const char *mode, FILE *stream)
 int DARSHAN_DECL(fflush)(FILE *fp)
 {
     double tm1, tm2;
+    unsigned long seq;
     int ret;
 
     MAP_OR_FAIL(fflush);
 
-    tm1 = STDIO_WTIME();
+    tm1 = STDIO_WTIME_ENTER(seq);
     ret = __real_fflush(fp);
-    tm2 = STDIO_WTIME();
+    tm2 = STDIO_WTIME_LEAVE(seq);
 
     STDIO_PRE_RECORD();
     if(ret >= 0)
@@ -464,6 +572,7 @@ int DARSHAN_DECL(fclose)(FILE *fp)
     tm2 = STDIO_WTIME();
 
     STDIO_PRE_RECORD();
+    STDIO_SMALL_BATCH_FOLD(fp);
     rec_ref = darshan_lookup_record_ref(stdio_runtime->stream_hash, &fp, sizeof(fp));
     if(rec_ref)
     {
@@ -474,14 +583,17 @@ int DARSHAN_DECL(fclose)(FILE *fp)
         DARSHAN_TIMER_INC_NO_OVERLAP(
             rec_ref->file_rec->fcounters[STDIO_F_META_TIME],
             tm1, tm2, rec_ref->last_meta_end);
-        darshan_delete_record_ref(&(stdio_runtime->stream_hash), &fp, sizeof(fp));
+        TIMESERIES_RECORD(TIMESERIES_API_STDIO, TIMESERIES_OP_META, 0,
+            tm1, tm2);
+        darshan_arena_delete_record_ref(stdio_runtime->arena,
+            &(stdio_runtime->stream_hash), &fp, sizeof(fp));
+        atomic_fetch_add(&stdio_stream_generation, 1);
 
 #ifdef HAVE_LDMS
         rec_ref->close_counts++;
         /* publish close information for stdio */
-        if(dC.ldms_lib)
-            if(dC.stdio_enable_ldms)
-                darshan_ldms_connector_send(rec_ref->file_rec->base_rec.id, rec_ref->file_rec->base_rec.rank, rec_ref->close_counts, "close", -1, -1, -1, -1, rec_ref->file_rec->counters[STDIO_FLUSHES], tm1, tm2, rec_ref->file_rec->fcounters[STDIO_F_META_TIME], "STDIO", "MOD");
+        if(DARSHAN_LDMS_ENABLED(stdio))
+            darshan_ldms_connector_send(rec_ref->file_rec->base_rec.id, rec_ref->file_rec->base_rec.rank, rec_ref->close_counts, "close", -1, -1, -1, -1, rec_ref->file_rec->counters[STDIO_FLUSHES], tm1, tm2, rec_ref->file_rec->fcounters[STDIO_F_META_TIME], "STDIO", "MOD");
 #endif
     }
     STDIO_POST_RECORD();
@@ -493,12 +605,13 @@ size_t DARSHAN_DECL(fwrite)(const void *ptr, size_t size, size_t nmemb, FILE *st
 {
     size_t ret;
     double tm1, tm2;
+    unsigned long seq;
 
     MAP_OR_FAIL(fwrite);
 
-    tm1 = STDIO_WTIME();
+    tm1 = STDIO_WTIME_ENTER(seq);
     ret = __real_fwrite(ptr, size, nmemb, stream);
-    tm2 = STDIO_WTIME();
+    tm2 = STDIO_WTIME_LEAVE(seq);
 
     STDIO_PRE_RECORD();
     if(ret > 0)
@@ -516,6 +629,8 @@ int DARSHAN_DECL(fputc)(int c, FILE *stream)
 
     MAP_OR_FAIL(fputc);
 
+    STDIO_SMALL_CALL(ret, __real_fputc(c, stream), stream, ret != EOF, 1, 1);
+
     tm1 = STDIO_WTIME();
     ret = __real_fputc(c, stream);
     tm2 = STDIO_WTIME();
@@ -535,6 +650,8 @@ int DARSHAN_DECL(putw)(int w, FILE *stream)
 
     MAP_OR_FAIL(putw);
 
+    STDIO_SMALL_CALL(ret, __real_putw(w, stream), stream, ret != EOF, sizeof(int), 1);
+
     tm1 = STDIO_WTIME();
     ret = __real_putw(w, stream);
     tm2 = STDIO_WTIME();
@@ -661,12 +778,13 @@ size_t DARSHAN_DECL(fread)(void *ptr, size_t size, size_t nmemb, FILE *stream)
 {
     size_t ret;
     double tm1, tm2;
+    unsigned long seq;
 
     MAP_OR_FAIL(fread);
 
-    tm1 = STDIO_WTIME();
+    tm1 = STDIO_WTIME_ENTER(seq);
     ret = __real_fread(ptr, size, nmemb, stream);
-    tm2 = STDIO_WTIME();
+    tm2 = STDIO_WTIME_LEAVE(seq);
 
     STDIO_PRE_RECORD();
     if(ret > 0)
@@ -683,6 +801,8 @@ int DARSHAN_DECL(fgetc)(FILE *stream)
 
     MAP_OR_FAIL(fgetc);
 
+    STDIO_SMALL_CALL(ret, __real_fgetc(stream), stream, ret != EOF, 1, 0);
+
     tm1 = STDIO_WTIME();
     ret = __real_fgetc(stream);
     tm2 = STDIO_WTIME();
@@ -703,6 +823,8 @@ int DARSHAN_DECL(_IO_getc)(FILE *stream)
 
     MAP_OR_FAIL(_IO_getc);
 
+    STDIO_SMALL_CALL(ret, __real__IO_getc(stream), stream, ret != EOF, 1, 0);
+
     tm1 = STDIO_WTIME();
     ret = __real__IO_getc(stream);
     tm2 = STDIO_WTIME();
@@ -723,6 +845,8 @@ int DARSHAN_DECL(_IO_putc)(int c, FILE *stream)
 
     MAP_OR_FAIL(_IO_putc);
 
+    STDIO_SMALL_CALL(ret, __real__IO_putc(c, stream), stream, ret != EOF, 1, 1);
+
     tm1 = STDIO_WTIME();
     ret = __real__IO_putc(c, stream);
     tm2 = STDIO_WTIME();
@@ -742,6 +866,8 @@ int DARSHAN_DECL(getw)(FILE *stream)
 
     MAP_OR_FAIL(getw);
 
+    STDIO_SMALL_CALL(ret, __real_getw(stream), stream, ret != EOF || ferror(stream) == 0, sizeof(int), 0);
+
     tm1 = STDIO_WTIME();
     ret = __real_getw(stream);
     tm2 = STDIO_WTIME();
@@ -883,6 +1009,7 @@ void DARSHAN_DECL(rewind)(FILE *stream)
         return;
     }
 
+    STDIO_SMALL_BATCH_FOLD(stream);
     rec_ref = darshan_lookup_record_ref(stdio_runtime->stream_hash, &stream, sizeof(stream));
 
     if(rec_ref)
@@ -913,6 +1040,7 @@ int DARSHAN_DECL(fseek)(FILE *stream, long offset, int whence)
     if(ret >= 0)
     {
         STDIO_PRE_RECORD();
+        STDIO_SMALL_BATCH_FOLD(stream);
         rec_ref = darshan_lookup_record_ref(stdio_runtime->stream_hash, &stream, sizeof(stream));
         if(rec_ref)
         {
@@ -943,6 +1071,7 @@ int DARSHAN_DECL(fseeko)(FILE *stream, off_t offset, int whence)
     if(ret >= 0)
     {
         STDIO_PRE_RECORD();
+        STDIO_SMALL_BATCH_FOLD(stream);
         rec_ref = darshan_lookup_record_ref(stdio_runtime->stream_hash, &stream, sizeof(stream));
         if(rec_ref)
         {
@@ -973,6 +1102,7 @@ int DARSHAN_DECL(fseeko64)(FILE *stream, off64_t offset, int whence)
     if(ret >= 0)
     {
         STDIO_PRE_RECORD();
+        STDIO_SMALL_BATCH_FOLD(stream);
         rec_ref = darshan_lookup_record_ref(stdio_runtime->stream_hash, &stream, sizeof(stream));
         if(rec_ref)
         {
@@ -1003,6 +1133,7 @@ int DARSHAN_DECL(fsetpos)(FILE *stream, const fpos_t *pos)
     if(ret >= 0)
     {
         STDIO_PRE_RECORD();
+        STDIO_SMALL_BATCH_FOLD(stream);
         rec_ref = darshan_lookup_record_ref(stdio_runtime->stream_hash, &stream, sizeof(stream));
         if(rec_ref)
         {
@@ -1033,6 +1164,7 @@ int DARSHAN_DECL(fsetpos64)(FILE *stream, const fpos64_t *pos)
     if(ret >= 0)
     {
         STDIO_PRE_RECORD();
+        STDIO_SMALL_BATCH_FOLD(stream);
         rec_ref = darshan_lookup_record_ref(stdio_runtime->stream_hash, &stream, sizeof(stream));
         if(rec_ref)
         {
@@ -1095,9 +1227,14 @@ static void stdio_runtime_initialize()
     STDIO_RECORD_OPEN(stdout, "<STDOUT>", 0, 0);
     STDIO_RECORD_OPEN(stderr, "<STDERR>", 0, 0);
 
+    /* allow DXT module to initialize if needed */
+    dxt_stdio_runtime_initialize();
+
     /* register a heatmap */
     stdio_runtime->heatmap_id = heatmap_register("heatmap:STDIO");
 
+    stdio_batch_sample = darshan_core_stdio_batch_small();
+
     return;
 }
 
@@ -1109,17 +1246,16 @@ static struct stdio_file_record_ref *stdio_track_new_file_record(
     struct darshan_fs_info fs_info;
     int ret;
 
-    rec_ref = malloc(sizeof(*rec_ref));
+    rec_ref = darshan_arena_alloc(&(stdio_runtime->arena), sizeof(*rec_ref));
     if(!rec_ref)
         return(NULL);
-    memset(rec_ref, 0, sizeof(*rec_ref));
 
     /* add a reference to this file record based on record id */
-    ret = darshan_add_record_ref(&(stdio_runtime->rec_id_hash), &rec_id,
-        sizeof(darshan_record_id), rec_ref);
+    ret = darshan_arena_add_record_ref(&(stdio_runtime->arena),
+        &(stdio_runtime->rec_id_hash), &rec_id, sizeof(darshan_record_id), rec_ref);
     if(ret == 0)
     {
-        free(rec_ref);
+        darshan_arena_free(stdio_runtime->arena, rec_ref, sizeof(*rec_ref));
         return(NULL);
     }
 
@@ -1135,9 +1271,9 @@ static struct stdio_file_record_ref *stdio_track_new_file_record(
 
     if(!file_rec)
     {
-        darshan_delete_record_ref(&(stdio_runtime->rec_id_hash),
-            &rec_id, sizeof(darshan_record_id));
-        free(rec_ref);
+        darshan_arena_delete_record_ref(stdio_runtime->arena,
+            &(stdio_runtime->rec_id_hash), &rec_id, sizeof(darshan_record_id));
+        darshan_arena_free(stdio_runtime->arena, rec_ref, sizeof(*rec_ref));
         return(NULL);
     }
 
@@ -1151,6 +1287,238 @@ static struct stdio_file_record_ref *stdio_track_new_file_record(
     return(rec_ref);
 }
 
+/* decide whether the next batched call in the given direction is timed.
+ * the first call in each direction is, and later calls are sampled at
+ * randomized intervals averaging the configured interval, so that the
+ * samples don't alias with the stream's periodic buffer flushes
+ */
+static int stdio_small_batch_timed(
+    struct stdio_small_batch *batch, int write_flag)
+{
+    uint32_t x;
+
+    if((write_flag ? batch->writes : batch->reads) == 0)
+        return(1);
+    if(--batch->sample_countdown > 0)
+        return(0);
+
+    /* xorshift32 */
+    x = batch->sample_seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    batch->sample_seed = x;
+    batch->sample_countdown = 1 + (x % (2 * stdio_batch_sample - 1));
+
+    return(1);
+}
+
+/* return the calling thread's batch for single character and word calls
+ * on 'stream', setting 'timed' if the call should be timed, or NULL if
+ * the call should be recorded individually
+ */
+static struct stdio_small_batch *stdio_small_batch_get(
+    FILE *stream, int write_flag, int *timed)
+{
+    struct stdio_small_batch *batch = stdio_thread_batch;
+    unsigned int generation;
+
+    /* NOTE: stdio_batch_sample is only set with the module initialized */
+    if(!stdio_batch_sample)
+        return(NULL);
+
+    generation = atomic_load_explicit(&stdio_stream_generation, memory_order_relaxed);
+    if(batch)
+    {
+        while(atomic_flag_test_and_set_explicit(&batch->busy, memory_order_acquire));
+        if(batch->stream == stream && batch->generation == generation &&
+            batch->calls < STDIO_SMALL_BATCH_MAX)
+        {
+            *timed = stdio_small_batch_timed(batch, write_flag);
+            atomic_flag_clear_explicit(&batch->busy, memory_order_release);
+            return(batch);
+        }
+        atomic_flag_clear_explicit(&batch->busy, memory_order_release);
+    }
+
+    /* fold the batch and start a new one for this stream */
+    STDIO_LOCK();
+    if(!stdio_runtime || stdio_runtime->frozen || !stdio_batch_sample)
+    {
+        STDIO_UNLOCK();
+        return(NULL);
+    }
+    if(!batch)
+    {
+        batch = calloc(1, sizeof(*batch));
+        if(!batch)
+        {
+            STDIO_UNLOCK();
+            return(NULL);
+        }
+        atomic_flag_clear(&batch->busy);
+        batch->sample_seed = (uint32_t)(uintptr_t)batch | 1;
+        batch->sample_countdown = stdio_batch_sample;
+        batch->next = stdio_small_batches;
+        stdio_small_batches = batch;
+        stdio_thread_batch = batch;
+    }
+    stdio_small_batch_fold(batch);
+
+    while(atomic_flag_test_and_set_explicit(&batch->busy, memory_order_acquire));
+    batch->stream = stream;
+    batch->rec_ref = darshan_lookup_record_ref(stdio_runtime->stream_hash,
+        &stream, sizeof(stream));
+    batch->generation = generation;
+    atomic_flag_clear_explicit(&batch->busy, memory_order_release);
+    STDIO_UNLOCK();
+
+    *timed = 1;
+    return(batch);
+}
+
+/* add a completed call to the calling thread's batch */
+static void stdio_small_batch_put(
+    struct stdio_small_batch *batch, FILE *stream, int success,
+    int64_t bytes, int write_flag, int timed, double tm1, double tm2)
+{
+    while(atomic_flag_test_and_set_explicit(&batch->busy, memory_order_acquire));
+    /* the batch may have been folded at shutdown in the meantime */
+    if(batch->stream == stream && batch->rec_ref)
+    {
+        batch->calls++;
+        if(success && write_flag)
+        {
+            if(batch->writes == 0)
+            {
+                batch->write_first_time = tm2 - tm1;
+                batch->write_start = tm1;
+            }
+            else if(timed)
+            {
+                batch->write_samples++;
+                batch->write_time += tm2 - tm1;
+            }
+            if(timed)
+                batch->write_end = tm2;
+            batch->writes++;
+            batch->bytes_written += bytes;
+        }
+        else if(success)
+        {
+            if(batch->reads == 0)
+            {
+                batch->read_first_time = tm2 - tm1;
+                batch->read_start = tm1;
+            }
+            else if(timed)
+            {
+                batch->read_samples++;
+                batch->read_time += tm2 - tm1;
+            }
+            if(timed)
+                batch->read_end = tm2;
+            batch->reads++;
+            batch->bytes_read += bytes;
+        }
+    }
+    atomic_flag_clear_explicit(&batch->busy, memory_order_release);
+
+    return;
+}
+
+/* fold a batch into its stream's record and empty it; must be called
+ * with the STDIO lock held
+ */
+static void stdio_small_batch_fold(
+    struct stdio_small_batch *batch)
+{
+    struct stdio_file_record_ref *rec_ref;
+    struct stdio_small_batch *next;
+    int64_t this_offset;
+    double elapsed;
+
+    while(atomic_flag_test_and_set_explicit(&batch->busy, memory_order_acquire));
+
+    rec_ref = batch->rec_ref;
+    /* calls that were not timed are charged the average sampled time (or
+     * the time of the first call, if no others were sampled). each
+     * direction is folded in one step, so the offsets of interleaved
+     * reads and writes are approximate
+     */
+    if(rec_ref && batch->reads > 0)
+    {
+        this_offset = rec_ref->offset;
+        rec_ref->offset = this_offset + batch->bytes_read;
+        HEATMAP_UPDATE(stdio_runtime->heatmap_id, HEATMAP_READ,
+            batch->bytes_read, batch->read_start, batch->read_end);
+        if(rec_ref->file_rec->counters[STDIO_MAX_BYTE_READ] < (rec_ref->offset - 1))
+            rec_ref->file_rec->counters[STDIO_MAX_BYTE_READ] = rec_ref->offset - 1;
+        rec_ref->file_rec->counters[STDIO_BYTES_READ] += batch->bytes_read;
+        rec_ref->file_rec->counters[STDIO_READS] += batch->reads;
+        if(rec_ref->file_rec->fcounters[STDIO_F_READ_START_TIMESTAMP] == 0 ||
+         rec_ref->file_rec->fcounters[STDIO_F_READ_START_TIMESTAMP] > batch->read_start)
+            rec_ref->file_rec->fcounters[STDIO_F_READ_START_TIMESTAMP] = batch->read_start;
+        rec_ref->file_rec->fcounters[STDIO_F_READ_END_TIMESTAMP] = batch->read_end;
+        if(batch->read_samples > 0)
+            elapsed = batch->read_first_time +
+                batch->read_time * (batch->reads - 1) / batch->read_samples;
+        else
+            elapsed = batch->read_first_time * batch->reads;
+        rec_ref->file_rec->fcounters[STDIO_F_READ_TIME] += elapsed;
+        TIMESERIES_RECORD_N(TIMESERIES_API_STDIO, TIMESERIES_OP_READ,
+            batch->reads, batch->bytes_read, elapsed, batch->read_end);
+        if(rec_ref->last_read_end < batch->read_end)
+            rec_ref->last_read_end = batch->read_end;
+    }
+    if(rec_ref && batch->writes > 0)
+    {
+        this_offset = rec_ref->offset;
+        rec_ref->offset = this_offset + batch->bytes_written;
+        HEATMAP_UPDATE(stdio_runtime->heatmap_id, HEATMAP_WRITE,
+            batch->bytes_written, batch->write_start, batch->write_end);
+        if(rec_ref->file_rec->counters[STDIO_MAX_BYTE_WRITTEN] < (rec_ref->offset - 1))
+            rec_ref->file_rec->counters[STDIO_MAX_BYTE_WRITTEN] = rec_ref->offset - 1;
+        rec_ref->file_rec->counters[STDIO_BYTES_WRITTEN] += batch->bytes_written;
+        rec_ref->file_rec->counters[STDIO_WRITES] += batch->writes;
+        if(rec_ref->file_rec->fcounters[STDIO_F_WRITE_START_TIMESTAMP] == 0 ||
+         rec_ref->file_rec->fcounters[STDIO_F_WRITE_START_TIMESTAMP] > batch->write_start)
+            rec_ref->file_rec->fcounters[STDIO_F_WRITE_START_TIMESTAMP] = batch->write_start;
+        rec_ref->file_rec->fcounters[STDIO_F_WRITE_END_TIMESTAMP] = batch->write_end;
+        if(batch->write_samples > 0)
+            elapsed = batch->write_first_time +
+                batch->write_time * (batch->writes - 1) / batch->write_samples;
+        else
+            elapsed = batch->write_first_time * batch->writes;
+        rec_ref->file_rec->fcounters[STDIO_F_WRITE_TIME] += elapsed;
+        TIMESERIES_RECORD_N(TIMESERIES_API_STDIO, TIMESERIES_OP_WRITE,
+            batch->writes, batch->bytes_written, elapsed, batch->write_end);
+        if(rec_ref->last_write_end < batch->write_end)
+            rec_ref->last_write_end = batch->write_end;
+    }
+
+    /* reset everything but the list linkage and the busy flag */
+    next = batch->next;
+    memset((char *)batch + offsetof(struct stdio_small_batch, stream), 0,
+        offsetof(struct stdio_small_batch, next) -
+        offsetof(struct stdio_small_batch, stream));
+    batch->next = next;
+
+    atomic_flag_clear_explicit(&batch->busy, memory_order_release);
+    return;
+}
+
+/* fold the batches of all threads; must be called with the STDIO lock held */
+static void stdio_small_batch_fold_all()
+{
+    struct stdio_small_batch *batch;
+
+    for(batch = stdio_small_batches; batch; batch = batch->next)
+        stdio_small_batch_fold(batch);
+
+    return;
+}
+
 #ifdef HAVE_MPI
 static void stdio_record_reduction_op(void* infile_v, void* inoutfile_v,
     int *len, MPI_Datatype *datatype)
@@ -1259,93 +1627,12 @@ static void stdio_record_reduction_op(void* infile_v, void* inoutfile_v,
     return;
 }
 
-static void stdio_shared_record_variance(MPI_Comm mod_comm,
-    struct darshan_stdio_file *inrec_array, struct darshan_stdio_file *outrec_array,
-    int shared_rec_count)
-{
-    MPI_Datatype var_dt;
-    MPI_Op var_op;
-    int i;
-    struct darshan_variance_dt *var_send_buf = NULL;
-    struct darshan_variance_dt *var_recv_buf = NULL;
-
-    PMPI_Type_contiguous(sizeof(struct darshan_variance_dt),
-        MPI_BYTE, &var_dt);
-    PMPI_Type_commit(&var_dt);
-
-    PMPI_Op_create(darshan_variance_reduce, 1, &var_op);
-
-    var_send_buf = malloc(shared_rec_count * sizeof(struct darshan_variance_dt));
-    if(!var_send_buf)
-        return;
-
-    if(my_rank == 0)
-    {
-        var_recv_buf = malloc(shared_rec_count * sizeof(struct darshan_variance_dt));
-
-        if(!var_recv_buf)
-            return;
-    }
-
-    /* get total i/o time variances for shared records */
-
-    for(i=0; i<shared_rec_count; i++)
-    {
-        var_send_buf[i].n = 1;
-        var_send_buf[i].S = 0;
-        var_send_buf[i].T = inrec_array[i].fcounters[STDIO_F_READ_TIME] +
-                            inrec_array[i].fcounters[STDIO_F_WRITE_TIME] +
-                            inrec_array[i].fcounters[STDIO_F_META_TIME];
-    }
-
-    PMPI_Reduce(var_send_buf, var_recv_buf, shared_rec_count,
-        var_dt, var_op, 0, mod_comm);
-
-    if(my_rank == 0)
-    {
-        for(i=0; i<shared_rec_count; i++)
-        {
-            outrec_array[i].fcounters[STDIO_F_VARIANCE_RANK_TIME] =
-                (var_recv_buf[i].S / var_recv_buf[i].n);
-        }
-    }
-
-    /* get total bytes moved variances for shared records */
-
-    for(i=0; i<shared_rec_count; i++)
-    {
-        var_send_buf[i].n = 1;
-        var_send_buf[i].S = 0;
-        var_send_buf[i].T = (double)
-                            inrec_array[i].counters[STDIO_BYTES_READ] +
-                            inrec_array[i].counters[STDIO_BYTES_WRITTEN];
-    }
-
-    PMPI_Reduce(var_send_buf, var_recv_buf, shared_rec_count,
-        var_dt, var_op, 0, mod_comm);
-
-    if(my_rank == 0)
-    {
-        for(i=0; i<shared_rec_count; i++)
-        {
-            outrec_array[i].fcounters[STDIO_F_VARIANCE_RANK_BYTES] =
-                (var_recv_buf[i].S / var_recv_buf[i].n);
-        }
-    }
-
-    PMPI_Type_free(&var_dt);
-    PMPI_Op_free(&var_op);
-    free(var_send_buf);
-    free(var_recv_buf);
-
-    return;
-}
 #endif
 
-char *darshan_stdio_lookup_record_name(FILE *stream)
+int darshan_stdio_lookup_record_name(FILE *stream, char *rec_name, size_t len)
 {
     struct stdio_file_record_ref *rec_ref;
-    char *rec_name = NULL;
+    int ret = 0;
 
     STDIO_LOCK();
     if(stdio_runtime)
@@ -1353,11 +1640,12 @@ char *darshan_stdio_lookup_record_name(FILE *stream)
         rec_ref = darshan_lookup_record_ref(stdio_runtime->stream_hash,
             &stream, sizeof(stream));
         if(rec_ref)
-            rec_name = darshan_core_lookup_record_name(rec_ref->file_rec->base_rec.id);
+            ret = darshan_core_lookup_record_name(
+                rec_ref->file_rec->base_rec.id, rec_name, len);
     }
     STDIO_UNLOCK();
 
-    return(rec_name);
+    return(ret);
 }
 
 /************************************************************************
@@ -1377,13 +1665,15 @@ static void stdio_mpi_redux(
     double stdio_time;
     struct darshan_stdio_file *red_send_buf = NULL;
     struct darshan_stdio_file *red_recv_buf = NULL;
-    MPI_Datatype red_type;
-    MPI_Op red_op;
+    double *var_vals = NULL;
+    int ret;
     int i;
 
     STDIO_LOCK();
     assert(stdio_runtime);
 
+    stdio_small_batch_fold_all();
+
     stdio_rec_count = stdio_runtime->file_rec_count;
 
     /* necessary initialization of shared records */
@@ -1430,40 +1720,51 @@ static void stdio_mpi_redux(
     /* make *send_buf point to the shared files at the end of sorted array */
     red_send_buf = &(stdio_rec_buf[stdio_rec_count-shared_rec_count]);
 
-    /* allocate memory for the reduction output on rank 0 */
+    /* allocate memory for the reduction output on rank 0, and for the
+     * time and byte totals whose variances are computed along with it
+     */
+    var_vals = malloc(shared_rec_count * 2 * sizeof(double));
     if(my_rank == 0)
-    {
         red_recv_buf = malloc(shared_rec_count * sizeof(struct darshan_stdio_file));
-        if(!red_recv_buf)
-        {
-            STDIO_UNLOCK();
-            return;
-        }
+    if(!var_vals || (my_rank == 0 && !red_recv_buf))
+    {
+        free(var_vals);
+        free(red_recv_buf);
+        STDIO_UNLOCK();
+        return;
+    }
+    for(i = 0; i < shared_rec_count; i++)
+    {
+        var_vals[2*i] = red_send_buf[i].fcounters[STDIO_F_READ_TIME] +
+            red_send_buf[i].fcounters[STDIO_F_WRITE_TIME] +
+            red_send_buf[i].fcounters[STDIO_F_META_TIME];
+        var_vals[2*i+1] = (double)red_send_buf[i].counters[STDIO_BYTES_READ] +
+            red_send_buf[i].counters[STDIO_BYTES_WRITTEN];
     }
 
-    /* construct a datatype for a STDIO file record.  This is serving no purpose
-     * except to make sure we can do a reduction on proper boundaries
+    /* reduce shared STDIO file records, along with their time and byte
+     * variances
      */
-    PMPI_Type_contiguous(sizeof(struct darshan_stdio_file),
-        MPI_BYTE, &red_type);
-    PMPI_Type_commit(&red_type);
-
-    /* register a STDIO file record reduction operator */
-    PMPI_Op_create(stdio_record_reduction_op, 1, &red_op);
-
-    /* reduce shared STDIO file records */
-    PMPI_Reduce(red_send_buf, red_recv_buf,
-        shared_rec_count, red_type, red_op, 0, mod_comm);
-
-    /* get the time and byte variances for shared files */
-    stdio_shared_record_variance(mod_comm, red_send_buf, red_recv_buf,
-        shared_rec_count);
+    ret = darshan_shared_record_reduce(mod_comm, red_send_buf, red_recv_buf,
+        shared_rec_count, sizeof(struct darshan_stdio_file),
+        stdio_record_reduction_op, var_vals, 2);
 
     /* update module state to account for shared file reduction */
-    if(my_rank == 0)
+    if(ret < 0)
+    {
+        free(red_recv_buf);
+    }
+    else if(my_rank == 0)
     {
         /* overwrite local shared records with globally reduced records */
         int tmp_ndx = stdio_rec_count - shared_rec_count;
+        for(i = 0; i < shared_rec_count; i++)
+        {
+            red_recv_buf[i].fcounters[STDIO_F_VARIANCE_RANK_TIME] =
+                var_vals[2*i];
+            red_recv_buf[i].fcounters[STDIO_F_VARIANCE_RANK_BYTES] =
+                var_vals[2*i+1];
+        }
         memcpy(&(stdio_rec_buf[tmp_ndx]), red_recv_buf,
             shared_rec_count * sizeof(struct darshan_stdio_file));
         free(red_recv_buf);
@@ -1473,9 +1774,7 @@ static void stdio_mpi_redux(
         /* drop shared records on non-zero ranks */
         stdio_runtime->file_rec_count -= shared_rec_count;
     }
-
-    PMPI_Type_free(&red_type);
-    PMPI_Op_free(&red_op);
+    free(var_vals);
 
     STDIO_UNLOCK();
     return;
@@ -1493,6 +1792,8 @@ static void stdio_output(
     STDIO_LOCK();
     assert(stdio_runtime);
 
+    stdio_small_batch_fold_all();
+
     stdio_rec_count = stdio_runtime->file_rec_count;
 
     /* filter out any records that have no activity on them; this is
@@ -1541,9 +1842,14 @@ static void stdio_cleanup()
     STDIO_LOCK();
     assert(stdio_runtime);
 
+    /* drop any batches still referring to the records freed below */
+    stdio_small_batch_fold_all();
+    stdio_batch_sample = 0;
+
     /* cleanup internal structures used for instrumenting */
-    darshan_clear_record_refs(&(stdio_runtime->stream_hash), 0);
-    darshan_clear_record_refs(&(stdio_runtime->rec_id_hash), 1);
+    darshan_arena_clear_record_refs(&(stdio_runtime->stream_hash));
+    darshan_arena_clear_record_refs(&(stdio_runtime->rec_id_hash));
+    darshan_arena_destroy(&(stdio_runtime->arena));
 
     free(stdio_runtime);
     stdio_runtime = NULL;
@@ -0,0 +1,446 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+# include <darshan-runtime-config.h>
+#endif
+
+#define _XOPEN_SOURCE 500
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <assert.h>
+
+#include "darshan.h"
+#include "darshan-timeseries.h"
+
+/* interval, in seconds, used when none is configured */
+#define TIMESERIES_DEF_INTERVAL 1.0
+
+/* The timeseries_runtime structure maintains necessary state for storing
+ * TIMESERIES records and for coordinating with darshan-core at shutdown
+ * time.  All records share the same interval, so that they collapse
+ * together.
+ */
+struct timeseries_runtime
+{
+    struct darshan_timeseries_record *recs[TIMESERIES_API_COUNT];
+    int rec_count;
+    double interval;
+    double inv_interval;
+    double max_time; /* end of the last bin at the current interval */
+    int frozen; /* flag to indicate that the counters should no longer be modified */
+};
+
+int timeseries_runtime_enabled = 0;
+
+static struct timeseries_runtime *timeseries_runtime = NULL;
+static pthread_mutex_t timeseries_runtime_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int my_rank = -1;
+
+static const char *timeseries_names[TIMESERIES_API_COUNT] = {
+    TIMESERIES_POSIX_NAME,
+    TIMESERIES_MPIIO_NAME,
+    TIMESERIES_STDIO_NAME
+};
+
+static void timeseries_collapse(void);
+#ifdef HAVE_MPI
+static void timeseries_record_reduction_op(
+    void* infile_v, void* inoutfile_v, int *len, MPI_Datatype *datatype);
+static void timeseries_mpi_redux(
+    void *timeseries_buf, MPI_Comm mod_comm,
+    darshan_record_id *shared_recs, int shared_rec_count);
+#endif
+static void timeseries_output(
+    void **timeseries_buf, int *timeseries_buf_sz);
+static void timeseries_cleanup(
+    void);
+
+#define TIMESERIES_LOCK() pthread_mutex_lock(&timeseries_runtime_mutex)
+#define TIMESERIES_UNLOCK() pthread_mutex_unlock(&timeseries_runtime_mutex)
+
+/**********************************************************
+ *      Hook for recording POSIX, MPI-IO and STDIO ops    *
+ **********************************************************/
+
+void timeseries_update(int api, int op, int64_t count, int64_t bytes,
+    double elapsed, double end_time)
+{
+    struct darshan_timeseries_record *rec;
+    int bin;
+
+    if(api < 0 || api >= TIMESERIES_API_COUNT || end_time < 0)
+        return;
+
+    TIMESERIES_LOCK();
+    if(!timeseries_runtime || timeseries_runtime->frozen ||
+       !timeseries_runtime->recs[api])
+    {
+        TIMESERIES_UNLOCK();
+        return;
+    }
+
+    /* has the job outlived the series?  if so, coarsen it */
+    while(end_time >= timeseries_runtime->max_time)
+        timeseries_collapse();
+
+    rec = timeseries_runtime->recs[api];
+    bin = (int)(end_time * timeseries_runtime->inv_interval);
+    if(bin >= TIMESERIES_NUM_BINS)
+        bin = TIMESERIES_NUM_BINS - 1;
+
+    switch(op)
+    {
+        case TIMESERIES_OP_READ:
+            rec->counters[TIMESERIES_BYTES_READ_0 + bin] += bytes;
+            rec->counters[TIMESERIES_READS_0 + bin] += count;
+            rec->fcounters[TIMESERIES_F_READ_TIME_0 + bin] += elapsed;
+            break;
+        case TIMESERIES_OP_WRITE:
+            rec->counters[TIMESERIES_BYTES_WRITTEN_0 + bin] += bytes;
+            rec->counters[TIMESERIES_WRITES_0 + bin] += count;
+            rec->fcounters[TIMESERIES_F_WRITE_TIME_0 + bin] += elapsed;
+            break;
+        case TIMESERIES_OP_META:
+            rec->counters[TIMESERIES_META_OPS_0 + bin] += count;
+            rec->fcounters[TIMESERIES_F_META_TIME_0 + bin] += elapsed;
+            break;
+        default:
+            break;
+    }
+    TIMESERIES_UNLOCK();
+
+    return;
+}
+
+/**********************************************************
+ * Internal functions for manipulating TIMESERIES module state *
+ **********************************************************/
+
+void timeseries_runtime_initialize()
+{
+    int ret;
+    int i;
+    size_t timeseries_rec_count = TIMESERIES_API_COUNT;
+    darshan_record_id rec_id;
+    struct darshan_timeseries_record *rec;
+    darshan_module_funcs mod_funcs = {
+#ifdef HAVE_MPI
+    .mod_redux_func = &timeseries_mpi_redux,
+#endif
+    .mod_output_func = &timeseries_output,
+    .mod_cleanup_func = &timeseries_cleanup
+    };
+
+    TIMESERIES_LOCK();
+
+    /* don't do anything if already initialized */
+    if(timeseries_runtime)
+    {
+        TIMESERIES_UNLOCK();
+        return;
+    }
+
+    /* register the TIMESERIES module with darshan core; this fails while
+     * the module is disabled, which it is by default
+     */
+    ret = darshan_core_register_module(
+        DARSHAN_TIMESERIES_MOD,
+        mod_funcs,
+        sizeof(struct darshan_timeseries_record),
+        &timeseries_rec_count,
+        &my_rank,
+        NULL);
+    if(ret < 0)
+    {
+        TIMESERIES_UNLOCK();
+        return;
+    }
+
+    timeseries_runtime = malloc(sizeof(*timeseries_runtime));
+    if(!timeseries_runtime)
+    {
+        darshan_core_unregister_module(DARSHAN_TIMESERIES_MOD);
+        TIMESERIES_UNLOCK();
+        return;
+    }
+    memset(timeseries_runtime, 0, sizeof(*timeseries_runtime));
+
+    timeseries_runtime->interval = darshan_core_timeseries_interval();
+    if(timeseries_runtime->interval <= 0)
+        timeseries_runtime->interval = TIMESERIES_DEF_INTERVAL;
+    timeseries_runtime->inv_interval = 1.0 / timeseries_runtime->interval;
+    timeseries_runtime->max_time =
+        timeseries_runtime->interval * TIMESERIES_NUM_BINS;
+
+    /* every process registers the record of every API up front, whether or
+     * not it uses the API, so that the records are shared and reduced at
+     * shutdown
+     */
+    for(i = 0; i < TIMESERIES_API_COUNT; i++)
+    {
+        rec_id = darshan_core_gen_record_id(timeseries_names[i]);
+        rec = darshan_core_register_record(
+            rec_id,
+            timeseries_names[i],
+            DARSHAN_TIMESERIES_MOD,
+            sizeof(struct darshan_timeseries_record),
+            NULL);
+        if(!rec)
+            continue;
+
+        rec->base_rec.id = rec_id;
+        rec->base_rec.rank = my_rank;
+        rec->counters[TIMESERIES_PROCS] = 1;
+        rec->fcounters[TIMESERIES_F_INTERVAL] = timeseries_runtime->interval;
+        timeseries_runtime->recs[i] = rec;
+        timeseries_runtime->rec_count++;
+    }
+
+    timeseries_runtime_enabled = 1;
+
+    TIMESERIES_UNLOCK();
+    return;
+}
+
+/* merge adjacent bins of every series and double the interval */
+static void timeseries_collapse()
+{
+    struct darshan_timeseries_record *rec;
+    int64_t *bins;
+    double *fbins;
+    int i, j, k;
+
+    for(i = 0; i < TIMESERIES_API_COUNT; i++)
+    {
+        rec = timeseries_runtime->recs[i];
+        if(!rec)
+            continue;
+
+        for(k = TIMESERIES_BYTES_READ_0; k < TIMESERIES_NUM_INDICES;
+            k += TIMESERIES_NUM_BINS)
+        {
+            bins = &rec->counters[k];
+            for(j = 0; j < TIMESERIES_NUM_BINS; j += 2)
+                bins[j/2] = bins[j] + bins[j+1];
+            memset(&bins[TIMESERIES_NUM_BINS/2], 0,
+                (TIMESERIES_NUM_BINS/2)*sizeof(int64_t));
+        }
+        for(k = TIMESERIES_F_READ_TIME_0; k < TIMESERIES_F_NUM_INDICES;
+            k += TIMESERIES_NUM_BINS)
+        {
+            fbins = &rec->fcounters[k];
+            for(j = 0; j < TIMESERIES_NUM_BINS; j += 2)
+                fbins[j/2] = fbins[j] + fbins[j+1];
+            memset(&fbins[TIMESERIES_NUM_BINS/2], 0,
+                (TIMESERIES_NUM_BINS/2)*sizeof(double));
+        }
+    }
+
+    timeseries_runtime->interval *= 2.0;
+    timeseries_runtime->inv_interval = 1.0 / timeseries_runtime->interval;
+    timeseries_runtime->max_time =
+        timeseries_runtime->interval * TIMESERIES_NUM_BINS;
+    for(i = 0; i < TIMESERIES_API_COUNT; i++)
+    {
+        if(timeseries_runtime->recs[i])
+            timeseries_runtime->recs[i]->fcounters[TIMESERIES_F_INTERVAL] =
+                timeseries_runtime->interval;
+    }
+
+    return;
+}
+
+#ifdef HAVE_MPI
+static void timeseries_record_reduction_op(void* infile_v, void* inoutfile_v,
+    int *len, MPI_Datatype *datatype)
+{
+    struct darshan_timeseries_record *infile = infile_v;
+    struct darshan_timeseries_record *inoutfile = inoutfile_v;
+    int i, j;
+
+    for(i=0; i<*len; i++)
+    {
+        /* all processes were brought to the same interval before the
+         * reduction, so every other counter sums bin by bin
+         */
+        for(j = 0; j < TIMESERIES_NUM_INDICES; j++)
+            inoutfile->counters[j] += infile->counters[j];
+        for(j = TIMESERIES_F_READ_TIME_0; j < TIMESERIES_F_NUM_INDICES; j++)
+            inoutfile->fcounters[j] += infile->fcounters[j];
+        inoutfile->base_rec.rank = -1;
+        infile++;
+        inoutfile++;
+    }
+
+    return;
+}
+#endif
+
+/********************************************************************************
+ * Functions exported by this module for coordinating with darshan-core *
+ ********************************************************************************/
+
+#ifdef HAVE_MPI
+static void timeseries_mpi_redux(
+    void *timeseries_buf,
+    MPI_Comm mod_comm,
+    darshan_record_id *shared_recs,
+    int shared_rec_count)
+{
+    int timeseries_rec_count;
+    struct darshan_timeseries_record *timeseries_rec_buf =
+        (struct darshan_timeseries_record *)timeseries_buf;
+    struct darshan_timeseries_record *red_send_buf = NULL;
+    struct darshan_timeseries_record *red_recv_buf = NULL;
+    MPI_Datatype red_type;
+    MPI_Op red_op;
+    double g_interval;
+    int i, j;
+
+    TIMESERIES_LOCK();
+    assert(timeseries_runtime);
+
+    /* no more updates once the records are rearranged below */
+    timeseries_runtime->frozen = 1;
+
+    /* agree on the widest interval, and coarsen the local series to it */
+    PMPI_Allreduce(&timeseries_runtime->interval, &g_interval, 1,
+        MPI_DOUBLE, MPI_MAX, mod_comm);
+    while(timeseries_runtime->interval < g_interval)
+        timeseries_collapse();
+
+    timeseries_rec_count = timeseries_runtime->rec_count;
+
+    /* necessary initialization of shared records */
+    for(i = 0; i < shared_rec_count; i++)
+    {
+        for(j = 0; j < TIMESERIES_API_COUNT; j++)
+        {
+            if(timeseries_runtime->recs[j] &&
+               timeseries_runtime->recs[j]->base_rec.id == shared_recs[i])
+                timeseries_runtime->recs[j]->base_rec.rank = -1;
+        }
+    }
+
+    /* sort the array of records descending by rank so that we get all of
+     * the shared records (marked by rank -1) in a contiguous portion at end
+     * of the array
+     */
+    darshan_record_sort(timeseries_rec_buf, timeseries_rec_count,
+        sizeof(struct darshan_timeseries_record));
+
+    /* make *send_buf point to the shared records at the end of sorted array */
+    red_send_buf = &(timeseries_rec_buf[timeseries_rec_count-shared_rec_count]);
+
+    /* allocate memory for the reduction output on rank 0 */
+    if(my_rank == 0)
+    {
+        red_recv_buf = malloc(shared_rec_count *
+            sizeof(struct darshan_timeseries_record));
+        if(!red_recv_buf)
+        {
+            TIMESERIES_UNLOCK();
+            return;
+        }
+    }
+
+    /* construct a datatype for a TIMESERIES record.  This is serving no
+     * purpose except to make sure we can do a reduction on proper boundaries
+     */
+    PMPI_Type_contiguous(sizeof(struct darshan_timeseries_record),
+        MPI_BYTE, &red_type);
+    PMPI_Type_commit(&red_type);
+
+    /* register a TIMESERIES record reduction operator */
+    PMPI_Op_create(timeseries_record_reduction_op, 1, &red_op);
+
+    /* reduce shared TIMESERIES records */
+    PMPI_Reduce(red_send_buf, red_recv_buf,
+        shared_rec_count, red_type, red_op, 0, mod_comm);
+
+    /* update module state to account for shared record reduction */
+    if(my_rank == 0)
+    {
+        /* overwrite local shared records with globally reduced records */
+        int tmp_ndx = timeseries_rec_count - shared_rec_count;
+        memcpy(&(timeseries_rec_buf[tmp_ndx]), red_recv_buf,
+            shared_rec_count * sizeof(struct darshan_timeseries_record));
+        free(red_recv_buf);
+    }
+    else
+    {
+        /* drop shared records on non-zero ranks */
+        timeseries_runtime->rec_count -= shared_rec_count;
+    }
+
+    PMPI_Type_free(&red_type);
+    PMPI_Op_free(&red_op);
+
+    TIMESERIES_UNLOCK();
+    return;
+}
+#endif
+
+static void timeseries_output(
+    void **timeseries_buf,
+    int *timeseries_buf_sz)
+{
+    struct darshan_timeseries_record *recs;
+    int i, j, k;
+
+    TIMESERIES_LOCK();
+    assert(timeseries_runtime);
+
+    timeseries_runtime->frozen = 1;
+
+    /* drop the series of APIs that were never used */
+    recs = (struct darshan_timeseries_record *)*timeseries_buf;
+    for(i = 0, j = 0; i < timeseries_runtime->rec_count; i++)
+    {
+        for(k = TIMESERIES_BYTES_READ_0; k < TIMESERIES_NUM_INDICES; k++)
+            if(recs[i].counters[k])
+                break;
+        if(k == TIMESERIES_NUM_INDICES)
+            continue;
+        if(i != j)
+            memcpy(&recs[j], &recs[i], sizeof(*recs));
+        j++;
+    }
+    timeseries_runtime->rec_count = j;
+
+    *timeseries_buf_sz = timeseries_runtime->rec_count *
+        sizeof(struct darshan_timeseries_record);
+
+    TIMESERIES_UNLOCK();
+    return;
+}
+
+static void timeseries_cleanup()
+{
+    TIMESERIES_LOCK();
+    assert(timeseries_runtime);
+
+    free(timeseries_runtime);
+    timeseries_runtime = NULL;
+    timeseries_runtime_enabled = 0;
+
+    TIMESERIES_UNLOCK();
+    return;
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
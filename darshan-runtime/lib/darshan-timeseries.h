@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifndef __DARSHAN_TIMESERIES_H
+#define __DARSHAN_TIMESERIES_H
+
+#include <stdint.h>
+
+#include "darshan-phase.h"
+#include "darshan-attrib.h"
+
+/* APIs with a series, in the order their records are registered */
+#define TIMESERIES_API_POSIX 0
+#define TIMESERIES_API_MPIIO 1
+#define TIMESERIES_API_STDIO 2
+#define TIMESERIES_API_COUNT 3
+
+/* operation classes accounted by the series */
+#define TIMESERIES_OP_READ 0
+#define TIMESERIES_OP_WRITE 1
+#define TIMESERIES_OP_META 2
+
+#ifdef DARSHAN_TIMESERIES
+
+/* set once the TIMESERIES module has registered with darshan-core, so that
+ * the record macros of other modules only pay for a flag test while the
+ * module is disabled (the default)
+ */
+extern int timeseries_runtime_enabled;
+
+/* timeseries_runtime_initialize()
+ *
+ * registers the TIMESERIES module and its records, if it is enabled;
+ * called by darshan-core at startup
+ */
+void timeseries_runtime_initialize(void);
+
+/* timeseries_update()
+ *
+ * accounts 'count' operations of class 'op' (TIMESERIES_OP_*) through API
+ * 'api' (TIMESERIES_API_*), moving 'bytes' bytes in 'elapsed' seconds, to
+ * the interval holding 'end_time'
+ */
+void timeseries_update(int api, int op, int64_t count, int64_t bytes,
+    double elapsed, double end_time);
+
+/* the series hooks also feed the PHASE module, which segments the same
+ * per-API accounting by application phase, and the ATTRIB module, which
+ * attributes it to the upper-layer call in progress
+ */
+#define TIMESERIES_RECORD_N(__api, __op, __count, __bytes, __elapsed, __end) do { \
+    if(timeseries_runtime_enabled) \
+        timeseries_update(__api, __op, __count, __bytes, __elapsed, __end); \
+    PHASE_RECORD_N(__api, __op, __count, __bytes, __elapsed); \
+    ATTRIB_RECORD_N(__api, __op, __count, __bytes, __elapsed); \
+} while(0)
+
+#else
+
+/* as with the heatmap module, provide stubs when the TIMESERIES module is
+ * disabled so that the instrumented modules do not need preprocessor guards
+ */
+
+#define TIMESERIES_RECORD_N(__api, __op, __count, __bytes, __elapsed, __end) do { \
+    PHASE_RECORD_N(__api, __op, __count, __bytes, __elapsed); \
+    ATTRIB_RECORD_N(__api, __op, __count, __bytes, __elapsed); \
+} while(0)
+
+#endif
+
+#define TIMESERIES_RECORD(__api, __op, __bytes, __tm1, __tm2) \
+    TIMESERIES_RECORD_N(__api, __op, 1, __bytes, (__tm2) - (__tm1), __tm2)
+
+#endif /* __DARSHAN_TIMESERIES_H */
@@ -33,6 +33,10 @@
 #include "darshan-config.h"
 #include "darshan-common.h"
 #include "darshan-dxt.h"
+#include "darshan-overhead.h"
+#include "darshan-rollup.h"
+#include "darshan-phase.h"
+#include "darshan-attrib.h"
 
 /* Environment variable to override __DARSHAN_JOBID */
 #define DARSHAN_JOBID_OVERRIDE "DARSHAN_JOBID"
@@ -43,22 +47,57 @@
 /* Environment variable to override __DARSHAN_LOG_HINTS */
 #define DARSHAN_LOG_HINTS_OVERRIDE "DARSHAN_LOGHINTS"
 
+/* Environment variable to override the log file compression method */
+#define DARSHAN_LOG_COMP_OVERRIDE "DARSHAN_LOGCOMP"
+
+/* Environment variable to specify a trained zstd dictionary to compress the
+ * log file with
+ */
+#define DARSHAN_LOG_COMP_DICT_OVERRIDE "DARSHAN_LOGCOMP_DICT"
+
+/* Environment variable to back Darshan's buffers with huge pages */
+#define DARSHAN_HUGEPAGES_OVERRIDE "DARSHAN_HUGEPAGES"
+
+/* huge page policies for Darshan's buffers: transparent huge pages
+ * (MADV_HUGEPAGE), or preallocated huge pages (MAP_HUGETLB) falling back
+ * to transparent ones
+ */
+#define DARSHAN_HUGEPAGES_THP 1
+#define DARSHAN_HUGEPAGES_HUGETLB 2
+
+/* Environment variable to sum heatmaps across ranks at shutdown */
+#define DARSHAN_HEATMAP_REDUCE_OVERRIDE "DARSHAN_HEATMAP_REDUCE"
+
+/* heatmap reductions: one heatmap per node (summed onto the lowest rank of
+ * the node), or one heatmap for the whole job (summed onto rank 0)
+ */
+#define DARSHAN_HEATMAP_REDUCE_NODE 1
+#define DARSHAN_HEATMAP_REDUCE_JOB 2
+
+/* assumed huge page size, to which the size of buffers is rounded up when
+ * using huge pages
+ */
+#define DARSHAN_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
 /* Environment variable to override __DARSHAN_MEM_ALIGNMENT */
 #define DARSHAN_MEM_ALIGNMENT_OVERRIDE "DARSHAN_MEMALIGN"
 
 /* Environment variable to override memory per module */
 #define DARSHAN_MOD_MEM_OVERRIDE "DARSHAN_MODMEM"
 
+/* Environment variable to grow module memory on demand, up to a cap */
+#define DARSHAN_MOD_MEM_GROW_OVERRIDE "DARSHAN_MODMEM_GROW"
+
 /* Environment variable to override memory for name records */
 #define DARSHAN_NAME_MEM_OVERRIDE "DARSHAN_NAMEMEM"
 
-#ifdef __DARSHAN_ENABLE_MMAP_LOGS
-/* Environment variable to override default mmap log path */
+/* Environment variable to override default mmap log path (also used for
+ * DXT spill files)
+ */
 #define DARSHAN_MMAP_LOG_PATH_OVERRIDE "DARSHAN_MMAP_LOGPATH"
 
 /* default path for storing mmap log files is '/tmp' */
 #define DARSHAN_DEF_MMAP_LOG_PATH "/tmp"
-#endif
 
 /* Maximum runtime memory consumption per process (in MiB) across
  * all instrumentation modules
@@ -107,15 +146,80 @@ struct darshan_core_mnt_data
     struct darshan_fs_info fs_info;
 };
 
-/* structure for keeping a reference to registered name records */
+/* lock-free open-addressed map from 64-bit ids to references whose first
+ * member is the id they are stored under. References are only ever added,
+ * by publishing them in an empty slot, and live until darshan-core shuts
+ * down.
+ */
+struct darshan_core_id_map
+{
+    void **slots;
+    uint64_t mask;
+    int shift;
+};
+
+/* structure for keeping a reference to registered name records. A thread
+ * that adds the reference to the name map appends the name entry, and
+ * other threads wait for 'state' to leave DARSHAN_CORE_REF_BUILDING before
+ * using it.
+ */
 struct darshan_core_name_record_ref
 {
-    struct darshan_name_record *name_record;
+    darshan_record_id id;
+    int state;
+    struct darshan_name_entry *name_record;
     uint64_t mod_flags;
     uint64_t global_mod_flags;
+};
+
+/* structure for keeping a reference to the directory entries that
+ * registered names are stored relative to
+ */
+struct darshan_core_name_dir_ref
+{
+    uint64_t id;
+    int state;
+    struct darshan_name_entry *dir_entry;
+    /* number of names registered directly in the directory, and the id of
+     * its rollup record once that reaches DARSHAN_DIR_ROLLUP_THRESHOLD
+     * (see darshan-rollup-log-format.h)
+     */
+    size_t file_count;
+    darshan_record_id rollup_id;
+};
+
+/* cached exclusion verdict for a record id, so that names which are
+ * repeatedly rejected are not re-matched against every exclusion rule
+ */
+struct darshan_core_excluded_ref
+{
+    darshan_record_id rec_id;
+    uint64_t mod_flags;
+};
+
+/* maps the id of each retired record to the chunk it was staged in */
+struct darshan_core_retired_ref
+{
+    darshan_record_id rec_id;
+    struct darshan_core_retired_chunk *chunk;
     UT_hash_handle hlink;
 };
 
+/* compressed copy of a batch of records that a module retired, i.e.,
+ * promised not to modify again, written to the log in place of the
+ * records themselves at shutdown unless it was dropped ('live' unset)
+ */
+struct darshan_core_retired_chunk
+{
+    char *comp_buf;
+    int comp_len;
+    int rec_count;
+    size_t rec_size;
+    struct darshan_core_retired_ref *refs;
+    int live;
+    struct darshan_core_retired_chunk *next;
+};
+
 /* linked-list structure for keeping track of different types of regexes */
 struct darshan_core_regex
 {
@@ -139,15 +243,47 @@ struct darshan_core_runtime
     struct darshan_core_module* mod_array[DARSHAN_KNOWN_MODULE_COUNT];
     struct darshan_config config;
     size_t mod_mem_used;
-    struct darshan_core_name_record_ref *name_hash;
+    /* records are registered without the core lock, so these are only
+     * updated atomically (see darshan_core_register_record())
+     */
+    struct darshan_core_id_map name_map;
+    struct darshan_core_id_map name_dir_map;
+    struct darshan_core_id_map excluded_map;
+    int excluded_cnt;
     size_t name_mem_used;
     char *comp_buf;
+    /* block index entries for the log data written by this rank */
+    struct darshan_log_block *log_index;
+    int log_index_cnt;
+    int log_index_max;
 #ifdef __DARSHAN_ENABLE_MMAP_LOGS
     char mmap_log_name[__DARSHAN_PATH_MAX];
+    struct darshan_mmap_live *mmap_live_p;
 #endif
 #ifdef HAVE_MPI
     MPI_Comm mpi_comm;
+    /* node-local aggregation state, only valid if node_agg is set */
+    int node_agg;
+    MPI_Comm node_comm;
+    MPI_Comm leader_comm;
+    int *node_counts;
+    int *node_displs;
+    /* sparse shutdown state, only valid if sparse_write is set: the ranks
+     * writing the module currently being appended to the log
+     */
+    int sparse_write;
+    MPI_Comm sparse_comm;
+    /* set if a deadline-bounded shutdown writes the log independently */
+    int indep_write;
 #endif
+    /* non-MPI child collection state (see DARSHAN_COLLECT_CHILDREN); the
+     * collecting parent records as rank 0 and its children as rank 1 and up
+     */
+    struct darshan_collect_ctl *collect_ctl;
+    char *collect_ctl_name;
+    int collect_rank;
+    struct darshan_collect_child *collect_children;
+    int collect_cnt;
     int pid;
 };
 
@@ -157,6 +293,14 @@ struct darshan_core_runtime
  */
 extern struct darshan_core_runtime *__darshan_core;
 extern double __darshan_core_wtime_offset;
+#ifdef __DARSHAN_RDTSCP_CALIBRATE
+/* seconds per TSC tick (0 if the TSC is not used for timing), and the TSC
+ * value and absolute time at which it was calibrated
+ */
+extern double __darshan_core_tsc_scale;
+extern uint64_t __darshan_core_tsc_start;
+extern double __darshan_core_tsc_base;
+#endif
 #ifdef HAVE_STDATOMIC_H
 extern atomic_flag __darshan_core_mutex;
 #define __DARSHAN_CORE_LOCK() \
@@ -231,6 +375,12 @@ extern pthread_mutex_t __darshan_core_mutex;
 /* default number of records to attempt to store for each module */
 #define DARSHAN_DEF_MOD_REC_COUNT 1024
 
+/* granularity at which module memory is grown with DARSHAN_MODMEM_GROW */
+#define DARSHAN_MOD_MEM_GROW_CHUNK (64 * 1024)
+
+/* maximum number of excluded record ids to remember the verdict for */
+#define DARSHAN_EXCLUDED_CACHE_MAX 4096
+
 #ifdef HAVE_MPI
 /*
  * module developers _may_ define a 'darshan_module_redux' function
@@ -274,8 +424,21 @@ typedef struct darshan_module_funcs
 struct darshan_core_module
 {
     void *rec_buf_start;
+    /* next free record and memory left for records, updated atomically */
     void *rec_buf_p;
     size_t rec_mem_avail;
+    /* size of the module's own address space reservation, which its
+     * records grow into, or 0 if they are carved from the shared pool,
+     * and how much of it has been made accessible so far
+     */
+    size_t rec_mem_max;
+    size_t rec_mem_grown;
+    /* record limit set by the user, if growing */
+    size_t rec_max_count;
+    /* records staged by darshan_core_retire_records() */
+    struct darshan_core_retired_chunk *retired_chunks;
+    struct darshan_core_retired_ref *retired_hash;
+    int retired_live;
     darshan_module_funcs mod_funcs;
 };
 
@@ -326,6 +489,30 @@ void darshan_instrument_fs_data(
     darshan_record_id rec_id,
     int fd);
 
+/* darshan_instrument_fs_open()
+ *
+ * Called when the file record corresponding to 'rec_id' is opened on file
+ * descriptor 'fd'. Instruments file system data for the file right away if
+ * a file system module needs it ahead of the first access of the file.
+ */
+void darshan_instrument_fs_open(
+    int fs_type,
+    darshan_record_id rec_id,
+    int fd);
+
+/* darshan_instrument_fs_io()
+ *
+ * Allow file system-specific modules to instrument a read or write
+ * ('rw_flag' is DARSHAN_IO_READ or DARSHAN_IO_WRITE) of 'length' bytes at
+ * 'offset' in the file record corresponding to 'rec_id'.
+ */
+void darshan_instrument_fs_io(
+    int fs_type,
+    darshan_record_id rec_id,
+    int64_t offset,
+    int64_t length,
+    int rw_flag);
+
 /* darshan_core_gen_record_id()
  *
  * Returns the Darshan record ID correpsonding to input string 'name'.
@@ -356,13 +543,44 @@ void *darshan_core_register_record(
     struct darshan_fs_info *fs_info);
 
 
-/* darshan_core_lookup_record_name()
+/* darshan_core_retire_records()
  *
- * Looks up the name associated with a given Darshan record ID.
+ * Stages a compressed copy of the 'count' records of module 'mod_id'
+ * pointed to by 'recs', each 'rec_size' bytes and starting with a
+ * darshan_base_record, which the module promises not to modify again
+ * unless it first calls darshan_core_revive_record().  At shutdown, the
+ * staged records are left out of the module's output buffer and their
+ * compressed copy is written instead, so that shutdown only compresses
+ * records that are still changing.  Returns 0 on success, or -1 if the
+ * records were not staged (they are then written as usual).
  */
-char *darshan_core_lookup_record_name(
+int darshan_core_retire_records(
+    darshan_module_id mod_id,
+    void **recs,
+    int count,
+    size_t rec_size);
+
+/* darshan_core_revive_record()
+ *
+ * Drops the compressed copy of record 'rec_id' of module 'mod_id', if it
+ * was retired, along with the records staged with it, which are then
+ * written from the module's output buffer as usual.
+ */
+void darshan_core_revive_record(
+    darshan_module_id mod_id,
     darshan_record_id rec_id);
 
+/* darshan_core_lookup_record_name()
+ *
+ * Looks up the name associated with a given Darshan record ID, and
+ * copies it to the 'name' buffer of size 'name_len'. Returns 1 on
+ * success, or 0 if the record has no name or the name does not fit.
+ */
+int darshan_core_lookup_record_name(
+    darshan_record_id rec_id,
+    char *name,
+    size_t name_len);
+
 /* darshan_core_disabled_instrumentation
  *
  * Returns true (1) if Darshan has currently disabled instrumentation,
@@ -384,6 +602,184 @@ static inline int darshan_core_disabled_instrumentation(void)
     return(ret);
 }
 
+/* darshan_core_thread_shards_enabled()
+ *
+ * Returns true (1) if modules should record data operations into
+ * per-thread shards of their runtime state (merged at shutdown time),
+ * rather than serializing all threads on a module-wide lock. Returns
+ * false (0) otherwise.
+ */
+int darshan_core_thread_shards_enabled(void);
+
+/* darshan_core_heatmap_ops_enabled()
+ *
+ * Returns true (1) if heatmaps should record operation counts (reads,
+ * writes, and metadata operations) in addition to bytes moved. Returns
+ * false (0) otherwise.
+ */
+int darshan_core_heatmap_ops_enabled(void);
+
+/* darshan_core_heatmap_reduce()
+ *
+ * Returns how heatmaps are summed across ranks at shutdown
+ * (DARSHAN_HEATMAP_REDUCE_NODE or DARSHAN_HEATMAP_REDUCE_JOB), or 0 if
+ * each rank keeps its own heatmaps.
+ */
+int darshan_core_heatmap_reduce(void);
+
+/* darshan_core_mpiio_coll_wait_enabled()
+ *
+ * Returns true (1) if the MPI-IO module should separate the time ranks
+ * spend waiting for each other to enter collective reads and writes from
+ * the time spent performing them. Returns false (0) otherwise.
+ */
+int darshan_core_mpiio_coll_wait_enabled(void);
+
+/* darshan_core_lustre_layout_cache_enabled()
+ *
+ * Returns true (1) if the Lustre module may take the layout of a newly
+ * instrumented file from the cached default layout of its directory
+ * rather than querying the file. Returns false (0) otherwise.
+ */
+int darshan_core_lustre_layout_cache_enabled(void);
+
+/* darshan_core_lustre_ost_traffic_enabled()
+ *
+ * Returns true (1) if the Lustre module should account POSIX read and
+ * write traffic to the OSTs serving it. Returns false (0) otherwise.
+ */
+int darshan_core_lustre_ost_traffic_enabled(void);
+
+/* darshan_core_stdio_batch_small()
+ *
+ * Returns N if the STDIO module should count single character and word
+ * calls in per-thread batches, timing about one in every N of them.
+ * Returns 0 if these calls should be recorded individually.
+ */
+size_t darshan_core_stdio_batch_small(void);
+
+/* darshan_core_sample_rate()
+ *
+ * Returns N if module 'mod_id' should only pay for the costly parts of
+ * recording (timers, common value tracking, tracing) on about one in every
+ * N data operations, scaling the results, or 1 if every operation should
+ * be recorded in full. A rate above 1 is noted in the job metadata as
+ * "<module>_sample_rate=N", so this should be called once, when the
+ * module initializes.
+ */
+size_t darshan_core_sample_rate(darshan_module_id mod_id);
+
+/* darshan_core_timeseries_interval()
+ *
+ * Returns the initial width, in seconds, of the intervals of the TIMESERIES
+ * module, or 0 if the module default should be used.
+ */
+double darshan_core_timeseries_interval(void);
+
+/* darshan_core_mmap_sample_interval()
+ *
+ * Returns the time, in seconds, between the residency samples of the MMAP
+ * module, or 0 if the module default should be used.
+ */
+double darshan_core_mmap_sample_interval(void);
+
+/* darshan_core_dir_rollup_threshold()
+ *
+ * Returns the number of files of a directory that get records of their
+ * own before darshan-core collapses further files of the directory into
+ * a rollup record, or 0 if directory rollup is disabled.
+ */
+size_t darshan_core_dir_rollup_threshold(void);
+
+/* darshan_core_phase_barriers()
+ *
+ * Returns the number of MPI_Barrier() calls that delimit automatic
+ * phases of the PHASE module, or 0 if automatic phases are disabled.
+ */
+size_t darshan_core_phase_barriers(void);
+
+/* darshan_core_record_retire_time()
+ *
+ * Returns the time, in seconds, that closed records must go untouched
+ * before modules retire them with darshan_core_retire_records(), or 0 if
+ * records are not retired.
+ */
+double darshan_core_record_retire_time(void);
+
+/* darshan_core_dxt_ring_segments()
+ *
+ * Returns the number of segments DXT should retain per file and per
+ * direction in ring buffer mode, overwriting the oldest segments once
+ * full. Returns 0 if ring buffer mode is disabled.
+ */
+size_t darshan_core_dxt_ring_segments(void);
+
+/* darshan_core_dxt_spill_dir()
+ *
+ * Returns a newly allocated copy of the directory DXT should place its
+ * trace spill file in, or NULL if DXT spill mode is not enabled. The
+ * caller is responsible for freeing the returned string.
+ */
+char *darshan_core_dxt_spill_dir(void);
+
+/* darshan_core_mem_policy_enabled()
+ *
+ * Returns true (1) if a huge page (DARSHAN_HUGEPAGES) or first-touch
+ * (DARSHAN_MEM_FIRST_TOUCH) policy is set for Darshan's buffers, in which
+ * case modules should allocate their large buffers with
+ * darshan_core_mem_alloc(). Returns false (0) otherwise.
+ */
+int darshan_core_mem_policy_enabled(void);
+
+/* darshan_core_mem_alloc()
+ *
+ * Allocates 'size' bytes of zeroed, page-aligned memory following the
+ * memory policy for Darshan's buffers. With a first-touch policy, the
+ * memory is faulted in by the calling thread, placing it on the calling
+ * thread's NUMA node. Returns NULL on failure.
+ */
+void *darshan_core_mem_alloc(size_t size);
+
+/* darshan_core_mem_free()
+ *
+ * Frees memory at 'ptr' of size 'size' (as passed to
+ * darshan_core_mem_alloc()).
+ */
+void darshan_core_mem_free(void *ptr, size_t size);
+
+struct dxt_trigger;
+
+/* darshan_core_dxt_online_triggers()
+ *
+ * Copies the configured DXT trace triggers (at most 2) into 'triggers' and
+ * sets 'trigger_count' accordingly. Returns the number of operations on a
+ * file after which DXT should evaluate the triggers while the application
+ * runs, or 0 if triggers should only be applied at shutdown.
+ */
+size_t darshan_core_dxt_online_triggers(
+    struct dxt_trigger *triggers,
+    int *trigger_count);
+
+/* darshan_core_mark_partial()
+ *
+ * Flags module 'mod_id' as having run out of memory to store its data.
+ * Intended for DXT modules, which account for their trace memory
+ * themselves rather than registering it with darshan-core.
+ */
+void darshan_core_mark_partial(
+    darshan_module_id mod_id);
+
+/* darshan_core_get_overhead()
+ *
+ * Fills the darshan-core costs of OVERHEAD record 'core_rec' (init, record
+ * registration and, during shutdown, the shutdown phases so far) and sets
+ * 'mod_shutdown_times' (DARSHAN_KNOWN_MODULE_COUNT entries) to the time each
+ * module has spent being shut down and written to the log.
+ */
+void darshan_core_get_overhead(
+    struct darshan_overhead_record *core_rec,
+    double *mod_shutdown_times);
+
 /* retrieve absolute wtime */
 static inline double darshan_core_wtime_absolute(void)
 {
@@ -397,6 +793,18 @@ static inline double darshan_core_wtime_absolute(void)
 #else
     /* normal path */
     struct timespec tp;
+#ifdef __DARSHAN_RDTSCP_CALIBRATE
+    /* use rdtscp if darshan-core found an invariant TSC and calibrated its
+     * frequency at startup
+     */
+    if(__darshan_core_tsc_scale > 0)
+    {
+        unsigned flag;
+
+        return(__darshan_core_tsc_base + __darshan_core_tsc_scale *
+            (double)(__rdtscp(&flag) - __darshan_core_tsc_start));
+    }
+#endif
     /* some notes on what function to use to retrieve time as of 2021-05:
      * - clock_gettime() is faster than MPI_Wtime() across platforms
      * - clock_gettime() is at least competitive with gettimeofday()
@@ -422,6 +830,104 @@ static inline double darshan_core_wtime(void)
     return(darshan_core_wtime_absolute() - __darshan_core_wtime_offset);
 }
 
+/* Per-thread timestamps shared between the layers of one logical I/O
+ * operation.  An upper-layer call that passes more or less directly
+ * through to the layer below (e.g., an independent MPI-IO write issuing a
+ * pwrite) publishes its start time, which the first lower-layer operation
+ * it issues takes as its own start time, and takes the end time of that
+ * lower-layer operation as its own if it was the only timed operation the
+ * call issued.  Calls that do significant work of their own around the
+ * lower layer (e.g., collective MPI-IO) time themselves as usual.
+ */
+struct darshan_layer_wtime
+{
+    double start;          /* start time published by the enclosing call */
+    int start_valid;       /* set until an operation takes 'start' */
+    double end;            /* end time of the last timed operation */
+    unsigned long seq;     /* count of timestamps taken on this thread */
+    unsigned long end_seq; /* value of 'seq' when 'end' was taken */
+};
+
+extern __thread struct darshan_layer_wtime darshan_layer_wtime;
+
+/* darshan_layer_wtime_start()
+ *
+ * Returns the start time of an operation: the start time published by the
+ * enclosing call, if no other operation has taken it yet, or else the
+ * current time.
+ */
+static inline double darshan_layer_wtime_start(void)
+{
+    if(darshan_layer_wtime.start_valid)
+    {
+        darshan_layer_wtime.start_valid = 0;
+        return(darshan_layer_wtime.start);
+    }
+    return(darshan_core_wtime());
+}
+
+/* darshan_layer_wtime_end()
+ *
+ * Returns the end time of a lowest-layer operation, and makes it
+ * available to the enclosing call.
+ */
+static inline double darshan_layer_wtime_end(void)
+{
+    double tm = darshan_core_wtime();
+
+    darshan_layer_wtime.end = tm;
+    darshan_layer_wtime.end_seq = ++darshan_layer_wtime.seq;
+    return(tm);
+}
+
+/* darshan_layer_wtime_other()
+ *
+ * Called for timestamps of operations that do not share them, so that
+ * they are not mistaken for part of an enclosing pass-through call.
+ */
+static inline void darshan_layer_wtime_other(void)
+{
+    darshan_layer_wtime.start_valid = 0;
+    darshan_layer_wtime.seq++;
+}
+
+/* darshan_layer_wtime_enter()
+ *
+ * Returns the start time of a pass-through call and publishes it to the
+ * layer below; '*seq' must be passed on to darshan_layer_wtime_leave().
+ */
+static inline double darshan_layer_wtime_enter(unsigned long *seq)
+{
+    double tm = darshan_layer_wtime_start();
+
+    darshan_layer_wtime.start = tm;
+    darshan_layer_wtime.start_valid = 1;
+    *seq = darshan_layer_wtime.seq;
+    return(tm);
+}
+
+/* darshan_layer_wtime_leave()
+ *
+ * Returns the end time of a pass-through call, reusing the end time of the
+ * lower-layer operation it issued if there was exactly one, and makes it
+ * available to the enclosing call in turn.
+ */
+static inline double darshan_layer_wtime_leave(unsigned long seq)
+{
+    double tm;
+
+    darshan_layer_wtime.start_valid = 0;
+    if(darshan_layer_wtime.seq == seq + 1 &&
+        darshan_layer_wtime.end_seq == darshan_layer_wtime.seq)
+        tm = darshan_layer_wtime.end;
+    else
+        tm = darshan_core_wtime();
+
+    darshan_layer_wtime.end = tm;
+    darshan_layer_wtime.seq = darshan_layer_wtime.end_seq = seq + 1;
+    return(tm);
+}
+
 /* darshan_core_abs_timespec_from_wtime
  * 
  * converts the darshan_core_wtime() floating point values to absolute times in timespec (i.e. epoch time).
@@ -3,8 +3,21 @@
  *      See COPYRIGHT in top-level directory.
  */
 
-/* Arguments: an integer specifying the number of iterations to run of each
- * test phase
+/* With no arguments, runs the built-in set of test cases and reports their
+ * timing on stderr (set DARSHAN_INTERNAL_TIMING to see it).
+ *
+ * With any of the following arguments, runs one shutdown of the described
+ * workload and appends its per-phase timing (maximum across ranks) as one
+ * line of JSON to stdout or to the --output file:
+ *
+ *   --files <n>         files per rank in each module (default 1)
+ *   --shared <f>        fraction of those files opened by every rank
+ *                       (default 0)
+ *   --dxt-segments <n>  DXT segments per file; 0 disables DXT (default 0)
+ *   --heatmap <0|1>     enable the heatmap module (default 1)
+ *   --modules <list>    modules to generate records for: POSIX, MPI-IO or
+ *                       POSIX,MPI-IO (default)
+ *   --output <file>     JSON output file
  */
 
 #include <stdio.h>
@@ -26,13 +39,6 @@ int main(int argc, char **argv)
 {
     MPI_Init(&argc, &argv);
 
-    if(argc != 1)
-    {
-        fprintf(stderr, "Usage: %s\n", argv[0]);
-        MPI_Finalize();
-        return(-1);
-    }
-
     darshan_shutdown_bench(argc, argv);
 
     MPI_Finalize();
@@ -0,0 +1,570 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+/*
+ * Microbenchmark for the per-call latency that Darshan adds to the I/O
+ * functions it wraps.
+ *
+ * Each selected operation is issued <iters> times in a tight loop by 1, 2,
+ * 4, ... up to <maxthreads> threads, each thread working on its own file.
+ * One CSV line is printed per (operation, thread count), giving the average
+ * latency of a call as seen by a thread and the aggregate call rate:
+ *
+ *   label,op,threads,iters,ns_per_call,calls_per_sec
+ *
+ * The program itself is not Darshan aware; run it once without Darshan and
+ * once per Darshan configuration of interest and compare the ns_per_call
+ * columns (darshan-wrapper-bench.sh does this for the usual configurations).
+ *
+ * Non-MPI build (POSIX and STDIO operations only):
+ *
+ * gcc -O2 -o darshan-wrapper-bench darshan-wrapper-bench.c -lpthread
+ *
+ * MPI build, adding MPI_File_write_at (and H5Dwrite with -DHAVE_HDF5):
+ *
+ * mpicc -O2 -DHAVE_MPI -o darshan-wrapper-bench darshan-wrapper-bench.c \
+ *     -lpthread
+ *
+ * The MPI-IO and HDF5 operations are only run single threaded, and with MPI
+ * every rank runs the loops on its own files; rank 0 reports the slowest
+ * rank.
+ */
+
+#define _XOPEN_SOURCE 600
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef HAVE_MPI
+#include <mpi.h>
+#endif
+#ifdef HAVE_HDF5
+#include <hdf5.h>
+#endif
+
+#define BENCH_BUF_SIZE 4096
+
+struct bench_thread
+{
+    int tid;
+    char path[4096];
+    int fd;
+    FILE *fp;
+#ifdef HAVE_MPI
+    MPI_File mfh;
+#endif
+#ifdef HAVE_HDF5
+    hid_t h5file;
+    hid_t h5dset;
+#endif
+    char buf[BENCH_BUF_SIZE];
+};
+
+struct bench_op
+{
+    const char *name;
+    int single_thread; /* the library is not assumed to be thread safe */
+    int (*setup)(struct bench_thread *t);
+    int (*run)(struct bench_thread *t, long iters);
+    void (*teardown)(struct bench_thread *t);
+};
+
+static const char *bench_dir = ".";
+static int bench_rank = 0;
+static size_t bench_xfer = 1;
+
+static double wtime(void)
+{
+    struct timespec tp;
+
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return((double)tp.tv_sec + (double)tp.tv_nsec * 1e-9);
+}
+
+/* POSIX operations, all on a file descriptor opened by setup */
+
+static int posix_setup(struct bench_thread *t)
+{
+    t->fd = open(t->path, O_CREAT|O_RDWR|O_TRUNC, 0644);
+    if(t->fd < 0 || pwrite(t->fd, t->buf, bench_xfer, 0) != (ssize_t)bench_xfer)
+    {
+        perror(t->path);
+        return(-1);
+    }
+    return(0);
+}
+
+static void posix_teardown(struct bench_thread *t)
+{
+    close(t->fd);
+    unlink(t->path);
+}
+
+static int run_read(struct bench_thread *t, long iters)
+{
+    long i;
+
+    for(i = 0; i < iters; i++)
+    {
+        /* read from the start every time so the call never hits EOF */
+        if(pread(t->fd, t->buf, bench_xfer, 0) != (ssize_t)bench_xfer)
+        {
+            perror("pread");
+            return(-1);
+        }
+    }
+    return(0);
+}
+
+static int run_pwrite(struct bench_thread *t, long iters)
+{
+    long i;
+
+    for(i = 0; i < iters; i++)
+    {
+        if(pwrite(t->fd, t->buf, bench_xfer, 0) != (ssize_t)bench_xfer)
+        {
+            perror("pwrite");
+            return(-1);
+        }
+    }
+    return(0);
+}
+
+static int run_open(struct bench_thread *t, long iters)
+{
+    long i;
+    int fd;
+
+    /* measured per open/close pair; there is no way to time open alone
+     * without running out of file descriptors
+     */
+    for(i = 0; i < iters; i++)
+    {
+        fd = open(t->path, O_RDONLY);
+        if(fd < 0)
+        {
+            perror("open");
+            return(-1);
+        }
+        close(fd);
+    }
+    return(0);
+}
+
+static int run_stat(struct bench_thread *t, long iters)
+{
+    struct stat sbuf;
+    long i;
+
+    for(i = 0; i < iters; i++)
+    {
+        if(stat(t->path, &sbuf) < 0)
+        {
+            perror("stat");
+            return(-1);
+        }
+    }
+    return(0);
+}
+
+/* STDIO operations */
+
+static int stdio_setup(struct bench_thread *t)
+{
+    t->fp = fopen(t->path, "w+");
+    if(!t->fp)
+    {
+        perror(t->path);
+        return(-1);
+    }
+    return(0);
+}
+
+static void stdio_teardown(struct bench_thread *t)
+{
+    fclose(t->fp);
+    unlink(t->path);
+}
+
+static int run_fwrite(struct bench_thread *t, long iters)
+{
+    long i;
+
+    for(i = 0; i < iters; i++)
+    {
+        /* rewind now and then so that the file stays small */
+        if((i & 1023) == 0)
+            rewind(t->fp);
+        if(fwrite(t->buf, 1, bench_xfer, t->fp) != bench_xfer)
+        {
+            perror("fwrite");
+            return(-1);
+        }
+    }
+    return(0);
+}
+
+#ifdef HAVE_MPI
+static int mpiio_setup(struct bench_thread *t)
+{
+    int ret;
+
+    ret = MPI_File_open(MPI_COMM_SELF, t->path, MPI_MODE_CREATE|MPI_MODE_RDWR,
+        MPI_INFO_NULL, &t->mfh);
+    if(ret != MPI_SUCCESS)
+    {
+        fprintf(stderr, "Error: MPI_File_open() failed for %s.\n", t->path);
+        return(-1);
+    }
+    return(0);
+}
+
+static void mpiio_teardown(struct bench_thread *t)
+{
+    MPI_File_close(&t->mfh);
+    unlink(t->path);
+}
+
+static int run_mpi_write_at(struct bench_thread *t, long iters)
+{
+    MPI_Status status;
+    long i;
+
+    for(i = 0; i < iters; i++)
+    {
+        if(MPI_File_write_at(t->mfh, 0, t->buf, (int)bench_xfer, MPI_BYTE,
+            &status) != MPI_SUCCESS)
+        {
+            fprintf(stderr, "Error: MPI_File_write_at() failed.\n");
+            return(-1);
+        }
+    }
+    return(0);
+}
+#endif
+
+#ifdef HAVE_HDF5
+static int hdf5_setup(struct bench_thread *t)
+{
+    hsize_t dims = BENCH_BUF_SIZE;
+    hid_t space;
+
+    t->h5file = H5Fcreate(t->path, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+    if(t->h5file < 0)
+        return(-1);
+    space = H5Screate_simple(1, &dims, NULL);
+    t->h5dset = H5Dcreate2(t->h5file, "bench", H5T_NATIVE_CHAR, space,
+        H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    H5Sclose(space);
+    if(t->h5dset < 0)
+        return(-1);
+    return(0);
+}
+
+static void hdf5_teardown(struct bench_thread *t)
+{
+    H5Dclose(t->h5dset);
+    H5Fclose(t->h5file);
+    unlink(t->path);
+}
+
+static int run_h5dwrite(struct bench_thread *t, long iters)
+{
+    hsize_t start = 0, count = bench_xfer;
+    hid_t mspace, fspace;
+    long i;
+    int ret = 0;
+
+    mspace = H5Screate_simple(1, &count, NULL);
+    fspace = H5Dget_space(t->h5dset);
+    H5Sselect_hyperslab(fspace, H5S_SELECT_SET, &start, NULL, &count, NULL);
+    for(i = 0; i < iters; i++)
+    {
+        if(H5Dwrite(t->h5dset, H5T_NATIVE_CHAR, mspace, fspace, H5P_DEFAULT,
+            t->buf) < 0)
+        {
+            fprintf(stderr, "Error: H5Dwrite() failed.\n");
+            ret = -1;
+            break;
+        }
+    }
+    H5Sclose(fspace);
+    H5Sclose(mspace);
+    return(ret);
+}
+#endif
+
+static struct bench_op bench_ops[] =
+{
+    {"read", 0, posix_setup, run_read, posix_teardown},
+    {"pwrite", 0, posix_setup, run_pwrite, posix_teardown},
+    {"open", 0, posix_setup, run_open, posix_teardown},
+    {"stat", 0, posix_setup, run_stat, posix_teardown},
+    {"fwrite", 0, stdio_setup, run_fwrite, stdio_teardown},
+#ifdef HAVE_MPI
+    {"MPI_File_write_at", 1, mpiio_setup, run_mpi_write_at, mpiio_teardown},
+#endif
+#ifdef HAVE_HDF5
+    {"H5Dwrite", 1, hdf5_setup, run_h5dwrite, hdf5_teardown},
+#endif
+};
+#define BENCH_NOPS (sizeof(bench_ops) / sizeof(bench_ops[0]))
+
+struct bench_run
+{
+    struct bench_op *op;
+    struct bench_thread *threads;
+    pthread_barrier_t barrier;
+    long iters;
+    double *elapsed;
+    int err;
+};
+
+struct bench_arg
+{
+    struct bench_run *run;
+    int tid;
+};
+
+static void *bench_thread_fn(void *arg)
+{
+    struct bench_arg *a = arg;
+    struct bench_run *r = a->run;
+    struct bench_thread *t = &r->threads[a->tid];
+    double tm1, tm2;
+    int ret;
+
+    ret = r->op->setup(t);
+    /* untimed warmup, so that the first call (which creates the Darshan
+     * record) is not counted
+     */
+    if(ret == 0)
+        ret = r->op->run(t, r->iters / 100 + 1);
+
+    pthread_barrier_wait(&r->barrier);
+    tm1 = wtime();
+    if(ret == 0)
+        ret = r->op->run(t, r->iters);
+    tm2 = wtime();
+
+    r->elapsed[a->tid] = tm2 - tm1;
+    if(ret != 0)
+        r->err = 1;
+    r->op->teardown(t);
+    return(NULL);
+}
+
+/* runs one operation with nthreads threads and returns the elapsed time of
+ * the slowest thread, or a negative value on error
+ */
+static double bench_run_op(struct bench_op *op, int nthreads, long iters)
+{
+    struct bench_run r;
+    struct bench_arg *args;
+    pthread_t *tids;
+    double max = 0;
+    int i;
+
+    memset(&r, 0, sizeof(r));
+    r.op = op;
+    r.iters = iters;
+    r.threads = calloc(nthreads, sizeof(*r.threads));
+    r.elapsed = calloc(nthreads, sizeof(*r.elapsed));
+    args = calloc(nthreads, sizeof(*args));
+    tids = calloc(nthreads, sizeof(*tids));
+    if(!r.threads || !r.elapsed || !args || !tids)
+    {
+        perror("calloc");
+        exit(1);
+    }
+    pthread_barrier_init(&r.barrier, NULL, nthreads);
+
+    for(i = 0; i < nthreads; i++)
+    {
+        r.threads[i].tid = i;
+        memset(r.threads[i].buf, 'a', BENCH_BUF_SIZE);
+        snprintf(r.threads[i].path, sizeof(r.threads[i].path),
+            "%s/wrapper-bench.%d.%d", bench_dir, bench_rank, i);
+        args[i].run = &r;
+        args[i].tid = i;
+        if(pthread_create(&tids[i], NULL, bench_thread_fn, &args[i]) != 0)
+        {
+            perror("pthread_create");
+            exit(1);
+        }
+    }
+    for(i = 0; i < nthreads; i++)
+    {
+        pthread_join(tids[i], NULL);
+        if(r.elapsed[i] > max)
+            max = r.elapsed[i];
+    }
+
+    pthread_barrier_destroy(&r.barrier);
+    free(tids);
+    free(args);
+    free(r.elapsed);
+    free(r.threads);
+
+    return(r.err ? -1.0 : max);
+}
+
+/* powers of two, always ending with maxthreads itself */
+static int next_nthreads(int nthreads, int maxthreads)
+{
+    if(nthreads == maxthreads)
+        return(maxthreads + 1);
+    if(nthreads * 2 > maxthreads)
+        return(maxthreads);
+    return(nthreads * 2);
+}
+
+static void usage(const char *exe)
+{
+    unsigned int i;
+
+    fprintf(stderr, "Usage: %s [-d <dir>] [-i <iters>] [-t <maxthreads>]"
+        " [-s <xfer_size>] [-o <op>[,<op>...]] [-l <label>] [-H]\n", exe);
+    fprintf(stderr, "    -d: directory to create test files in (default: .)\n");
+    fprintf(stderr, "    -i: calls per thread and operation (default: 100000)\n");
+    fprintf(stderr, "    -t: maximum number of threads (default: 1)\n");
+    fprintf(stderr, "    -s: bytes per read/write call (default: 1)\n");
+    fprintf(stderr, "    -o: operations to run (default: all of");
+    for(i = 0; i < BENCH_NOPS; i++)
+        fprintf(stderr, " %s", bench_ops[i].name);
+    fprintf(stderr, ")\n");
+    fprintf(stderr, "    -l: value of the label column (default: none)\n");
+    fprintf(stderr, "    -H: do not print the CSV header line\n");
+}
+
+static int op_selected(const char *ops, const char *name)
+{
+    size_t len = strlen(name);
+    const char *p = ops;
+
+    if(!ops)
+        return(1);
+    while((p = strstr(p, name)) != NULL)
+    {
+        if((p == ops || p[-1] == ',') && (p[len] == ',' || p[len] == '\0'))
+            return(1);
+        p += len;
+    }
+    return(0);
+}
+
+int main(int argc, char **argv)
+{
+    const char *ops = NULL;
+    const char *label = "";
+    long iters = 100000;
+    int maxthreads = 1;
+    int header = 1;
+    int nthreads;
+    int opt;
+    int err = 0;
+    unsigned int i;
+    double elapsed;
+
+#ifdef HAVE_MPI
+    int provided;
+
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+    MPI_Comm_rank(MPI_COMM_WORLD, &bench_rank);
+#endif
+
+    while((opt = getopt(argc, argv, "d:i:t:s:o:l:H")) != -1)
+    {
+        switch(opt)
+        {
+            case 'd':
+                bench_dir = optarg;
+                break;
+            case 'i':
+                iters = atol(optarg);
+                break;
+            case 't':
+                maxthreads = atoi(optarg);
+                break;
+            case 's':
+                bench_xfer = strtoul(optarg, NULL, 10);
+                break;
+            case 'o':
+                ops = optarg;
+                break;
+            case 'l':
+                label = optarg;
+                break;
+            case 'H':
+                header = 0;
+                break;
+            default:
+                usage(argv[0]);
+                return(-1);
+        }
+    }
+    if(optind != argc || iters < 1 || maxthreads < 1 || bench_xfer < 1 ||
+        bench_xfer > BENCH_BUF_SIZE)
+    {
+        usage(argv[0]);
+        return(-1);
+    }
+
+    if(header && bench_rank == 0)
+        printf("label,op,threads,iters,ns_per_call,calls_per_sec\n");
+
+    for(i = 0; i < BENCH_NOPS && !err; i++)
+    {
+        if(!op_selected(ops, bench_ops[i].name))
+            continue;
+        for(nthreads = 1; nthreads <= maxthreads;
+            nthreads = next_nthreads(nthreads, maxthreads))
+        {
+            if(bench_ops[i].single_thread && nthreads > 1)
+                break;
+
+            elapsed = bench_run_op(&bench_ops[i], nthreads, iters);
+#ifdef HAVE_MPI
+            /* an error on any rank shows up as a negative minimum */
+            {
+                double min;
+                MPI_Allreduce(&elapsed, &min, 1, MPI_DOUBLE, MPI_MIN,
+                    MPI_COMM_WORLD);
+                MPI_Allreduce(MPI_IN_PLACE, &elapsed, 1, MPI_DOUBLE, MPI_MAX,
+                    MPI_COMM_WORLD);
+                if(min < 0)
+                    elapsed = min;
+            }
+#endif
+            if(elapsed < 0)
+            {
+                fprintf(stderr, "Error: %s benchmark failed.\n",
+                    bench_ops[i].name);
+                err = 1;
+                break;
+            }
+            if(bench_rank == 0)
+                printf("%s,%s,%d,%ld,%.2f,%.0f\n", label, bench_ops[i].name,
+                    nthreads, iters, elapsed * 1e9 / (double)iters,
+                    (double)nthreads * (double)iters / elapsed);
+            fflush(stdout);
+        }
+    }
+
+#ifdef HAVE_MPI
+    MPI_Finalize();
+#endif
+    return(err ? -1 : 0);
+}
@@ -0,0 +1,62 @@
+#!/bin/bash
+#
+# Copyright (C) 2024 University of Chicago.
+# See COPYRIGHT notice in top-level directory.
+#
+# Runs darshan-wrapper-bench once without Darshan and once for each of the
+# usual Darshan configurations, and prints a single CSV table (see
+# darshan-wrapper-bench.c for the columns) on stdout:
+#
+#   none     Darshan not loaded
+#   darshan  default modules, heatmap disabled
+#   heatmap  default modules (the heatmap module is enabled by default)
+#   dxt      default modules plus DXT tracing, heatmap disabled
+#
+# Usage: darshan-wrapper-bench.sh <libdarshan.so> <bench_exe> [bench args]
+#
+# Any extra arguments (e.g. -i, -t, -o, -d) are passed to every run. To run
+# an MPI build under a launcher, set BENCH_LAUNCHER (e.g. "mpiexec -n 1");
+# otherwise Darshan is used in non-MPI mode.
+
+if [ $# -lt 2 ]; then
+    echo "Usage: $0 <libdarshan.so> <bench_exe> [bench args]" 1>&2
+    exit 1
+fi
+
+DARSHAN_LIB=$1
+BENCH_EXE=$2
+shift 2
+
+if [ ! -f "$DARSHAN_LIB" ] || [ ! -x "$BENCH_EXE" ]; then
+    echo "Error: $DARSHAN_LIB or $BENCH_EXE not found." 1>&2
+    exit 1
+fi
+
+LOG_DIR=$(mktemp -d) || exit 1
+trap 'rm -rf "$LOG_DIR"' EXIT
+
+run_config()
+{
+    label=$1
+    shift
+    # the remaining arguments are environment settings for this run
+    env "$@" DARSHAN_LOGFILE="$LOG_DIR/$label.darshan" \
+        $BENCH_LAUNCHER "$BENCH_EXE" -l "$label" $HEADER_OPT $BENCH_ARGS || exit 1
+    HEADER_OPT=-H
+}
+
+BENCH_ARGS="$*"
+HEADER_OPT=
+if [ -z "$BENCH_LAUNCHER" ]; then
+    NONMPI=DARSHAN_ENABLE_NONMPI=1
+else
+    NONMPI=
+fi
+
+run_config none
+run_config darshan LD_PRELOAD="$DARSHAN_LIB" $NONMPI DARSHAN_MOD_DISABLE=HEATMAP
+run_config heatmap LD_PRELOAD="$DARSHAN_LIB" $NONMPI
+run_config dxt LD_PRELOAD="$DARSHAN_LIB" $NONMPI DARSHAN_MOD_DISABLE=HEATMAP \
+    DXT_ENABLE_IO_TRACE=1
+
+exit 0
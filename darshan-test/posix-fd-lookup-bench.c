@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+/*
+ * Microbenchmark for the per-call cost of Darshan's POSIX read/write
+ * instrumentation, which is dominated by mapping the file descriptor to
+ * its Darshan record.
+ *
+ * Opens <nfiles> files and issues <iters> 1-byte pread() calls round-robin
+ * across them, then reports the average time per call. Run once without
+ * Darshan and once with it preloaded (non-MPI mode) to get the per-call
+ * instrumentation overhead:
+ *
+ * gcc -O2 -o posix-fd-lookup-bench posix-fd-lookup-bench.c
+ * ./posix-fd-lookup-bench <dir> <nfiles> <iters>
+ * DARSHAN_ENABLE_NONMPI=1 LD_PRELOAD=libdarshan.so \
+ *     ./posix-fd-lookup-bench <dir> <nfiles> <iters>
+ */
+
+#define _XOPEN_SOURCE 500
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+
+static double wtime(void)
+{
+    struct timespec tp;
+
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return((double)tp.tv_sec + (double)tp.tv_nsec * 1e-9);
+}
+
+int main(int argc, char **argv)
+{
+    char path[4096];
+    char buf = 0;
+    int *fds;
+    int nfiles;
+    long iters;
+    long i;
+    double tm1, tm2;
+
+    if(argc != 4)
+    {
+        fprintf(stderr, "Usage: %s <dir> <nfiles> <iters>\n", argv[0]);
+        return(-1);
+    }
+    nfiles = atoi(argv[2]);
+    iters = atol(argv[3]);
+    if(nfiles < 1 || iters < 1)
+    {
+        fprintf(stderr, "Error: <nfiles> and <iters> must be positive.\n");
+        return(-1);
+    }
+
+    fds = malloc(nfiles * sizeof(*fds));
+    if(!fds)
+    {
+        perror("malloc");
+        return(-1);
+    }
+
+    for(i = 0; i < nfiles; i++)
+    {
+        snprintf(path, sizeof(path), "%s/fd-lookup-bench.%ld", argv[1], i);
+        fds[i] = open(path, O_CREAT|O_RDWR|O_TRUNC, 0644);
+        if(fds[i] < 0 || pwrite(fds[i], &buf, 1, 0) != 1)
+        {
+            perror(path);
+            return(-1);
+        }
+    }
+
+    tm1 = wtime();
+    for(i = 0; i < iters; i++)
+    {
+        if(pread(fds[i % nfiles], &buf, 1, 0) != 1)
+        {
+            perror("pread");
+            return(-1);
+        }
+    }
+    tm2 = wtime();
+
+    printf("# nfiles\titers\ttotal_s\tns_per_call\n");
+    printf("%d\t%ld\t%f\t%f\n", nfiles, iters, tm2 - tm1,
+        (tm2 - tm1) * 1e9 / (double)iters);
+
+    for(i = 0; i < nfiles; i++)
+    {
+        close(fds[i]);
+        snprintf(path, sizeof(path), "%s/fd-lookup-bench.%ld", argv[1], i);
+        unlink(path);
+    }
+    free(fds);
+
+    return(0);
+}
@@ -11,9 +11,12 @@ ENV_VAR_LIST="DARSHAN_LOGFILE,DARSHAN_DEFAULT_NPROCS,DARSHAN_SCRIPT_ARGS"
 if [ -n "${DXT_ENABLE_IO_TRACE+defined}" ]; then
 	ENV_VAR_LIST="$ENV_VAR_LIST,DXT_ENABLE_IO_TRACE"
 fi
+if [ -n "${DARSHAN_DISABLE+defined}" ]; then
+	ENV_VAR_LIST="$ENV_VAR_LIST,DARSHAN_DISABLE"
+fi
 
 # submit job and wait for it to return
-jobid=`qsub -A $PROJ -q debug -l select=1,walltime=0:10:00,filesystems=home:grand:eagle -v $ENV_VAR_LIST -o $DARSHAN_TMP/$$-tmp.out -e $DARSHAN_TMP/$$-tmp.err $DARSHAN_TESTDIR/$DARSHAN_PLATFORM/pbs-submit.sh`
+jobid=`qsub -A $PROJ -q debug -l select=1,walltime=0:10:00,filesystems=home:grand:eagle -v $ENV_VAR_LIST -o ${DARSHAN_RUNJOB_OUTPUT:-$DARSHAN_TMP/$$-tmp.out} -e $DARSHAN_TMP/$$-tmp.err $DARSHAN_TESTDIR/$DARSHAN_PLATFORM/pbs-submit.sh`
 
 if [ $? -ne 0 ]; then
         echo "Error: failed to qsub $@"
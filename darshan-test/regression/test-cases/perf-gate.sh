@@ -0,0 +1,183 @@
+#!/bin/bash
+
+# Performance gate: runs a fixed set of overhead workloads with and without
+# Darshan, and fails if Darshan's overhead or shutdown time grew by more
+# than a given percentage over the baseline stored for this platform
+# profile.  The first run on a platform profile stores the baseline.
+#
+# The workloads are the wrapper microbenchmark (darshan-wrapper-bench.c),
+# stdio-benchmark.c and mpi-io-test.c.  Runs "without Darshan" set
+# DARSHAN_DISABLE=1, so that the same executables can be compared on
+# platforms that link Darshan in at compile time.  For each workload, the
+# overhead is the ratio of the median time (or time per call) with Darshan
+# to the median time without it, and the shutdown time is the median
+# OVERHEAD_F_SHUTDOWN_TIME of its Darshan logs.
+#
+# Optional settings:
+#   DARSHAN_PERF_GATE=0             skip this test
+#   DARSHAN_PERF_THRESHOLD=<pct>    allowed growth over the baseline
+#                                   (default 25)
+#   DARSHAN_PERF_REPS=<n>           runs of each workload per configuration
+#                                   (default 5)
+#   DARSHAN_PERF_BASELINE_DIR=<dir> directory holding one baseline per
+#                                   platform profile
+#                                   (default $HOME/.darshan-perf-baselines)
+#   DARSHAN_PERF_UPDATE_BASELINE=1  store this run's results as the
+#                                   baseline, whether or not it passed
+
+if [ "$DARSHAN_PERF_GATE" = "0" ]; then
+    echo "Skipping performance gate (DARSHAN_PERF_GATE=0)"
+    exit 0
+fi
+
+THRESHOLD=${DARSHAN_PERF_THRESHOLD:-25}
+REPS=${DARSHAN_PERF_REPS:-5}
+BASELINE_DIR=${DARSHAN_PERF_BASELINE_DIR:-$HOME/.darshan-perf-baselines}
+BASELINE=$BASELINE_DIR/$DARSHAN_PLATFORM.txt
+PERF_DIR=$DARSHAN_TMP/perf-gate
+RESULTS=$PERF_DIR/results.txt
+# shutdown time growth below this many seconds is ignored as timer noise
+SHUTDOWN_NOISE=0.01
+
+rm -rf $PERF_DIR
+mkdir -p $PERF_DIR
+if [ $? -ne 0 ]; then
+    echo "Error: failed to create $PERF_DIR" 1>&2
+    exit 1
+fi
+
+# compile
+$DARSHAN_CC -O2 -DHAVE_MPI $DARSHAN_TESTDIR/../darshan-wrapper-bench.c \
+    -o $PERF_DIR/darshan-wrapper-bench -lpthread
+if [ $? -ne 0 ]; then
+    echo "Error: failed to compile darshan-wrapper-bench" 1>&2
+    exit 1
+fi
+for PROG in stdio-benchmark mpi-io-test; do
+    $DARSHAN_CC -O2 $DARSHAN_TESTDIR/test-cases/src/${PROG}.c -o $PERF_DIR/${PROG}
+    if [ $? -ne 0 ]; then
+        echo "Error: failed to compile ${PROG}" 1>&2
+        exit 1
+    fi
+done
+
+# run_workload <config> <rep> <name> <command...>
+#
+# runs one job of workload <name>, with Darshan disabled if <config> is
+# "none", leaving its output in $PERF_DIR/<name>.<config>.<rep>.out and its
+# Darshan log in $PERF_DIR/<name>.<rep>.darshan
+run_workload()
+{
+    config=$1
+    rep=$2
+    name=$3
+    shift 3
+    out=$PERF_DIR/$name.$config.$rep.out
+
+    export DARSHAN_LOGFILE=$PERF_DIR/$name.$rep.darshan
+    rm -f $DARSHAN_LOGFILE
+    if [ "$config" = "none" ]; then
+        export DARSHAN_DISABLE=1
+    fi
+    # batch platforms write the job's output to DARSHAN_RUNJOB_OUTPUT
+    DARSHAN_RUNJOB_OUTPUT=$out.job $DARSHAN_RUNJOB "$@" > $out 2>&1
+    rc=$?
+    unset DARSHAN_DISABLE
+    if [ -f $out.job ]; then
+        cat $out.job >> $out
+    fi
+    if [ $rc -ne 0 ]; then
+        echo "Error: failed to execute $name ($config)" 1>&2
+        cat $out 1>&2
+        exit 1
+    fi
+
+    # one "<metric> <value>" line per measurement
+    case $name in
+        wrapper)
+            awk -F, 'NF == 6 && $5 ~ /^[0-9.]+$/ {
+                print "wrapper_" $2, $5 }' $out ;;
+        stdio)
+            awk '/\(\)s of size/ {
+                op = $2; sub(/\(\)s$/, "", op); print "stdio_" op, $8 }' $out ;;
+        mpiio)
+            awk -F'[=,]' '/^# Write:/ { print "mpiio_write", $4 + 0 }
+                /^# Read:/ { print "mpiio_read", $4 + 0 }' $out ;;
+    esac > $out.metrics
+    if [ "$config" = "darshan" ]; then
+        $DARSHAN_UTIL_PATH/bin/darshan-parser $DARSHAN_LOGFILE | \
+            awk -v n=$name '$4 == "OVERHEAD_F_SHUTDOWN_TIME" &&
+                $6 == "overhead:core" { print n "_shutdown_s", $5 }' \
+            >> $out.metrics
+    fi
+    if [ ! -s $out.metrics ]; then
+        echo "Error: no timing found in the output of $name ($config)" 1>&2
+        cat $out 1>&2
+        exit 1
+    fi
+}
+
+# alternate the configurations so that both see the same system noise
+for rep in `seq 1 $REPS`; do
+    for config in none darshan; do
+        run_workload $config $rep wrapper $PERF_DIR/darshan-wrapper-bench \
+            -d $PERF_DIR -t 1 -o read,pwrite,open,stat,fwrite,MPI_File_write_at -H
+        run_workload $config $rep stdio $PERF_DIR/stdio-benchmark \
+            $PERF_DIR/stdio-benchmark.tmp.dat 100000 64
+        run_workload $config $rep mpiio $PERF_DIR/mpi-io-test \
+            -f $PERF_DIR/mpi-io-test.tmp.dat -b 4096 -i 4096
+    done
+done
+
+# medians of each metric, then the overhead ratio of each timing metric
+for config in none darshan; do
+    cat $PERF_DIR/*.$config.*.out.metrics | sort -k1,1 -k2,2g | \
+        awk '{ v[$1, ++n[$1]] = $2 }
+            END { for (m in n) {
+                c = n[m]
+                if (c % 2) med = v[m, (c + 1) / 2]
+                else med = (v[m, c / 2] + v[m, c / 2 + 1]) / 2
+                print m, med } }' > $PERF_DIR/median.$config.txt
+done
+awk 'NR == FNR { none[$1] = $2; next }
+    $1 ~ /_shutdown_s$/ { printf("%s %f\n", $1, $2); next }
+    ($1 in none) && none[$1] > 0 { printf("%s %f\n", $1 "_overhead", $2 / none[$1]) }' \
+    $PERF_DIR/median.none.txt $PERF_DIR/median.darshan.txt | sort > $RESULTS
+
+# compare against the baseline for this platform profile
+status=0
+if [ -f $BASELINE ]; then
+    echo "Comparing against $BASELINE (threshold ${THRESHOLD}%):"
+    awk -v t=$THRESHOLD -v noise=$SHUTDOWN_NOISE '
+        NR == FNR { base[$1] = $2; next }
+        !($1 in base) { printf("  %-40s %12f (new)\n", $1, $2); next }
+        {
+            limit = base[$1] * (1 + t / 100)
+            bad = ($2 > limit)
+            if ($1 ~ /_shutdown_s$/ && $2 - base[$1] < noise)
+                bad = 0
+            printf("  %-40s %12f baseline %12f%s\n", $1, $2, base[$1],
+                bad ? "  REGRESSION" : "")
+            if (bad) failed = 1
+        }
+        END { exit failed }' $BASELINE $RESULTS
+    status=$?
+else
+    echo "No baseline for $DARSHAN_PLATFORM; storing this run in $BASELINE:"
+    sed 's/^/  /' $RESULTS
+fi
+
+if [ ! -f $BASELINE -o "$DARSHAN_PERF_UPDATE_BASELINE" = "1" ]; then
+    mkdir -p $BASELINE_DIR && cp $RESULTS $BASELINE
+    if [ $? -ne 0 ]; then
+        echo "Error: failed to store baseline $BASELINE" 1>&2
+        exit 1
+    fi
+fi
+
+if [ $status -ne 0 ]; then
+    echo "Error: Darshan overhead or shutdown time grew by more than ${THRESHOLD}% over the baseline" 1>&2
+    exit 1
+fi
+
+exit 0
@@ -14,6 +14,9 @@
  * libc buffering and/or kernel buffering); this benchmark is therefore a
  * good measure of wrapper overhead that might otherwise be difficult to
  * observe in relation to I/O operation cost.
+ *
+ * If run with more than one rank, each rank appends its rank to the file
+ * name and only rank 0 reports its timing.
  */
 
 #include <stdio.h>
@@ -30,6 +33,7 @@ int main(int argc, char* argv[])
     int           access_size;
     int           ret;
     char*         buffer;
+    char          filename[4096];
     char          format[64] = "";
     double        t1, t2;
 
@@ -60,12 +64,12 @@ int main(int argc, char* argv[])
     MPI_Comm_size(MPI_COMM_WORLD, &npes);
     MPI_Comm_rank(MPI_COMM_WORLD, &myrank);
 
-    if (npes != 1) {
-        fprintf(stderr, "Error: one rank only please.\n");
-        return (-1);
-    }
+    if (npes == 1)
+        snprintf(filename, sizeof(filename), "%s", argv[1]);
+    else
+        snprintf(filename, sizeof(filename), "%s.%d", argv[1], myrank);
 
-    FILE* fp = fopen(argv[1], "w+");
+    FILE* fp = fopen(filename, "w+");
     if (!fp) {
         perror("fopen");
         return (-1);
@@ -81,8 +85,9 @@ int main(int argc, char* argv[])
         assert(ret == access_size);
     }
     t2 = MPI_Wtime();
-    printf("%lu fprintf()s of size %d each in %f seconds (%f ops/s)\n", iters,
-           access_size, t2 - t1, ((double)iters) / (t2 - t1));
+    if (myrank == 0)
+        printf("%lu fprintf()s of size %d each in %f seconds (%f ops/s)\n",
+               iters, access_size, t2 - t1, ((double)iters) / (t2 - t1));
 
     rewind(fp);
 
@@ -93,8 +98,9 @@ int main(int argc, char* argv[])
         assert(ret == 1);
     }
     t2 = MPI_Wtime();
-    printf("%lu fscanf()s of size %d each in %f seconds (%f ops/s)\n", iters,
-           access_size, t2 - t1, ((double)iters) / (t2 - t1));
+    if (myrank == 0)
+        printf("%lu fscanf()s of size %d each in %f seconds (%f ops/s)\n",
+               iters, access_size, t2 - t1, ((double)iters) / (t2 - t1));
 
     rewind(fp);
 
@@ -104,11 +110,12 @@ int main(int argc, char* argv[])
         assert(ret == access_size);
     }
     t2 = MPI_Wtime();
-    printf("%lu fread()s of size %d each in %f seconds (%f ops/s)\n", iters,
-           access_size, t2 - t1, ((double)iters) / (t2 - t1));
+    if (myrank == 0)
+        printf("%lu fread()s of size %d each in %f seconds (%f ops/s)\n",
+               iters, access_size, t2 - t1, ((double)iters) / (t2 - t1));
 
     fclose(fp);
-    unlink(argv[1]);
+    unlink(filename);
 
     MPI_Finalize();
 
@@ -14,6 +14,11 @@
 #include <assert.h>
 #include <ftw.h>
 #include <zlib.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "uthash-1.9.2/src/uthash.h"
 
 #include "darshan-logutils.h"
 
@@ -21,19 +26,66 @@
 #define BUCKET2 0.40
 #define BUCKET3 0.60
 #define BUCKET4 0.80
+#define NBUCKETS 5
+
+/* number of log paths queued per worker thread */
+#define QUEUE_DEPTH_PER_THREAD 64
+
+/* summary of a single log; this is also what the checkpoint file stores */
+struct log_summary
+{
+    int used_mpio;
+    int used_pnet;
+    int used_hdf5;
+    int used_shared;
+    int used_fpp;
+    int bucket; /* -1 if the I/O ratio does not fall in any bucket */
+};
+
+/* totals over a set of logs; each worker thread reduces into its own copy */
+struct analyzer_totals
+{
+    int count;
+    int shared;
+    int fpp;
+    int mpio;
+    int pnet;
+    int hdf5;
+    int buckets[NBUCKETS];
+};
+
+/* log already summarized in the checkpoint file of an earlier run */
+struct checkpoint_ref
+{
+    char *path;
+    struct log_summary summary;
+    UT_hash_handle hlink;
+};
 
-int total_shared = 0;
-int total_fpp    = 0;
-int total_mpio   = 0;
-int total_pnet   = 0;
-int total_hdf5   = 0;
-int total_count  = 0;
+struct analyzer_thread
+{
+    pthread_t tid;
+    struct analyzer_totals totals;
+};
 
-int bucket1 = 0;
-int bucket2 = 0;
-int bucket3 = 0;
-int bucket4 = 0;
-int bucket5 = 0;
+/* state shared by the directory walk (which has no way to pass an
+ * argument to its callback) and the worker threads
+ */
+static struct
+{
+    char **queue;
+    int queue_sz;
+    int queue_head;
+    int queue_cnt;
+    int walk_done;
+    pthread_mutex_t mutex;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    struct checkpoint_ref *ckpt_hash;
+    struct analyzer_totals ckpt_totals;
+    FILE *ckpt_fp;
+    pthread_mutex_t ckpt_mutex;
+} analyzer;
 
 int process_log(const char *fname, double *io_ratio, int *used_mpio, int *used_pnet, int *used_hdf5, int *used_shared, int *used_fpp)
 {
@@ -113,55 +165,353 @@ int process_log(const char *fname, double *io_ratio, int *used_mpio, int *used_p
     return 0;
 }
 
+static int io_ratio_bucket(double io_ratio)
+{
+    if (io_ratio <= BUCKET1)
+        return 0;
+    else if ((io_ratio > BUCKET1) && (io_ratio <= BUCKET2))
+        return 1;
+    else if ((io_ratio > BUCKET2) && (io_ratio <= BUCKET3))
+        return 2;
+    else if ((io_ratio > BUCKET3) && (io_ratio <= BUCKET4))
+        return 3;
+    else if (io_ratio > BUCKET4)
+        return 4;
+
+    return -1;
+}
+
+static void add_summary(struct analyzer_totals *totals, struct log_summary *summary)
+{
+    totals->count++;
+
+    if (summary->used_mpio > 0) totals->mpio++;
+    if (summary->used_pnet > 0) totals->pnet++;
+    if (summary->used_hdf5 > 0) totals->hdf5++;
+    if (summary->used_shared > 0) totals->shared++;
+    if (summary->used_fpp > 0) totals->fpp++;
+
+    if (summary->bucket >= 0)
+        totals->buckets[summary->bucket]++;
+
+    return;
+}
+
+static void add_totals(struct analyzer_totals *totals, struct analyzer_totals *partial)
+{
+    int i;
+
+    totals->count  += partial->count;
+    totals->shared += partial->shared;
+    totals->fpp    += partial->fpp;
+    totals->mpio   += partial->mpio;
+    totals->pnet   += partial->pnet;
+    totals->hdf5   += partial->hdf5;
+    for (i = 0; i < NBUCKETS; i++)
+        totals->buckets[i] += partial->buckets[i];
+
+    return;
+}
+
+/* read the summaries of logs processed by an earlier, interrupted run;
+ * a truncated last line is discarded, and that log is processed again
+ */
+static int load_checkpoint(const char *ckpt_path)
+{
+    FILE *fp;
+    char *line = NULL;
+    size_t line_sz = 0;
+    ssize_t len;
+    off_t valid_len = 0;
+    struct checkpoint_ref *ref;
+    struct log_summary summary;
+    int off;
+
+    fp = fopen(ckpt_path, "r");
+    if (fp == NULL)
+        return 0; /* nothing to resume */
+
+    while ((len = getline(&line, &line_sz, fp)) > 0)
+    {
+        if (line[len-1] != '\n')
+            break;
+        valid_len += len;
+        line[len-1] = '\0';
+
+        if (sscanf(line, "%d %d %d %d %d %d %n", &summary.used_mpio,
+            &summary.used_pnet, &summary.used_hdf5, &summary.used_shared,
+            &summary.used_fpp, &summary.bucket, &off) != 6 ||
+            summary.bucket < -1 || summary.bucket >= NBUCKETS)
+        {
+            fprintf(stderr, "Error: invalid line in checkpoint file %s.\n", ckpt_path);
+            free(line);
+            fclose(fp);
+            return -1;
+        }
+
+        HASH_FIND(hlink, analyzer.ckpt_hash, &line[off], strlen(&line[off]), ref);
+        if (ref)
+            continue;
+
+        ref = malloc(sizeof(*ref));
+        if (ref)
+            ref->path = strdup(&line[off]);
+        if (!ref || !ref->path)
+        {
+            fprintf(stderr, "Error: unable to allocate checkpoint data.\n");
+            free(ref);
+            free(line);
+            fclose(fp);
+            return -1;
+        }
+        ref->summary = summary;
+        HASH_ADD_KEYPTR(hlink, analyzer.ckpt_hash, ref->path, strlen(ref->path), ref);
+    }
+
+    free(line);
+    fclose(fp);
+
+    if (len > 0 && truncate(ckpt_path, valid_len) < 0)
+    {
+        fprintf(stderr, "Error: unable to truncate checkpoint file %s.\n", ckpt_path);
+        return -1;
+    }
+
+    return 0;
+}
+
+static void *analyzer_thread_fn(void *arg)
+{
+    struct analyzer_thread *thread = arg;
+    struct log_summary summary;
+    double io_ratio;
+    char *fpath;
+
+    while (1)
+    {
+        pthread_mutex_lock(&analyzer.mutex);
+        while (analyzer.queue_cnt == 0 && !analyzer.walk_done)
+            pthread_cond_wait(&analyzer.not_empty, &analyzer.mutex);
+        if (analyzer.queue_cnt == 0)
+        {
+            pthread_mutex_unlock(&analyzer.mutex);
+            break;
+        }
+        fpath = analyzer.queue[analyzer.queue_head];
+        analyzer.queue_head = (analyzer.queue_head + 1) % analyzer.queue_sz;
+        analyzer.queue_cnt--;
+        pthread_cond_signal(&analyzer.not_full);
+        pthread_mutex_unlock(&analyzer.mutex);
+
+        memset(&summary, 0, sizeof(summary));
+        io_ratio = 0.0;
+        process_log(fpath, &io_ratio, &summary.used_mpio, &summary.used_pnet,
+            &summary.used_hdf5, &summary.used_shared, &summary.used_fpp);
+        summary.bucket = io_ratio_bucket(io_ratio);
+
+        add_summary(&thread->totals, &summary);
+
+        if (analyzer.ckpt_fp)
+        {
+            pthread_mutex_lock(&analyzer.ckpt_mutex);
+            fprintf(analyzer.ckpt_fp, "%d %d %d %d %d %d %s\n",
+                summary.used_mpio, summary.used_pnet, summary.used_hdf5,
+                summary.used_shared, summary.used_fpp, summary.bucket, fpath);
+            fflush(analyzer.ckpt_fp);
+            pthread_mutex_unlock(&analyzer.ckpt_mutex);
+        }
+
+        free(fpath);
+    }
+
+    return NULL;
+}
+
 int tree_walk (const char *fpath, const struct stat *sb, int typeflag)
 {
-    double io_ratio = 0.0;
-    int used_mpio = 0;
-    int used_pnet = 0;
-    int used_hdf5 = 0;
-    int used_shared = 0;
-    int used_fpp = 0;
+    struct checkpoint_ref *ref;
+    char *path;
+    int tail;
 
     if (typeflag != FTW_F) return 0;
 
-    process_log(fpath,&io_ratio,&used_mpio,&used_pnet,&used_hdf5,&used_shared,&used_fpp);
-
-    total_count++;
+    /* logs summarized by an earlier run are not opened again */
+    HASH_FIND(hlink, analyzer.ckpt_hash, fpath, strlen(fpath), ref);
+    if (ref)
+    {
+        add_summary(&analyzer.ckpt_totals, &ref->summary);
+        return 0;
+    }
 
-    if (used_mpio > 0) total_mpio++;
-    if (used_pnet > 0) total_pnet++;
-    if (used_hdf5 > 0) total_hdf5++;
-    if (used_shared > 0) total_shared++;
-    if (used_fpp > 0) total_fpp++;
+    path = strdup(fpath);
+    if (path == NULL)
+    {
+        fprintf(stderr, "Error: unable to allocate log path.\n");
+        return -1;
+    }
 
-    if (io_ratio <= BUCKET1)
-        bucket1++;
-    else if ((io_ratio > BUCKET1) && (io_ratio <= BUCKET2))
-        bucket2++;
-    else if ((io_ratio > BUCKET2) && (io_ratio <= BUCKET3))
-        bucket3++;
-    else if ((io_ratio > BUCKET3) && (io_ratio <= BUCKET4))
-        bucket4++;
-    else if (io_ratio > BUCKET4)
-        bucket5++;
+    /* hand the log to the worker threads */
+    pthread_mutex_lock(&analyzer.mutex);
+    while (analyzer.queue_cnt == analyzer.queue_sz)
+        pthread_cond_wait(&analyzer.not_full, &analyzer.mutex);
+    tail = (analyzer.queue_head + analyzer.queue_cnt) % analyzer.queue_sz;
+    analyzer.queue[tail] = path;
+    analyzer.queue_cnt++;
+    pthread_cond_signal(&analyzer.not_empty);
+    pthread_mutex_unlock(&analyzer.mutex);
 
     return 0;
 }
 
+void usage(char *exename)
+{
+    fprintf(stderr, "Usage: %s [options] <log_dir>\n", exename);
+    fprintf(stderr, "This utility summarizes the access methods used by all Darshan log files under <log_dir>.\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "\t--threads\tNumber of threads processing logs (default: number of cores).\n");
+    fprintf(stderr, "\t--checkpoint\tFile recording each processed log; if it exists, logs recorded in it are not processed again.\n");
+
+    exit(1);
+}
+
+void parse_args(int argc, char **argv, char **base, int *nthreads, char **ckpt_path)
+{
+    int index;
+    char *check;
+    static struct option long_opts[] =
+    {
+        {"threads", required_argument, NULL, 't'},
+        {"checkpoint", required_argument, NULL, 'c'},
+        {"help", no_argument, NULL, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    *nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+    *ckpt_path = NULL;
+
+    while(1)
+    {
+        int c = getopt_long(argc, argv, "", long_opts, &index);
+
+        if(c == -1) break;
+
+        switch(c)
+        {
+            case 't':
+                *nthreads = strtol(optarg, &check, 10);
+                if(optarg == check || *nthreads < 1)
+                {
+                    fprintf(stderr, "Error: invalid number of threads.\n");
+                    exit(1);
+                }
+                break;
+            case 'c':
+                *ckpt_path = optarg;
+                break;
+            case 'h':
+            case '?':
+            default:
+                usage(argv[0]);
+                break;
+        }
+    }
+
+    if(optind + 1 != argc)
+    {
+        fprintf(stderr, "Error: directory of Darshan logs required as argument.\n");
+        usage(argv[0]);
+    }
+    if(*nthreads < 1)
+        *nthreads = 1;
+
+    *base = argv[optind];
+
+    return;
+}
+
 int main(int argc, char **argv)
 {
     char * base = NULL;
+    char *ckpt_path;
+    int nthreads;
+    struct analyzer_thread *threads;
+    struct analyzer_totals totals;
+    struct checkpoint_ref *ref, *tmp;
     int ret = 0;
+    int i;
+
+    parse_args(argc, argv, &base, &nthreads, &ckpt_path);
 
-    if(argc != 2)
+    if (ckpt_path)
     {
-        fprintf(stderr, "Error: directory of Darshan logs required as argument.\n");
+        if (load_checkpoint(ckpt_path) < 0)
+            return(-1);
+        analyzer.ckpt_fp = fopen(ckpt_path, "a");
+        if (analyzer.ckpt_fp == NULL)
+        {
+            fprintf(stderr, "Error: unable to open checkpoint file %s.\n", ckpt_path);
+            return(-1);
+        }
+    }
+
+    /* the directory walk feeds log paths to worker threads that each
+     * reduce their logs into their own totals
+     */
+    analyzer.queue_sz = nthreads * QUEUE_DEPTH_PER_THREAD;
+    analyzer.queue = malloc(analyzer.queue_sz * sizeof(*analyzer.queue));
+    threads = calloc(nthreads, sizeof(*threads));
+    if (!analyzer.queue || !threads)
+    {
+        fprintf(stderr, "Error: unable to allocate work queue.\n");
         return(-1);
     }
+    pthread_mutex_init(&analyzer.mutex, NULL);
+    pthread_cond_init(&analyzer.not_empty, NULL);
+    pthread_cond_init(&analyzer.not_full, NULL);
+    pthread_mutex_init(&analyzer.ckpt_mutex, NULL);
 
-    base = argv[1];
+    for (i = 0; i < nthreads; i++)
+    {
+        if (pthread_create(&threads[i].tid, NULL, analyzer_thread_fn, &threads[i]) != 0)
+            break;
+    }
+    nthreads = i;
+    if (nthreads == 0)
+    {
+        fprintf(stderr, "Error: unable to create worker threads.\n");
+        return(-1);
+    }
 
     ret = ftw(base, tree_walk, 512);
+
+    pthread_mutex_lock(&analyzer.mutex);
+    analyzer.walk_done = 1;
+    pthread_cond_broadcast(&analyzer.not_empty);
+    pthread_mutex_unlock(&analyzer.mutex);
+
+    /* merge the per-thread totals */
+    totals = analyzer.ckpt_totals;
+    for (i = 0; i < nthreads; i++)
+    {
+        pthread_join(threads[i].tid, NULL);
+        add_totals(&totals, &threads[i].totals);
+    }
+
+    free(threads);
+    free(analyzer.queue);
+    pthread_mutex_destroy(&analyzer.mutex);
+    pthread_cond_destroy(&analyzer.not_empty);
+    pthread_cond_destroy(&analyzer.not_full);
+    pthread_mutex_destroy(&analyzer.ckpt_mutex);
+    if (analyzer.ckpt_fp)
+        fclose(analyzer.ckpt_fp);
+    HASH_ITER(hlink, analyzer.ckpt_hash, ref, tmp)
+    {
+        HASH_DELETE(hlink, analyzer.ckpt_hash, ref);
+        free(ref->path);
+        free(ref);
+    }
+
     if(ret != 0)
     {
         fprintf(stderr, "Error: failed to walk path: %s\n", base);
@@ -169,18 +519,18 @@ int main(int argc, char **argv)
     }
 
     printf ("log dir: %s\n", base);
-    printf ("total logs: %d\n", total_count);
-    printf ("      shared file access: %lf [%d]\n", (double)total_shared/(double)total_count, total_shared);
-    printf ("file-per-proccess access: %lf [%d]\n", (double)total_fpp/(double)total_count, total_fpp);
-    printf ("             mpio access: %lf [%d]\n", (double)total_mpio/(double)total_count, total_mpio);
-    printf ("          pnetcdf access: %lf [%d]\n", (double)total_pnet/(double)total_count, total_pnet);
-    printf ("             hdf5 access: %lf [%d]\n", (double)total_hdf5/(double)total_count, total_hdf5);
+    printf ("total logs: %d\n", totals.count);
+    printf ("      shared file access: %lf [%d]\n", (double)totals.shared/(double)totals.count, totals.shared);
+    printf ("file-per-proccess access: %lf [%d]\n", (double)totals.fpp/(double)totals.count, totals.fpp);
+    printf ("             mpio access: %lf [%d]\n", (double)totals.mpio/(double)totals.count, totals.mpio);
+    printf ("          pnetcdf access: %lf [%d]\n", (double)totals.pnet/(double)totals.count, totals.pnet);
+    printf ("             hdf5 access: %lf [%d]\n", (double)totals.hdf5/(double)totals.count, totals.hdf5);
     printf("\nI/O percentage of runtime:\n");
-    printf ("%.2lf-%.2lf: %d\n", (double)0.0,     (double)BUCKET1, bucket1);
-    printf ("%.2lf-%.2lf: %d\n", (double)BUCKET1, (double)BUCKET2, bucket2);
-    printf ("%.2lf-%.2lf: %d\n", (double)BUCKET2, (double)BUCKET3, bucket3);
-    printf ("%.2lf-%.2lf: %d\n", (double)BUCKET3, (double)BUCKET4, bucket4);
-    printf ("%.2lf-%.2lf: %d\n", (double)BUCKET4, (double)1.0,   bucket5);
+    printf ("%.2lf-%.2lf: %d\n", (double)0.0,     (double)BUCKET1, totals.buckets[0]);
+    printf ("%.2lf-%.2lf: %d\n", (double)BUCKET1, (double)BUCKET2, totals.buckets[1]);
+    printf ("%.2lf-%.2lf: %d\n", (double)BUCKET2, (double)BUCKET3, totals.buckets[2]);
+    printf ("%.2lf-%.2lf: %d\n", (double)BUCKET3, (double)BUCKET4, totals.buckets[3]);
+    printf ("%.2lf-%.2lf: %d\n", (double)BUCKET4, (double)1.0,   totals.buckets[4]);
     return 0;
 }
 
@@ -0,0 +1,1072 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+/* This file implements the archive index API (darshan_index*) functions
+ * in darshan-archive-index.h.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "darshan-util-config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "uthash-1.9.2/src/uthash.h"
+
+#include "darshan-archive-index.h"
+
+#define DARSHAN_INDEX_VERSION 1
+
+/* index metadata file; the committed size of each table */
+struct darshan_index_meta
+{
+    int64_t magic_nr;
+    int64_t version;
+    uint64_t njobs;
+    uint64_t nmnts;
+    uint64_t nmods;
+    uint64_t strings_len;
+    uint64_t nsegs;
+};
+
+/* a name segment starts with this header, followed by 'count' entries
+ * sorted by name and then by job, followed by the null-terminated names
+ * the entries refer to, each stored once
+ */
+struct darshan_index_seg_header
+{
+    int64_t magic_nr;
+    uint64_t count;
+    uint64_t names_len;
+};
+
+struct darshan_index_seg_entry
+{
+    uint64_t name_off;
+    uint64_t job;
+};
+
+struct darshan_index_seg
+{
+    struct darshan_index_seg_entry *entries;
+    uint64_t count;
+    char *names;
+};
+
+/* string of the string table, for storing each distinct string once */
+struct darshan_index_string_ref
+{
+    uint64_t off;
+    int is_log;
+    UT_hash_handle hlink;
+    char str[1];
+};
+
+/* distinct record name of the logs added since the last commit */
+struct darshan_index_name_ref
+{
+    UT_hash_handle hlink;
+    char name[1];
+};
+
+/* record name of a job added since the last commit */
+struct darshan_index_posting
+{
+    struct darshan_index_name_ref *name_ref;
+    uint64_t job;
+};
+
+struct darshan_index_st
+{
+    char *path;
+    int mode;
+    struct darshan_index_meta meta;
+
+    /* tables, including entries added since the last commit */
+    struct darshan_index_job *jobs;
+    uint64_t njobs;
+    uint64_t jobs_max;
+    struct darshan_index_mnt *mnts;
+    uint64_t nmnts;
+    uint64_t mnts_max;
+    struct darshan_index_mod *mods;
+    uint64_t nmods;
+    uint64_t mods_max;
+    char *strings;
+    uint64_t strings_len;
+    uint64_t strings_max;
+
+    struct darshan_index_seg *segs;
+    uint64_t nsegs;
+
+    /* only used if the index is writable */
+    struct darshan_index_string_ref *string_hash;
+    struct darshan_index_name_ref *name_hash;
+    struct darshan_index_posting *postings;
+    uint64_t npostings;
+    uint64_t postings_max;
+};
+
+static int darshan_index_grow(void **buf, uint64_t *max, uint64_t need,
+    size_t elem_sz)
+{
+    uint64_t new_max;
+    void *tmp;
+
+    if(need <= *max)
+        return(0);
+
+    new_max = *max ? *max : 64;
+    while(new_max < need)
+        new_max *= 2;
+    tmp = realloc(*buf, new_max * elem_sz);
+    if(!tmp)
+        return(-1);
+    *buf = tmp;
+    *max = new_max;
+
+    return(0);
+}
+
+static char *darshan_index_file_path(darshan_index idx, const char *name)
+{
+    char *file_path;
+
+    file_path = malloc(strlen(idx->path) + strlen(name) + 2);
+    if(file_path)
+        sprintf(file_path, "%s/%s", idx->path, name);
+
+    return(file_path);
+}
+
+/* read the first 'len' bytes of index file 'name' into a new buffer */
+static int darshan_index_read_file(darshan_index idx, const char *name,
+    uint64_t len, void **buf)
+{
+    char *file_path;
+    ssize_t ret;
+    uint64_t done = 0;
+    int fd;
+
+    *buf = NULL;
+    if(len == 0)
+        return(0);
+
+    file_path = darshan_index_file_path(idx, name);
+    if(!file_path)
+        return(-1);
+    fd = open(file_path, O_RDONLY);
+    if(fd < 0)
+    {
+        fprintf(stderr, "Error: unable to open index file %s: %s.\n",
+            file_path, strerror(errno));
+        free(file_path);
+        return(-1);
+    }
+
+    *buf = malloc(len);
+    while(*buf && done < len)
+    {
+        ret = read(fd, (char *)*buf + done, len - done);
+        if(ret < 0 && errno == EINTR)
+            continue;
+        if(ret <= 0)
+            break;
+        done += ret;
+    }
+    close(fd);
+    if(done < len)
+    {
+        fprintf(stderr, "Error: index file %s is truncated.\n", file_path);
+        free(*buf);
+        *buf = NULL;
+        free(file_path);
+        return(-1);
+    }
+    free(file_path);
+
+    return(0);
+}
+
+/* write 'len' bytes to index file 'name' at offset 'off', discarding
+ * anything past it left by an interrupted commit
+ */
+static int darshan_index_write_file(darshan_index idx, const char *name,
+    uint64_t off, void *buf, uint64_t len)
+{
+    char *file_path;
+    ssize_t ret;
+    uint64_t done = 0;
+    int fd;
+
+    file_path = darshan_index_file_path(idx, name);
+    if(!file_path)
+        return(-1);
+    fd = open(file_path, O_WRONLY|O_CREAT, 0644);
+    if(fd < 0 || ftruncate(fd, off) < 0)
+    {
+        fprintf(stderr, "Error: unable to write index file %s: %s.\n",
+            file_path, strerror(errno));
+        if(fd >= 0)
+            close(fd);
+        free(file_path);
+        return(-1);
+    }
+
+    while(done < len)
+    {
+        ret = pwrite(fd, (char *)buf + done, len - done, off + done);
+        if(ret < 0 && errno == EINTR)
+            continue;
+        if(ret <= 0)
+            break;
+        done += ret;
+    }
+    if(done < len || fsync(fd) < 0)
+    {
+        fprintf(stderr, "Error: unable to write index file %s: %s.\n",
+            file_path, strerror(errno));
+        close(fd);
+        free(file_path);
+        return(-1);
+    }
+    close(fd);
+    free(file_path);
+
+    return(0);
+}
+
+static int darshan_index_load_seg(darshan_index idx, uint64_t seg_idx)
+{
+    struct darshan_index_seg_header hdr;
+    struct darshan_index_seg *seg = &idx->segs[seg_idx];
+    char seg_name[64];
+    void *buf;
+    void *hdr_buf;
+
+    sprintf(seg_name, "names.%" PRIu64, seg_idx);
+    if(darshan_index_read_file(idx, seg_name, sizeof(hdr), &hdr_buf) < 0)
+        return(-1);
+    memcpy(&hdr, hdr_buf, sizeof(hdr));
+    free(hdr_buf);
+    if(hdr.magic_nr != DARSHAN_INDEX_MAGIC_NR)
+    {
+        fprintf(stderr, "Error: invalid index name segment %s.\n", seg_name);
+        return(-1);
+    }
+
+    if(darshan_index_read_file(idx, seg_name, sizeof(hdr) +
+        hdr.count * sizeof(*seg->entries) + hdr.names_len, &buf) < 0)
+        return(-1);
+    seg->entries = (struct darshan_index_seg_entry *)((char *)buf + sizeof(hdr));
+    seg->count = hdr.count;
+    seg->names = (char *)&seg->entries[hdr.count];
+
+    return(0);
+}
+
+static struct darshan_index_string_ref *darshan_index_find_string(
+    darshan_index idx, const char *str)
+{
+    struct darshan_index_string_ref *ref;
+
+    HASH_FIND(hlink, idx->string_hash, str, strlen(str), ref);
+
+    return(ref);
+}
+
+/* return the offset of 'str' in the string table, adding it if needed */
+static int darshan_index_intern_string(darshan_index idx, const char *str,
+    uint64_t *off)
+{
+    struct darshan_index_string_ref *ref;
+    size_t len = strlen(str);
+
+    ref = darshan_index_find_string(idx, str);
+    if(ref)
+    {
+        *off = ref->off;
+        return(0);
+    }
+
+    if(darshan_index_grow((void **)&idx->strings, &idx->strings_max,
+        idx->strings_len + len + 1, 1) < 0)
+        return(-1);
+    ref = malloc(sizeof(*ref) + len);
+    if(!ref)
+        return(-1);
+    ref->off = idx->strings_len;
+    ref->is_log = 0;
+    strcpy(ref->str, str);
+    HASH_ADD_KEYPTR(hlink, idx->string_hash, ref->str, len, ref);
+
+    memcpy(&idx->strings[idx->strings_len], str, len + 1);
+    idx->strings_len += len + 1;
+    *off = ref->off;
+
+    return(0);
+}
+
+static int darshan_index_add_posting(darshan_index idx, const char *name,
+    uint64_t job)
+{
+    struct darshan_index_name_ref *ref;
+    size_t len = strlen(name);
+
+    HASH_FIND(hlink, idx->name_hash, name, len, ref);
+    if(!ref)
+    {
+        ref = malloc(sizeof(*ref) + len);
+        if(!ref)
+            return(-1);
+        strcpy(ref->name, name);
+        HASH_ADD_KEYPTR(hlink, idx->name_hash, ref->name, len, ref);
+    }
+
+    if(darshan_index_grow((void **)&idx->postings, &idx->postings_max,
+        idx->npostings + 1, sizeof(*idx->postings)) < 0)
+        return(-1);
+    idx->postings[idx->npostings].name_ref = ref;
+    idx->postings[idx->npostings].job = job;
+    idx->npostings++;
+
+    return(0);
+}
+
+static void darshan_index_free_pending(darshan_index idx)
+{
+    struct darshan_index_name_ref *ref, *tmp;
+
+    HASH_ITER(hlink, idx->name_hash, ref, tmp)
+    {
+        HASH_DELETE(hlink, idx->name_hash, ref);
+        free(ref);
+    }
+    free(idx->postings);
+    idx->postings = NULL;
+    idx->npostings = 0;
+    idx->postings_max = 0;
+
+    return;
+}
+
+darshan_index darshan_index_open(const char *path, int mode)
+{
+    darshan_index idx;
+    void *buf;
+    uint64_t off;
+    uint64_t i;
+    int ret;
+
+    idx = calloc(1, sizeof(*idx));
+    if(!idx)
+        return(NULL);
+    idx->mode = mode;
+    idx->path = strdup(path);
+    if(!idx->path)
+    {
+        free(idx);
+        return(NULL);
+    }
+
+    if(mode == DARSHAN_INDEX_WRITE && mkdir(path, 0755) < 0 && errno != EEXIST)
+    {
+        fprintf(stderr, "Error: unable to create index directory %s: %s.\n",
+            path, strerror(errno));
+        darshan_index_close(idx);
+        return(NULL);
+    }
+
+    /* a writable index without metadata is a new index */
+    if(mode == DARSHAN_INDEX_WRITE)
+    {
+        char *meta_path = darshan_index_file_path(idx, "meta");
+        if(!meta_path)
+        {
+            darshan_index_close(idx);
+            return(NULL);
+        }
+        ret = access(meta_path, F_OK);
+        free(meta_path);
+        if(ret < 0)
+        {
+            idx->meta.magic_nr = DARSHAN_INDEX_MAGIC_NR;
+            idx->meta.version = DARSHAN_INDEX_VERSION;
+            return(idx);
+        }
+    }
+
+    if(darshan_index_read_file(idx, "meta", sizeof(idx->meta), &buf) < 0)
+    {
+        darshan_index_close(idx);
+        return(NULL);
+    }
+    memcpy(&idx->meta, buf, sizeof(idx->meta));
+    free(buf);
+    if(idx->meta.magic_nr != DARSHAN_INDEX_MAGIC_NR ||
+       idx->meta.version != DARSHAN_INDEX_VERSION)
+    {
+        fprintf(stderr, "Error: %s is not a supported Darshan log index.\n", path);
+        darshan_index_close(idx);
+        return(NULL);
+    }
+
+    /* read the committed part of each table */
+    if(darshan_index_read_file(idx, "jobs",
+        idx->meta.njobs * sizeof(*idx->jobs), (void **)&idx->jobs) < 0 ||
+       darshan_index_read_file(idx, "mounts",
+        idx->meta.nmnts * sizeof(*idx->mnts), (void **)&idx->mnts) < 0 ||
+       darshan_index_read_file(idx, "mods",
+        idx->meta.nmods * sizeof(*idx->mods), (void **)&idx->mods) < 0 ||
+       darshan_index_read_file(idx, "strings",
+        idx->meta.strings_len, (void **)&idx->strings) < 0)
+    {
+        darshan_index_close(idx);
+        return(NULL);
+    }
+    idx->njobs = idx->jobs_max = idx->meta.njobs;
+    idx->nmnts = idx->mnts_max = idx->meta.nmnts;
+    idx->nmods = idx->mods_max = idx->meta.nmods;
+    idx->strings_len = idx->strings_max = idx->meta.strings_len;
+
+    idx->segs = calloc(idx->meta.nsegs + 1, sizeof(*idx->segs));
+    if(!idx->segs)
+    {
+        darshan_index_close(idx);
+        return(NULL);
+    }
+    for(i = 0; i < idx->meta.nsegs; i++)
+    {
+        if(darshan_index_load_seg(idx, i) < 0)
+        {
+            darshan_index_close(idx);
+            return(NULL);
+        }
+        idx->nsegs++;
+    }
+
+    /* hash the existing strings, so new logs reuse them and logs that
+     * are already indexed are not added again
+     */
+    if(mode == DARSHAN_INDEX_WRITE)
+    {
+        struct darshan_index_string_ref *ref;
+
+        for(off = 0; off < idx->strings_len; off += strlen(&idx->strings[off]) + 1)
+        {
+            size_t len = strlen(&idx->strings[off]);
+
+            ref = malloc(sizeof(*ref) + len);
+            if(!ref)
+            {
+                darshan_index_close(idx);
+                return(NULL);
+            }
+            ref->off = off;
+            ref->is_log = 0;
+            strcpy(ref->str, &idx->strings[off]);
+            HASH_ADD_KEYPTR(hlink, idx->string_hash, ref->str, len, ref);
+        }
+        for(i = 0; i < idx->njobs; i++)
+        {
+            ref = darshan_index_find_string(idx,
+                &idx->strings[idx->jobs[i].log_path_off]);
+            if(ref)
+                ref->is_log = 1;
+        }
+    }
+
+    return(idx);
+}
+
+int darshan_index_add_log(darshan_index idx, const char *log_path)
+{
+    char full_path[PATH_MAX];
+    darshan_fd fd;
+    struct darshan_job job;
+    char exe[DARSHAN_EXE_LEN+1] = {0};
+    struct darshan_mnt_info *mnt_array = NULL;
+    int mnt_count = 0;
+    char *mnt_used = NULL;
+    struct darshan_name_table *name_table = NULL;
+    struct darshan_index_mod mods[DARSHAN_KNOWN_MODULE_COUNT];
+    int nmods = 0;
+    struct darshan_index_job *ijob;
+    struct darshan_index_string_ref *ref;
+    darshan_accumulator acc;
+    struct darshan_derived_metrics metrics;
+    char *rec_buf = NULL;
+    char *agg_buf = NULL;
+    uint64_t job_idx;
+    int64_t i;
+    int j;
+    int ret;
+
+    if(idx->mode != DARSHAN_INDEX_WRITE)
+        return(-1);
+
+    if(!realpath(log_path, full_path))
+    {
+        fprintf(stderr, "Error: unable to resolve path of log file %s: %s.\n",
+            log_path, strerror(errno));
+        return(-1);
+    }
+    ref = darshan_index_find_string(idx, full_path);
+    if(ref && ref->is_log)
+        return(0);
+
+    fd = darshan_log_open(full_path);
+    if(!fd)
+        return(-1);
+
+    rec_buf = malloc(DEF_MOD_BUF_SIZE);
+    agg_buf = malloc(DEF_MOD_BUF_SIZE);
+    if(!rec_buf || !agg_buf ||
+       darshan_log_get_job(fd, &job) < 0 ||
+       darshan_log_get_exe(fd, exe) < 0 ||
+       darshan_log_get_mounts(fd, &mnt_array, &mnt_count) < 0 ||
+       darshan_log_get_name_table(fd, &name_table) < 0)
+    {
+        fprintf(stderr, "Error: unable to read log file %s.\n", full_path);
+        ret = -1;
+        goto out;
+    }
+
+    /* derive per-module totals for modules the accumulator API supports */
+    for(j = 0; j < DARSHAN_KNOWN_MODULE_COUNT; j++)
+    {
+        void *rec_p = rec_buf;
+
+        if(fd->mod_map[j].len == 0 || !mod_logutils[j])
+            continue;
+        if(darshan_accumulator_create(j, job.nprocs, &acc) < 0)
+            continue;
+
+        while((ret = mod_logutils[j]->log_get_record(fd, &rec_p)) == 1)
+        {
+            if(darshan_accumulator_inject(acc, rec_buf, 1) < 0)
+            {
+                ret = -1;
+                break;
+            }
+        }
+        if(ret == 0)
+            ret = darshan_accumulator_emit(acc, &metrics, agg_buf);
+        darshan_accumulator_destroy(acc);
+        if(ret < 0)
+        {
+            fprintf(stderr, "Error: unable to read %s module records of log file %s.\n",
+                darshan_module_names[j], full_path);
+            goto out;
+        }
+
+        mods[nmods].mod_id = j;
+        mods[nmods].files = metrics.category_counters[DARSHAN_ALL_FILES].count;
+        mods[nmods].bytes_read =
+            metrics.category_counters[DARSHAN_ALL_FILES].total_read_volume_bytes;
+        mods[nmods].bytes_written =
+            metrics.category_counters[DARSHAN_ALL_FILES].total_write_volume_bytes;
+        mods[nmods].agg_perf_by_slowest = metrics.agg_perf_by_slowest;
+        mods[nmods].agg_time_by_slowest = metrics.agg_time_by_slowest;
+        nmods++;
+    }
+
+    /* find the mount points the records resolve to; mounts are sorted by
+     * decreasing length, so the first prefix match is the right one
+     */
+    mnt_used = calloc(mnt_count + 1, 1);
+    if(!mnt_used)
+    {
+        ret = -1;
+        goto out;
+    }
+    for(i = 0; i < name_table->count; i++)
+    {
+        char *name = &name_table->names[name_table->entries[i].name_off];
+
+        for(j = 0; j < mnt_count; j++)
+        {
+            if(strncmp(mnt_array[j].mnt_path, name,
+                strlen(mnt_array[j].mnt_path)) == 0)
+            {
+                mnt_used[j] = 1;
+                break;
+            }
+        }
+    }
+
+    /* everything was read, so add the log to the tables */
+    job_idx = idx->njobs;
+    if(darshan_index_grow((void **)&idx->jobs, &idx->jobs_max,
+        idx->njobs + 1, sizeof(*idx->jobs)) < 0 ||
+       darshan_index_grow((void **)&idx->mnts, &idx->mnts_max,
+        idx->nmnts + mnt_count, sizeof(*idx->mnts)) < 0 ||
+       darshan_index_grow((void **)&idx->mods, &idx->mods_max,
+        idx->nmods + nmods, sizeof(*idx->mods)) < 0)
+    {
+        ret = -1;
+        goto out;
+    }
+    ijob = &idx->jobs[job_idx];
+    memset(ijob, 0, sizeof(*ijob));
+    ijob->uid = job.uid;
+    ijob->jobid = job.jobid;
+    ijob->nprocs = job.nprocs;
+    ijob->start_time_sec = job.start_time_sec;
+    ijob->end_time_sec = job.end_time_sec;
+    ijob->mnt_first = idx->nmnts;
+    ijob->mod_first = idx->nmods;
+    if(darshan_index_intern_string(idx, full_path, &ijob->log_path_off) < 0 ||
+       darshan_index_intern_string(idx, exe, &ijob->exe_off) < 0)
+    {
+        ret = -1;
+        goto out;
+    }
+    for(j = 0; j < mnt_count; j++)
+    {
+        struct darshan_index_mnt *mnt = &idx->mnts[idx->nmnts + ijob->mnt_count];
+
+        if(!mnt_used[j])
+            continue;
+        if(darshan_index_intern_string(idx, mnt_array[j].mnt_path, &mnt->mnt_path_off) < 0 ||
+           darshan_index_intern_string(idx, mnt_array[j].mnt_type, &mnt->mnt_type_off) < 0)
+        {
+            ret = -1;
+            goto out;
+        }
+        ijob->mnt_count++;
+    }
+    memcpy(&idx->mods[idx->nmods], mods, nmods * sizeof(*mods));
+    ijob->mod_count = nmods;
+    for(i = 0; i < name_table->count; i++)
+    {
+        if(darshan_index_add_posting(idx,
+            &name_table->names[name_table->entries[i].name_off], job_idx) < 0)
+        {
+            ret = -1;
+            goto out;
+        }
+    }
+    idx->nmnts += ijob->mnt_count;
+    idx->nmods += nmods;
+    idx->njobs++;
+    darshan_index_find_string(idx, full_path)->is_log = 1;
+    ret = 1;
+
+out:
+    if(ret < 0)
+    {
+        /* drop postings added for this log; strings added for it are
+         * harmless and reused later
+         */
+        while(idx->npostings > 0 &&
+            idx->postings[idx->npostings-1].job == idx->njobs)
+            idx->npostings--;
+    }
+    free(mnt_used);
+    free(mnt_array);
+    if(name_table)
+        darshan_name_table_free(name_table);
+    free(rec_buf);
+    free(agg_buf);
+    darshan_log_close(fd);
+
+    return(ret);
+}
+
+static int darshan_index_posting_cmp(const void *a, const void *b)
+{
+    const struct darshan_index_posting *p_a = a;
+    const struct darshan_index_posting *p_b = b;
+    int ret;
+
+    if(p_a->name_ref != p_b->name_ref)
+    {
+        ret = strcmp(p_a->name_ref->name, p_b->name_ref->name);
+        if(ret)
+            return(ret);
+    }
+    if(p_a->job < p_b->job)
+        return(-1);
+    else if(p_a->job > p_b->job)
+        return(1);
+
+    return(0);
+}
+
+/* write the postings of the logs added since the last commit as a new
+ * name segment
+ */
+static int darshan_index_write_seg(darshan_index idx)
+{
+    struct darshan_index_seg_header *hdr;
+    struct darshan_index_seg_entry *entries;
+    struct darshan_index_seg *segs;
+    char *names;
+    char seg_name[64];
+    char *buf;
+    uint64_t names_len = 0;
+    uint64_t buf_sz;
+    uint64_t i;
+    int ret;
+
+    qsort(idx->postings, idx->npostings, sizeof(*idx->postings),
+        darshan_index_posting_cmp);
+
+    for(i = 0; i < idx->npostings; i++)
+    {
+        if(i == 0 || idx->postings[i].name_ref != idx->postings[i-1].name_ref)
+            names_len += strlen(idx->postings[i].name_ref->name) + 1;
+    }
+
+    buf_sz = sizeof(*hdr) + idx->npostings * sizeof(*entries) + names_len;
+    buf = malloc(buf_sz);
+    segs = realloc(idx->segs, (idx->nsegs + 1) * sizeof(*idx->segs));
+    if(!buf || !segs)
+    {
+        free(buf);
+        return(-1);
+    }
+    idx->segs = segs;
+
+    hdr = (struct darshan_index_seg_header *)buf;
+    hdr->magic_nr = DARSHAN_INDEX_MAGIC_NR;
+    hdr->count = idx->npostings;
+    hdr->names_len = names_len;
+    entries = (struct darshan_index_seg_entry *)&hdr[1];
+    names = (char *)&entries[idx->npostings];
+    names_len = 0;
+    for(i = 0; i < idx->npostings; i++)
+    {
+        if(i == 0 || idx->postings[i].name_ref != idx->postings[i-1].name_ref)
+        {
+            strcpy(&names[names_len], idx->postings[i].name_ref->name);
+            entries[i].name_off = names_len;
+            names_len += strlen(idx->postings[i].name_ref->name) + 1;
+        }
+        else
+            entries[i].name_off = entries[i-1].name_off;
+        entries[i].job = idx->postings[i].job;
+    }
+
+    sprintf(seg_name, "names.%" PRIu64, idx->nsegs);
+    ret = darshan_index_write_file(idx, seg_name, 0, buf, buf_sz);
+    if(ret < 0)
+    {
+        free(buf);
+        return(-1);
+    }
+
+    idx->segs[idx->nsegs].entries = entries;
+    idx->segs[idx->nsegs].count = idx->npostings;
+    idx->segs[idx->nsegs].names = names;
+    idx->nsegs++;
+
+    return(0);
+}
+
+int darshan_index_commit(darshan_index idx)
+{
+    struct darshan_index_meta meta;
+    char *meta_path;
+    char *tmp_path;
+    int ret;
+
+    if(idx->mode != DARSHAN_INDEX_WRITE)
+        return(-1);
+    if(idx->njobs == idx->meta.njobs)
+        return(0);
+
+    /* append new table entries, then make them visible by replacing the
+     * metadata file
+     */
+    if(darshan_index_write_file(idx, "jobs", idx->meta.njobs * sizeof(*idx->jobs),
+        &idx->jobs[idx->meta.njobs],
+        (idx->njobs - idx->meta.njobs) * sizeof(*idx->jobs)) < 0 ||
+       darshan_index_write_file(idx, "mounts", idx->meta.nmnts * sizeof(*idx->mnts),
+        &idx->mnts[idx->meta.nmnts],
+        (idx->nmnts - idx->meta.nmnts) * sizeof(*idx->mnts)) < 0 ||
+       darshan_index_write_file(idx, "mods", idx->meta.nmods * sizeof(*idx->mods),
+        &idx->mods[idx->meta.nmods],
+        (idx->nmods - idx->meta.nmods) * sizeof(*idx->mods)) < 0 ||
+       darshan_index_write_file(idx, "strings", idx->meta.strings_len,
+        &idx->strings[idx->meta.strings_len],
+        idx->strings_len - idx->meta.strings_len) < 0 ||
+       darshan_index_write_seg(idx) < 0)
+        return(-1);
+
+    meta = idx->meta;
+    meta.njobs = idx->njobs;
+    meta.nmnts = idx->nmnts;
+    meta.nmods = idx->nmods;
+    meta.strings_len = idx->strings_len;
+    meta.nsegs = idx->nsegs;
+
+    meta_path = darshan_index_file_path(idx, "meta");
+    tmp_path = darshan_index_file_path(idx, "meta.tmp");
+    ret = -1;
+    if(meta_path && tmp_path &&
+       darshan_index_write_file(idx, "meta.tmp", 0, &meta, sizeof(meta)) == 0)
+    {
+        ret = rename(tmp_path, meta_path);
+        if(ret < 0)
+            fprintf(stderr, "Error: unable to update index metadata file %s: %s.\n",
+                meta_path, strerror(errno));
+    }
+    free(meta_path);
+    free(tmp_path);
+    if(ret < 0)
+    {
+        /* the new segment is not part of the index */
+        idx->nsegs--;
+        free((char *)idx->segs[idx->nsegs].entries -
+            sizeof(struct darshan_index_seg_header));
+        return(-1);
+    }
+
+    idx->meta = meta;
+    darshan_index_free_pending(idx);
+
+    return(0);
+}
+
+void darshan_index_close(darshan_index idx)
+{
+    struct darshan_index_string_ref *ref, *tmp;
+    uint64_t i;
+
+    if(!idx)
+        return;
+
+    darshan_index_free_pending(idx);
+    HASH_ITER(hlink, idx->string_hash, ref, tmp)
+    {
+        HASH_DELETE(hlink, idx->string_hash, ref);
+        free(ref);
+    }
+    for(i = 0; i < idx->nsegs; i++)
+        free((char *)idx->segs[i].entries - sizeof(struct darshan_index_seg_header));
+    free(idx->segs);
+    free(idx->jobs);
+    free(idx->mnts);
+    free(idx->mods);
+    free(idx->strings);
+    free(idx->path);
+    free(idx);
+
+    return;
+}
+
+int64_t darshan_index_job_count(darshan_index idx)
+{
+    return(idx->meta.njobs);
+}
+
+const struct darshan_index_job *darshan_index_get_job(darshan_index idx,
+    int64_t job_idx)
+{
+    if(job_idx < 0 || (uint64_t)job_idx >= idx->meta.njobs)
+        return(NULL);
+
+    return(&idx->jobs[job_idx]);
+}
+
+const struct darshan_index_mnt *darshan_index_get_mounts(darshan_index idx,
+    const struct darshan_index_job *job)
+{
+    return(&idx->mnts[job->mnt_first]);
+}
+
+const struct darshan_index_mod *darshan_index_get_mods(darshan_index idx,
+    const struct darshan_index_job *job)
+{
+    return(&idx->mods[job->mod_first]);
+}
+
+const char *darshan_index_get_string(darshan_index idx, uint64_t off)
+{
+    if(off >= idx->strings_len)
+        return(NULL);
+
+    return(&idx->strings[off]);
+}
+
+void darshan_index_query_init(struct darshan_index_query *query)
+{
+    memset(query, 0, sizeof(*query));
+    query->uid = -1;
+
+    return;
+}
+
+/* flag the jobs that have a record name starting with 'prefix' */
+static void darshan_index_match_prefix(darshan_index idx, const char *prefix,
+    unsigned char *job_flags)
+{
+    struct darshan_index_seg *seg;
+    size_t len = strlen(prefix);
+    uint64_t lo, hi, mid;
+    uint64_t i;
+
+    for(i = 0; i < idx->nsegs; i++)
+    {
+        seg = &idx->segs[i];
+
+        /* find the first entry not sorting before the prefix */
+        lo = 0;
+        hi = seg->count;
+        while(lo < hi)
+        {
+            mid = lo + (hi - lo) / 2;
+            if(strcmp(&seg->names[seg->entries[mid].name_off], prefix) < 0)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        for(; lo < seg->count; lo++)
+        {
+            if(strncmp(&seg->names[seg->entries[lo].name_off], prefix, len))
+                break;
+            if(seg->entries[lo].job < idx->meta.njobs)
+                job_flags[seg->entries[lo].job] = 1;
+        }
+    }
+
+    return;
+}
+
+static int darshan_index_match_thresholds(darshan_index idx,
+    const struct darshan_index_job *job, struct darshan_index_query *query)
+{
+    const struct darshan_index_mod *mods = darshan_index_get_mods(idx, job);
+    double val;
+    uint32_t m;
+    int i;
+
+    for(i = 0; i < query->threshold_count; i++)
+    {
+        struct darshan_index_threshold *thr = &query->thresholds[i];
+
+        for(m = 0; m < job->mod_count; m++)
+        {
+            if(mods[m].mod_id == thr->mod_id)
+                break;
+        }
+        if(m == job->mod_count)
+            return(0);
+
+        switch(thr->metric)
+        {
+            case DARSHAN_INDEX_FILES:
+                val = mods[m].files;
+                break;
+            case DARSHAN_INDEX_BYTES_READ:
+                val = mods[m].bytes_read;
+                break;
+            case DARSHAN_INDEX_BYTES_WRITTEN:
+                val = mods[m].bytes_written;
+                break;
+            case DARSHAN_INDEX_TOTAL_BYTES:
+                val = (double)mods[m].bytes_read + mods[m].bytes_written;
+                break;
+            case DARSHAN_INDEX_AGG_PERF:
+                val = mods[m].agg_perf_by_slowest;
+                break;
+            case DARSHAN_INDEX_AGG_TIME:
+                val = mods[m].agg_time_by_slowest;
+                break;
+            default:
+                return(0);
+        }
+        if(!(val >= thr->min))
+            return(0);
+    }
+
+    return(1);
+}
+
+static int darshan_index_match_mounts(darshan_index idx,
+    const struct darshan_index_job *job, struct darshan_index_query *query)
+{
+    const struct darshan_index_mnt *mnts = darshan_index_get_mounts(idx, job);
+    uint32_t m;
+
+    for(m = 0; m < job->mnt_count; m++)
+    {
+        if(query->mnt_prefix && strncmp(&idx->strings[mnts[m].mnt_path_off],
+            query->mnt_prefix, strlen(query->mnt_prefix)))
+            continue;
+        if(query->mnt_type && strcmp(&idx->strings[mnts[m].mnt_type_off],
+            query->mnt_type))
+            continue;
+        return(1);
+    }
+
+    return(0);
+}
+
+int64_t darshan_index_query(darshan_index idx, struct darshan_index_query *query,
+    darshan_index_query_cb cb, void *arg)
+{
+    unsigned char *job_flags = NULL;
+    const struct darshan_index_job *job;
+    int64_t matches = 0;
+    uint64_t i;
+
+    if(query->path_prefix)
+    {
+        job_flags = calloc(idx->meta.njobs + 1, 1);
+        if(!job_flags)
+            return(-1);
+        darshan_index_match_prefix(idx, query->path_prefix, job_flags);
+    }
+
+    for(i = 0; i < idx->meta.njobs; i++)
+    {
+        job = &idx->jobs[i];
+
+        if(job_flags && !job_flags[i])
+            continue;
+        if(query->uid >= 0 && job->uid != query->uid)
+            continue;
+        if(query->start_time && job->end_time_sec < query->start_time)
+            continue;
+        if(query->end_time && job->start_time_sec > query->end_time)
+            continue;
+        if(query->exe && !strstr(&idx->strings[job->exe_off], query->exe))
+            continue;
+        if((query->mnt_prefix || query->mnt_type) &&
+           !darshan_index_match_mounts(idx, job, query))
+            continue;
+        if(!darshan_index_match_thresholds(idx, job, query))
+            continue;
+
+        matches++;
+        if(cb && cb(idx, job, arg))
+            break;
+    }
+    free(job_flags);
+
+    return(matches);
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
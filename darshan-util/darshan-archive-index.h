@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifndef __DARSHAN_ARCHIVE_INDEX_H
+#define __DARSHAN_ARCHIVE_INDEX_H
+
+#include <stdint.h>
+
+#include "darshan-logutils.h"
+
+/* The archive index API maintains a persistent index of a collection of
+ * Darshan logs, so that questions spanning many jobs (e.g., which jobs
+ * accessed a given file or file system, or wrote more than a given amount
+ * of data) can be answered without reading the logs again.
+ *
+ * An index is a directory holding a few append-only tables: a job table,
+ * a string table, the mount points each job's records resolved to, and
+ * per-module totals derived with the accumulator API. Record names are
+ * stored in name segments, each sorted by name, with one segment added per
+ * commit. A small metadata file lists the committed size of each table, so
+ * logs added after the last commit are discarded if the process adding
+ * them is interrupted. The index is stored in host byte order.
+ */
+
+#define DARSHAN_INDEX_MAGIC_NR 6567225
+
+/* opaque index reference */
+struct darshan_index_st;
+typedef struct darshan_index_st* darshan_index;
+
+/* job table entry; string fields are offsets into the string table */
+struct darshan_index_job
+{
+    uint64_t log_path_off;
+    uint64_t exe_off;
+    int64_t uid;
+    int64_t jobid;
+    int64_t nprocs;
+    int64_t start_time_sec;
+    int64_t end_time_sec;
+    /* entries of the mount table for mount points used by the job's
+     * records, and of the module table for the job's modules
+     */
+    uint64_t mnt_first;
+    uint64_t mod_first;
+    uint32_t mnt_count;
+    uint32_t mod_count;
+};
+
+/* mount table entry */
+struct darshan_index_mnt
+{
+    uint64_t mnt_path_off;
+    uint64_t mnt_type_off;
+};
+
+/* per-module totals of a job, for modules supported by the accumulator
+ * API; values are taken from the DARSHAN_ALL_FILES category
+ */
+struct darshan_index_mod
+{
+    int64_t mod_id;
+    int64_t files;
+    int64_t bytes_read;
+    int64_t bytes_written;
+    double agg_perf_by_slowest;
+    double agg_time_by_slowest;
+};
+
+/* module total that can be used in a query threshold */
+enum darshan_index_metric
+{
+    DARSHAN_INDEX_FILES,
+    DARSHAN_INDEX_BYTES_READ,
+    DARSHAN_INDEX_BYTES_WRITTEN,
+    DARSHAN_INDEX_TOTAL_BYTES,
+    DARSHAN_INDEX_AGG_PERF,
+    DARSHAN_INDEX_AGG_TIME,
+    DARSHAN_INDEX_METRIC_MAX
+};
+
+struct darshan_index_threshold
+{
+    darshan_module_id mod_id;
+    enum darshan_index_metric metric;
+    double min;
+};
+
+/* query criteria; a job matches if it satisfies all criteria that are set.
+ * String criteria are ignored if NULL, and uid if negative.
+ */
+struct darshan_index_query
+{
+    int64_t uid;
+    /* substring of the executable name and arguments */
+    const char *exe;
+    /* prefix of the name of a record of the job */
+    const char *path_prefix;
+    /* prefix of a mount point, or type of a file system, used by the job */
+    const char *mnt_prefix;
+    const char *mnt_type;
+    /* the job must have run at some point in [start_time, end_time];
+     * either bound is ignored if 0
+     */
+    int64_t start_time;
+    int64_t end_time;
+    struct darshan_index_threshold *thresholds;
+    int threshold_count;
+};
+
+/* callback invoked for each job matching a query; a non-zero return value
+ * stops the query
+ */
+typedef int (*darshan_index_query_cb)(darshan_index idx,
+    const struct darshan_index_job *job, void *arg);
+
+/* modes for opening an index */
+#define DARSHAN_INDEX_RDONLY 0
+#define DARSHAN_INDEX_WRITE  1 /* create the index if it does not exist */
+
+/* open the index stored in directory 'path' */
+darshan_index darshan_index_open(const char *path, int mode);
+/* add the log at 'log_path' to the index; returns 1 if the log was added,
+ * 0 if it was already indexed, and -1 on error
+ */
+int darshan_index_add_log(darshan_index idx, const char *log_path);
+/* make the logs added since the last commit part of the index */
+int darshan_index_commit(darshan_index idx);
+/* close the index, discarding logs added since the last commit */
+void darshan_index_close(darshan_index idx);
+
+int64_t darshan_index_job_count(darshan_index idx);
+const struct darshan_index_job *darshan_index_get_job(darshan_index idx,
+    int64_t job_idx);
+const struct darshan_index_mnt *darshan_index_get_mounts(darshan_index idx,
+    const struct darshan_index_job *job);
+const struct darshan_index_mod *darshan_index_get_mods(darshan_index idx,
+    const struct darshan_index_job *job);
+const char *darshan_index_get_string(darshan_index idx, uint64_t off);
+
+void darshan_index_query_init(struct darshan_index_query *query);
+/* run a query over the committed jobs of the index, in the order in
+ * which they were added; returns the number of matching jobs, or -1
+ * on error
+ */
+int64_t darshan_index_query(darshan_index idx, struct darshan_index_query *query,
+    darshan_index_query_cb cb, void *arg);
+
+#endif /* __DARSHAN_ARCHIVE_INDEX_H */
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
@@ -0,0 +1,761 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "darshan-util-config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "darshan-arrow.h"
+
+/* An Arrow IPC file is laid out as follows (see the Arrow columnar format
+ * specification):
+ *      - the magic string "ARROW1", padded to 8 bytes
+ *      - a Schema message
+ *      - one RecordBatch message per batch of rows
+ *      - an end-of-stream marker
+ *      - a Footer, which repeats the schema and locates each record batch
+ *      - the size of the footer and the magic string "ARROW1"
+ *
+ * Each message is a 0xFFFFFFFF continuation marker, the size of its
+ * metadata, the metadata as a FlatBuffers-encoded Message table, and the
+ * message body. The body of a record batch holds the buffers of each
+ * column, 8-byte aligned: a validity bitmap (always empty, as columns are
+ * never null), followed by the values for numeric columns, or by int32
+ * offsets and the character data for string columns.
+ *
+ * The few FlatBuffers tables needed are encoded with the minimal builder
+ * below rather than adding a dependency on the FlatBuffers library. Like
+ * the reference builder, it fills its buffer from the end toward the
+ * beginning, so that objects referenced by a table are already in place
+ * when the table is written, and offsets are tracked as distances from the
+ * end of the buffer. FlatBuffers data is always little-endian.
+ */
+
+#define ARROW_MAGIC "ARROW1"
+#define ARROW_CONTINUATION 0xFFFFFFFF
+
+/* Arrow schema enumerations (Schema.fbs and Message.fbs) */
+#define ARROW_METADATA_V5 4
+#define ARROW_HEADER_SCHEMA 1
+#define ARROW_HEADER_RECORD_BATCH 3
+#define ARROW_TYPE_INT 2
+#define ARROW_TYPE_FLOATING_POINT 3
+#define ARROW_TYPE_UTF8 5
+#define ARROW_PRECISION_DOUBLE 2
+#define ARROW_ENDIANNESS_LITTLE 0
+#define ARROW_ENDIANNESS_BIG 1
+
+#define FB_MAX_FIELDS 8
+
+struct fb_builder
+{
+    unsigned char *buf;
+    size_t cap;
+    size_t len;
+    int err;
+    /* fields of the table being built */
+    int nfields;
+    int field_id[FB_MAX_FIELDS];
+    size_t field_off[FB_MAX_FIELDS];
+    size_t table_start;
+};
+
+struct arrow_col_buf
+{
+    unsigned char *data;
+    size_t len;
+    size_t cap;
+    /* value offsets of string columns */
+    int32_t *offs;
+    size_t noffs;
+    size_t offs_cap;
+};
+
+struct arrow_block
+{
+    int64_t offset;
+    int32_t meta_len;
+    int64_t body_len;
+};
+
+struct darshan_arrow_writer_st
+{
+    FILE *fp;
+    int64_t pos;
+    int err;
+    int ncols;
+    struct darshan_arrow_column *cols;
+    int nmeta;
+    char **meta;
+    struct arrow_col_buf *bufs;
+    int64_t nrows;
+    struct arrow_block *blocks;
+    int nblocks;
+    int blocks_cap;
+};
+
+static void fb_le(unsigned char *p, uint64_t val, int size)
+{
+    int i;
+
+    for(i = 0; i < size; i++)
+        p[i] = (unsigned char)(val >> (8 * i));
+}
+
+/* prepend 'n' bytes to the buffer, returning a pointer to them */
+static unsigned char *fb_space(struct fb_builder *b, size_t n)
+{
+    unsigned char *tmp;
+    size_t new_cap;
+
+    if(b->err)
+        return(NULL);
+
+    if(b->cap - b->len < n)
+    {
+        new_cap = b->cap ? 2 * b->cap : 1024;
+        while(new_cap - b->len < n)
+            new_cap *= 2;
+        tmp = malloc(new_cap);
+        if(!tmp)
+        {
+            b->err = 1;
+            return(NULL);
+        }
+        memcpy(tmp + new_cap - b->len, b->buf + b->cap - b->len, b->len);
+        free(b->buf);
+        b->buf = tmp;
+        b->cap = new_cap;
+    }
+    b->len += n;
+
+    return(b->buf + b->cap - b->len);
+}
+
+static void fb_push(struct fb_builder *b, const void *data, size_t n)
+{
+    unsigned char *p = fb_space(b, n);
+
+    if(p)
+        memcpy(p, data, n);
+}
+
+/* pad the buffer so that it is aligned to 'align' once 'additional' more
+ * bytes are prepended
+ */
+static void fb_prep(struct fb_builder *b, size_t align, size_t additional)
+{
+    size_t pad = (align - ((b->len + additional) % align)) % align;
+    unsigned char *p = fb_space(b, pad);
+
+    if(p)
+        memset(p, 0, pad);
+}
+
+static size_t fb_scalar(struct fb_builder *b, uint64_t val, int size)
+{
+    unsigned char *p;
+
+    fb_prep(b, size, 0);
+    p = fb_space(b, size);
+    if(p)
+        fb_le(p, val, size);
+
+    return(b->len);
+}
+
+/* prepend an offset to the object at 'target' */
+static size_t fb_uoffset(struct fb_builder *b, size_t target)
+{
+    fb_prep(b, 4, 0);
+    return(fb_scalar(b, b->len + 4 - target, 4));
+}
+
+static size_t fb_string(struct fb_builder *b, const char *str)
+{
+    size_t n = strlen(str);
+
+    fb_prep(b, 4, n + 1);
+    fb_prep(b, 1, 0);
+    fb_push(b, "", 1);
+    fb_push(b, str, n);
+
+    return(fb_scalar(b, n, 4));
+}
+
+static size_t fb_vec_offsets(struct fb_builder *b, const size_t *targets, int n)
+{
+    int i;
+
+    fb_prep(b, 4, 4 * n);
+    for(i = n - 1; i >= 0; i--)
+        fb_uoffset(b, targets[i]);
+
+    return(fb_scalar(b, n, 4));
+}
+
+/* prepend a vector of 'n' structs of 8-byte aligned, already encoded data */
+static size_t fb_vec_structs(struct fb_builder *b, const unsigned char *data,
+    size_t size, int n)
+{
+    fb_prep(b, 4, size);
+    fb_prep(b, 8, size);
+    fb_push(b, data, size);
+
+    return(fb_scalar(b, n, 4));
+}
+
+static void fb_table_start(struct fb_builder *b)
+{
+    b->nfields = 0;
+    b->table_start = b->len;
+}
+
+static void fb_table_field(struct fb_builder *b, int id, size_t off)
+{
+    b->field_id[b->nfields] = id;
+    b->field_off[b->nfields] = off;
+    b->nfields++;
+}
+
+static void fb_table_scalar(struct fb_builder *b, int id, uint64_t val, int size)
+{
+    fb_table_field(b, id, fb_scalar(b, val, size));
+}
+
+static void fb_table_offset(struct fb_builder *b, int id, size_t target)
+{
+    fb_table_field(b, id, fb_uoffset(b, target));
+}
+
+static size_t fb_table_end(struct fb_builder *b)
+{
+    unsigned char vtable[4 + 2 * FB_MAX_FIELDS] = {0};
+    size_t table_off;
+    int nids = 0;
+    int i;
+
+    table_off = fb_scalar(b, 0, 4);
+    for(i = 0; i < b->nfields; i++)
+    {
+        if(b->field_id[i] + 1 > nids)
+            nids = b->field_id[i] + 1;
+        fb_le(vtable + 4 + 2 * b->field_id[i], table_off - b->field_off[i], 2);
+    }
+    fb_le(vtable, 4 + 2 * nids, 2);
+    fb_le(vtable + 2, table_off - b->table_start, 2);
+    fb_push(b, vtable, 4 + 2 * nids);
+
+    /* point the table at its vtable, which precedes it */
+    if(!b->err)
+        fb_le(b->buf + b->cap - table_off, b->len - table_off, 4);
+
+    return(table_off);
+}
+
+static void fb_finish(struct fb_builder *b, size_t root)
+{
+    fb_prep(b, 8, 4);
+    fb_uoffset(b, root);
+}
+
+static size_t arrow_build_schema(struct fb_builder *b, darshan_arrow_writer w)
+{
+    size_t *fields;
+    size_t *kvs;
+    size_t name, type, children, key, value;
+    size_t fields_vec, meta_vec = 0;
+    int type_type;
+    int i;
+
+    fields = malloc((w->ncols + w->nmeta) * sizeof(*fields));
+    if(!fields)
+    {
+        b->err = 1;
+        return(0);
+    }
+    kvs = fields + w->ncols;
+
+    for(i = 0; i < w->ncols; i++)
+    {
+        name = fb_string(b, w->cols[i].name);
+        fb_table_start(b);
+        switch(w->cols[i].type)
+        {
+            case DARSHAN_ARROW_INT64:
+            case DARSHAN_ARROW_UINT64:
+                fb_table_scalar(b, 0, 64, 4);
+                fb_table_scalar(b, 1, w->cols[i].type == DARSHAN_ARROW_INT64, 1);
+                type_type = ARROW_TYPE_INT;
+                break;
+            case DARSHAN_ARROW_DOUBLE:
+                fb_table_scalar(b, 0, ARROW_PRECISION_DOUBLE, 2);
+                type_type = ARROW_TYPE_FLOATING_POINT;
+                break;
+            case DARSHAN_ARROW_UTF8:
+            default:
+                type_type = ARROW_TYPE_UTF8;
+                break;
+        }
+        type = fb_table_end(b);
+        children = fb_vec_offsets(b, NULL, 0);
+
+        fb_table_start(b);
+        fb_table_offset(b, 0, name);
+        fb_table_scalar(b, 1, 0, 1);
+        fb_table_scalar(b, 2, type_type, 1);
+        fb_table_offset(b, 3, type);
+        fb_table_offset(b, 5, children);
+        fields[i] = fb_table_end(b);
+    }
+    fields_vec = fb_vec_offsets(b, fields, w->ncols);
+
+    if(w->nmeta)
+    {
+        for(i = 0; i < w->nmeta; i++)
+        {
+            key = fb_string(b, w->meta[2 * i]);
+            value = fb_string(b, w->meta[2 * i + 1]);
+            fb_table_start(b);
+            fb_table_offset(b, 0, key);
+            fb_table_offset(b, 1, value);
+            kvs[i] = fb_table_end(b);
+        }
+        meta_vec = fb_vec_offsets(b, kvs, w->nmeta);
+    }
+    free(fields);
+
+    fb_table_start(b);
+#ifdef WORDS_BIGENDIAN
+    fb_table_scalar(b, 0, ARROW_ENDIANNESS_BIG, 2);
+#else
+    fb_table_scalar(b, 0, ARROW_ENDIANNESS_LITTLE, 2);
+#endif
+    fb_table_offset(b, 1, fields_vec);
+    if(w->nmeta)
+        fb_table_offset(b, 2, meta_vec);
+
+    return(fb_table_end(b));
+}
+
+/* wrap the message header at 'header' in a Message table and finish */
+static void arrow_finish_message(struct fb_builder *b, int header_type,
+    size_t header, int64_t body_len)
+{
+    size_t msg;
+
+    fb_table_start(b);
+    fb_table_scalar(b, 3, body_len, 8);
+    fb_table_offset(b, 2, header);
+    fb_table_scalar(b, 0, ARROW_METADATA_V5, 2);
+    fb_table_scalar(b, 1, header_type, 1);
+    msg = fb_table_end(b);
+    fb_finish(b, msg);
+}
+
+static void arrow_write(darshan_arrow_writer w, const void *data, size_t n)
+{
+    if(n && fwrite(data, 1, n, w->fp) != n)
+        w->err = 1;
+    w->pos += n;
+}
+
+static void arrow_write_pad(darshan_arrow_writer w)
+{
+    static const char zeros[8] = {0};
+
+    arrow_write(w, zeros, (8 - (w->pos % 8)) % 8);
+}
+
+/* write an encapsulated message; the metadata is 8-byte aligned as built */
+static void arrow_write_message(darshan_arrow_writer w, struct fb_builder *b)
+{
+    unsigned char prefix[8];
+
+    fb_le(prefix, ARROW_CONTINUATION, 4);
+    fb_le(prefix + 4, b->len, 4);
+    arrow_write(w, prefix, 8);
+    arrow_write(w, b->buf + b->cap - b->len, b->len);
+}
+
+static void *arrow_grow(void *ptr, size_t *cap, size_t need, size_t elem,
+    int *err)
+{
+    void *tmp;
+    size_t new_cap;
+
+    if(need <= *cap)
+        return(ptr);
+    new_cap = *cap ? *cap : 64;
+    while(new_cap < need)
+        new_cap *= 2;
+    tmp = realloc(ptr, new_cap * elem);
+    if(!tmp)
+    {
+        *err = 1;
+        return(NULL);
+    }
+    *cap = new_cap;
+
+    return(tmp);
+}
+
+static void arrow_put(darshan_arrow_writer w, int col, const void *val,
+    size_t n)
+{
+    struct arrow_col_buf *cb = &w->bufs[col];
+    unsigned char *tmp;
+
+    if(cb->len + n > cb->cap)
+    {
+        tmp = arrow_grow(cb->data, &cb->cap, cb->len + n, 1, &w->err);
+        if(!tmp)
+            return;
+        cb->data = tmp;
+    }
+    memcpy(cb->data + cb->len, val, n);
+    cb->len += n;
+}
+
+static int arrow_flush_batch(darshan_arrow_writer w)
+{
+    struct fb_builder b;
+    struct arrow_block *blk;
+    struct arrow_col_buf *cb;
+    unsigned char *nodes, *bufs;
+    int64_t body_len = 0;
+    int64_t lens[3];
+    int nbufs = 0;
+    size_t nodes_vec, bufs_vec, batch;
+    int i, j, k;
+
+    if(w->nrows == 0 || w->err)
+        return(w->err ? -1 : 0);
+
+    for(i = 0; i < w->ncols; i++)
+    {
+        cb = &w->bufs[i];
+        if((w->cols[i].type == DARSHAN_ARROW_UTF8 && (int64_t)cb->noffs != w->nrows + 1) ||
+           (w->cols[i].type != DARSHAN_ARROW_UTF8 && (int64_t)cb->len != w->nrows * 8))
+        {
+            fprintf(stderr, "Error: missing values for Arrow column %s.\n",
+                w->cols[i].name);
+            w->err = 1;
+            return(-1);
+        }
+    }
+
+    nodes = malloc((size_t)w->ncols * 4 * 16);
+    if(!nodes)
+    {
+        w->err = 1;
+        return(-1);
+    }
+    bufs = nodes + w->ncols * 16;
+
+    /* describe the body: each column's validity bitmap (empty), then its
+     * offsets for string columns, then its values
+     */
+    for(i = 0; i < w->ncols; i++)
+    {
+        cb = &w->bufs[i];
+        fb_le(nodes + 16 * i, w->nrows, 8);
+        fb_le(nodes + 16 * i + 8, 0, 8);
+        k = 0;
+        lens[k++] = 0;
+        if(w->cols[i].type == DARSHAN_ARROW_UTF8)
+            lens[k++] = cb->noffs * sizeof(int32_t);
+        lens[k++] = cb->len;
+        for(j = 0; j < k; j++)
+        {
+            fb_le(bufs + 16 * nbufs, body_len, 8);
+            fb_le(bufs + 16 * nbufs + 8, lens[j], 8);
+            nbufs++;
+            body_len += (lens[j] + 7) & ~7;
+        }
+    }
+
+    memset(&b, 0, sizeof(b));
+    bufs_vec = fb_vec_structs(&b, bufs, 16 * nbufs, nbufs);
+    nodes_vec = fb_vec_structs(&b, nodes, 16 * w->ncols, w->ncols);
+    fb_table_start(&b);
+    fb_table_scalar(&b, 0, w->nrows, 8);
+    fb_table_offset(&b, 1, nodes_vec);
+    fb_table_offset(&b, 2, bufs_vec);
+    batch = fb_table_end(&b);
+    arrow_finish_message(&b, ARROW_HEADER_RECORD_BATCH, batch, body_len);
+    free(nodes);
+    if(b.err)
+    {
+        free(b.buf);
+        w->err = 1;
+        return(-1);
+    }
+
+    if(w->nblocks == w->blocks_cap)
+    {
+        size_t cap = w->blocks_cap;
+        blk = arrow_grow(w->blocks, &cap, cap + 1, sizeof(*blk), &w->err);
+        if(!blk)
+        {
+            free(b.buf);
+            return(-1);
+        }
+        w->blocks = blk;
+        w->blocks_cap = cap;
+    }
+    blk = &w->blocks[w->nblocks++];
+    blk->offset = w->pos;
+    blk->meta_len = 8 + b.len;
+    blk->body_len = body_len;
+
+    arrow_write_message(w, &b);
+    free(b.buf);
+    for(i = 0; i < w->ncols; i++)
+    {
+        cb = &w->bufs[i];
+        if(w->cols[i].type == DARSHAN_ARROW_UTF8)
+        {
+            arrow_write(w, cb->offs, cb->noffs * sizeof(int32_t));
+            arrow_write_pad(w);
+            cb->noffs = 1;
+        }
+        arrow_write(w, cb->data, cb->len);
+        arrow_write_pad(w);
+        cb->len = 0;
+    }
+    w->nrows = 0;
+
+    return(w->err ? -1 : 0);
+}
+
+darshan_arrow_writer darshan_arrow_create(const char *path,
+    const struct darshan_arrow_column *cols, int ncols,
+    const char * const *meta, int nmeta)
+{
+    darshan_arrow_writer w;
+    struct fb_builder b;
+    size_t schema;
+    int i;
+
+    w = calloc(1, sizeof(*w));
+    if(!w)
+        return(NULL);
+    w->ncols = ncols;
+    w->nmeta = nmeta;
+    w->cols = calloc(ncols, sizeof(*w->cols));
+    w->bufs = calloc(ncols, sizeof(*w->bufs));
+    w->meta = calloc(2 * nmeta + 1, sizeof(*w->meta));
+    if(!w->cols || !w->bufs || !w->meta)
+        w->err = 1;
+    for(i = 0; !w->err && i < ncols; i++)
+    {
+        w->cols[i].type = cols[i].type;
+        w->cols[i].name = strdup(cols[i].name);
+        if(!w->cols[i].name)
+            w->err = 1;
+        if(cols[i].type == DARSHAN_ARROW_UTF8)
+        {
+            w->bufs[i].offs = arrow_grow(NULL, &w->bufs[i].offs_cap, 1,
+                sizeof(int32_t), &w->err);
+            if(w->bufs[i].offs)
+            {
+                w->bufs[i].offs[0] = 0;
+                w->bufs[i].noffs = 1;
+            }
+        }
+    }
+    for(i = 0; !w->err && i < 2 * nmeta; i++)
+    {
+        w->meta[i] = strdup(meta[i]);
+        if(!w->meta[i])
+            w->err = 1;
+    }
+    if(w->err)
+    {
+        darshan_arrow_close(w);
+        return(NULL);
+    }
+
+    w->fp = fopen(path, "w");
+    if(!w->fp)
+    {
+        fprintf(stderr, "Error: unable to create Arrow file %s.\n", path);
+        darshan_arrow_close(w);
+        return(NULL);
+    }
+    arrow_write(w, ARROW_MAGIC "\0\0", 8);
+
+    memset(&b, 0, sizeof(b));
+    schema = arrow_build_schema(&b, w);
+    arrow_finish_message(&b, ARROW_HEADER_SCHEMA, schema, 0);
+    if(b.err)
+        w->err = 1;
+    else
+        arrow_write_message(w, &b);
+    free(b.buf);
+    if(w->err)
+    {
+        fprintf(stderr, "Error: unable to write Arrow file %s.\n", path);
+        darshan_arrow_close(w);
+        return(NULL);
+    }
+
+    return(w);
+}
+
+void darshan_arrow_put_int64(darshan_arrow_writer w, int col, int64_t val)
+{
+    arrow_put(w, col, &val, sizeof(val));
+}
+
+void darshan_arrow_put_uint64(darshan_arrow_writer w, int col, uint64_t val)
+{
+    arrow_put(w, col, &val, sizeof(val));
+}
+
+void darshan_arrow_put_double(darshan_arrow_writer w, int col, double val)
+{
+    arrow_put(w, col, &val, sizeof(val));
+}
+
+void darshan_arrow_put_utf8(darshan_arrow_writer w, int col, const char *val)
+{
+    struct arrow_col_buf *cb = &w->bufs[col];
+    size_t n = strlen(val);
+    int32_t *tmp;
+
+    if(cb->len + n > INT32_MAX)
+    {
+        w->err = 1;
+        return;
+    }
+    if(cb->noffs == cb->offs_cap)
+    {
+        tmp = arrow_grow(cb->offs, &cb->offs_cap, cb->noffs + 1,
+            sizeof(int32_t), &w->err);
+        if(!tmp)
+            return;
+        cb->offs = tmp;
+    }
+    arrow_put(w, col, val, n);
+    cb->offs[cb->noffs++] = cb->len;
+}
+
+void darshan_arrow_put_int64_array(darshan_arrow_writer w, int col,
+    const int64_t *vals, int count)
+{
+    int i;
+
+    for(i = 0; i < count; i++)
+        arrow_put(w, col + i, &vals[i], sizeof(*vals));
+}
+
+void darshan_arrow_put_double_array(darshan_arrow_writer w, int col,
+    const double *vals, int count)
+{
+    int i;
+
+    for(i = 0; i < count; i++)
+        arrow_put(w, col + i, &vals[i], sizeof(*vals));
+}
+
+int darshan_arrow_end_row(darshan_arrow_writer w)
+{
+    if(w->err)
+        return(-1);
+
+    w->nrows++;
+    if(w->nrows == DARSHAN_ARROW_BATCH_ROWS)
+        return(arrow_flush_batch(w));
+
+    return(0);
+}
+
+int darshan_arrow_close(darshan_arrow_writer w)
+{
+    struct fb_builder b;
+    unsigned char *blocks;
+    unsigned char trailer[4 + 6];
+    unsigned char eos[8];
+    size_t schema, blocks_vec, footer;
+    int ret;
+    int i;
+
+    if(w->fp)
+    {
+        arrow_flush_batch(w);
+
+        fb_le(eos, ARROW_CONTINUATION, 4);
+        fb_le(eos + 4, 0, 4);
+        arrow_write(w, eos, 8);
+
+        memset(&b, 0, sizeof(b));
+        blocks = calloc(w->nblocks + 1, 24);
+        if(!blocks)
+            b.err = 1;
+        for(i = 0; blocks && i < w->nblocks; i++)
+        {
+            fb_le(blocks + 24 * i, w->blocks[i].offset, 8);
+            fb_le(blocks + 24 * i + 8, w->blocks[i].meta_len, 4);
+            fb_le(blocks + 24 * i + 16, w->blocks[i].body_len, 8);
+        }
+        blocks_vec = fb_vec_structs(&b, blocks, 24 * w->nblocks, w->nblocks);
+        free(blocks);
+        schema = arrow_build_schema(&b, w);
+        fb_table_start(&b);
+        fb_table_offset(&b, 1, schema);
+        fb_table_offset(&b, 3, blocks_vec);
+        fb_table_scalar(&b, 0, ARROW_METADATA_V5, 2);
+        footer = fb_table_end(&b);
+        fb_finish(&b, footer);
+        if(b.err)
+            w->err = 1;
+        else
+        {
+            arrow_write(w, b.buf + b.cap - b.len, b.len);
+            fb_le(trailer, b.len, 4);
+            memcpy(trailer + 4, ARROW_MAGIC, 6);
+            arrow_write(w, trailer, sizeof(trailer));
+        }
+        free(b.buf);
+
+        if(fclose(w->fp) != 0)
+            w->err = 1;
+    }
+    ret = w->err ? -1 : 0;
+
+    for(i = 0; w->cols && i < w->ncols; i++)
+        free((char *)w->cols[i].name);
+    for(i = 0; w->bufs && i < w->ncols; i++)
+    {
+        free(w->bufs[i].data);
+        free(w->bufs[i].offs);
+    }
+    for(i = 0; w->meta && i < 2 * w->nmeta; i++)
+        free(w->meta[i]);
+    free(w->cols);
+    free(w->bufs);
+    free(w->meta);
+    free(w->blocks);
+    free(w);
+
+    return(ret);
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
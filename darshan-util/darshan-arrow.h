@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifndef __DARSHAN_ARROW_H
+#define __DARSHAN_ARROW_H
+
+#include <stdint.h>
+
+/* The Arrow writer API writes a table to a file in the Arrow IPC file
+ * format (also known as Feather version 2), which can be read directly by
+ * pyarrow, Spark, pandas, polars, DuckDB and other columnar tools.
+ *
+ * Rows are appended one value per column at a time, and are written to
+ * the file as record batches of DARSHAN_ARROW_BATCH_ROWS rows. Columns are
+ * never null. Numeric data is stored in host byte order, which is recorded
+ * in the schema.
+ */
+
+#define DARSHAN_ARROW_BATCH_ROWS 65536
+
+/* opaque writer reference */
+struct darshan_arrow_writer_st;
+typedef struct darshan_arrow_writer_st* darshan_arrow_writer;
+
+enum darshan_arrow_type
+{
+    DARSHAN_ARROW_INT64,
+    DARSHAN_ARROW_UINT64,
+    DARSHAN_ARROW_DOUBLE,
+    DARSHAN_ARROW_UTF8,
+};
+
+struct darshan_arrow_column
+{
+    const char *name;
+    enum darshan_arrow_type type;
+};
+
+/* create the file at 'path' holding a table with the given columns; the
+ * table is annotated with 'nmeta' key/value pairs stored in 'meta' as
+ * {key0, value0, key1, value1, ...}
+ */
+darshan_arrow_writer darshan_arrow_create(const char *path,
+    const struct darshan_arrow_column *cols, int ncols,
+    const char * const *meta, int nmeta);
+
+/* append a value to column 'col' of the current row */
+void darshan_arrow_put_int64(darshan_arrow_writer w, int col, int64_t val);
+void darshan_arrow_put_uint64(darshan_arrow_writer w, int col, uint64_t val);
+void darshan_arrow_put_double(darshan_arrow_writer w, int col, double val);
+void darshan_arrow_put_utf8(darshan_arrow_writer w, int col, const char *val);
+/* append one value to each of the 'count' columns starting at 'col' (e.g.,
+ * a record's counters)
+ */
+void darshan_arrow_put_int64_array(darshan_arrow_writer w, int col,
+    const int64_t *vals, int count);
+void darshan_arrow_put_double_array(darshan_arrow_writer w, int col,
+    const double *vals, int count);
+/* finish the current row; every column must have been given a value */
+int darshan_arrow_end_row(darshan_arrow_writer w);
+
+/* write any pending rows and the file footer, and close the file;
+ * returns 0 on success, -1 if any write or allocation failed
+ */
+int darshan_arrow_close(darshan_arrow_writer w);
+
+#endif /* __DARSHAN_ARROW_H */
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "darshan-util-config.h"
+#endif
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "darshan-logutils.h"
+
+/* integer counter name strings for the ATTRIB module */
+#define X(a) #a,
+char *attrib_counter_names[] = {
+    ATTRIB_COUNTERS
+};
+
+/* floating point counter name strings for the ATTRIB module */
+char *attrib_f_counter_names[] = {
+    ATTRIB_F_COUNTERS
+};
+#undef X
+
+/* prototypes for each of the ATTRIB module's logutil functions */
+static int darshan_log_get_attrib_record(darshan_fd fd, void** attrib_buf_p);
+static int darshan_log_put_attrib_record(darshan_fd fd, void* attrib_buf);
+static void darshan_log_print_attrib_record(void *file_rec,
+    char *file_name, char *mnt_pt, char *fs_type);
+static void darshan_log_print_attrib_description(int ver);
+static void darshan_log_print_attrib_record_diff(void *file_rec1, char *file_name1,
+    void *file_rec2, char *file_name2);
+static void darshan_log_agg_attrib_records(void *rec, void *agg_rec, int init_flag);
+
+/* structure storing each function needed for implementing the darshan
+ * logutil interface. these functions are used for reading, writing, and
+ * printing module data in a consistent manner.
+ */
+struct darshan_mod_logutil_funcs attrib_logutils =
+{
+    .log_get_record = &darshan_log_get_attrib_record,
+    .log_put_record = &darshan_log_put_attrib_record,
+    .log_print_record = &darshan_log_print_attrib_record,
+    .log_print_description = &darshan_log_print_attrib_description,
+    .log_print_diff = &darshan_log_print_attrib_record_diff,
+    .log_agg_records = &darshan_log_agg_attrib_records
+};
+
+/* retrieve a ATTRIB record from log file descriptor 'fd', storing the
+ * data in the buffer address pointed to by 'attrib_buf_p'. Return 1 on
+ * successful record read, 0 on no more data, and -1 on error.
+ */
+static int darshan_log_get_attrib_record(darshan_fd fd, void** attrib_buf_p)
+{
+    struct darshan_attrib_record *rec = *((struct darshan_attrib_record **)attrib_buf_p);
+    int ret;
+
+    if(fd->mod_map[DARSHAN_ATTRIB_MOD].len == 0)
+        return(0);
+
+    if(fd->mod_ver[DARSHAN_ATTRIB_MOD] == 0 ||
+        fd->mod_ver[DARSHAN_ATTRIB_MOD] > DARSHAN_ATTRIB_VER)
+    {
+        fprintf(stderr, "Error: Invalid ATTRIB module version number (got %d)\n",
+            fd->mod_ver[DARSHAN_ATTRIB_MOD]);
+        return(-1);
+    }
+
+    if(*attrib_buf_p == NULL)
+    {
+        rec = malloc(sizeof(*rec));
+        if(!rec)
+            return(-1);
+    }
+
+    /* read a ATTRIB module record from the darshan log file */
+    ret = darshan_log_get_mod(fd, DARSHAN_ATTRIB_MOD, rec,
+        sizeof(struct darshan_attrib_record));
+
+    if(*attrib_buf_p == NULL)
+    {
+        if(ret == sizeof(struct darshan_attrib_record))
+            *attrib_buf_p = rec;
+        else
+            free(rec);
+    }
+
+    if(ret < 0)
+        return(-1);
+    else if(ret < sizeof(struct darshan_attrib_record))
+        return(0);
+    else
+    {
+        /* if the read was successful, do any necessary byte-swapping */
+        if(fd->swap_flag)
+        {
+            /* records consist only of 64-bit fields */
+            darshan_log_bswap64_array(rec,
+                sizeof(struct darshan_attrib_record) / sizeof(int64_t));
+        }
+
+        return(1);
+    }
+}
+
+/* write the ATTRIB record stored in 'attrib_buf' to log file descriptor 'fd'.
+ * Return 0 on success, -1 on failure
+ */
+static int darshan_log_put_attrib_record(darshan_fd fd, void* attrib_buf)
+{
+    struct darshan_attrib_record *rec = (struct darshan_attrib_record *)attrib_buf;
+    int ret;
+
+    /* append ATTRIB record to darshan log file */
+    ret = darshan_log_put_mod(fd, DARSHAN_ATTRIB_MOD, rec,
+        sizeof(struct darshan_attrib_record), DARSHAN_ATTRIB_VER);
+    if(ret < 0)
+        return(-1);
+
+    return(0);
+}
+
+/* print all I/O data record statistics for the given ATTRIB record */
+static void darshan_log_print_attrib_record(void *file_rec, char *file_name,
+    char *mnt_pt, char *fs_type)
+{
+    int i;
+    struct darshan_attrib_record *attrib_rec =
+        (struct darshan_attrib_record *)file_rec;
+
+    /* print each of the integer and floating point counters for the ATTRIB module */
+    for(i=0; i<ATTRIB_NUM_INDICES; i++)
+    {
+        /* macro defined in darshan-logutils.h */
+        DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_ATTRIB_MOD],
+            attrib_rec->base_rec.rank, attrib_rec->base_rec.id,
+            attrib_counter_names[i], attrib_rec->counters[i],
+            file_name, mnt_pt, fs_type);
+    }
+
+    for(i=0; i<ATTRIB_F_NUM_INDICES; i++)
+    {
+        /* macro defined in darshan-logutils.h */
+        DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_ATTRIB_MOD],
+            attrib_rec->base_rec.rank, attrib_rec->base_rec.id,
+            attrib_f_counter_names[i], attrib_rec->fcounters[i],
+            file_name, mnt_pt, fs_type);
+    }
+
+    return;
+}
+
+/* print out a description of the ATTRIB module record fields */
+static void darshan_log_print_attrib_description(int ver)
+{
+    printf("\n# description of ATTRIB counters:\n");
+    printf("#   each record shares the id and name of an H5D, PNETCDF_VAR, or MPI-IO\n");
+    printf("#   record, and counts the lower-layer I/O issued by its read and write calls.\n");
+    printf("#   ATTRIB_UPPER_MODULE: module id of the upper-layer record.\n");
+    printf("#   ATTRIB_CALLS: number of upper-layer calls that issued lower-layer I/O.\n");
+    printf("#   ATTRIB_<LAYER>_READS, _WRITES, _META_OPS: MPI-IO and POSIX operations issued.\n");
+    printf("#   ATTRIB_<LAYER>_BYTES_READ, _BYTES_WRITTEN: bytes moved by those operations.\n");
+    printf("#   ATTRIB_F_<LAYER>_READ_TIME, _WRITE_TIME, _META_TIME: time spent in them.\n");
+
+    return;
+}
+
+/* print a diff of two ATTRIB records (with the same record id) */
+static void darshan_log_print_attrib_record_diff(void *file_rec1, char *file_name1,
+    void *file_rec2, char *file_name2)
+{
+    struct darshan_attrib_record *file1 = (struct darshan_attrib_record *)file_rec1;
+    struct darshan_attrib_record *file2 = (struct darshan_attrib_record *)file_rec2;
+    int i;
+
+    /* NOTE: we assume that both input records are the same module format version */
+
+    for(i=0; i<ATTRIB_NUM_INDICES; i++)
+    {
+        if(!file2)
+        {
+            printf("- ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_ATTRIB_MOD],
+                file1->base_rec.rank, file1->base_rec.id, attrib_counter_names[i],
+                file1->counters[i], file_name1, "", "");
+
+        }
+        else if(!file1)
+        {
+            printf("+ ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_ATTRIB_MOD],
+                file2->base_rec.rank, file2->base_rec.id, attrib_counter_names[i],
+                file2->counters[i], file_name2, "", "");
+        }
+        else if(file1->counters[i] != file2->counters[i])
+        {
+            printf("- ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_ATTRIB_MOD],
+                file1->base_rec.rank, file1->base_rec.id, attrib_counter_names[i],
+                file1->counters[i], file_name1, "", "");
+            printf("+ ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_ATTRIB_MOD],
+                file2->base_rec.rank, file2->base_rec.id, attrib_counter_names[i],
+                file2->counters[i], file_name2, "", "");
+        }
+    }
+
+    for(i=0; i<ATTRIB_F_NUM_INDICES; i++)
+    {
+        if(!file2)
+        {
+            printf("- ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_ATTRIB_MOD],
+                file1->base_rec.rank, file1->base_rec.id, attrib_f_counter_names[i],
+                file1->fcounters[i], file_name1, "", "");
+
+        }
+        else if(!file1)
+        {
+            printf("+ ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_ATTRIB_MOD],
+                file2->base_rec.rank, file2->base_rec.id, attrib_f_counter_names[i],
+                file2->fcounters[i], file_name2, "", "");
+        }
+        else if(file1->fcounters[i] != file2->fcounters[i])
+        {
+            printf("- ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_ATTRIB_MOD],
+                file1->base_rec.rank, file1->base_rec.id, attrib_f_counter_names[i],
+                file1->fcounters[i], file_name1, "", "");
+            printf("+ ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_ATTRIB_MOD],
+                file2->base_rec.rank, file2->base_rec.id, attrib_f_counter_names[i],
+                file2->fcounters[i], file_name2, "", "");
+        }
+    }
+
+    return;
+}
+
+/* aggregate the input ATTRIB record 'rec'  into the output record 'agg_rec' */
+static void darshan_log_agg_attrib_records(void *rec, void *agg_rec, int init_flag)
+{
+    struct darshan_attrib_record *attrib_rec = (struct darshan_attrib_record *)rec;
+    struct darshan_attrib_record *agg_attrib_rec = (struct darshan_attrib_record *)agg_rec;
+    int i;
+
+    for(i = 0; i < ATTRIB_NUM_INDICES; i++)
+    {
+        switch(i)
+        {
+            case ATTRIB_UPPER_MODULE:
+                /* -1 if records of different modules are aggregated */
+                if(init_flag)
+                    agg_attrib_rec->counters[i] = attrib_rec->counters[i];
+                else if(agg_attrib_rec->counters[i] != attrib_rec->counters[i])
+                    agg_attrib_rec->counters[i] = -1;
+                break;
+            default:
+                /* sum */
+                agg_attrib_rec->counters[i] += attrib_rec->counters[i];
+                break;
+        }
+    }
+
+    for(i = 0; i < ATTRIB_F_NUM_INDICES; i++)
+    {
+        /* sum */
+        agg_attrib_rec->fcounters[i] += attrib_rec->fcounters[i];
+    }
+
+    return;
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
@@ -0,0 +1,325 @@
+/*
+ * Copyright (C) 2015 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "darshan-util-config.h"
+#endif
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "darshan-logutils.h"
+
+/* integer counter name strings for the BATCHIO module */
+#define X(a) #a,
+char *batchio_counter_names[] = {
+    BATCHIO_COUNTERS
+};
+
+/* floating point counter name strings for the BATCHIO module */
+char *batchio_f_counter_names[] = {
+    BATCHIO_F_COUNTERS
+};
+#undef X
+
+/* prototypes for each of the BATCHIO module's logutil functions */
+static int darshan_log_get_batchio_record(darshan_fd fd, void** batchio_buf_p);
+static int darshan_log_put_batchio_record(darshan_fd fd, void* batchio_buf);
+static void darshan_log_print_batchio_record(void *file_rec,
+    char *file_name, char *mnt_pt, char *fs_type);
+static void darshan_log_print_batchio_description(int ver);
+static void darshan_log_print_batchio_record_diff(void *file_rec1, char *file_name1,
+    void *file_rec2, char *file_name2);
+static void darshan_log_agg_batchio_records(void *rec, void *agg_rec, int init_flag);
+
+/* structure storing each function needed for implementing the darshan
+ * logutil interface. these functions are used for reading, writing, and
+ * printing module data in a consistent manner.
+ */
+struct darshan_mod_logutil_funcs batchio_logutils =
+{
+    .log_get_record = &darshan_log_get_batchio_record,
+    .log_put_record = &darshan_log_put_batchio_record,
+    .log_print_record = &darshan_log_print_batchio_record,
+    .log_print_description = &darshan_log_print_batchio_description,
+    .log_print_diff = &darshan_log_print_batchio_record_diff,
+    .log_agg_records = &darshan_log_agg_batchio_records
+};
+
+/* retrieve a BATCHIO record from log file descriptor 'fd', storing the
+ * data in the buffer address pointed to by 'batchio_buf_p'. Return 1 on
+ * successful record read, 0 on no more data, and -1 on error.
+ */
+static int darshan_log_get_batchio_record(darshan_fd fd, void** batchio_buf_p)
+{
+    struct darshan_batchio_record *rec = *((struct darshan_batchio_record **)batchio_buf_p);
+    int ret;
+
+    if(fd->mod_map[DARSHAN_BATCHIO_MOD].len == 0)
+        return(0);
+
+    if(fd->mod_ver[DARSHAN_BATCHIO_MOD] == 0 ||
+        fd->mod_ver[DARSHAN_BATCHIO_MOD] > DARSHAN_BATCHIO_VER)
+    {
+        fprintf(stderr, "Error: Invalid BATCHIO module version number (got %d)\n",
+            fd->mod_ver[DARSHAN_BATCHIO_MOD]);
+        return(-1);
+    }
+
+    if(*batchio_buf_p == NULL)
+    {
+        rec = malloc(sizeof(*rec));
+        if(!rec)
+            return(-1);
+    }
+
+    /* read a BATCHIO module record from the darshan log file */
+    ret = darshan_log_get_mod(fd, DARSHAN_BATCHIO_MOD, rec,
+        sizeof(struct darshan_batchio_record));
+
+    if(*batchio_buf_p == NULL)
+    {
+        if(ret == sizeof(struct darshan_batchio_record))
+            *batchio_buf_p = rec;
+        else
+            free(rec);
+    }
+
+    if(ret < 0)
+        return(-1);
+    else if(ret < sizeof(struct darshan_batchio_record))
+        return(0);
+    else
+    {
+        /* if the read was successful, do any necessary byte-swapping */
+        if(fd->swap_flag)
+        {
+            /* records consist only of 64-bit fields */
+            darshan_log_bswap64_array(rec,
+                sizeof(struct darshan_batchio_record) / sizeof(int64_t));
+        }
+
+        return(1);
+    }
+}
+
+/* write the BATCHIO record stored in 'batchio_buf' to log file descriptor 'fd'.
+ * Return 0 on success, -1 on failure
+ */
+static int darshan_log_put_batchio_record(darshan_fd fd, void* batchio_buf)
+{
+    struct darshan_batchio_record *rec = (struct darshan_batchio_record *)batchio_buf;
+    int ret;
+
+    /* append BATCHIO record to darshan log file */
+    ret = darshan_log_put_mod(fd, DARSHAN_BATCHIO_MOD, rec,
+        sizeof(struct darshan_batchio_record), DARSHAN_BATCHIO_VER);
+    if(ret < 0)
+        return(-1);
+
+    return(0);
+}
+
+/* print all I/O data record statistics for the given BATCHIO record */
+static void darshan_log_print_batchio_record(void *file_rec, char *file_name,
+    char *mnt_pt, char *fs_type)
+{
+    int i;
+    struct darshan_batchio_record *batchio_rec =
+        (struct darshan_batchio_record *)file_rec;
+
+    /* print each of the integer and floating point counters for the BATCHIO module */
+    for(i=0; i<BATCHIO_NUM_INDICES; i++)
+    {
+        /* macro defined in darshan-logutils.h */
+        DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_BATCHIO_MOD],
+            batchio_rec->base_rec.rank, batchio_rec->base_rec.id,
+            batchio_counter_names[i], batchio_rec->counters[i],
+            file_name, mnt_pt, fs_type);
+    }
+
+    for(i=0; i<BATCHIO_F_NUM_INDICES; i++)
+    {
+        /* macro defined in darshan-logutils.h */
+        DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_BATCHIO_MOD],
+            batchio_rec->base_rec.rank, batchio_rec->base_rec.id,
+            batchio_f_counter_names[i], batchio_rec->fcounters[i],
+            file_name, mnt_pt, fs_type);
+    }
+
+    return;
+}
+
+/* print out a description of the BATCHIO module record fields */
+static void darshan_log_print_batchio_description(int ver)
+{
+    printf("\n# description of BATCHIO counters:\n");
+    printf("#   records are kept for each file accessed through vectored or batched\n");
+    printf("#   asynchronous I/O, and for each submission interface used (named\n");
+    printf("#   %s and %s).\n", BATCHIO_LIBAIO_NAME, BATCHIO_IO_URING_NAME);
+    printf("#   BATCHIO_VEC_*: number of vectored read and write calls (readv, preadv,\n");
+    printf("#       preadv2, writev, pwritev, pwritev2 and their 64-bit variants).\n");
+    printf("#   BATCHIO_IOVECS: total iovec segments of vectored calls and requests.\n");
+    printf("#   BATCHIO_MAX_IOVCNT: largest iovec count of a vectored call or request.\n");
+    printf("#   BATCHIO_IOVCNT_*: histogram of iovec counts per vectored call or request.\n");
+    printf("#   BATCHIO_ASYNC_*: asynchronous read, write and other requests submitted.\n");
+    printf("#   BATCHIO_COMPLETIONS: asynchronous requests whose completion was reaped.\n");
+    printf("#   BATCHIO_MAX_QUEUE_DEPTH: most requests in flight at once.\n");
+    printf("#   BATCHIO_QUEUE_DEPTH_SUM: sum over submitted requests of the requests in\n");
+    printf("#       flight when each was submitted (divide by the number of requests for\n");
+    printf("#       the mean queue depth).\n");
+    printf("#   BATCHIO_SUBMITS: submission calls (interface records only).\n");
+    printf("#   BATCHIO_SUBMITTED: requests accepted by submission calls.\n");
+    printf("#   BATCHIO_SHORT_SUBMITS: submission calls that accepted fewer requests than\n");
+    printf("#       given, or failed.\n");
+    printf("#   BATCHIO_MAX_BATCH: most requests accepted by one submission call.\n");
+    printf("#   BATCHIO_BATCH_*: histogram of requests accepted per submission call.\n");
+    printf("#   BATCHIO_WAITS: calls that waited for or reaped completions.\n");
+    printf("#   BATCHIO_F_SUBMIT_TIME: cumulative time spent in submission calls.\n");
+    printf("#   BATCHIO_F_WAIT_TIME: cumulative time spent waiting for completions\n");
+    printf("#       (including calls that both submit and wait).\n");
+    printf("#   BATCHIO_F_COMPLETION_LATENCY: sum of submission-to-reap latencies.\n");
+    printf("#   BATCHIO_F_MAX_COMPLETION_LATENCY: largest submission-to-reap latency.\n");
+    printf("#   NOTE: io_uring requests are not attributed to files, and their queue\n");
+    printf("#       depth and completion latency are not known.\n");
+
+    return;
+}
+
+/* print a diff of two BATCHIO records (with the same record id) */
+static void darshan_log_print_batchio_record_diff(void *file_rec1, char *file_name1,
+    void *file_rec2, char *file_name2)
+{
+    struct darshan_batchio_record *file1 = (struct darshan_batchio_record *)file_rec1;
+    struct darshan_batchio_record *file2 = (struct darshan_batchio_record *)file_rec2;
+    int i;
+
+    /* NOTE: we assume that both input records are the same module format version */
+
+    for(i=0; i<BATCHIO_NUM_INDICES; i++)
+    {
+        if(!file2)
+        {
+            printf("- ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_BATCHIO_MOD],
+                file1->base_rec.rank, file1->base_rec.id, batchio_counter_names[i],
+                file1->counters[i], file_name1, "", "");
+
+        }
+        else if(!file1)
+        {
+            printf("+ ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_BATCHIO_MOD],
+                file2->base_rec.rank, file2->base_rec.id, batchio_counter_names[i],
+                file2->counters[i], file_name2, "", "");
+        }
+        else if(file1->counters[i] != file2->counters[i])
+        {
+            printf("- ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_BATCHIO_MOD],
+                file1->base_rec.rank, file1->base_rec.id, batchio_counter_names[i],
+                file1->counters[i], file_name1, "", "");
+            printf("+ ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_BATCHIO_MOD],
+                file2->base_rec.rank, file2->base_rec.id, batchio_counter_names[i],
+                file2->counters[i], file_name2, "", "");
+        }
+    }
+
+    for(i=0; i<BATCHIO_F_NUM_INDICES; i++)
+    {
+        if(!file2)
+        {
+            printf("- ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_BATCHIO_MOD],
+                file1->base_rec.rank, file1->base_rec.id, batchio_f_counter_names[i],
+                file1->fcounters[i], file_name1, "", "");
+
+        }
+        else if(!file1)
+        {
+            printf("+ ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_BATCHIO_MOD],
+                file2->base_rec.rank, file2->base_rec.id, batchio_f_counter_names[i],
+                file2->fcounters[i], file_name2, "", "");
+        }
+        else if(file1->fcounters[i] != file2->fcounters[i])
+        {
+            printf("- ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_BATCHIO_MOD],
+                file1->base_rec.rank, file1->base_rec.id, batchio_f_counter_names[i],
+                file1->fcounters[i], file_name1, "", "");
+            printf("+ ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_BATCHIO_MOD],
+                file2->base_rec.rank, file2->base_rec.id, batchio_f_counter_names[i],
+                file2->fcounters[i], file_name2, "", "");
+        }
+    }
+
+    return;
+}
+
+/* aggregate the input BATCHIO record 'rec'  into the output record 'agg_rec' */
+static void darshan_log_agg_batchio_records(void *rec, void *agg_rec, int init_flag)
+{
+    struct darshan_batchio_record *batchio_rec = (struct darshan_batchio_record *)rec;
+    struct darshan_batchio_record *agg_batchio_rec = (struct darshan_batchio_record *)agg_rec;
+    int i;
+
+    for(i = 0; i < BATCHIO_NUM_INDICES; i++)
+    {
+        switch(i)
+        {
+            case BATCHIO_MAX_IOVCNT:
+            case BATCHIO_MAX_QUEUE_DEPTH:
+            case BATCHIO_MAX_BATCH:
+                /* max */
+                if(batchio_rec->counters[i] > agg_batchio_rec->counters[i])
+                    agg_batchio_rec->counters[i] = batchio_rec->counters[i];
+                break;
+            default:
+                /* sum */
+                agg_batchio_rec->counters[i] += batchio_rec->counters[i];
+                break;
+        }
+    }
+
+    for(i = 0; i < BATCHIO_F_NUM_INDICES; i++)
+    {
+        switch(i)
+        {
+            case BATCHIO_F_MAX_COMPLETION_LATENCY:
+                /* max */
+                if(batchio_rec->fcounters[i] > agg_batchio_rec->fcounters[i])
+                    agg_batchio_rec->fcounters[i] = batchio_rec->fcounters[i];
+                break;
+            default:
+                /* sum */
+                agg_batchio_rec->fcounters[i] += batchio_rec->fcounters[i];
+                break;
+        }
+    }
+
+    return;
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
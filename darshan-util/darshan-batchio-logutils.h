@@ -0,0 +1,18 @@
+/*
+ * Copyright (C) 2015 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifndef __DARSHAN_BATCHIO_LOG_UTILS_H
+#define __DARSHAN_BATCHIO_LOG_UTILS_H
+
+/* declare BATCHIO module counter name strings and logutil definition as
+ * extern variables so they can be used in other utilities
+ */
+extern char *batchio_counter_names[];
+extern char *batchio_f_counter_names[];
+
+extern struct darshan_mod_logutil_funcs batchio_logutils;
+
+#endif
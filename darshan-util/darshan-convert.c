@@ -19,50 +19,134 @@
 #include <getopt.h>
 #include <assert.h>
 #include <errno.h>
+#include <libgen.h>
+#include <limits.h>
+#include <pthread.h>
+#ifdef HAVE_LIBZSTD
+#include <zdict.h>
+#endif
 
 #include "darshan-logutils.h"
 
 extern uint32_t darshan_hashlittle(const void *key, size_t length, uint32_t initval);
 
+/* conversion settings, shared by all logs converted in batch mode */
+struct convert_opts
+{
+    enum darshan_comp_type comp_type;
+    int obfuscate;
+    int key;
+    int reset_md;
+    char *annotation;
+    darshan_record_id hash;
+    /* pruning, applied to logs of jobs that ended more than 'older_than'
+     * seconds ago (or to all logs if negative)
+     */
+    int drop_dxt;
+    int drop_heatmap;
+    int dxt_sample;
+    int64_t older_than;
+    /* trained zstd dictionary to compress output logs with, if any */
+    char *zstd_dict;
+    size_t zstd_dict_len;
+};
+
+/* limits on the samples a zstd dictionary is trained on: the name record
+ * region and the small module regions of each log, since large regions
+ * compress well without a dictionary
+ */
+#define ZDICT_SAMPLE_MOD_MAX (64*1024)
+#define ZDICT_SAMPLE_MAX (256*1024)
+#define ZDICT_TOTAL_MAX (64*1024*1024)
+#define ZDICT_CAPACITY (110*1024)
+
+/* state shared by the worker threads of a batch conversion */
+static struct
+{
+    char **logs;
+    int log_cnt;
+    int next_log;
+    int failed;
+    char *outdir;
+    const struct convert_opts *opts;
+    pthread_mutex_t mutex;
+} batch;
+
 int usage (char *exename)
 {
     fprintf(stderr, "Usage: %s [options] <infile> <outfile>\n", exename);
+    fprintf(stderr, "       %s [options] --batch <list> (--outdir <dir> | --in-place)\n", exename);
+    fprintf(stderr, "       %s --train-zstd-dict <dir> --batch <list>\n", exename);
     fprintf(stderr, "       Converts darshan log from infile to outfile.\n");
     fprintf(stderr, "       rewrites the log file into the newest format.\n");
+    fprintf(stderr, "       --batch <list> Convert each log named in the file <list> (one\n");
+    fprintf(stderr, "                      path per line, - for stdin) using a pool of threads.\n");
+    fprintf(stderr, "       --outdir <dir> Write batch output logs to <dir>, under their input names.\n");
+    fprintf(stderr, "       --in-place Replace each batch input log with its converted version.\n");
+    fprintf(stderr, "       --threads <n> Number of threads converting logs in batch mode\n");
+    fprintf(stderr, "                     (default: number of cores).\n");
     fprintf(stderr, "       --bzip2 Use bzip2 compression instead of zlib.\n");
+    fprintf(stderr, "       --zstd Use zstd compression instead of zlib.\n");
+    fprintf(stderr, "       --zstd-dict <file> Use zstd compression with the trained dictionary\n");
+    fprintf(stderr, "                          in <file>.\n");
+    fprintf(stderr, "       --train-zstd-dict <dir> Train a zstd dictionary on the batch logs\n");
+    fprintf(stderr, "                               and write it to <dir> instead of converting.\n");
     fprintf(stderr, "       --obfuscate Obfuscate items in the log.\n");
     fprintf(stderr, "       --key <key> Key to use when obfuscating.\n");
     fprintf(stderr, "       --annotate <string> Additional metadata to add.\n");
     fprintf(stderr, "       --file <hash> Limit output to specified (hashed) file only.\n");
     fprintf(stderr, "       --reset-md Reset old metadata during conversion.\n");
+    fprintf(stderr, "       --drop-dxt Drop DXT trace data.\n");
+    fprintf(stderr, "       --drop-heatmap Drop heatmap data.\n");
+    fprintf(stderr, "       --dxt-sample <n> Keep only every <n>th DXT trace segment.\n");
+    fprintf(stderr, "       --older-than <days> Only apply the three options above to logs\n");
+    fprintf(stderr, "                           of jobs that ended more than <days> days ago.\n");
 
     exit(1);
 }
 
 void parse_args (int argc, char **argv, char **infile, char **outfile,
-                 int *bzip2, int *obfuscate, int *reset_md, int *key,
-                 char **annotate, uint64_t* hash)
+                 struct convert_opts *opts, char **batch_list, char **outdir,
+                 int *in_place, int *nthreads, char **dict_path,
+                 char **train_dir)
 {
     int index;
     int ret;
+    char *check;
+    double days;
 
     static struct option long_opts[] =
     {
         {"bzip2", 0, NULL, 'b'},
+        {"zstd", 0, NULL, 'z'},
+        {"zstd-dict", 1, NULL, 'Z'},
+        {"train-zstd-dict", 1, NULL, 'T'},
         {"annotate", 1, NULL, 'a'},
         {"obfuscate", 0, NULL, 'o'},
         {"reset-md", 0, NULL, 'r'},
         {"key", 1, NULL, 'k'},
         {"file", 1, NULL, 'f'},
+        {"drop-dxt", 0, NULL, 'D'},
+        {"drop-heatmap", 0, NULL, 'H'},
+        {"dxt-sample", 1, NULL, 'S'},
+        {"older-than", 1, NULL, 'O'},
+        {"batch", 1, NULL, 'B'},
+        {"outdir", 1, NULL, 'd'},
+        {"in-place", 0, NULL, 'i'},
+        {"threads", 1, NULL, 't'},
         {"help",  0, NULL, 0},
         { 0, 0, 0, 0 }
     };
 
-    *bzip2 = 0;
-    *obfuscate = 0;
-    *reset_md = 0;
-    *key = 0;
-    *hash = 0;
+    memset(opts, 0, sizeof(*opts));
+    opts->comp_type = DARSHAN_ZLIB_COMP;
+    opts->older_than = -1;
+    *batch_list = NULL;
+    *outdir = NULL;
+    *in_place = 0;
+    *nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+    *dict_path = NULL;
+    *train_dir = NULL;
 
     while(1)
     {
@@ -73,25 +157,66 @@ void parse_args (int argc, char **argv, char **infile, char **outfile,
         switch(c)
         {
             case 'b':
-                *bzip2 = 1;
+                opts->comp_type = DARSHAN_BZIP2_COMP;
+                break;
+            case 'z':
+                opts->comp_type = DARSHAN_ZSTD_COMP;
+                break;
+            case 'Z':
+                opts->comp_type = DARSHAN_ZSTD_COMP;
+                *dict_path = optarg;
+                break;
+            case 'T':
+                *train_dir = optarg;
                 break;
             case 'a':
-                *annotate = optarg;
+                opts->annotation = optarg;
                 break;
             case 'o':
-                *obfuscate = 1;
+                opts->obfuscate = 1;
                 break;
             case 'r':
-                *reset_md = 1;
+                opts->reset_md = 1;
                 break;
             case 'k':
-                *key = atoi(optarg);
+                opts->key = atoi(optarg);
                 break;
             case 'f':
-                ret = sscanf(optarg, "%" PRIu64, hash);
+                ret = sscanf(optarg, "%" PRIu64, &opts->hash);
                 if(ret != 1)
                     usage(argv[0]);
                 break;
+            case 'D':
+                opts->drop_dxt = 1;
+                break;
+            case 'H':
+                opts->drop_heatmap = 1;
+                break;
+            case 'S':
+                opts->dxt_sample = strtol(optarg, &check, 10);
+                if(optarg == check || *check != '\0' || opts->dxt_sample < 1)
+                    usage(argv[0]);
+                break;
+            case 'O':
+                days = strtod(optarg, &check);
+                if(optarg == check || *check != '\0' || days < 0)
+                    usage(argv[0]);
+                opts->older_than = (int64_t)(days * 86400);
+                break;
+            case 'B':
+                *batch_list = optarg;
+                break;
+            case 'd':
+                *outdir = optarg;
+                break;
+            case 'i':
+                *in_place = 1;
+                break;
+            case 't':
+                *nthreads = strtol(optarg, &check, 10);
+                if(optarg == check || *check != '\0' || *nthreads < 1)
+                    usage(argv[0]);
+                break;
             case 0:
             case '?':
             default:
@@ -100,7 +225,19 @@ void parse_args (int argc, char **argv, char **infile, char **outfile,
         }
     }
 
-    if (optind + 2 == argc)
+    if (*train_dir)
+    {
+        /* training only reads the batch logs */
+        if (!*batch_list || optind != argc || *outdir || *in_place)
+            usage(argv[0]);
+    }
+    else if (*batch_list)
+    {
+        /* batch output goes either to a directory or over the inputs */
+        if (optind != argc || (*outdir == NULL) == (*in_place == 0))
+            usage(argv[0]);
+    }
+    else if (optind + 2 == argc && !*outdir && !*in_place)
     {
         *infile = argv[optind];
         *outfile = argv[optind+1];
@@ -109,6 +246,8 @@ void parse_args (int argc, char **argv, char **infile, char **outfile,
     {
         usage(argv[0]);
     }
+    if(*nthreads < 1)
+        *nthreads = 1;
 
     return;
 }
@@ -249,11 +388,33 @@ static void remove_hash_recs(struct darshan_name_record_ref **name_hash,
     return;
 }
 
-int main(int argc, char **argv)
+/* keep only every 'sample'th segment of each of the write and read
+ * traces of a DXT file record
+ */
+static void sample_dxt_record(struct dxt_file_record *rec, int sample)
+{
+    segment_info *segs = (segment_info *)(rec + 1);
+    int64_t kept = 0;
+    int64_t i;
+
+    for(i = 0; i < rec->write_count; i += sample)
+        segs[kept++] = segs[i];
+    for(i = rec->write_count; i < rec->write_count + rec->read_count; i += sample)
+        segs[kept++] = segs[i];
+
+    rec->write_count = (rec->write_count + sample - 1) / sample;
+    rec->read_count = kept - rec->write_count;
+
+    return;
+}
+
+/* convert the log at 'infile_name' to 'outfile_name' according to 'opts';
+ * on failure, 'outfile_name' is removed
+ */
+static int convert_log(const char *infile_name, const char *outfile_name,
+    const struct convert_opts *opts)
 {
     int ret;
-    char *infile_name;
-    char *outfile_name;
     struct darshan_job job;
     char tmp_string[4096] = {0};
     darshan_fd infile;
@@ -264,48 +425,82 @@ int main(int argc, char **argv)
     struct darshan_name_record_ref *name_hash = NULL;
     struct darshan_name_record_ref *ref, *tmp;
     char *mod_buf, *tmp_mod_buf;
-    enum darshan_comp_type comp_type;
-    int bzip2;
-    int obfuscate;
-    int key;
-    char *annotation = NULL;
-    darshan_record_id hash;
-    int reset_md;
-
-    parse_args(argc, argv, &infile_name, &outfile_name, &bzip2, &obfuscate,
-               &reset_md, &key, &annotation, &hash);
+    char *annotation;
+    uint64_t partial_flag;
+    int prune;
+    int is_dxt;
 
     infile = darshan_log_open(infile_name);
     if(!infile)
         return(-1);
- 
-    comp_type = bzip2 ? DARSHAN_BZIP2_COMP : DARSHAN_ZLIB_COMP;
-    outfile = darshan_log_create(outfile_name, comp_type, infile->partial_flag);
-    if(!outfile)
+
+    /* read job info */
+    ret = darshan_log_get_job(infile, &job);
+    if(ret < 0)
     {
         darshan_log_close(infile);
         return(-1);
     }
 
-    /* read job info */
-    ret = darshan_log_get_job(infile, &job);
-    if(ret < 0)
+    /* data is only pruned from logs of jobs that are old enough */
+    prune = (opts->drop_dxt || opts->drop_heatmap || opts->dxt_sample > 1) &&
+        (opts->older_than < 0 || time(NULL) - job.end_time_sec > opts->older_than);
+
+    /* dropped modules are not incomplete in the new log */
+    partial_flag = infile->partial_flag;
+    if(prune && opts->drop_dxt)
+    {
+        DARSHAN_MOD_FLAG_UNSET(partial_flag, DXT_POSIX_MOD);
+        DARSHAN_MOD_FLAG_UNSET(partial_flag, DXT_MPIIO_MOD);
+        DARSHAN_MOD_FLAG_UNSET(partial_flag, DXT_STDIO_MOD);
+    }
+    if(prune && opts->drop_heatmap)
+        DARSHAN_MOD_FLAG_UNSET(partial_flag, DARSHAN_HEATMAP_MOD);
+
+    outfile = darshan_log_create(outfile_name, opts->comp_type, partial_flag);
+    if(!outfile)
     {
         darshan_log_close(infile);
-        darshan_log_close(outfile);
-        unlink(outfile_name);
         return(-1);
     }
+    if(opts->zstd_dict)
+    {
+        ret = darshan_log_set_zstd_dict(outfile, opts->zstd_dict,
+            opts->zstd_dict_len);
+        if(ret < 0)
+        {
+            darshan_log_close(infile);
+            darshan_log_close(outfile);
+            unlink(outfile_name);
+            return(-1);
+        }
+    }
 
-    if (reset_md) reset_md_job(&job);
-    if (obfuscate) obfuscate_job(key, &job);
-    if (annotation) add_annotation(annotation, &job);
+    if (opts->reset_md) reset_md_job(&job);
+    if (opts->obfuscate) obfuscate_job(opts->key, &job);
+    if (opts->annotation)
+    {
+        /* the annotation is tokenized in place, so work on a copy */
+        annotation = strdup(opts->annotation);
+        if(annotation)
+        {
+            add_annotation(annotation, &job);
+            free(annotation);
+        }
+    }
+    if (prune && opts->dxt_sample > 1 && !opts->drop_dxt)
+    {
+        /* record how the traces were thinned out */
+        snprintf(tmp_string, sizeof(tmp_string), "dxt_sample=%d", opts->dxt_sample);
+        add_annotation(tmp_string, &job);
+    }
 
     ret = darshan_log_put_job(outfile, &job);
     if (ret < 0)
     {
         darshan_log_close(infile);
         darshan_log_close(outfile);
+        unlink(outfile_name);
         return(-1);
     }
 
@@ -318,13 +513,14 @@ int main(int argc, char **argv)
         return(-1);
     }
 
-    if (obfuscate) obfuscate_exe(key, tmp_string);
+    if (opts->obfuscate) obfuscate_exe(opts->key, tmp_string);
 
     ret = darshan_log_put_exe(outfile, tmp_string);
     if(ret < 0)
     {
         darshan_log_close(infile);
         darshan_log_close(outfile);
+        unlink(outfile_name);
         return(-1);
     }
 
@@ -342,6 +538,7 @@ int main(int argc, char **argv)
     {
         darshan_log_close(infile);
         darshan_log_close(outfile);
+        unlink(outfile_name);
         return(-1);
     }
 
@@ -357,8 +554,8 @@ int main(int argc, char **argv)
     /* NOTE: obfuscating filepaths breaks the ability to map files
      * to the corresponding FS & mount info maintained by darshan
      */
-    if(obfuscate) obfuscate_filenames(key, name_hash, mnt_data_array, mount_count );
-    if(hash) remove_hash_recs(&name_hash, hash);
+    if(opts->obfuscate) obfuscate_filenames(opts->key, name_hash, mnt_data_array, mount_count );
+    if(opts->hash) remove_hash_recs(&name_hash, opts->hash);
 
     ret = darshan_log_put_namehash(outfile, name_hash);
     if(ret < 0)
@@ -383,6 +580,8 @@ int main(int argc, char **argv)
     {
         struct darshan_base_record *base_rec;
 
+        is_dxt = (i == DXT_POSIX_MOD || i == DXT_MPIIO_MOD || i == DXT_STDIO_MOD);
+
         /* check each module for any data */
         if(infile->mod_map[i].len == 0)
             continue;
@@ -399,11 +598,15 @@ int main(int argc, char **argv)
                 "for module %s, SKIPPING.\n", darshan_module_names[i]);
             continue;
         }
+        /* skip modules that are pruned from this log */
+        else if(prune && ((opts->drop_dxt && is_dxt) ||
+            (opts->drop_heatmap && i == DARSHAN_HEATMAP_MOD)))
+            continue;
 
         /* for dxt, don't use static record buffer and instead have
          * darshan-logutils malloc us memory for the trace data
          */
-        if(i == DXT_POSIX_MOD || i == DXT_MPIIO_MOD)
+        if(is_dxt)
         {
             tmp_mod_buf = NULL;
         }
@@ -418,13 +621,18 @@ int main(int argc, char **argv)
         {
             base_rec = (struct darshan_base_record *)tmp_mod_buf;
 
-            if(!hash || hash == base_rec->id)
+            if(!opts->hash || opts->hash == base_rec->id)
             {
+                if(is_dxt && prune && opts->dxt_sample > 1)
+                    sample_dxt_record((struct dxt_file_record *)tmp_mod_buf,
+                        opts->dxt_sample);
+
                 ret = mod_logutils[i]->log_put_record(outfile, tmp_mod_buf);
                 if(ret < 0)
                 {
-                    if(i == DXT_POSIX_MOD || i == DXT_MPIIO_MOD)
+                    if(is_dxt)
                         free(tmp_mod_buf);
+                    free(mod_buf);
                     darshan_log_close(infile);
                     darshan_log_close(outfile);
                     unlink(outfile_name);
@@ -432,7 +640,7 @@ int main(int argc, char **argv)
                 }
             }
 
-            if(i == DXT_POSIX_MOD || i == DXT_MPIIO_MOD)
+            if(is_dxt)
             {
                 free(tmp_mod_buf);
                 tmp_mod_buf = NULL;
@@ -446,6 +654,7 @@ int main(int argc, char **argv)
         {
             fprintf(stderr, "Error: failed to parse %s module record.\n",
                 darshan_module_names[i]);
+            free(mod_buf);
             darshan_log_close(infile);
             darshan_log_close(outfile);
             unlink(outfile_name);
@@ -471,6 +680,354 @@ int main(int argc, char **argv)
     return(ret);
 }
 
+/* convert one log of a batch, to the output directory or over the input */
+static int convert_batch_log(const char *path)
+{
+    char outpath[PATH_MAX];
+    char *tmp_path;
+    char *base;
+    int ret;
+
+    if(batch.outdir)
+    {
+        tmp_path = strdup(path);
+        if(!tmp_path)
+            return(-1);
+        base = basename(tmp_path);
+        ret = snprintf(outpath, sizeof(outpath), "%s/%s", batch.outdir, base);
+        free(tmp_path);
+        if(ret >= (int)sizeof(outpath))
+            return(-1);
+        return(convert_log(path, outpath, batch.opts));
+    }
+
+    /* write a temporary log next to the input and move it over the input
+     * only once it is complete
+     */
+    ret = snprintf(outpath, sizeof(outpath), "%s.convert.tmp", path);
+    if(ret >= (int)sizeof(outpath))
+        return(-1);
+    ret = convert_log(path, outpath, batch.opts);
+    if(ret < 0)
+        return(-1);
+    if(rename(outpath, path) < 0)
+    {
+        unlink(outpath);
+        return(-1);
+    }
+
+    return(0);
+}
+
+static void *batch_thread_fn(void *arg)
+{
+    char *path;
+    int ret;
+
+    while(1)
+    {
+        pthread_mutex_lock(&batch.mutex);
+        if(batch.next_log == batch.log_cnt)
+        {
+            pthread_mutex_unlock(&batch.mutex);
+            break;
+        }
+        path = batch.logs[batch.next_log++];
+        pthread_mutex_unlock(&batch.mutex);
+
+        ret = convert_batch_log(path);
+        if(ret < 0)
+        {
+            fprintf(stderr, "Error: unable to convert log file %s.\n", path);
+            pthread_mutex_lock(&batch.mutex);
+            batch.failed++;
+            pthread_mutex_unlock(&batch.mutex);
+        }
+    }
+
+    return NULL;
+}
+
+/* read the list of log paths to convert, one per line */
+static int read_batch_list(const char *list_path)
+{
+    char line[PATH_MAX];
+    char **tmp;
+    FILE *fp;
+    int cap = 0;
+    size_t len;
+
+    if(strcmp(list_path, "-") == 0)
+        fp = stdin;
+    else
+        fp = fopen(list_path, "r");
+    if(!fp)
+    {
+        fprintf(stderr, "Error: unable to open log list %s.\n", list_path);
+        return(-1);
+    }
+
+    while(fgets(line, sizeof(line), fp))
+    {
+        len = strlen(line);
+        while(len > 0 && (line[len-1] == '\n' || line[len-1] == '\r'))
+            line[--len] = '\0';
+        if(len == 0)
+            continue;
+
+        if(batch.log_cnt == cap)
+        {
+            cap = cap ? 2 * cap : 64;
+            tmp = realloc(batch.logs, cap * sizeof(*batch.logs));
+            if(!tmp)
+                break;
+            batch.logs = tmp;
+        }
+        batch.logs[batch.log_cnt] = strdup(line);
+        if(!batch.logs[batch.log_cnt])
+            break;
+        batch.log_cnt++;
+    }
+    if(!feof(fp))
+    {
+        fprintf(stderr, "Error: unable to read log list %s.\n", list_path);
+        if(fp != stdin)
+            fclose(fp);
+        return(-1);
+    }
+    if(fp != stdin)
+        fclose(fp);
+
+    return(0);
+}
+
+static int convert_batch(const char *list_path, char *outdir,
+    const struct convert_opts *opts, int nthreads)
+{
+    pthread_t *threads;
+    int ret = 0;
+    int i;
+
+    if(read_batch_list(list_path) < 0)
+        ret = -1;
+    batch.outdir = outdir;
+    batch.opts = opts;
+
+    threads = malloc(nthreads * sizeof(*threads));
+    if(ret == 0 && !threads)
+    {
+        fprintf(stderr, "Error: unable to allocate worker threads.\n");
+        ret = -1;
+    }
+
+    if(ret == 0)
+    {
+        pthread_mutex_init(&batch.mutex, NULL);
+        for(i = 0; i < nthreads && i < batch.log_cnt; i++)
+        {
+            if(pthread_create(&threads[i], NULL, batch_thread_fn, NULL) != 0)
+                break;
+        }
+        nthreads = i;
+        /* convert on this thread if no worker could be started */
+        if(nthreads == 0)
+            batch_thread_fn(NULL);
+        for(i = 0; i < nthreads; i++)
+            pthread_join(threads[i], NULL);
+        pthread_mutex_destroy(&batch.mutex);
+
+        printf("# converted %d logs, %d failed\n",
+            batch.log_cnt - batch.failed, batch.failed);
+        if(batch.failed)
+            ret = -1;
+    }
+
+    free(threads);
+    for(i = 0; i < batch.log_cnt; i++)
+        free(batch.logs[i]);
+    free(batch.logs);
+
+    return(ret);
+}
+
+/* read the trained zstd dictionary in 'path' into the conversion settings */
+static int read_zstd_dict(const char *path, struct convert_opts *opts)
+{
+    struct stat st;
+    int fd;
+    int ret = -1;
+
+    fd = open(path, O_RDONLY);
+    if(fd >= 0)
+    {
+        if(fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            opts->zstd_dict = malloc(st.st_size);
+            if(opts->zstd_dict &&
+                pread(fd, opts->zstd_dict, st.st_size, 0) == st.st_size)
+            {
+                opts->zstd_dict_len = st.st_size;
+                ret = 0;
+            }
+        }
+        close(fd);
+    }
+    if(ret < 0)
+        fprintf(stderr, "Error: unable to read zstd dictionary %s.\n", path);
+
+    return(ret);
+}
+
+/* train a zstd dictionary on the name record region and the small module
+ * regions of the logs in 'list_path' and write it to 'dir', named after
+ * its id so that log readers can find it through DARSHAN_ZSTD_DICT_PATH
+ */
+static int train_zstd_dict(const char *list_path, const char *dir)
+{
+#ifdef HAVE_LIBZSTD
+    char path[PATH_MAX];
+    char *samples = NULL;
+    size_t *sample_lens = NULL;
+    size_t total = 0;
+    unsigned int sample_cnt = 0;
+    unsigned int sample_cap = 0;
+    char *dict = NULL;
+    size_t dict_len;
+    darshan_fd fd;
+    struct darshan_job job;
+    int mod_id;
+    int len;
+    int i;
+    FILE *fp;
+    int ret = -1;
+
+    if(read_batch_list(list_path) < 0)
+        goto out;
+
+    samples = malloc(ZDICT_TOTAL_MAX);
+    if(!samples)
+        goto out;
+
+    for(i = 0; i < batch.log_cnt && total < ZDICT_TOTAL_MAX; i++)
+    {
+        fd = darshan_log_open(batch.logs[i]);
+        if(!fd)
+            continue;
+        if(darshan_log_get_job(fd, &job) < 0)
+        {
+            darshan_log_close(fd);
+            continue;
+        }
+
+        /* one sample for the name records and one per small module */
+        for(mod_id = -1; mod_id < DARSHAN_MAX_MODS && total < ZDICT_TOTAL_MAX;
+            mod_id++)
+        {
+            if(mod_id >= 0 && (fd->mod_map[mod_id].len == 0 ||
+                fd->mod_map[mod_id].len > ZDICT_SAMPLE_MOD_MAX))
+                continue;
+            if(sample_cnt == sample_cap)
+            {
+                size_t *tmp;
+                sample_cap = sample_cap ? 2 * sample_cap : 1024;
+                tmp = realloc(sample_lens, sample_cap * sizeof(*sample_lens));
+                if(!tmp)
+                    break;
+                sample_lens = tmp;
+            }
+            len = ZDICT_TOTAL_MAX - total;
+            if(len > ZDICT_SAMPLE_MAX)
+                len = ZDICT_SAMPLE_MAX;
+            len = darshan_log_get_region_sample(fd, mod_id, samples + total, len);
+            if(len <= 0)
+                continue;
+            sample_lens[sample_cnt++] = len;
+            total += len;
+        }
+        darshan_log_close(fd);
+    }
+
+    dict = malloc(ZDICT_CAPACITY);
+    if(!dict)
+        goto out;
+    dict_len = ZDICT_trainFromBuffer(dict, ZDICT_CAPACITY, samples,
+        sample_lens, sample_cnt);
+    if(ZDICT_isError(dict_len))
+    {
+        fprintf(stderr, "Error: unable to train zstd dictionary on %u samples: %s.\n",
+            sample_cnt, ZDICT_getErrorName(dict_len));
+        goto out;
+    }
+
+    snprintf(path, sizeof(path), "%s/darshan-%u.zdict", dir,
+        ZDICT_getDictID(dict, dict_len));
+    fp = fopen(path, "w");
+    if(!fp || fwrite(dict, 1, dict_len, fp) != dict_len)
+    {
+        fprintf(stderr, "Error: unable to write zstd dictionary %s.\n", path);
+        if(fp)
+        {
+            fclose(fp);
+            unlink(path);
+        }
+        goto out;
+    }
+    if(fclose(fp) != 0)
+    {
+        fprintf(stderr, "Error: unable to write zstd dictionary %s.\n", path);
+        unlink(path);
+        goto out;
+    }
+
+    printf("# zstd dictionary %u (%zu bytes, %u samples): %s\n",
+        ZDICT_getDictID(dict, dict_len), dict_len, sample_cnt, path);
+    ret = 0;
+
+out:
+    free(dict);
+    free(samples);
+    free(sample_lens);
+    for(i = 0; i < batch.log_cnt; i++)
+        free(batch.logs[i]);
+    free(batch.logs);
+    return(ret);
+#else
+    fprintf(stderr, "Error: training zstd dictionaries requires zstd support.\n");
+    return(-1);
+#endif
+}
+
+int main(int argc, char **argv)
+{
+    char *infile_name;
+    char *outfile_name;
+    struct convert_opts opts;
+    char *batch_list;
+    char *outdir;
+    int in_place;
+    int nthreads;
+    char *dict_path;
+    char *train_dir;
+    int ret;
+
+    parse_args(argc, argv, &infile_name, &outfile_name, &opts, &batch_list,
+               &outdir, &in_place, &nthreads, &dict_path, &train_dir);
+
+    if(train_dir)
+        return(train_zstd_dict(batch_list, train_dir) < 0);
+
+    if(dict_path && read_zstd_dict(dict_path, &opts) < 0)
+        return(1);
+
+    if(batch_list)
+        ret = convert_batch(batch_list, outdir, &opts, nthreads);
+    else
+        ret = convert_log(infile_name, outfile_name, &opts);
+
+    free(opts.zstd_dict);
+    return(ret);
+}
+
 /*
  * Local variables:
  *  c-indent-level: 4
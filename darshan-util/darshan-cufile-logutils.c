@@ -0,0 +1,344 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "darshan-util-config.h"
+#endif
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "darshan-logutils.h"
+
+/* integer counter name strings for the CUFILE module */
+#define X(a) #a,
+char *cufile_counter_names[] = {
+    CUFILE_COUNTERS
+};
+
+/* floating point counter name strings for the CUFILE module */
+char *cufile_f_counter_names[] = {
+    CUFILE_F_COUNTERS
+};
+#undef X
+
+/* prototypes for each of the CUFILE module's logutil functions */
+static int darshan_log_get_cufile_record(darshan_fd fd, void** cufile_buf_p);
+static int darshan_log_put_cufile_record(darshan_fd fd, void* cufile_buf);
+static void darshan_log_print_cufile_record(void *file_rec,
+    char *file_name, char *mnt_pt, char *fs_type);
+static void darshan_log_print_cufile_description(int ver);
+static void darshan_log_print_cufile_record_diff(void *file_rec1, char *file_name1,
+    void *file_rec2, char *file_name2);
+static void darshan_log_agg_cufile_records(void *rec, void *agg_rec, int init_flag);
+
+/* structure storing each function needed for implementing the darshan
+ * logutil interface. these functions are used for reading, writing, and
+ * printing module data in a consistent manner.
+ */
+struct darshan_mod_logutil_funcs cufile_logutils =
+{
+    .log_get_record = &darshan_log_get_cufile_record,
+    .log_put_record = &darshan_log_put_cufile_record,
+    .log_print_record = &darshan_log_print_cufile_record,
+    .log_print_description = &darshan_log_print_cufile_description,
+    .log_print_diff = &darshan_log_print_cufile_record_diff,
+    .log_agg_records = &darshan_log_agg_cufile_records
+};
+
+/* retrieve a CUFILE record from log file descriptor 'fd', storing the
+ * data in the buffer address pointed to by 'cufile_buf_p'. Return 1 on
+ * successful record read, 0 on no more data, and -1 on error.
+ */
+static int darshan_log_get_cufile_record(darshan_fd fd, void** cufile_buf_p)
+{
+    struct darshan_cufile_record *rec = *((struct darshan_cufile_record **)cufile_buf_p);
+    int ret;
+
+    if(fd->mod_map[DARSHAN_CUFILE_MOD].len == 0)
+        return(0);
+
+    if(fd->mod_ver[DARSHAN_CUFILE_MOD] == 0 ||
+        fd->mod_ver[DARSHAN_CUFILE_MOD] > DARSHAN_CUFILE_VER)
+    {
+        fprintf(stderr, "Error: Invalid CUFILE module version number (got %d)\n",
+            fd->mod_ver[DARSHAN_CUFILE_MOD]);
+        return(-1);
+    }
+
+    if(*cufile_buf_p == NULL)
+    {
+        rec = malloc(sizeof(*rec));
+        if(!rec)
+            return(-1);
+    }
+
+    /* read a CUFILE module record from the darshan log file */
+    ret = darshan_log_get_mod(fd, DARSHAN_CUFILE_MOD, rec,
+        sizeof(struct darshan_cufile_record));
+
+    if(*cufile_buf_p == NULL)
+    {
+        if(ret == sizeof(struct darshan_cufile_record))
+            *cufile_buf_p = rec;
+        else
+            free(rec);
+    }
+
+    if(ret < 0)
+        return(-1);
+    else if(ret < sizeof(struct darshan_cufile_record))
+        return(0);
+    else
+    {
+        /* if the read was successful, do any necessary byte-swapping */
+        if(fd->swap_flag)
+        {
+            /* records consist only of 64-bit fields */
+            darshan_log_bswap64_array(rec,
+                sizeof(struct darshan_cufile_record) / sizeof(int64_t));
+        }
+
+        return(1);
+    }
+}
+
+/* write the CUFILE record stored in 'cufile_buf' to log file descriptor 'fd'.
+ * Return 0 on success, -1 on failure
+ */
+static int darshan_log_put_cufile_record(darshan_fd fd, void* cufile_buf)
+{
+    struct darshan_cufile_record *rec = (struct darshan_cufile_record *)cufile_buf;
+    int ret;
+
+    /* append CUFILE record to darshan log file */
+    ret = darshan_log_put_mod(fd, DARSHAN_CUFILE_MOD, rec,
+        sizeof(struct darshan_cufile_record), DARSHAN_CUFILE_VER);
+    if(ret < 0)
+        return(-1);
+
+    return(0);
+}
+
+/* print all I/O data record statistics for the given CUFILE record */
+static void darshan_log_print_cufile_record(void *file_rec, char *file_name,
+    char *mnt_pt, char *fs_type)
+{
+    int i;
+    struct darshan_cufile_record *cufile_rec =
+        (struct darshan_cufile_record *)file_rec;
+
+    /* print each of the integer and floating point counters for the CUFILE module */
+    for(i=0; i<CUFILE_NUM_INDICES; i++)
+    {
+        /* macro defined in darshan-logutils.h */
+        DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_CUFILE_MOD],
+            cufile_rec->base_rec.rank, cufile_rec->base_rec.id,
+            cufile_counter_names[i], cufile_rec->counters[i],
+            file_name, mnt_pt, fs_type);
+    }
+
+    for(i=0; i<CUFILE_F_NUM_INDICES; i++)
+    {
+        /* macro defined in darshan-logutils.h */
+        DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_CUFILE_MOD],
+            cufile_rec->base_rec.rank, cufile_rec->base_rec.id,
+            cufile_f_counter_names[i], cufile_rec->fcounters[i],
+            file_name, mnt_pt, fs_type);
+    }
+
+    return;
+}
+
+/* print out a description of the CUFILE module record fields */
+static void darshan_log_print_cufile_description(int ver)
+{
+    printf("\n# description of CUFILE counters:\n");
+    printf("#   records are kept for each file accessed through a cuFile (GPUDirect\n");
+    printf("#   Storage) handle, plus a %s record for buffer registration,\n", CUFILE_SUMMARY_NAME);
+    printf("#   batch submission, and I/O on handles registered before Darshan started.\n");
+    printf("#   CUFILE_HANDLE_REGISTERS: cuFile handles registered for the file.\n");
+    printf("#   CUFILE_READS, CUFILE_WRITES: cuFileRead and cuFileWrite calls.\n");
+    printf("#   CUFILE_BATCH_READS, CUFILE_BATCH_WRITES: requests submitted in batches.\n");
+    printf("#   CUFILE_BYTES_*: bytes moved by cuFileRead and cuFileWrite.\n");
+    printf("#   CUFILE_BATCH_BYTES_*: bytes requested by batched reads and writes.\n");
+    printf("#   CUFILE_MAX_BYTE_*: highest offset in the file read or written.\n");
+    printf("#   CUFILE_REG_BUF_*: operations and bytes on buffers registered with\n");
+    printf("#       cuFileBufRegister, which GDS can move without staging.\n");
+    printf("#   CUFILE_UNREG_BUF_*: operations and bytes on unregistered buffers, which\n");
+    printf("#       GDS stages through its internal bounce buffers.\n");
+    printf("#   CUFILE_ERRORS: failed calls and failed batch requests.\n");
+    printf("#   CUFILE_SIZE_*_*: histogram of read and write access sizes.\n");
+    printf("#   CUFILE_BUF_REGISTERS, CUFILE_BUF_REGISTERED_BYTES: buffers registered\n");
+    printf("#       with cuFileBufRegister and their total size.\n");
+    printf("#   CUFILE_BATCH_SUBMITS: cuFileBatchIOSubmit calls.\n");
+    printf("#   CUFILE_BATCH_SUBMITTED: requests accepted by cuFileBatchIOSubmit.\n");
+    printf("#   CUFILE_MAX_BATCH: most requests in one submission.\n");
+    printf("#   CUFILE_BATCH_*: histogram of requests per submission.\n");
+    printf("#   CUFILE_BATCH_POLLS: cuFileBatchIOGetStatus calls.\n");
+    printf("#   CUFILE_BATCH_COMPLETIONS: batch requests reported complete.\n");
+    printf("#   CUFILE_F_*_START_TIMESTAMP: timestamp of first read/write.\n");
+    printf("#   CUFILE_F_*_END_TIMESTAMP: timestamp of last read/write.\n");
+    printf("#   CUFILE_F_READ_TIME, CUFILE_F_WRITE_TIME: cumulative time spent in\n");
+    printf("#       cuFileRead and cuFileWrite.\n");
+    printf("#   CUFILE_F_META_TIME: cumulative time spent registering and\n");
+    printf("#       deregistering handles and buffers.\n");
+    printf("#   CUFILE_F_MAX_READ_TIME, CUFILE_F_MAX_WRITE_TIME: slowest single call.\n");
+    printf("#   CUFILE_F_BATCH_SUBMIT_TIME, CUFILE_F_BATCH_POLL_TIME: cumulative time\n");
+    printf("#       spent submitting batches and polling for their completions.\n");
+    printf("#   CUFILE_F_BATCH_LATENCY: sum of submission-to-completion latencies of\n");
+    printf("#       batch requests, measured from the latest submission on the batch.\n");
+    printf("#   CUFILE_F_MAX_BATCH_LATENCY: largest batch request latency.\n");
+
+    return;
+}
+
+/* print a diff of two CUFILE records (with the same record id) */
+static void darshan_log_print_cufile_record_diff(void *file_rec1, char *file_name1,
+    void *file_rec2, char *file_name2)
+{
+    struct darshan_cufile_record *file1 = (struct darshan_cufile_record *)file_rec1;
+    struct darshan_cufile_record *file2 = (struct darshan_cufile_record *)file_rec2;
+    int i;
+
+    /* NOTE: we assume that both input records are the same module format version */
+
+    for(i=0; i<CUFILE_NUM_INDICES; i++)
+    {
+        if(!file2)
+        {
+            printf("- ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_CUFILE_MOD],
+                file1->base_rec.rank, file1->base_rec.id, cufile_counter_names[i],
+                file1->counters[i], file_name1, "", "");
+
+        }
+        else if(!file1)
+        {
+            printf("+ ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_CUFILE_MOD],
+                file2->base_rec.rank, file2->base_rec.id, cufile_counter_names[i],
+                file2->counters[i], file_name2, "", "");
+        }
+        else if(file1->counters[i] != file2->counters[i])
+        {
+            printf("- ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_CUFILE_MOD],
+                file1->base_rec.rank, file1->base_rec.id, cufile_counter_names[i],
+                file1->counters[i], file_name1, "", "");
+            printf("+ ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_CUFILE_MOD],
+                file2->base_rec.rank, file2->base_rec.id, cufile_counter_names[i],
+                file2->counters[i], file_name2, "", "");
+        }
+    }
+
+    for(i=0; i<CUFILE_F_NUM_INDICES; i++)
+    {
+        if(!file2)
+        {
+            printf("- ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_CUFILE_MOD],
+                file1->base_rec.rank, file1->base_rec.id, cufile_f_counter_names[i],
+                file1->fcounters[i], file_name1, "", "");
+
+        }
+        else if(!file1)
+        {
+            printf("+ ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_CUFILE_MOD],
+                file2->base_rec.rank, file2->base_rec.id, cufile_f_counter_names[i],
+                file2->fcounters[i], file_name2, "", "");
+        }
+        else if(file1->fcounters[i] != file2->fcounters[i])
+        {
+            printf("- ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_CUFILE_MOD],
+                file1->base_rec.rank, file1->base_rec.id, cufile_f_counter_names[i],
+                file1->fcounters[i], file_name1, "", "");
+            printf("+ ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_CUFILE_MOD],
+                file2->base_rec.rank, file2->base_rec.id, cufile_f_counter_names[i],
+                file2->fcounters[i], file_name2, "", "");
+        }
+    }
+
+    return;
+}
+
+/* aggregate the input CUFILE record 'rec'  into the output record 'agg_rec' */
+static void darshan_log_agg_cufile_records(void *rec, void *agg_rec, int init_flag)
+{
+    struct darshan_cufile_record *cufile_rec = (struct darshan_cufile_record *)rec;
+    struct darshan_cufile_record *agg_cufile_rec = (struct darshan_cufile_record *)agg_rec;
+    int i;
+
+    for(i = 0; i < CUFILE_NUM_INDICES; i++)
+    {
+        switch(i)
+        {
+            case CUFILE_MAX_BYTE_READ:
+            case CUFILE_MAX_BYTE_WRITTEN:
+            case CUFILE_MAX_BATCH:
+                /* max */
+                if(cufile_rec->counters[i] > agg_cufile_rec->counters[i])
+                    agg_cufile_rec->counters[i] = cufile_rec->counters[i];
+                break;
+            default:
+                /* sum */
+                agg_cufile_rec->counters[i] += cufile_rec->counters[i];
+                break;
+        }
+    }
+
+    for(i = 0; i < CUFILE_F_NUM_INDICES; i++)
+    {
+        switch(i)
+        {
+            case CUFILE_F_READ_START_TIMESTAMP:
+            case CUFILE_F_WRITE_START_TIMESTAMP:
+                /* min non-zero */
+                if((cufile_rec->fcounters[i] > 0) &&
+                    (init_flag || agg_cufile_rec->fcounters[i] == 0 ||
+                    cufile_rec->fcounters[i] < agg_cufile_rec->fcounters[i]))
+                    agg_cufile_rec->fcounters[i] = cufile_rec->fcounters[i];
+                break;
+            case CUFILE_F_READ_END_TIMESTAMP:
+            case CUFILE_F_WRITE_END_TIMESTAMP:
+            case CUFILE_F_MAX_READ_TIME:
+            case CUFILE_F_MAX_WRITE_TIME:
+            case CUFILE_F_MAX_BATCH_LATENCY:
+                /* max */
+                if(cufile_rec->fcounters[i] > agg_cufile_rec->fcounters[i])
+                    agg_cufile_rec->fcounters[i] = cufile_rec->fcounters[i];
+                break;
+            default:
+                /* sum */
+                agg_cufile_rec->fcounters[i] += cufile_rec->fcounters[i];
+                break;
+        }
+    }
+
+    return;
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
@@ -9,8 +9,10 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <inttypes.h>
 #include <sys/types.h>
+#include <getopt.h>
 #include <assert.h>
 
 #include "darshan-logutils.h"
@@ -33,6 +35,26 @@ struct darshan_file_record_ref
 
 static int darshan_build_global_record_hash(
     darshan_fd fd, struct darshan_file_record_ref **rec_hash);
+static int darshan_build_module_record_hash(
+    darshan_fd fd, int i, struct darshan_file_record_ref **rec_hash);
+static void darshan_diff_record_hashes(
+    darshan_fd file1, struct darshan_name_table *names1,
+    struct darshan_file_record_ref **rec_hash1,
+    darshan_fd file2, struct darshan_name_table *names2,
+    struct darshan_file_record_ref **rec_hash2, uint8_t *seps1);
+static void darshan_diff_separator(struct darshan_name_table *names1,
+    uint8_t *seps1, darshan_record_id rec_id);
+static int darshan_merge_diff(
+    darshan_fd file1, struct darshan_name_table *names1, char *logfile1,
+    darshan_fd file2, struct darshan_name_table *names2, char *logfile2);
+
+static void usage(void)
+{
+    fprintf(stderr, "Usage: darshan-diff [--merge] <logfile1> <logfile2>\n");
+    fprintf(stderr, "    --merge : diff the logs module by module in a single pass over\n");
+    fprintf(stderr, "              their records, using constant memory\n");
+    exit(-1);
+}
 
 static void print_str_diff(char *prefix, char *arg1, char *arg2)
 {
@@ -54,25 +76,41 @@ int main(int argc, char *argv[])
     darshan_fd file1, file2;
     struct darshan_job job1, job2;
     char exe1[4096], exe2[4096];
-    struct darshan_name_record_ref *name_hash1 = NULL, *name_hash2 = NULL;
-    struct darshan_name_record_ref *name_ref1, *name_ref2;
+    struct darshan_name_table *names1 = NULL, *names2 = NULL;
     struct darshan_file_record_ref *rec_hash1 = NULL, *rec_hash2 = NULL;
-    struct darshan_file_record_ref *rec_ref1, *rec_ref2, *rec_tmp;
-    struct darshan_mod_record_ref *mod_rec1, *mod_rec2;
-    void *mod_buf1, *mod_buf2;
-    struct darshan_base_record *base_rec1, *base_rec2;
-    char *file_name1, *file_name2;
-    int i;
+    int merge = 0;
+    int index;
     int ret;
+    static struct option long_opts[] =
+    {
+        {"merge", 0, NULL, 'm'},
+        {"help", 0, NULL, 'h'},
+        {0, 0, 0, 0}
+    };
 
-    if(argc != 3)
+    while(1)
     {
-        fprintf(stderr, "Usage: darshan-diff <logfile1> <logfile2>\n");
-        return(-1);
+        int c = getopt_long(argc, argv, "", long_opts, &index);
+
+        if(c == -1) break;
+
+        switch(c)
+        {
+            case 'm':
+                merge = 1;
+                break;
+            case 'h':
+            case '?':
+            default:
+                usage();
+                break;
+        }
     }
+    if(optind + 2 != argc)
+        usage();
 
-    logfile1 = argv[1];
-    logfile2 = argv[2];
+    logfile1 = argv[optind];
+    logfile2 = argv[optind + 1];
 
     file1 = darshan_log_open(logfile1);
     if(!file1)
@@ -144,8 +182,8 @@ int main(int argc, char *argv[])
                 (int64_t)(job1.end_time_sec - job1.start_time_sec + 1),
                 (int64_t)(job2.end_time_sec - job2.start_time_sec + 1));
 
-    /* get hash of record ids to file names for each log */
-    ret = darshan_log_get_namehash(file1, &name_hash1);
+    /* get table of record ids to file names for each log */
+    ret = darshan_log_get_name_table(file1, &names1);
     if(ret < 0)
     {
         darshan_log_close(file1);
@@ -154,48 +192,82 @@ int main(int argc, char *argv[])
         return(-1);
     }
 
-    ret = darshan_log_get_namehash(file2, &name_hash2);
+    ret = darshan_log_get_name_table(file2, &names2);
     if(ret < 0)
     {
+        darshan_name_table_free(names1);
         darshan_log_close(file1);
         darshan_log_close(file2);
         fprintf(stderr, "Error: unable to read record hash for darshan log file %s.\n", logfile2);
         return(-1);
     }
 
+    if(merge)
+    {
+        ret = darshan_merge_diff(file1, names1, logfile1, file2, names2, logfile2);
+        goto cleanup;
+    }
+
     /* build hash tables of all records opened by all modules for each darshan log file */
     ret = darshan_build_global_record_hash(file1, &rec_hash1);
     if(ret < 0)
     {
         fprintf(stderr, "Error: unable to build record hash for darshan log file %s.\n", logfile1);
-        darshan_log_close(file1);
-        darshan_log_close(file2);
-        return(-1);
+        goto cleanup;
     }
 
     ret = darshan_build_global_record_hash(file2, &rec_hash2);
     if(ret < 0)
     {
         fprintf(stderr, "Error: unable to build record hash for darshan log file %s.\n", logfile2);
-        darshan_log_close(file1);
-        darshan_log_close(file2);
-        return(-1);
+        goto cleanup;
     }
 
+    darshan_diff_record_hashes(file1, names1, &rec_hash1, file2, names2,
+        &rec_hash2, NULL);
+    ret = 0;
+
+cleanup:
+    darshan_name_table_free(names1);
+    darshan_name_table_free(names2);
+    darshan_log_close(file1);
+    darshan_log_close(file2);
+
+    return(ret);
+}
+
+/* diff the records of two record hashes, removing (and freeing) them from
+ * the hashes as they are diffed
+ */
+static void darshan_diff_record_hashes(
+    darshan_fd file1, struct darshan_name_table *names1,
+    struct darshan_file_record_ref **rec_hash1,
+    darshan_fd file2, struct darshan_name_table *names2,
+    struct darshan_file_record_ref **rec_hash2, uint8_t *seps1)
+{
+    struct darshan_file_record_ref *rec_ref1, *rec_ref2, *rec_tmp;
+    struct darshan_mod_record_ref *mod_rec1, *mod_rec2;
+    void *mod_buf1, *mod_buf2;
+    struct darshan_base_record *base_rec1, *base_rec2;
+    char *file_name1, *file_name2;
+    int i;
+
     /* iterate records for the first log file and correlate/diff with records from
      * the second log file
      */
-    HASH_ITER(hlink, rec_hash1, rec_ref1, rec_tmp)
+    HASH_ITER(hlink, *rec_hash1, rec_ref1, rec_tmp)
     {
-        printf("\n");
+        darshan_diff_separator(names1, seps1, rec_ref1->rec_id);
 
         /* search hash2 for this record */
-        HASH_FIND(hlink, rec_hash2, &(rec_ref1->rec_id), sizeof(darshan_record_id), rec_ref2);
+        HASH_FIND(hlink, *rec_hash2, &(rec_ref1->rec_id), sizeof(darshan_record_id), rec_ref2);
 
         for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
         {
-            /* skip the DXT modules -- we won't be diff'ing traces */
-            if(i == DXT_POSIX_MOD || i == DXT_MPIIO_MOD)
+            /* skip modules that can't be diffed, e.g., the DXT modules --
+             * we won't be diff'ing traces
+             */
+            if(!mod_logutils[i] || !mod_logutils[i]->log_print_diff)
                 continue;
 
             /* TODO: skip modules that don't have the same format version, for now */
@@ -210,6 +282,8 @@ int main(int argc, char *argv[])
 
             while(1)
             {
+                file_name1 = NULL;
+                file_name2 = NULL;
                 mod_rec1 = rec_ref1->mod_recs[i];
                 if(rec_ref2)
                     mod_rec2 = rec_ref2->mod_recs[i];
@@ -248,17 +322,13 @@ int main(int argc, char *argv[])
                 /* get corresponding file name for each record */
                 if(mod_buf1)
                 {
-                    HASH_FIND(hlink, name_hash1, &(base_rec1->id),
-                        sizeof(darshan_record_id), name_ref1);
-                    assert(name_ref1);
-                    file_name1 = name_ref1->name_record->name;
+                    file_name1 = darshan_name_table_lookup(names1, base_rec1->id);
+                    assert(file_name1);
                 }
                 if(mod_buf2)
                 {
-                    HASH_FIND(hlink, name_hash2, &(base_rec2->id),
-                        sizeof(darshan_record_id), name_ref2);
-                    assert(name_ref2);
-                    file_name2 = name_ref2->name_record->name;
+                    file_name2 = darshan_name_table_lookup(names2, base_rec2->id);
+                    assert(file_name2);
                 }
 
                 mod_logutils[i]->log_print_diff(mod_buf1, file_name1, mod_buf2, file_name2);
@@ -297,11 +367,11 @@ int main(int argc, char *argv[])
             }
         }
 
-        HASH_DELETE(hlink, rec_hash1, rec_ref1);
+        HASH_DELETE(hlink, *rec_hash1, rec_ref1);
         free(rec_ref1);
         if(rec_ref2)
         {
-            HASH_DELETE(hlink, rec_hash2, rec_ref2);
+            HASH_DELETE(hlink, *rec_hash2, rec_ref2);
             free(rec_ref2);
         }
     }
@@ -309,7 +379,7 @@ int main(int argc, char *argv[])
     /* iterate any remaning records from the 2nd log file and print the diff output --
      * NOTE: that these records do not have corresponding records in the first log file
      */
-    HASH_ITER(hlink, rec_hash2, rec_ref2, rec_tmp)
+    HASH_ITER(hlink, *rec_hash2, rec_ref2, rec_tmp)
     {
         for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
         {
@@ -318,12 +388,11 @@ int main(int argc, char *argv[])
                 mod_rec2 = rec_ref2->mod_recs[i];
                 base_rec2 = (struct darshan_base_record *)mod_rec2->mod_dat;
 
-                HASH_FIND(hlink, name_hash2, &(base_rec2->id),
-                    sizeof(darshan_record_id), name_ref2);
-                assert(name_ref2);
-                file_name2 = name_ref2->name_record->name;
+                file_name2 = darshan_name_table_lookup(names2, base_rec2->id);
+                assert(file_name2);
 
-                mod_logutils[i]->log_print_diff(NULL, NULL, mod_rec2->mod_dat, file_name2);
+                if(mod_logutils[i]->log_print_diff)
+                    mod_logutils[i]->log_print_diff(NULL, NULL, mod_rec2->mod_dat, file_name2);
                 
                 /* remove the record we just diffed */
                 if(mod_rec2->next == mod_rec2)
@@ -341,37 +410,52 @@ int main(int argc, char *argv[])
             }
         }
 
-        HASH_DELETE(hlink, rec_hash2, rec_ref2);
+        HASH_DELETE(hlink, *rec_hash2, rec_ref2);
         free(rec_ref2);
     }
 
-    HASH_ITER(hlink, name_hash1, name_ref1, name_ref2)
-    {
-        HASH_DELETE(hlink, name_hash1, name_ref1);
-        free(name_ref1->name_record);
-        free(name_ref1);
-    }
-    HASH_ITER(hlink, name_hash2, name_ref2, name_ref1)
+    return;
+}
+
+/* print the blank line that precedes the diff of each record of the first
+ * log file. if 'seps1' is given, it has a bit for each entry of 'names1'
+ * that is set once the line has been printed for that record id, so that
+ * it is printed only once per record id even if the record's modules and
+ * ranks are diffed separately.
+ */
+static void darshan_diff_separator(struct darshan_name_table *names1,
+    uint8_t *seps1, darshan_record_id rec_id)
+{
+    int64_t lo = 0, hi, mid;
+
+    if(seps1)
     {
-        HASH_DELETE(hlink, name_hash2, name_ref2);
-        free(name_ref2->name_record);
-        free(name_ref2);
+        hi = names1->count - 1;
+        while(lo <= hi)
+        {
+            mid = lo + (hi - lo) / 2;
+            if(names1->entries[mid].id == rec_id)
+            {
+                if(seps1[mid / 8] & (1 << (mid % 8)))
+                    return;
+                seps1[mid / 8] |= (1 << (mid % 8));
+                break;
+            }
+            else if(names1->entries[mid].id < rec_id)
+                lo = mid + 1;
+            else
+                hi = mid - 1;
+        }
     }
 
-    darshan_log_close(file1);
-    darshan_log_close(file2);
-
-    return(0);
+    printf("\n");
+    return;
 }
 
 static int darshan_build_global_record_hash(
     darshan_fd fd, struct darshan_file_record_ref **rec_hash)
 {
-    struct darshan_mod_record_ref *mod_rec;
-    struct darshan_file_record_ref *file_rec;
-    struct darshan_base_record *base_rec;
     int i;
-    int ret;
 
     /* iterate over all modules in each log file, adding records to the
      * appropriate hash table
@@ -380,98 +464,369 @@ static int darshan_build_global_record_hash(
     {
         if(!mod_logutils[i]) continue;
 
-        while(1)
+        if(darshan_build_module_record_hash(fd, i, rec_hash) < 0)
+            return(-1);
+    }
+
+    return(0);
+}
+
+/* add the records of module 'i' to the record hash */
+static int darshan_build_module_record_hash(
+    darshan_fd fd, int i, struct darshan_file_record_ref **rec_hash)
+{
+    struct darshan_mod_record_ref *mod_rec;
+    struct darshan_file_record_ref *file_rec;
+    struct darshan_base_record *base_rec;
+    int ret;
+
+    while(1)
+    {
+        mod_rec = malloc(sizeof(struct darshan_mod_record_ref));
+        assert(mod_rec);
+        memset(mod_rec, 0, sizeof(struct darshan_mod_record_ref));
+
+        ret = mod_logutils[i]->log_get_record(fd, (void **)&(mod_rec->mod_dat));
+        if(ret < 0)
+        {
+            fprintf(stderr, "Error: unable to read module %s data from log file.\n",
+                darshan_module_names[i]);
+            free(mod_rec);
+            return(-1);
+        }
+        else if(ret == 0)
         {
-            mod_rec = malloc(sizeof(struct darshan_mod_record_ref));
-            assert(mod_rec);
-            memset(mod_rec, 0, sizeof(struct darshan_mod_record_ref));
+            free(mod_rec);
+            break;
+        }
+        else
+        {
+            base_rec = (struct darshan_base_record *)mod_rec->mod_dat;
+            mod_rec->rank = base_rec->rank;
 
-            ret = mod_logutils[i]->log_get_record(fd, (void **)&(mod_rec->mod_dat));
-            if(ret < 0)
+            HASH_FIND(hlink, *rec_hash, &(base_rec->id), sizeof(darshan_record_id), file_rec);
+            if(!file_rec)
             {
-                fprintf(stderr, "Error: unable to read module %s data from log file.\n",
-                    darshan_module_names[i]);
-                free(mod_rec);
-                return(-1);
+                /* there is no entry in the global hash table of darshan records
+                 * for this log file, so create one and add it.
+                 */
+                file_rec = malloc(sizeof(struct darshan_file_record_ref));
+                assert(file_rec);
+
+                memset(file_rec, 0, sizeof(struct darshan_file_record_ref));
+                file_rec->rec_id = base_rec->id;
+                HASH_ADD(hlink, *rec_hash, rec_id, sizeof(darshan_record_id), file_rec);
+
             }
-            else if(ret == 0)
+
+            /* add new record into the linked list of this module's records */
+            if(file_rec->mod_recs[i])
             {
-                free(mod_rec);
-                break;
+                /* there is already an initialized linked list for this module */
+
+                /* we start at the end of the list and work backwards to insert this
+                 * record (the list is sorted according to increasing ranks, and in
+                 * general, darshan log records are sorted according to increasing
+                 * ranks, as well)
+                 */
+                struct darshan_mod_record_ref *tmp_mod_rec = file_rec->mod_recs[i]->prev;
+                while(1)
+                {
+                    if(mod_rec->rank > tmp_mod_rec->rank)
+                    {
+                        /* insert new module record after this record */
+                        mod_rec->prev = tmp_mod_rec;
+                        mod_rec->next = tmp_mod_rec->next;
+                        tmp_mod_rec->next->prev = mod_rec;
+                        tmp_mod_rec->next = mod_rec;
+                        break;
+                    }
+                    else if(mod_rec->rank < tmp_mod_rec->rank)
+                    {
+                        /* insert new module record before this record */
+                        mod_rec->prev = tmp_mod_rec->prev;
+                        mod_rec->next = tmp_mod_rec;
+                        tmp_mod_rec->prev->next = mod_rec;
+                        tmp_mod_rec->prev = mod_rec;
+                        if(file_rec->mod_recs[i] == mod_rec->next)
+                            file_rec->mod_recs[i] = mod_rec;
+                        break;
+                    }
+
+                    tmp_mod_rec = tmp_mod_rec->prev;
+                    assert(tmp_mod_rec != file_rec->mod_recs[i]);
+                }
             }
             else
             {
-                base_rec = (struct darshan_base_record *)mod_rec->mod_dat;
-                mod_rec->rank = base_rec->rank;
+                /* there are currently no records for this module, so just
+                 * initialize a new linked list
+                 */
+                mod_rec->prev = mod_rec->next = mod_rec;
+                file_rec->mod_recs[i] = mod_rec;
+            }
+        }
+    }
 
-                HASH_FIND(hlink, *rec_hash, &(base_rec->id), sizeof(darshan_record_id), file_rec);
-                if(!file_rec)
-                {
-                    /* there is no entry in the global hash table of darshan records
-                     * for this log file, so create one and add it.
-                     */
-                    file_rec = malloc(sizeof(struct darshan_file_record_ref));
-                    assert(file_rec);
+    return(0);
+}
 
-                    memset(file_rec, 0, sizeof(struct darshan_file_record_ref));
-                    file_rec->rec_id = base_rec->id;
-                    HASH_ADD(hlink, *rec_hash, rec_id, sizeof(darshan_record_id), file_rec);
+/* compare two records by the order the runtime writes them in: by rank,
+ * with shared records (rank -1) following those of rank 0, then by record id
+ */
+static int darshan_diff_rec_cmp(struct darshan_base_record *rec1,
+    struct darshan_base_record *rec2)
+{
+    int64_t ord1 = (rec1->rank < 0) ? 1 : 2 * rec1->rank;
+    int64_t ord2 = (rec2->rank < 0) ? 1 : 2 * rec2->rank;
 
-                }
+    if(ord1 != ord2)
+        return((ord1 < ord2) ? -1 : 1);
+    if(rec1->id != rec2->id)
+        return((rec1->id < rec2->id) ? -1 : 1);
 
-                /* add new record into the linked list of this module's records */
-                if(file_rec->mod_recs[i])
-                {
-                    /* there is already an initialized linked list for this module */
+    return(0);
+}
 
-                    /* we start at the end of the list and work backwards to insert this
-                     * record (the list is sorted according to increasing ranks, and in
-                     * general, darshan log records are sorted according to increasing
-                     * ranks, as well)
-                     */
-                    struct darshan_mod_record_ref *tmp_mod_rec = file_rec->mod_recs[i]->prev;
-                    while(1)
-                    {
-                        if(mod_rec->rank > tmp_mod_rec->rank)
-                        {
-                            /* insert new module record after this record */
-                            mod_rec->prev = tmp_mod_rec;
-                            mod_rec->next = tmp_mod_rec->next;
-                            tmp_mod_rec->next->prev = mod_rec;
-                            tmp_mod_rec->next = mod_rec;
-                            break;
-                        }
-                        else if(mod_rec->rank < tmp_mod_rec->rank)
-                        {
-                            /* insert new module record before this record */
-                            mod_rec->prev = tmp_mod_rec->prev;
-                            mod_rec->next = tmp_mod_rec;
-                            tmp_mod_rec->prev->next = mod_rec;
-                            tmp_mod_rec->prev = mod_rec;
-                            if(file_rec->mod_recs[i] == mod_rec->next)
-                                file_rec->mod_recs[i] = mod_rec;
-                            break;
-                        }
-
-                        tmp_mod_rec = tmp_mod_rec->prev;
-                        assert(tmp_mod_rec != file_rec->mod_recs[i]);
-                    }
-                }
-                else
-                {
-                    /* there are currently no records for this module, so just
-                     * initialize a new linked list
-                     */
-                    mod_rec->prev = mod_rec->next = mod_rec;
-                    file_rec->mod_recs[i] = mod_rec;
-                }
-            }
+/* check that the records of module 'mod_id' are stored in strictly
+ * increasing order; returns 1 if so, 0 if not, and -1 on error
+ */
+static int darshan_check_module_order(darshan_fd fd, int mod_id)
+{
+    struct darshan_base_record prev;
+    void *buf = NULL;
+    int have_prev = 0;
+    int ret;
+
+    while((ret = mod_logutils[mod_id]->log_get_record(fd, &buf)) > 0)
+    {
+        if(have_prev && darshan_diff_rec_cmp(&prev, buf) >= 0)
+        {
+            free(buf);
+            return(0);
         }
+        prev = *(struct darshan_base_record *)buf;
+        have_prev = 1;
+        free(buf);
+        buf = NULL;
+    }
+    if(ret < 0)
+    {
+        fprintf(stderr, "Error: unable to read module %s data from log file.\n",
+            darshan_module_names[mod_id]);
+        return(-1);
+    }
+
+    return(1);
+}
+
+/* diff the records of module 'mod_id', which are sorted in both logs, by
+ * reading them in lockstep and holding only one record of each log in
+ * memory at a time. if 'skip_common' is set, only records found in just one
+ * of the logs are printed. records are separated as in the default diff,
+ * using 'seps1' (see darshan_diff_separator()).
+ */
+static int darshan_merge_diff_module(int mod_id,
+    darshan_fd file1, struct darshan_name_table *names1,
+    darshan_fd file2, struct darshan_name_table *names2, int skip_common,
+    uint8_t *seps1)
+{
+    void *mod_buf1 = NULL, *mod_buf2 = NULL;
+    char *file_name1, *file_name2;
+    int ret1, ret2;
+    int cmp;
+
+    ret1 = mod_logutils[mod_id]->log_get_record(file1, &mod_buf1);
+    ret2 = mod_logutils[mod_id]->log_get_record(file2, &mod_buf2);
+    while(ret1 > 0 || ret2 > 0)
+    {
+        if(ret1 < 0 || ret2 < 0)
+            break;
+
+        if(ret1 == 0)
+            cmp = 1;
+        else if(ret2 == 0)
+            cmp = -1;
+        else
+            cmp = darshan_diff_rec_cmp(mod_buf1, mod_buf2);
+
+        file_name1 = file_name2 = NULL;
+        if(cmp <= 0)
+        {
+            file_name1 = darshan_name_table_lookup(names1,
+                ((struct darshan_base_record *)mod_buf1)->id);
+            assert(file_name1);
+        }
+        if(cmp >= 0)
+        {
+            file_name2 = darshan_name_table_lookup(names2,
+                ((struct darshan_base_record *)mod_buf2)->id);
+            assert(file_name2);
+        }
+
+        if(cmp <= 0)
+            darshan_diff_separator(names1, seps1,
+                ((struct darshan_base_record *)mod_buf1)->id);
+        if(cmp != 0 || !skip_common)
+        {
+            mod_logutils[mod_id]->log_print_diff(
+                (cmp <= 0) ? mod_buf1 : NULL, file_name1,
+                (cmp >= 0) ? mod_buf2 : NULL, file_name2);
+        }
+
+        /* advance past the records we just diffed */
+        if(cmp <= 0)
+        {
+            free(mod_buf1);
+            mod_buf1 = NULL;
+            ret1 = mod_logutils[mod_id]->log_get_record(file1, &mod_buf1);
+        }
+        if(cmp >= 0)
+        {
+            free(mod_buf2);
+            mod_buf2 = NULL;
+            ret2 = mod_logutils[mod_id]->log_get_record(file2, &mod_buf2);
+        }
+    }
+    free(mod_buf1);
+    free(mod_buf2);
+
+    if(ret1 < 0 || ret2 < 0)
+    {
+        fprintf(stderr, "Error: unable to read module %s data from log file.\n",
+            darshan_module_names[mod_id]);
+        return(-1);
     }
 
     return(0);
 }
 
+/* print the separators of the records of module 'mod_id' of the first log
+ * file, which has no diff output of its own
+ */
+static int darshan_merge_diff_separators(int mod_id, darshan_fd file1,
+    struct darshan_name_table *names1, uint8_t *seps1)
+{
+    void *mod_buf = NULL;
+    int ret;
+
+    while((ret = mod_logutils[mod_id]->log_get_record(file1, &mod_buf)) > 0)
+    {
+        darshan_diff_separator(names1, seps1,
+            ((struct darshan_base_record *)mod_buf)->id);
+        free(mod_buf);
+        mod_buf = NULL;
+    }
+
+    if(ret < 0)
+    {
+        fprintf(stderr, "Error: unable to read module %s data from log file.\n",
+            darshan_module_names[mod_id]);
+        return(-1);
+    }
+
+    return(0);
+}
+
+/* diff the two logs module by module. Records of each module are sorted by
+ * the runtime, so they can be matched up in a single pass over both logs.
+ * Each module is first checked to be sorted in both logs (using separate
+ * handles to the logs), and modules that are not are diffed using a hash of
+ * their records instead.
+ */
+static int darshan_merge_diff(
+    darshan_fd file1, struct darshan_name_table *names1, char *logfile1,
+    darshan_fd file2, struct darshan_name_table *names2, char *logfile2)
+{
+    struct darshan_file_record_ref *rec_hash1 = NULL, *rec_hash2 = NULL;
+    uint8_t *seps1;
+    darshan_fd check1, check2;
+    int sorted1, sorted2;
+    int skip_common;
+    int ret = 0;
+    int i;
+
+    seps1 = calloc((names1->count + 7) / 8 + 1, 1);
+    if(!seps1)
+        return(-1);
+
+    check1 = darshan_log_open(logfile1);
+    if(!check1)
+    {
+        free(seps1);
+        fprintf(stderr, "Error: unable to open darshan log file %s.\n", logfile1);
+        return(-1);
+    }
+    check2 = darshan_log_open(logfile2);
+    if(!check2)
+    {
+        free(seps1);
+        darshan_log_close(check1);
+        fprintf(stderr, "Error: unable to open darshan log file %s.\n", logfile2);
+        return(-1);
+    }
+
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT && ret == 0; i++)
+    {
+        if(!mod_logutils[i])
+            continue;
+
+        /* skip modules that can't be diffed, e.g., the DXT modules, but
+         * separate their records of the first log like the default diff
+         */
+        if(!mod_logutils[i]->log_print_diff)
+        {
+            if(file1->mod_map[i].len)
+                ret = darshan_merge_diff_separators(i, file1, names1, seps1);
+            continue;
+        }
+        if(file1->mod_map[i].len == 0 && file2->mod_map[i].len == 0)
+            continue;
+
+        /* TODO: skip records found in both logs for modules that don't
+         * have the same format version, for now
+         */
+        skip_common = 0;
+        if(file1->mod_map[i].len && file2->mod_map[i].len &&
+            (file1->mod_ver[i] != file2->mod_ver[i]))
+        {
+            fprintf(stderr, "Warning: skipping %s module data due to incompatible"
+                "version numbers (file1=%d, file2=%d).\n",
+                darshan_module_names[i], file1->mod_ver[i], file2->mod_ver[i]);
+            skip_common = 1;
+        }
+
+        sorted1 = darshan_check_module_order(check1, i);
+        sorted2 = darshan_check_module_order(check2, i);
+        if(sorted1 < 0 || sorted2 < 0)
+        {
+            ret = -1;
+            break;
+        }
+
+        if(sorted1 && sorted2)
+        {
+            ret = darshan_merge_diff_module(i, file1, names1, file2, names2,
+                skip_common, seps1);
+            continue;
+        }
+
+        /* fall back to hashing the records of this module only */
+        ret = darshan_build_module_record_hash(file1, i, &rec_hash1);
+        if(ret == 0)
+            ret = darshan_build_module_record_hash(file2, i, &rec_hash2);
+        if(ret == 0)
+            darshan_diff_record_hashes(file1, names1, &rec_hash1,
+                file2, names2, &rec_hash2, seps1);
+    }
+
+    free(seps1);
+    darshan_log_close(check1);
+    darshan_log_close(check2);
+
+    return(ret);
+}
+
 /*
  * Local variables:
  *  c-indent-level: 4
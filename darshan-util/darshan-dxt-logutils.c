@@ -13,6 +13,7 @@
 #include <string.h>
 #include <assert.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <unistd.h>
 #include <inttypes.h>
 #include <sys/types.h>
@@ -22,20 +23,51 @@
 
 #include "darshan-logutils.h"
 
+/* size of DXT file records in the original layout, before the dropped
+ * segment counters were added (DXT_POSIX version 1, DXT_MPIIO versions 1
+ * and 2)
+ */
+#define DXT_FILE_RECORD_V1_SIZE offsetof(struct dxt_file_record, write_dropped)
+
+/* size of the fixed-size trace segments of the original layout, which lack
+ * the thread id
+ */
+#define DXT_SEGMENT_V1_SIZE offsetof(segment_info, thread_id)
+
 static int dxt_log_get_posix_file(darshan_fd fd, void** dxt_posix_buf_p);
 static int dxt_log_put_posix_file(darshan_fd fd, void* dxt_posix_buf);
 
 static int dxt_log_get_mpiio_file(darshan_fd fd, void** dxt_mpiio_buf_p);
 static int dxt_log_put_mpiio_file(darshan_fd fd, void* dxt_mpiio_buf);
 
+static int dxt_log_get_stdio_file(darshan_fd fd, void** dxt_stdio_buf_p);
+static int dxt_log_put_stdio_file(darshan_fd fd, void* dxt_stdio_buf);
+
 static void dxt_log_print_posix_file_darshan(void *file_rec,
             char *file_name, char *mnt_pt, char *fs_type);
 static void dxt_log_print_mpiio_file_darshan(void *file_rec,
             char *file_name, char *mnt_pt, char *fs_type);
+static void dxt_log_print_stdio_file_darshan(void *file_rec,
+            char *file_name, char *mnt_pt, char *fs_type);
+static void dxt_log_print_posix_trace(struct dxt_file_record *file_rec,
+            char *file_name, char *mnt_pt, char *fs_type,
+            struct lustre_record_ref *lustre_rec_ref,
+            const struct dxt_log_filter *filter);
+static void dxt_log_print_trace(struct dxt_file_record *file_rec,
+            char *file_name, char *mnt_pt, char *fs_type, const char *mod_label,
+            const struct dxt_log_filter *filter);
 
 static void dxt_swap_file_record(struct dxt_file_record *file_rec);
 static void dxt_swap_file_record(struct dxt_file_record *file_rec);
 
+static int dxt_log_get_raw_segments(darshan_fd fd,
+            darshan_module_id mod_id, struct dxt_file_record *file_rec);
+static int dxt_log_get_compact_segments(darshan_fd fd,
+            darshan_module_id mod_id, struct dxt_file_record *file_rec,
+            int64_t enc_size);
+static int dxt_log_put_compact_file(darshan_fd fd, darshan_module_id mod_id,
+            struct dxt_file_record *file_rec, int ver);
+
 struct darshan_mod_logutil_funcs dxt_posix_logutils =
 {
     .log_get_record = &dxt_log_get_posix_file,
@@ -56,6 +88,16 @@ struct darshan_mod_logutil_funcs dxt_mpiio_logutils =
     .log_agg_records = NULL,
 };
 
+struct darshan_mod_logutil_funcs dxt_stdio_logutils =
+{
+    .log_get_record = &dxt_log_get_stdio_file,
+    .log_put_record = &dxt_log_put_stdio_file,
+    .log_print_record = &dxt_log_print_stdio_file_darshan,
+    .log_print_description = NULL,
+    .log_print_diff = NULL,
+    .log_agg_records = NULL,
+};
+
 static void dxt_swap_file_record(struct dxt_file_record *file_rec)
 {
     DARSHAN_BSWAP64(&file_rec->base_rec.id);
@@ -63,6 +105,8 @@ static void dxt_swap_file_record(struct dxt_file_record *file_rec)
     DARSHAN_BSWAP64(&file_rec->shared_record);
     DARSHAN_BSWAP64(&file_rec->write_count);
     DARSHAN_BSWAP64(&file_rec->read_count);
+    DARSHAN_BSWAP64(&file_rec->write_dropped);
+    DARSHAN_BSWAP64(&file_rec->read_dropped);
 }
 
 static void dxt_swap_segments(struct dxt_file_record *file_rec)
@@ -81,194 +125,481 @@ static void dxt_swap_segments(struct dxt_file_record *file_rec)
     }
 }
 
-static int dxt_log_get_posix_file(darshan_fd fd, void** dxt_posix_buf_p)
+/* layout of the records of a DXT module, by module version */
+struct dxt_mod_layout
 {
-    struct dxt_file_record *rec = *((struct dxt_file_record **)dxt_posix_buf_p);
-    struct dxt_file_record tmp_rec;
-    int ret;
-    int64_t io_trace_size;
+    int max_ver;
+    /* versions up to this one use the original layout, with fixed-size
+     * segments and without the dropped segment counters; later ones use
+     * the compact layout described in darshan-dxt-log-format.h
+     */
+    int v1_max_ver;
+};
 
-    if(fd->mod_map[DXT_POSIX_MOD].len == 0)
-        return(0);
+static const struct dxt_mod_layout dxt_posix_layout = {DXT_POSIX_VER, 1};
+static const struct dxt_mod_layout dxt_mpiio_layout = {DXT_MPIIO_VER, 2};
+static const struct dxt_mod_layout dxt_stdio_layout = {DXT_STDIO_VER, 0};
 
-    if(fd->mod_ver[DXT_POSIX_MOD] == 0 ||
-        fd->mod_ver[DXT_POSIX_MOD] > DXT_POSIX_VER)
+static const struct dxt_mod_layout *dxt_get_layout(darshan_module_id mod_id)
+{
+    switch(mod_id)
     {
-        fprintf(stderr, "Error: Invalid DXT POSIX module version number (got %d)\n",
-            fd->mod_ver[DXT_POSIX_MOD]);
-        return(-1);
+        case DXT_POSIX_MOD:
+            return(&dxt_posix_layout);
+        case DXT_MPIIO_MOD:
+            return(&dxt_mpiio_layout);
+        case DXT_STDIO_MOD:
+            return(&dxt_stdio_layout);
+        default:
+            return(NULL);
     }
+}
 
-    ret = darshan_log_get_mod(fd, DXT_POSIX_MOD, &tmp_rec,
-                sizeof(struct dxt_file_record));
-    if(ret < 0)
-        return (-1);
-    else if(ret < sizeof(struct dxt_file_record))
-        return (0);
+/* whether 'filter' restricts the time of the segments to read */
+static int dxt_filter_has_window(const struct dxt_log_filter *filter)
+{
+    return(filter && (filter->start_time > 0 || filter->end_time >= 0));
+}
 
-    if (fd->swap_flag)
-    {
-        /* swap bytes if necessary */
-        dxt_swap_file_record(&tmp_rec);
-    }
+static int dxt_filter_rank(const struct dxt_log_filter *filter, int64_t rank)
+{
+    int i;
 
-    io_trace_size = (tmp_rec.write_count + tmp_rec.read_count) *
-                        sizeof(segment_info);
+    if(!filter || !filter->rank_ranges)
+        return(1);
 
-    if (*dxt_posix_buf_p == NULL)
+    for(i = 0; i < filter->rank_range_count; i++)
     {
-        rec = malloc(sizeof(struct dxt_file_record) + io_trace_size);
-        if (!rec)
-            return(-1);
+        if(rank >= filter->rank_ranges[2 * i] &&
+           rank <= filter->rank_ranges[2 * i + 1])
+            return(1);
     }
-    memcpy(rec, &tmp_rec, sizeof(struct dxt_file_record));
 
-    if (io_trace_size > 0)
-    {
-        void *tmp_p = (void *)rec + sizeof(struct dxt_file_record);
+    return(0);
+}
 
-        ret = darshan_log_get_mod(fd, DXT_POSIX_MOD, tmp_p,
-                    io_trace_size);
-        if (ret < io_trace_size)
-            ret = -1;
-        else
-        {
-            ret = 1;
-            if(fd->swap_flag)
-            {
-                /* byte swap trace data if necessary */
-                dxt_swap_segments(rec);
-            }
-        }
-    }
-    else
-    {
-        ret = 1;
-    }
+/* consume 'size' bytes of a module's data without decoding them */
+static int dxt_log_skip(darshan_fd fd, darshan_module_id mod_id, int64_t size)
+{
+    char buf[4096];
+    int64_t n;
+    int ret;
 
-    if(*dxt_posix_buf_p == NULL)
-    {   
-        if(ret == 1)
-            *dxt_posix_buf_p = rec;
-        else
-            free(rec);
+    while(size > 0)
+    {
+        n = (size < (int64_t)sizeof(buf)) ? size : (int64_t)sizeof(buf);
+        ret = darshan_log_get_mod(fd, mod_id, buf, n);
+        if(ret < n)
+            return(-1);
+        size -= n;
     }
 
-    return(ret);
+    return(0);
 }
 
-static int dxt_log_get_mpiio_file(darshan_fd fd, void** dxt_mpiio_buf_p)
+/* read the next DXT file record of module 'mod_id' matching 'filter' (or
+ * the next record if 'filter' is NULL), skipping records that don't match
+ * without decoding their trace segments where the log allows it
+ */
+static int dxt_log_get_file(darshan_fd fd, darshan_module_id mod_id,
+    void **dxt_buf_p, const struct dxt_log_filter *filter)
 {
-    struct dxt_file_record *rec = *((struct dxt_file_record **)dxt_mpiio_buf_p);
+    const struct dxt_mod_layout *layout = dxt_get_layout(mod_id);
+    struct dxt_file_record *rec = *((struct dxt_file_record **)dxt_buf_p);
     struct dxt_file_record tmp_rec;
-    int i;
-    int ret;
+    segment_info *segs;
     int64_t io_trace_size;
+    int64_t seg_count;
+    int64_t enc_size = 0;
+    int64_t range[2];
+    int compact;
+    int rec_hdr_size;
+    int ver;
+    int match;
+    int64_t i;
+    int ret;
 
-    if(fd->mod_map[DXT_MPIIO_MOD].len == 0)
+    if(fd->mod_map[mod_id].len == 0)
         return(0);
 
-    if(fd->mod_ver[DXT_MPIIO_MOD] == 0 ||
-        fd->mod_ver[DXT_MPIIO_MOD] > DXT_MPIIO_VER)
+    ver = fd->mod_ver[mod_id];
+    if(ver == 0 || ver > layout->max_ver)
     {
-        fprintf(stderr, "Error: Invalid DXT MPIIO module version number (got %d)\n",
-            fd->mod_ver[DXT_MPIIO_MOD]);
+        fprintf(stderr, "Error: Invalid %s module version number (got %d)\n",
+            darshan_module_names[mod_id], ver);
         return(-1);
     }
 
-    ret = darshan_log_get_mod(fd, DXT_MPIIO_MOD, &tmp_rec,
-                sizeof(struct dxt_file_record));
-    if(ret < 0)
-        return (-1);
-    else if(ret < sizeof(struct dxt_file_record))
-        return (0);
+    /* records of the original layout lack the dropped segment counters */
+    compact = (ver > layout->v1_max_ver);
+    if(compact)
+        rec_hdr_size = sizeof(struct dxt_file_record);
+    else
+        rec_hdr_size = DXT_FILE_RECORD_V1_SIZE;
 
-    if (fd->swap_flag)
+    while(1)
     {
-        /* swap bytes if necessary */
-        dxt_swap_file_record(&tmp_rec);
-    }
+        memset(&tmp_rec, 0, sizeof(tmp_rec));
+        ret = darshan_log_get_mod(fd, mod_id, &tmp_rec, rec_hdr_size);
+        if(ret < 0)
+            return (-1);
+        else if(ret < rec_hdr_size)
+            return (0);
+
+        if (fd->swap_flag)
+        {
+            /* swap bytes if necessary */
+            dxt_swap_file_record(&tmp_rec);
+        }
+        seg_count = tmp_rec.write_count + tmp_rec.read_count;
+        if(seg_count < 0)
+            return(-1);
 
-    io_trace_size = (tmp_rec.write_count + tmp_rec.read_count) *
-                        sizeof(segment_info);
+        if(compact)
+        {
+            ret = darshan_log_get_mod(fd, mod_id, &enc_size, sizeof(enc_size));
+            if(ret < (int)sizeof(enc_size))
+                return(-1);
+            if(fd->swap_flag)
+                DARSHAN_BSWAP64(&enc_size);
+            if(enc_size < 0 || enc_size > seg_count * DXT_SEG_MAX_ENCODED_SIZE)
+                return(-1);
+            ret = darshan_log_get_mod(fd, mod_id, range, sizeof(range));
+            if(ret < (int)sizeof(range))
+                return(-1);
+            if(fd->swap_flag)
+                darshan_log_bswap64_array(range, 2);
+        }
 
-    if (*dxt_mpiio_buf_p == NULL)
-    {
-        rec = malloc(sizeof(struct dxt_file_record) + io_trace_size);
-        if (!rec)
-            return(-1);
-    }
-    memcpy(rec, &tmp_rec, sizeof(struct dxt_file_record));
+        /* records of other ranks, or recorded entirely outside of the
+         * requested time window, are skipped without being decoded
+         */
+        match = dxt_filter_rank(filter, tmp_rec.base_rec.rank);
+        if(match && compact && dxt_filter_has_window(filter))
+        {
+            match = seg_count > 0 &&
+                DXT_SEG_TICKS_TO_TIME(range[1]) >= filter->start_time &&
+                (filter->end_time < 0 ||
+                 DXT_SEG_TICKS_TO_TIME(range[0]) <= filter->end_time);
+        }
+        if(!match)
+        {
+            if(compact)
+                ret = dxt_log_skip(fd, mod_id, enc_size);
+            else
+                ret = dxt_log_skip(fd, mod_id, seg_count * DXT_SEGMENT_V1_SIZE);
+            if(ret < 0)
+                return(-1);
+            continue;
+        }
 
-    if (io_trace_size > 0)
-    {
-        void *tmp_p = (void *)rec + sizeof(struct dxt_file_record);
+        io_trace_size = seg_count * sizeof(segment_info);
+        if (*dxt_buf_p == NULL)
+        {
+            rec = malloc(sizeof(struct dxt_file_record) + io_trace_size);
+            if (!rec)
+                return(-1);
+        }
+        memcpy(rec, &tmp_rec, sizeof(struct dxt_file_record));
 
-        ret = darshan_log_get_mod(fd, DXT_MPIIO_MOD, tmp_p,
-                    io_trace_size);
-        if (ret < io_trace_size)
-            ret = -1;
+        if(compact)
+            ret = dxt_log_get_compact_segments(fd, mod_id, rec, enc_size);
         else
         {
-            ret = 1;
-            if(fd->swap_flag)
+            ret = dxt_log_get_raw_segments(fd, mod_id, rec);
+            if(ret == 1 && mod_id == DXT_MPIIO_MOD && ver == 1)
             {
-                /* byte swap trace data if necessary */
-                dxt_swap_segments(rec);
-            }
+                segs = (segment_info *)
+                    ((void *)rec + sizeof(struct dxt_file_record));
 
-            if(fd->mod_ver[DXT_MPIIO_MOD] == 1)
-            {
                 /* make sure to indicate offsets are invalid in version 1 */
-                for(i = 0; i < (tmp_rec.write_count + tmp_rec.read_count); i++)
+                for(i = 0; i < seg_count; i++)
                 {
-                    ((segment_info *)tmp_p)[i].offset = -1;
+                    segs[i].offset = -1;
                 }
             }
         }
+
+        /* without a stored time range, the segments must be checked */
+        if(ret == 1 && !compact && dxt_filter_has_window(filter))
+        {
+            segs = (segment_info *)
+                ((void *)rec + sizeof(struct dxt_file_record));
+            for(i = 0; i < seg_count; i++)
+            {
+                if(DXT_LOG_SEG_IN_FILTER(filter, &segs[i]))
+                    break;
+            }
+            if(i == seg_count)
+            {
+                if(*dxt_buf_p == NULL)
+                    free(rec);
+                continue;
+            }
+        }
+
+        if(*dxt_buf_p == NULL)
+        {
+            if(ret == 1)
+                *dxt_buf_p = rec;
+            else
+                free(rec);
+        }
+
+        return(ret);
     }
-    else
-    {
-        ret = 1;
-    }
+}
+
+static int dxt_log_get_posix_file(darshan_fd fd, void** dxt_posix_buf_p)
+{
+    return(dxt_log_get_file(fd, DXT_POSIX_MOD, dxt_posix_buf_p, NULL));
+}
+
+static int dxt_log_get_mpiio_file(darshan_fd fd, void** dxt_mpiio_buf_p)
+{
+    return(dxt_log_get_file(fd, DXT_MPIIO_MOD, dxt_mpiio_buf_p, NULL));
+}
+
+static int dxt_log_get_stdio_file(darshan_fd fd, void** dxt_stdio_buf_p)
+{
+    return(dxt_log_get_file(fd, DXT_STDIO_MOD, dxt_stdio_buf_p, NULL));
+}
 
-    if(*dxt_mpiio_buf_p == NULL)
+int dxt_log_get_filtered_file(darshan_fd fd, darshan_module_id mod_id,
+    const struct dxt_log_filter *filter, void **dxt_buf_p)
+{
+    if(!dxt_get_layout(mod_id))
     {
-        if(ret == 1)
-            *dxt_mpiio_buf_p = rec;
-        else
-            free(rec);
+        fprintf(stderr, "Error: %s is not a DXT module.\n",
+            darshan_module_names[mod_id]);
+        return(-1);
     }
 
-    return(ret);
+    return(dxt_log_get_file(fd, mod_id, dxt_buf_p, filter));
 }
 
 static int dxt_log_put_posix_file(darshan_fd fd, void* dxt_posix_buf)
 {
     struct dxt_file_record *file_rec =
                 (struct dxt_file_record *)dxt_posix_buf;
-    int rec_size = sizeof(struct dxt_file_record) + (sizeof(segment_info) * 
-        (file_rec->write_count + file_rec->read_count));
-    int ret;
 
-    ret = darshan_log_put_mod(fd, DXT_POSIX_MOD, file_rec,
-                rec_size, DXT_POSIX_VER);
-    if(ret < 0)
-        return(-1);
-
-    return(0);
+    return(dxt_log_put_compact_file(fd, DXT_POSIX_MOD, file_rec, DXT_POSIX_VER));
 }
 
 static int dxt_log_put_mpiio_file(darshan_fd fd, void* dxt_mpiio_buf)
 {
     struct dxt_file_record *file_rec =
                 (struct dxt_file_record *)dxt_mpiio_buf;
-    int rec_size = sizeof(struct dxt_file_record) + (sizeof(segment_info) * 
-        (file_rec->write_count + file_rec->read_count));
+
+    return(dxt_log_put_compact_file(fd, DXT_MPIIO_MOD, file_rec, DXT_MPIIO_VER));
+}
+
+static int dxt_log_put_stdio_file(darshan_fd fd, void* dxt_stdio_buf)
+{
+    struct dxt_file_record *file_rec =
+                (struct dxt_file_record *)dxt_stdio_buf;
+
+    return(dxt_log_put_compact_file(fd, DXT_STDIO_MOD, file_rec, DXT_STDIO_VER));
+}
+
+/* decode 'count' compactly encoded trace segments from '*buf' (not reading
+ * past 'end') into 'segs', advancing '*buf' past the decoded data
+ */
+static int dxt_decode_segments(unsigned char **buf, unsigned char *end,
+    segment_info *segs, int64_t count)
+{
+    uint64_t fields[5];
+    int64_t prev_end = 0;
+    int64_t prev_start = 0;
+    int64_t prev_thread = 0;
+    int64_t start;
+    int64_t i;
+    int ok;
+    int j;
+
+    for(i = 0; i < count; i++)
+    {
+        for(j = 0; j < 5; j++)
+        {
+            DXT_VARINT_GET(*buf, end, fields[j], ok);
+            if(!ok)
+                return(-1);
+        }
+
+        segs[i].offset = prev_end + DXT_ZIGZAG_DEC(fields[0]);
+        segs[i].length = DXT_ZIGZAG_DEC(fields[1]);
+        start = prev_start + DXT_ZIGZAG_DEC(fields[2]);
+        segs[i].start_time = DXT_SEG_TICKS_TO_TIME(start);
+        segs[i].end_time = DXT_SEG_TICKS_TO_TIME(start + DXT_ZIGZAG_DEC(fields[3]));
+        segs[i].thread_id = prev_thread + DXT_ZIGZAG_DEC(fields[4]);
+        prev_thread = segs[i].thread_id;
+        prev_end = segs[i].offset + segs[i].length;
+        prev_start = start;
+    }
+
+    return(0);
+}
+
+/* encode 'count' trace segments from 'segs' into 'buf', returning the end
+ * of the encoded data
+ */
+static unsigned char *dxt_encode_segments(unsigned char *buf,
+    segment_info *segs, int64_t count)
+{
+    int64_t prev_end = 0;
+    int64_t prev_start = 0;
+    int64_t prev_thread = 0;
+    int64_t start, end;
+    int64_t i;
+
+    for(i = 0; i < count; i++)
+    {
+        start = DXT_SEG_TIME_TO_TICKS(segs[i].start_time);
+        end = DXT_SEG_TIME_TO_TICKS(segs[i].end_time);
+        DXT_VARINT_PUT(buf, DXT_ZIGZAG_ENC(segs[i].offset - prev_end));
+        DXT_VARINT_PUT(buf, DXT_ZIGZAG_ENC(segs[i].length));
+        DXT_VARINT_PUT(buf, DXT_ZIGZAG_ENC(start - prev_start));
+        DXT_VARINT_PUT(buf, DXT_ZIGZAG_ENC(end - start));
+        DXT_VARINT_PUT(buf, DXT_ZIGZAG_ENC(segs[i].thread_id - prev_thread));
+        prev_end = segs[i].offset + segs[i].length;
+        prev_start = start;
+        prev_thread = segs[i].thread_id;
+    }
+
+    return(buf);
+}
+
+/* read the fixed-size trace segments following the DXT file record
+ * 'file_rec' into the segment array trailing it in memory
+ */
+static int dxt_log_get_raw_segments(darshan_fd fd,
+    darshan_module_id mod_id, struct dxt_file_record *file_rec)
+{
+    segment_info *segs = (segment_info *)
+        ((void *)file_rec + sizeof(struct dxt_file_record));
+    int64_t seg_count = file_rec->write_count + file_rec->read_count;
+    int64_t raw_size = seg_count * DXT_SEGMENT_V1_SIZE;
+    int64_t i;
     int ret;
 
-    ret = darshan_log_put_mod(fd, DXT_MPIIO_MOD, file_rec,
-                rec_size, DXT_MPIIO_VER);
+    if(raw_size == 0)
+        return(1);
+
+    ret = darshan_log_get_mod(fd, mod_id, segs, raw_size);
+    if(ret < raw_size)
+        return(-1);
+
+    /* spread the segments out to their in-memory size, starting with the
+     * last one so that none is overwritten before it has been moved
+     */
+    for(i = seg_count - 1; i >= 0; i--)
+    {
+        memmove(&segs[i], (char *)segs + i * DXT_SEGMENT_V1_SIZE,
+            DXT_SEGMENT_V1_SIZE);
+        segs[i].thread_id = -1;
+    }
+
+    if(fd->swap_flag)
+    {
+        /* byte swap trace data if necessary */
+        dxt_swap_segments(file_rec);
+    }
+
+    return(1);
+}
+
+/* read the 'enc_size' bytes of compactly encoded trace segments following
+ * the DXT file record 'file_rec' into the segment array trailing it in memory
+ */
+static int dxt_log_get_compact_segments(darshan_fd fd,
+    darshan_module_id mod_id, struct dxt_file_record *file_rec,
+    int64_t enc_size)
+{
+    segment_info *segs = (segment_info *)
+        ((void *)file_rec + sizeof(struct dxt_file_record));
+    int64_t seg_count = file_rec->write_count + file_rec->read_count;
+    unsigned char *enc_buf;
+    unsigned char *enc_p;
+    int ret;
+
+    if(enc_size == 0)
+        return((seg_count == 0) ? 1 : -1);
+
+    enc_buf = malloc(enc_size);
+    if(!enc_buf)
+        return(-1);
+
+    ret = darshan_log_get_mod(fd, mod_id, enc_buf, enc_size);
+    if(ret < enc_size)
+    {
+        free(enc_buf);
+        return(-1);
+    }
+
+    /* write segments are followed by read segments, and the encoded data
+     * must be consumed exactly
+     */
+    enc_p = enc_buf;
+    ret = dxt_decode_segments(&enc_p, enc_buf + enc_size, segs,
+        file_rec->write_count);
+    if(ret == 0)
+        ret = dxt_decode_segments(&enc_p, enc_buf + enc_size,
+            segs + file_rec->write_count, file_rec->read_count);
+    if(ret == 0 && enc_p != enc_buf + enc_size)
+        ret = -1;
+    free(enc_buf);
+
+    return((ret == 0) ? 1 : -1);
+}
+
+/* write a DXT file record, followed by its trace segments in the compact
+ * encoding described in darshan-dxt-log-format.h
+ */
+static int dxt_log_put_compact_file(darshan_fd fd, darshan_module_id mod_id,
+    struct dxt_file_record *file_rec, int ver)
+{
+    segment_info *segs = (segment_info *)
+        ((void *)file_rec + sizeof(struct dxt_file_record));
+    int64_t seg_count = file_rec->write_count + file_rec->read_count;
+    int64_t hdr_size = sizeof(struct dxt_file_record) + 3 * sizeof(int64_t);
+    unsigned char *rec_buf;
+    unsigned char *enc_p;
+    int64_t enc_size;
+    int64_t range[2] = {0, 0};
+    int64_t start, end;
+    int64_t i;
+    int rec_size;
+    int ret;
+
+    rec_buf = malloc(hdr_size + DXT_SEG_MAX_ENCODED_SIZE * seg_count);
+    if(!rec_buf)
+        return(-1);
+
+    /* time range of the record's segments, in the ticks they are encoded in */
+    for(i = 0; i < seg_count; i++)
+    {
+        start = DXT_SEG_TIME_TO_TICKS(segs[i].start_time);
+        end = DXT_SEG_TIME_TO_TICKS(segs[i].end_time);
+        if(i == 0 || start < range[0])
+            range[0] = start;
+        if(i == 0 || end > range[1])
+            range[1] = end;
+    }
+
+    memcpy(rec_buf, file_rec, sizeof(struct dxt_file_record));
+    enc_p = rec_buf + hdr_size;
+    enc_p = dxt_encode_segments(enc_p, segs, file_rec->write_count);
+    enc_p = dxt_encode_segments(enc_p, segs + file_rec->write_count,
+        file_rec->read_count);
+
+    rec_size = enc_p - rec_buf;
+    enc_size = rec_size - hdr_size;
+    memcpy(rec_buf + sizeof(struct dxt_file_record), &enc_size, sizeof(int64_t));
+    memcpy(rec_buf + sizeof(struct dxt_file_record) + sizeof(int64_t),
+        range, sizeof(range));
+
+    ret = darshan_log_put_mod(fd, mod_id, rec_buf, rec_size, ver);
+    free(rec_buf);
     if(ret < 0)
         return(-1);
 
@@ -285,11 +616,27 @@ static void dxt_log_print_mpiio_file_darshan(void *file_rec, char *file_name,
 {
 }
 
+static void dxt_log_print_stdio_file_darshan(void *file_rec, char *file_name,
+    char *mnt_pt, char *fs_type)
+{
+}
+
 void dxt_log_print_posix_file(void *posix_file_rec, char *file_name,
     char *mnt_pt, char *fs_type, struct lustre_record_ref *lustre_rec_ref)
 {
-    struct dxt_file_record *file_rec =
-                (struct dxt_file_record *)posix_file_rec;
+    dxt_log_print_posix_trace((struct dxt_file_record *)posix_file_rec,
+        file_name, mnt_pt, fs_type, lustre_rec_ref, NULL);
+}
+
+/* print the trace segments of a DXT POSIX file record, along with the
+ * Lustre OSTs they map to if 'lustre_rec_ref' is given, skipping segments
+ * outside the time window of 'filter' (if any)
+ */
+static void dxt_log_print_posix_trace(struct dxt_file_record *file_rec,
+    char *file_name, char *mnt_pt, char *fs_type,
+    struct lustre_record_ref *lustre_rec_ref,
+    const struct dxt_log_filter *filter)
+{
     int64_t offset;
     int64_t length;
     double start_time;
@@ -323,6 +670,9 @@ void dxt_log_print_posix_file(void *posix_file_rec, char *file_name,
     printf("# DXT, rank: %" PRId64 ", hostname: %s\n", rank, hostname);
     printf("# DXT, write_count: %" PRId64 ", read_count: %" PRId64 "\n",
                 write_count, read_count);
+    if(file_rec->write_dropped || file_rec->read_dropped)
+        printf("# DXT, write_dropped: %" PRId64 ", read_dropped: %" PRId64 "\n",
+                file_rec->write_dropped, file_rec->read_dropped);
 
     printf("# DXT, mnt_pt: %s, fs_type: %s\n", mnt_pt, fs_type);
     if (lustreFS) {
@@ -349,7 +699,7 @@ void dxt_log_print_posix_file(void *posix_file_rec, char *file_name,
     }
 
     /* Print header */
-    printf("# Module    Rank  Wt/Rd  Segment          Offset       Length    Start(s)      End(s)");
+    printf("# Module    Rank  Wt/Rd  Segment          Offset       Length    Start(s)      End(s)    Thread");
 
     if (lustreFS) {
         printf("   [OST]");
@@ -362,8 +712,10 @@ void dxt_log_print_posix_file(void *posix_file_rec, char *file_name,
         length = io_trace[i].length;
         start_time = io_trace[i].start_time;
         end_time = io_trace[i].end_time;
+        if (filter && !DXT_LOG_SEG_IN_FILTER(filter, &io_trace[i]))
+            continue;
 
-        printf("%8s%8" PRId64 "%7s%9d%16" PRId64 "%16" PRId64 "%12.4f%12.4f   ", "X_POSIX", rank, "write", i, offset, length, start_time, end_time);
+        printf("%8s%8" PRId64 "%7s%9d%16" PRId64 "%16" PRId64 "%12.4f%12.4f%10" PRId64 "   ", "X_POSIX", rank, "write", (int)(i + file_rec->write_dropped), offset, length, start_time, end_time, io_trace[i].thread_id);
 
         if (lustreFS) {
             cur_file_offset = offset;
@@ -408,8 +760,10 @@ void dxt_log_print_posix_file(void *posix_file_rec, char *file_name,
         length = io_trace[i].length;
         start_time = io_trace[i].start_time;
         end_time = io_trace[i].end_time;
+        if (filter && !DXT_LOG_SEG_IN_FILTER(filter, &io_trace[i]))
+            continue;
 
-        printf("%8s%8" PRId64 "%7s%9d%16" PRId64 "%16" PRId64 "%12.4f%12.4f   ", "X_POSIX", rank, "read", (int)(i - write_count), offset, length, start_time, end_time);
+        printf("%8s%8" PRId64 "%7s%9d%16" PRId64 "%16" PRId64 "%12.4f%12.4f%10" PRId64 "   ", "X_POSIX", rank, "read", (int)(i - write_count + file_rec->read_dropped), offset, length, start_time, end_time, io_trace[i].thread_id);
 
         if (lustreFS) {
             cur_file_offset = offset;
@@ -451,12 +805,14 @@ void dxt_log_print_posix_file(void *posix_file_rec, char *file_name,
     return;
 }
 
-void dxt_log_print_mpiio_file(void *mpiio_file_rec, char *file_name,
-    char *mnt_pt, char *fs_type)
+/* print the trace segments of a DXT file record that carries no file
+ * system layout details, labeling each segment with 'mod_label' and
+ * skipping segments outside the time window of 'filter' (if any)
+ */
+static void dxt_log_print_trace(struct dxt_file_record *file_rec,
+    char *file_name, char *mnt_pt, char *fs_type, const char *mod_label,
+    const struct dxt_log_filter *filter)
 {
-    struct dxt_file_record *file_rec =
-                (struct dxt_file_record *)mpiio_file_rec;
-
     int64_t length;
     int64_t offset;
     double start_time;
@@ -477,11 +833,14 @@ void dxt_log_print_mpiio_file(void *mpiio_file_rec, char *file_name,
     printf("# DXT, rank: %" PRId64 ", hostname: %s\n", rank, hostname);
     printf("# DXT, write_count: %" PRId64 ", read_count: %" PRId64 "\n",
                 write_count, read_count);
+    if(file_rec->write_dropped || file_rec->read_dropped)
+        printf("# DXT, write_dropped: %" PRId64 ", read_dropped: %" PRId64 "\n",
+                file_rec->write_dropped, file_rec->read_dropped);
 
     printf("# DXT, mnt_pt: %s, fs_type: %s\n", mnt_pt, fs_type);
 
     /* Print header */
-    printf("# Module    Rank  Wt/Rd  Segment          Offset       Length    Start(s)      End(s)\n");
+    printf("# Module    Rank  Wt/Rd  Segment          Offset       Length    Start(s)      End(s)    Thread\n");
 
     /* Print IO Traces information */
     for (i = 0; i < write_count; i++) {
@@ -489,8 +848,10 @@ void dxt_log_print_mpiio_file(void *mpiio_file_rec, char *file_name,
         length = io_trace[i].length;
         start_time = io_trace[i].start_time;
         end_time = io_trace[i].end_time;
+        if (filter && !DXT_LOG_SEG_IN_FILTER(filter, &io_trace[i]))
+            continue;
 
-        printf("%8s%8" PRId64 "%7s%9d%16" PRId64 "%16" PRId64 "%12.4f%12.4f\n", "X_MPIIO", rank, "write", i, offset, length, start_time, end_time);
+        printf("%8s%8" PRId64 "%7s%9d%16" PRId64 "%16" PRId64 "%12.4f%12.4f%10" PRId64 "\n", mod_label, rank, "write", (int)(i + file_rec->write_dropped), offset, length, start_time, end_time, io_trace[i].thread_id);
     }
 
     for (i = write_count; i < write_count + read_count; i++) {
@@ -498,13 +859,45 @@ void dxt_log_print_mpiio_file(void *mpiio_file_rec, char *file_name,
         length = io_trace[i].length;
         start_time = io_trace[i].start_time;
         end_time = io_trace[i].end_time;
+        if (filter && !DXT_LOG_SEG_IN_FILTER(filter, &io_trace[i]))
+            continue;
 
-        printf("%8s%8" PRId64 "%7s%9d%16" PRId64 "%16" PRId64 "%12.4f%12.4f\n", "X_MPIIO", rank, "read", (int)(i - write_count), offset, length, start_time, end_time);
+        printf("%8s%8" PRId64 "%7s%9d%16" PRId64 "%16" PRId64 "%12.4f%12.4f%10" PRId64 "\n", mod_label, rank, "read", (int)(i - write_count + file_rec->read_dropped), offset, length, start_time, end_time, io_trace[i].thread_id);
     }
 
     return;
 }
 
+void dxt_log_print_mpiio_file(void *mpiio_file_rec, char *file_name,
+    char *mnt_pt, char *fs_type)
+{
+    dxt_log_print_trace((struct dxt_file_record *)mpiio_file_rec,
+        file_name, mnt_pt, fs_type, "X_MPIIO", NULL);
+}
+
+void dxt_log_print_stdio_file(void *stdio_file_rec, char *file_name,
+    char *mnt_pt, char *fs_type)
+{
+    dxt_log_print_trace((struct dxt_file_record *)stdio_file_rec,
+        file_name, mnt_pt, fs_type, "X_STDIO", NULL);
+}
+
+void dxt_log_print_filtered_file(darshan_module_id mod_id, void *file_rec,
+    char *file_name, char *mnt_pt, char *fs_type,
+    struct lustre_record_ref *lustre_rec_ref,
+    const struct dxt_log_filter *filter)
+{
+    if(mod_id == DXT_POSIX_MOD)
+        dxt_log_print_posix_trace((struct dxt_file_record *)file_rec,
+            file_name, mnt_pt, fs_type, lustre_rec_ref, filter);
+    else if(mod_id == DXT_MPIIO_MOD)
+        dxt_log_print_trace((struct dxt_file_record *)file_rec,
+            file_name, mnt_pt, fs_type, "X_MPIIO", filter);
+    else if(mod_id == DXT_STDIO_MOD)
+        dxt_log_print_trace((struct dxt_file_record *)file_rec,
+            file_name, mnt_pt, fs_type, "X_STDIO", filter);
+}
+
 /*
  * Local variables:
  *  c-indent-level: 4
@@ -10,10 +10,46 @@
 
 extern struct darshan_mod_logutil_funcs dxt_posix_logutils;
 extern struct darshan_mod_logutil_funcs dxt_mpiio_logutils;
+extern struct darshan_mod_logutil_funcs dxt_stdio_logutils;
 
 void dxt_log_print_posix_file(void *file_rec, char *file_name,
         char *mnt_pt, char *fs_type, struct lustre_record_ref *rec_ref);
 void dxt_log_print_mpiio_file(void *file_rec,
         char *file_name, char *mnt_pt, char *fs_type);
+void dxt_log_print_stdio_file(void *file_rec,
+        char *file_name, char *mnt_pt, char *fs_type);
+
+/* selection of DXT trace data to read: records of ranks within any of
+ * 'rank_range_count' inclusive ranges stored in 'rank_ranges' as
+ * {first0, last0, first1, last1, ...} (all ranks if NULL), and segments
+ * overlapping the window from 'start_time' to 'end_time' seconds (no upper
+ * bound if 'end_time' is negative)
+ */
+struct dxt_log_filter
+{
+    int64_t *rank_ranges;
+    int rank_range_count;
+    double start_time;
+    double end_time;
+};
+
+#define DXT_LOG_SEG_IN_FILTER(__filter, __seg) \
+    ((__seg)->end_time >= (__filter)->start_time && \
+     ((__filter)->end_time < 0 || (__seg)->start_time <= (__filter)->end_time))
+
+/* read the next record of DXT module 'mod_id' matching 'filter' into
+ * '*file_rec' (allocating it if NULL); records of other ranks, and records
+ * with no segments in the time window, are skipped without decoding their
+ * segments when the log stores per-record time ranges. returns 1 if a
+ * record was read, 0 at the end of the module's data, and -1 on error.
+ */
+int dxt_log_get_filtered_file(darshan_fd fd, darshan_module_id mod_id,
+        const struct dxt_log_filter *filter, void **file_rec);
+/* print a DXT record read with 'filter', omitting segments outside its
+ * time window
+ */
+void dxt_log_print_filtered_file(darshan_module_id mod_id, void *file_rec,
+        char *file_name, char *mnt_pt, char *fs_type,
+        struct lustre_record_ref *rec_ref, const struct dxt_log_filter *filter);
 
 #endif
@@ -18,15 +18,97 @@
 #include <stdlib.h>
 #include <getopt.h>
 #include <assert.h>
+#include <limits.h>
 
 #include "uthash-1.9.2/src/uthash.h"
 
 #include "darshan-logutils.h"
+#include "darshan-arrow.h"
 
 #define OPTION_SHOW_INCOMPLETE  (1 << 7)  /* show what we have, even if log is incomplete */
+#define OPTION_ARROW (1 << 8)  /* write traces as Arrow tables */
+#define OPTION_START (1 << 9)  /* only show segments ending at or after a time */
+#define OPTION_END (1 << 10)  /* only show segments starting at or before a time */
+#define OPTION_RANKS (1 << 11)  /* only show records of the given ranks */
+#define OPTION_FILTER (OPTION_START | OPTION_END | OPTION_RANKS)
+
+/* maximum number of key/value pairs describing the job in Arrow tables */
+#define ARROW_MAX_META (8 + DARSHAN_JOB_METADATA_LEN / 2)
+
+/* columns of the Arrow tables of each DXT module: one row per trace
+ * segment, and one row per traced record
+ */
+enum
+{
+    SEG_ID,
+    SEG_RANK,
+    SEG_OP,
+    SEG_SEGMENT,
+    SEG_OFFSET,
+    SEG_LENGTH,
+    SEG_START_TIME,
+    SEG_END_TIME,
+    SEG_THREAD_ID,
+    SEG_NUM_COLS
+};
+
+static const struct darshan_arrow_column seg_cols[SEG_NUM_COLS] =
+{
+    {"id", DARSHAN_ARROW_UINT64},
+    {"rank", DARSHAN_ARROW_INT64},
+    {"op", DARSHAN_ARROW_UTF8},
+    {"segment", DARSHAN_ARROW_INT64},
+    {"offset", DARSHAN_ARROW_INT64},
+    {"length", DARSHAN_ARROW_INT64},
+    {"start_time", DARSHAN_ARROW_DOUBLE},
+    {"end_time", DARSHAN_ARROW_DOUBLE},
+    {"thread_id", DARSHAN_ARROW_INT64},
+};
+
+enum
+{
+    REC_ID,
+    REC_RANK,
+    REC_HOSTNAME,
+    REC_FILE_NAME,
+    REC_MOUNT_PT,
+    REC_FS_TYPE,
+    REC_WRITE_COUNT,
+    REC_READ_COUNT,
+    REC_WRITE_DROPPED,
+    REC_READ_DROPPED,
+    REC_NUM_COLS
+};
+
+static const struct darshan_arrow_column rec_cols[REC_NUM_COLS] =
+{
+    {"id", DARSHAN_ARROW_UINT64},
+    {"rank", DARSHAN_ARROW_INT64},
+    {"hostname", DARSHAN_ARROW_UTF8},
+    {"file_name", DARSHAN_ARROW_UTF8},
+    {"mount_pt", DARSHAN_ARROW_UTF8},
+    {"fs_type", DARSHAN_ARROW_UTF8},
+    {"write_count", DARSHAN_ARROW_INT64},
+    {"read_count", DARSHAN_ARROW_INT64},
+    {"write_dropped", DARSHAN_ARROW_INT64},
+    {"read_dropped", DARSHAN_ARROW_INT64},
+};
 
 static int usage (char *exename);
-static int parse_args (int argc, char **argv, char **filename);
+static int parse_args (int argc, char **argv, char **filename, char **arrow_dir,
+    struct dxt_log_filter *filter);
+static int parse_ranks(const char *arg, struct dxt_log_filter *filter);
+static int select_next_block(darshan_fd fd, int mod_id,
+    struct darshan_log_block *blocks, int block_count, int *block,
+    const struct dxt_log_filter *filter);
+static void arrow_add_meta(char **meta, int *nmeta, const char *key,
+    const char *value);
+static darshan_arrow_writer arrow_create_table(const char *dir, int mod_id,
+    const char *suffix, const struct darshan_arrow_column *cols, int ncols,
+    char **meta, int nmeta);
+static int arrow_put_trace(darshan_arrow_writer seg_w, darshan_arrow_writer rec_w,
+    struct dxt_file_record *file_rec, char *file_name, char *mnt_pt,
+    char *fs_type, const struct dxt_log_filter *filter);
 
 int main(int argc, char **argv)
 {
@@ -50,8 +132,22 @@ int main(int argc, char **argv)
     struct lustre_record_ref *lustre_rec_ref, *tmp_lustre_rec_ref;
     struct lustre_record_ref *lustre_rec_hash = NULL;
     char *mod_buf = NULL;
-
-    mask = parse_args(argc, argv, &filename);
+    char *arrow_dir = NULL;
+    char *arrow_meta[2 * ARROW_MAX_META];
+    char arrow_val[64];
+    int arrow_nmeta = 0;
+    int arrow_ret = 0;
+    darshan_arrow_writer seg_w = NULL;
+    darshan_arrow_writer rec_w = NULL;
+    struct dxt_log_filter filter = {NULL, 0, 0.0, -1.0};
+    struct dxt_log_filter *filter_p = NULL;
+    struct darshan_log_block *blocks;
+    int block_count;
+    int block;
+
+    mask = parse_args(argc, argv, &filename, &arrow_dir, &filter);
+    if (mask & OPTION_FILTER)
+        filter_p = &filter;
 
     fd = darshan_log_open(filename);
     if (!fd)
@@ -117,6 +213,24 @@ int main(int argc, char **argv)
     printf("# nprocs: %" PRId64 "\n", job.nprocs);
     darshan_log_get_job_runtime(fd, job, &run_time);
     printf("# run time: %.4lf\n", run_time);
+    if(mask & OPTION_ARROW)
+    {
+        /* describe the job in the metadata of each Arrow table */
+        arrow_add_meta(arrow_meta, &arrow_nmeta, "darshan_log_version", fd->version);
+        arrow_add_meta(arrow_meta, &arrow_nmeta, "exe", tmp_string);
+        snprintf(arrow_val, sizeof(arrow_val), "%" PRId64, job.uid);
+        arrow_add_meta(arrow_meta, &arrow_nmeta, "uid", arrow_val);
+        snprintf(arrow_val, sizeof(arrow_val), "%" PRId64, job.jobid);
+        arrow_add_meta(arrow_meta, &arrow_nmeta, "jobid", arrow_val);
+        snprintf(arrow_val, sizeof(arrow_val), "%" PRId64, job.start_time_sec);
+        arrow_add_meta(arrow_meta, &arrow_nmeta, "start_time", arrow_val);
+        snprintf(arrow_val, sizeof(arrow_val), "%" PRId64, job.end_time_sec);
+        arrow_add_meta(arrow_meta, &arrow_nmeta, "end_time", arrow_val);
+        snprintf(arrow_val, sizeof(arrow_val), "%" PRId64, job.nprocs);
+        arrow_add_meta(arrow_meta, &arrow_nmeta, "nprocs", arrow_val);
+        snprintf(arrow_val, sizeof(arrow_val), "%.4lf", run_time);
+        arrow_add_meta(arrow_meta, &arrow_nmeta, "run_time", arrow_val);
+    }
     for (token = strtok_r(job.metadata, "\n", &save);
         token != NULL;
         token = strtok_r(NULL, "\n", &save))
@@ -136,6 +250,8 @@ int main(int argc, char **argv)
         value[0] = '\0';
         value++;
         printf("# metadata: %s = %s\n", key, value);
+        if(mask & OPTION_ARROW)
+            arrow_add_meta(arrow_meta, &arrow_nmeta, key, value);
     }
 
     /* print breakdown of each log file region's contribution to file size */
@@ -171,7 +287,8 @@ int main(int argc, char **argv)
     }
 
     /* just exit if there is no DXT data in this log file */
-    if(fd->mod_map[DXT_POSIX_MOD].len == 0 && fd->mod_map[DXT_MPIIO_MOD].len == 0)
+    if(fd->mod_map[DXT_POSIX_MOD].len == 0 && fd->mod_map[DXT_MPIIO_MOD].len == 0 &&
+        fd->mod_map[DXT_STDIO_MOD].len == 0)
     {
         printf("\n# no DXT module data available for this Darshan log.\n");
         goto cleanup;
@@ -199,7 +316,7 @@ int main(int argc, char **argv)
             continue;
         }
 
-        if (i == DXT_POSIX_MOD || i == DXT_MPIIO_MOD) {
+        if (i == DXT_POSIX_MOD || i == DXT_MPIIO_MOD || i == DXT_STDIO_MOD) {
             printf("\n# ***************************************************\n");
             printf("# %s module data\n", darshan_module_names[i]);
             printf("# ***************************************************\n");
@@ -247,8 +364,44 @@ int main(int argc, char **argv)
 
         }
 
+        if((mask & OPTION_ARROW) && i != DARSHAN_LUSTRE_MOD)
+        {
+            seg_w = arrow_create_table(arrow_dir, i, "", seg_cols,
+                SEG_NUM_COLS, arrow_meta, arrow_nmeta);
+            if(seg_w)
+                rec_w = arrow_create_table(arrow_dir, i, "_records", rec_cols,
+                    REC_NUM_COLS, arrow_meta, arrow_nmeta);
+            if(!rec_w)
+            {
+                fprintf(stderr, "Error: unable to create Arrow tables for %s module.\n",
+                    darshan_module_names[i]);
+                if(seg_w)
+                    darshan_arrow_close(seg_w);
+                seg_w = NULL;
+                ret = -1;
+                goto cleanup;
+            }
+        }
+
+        /* when selecting ranks, only read the blocks of those ranks if
+         * the log has a block index
+         */
+        block = -1;
+        block_count = 0;
+        if ((mask & OPTION_RANKS) && i != DARSHAN_LUSTRE_MOD &&
+            darshan_log_get_blocks(fd, i, &blocks, &block_count) == 0 &&
+            block_count > 0)
+        {
+            if (select_next_block(fd, i, blocks, block_count, &block,
+                filter_p) < 0)
+            {
+                ret = -1;
+                goto cleanup;
+            }
+        }
+
         /* loop over each of this module's records and print them */
-        while(1)
+        while(block < block_count)
         {
             char *mnt_pt = NULL;
             char *fs_type = NULL;
@@ -262,7 +415,8 @@ int main(int argc, char **argv)
                 ret = mod_logutils[i]->log_get_record(fd,
                         (void **)&(lustre_rec_ref->rec));
             } else {
-                ret = mod_logutils[i]->log_get_record(fd, (void **)&mod_buf);
+                ret = dxt_log_get_filtered_file(fd, i, filter_p,
+                        (void **)&mod_buf);
             }
 
             if (ret < 1)
@@ -273,6 +427,17 @@ int main(int argc, char **argv)
                         darshan_module_names[i]);
                     goto cleanup;
                 }
+                if (block >= 0)
+                {
+                    /* move on to the next selected block */
+                    if (select_next_block(fd, i, blocks, block_count, &block,
+                        filter_p) < 0)
+                    {
+                        ret = -1;
+                        goto cleanup;
+                    }
+                    continue;
+                }
                 break;
             }
 
@@ -310,27 +475,60 @@ int main(int argc, char **argv)
             if (!fs_type)
                 fs_type = "UNKNOWN";
 
-            if (i == DXT_POSIX_MOD) {
+            if (seg_w) {
+                if(arrow_put_trace(seg_w, rec_w, (struct dxt_file_record *)mod_buf,
+                    rec_name, mnt_pt, fs_type, filter_p) < 0)
+                {
+                    arrow_ret = -1;
+                    break;
+                }
+            } else {
                 /* look for corresponding lustre record and print DXT data */
-                HASH_FIND(hlink, lustre_rec_hash, &(base_rec->id),
-                        sizeof(darshan_record_id), lustre_rec_ref);
+                lustre_rec_ref = NULL;
+                if (i == DXT_POSIX_MOD)
+                    HASH_FIND(hlink, lustre_rec_hash, &(base_rec->id),
+                            sizeof(darshan_record_id), lustre_rec_ref);
 
-                dxt_log_print_posix_file(mod_buf, rec_name,
-                        mnt_pt, fs_type, lustre_rec_ref);
-            } else if (i == DXT_MPIIO_MOD){
-                dxt_log_print_mpiio_file(mod_buf, rec_name,
-                        mnt_pt, fs_type);
+                dxt_log_print_filtered_file(i, mod_buf, rec_name,
+                        mnt_pt, fs_type, lustre_rec_ref, filter_p);
             }
 
             free(mod_buf);
             mod_buf = NULL;
         }
+        if (block >= 0)
+            darshan_log_select_block(fd, i, -1);
+
+        if (seg_w)
+        {
+            if(darshan_arrow_close(seg_w) < 0)
+                arrow_ret = -1;
+            if(darshan_arrow_close(rec_w) < 0)
+                arrow_ret = -1;
+            seg_w = rec_w = NULL;
+            if(arrow_ret < 0)
+            {
+                fprintf(stderr, "Error: failed to write Arrow tables for %s module.\n",
+                    darshan_module_names[i]);
+                ret = -1;
+                goto cleanup;
+            }
+        }
     }
 
     ret = 0;
 
 cleanup:
+    if (seg_w)
+    {
+        darshan_arrow_close(seg_w);
+        darshan_arrow_close(rec_w);
+    }
     darshan_log_close(fd);
+    free(mod_buf);
+    free(filter.rank_ranges);
+    for (i = 0; i < 2 * arrow_nmeta; i++)
+        free(arrow_meta[i]);
 
     /* free record hash data */
     HASH_ITER(hlink, name_hash, ref, tmp_ref)
@@ -357,13 +555,171 @@ cleanup:
     return(ret);
 }
 
-static int parse_args (int argc, char **argv, char **filename)
+static void arrow_add_meta(char **meta, int *nmeta, const char *key,
+    const char *value)
+{
+    if (*nmeta == ARROW_MAX_META)
+        return;
+
+    meta[2 * *nmeta] = strdup(key);
+    meta[2 * *nmeta + 1] = strdup(value);
+    if (meta[2 * *nmeta] && meta[2 * *nmeta + 1])
+        (*nmeta)++;
+    else
+    {
+        free(meta[2 * *nmeta]);
+        free(meta[2 * *nmeta + 1]);
+    }
+}
+
+/* create <dir>/<module><suffix>.arrow */
+static darshan_arrow_writer arrow_create_table(const char *dir, int mod_id,
+    const char *suffix, const struct darshan_arrow_column *cols, int ncols,
+    char **meta, int nmeta)
+{
+    char path[PATH_MAX];
+
+    snprintf(path, sizeof(path), "%s/%s%s.arrow", dir,
+        darshan_module_names[mod_id], suffix);
+
+    return (darshan_arrow_create(path, cols, ncols,
+        (const char * const *)meta, nmeta));
+}
+
+static int arrow_put_trace(darshan_arrow_writer seg_w, darshan_arrow_writer rec_w,
+    struct dxt_file_record *file_rec, char *file_name, char *mnt_pt,
+    char *fs_type, const struct dxt_log_filter *filter)
+{
+    segment_info *io_trace = (segment_info *)
+        ((void *)file_rec + sizeof(struct dxt_file_record));
+    int64_t i;
+
+    darshan_arrow_put_uint64(rec_w, REC_ID, file_rec->base_rec.id);
+    darshan_arrow_put_int64(rec_w, REC_RANK, file_rec->base_rec.rank);
+    darshan_arrow_put_utf8(rec_w, REC_HOSTNAME, file_rec->hostname);
+    darshan_arrow_put_utf8(rec_w, REC_FILE_NAME, file_name ? file_name : "");
+    darshan_arrow_put_utf8(rec_w, REC_MOUNT_PT, mnt_pt);
+    darshan_arrow_put_utf8(rec_w, REC_FS_TYPE, fs_type);
+    darshan_arrow_put_int64(rec_w, REC_WRITE_COUNT, file_rec->write_count);
+    darshan_arrow_put_int64(rec_w, REC_READ_COUNT, file_rec->read_count);
+    darshan_arrow_put_int64(rec_w, REC_WRITE_DROPPED, file_rec->write_dropped);
+    darshan_arrow_put_int64(rec_w, REC_READ_DROPPED, file_rec->read_dropped);
+    if (darshan_arrow_end_row(rec_w) < 0)
+        return (-1);
+
+    /* write segments precede read segments, and segments are numbered
+     * from the first one kept in the trace
+     */
+    for (i = 0; i < file_rec->write_count + file_rec->read_count; i++)
+    {
+        int is_write = i < file_rec->write_count;
+
+        if (filter && !DXT_LOG_SEG_IN_FILTER(filter, &io_trace[i]))
+            continue;
+        darshan_arrow_put_uint64(seg_w, SEG_ID, file_rec->base_rec.id);
+        darshan_arrow_put_int64(seg_w, SEG_RANK, file_rec->base_rec.rank);
+        darshan_arrow_put_utf8(seg_w, SEG_OP, is_write ? "write" : "read");
+        darshan_arrow_put_int64(seg_w, SEG_SEGMENT, is_write ?
+            i + file_rec->write_dropped :
+            i - file_rec->write_count + file_rec->read_dropped);
+        darshan_arrow_put_int64(seg_w, SEG_OFFSET, io_trace[i].offset);
+        darshan_arrow_put_int64(seg_w, SEG_LENGTH, io_trace[i].length);
+        darshan_arrow_put_double(seg_w, SEG_START_TIME, io_trace[i].start_time);
+        darshan_arrow_put_double(seg_w, SEG_END_TIME, io_trace[i].end_time);
+        darshan_arrow_put_int64(seg_w, SEG_THREAD_ID, io_trace[i].thread_id);
+        if (darshan_arrow_end_row(seg_w) < 0)
+            return (-1);
+    }
+
+    return (0);
+}
+
+/* select the next block of module 'mod_id' after '*block' written by a rank
+ * accepted by 'filter', setting '*block' to 'block_count' if there is none
+ */
+static int select_next_block(darshan_fd fd, int mod_id,
+    struct darshan_log_block *blocks, int block_count, int *block,
+    const struct dxt_log_filter *filter)
+{
+    int i, j;
+
+    for (j = *block + 1; j < block_count; j++)
+    {
+        if (blocks[j].rank < 0)
+            break;
+        for (i = 0; i < filter->rank_range_count; i++)
+        {
+            if (blocks[j].rank >= filter->rank_ranges[2 * i] &&
+                blocks[j].rank <= filter->rank_ranges[2 * i + 1])
+                break;
+        }
+        if (i < filter->rank_range_count)
+            break;
+    }
+
+    *block = j;
+    if (j == block_count)
+        return (darshan_log_select_block(fd, mod_id, -1));
+
+    return (darshan_log_select_block(fd, mod_id, j));
+}
+
+/* parse a comma-separated list of ranks and inclusive rank ranges, such
+ * as "0-3,7"
+ */
+static int parse_ranks(const char *arg, struct dxt_log_filter *filter)
+{
+    const char *p = arg;
+    char *end;
+    int64_t first, last;
+    int64_t *tmp;
+
+    while (1)
+    {
+        first = strtoll(p, &end, 10);
+        if (end == p || first < 0)
+            return (-1);
+        last = first;
+        if (*end == '-')
+        {
+            p = end + 1;
+            last = strtoll(p, &end, 10);
+            if (end == p || last < first)
+                return (-1);
+        }
+
+        tmp = realloc(filter->rank_ranges,
+            2 * (filter->rank_range_count + 1) * sizeof(*tmp));
+        if (!tmp)
+            return (-1);
+        filter->rank_ranges = tmp;
+        filter->rank_ranges[2 * filter->rank_range_count] = first;
+        filter->rank_ranges[2 * filter->rank_range_count + 1] = last;
+        filter->rank_range_count++;
+
+        if (*end == '\0')
+            break;
+        if (*end != ',')
+            return (-1);
+        p = end + 1;
+    }
+
+    return (0);
+}
+
+static int parse_args (int argc, char **argv, char **filename, char **arrow_dir,
+    struct dxt_log_filter *filter)
 {
     int index;
     int mask;
+    char *check;
     static struct option long_opts[] =
     {
         {"show-incomplete", 0, NULL, OPTION_SHOW_INCOMPLETE},
+        {"arrow", 1, NULL, OPTION_ARROW},
+        {"start", 1, NULL, OPTION_START},
+        {"end", 1, NULL, OPTION_END},
+        {"ranks", 1, NULL, OPTION_RANKS},
         {"help",  0, NULL, 0},
         {0, 0, 0, 0}
     };
@@ -381,6 +737,34 @@ static int parse_args (int argc, char **argv, char **filename)
             case OPTION_SHOW_INCOMPLETE:
                 mask |= c;
                 break;
+            case OPTION_ARROW:
+                mask |= c;
+                *arrow_dir = optarg;
+                break;
+            case OPTION_START:
+            case OPTION_END:
+            {
+                double t = strtod(optarg, &check);
+                if (optarg == check || *check != '\0' || t < 0)
+                {
+                    fprintf(stderr, "Error: invalid time value %s.\n", optarg);
+                    exit(1);
+                }
+                mask |= c;
+                if (c == OPTION_START)
+                    filter->start_time = t;
+                else
+                    filter->end_time = t;
+                break;
+            }
+            case OPTION_RANKS:
+                if (parse_ranks(optarg, filter) < 0)
+                {
+                    fprintf(stderr, "Error: invalid rank list %s.\n", optarg);
+                    exit(1);
+                }
+                mask |= c;
+                break;
             case 0:
             case '?':
             default:
@@ -405,6 +789,12 @@ static int usage (char *exename)
 {
     fprintf(stderr, "Usage: %s [options] <filename>\n", exename);
     fprintf(stderr, "    --show-incomplete : display results even if log is incomplete\n");
+    fprintf(stderr, "    --arrow <dir> : write each module's trace segments and traced records\n");
+    fprintf(stderr, "                    to <dir>/<module>.arrow and <dir>/<module>_records.arrow\n");
+    fprintf(stderr, "                    (Arrow IPC file format) instead of printing them\n");
+    fprintf(stderr, "    --start <sec> : only show segments ending at or after <sec> seconds\n");
+    fprintf(stderr, "    --end <sec> : only show segments starting at or before <sec> seconds\n");
+    fprintf(stderr, "    --ranks <list> : only show records of the given ranks (e.g., 0-3,7)\n");
 
     exit(1);
 }
@@ -0,0 +1,966 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+/* darshan-gen-log generates synthetic Darshan logs of arbitrary size, for
+ * testing the performance of the log utilities (and of tools built on them)
+ * at scales that are impractical to reach by running real jobs.
+ *
+ * The logs are written with the regular logutils put APIs, so that they are
+ * indistinguishable in format from logs written by the runtime.  Their
+ * content follows a simple model of an HPC job: most files are accessed by a
+ * single rank (file-per-process), a configurable fraction are shared by all
+ * ranks (and so reduced into a single record, as the runtime does), file
+ * sizes and transfer sizes are drawn from log-scale distributions, and a
+ * fraction of the files are accessed through MPI-IO as well as POSIX.  The
+ * output is a deterministic function of the options and the seed.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "darshan-util-config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <unistd.h>
+
+#include "uthash-1.9.2/src/uthash.h"
+
+#include "darshan-logutils.h"
+
+extern uint32_t darshan_hashlittle(const void *key, size_t length, uint32_t initval);
+
+/* the time at which every generated job starts */
+#define GEN_START_TIME 1700000000
+
+/* access modes of a generated file */
+#define GEN_READ  0x1
+#define GEN_WRITE 0x2
+
+struct gen_opts
+{
+    char *outlog_path;
+    enum darshan_comp_type comp_type;
+    int64_t nprocs;
+    int64_t records;
+    double shared_frac;
+    double mpiio_frac;
+    int64_t stdio_records;
+    int64_t dxt_segments;
+    int64_t heatmap_bins;
+    int64_t runtime;
+    uint64_t seed;
+};
+
+/* everything needed to regenerate the records of one POSIX (and MPI-IO)
+ * file; the names are regenerated from the index of the file
+ */
+struct gen_file
+{
+    darshan_record_id id;
+    int64_t rank;   /* -1 for files shared by all ranks */
+    int64_t xfer;   /* dominant transfer size */
+    int64_t size;   /* bytes read and/or written, per rank for shared files */
+    double start;   /* open time, relative to the job start */
+    double bw;      /* per-rank bandwidth in bytes/second */
+    int mode;       /* GEN_READ and/or GEN_WRITE */
+    int mpiio;      /* set if also accessed through MPI-IO */
+};
+
+static uint64_t gen_state;
+
+static uint64_t gen_rand(void)
+{
+    /* xorshift64* */
+    gen_state ^= gen_state >> 12;
+    gen_state ^= gen_state << 25;
+    gen_state ^= gen_state >> 27;
+    return(gen_state * 2685821657736338717ULL);
+}
+
+/* uniform in [0, 1) */
+static double gen_uniform(void)
+{
+    return((gen_rand() >> 11) * (1.0 / 9007199254740992.0));
+}
+
+/* roughly log-uniform in [lo, hi), for lo a power of two */
+static int64_t gen_log_uniform(int64_t lo, int64_t hi)
+{
+    int64_t v;
+    int doublings = 0;
+
+    for(v = lo; v < hi / 2; v *= 2)
+        doublings++;
+    v = lo << (gen_rand() % (doublings + 1));
+    v += (int64_t)(gen_uniform() * v);
+    return((v < hi) ? v : hi - 1);
+}
+
+/* a transfer size, weighted towards the sizes applications commonly use */
+static int64_t gen_xfer_size(void)
+{
+    static const int64_t sizes[] = {
+        100, 4096, 8192, 65536, 262144, 1048576, 1048576, 4194304,
+        4194304, 16777216};
+
+    return(sizes[gen_rand() % (sizeof(sizes) / sizeof(sizes[0]))]);
+}
+
+/* index of the access size histogram bucket for an access of 'sz' bytes */
+static int gen_size_bucket(int64_t sz)
+{
+    static const int64_t bounds[] = {
+        100, 1024, 10240, 102400, 1048576, 4194304, 10485760,
+        104857600, 1073741824};
+    int i;
+
+    for(i = 0; i < (int)(sizeof(bounds) / sizeof(bounds[0])); i++)
+        if(sz <= bounds[i])
+            return(i);
+    return(i);
+}
+
+static darshan_record_id gen_record_id(const char *name)
+{
+    uint32_t hi = darshan_hashlittle(name, strlen(name), 0);
+    uint32_t lo = darshan_hashlittle(name, strlen(name), hi);
+
+    return(((uint64_t)hi << 32) | lo);
+}
+
+static void gen_file_name(int64_t i, const struct gen_file *f, char *buf,
+    size_t len)
+{
+    if(f->rank < 0)
+        snprintf(buf, len, "/scratch/gen/run/shared/data.%06lld.h5",
+            (long long)i);
+    else
+        snprintf(buf, len, "/scratch/gen/run/rank%06lld/file.%06lld.dat",
+            (long long)f->rank, (long long)i);
+}
+
+static void gen_stdio_name(int64_t i, int64_t nprocs, char *buf, size_t len)
+{
+    if(i == 0)
+        snprintf(buf, len, "<STDOUT>");
+    else if(i == 1)
+        snprintf(buf, len, "<STDERR>");
+    else
+        snprintf(buf, len, "/home/user/gen/logs/rank%06lld.%06lld.log",
+            (long long)((i - 2) % nprocs), (long long)i);
+}
+
+void usage(char *exename)
+{
+    fprintf(stderr, "Usage: %s --output <output_path> [options]\n", exename);
+    fprintf(stderr, "This utility generates a synthetic Darshan log, for performance testing of log tools.\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "\t--output\t(REQUIRED) Full path of the output darshan log file.\n");
+    fprintf(stderr, "\t--nprocs\tNumber of ranks in the job (default: 1024).\n");
+    fprintf(stderr, "\t--records\tNumber of POSIX records (default: 10000).\n");
+    fprintf(stderr, "\t--shared\tFraction of the files shared by all ranks (default: 0.1).\n");
+    fprintf(stderr, "\t--mpiio\t\tFraction of the files also accessed through MPI-IO (default: 0.5).\n");
+    fprintf(stderr, "\t--stdio\t\tNumber of STDIO records (default: records / 10).\n");
+    fprintf(stderr, "\t--dxt-segments\tDXT trace segments per rank and file (default: 0, no DXT data).\n");
+    fprintf(stderr, "\t--heatmap-bins\tHeatmap bins per rank and API (default: 0, no heatmaps).\n");
+    fprintf(stderr, "\t--runtime\tJob runtime in seconds (default: 3600).\n");
+    fprintf(stderr, "\t--seed\t\tSeed of the random number generator (default: 1).\n");
+    fprintf(stderr, "\t--bzip2\t\tUse bzip2 compression instead of zlib.\n");
+    fprintf(stderr, "\t--zstd\t\tUse zstd compression instead of zlib.\n");
+
+    exit(1);
+}
+
+static int64_t parse_count(const char *arg, const char *what, int64_t min)
+{
+    char *check;
+    int64_t val = strtoll(arg, &check, 10);
+
+    if(arg == check || *check != '\0' || val < min)
+    {
+        fprintf(stderr, "Error: invalid %s.\n", what);
+        exit(1);
+    }
+    return(val);
+}
+
+static double parse_fraction(const char *arg, const char *what)
+{
+    char *check;
+    double val = strtod(arg, &check);
+
+    if(arg == check || *check != '\0' || val < 0.0 || val > 1.0)
+    {
+        fprintf(stderr, "Error: invalid %s (must be between 0 and 1).\n", what);
+        exit(1);
+    }
+    return(val);
+}
+
+void parse_args(int argc, char **argv, struct gen_opts *opts)
+{
+    int index;
+    int stdio_set = 0;
+    static struct option long_opts[] =
+    {
+        {"output", required_argument, NULL, 'o'},
+        {"nprocs", required_argument, NULL, 'n'},
+        {"records", required_argument, NULL, 'r'},
+        {"shared", required_argument, NULL, 's'},
+        {"mpiio", required_argument, NULL, 'm'},
+        {"stdio", required_argument, NULL, 'S'},
+        {"dxt-segments", required_argument, NULL, 'd'},
+        {"heatmap-bins", required_argument, NULL, 'H'},
+        {"runtime", required_argument, NULL, 't'},
+        {"seed", required_argument, NULL, 'x'},
+        {"bzip2", no_argument, NULL, 'b'},
+        {"zstd", no_argument, NULL, 'z'},
+        {0, 0, 0, 0}
+    };
+
+    memset(opts, 0, sizeof(*opts));
+    opts->comp_type = DARSHAN_ZLIB_COMP;
+    opts->nprocs = 1024;
+    opts->records = 10000;
+    opts->shared_frac = 0.1;
+    opts->mpiio_frac = 0.5;
+    opts->runtime = 3600;
+    opts->seed = 1;
+
+    while(1)
+    {
+        int c = getopt_long(argc, argv, "", long_opts, &index);
+
+        if(c == -1) break;
+
+        switch(c)
+        {
+            case 'o':
+                opts->outlog_path = optarg;
+                break;
+            case 'n':
+                opts->nprocs = parse_count(optarg, "number of ranks", 1);
+                break;
+            case 'r':
+                opts->records = parse_count(optarg, "number of records", 0);
+                break;
+            case 's':
+                opts->shared_frac = parse_fraction(optarg, "shared fraction");
+                break;
+            case 'm':
+                opts->mpiio_frac = parse_fraction(optarg, "MPI-IO fraction");
+                break;
+            case 'S':
+                opts->stdio_records = parse_count(optarg,
+                    "number of STDIO records", 0);
+                stdio_set = 1;
+                break;
+            case 'd':
+                opts->dxt_segments = parse_count(optarg,
+                    "number of DXT segments", 0);
+                break;
+            case 'H':
+                opts->heatmap_bins = parse_count(optarg,
+                    "number of heatmap bins", 0);
+                break;
+            case 't':
+                opts->runtime = parse_count(optarg, "runtime", 1);
+                break;
+            case 'x':
+                opts->seed = parse_count(optarg, "seed", 0);
+                break;
+            case 'b':
+                opts->comp_type = DARSHAN_BZIP2_COMP;
+                break;
+            case 'z':
+                opts->comp_type = DARSHAN_ZSTD_COMP;
+                break;
+            case '?':
+            default:
+                usage(argv[0]);
+                break;
+        }
+    }
+
+    if(opts->outlog_path == NULL || optind != argc)
+    {
+        usage(argv[0]);
+    }
+
+    if(!stdio_set)
+        opts->stdio_records = opts->records / 10;
+
+    return;
+}
+
+/* decide the access pattern of each file, up front, since the name records
+ * have to be written before any module data
+ */
+static struct gen_file *gen_files(const struct gen_opts *opts)
+{
+    struct gen_file *files;
+    char name[256];
+    int64_t i;
+
+    files = calloc(opts->records ? opts->records : 1, sizeof(*files));
+    if(!files)
+        return(NULL);
+
+    for(i = 0; i < opts->records; i++)
+    {
+        struct gen_file *f = &files[i];
+        double u = gen_uniform();
+
+        f->rank = (gen_uniform() < opts->shared_frac) ? -1 : i % opts->nprocs;
+        f->mode = (u < 0.4) ? GEN_WRITE : ((u < 0.8) ? GEN_READ :
+            GEN_READ | GEN_WRITE);
+        f->mpiio = (gen_uniform() < opts->mpiio_frac);
+        f->xfer = gen_xfer_size();
+        /* small files are read or written in a single access */
+        f->size = gen_log_uniform(4096, (f->rank < 0) ? 1LL << 32 : 1LL << 30);
+        if(f->size < f->xfer)
+            f->xfer = f->size;
+        f->bw = gen_log_uniform(64 << 20, 4LL << 30);
+        /* the job spends its first 80% opening files */
+        f->start = gen_uniform() * opts->runtime * 0.8;
+
+        gen_file_name(i, f, name, sizeof(name));
+        f->id = gen_record_id(name);
+    }
+
+    return(files);
+}
+
+static int add_name(struct darshan_name_record_ref **hash, const char *name,
+    darshan_record_id id)
+{
+    struct darshan_name_record_ref *ref;
+
+    HASH_FIND(hlink, *hash, &id, sizeof(darshan_record_id), ref);
+    if(ref)
+        return(0);
+
+    ref = malloc(sizeof(*ref));
+    if(!ref)
+        return(-1);
+    ref->name_record = malloc(sizeof(struct darshan_name_record) + strlen(name));
+    if(!ref->name_record)
+    {
+        free(ref);
+        return(-1);
+    }
+    ref->name_record->id = id;
+    strcpy(ref->name_record->name, name);
+    HASH_ADD(hlink, *hash, name_record->id, sizeof(darshan_record_id), ref);
+
+    return(0);
+}
+
+/* time spent reading or writing 'bytes' bytes of file 'f' by one rank */
+static double io_time(const struct gen_file *f, int64_t bytes)
+{
+    return(bytes / f->bw);
+}
+
+static void gen_posix_record(const struct gen_opts *opts,
+    const struct gen_file *f, struct darshan_posix_file *rec)
+{
+    int64_t nranks = (f->rank < 0) ? opts->nprocs : 1;
+    int64_t ops = (f->size + f->xfer - 1) / f->xfer;
+    double t = f->start;
+    double meta = 0.0005 + gen_uniform() * 0.002;
+    double rank_time = 0;
+
+    /* each file has its own random state, so that its records can be
+     * regenerated identically for every module that needs them
+     */
+    gen_state = (f->id ^ (opts->seed * 0x9E3779B97F4A7C15ULL)) | 1;
+
+    memset(rec, 0, sizeof(*rec));
+    rec->base_rec.id = f->id;
+    rec->base_rec.rank = f->rank;
+
+    rec->counters[POSIX_OPENS] = nranks * (1 + (gen_rand() % 4 == 0));
+    rec->counters[POSIX_STATS] = nranks * (gen_rand() % 3);
+    rec->counters[POSIX_MODE] = 0644;
+    rec->counters[POSIX_MEM_ALIGNMENT] = 8;
+    rec->counters[POSIX_FILE_ALIGNMENT] = 1048576;
+    rec->counters[POSIX_FILE_NOT_ALIGNED] =
+        (f->xfer % 1048576) ? nranks * ops : 0;
+    rec->fcounters[POSIX_F_OPEN_START_TIMESTAMP] = t;
+    t += meta;
+    rec->fcounters[POSIX_F_OPEN_END_TIMESTAMP] = t;
+    rec->fcounters[POSIX_F_META_TIME] = nranks * meta;
+
+    if(f->mode & GEN_WRITE)
+    {
+        double wt = io_time(f, f->size);
+
+        rec->counters[POSIX_WRITES] = nranks * ops;
+        rec->counters[POSIX_BYTES_WRITTEN] = nranks * f->size;
+        rec->counters[POSIX_MAX_BYTE_WRITTEN] = nranks * f->size - 1;
+        rec->counters[POSIX_CONSEC_WRITES] = (f->rank < 0) ? 0 : ops - 1;
+        rec->counters[POSIX_SEQ_WRITES] = nranks * (ops - 1);
+        rec->counters[POSIX_SIZE_WRITE_0_100 + gen_size_bucket(f->xfer)] =
+            nranks * ops;
+        rec->counters[POSIX_MAX_WRITE_TIME_SIZE] = f->xfer;
+        rec->fcounters[POSIX_F_WRITE_START_TIMESTAMP] = t;
+        t += wt;
+        rec->fcounters[POSIX_F_WRITE_END_TIMESTAMP] = t;
+        rec->fcounters[POSIX_F_WRITE_TIME] = nranks * wt;
+        rec->fcounters[POSIX_F_MAX_WRITE_TIME] =
+            io_time(f, f->xfer) * (1 + gen_uniform() * 9);
+        rank_time += wt;
+    }
+    if(f->mode & GEN_READ)
+    {
+        double rt = io_time(f, f->size);
+
+        rec->counters[POSIX_READS] = nranks * ops;
+        rec->counters[POSIX_BYTES_READ] = nranks * f->size;
+        rec->counters[POSIX_MAX_BYTE_READ] = nranks * f->size - 1;
+        rec->counters[POSIX_CONSEC_READS] = (f->rank < 0) ? 0 : ops - 1;
+        rec->counters[POSIX_SEQ_READS] = nranks * (ops - 1);
+        rec->counters[POSIX_SIZE_READ_0_100 + gen_size_bucket(f->xfer)] =
+            nranks * ops;
+        rec->counters[POSIX_MAX_READ_TIME_SIZE] = f->xfer;
+        rec->fcounters[POSIX_F_READ_START_TIMESTAMP] = t;
+        t += rt;
+        rec->fcounters[POSIX_F_READ_END_TIMESTAMP] = t;
+        rec->fcounters[POSIX_F_READ_TIME] = nranks * rt;
+        rec->fcounters[POSIX_F_MAX_READ_TIME] =
+            io_time(f, f->xfer) * (1 + gen_uniform() * 9);
+        rank_time += rt;
+    }
+    if(f->mode == (GEN_READ | GEN_WRITE))
+    {
+        rec->counters[POSIX_RW_SWITCHES] = nranks;
+        rec->counters[POSIX_SEEKS] = nranks;
+    }
+    if(f->rank < 0)
+    {
+        /* ranks write interleaved blocks of the shared file */
+        rec->counters[POSIX_SEEKS] += nranks * ops;
+        rec->counters[POSIX_STRIDE1_STRIDE] = (nranks - 1) * f->xfer;
+        rec->counters[POSIX_STRIDE1_COUNT] = nranks * (ops - 1);
+    }
+
+    rec->counters[POSIX_ACCESS1_ACCESS] = f->xfer;
+    rec->counters[POSIX_ACCESS1_COUNT] =
+        rec->counters[POSIX_READS] + rec->counters[POSIX_WRITES];
+
+    rec->fcounters[POSIX_F_CLOSE_START_TIMESTAMP] = t;
+    t += meta / 2;
+    rec->fcounters[POSIX_F_CLOSE_END_TIMESTAMP] = t;
+
+    rank_time += meta;
+    if(f->rank < 0)
+    {
+        /* the fastest and slowest ranks are within 30% of the average */
+        rec->counters[POSIX_FASTEST_RANK] = gen_rand() % nranks;
+        rec->counters[POSIX_SLOWEST_RANK] = gen_rand() % nranks;
+        rec->counters[POSIX_FASTEST_RANK_BYTES] = f->size *
+            ((f->mode == (GEN_READ | GEN_WRITE)) ? 2 : 1);
+        rec->counters[POSIX_SLOWEST_RANK_BYTES] =
+            rec->counters[POSIX_FASTEST_RANK_BYTES];
+        rec->fcounters[POSIX_F_FASTEST_RANK_TIME] =
+            rank_time * (0.7 + gen_uniform() * 0.3);
+        rec->fcounters[POSIX_F_SLOWEST_RANK_TIME] =
+            rank_time * (1.0 + gen_uniform() * 0.3);
+        rec->fcounters[POSIX_F_VARIANCE_RANK_TIME] =
+            rank_time * rank_time * 0.01 * gen_uniform();
+        rec->fcounters[POSIX_F_VARIANCE_RANK_BYTES] = 0;
+    }
+    else
+    {
+        rec->counters[POSIX_FASTEST_RANK] = f->rank;
+        rec->counters[POSIX_SLOWEST_RANK] = f->rank;
+        rec->counters[POSIX_FASTEST_RANK_BYTES] =
+            rec->counters[POSIX_BYTES_READ] + rec->counters[POSIX_BYTES_WRITTEN];
+        rec->counters[POSIX_SLOWEST_RANK_BYTES] =
+            rec->counters[POSIX_FASTEST_RANK_BYTES];
+        rec->fcounters[POSIX_F_FASTEST_RANK_TIME] = rank_time;
+        rec->fcounters[POSIX_F_SLOWEST_RANK_TIME] = rank_time;
+    }
+
+    return;
+}
+
+static void gen_mpiio_record(const struct gen_opts *opts,
+    const struct darshan_posix_file *prec, const struct gen_file *f,
+    struct darshan_mpiio_file *rec)
+{
+    int64_t nranks = (f->rank < 0) ? opts->nprocs : 1;
+    /* the MPI-IO layer adds a little time on top of POSIX */
+    double slow = 1.05 + gen_uniform() * 0.1;
+
+    memset(rec, 0, sizeof(*rec));
+    rec->base_rec.id = f->id;
+    rec->base_rec.rank = f->rank;
+
+    /* shared files are accessed collectively, others independently */
+    if(f->rank < 0)
+    {
+        rec->counters[MPIIO_COLL_OPENS] = nranks;
+        rec->counters[MPIIO_COLL_WRITES] = prec->counters[POSIX_WRITES];
+        rec->counters[MPIIO_COLL_READS] = prec->counters[POSIX_READS];
+        rec->counters[MPIIO_HINTS] = nranks;
+        rec->counters[MPIIO_VIEWS] = nranks;
+    }
+    else
+    {
+        rec->counters[MPIIO_INDEP_OPENS] = 1;
+        rec->counters[MPIIO_INDEP_WRITES] = prec->counters[POSIX_WRITES];
+        rec->counters[MPIIO_INDEP_READS] = prec->counters[POSIX_READS];
+    }
+    rec->counters[MPIIO_MODE] = (f->mode & GEN_WRITE) ? 9 : 2;
+    rec->counters[MPIIO_BYTES_READ] = prec->counters[POSIX_BYTES_READ];
+    rec->counters[MPIIO_BYTES_WRITTEN] = prec->counters[POSIX_BYTES_WRITTEN];
+    rec->counters[MPIIO_RW_SWITCHES] = prec->counters[POSIX_RW_SWITCHES];
+    rec->counters[MPIIO_MAX_READ_TIME_SIZE] =
+        prec->counters[POSIX_MAX_READ_TIME_SIZE];
+    rec->counters[MPIIO_MAX_WRITE_TIME_SIZE] =
+        prec->counters[POSIX_MAX_WRITE_TIME_SIZE];
+    rec->counters[MPIIO_SIZE_READ_AGG_0_100 + gen_size_bucket(f->xfer)] =
+        prec->counters[POSIX_READS];
+    rec->counters[MPIIO_SIZE_WRITE_AGG_0_100 + gen_size_bucket(f->xfer)] =
+        prec->counters[POSIX_WRITES];
+    rec->counters[MPIIO_ACCESS1_ACCESS] = f->xfer;
+    rec->counters[MPIIO_ACCESS1_COUNT] = prec->counters[POSIX_ACCESS1_COUNT];
+    rec->counters[MPIIO_FASTEST_RANK] = prec->counters[POSIX_FASTEST_RANK];
+    rec->counters[MPIIO_FASTEST_RANK_BYTES] =
+        prec->counters[POSIX_FASTEST_RANK_BYTES];
+    rec->counters[MPIIO_SLOWEST_RANK] = prec->counters[POSIX_SLOWEST_RANK];
+    rec->counters[MPIIO_SLOWEST_RANK_BYTES] =
+        prec->counters[POSIX_SLOWEST_RANK_BYTES];
+
+    rec->fcounters[MPIIO_F_OPEN_START_TIMESTAMP] =
+        prec->fcounters[POSIX_F_OPEN_START_TIMESTAMP];
+    rec->fcounters[MPIIO_F_OPEN_END_TIMESTAMP] =
+        prec->fcounters[POSIX_F_OPEN_END_TIMESTAMP] * slow;
+    rec->fcounters[MPIIO_F_READ_START_TIMESTAMP] =
+        prec->fcounters[POSIX_F_READ_START_TIMESTAMP];
+    rec->fcounters[MPIIO_F_READ_END_TIMESTAMP] =
+        prec->fcounters[POSIX_F_READ_END_TIMESTAMP];
+    rec->fcounters[MPIIO_F_WRITE_START_TIMESTAMP] =
+        prec->fcounters[POSIX_F_WRITE_START_TIMESTAMP];
+    rec->fcounters[MPIIO_F_WRITE_END_TIMESTAMP] =
+        prec->fcounters[POSIX_F_WRITE_END_TIMESTAMP];
+    rec->fcounters[MPIIO_F_CLOSE_START_TIMESTAMP] =
+        prec->fcounters[POSIX_F_CLOSE_START_TIMESTAMP];
+    rec->fcounters[MPIIO_F_CLOSE_END_TIMESTAMP] =
+        prec->fcounters[POSIX_F_CLOSE_END_TIMESTAMP];
+    rec->fcounters[MPIIO_F_READ_TIME] = prec->fcounters[POSIX_F_READ_TIME] * slow;
+    rec->fcounters[MPIIO_F_WRITE_TIME] = prec->fcounters[POSIX_F_WRITE_TIME] * slow;
+    rec->fcounters[MPIIO_F_META_TIME] = prec->fcounters[POSIX_F_META_TIME] * slow;
+    rec->fcounters[MPIIO_F_MAX_READ_TIME] =
+        prec->fcounters[POSIX_F_MAX_READ_TIME] * slow;
+    rec->fcounters[MPIIO_F_MAX_WRITE_TIME] =
+        prec->fcounters[POSIX_F_MAX_WRITE_TIME] * slow;
+    rec->fcounters[MPIIO_F_FASTEST_RANK_TIME] =
+        prec->fcounters[POSIX_F_FASTEST_RANK_TIME] * slow;
+    rec->fcounters[MPIIO_F_SLOWEST_RANK_TIME] =
+        prec->fcounters[POSIX_F_SLOWEST_RANK_TIME] * slow;
+    rec->fcounters[MPIIO_F_VARIANCE_RANK_TIME] =
+        prec->fcounters[POSIX_F_VARIANCE_RANK_TIME];
+    if(f->rank < 0)
+    {
+        rec->fcounters[MPIIO_F_COLL_IO_TIME] =
+            (prec->fcounters[POSIX_F_READ_TIME] +
+            prec->fcounters[POSIX_F_WRITE_TIME]) * slow;
+        rec->fcounters[MPIIO_F_COLL_WAIT_TIME] =
+            rec->fcounters[MPIIO_F_COLL_IO_TIME] * (slow - 1);
+    }
+
+    return;
+}
+
+static void gen_stdio_record(const struct gen_opts *opts, int64_t i,
+    darshan_record_id id, struct darshan_stdio_file *rec)
+{
+    /* the standard streams are used by every rank; the other files are
+     * per-rank logs written a line at a time
+     */
+    int64_t nranks = (i < 2) ? opts->nprocs : 1;
+    int64_t lines = 1 + gen_rand() % 10000;
+    int64_t bytes = lines * (40 + gen_rand() % 80);
+    double start = gen_uniform() * opts->runtime * 0.1;
+    double wt = lines * 2e-6;
+
+    memset(rec, 0, sizeof(*rec));
+    rec->base_rec.id = id;
+    rec->base_rec.rank = (i < 2) ? -1 : (i - 2) % opts->nprocs;
+
+    rec->counters[STDIO_OPENS] = (i < 2) ? 0 : 1;
+    rec->counters[STDIO_WRITES] = nranks * lines;
+    rec->counters[STDIO_FLUSHES] = nranks * (lines / 100);
+    rec->counters[STDIO_BYTES_WRITTEN] = nranks * bytes;
+    rec->counters[STDIO_MAX_BYTE_WRITTEN] = nranks * bytes - 1;
+    rec->counters[STDIO_FASTEST_RANK] =
+        (i < 2) ? (int64_t)(gen_rand() % nranks) : rec->base_rec.rank;
+    rec->counters[STDIO_FASTEST_RANK_BYTES] = bytes;
+    rec->counters[STDIO_SLOWEST_RANK] =
+        (i < 2) ? (int64_t)(gen_rand() % nranks) : rec->base_rec.rank;
+    rec->counters[STDIO_SLOWEST_RANK_BYTES] = bytes;
+
+    rec->fcounters[STDIO_F_META_TIME] = (i < 2) ? 0 : 1e-4;
+    rec->fcounters[STDIO_F_WRITE_TIME] = nranks * wt;
+    rec->fcounters[STDIO_F_OPEN_START_TIMESTAMP] = (i < 2) ? 0 : start;
+    rec->fcounters[STDIO_F_OPEN_END_TIMESTAMP] = (i < 2) ? 0 : start + 1e-4;
+    rec->fcounters[STDIO_F_WRITE_START_TIMESTAMP] = start + 1e-4;
+    rec->fcounters[STDIO_F_WRITE_END_TIMESTAMP] =
+        opts->runtime * (0.9 + gen_uniform() * 0.1);
+    rec->fcounters[STDIO_F_CLOSE_START_TIMESTAMP] =
+        rec->fcounters[STDIO_F_WRITE_END_TIMESTAMP];
+    rec->fcounters[STDIO_F_CLOSE_END_TIMESTAMP] =
+        rec->fcounters[STDIO_F_CLOSE_START_TIMESTAMP] + 1e-4;
+    rec->fcounters[STDIO_F_FASTEST_RANK_TIME] = wt * 0.9;
+    rec->fcounters[STDIO_F_SLOWEST_RANK_TIME] = wt * 1.1;
+
+    return;
+}
+
+/* fill in the trace segments of one rank's accesses to file 'f', as
+ * summarized by POSIX record 'prec'.  'segs' has room for
+ * opts->dxt_segments segments.
+ */
+static void gen_dxt_record(const struct gen_opts *opts,
+    const struct gen_file *f, const struct darshan_posix_file *prec,
+    int64_t rank, struct dxt_file_record *rec)
+{
+    segment_info *segs = (segment_info *)(rec + 1);
+    int64_t ops = (f->size + f->xfer - 1) / f->xfer;
+    int64_t count, i, n = 0;
+    int pass;
+
+    memset(rec, 0, sizeof(*rec));
+    rec->base_rec.id = f->id;
+    rec->base_rec.rank = rank;
+    snprintf(rec->hostname, HOSTNAME_SIZE, "nid%05lld", (long long)(rank / 64));
+
+    /* writes first, then reads, as in the log */
+    for(pass = 0; pass < 2; pass++)
+    {
+        int mode = pass ? GEN_READ : GEN_WRITE;
+        double start = pass ? prec->fcounters[POSIX_F_READ_START_TIMESTAMP] :
+            prec->fcounters[POSIX_F_WRITE_START_TIMESTAMP];
+        double dt = io_time(f, f->xfer);
+        /* the offset of this rank's first block of the file */
+        int64_t base = (f->rank < 0) ? rank * f->xfer : 0;
+        int64_t stride = (f->rank < 0) ? opts->nprocs * f->xfer : f->xfer;
+
+        if(!(f->mode & mode))
+            continue;
+
+        count = (ops < opts->dxt_segments - n) ? ops : opts->dxt_segments - n;
+        if(!pass && (f->mode & GEN_READ) && count > 1)
+            count = (count + 1) / 2;
+        for(i = 0; i < count; i++, n++)
+        {
+            segs[n].offset = base + i * stride;
+            segs[n].length = f->xfer;
+            segs[n].start_time = start + i * dt;
+            segs[n].end_time = segs[n].start_time + dt * (0.5 + gen_uniform());
+            segs[n].thread_id = 0;
+        }
+        if(pass)
+            rec->read_count = count;
+        else
+            rec->write_count = count;
+    }
+
+    return;
+}
+
+/* fill in one rank's heatmap for an API, given the bytes and operations
+ * that rank read and wrote.  reads happen while the job starts up, and
+ * writes in checkpoint bursts every tenth of the runtime.
+ */
+static void gen_heatmap_record(const struct gen_opts *opts,
+    darshan_record_id id, int64_t rank, int64_t rbytes, int64_t wbytes,
+    int64_t rops, int64_t wops, int64_t mops,
+    struct darshan_heatmap_record *rec)
+{
+    int64_t nbins = opts->heatmap_bins;
+    int64_t rbins = (nbins + 9) / 10;
+    int64_t period = (nbins >= 10) ? nbins / 10 : 1;
+    int64_t wbins = nbins / period;
+    int64_t b;
+
+    memset(rec, 0, sizeof(*rec) + 5 * nbins * sizeof(int64_t));
+    rec->base_rec.id = id;
+    rec->base_rec.rank = rank;
+    rec->bin_width_seconds = (double)opts->runtime / nbins;
+    rec->nbins = nbins;
+    rec->flags = DARSHAN_HEATMAP_F_OP_BINS;
+    rec->write_bins = (int64_t *)(rec + 1);
+    rec->read_bins = rec->write_bins + nbins;
+    rec->write_op_bins = rec->read_bins + nbins;
+    rec->read_op_bins = rec->write_op_bins + nbins;
+    rec->meta_op_bins = rec->read_op_bins + nbins;
+
+    for(b = 0; b < nbins; b++)
+    {
+        if(b < rbins)
+        {
+            rec->read_bins[b] = rbytes / rbins + (b < rbytes % rbins);
+            rec->read_op_bins[b] = rops / rbins + (b < rops % rbins);
+        }
+        if(b % period == period - 1)
+        {
+            int64_t w = b / period;
+
+            rec->write_bins[b] = wbytes / wbins + (w < wbytes % wbins);
+            rec->write_op_bins[b] = wops / wbins + (w < wops % wbins);
+        }
+        rec->meta_op_bins[b] = mops / nbins + (b < mops % nbins);
+    }
+
+    return;
+}
+
+int main(int argc, char **argv)
+{
+    struct gen_opts opts;
+    struct gen_file *files;
+    struct darshan_job job;
+    struct darshan_mnt_info mnts[3];
+    struct darshan_name_record_ref *name_hash = NULL;
+    struct darshan_name_record_ref *ref, *tmp;
+    struct darshan_posix_file prec;
+    struct darshan_mpiio_file mrec;
+    struct darshan_stdio_file srec;
+    darshan_record_id *stdio_ids = NULL;
+    void *big_rec = NULL;
+    /* per-rank totals for the heatmaps: read and written bytes, read,
+     * write and metadata operations, for POSIX and MPI-IO; accesses to
+     * shared files are tracked separately, as they apply to every rank
+     */
+    int64_t (*totals)[2][5] = NULL;
+    int64_t shared_totals[2][5] = {{0}};
+    char name[256];
+    char exe[DARSHAN_EXE_LEN+1];
+    darshan_fd fd;
+    int64_t i, r;
+    int api;
+    int ret = -1;
+
+    parse_args(argc, argv, &opts);
+    gen_state = opts.seed * 0x9E3779B97F4A7C15ULL + 1;
+
+    files = gen_files(&opts);
+    stdio_ids = malloc((opts.stdio_records ? opts.stdio_records : 1) *
+        sizeof(*stdio_ids));
+    if(opts.heatmap_bins)
+        totals = calloc(opts.nprocs, sizeof(*totals));
+    if(opts.dxt_segments || opts.heatmap_bins)
+        big_rec = malloc(sizeof(struct dxt_file_record) +
+            opts.dxt_segments * sizeof(segment_info) +
+            sizeof(struct darshan_heatmap_record) +
+            5 * opts.heatmap_bins * sizeof(int64_t));
+    if(!files || !stdio_ids || (opts.heatmap_bins && !totals) ||
+        ((opts.dxt_segments || opts.heatmap_bins) && !big_rec))
+    {
+        fprintf(stderr, "Error: unable to allocate memory for the log.\n");
+        return(-1);
+    }
+
+    fd = darshan_log_create(opts.outlog_path, opts.comp_type, 0);
+    if(!fd)
+    {
+        fprintf(stderr, "Error: unable to create output darshan log.\n");
+        return(-1);
+    }
+
+    /* job, exe, mount and name data */
+    memset(&job, 0, sizeof(job));
+    job.uid = 1000;
+    job.start_time_sec = GEN_START_TIME;
+    job.end_time_sec = GEN_START_TIME + opts.runtime;
+    job.nprocs = opts.nprocs;
+    job.jobid = 4242;
+    snprintf(job.metadata, sizeof(job.metadata),
+        "lib_ver=%s\nh=romio_no_indep_rw=true;cb_nodes=4\n"
+        "generator=darshan-gen-log seed=%llu\n",
+        PACKAGE_VERSION, (unsigned long long)opts.seed);
+    if(darshan_log_put_job(fd, &job) < 0)
+        goto out;
+
+    snprintf(exe, sizeof(exe), "/home/user/gen/bin/app --input /scratch/gen/run "
+        "--ranks %lld", (long long)opts.nprocs);
+    if(darshan_log_put_exe(fd, exe) < 0)
+        goto out;
+
+    memset(mnts, 0, sizeof(mnts));
+    strcpy(mnts[0].mnt_path, "/scratch");
+    strcpy(mnts[0].mnt_type, "lustre");
+    strcpy(mnts[1].mnt_path, "/home");
+    strcpy(mnts[1].mnt_type, "nfs");
+    strcpy(mnts[2].mnt_path, "/");
+    strcpy(mnts[2].mnt_type, "rootfs");
+    if(darshan_log_put_mounts(fd, mnts, 3) < 0)
+        goto out;
+
+    for(i = 0; i < opts.records; i++)
+    {
+        gen_file_name(i, &files[i], name, sizeof(name));
+        if(add_name(&name_hash, name, files[i].id) < 0)
+            goto out;
+    }
+    for(i = 0; i < opts.stdio_records; i++)
+    {
+        gen_stdio_name(i, opts.nprocs, name, sizeof(name));
+        stdio_ids[i] = gen_record_id(name);
+        if(add_name(&name_hash, name, stdio_ids[i]) < 0)
+            goto out;
+    }
+    if(opts.heatmap_bins)
+    {
+        if(add_name(&name_hash, "heatmap:POSIX",
+                gen_record_id("heatmap:POSIX")) < 0 ||
+            add_name(&name_hash, "heatmap:MPIIO",
+                gen_record_id("heatmap:MPIIO")) < 0 ||
+            add_name(&name_hash, "heatmap:STDIO",
+                gen_record_id("heatmap:STDIO")) < 0)
+            goto out;
+    }
+    if(darshan_log_put_namehash(fd, name_hash) < 0)
+        goto out;
+
+    /* module data, in module id order */
+    for(i = 0; i < opts.records; i++)
+    {
+        gen_posix_record(&opts, &files[i], &prec);
+        if(mod_logutils[DARSHAN_POSIX_MOD]->log_put_record(fd, &prec) < 0)
+            goto out;
+
+        if(totals)
+        {
+            int64_t *t = (files[i].rank < 0) ? shared_totals[0] :
+                totals[files[i].rank][0];
+            int64_t ops = (files[i].size + files[i].xfer - 1) / files[i].xfer;
+
+            for(api = 0; api <= files[i].mpiio; api++)
+            {
+                t[0] += (files[i].mode & GEN_READ) ? files[i].size : 0;
+                t[1] += (files[i].mode & GEN_WRITE) ? files[i].size : 0;
+                t[2] += (files[i].mode & GEN_READ) ? ops : 0;
+                t[3] += (files[i].mode & GEN_WRITE) ? ops : 0;
+                t[4] += 2;
+                t += 5;
+            }
+        }
+    }
+
+    for(i = 0; i < opts.records; i++)
+    {
+        gen_posix_record(&opts, &files[i], &prec);
+        if(!files[i].mpiio)
+            continue;
+        gen_mpiio_record(&opts, &prec, &files[i], &mrec);
+        if(mod_logutils[DARSHAN_MPIIO_MOD]->log_put_record(fd, &mrec) < 0)
+            goto out;
+    }
+
+    for(i = 0; i < opts.stdio_records; i++)
+    {
+        gen_stdio_record(&opts, i, stdio_ids[i], &srec);
+        if(mod_logutils[DARSHAN_STDIO_MOD]->log_put_record(fd, &srec) < 0)
+            goto out;
+    }
+
+    if(opts.dxt_segments)
+    {
+        darshan_module_id dxt_mods[2] = {DXT_POSIX_MOD, DXT_MPIIO_MOD};
+        int m;
+
+        /* DXT records are not reduced, so each rank that accessed a shared
+         * file has its own trace of it
+         */
+        for(m = 0; m < 2; m++)
+        {
+            for(i = 0; i < opts.records; i++)
+            {
+                if(m == 1 && !files[i].mpiio)
+                    continue;
+                gen_posix_record(&opts, &files[i], &prec);
+                for(r = 0; r < ((files[i].rank < 0) ? opts.nprocs : 1); r++)
+                {
+                    gen_dxt_record(&opts, &files[i], &prec,
+                        (files[i].rank < 0) ? r : files[i].rank, big_rec);
+                    if(mod_logutils[dxt_mods[m]]->log_put_record(fd, big_rec) < 0)
+                        goto out;
+                }
+            }
+        }
+    }
+
+    if(opts.heatmap_bins)
+    {
+        static const char *hm_names[2] = {"heatmap:POSIX", "heatmap:MPIIO"};
+
+        for(r = 0; r < opts.nprocs; r++)
+        {
+            for(api = 0; api < 2; api++)
+            {
+                int64_t *t = totals[r][api];
+                int64_t *s = shared_totals[api];
+
+                if(!(t[4] + s[4]))
+                    continue;
+                gen_heatmap_record(&opts, gen_record_id(hm_names[api]), r,
+                    t[0] + s[0], t[1] + s[1], t[2] + s[2], t[3] + s[3],
+                    t[4] + s[4], big_rec);
+                if(mod_logutils[DARSHAN_HEATMAP_MOD]->log_put_record(fd, big_rec) < 0)
+                    goto out;
+            }
+            if(opts.stdio_records)
+            {
+                /* every rank writes to the standard streams */
+                gen_heatmap_record(&opts, gen_record_id("heatmap:STDIO"), r,
+                    0, 4096 * opts.heatmap_bins, 0, 64 * opts.heatmap_bins, 2,
+                    big_rec);
+                if(mod_logutils[DARSHAN_HEATMAP_MOD]->log_put_record(fd, big_rec) < 0)
+                    goto out;
+            }
+        }
+    }
+
+    ret = 0;
+
+out:
+    darshan_log_close(fd);
+    if(ret < 0)
+    {
+        fprintf(stderr, "Error: failed to write darshan log %s.\n",
+            opts.outlog_path);
+        unlink(opts.outlog_path);
+    }
+
+    HASH_ITER(hlink, name_hash, ref, tmp)
+    {
+        HASH_DELETE(hlink, name_hash, ref);
+        free(ref->name_record);
+        free(ref);
+    }
+    free(big_rec);
+    free(totals);
+    free(stdio_ids);
+    free(files);
+
+    return(ret);
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
@@ -180,7 +180,13 @@ exit:
     else
     {
         /* if the read was successful, do any necessary byte-swapping */
-        if(fd->swap_flag)
+        if(fd->swap_flag && fd->mod_ver[DARSHAN_H5F_MOD] == DARSHAN_H5F_VER)
+        {
+            /* current records consist only of 64-bit fields */
+            darshan_log_bswap64_array(file,
+                sizeof(struct darshan_hdf5_file) / sizeof(int64_t));
+        }
+        else if(fd->swap_flag)
         {
             DARSHAN_BSWAP64(&(file->base_rec.id));
             DARSHAN_BSWAP64(&(file->base_rec.rank));
@@ -292,7 +298,13 @@ exit:
     else
     {
         /* if the read was successful, do any necessary byte-swapping */
-        if(fd->swap_flag)
+        if(fd->swap_flag && fd->mod_ver[DARSHAN_H5D_MOD] == DARSHAN_H5D_VER)
+        {
+            /* current records consist only of 64-bit fields */
+            darshan_log_bswap64_array(ds,
+                sizeof(struct darshan_hdf5_dataset) / sizeof(int64_t));
+        }
+        else if(fd->swap_flag)
         {
             DARSHAN_BSWAP64(&(ds->base_rec.id));
             DARSHAN_BSWAP64(&(ds->base_rec.rank));
@@ -19,6 +19,7 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <stddef.h>
 
 #include "darshan-logutils.h"
 
@@ -28,6 +29,15 @@ static int darshan_log_put_heatmap_record(darshan_fd fd, void* heatmap_buf);
 static void darshan_log_print_heatmap_record(void *file_rec,
     char *file_name, char *mnt_pt, char *fs_type);
 static void darshan_log_print_heatmap_description(int ver);
+static void darshan_log_set_heatmap_bins(struct darshan_heatmap_record *rec,
+    int64_t nbins, int64_t old_nbins);
+static int darshan_log_get_sparse_heatmap_bins(darshan_fd fd,
+    struct darshan_heatmap_record *rec);
+static int64_t darshan_log_encode_sparse_heatmap_bins(
+    struct darshan_heatmap_record *rec, int64_t *buf);
+
+/* size of a version 1 heatmap record, which lacks the op count fields */
+#define DARSHAN_HEATMAP_V1_SIZE offsetof(struct darshan_heatmap_record, flags)
 
 /* structure storing each function needed for implementing the darshan
  * logutil interface. these functions are used for reading, writing, and
@@ -60,6 +70,9 @@ static int darshan_log_get_heatmap_record(darshan_fd fd, void** heatmap_buf_p)
     void* trailing;
     int ret;
     int i;
+    int narrays;
+    int base_rec_size;
+    int trailing_size;
     int total_rec_size;
 
     if(fd->mod_map[DARSHAN_HEATMAP_MOD].len == 0)
@@ -76,13 +89,19 @@ static int darshan_log_get_heatmap_record(darshan_fd fd, void** heatmap_buf_p)
     if(*heatmap_buf_p == NULL)
         rec = &static_rec;
 
-    /* read base record; it is a fixed size */
-    ret = darshan_log_get_mod(fd, DARSHAN_HEATMAP_MOD, rec,
-        sizeof(struct darshan_heatmap_record));
+    /* read base record; it is a fixed size for a given version */
+    if(fd->mod_ver[DARSHAN_HEATMAP_MOD] == 1)
+        base_rec_size = DARSHAN_HEATMAP_V1_SIZE;
+    else
+        base_rec_size = sizeof(struct darshan_heatmap_record);
+    ret = darshan_log_get_mod(fd, DARSHAN_HEATMAP_MOD, rec, base_rec_size);
     if(ret < 0)
         return(-1);
-    else if(ret < sizeof(struct darshan_heatmap_record))
+    else if(ret < base_rec_size)
         return(0);
+    /* version 1 records never carry op count bins */
+    if(fd->mod_ver[DARSHAN_HEATMAP_MOD] == 1)
+        rec->flags = 0;
 
     /* do byte swapping if necessary */
     if(fd->swap_flag)
@@ -91,6 +110,7 @@ static int darshan_log_get_heatmap_record(darshan_fd fd, void** heatmap_buf_p)
         DARSHAN_BSWAP64(&rec->base_rec.rank);
         DARSHAN_BSWAP64(&rec->bin_width_seconds);
         DARSHAN_BSWAP64(&rec->nbins);
+        DARSHAN_BSWAP64(&rec->flags);
     }
     /* If this is the first heatmap record that we have seen for this log,
      * then record the initial bin count and width.  We may need to correct
@@ -103,8 +123,13 @@ static int darshan_log_get_heatmap_record(darshan_fd fd, void** heatmap_buf_p)
 
     /* if buffer was provided by caller, then it is implied that it is
      * DEF_MOD_BUF_SIZE bytes in size.  Make sure it is big enough, or if we
-     * are allocating the buffer malloc enough size */
-    total_rec_size = sizeof(struct darshan_heatmap_record) + rec->nbins*2*sizeof(int64_t);
+     * are allocating the buffer malloc enough size.  Leave room for one
+     * extra bin per array in case the record needs to be corrected below.
+     */
+    narrays = DARSHAN_HEATMAP_NARRAYS(rec->flags);
+    trailing_size = rec->nbins*narrays*sizeof(int64_t);
+    total_rec_size = sizeof(struct darshan_heatmap_record) +
+        (rec->nbins+1)*narrays*sizeof(int64_t);
     if(*heatmap_buf_p)
     {
         if(total_rec_size > DEF_MOD_BUF_SIZE)
@@ -122,22 +147,32 @@ static int darshan_log_get_heatmap_record(darshan_fd fd, void** heatmap_buf_p)
         rec = *heatmap_buf_p;
     }
 
-    /* set pointer for trailing data */
-    trailing = (void*)((intptr_t)(*heatmap_buf_p) + sizeof(*rec));
-    ret = darshan_log_get_mod(fd, DARSHAN_HEATMAP_MOD, trailing,
-        rec->nbins*2*sizeof(int64_t));
-    if(ret < rec->nbins*2*sizeof(int64_t))
-        return(-1);
-
-    /* set pointers and byteswap trailing data */
-    rec->write_bins = (int64_t*)((uintptr_t)rec + sizeof(*rec));
-    rec->read_bins = (int64_t*)((uintptr_t)rec + sizeof(*rec) + rec->nbins*sizeof(uint64_t));
-    if(fd->swap_flag)
+    if(rec->flags & DARSHAN_HEATMAP_F_SPARSE)
+    {
+        /* expand sparsely stored bins; records are always returned with
+         * dense bin arrays
+         */
+        ret = darshan_log_get_sparse_heatmap_bins(fd, rec);
+        if(ret < 0)
+            return(-1);
+        rec->flags &= ~DARSHAN_HEATMAP_F_SPARSE;
+        darshan_log_set_heatmap_bins(rec, rec->nbins, rec->nbins);
+    }
+    else
     {
-        for(i=0; i<rec->nbins; i++)
+        /* set pointer for trailing data */
+        trailing = (void*)((intptr_t)(*heatmap_buf_p) + sizeof(*rec));
+        ret = darshan_log_get_mod(fd, DARSHAN_HEATMAP_MOD, trailing,
+            trailing_size);
+        if(ret < trailing_size)
+            return(-1);
+
+        /* set pointers and byteswap trailing data */
+        darshan_log_set_heatmap_bins(rec, rec->nbins, rec->nbins);
+        if(fd->swap_flag)
         {
-            DARSHAN_BSWAP64(&rec->write_bins[i]);
-            DARSHAN_BSWAP64(&rec->read_bins[i]);
+            for(i=0; i<rec->nbins*narrays; i++)
+                DARSHAN_BSWAP64(&rec->write_bins[i]);
         }
     }
     /* On the fly correction if we find a record that is off by one in the
@@ -153,42 +188,213 @@ static int darshan_log_get_heatmap_record(darshan_fd fd, void** heatmap_buf_p)
         rec->nbins == (fd->first_heatmap_record_nbins + 1))
     {
         /* One too many bins in this record.  Just drop one. */
-        /* note that this will leave a hole between the write bins array and
-         * read bins array; that's fine because we have already set pointers
-         * to the correct start of each one.
-         */
-        rec->nbins--;
+        darshan_log_set_heatmap_bins(rec, rec->nbins-1, rec->nbins);
     }
     else if(rec->bin_width_seconds == fd->first_heatmap_record_bin_width_seconds &&
         rec->nbins == (fd->first_heatmap_record_nbins - 1))
     {
         /* One too few bins; need to add one */
-
-        /* we have to shift the read bins down because the data is
-         * contiguous in memory
-         */
-        memmove(&rec->read_bins[1], &rec->read_bins[0],
-                rec->nbins*sizeof(uint64_t));
-        /* zero out values in new bins */
-        rec->write_bins[rec->nbins] = 0;
-        rec->read_bins[rec->nbins] = 0;
-        rec->nbins++;
+        darshan_log_set_heatmap_bins(rec, rec->nbins+1, rec->nbins);
     }
 
     return(1);
 }
 
+/* read the sparsely stored bins of heatmap record 'rec' from log file
+ * descriptor 'fd', expanding them into the dense bin arrays trailing the
+ * record.  Return 0 on success, -1 on failure.
+ */
+static int darshan_log_get_sparse_heatmap_bins(darshan_fd fd,
+    struct darshan_heatmap_record *rec)
+{
+    int64_t *bins = (int64_t*)((uintptr_t)rec + sizeof(*rec));
+    int narrays = DARSHAN_HEATMAP_NARRAYS(rec->flags);
+    int64_t *entries;
+    int64_t *entry;
+    int64_t nnz;
+    int64_t index;
+    int entries_size;
+    int ret;
+    int i,k;
+
+    ret = darshan_log_get_mod(fd, DARSHAN_HEATMAP_MOD, &nnz, sizeof(nnz));
+    if(ret < (int)sizeof(nnz))
+        return(-1);
+    if(fd->swap_flag)
+        DARSHAN_BSWAP64(&nnz);
+    if(nnz < 0 || nnz > rec->nbins)
+    {
+        fprintf(stderr, "Error: invalid sparse HEATMAP record bin count (got %" PRId64 ")\n", nnz);
+        return(-1);
+    }
+
+    memset(bins, 0, rec->nbins*narrays*sizeof(int64_t));
+    if(nnz == 0)
+        return(0);
+
+    entries_size = DARSHAN_HEATMAP_SPARSE_SIZE(rec->flags, nnz) - sizeof(nnz);
+    entries = malloc(entries_size);
+    if(!entries)
+        return(-1);
+    ret = darshan_log_get_mod(fd, DARSHAN_HEATMAP_MOD, entries, entries_size);
+    if(ret < entries_size)
+    {
+        free(entries);
+        return(-1);
+    }
+
+    entry = entries;
+    for(i=0; i<nnz; i++)
+    {
+        if(fd->swap_flag)
+        {
+            for(k=0; k<narrays+1; k++)
+                DARSHAN_BSWAP64(&entry[k]);
+        }
+        index = *entry++;
+        if(index < 0 || index >= rec->nbins)
+        {
+            fprintf(stderr, "Error: invalid sparse HEATMAP record bin index (got %" PRId64 ")\n", index);
+            free(entries);
+            return(-1);
+        }
+        for(k=0; k<narrays; k++)
+            bins[k*rec->nbins + index] = *entry++;
+    }
+
+    free(entries);
+    return(0);
+}
+
+/* encode the bins of heatmap record 'rec' in the sparse log layout into
+ * 'buf', returning the encoded size in bytes
+ */
+static int64_t darshan_log_encode_sparse_heatmap_bins(
+    struct darshan_heatmap_record *rec, int64_t *buf)
+{
+    int64_t *arrays[DARSHAN_HEATMAP_NARRAYS(DARSHAN_HEATMAP_F_OP_BINS)];
+    int narrays = DARSHAN_HEATMAP_NARRAYS(rec->flags);
+    int64_t *entry = &buf[1];
+    int64_t nnz = 0;
+    int64_t i;
+    int k;
+
+    arrays[0] = rec->write_bins;
+    arrays[1] = rec->read_bins;
+    if(rec->flags & DARSHAN_HEATMAP_F_OP_BINS)
+    {
+        arrays[2] = rec->write_op_bins;
+        arrays[3] = rec->read_op_bins;
+        arrays[4] = rec->meta_op_bins;
+    }
+
+    for(i=0; i<rec->nbins; i++)
+    {
+        for(k=0; k<narrays; k++)
+        {
+            if(arrays[k][i])
+                break;
+        }
+        if(k == narrays)
+            continue;
+
+        *entry++ = i;
+        for(k=0; k<narrays; k++)
+            *entry++ = arrays[k][i];
+        nnz++;
+    }
+    buf[0] = nnz;
+
+    return(DARSHAN_HEATMAP_SPARSE_SIZE(rec->flags, nnz));
+}
+
+/* lay out the bin arrays trailing heatmap record 'rec' contiguously with
+ * 'nbins' bins each, moving them from a layout of 'old_nbins' bins each.
+ * Bins dropped from the end of each array are discarded and bins added to
+ * the end of each array are zeroed.
+ */
+static void darshan_log_set_heatmap_bins(struct darshan_heatmap_record *rec,
+    int64_t nbins, int64_t old_nbins)
+{
+    int64_t *bins = (int64_t*)((uintptr_t)rec + sizeof(*rec));
+    int64_t *arrays[DARSHAN_HEATMAP_NARRAYS(DARSHAN_HEATMAP_F_OP_BINS)];
+    int64_t keep = (nbins < old_nbins) ? nbins : old_nbins;
+    int narrays = DARSHAN_HEATMAP_NARRAYS(rec->flags);
+    int i;
+
+    /* the arrays themselves are contiguous, so shift them in the direction
+     * that does not overwrite arrays that have yet to be moved
+     */
+    if(nbins < old_nbins)
+    {
+        for(i=1; i<narrays; i++)
+            memmove(&bins[i*nbins], &bins[i*old_nbins], keep*sizeof(int64_t));
+    }
+    else if(nbins > old_nbins)
+    {
+        for(i=narrays-1; i>0; i--)
+            memmove(&bins[i*nbins], &bins[i*old_nbins], keep*sizeof(int64_t));
+    }
+    for(i=0; i<narrays; i++)
+    {
+        arrays[i] = &bins[i*nbins];
+        if(nbins > old_nbins)
+            memset(&arrays[i][keep], 0, (nbins-keep)*sizeof(int64_t));
+    }
+
+    rec->nbins = nbins;
+    rec->write_bins = arrays[0];
+    rec->read_bins = arrays[1];
+    if(rec->flags & DARSHAN_HEATMAP_F_OP_BINS)
+    {
+        rec->write_op_bins = arrays[2];
+        rec->read_op_bins = arrays[3];
+        rec->meta_op_bins = arrays[4];
+    }
+    else
+    {
+        rec->write_op_bins = NULL;
+        rec->read_op_bins = NULL;
+        rec->meta_op_bins = NULL;
+    }
+
+    return;
+}
+
 /* write the heatmap record stored in 'heatmap_buf' to log file descriptor 'fd'.
  * Return 0 on success, -1 on failure
  */
 static int darshan_log_put_heatmap_record(darshan_fd fd, void* heatmap_buf)
 {
     struct darshan_heatmap_record *rec = (struct darshan_heatmap_record *)heatmap_buf;
+    struct darshan_heatmap_record *sparse_rec;
+    int64_t dense_size;
+    int64_t sparse_size;
     int ret;
 
+    dense_size = sizeof(struct darshan_heatmap_record) +
+        rec->nbins*DARSHAN_HEATMAP_NARRAYS(rec->flags)*sizeof(int64_t);
+
+    /* store the bins sparsely if that is smaller, as the runtime does */
+    sparse_rec = malloc(sizeof(*rec) +
+        DARSHAN_HEATMAP_SPARSE_SIZE(rec->flags, rec->nbins));
+    if(!sparse_rec)
+        return(-1);
+    memcpy(sparse_rec, rec, sizeof(*rec));
+    sparse_size = darshan_log_encode_sparse_heatmap_bins(rec,
+        (int64_t*)((uintptr_t)sparse_rec + sizeof(*rec)));
+
     /* append heatmap record to darshan log file */
-    ret = darshan_log_put_mod(fd, DARSHAN_HEATMAP_MOD, rec,
-        sizeof(struct darshan_heatmap_record) + rec->nbins*2*sizeof(int64_t), DARSHAN_HEATMAP_VER);
+    if(sizeof(*rec) + sparse_size < dense_size)
+    {
+        sparse_rec->flags |= DARSHAN_HEATMAP_F_SPARSE;
+        ret = darshan_log_put_mod(fd, DARSHAN_HEATMAP_MOD, sparse_rec,
+            sizeof(*rec) + sparse_size, DARSHAN_HEATMAP_VER);
+    }
+    else
+        ret = darshan_log_put_mod(fd, DARSHAN_HEATMAP_MOD, rec,
+            dense_size, DARSHAN_HEATMAP_VER);
+    free(sparse_rec);
     if(ret < 0)
         return(-1);
 
@@ -227,6 +433,36 @@ static void darshan_log_print_heatmap_record(void *file_rec, char *file_name,
             heatmap_rec->write_bins[i], file_name, mnt_pt, fs_type);
     }
 
+    if(!(heatmap_rec->flags & DARSHAN_HEATMAP_F_OP_BINS))
+        return;
+
+    for(i=0; i<heatmap_rec->nbins; i++)
+    {
+        snprintf(counter_name_buffer, 256, "HEATMAP_READ_OPS_BIN_%d", i);
+        DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_HEATMAP_MOD],
+            heatmap_rec->base_rec.rank, heatmap_rec->base_rec.id,
+            counter_name_buffer,
+            heatmap_rec->read_op_bins[i], file_name, mnt_pt, fs_type);
+    }
+
+    for(i=0; i<heatmap_rec->nbins; i++)
+    {
+        snprintf(counter_name_buffer, 256, "HEATMAP_WRITE_OPS_BIN_%d", i);
+        DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_HEATMAP_MOD],
+            heatmap_rec->base_rec.rank, heatmap_rec->base_rec.id,
+            counter_name_buffer,
+            heatmap_rec->write_op_bins[i], file_name, mnt_pt, fs_type);
+    }
+
+    for(i=0; i<heatmap_rec->nbins; i++)
+    {
+        snprintf(counter_name_buffer, 256, "HEATMAP_META_OPS_BIN_%d", i);
+        DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_HEATMAP_MOD],
+            heatmap_rec->base_rec.rank, heatmap_rec->base_rec.id,
+            counter_name_buffer,
+            heatmap_rec->meta_op_bins[i], file_name, mnt_pt, fs_type);
+    }
+
     return;
 }
 
@@ -236,10 +472,74 @@ static void darshan_log_print_heatmap_description(int ver)
     printf("\n# description of heatmap counters:\n");
     printf("#   HEATMAP_F_BIN_WIDTH_SECONDS: time duration of each heatmap bin\n");
     printf("#   HEATMAP_{READ|WRITE}_BIN_{*}: number of bytes read or written within specified heatmap bin\n");
+    if(ver >= 2)
+        printf("#   HEATMAP_{READ|WRITE|META}_OPS_BIN_{*}: number of read, write, or metadata operations started within specified heatmap bin (only present if op counts were enabled at runtime)\n");
+    printf("#   NOTE: if heatmaps were summed across ranks at runtime (DARSHAN_HEATMAP_REDUCE), each rank's record holds the heatmap of its whole node, and a rank -1 record holds the heatmap of the whole job\n");
 
     return;
 }
 
+/* read up to 'max_records' of the next heatmap records of log file
+ * descriptor 'fd' into dense arrays, one entry per record: the record id,
+ * rank, bin width, bin count and flags go to 'ids', 'ranks', 'bin_widths',
+ * 'rec_nbins' and 'flags', and the write, read, write op, read op and
+ * metadata op bins go to 'bins', which holds a row of 'nbins' bins per
+ * array (DARSHAN_HEATMAP_NARRAYS(DARSHAN_HEATMAP_F_OP_BINS) rows) per
+ * record.  Records with more than 'nbins' bins are truncated, while bins
+ * past the end of shorter records and op count bins of records without
+ * them are zero.  The number of records read is returned in 'n'; fewer
+ * than 'max_records' are read only at the end of the module's data.
+ * Return 0 on success, -1 on failure.
+ */
+int heatmap_log_get_bins(darshan_fd fd, int64_t nbins, int max_records,
+    darshan_record_id *ids, int64_t *ranks, double *bin_widths,
+    int64_t *rec_nbins, int64_t *flags, int64_t *bins, int *n)
+{
+    struct darshan_heatmap_record *rec;
+    int max_narrays = DARSHAN_HEATMAP_NARRAYS(DARSHAN_HEATMAP_F_OP_BINS);
+    int64_t *rec_bins;
+    int64_t *row;
+    int64_t keep;
+    void *buf;
+    int narrays;
+    int ret;
+    int i;
+
+    *n = 0;
+    while(*n < max_records)
+    {
+        /* records vary in size, so let the reader allocate each one */
+        buf = NULL;
+        ret = darshan_log_get_heatmap_record(fd, &buf);
+        if(ret < 1)
+        {
+            free(buf);
+            return((ret < 0) ? -1 : 0);
+        }
+        rec = buf;
+
+        ids[*n] = rec->base_rec.id;
+        ranks[*n] = rec->base_rec.rank;
+        bin_widths[*n] = rec->bin_width_seconds;
+        rec_nbins[*n] = rec->nbins;
+        flags[*n] = rec->flags;
+
+        /* the bin arrays trail the record contiguously */
+        rec_bins = (int64_t*)((uintptr_t)rec + sizeof(*rec));
+        narrays = DARSHAN_HEATMAP_NARRAYS(rec->flags);
+        keep = (rec->nbins < nbins) ? rec->nbins : nbins;
+        row = &bins[(int64_t)(*n)*max_narrays*nbins];
+        memset(row, 0, max_narrays*nbins*sizeof(int64_t));
+        for(i=0; i<narrays; i++)
+            memcpy(&row[i*nbins], &rec_bins[i*rec->nbins], keep*sizeof(int64_t));
+
+        free(buf);
+        (*n)++;
+    }
+
+    return(0);
+}
+
 /*
  * Local variables:
  *  c-indent-level: 4
@@ -9,4 +9,9 @@
 
 extern struct darshan_mod_logutil_funcs heatmap_logutils;
 
+/* read the next heatmap records of a log into dense per-record arrays */
+int heatmap_log_get_bins(darshan_fd fd, int64_t nbins, int max_records,
+    darshan_record_id *ids, int64_t *ranks, double *bin_widths,
+    int64_t *rec_nbins, int64_t *flags, int64_t *bins, int *n);
+
 #endif
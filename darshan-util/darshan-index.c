@@ -0,0 +1,328 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "darshan-util-config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <ftw.h>
+
+#include "darshan-archive-index.h"
+
+static const char * const metric_names[DARSHAN_INDEX_METRIC_MAX] =
+{
+    "files",
+    "bytes_read",
+    "bytes_written",
+    "total_bytes",
+    "agg_perf",
+    "agg_time",
+};
+
+/* state of an "add" command; ftw callbacks take no argument */
+static darshan_index add_idx;
+static int64_t n_added = 0;
+static int64_t n_skipped = 0;
+static int64_t n_failed = 0;
+
+void usage(char *exename)
+{
+    fprintf(stderr, "Usage: %s add <index_dir> <log_file_or_dir> [...]\n", exename);
+    fprintf(stderr, "       %s query [options] <index_dir>\n", exename);
+    fprintf(stderr, "This utility maintains an index of Darshan log files that can be queried\n");
+    fprintf(stderr, "without reading the logs. 'add' indexes the given logs and all logs under\n");
+    fprintf(stderr, "the given directories, skipping logs that are already indexed. 'query'\n");
+    fprintf(stderr, "lists the indexed jobs matching all of the given options.\n");
+    fprintf(stderr, "Query options:\n");
+    fprintf(stderr, "\t--uid <uid>\t\tJobs run by the given user id.\n");
+    fprintf(stderr, "\t--exe <string>\t\tJobs whose command line contains the given string.\n");
+    fprintf(stderr, "\t--path <prefix>\t\tJobs with a record whose name starts with the given prefix.\n");
+    fprintf(stderr, "\t--mount <prefix>\tJobs with records on a mount point starting with the given prefix.\n");
+    fprintf(stderr, "\t--fs-type <type>\tJobs with records on a file system of the given type.\n");
+    fprintf(stderr, "\t--after <seconds>\tJobs running at or after the given time (seconds since Epoch).\n");
+    fprintf(stderr, "\t--before <seconds>\tJobs running at or before the given time (seconds since Epoch).\n");
+    fprintf(stderr, "\t--min <MOD>:<metric>=<value>\n");
+    fprintf(stderr, "\t\t\t\tJobs whose total for module MOD is at least the given value.\n");
+    fprintf(stderr, "\t\t\t\tMetrics are files, bytes_read, bytes_written, total_bytes,\n");
+    fprintf(stderr, "\t\t\t\tagg_perf (MiB/s), and agg_time (seconds); values may have a\n");
+    fprintf(stderr, "\t\t\t\tK, M, G, T, or P suffix (powers of 1024).\n");
+    fprintf(stderr, "\t--count\t\t\tOnly print the number of matching jobs.\n");
+
+    exit(1);
+}
+
+static int add_walk(const char *fpath, const struct stat *sb, int typeflag)
+{
+    int ret;
+
+    if(typeflag != FTW_F) return 0;
+
+    ret = darshan_index_add_log(add_idx, fpath);
+    if(ret < 0)
+    {
+        fprintf(stderr, "Error: unable to index log file %s.\n", fpath);
+        n_failed++;
+    }
+    else if(ret == 0)
+        n_skipped++;
+    else
+        n_added++;
+
+    return 0;
+}
+
+static int add_main(int argc, char **argv)
+{
+    int i;
+
+    if(argc < 4)
+        usage(argv[0]);
+
+    add_idx = darshan_index_open(argv[2], DARSHAN_INDEX_WRITE);
+    if(!add_idx)
+    {
+        fprintf(stderr, "Error: unable to open index %s.\n", argv[2]);
+        return(-1);
+    }
+
+    for(i = 3; i < argc; i++)
+    {
+        if(ftw(argv[i], add_walk, 512) != 0)
+        {
+            fprintf(stderr, "Error: failed to walk path: %s\n", argv[i]);
+            darshan_index_close(add_idx);
+            return(-1);
+        }
+    }
+
+    if(darshan_index_commit(add_idx) < 0)
+    {
+        fprintf(stderr, "Error: unable to commit index %s.\n", argv[2]);
+        darshan_index_close(add_idx);
+        return(-1);
+    }
+
+    printf("# added %" PRId64 " logs (%" PRId64 " already indexed, %" PRId64
+        " failed), %" PRId64 " logs in index\n", n_added, n_skipped, n_failed,
+        darshan_index_job_count(add_idx));
+    darshan_index_close(add_idx);
+
+    return(n_failed ? 1 : 0);
+}
+
+static int parse_threshold(const char *arg, struct darshan_index_threshold *thr)
+{
+    char mod[32];
+    const char *metric;
+    const char *val;
+    char *end;
+    int i;
+
+    metric = strchr(arg, ':');
+    val = metric ? strchr(metric, '=') : NULL;
+    if(!val || (size_t)(metric - arg) >= sizeof(mod))
+        return(-1);
+    memcpy(mod, arg, metric - arg);
+    mod[metric - arg] = '\0';
+    metric++;
+    val++;
+
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+    {
+        if(strcmp(mod, darshan_module_names[i]) == 0)
+            break;
+    }
+    if(i == DARSHAN_KNOWN_MODULE_COUNT)
+        return(-1);
+    thr->mod_id = i;
+
+    for(i = 0; i < DARSHAN_INDEX_METRIC_MAX; i++)
+    {
+        if(strncmp(metric, metric_names[i], val - metric - 1) == 0 &&
+           metric_names[i][val - metric - 1] == '\0')
+            break;
+    }
+    if(i == DARSHAN_INDEX_METRIC_MAX)
+        return(-1);
+    thr->metric = i;
+
+    thr->min = strtod(val, &end);
+    if(end == val)
+        return(-1);
+    switch(*end)
+    {
+        case 'P': thr->min *= 1024.0;
+        /* fall through */
+        case 'T': thr->min *= 1024.0;
+        /* fall through */
+        case 'G': thr->min *= 1024.0;
+        /* fall through */
+        case 'M': thr->min *= 1024.0;
+        /* fall through */
+        case 'K': thr->min *= 1024.0;
+            end++;
+            break;
+        default:
+            break;
+    }
+    if(*end != '\0')
+        return(-1);
+
+    return(0);
+}
+
+static int print_job(darshan_index idx, const struct darshan_index_job *job,
+    void *arg)
+{
+    printf("%" PRId64 "\t%" PRId64 "\t%" PRId64 "\t%" PRId64 "\t%" PRId64 "\t%s\t%s\n",
+        job->jobid, job->uid, job->nprocs, job->start_time_sec,
+        job->end_time_sec, darshan_index_get_string(idx, job->log_path_off),
+        darshan_index_get_string(idx, job->exe_off));
+
+    return(0);
+}
+
+static int query_main(int argc, char **argv)
+{
+    struct darshan_index_query query;
+    struct darshan_index_threshold *thresholds;
+    darshan_index idx;
+    int count_only = 0;
+    int64_t matches;
+    int index;
+    char *check;
+    static struct option long_opts[] =
+    {
+        {"uid", required_argument, NULL, 'u'},
+        {"exe", required_argument, NULL, 'e'},
+        {"path", required_argument, NULL, 'p'},
+        {"mount", required_argument, NULL, 'm'},
+        {"fs-type", required_argument, NULL, 'f'},
+        {"after", required_argument, NULL, 'a'},
+        {"before", required_argument, NULL, 'b'},
+        {"min", required_argument, NULL, 't'},
+        {"count", no_argument, NULL, 'c'},
+        {0, 0, 0, 0}
+    };
+
+    darshan_index_query_init(&query);
+    thresholds = calloc(argc, sizeof(*thresholds));
+    if(!thresholds)
+        return(-1);
+    query.thresholds = thresholds;
+
+    /* skip the command name */
+    optind = 2;
+    while(1)
+    {
+        int c = getopt_long(argc, argv, "", long_opts, &index);
+
+        if(c == -1) break;
+
+        switch(c)
+        {
+            case 'u':
+                query.uid = strtoll(optarg, &check, 10);
+                if(optarg == check || query.uid < 0)
+                {
+                    fprintf(stderr, "Error: invalid user id.\n");
+                    exit(1);
+                }
+                break;
+            case 'e':
+                query.exe = optarg;
+                break;
+            case 'p':
+                query.path_prefix = optarg;
+                break;
+            case 'm':
+                query.mnt_prefix = optarg;
+                break;
+            case 'f':
+                query.mnt_type = optarg;
+                break;
+            case 'a':
+            case 'b':
+            {
+                int64_t t = strtoll(optarg, &check, 10);
+                if(optarg == check)
+                {
+                    fprintf(stderr, "Error: unable to parse time value.\n");
+                    exit(1);
+                }
+                if(c == 'a')
+                    query.start_time = t;
+                else
+                    query.end_time = t;
+                break;
+            }
+            case 't':
+                if(parse_threshold(optarg, &thresholds[query.threshold_count]) < 0)
+                {
+                    fprintf(stderr, "Error: invalid threshold %s.\n", optarg);
+                    exit(1);
+                }
+                query.threshold_count++;
+                break;
+            case 'c':
+                count_only = 1;
+                break;
+            case '?':
+            default:
+                usage(argv[0]);
+                break;
+        }
+    }
+    if(optind + 1 != argc)
+        usage(argv[0]);
+
+    idx = darshan_index_open(argv[optind], DARSHAN_INDEX_RDONLY);
+    if(!idx)
+    {
+        fprintf(stderr, "Error: unable to open index %s.\n", argv[optind]);
+        free(thresholds);
+        return(-1);
+    }
+
+    if(!count_only)
+        printf("#<jobid>\t<uid>\t<nprocs>\t<start time>\t<end time>\t<log file>\t<exe>\n");
+    matches = darshan_index_query(idx, &query, count_only ? NULL : print_job, NULL);
+    if(matches >= 0)
+        printf("# %" PRId64 " of %" PRId64 " jobs matched\n", matches,
+            darshan_index_job_count(idx));
+
+    darshan_index_close(idx);
+    free(thresholds);
+
+    return(matches < 0 ? -1 : 0);
+}
+
+int main(int argc, char **argv)
+{
+    if(argc < 2)
+        usage(argv[0]);
+
+    if(strcmp(argv[1], "add") == 0)
+        return(add_main(argc, argv));
+    else if(strcmp(argv[1], "query") == 0)
+        return(query_main(argc, argv));
+
+    usage(argv[0]);
+    return(1);
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
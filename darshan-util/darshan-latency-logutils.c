@@ -0,0 +1,282 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "darshan-util-config.h"
+#endif
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "darshan-logutils.h"
+
+/* integer counter name strings for the LATENCY module */
+#define X(a) #a,
+char *latency_counter_names[] = {
+    LATENCY_COUNTERS
+};
+
+/* floating point counter name strings for the LATENCY module */
+char *latency_f_counter_names[] = {
+    LATENCY_F_COUNTERS
+};
+#undef X
+
+/* prototypes for each of the LATENCY module's logutil functions */
+static int darshan_log_get_latency_record(darshan_fd fd, void** latency_buf_p);
+static int darshan_log_put_latency_record(darshan_fd fd, void* latency_buf);
+static void darshan_log_print_latency_record(void *file_rec,
+    char *file_name, char *mnt_pt, char *fs_type);
+static void darshan_log_print_latency_description(int ver);
+static void darshan_log_print_latency_record_diff(void *file_rec1, char *file_name1,
+    void *file_rec2, char *file_name2);
+static void darshan_log_agg_latency_records(void *rec, void *agg_rec, int init_flag);
+
+/* structure storing each function needed for implementing the darshan
+ * logutil interface. these functions are used for reading, writing, and
+ * printing module data in a consistent manner.
+ */
+struct darshan_mod_logutil_funcs latency_logutils =
+{
+    .log_get_record = &darshan_log_get_latency_record,
+    .log_put_record = &darshan_log_put_latency_record,
+    .log_print_record = &darshan_log_print_latency_record,
+    .log_print_description = &darshan_log_print_latency_description,
+    .log_print_diff = &darshan_log_print_latency_record_diff,
+    .log_agg_records = &darshan_log_agg_latency_records
+};
+
+/* retrieve a LATENCY record from log file descriptor 'fd', storing the
+ * data in the buffer address pointed to by 'latency_buf_p'. Return 1 on
+ * successful record read, 0 on no more data, and -1 on error.
+ */
+static int darshan_log_get_latency_record(darshan_fd fd, void** latency_buf_p)
+{
+    struct darshan_latency_record *rec = *((struct darshan_latency_record **)latency_buf_p);
+    int ret;
+
+    if(fd->mod_map[DARSHAN_LATENCY_MOD].len == 0)
+        return(0);
+
+    if(fd->mod_ver[DARSHAN_LATENCY_MOD] == 0 ||
+        fd->mod_ver[DARSHAN_LATENCY_MOD] > DARSHAN_LATENCY_VER)
+    {
+        fprintf(stderr, "Error: Invalid LATENCY module version number (got %d)\n",
+            fd->mod_ver[DARSHAN_LATENCY_MOD]);
+        return(-1);
+    }
+
+    if(*latency_buf_p == NULL)
+    {
+        rec = malloc(sizeof(*rec));
+        if(!rec)
+            return(-1);
+    }
+
+    /* read a LATENCY module record from the darshan log file */
+    ret = darshan_log_get_mod(fd, DARSHAN_LATENCY_MOD, rec,
+        sizeof(struct darshan_latency_record));
+
+    if(*latency_buf_p == NULL)
+    {
+        if(ret == sizeof(struct darshan_latency_record))
+            *latency_buf_p = rec;
+        else
+            free(rec);
+    }
+
+    if(ret < 0)
+        return(-1);
+    else if(ret < sizeof(struct darshan_latency_record))
+        return(0);
+    else
+    {
+        /* if the read was successful, do any necessary byte-swapping */
+        if(fd->swap_flag)
+        {
+            /* records consist only of 64-bit fields */
+            darshan_log_bswap64_array(rec,
+                sizeof(struct darshan_latency_record) / sizeof(int64_t));
+        }
+
+        return(1);
+    }
+}
+
+/* write the LATENCY record stored in 'latency_buf' to log file descriptor 'fd'.
+ * Return 0 on success, -1 on failure
+ */
+static int darshan_log_put_latency_record(darshan_fd fd, void* latency_buf)
+{
+    struct darshan_latency_record *rec = (struct darshan_latency_record *)latency_buf;
+    int ret;
+
+    /* append LATENCY record to darshan log file */
+    ret = darshan_log_put_mod(fd, DARSHAN_LATENCY_MOD, rec,
+        sizeof(struct darshan_latency_record), DARSHAN_LATENCY_VER);
+    if(ret < 0)
+        return(-1);
+
+    return(0);
+}
+
+/* print all I/O data record statistics for the given LATENCY record */
+static void darshan_log_print_latency_record(void *file_rec, char *file_name,
+    char *mnt_pt, char *fs_type)
+{
+    int i;
+    struct darshan_latency_record *latency_rec =
+        (struct darshan_latency_record *)file_rec;
+
+    /* print each of the integer and floating point counters for the LATENCY module */
+    for(i=0; i<LATENCY_NUM_INDICES; i++)
+    {
+        /* macro defined in darshan-logutils.h */
+        DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_LATENCY_MOD],
+            latency_rec->base_rec.rank, latency_rec->base_rec.id,
+            latency_counter_names[i], latency_rec->counters[i],
+            file_name, mnt_pt, fs_type);
+    }
+
+    for(i=0; i<LATENCY_F_NUM_INDICES; i++)
+    {
+        /* macro defined in darshan-logutils.h */
+        DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_LATENCY_MOD],
+            latency_rec->base_rec.rank, latency_rec->base_rec.id,
+            latency_f_counter_names[i], latency_rec->fcounters[i],
+            file_name, mnt_pt, fs_type);
+    }
+
+    return;
+}
+
+/* print out a description of the LATENCY module record fields */
+static void darshan_log_print_latency_description(int ver)
+{
+    printf("\n# description of LATENCY counters:\n");
+    printf("#   per-file histograms of operation latencies, one per operation class:\n");
+    printf("#   LATENCY_POSIX_READ_*, LATENCY_POSIX_WRITE_*: POSIX reads and writes.\n");
+    printf("#   LATENCY_POSIX_META_*: POSIX opens, stats and closes.\n");
+    printf("#   LATENCY_MPIIO_READ_*, LATENCY_MPIIO_WRITE_*: MPI-IO reads and writes.\n");
+    printf("#   LATENCY_MPIIO_META_*: MPI-IO opens and closes.\n");
+    printf("#   *_0: operations that took less than 1 microsecond.\n");
+    printf("#   *_<i>: operations that took [2^(i-1), 2^i) microseconds, for 0 < i < %d.\n",
+        LATENCY_NUM_BUCKETS - 1);
+    printf("#   *_%d: operations that took 2^%d microseconds or more.\n",
+        LATENCY_NUM_BUCKETS - 1, LATENCY_NUM_BUCKETS - 2);
+    printf("#   LATENCY_F_*_TIME: sum of the latencies counted in each histogram,\n");
+    printf("#       including overlapping operations.\n");
+
+    return;
+}
+
+/* print a diff of two LATENCY records (with the same record id) */
+static void darshan_log_print_latency_record_diff(void *file_rec1, char *file_name1,
+    void *file_rec2, char *file_name2)
+{
+    struct darshan_latency_record *file1 = (struct darshan_latency_record *)file_rec1;
+    struct darshan_latency_record *file2 = (struct darshan_latency_record *)file_rec2;
+    int i;
+
+    /* NOTE: we assume that both input records are the same module format version */
+
+    for(i=0; i<LATENCY_NUM_INDICES; i++)
+    {
+        if(!file2)
+        {
+            printf("- ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_LATENCY_MOD],
+                file1->base_rec.rank, file1->base_rec.id, latency_counter_names[i],
+                file1->counters[i], file_name1, "", "");
+
+        }
+        else if(!file1)
+        {
+            printf("+ ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_LATENCY_MOD],
+                file2->base_rec.rank, file2->base_rec.id, latency_counter_names[i],
+                file2->counters[i], file_name2, "", "");
+        }
+        else if(file1->counters[i] != file2->counters[i])
+        {
+            printf("- ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_LATENCY_MOD],
+                file1->base_rec.rank, file1->base_rec.id, latency_counter_names[i],
+                file1->counters[i], file_name1, "", "");
+            printf("+ ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_LATENCY_MOD],
+                file2->base_rec.rank, file2->base_rec.id, latency_counter_names[i],
+                file2->counters[i], file_name2, "", "");
+        }
+    }
+
+    for(i=0; i<LATENCY_F_NUM_INDICES; i++)
+    {
+        if(!file2)
+        {
+            printf("- ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_LATENCY_MOD],
+                file1->base_rec.rank, file1->base_rec.id, latency_f_counter_names[i],
+                file1->fcounters[i], file_name1, "", "");
+
+        }
+        else if(!file1)
+        {
+            printf("+ ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_LATENCY_MOD],
+                file2->base_rec.rank, file2->base_rec.id, latency_f_counter_names[i],
+                file2->fcounters[i], file_name2, "", "");
+        }
+        else if(file1->fcounters[i] != file2->fcounters[i])
+        {
+            printf("- ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_LATENCY_MOD],
+                file1->base_rec.rank, file1->base_rec.id, latency_f_counter_names[i],
+                file1->fcounters[i], file_name1, "", "");
+            printf("+ ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_LATENCY_MOD],
+                file2->base_rec.rank, file2->base_rec.id, latency_f_counter_names[i],
+                file2->fcounters[i], file_name2, "", "");
+        }
+    }
+
+    return;
+}
+
+/* aggregate the input LATENCY record 'rec' into the output record 'agg_rec' */
+static void darshan_log_agg_latency_records(void *rec, void *agg_rec, int init_flag)
+{
+    struct darshan_latency_record *latency_rec = (struct darshan_latency_record *)rec;
+    struct darshan_latency_record *agg_latency_rec = (struct darshan_latency_record *)agg_rec;
+    int i;
+
+    /* every counter sums */
+    for(i = 0; i < LATENCY_NUM_INDICES; i++)
+        agg_latency_rec->counters[i] += latency_rec->counters[i];
+
+    for(i = 0; i < LATENCY_F_NUM_INDICES; i++)
+        agg_latency_rec->fcounters[i] += latency_rec->fcounters[i];
+
+    return;
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
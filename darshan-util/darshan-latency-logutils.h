@@ -0,0 +1,18 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifndef __DARSHAN_LATENCY_LOG_UTILS_H
+#define __DARSHAN_LATENCY_LOG_UTILS_H
+
+/* declare LATENCY module counter name strings and logutil definition as
+ * extern variables so they can be used in other utilities
+ */
+extern char *latency_counter_names[];
+extern char *latency_f_counter_names[];
+
+extern struct darshan_mod_logutil_funcs latency_logutils;
+
+#endif
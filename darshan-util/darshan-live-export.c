@@ -0,0 +1,493 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "darshan-util-config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <dirent.h>
+#include <signal.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "darshan-logutils.h"
+
+/* give up on a region that keeps changing while it is copied */
+#define LIVE_COPY_TRIES 1000
+
+/* the mapping of one mmap log file being sampled */
+struct live_log
+{
+    char *path;
+    char *map;
+    size_t size;
+    struct darshan_header *hdr;
+    struct darshan_job *job;
+    struct darshan_mmap_live *live;
+};
+
+/* totals of one module in one mmap log at the time it was sampled */
+struct live_mod_sample
+{
+    int valid;
+    int64_t records;
+    int64_t bytes_read;
+    int64_t bytes_written;
+    double io_time;
+};
+
+struct live_sample
+{
+    int64_t jobid;
+    int64_t rank;
+    int64_t pid;
+    int up;
+    struct live_mod_sample mods[DARSHAN_KNOWN_MODULE_COUNT];
+};
+
+static char *copy_buf = NULL;
+static size_t copy_buf_sz = 0;
+
+void usage(char *exename)
+{
+    fprintf(stderr, "Usage: %s [options] <mmap_log_file_or_dir> [...]\n", exename);
+    fprintf(stderr, "This utility samples the mmap log files of running processes (see the\n");
+    fprintf(stderr, "--enable-mmap-logs configure option of darshan-runtime) and prints the\n");
+    fprintf(stderr, "record count, bytes read and written, and I/O time of each module in the\n");
+    fprintf(stderr, "Prometheus text format. Directories are scanned for mmap log files.\n");
+    fprintf(stderr, "The sampled processes do no work for this utility.\n");
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "\t--interval <seconds>\tSample repeatedly at the given interval, rather\n");
+    fprintf(stderr, "\t\t\t\tthan once.\n");
+    fprintf(stderr, "\t--output <file>\t\tReplace the given file with each sample, rather than\n");
+    fprintf(stderr, "\t\t\t\tprinting it.\n");
+
+    exit(1);
+}
+
+static void parse_args(int argc, char **argv, double *interval, char **output)
+{
+    int index;
+    static struct option long_opts[] =
+    {
+        {"interval", 1, NULL, 'i'},
+        {"output", 1, NULL, 'o'},
+        {"help", 0, NULL, 0},
+        {0, 0, 0, 0}
+    };
+
+    *interval = 0;
+    *output = NULL;
+
+    while(1)
+    {
+        int c = getopt_long(argc, argv, "", long_opts, &index);
+
+        if(c == -1) break;
+
+        switch(c)
+        {
+            case 'i':
+                *interval = atof(optarg);
+                if(*interval <= 0)
+                    usage(argv[0]);
+                break;
+            case 'o':
+                *output = optarg;
+                break;
+            case 0:
+            case '?':
+            default:
+                usage(argv[0]);
+                break;
+        }
+    }
+
+    if(optind >= argc)
+        usage(argv[0]);
+
+    return;
+}
+
+static int live_log_open(const char *path, struct live_log *log)
+{
+    struct stat statbuf;
+    int fd;
+
+    memset(log, 0, sizeof(*log));
+
+    fd = open(path, O_RDONLY);
+    if(fd < 0)
+        return(-1);
+    if(fstat(fd, &statbuf) < 0 || statbuf.st_size <
+        (off_t)(sizeof(struct darshan_header) + sizeof(struct darshan_job) +
+        sizeof(struct darshan_mmap_live)))
+    {
+        close(fd);
+        return(-1);
+    }
+    log->size = statbuf.st_size;
+    log->map = mmap(NULL, log->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(log->map == MAP_FAILED)
+        return(-1);
+
+    log->hdr = (struct darshan_header *)log->map;
+    log->job = (struct darshan_job *)(log->map + sizeof(struct darshan_header));
+    log->live = (struct darshan_mmap_live *)
+        (log->map + log->size - sizeof(struct darshan_mmap_live));
+
+    /* only mmap logs of a runtime that maintains the trailer can be sampled */
+    if(log->live->magic_nr != DARSHAN_MMAP_LIVE_MAGIC_NR ||
+       log->live->version != DARSHAN_MMAP_LIVE_VER ||
+       log->hdr->magic_nr != DARSHAN_MAGIC_NR)
+    {
+        munmap(log->map, log->size);
+        return(-1);
+    }
+    atomic_thread_fence(memory_order_acquire);
+    log->path = strdup(path);
+
+    return(0);
+}
+
+static void live_log_close(struct live_log *log)
+{
+    munmap(log->map, log->size);
+    free(log->path);
+    return;
+}
+
+/* copy the region of module 'mod_id' into copy_buf, retrying while the
+ * process extends it; returns the region length, or -1 if it can not be
+ * copied consistently
+ */
+static int64_t live_copy_mod_region(struct live_log *log, int mod_id)
+{
+    volatile uint64_t *gen = &log->live->mod_gen[mod_id];
+    volatile struct darshan_log_map *map = &log->hdr->mod_map[mod_id];
+    uint64_t gen1, gen2;
+    uint64_t off, len;
+    int tries;
+
+    for(tries = 0; tries < LIVE_COPY_TRIES; tries++)
+    {
+        gen1 = *gen;
+        if(gen1 & 1)
+            continue;
+        atomic_thread_fence(memory_order_acquire);
+
+        off = map->off;
+        len = map->len;
+        if(off > log->size || len > log->size - off)
+            return(-1);
+        if(len > copy_buf_sz)
+        {
+            char *tmp = realloc(copy_buf, len);
+            if(!tmp)
+                return(-1);
+            copy_buf = tmp;
+            copy_buf_sz = len;
+        }
+        memcpy(copy_buf, log->map + off, len);
+
+        atomic_thread_fence(memory_order_acquire);
+        gen2 = *gen;
+        if(gen1 == gen2)
+            return((int64_t)len);
+    }
+
+    return(-1);
+}
+
+static void live_sample_log(struct live_log *log, struct live_sample *sample)
+{
+    struct darshan_mod_logutil_funcs *funcs;
+    struct darshan_base_record *base_rec;
+    uint64_t rec_id;
+    int64_t r_bytes, w_bytes, max_offset, rank, nprocs;
+    double io_total_time, md_only_time, rw_only_time;
+    int64_t len, pos;
+    int rec_size;
+    int i;
+
+    memset(sample, 0, sizeof(*sample));
+    sample->jobid = log->job->jobid;
+    sample->rank = log->live->rank;
+    sample->pid = log->live->pid;
+
+    /* a process that exited without shutting down leaves its log behind */
+    sample->up = (log->live->state == DARSHAN_MMAP_LIVE_RUNNING) &&
+        (kill((pid_t)sample->pid, 0) == 0 || errno == EPERM);
+    if(!sample->up)
+        return;
+
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+    {
+        funcs = mod_logutils[i];
+        if(!funcs || !funcs->log_record_metrics || !funcs->log_sizeof_record ||
+           log->hdr->mod_ver[i] == 0)
+            continue;
+
+        len = live_copy_mod_region(log, i);
+        if(len <= 0)
+            continue;
+
+        sample->mods[i].valid = 1;
+        for(pos = 0; pos + (int64_t)sizeof(*base_rec) <= len; pos += rec_size)
+        {
+            base_rec = (struct darshan_base_record *)(copy_buf + pos);
+            rec_size = funcs->log_sizeof_record(base_rec);
+            if(rec_size <= 0 || pos + rec_size > len)
+                break;
+
+            /* skip records that are still being initialized */
+            if(base_rec->id == 0)
+                continue;
+
+            if(funcs->log_record_metrics(base_rec, &rec_id, &r_bytes, &w_bytes,
+                &max_offset, &io_total_time, &md_only_time, &rw_only_time,
+                &rank, &nprocs) < 0)
+                continue;
+
+            sample->mods[i].records++;
+            sample->mods[i].bytes_read += r_bytes;
+            sample->mods[i].bytes_written += w_bytes;
+            sample->mods[i].io_time += io_total_time;
+        }
+    }
+
+    return;
+}
+
+static int is_mmap_log_name(const char *name)
+{
+    size_t len = strlen(name);
+
+    return(strstr(name, "_mmap-log-") != NULL && len > 8 &&
+        strcmp(name + len - 8, ".darshan") == 0);
+}
+
+/* sample the given log, or all mmap logs in the given directory */
+static int sample_path(const char *path, struct live_sample **samples,
+    int *nsamples, int *max_samples)
+{
+    struct live_log log;
+    struct stat statbuf;
+    DIR *dir;
+    struct dirent *ent;
+    char *child;
+
+    if(stat(path, &statbuf) == 0 && S_ISDIR(statbuf.st_mode))
+    {
+        dir = opendir(path);
+        if(!dir)
+            return(-1);
+        while((ent = readdir(dir)) != NULL)
+        {
+            if(!is_mmap_log_name(ent->d_name))
+                continue;
+            child = malloc(strlen(path) + strlen(ent->d_name) + 2);
+            if(!child)
+                break;
+            sprintf(child, "%s/%s", path, ent->d_name);
+            sample_path(child, samples, nsamples, max_samples);
+            free(child);
+        }
+        closedir(dir);
+        return(0);
+    }
+
+    /* processes come and go, so logs that can not be opened are skipped */
+    if(live_log_open(path, &log) < 0)
+        return(0);
+
+    if(*nsamples == *max_samples)
+    {
+        struct live_sample *tmp;
+        int new_max = *max_samples ? *max_samples * 2 : 16;
+
+        tmp = realloc(*samples, new_max * sizeof(**samples));
+        if(!tmp)
+        {
+            live_log_close(&log);
+            return(-1);
+        }
+        *samples = tmp;
+        *max_samples = new_max;
+    }
+    live_sample_log(&log, &(*samples)[*nsamples]);
+    (*nsamples)++;
+    live_log_close(&log);
+
+    return(0);
+}
+
+static void print_labels(FILE *out, struct live_sample *sample, int mod_id)
+{
+    fprintf(out, "{jobid=\"%" PRId64 "\",rank=\"%" PRId64 "\",pid=\"%" PRId64 "\"",
+        sample->jobid, sample->rank, sample->pid);
+    if(mod_id >= 0)
+        fprintf(out, ",module=\"%s\"", darshan_module_names[mod_id]);
+    fprintf(out, "}");
+
+    return;
+}
+
+static void print_mod_metric(FILE *out, struct live_sample *samples,
+    int nsamples, const char *name, const char *type, const char *help,
+    int which)
+{
+    int i, j;
+
+    fprintf(out, "# HELP %s %s\n", name, help);
+    fprintf(out, "# TYPE %s %s\n", name, type);
+    for(i = 0; i < nsamples; i++)
+    {
+        for(j = 0; j < DARSHAN_KNOWN_MODULE_COUNT; j++)
+        {
+            struct live_mod_sample *mod = &samples[i].mods[j];
+
+            if(!mod->valid)
+                continue;
+            fprintf(out, "%s", name);
+            print_labels(out, &samples[i], j);
+            switch(which)
+            {
+                case 0:
+                    fprintf(out, " %" PRId64 "\n", mod->records);
+                    break;
+                case 1:
+                    fprintf(out, " %" PRId64 "\n", mod->bytes_read);
+                    break;
+                case 2:
+                    fprintf(out, " %" PRId64 "\n", mod->bytes_written);
+                    break;
+                default:
+                    fprintf(out, " %.6f\n", mod->io_time);
+                    break;
+            }
+        }
+    }
+
+    return;
+}
+
+static void print_samples(FILE *out, struct live_sample *samples, int nsamples)
+{
+    int i;
+
+    fprintf(out, "# HELP darshan_live_up 1 if the process is running and instrumented by Darshan\n");
+    fprintf(out, "# TYPE darshan_live_up gauge\n");
+    for(i = 0; i < nsamples; i++)
+    {
+        fprintf(out, "darshan_live_up");
+        print_labels(out, &samples[i], -1);
+        fprintf(out, " %d\n", samples[i].up);
+    }
+
+    print_mod_metric(out, samples, nsamples, "darshan_live_records", "gauge",
+        "records held by the module", 0);
+    print_mod_metric(out, samples, nsamples, "darshan_live_bytes_read_total",
+        "counter", "bytes read through the module", 1);
+    print_mod_metric(out, samples, nsamples, "darshan_live_bytes_written_total",
+        "counter", "bytes written through the module", 2);
+    print_mod_metric(out, samples, nsamples, "darshan_live_io_seconds_total",
+        "counter", "time spent in I/O and metadata operations of the module", 3);
+
+    return;
+}
+
+int main(int argc, char **argv)
+{
+    double interval;
+    char *output;
+    struct live_sample *samples = NULL;
+    int nsamples, max_samples = 0;
+    char *tmp_output = NULL;
+    FILE *out;
+    int i;
+    int ret = 0;
+
+    parse_args(argc, argv, &interval, &output);
+
+    if(output)
+    {
+        /* write each sample next to the output and rename it into place, so
+         * that the output is never seen partially written
+         */
+        tmp_output = malloc(strlen(output) + 5);
+        if(!tmp_output)
+            return(-1);
+        sprintf(tmp_output, "%s.tmp", output);
+    }
+
+    do
+    {
+        nsamples = 0;
+        for(i = optind; i < argc; i++)
+        {
+            if(sample_path(argv[i], &samples, &nsamples, &max_samples) < 0)
+            {
+                fprintf(stderr, "Error: unable to sample %s.\n", argv[i]);
+                ret = -1;
+            }
+        }
+
+        if(output)
+        {
+            out = fopen(tmp_output, "w");
+            if(!out)
+            {
+                fprintf(stderr, "Error: unable to open %s: %s.\n", tmp_output,
+                    strerror(errno));
+                ret = -1;
+                break;
+            }
+            print_samples(out, samples, nsamples);
+            fclose(out);
+            if(rename(tmp_output, output) < 0)
+            {
+                fprintf(stderr, "Error: unable to rename %s to %s: %s.\n",
+                    tmp_output, output, strerror(errno));
+                ret = -1;
+                break;
+            }
+        }
+        else
+        {
+            print_samples(stdout, samples, nsamples);
+            fflush(stdout);
+        }
+
+        if(interval > 0)
+            usleep((useconds_t)(interval * 1e6));
+    } while(interval > 0);
+
+    free(samples);
+    free(tmp_output);
+    free(copy_buf);
+
+    return(ret);
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
@@ -9,6 +9,8 @@
  */
 
 #include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
 #include <assert.h>
 
 #include "darshan-logutils.h"
@@ -27,6 +29,24 @@ typedef struct file_hash_entry_s
     int64_t nprocs;      /* nprocs that accessed it */
 } file_hash_entry_t;
 
+/* struct to track the number of accesses of each common access size */
+typedef struct access_hash_entry_s
+{
+    UT_hash_handle hlink;
+    int64_t size;
+    int64_t count;
+} access_hash_entry_t;
+
+/* struct to track per-file data accessed, by category */
+typedef struct category_hash_entry_s
+{
+    UT_hash_handle hlink;
+    darshan_record_id rec_id;
+    int category;
+    int64_t r_bytes;
+    int64_t w_bytes;
+} category_hash_entry_t;
+
 /* accumulator state */
 struct darshan_accumulator_st {
     darshan_module_id module_id;
@@ -34,6 +54,11 @@ struct darshan_accumulator_st {
     void* agg_record;
     int num_records;
     file_hash_entry_t *file_hash_table;
+    /* offset of the common access size counters in the module's records
+     * (-1 if the module does not record them), and their histogram
+     */
+    int access_counters_offset;
+    access_hash_entry_t *access_hash_table;
 
     /* amount of time consumed by slowest rank in shared files, across all
      * shared files observed
@@ -47,6 +72,49 @@ struct darshan_accumulator_st {
     double *rank_cumul_md_only_time;
 };
 
+/* offset of the ACCESS1_ACCESS counter in the records of modules that
+ * record common access sizes; the ACCESS1-4_ACCESS counters are followed
+ * by the ACCESS1-4_COUNT counters
+ */
+static int access_counters_offset(darshan_module_id id)
+{
+    switch(id)
+    {
+        case DARSHAN_POSIX_MOD:
+            return(offsetof(struct darshan_posix_file, counters) +
+                POSIX_ACCESS1_ACCESS * sizeof(int64_t));
+        case DARSHAN_MPIIO_MOD:
+            return(offsetof(struct darshan_mpiio_file, counters) +
+                MPIIO_ACCESS1_ACCESS * sizeof(int64_t));
+        default:
+            return(-1);
+    }
+}
+
+/* add 'count' accesses of 'size' to a histogram of access sizes */
+static int access_hash_add(access_hash_entry_t **table, int64_t size,
+    int64_t count)
+{
+    access_hash_entry_t *hacc = NULL;
+
+    HASH_FIND(hlink, *table, &size, sizeof(size), hacc);
+    if(!hacc) {
+        hacc = calloc(1, sizeof(*hacc));
+        if(!hacc)
+            return(-1);
+        hacc->size = size;
+        HASH_ADD(hlink, *table, size, sizeof(size), hacc);
+    }
+    hacc->count += count;
+
+    return(0);
+}
+
+static int access_size_cmp(access_hash_entry_t *a, access_hash_entry_t *b)
+{
+    return((a->size > b->size) - (a->size < b->size));
+}
+
 int darshan_accumulator_create(darshan_module_id id,
                                int64_t job_nprocs,
                                darshan_accumulator*   new_accumulator)
@@ -69,6 +137,7 @@ int darshan_accumulator_create(darshan_module_id id,
 
     (*new_accumulator)->module_id = id;
     (*new_accumulator)->job_nprocs = job_nprocs;
+    (*new_accumulator)->access_counters_offset = access_counters_offset(id);
     (*new_accumulator)->agg_record = calloc(1, DEF_MOD_BUF_SIZE);
     if(!(*new_accumulator)->agg_record) {
         free(*new_accumulator);
@@ -93,8 +162,9 @@ int darshan_accumulator_inject(darshan_accumulator acc,
                                void*               record_array,
                                int                 record_count)
 {
-    int i;
+    int i, j;
     void* new_record = record_array;
+    int64_t *access;
     uint64_t rec_id;
     int64_t r_bytes;
     int64_t w_bytes;
@@ -114,12 +184,20 @@ int darshan_accumulator_inject(darshan_accumulator acc,
         return(-1);
     }
 
+    if(mod_logutils[acc->module_id]->log_agg_records_batch && record_count > 0) {
+        /* accumulate aggregate record for all of the records at once */
+        mod_logutils[acc->module_id]->log_agg_records_batch(record_array,
+            record_count, acc->agg_record, acc->num_records == 0);
+    }
+
     for(i=0; i<record_count; i++) {
-        /* accumulate aggregate record */
-        if(acc->num_records == 0)
-            mod_logutils[acc->module_id]->log_agg_records(new_record, acc->agg_record, 1);
-        else
-            mod_logutils[acc->module_id]->log_agg_records(new_record, acc->agg_record, 0);
+        /* accumulate aggregate record, if not done above */
+        if(!mod_logutils[acc->module_id]->log_agg_records_batch) {
+            if(acc->num_records == 0)
+                mod_logutils[acc->module_id]->log_agg_records(new_record, acc->agg_record, 1);
+            else
+                mod_logutils[acc->module_id]->log_agg_records(new_record, acc->agg_record, 0);
+        }
         acc->num_records++;
 
         /* retrieve generic metrics from record */
@@ -178,6 +256,18 @@ int darshan_accumulator_inject(darshan_accumulator acc,
             hfile->nprocs += nprocs; /* partially shared or unique, as far as we
                                         know so far */
 
+        /* histogram of common access sizes; unused slots are all zero */
+        if(acc->access_counters_offset >= 0) {
+            access = (int64_t *)((char *)new_record + acc->access_counters_offset);
+            for(j = 0; j < 4; j++) {
+                if(access[j] == 0 && access[j+4] == 0)
+                    continue;
+                if(access_hash_add(&acc->access_hash_table, access[j],
+                        access[j+4]) < 0)
+                    return(-1);
+            }
+        }
+
         /* advance to next record */
         new_record += mod_logutils[acc->module_id]->log_sizeof_record(new_record);
     }
@@ -185,6 +275,77 @@ int darshan_accumulator_inject(darshan_accumulator acc,
     return(0);
 }
 
+int darshan_accumulator_merge(darshan_accumulator dst,
+                              darshan_accumulator src)
+{
+    file_hash_entry_t *curr = NULL;
+    file_hash_entry_t *tmp_file = NULL;
+    file_hash_entry_t *hfile = NULL;
+    access_hash_entry_t *curr_acc = NULL;
+    access_hash_entry_t *tmp_acc = NULL;
+    int64_t i;
+
+    if(dst->module_id != src->module_id || dst->job_nprocs != src->job_nprocs)
+        return(-1);
+
+    if(src->num_records == 0)
+        return(0);
+
+    /* combine aggregate records; the source aggregate record is treated
+     * like any other record of the module
+     */
+    if(dst->num_records == 0)
+        memcpy(dst->agg_record, src->agg_record,
+            mod_logutils[dst->module_id]->log_sizeof_record(src->agg_record));
+    else
+        mod_logutils[dst->module_id]->log_agg_records(src->agg_record,
+            dst->agg_record, 0);
+    dst->num_records += src->num_records;
+
+    /* combine performance metrics */
+    dst->total_bytes += src->total_bytes;
+    dst->shared_io_total_time_by_slowest += src->shared_io_total_time_by_slowest;
+    for(i = 0; i < dst->job_nprocs; i++) {
+        dst->rank_cumul_io_total_time[i] += src->rank_cumul_io_total_time[i];
+        dst->rank_cumul_rw_only_time[i] += src->rank_cumul_rw_only_time[i];
+        dst->rank_cumul_md_only_time[i] += src->rank_cumul_md_only_time[i];
+    }
+
+    /* combine per-file metrics */
+    HASH_ITER(hlink, src->file_hash_table, curr, tmp_file)
+    {
+        HASH_FIND(hlink, dst->file_hash_table, &curr->rec_id,
+            sizeof(curr->rec_id), hfile);
+        if(!hfile) {
+            /* move the entry over */
+            HASH_DELETE(hlink, src->file_hash_table, curr);
+            HASH_ADD(hlink, dst->file_hash_table, rec_id, sizeof(curr->rec_id), curr);
+            continue;
+        }
+
+        hfile->r_bytes += curr->r_bytes;
+        hfile->w_bytes += curr->w_bytes;
+        if(curr->max_offset == -1 || hfile->max_offset == -1)
+            hfile->max_offset = -1;
+        else
+            hfile->max_offset = max(hfile->max_offset, curr->max_offset);
+        if(curr->nprocs == -1 || hfile->nprocs == -1)
+            hfile->nprocs = -1;
+        else
+            hfile->nprocs += curr->nprocs;
+    }
+
+    /* combine access size histograms */
+    HASH_ITER(hlink, src->access_hash_table, curr_acc, tmp_acc)
+    {
+        if(access_hash_add(&dst->access_hash_table, curr_acc->size,
+                curr_acc->count) < 0)
+            return(-1);
+    }
+
+    return(0);
+}
+
 /* NOTE: use -1 for procs to indicate that the file was globally shared.
  * This will be marked in the category counters if we find a file hash that
  * was globally shared or if the proc value gets incremented to cover all
@@ -293,10 +454,104 @@ int darshan_accumulator_emit(darshan_accumulator             acc,
     return(0);
 }
 
+int darshan_accumulator_emit_access_sizes(darshan_accumulator acc,
+                                          struct darshan_access_size *sizes,
+                                          int max_sizes)
+{
+    access_hash_entry_t *curr = NULL;
+    access_hash_entry_t *tmp_acc = NULL;
+    int n = 0;
+
+    if(acc->access_counters_offset < 0)
+        return(-1);
+
+    HASH_SRT(hlink, acc->access_hash_table, access_size_cmp);
+    HASH_ITER(hlink, acc->access_hash_table, curr, tmp_acc)
+    {
+        if(n < max_sizes) {
+            sizes[n].size = curr->size;
+            sizes[n].count = curr->count;
+        }
+        n++;
+    }
+
+    return(n);
+}
+
+int darshan_accumulator_emit_categories(darshan_accumulator *accs,
+                                        int acc_count,
+                                        darshan_record_id *ids,
+                                        int *categories,
+                                        int id_count,
+                                        struct darshan_category_io *category_io,
+                                        int category_count)
+{
+    category_hash_entry_t *cat_table = NULL;
+    category_hash_entry_t *hcat = NULL;
+    category_hash_entry_t *tmp_cat = NULL;
+    file_hash_entry_t *curr = NULL;
+    file_hash_entry_t *tmp_file = NULL;
+    int ret = 0;
+    int i;
+
+    memset(category_io, 0, category_count * sizeof(*category_io));
+
+    /* per-file totals across all accumulators, for the listed files */
+    for(i = 0; i < id_count; i++) {
+        if(categories[i] < 0 || categories[i] >= category_count) {
+            ret = -1;
+            goto cleanup;
+        }
+        HASH_FIND(hlink, cat_table, &ids[i], sizeof(ids[i]), hcat);
+        if(hcat)
+            continue;
+        hcat = calloc(1, sizeof(*hcat));
+        if(!hcat) {
+            ret = -1;
+            goto cleanup;
+        }
+        hcat->rec_id = ids[i];
+        hcat->category = categories[i];
+        HASH_ADD(hlink, cat_table, rec_id, sizeof(hcat->rec_id), hcat);
+    }
+
+    for(i = 0; i < acc_count; i++) {
+        HASH_ITER(hlink, accs[i]->file_hash_table, curr, tmp_file)
+        {
+            HASH_FIND(hlink, cat_table, &curr->rec_id, sizeof(curr->rec_id), hcat);
+            if(!hcat)
+                continue;
+            hcat->r_bytes += curr->r_bytes;
+            hcat->w_bytes += curr->w_bytes;
+        }
+    }
+
+    HASH_ITER(hlink, cat_table, hcat, tmp_cat)
+    {
+        category_io[hcat->category].bytes_read += hcat->r_bytes;
+        category_io[hcat->category].bytes_written += hcat->w_bytes;
+        if(hcat->r_bytes > 0)
+            category_io[hcat->category].files_read++;
+        if(hcat->w_bytes > 0)
+            category_io[hcat->category].files_written++;
+    }
+
+cleanup:
+    HASH_ITER(hlink, cat_table, hcat, tmp_cat)
+    {
+        HASH_DELETE(hlink, cat_table, hcat);
+        free(hcat);
+    }
+
+    return(ret);
+}
+
 int darshan_accumulator_destroy(darshan_accumulator acc)
 {
     file_hash_entry_t *curr = NULL;
     file_hash_entry_t *tmp_file = NULL;
+    access_hash_entry_t *curr_acc = NULL;
+    access_hash_entry_t *tmp_acc = NULL;
 
     if(!acc)
         return(0);
@@ -315,6 +570,12 @@ int darshan_accumulator_destroy(darshan_accumulator acc)
         free(curr);
     }
 
+    HASH_ITER(hlink, acc->access_hash_table, curr_acc, tmp_acc)
+    {
+        HASH_DELETE(hlink, acc->access_hash_table, curr_acc);
+        free(curr_acc);
+    }
+
     free(acc);
 
     return(0);
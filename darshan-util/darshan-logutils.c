@@ -17,11 +17,16 @@
 #include <inttypes.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <pthread.h>
 #ifdef HAVE_LIBBZ2
 #include <bzlib.h>
 #endif
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
 
 #include "darshan-logutils.h"
 
@@ -45,6 +50,10 @@ struct darshan_dz_state
     void *comp_dat;
     /* buffer for staging compressed data to/from log file */
     unsigned char *buf;
+    /* data most recently loaded for reading: either the staging buffer
+     * or, for mmap-backed file descriptors, the mapped log file region
+     */
+    unsigned char *rd_buf;
     /* size of staging buffer */
     unsigned int size;
     /* for reading logs, flag indicating end of log file region */
@@ -53,6 +62,132 @@ struct darshan_dz_state
     int prev_reg_id;
 };
 
+#ifdef HAVE_LIBZSTD
+/* zstd stream state; the input buffer position is kept across reads */
+struct darshan_zstd_strm
+{
+    ZSTD_CCtx *cctx;
+    ZSTD_DCtx *dctx;
+    ZSTD_inBuffer in;
+};
+#endif
+
+/* state for returning pointers to records of a module region in place */
+struct darshan_rec_ptr_state
+{
+    /* module region currently exposed, or -1 if none */
+    int region_id;
+    /* start and length of the region's uncompressed data */
+    char *base;
+    int64_t len;
+    /* offset of the next record to return */
+    int64_t pos;
+    /* records before this offset have already been byte swapped */
+    int64_t swap_pos;
+    /* private copy of the region, if it could not be used in place */
+    char *copy;
+    /* record buffer used for modules that must be read by copying */
+    void *rec_buf;
+};
+
+/* a module region inflated ahead of time by darshan_log_prefetch_mods() */
+struct darshan_mod_cache
+{
+    char *buf;
+    int64_t len;
+    /* offset of the next byte to return from darshan_log_dzread() */
+    int64_t pos;
+};
+
+/* self-contained decompression context for one log region, so that
+ * independent regions can be inflated concurrently by different threads
+ */
+struct darshan_region_ctx
+{
+    darshan_fd fd;
+    int region_id;
+    struct darshan_log_map map;
+    /* amount of compressed region data consumed so far */
+    uint64_t in_off;
+    /* staging buffer for compressed data, if the log is not mapped */
+    unsigned char *stage;
+    /* inflated region data */
+    char *out;
+    int64_t out_len;
+    int64_t out_cap;
+};
+
+/* position of a darshan_log_get_columns() scan of a columnar module */
+struct darshan_column_scan
+{
+    int mod_id;
+    /* index of the module's block held in 'vals', or -1 */
+    int block;
+    /* number of records in 'vals' and the next one to return */
+    int64_t nrecs;
+    int64_t rec;
+    /* decoded values of columns 'cols' of the block, by record */
+    int *cols;
+    int ncols;
+    char *vals;
+};
+
+/* compressed data of a module region written by a region writer, which
+ * is spooled to a temporary file until the log is closed
+ */
+#define DARSHAN_SPOOL_NONE 0
+#define DARSHAN_SPOOL_OPEN 1
+#define DARSHAN_SPOOL_DONE 2
+struct darshan_region_spool
+{
+    int status;
+    int fildes;
+    uint64_t len;
+    uint32_t ver;
+};
+
+/* work queue shared by darshan_log_prefetch_mods() threads */
+struct darshan_prefetch_queue
+{
+    pthread_mutex_t mutex;
+    struct darshan_region_ctx *ctxs;
+    int count;
+    int next;
+    int err;
+};
+
+/* callback used to collect each name record parsed from the log; 'name'
+ * is not necessarily null-terminated.  returns 0 on success, -1 on failure
+ */
+typedef int (*darshan_name_rec_add_fn)(void *add_arg, darshan_record_id id,
+    const char *name, int name_len);
+
+/* directory entry of a name record region (log ver 3.42 and later) */
+struct darshan_name_dir_ref
+{
+    uint64_t id;
+    char *name;
+    UT_hash_handle hlink;
+};
+
+/* directory entries seen while reading or writing a name record region */
+struct darshan_name_dirs
+{
+    struct darshan_name_dir_ref *hash;
+    uint64_t count;
+    char *buf;
+    int buf_sz;
+};
+
+/* state for building a darshan_name_table */
+struct darshan_name_table_build
+{
+    struct darshan_name_table *table;
+    int64_t entries_max;
+    uint64_t names_len;
+    uint64_t names_max;
+};
+
 /* internal fd data structure */
 struct darshan_fd_int_state
 {
@@ -71,11 +206,52 @@ struct darshan_fd_int_state
     /* log format version-specific function calls for getting
      * data from the log file
      */
-    int (*get_namerecs)(void *, int, int, struct darshan_name_record_ref **,
-                        darshan_record_id *, int);
+    int (*get_namerecs)(void *, int, int, darshan_name_rec_add_fn, void *,
+                        darshan_record_id *, int, struct darshan_name_dirs *);
 
     /* compression/decompression stream read/write state */
     struct darshan_dz_state dz;
+#ifdef HAVE_LIBZSTD
+    /* trained dictionary of the log's zstd frames, if any */
+    ZSTD_CDict *zstd_cdict;
+    ZSTD_DDict *zstd_ddict;
+#endif
+    /* read-only mapping of the whole log file, if mmap-backed */
+    char *map_base;
+    size_t map_size;
+    /* darshan_log_get_record_ptr() state */
+    struct darshan_rec_ptr_state rptr;
+    /* block index read from the end of the log file, if any, sorted by
+     * module and file offset
+     */
+    struct darshan_log_block *blocks;
+    int block_cnt;
+    int blocks_loaded;
+    /* if blk_map.len is set, reads of module region blk_mod_id are
+     * restricted to this block
+     */
+    int blk_mod_id;
+    struct darshan_log_map blk_map;
+    /* module regions inflated by darshan_log_prefetch_mods() */
+    struct darshan_mod_cache mod_cache[DARSHAN_MAX_MODS];
+    /* modules whose last darshan_log_get_records_batch() call reached the
+     * end of their records, so the next call reports no more records
+     */
+    uint64_t batch_end_flags;
+    /* modules stored in the columnar layout, the last of their blocks
+     * reassembled for reads restricted to that block, and the state of
+     * darshan_log_get_columns()
+     */
+    uint64_t columnar_mods;
+    struct darshan_mod_cache col_blk;
+    uint64_t col_blk_off;
+    struct darshan_column_scan col_scan;
+    /* region writers of a log being created; the mutex protects 'spools' */
+    pthread_mutex_t spool_mutex;
+    struct darshan_region_spool spools[DARSHAN_MAX_MODS];
+    /* for a region writer, the log it writes to and the region it writes */
+    darshan_fd parent;
+    int spool_mod_id;
 };
 
 /* each module's implementation of the darshan logutil functions */
@@ -87,10 +263,31 @@ struct darshan_mod_logutil_funcs *mod_logutils[DARSHAN_KNOWN_MODULE_COUNT] =
 #undef X
 
 /* internal helper functions */
+static darshan_fd darshan_log_open_int(const char *name, int mmap_flag);
 static int darshan_mnt_info_cmp(const void *a, const void *b);
 static int darshan_log_get_namerecs(void *name_rec_buf, int buf_len,
-    int swap_flag, struct darshan_name_record_ref **hash,
-    darshan_record_id *whitelist, int whitelist_count);
+    int swap_flag, darshan_name_rec_add_fn add, void *add_arg,
+    darshan_record_id *whitelist, int whitelist_count,
+    struct darshan_name_dirs *dirs);
+static int darshan_name_dir_len(const char *name, int len);
+static char *darshan_name_dirs_buf(struct darshan_name_dirs *dirs, int len);
+static void darshan_name_dirs_free(struct darshan_name_dirs *dirs);
+static int darshan_log_put_name_record(darshan_fd fd,
+    struct darshan_name_dirs *dirs, darshan_record_id id, char *name);
+static int darshan_log_put_name_entry(darshan_fd fd,
+    struct darshan_name_dirs *dirs, uint64_t id, uint64_t dir,
+    const char *name, int len);
+static int darshan_log_put_name_dir(darshan_fd fd,
+    struct darshan_name_dirs *dirs, const char *name, int len,
+    uint64_t *dir_id);
+static int darshan_log_read_namerecs(darshan_fd fd, darshan_name_rec_add_fn add,
+    void *add_arg, darshan_record_id *whitelist, int whitelist_count);
+static int darshan_log_namehash_add(void *add_arg, darshan_record_id id,
+    const char *name, int name_len);
+static int darshan_log_name_table_add(void *add_arg, darshan_record_id id,
+    const char *name, int name_len);
+static int darshan_name_table_entry_cmp(const void *a, const void *b);
+static int darshan_record_id_cmp(const void *a, const void *b);
 static int darshan_log_get_format_version(char *ver_str, int *maj_num, int *min_num);
 static int darshan_log_get_header(darshan_fd fd);
 static int darshan_log_put_header(darshan_fd fd);
@@ -113,15 +310,55 @@ static int darshan_log_bzip2_write(darshan_fd fd, struct darshan_log_map *map_p,
     void *buf, int len, int flush_strm_flag);
 static int darshan_log_bzip2_flush(darshan_fd fd, int region_id);
 #endif
+#ifdef HAVE_LIBZSTD
+static ZSTD_DDict *darshan_log_zstd_load_ddict(uint32_t dict_id);
+static int darshan_log_zstd_read(darshan_fd fd, struct darshan_log_map map,
+    void *buf, int len, int reset_strm_flag);
+static int darshan_log_zstd_write(darshan_fd fd, struct darshan_log_map *map_p,
+    void *buf, int len, int flush_strm_flag);
+static int darshan_log_zstd_flush(darshan_fd fd, int region_id);
+#endif
 static int darshan_log_dzload(darshan_fd fd, struct darshan_log_map map);
 static int darshan_log_dzunload(darshan_fd fd, struct darshan_log_map *map_p);
+static int darshan_log_dzflush(darshan_fd fd);
+static int darshan_log_append_spools(darshan_fd fd);
 static int darshan_log_noz_read(darshan_fd fd, struct darshan_log_map map,
     void *buf, int len, int reset_strm_flag);
+static int darshan_log_rec_ptr_load(darshan_fd fd, int region_id);
+static void darshan_log_rec_ptr_unload(darshan_fd fd);
+static int darshan_log_load_blocks(darshan_fd fd);
+static int darshan_log_block_cmp(const void *a, const void *b);
+static int darshan_log_cache_read(struct darshan_mod_cache *cache, void *buf,
+    int len, int reset_strm_flag);
+static int darshan_log_region_fetch(struct darshan_region_ctx *ctx,
+    const unsigned char **in, size_t *in_len);
+static int darshan_log_region_grow(struct darshan_region_ctx *ctx);
+static int darshan_log_region_inflate(struct darshan_region_ctx *ctx);
+static void *darshan_log_prefetch_thread(void *arg);
+static int darshan_log_region_len_cmp(const void *a, const void *b);
+static size_t darshan_log_fixed_rec_size(int mod_idx);
+static uint64_t *darshan_log_columnar_dir(darshan_fd fd,
+    struct darshan_log_block *blk);
+static int darshan_log_columnar_block(darshan_fd fd,
+    struct darshan_log_block *blk, uint64_t *dir, const int *cols, int ncols,
+    char *out);
+static int darshan_log_columnar_append(struct darshan_region_ctx *ctx,
+    struct darshan_log_block *blk);
+static int darshan_log_columnar_inflate(struct darshan_region_ctx *ctx);
+static int darshan_log_columnar_load(darshan_fd fd, int region_id);
+static int darshan_log_columnar_read(darshan_fd fd, int region_id, void *buf,
+    int len, int reset_strm_flag);
+static void darshan_log_column_scan_reset(darshan_fd fd);
 
 /* backwards compatibility functions */
 static int darshan_log_get_namerecs_3_00(void *name_rec_buf, int buf_len,
-    int swap_flag, struct darshan_name_record_ref **hash,
-    darshan_record_id *whitelist, int whitelist_count);
+    int swap_flag, darshan_name_rec_add_fn add, void *add_arg,
+    darshan_record_id *whitelist, int whitelist_count,
+    struct darshan_name_dirs *dirs);
+static int darshan_log_get_namerecs_3_41(void *name_rec_buf, int buf_len,
+    int swap_flag, darshan_name_rec_add_fn add, void *add_arg,
+    darshan_record_id *whitelist, int whitelist_count,
+    struct darshan_name_dirs *dirs);
 
 static char *darshan_util_lib_ver = PACKAGE_VERSION;
 
@@ -137,58 +374,22 @@ static char *darshan_util_lib_ver = PACKAGE_VERSION;
  */
 darshan_fd darshan_log_open(const char *name)
 {
-    darshan_fd tmp_fd;
-    int ret;
-
-    /* allocate a darshan file descriptor */
-    tmp_fd = malloc(sizeof(*tmp_fd));
-    if(!tmp_fd)
-        return(NULL);
-    memset(tmp_fd, 0, sizeof(*tmp_fd));
-    tmp_fd->state = malloc(sizeof(struct darshan_fd_int_state));
-    if(!tmp_fd->state)
-    {
-        free(tmp_fd->state);
-        return(NULL);
-    }
-    memset(tmp_fd->state, 0, sizeof(struct darshan_fd_int_state));
-
-    /* open the log file in read mode */
-    tmp_fd->state->fildes = open(name, O_RDONLY);
-    if(tmp_fd->state->fildes < 0)
-    {
-        fprintf(stderr, "Error: %s failed to open darshan log file %s: %s.\n", __func__,
-                name, strerror(errno));
-        free(tmp_fd->state);
-        free(tmp_fd);
-        return(NULL);
-    }
-    strncpy(tmp_fd->state->logfile_path, name, __DARSHAN_PATH_MAX);
-
-    /* read the header from the log file to init fd data structures */
-    ret = darshan_log_get_header(tmp_fd);
-    if(ret < 0)
-    {
-        fprintf(stderr, "Error: %s failed to read darshan log file header: %s.\n",
-                __func__, strerror(errno));
-        close(tmp_fd->state->fildes);
-        free(tmp_fd->state);
-        free(tmp_fd);
-        return(NULL);
-    }
-
-    /* initialize compression data structures */
-    ret = darshan_log_dzinit(tmp_fd);
-    if(ret < 0)
-    {
-        fprintf(stderr, "Error: failed to initialize decompression data structures.\n");
-        close(tmp_fd->state->fildes);
-        free(tmp_fd->state);
-        free(tmp_fd);
-        return(NULL);
-    }
+    return(darshan_log_open_int(name, 0));
+}
 
-    return(tmp_fd);
+/* darshan_log_open_mmap()
+ *
+ * open an existing darshan log file for reading only, mapping the whole
+ * file into memory so that log regions are decompressed (or, for
+ * uncompressed logs, returned by darshan_log_get_record_ptr()) directly
+ * from the mapping rather than staged through read() calls. Falls back
+ * to regular reads if the file cannot be mapped.
+ *
+ * returns file descriptor on success, NULL on failure
+ */
+darshan_fd darshan_log_open_mmap(const char *name)
+{
+    return(darshan_log_open_int(name, 1));
 }
 
 /* darshan_log_create()
@@ -230,6 +431,7 @@ darshan_fd darshan_log_create(const char *name, enum darshan_comp_type comp_type
     tmp_fd->state->creat_flag = 1;
     tmp_fd->partial_flag = partial_flag;
     strncpy(tmp_fd->state->logfile_path, name, __DARSHAN_PATH_MAX);
+    pthread_mutex_init(&tmp_fd->state->spool_mutex, NULL);
 
     /* position file pointer to prealloc space for the log file header
      * NOTE: the header is written at close time, after all internal data
@@ -627,6 +829,140 @@ int darshan_log_get_namehash(darshan_fd fd, struct darshan_name_record_ref **has
 int darshan_log_get_filtered_namehash(darshan_fd fd, 
         struct darshan_name_record_ref **hash,
         darshan_record_id *whitelist, int whitelist_count)
+{
+    if(!fd)
+    {
+        fprintf(stderr, "Error: invalid Darshan log file handle.\n");
+        return(-1);
+    }
+
+    /* just return if there is no name record mapping data */
+    if(fd->name_map.len == 0)
+    {
+        *hash = NULL;
+        return(0);
+    }
+
+    return(darshan_log_read_namerecs(fd, darshan_log_namehash_add, hash,
+        whitelist, whitelist_count));
+}
+
+/* darshan_log_get_name_table()
+ *
+ * read the set of name records from the darshan log file into a flat
+ * name table, which needs much less memory than the name record hash
+ * table for logs with many records. The table must be freed using
+ * darshan_name_table_free().
+ *
+ * returns 0 on success, -1 on failure
+ */
+int darshan_log_get_name_table(darshan_fd fd, struct darshan_name_table **table)
+{
+    return(darshan_log_get_filtered_name_table(fd, table, NULL, 0));
+}
+
+/* darshan_log_get_filtered_name_table()
+ *
+ * read the set of name records from the darshan log file into a flat
+ * name table, optionally applying a whitelist
+ *
+ * returns 0 on success, -1 on failure
+ */
+int darshan_log_get_filtered_name_table(darshan_fd fd,
+        struct darshan_name_table **table,
+        darshan_record_id *whitelist, int whitelist_count)
+{
+    struct darshan_name_table_build build;
+    struct darshan_name_table *tab;
+    int64_t i, j;
+    int ret;
+
+    *table = NULL;
+    if(!fd)
+    {
+        fprintf(stderr, "Error: invalid Darshan log file handle.\n");
+        return(-1);
+    }
+
+    tab = calloc(1, sizeof(*tab));
+    if(!tab)
+        return(-1);
+    memset(&build, 0, sizeof(build));
+    build.table = tab;
+
+    if(fd->name_map.len > 0)
+    {
+        ret = darshan_log_read_namerecs(fd, darshan_log_name_table_add, &build,
+            whitelist, whitelist_count);
+        if(ret < 0)
+        {
+            darshan_name_table_free(tab);
+            return(-1);
+        }
+    }
+
+    /* sort by record id, then by position in the log, so that only the
+     * first name record seen for each id is kept (as in the hash table)
+     */
+    qsort(tab->entries, tab->count, sizeof(*tab->entries),
+        darshan_name_table_entry_cmp);
+    for(i = 0, j = 0; i < tab->count; i++)
+    {
+        if(j > 0 && tab->entries[j-1].id == tab->entries[i].id)
+            continue;
+        tab->entries[j++] = tab->entries[i];
+    }
+    tab->count = j;
+
+    *table = tab;
+    return(0);
+}
+
+/* darshan_name_table_lookup()
+ *
+ * returns the name of the given record id, or NULL if it is not present
+ * in the name table
+ */
+char *darshan_name_table_lookup(struct darshan_name_table *table,
+        darshan_record_id id)
+{
+    int64_t lo = 0, hi, mid;
+
+    if(!table)
+        return(NULL);
+
+    hi = table->count - 1;
+    while(lo <= hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if(table->entries[mid].id == id)
+            return(table->names + table->entries[mid].name_off);
+        else if(table->entries[mid].id < id)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+
+    return(NULL);
+}
+
+void darshan_name_table_free(struct darshan_name_table *table)
+{
+    if(!table)
+        return;
+
+    free(table->entries);
+    free(table->names);
+    free(table);
+    return;
+}
+
+/* read all name records of the log, passing each one to 'add'
+ *
+ * returns 0 on success, -1 on failure
+ */
+static int darshan_log_read_namerecs(darshan_fd fd, darshan_name_rec_add_fn add,
+    void *add_arg, darshan_record_id *whitelist, int whitelist_count)
 {
     struct darshan_fd_int_state *state;
     char *name_rec_buf;
@@ -635,33 +971,41 @@ int darshan_log_get_filtered_namehash(darshan_fd fd,
     int read_req_sz;
     int buf_len = 0;
     int buf_processed;
+    darshan_record_id *sorted_whitelist = NULL;
+    struct darshan_name_dirs dirs;
 
-    if(!fd)
-    {
-        fprintf(stderr, "Error: invalid Darshan log file handle.\n");
-        return(-1);
-    }
     state = fd->state;
     assert(state);
+    memset(&dirs, 0, sizeof(dirs));
 
-    /* just return if there is no name record mapping data */
-    if(fd->name_map.len == 0)
+    /* sort a copy of the whitelist, so each name record can be filtered
+     * with a binary search rather than a scan of the whole list
+     */
+    if(whitelist)
     {
-        *hash = NULL;
-        return(0);
+        sorted_whitelist = malloc(whitelist_count * sizeof(*whitelist) + 1);
+        if(!sorted_whitelist)
+            return(-1);
+        memcpy(sorted_whitelist, whitelist, whitelist_count * sizeof(*whitelist));
+        qsort(sorted_whitelist, whitelist_count, sizeof(*whitelist),
+            darshan_record_id_cmp);
+        whitelist = sorted_whitelist;
     }
 
     /* default to buffer twice as big as default compression buf */
     name_rec_buf_sz = DARSHAN_DEF_COMP_BUF_SZ * 2;
     name_rec_buf = malloc(name_rec_buf_sz);
     if(!name_rec_buf)
+    {
+        free(sorted_whitelist);
         return(-1);
+    }
     memset(name_rec_buf, 0, name_rec_buf_sz);
 
     do
     {
         /* read chunks of the darshan record id -> name mapping from log file,
-         * constructing a hash table in the process
+         * handing each complete name record to the caller's add function
          */
         read_req_sz = name_rec_buf_sz - buf_len;
         read = darshan_log_dzread(fd, DARSHAN_NAME_MAP_REGION_ID,
@@ -669,14 +1013,23 @@ int darshan_log_get_filtered_namehash(darshan_fd fd,
         if(read < 0)
         {
             fprintf(stderr, "Error: failed to read name hash from darshan log file.\n");
+            darshan_name_dirs_free(&dirs);
             free(name_rec_buf);
+            free(sorted_whitelist);
             return(-1);
         }
         buf_len += read;
 
         /* extract any name records in the buffer */
-        buf_processed = state->get_namerecs(name_rec_buf, buf_len, fd->swap_flag, hash,
-            whitelist, whitelist_count);
+        buf_processed = state->get_namerecs(name_rec_buf, buf_len, fd->swap_flag,
+            add, add_arg, whitelist, whitelist_count, &dirs);
+        if(buf_processed < 0)
+        {
+            darshan_name_dirs_free(&dirs);
+            free(name_rec_buf);
+            free(sorted_whitelist);
+            return(-1);
+        }
 
         /* copy any leftover data to beginning of buffer to parse next */
         memcpy(name_rec_buf, name_rec_buf + buf_processed, buf_len - buf_processed);
@@ -688,7 +1041,9 @@ int darshan_log_get_filtered_namehash(darshan_fd fd,
     } while(read == read_req_sz);
     assert(buf_len == 0);
 
+    darshan_name_dirs_free(&dirs);
     free(name_rec_buf);
+    free(sorted_whitelist);
     return(0);
 }
 
@@ -703,105 +1058,229 @@ int darshan_log_get_filtered_namehash(darshan_fd fd,
  */
 int darshan_log_put_namehash(darshan_fd fd, struct darshan_name_record_ref *hash)
 {
-    struct darshan_fd_int_state *state;
     struct darshan_name_record_ref *ref, *tmp;
-    struct darshan_name_record *name_rec;
-    int name_rec_len;
-    int wrote;
+    struct darshan_name_dirs dirs;
+    int ret;
 
     if(!fd)
     {
         fprintf(stderr, "Error: invalid Darshan log file handle.\n");
         return(-1);
     }
-    state = fd->state;
-    assert(state);
-
-    /* allocate memory for largest possible hash record */
-    name_rec = malloc(sizeof(darshan_record_id) + __DARSHAN_PATH_MAX + 1);
-    if(!name_rec)
-        return(-1);
-    memset(name_rec, 0, sizeof(darshan_record_id) + __DARSHAN_PATH_MAX + 1);
+    memset(&dirs, 0, sizeof(dirs));
 
     /* individually serialize each hash record and write to log file */
     HASH_ITER(hlink, hash, ref, tmp)
     {
-        name_rec_len = sizeof(darshan_record_id) + strlen(ref->name_record->name) + 1;
-        memcpy(name_rec, ref->name_record, name_rec_len);
+        ret = darshan_log_put_name_record(fd, &dirs, ref->name_record->id,
+            ref->name_record->name);
+        if(ret < 0)
+            break;
+    }
 
-        /* write this hash entry to log file */
-        wrote = darshan_log_dzwrite(fd, DARSHAN_NAME_MAP_REGION_ID,
-            name_rec, name_rec_len);
-        if(wrote != name_rec_len)
-        {
-            state->err = -1;
-            fprintf(stderr, "Error: failed to write name hash to darshan log file.\n");
-            free(name_rec);
-            return(-1);
-        }
+    darshan_name_dirs_free(&dirs);
+    if(ref)
+    {
+        fd->state->err = -1;
+        fprintf(stderr, "Error: failed to write name hash to darshan log file.\n");
+        return(-1);
     }
 
-    free(name_rec);
     return(0);
 }
 
-/* darshan_log_get_mod()
+/* darshan_log_put_name_records()
  *
- * get a chunk of module data from the darshan log file
+ * writes 'count' name records, given as parallel arrays of record ids and
+ * names, to the darshan log file, like darshan_log_put_namehash() does for
+ * a hash table of them (e.g., for callers that do not link against uthash)
  *
- * returns number of bytes read on success, -1 on failure
+ * returns 0 on success, -1 on failure
  */
-int darshan_log_get_mod(darshan_fd fd, darshan_module_id mod_id,
-    void *mod_buf, int mod_buf_sz)
+int darshan_log_put_name_records(darshan_fd fd,
+    darshan_record_id *ids, char **names, int count)
 {
-    struct darshan_fd_int_state *state;
-    int ret;
+    struct darshan_name_dirs dirs;
+    int ret = 0;
+    int i;
 
     if(!fd)
     {
         fprintf(stderr, "Error: invalid Darshan log file handle.\n");
         return(-1);
     }
-    state = fd->state;
-    assert(state);
-
-    if(mod_id < 0 || mod_id >= DARSHAN_KNOWN_MODULE_COUNT)
-    {
-        fprintf(stderr, "Error: invalid Darshan module id.\n");
-        return(-1);
-    }
+    memset(&dirs, 0, sizeof(dirs));
 
-    if(fd->mod_map[mod_id].len == 0)
-        return(0); /* no data corresponding to this mod_id */
-
-    /* assume module will support backwards compatibility, but we obviously
-     * can't provide any sort of "forwards" compatibility
-     */
-    if(fd->mod_ver[mod_id] > darshan_module_versions[mod_id])
+    for(i = 0; i < count; i++)
     {
-        fprintf(stderr, "Error: invalid %s module log format version "
-                "(expected %d, got %d)\n", darshan_module_names[mod_id],
-                darshan_module_versions[mod_id], fd->mod_ver[mod_id]);
-        return(-1);
+        ret = darshan_log_put_name_record(fd, &dirs, ids[i], names[i]);
+        if(ret < 0)
+            break;
     }
 
-    /* read this module's data from the log file */
-    ret = darshan_log_dzread(fd, mod_id, mod_buf, mod_buf_sz);
+    darshan_name_dirs_free(&dirs);
     if(ret < 0)
     {
-        fprintf(stderr,
-            "Error: failed to read module %s data from darshan log file.\n",
-            darshan_module_names[mod_id]);
+        fd->state->err = -1;
+        fprintf(stderr, "Error: failed to write name records to darshan log file.\n");
         return(-1);
     }
 
-    return(ret);
+    return(0);
 }
 
-/* darshan_log_put_mod()
- *
- * write a chunk of module data to the darshan log file
- * NOTE: this function call should be called directly after the
+/* write a name record, preceded by any directory entries it is stored
+ * relative to
+ */
+static int darshan_log_put_name_record(darshan_fd fd,
+    struct darshan_name_dirs *dirs, darshan_record_id id, char *name)
+{
+    int name_len = strlen(name);
+    uint64_t dir = 0;
+    int dir_len;
+    int ret;
+
+    dir_len = darshan_name_dir_len(name, name_len);
+    if(dir_len > 0)
+    {
+        ret = darshan_log_put_name_dir(fd, dirs, name, dir_len, &dir);
+        if(ret < 0)
+            return(-1);
+    }
+    else
+        dir_len = -1;
+
+    return(darshan_log_put_name_entry(fd, dirs, id,
+        dir, name + dir_len + 1, name_len - (dir_len + 1)));
+}
+
+/* serialize one name entry and write it to the log file */
+static int darshan_log_put_name_entry(darshan_fd fd,
+    struct darshan_name_dirs *dirs, uint64_t id, uint64_t dir,
+    const char *name, int len)
+{
+    struct darshan_name_entry *entry;
+    int entry_len = DARSHAN_NAME_ENTRY_SIZE(len);
+
+    entry = (struct darshan_name_entry *)darshan_name_dirs_buf(dirs, entry_len);
+    if(!entry)
+        return(-1);
+    entry->id = id;
+    entry->dir = dir;
+    memcpy(entry->name, name, len);
+    entry->name[len] = '\0';
+
+    if(darshan_log_dzwrite(fd, DARSHAN_NAME_MAP_REGION_ID, entry,
+        entry_len) != entry_len)
+        return(-1);
+
+    return(0);
+}
+
+/* write entries for the directory given by the first 'len' characters of
+ * 'name' and its parents, unless already written, and return its
+ * identifier in 'dir_id'
+ */
+static int darshan_log_put_name_dir(darshan_fd fd,
+    struct darshan_name_dirs *dirs, const char *name, int len,
+    uint64_t *dir_id)
+{
+    struct darshan_name_dir_ref *dir_ref;
+    uint64_t parent = 0;
+    int parent_len;
+
+    HASH_FIND(hlink, dirs->hash, name, len, dir_ref);
+    if(dir_ref)
+    {
+        *dir_id = dir_ref->id;
+        return(0);
+    }
+
+    parent_len = darshan_name_dir_len(name, len);
+    if(parent_len > 0)
+    {
+        if(darshan_log_put_name_dir(fd, dirs, name, parent_len, &parent) < 0)
+            return(-1);
+    }
+    else
+        parent_len = -1;
+
+    dir_ref = calloc(1, sizeof(*dir_ref));
+    if(!dir_ref)
+        return(-1);
+    dir_ref->name = strndup(name, len);
+    if(!dir_ref->name)
+    {
+        free(dir_ref);
+        return(-1);
+    }
+    /* identifiers only need to be unique within this log */
+    dir_ref->id = ++dirs->count << 1;
+    HASH_ADD_KEYPTR(hlink, dirs->hash, dir_ref->name, len, dir_ref);
+
+    *dir_id = dir_ref->id;
+    return(darshan_log_put_name_entry(fd, dirs, dir_ref->id,
+        parent | DARSHAN_NAME_DIR_FLAG, name + parent_len + 1,
+        len - (parent_len + 1)));
+}
+
+/* darshan_log_get_mod()
+ *
+ * get a chunk of module data from the darshan log file
+ *
+ * returns number of bytes read on success, -1 on failure
+ */
+int darshan_log_get_mod(darshan_fd fd, darshan_module_id mod_id,
+    void *mod_buf, int mod_buf_sz)
+{
+    struct darshan_fd_int_state *state;
+    int ret;
+
+    if(!fd)
+    {
+        fprintf(stderr, "Error: invalid Darshan log file handle.\n");
+        return(-1);
+    }
+    state = fd->state;
+    assert(state);
+
+    if(mod_id < 0 || mod_id >= DARSHAN_KNOWN_MODULE_COUNT)
+    {
+        fprintf(stderr, "Error: invalid Darshan module id.\n");
+        return(-1);
+    }
+
+    if(fd->mod_map[mod_id].len == 0)
+        return(0); /* no data corresponding to this mod_id */
+
+    /* assume module will support backwards compatibility, but we obviously
+     * can't provide any sort of "forwards" compatibility
+     */
+    if(fd->mod_ver[mod_id] > darshan_module_versions[mod_id])
+    {
+        fprintf(stderr, "Error: invalid %s module log format version "
+                "(expected %d, got %d)\n", darshan_module_names[mod_id],
+                darshan_module_versions[mod_id], fd->mod_ver[mod_id]);
+        return(-1);
+    }
+
+    /* read this module's data from the log file */
+    ret = darshan_log_dzread(fd, mod_id, mod_buf, mod_buf_sz);
+    if(ret < 0)
+    {
+        fprintf(stderr,
+            "Error: failed to read module %s data from darshan log file.\n",
+            darshan_module_names[mod_id]);
+        return(-1);
+    }
+
+    return(ret);
+}
+
+/* darshan_log_put_mod()
+ *
+ * write a chunk of module data to the darshan log file
+ * NOTE: this function call should be called directly after the
  * put_hash() function, as it expects the file pointer to be
  * positioned directly past the record hash location. Also,
  * for a set of modules with data to write to file, this function
@@ -848,258 +1327,389 @@ int darshan_log_put_mod(darshan_fd fd, darshan_module_id mod_id,
     return(0);
 }
 
-/* darshan_log_close()
+/* darshan_log_region_writer_open()
  *
- * close an open darshan file descriptor, freeing any resources
+ * open a writer for the data of module 'mod_id' of a log created with
+ * darshan_log_create(). The returned descriptor can be passed to the
+ * module's log_put_record() function (or to darshan_log_put_mod()) like
+ * the log's own descriptor. Its compressed output is streamed to a
+ * temporary file next to the log rather than kept in memory, and is
+ * copied into the log, with the header updated accordingly, when the log
+ * is closed.
  *
+ * Unlike the log's own descriptor, region writers for different modules
+ * may be used in any order and concurrently from different threads. A
+ * module's data can't be written both ways.
+ *
+ * returns a region writer descriptor on success, NULL on failure
  */
-void darshan_log_close(darshan_fd fd)
+/* darshan_log_set_zstd_dict()
+ *
+ * compresses the regions of a zstd log being created with the trained
+ * dictionary 'dict', whose id is recorded in the log header so that
+ * readers can look it up (see darshan_log_zstd_load_ddict()); must be
+ * called before any data or region writer is written to the log
+ *
+ * returns 0 on success, -1 on failure
+ */
+int darshan_log_set_zstd_dict(darshan_fd fd, const void *dict, size_t dict_len)
 {
+#ifdef HAVE_LIBZSTD
     struct darshan_fd_int_state *state;
-    int ret;
+    struct darshan_zstd_strm *zstd_strmp;
+    uint32_t dict_id;
 
     if(!fd)
     {
         fprintf(stderr, "Error: invalid Darshan log file handle.\n");
-        return;
+        return(-1);
     }
     state = fd->state;
     assert(state);
 
-    /* if the file was created for writing */
-    if(state->creat_flag)
+    if(!state->creat_flag || state->parent ||
+        fd->comp_type != DARSHAN_ZSTD_COMP || state->zstd_cdict)
     {
-        /* flush the last region of the log to file */
-        switch(fd->comp_type)
-        {
-            case DARSHAN_ZLIB_COMP:
-                ret = darshan_log_libz_flush(fd, state->dz.prev_reg_id);
-                if(ret == 0)
-                    break;
-#ifdef HAVE_LIBBZ2
-            case DARSHAN_BZIP2_COMP:
-                ret = darshan_log_bzip2_flush(fd, state->dz.prev_reg_id);
-                if(ret == 0)
-                    break;
-#endif 
-            default:
-                /* if flush fails, remove the output log file */
-                state->err = -1;
-                fprintf(stderr, "Error: final flush to log file failed.\n");
-                break;
-        }
-
-        /* if no errors flushing, write the log header before closing */
-        if(state->err != -1)
-        {
-            ret = darshan_log_put_header(fd);
-            if(ret < 0)
-                state->err = -1;
-        }
+        fprintf(stderr, "Error: zstd dictionaries can only be set once on zstd logs being created.\n");
+        return(-1);
     }
 
-    close(state->fildes);
-
-    /* remove output log file if error writing to it */
-    if((state->creat_flag) && (state->err == -1))
+    /* raw content dictionaries have no id to look them up by */
+    dict_id = ZSTD_getDictID_fromDict(dict, dict_len);
+    if(!dict_id)
     {
-        fprintf(stderr, "Unlinking darshan log file %s ...\n",
-            state->logfile_path);
-        unlink(state->logfile_path);
+        fprintf(stderr, "Error: zstd dictionary is not a trained dictionary.\n");
+        return(-1);
     }
 
-    darshan_log_dzdestroy(fd);
-    if(state->exe_mnt_data)
-        free(state->exe_mnt_data);
-    free(state);
-    free(fd);
+    state->zstd_cdict = ZSTD_createCDict(dict, dict_len, ZSTD_CLEVEL_DEFAULT);
+    if(!state->zstd_cdict)
+        return(-1);
+    zstd_strmp = state->dz.comp_dat;
+    ZSTD_CCtx_refCDict(zstd_strmp->cctx, state->zstd_cdict);
+    fd->comp_dict_id = dict_id;
 
-    return;
+    return(0);
+#else
+    fprintf(stderr, "Error: zstd dictionaries require zstd support.\n");
+    return(-1);
+#endif
 }
 
-void darshan_log_print_version_warnings(const char *version_string)
+/* darshan_log_get_region_sample()
+ *
+ * reads up to 'len' bytes of the uncompressed contents of the name record
+ * region (if 'mod_id' is negative) or of module region 'mod_id' into
+ * 'buf', e.g. to train a compression dictionary on
+ *
+ * returns number of bytes read on success, -1 on failure
+ */
+int darshan_log_get_region_sample(darshan_fd fd, int mod_id, void *buf, int len)
 {
-    if(strcmp(version_string, "3.20") == 0)
+    int region_id;
+    int total = 0;
+    int ret;
+
+    if(!fd)
     {
-        printf("# WARNING: Darshan logs generated by runtime version 3.2.0 likely exhibit some corruption in counter values.\n");
-        printf("#          This bug clearly results in bogus values for some COMMON_ACCESS counters (POSIX, MPIIO, H5 modules),\n");
-        printf("#          but preceding data may also be corrupted.\n");
+        fprintf(stderr, "Error: invalid Darshan log file handle.\n");
+        return(-1);
     }
 
-    return;
-}
+    if(mod_id < 0)
+        region_id = DARSHAN_NAME_MAP_REGION_ID;
+    else if(mod_id < DARSHAN_MAX_MODS)
+        region_id = mod_id;
+    else
+        return(-1);
 
-char *darshan_log_get_lib_version(void)
-{
-    return darshan_util_lib_ver;
+    /* read from the start of the region */
+    fd->state->dz.prev_reg_id = DARSHAN_HEADER_REGION_ID;
+    while(total < len)
+    {
+        ret = darshan_log_dzread(fd, region_id, (char *)buf + total, len - total);
+        if(ret < 0)
+            return(-1);
+        if(ret == 0)
+            break;
+        total += ret;
+    }
+
+    /* later reads of the region start over */
+    fd->state->dz.prev_reg_id = DARSHAN_HEADER_REGION_ID;
+
+    return(total);
 }
 
-int darshan_log_get_job_runtime(darshan_fd fd, struct darshan_job job, double *runtime)
+darshan_fd darshan_log_region_writer_open(darshan_fd fd, darshan_module_id mod_id)
 {
-    int log_ver_maj, log_ver_min;
+    struct darshan_fd_int_state *state;
+    darshan_fd tmp_fd;
+    char spool_path[__DARSHAN_PATH_MAX];
+    int status;
     int ret;
-    *runtime = 0;
 
-    /* get major/minor version numbers */
-    ret = darshan_log_get_format_version(fd->version, &log_ver_maj, &log_ver_min);
-    if(ret < 0)
+    if(!fd)
     {
-        fprintf(stderr, "Error: unable to parse log file format version.\n");
-        return(-1);
+        fprintf(stderr, "Error: invalid Darshan log file handle.\n");
+        return(NULL);
     }
+    state = fd->state;
+    assert(state);
 
-    if(((log_ver_maj == 3) && (log_ver_min >= 41)) || (log_ver_maj > 3))
-        *runtime = (double)((job.end_time_sec + (job.end_time_nsec / 1e9)) -
-                    (job.start_time_sec + (job.start_time_nsec / 1e9)));
+    if(!state->creat_flag || state->parent ||
+        mod_id < 0 || mod_id >= DARSHAN_KNOWN_MODULE_COUNT)
+    {
+        fprintf(stderr, "Error: invalid region writer request.\n");
+        return(NULL);
+    }
+
+    /* claim the module's region, unless it was already written directly */
+    pthread_mutex_lock(&state->spool_mutex);
+    status = state->spools[mod_id].status;
+    if(status == DARSHAN_SPOOL_NONE && fd->mod_map[mod_id].len == 0 &&
+        state->dz.prev_reg_id != mod_id)
+        state->spools[mod_id].status = DARSHAN_SPOOL_OPEN;
     else
-        *runtime = (double)(job.end_time_sec - job.start_time_sec + 1);
+        status = -1;
+    pthread_mutex_unlock(&state->spool_mutex);
+    if(status != DARSHAN_SPOOL_NONE)
+    {
+        fprintf(stderr, "Error: module %s data has already been written.\n",
+            darshan_module_names[mod_id]);
+        return(NULL);
+    }
 
-    return(0);
-}
+    tmp_fd = malloc(sizeof(*tmp_fd));
+    if(!tmp_fd)
+        goto fail;
+    memset(tmp_fd, 0, sizeof(*tmp_fd));
+    tmp_fd->state = malloc(sizeof(struct darshan_fd_int_state));
+    if(!tmp_fd->state)
+    {
+        free(tmp_fd);
+        goto fail;
+    }
+    memset(tmp_fd->state, 0, sizeof(struct darshan_fd_int_state));
+    tmp_fd->comp_type = fd->comp_type;
+    tmp_fd->state->creat_flag = 1;
+    tmp_fd->state->parent = fd;
+    tmp_fd->state->spool_mod_id = mod_id;
 
-/********************************************************
- *             internal helper functions                *
- ********************************************************/
+    /* spool to an anonymous file on the same file system as the log; the
+     * spool path must fit in the fd's path buffer, template and all
+     */
+    ret = snprintf(spool_path, sizeof(spool_path), "%s.spool.XXXXXX",
+        state->logfile_path);
+    if(ret < 0 || ret >= (int)sizeof(spool_path))
+    {
+        fprintf(stderr, "Error: spool file path for darshan log file %s is too long.\n",
+            state->logfile_path);
+        free(tmp_fd->state);
+        free(tmp_fd);
+        goto fail;
+    }
+    tmp_fd->state->fildes = mkstemp(spool_path);
+    if(tmp_fd->state->fildes < 0)
+    {
+        fprintf(stderr, "Error: unable to create spool file %s: %s.\n",
+            spool_path, strerror(errno));
+        free(tmp_fd->state);
+        free(tmp_fd);
+        goto fail;
+    }
+    unlink(spool_path);
+    memcpy(tmp_fd->state->logfile_path, spool_path, ret + 1);
 
-static int darshan_mnt_info_cmp(const void *a, const void *b)
-{
-    struct darshan_mnt_info *m_a = (struct darshan_mnt_info *)a;
-    struct darshan_mnt_info *m_b = (struct darshan_mnt_info *)b;
+    ret = darshan_log_dzinit(tmp_fd);
+    if(ret < 0)
+    {
+        fprintf(stderr, "Error: failed to initialize compression data structures.\n");
+        close(tmp_fd->state->fildes);
+        free(tmp_fd->state);
+        free(tmp_fd);
+        goto fail;
+    }
 
-    if(strlen(m_a->mnt_path) > strlen(m_b->mnt_path))
-        return(-1);
-    else if(strlen(m_a->mnt_path) < strlen(m_b->mnt_path))
-        return(1);
-    else
-        return(0);
+    return(tmp_fd);
+
+fail:
+    pthread_mutex_lock(&state->spool_mutex);
+    state->spools[mod_id].status = DARSHAN_SPOOL_NONE;
+    pthread_mutex_unlock(&state->spool_mutex);
+    return(NULL);
 }
 
-/* whitelist_filter
+/* darshan_log_region_writer_close()
  *
- * A simple filter function, that tests if a provided value is in 
+ * finish writing a module region opened with
+ * darshan_log_region_writer_open() and free the region writer. If
+ * writing the region failed, the whole log is discarded when it is
+ * closed.
  *
+ * returns 0 on success, -1 on failure
  */
-int whitelist_filter(darshan_record_id val, darshan_record_id *whitelist, int whitelist_count){
-    int i;
-    for(i = 0; i < whitelist_count; i++)
+int darshan_log_region_writer_close(darshan_fd region_fd)
+{
+    struct darshan_fd_int_state *state;
+    struct darshan_fd_int_state *parent_state;
+    struct darshan_region_spool *spool;
+    int mod_id;
+    int ret = 0;
+
+    if(!region_fd || !region_fd->state->parent)
     {
-        if (whitelist[i] == val)
-        {
-            return 1;
-        }
+        fprintf(stderr, "Error: invalid Darshan region writer handle.\n");
+        return(-1);
     }
-    return 0;
+    state = region_fd->state;
+    parent_state = state->parent->state;
+    mod_id = state->spool_mod_id;
+
+    /* only flush the stream if anything was written to the region */
+    if(state->err != -1 && state->dz.prev_reg_id == mod_id)
+        ret = darshan_log_dzflush(region_fd);
+    if(state->err == -1 || ret < 0)
+    {
+        fprintf(stderr, "Error: failed to write module %s data to darshan log file.\n",
+            darshan_module_names[mod_id]);
+        ret = -1;
+    }
+
+    pthread_mutex_lock(&parent_state->spool_mutex);
+    spool = &parent_state->spools[mod_id];
+    spool->status = DARSHAN_SPOOL_DONE;
+    spool->fildes = state->fildes;
+    spool->len = region_fd->mod_map[mod_id].len;
+    spool->ver = region_fd->mod_ver[mod_id];
+    if(ret < 0)
+        parent_state->err = -1;
+    pthread_mutex_unlock(&parent_state->spool_mutex);
+
+    darshan_log_dzdestroy(region_fd);
+    free(state);
+    free(region_fd);
+
+    return(ret);
 }
 
-static int darshan_log_get_namerecs(void *name_rec_buf, int buf_len,
-    int swap_flag, struct darshan_name_record_ref **hash,
-    darshan_record_id *whitelist, int whitelist_count)
+/* darshan_log_close()
+ *
+ * close an open darshan file descriptor, freeing any resources
+ *
+ */
+void darshan_log_close(darshan_fd fd)
 {
-    struct darshan_name_record_ref *ref;
-    struct darshan_name_record *name_rec;
-    char *tmp_p;
-    int buf_processed = 0;
-    int rec_len;
+    struct darshan_fd_int_state *state;
+    int i;
+    int ret;
 
-    /* work through the name record buffer -- deserialize the record data
-     * and add to the output hash table
-     * NOTE: these mapping pairs are variable in length, so we have to be able
-     * to handle incomplete mappings temporarily here
-     */
-    name_rec = (struct darshan_name_record *)name_rec_buf;
-    while(buf_len > sizeof(darshan_record_id) + 1)
+    if(!fd)
     {
-        if(strnlen(name_rec->name, buf_len - sizeof(darshan_record_id)) ==
-            (buf_len - sizeof(darshan_record_id)))
+        fprintf(stderr, "Error: invalid Darshan log file handle.\n");
+        return;
+    }
+    state = fd->state;
+    assert(state);
+
+    if(state->parent)
+    {
+        (void)darshan_log_region_writer_close(fd);
+        return;
+    }
+
+    /* if the file was created for writing */
+    if(state->creat_flag)
+    {
+        /* flush the last region of the log to file, if any was written;
+         * a log that failed before its first write (e.g., darshan-merge
+         * with an unreadable input) has no stream to finish
+         */
+        if(state->dz.prev_reg_id != DARSHAN_HEADER_REGION_ID)
         {
-            /* if this record name's terminating null character is not
-             * present, we need to read more of the buffer before continuing
-             */
-            break;
+            ret = darshan_log_dzflush(fd);
+            if(ret < 0)
+            {
+                /* if flush fails, remove the output log file */
+                state->err = -1;
+                fprintf(stderr, "Error: final flush to log file failed.\n");
+            }
         }
-        rec_len = sizeof(darshan_record_id) + strlen(name_rec->name) + 1;
 
-        if(swap_flag)
+        /* append regions written by region writers after all other data */
+        if(state->err != -1)
         {
-            /* we need to sort out endianness issues before deserializing */
-            DARSHAN_BSWAP64(&(name_rec->id));
+            ret = darshan_log_append_spools(fd);
+            if(ret < 0)
+                state->err = -1;
         }
 
-        HASH_FIND(hlink, *hash, &(name_rec->id), sizeof(darshan_record_id), ref);
-        if(!ref && (!whitelist ||
-            whitelist_filter(name_rec->id, whitelist, whitelist_count)))
+        /* if no errors flushing, write the log header before closing */
+        if(state->err != -1)
         {
-            ref = malloc(sizeof(*ref));
-            if(!ref)
-                return(-1);
-
-            ref->name_record = malloc(rec_len);
-            if(!ref->name_record)
-            {
-                free(ref);
-                return(-1);
-            }
-
-            /* copy the name record over from the hash buffer */
-            memcpy(ref->name_record, name_rec, rec_len);
+            ret = darshan_log_put_header(fd);
+            if(ret < 0)
+                state->err = -1;
+        }
 
-            /* add this record to the hash */
-            HASH_ADD(hlink, *hash, name_record->id, sizeof(darshan_record_id), ref);
+        for(i = 0; i < DARSHAN_MAX_MODS; i++)
+        {
+            if(state->spools[i].status == DARSHAN_SPOOL_DONE)
+                close(state->spools[i].fildes);
         }
+        pthread_mutex_destroy(&state->spool_mutex);
+    }
 
-        tmp_p = (char *)name_rec + rec_len;
-        name_rec = (struct darshan_name_record *)tmp_p;
-        buf_len -= rec_len;
-        buf_processed += rec_len;
+    close(state->fildes);
+
+    /* remove output log file if error writing to it */
+    if((state->creat_flag) && (state->err == -1))
+    {
+        fprintf(stderr, "Unlinking darshan log file %s ...\n",
+            state->logfile_path);
+        unlink(state->logfile_path);
     }
 
-    return(buf_processed);
+    darshan_log_dzdestroy(fd);
+    darshan_log_rec_ptr_unload(fd);
+    free(state->rptr.rec_buf);
+    free(state->blocks);
+    free(state->col_blk.buf);
+    darshan_log_column_scan_reset(fd);
+    for(i = 0; i < DARSHAN_MAX_MODS; i++)
+        free(state->mod_cache[i].buf);
+    if(state->map_base)
+        munmap(state->map_base, state->map_size);
+    if(state->exe_mnt_data)
+        free(state->exe_mnt_data);
+    free(state);
+    free(fd);
+
+    return;
 }
 
-/* extracts a major and minor format version from a log format version
- *
- * returns 0 on success, -1 on failure
- */
-static int darshan_log_get_format_version(char *ver_str, int *maj_num, int *min_num)
+void darshan_log_print_version_warnings(const char *version_string)
 {
-    int ret;
-
-    if(!ver_str)
-        return(-1);
+    if(strcmp(version_string, "3.20") == 0)
+    {
+        printf("# WARNING: Darshan logs generated by runtime version 3.2.0 likely exhibit some corruption in counter values.\n");
+        printf("#          This bug clearly results in bogus values for some COMMON_ACCESS counters (POSIX, MPIIO, H5 modules),\n");
+        printf("#          but preceding data may also be corrupted.\n");
+    }
 
-    ret = sscanf(ver_str, "%d.%d", maj_num, min_num);
-    if(ret < 2)
-        return(-1);
+    return;
+}
 
-    return(0);
+char *darshan_log_get_lib_version(void)
+{
+    return darshan_util_lib_ver;
 }
 
-/* read the header of the darshan log and set internal fd data structures
- * NOTE: this is the only portion of the darshan log that is uncompressed
- *
- * returns 0 on success, -1 on failure
- */
-static int darshan_log_get_header(darshan_fd fd)
+int darshan_log_get_job_runtime(darshan_fd fd, struct darshan_job job, double *runtime)
 {
-    struct darshan_header header;
     int log_ver_maj, log_ver_min;
-    int i;
     int ret;
-
-    ret = darshan_log_seek(fd, 0);
-    if(ret < 0)
-    {
-        fprintf(stderr, "Error: unable to seek in darshan log file.\n");
-        return(-1);
-    }
-
-    /* read the version number so we know how to process this log */
-    ret = darshan_log_read(fd, &fd->version, 8);
-    if(ret < 8)
-    {
-        fprintf(stderr, "Error: invalid log file (failed to read version).\n");
-        return(-1);
-    }
+    *runtime = 0;
 
     /* get major/minor version numbers */
     ret = darshan_log_get_format_version(fd->version, &log_ver_maj, &log_ver_min);
@@ -1109,67 +1719,490 @@ static int darshan_log_get_header(darshan_fd fd)
         return(-1);
     }
 
-    /* other log file versions can be detected and handled here */
-    if((log_ver_maj == 3) && (log_ver_min == 0))
-    {
-        fd->state->get_namerecs = darshan_log_get_namerecs_3_00;
-    }
-    else if((log_ver_maj == 3) &&
-                ((log_ver_min == 10) ||
-                 (log_ver_min == 20) ||
-                 (log_ver_min == 21) ||
-                 (log_ver_min == 41)))
+    if(((log_ver_maj == 3) && (log_ver_min >= 41)) || (log_ver_maj > 3))
+        *runtime = (double)((job.end_time_sec + (job.end_time_nsec / 1e9)) -
+                    (job.start_time_sec + (job.start_time_nsec / 1e9)));
+    else
+        *runtime = (double)(job.end_time_sec - job.start_time_sec + 1);
+
+    return(0);
+}
+
+/********************************************************
+ *             internal helper functions                *
+ ********************************************************/
+
+static darshan_fd darshan_log_open_int(const char *name, int mmap_flag)
+{
+    darshan_fd tmp_fd;
+    struct stat statbuf;
+    void *map;
+    int ret;
+
+    /* allocate a darshan file descriptor */
+    tmp_fd = malloc(sizeof(*tmp_fd));
+    if(!tmp_fd)
+        return(NULL);
+    memset(tmp_fd, 0, sizeof(*tmp_fd));
+    tmp_fd->state = malloc(sizeof(struct darshan_fd_int_state));
+    if(!tmp_fd->state)
     {
-        fd->state->get_namerecs = darshan_log_get_namerecs;
+        free(tmp_fd);
+        return(NULL);
     }
-    else
+    memset(tmp_fd->state, 0, sizeof(struct darshan_fd_int_state));
+    tmp_fd->state->rptr.region_id = -1;
+
+    /* open the log file in read mode */
+    tmp_fd->state->fildes = open(name, O_RDONLY);
+    if(tmp_fd->state->fildes < 0)
     {
-        fprintf(stderr, "Error: incompatible darshan file.\n");
-        fprintf(stderr, "Error: expected version %s, but got %s\n",
-            DARSHAN_LOG_VERSION, fd->version);
-        return(-1);
+        fprintf(stderr, "Error: %s failed to open darshan log file %s: %s.\n", __func__,
+                name, strerror(errno));
+        free(tmp_fd->state);
+        free(tmp_fd);
+        return(NULL);
     }
+    strncpy(tmp_fd->state->logfile_path, name, __DARSHAN_PATH_MAX);
 
-    /* seek back so we can read the entire header */
-    ret = darshan_log_seek(fd, 0);
+    /* read the header from the log file to init fd data structures */
+    ret = darshan_log_get_header(tmp_fd);
     if(ret < 0)
     {
-        fprintf(stderr, "Error: unable to seek in darshan log file.\n");
-        return(-1);
+        fprintf(stderr, "Error: %s failed to read darshan log file header: %s.\n",
+                __func__, strerror(errno));
+        close(tmp_fd->state->fildes);
+        free(tmp_fd->state);
+        free(tmp_fd);
+        return(NULL);
     }
 
-    /* read uncompressed header from log file */
-    /* NOTE: header bumped from 16 to 64 modules at log ver 3.41 */
-    if(((log_ver_maj == 3) && (log_ver_min >= 41)) || (log_ver_maj > 3))
+    /* map the log file if requested; if that fails for any reason, we
+     * just read it as usual
+     */
+    if(mmap_flag && fstat(tmp_fd->state->fildes, &statbuf) == 0 &&
+        statbuf.st_size > 0)
     {
-        ret = darshan_log_read(fd, &header, sizeof(header));
-        if(ret != (int)sizeof(header))
+        map = mmap(NULL, statbuf.st_size, PROT_READ, MAP_PRIVATE,
+            tmp_fd->state->fildes, 0);
+        if(map != MAP_FAILED)
         {
-            fprintf(stderr, "Error: failed to read darshan log file header.\n");
-            return(-1);
+            madvise(map, statbuf.st_size, MADV_SEQUENTIAL);
+            tmp_fd->state->map_base = map;
+            tmp_fd->state->map_size = statbuf.st_size;
         }
-
-        fd->job_map.off = sizeof(struct darshan_header);
     }
-    else
+
+    /* initialize compression data structures */
+    ret = darshan_log_dzinit(tmp_fd);
+    if(ret < 0)
     {
-        /* backwards compatibility with 3.00 version of Darshan header */
-        #define DARSHAN_MAX_MODS_3_00 16
-        struct
-        {
-            char version_string[8];
-            int64_t magic_nr;
-            unsigned char comp_type;
-            uint32_t partial_flag;
-            struct darshan_log_map name_map;
-            struct darshan_log_map mod_map[DARSHAN_MAX_MODS_3_00];
-            uint32_t mod_ver[DARSHAN_MAX_MODS_3_00];
-        } header_3_00;
+        fprintf(stderr, "Error: failed to initialize decompression data structures.\n");
+        if(tmp_fd->state->map_base)
+            munmap(tmp_fd->state->map_base, tmp_fd->state->map_size);
+        close(tmp_fd->state->fildes);
+        free(tmp_fd->state);
+        free(tmp_fd);
+        return(NULL);
+    }
 
-        /* read old header structure */
-        ret = darshan_log_read(fd, &header_3_00, sizeof(header_3_00));
-        if(ret != sizeof(header_3_00))
-        {
+    return(tmp_fd);
+}
+
+static int darshan_mnt_info_cmp(const void *a, const void *b)
+{
+    struct darshan_mnt_info *m_a = (struct darshan_mnt_info *)a;
+    struct darshan_mnt_info *m_b = (struct darshan_mnt_info *)b;
+
+    if(strlen(m_a->mnt_path) > strlen(m_b->mnt_path))
+        return(-1);
+    else if(strlen(m_a->mnt_path) < strlen(m_b->mnt_path))
+        return(1);
+    else
+        return(0);
+}
+
+/* whitelist_filter
+ *
+ * A simple filter function, that tests if a provided value is in 
+ * the given whitelist, which must be sorted in ascending order
+ *
+ */
+int whitelist_filter(darshan_record_id val, darshan_record_id *whitelist, int whitelist_count){
+    int lo = 0, hi = whitelist_count - 1, mid;
+    while(lo <= hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (whitelist[mid] == val)
+        {
+            return 1;
+        }
+        else if (whitelist[mid] < val)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+    return 0;
+}
+
+static int darshan_record_id_cmp(const void *a, const void *b)
+{
+    darshan_record_id id_a = *(const darshan_record_id *)a;
+    darshan_record_id id_b = *(const darshan_record_id *)b;
+
+    return((id_a > id_b) - (id_a < id_b));
+}
+
+static int darshan_log_get_namerecs(void *name_rec_buf, int buf_len,
+    int swap_flag, darshan_name_rec_add_fn add, void *add_arg,
+    darshan_record_id *whitelist, int whitelist_count,
+    struct darshan_name_dirs *dirs)
+{
+    struct darshan_name_entry *entry;
+    struct darshan_name_dir_ref *dir_ref;
+    const int hdr_len = DARSHAN_NAME_ENTRY_SIZE(0) - 1;
+    char *tmp_p;
+    char *name;
+    uint64_t dir;
+    int buf_processed = 0;
+    int name_len, full_len;
+    int rec_len;
+
+    /* work through the name entry buffer -- expand each name relative to
+     * its directory entry and pass name records on to the add function
+     * NOTE: these entries are variable in length, so we have to be able
+     * to handle incomplete entries temporarily here
+     */
+    entry = (struct darshan_name_entry *)name_rec_buf;
+    while(buf_len > hdr_len + 1)
+    {
+        if(strnlen(entry->name, buf_len - hdr_len) == (buf_len - hdr_len))
+        {
+            /* if this entry's terminating null character is not
+             * present, we need to read more of the buffer before continuing
+             */
+            break;
+        }
+        name_len = strlen(entry->name);
+        rec_len = DARSHAN_NAME_ENTRY_SIZE(name_len);
+
+        if(swap_flag)
+        {
+            /* we need to sort out endianness issues before deserializing */
+            DARSHAN_BSWAP64(&(entry->id));
+            DARSHAN_BSWAP64(&(entry->dir));
+        }
+
+        name = entry->name;
+        full_len = name_len;
+        dir = entry->dir & ~DARSHAN_NAME_DIR_FLAG;
+        if(dir)
+        {
+            HASH_FIND(hlink, dirs->hash, &dir, sizeof(dir), dir_ref);
+            if(!dir_ref)
+            {
+                fprintf(stderr, "Error: invalid name record directory in darshan log file.\n");
+                return(-1);
+            }
+            full_len = strlen(dir_ref->name) + 1 + name_len;
+            name = darshan_name_dirs_buf(dirs, full_len + 1);
+            if(!name)
+                return(-1);
+            sprintf(name, "%s/%s", dir_ref->name, entry->name);
+        }
+
+        if(entry->dir & DARSHAN_NAME_DIR_FLAG)
+        {
+            /* a directory defined again replaces the earlier definition */
+            HASH_FIND(hlink, dirs->hash, &(entry->id), sizeof(uint64_t), dir_ref);
+            if(!dir_ref)
+            {
+                dir_ref = calloc(1, sizeof(*dir_ref));
+                if(!dir_ref)
+                    return(-1);
+                dir_ref->id = entry->id;
+                HASH_ADD(hlink, dirs->hash, id, sizeof(uint64_t), dir_ref);
+            }
+            free(dir_ref->name);
+            dir_ref->name = strndup(name, full_len);
+            if(!dir_ref->name)
+                return(-1);
+        }
+        else if(!whitelist ||
+            whitelist_filter(entry->id, whitelist, whitelist_count))
+        {
+            if(add(add_arg, entry->id, name, full_len) < 0)
+                return(-1);
+        }
+
+        tmp_p = (char *)entry + rec_len;
+        entry = (struct darshan_name_entry *)tmp_p;
+        buf_len -= rec_len;
+        buf_processed += rec_len;
+    }
+
+    return(buf_processed);
+}
+
+/* returns the length of the directory that the first 'len' characters of
+ * a name are stored relative to, or -1 if they are stored in full
+ */
+static int darshan_name_dir_len(const char *name, int len)
+{
+    int i;
+
+    for(i = len - 1; i > 0; i--)
+    {
+        if(name[i] == '/')
+            return(i);
+    }
+
+    return(-1);
+}
+
+/* returns a scratch buffer of at least 'len' bytes */
+static char *darshan_name_dirs_buf(struct darshan_name_dirs *dirs, int len)
+{
+    char *tmp_buf;
+
+    if(len > dirs->buf_sz)
+    {
+        tmp_buf = realloc(dirs->buf, len);
+        if(!tmp_buf)
+            return(NULL);
+        dirs->buf = tmp_buf;
+        dirs->buf_sz = len;
+    }
+
+    return(dirs->buf);
+}
+
+static void darshan_name_dirs_free(struct darshan_name_dirs *dirs)
+{
+    struct darshan_name_dir_ref *dir_ref, *tmp;
+
+    HASH_ITER(hlink, dirs->hash, dir_ref, tmp)
+    {
+        HASH_DELETE(hlink, dirs->hash, dir_ref);
+        free(dir_ref->name);
+        free(dir_ref);
+    }
+    free(dirs->buf);
+    memset(dirs, 0, sizeof(*dirs));
+
+    return;
+}
+
+/* add a name record to a name record hash table, unless its id is
+ * already present
+ */
+static int darshan_log_namehash_add(void *add_arg, darshan_record_id id,
+    const char *name, int name_len)
+{
+    struct darshan_name_record_ref **hash = add_arg;
+    struct darshan_name_record_ref *ref;
+
+    HASH_FIND(hlink, *hash, &id, sizeof(darshan_record_id), ref);
+    if(ref)
+        return(0);
+
+    ref = malloc(sizeof(*ref));
+    if(!ref)
+        return(-1);
+
+    ref->name_record = malloc(sizeof(darshan_record_id) + name_len + 1);
+    if(!ref->name_record)
+    {
+        free(ref);
+        return(-1);
+    }
+
+    /* transform the serialized name record into the zero-length
+     * array structure darshan uses to track name records
+     */
+    ref->name_record->id = id;
+    memcpy(ref->name_record->name, name, name_len);
+    ref->name_record->name[name_len] = '\0';
+
+    /* add this record to the hash */
+    HASH_ADD(hlink, *hash, name_record->id, sizeof(darshan_record_id), ref);
+
+    return(0);
+}
+
+/* append a name record to a name table that is being built; duplicates
+ * are removed once all records have been added
+ */
+static int darshan_log_name_table_add(void *add_arg, darshan_record_id id,
+    const char *name, int name_len)
+{
+    struct darshan_name_table_build *build = add_arg;
+    struct darshan_name_table *table = build->table;
+    struct darshan_name_table_entry *tmp_entries;
+    char *tmp_names;
+    uint64_t new_names_max;
+
+    if(table->count == build->entries_max)
+    {
+        build->entries_max = build->entries_max ? (build->entries_max * 2) : 1024;
+        tmp_entries = realloc(table->entries,
+            build->entries_max * sizeof(*table->entries));
+        if(!tmp_entries)
+            return(-1);
+        table->entries = tmp_entries;
+    }
+
+    if(build->names_len + name_len + 1 > build->names_max)
+    {
+        new_names_max = build->names_max ? build->names_max : (64 * 1024);
+        while(build->names_len + name_len + 1 > new_names_max)
+            new_names_max *= 2;
+        tmp_names = realloc(table->names, new_names_max);
+        if(!tmp_names)
+            return(-1);
+        table->names = tmp_names;
+        build->names_max = new_names_max;
+    }
+
+    table->entries[table->count].id = id;
+    table->entries[table->count].name_off = build->names_len;
+    table->count++;
+    memcpy(table->names + build->names_len, name, name_len);
+    table->names[build->names_len + name_len] = '\0';
+    build->names_len += name_len + 1;
+
+    return(0);
+}
+
+static int darshan_name_table_entry_cmp(const void *a, const void *b)
+{
+    const struct darshan_name_table_entry *entry_a = a;
+    const struct darshan_name_table_entry *entry_b = b;
+
+    if(entry_a->id != entry_b->id)
+        return((entry_a->id > entry_b->id) - (entry_a->id < entry_b->id));
+    return((entry_a->name_off > entry_b->name_off) -
+        (entry_a->name_off < entry_b->name_off));
+}
+
+/* extracts a major and minor format version from a log format version
+ *
+ * returns 0 on success, -1 on failure
+ */
+static int darshan_log_get_format_version(char *ver_str, int *maj_num, int *min_num)
+{
+    int ret;
+
+    if(!ver_str)
+        return(-1);
+
+    ret = sscanf(ver_str, "%d.%d", maj_num, min_num);
+    if(ret < 2)
+        return(-1);
+
+    return(0);
+}
+
+/* read the header of the darshan log and set internal fd data structures
+ * NOTE: this is the only portion of the darshan log that is uncompressed
+ *
+ * returns 0 on success, -1 on failure
+ */
+static int darshan_log_get_header(darshan_fd fd)
+{
+    struct darshan_header header;
+    int log_ver_maj, log_ver_min;
+    int i;
+    int ret;
+
+    ret = darshan_log_seek(fd, 0);
+    if(ret < 0)
+    {
+        fprintf(stderr, "Error: unable to seek in darshan log file.\n");
+        return(-1);
+    }
+
+    /* read the version number so we know how to process this log */
+    ret = darshan_log_read(fd, &fd->version, 8);
+    if(ret < 8)
+    {
+        fprintf(stderr, "Error: invalid log file (failed to read version).\n");
+        return(-1);
+    }
+
+    /* get major/minor version numbers */
+    ret = darshan_log_get_format_version(fd->version, &log_ver_maj, &log_ver_min);
+    if(ret < 0)
+    {
+        fprintf(stderr, "Error: unable to parse log file format version.\n");
+        return(-1);
+    }
+
+    /* other log file versions can be detected and handled here */
+    if((log_ver_maj == 3) && (log_ver_min == 0))
+    {
+        fd->state->get_namerecs = darshan_log_get_namerecs_3_00;
+    }
+    else if((log_ver_maj == 3) &&
+                ((log_ver_min == 10) ||
+                 (log_ver_min == 20) ||
+                 (log_ver_min == 21) ||
+                 (log_ver_min == 41)))
+    {
+        fd->state->get_namerecs = darshan_log_get_namerecs_3_41;
+    }
+    else if((log_ver_maj == 3) && (log_ver_min == 42))
+    {
+        fd->state->get_namerecs = darshan_log_get_namerecs;
+    }
+    else
+    {
+        fprintf(stderr, "Error: incompatible darshan file.\n");
+        fprintf(stderr, "Error: expected version %s, but got %s\n",
+            DARSHAN_LOG_VERSION, fd->version);
+        return(-1);
+    }
+
+    /* seek back so we can read the entire header */
+    ret = darshan_log_seek(fd, 0);
+    if(ret < 0)
+    {
+        fprintf(stderr, "Error: unable to seek in darshan log file.\n");
+        return(-1);
+    }
+
+    /* read uncompressed header from log file */
+    /* NOTE: header bumped from 16 to 64 modules at log ver 3.41 */
+    if(((log_ver_maj == 3) && (log_ver_min >= 41)) || (log_ver_maj > 3))
+    {
+        ret = darshan_log_read(fd, &header, sizeof(header));
+        if(ret != (int)sizeof(header))
+        {
+            fprintf(stderr, "Error: failed to read darshan log file header.\n");
+            return(-1);
+        }
+
+        fd->job_map.off = sizeof(struct darshan_header);
+    }
+    else
+    {
+        /* backwards compatibility with 3.00 version of Darshan header */
+        #define DARSHAN_MAX_MODS_3_00 16
+        struct
+        {
+            char version_string[8];
+            int64_t magic_nr;
+            unsigned char comp_type;
+            uint32_t partial_flag;
+            struct darshan_log_map name_map;
+            struct darshan_log_map mod_map[DARSHAN_MAX_MODS_3_00];
+            uint32_t mod_ver[DARSHAN_MAX_MODS_3_00];
+        } header_3_00;
+
+        /* read old header structure */
+        ret = darshan_log_read(fd, &header_3_00, sizeof(header_3_00));
+        if(ret != sizeof(header_3_00))
+        {
             fprintf(stderr, "Error: failed to read darshan log file header.\n");
             return(-1);
         }
@@ -1202,6 +2235,7 @@ static int darshan_log_get_header(darshan_fd fd)
             fd->swap_flag = 1;
 
             /* swap the log map variables in the header */
+            DARSHAN_BSWAP32(&(header.comp_dict_id));
             DARSHAN_BSWAP64(&(header.name_map.off));
             DARSHAN_BSWAP64(&(header.name_map.len));
             for(i = 0; i < DARSHAN_MAX_MODS; i++)
@@ -1221,6 +2255,9 @@ static int darshan_log_get_header(darshan_fd fd)
 
     /* set some fd fields based on what's stored in the header */
     fd->comp_type = header.comp_type;
+    /* NOTE: the dictionary id was padding before log ver 3.42 */
+    if(((log_ver_maj == 3) && (log_ver_min >= 42)) || (log_ver_maj > 3))
+        fd->comp_dict_id = header.comp_dict_id;
     fd->partial_flag = header.partial_flag;
     memcpy(fd->mod_ver, header.mod_ver, DARSHAN_MAX_MODS * sizeof(uint32_t));
 
@@ -1271,7 +2308,19 @@ static int darshan_log_get_header(darshan_fd fd)
         fd->partial_flag = fd->partial_flag | partial_flag_shift;
     }
 
-    /* there may be nothing following the job data, so safety check map */
+    /* remember which modules are stored in the columnar layout, so that
+     * module versions can be compared as usual
+     */
+    for(i = 0; i < DARSHAN_MAX_MODS; i++)
+    {
+        if(fd->mod_ver[i] & DARSHAN_LOG_COLUMNAR_FLAG)
+        {
+            fd->mod_ver[i] &= ~DARSHAN_LOG_COLUMNAR_FLAG;
+            DARSHAN_MOD_FLAG_SET(fd->state->columnar_mods, i);
+        }
+    }
+
+    /* there may be nothing following the job data, so safety check map */
     if(fd->name_map.off == 0)
     {
         for(i = 0; i < DARSHAN_MAX_MODS; i++)
@@ -1322,6 +2371,7 @@ static int darshan_log_put_header(darshan_fd fd)
     strcpy(header.version_string, DARSHAN_LOG_VERSION);
     header.magic_nr = DARSHAN_MAGIC_NR;
     header.comp_type = fd->comp_type;
+    header.comp_dict_id = fd->comp_dict_id;
     header.partial_flag = fd->partial_flag;
     memcpy(&header.name_map, &fd->name_map, sizeof(struct darshan_log_map));
     memcpy(header.mod_map, fd->mod_map, DARSHAN_MAX_MODS * sizeof(struct darshan_log_map));
@@ -1490,6 +2540,53 @@ static int darshan_log_dzinit(darshan_fd fd)
             state->dz.comp_dat = tmp_bzstrm;
             break;
         }
+#endif
+#ifdef HAVE_LIBZSTD
+        case DARSHAN_ZSTD_COMP:
+        {
+            struct darshan_zstd_strm *tmp_zstdstrm = calloc(1, sizeof(*tmp_zstdstrm));
+            if(!tmp_zstdstrm)
+            {
+                free(state->dz.buf);
+                return(-1);
+            }
+
+            if(!(state->creat_flag))
+            {
+                /* read only file, init decompression context */
+                tmp_zstdstrm->dctx = ZSTD_createDCtx();
+                if(tmp_zstdstrm->dctx && fd->comp_dict_id)
+                {
+                    state->zstd_ddict = darshan_log_zstd_load_ddict(fd->comp_dict_id);
+                    if(!state->zstd_ddict)
+                    {
+                        ZSTD_freeDCtx(tmp_zstdstrm->dctx);
+                        tmp_zstdstrm->dctx = NULL;
+                    }
+                    else
+                        ZSTD_DCtx_refDDict(tmp_zstdstrm->dctx, state->zstd_ddict);
+                }
+            }
+            else
+            {
+                /* write only file, init compression context; region
+                 * writers use the dictionary of the log they write to
+                 */
+                tmp_zstdstrm->cctx = ZSTD_createCCtx();
+                if(tmp_zstdstrm->cctx && state->parent &&
+                    state->parent->state->zstd_cdict)
+                    ZSTD_CCtx_refCDict(tmp_zstdstrm->cctx,
+                        state->parent->state->zstd_cdict);
+            }
+            if(!tmp_zstdstrm->dctx && !tmp_zstdstrm->cctx)
+            {
+                free(tmp_zstdstrm);
+                free(state->dz.buf);
+                return(-1);
+            }
+            state->dz.comp_dat = tmp_zstdstrm;
+            break;
+        }
 #endif
         case DARSHAN_NO_COMP:
         {
@@ -1526,6 +2623,19 @@ static void darshan_log_dzdestroy(darshan_fd fd)
             else
                 BZ2_bzCompressEnd((bz_stream *)state->dz.comp_dat);
             break;
+#endif
+#ifdef HAVE_LIBZSTD
+        case DARSHAN_ZSTD_COMP:
+        {
+            struct darshan_zstd_strm *zstd_strmp = state->dz.comp_dat;
+            if(!(state->creat_flag))
+                ZSTD_freeDCtx(zstd_strmp->dctx);
+            else
+                ZSTD_freeCCtx(zstd_strmp->cctx);
+            ZSTD_freeCDict(state->zstd_cdict);
+            ZSTD_freeDDict(state->zstd_ddict);
+            break;
+        }
 #endif
         case DARSHAN_NO_COMP:
             /* do nothing */
@@ -1554,10 +2664,34 @@ static int darshan_log_dzread(darshan_fd fd, int region_id, void *buf, int len)
         reset_strm_flag = 1; /* reset libz/bzip2 streams */
     }
 
+    /* columnar module data is reassembled into records in memory */
+    if(region_id >= 0 &&
+        DARSHAN_MOD_FLAG_ISSET(state->columnar_mods, region_id))
+    {
+        ret = darshan_log_columnar_read(fd, region_id, buf, len,
+            reset_strm_flag);
+        state->dz.prev_reg_id = region_id;
+        return(ret);
+    }
+
+    /* serve prefetched module regions from memory, unless reads of the
+     * region are restricted to a single block
+     */
+    if(region_id >= 0 && state->mod_cache[region_id].buf &&
+        !(state->blk_map.len && region_id == state->blk_mod_id))
+    {
+        ret = darshan_log_cache_read(&state->mod_cache[region_id], buf, len,
+            reset_strm_flag);
+        state->dz.prev_reg_id = region_id;
+        return(ret);
+    }
+
     if(region_id == DARSHAN_JOB_REGION_ID)
         map = fd->job_map;
     else if(region_id == DARSHAN_NAME_MAP_REGION_ID)
         map = fd->name_map;
+    else if(state->blk_map.len && region_id == state->blk_mod_id)
+        map = state->blk_map;
     else
         map = fd->mod_map[region_id];
 
@@ -1570,6 +2704,11 @@ static int darshan_log_dzread(darshan_fd fd, int region_id, void *buf, int len)
         case DARSHAN_BZIP2_COMP:
             ret = darshan_log_bzip2_read(fd, map, buf, len, reset_strm_flag);
             break;
+#endif
+#ifdef HAVE_LIBZSTD
+        case DARSHAN_ZSTD_COMP:
+            ret = darshan_log_zstd_read(fd, map, buf, len, reset_strm_flag);
+            break;
 #endif
         case DARSHAN_NO_COMP:
             ret = darshan_log_noz_read(fd, map, buf, len, reset_strm_flag);
@@ -1614,6 +2753,20 @@ static int darshan_log_dzwrite(darshan_fd fd, int region_id, void *buf, int len)
         if(region_id < state->dz.prev_reg_id)
             return(-1);
 
+        /* regions handed to a region writer can't also be written directly */
+        if(region_id >= 0 && !state->parent)
+        {
+            pthread_mutex_lock(&state->spool_mutex);
+            ret = state->spools[region_id].status;
+            pthread_mutex_unlock(&state->spool_mutex);
+            if(ret != DARSHAN_SPOOL_NONE)
+            {
+                fprintf(stderr, "Error: module %s data is being written by a region writer.\n",
+                    darshan_module_names[region_id]);
+                return(-1);
+            }
+        }
+
         if(state->dz.prev_reg_id != DARSHAN_HEADER_REGION_ID)
             flush_strm_flag = 1;
     }
@@ -1634,6 +2787,11 @@ static int darshan_log_dzwrite(darshan_fd fd, int region_id, void *buf, int len)
         case DARSHAN_BZIP2_COMP:
             ret = darshan_log_bzip2_write(fd, map_p, buf, len, flush_strm_flag);
             break;
+#endif
+#ifdef HAVE_LIBZSTD
+        case DARSHAN_ZSTD_COMP:
+            ret = darshan_log_zstd_write(fd, map_p, buf, len, flush_strm_flag);
+            break;
 #endif
         case DARSHAN_NO_COMP:
             fprintf(stderr,
@@ -1660,7 +2818,11 @@ static int darshan_log_libz_read(darshan_fd fd, struct darshan_log_map map,
     assert(z_strmp);
 
     if(reset_stream_flag)
+    {
+        /* the previous region may not have been read to the end */
         z_strmp->avail_in = 0;
+        inflateReset(z_strmp);
+    }
 
     z_strmp->avail_out = len;
     z_strmp->next_out = buf;
@@ -1689,7 +2851,7 @@ static int darshan_log_libz_read(darshan_fd fd, struct darshan_log_map map,
             assert(state->dz.size > 0);
 
             z_strmp->avail_in = state->dz.size;
-            z_strmp->next_in = state->dz.buf;
+            z_strmp->next_in = state->dz.rd_buf;
         }
 
         tmp_out_bytes = z_strmp->total_out;
@@ -1822,7 +2984,12 @@ static int darshan_log_bzip2_read(darshan_fd fd, struct darshan_log_map map,
     assert(bz_strmp);
 
     if(reset_strm_flag)
+    {
+        /* the previous region may not have been read to the end */
         bz_strmp->avail_in = 0;
+        BZ2_bzDecompressEnd(bz_strmp);
+        BZ2_bzDecompressInit(bz_strmp, 1, 0);
+    }
 
     bz_strmp->avail_out = len;
     bz_strmp->next_out = buf;
@@ -1851,7 +3018,7 @@ static int darshan_log_bzip2_read(darshan_fd fd, struct darshan_log_map map,
             assert(state->dz.size > 0);
 
             bz_strmp->avail_in = state->dz.size;
-            bz_strmp->next_in = (char *)state->dz.buf;
+            bz_strmp->next_in = (char *)state->dz.rd_buf;
         }
 
         tmp_out_bytes = bz_strmp->total_out_lo32;
@@ -1871,468 +3038,2495 @@ static int darshan_log_bzip2_read(darshan_fd fd, struct darshan_log_map map,
         }
     }
 
-    return(total_bytes);
+    return(total_bytes);
+}
+
+static int darshan_log_bzip2_write(darshan_fd fd, struct darshan_log_map *map_p,
+    void *buf, int len, int flush_strm_flag)
+{
+    struct darshan_fd_int_state *state = fd->state;
+    int ret;
+    int total_bytes = 0;
+    int tmp_in_bytes;
+    int tmp_out_bytes;
+    bz_stream *bz_strmp = (bz_stream *)state->dz.comp_dat;
+
+    assert(bz_strmp);
+
+    /* flush compressed output buffer if we are moving to a new log region */
+    if(flush_strm_flag)
+    {
+        ret = darshan_log_bzip2_flush(fd, state->dz.prev_reg_id);
+        if(ret < 0)
+            return(-1);
+    }
+
+    bz_strmp->avail_in = len;
+    bz_strmp->next_in = buf;
+
+    /* compress input data until none left */
+    while(bz_strmp->avail_in)
+    {
+        /* if we are out of output, flush to log file */
+        if(bz_strmp->avail_out == 0)
+        {
+            assert(state->dz.size == DARSHAN_DEF_COMP_BUF_SZ);
+
+            ret = darshan_log_dzunload(fd, map_p);
+            if(ret < 0)
+                return(-1);
+
+            bz_strmp->avail_out = DARSHAN_DEF_COMP_BUF_SZ;
+            bz_strmp->next_out = (char *)state->dz.buf;
+        }
+
+        tmp_in_bytes = bz_strmp->total_in_lo32;
+        tmp_out_bytes = bz_strmp->total_out_lo32;
+        ret = BZ2_bzCompress(bz_strmp, BZ_RUN);
+        if(ret != BZ_RUN_OK)
+        {
+            fprintf(stderr, "Error: unable to compress darshan log data.\n");
+            return(-1);
+        }
+        total_bytes += (bz_strmp->total_in_lo32 - tmp_in_bytes);
+        state->dz.size += (bz_strmp->total_out_lo32 - tmp_out_bytes);
+    }
+
+    return(total_bytes);
+}
+
+static int darshan_log_bzip2_flush(darshan_fd fd, int region_id)
+{
+    struct darshan_fd_int_state *state = fd->state;
+    int ret;
+    int tmp_out_bytes;
+    struct darshan_log_map *map_p;
+    bz_stream *bz_strmp = (bz_stream *)state->dz.comp_dat;
+
+    assert(bz_strmp);
+
+    if(region_id == DARSHAN_JOB_REGION_ID)
+        map_p = &(fd->job_map);
+    else if(region_id == DARSHAN_NAME_MAP_REGION_ID)
+        map_p = &(fd->name_map);
+    else
+        map_p = &(fd->mod_map[region_id]);
+
+    /* make sure deflate finishes this stream */
+    bz_strmp->avail_in = 0;
+    bz_strmp->next_in = NULL;
+    do
+    {
+        tmp_out_bytes = bz_strmp->total_out_lo32;
+        ret = BZ2_bzCompress(bz_strmp, BZ_FINISH);
+        if(ret < 0)
+        {
+            fprintf(stderr, "Error: unable to compress darshan log data.\n");
+            return(-1);
+        }
+        state->dz.size += (bz_strmp->total_out_lo32 - tmp_out_bytes);
+
+        if(state->dz.size)
+        {
+            /* flush to file */
+            if(darshan_log_dzunload(fd, map_p) < 0)
+                return(-1);
+
+            bz_strmp->avail_out = DARSHAN_DEF_COMP_BUF_SZ;
+            bz_strmp->next_out = (char *)state->dz.buf;
+        }
+    } while (ret != BZ_STREAM_END);
+    
+    BZ2_bzCompressEnd(bz_strmp);
+    BZ2_bzCompressInit(bz_strmp, 9, 1, 30);
+    return(0);
+}
+#endif
+
+#ifdef HAVE_LIBZSTD
+/* looks up the trained zstd dictionary 'dict_id' as darshan-<id>.zdict in
+ * the colon-separated list of directories in DARSHAN_ZSTD_DICT_PATH
+ */
+static ZSTD_DDict *darshan_log_zstd_load_ddict(uint32_t dict_id)
+{
+    char path[__DARSHAN_PATH_MAX];
+    char *dirs, *dir, *save;
+    char *dict;
+    struct stat st;
+    ZSTD_DDict *ddict = NULL;
+    int fd;
+
+    dirs = getenv("DARSHAN_ZSTD_DICT_PATH");
+    if(dirs)
+        dirs = strdup(dirs);
+    for(dir = dirs ? strtok_r(dirs, ":", &save) : NULL; dir && !ddict;
+        dir = strtok_r(NULL, ":", &save))
+    {
+        snprintf(path, sizeof(path), "%s/darshan-%u.zdict", dir, dict_id);
+        fd = open(path, O_RDONLY);
+        if(fd < 0)
+            continue;
+        if(fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            dict = malloc(st.st_size);
+            if(dict && pread(fd, dict, st.st_size, 0) == st.st_size &&
+                ZSTD_getDictID_fromDict(dict, st.st_size) == dict_id)
+                ddict = ZSTD_createDDict(dict, st.st_size);
+            free(dict);
+        }
+        close(fd);
+    }
+    free(dirs);
+
+    if(!ddict)
+        fprintf(stderr, "Error: unable to find zstd dictionary %u in DARSHAN_ZSTD_DICT_PATH.\n",
+            dict_id);
+    return(ddict);
+}
+
+static int darshan_log_zstd_read(darshan_fd fd, struct darshan_log_map map,
+    void *buf, int len, int reset_strm_flag)
+{
+    struct darshan_fd_int_state *state = fd->state;
+    size_t ret;
+    ZSTD_outBuffer out_buf;
+    struct darshan_zstd_strm *zstd_strmp = (struct darshan_zstd_strm *)state->dz.comp_dat;
+
+    assert(zstd_strmp);
+
+    if(reset_strm_flag)
+    {
+        zstd_strmp->in.size = 0;
+        zstd_strmp->in.pos = 0;
+        ZSTD_DCtx_reset(zstd_strmp->dctx, ZSTD_reset_session_only);
+    }
+
+    out_buf.dst = buf;
+    out_buf.size = len;
+    out_buf.pos = 0;
+
+    /* we just decompress until the output buffer is full, assuming there
+     * is enough compressed data in file to satisfy the request size.
+     * NOTE: each rank's contribution to a region is a separate zstd frame;
+     * the decompressor moves on to the next frame on its own.
+     */
+    while(out_buf.pos < out_buf.size)
+    {
+        /* check if we need more compressed data */
+        if(zstd_strmp->in.pos == zstd_strmp->in.size)
+        {
+            /* if the eor flag is set, clear it and return -- future
+             * reads of this log region will restart at the beginning
+             */
+            if(state->dz.eor)
+            {
+                state->dz.eor = 0;
+                break;
+            }
+
+            /* read more data from input file */
+            if(darshan_log_dzload(fd, map) < 0)
+                return(-1);
+            assert(state->dz.size > 0);
+
+            zstd_strmp->in.src = state->dz.rd_buf;
+            zstd_strmp->in.size = state->dz.size;
+            zstd_strmp->in.pos = 0;
+        }
+
+        ret = ZSTD_decompressStream(zstd_strmp->dctx, &out_buf, &zstd_strmp->in);
+        if(ZSTD_isError(ret))
+        {
+            fprintf(stderr, "Error: unable to decompress darshan log data.\n");
+            return(-1);
+        }
+    }
+
+    return(out_buf.pos);
+}
+
+static int darshan_log_zstd_write(darshan_fd fd, struct darshan_log_map *map_p,
+    void *buf, int len, int flush_strm_flag)
+{
+    struct darshan_fd_int_state *state = fd->state;
+    size_t ret;
+    ZSTD_inBuffer in_buf;
+    ZSTD_outBuffer out_buf;
+    struct darshan_zstd_strm *zstd_strmp = (struct darshan_zstd_strm *)state->dz.comp_dat;
+
+    assert(zstd_strmp);
+
+    /* flush compressed output buffer if we are moving to a new log region */
+    if(flush_strm_flag)
+    {
+        if(darshan_log_zstd_flush(fd, state->dz.prev_reg_id) < 0)
+            return(-1);
+    }
+
+    in_buf.src = buf;
+    in_buf.size = len;
+    in_buf.pos = 0;
+
+    /* compress input data until none left */
+    while(in_buf.pos < in_buf.size)
+    {
+        /* if we are out of output, flush to log file */
+        if(state->dz.size == DARSHAN_DEF_COMP_BUF_SZ)
+        {
+            if(darshan_log_dzunload(fd, map_p) < 0)
+                return(-1);
+        }
+
+        out_buf.dst = state->dz.buf;
+        out_buf.size = DARSHAN_DEF_COMP_BUF_SZ;
+        out_buf.pos = state->dz.size;
+        ret = ZSTD_compressStream2(zstd_strmp->cctx, &out_buf, &in_buf,
+            ZSTD_e_continue);
+        if(ZSTD_isError(ret))
+        {
+            fprintf(stderr, "Error: unable to compress darshan log data.\n");
+            return(-1);
+        }
+        state->dz.size = out_buf.pos;
+    }
+
+    return(in_buf.pos);
+}
+
+static int darshan_log_zstd_flush(darshan_fd fd, int region_id)
+{
+    struct darshan_fd_int_state *state = fd->state;
+    size_t ret;
+    ZSTD_inBuffer in_buf;
+    ZSTD_outBuffer out_buf;
+    struct darshan_log_map *map_p;
+    struct darshan_zstd_strm *zstd_strmp = (struct darshan_zstd_strm *)state->dz.comp_dat;
+
+    assert(zstd_strmp);
+
+    if(region_id == DARSHAN_JOB_REGION_ID)
+        map_p = &(fd->job_map);
+    else if(region_id == DARSHAN_NAME_MAP_REGION_ID)
+        map_p = &(fd->name_map);
+    else
+        map_p = &(fd->mod_map[region_id]);
+
+    /* make sure the compressor finishes this frame */
+    in_buf.src = NULL;
+    in_buf.size = 0;
+    in_buf.pos = 0;
+    do
+    {
+        out_buf.dst = state->dz.buf;
+        out_buf.size = DARSHAN_DEF_COMP_BUF_SZ;
+        out_buf.pos = state->dz.size;
+        ret = ZSTD_compressStream2(zstd_strmp->cctx, &out_buf, &in_buf,
+            ZSTD_e_end);
+        if(ZSTD_isError(ret))
+        {
+            fprintf(stderr, "Error: unable to compress darshan log data.\n");
+            return(-1);
+        }
+        state->dz.size = out_buf.pos;
+
+        if(state->dz.size)
+        {
+            /* flush to file */
+            if(darshan_log_dzunload(fd, map_p) < 0)
+                return(-1);
+        }
+    } while(ret != 0);
+
+    return(0);
+}
+#endif
+
+static int darshan_log_noz_read(darshan_fd fd, struct darshan_log_map map,
+    void *buf, int len, int reset_strm_flag)
+{
+    struct darshan_fd_int_state *state = fd->state;
+    int ret;
+    int total_bytes = 0;
+    int cp_size;
+    int *buf_off = (int *)state->dz.comp_dat;
+
+    if(reset_strm_flag)
+        *buf_off = state->dz.size;
+
+    /* we just read data from the given log file region until we have
+     * accumulated 'len' bytes, or until the region ends
+     */
+    while(total_bytes < len)
+    {
+        /* check if we need to load more data from log file */
+        if(*buf_off == state->dz.size)
+        {
+            /* if the eor flag is set, clear it and return -- future
+             * reads of this log region will restart at the beginning
+             */
+            if(state->dz.eor)
+            {
+                state->dz.eor = 0;
+                break;
+            }
+
+            /* read more data from input file */
+            ret = darshan_log_dzload(fd, map);
+            if(ret < 0)
+                return(-1);
+            assert(state->dz.size > 0);
+        }
+
+        cp_size = (len > (state->dz.size - *buf_off)) ?
+            state->dz.size - *buf_off : len;
+        memcpy(buf, state->dz.rd_buf + *buf_off, cp_size);
+        total_bytes += cp_size;
+        *buf_off += cp_size;
+    }
+
+    return(total_bytes);
+}
+
+static int darshan_log_dzload(darshan_fd fd, struct darshan_log_map map)
+{
+    struct darshan_fd_int_state *state = fd->state;
+    int ret;
+    unsigned int remaining;
+    unsigned int read_size;
+
+    /* for mmap-backed file descriptors the whole region is available */
+    if(state->map_base)
+    {
+        if((map.off + map.len) > state->map_size || map.len > UINT_MAX)
+        {
+            fprintf(stderr, "Error: invalid log file region.\n");
+            return(-1);
+        }
+        state->dz.rd_buf = (unsigned char *)state->map_base + map.off;
+        state->dz.size = map.len;
+        state->dz.eor = 1;
+        return(0);
+    }
+
+    /* seek to the appropriate portion of the log file, if out of range */
+    if((state->pos < map.off) || (state->pos >= (map.off + map.len)))
+    {
+        ret = darshan_log_seek(fd, map.off);
+        if(ret < 0)
+        {
+            fprintf(stderr, "Error: unable to seek in darshan log file.\n");
+            return(-1);
+        }
+    }
+
+    /* read more compressed data from file to staging buffer */
+    remaining = (map.off + map.len) - state->pos;
+    read_size = (remaining > DARSHAN_DEF_COMP_BUF_SZ) ?
+        DARSHAN_DEF_COMP_BUF_SZ : remaining;
+
+    ret = darshan_log_read(fd, state->dz.buf, read_size);
+    if(ret < (int)read_size)
+    {
+        fprintf(stderr, "Error: unable to read compressed data from file.\n");
+        return(-1);
+    }
+
+    if(ret == (int)remaining)
+    {
+        state->dz.eor = 1;
+    }
+    state->dz.rd_buf = state->dz.buf;
+    state->dz.size = read_size;
+    return(0);
+}
+
+static int darshan_log_dzunload(darshan_fd fd, struct darshan_log_map *map_p)
+{
+    struct darshan_fd_int_state *state = fd->state;
+    int ret;
+
+    /* initialize map structure for this log region */
+    if(map_p->off == 0)
+        map_p->off = state->pos;
+
+    /* write more compressed data from staging buffer to file */
+    ret = darshan_log_write(fd, state->dz.buf, state->dz.size);
+    if(ret < (int)state->dz.size)
+    {
+        fprintf(stderr, "Error: unable to write compressed data to file.\n");
+        return(-1);
+    }
+
+    map_p->len += state->dz.size;
+    state->dz.size = 0;
+    return (0);
+}
+
+/* finish the compression stream of the last region written and flush it
+ * to the log file
+ */
+static int darshan_log_dzflush(darshan_fd fd)
+{
+    struct darshan_fd_int_state *state = fd->state;
+
+    switch(fd->comp_type)
+    {
+        case DARSHAN_ZLIB_COMP:
+            return(darshan_log_libz_flush(fd, state->dz.prev_reg_id));
+#ifdef HAVE_LIBBZ2
+        case DARSHAN_BZIP2_COMP:
+            return(darshan_log_bzip2_flush(fd, state->dz.prev_reg_id));
+#endif 
+#ifdef HAVE_LIBZSTD
+        case DARSHAN_ZSTD_COMP:
+            return(darshan_log_zstd_flush(fd, state->dz.prev_reg_id));
+#endif
+        default:
+            return(-1);
+    }
+}
+
+/* copy the regions spooled by region writers to the end of the log file,
+ * a bounded amount of data at a time, and point the header at them
+ */
+static int darshan_log_append_spools(darshan_fd fd)
+{
+    struct darshan_fd_int_state *state = fd->state;
+    struct darshan_region_spool *spool;
+    char *buf = NULL;
+    uint64_t copied;
+    int read_size;
+    ssize_t ret;
+    int i;
+
+    for(i = 0; i < DARSHAN_MAX_MODS; i++)
+    {
+        spool = &state->spools[i];
+        if(spool->status == DARSHAN_SPOOL_OPEN)
+        {
+            fprintf(stderr, "Error: region writer for module %s was not closed.\n",
+                darshan_module_names[i]);
+            free(buf);
+            return(-1);
+        }
+        if(spool->status != DARSHAN_SPOOL_DONE || spool->len == 0)
+            continue;
+
+        if(!buf)
+        {
+            buf = malloc(DARSHAN_DEF_COMP_BUF_SZ);
+            if(!buf)
+                return(-1);
+        }
+
+        fd->mod_map[i].off = state->pos;
+        fd->mod_map[i].len = spool->len;
+        fd->mod_ver[i] = spool->ver;
+        for(copied = 0; copied < spool->len; copied += read_size)
+        {
+            read_size = ((spool->len - copied) > DARSHAN_DEF_COMP_BUF_SZ) ?
+                DARSHAN_DEF_COMP_BUF_SZ : (spool->len - copied);
+            ret = pread(spool->fildes, buf, read_size, copied);
+            if(ret != read_size ||
+                darshan_log_write(fd, buf, read_size) != read_size)
+            {
+                fprintf(stderr, "Error: unable to copy module %s data to darshan log file.\n",
+                    darshan_module_names[i]);
+                free(buf);
+                return(-1);
+            }
+        }
+    }
+
+    free(buf);
+    return(0);
+}
+
+/* make the uncompressed data of module region 'region_id' available to
+ * darshan_log_get_record_ptr(), either in place in the mapped log file or
+ * by inflating (or copying) the whole region into a private buffer
+ */
+static int darshan_log_rec_ptr_load(darshan_fd fd, int region_id)
+{
+    struct darshan_fd_int_state *state = fd->state;
+    struct darshan_rec_ptr_state *rptr = &state->rptr;
+    struct darshan_log_map map = fd->mod_map[region_id];
+    char *tmp_buf;
+    int64_t buf_size;
+    int ret;
+
+    darshan_log_rec_ptr_unload(fd);
+    if(state->blk_map.len && region_id == state->blk_mod_id)
+        map = state->blk_map;
+    else if(DARSHAN_MOD_FLAG_ISSET(state->columnar_mods, region_id))
+    {
+        /* columnar regions are reassembled in memory, then used as is */
+        ret = darshan_log_columnar_load(fd, region_id);
+        if(ret < 0)
+            return(-1);
+    }
+
+    /* prefetched regions in native byte order can be used as is */
+    if(state->mod_cache[region_id].buf && !fd->swap_flag &&
+        !(state->blk_map.len && region_id == state->blk_mod_id))
+    {
+        rptr->base = state->mod_cache[region_id].buf;
+        rptr->len = state->mod_cache[region_id].len;
+    }
+    /* uncompressed, native byte order regions of a mapped log can be used
+     * as is, as long as they are suitably aligned for the record types
+     */
+    else if(state->map_base && fd->comp_type == DARSHAN_NO_COMP &&
+        !fd->swap_flag && (map.off % sizeof(int64_t)) == 0 &&
+        !DARSHAN_MOD_FLAG_ISSET(state->columnar_mods, region_id))
+    {
+        if((map.off + map.len) > state->map_size)
+        {
+            fprintf(stderr, "Error: invalid log file region.\n");
+            return(-1);
+        }
+        rptr->base = state->map_base + map.off;
+        rptr->len = map.len;
+    }
+    else
+    {
+        /* we don't know the uncompressed size up front, so grow the
+         * buffer until the whole region has been read
+         */
+        buf_size = (map.len < DEF_MOD_BUF_SIZE) ? DEF_MOD_BUF_SIZE : map.len;
+        if(fd->comp_type != DARSHAN_NO_COMP)
+            buf_size *= 4;
+
+        rptr->copy = malloc(buf_size);
+        if(!rptr->copy)
+            return(-1);
+
+        /* force the decompression stream to restart at the beginning of
+         * the region
+         */
+        state->dz.prev_reg_id = DARSHAN_HEADER_REGION_ID;
+        while(1)
+        {
+            ret = darshan_log_dzread(fd, region_id, rptr->copy + rptr->len,
+                buf_size - rptr->len);
+            if(ret < 0)
+            {
+                fprintf(stderr,
+                    "Error: failed to read module %s data from darshan log file.\n",
+                    darshan_module_names[region_id]);
+                darshan_log_rec_ptr_unload(fd);
+                return(-1);
+            }
+            rptr->len += ret;
+            if(rptr->len < buf_size)
+                break; /* short read, so the region has been exhausted */
+
+            /* buffer is full, grow it and keep reading */
+            if(buf_size > INT_MAX / 2)
+            {
+                fprintf(stderr, "Error: module region too large to load.\n");
+                darshan_log_rec_ptr_unload(fd);
+                return(-1);
+            }
+            buf_size *= 2;
+            tmp_buf = realloc(rptr->copy, buf_size);
+            if(!tmp_buf)
+            {
+                darshan_log_rec_ptr_unload(fd);
+                return(-1);
+            }
+            rptr->copy = tmp_buf;
+        }
+        rptr->base = rptr->copy;
+    }
+
+    rptr->region_id = region_id;
+    rptr->pos = 0;
+    rptr->swap_pos = 0;
+    return(0);
+}
+
+static void darshan_log_rec_ptr_unload(darshan_fd fd)
+{
+    struct darshan_rec_ptr_state *rptr = &fd->state->rptr;
+
+    free(rptr->copy);
+    rptr->copy = NULL;
+    rptr->base = NULL;
+    rptr->len = 0;
+    rptr->pos = 0;
+    rptr->swap_pos = 0;
+    rptr->region_id = -1;
+    return;
+}
+
+/* read the block index from the end of the log file, if there is one;
+ * a missing or inconsistent index is not an error, the log is just
+ * treated as having no index
+ */
+static int darshan_log_load_blocks(darshan_fd fd)
+{
+    struct darshan_fd_int_state *state = fd->state;
+    struct darshan_log_index_trailer trailer;
+    struct darshan_log_block *blocks;
+    struct darshan_log_block *blk;
+    struct darshan_log_map map;
+    struct stat statbuf;
+    uint64_t index_sz;
+    uint64_t i;
+    ssize_t ret;
+
+    if(state->blocks_loaded)
+        return(0);
+    state->blocks_loaded = 1;
+
+    if(fstat(state->fildes, &statbuf) != 0)
+    {
+        fprintf(stderr, "Error: unable to stat darshan log file.\n");
+        return(-1);
+    }
+    if((uint64_t)statbuf.st_size < fd->job_map.off + sizeof(trailer))
+        return(0);
+
+    /* use pread() so as not to disturb the region currently being read */
+    ret = pread(state->fildes, &trailer, sizeof(trailer),
+        statbuf.st_size - sizeof(trailer));
+    if(ret != sizeof(trailer))
+        return(0);
+    if(fd->swap_flag)
+    {
+        DARSHAN_BSWAP64(&trailer.off);
+        DARSHAN_BSWAP64(&trailer.count);
+        DARSHAN_BSWAP64(&trailer.magic_nr);
+    }
+    if(trailer.magic_nr != DARSHAN_LOG_INDEX_MAGIC_NR || trailer.count == 0)
+        return(0);
+
+    index_sz = trailer.count * sizeof(*blocks);
+    if(trailer.count > INT_MAX / sizeof(*blocks) ||
+        trailer.off + index_sz + sizeof(trailer) != (uint64_t)statbuf.st_size)
+        return(0);
+
+    blocks = malloc(index_sz);
+    if(!blocks)
+        return(-1);
+    ret = pread(state->fildes, blocks, index_sz, trailer.off);
+    if(ret != (ssize_t)index_sz)
+    {
+        free(blocks);
+        return(0);
+    }
+
+    for(i = 0; i < trailer.count; i++)
+    {
+        blk = &blocks[i];
+        if(fd->swap_flag)
+        {
+            DARSHAN_BSWAP64(&blk->first_id);
+            DARSHAN_BSWAP64(&blk->last_id);
+            DARSHAN_BSWAP64(&blk->rank);
+            DARSHAN_BSWAP64(&blk->off);
+            DARSHAN_BSWAP64(&blk->len);
+            DARSHAN_BSWAP32(&blk->mod_id);
+            DARSHAN_BSWAP32(&blk->nrecs);
+        }
+
+        /* every block must lie within its module's region */
+        if(blk->mod_id >= DARSHAN_KNOWN_MODULE_COUNT)
+            break;
+        map = fd->mod_map[blk->mod_id];
+        if(blk->len == 0 || blk->off < map.off ||
+            blk->off + blk->len > map.off + map.len)
+            break;
+    }
+    if(i < trailer.count)
+    {
+        free(blocks);
+        return(0);
+    }
+
+    qsort(blocks, trailer.count, sizeof(*blocks), darshan_log_block_cmp);
+    state->blocks = blocks;
+    state->block_cnt = trailer.count;
+    return(0);
+}
+
+static int darshan_log_block_cmp(const void *a, const void *b)
+{
+    const struct darshan_log_block *blk_a = a;
+    const struct darshan_log_block *blk_b = b;
+
+    if(blk_a->mod_id != blk_b->mod_id)
+        return((blk_a->mod_id > blk_b->mod_id) - (blk_a->mod_id < blk_b->mod_id));
+    return((blk_a->off > blk_b->off) - (blk_a->off < blk_b->off));
+}
+
+/* darshan_log_dzread() counterpart for prefetched module regions, which
+ * mimics the stream readers: a read that reaches the end of the region
+ * returns what is left, and reads restart at the beginning of the region
+ * after the end has been reported
+ */
+static int darshan_log_cache_read(struct darshan_mod_cache *cache, void *buf,
+    int len, int reset_strm_flag)
+{
+    int64_t cp_size;
+
+    if(reset_strm_flag)
+        cache->pos = 0;
+
+    if(cache->pos == cache->len)
+    {
+        cache->pos = 0;
+        return(0);
+    }
+
+    cp_size = cache->len - cache->pos;
+    if(cp_size > len)
+        cp_size = len;
+    memcpy(buf, cache->buf + cache->pos, cp_size);
+    cache->pos += cp_size;
+    if(cp_size < len)
+        cache->pos = 0;
+
+    return((int)cp_size);
+}
+
+/* get the next chunk of a region's compressed data, either directly from
+ * the mapped log file or by reading it into the context's staging buffer
+ *
+ * returns 1 if data was returned, 0 at the end of the region, -1 on failure
+ */
+static int darshan_log_region_fetch(struct darshan_region_ctx *ctx,
+    const unsigned char **in, size_t *in_len)
+{
+    struct darshan_fd_int_state *state = ctx->fd->state;
+    uint64_t remaining = ctx->map.len - ctx->in_off;
+    size_t read_size;
+    size_t read_so_far = 0;
+    ssize_t ret;
+
+    if(remaining == 0)
+        return(0);
+
+    if(state->map_base)
+    {
+        if((ctx->map.off + ctx->map.len) > state->map_size)
+            return(-1);
+        *in = (unsigned char *)state->map_base + ctx->map.off + ctx->in_off;
+        *in_len = remaining;
+        ctx->in_off += remaining;
+        return(1);
+    }
+
+    /* pread() doesn't move the shared file position */
+    read_size = (remaining > DARSHAN_DEF_COMP_BUF_SZ) ?
+        DARSHAN_DEF_COMP_BUF_SZ : remaining;
+    do
+    {
+        ret = pread(state->fildes, ctx->stage + read_so_far,
+            read_size - read_so_far,
+            ctx->map.off + ctx->in_off + read_so_far);
+        if(ret <= 0)
+            return(-1);
+        read_so_far += ret;
+    } while(read_so_far < read_size);
+
+    *in = ctx->stage;
+    *in_len = read_size;
+    ctx->in_off += read_size;
+    return(1);
+}
+
+/* make sure there is room for more inflated data in the context */
+static int darshan_log_region_grow(struct darshan_region_ctx *ctx)
+{
+    char *tmp_out;
+    int64_t new_cap;
+
+    if(ctx->out_len < ctx->out_cap)
+        return(0);
+
+    new_cap = ctx->out_cap ? (ctx->out_cap * 2) : DEF_MOD_BUF_SIZE;
+    if(new_cap > INT_MAX)
+    {
+        /* module data is read in int-sized chunks */
+        fprintf(stderr, "Error: module region too large to load.\n");
+        return(-1);
+    }
+    tmp_out = realloc(ctx->out, new_cap);
+    if(!tmp_out)
+        return(-1);
+    ctx->out = tmp_out;
+    ctx->out_cap = new_cap;
+    return(0);
+}
+
+/* inflate a whole log region into ctx->out. Regions are made up of one or
+ * more compressed streams (one per rank or block), which are decompressed
+ * back to back.
+ *
+ * returns 0 on success, -1 on failure
+ */
+static int darshan_log_region_inflate(struct darshan_region_ctx *ctx)
+{
+    darshan_fd fd = ctx->fd;
+    const unsigned char *in = NULL;
+    size_t in_len = 0;
+    int ret;
+
+    if(ctx->map.len > INT_MAX)
+    {
+        fprintf(stderr, "Error: module region too large to load.\n");
+        return(-1);
+    }
+    if(fd->comp_type == DARSHAN_NO_COMP)
+        ctx->out_cap = ctx->map.len;
+    else
+        ctx->out_cap = (ctx->map.len < DEF_MOD_BUF_SIZE / 4) ?
+            DEF_MOD_BUF_SIZE : (ctx->map.len * 4);
+    if(ctx->out_cap > INT_MAX)
+        ctx->out_cap = INT_MAX;
+    ctx->out = malloc(ctx->out_cap);
+    if(!ctx->out)
+        return(-1);
+    if(!fd->state->map_base)
+    {
+        ctx->stage = malloc(DARSHAN_DEF_COMP_BUF_SZ);
+        if(!ctx->stage)
+            return(-1);
+    }
+
+    switch(fd->comp_type)
+    {
+        case DARSHAN_ZLIB_COMP:
+        {
+            z_stream z_strm;
+            int flush_pending = 0;
+
+            memset(&z_strm, 0, sizeof(z_strm));
+            if(inflateInit(&z_strm) != Z_OK)
+                return(-1);
+            while(1)
+            {
+                /* inflate may hold more output even with no input left */
+                if(z_strm.avail_in == 0 && !flush_pending)
+                {
+                    ret = darshan_log_region_fetch(ctx, &in, &in_len);
+                    if(ret <= 0)
+                        break;
+                    z_strm.next_in = (unsigned char *)in;
+                    z_strm.avail_in = in_len;
+                }
+                ret = darshan_log_region_grow(ctx);
+                if(ret < 0)
+                    break;
+                z_strm.next_out = (unsigned char *)ctx->out + ctx->out_len;
+                z_strm.avail_out = ctx->out_cap - ctx->out_len;
+                ret = inflate(&z_strm, Z_NO_FLUSH);
+                ctx->out_len = ctx->out_cap - z_strm.avail_out;
+                flush_pending = (z_strm.avail_out == 0);
+                if(ret == Z_BUF_ERROR && z_strm.avail_in == 0)
+                    flush_pending = 0; /* no progress possible, need input */
+                else if(ret == Z_STREAM_END)
+                    inflateReset(&z_strm);
+                else if(ret != Z_OK)
+                {
+                    fprintf(stderr, "Error: unable to inflate darshan log data.\n");
+                    ret = -1;
+                    break;
+                }
+            }
+            inflateEnd(&z_strm);
+            break;
+        }
+#ifdef HAVE_LIBBZ2
+        case DARSHAN_BZIP2_COMP:
+        {
+            bz_stream bz_strm;
+            int flush_pending = 0;
+
+            memset(&bz_strm, 0, sizeof(bz_strm));
+            if(BZ2_bzDecompressInit(&bz_strm, 0, 0) != BZ_OK)
+                return(-1);
+            while(1)
+            {
+                if(bz_strm.avail_in == 0 && !flush_pending)
+                {
+                    ret = darshan_log_region_fetch(ctx, &in, &in_len);
+                    if(ret <= 0)
+                        break;
+                    bz_strm.next_in = (char *)in;
+                    bz_strm.avail_in = in_len;
+                }
+                ret = darshan_log_region_grow(ctx);
+                if(ret < 0)
+                    break;
+                bz_strm.next_out = ctx->out + ctx->out_len;
+                bz_strm.avail_out = ctx->out_cap - ctx->out_len;
+                ret = BZ2_bzDecompress(&bz_strm);
+                ctx->out_len = ctx->out_cap - bz_strm.avail_out;
+                flush_pending = (bz_strm.avail_out == 0);
+                if(ret == BZ_STREAM_END)
+                {
+                    BZ2_bzDecompressEnd(&bz_strm);
+                    BZ2_bzDecompressInit(&bz_strm, 0, 0);
+                }
+                else if(ret != BZ_OK)
+                {
+                    fprintf(stderr, "Error: unable to decompress darshan log data.\n");
+                    ret = -1;
+                    break;
+                }
+            }
+            BZ2_bzDecompressEnd(&bz_strm);
+            break;
+        }
+#endif
+#ifdef HAVE_LIBZSTD
+        case DARSHAN_ZSTD_COMP:
+        {
+            ZSTD_DCtx *dctx;
+            ZSTD_inBuffer in_buf = {NULL, 0, 0};
+            ZSTD_outBuffer out_buf;
+            size_t zret;
+            int flush_pending = 0;
+
+            dctx = ZSTD_createDCtx();
+            if(!dctx)
+                return(-1);
+            if(ctx->fd->state->zstd_ddict)
+                ZSTD_DCtx_refDDict(dctx, ctx->fd->state->zstd_ddict);
+            while(1)
+            {
+                /* the decoder may hold more output even with no input left */
+                if(in_buf.pos == in_buf.size && !flush_pending)
+                {
+                    ret = darshan_log_region_fetch(ctx, &in, &in_len);
+                    if(ret <= 0)
+                        break;
+                    in_buf.src = in;
+                    in_buf.size = in_len;
+                    in_buf.pos = 0;
+                }
+                ret = darshan_log_region_grow(ctx);
+                if(ret < 0)
+                    break;
+                out_buf.dst = ctx->out + ctx->out_len;
+                out_buf.size = ctx->out_cap - ctx->out_len;
+                out_buf.pos = 0;
+                zret = ZSTD_decompressStream(dctx, &out_buf, &in_buf);
+                if(ZSTD_isError(zret))
+                {
+                    fprintf(stderr, "Error: unable to decompress darshan log data: %s.\n",
+                        ZSTD_getErrorName(zret));
+                    ret = -1;
+                    break;
+                }
+                ctx->out_len += out_buf.pos;
+                flush_pending = (out_buf.pos == out_buf.size);
+            }
+            ZSTD_freeDCtx(dctx);
+            break;
+        }
+#endif
+        case DARSHAN_NO_COMP:
+            /* output buffer was sized to hold the whole region */
+            while((ret = darshan_log_region_fetch(ctx, &in, &in_len)) > 0)
+            {
+                memcpy(ctx->out + ctx->out_len, in, in_len);
+                ctx->out_len += in_len;
+            }
+            break;
+        default:
+            fprintf(stderr, "Error: invalid compression type.\n");
+            return(-1);
+    }
+
+    return(ret);
+}
+
+static void *darshan_log_prefetch_thread(void *arg)
+{
+    struct darshan_prefetch_queue *queue = arg;
+    struct darshan_region_ctx *ctx;
+    int ret;
+
+    while(1)
+    {
+        pthread_mutex_lock(&queue->mutex);
+        if(queue->err || queue->next == queue->count)
+        {
+            pthread_mutex_unlock(&queue->mutex);
+            break;
+        }
+        ctx = &queue->ctxs[queue->next++];
+        pthread_mutex_unlock(&queue->mutex);
+
+        if(DARSHAN_MOD_FLAG_ISSET(ctx->fd->state->columnar_mods,
+            ctx->region_id))
+            ret = darshan_log_columnar_inflate(ctx);
+        else
+            ret = darshan_log_region_inflate(ctx);
+        free(ctx->stage);
+        ctx->stage = NULL;
+        if(ret < 0)
+        {
+            fprintf(stderr,
+                "Error: failed to read module %s data from darshan log file.\n",
+                darshan_module_names[ctx->region_id]);
+            pthread_mutex_lock(&queue->mutex);
+            queue->err = 1;
+            pthread_mutex_unlock(&queue->mutex);
+        }
+    }
+
+    return(NULL);
+}
+
+/* returns the size of the given module's records, or 0 for modules whose
+ * records vary in size
+ */
+static size_t darshan_log_fixed_rec_size(int mod_idx)
+{
+    switch(mod_idx)
+    {
+        case DARSHAN_POSIX_MOD:
+            return(sizeof(struct darshan_posix_file));
+        case DARSHAN_MPIIO_MOD:
+            return(sizeof(struct darshan_mpiio_file));
+        case DARSHAN_H5F_MOD:
+            return(sizeof(struct darshan_hdf5_file));
+        case DARSHAN_H5D_MOD:
+            return(sizeof(struct darshan_hdf5_dataset));
+        case DARSHAN_PNETCDF_FILE_MOD:
+            return(sizeof(struct darshan_pnetcdf_file));
+        case DARSHAN_PNETCDF_VAR_MOD:
+            return(sizeof(struct darshan_pnetcdf_var));
+        case DARSHAN_STDIO_MOD:
+            return(sizeof(struct darshan_stdio_file));
+        case DARSHAN_BATCHIO_MOD:
+            return(sizeof(struct darshan_batchio_record));
+        case DARSHAN_OVERHEAD_MOD:
+            return(sizeof(struct darshan_overhead_record));
+        case DARSHAN_LATENCY_MOD:
+            return(sizeof(struct darshan_latency_record));
+        case DARSHAN_TIMESERIES_MOD:
+            return(sizeof(struct darshan_timeseries_record));
+        case DARSHAN_CUFILE_MOD:
+            return(sizeof(struct darshan_cufile_record));
+        case DARSHAN_MMAP_MOD:
+            return(sizeof(struct darshan_mmap_record));
+        case DARSHAN_ROLLUP_MOD:
+            return(sizeof(struct darshan_rollup_record));
+        case DARSHAN_PHASE_MOD:
+            return(sizeof(struct darshan_phase_record));
+        case DARSHAN_ATTRIB_MOD:
+            return(sizeof(struct darshan_attrib_record));
+        default:
+            return(0);
+    }
+}
+
+/* read the column directory at the start of a columnar block: the number
+ * of columns followed by the compressed length of each column
+ *
+ * returns the directory on success (to be freed by the caller), NULL on
+ * failure
+ */
+static uint64_t *darshan_log_columnar_dir(darshan_fd fd,
+    struct darshan_log_block *blk)
+{
+    struct darshan_fd_int_state *state = fd->state;
+    uint64_t ncols;
+    uint64_t *dir;
+    uint64_t total;
+    uint64_t i;
+    ssize_t ret;
+
+    if(blk->len < sizeof(ncols) || blk->nrecs == 0)
+        goto fail;
+    if(state->map_base)
+    {
+        if((blk->off + blk->len) > state->map_size)
+            goto fail;
+        memcpy(&ncols, state->map_base + blk->off, sizeof(ncols));
+    }
+    else if(pread(state->fildes, &ncols, sizeof(ncols), blk->off) !=
+        sizeof(ncols))
+        goto fail;
+    if(fd->swap_flag)
+        DARSHAN_BSWAP64(&ncols);
+    if(ncols == 0 || ncols >= (blk->len / sizeof(ncols)))
+        goto fail;
+
+    dir = malloc((ncols + 1) * sizeof(*dir));
+    if(!dir)
+        return(NULL);
+    if(state->map_base)
+        memcpy(dir, state->map_base + blk->off, (ncols + 1) * sizeof(*dir));
+    else
+    {
+        ret = pread(state->fildes, dir, (ncols + 1) * sizeof(*dir), blk->off);
+        if(ret != (ssize_t)((ncols + 1) * sizeof(*dir)))
+        {
+            free(dir);
+            goto fail;
+        }
+    }
+    if(fd->swap_flag)
+        darshan_log_bswap64_array(dir, ncols + 1);
+
+    /* the columns must exactly fill the rest of the block */
+    total = (ncols + 1) * sizeof(*dir);
+    for(i = 1; i <= ncols; i++)
+    {
+        if(dir[i] > blk->len - total)
+        {
+            free(dir);
+            goto fail;
+        }
+        total += dir[i];
+    }
+    if(total != blk->len)
+    {
+        free(dir);
+        goto fail;
+    }
+
+    return(dir);
+
+fail:
+    fprintf(stderr, "Error: invalid columnar block of module %s.\n",
+        darshan_module_names[blk->mod_id]);
+    return(NULL);
+}
+
+/* decompress columns 'cols' of a columnar block, whose column directory
+ * is 'dir', into 'out' as blk->nrecs rows of 'ncols' 8-byte values.
+ * Passing all of the block's columns in order yields its records. Values
+ * are left in the byte order of the log.
+ *
+ * returns 0 on success, -1 on failure
+ */
+static int darshan_log_columnar_block(darshan_fd fd,
+    struct darshan_log_block *blk, uint64_t *dir, const int *cols, int ncols,
+    char *out)
+{
+    struct darshan_region_ctx ctx;
+    uint64_t col_off;
+    uint64_t r;
+    int c, j;
+    int ret;
+
+    for(j = 0; j < ncols; j++)
+    {
+        if(cols[j] < 0 || (uint64_t)cols[j] >= dir[0])
+        {
+            fprintf(stderr, "Error: invalid %s column %d.\n",
+                darshan_module_names[blk->mod_id], cols[j]);
+            return(-1);
+        }
+
+        col_off = blk->off + ((dir[0] + 1) * sizeof(*dir));
+        for(c = 0; c < cols[j]; c++)
+            col_off += dir[c + 1];
+
+        /* each column is an independent stream, inflated like a region */
+        memset(&ctx, 0, sizeof(ctx));
+        ctx.fd = fd;
+        ctx.region_id = blk->mod_id;
+        ctx.map.off = col_off;
+        ctx.map.len = dir[cols[j] + 1];
+        ret = darshan_log_region_inflate(&ctx);
+        free(ctx.stage);
+        if(ret == 0 && ctx.out_len != (int64_t)(blk->nrecs * sizeof(uint64_t)))
+        {
+            fprintf(stderr, "Error: invalid columnar block of module %s.\n",
+                darshan_module_names[blk->mod_id]);
+            ret = -1;
+        }
+        if(ret < 0)
+        {
+            free(ctx.out);
+            return(-1);
+        }
+
+        for(r = 0; r < blk->nrecs; r++)
+            memcpy(out + (((r * ncols) + j) * sizeof(uint64_t)),
+                ctx.out + (r * sizeof(uint64_t)), sizeof(uint64_t));
+        free(ctx.out);
+    }
+
+    return(0);
+}
+
+/* append the reassembled records of a columnar block to ctx->out
+ *
+ * returns 0 on success, -1 on failure
+ */
+static int darshan_log_columnar_append(struct darshan_region_ctx *ctx,
+    struct darshan_log_block *blk)
+{
+    uint64_t *dir;
+    int64_t blk_size;
+    char *tmp_out;
+    int *cols;
+    uint64_t c;
+    int ret;
+
+    dir = darshan_log_columnar_dir(ctx->fd, blk);
+    if(!dir)
+        return(-1);
+    blk_size = blk->nrecs * dir[0] * sizeof(uint64_t);
+    if(ctx->out_len + blk_size > INT_MAX)
+    {
+        /* module data is read in int-sized chunks */
+        fprintf(stderr, "Error: module region too large to load.\n");
+        free(dir);
+        return(-1);
+    }
+    tmp_out = realloc(ctx->out, ctx->out_len + blk_size);
+    if(tmp_out)
+        ctx->out = tmp_out;
+    cols = malloc(dir[0] * sizeof(*cols));
+    if(!tmp_out || !cols)
+    {
+        free(cols);
+        free(dir);
+        return(-1);
+    }
+    for(c = 0; c < dir[0]; c++)
+        cols[c] = c;
+
+    ret = darshan_log_columnar_block(ctx->fd, blk, dir, cols, dir[0],
+        ctx->out + ctx->out_len);
+    free(cols);
+    free(dir);
+    if(ret < 0)
+        return(-1);
+    ctx->out_len += blk_size;
+    ctx->out_cap = ctx->out_len;
+    return(0);
+}
+
+/* reassemble the records of all blocks of a columnar module region into
+ * ctx->out; the block index must already be loaded
+ *
+ * returns 0 on success, -1 on failure
+ */
+static int darshan_log_columnar_inflate(struct darshan_region_ctx *ctx)
+{
+    struct darshan_fd_int_state *state = ctx->fd->state;
+    int found = 0;
+    int i;
+    int ret;
+
+    for(i = 0; i < state->block_cnt; i++)
+    {
+        if(state->blocks[i].mod_id != (uint32_t)ctx->region_id)
+            continue;
+        found = 1;
+        ret = darshan_log_columnar_append(ctx, &state->blocks[i]);
+        if(ret < 0)
+            return(-1);
+    }
+
+    if(!found)
+    {
+        fprintf(stderr, "Error: columnar module %s data requires the log's block index.\n",
+            darshan_module_names[ctx->region_id]);
+        return(-1);
+    }
+
+    return(0);
+}
+
+/* reassemble a columnar module region in the module's cache, if that
+ * hasn't been done already
+ *
+ * returns 0 on success, -1 on failure
+ */
+static int darshan_log_columnar_load(darshan_fd fd, int region_id)
+{
+    struct darshan_fd_int_state *state = fd->state;
+    struct darshan_region_ctx ctx;
+    int ret;
+
+    if(state->mod_cache[region_id].buf)
+        return(0);
+
+    ret = darshan_log_load_blocks(fd);
+    if(ret < 0)
+        return(-1);
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.fd = fd;
+    ctx.region_id = region_id;
+    ret = darshan_log_columnar_inflate(&ctx);
+    if(ret < 0)
+    {
+        fprintf(stderr,
+            "Error: failed to read module %s data from darshan log file.\n",
+            darshan_module_names[region_id]);
+        free(ctx.out);
+        return(-1);
+    }
+
+    state->mod_cache[region_id].buf = ctx.out;
+    state->mod_cache[region_id].len = ctx.out_len;
+    state->mod_cache[region_id].pos = 0;
+    return(0);
+}
+
+/* darshan_log_dzread() counterpart for columnar module regions, which
+ * serves reassembled records from memory. If reads of the region are
+ * restricted to a single block, only that block is reassembled.
+ */
+static int darshan_log_columnar_read(darshan_fd fd, int region_id, void *buf,
+    int len, int reset_strm_flag)
+{
+    struct darshan_fd_int_state *state = fd->state;
+    struct darshan_region_ctx ctx;
+    int i;
+    int ret;
+
+    if(!(state->blk_map.len && region_id == state->blk_mod_id))
+    {
+        ret = darshan_log_columnar_load(fd, region_id);
+        if(ret < 0)
+            return(-1);
+        return(darshan_log_cache_read(&state->mod_cache[region_id], buf, len,
+            reset_strm_flag));
+    }
+
+    if(!state->col_blk.buf || state->col_blk_off != state->blk_map.off)
+    {
+        free(state->col_blk.buf);
+        memset(&state->col_blk, 0, sizeof(state->col_blk));
+
+        /* select_block() only accepts blocks of the loaded index */
+        for(i = 0; i < state->block_cnt; i++)
+        {
+            if(state->blocks[i].mod_id == (uint32_t)region_id &&
+                state->blocks[i].off == state->blk_map.off)
+                break;
+        }
+        if(i == state->block_cnt)
+            return(-1);
+
+        memset(&ctx, 0, sizeof(ctx));
+        ctx.fd = fd;
+        ctx.region_id = region_id;
+        ret = darshan_log_columnar_append(&ctx, &state->blocks[i]);
+        if(ret < 0)
+        {
+            free(ctx.out);
+            return(-1);
+        }
+        state->col_blk.buf = ctx.out;
+        state->col_blk.len = ctx.out_len;
+        state->col_blk_off = state->blk_map.off;
+        reset_strm_flag = 1;
+    }
+
+    return(darshan_log_cache_read(&state->col_blk, buf, len, reset_strm_flag));
+}
+
+/* forget the position of darshan_log_get_columns() */
+static void darshan_log_column_scan_reset(darshan_fd fd)
+{
+    struct darshan_column_scan *scan = &fd->state->col_scan;
+
+    free(scan->cols);
+    free(scan->vals);
+    memset(scan, 0, sizeof(*scan));
+    scan->block = -1;
+    return;
+}
+
+/* sort regions largest first, so the longest decompressions start early */
+static int darshan_log_region_len_cmp(const void *a, const void *b)
+{
+    const struct darshan_region_ctx *ctx_a = a;
+    const struct darshan_region_ctx *ctx_b = b;
+
+    return((ctx_a->map.len < ctx_b->map.len) - (ctx_a->map.len > ctx_b->map.len));
+}
+
+/********************************************************
+ *          backwards compatibility functions           *
+ ********************************************************/
+
+static int darshan_log_get_namerecs_3_00(void *name_rec_buf, int buf_len,
+    int swap_flag, darshan_name_rec_add_fn add, void *add_arg,
+    darshan_record_id *whitelist, int whitelist_count,
+    struct darshan_name_dirs *dirs)
+{
+    char *buf_ptr;
+    darshan_record_id *rec_id_ptr;
+    uint32_t *path_len_ptr;
+    char *path_ptr;
+    int rec_len;
+    int buf_processed = 0;
+
+    /* work through the name record buffer -- deserialize the mapping data and
+     * pass it on to the add function
+     * NOTE: these mapping pairs are variable in length, so we have to be able
+     * to handle incomplete mappings temporarily here
+     */
+    buf_ptr = name_rec_buf;
+    while(buf_len > (sizeof(darshan_record_id) + sizeof(uint32_t)))
+    {
+        /* see if we have enough buf space to read in the next full record */
+        path_len_ptr = (uint32_t *)(buf_ptr + sizeof(darshan_record_id));
+        if(swap_flag)
+            DARSHAN_BSWAP32(path_len_ptr);
+        rec_len = sizeof(darshan_record_id) + sizeof(uint32_t) + *path_len_ptr;
+
+        /* we need to read more before we continue deserializing */
+        if(buf_len < rec_len)
+            break;
+
+        /* get pointers for each field of this darshan record */
+        /* NOTE: darshan record hash serialization method: 
+         *          ... darshan_record_id | (uint32_t) path_len | path ...
+         */
+        rec_id_ptr = (darshan_record_id *)buf_ptr;
+        path_ptr = (char *)(buf_ptr + sizeof(darshan_record_id) + sizeof(uint32_t));
+
+        if(swap_flag)
+            /* we need to sort out endianness issues before deserializing */
+            DARSHAN_BSWAP64(rec_id_ptr);
+
+        if(!whitelist ||
+            whitelist_filter(*rec_id_ptr, whitelist, whitelist_count))
+        {
+            if(add(add_arg, *rec_id_ptr, path_ptr, *path_len_ptr) < 0)
+                return(-1);
+        }
+
+        buf_ptr += rec_len;
+        buf_len -= rec_len;
+        buf_processed += rec_len;
+    }
+
+    return(buf_processed);
+}
+
+static int darshan_log_get_namerecs_3_41(void *name_rec_buf, int buf_len,
+    int swap_flag, darshan_name_rec_add_fn add, void *add_arg,
+    darshan_record_id *whitelist, int whitelist_count,
+    struct darshan_name_dirs *dirs)
+{
+    struct darshan_name_record *name_rec;
+    char *tmp_p;
+    int buf_processed = 0;
+    int name_len;
+    int rec_len;
+
+    /* work through the name record buffer -- deserialize the record data
+     * and pass it on to the add function
+     * NOTE: these mapping pairs are variable in length, so we have to be able
+     * to handle incomplete mappings temporarily here
+     */
+    name_rec = (struct darshan_name_record *)name_rec_buf;
+    while(buf_len > sizeof(darshan_record_id) + 1)
+    {
+        if(strnlen(name_rec->name, buf_len - sizeof(darshan_record_id)) ==
+            (buf_len - sizeof(darshan_record_id)))
+        {
+            /* if this record name's terminating null character is not
+             * present, we need to read more of the buffer before continuing
+             */
+            break;
+        }
+        name_len = strlen(name_rec->name);
+        rec_len = sizeof(darshan_record_id) + name_len + 1;
+
+        if(swap_flag)
+        {
+            /* we need to sort out endianness issues before deserializing */
+            DARSHAN_BSWAP64(&(name_rec->id));
+        }
+
+        if(!whitelist ||
+            whitelist_filter(name_rec->id, whitelist, whitelist_count))
+        {
+            if(add(add_arg, name_rec->id, name_rec->name, name_len) < 0)
+                return(-1);
+        }
+
+        tmp_p = (char *)name_rec + rec_len;
+        name_rec = (struct darshan_name_record *)tmp_p;
+        buf_len -= rec_len;
+        buf_processed += rec_len;
+    }
+
+    return(buf_processed);
+}
+
+/*
+ * Support functions for use with other languages
+ */
+
+/*
+ * darshan_log_get_modules
+ *
+ * Gets list of modules present in logs and returns the info
+ */
+void darshan_log_get_modules(darshan_fd fd,
+                             struct darshan_mod_info **mods,
+                             int* count)
+{
+    int i;
+    int j;
+
+    if(!fd)
+    {
+        fprintf(stderr, "Error: invalid Darshan log file handle.\n");
+        *count = 0;
+        return;
+    }
+
+    *mods = malloc(sizeof(**mods) * DARSHAN_MAX_MODS);
+    assert(*mods);
+
+    for (i = 0, j = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+    {
+        if (fd->mod_map[i].len)
+        {
+            (*mods)[j].name          = darshan_module_names[i];
+            (*mods)[j].len           = fd->mod_map[i].len;
+            (*mods)[j].ver           = fd->mod_ver[i];
+            (*mods)[j].partial_flag  = DARSHAN_MOD_FLAG_ISSET(fd->partial_flag, i);
+            (*mods)[j].idx           = i;
+            j += 1;
+        }
+    }
+    for (i = DARSHAN_KNOWN_MODULE_COUNT; i < DARSHAN_MAX_MODS; i++)
+    {
+        if (fd->mod_map[i].len)
+        {
+            /* we don't know the names of any modules in this region */
+            (*mods)[j].name = NULL;
+            (*mods)[j].len  = fd->mod_map[i].len;
+            (*mods)[j].ver  = fd->mod_ver[i];
+            (*mods)[j].idx  = i;
+            j += 1;
+        }
+    }
+
+    *count = j;
+}
+
+/*
+ * darshan_log_get_name_records
+ *
+ * Gets list of hashed name_records present in logs and returns the info
+ */
+void darshan_log_get_name_records(darshan_fd fd,
+                              struct darshan_name_record_info **name_records,
+                              int* count)
+{
+    darshan_log_get_filtered_name_records(fd, name_records, count, NULL, 0);
+}
+
+/*
+ * darshan_log_lookup_name_records
+ *
+ * Get filtered list of hashed name_records in logs and returns the info
+ */
+void darshan_log_get_filtered_name_records(darshan_fd fd,
+                              struct darshan_name_record_info **name_records,
+                              int* count,
+                              darshan_record_id *whitelist, int whitelist_count)
+{
+
+    int ret;
+    struct darshan_name_table *name_table = NULL;
+
+    /* read table of darshan records */
+    ret = darshan_log_get_filtered_name_table(fd, &name_table, whitelist, whitelist_count);
+    if(ret < 0)
+    {
+        darshan_log_close(fd);
+        return;
+    }
+
+    int num = name_table->count;
+    *name_records = malloc(sizeof(**name_records) * num);
+    assert(*name_records);
+
+    int i;
+    for(i = 0; i < num; i++)
+    {
+        (*name_records)[i].id = name_table->entries[i].id;
+        /* NOTE: the name table is not exposed to callers, so record names
+         * are strdup()'d here and the table is freed before returning.
+         * Callers are responsible for freeing these names, just as they
+         * are responsible for freeing the name_records array allocated
+         * above.
+         */
+        (*name_records)[i].name =
+            strdup(name_table->names + name_table->entries[i].name_off);
+    }
+    darshan_name_table_free(name_table);
+ 
+    *count = num;
+
+}
+
+/*
+ * darshan_log_get_record 
+ *
+ * Wrapper to hide the mod_logutils callback functions.
+ */
+int darshan_log_get_record(darshan_fd fd,
+                           int mod_idx,
+                           void **buf)
+{
+    int r;
+
+    r = mod_logutils[mod_idx]->log_get_record(fd, buf);
+
+    return r;
+}
+
+/*
+ * darshan_log_put_record
+ *
+ * Write the record in 'buf' to the given module's data, as read by
+ * darshan_log_get_record().  Records must be written one module at a
+ * time, in the order of the module ids, after the name records.
+ *
+ * returns 0 on success, -1 on failure
+ */
+int darshan_log_put_record(darshan_fd fd,
+                           int mod_idx,
+                           void *buf)
+{
+    if(mod_idx < 0 || mod_idx >= DARSHAN_KNOWN_MODULE_COUNT ||
+        !mod_logutils[mod_idx])
+    {
+        fprintf(stderr, "Error: invalid Darshan module id.\n");
+        return(-1);
+    }
+
+    return(mod_logutils[mod_idx]->log_put_record(fd, buf));
 }
 
-static int darshan_log_bzip2_write(darshan_fd fd, struct darshan_log_map *map_p,
-    void *buf, int len, int flush_strm_flag)
+/*
+ * darshan_log_get_record_ptr
+ *
+ * Like darshan_log_get_record(), but rather than copying the next record
+ * of the given module into a caller-provided buffer, set '*rec' to point
+ * at the record in place.  For modules that support it, the record lives
+ * in the mapped log file (uncompressed, native byte order logs opened
+ * with darshan_log_open_mmap()) or in a copy of the module region that is
+ * inflated once, with any byte swapping done in place.  Other modules are
+ * read into a buffer owned by 'fd' that is reused on each call.
+ *
+ * The returned record must not be modified or freed by the caller.  It
+ * remains valid until the next call for a different module (or, for
+ * modules read by copying, the next call for any module) or until
+ * 'fd' is closed.  Records of a module should not be read with both this
+ * function and darshan_log_get_record().
+ *
+ * returns 1 on success, 0 on no more module data, -1 on error
+ */
+int darshan_log_get_record_ptr(darshan_fd fd,
+                               int mod_idx,
+                               void **rec)
 {
-    struct darshan_fd_int_state *state = fd->state;
+    struct darshan_fd_int_state *state;
+    struct darshan_rec_ptr_state *rptr;
+    struct darshan_mod_logutil_funcs *funcs;
+    int rec_len;
     int ret;
-    int total_bytes = 0;
-    int tmp_in_bytes;
-    int tmp_out_bytes;
-    bz_stream *bz_strmp = (bz_stream *)state->dz.comp_dat;
 
-    assert(bz_strmp);
+    if(!fd)
+    {
+        fprintf(stderr, "Error: invalid Darshan log file handle.\n");
+        return(-1);
+    }
+    state = fd->state;
+    assert(state);
+    rptr = &state->rptr;
 
-    /* flush compressed output buffer if we are moving to a new log region */
-    if(flush_strm_flag)
+    if(mod_idx < 0 || mod_idx >= DARSHAN_KNOWN_MODULE_COUNT ||
+        !mod_logutils[mod_idx])
     {
-        ret = darshan_log_bzip2_flush(fd, state->dz.prev_reg_id);
+        fprintf(stderr, "Error: invalid Darshan module id.\n");
+        return(-1);
+    }
+    funcs = mod_logutils[mod_idx];
+
+    if(fd->mod_map[mod_idx].len == 0)
+        return(0); /* no data corresponding to this mod_id */
+
+    /* records can only be used in place if the module knows how to swap
+     * them and they do not need to be converted from an older version
+     */
+    if(!funcs->log_swap_record || !funcs->log_sizeof_record ||
+        fd->mod_ver[mod_idx] != darshan_module_versions[mod_idx])
+    {
+        /* let the module allocate a buffer of the right size, as some
+         * records (e.g., DXT) have no fixed upper bound on their size
+         */
+        free(rptr->rec_buf);
+        rptr->rec_buf = NULL;
+        ret = funcs->log_get_record(fd, &rptr->rec_buf);
+        if(ret == 1)
+            *rec = rptr->rec_buf;
+        return(ret);
+    }
+
+    if(rptr->region_id != mod_idx)
+    {
+        ret = darshan_log_rec_ptr_load(fd, mod_idx);
         if(ret < 0)
             return(-1);
     }
 
-    bz_strmp->avail_in = len;
-    bz_strmp->next_in = buf;
+    /* at the end of the region; future calls restart at the beginning */
+    if(rptr->pos >= rptr->len)
+    {
+        rptr->pos = 0;
+        return(0);
+    }
 
-    /* compress input data until none left */
-    while(bz_strmp->avail_in)
+    /* these are fixed-size records, so the size can be determined before
+     * the record is swapped
+     */
+    rec_len = funcs->log_sizeof_record(rptr->base + rptr->pos);
+    if(rec_len <= 0 || rec_len > (rptr->len - rptr->pos))
     {
-        /* if we are out of output, flush to log file */
-        if(bz_strmp->avail_out == 0)
-        {
-            assert(state->dz.size == DARSHAN_DEF_COMP_BUF_SZ);
+        /* partial record at the end of the region */
+        rptr->pos = 0;
+        return(0);
+    }
 
-            ret = darshan_log_dzunload(fd, map_p);
-            if(ret < 0)
-                return(-1);
+    if(fd->swap_flag && rptr->pos >= rptr->swap_pos)
+    {
+        funcs->log_swap_record(rptr->base + rptr->pos);
+        rptr->swap_pos = rptr->pos + rec_len;
+    }
 
-            bz_strmp->avail_out = DARSHAN_DEF_COMP_BUF_SZ;
-            bz_strmp->next_out = (char *)state->dz.buf;
-        }
+    *rec = rptr->base + rptr->pos;
+    rptr->pos += rec_len;
+    return(1);
+}
 
-        tmp_in_bytes = bz_strmp->total_in_lo32;
-        tmp_out_bytes = bz_strmp->total_out_lo32;
-        ret = BZ2_bzCompress(bz_strmp, BZ_RUN);
-        if(ret != BZ_RUN_OK)
-        {
-            fprintf(stderr, "Error: unable to compress darshan log data.\n");
-            return(-1);
-        }
-        total_bytes += (bz_strmp->total_in_lo32 - tmp_in_bytes);
-        state->dz.size += (bz_strmp->total_out_lo32 - tmp_out_bytes);
+/*
+ * darshan_log_get_blocks
+ *
+ * Get the block index entries for module 'mod_id', sorted by file offset.
+ * '*blocks' points into memory owned by 'fd' that remains valid until
+ * 'fd' is closed. '*count' is set to 0 if the log has no block index for
+ * this module, in which case the module region can only be read as a
+ * whole.
+ *
+ * returns 0 on success, -1 on failure
+ */
+int darshan_log_get_blocks(darshan_fd fd,
+                           darshan_module_id mod_id,
+                           struct darshan_log_block **blocks,
+                           int *count)
+{
+    struct darshan_fd_int_state *state;
+    int i;
+    int ret;
+
+    if(!fd)
+    {
+        fprintf(stderr, "Error: invalid Darshan log file handle.\n");
+        return(-1);
     }
+    state = fd->state;
+    assert(state);
 
-    return(total_bytes);
+    *blocks = NULL;
+    *count = 0;
+    ret = darshan_log_load_blocks(fd);
+    if(ret < 0)
+        return(-1);
+
+    for(i = 0; i < state->block_cnt; i++)
+    {
+        if(state->blocks[i].mod_id != (uint32_t)mod_id)
+            continue;
+        if(*count == 0)
+            *blocks = &state->blocks[i];
+        (*count)++;
+    }
+
+    return(0);
 }
 
-static int darshan_log_bzip2_flush(darshan_fd fd, int region_id)
+/*
+ * darshan_log_select_block
+ *
+ * Restrict subsequent reads of module 'mod_id' (using darshan_log_get_mod()
+ * or any of the record reading functions) to the block with index 'block'
+ * in the array returned by darshan_log_get_blocks(), or lift the
+ * restriction if 'block' is -1. In either case, reads of the module
+ * restart at the beginning of the selected block or region.
+ *
+ * returns 0 on success, -1 on failure
+ */
+int darshan_log_select_block(darshan_fd fd,
+                             darshan_module_id mod_id,
+                             int block)
 {
-    struct darshan_fd_int_state *state = fd->state;
+    struct darshan_fd_int_state *state;
+    struct darshan_log_block *blocks;
+    int count;
     int ret;
-    int tmp_out_bytes;
-    struct darshan_log_map *map_p;
-    bz_stream *bz_strmp = (bz_stream *)state->dz.comp_dat;
 
-    assert(bz_strmp);
+    if(!fd)
+    {
+        fprintf(stderr, "Error: invalid Darshan log file handle.\n");
+        return(-1);
+    }
+    state = fd->state;
+    assert(state);
 
-    if(region_id == DARSHAN_JOB_REGION_ID)
-        map_p = &(fd->job_map);
-    else if(region_id == DARSHAN_NAME_MAP_REGION_ID)
-        map_p = &(fd->name_map);
-    else
-        map_p = &(fd->mod_map[region_id]);
+    if(mod_id < 0 || mod_id >= DARSHAN_KNOWN_MODULE_COUNT)
+    {
+        fprintf(stderr, "Error: invalid Darshan module id.\n");
+        return(-1);
+    }
 
-    /* make sure deflate finishes this stream */
-    bz_strmp->avail_in = 0;
-    bz_strmp->next_in = NULL;
-    do
+    if(block < 0)
     {
-        tmp_out_bytes = bz_strmp->total_out_lo32;
-        ret = BZ2_bzCompress(bz_strmp, BZ_FINISH);
+        if(state->blk_mod_id == mod_id)
+            state->blk_map.len = 0;
+    }
+    else
+    {
+        ret = darshan_log_get_blocks(fd, mod_id, &blocks, &count);
         if(ret < 0)
+            return(-1);
+        if(block >= count)
         {
-            fprintf(stderr, "Error: unable to compress darshan log data.\n");
+            fprintf(stderr, "Error: invalid %s block index %d.\n",
+                darshan_module_names[mod_id], block);
             return(-1);
         }
-        state->dz.size += (bz_strmp->total_out_lo32 - tmp_out_bytes);
+        state->blk_mod_id = mod_id;
+        state->blk_map.off = blocks[block].off;
+        state->blk_map.len = blocks[block].len;
+    }
 
-        if(state->dz.size)
-        {
-            /* flush to file */
-            if(darshan_log_dzunload(fd, map_p) < 0)
-                return(-1);
+    /* force the module's stream to restart, and the next read of the log
+     * file to seek, even if we were already within the selected range
+     */
+    if(state->dz.prev_reg_id == mod_id)
+        state->dz.prev_reg_id = DARSHAN_HEADER_REGION_ID;
+    if(state->rptr.region_id == mod_id)
+        darshan_log_rec_ptr_unload(fd);
+    state->pos = -1;
 
-            bz_strmp->avail_out = DARSHAN_DEF_COMP_BUF_SZ;
-            bz_strmp->next_out = (char *)state->dz.buf;
-        }
-    } while (ret != BZ_STREAM_END);
-    
-    BZ2_bzCompressEnd(bz_strmp);
-    BZ2_bzCompressInit(bz_strmp, 9, 1, 30);
     return(0);
 }
-#endif
 
-static int darshan_log_noz_read(darshan_fd fd, struct darshan_log_map map,
-    void *buf, int len, int reset_strm_flag)
+/*
+ * darshan_log_get_record_by_id
+ *
+ * Find the record of module 'mod_idx' with the given record id, reading
+ * it into '*buf' as darshan_log_get_record() would. If the log has a
+ * block index, only blocks whose record id range covers 'rec_id' are
+ * decompressed; otherwise the whole module region is scanned. Afterwards,
+ * reads of the module restart at the beginning of its region.
+ *
+ * returns 1 if the record was found, 0 if not, -1 on error
+ */
+int darshan_log_get_record_by_id(darshan_fd fd,
+                                 int mod_idx,
+                                 darshan_record_id rec_id,
+                                 void **buf)
 {
-    struct darshan_fd_int_state *state = fd->state;
+    struct darshan_log_block *blocks;
+    int count;
+    int i;
     int ret;
-    int total_bytes = 0;
-    int cp_size;
-    int *buf_off = (int *)state->dz.comp_dat;
 
-    if(reset_strm_flag)
-        *buf_off = state->dz.size;
+    if(mod_idx < 0 || mod_idx >= DARSHAN_KNOWN_MODULE_COUNT ||
+        !mod_logutils[mod_idx])
+    {
+        fprintf(stderr, "Error: invalid Darshan module id.\n");
+        return(-1);
+    }
 
-    /* we just read data from the given log file region until we have
-     * accumulated 'len' bytes, or until the region ends
-     */
-    while(total_bytes < len)
+    ret = darshan_log_get_blocks(fd, mod_idx, &blocks, &count);
+    if(ret < 0)
+        return(-1);
+
+    i = 0;
+    do
     {
-        /* check if we need to load more data from log file */
-        if(*buf_off == state->dz.size)
+        if(count > 0)
         {
-            /* if the eor flag is set, clear it and return -- future
-             * reads of this log region will restart at the beginning
-             */
-            if(state->dz.eor)
-            {
-                state->dz.eor = 0;
-                break;
-            }
-
-            /* read more data from input file */
-            ret = darshan_log_dzload(fd, map);
-            if(ret < 0)
-                return(-1);
-            assert(state->dz.size > 0);
+            if(rec_id < blocks[i].first_id || rec_id > blocks[i].last_id)
+                continue;
+            ret = darshan_log_select_block(fd, mod_idx, i);
         }
+        else
+            ret = darshan_log_select_block(fd, mod_idx, -1);
+        if(ret < 0)
+            break;
 
-        cp_size = (len > (state->dz.size - *buf_off)) ?
-            state->dz.size - *buf_off : len;
-        memcpy(buf, state->dz.buf + *buf_off, cp_size);
-        total_bytes += cp_size;
-        *buf_off += cp_size;
-    }
+        while((ret = mod_logutils[mod_idx]->log_get_record(fd, buf)) == 1)
+        {
+            if(((struct darshan_base_record *)*buf)->id == rec_id)
+                break;
+        }
+        if(ret != 0)
+            break;
+    } while(++i < count);
 
-    return(total_bytes);
+    (void)darshan_log_select_block(fd, mod_idx, -1);
+    return(ret);
 }
 
-static int darshan_log_dzload(darshan_fd fd, struct darshan_log_map map)
+/*
+ * darshan_log_get_records_batch
+ *
+ * Read up to 'max_records' of the next records of the given module into
+ * 'buf', which is treated as an array of the module's record structure
+ * (e.g., struct darshan_posix_file) and must be large enough to hold
+ * 'max_records' of them.  The number of records read is returned in 'n',
+ * which is 0 once all of the module's records have been read.  Records
+ * are read in the same order, and from the same position in the module's
+ * data, as with darshan_log_get_record().  Only modules with fixed-size
+ * records are supported.
+ *
+ * returns 0 on success, -1 on failure
+ */
+int darshan_log_get_records_batch(darshan_fd fd,
+                                  int mod_idx,
+                                  void *buf,
+                                  int max_records,
+                                  int *n)
 {
-    struct darshan_fd_int_state *state = fd->state;
+    struct darshan_fd_int_state *state;
+    size_t rec_size;
+    void *rec;
     int ret;
-    unsigned int remaining;
-    unsigned int read_size;
 
-    /* seek to the appropriate portion of the log file, if out of range */
-    if((state->pos < map.off) || (state->pos >= (map.off + map.len)))
+    *n = 0;
+    if(!fd)
     {
-        ret = darshan_log_seek(fd, map.off);
-        if(ret < 0)
-        {
-            fprintf(stderr, "Error: unable to seek in darshan log file.\n");
-            return(-1);
-        }
+        fprintf(stderr, "Error: invalid Darshan log file handle.\n");
+        return(-1);
     }
+    state = fd->state;
+    assert(state);
 
-    /* read more compressed data from file to staging buffer */
-    remaining = (map.off + map.len) - state->pos;
-    read_size = (remaining > DARSHAN_DEF_COMP_BUF_SZ) ?
-        DARSHAN_DEF_COMP_BUF_SZ : remaining;
+    if(mod_idx < 0 || mod_idx >= DARSHAN_KNOWN_MODULE_COUNT ||
+        !mod_logutils[mod_idx])
+    {
+        fprintf(stderr, "Error: invalid Darshan module id.\n");
+        return(-1);
+    }
 
-    ret = darshan_log_read(fd, state->dz.buf, read_size);
-    if(ret < (int)read_size)
+    rec_size = darshan_log_fixed_rec_size(mod_idx);
+    if(rec_size == 0)
     {
-        fprintf(stderr, "Error: unable to read compressed data from file.\n");
+        fprintf(stderr, "Error: module %s does not support batch record reads.\n",
+            darshan_module_names[mod_idx]);
         return(-1);
     }
 
-    if(ret == (int)remaining)
-    {
-        state->dz.eor = 1;
-    }
-    state->dz.size = read_size;
+    /* the end of the module's records was reached by the previous call;
+     * report it now, as the module's next read starts over
+     */
+    if(DARSHAN_MOD_FLAG_ISSET(state->batch_end_flags, mod_idx))
+    {
+        DARSHAN_MOD_FLAG_UNSET(state->batch_end_flags, mod_idx);
+        return(0);
+    }
+
+    /* each module decodes (and upconverts) its records straight into
+     * the caller's array
+     */
+    while(*n < max_records)
+    {
+        rec = (char *)buf + (*n * rec_size);
+        ret = mod_logutils[mod_idx]->log_get_record(fd, &rec);
+        if(ret < 0)
+            return(-1);
+        else if(ret == 0)
+        {
+            if(*n > 0)
+                DARSHAN_MOD_FLAG_SET(state->batch_end_flags, mod_idx);
+            break;
+        }
+        (*n)++;
+    }
+
     return(0);
 }
 
-static int darshan_log_dzunload(darshan_fd fd, struct darshan_log_map *map_p)
+/*
+ * darshan_log_get_columns
+ *
+ * Read the values of columns 'cols' of up to 'max_records' of the next
+ * records of the given module into 'buf', which receives 'ncols' 8-byte
+ * values (int64_t or double, as in the record) per record, in the order
+ * given by 'cols'.  Columns are numbered by the position of each 8-byte
+ * field in the module's record structure (see DARSHAN_COLUMN()).  The
+ * number of records read is returned in 'n', which is 0 once all of the
+ * module's records have been read; the next call then starts over.
+ *
+ * For modules stored in the columnar layout, only the requested columns
+ * are decompressed.  Other modules are read as with
+ * darshan_log_get_records_batch(), so only modules with fixed-size records
+ * are supported.  A scan should not be interleaved with other reads of
+ * the same module.
+ *
+ * returns 0 on success, -1 on failure
+ */
+int darshan_log_get_columns(darshan_fd fd,
+                            int mod_idx,
+                            const int *cols,
+                            int ncols,
+                            void *buf,
+                            int max_records,
+                            int *n)
 {
-    struct darshan_fd_int_state *state = fd->state;
+    struct darshan_fd_int_state *state;
+    struct darshan_column_scan *scan;
+    struct darshan_log_block *blocks;
+    uint64_t *dir;
+    size_t rec_size;
+    char *rows;
+    int64_t cp_recs;
+    int count;
+    int got;
+    int i, j;
     int ret;
 
-    /* initialize map structure for this log region */
-    if(map_p->off == 0)
-        map_p->off = state->pos;
-
-    /* write more compressed data from staging buffer to file */
-    ret = darshan_log_write(fd, state->dz.buf, state->dz.size);
-    if(ret < (int)state->dz.size)
+    *n = 0;
+    if(!fd)
     {
-        fprintf(stderr, "Error: unable to write compressed data to file.\n");
+        fprintf(stderr, "Error: invalid Darshan log file handle.\n");
         return(-1);
     }
+    state = fd->state;
+    assert(state);
+    scan = &state->col_scan;
 
-    map_p->len += state->dz.size;
-    state->dz.size = 0;
-    return (0);
-}
-
-/********************************************************
- *          backwards compatibility functions           *
- ********************************************************/
-
-static int darshan_log_get_namerecs_3_00(void *name_rec_buf, int buf_len,
-    int swap_flag, struct darshan_name_record_ref **hash,
-    darshan_record_id *whitelist, int whitelist_count)
-{
-    struct darshan_name_record_ref *ref;
-    char *buf_ptr;
-    darshan_record_id *rec_id_ptr;
-    uint32_t *path_len_ptr;
-    char *path_ptr;
-    int rec_len;
-    int buf_processed = 0;
+    if(mod_idx < 0 || mod_idx >= DARSHAN_KNOWN_MODULE_COUNT ||
+        !mod_logutils[mod_idx] || ncols <= 0)
+    {
+        fprintf(stderr, "Error: invalid Darshan module id.\n");
+        return(-1);
+    }
 
-    /* work through the name record buffer -- deserialize the mapping data and
-     * add to the output hash table
-     * NOTE: these mapping pairs are variable in length, so we have to be able
-     * to handle incomplete mappings temporarily here
+    /* columnar data is only in the current layout of module records;
+     * older versions are reassembled and upconverted by record
      */
-    buf_ptr = name_rec_buf;
-    while(buf_len > (sizeof(darshan_record_id) + sizeof(uint32_t)))
+    if(!DARSHAN_MOD_FLAG_ISSET(state->columnar_mods, mod_idx) ||
+        fd->mod_ver[mod_idx] != (uint32_t)darshan_module_versions[mod_idx])
     {
-        /* see if we have enough buf space to read in the next full record */
-        path_len_ptr = (uint32_t *)(buf_ptr + sizeof(darshan_record_id));
-        if(swap_flag)
-            DARSHAN_BSWAP32(path_len_ptr);
-        rec_len = sizeof(darshan_record_id) + sizeof(uint32_t) + *path_len_ptr;
-
-        /* we need to read more before we continue deserializing */
-        if(buf_len < rec_len)
-            break;
-
-        /* get pointers for each field of this darshan record */
-        /* NOTE: darshan record hash serialization method: 
-         *          ... darshan_record_id | (uint32_t) path_len | path ...
-         */
-        rec_id_ptr = (darshan_record_id *)buf_ptr;
-        path_ptr = (char *)(buf_ptr + sizeof(darshan_record_id) + sizeof(uint32_t));
-
-        if(swap_flag)
-            /* we need to sort out endianness issues before deserializing */
-            DARSHAN_BSWAP64(rec_id_ptr);
-
-        HASH_FIND(hlink, *hash, rec_id_ptr, sizeof(darshan_record_id), ref);
-        if(!ref && (!whitelist ||
-            whitelist_filter(*rec_id_ptr, whitelist, whitelist_count)))
+        rec_size = darshan_log_fixed_rec_size(mod_idx);
+        if(rec_size == 0)
+        {
+            fprintf(stderr, "Error: module %s does not support column reads.\n",
+                darshan_module_names[mod_idx]);
+            return(-1);
+        }
+        for(j = 0; j < ncols; j++)
         {
-            ref = malloc(sizeof(*ref));
-            if(!ref)
+            if(cols[j] < 0 || (size_t)cols[j] >= rec_size / sizeof(uint64_t))
+            {
+                fprintf(stderr, "Error: invalid %s column %d.\n",
+                    darshan_module_names[mod_idx], cols[j]);
                 return(-1);
+            }
+        }
 
-            ref->name_record = malloc(rec_len - sizeof(uint32_t) + 1);
-            if(!ref->name_record)
+        count = (max_records < 256) ? max_records : 256;
+        rows = malloc(count * rec_size);
+        if(!rows)
+            return(-1);
+        while(*n < max_records)
+        {
+            count = ((max_records - *n) < 256) ? (max_records - *n) : 256;
+            ret = darshan_log_get_records_batch(fd, mod_idx, rows, count, &got);
+            if(ret < 0)
             {
-                free(ref);
+                free(rows);
                 return(-1);
             }
+            if(got == 0)
+            {
+                /* the module's reads start over, so report the end on
+                 * the next call
+                 */
+                if(*n > 0)
+                    DARSHAN_MOD_FLAG_SET(state->batch_end_flags, mod_idx);
+                break;
+            }
+            for(i = 0; i < got; i++, (*n)++)
+                for(j = 0; j < ncols; j++)
+                    memcpy((char *)buf + (((*n * ncols) + j) * sizeof(uint64_t)),
+                        rows + (i * rec_size) + (cols[j] * sizeof(uint64_t)),
+                        sizeof(uint64_t));
+            if(got < count)
+                break;
+        }
+        free(rows);
+        return(0);
+    }
+
+    ret = darshan_log_get_blocks(fd, mod_idx, &blocks, &count);
+    if(ret < 0)
+        return(-1);
+    if(count == 0)
+    {
+        fprintf(stderr, "Error: columnar module %s data requires the log's block index.\n",
+            darshan_module_names[mod_idx]);
+        return(-1);
+    }
+
+    if(scan->mod_id != mod_idx || scan->ncols == 0)
+    {
+        darshan_log_column_scan_reset(fd);
+        scan->mod_id = mod_idx;
+    }
 
-            /* transform the serialized name record into the zero-length
-             * array structure darshan uses to track name records
+    while(*n < max_records)
+    {
+        if(scan->rec == scan->nrecs || scan->ncols != ncols ||
+            memcmp(scan->cols, cols, ncols * sizeof(*cols)) != 0)
+        {
+            /* move on to the next block, unless only the requested
+             * columns changed
              */
-            ref->name_record->id = *rec_id_ptr;
-            memcpy(ref->name_record->name, path_ptr, *path_len_ptr);
-            ref->name_record->name[*path_len_ptr] = '\0';
+            if(scan->rec == scan->nrecs)
+            {
+                if(scan->block + 1 >= count)
+                {
+                    /* report the end of the records on its own */
+                    if(*n == 0)
+                        darshan_log_column_scan_reset(fd);
+                    break;
+                }
+                scan->block++;
+                scan->rec = 0;
+            }
 
-            /* add this record to the hash */
-            HASH_ADD(hlink, *hash, name_record->id, sizeof(darshan_record_id), ref);
+            free(scan->vals);
+            free(scan->cols);
+            scan->nrecs = blocks[scan->block].nrecs;
+            scan->vals = malloc(scan->nrecs * ncols * sizeof(uint64_t));
+            scan->cols = malloc(ncols * sizeof(*cols));
+            scan->ncols = ncols;
+            dir = darshan_log_columnar_dir(fd, &blocks[scan->block]);
+            if(!scan->vals || !scan->cols || !dir)
+                ret = -1;
+            else
+                ret = darshan_log_columnar_block(fd, &blocks[scan->block], dir,
+                    cols, ncols, scan->vals);
+            free(dir);
+            if(ret < 0)
+            {
+                darshan_log_column_scan_reset(fd);
+                return(-1);
+            }
+            memcpy(scan->cols, cols, ncols * sizeof(*cols));
+            if(fd->swap_flag)
+                darshan_log_bswap64_array(scan->vals, scan->nrecs * ncols);
         }
 
-        buf_ptr += rec_len;
-        buf_len -= rec_len;
-        buf_processed += rec_len;
+        cp_recs = scan->nrecs - scan->rec;
+        if(cp_recs > max_records - *n)
+            cp_recs = max_records - *n;
+        memcpy((char *)buf + (*n * ncols * sizeof(uint64_t)),
+            scan->vals + (scan->rec * ncols * sizeof(uint64_t)),
+            cp_recs * ncols * sizeof(uint64_t));
+        scan->rec += cp_recs;
+        *n += cp_recs;
     }
 
-    return(buf_processed);
+    return(0);
 }
 
 /*
- * Support functions for use with other languages
- */
-
-/*
- * darshan_log_get_modules
+ * darshan_log_bswap64_array
  *
- * Gets list of modules present in logs and returns the info
+ * Byte swap an array of 'count' 64-bit values in place.  Records of most
+ * modules are made up entirely of 64-bit fields, so a whole record (or an
+ * array of records) can be swapped with a single call.  This is written as
+ * a tight loop over whole words, which compilers turn into vector byte
+ * shuffles.
  */
-void darshan_log_get_modules(darshan_fd fd,
-                             struct darshan_mod_info **mods,
-                             int* count)
+void darshan_log_bswap64_array(void *buf, int count)
 {
+    char *p = buf;
+    uint64_t val;
     int i;
-    int j;
 
-    if(!fd)
+    for(i = 0; i < count; i++, p += sizeof(val))
     {
-        fprintf(stderr, "Error: invalid Darshan log file handle.\n");
-        *count = 0;
-        return;
+        /* memcpy avoids assumptions about the alignment of 'buf' */
+        memcpy(&val, p, sizeof(val));
+#if defined(__GNUC__)
+        val = __builtin_bswap64(val);
+#else
+        DARSHAN_BSWAP64(&val);
+#endif
+        memcpy(p, &val, sizeof(val));
     }
 
-    *mods = malloc(sizeof(**mods) * DARSHAN_MAX_MODS);
-    assert(*mods);
+    return;
+}
 
-    for (i = 0, j = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+/*
+ * darshan_log_agg_counters
+ *
+ * Combine the integer counters of a record covered by 'runs' with those of
+ * an aggregate record. Each run is handled by a loop over consecutive
+ * counters without data dependent branches, which compilers can unroll or
+ * vectorize; this is much cheaper than deciding what to do one counter at
+ * a time. Sums are computed with unsigned arithmetic to avoid undefined
+ * behavior on overflow; the result is the same.
+ */
+void darshan_log_agg_counters(int64_t *agg, const int64_t *rec,
+    const struct darshan_agg_run *runs, int nruns)
+{
+    int64_t *a;
+    const int64_t *r;
+    int64_t sum;
+    int n, i, count;
+
+    for(n = 0; n < nruns; n++)
     {
-        if (fd->mod_map[i].len)
+        a = agg + runs[n].first;
+        r = rec + runs[n].first;
+        count = runs[n].last - runs[n].first + 1;
+        switch(runs[n].op)
         {
-            (*mods)[j].name          = darshan_module_names[i];
-            (*mods)[j].len           = fd->mod_map[i].len;
-            (*mods)[j].ver           = fd->mod_ver[i];
-            (*mods)[j].partial_flag  = DARSHAN_MOD_FLAG_ISSET(fd->partial_flag, i);
-            (*mods)[j].idx           = i;
-            j += 1;
+            case DARSHAN_AGG_SUM:
+                for(i = 0; i < count; i++)
+                    a[i] = (int64_t)((uint64_t)a[i] + (uint64_t)r[i]);
+                break;
+            case DARSHAN_AGG_SUM_VALID:
+                /* make sure invalid counters are -1 exactly */
+                for(i = 0; i < count; i++)
+                {
+                    sum = (int64_t)((uint64_t)a[i] + (uint64_t)r[i]);
+                    a[i] = (sum < 0) ? -1 : sum;
+                }
+                break;
+            case DARSHAN_AGG_MAX:
+                for(i = 0; i < count; i++)
+                    a[i] = (r[i] > a[i]) ? r[i] : a[i];
+                break;
+            case DARSHAN_AGG_SET:
+                memcpy(a, r, count * sizeof(*a));
+                break;
+            default:
+                break;
         }
     }
-    for (i = DARSHAN_KNOWN_MODULE_COUNT; i < DARSHAN_MAX_MODS; i++)
+
+    return;
+}
+
+/*
+ * darshan_log_agg_fcounters
+ *
+ * Floating point counterpart of darshan_log_agg_counters().
+ */
+void darshan_log_agg_fcounters(double *agg, const double *rec,
+    const struct darshan_agg_run *runs, int nruns)
+{
+    double *a;
+    const double *r;
+    int n, i, count;
+
+    for(n = 0; n < nruns; n++)
     {
-        if (fd->mod_map[i].len)
+        a = agg + runs[n].first;
+        r = rec + runs[n].first;
+        count = runs[n].last - runs[n].first + 1;
+        switch(runs[n].op)
         {
-            /* we don't know the names of any modules in this region */
-            (*mods)[j].name = NULL;
-            (*mods)[j].len  = fd->mod_map[i].len;
-            (*mods)[j].ver  = fd->mod_ver[i];
-            (*mods)[j].idx  = i;
-            j += 1;
+            case DARSHAN_AGG_SUM:
+                for(i = 0; i < count; i++)
+                    a[i] += r[i];
+                break;
+            case DARSHAN_AGG_SUM_VALID:
+                for(i = 0; i < count; i++)
+                    a[i] = (r[i] > 0) ? a[i] + r[i] : a[i];
+                break;
+            case DARSHAN_AGG_MAX:
+                for(i = 0; i < count; i++)
+                    a[i] = (r[i] > a[i]) ? r[i] : a[i];
+                break;
+            case DARSHAN_AGG_MIN_NONZERO:
+                for(i = 0; i < count; i++)
+                    a[i] = (r[i] > 0 && (a[i] == 0 || r[i] < a[i])) ? r[i] : a[i];
+                break;
+            case DARSHAN_AGG_SET:
+                memcpy(a, r, count * sizeof(*a));
+                break;
+            default:
+                break;
         }
     }
 
-    *count = j;
+    return;
 }
 
 /*
- * darshan_log_get_name_records
+ * darshan_log_agg_records
  *
- * Gets list of hashed name_records present in logs and returns the info
+ * Aggregate 'count' records of module 'mod_id', stored back to back in
+ * 'rec_buf', into 'agg_rec' using the module's log_agg_records() rules
+ * (or log_agg_records_batch(), when the module provides it). 'rec_size'
+ * is the size of each record, or 0 to ask the module for the size of
+ * every record. 'init_flag' applies to the first record only, so that
+ * records can be aggregated over several calls.
+ *
+ * returns 0 on success, -1 if the module does not support aggregation
  */
-void darshan_log_get_name_records(darshan_fd fd,
-                              struct darshan_name_record_info **name_records,
-                              int* count)
+int darshan_log_agg_records(darshan_module_id mod_id, void *rec_buf,
+    int count, int rec_size, void *agg_rec, int init_flag)
 {
-    int ret;
-    struct darshan_name_record_ref *name_hash = NULL;
-    struct darshan_name_record_ref *tmp = NULL;
-    struct darshan_name_record_ref *curr = NULL;
+    char *rec = rec_buf;
+    int i;
 
-    /* read hash of darshan records */
-    ret = darshan_log_get_namehash(fd, &name_hash);
-    if(ret < 0)
+    if(mod_id >= DARSHAN_KNOWN_MODULE_COUNT || !mod_logutils[mod_id] ||
+       !mod_logutils[mod_id]->log_agg_records)
+        return(-1);
+    if(rec_size <= 0 && !mod_logutils[mod_id]->log_sizeof_record)
+        return(-1);
+
+    if(count <= 0)
+        return(0);
+
+    if(mod_logutils[mod_id]->log_agg_records_batch)
     {
-        darshan_log_close(fd);
-        return;
+        mod_logutils[mod_id]->log_agg_records_batch(rec_buf, count, agg_rec,
+            init_flag);
+        return(0);
     }
 
-    int num = HASH_CNT(hlink, name_hash);
-    *name_records = malloc(sizeof(**name_records) * num);
-    assert(*name_records);
-
-    int i = 0;
-    HASH_ITER(hlink, name_hash, curr, tmp)
-    {
-        (*name_records)[i].id = curr->name_record->id;
-        /* NOTE: darshan_log_get_namehash() call above returns a
-         * hash table that has allocated name record memory for records
-         * in the log file. This hash table is not exposed to callers,
-         * though, so it's this function's responsibility to destroy the
-         * table and free corresponding memory before returning, as is
-         * done below. This also requires that we strdup() record names
-         * that are returned to callers, who are then responsible for
-         * freeing this memory, just as they are responsible for freeing
-         * the name_records array allocated above.
-         */
-        (*name_records)[i].name = strdup(curr->name_record->name);
-        HASH_DELETE(hlink, name_hash, curr);
-        free(curr->name_record);
-        free(curr);
-        i++;
+    for(i = 0; i < count; i++)
+    {
+        mod_logutils[mod_id]->log_agg_records(rec, agg_rec,
+            init_flag && i == 0);
+        if(rec_size > 0)
+            rec += rec_size;
+        else
+            rec += mod_logutils[mod_id]->log_sizeof_record(rec);
     }
- 
-    *count = num;
 
+    return(0);
 }
 
 /*
- * darshan_log_lookup_name_records
+ * darshan_log_prefetch_mods
  *
- * Get filtered list of hashed name_records in logs and returns the info
+ * Decompress the regions of all modules present in the log ahead of time,
+ * using up to 'nthreads' threads (one per online processor if 'nthreads'
+ * is 0) to inflate independent regions concurrently. Subsequent reads of
+ * these modules, by darshan_log_get_mod() or any of the record reading
+ * functions, are served from memory and restart at the beginning of each
+ * module's data. The inflated data is kept until 'fd' is closed.
+ *
+ * returns 0 on success, -1 on failure
  */
-void darshan_log_get_filtered_name_records(darshan_fd fd,
-                              struct darshan_name_record_info **name_records,
-                              int* count,
-                              darshan_record_id *whitelist, int whitelist_count)
+int darshan_log_prefetch_mods(darshan_fd fd, int nthreads)
 {
+    struct darshan_fd_int_state *state;
+    struct darshan_prefetch_queue queue;
+    struct darshan_region_ctx *ctx;
+    pthread_t *threads;
+    int started = 0;
+    int i;
 
-    int ret;
-    struct darshan_name_record_ref *name_hash = NULL;
-    struct darshan_name_record_ref *tmp = NULL;
-    struct darshan_name_record_ref *curr = NULL;
-
-    /* read hash of darshan records */
-    ret = darshan_log_get_filtered_namehash(fd, &name_hash, whitelist, whitelist_count);
-    if(ret < 0)
+    if(!fd)
     {
-        darshan_log_close(fd);
-        return;
+        fprintf(stderr, "Error: invalid Darshan log file handle.\n");
+        return(-1);
     }
+    state = fd->state;
+    assert(state);
 
-    int num = HASH_CNT(hlink, name_hash);
-    *name_records = malloc(sizeof(**name_records) * num);
-    assert(*name_records);
+    memset(&queue, 0, sizeof(queue));
+    queue.ctxs = malloc(DARSHAN_KNOWN_MODULE_COUNT * sizeof(*queue.ctxs));
+    if(!queue.ctxs)
+        return(-1);
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+    {
+        if(fd->mod_map[i].len == 0 || state->mod_cache[i].buf)
+            continue;
+        if(fd->mod_ver[i] > darshan_module_versions[i])
+            continue; /* let darshan_log_get_mod() report these */
+        ctx = &queue.ctxs[queue.count++];
+        memset(ctx, 0, sizeof(*ctx));
+        ctx->fd = fd;
+        ctx->region_id = i;
+        ctx->map = fd->mod_map[i];
+    }
+    qsort(queue.ctxs, queue.count, sizeof(*queue.ctxs),
+        darshan_log_region_len_cmp);
 
-    int i = 0;
-    HASH_ITER(hlink, name_hash, curr, tmp)
-    {
-        (*name_records)[i].id = curr->name_record->id;
-        /* NOTE: darshan_log_get_filtered_namehash() call above returns a
-         * hash table that has allocated name record memory for records
-         * in the log file. This hash table is not exposed to callers,
-         * though, so it's this function's responsibility to destroy the
-         * table and free corresponding memory before returning, as is
-         * done below. This also requires that we strdup() record names
-         * that are returned to callers, who are then responsible for
-         * freeing this memory, just as they are responsible for freeing
-         * the name_records array allocated above.
-         */
-        (*name_records)[i].name = strdup(curr->name_record->name);
-        HASH_DELETE(hlink, name_hash, curr);
-        free(curr->name_record);
-        free(curr);
-        i++;
+    /* columnar regions are located using the block index, which threads
+     * can't load themselves
+     */
+    if(state->columnar_mods && darshan_log_load_blocks(fd) < 0)
+    {
+        free(queue.ctxs);
+        return(-1);
     }
- 
-    *count = num;
 
-}
+    if(nthreads <= 0)
+        nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+    if(nthreads > queue.count)
+        nthreads = queue.count;
 
-/*
- * darshan_log_get_record 
- *
- * Wrapper to hide the mod_logutils callback functions.
- */
-int darshan_log_get_record(darshan_fd fd,
-                           int mod_idx,
-                           void **buf)
-{
-    int r;
+    /* the calling thread decompresses regions too */
+    threads = malloc(nthreads * sizeof(*threads));
+    pthread_mutex_init(&queue.mutex, NULL);
+    for(i = 1; threads && i < nthreads; i++)
+    {
+        if(pthread_create(&threads[started], NULL,
+            darshan_log_prefetch_thread, &queue) != 0)
+            break;
+        started++;
+    }
+    darshan_log_prefetch_thread(&queue);
+    for(i = 0; i < started; i++)
+        pthread_join(threads[i], NULL);
+    pthread_mutex_destroy(&queue.mutex);
+    free(threads);
 
-    r = mod_logutils[mod_idx]->log_get_record(fd, buf);
+    for(i = 0; i < queue.count; i++)
+    {
+        ctx = &queue.ctxs[i];
+        if(queue.err)
+        {
+            free(ctx->out);
+            continue;
+        }
+        state->mod_cache[ctx->region_id].buf = ctx->out;
+        state->mod_cache[ctx->region_id].len = ctx->out_len;
+        state->mod_cache[ctx->region_id].pos = 0;
+        /* restart the module's reads from the beginning of the region */
+        if(state->dz.prev_reg_id == ctx->region_id)
+            state->dz.prev_reg_id = DARSHAN_HEADER_REGION_ID;
+        if(state->rptr.region_id == ctx->region_id)
+            darshan_log_rec_ptr_unload(fd);
+    }
+    free(queue.ctxs);
 
-    return r;
+    return(queue.err ? -1 : 0);
 }
 
 /*
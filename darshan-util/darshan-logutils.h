@@ -8,6 +8,7 @@
 #define __DARSHAN_LOG_UTILS_H
 
 #include <limits.h>
+#include <stddef.h>
 #include <zlib.h>
 
 #include "uthash-1.9.2/src/uthash.h"
@@ -34,6 +35,8 @@ struct darshan_fd_s
     uint64_t partial_flag;
     /* compression type used on log file */
     enum darshan_comp_type comp_type;
+    /* id of the trained zstd dictionary used on log file, or 0 if none */
+    uint32_t comp_dict_id;
     /* log file offset/length maps for each log file region */
     struct darshan_log_map job_map;
     struct darshan_log_map name_map;
@@ -86,6 +89,24 @@ struct darshan_name_record_info
     char *name;
 };
 
+/* compact, read-only alternative to the name record hash table: entries
+ * are sorted by record id and all names are stored back to back in a
+ * single buffer
+ */
+struct darshan_name_table_entry
+{
+    darshan_record_id id;
+    /* offset of the record's null-terminated name in 'names' */
+    uint64_t name_off;
+};
+
+struct darshan_name_table
+{
+    struct darshan_name_table_entry *entries;
+    int64_t count;
+    char *names;
+};
+
 
 
 /* functions to be implemented by each module for integration with
@@ -154,6 +175,17 @@ struct darshan_mod_logutil_funcs
         void *agg_rec,
         int init_flag
     );
+    /* aggregate 'count' records, stored back to back in 'rec_buf', into
+     * an aggregate record; equivalent to calling log_agg_records() on each
+     * record in turn, with 'init_flag' applying to the first record only
+     * (optional)
+     */
+    void (*log_agg_records_batch)(
+        void *rec_buf,
+        int count,
+        void *agg_rec,
+        int init_flag
+    );
     /* report the true size of the record, including variable-length data if
      * present
      */
@@ -171,6 +203,13 @@ struct darshan_mod_logutil_funcs
         double* rw_only_time,  /* time spent in read/write fns, if known */
         int64_t* rank,        /* rank associated with record (-1 for shared) */
         int64_t* nprocs);     /* nprocs that accessed it */
+    /* byte swap a record of the current log format version in place
+     * (optional). Modules with fixed-size records that provide this
+     * function can be read without copying using
+     * darshan_log_get_record_ptr().
+     */
+    void (*log_swap_record)(
+        void *rec);
 };
 
 extern struct darshan_mod_logutil_funcs *mod_logutils[];
@@ -183,6 +222,15 @@ extern struct darshan_mod_logutil_funcs *mod_logutils[];
 #include "darshan-lustre-logutils.h"
 #include "darshan-stdio-logutils.h"
 #include "darshan-heatmap-logutils.h"
+#include "darshan-batchio-logutils.h"
+#include "darshan-overhead-logutils.h"
+#include "darshan-latency-logutils.h"
+#include "darshan-timeseries-logutils.h"
+#include "darshan-cufile-logutils.h"
+#include "darshan-mmap-logutils.h"
+#include "darshan-rollup-logutils.h"
+#include "darshan-phase-logutils.h"
+#include "darshan-attrib-logutils.h"
 
 /* DXT */
 #include "darshan-dxt-logutils.h"
@@ -195,7 +243,13 @@ extern struct darshan_mod_logutil_funcs *mod_logutils[];
 #include "darshan-apmpi-logutils.h"
 #endif
 
+/* these functions keep all of their state in the darshan_fd they are given
+ * (the mod_logutils[] tables are only read), so different threads may use
+ * different darshan_fd handles at the same time; a single darshan_fd must
+ * not be used by more than one thread at a time.
+ */
 darshan_fd darshan_log_open(const char *name);
+darshan_fd darshan_log_open_mmap(const char *name);
 darshan_fd darshan_log_create(const char *name, enum darshan_comp_type comp_type,
     int partial_flag);
 int darshan_log_get_job(darshan_fd fd, struct darshan_job *job);
@@ -210,10 +264,23 @@ int darshan_log_get_namehash(darshan_fd fd, struct darshan_name_record_ref **has
 int darshan_log_get_filtered_namehash(darshan_fd fd, struct darshan_name_record_ref **hash,
     darshan_record_id *whitelist, int whitelist_count);
 int darshan_log_put_namehash(darshan_fd fd, struct darshan_name_record_ref *hash);
+int darshan_log_put_name_records(darshan_fd fd,
+    darshan_record_id *ids, char **names, int count);
+int darshan_log_get_name_table(darshan_fd fd, struct darshan_name_table **table);
+int darshan_log_get_filtered_name_table(darshan_fd fd,
+    struct darshan_name_table **table,
+    darshan_record_id *whitelist, int whitelist_count);
+char *darshan_name_table_lookup(struct darshan_name_table *table,
+    darshan_record_id id);
+void darshan_name_table_free(struct darshan_name_table *table);
 int darshan_log_get_mod(darshan_fd fd, darshan_module_id mod_id,
     void *mod_buf, int mod_buf_sz);
 int darshan_log_put_mod(darshan_fd fd, darshan_module_id mod_id,
     void *mod_buf, int mod_buf_sz, int ver);
+int darshan_log_set_zstd_dict(darshan_fd fd, const void *dict, size_t dict_len);
+int darshan_log_get_region_sample(darshan_fd fd, int mod_id, void *buf, int len);
+darshan_fd darshan_log_region_writer_open(darshan_fd fd, darshan_module_id mod_id);
+int darshan_log_region_writer_close(darshan_fd region_fd);
 void darshan_log_close(darshan_fd file);
 void darshan_log_print_version_warnings(const char *version_string);
 char *darshan_log_get_lib_version(void);
@@ -226,9 +293,29 @@ void darshan_log_get_filtered_name_records(darshan_fd fd,
     struct darshan_name_record_info **mods, int* count,
     darshan_record_id *whitelist, int whitelist_count);
 int darshan_log_get_record(darshan_fd fd, int mod_idx, void **buf);
+int darshan_log_put_record(darshan_fd fd, int mod_idx, void *buf);
+int darshan_log_get_record_ptr(darshan_fd fd, int mod_idx, void **rec);
+int darshan_log_get_blocks(darshan_fd fd, darshan_module_id mod_id,
+    struct darshan_log_block **blocks, int *count);
+int darshan_log_select_block(darshan_fd fd, darshan_module_id mod_id,
+    int block);
+int darshan_log_get_record_by_id(darshan_fd fd, int mod_idx,
+    darshan_record_id rec_id, void **buf);
+int darshan_log_get_records_batch(darshan_fd fd, int mod_idx, void *buf,
+    int max_records, int *n);
+int darshan_log_get_columns(darshan_fd fd, int mod_idx, const int *cols,
+    int ncols, void *buf, int max_records, int *n);
+int darshan_log_prefetch_mods(darshan_fd fd, int nthreads);
 void darshan_free(void *ptr);
 
 
+/* column number of an 8-byte field of a module record structure, for use
+ * with darshan_log_get_columns(), e.g.
+ * DARSHAN_COLUMN(struct darshan_posix_file, counters[POSIX_READS])
+ */
+#define DARSHAN_COLUMN(__rec_type, __field) \
+    (offsetof(__rec_type, __field) / sizeof(uint64_t))
+
 /* convenience macros for printing Darshan counters */
 #define DARSHAN_PRINT_HEADER() \
     printf("\n#<module>\t<rank>\t<record id>\t<counter>\t<value>" \
@@ -288,6 +375,8 @@ void darshan_free(void *ptr);
     __dst_char[7] = __src_char[0]; \
     memcpy(__ptr, __dst_char, 8); \
 } while(0)
+/* byte swap an array of 'count' 64-bit values in place */
+void darshan_log_bswap64_array(void *buf, int count);
 #define DARSHAN_BSWAP32(__ptr) do {\
     char __dst_char[4]; \
     char* __src_char = (char*)__ptr; \
@@ -298,6 +387,47 @@ void darshan_free(void *ptr);
     memcpy(__ptr, __dst_char, 4); \
 } while(0)
 
+/* how a counter of an incoming record is combined with the same counter of
+ * an aggregate record
+ */
+enum darshan_agg_op
+{
+    DARSHAN_AGG_SUM,        /* sum */
+    DARSHAN_AGG_SUM_VALID,  /* sum; integer sums that become negative are
+                             * set to -1, and FP values <= 0 are skipped */
+    DARSHAN_AGG_MAX,        /* maximum */
+    DARSHAN_AGG_MIN_NONZERO,/* minimum value > 0 (FP counters only) */
+    DARSHAN_AGG_SET,        /* set to the incoming value */
+};
+
+/* counters 'first' through 'last' (inclusive) of a module's integer or FP
+ * counter array, which are all aggregated with the same operation. Modules
+ * describe their counters with tables of runs, so that most counters can
+ * be aggregated with tight loops over consecutive counters.
+ */
+struct darshan_agg_run
+{
+    int first;
+    int last;
+    enum darshan_agg_op op;
+};
+
+/* combine the counters of a record covered by 'runs' into an aggregate
+ * record
+ */
+void darshan_log_agg_counters(int64_t *agg, const int64_t *rec,
+    const struct darshan_agg_run *runs, int nruns);
+void darshan_log_agg_fcounters(double *agg, const double *rec,
+    const struct darshan_agg_run *runs, int nruns);
+
+/* aggregate 'count' back to back records of a module, each 'rec_size'
+ * bytes long (0 to ask the module), into 'agg_rec' as the module's
+ * log_agg_records() function would; returns -1 if the module does not
+ * support aggregation
+ */
+int darshan_log_agg_records(darshan_module_id mod_id, void *rec_buf,
+    int count, int rec_size, void *agg_rec, int init_flag);
+
 /*****************************************************************
  * The functions in this section make up the accumulator API, which is a
  * mechanism for aggregating records to produce derived metrics and
@@ -391,6 +521,55 @@ int darshan_accumulator_emit(darshan_accumulator             accumulator,
                              struct darshan_derived_metrics* metrics,
                              void*                           aggregation_record);
 
+/* Combine the state of accumulator 'src' into accumulator 'dst', as if the
+ * records injected into 'src' had been injected into 'dst'.  Both must
+ * have been created for the same module and job_nprocs.  'src' must still
+ * be destroyed afterwards, but is no longer meaningful.  Accumulators do
+ * not share state, so records can be injected into several accumulators
+ * from different threads, and the accumulators merged once done.
+ */
+int darshan_accumulator_merge(darshan_accumulator dst,
+                              darshan_accumulator src);
+
+/* an access size and the number of accesses of that size */
+struct darshan_access_size {
+    int64_t size;
+    int64_t count;
+};
+
+/* Emit the histogram of the common access sizes (ACCESS*_ACCESS and
+ * ACCESS*_COUNT counters) of all accumulated records, in order of
+ * increasing access size.  At most 'max_sizes' entries are stored in
+ * 'sizes'.  Returns the number of distinct access sizes, which may be
+ * larger than 'max_sizes', or -1 if the module does not record common
+ * access sizes.
+ */
+int darshan_accumulator_emit_access_sizes(darshan_accumulator        accumulator,
+                                          struct darshan_access_size* sizes,
+                                          int                        max_sizes);
+
+/* data accessed in the files of a category (e.g., a file system) */
+struct darshan_category_io {
+    int64_t bytes_read;
+    int64_t bytes_written;
+    int64_t files_read;     /* files with at least 1 byte read */
+    int64_t files_written;  /* files with at least 1 byte written */
+};
+
+/* Sum the data accessed in the files seen by 'acc_count' accumulators by
+ * category, where the file 'ids[i]' belongs to category 'categories[i]'
+ * (in [0, category_count)); files that are not listed are skipped.  A
+ * file seen by several accumulators (e.g., for both its POSIX and STDIO
+ * records) is counted once.
+ */
+int darshan_accumulator_emit_categories(darshan_accumulator*        accumulators,
+                                        int                         acc_count,
+                                        darshan_record_id*          ids,
+                                        int*                        categories,
+                                        int                         id_count,
+                                        struct darshan_category_io* category_io,
+                                        int                         category_count);
+
 /* frees resources associated with an accumulator */
 int darshan_accumulator_destroy(darshan_accumulator accumulator);
 
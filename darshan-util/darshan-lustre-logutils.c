@@ -25,6 +25,9 @@
 char *lustre_comp_counter_names[] = {
     LUSTRE_COMP_COUNTERS
 };
+char *lustre_ost_counter_names[] = {
+    LUSTRE_OST_COUNTERS
+};
 #undef X
 
 static int darshan_log_get_lustre_record(darshan_fd fd, void** lustre_buf_p);
@@ -37,6 +40,8 @@ static void darshan_log_print_lustre_record_diff(void *rec1, char *file_name1,
 static void darshan_log_agg_lustre_records(void *rec, void *agg_rec, int init_flag);
 
 static int darshan_log_get_lustre_record_v1(darshan_fd fd, void** lustre_buf_p);
+static int darshan_log_get_lustre_ost_traffic(darshan_fd fd,
+    struct darshan_lustre_record *tmp_rec, void** lustre_buf_p);
 
 struct darshan_mod_logutil_funcs lustre_logutils =
 {
@@ -89,6 +94,9 @@ static int darshan_log_get_lustre_record(darshan_fd fd, void** lustre_buf_p)
         DARSHAN_BSWAP64(&tmp_rec.num_stripes);
     }
 
+    if(tmp_rec.num_comps == LUSTRE_OST_TRAFFIC_COMPS)
+        return darshan_log_get_lustre_ost_traffic(fd, &tmp_rec, lustre_buf_p);
+
     comps_size = tmp_rec.num_comps * sizeof(*tmp_rec.comps);
     osts_size = tmp_rec.num_stripes * sizeof(*tmp_rec.ost_ids);
     if(*lustre_buf_p == NULL)
@@ -98,6 +106,7 @@ static int darshan_log_get_lustre_record(darshan_fd fd, void** lustre_buf_p)
             return(-1);
     }
     memcpy(rec, &tmp_rec, fixed_size);
+    rec->ost_traffic = NULL;
     if(tmp_rec.num_comps < 1)
     {
         rec->comps = NULL;
@@ -176,6 +185,59 @@ static int darshan_log_get_lustre_record(darshan_fd fd, void** lustre_buf_p)
     return(ret);
 }
 
+static int darshan_log_get_lustre_ost_traffic(darshan_fd fd,
+    struct darshan_lustre_record *tmp_rec, void** lustre_buf_p)
+{
+    struct darshan_lustre_record *rec = *((struct darshan_lustre_record **)lustre_buf_p);
+    int fixed_size = sizeof(struct darshan_base_record) + (2*sizeof(int64_t));
+    int traffic_size;
+    int i, j;
+    int ret;
+
+    traffic_size = tmp_rec->num_stripes * sizeof(*tmp_rec->ost_traffic);
+    if(*lustre_buf_p == NULL)
+    {
+        rec = malloc(sizeof(struct darshan_lustre_record) + traffic_size);
+        if(!rec)
+            return(-1);
+    }
+    memcpy(rec, tmp_rec, fixed_size);
+    rec->comps = NULL;
+    rec->ost_ids = NULL;
+    rec->ost_traffic = (struct darshan_lustre_ost_traffic *)
+        ((void *)rec + sizeof(struct darshan_lustre_record));
+
+    /* read the per-OST traffic entries */
+    ret = darshan_log_get_mod(fd, DARSHAN_LUSTRE_MOD, (void *)(rec->ost_traffic),
+        traffic_size);
+    if(ret < traffic_size)
+        ret = -1;
+    else
+    {
+        ret = 1;
+        /* swap bytes if necessary */
+        if(fd->swap_flag)
+        {
+            for(i = 0; i < rec->num_stripes; i++)
+            {
+                DARSHAN_BSWAP64(&rec->ost_traffic[i].ost_id);
+                for(j = 0; j < LUSTRE_OST_NUM_INDICES; j++)
+                    DARSHAN_BSWAP64(&rec->ost_traffic[i].counters[j]);
+            }
+        }
+    }
+
+    if(*lustre_buf_p == NULL)
+    {
+        if(ret == 1)
+            *lustre_buf_p = rec;
+        else
+            free(rec);
+    }
+
+    return(ret);
+}
+
 static int darshan_log_get_lustre_record_v1(darshan_fd fd, void** lustre_buf_p)
 {
     struct darshan_lustre_record *rec = *((struct darshan_lustre_record **)lustre_buf_p);
@@ -211,6 +273,7 @@ static int darshan_log_get_lustre_record_v1(darshan_fd fd, void** lustre_buf_p)
     memcpy(rec, &fixed_record, sizeof(struct darshan_base_record));
     rec->num_comps = 1; // only 1 component for old Lustre records
     rec->num_stripes = stripe_count; // newer records have separate field for total stripes
+    rec->ost_traffic = NULL;
     rec->comps = (struct darshan_lustre_component *)
         ((void *)rec + sizeof(struct darshan_lustre_record));
     rec->ost_ids = (OST_ID *)
@@ -268,6 +331,16 @@ static int darshan_log_put_lustre_record(darshan_fd fd, void* lustre_buf)
     if(ret < 0)
         return(-1);
 
+    if(rec->num_comps == LUSTRE_OST_TRAFFIC_COMPS)
+    {
+        ret = darshan_log_put_mod(fd, DARSHAN_LUSTRE_MOD, rec->ost_traffic,
+            rec->num_stripes * sizeof(*rec->ost_traffic), DARSHAN_LUSTRE_VER);
+        if(ret < 0)
+            return(-1);
+
+        return(0);
+    }
+
     comps_size = rec->num_comps * sizeof(*rec->comps);
     osts_size = rec->num_stripes * sizeof(*rec->ost_ids);
     ret = darshan_log_put_mod(fd, DARSHAN_LUSTRE_MOD, rec->comps,
@@ -289,6 +362,30 @@ static void darshan_log_print_lustre_record(void *rec, char *file_name,
     int idx;
     int global_ost_idx = 0;
 
+    if(lustre_rec->num_comps == LUSTRE_OST_TRAFFIC_COMPS)
+    {
+        for(i = 0; i < lustre_rec->num_stripes; i++)
+        {
+            for(j = 0; j < LUSTRE_OST_NUM_INDICES; j++)
+            {
+                /* LUSTRE_OST_<id>_<counter>, with "OTHER" for OST -1 */
+                ptr = &lustre_ost_counter_names[j][strlen("LUSTRE_OST_")];
+                if(lustre_rec->ost_traffic[i].ost_id == -1)
+                    snprintf(tmp_counter_str, sizeof(tmp_counter_str),
+                        "LUSTRE_OST_OTHER_%s", ptr);
+                else
+                    snprintf(tmp_counter_str, sizeof(tmp_counter_str),
+                        "LUSTRE_OST_%" PRId64 "_%s",
+                        lustre_rec->ost_traffic[i].ost_id, ptr);
+                DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_LUSTRE_MOD],
+                    lustre_rec->base_rec.rank, lustre_rec->base_rec.id,
+                    tmp_counter_str, lustre_rec->ost_traffic[i].counters[j],
+                    file_name, mnt_pt, fs_type);
+            }
+        }
+        return;
+    }
+
     DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_LUSTRE_MOD],
         lustre_rec->base_rec.rank, lustre_rec->base_rec.id, "LUSTRE_NUM_COMPONENTS",
         lustre_rec->num_comps, file_name, mnt_pt, fs_type);
@@ -396,6 +493,12 @@ static void darshan_log_print_lustre_description(int ver)
     printf("#   LUSTRE_COMP*_MIRROR_ID: mirror ID for this file layout component, if mirrors are enabled.\n");
     printf("#   LUSTRE_COMP*_POOL_NAME: Lustre OST pool used for this file layout component.\n");
     printf("#   LUSTRE_COMP*_OST_ID_*: indices of OSTs over which this file layout component is striped.\n");
+    if(ver >= 3)
+    {
+        printf("#   LUSTRE_OST_*_BYTES_READ, LUSTRE_OST_*_BYTES_WRITTEN: bytes of POSIX reads/writes served by this OST (in the %s record, if OST traffic accounting was enabled).\n", LUSTRE_OST_TRAFFIC_REC_NAME);
+        printf("#   LUSTRE_OST_*_READS, LUSTRE_OST_*_WRITES: number of POSIX read/write calls that accessed this OST.\n");
+        printf("#   LUSTRE_OST_OTHER_*: traffic to non-instantiated layout components or to OSTs with indices >= %d.\n", LUSTRE_OST_TRAFFIC_MAX_OSTS);
+    }
 
     return;
 }
@@ -412,6 +515,47 @@ static void darshan_log_agg_lustre_records(void *rec, void *agg_rec, int init_fl
     struct darshan_lustre_record *lustre_rec = (struct darshan_lustre_record *)rec;
     struct darshan_lustre_record *agg_lustre_rec = (struct darshan_lustre_record *)agg_rec;
     int comps_size = 0, osts_size = 0;
+    int i, j, k;
+
+    if(lustre_rec->num_comps == LUSTRE_OST_TRAFFIC_COMPS)
+    {
+        if(init_flag)
+        {
+            memcpy(agg_lustre_rec, lustre_rec, sizeof(struct darshan_lustre_record));
+            agg_lustre_rec->ost_traffic = (struct darshan_lustre_ost_traffic *)
+                ((void *)agg_lustre_rec + sizeof(struct darshan_lustre_record));
+            memcpy(agg_lustre_rec->ost_traffic, lustre_rec->ost_traffic,
+                lustre_rec->num_stripes * sizeof(*lustre_rec->ost_traffic));
+        }
+        else if(agg_lustre_rec->num_comps == LUSTRE_OST_TRAFFIC_COMPS)
+        {
+            /* sum the traffic of each OST, adding entries for OSTs not
+             * seen yet; the OST index bound at runtime keeps this within
+             * the aggregate record buffer
+             */
+            for(i = 0; i < lustre_rec->num_stripes; i++)
+            {
+                for(k = 0; k < agg_lustre_rec->num_stripes; k++)
+                    if(agg_lustre_rec->ost_traffic[k].ost_id ==
+                        lustre_rec->ost_traffic[i].ost_id)
+                        break;
+                if(k == agg_lustre_rec->num_stripes)
+                {
+                    if(k > LUSTRE_OST_TRAFFIC_MAX_OSTS)
+                        continue;
+                    memset(&agg_lustre_rec->ost_traffic[k], 0,
+                        sizeof(*agg_lustre_rec->ost_traffic));
+                    agg_lustre_rec->ost_traffic[k].ost_id =
+                        lustre_rec->ost_traffic[i].ost_id;
+                    agg_lustre_rec->num_stripes++;
+                }
+                for(j = 0; j < LUSTRE_OST_NUM_INDICES; j++)
+                    agg_lustre_rec->ost_traffic[k].counters[j] +=
+                        lustre_rec->ost_traffic[i].counters[j];
+            }
+        }
+        return;
+    }
 
     if(init_flag)
     {
@@ -421,6 +565,7 @@ static void darshan_log_agg_lustre_records(void *rec, void *agg_rec, int init_fl
          * final output record
          */
         memcpy(agg_lustre_rec, lustre_rec, sizeof(struct darshan_lustre_record));
+        agg_lustre_rec->ost_traffic = NULL;
         agg_lustre_rec->comps = (struct darshan_lustre_component *)
             ((void *)agg_lustre_rec + sizeof(struct darshan_lustre_record));
         comps_size = lustre_rec->num_comps * sizeof(*lustre_rec->comps);
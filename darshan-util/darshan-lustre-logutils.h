@@ -8,6 +8,7 @@
 #define __DARSHAN_LUSTRE_LOG_UTILS_H
 
 extern char *lustre_comp_counter_names[];
+extern char *lustre_ost_counter_names[];
 
 extern struct darshan_mod_logutil_funcs lustre_logutils;
 
@@ -34,6 +34,11 @@ char *mdhim_f_counter_names[] = {
 };
 #undef X
 
+/* size of the fixed-size portion of a version 1 MDHIM record: the base
+ * record, 5 counters, 4 timers, and the first server histogram entry
+ */
+#define DARSHAN_MDHIM_RECORD_SIZE_1 96
+
 /* prototypes for each of the MDHIM module's logutil functions */
 static int darshan_log_get_mdhim_record(darshan_fd fd, void** mdhim_buf_p);
 static int darshan_log_put_mdhim_record(darshan_fd fd, void* mdhim_buf);
@@ -67,61 +72,109 @@ static int darshan_log_get_mdhim_record(darshan_fd fd, void** mdhim_buf_p)
     struct darshan_mdhim_record *rec =
         *((struct darshan_mdhim_record **)mdhim_buf_p);
     struct darshan_mdhim_record tmp_rec;
+    int64_t scratch[DARSHAN_MDHIM_RECORD_SIZE_1 / sizeof(int64_t)];
+    int64_t *v1_counters;
+    double *v1_fcounters;
+    double *server_times;
+    int64_t nr_servers;
+    int tail_len;
+    int ver;
     int i;
     int ret;
 
     if(fd->mod_map[DARSHAN_MDHIM_MOD].len == 0)
         return(0);
 
+    ver = fd->mod_ver[DARSHAN_MDHIM_MOD];
+    if(ver == 0 || ver > DARSHAN_MDHIM_VER)
+    {
+        fprintf(stderr, "Error: Invalid MDHIM module version number (got %d)\n",
+            ver);
+        return(-1);
+    }
+
     /* read the fixed-sized portion of the MDHIM module record from the
-     * darshan log file */
-    ret = darshan_log_get_mod(fd, DARSHAN_MDHIM_MOD, &tmp_rec,
-        sizeof(struct darshan_mdhim_record));
-    if (ret < 0)
-        return (-1);
-    else if (ret < sizeof(struct darshan_mdhim_record))
-        return (0);
-    /* swap bytes if necessary */
-    if (fd->swap_flag)
+     * darshan log file; it consists only of 64-bit fields, so swap bytes
+     * (reader-makes-right) before looking at any of them */
+    if (ver == DARSHAN_MDHIM_VER)
+    {
+        ret = darshan_log_get_mod(fd, DARSHAN_MDHIM_MOD, &tmp_rec,
+            sizeof(struct darshan_mdhim_record));
+        if (ret < 0)
+            return (-1);
+        else if (ret < sizeof(struct darshan_mdhim_record))
+            return (0);
+        if (fd->swap_flag)
+            darshan_log_bswap64_array(&tmp_rec,
+                sizeof(struct darshan_mdhim_record) / sizeof(int64_t));
+    }
+    else
     {
-        /* reader-makes-right:  don't look at a field until it has
-         * been swapped */
-        DARSHAN_BSWAP64(&tmp_rec.base_rec.id);
-        DARSHAN_BSWAP64(&tmp_rec.base_rec.rank);
+        ret = darshan_log_get_mod(fd, DARSHAN_MDHIM_MOD, scratch,
+            DARSHAN_MDHIM_RECORD_SIZE_1);
+        if (ret < 0)
+            return (-1);
+        else if (ret < DARSHAN_MDHIM_RECORD_SIZE_1)
+            return (0);
+        if (fd->swap_flag)
+            darshan_log_bswap64_array(scratch,
+                DARSHAN_MDHIM_RECORD_SIZE_1 / sizeof(int64_t));
+
+        /* upconvert version 1: counters and timers it did not have are
+         * set to -1 */
+        memcpy(&tmp_rec.base_rec, scratch, sizeof(struct darshan_base_record));
+        v1_counters = (int64_t *)((char *)scratch +
+            sizeof(struct darshan_base_record));
+        v1_fcounters = (double *)(v1_counters + MDHIM_BPUTS);
         for (i=0; i< MDHIM_NUM_INDICES; i++)
-            DARSHAN_BSWAP64(&tmp_rec.counters[i]);
+            tmp_rec.counters[i] = (i < MDHIM_BPUTS) ? v1_counters[i] : -1;
         for (i=0; i< MDHIM_F_NUM_INDICES; i++)
-            DARSHAN_BSWAP64(&tmp_rec.fcounters[i]);
-        DARSHAN_BSWAP64(&(tmp_rec.server_histogram[0]) );
+            tmp_rec.fcounters[i] =
+                (i < MDHIM_F_PUT_TIME) ? v1_fcounters[i] : -1;
+        tmp_rec.server_histogram[0] =
+            *((int64_t *)(v1_fcounters + MDHIM_F_PUT_TIME));
     }
 
+    nr_servers = tmp_rec.counters[MDHIM_SERVERS];
+    if (nr_servers < 1)
+        return (-1);
+
     if(*mdhim_buf_p == NULL)
     {
-        rec = malloc(MDHIM_RECORD_SIZE(tmp_rec.counters[MDHIM_SERVERS]));
+        rec = malloc(MDHIM_RECORD_SIZE(nr_servers));
         if (!rec)
             return (-1);
     }
     memcpy(rec, &tmp_rec, sizeof(struct darshan_mdhim_record));
 
-    if (rec->counters[MDHIM_SERVERS] > 1) {
+    /* the rest of the server histogram follows, then (since version 2)
+     * the time spent on each server */
+    tail_len = (nr_servers - 1) * sizeof(int64_t);
+    if (ver == DARSHAN_MDHIM_VER)
+        tail_len += nr_servers * sizeof(double);
+    ret = 1;
+    if (tail_len > 0)
+    {
         ret = darshan_log_get_mod(fd, DARSHAN_MDHIM_MOD,
-                &(rec->server_histogram[1]),
-                (rec->counters[MDHIM_SERVERS] - 1)*sizeof(int64_t));
+                &(rec->server_histogram[1]), tail_len);
 
-        if (ret < (rec->counters[MDHIM_SERVERS] -1)*sizeof(int64_t))
+        if (ret < tail_len)
             ret = -1;
         else
         {
             ret = 1;
             if (fd->swap_flag)
-                for(i=1; i< rec->counters[MDHIM_SERVERS]; i++)
-                    DARSHAN_BSWAP64(&(rec->server_histogram[i]));
+                darshan_log_bswap64_array(&(rec->server_histogram[1]),
+                    tail_len / sizeof(int64_t));
         }
     }
-    else
+    if (ret == 1 && ver < DARSHAN_MDHIM_VER)
     {
-        ret = 1;
+        server_times = MDHIM_SERVER_TIMES(rec);
+        for (i=0; i< nr_servers; i++)
+            server_times[i] = -1;
     }
+
     if (*mdhim_buf_p == NULL)
     {
         if (ret == 1)
@@ -140,9 +193,9 @@ static int darshan_log_put_mdhim_record(darshan_fd fd, void* mdhim_buf)
     struct darshan_mdhim_record *rec = (struct darshan_mdhim_record *)mdhim_buf;
     int ret;
 
-    /* append MDHIM record to darshan log file */
+    /* append MDHIM record, including its per-server data, to darshan log file */
     ret = darshan_log_put_mod(fd, DARSHAN_MDHIM_MOD, rec,
-        sizeof(struct darshan_mdhim_record), DARSHAN_MDHIM_VER);
+        MDHIM_RECORD_SIZE(rec->counters[MDHIM_SERVERS]), DARSHAN_MDHIM_VER);
     if(ret < 0)
         return(-1);
 
@@ -156,6 +209,8 @@ static void darshan_log_print_mdhim_record(void *file_rec, char *file_name,
     int i;
     struct darshan_mdhim_record *mdhim_rec =
         (struct darshan_mdhim_record *)file_rec;
+    double *server_times;
+    double total_time = 0;
 
     /* print each of the integer and floating point counters for the MDHIM module */
     for(i=0; i<MDHIM_NUM_INDICES; i++)
@@ -186,6 +241,33 @@ static void darshan_log_print_mdhim_record(void *file_rec, char *file_name,
                 (int64_t)mdhim_rec->server_histogram[i],
                 file_name, mnt_pt, fs_type);
     }
+
+    /* time spent on each server, and its share of the time on all servers */
+    server_times = MDHIM_SERVER_TIMES(mdhim_rec);
+    for (i=0; i< mdhim_rec->counters[MDHIM_SERVERS]; i++)
+    {
+        if (server_times[i] > 0)
+            total_time += server_times[i];
+    }
+    for (i=0; i< mdhim_rec->counters[MDHIM_SERVERS]; i++)
+    {
+        char strbuf[32];
+        snprintf(strbuf, sizeof(strbuf), "MDHIM_F_SERVER_TIME_%d", i);
+        DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_MDHIM_MOD],
+                mdhim_rec->base_rec.rank,
+                mdhim_rec->base_rec.id,
+                strbuf,
+                server_times[i],
+                file_name, mnt_pt, fs_type);
+        snprintf(strbuf, sizeof(strbuf), "MDHIM_F_SERVER_SHARE_%d", i);
+        DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_MDHIM_MOD],
+                mdhim_rec->base_rec.rank,
+                mdhim_rec->base_rec.id,
+                strbuf,
+                (server_times[i] < 0) ? -1.0 :
+                    ((total_time > 0) ? server_times[i] / total_time : 0.0),
+                file_name, mnt_pt, fs_type);
+    }
     return;
 }
 
@@ -196,9 +278,23 @@ static void darshan_log_print_mdhim_description(int ver)
     printf("#   MDHIM_PUTS: number of 'mdhim_put' function calls.\n");
     printf("#   MDHIM_GETS: number of 'mdhim_get' function calls.\n");
     printf("#   MDHIM_SERVERS: how many mdhim servers \n");
+    printf("#   MDHIM_BPUTS, MDHIM_BGETS: number of 'mdhimBPut' and 'mdhimBGet' function calls.\n");
+    printf("#   MDHIM_BPUT_KEYS, MDHIM_BGET_KEYS: number of keys carried by bulk calls.\n");
+    printf("#   MDHIM_*_LAT_*: histogram of put/get latencies, in decades from 10us to 1s.\n");
+    printf("#   MDHIM_*_BATCH_*: histogram of the number of keys per bulk put/get call.\n");
     printf("#   MDHIM_F_PUT_TIMESTAMP: timestamp of the first call to function 'mdhim_put'.\n");
     printf("#   MDHIM_F_GET_TIMESTAMP: timestamp of the first call to function 'mdhim_get'.\n");
-    printf("#   MDHIM_SERVER_N: how many operations sent to this server\n");
+    printf("#   MDHIM_F_*_TIME: cumulative time spent in put/get and bulk put/get calls.\n");
+    printf("#   MDHIM_SERVER_N: how many operations sent to this server (each key of a bulk call counts)\n");
+    printf("#   MDHIM_F_SERVER_TIME_N: time spent in operations sent to this server (a bulk call's time is split over its keys)\n");
+    printf("#   MDHIM_F_SERVER_SHARE_N: this server's fraction of the time spent on all servers\n");
+
+    if(ver == 1)
+    {
+        printf("\n# WARNING: MDHIM module log format version 1 does not support the following counters:\n");
+        printf("# - MDHIM bulk operation counters and latency and batch size histograms\n");
+        printf("# - MDHIM_F_*_TIME and MDHIM_F_SERVER_TIME_N\n");
+    }
 
     return;
 }
@@ -319,6 +415,35 @@ static void darshan_log_print_mdhim_record_diff(void *file_rec1, char *file_name
             (!file2 || i >= file2->counters[MDHIM_SERVERS] ) )
             break;
     }
+    /* server times are only compared for servers both records have */
+    if (file1 && file2)
+    {
+        double *times1 = MDHIM_SERVER_TIMES(file1);
+        double *times2 = MDHIM_SERVER_TIMES(file2);
+
+        for (i=0; i< file1->counters[MDHIM_SERVERS] &&
+                i< file2->counters[MDHIM_SERVERS]; i++)
+        {
+            char strbuf[32];
+            if (times1[i] == times2[i])
+                continue;
+            snprintf(strbuf, sizeof(strbuf), "MDHIM_F_SERVER_TIME_%d", i);
+            printf("- ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_MDHIM_MOD],
+                    file1->base_rec.rank,
+                    file1->base_rec.id,
+                    strbuf,
+                    times1[i],
+                    file_name1, "", "");
+            printf("+ ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_MDHIM_MOD],
+                    file2->base_rec.rank,
+                    file2->base_rec.id,
+                    strbuf,
+                    times2[i],
+                    file_name2, "", "");
+        }
+    }
     return;
 }
 
@@ -327,6 +452,7 @@ static void darshan_log_agg_mdhim_records(void *rec, void *agg_rec, int init_fla
 {
     struct darshan_mdhim_record *mdhim_rec = (struct darshan_mdhim_record *)rec;
     struct darshan_mdhim_record *agg_mdhim_rec = (struct darshan_mdhim_record *)agg_rec;
+    double *server_times, *agg_server_times;
     int i;
 
     for(i = 0; i < MDHIM_NUM_INDICES; i++)
@@ -345,6 +471,44 @@ static void darshan_log_agg_mdhim_records(void *rec, void *agg_rec, int init_fla
                 /* all clients should have the same value for this, hence
                  * assignment instead of aggregating */
                 agg_mdhim_rec->counters[i] = mdhim_rec->counters[i];
+                break;
+            case MDHIM_PUT_MAX_SIZE:
+            case MDHIM_GET_MAX_SIZE:
+                /* max */
+                if(mdhim_rec->counters[i] > agg_mdhim_rec->counters[i])
+                    agg_mdhim_rec->counters[i] = mdhim_rec->counters[i];
+                break;
+            case MDHIM_BPUTS:
+            case MDHIM_BGETS:
+            case MDHIM_BPUT_KEYS:
+            case MDHIM_BGET_KEYS:
+            case MDHIM_PUT_LAT_0_10US:
+            case MDHIM_PUT_LAT_10US_100US:
+            case MDHIM_PUT_LAT_100US_1MS:
+            case MDHIM_PUT_LAT_1MS_10MS:
+            case MDHIM_PUT_LAT_10MS_100MS:
+            case MDHIM_PUT_LAT_100MS_1S:
+            case MDHIM_PUT_LAT_1S_PLUS:
+            case MDHIM_GET_LAT_0_10US:
+            case MDHIM_GET_LAT_10US_100US:
+            case MDHIM_GET_LAT_100US_1MS:
+            case MDHIM_GET_LAT_1MS_10MS:
+            case MDHIM_GET_LAT_10MS_100MS:
+            case MDHIM_GET_LAT_100MS_1S:
+            case MDHIM_GET_LAT_1S_PLUS:
+            case MDHIM_BPUT_BATCH_1:
+            case MDHIM_BPUT_BATCH_2_10:
+            case MDHIM_BPUT_BATCH_11_100:
+            case MDHIM_BPUT_BATCH_101_1K:
+            case MDHIM_BPUT_BATCH_1K_PLUS:
+            case MDHIM_BGET_BATCH_1:
+            case MDHIM_BGET_BATCH_2_10:
+            case MDHIM_BGET_BATCH_11_100:
+            case MDHIM_BGET_BATCH_101_1K:
+            case MDHIM_BGET_BATCH_1K_PLUS:
+                /* sum */
+                agg_mdhim_rec->counters[i] += mdhim_rec->counters[i];
+                break;
             default:
                 /* if we don't know how to aggregate this counter, just set to -1 */
                 agg_mdhim_rec->counters[i] = -1;
@@ -374,6 +538,19 @@ static void darshan_log_agg_mdhim_records(void *rec, void *agg_rec, int init_fla
                     agg_mdhim_rec->fcounters[i] = mdhim_rec->fcounters[i];
                 }
                 break;
+            case MDHIM_F_PUT_MAX_DURATION:
+            case MDHIM_F_GET_MAX_DURATION:
+                /* max */
+                if(mdhim_rec->fcounters[i] > agg_mdhim_rec->fcounters[i])
+                    agg_mdhim_rec->fcounters[i] = mdhim_rec->fcounters[i];
+                break;
+            case MDHIM_F_PUT_TIME:
+            case MDHIM_F_GET_TIME:
+            case MDHIM_F_BPUT_TIME:
+            case MDHIM_F_BGET_TIME:
+                /* sum */
+                agg_mdhim_rec->fcounters[i] += mdhim_rec->fcounters[i];
+                break;
 
             default:
                 /* if we don't know how to aggregate this counter, just set to -1 */
@@ -381,9 +558,12 @@ static void darshan_log_agg_mdhim_records(void *rec, void *agg_rec, int init_fla
                 break;
         }
     }
+    agg_server_times = MDHIM_SERVER_TIMES(agg_mdhim_rec);
+    server_times = MDHIM_SERVER_TIMES(mdhim_rec);
     for (i=0; i< mdhim_rec->counters[MDHIM_SERVERS]; i++)
     {
         agg_mdhim_rec->server_histogram[i] += mdhim_rec->server_histogram[i];
+        agg_server_times[i] += server_times[i];
     }
 
     return;
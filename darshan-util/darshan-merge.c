@@ -8,6 +8,8 @@
 #include <string.h>
 #include <getopt.h>
 #include <glob.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #include "uthash-1.9.2/src/uthash.h"
 
@@ -18,9 +20,49 @@ struct darshan_shared_record_ref
     darshan_record_id id;
     int ref_cnt;
     char agg_rec[DEF_MOD_BUF_SIZE];
+    /* the individual records, written out instead of the aggregate
+     * record if the record turns out not to be shared
+     */
+    void **recs;
+    int rec_cnt;
+    int rec_max;
     UT_hash_handle hlink;
 };
 
+/* an input log decoded by a worker thread, waiting to be merged */
+struct merge_input
+{
+    int status;
+    struct darshan_job job;
+    char *exe;
+    struct darshan_mnt_info *mnt_array;
+    int mnt_count;
+    struct darshan_name_record_ref *name_hash;
+    void **recs[DARSHAN_KNOWN_MODULE_COUNT];
+    int rec_cnt[DARSHAN_KNOWN_MODULE_COUNT];
+    int rec_max[DARSHAN_KNOWN_MODULE_COUNT];
+};
+
+#define MERGE_INPUT_EMPTY 0
+#define MERGE_INPUT_READY 1
+#define MERGE_INPUT_FAILED 2
+
+/* state shared between the worker threads decoding input logs and the
+ * main thread merging them, in order, into the output log
+ */
+struct merge_state
+{
+    char **infile_list;
+    int n_infiles;
+    struct merge_input *inputs;
+    int window;
+    int next_claim;
+    int next_merge;
+    int abort;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+};
+
 void usage(char *exename)
 {
     fprintf(stderr, "Usage: %s --output <output_path> [options] <input_log_glob>\n", exename);
@@ -30,12 +72,14 @@ void usage(char *exename)
     fprintf(stderr, "\t--output\t(REQUIRED) Full path of the output darshan log file.\n");
     fprintf(stderr, "\t--shared-redux\tReduce globally shared records into a single record.\n");
     fprintf(stderr, "\t--job-end-time\tSet the output log's job end time (requires argument of seconds since Epoch).\n");
+    fprintf(stderr, "\t--threads\tNumber of threads decoding input logs (default: number of cores).\n");
 
     exit(1);
 }
 
 void parse_args(int argc, char **argv, char ***infile_list, int *n_files,
-    char **outlog_path, int *shared_redux, int64_t *job_end_time)
+    char **outlog_path, int *shared_redux, int64_t *job_end_time,
+    int *nthreads)
 {
     int index;
     char *check;
@@ -44,12 +88,14 @@ void parse_args(int argc, char **argv, char ***infile_list, int *n_files,
         {"output", required_argument, NULL, 'o'},
         {"shared-redux", no_argument, NULL, 's'},
         {"job-end-time", required_argument, NULL, 'e'},
+        {"threads", required_argument, NULL, 't'},
         {0, 0, 0, 0}
     };
 
     *shared_redux = 0;
     *outlog_path = NULL;
     *job_end_time = 0;
+    *nthreads = sysconf(_SC_NPROCESSORS_ONLN);
 
     while(1)
     {
@@ -73,6 +119,14 @@ void parse_args(int argc, char **argv, char ***infile_list, int *n_files,
                     exit(1);
                 }
                 break;
+            case 't':
+                *nthreads = strtol(optarg, &check, 10);
+                if(optarg == check || *nthreads < 1)
+                {
+                    fprintf(stderr, "Error: invalid number of threads.\n");
+                    exit(1);
+                }
+                break;
             case '?':
             default:
                 usage(argv[0]);
@@ -84,6 +138,8 @@ void parse_args(int argc, char **argv, char ***infile_list, int *n_files,
     {
         usage(argv[0]);
     }
+    if(*nthreads < 1)
+        *nthreads = 1;
 
     *infile_list = &argv[optind];
     *n_files = argc - optind;
@@ -91,237 +147,448 @@ void parse_args(int argc, char **argv, char ***infile_list, int *n_files,
     return;
 }
 
-int build_mod_shared_rec_hash(char **infile_list, int n_infiles,
-    darshan_module_id mod_id, int nprocs, char *mod_buf,
-    struct darshan_shared_record_ref **shared_rec_hash)
+static void free_input(struct merge_input *input)
+{
+    struct darshan_name_record_ref *ref, *tmp;
+    int i, j;
+
+    free(input->exe);
+    free(input->mnt_array);
+    HASH_ITER(hlink, input->name_hash, ref, tmp)
+    {
+        HASH_DELETE(hlink, input->name_hash, ref);
+        free(ref->name_record);
+        free(ref);
+    }
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+    {
+        for(j = 0; j < input->rec_cnt[i]; j++)
+            free(input->recs[i][j]);
+        free(input->recs[i]);
+    }
+    memset(input, 0, sizeof(*input));
+
+    return;
+}
+
+static int append_rec(void ***recs, int *cnt, int *max, void *rec)
+{
+    void **tmp_recs;
+
+    if(*cnt == *max)
+    {
+        *max = *max ? *max * 2 : 64;
+        tmp_recs = realloc(*recs, *max * sizeof(**recs));
+        if(!tmp_recs)
+            return(-1);
+        *recs = tmp_recs;
+    }
+    (*recs)[(*cnt)++] = rec;
+
+    return(0);
+}
+
+/* read everything needed from an input log, so that it is only opened
+ * (and decompressed) once
+ */
+static int decode_input(char *infile, int first, struct merge_input *input)
 {
     darshan_fd in_fd;
-    struct darshan_base_record *base_rec;
-    struct darshan_shared_record_ref *ref, *tmp;
-    int init_rank = -1;
+    void *rec;
     int ret;
     int i;
 
-    /* if this module has no method for aggregating shared records, do nothing */
-    if(!(mod_logutils[mod_id]->log_agg_records))
-        return(0);
+    in_fd = darshan_log_open(infile);
+    if(in_fd == NULL)
+    {
+        fprintf(stderr,
+            "Error: unable to open input Darshan log file %s.\n", infile);
+        return(-1);
+    }
+
+    /* read job-level metadata from the input file */
+    ret = darshan_log_get_job(in_fd, &input->job);
+    if(ret < 0)
+    {
+        fprintf(stderr,
+            "Error: unable to read job data from input Darshan log file %s.\n",
+            infile);
+        darshan_log_close(in_fd);
+        return(-1);
+    }
+
+#if 0
+    /* XXX: the darshan_shutdown tag is never set in darshan-core, currently */
+    /* if the input darshan log has metadata set indicating the darshan
+     * shutdown procedure was called on the log, then we error out. if the
+     * shutdown procedure was started, then it's possible the log has
+     * incomplete or corrupt data, so we just throw out the data for now.
+     */
+    if(strstr(input->job.metadata, "darshan_shutdown=yes"))
+    {
+        fprintf(stderr,
+            "Error: potentially corrupt data found in input log file %s.\n",
+            infile);
+        darshan_log_close(in_fd);
+        return(-1);
+    }
+#endif
 
-    /* loop over each input log file */
-    for(i = 0; i < n_infiles; i++)
+    if(first)
     {
-        in_fd = darshan_log_open(infile_list[i]);
-        if(in_fd == NULL)
+        /* get exe & mounts directly from the first input log */
+        input->exe = calloc(1, DARSHAN_EXE_LEN+1);
+        if(!input->exe)
+        {
+            darshan_log_close(in_fd);
+            return(-1);
+        }
+        ret = darshan_log_get_exe(in_fd, input->exe);
+        if(ret < 0)
         {
             fprintf(stderr,
-                "Error: unable to open input Darshan log file %s.\n",
-                infile_list[i]);
+                "Error: unable to read exe string from input Darshan log file %s.\n",
+                infile);
+            darshan_log_close(in_fd);
             return(-1);
         }
 
-        while((ret = mod_logutils[mod_id]->log_get_record(in_fd, (void **)&mod_buf)) == 1)
+        ret = darshan_log_get_mounts(in_fd, &input->mnt_array, &input->mnt_count);
+        if(ret < 0)
         {
-            base_rec = (struct darshan_base_record *)mod_buf;
-            if(init_rank == -1)
-                init_rank = base_rec->rank;
-
-            /* initialize the hash with the first rank's records */
-            if(base_rec->rank == init_rank)
-            {
-                struct darshan_base_record *agg_base;
+            fprintf(stderr,
+                "Error: unable to read mount info from input Darshan log file %s.\n",
+                infile);
+            darshan_log_close(in_fd);
+            return(-1);
+        }
+    }
 
-                /* create a new ref and add to the hash */
-                ref = malloc(sizeof(*ref));
-                if(!ref)
-                {
-                    darshan_log_close(in_fd);
-                    return(-1);
-                }
-                memset(ref, 0, sizeof(*ref));
+    /* read the hash of ids->names for the input log */
+    ret = darshan_log_get_namehash(in_fd, &input->name_hash);
+    if(ret < 0)
+    {
+        fprintf(stderr,
+            "Error: unable to read job data from input Darshan log file %s.\n",
+            infile);
+        darshan_log_close(in_fd);
+        return(-1);
+    }
 
-                /* initialize the aggregate record with this rank's record */
-                mod_logutils[mod_id]->log_agg_records(mod_buf, ref->agg_rec, 1);
-                agg_base = (struct darshan_base_record *)ref->agg_rec;
-                agg_base->id = base_rec->id;
-                agg_base->rank = -1;
+    /* read all module records; logutils allocates each of them, as DXT
+     * records are variable-sized
+     */
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+    {
+        if(!mod_logutils[i]) continue;
 
-                ref->id = base_rec->id;
-                ref->ref_cnt = 1;
-                HASH_ADD(hlink, *shared_rec_hash, id, sizeof(darshan_record_id), ref);
-            }
-            else
-           {
-                /* search for this record in shared record hash */
-                HASH_FIND(hlink, *shared_rec_hash, &(base_rec->id),
-                    sizeof(darshan_record_id), ref);
-                if(ref)
-                {
-                    /* if found, aggregate this rank's record into the shared record */
-                    mod_logutils[mod_id]->log_agg_records(mod_buf, ref->agg_rec, 0);
-                    ref->ref_cnt++;
-                }
+        rec = NULL;
+        while((ret = mod_logutils[i]->log_get_record(in_fd, &rec)) == 1)
+        {
+            if(append_rec(&input->recs[i], &input->rec_cnt[i],
+                &input->rec_max[i], rec) < 0)
+            {
+                free(rec);
+                ret = -1;
+                break;
             }
+            rec = NULL;
         }
         if(ret < 0)
         {
             fprintf(stderr,
                 "Error: unable to read %s module record from input log file %s.\n",
-                darshan_module_names[mod_id], infile_list[i]);
+                darshan_module_names[i], infile);
             darshan_log_close(in_fd);
             return(-1);
         }
+    }
 
-        darshan_log_close(in_fd);
+    darshan_log_close(in_fd);
+    return(0);
+}
+
+static void *decode_thread(void *arg)
+{
+    struct merge_state *ms = arg;
+    struct merge_input *input;
+    int i;
+    int ret;
+
+    while(1)
+    {
+        /* claim the next input, staying within the window of inputs
+         * that the main thread has yet to merge
+         */
+        pthread_mutex_lock(&ms->mutex);
+        while(!ms->abort && ms->next_claim < ms->n_infiles &&
+            ms->next_claim - ms->next_merge >= ms->window)
+            pthread_cond_wait(&ms->cond, &ms->mutex);
+        if(ms->abort || ms->next_claim >= ms->n_infiles)
+        {
+            pthread_mutex_unlock(&ms->mutex);
+            break;
+        }
+        i = ms->next_claim++;
+        pthread_mutex_unlock(&ms->mutex);
+
+        input = &ms->inputs[i % ms->window];
+        ret = decode_input(ms->infile_list[i], i == 0, input);
+
+        pthread_mutex_lock(&ms->mutex);
+        input->status = (ret < 0) ? MERGE_INPUT_FAILED : MERGE_INPUT_READY;
+        pthread_cond_broadcast(&ms->cond);
+        pthread_mutex_unlock(&ms->mutex);
     }
 
-    /* prune any non-shared records from the hash one last time */
-    HASH_ITER(hlink, *shared_rec_hash, ref, tmp)
+    return(NULL);
+}
+
+/* merge one module's records from an input log. Records of the first
+ * input log (of modules that can aggregate records) are candidates for
+ * being shared, and are held back until all input logs have been merged;
+ * all other records are written out right away.
+ */
+static int merge_mod_records(darshan_fd out_fd, darshan_module_id mod_id,
+    struct merge_input *input, int first,
+    struct darshan_shared_record_ref **shared_rec_hash)
+{
+    struct darshan_base_record *base_rec;
+    struct darshan_shared_record_ref *ref;
+    int ret;
+    int i;
+
+    for(i = 0; i < input->rec_cnt[mod_id]; i++)
     {
-        if(ref->ref_cnt != nprocs)
+        base_rec = input->recs[mod_id][i];
+        ref = NULL;
+
+        if(first)
+        {
+            struct darshan_base_record *agg_base;
+
+            /* create a new ref and add to the hash */
+            ref = malloc(sizeof(*ref));
+            if(!ref)
+                return(-1);
+            memset(ref, 0, sizeof(*ref));
+
+            /* initialize the aggregate record with this rank's record */
+            mod_logutils[mod_id]->log_agg_records(base_rec, ref->agg_rec, 1);
+            agg_base = (struct darshan_base_record *)ref->agg_rec;
+            agg_base->id = base_rec->id;
+            agg_base->rank = -1;
+
+            ref->id = base_rec->id;
+            ref->ref_cnt = 1;
+            HASH_ADD(hlink, *shared_rec_hash, id, sizeof(darshan_record_id), ref);
+        }
+        else
+        {
+            /* search for this record in shared record hash */
+            HASH_FIND(hlink, *shared_rec_hash, &(base_rec->id),
+                sizeof(darshan_record_id), ref);
+            if(ref)
+            {
+                /* if found, aggregate this rank's record into the shared record */
+                mod_logutils[mod_id]->log_agg_records(base_rec, ref->agg_rec, 0);
+                ref->ref_cnt++;
+            }
+        }
+
+        if(ref)
+        {
+            /* keep the record, in case the record turns out not to be shared */
+            if(append_rec(&ref->recs, &ref->rec_cnt, &ref->rec_max, base_rec) < 0)
+                return(-1);
+            input->recs[mod_id][i] = NULL;
+        }
+        else
         {
-            HASH_DELETE(hlink, *shared_rec_hash, ref);
-            free(ref);
+            ret = mod_logutils[mod_id]->log_put_record(out_fd, base_rec);
+            if(ret < 0)
+                return(-1);
         }
     }
 
     return(0);
 }
 
+/* write out the records held back as shared record candidates, either
+ * as a single aggregate record or individually
+ */
+static int put_shared_records(darshan_fd out_fd, darshan_module_id mod_id,
+    int nprocs, struct darshan_shared_record_ref **shared_rec_hash)
+{
+    struct darshan_shared_record_ref *sref, *stmp;
+    int ret = 0;
+    int i;
+
+    HASH_ITER(hlink, *shared_rec_hash, sref, stmp)
+    {
+        if(ret == 0)
+        {
+            if(sref->ref_cnt == nprocs)
+                ret = mod_logutils[mod_id]->log_put_record(out_fd, sref->agg_rec);
+            else
+            {
+                for(i = 0; i < sref->rec_cnt && ret == 0; i++)
+                    ret = mod_logutils[mod_id]->log_put_record(out_fd,
+                        sref->recs[i]);
+            }
+        }
+
+        HASH_DELETE(hlink, *shared_rec_hash, sref);
+        for(i = 0; i < sref->rec_cnt; i++)
+            free(sref->recs[i]);
+        free(sref->recs);
+        free(sref);
+    }
+
+    return(ret);
+}
+
 int main(int argc, char *argv[])
 {
     char **infile_list;
     int n_infiles;
     int shared_redux;
     int64_t job_end_time = 0;
+    int nthreads;
     char *outlog_path;
-    darshan_fd in_fd, merge_fd;
-    struct darshan_job in_job, merge_job;
+    darshan_fd merge_fd;
+    darshan_fd mod_fds[DARSHAN_KNOWN_MODULE_COUNT] = {0};
+    struct darshan_job merge_job;
     char merge_exe[DARSHAN_EXE_LEN+1] = {0};
-    struct darshan_mnt_info *merge_mnt_array;
+    struct darshan_mnt_info *merge_mnt_array = NULL;
     int merge_mnt_count = 0;
-    struct darshan_name_record_ref *in_hash = NULL;
     struct darshan_name_record_ref *merge_hash = NULL;
     struct darshan_name_record_ref *ref, *tmp, *found;
-    struct darshan_shared_record_ref *shared_rec_hash = NULL;
-    struct darshan_shared_record_ref *sref, *stmp;
-    struct darshan_base_record *base_rec;
-    char *mod_buf;
+    struct darshan_shared_record_ref *shared_rec_hash[DARSHAN_KNOWN_MODULE_COUNT] = {0};
+    struct merge_state ms;
+    struct merge_input *input;
+    pthread_t *threads;
     int i, j;
-    int ret;
+    int ret = 0;
 
     /* grab command line arguments */
-    parse_args(argc, argv, &infile_list, &n_infiles, &outlog_path, &shared_redux, &job_end_time);
+    parse_args(argc, argv, &infile_list, &n_infiles, &outlog_path, &shared_redux,
+        &job_end_time, &nthreads);
 
     memset(&merge_job, 0, sizeof(struct darshan_job));
 
-    /* first pass at merging together logs:
-     *      - compose output job-level metadata structure (including exe & mount data)
-     *      - compose output record_id->file_name mapping 
+    /* create the output "merged" log; module records are streamed to it
+     * through a region writer per module as input logs are merged, and
+     * the job data and record table are written once all inputs are read
      */
-    for(i = 0; i < n_infiles; i++)
+    merge_fd = darshan_log_create(outlog_path, DARSHAN_ZLIB_COMP, 1);
+    if(merge_fd == NULL)
     {
-        memset(&in_job, 0, sizeof(struct darshan_job));
+        fprintf(stderr, "Error: unable to create output darshan log.\n");
+        return(-1);
+    }
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+    {
+        if(!mod_logutils[i]) continue;
 
-        in_fd = darshan_log_open(infile_list[i]);
-        if(in_fd == NULL)
+        mod_fds[i] = darshan_log_region_writer_open(merge_fd, i);
+        if(!mod_fds[i])
         {
-            fprintf(stderr,
-                "Error: unable to open input Darshan log file %s.\n",
-                infile_list[i]);
+            fprintf(stderr, "Error: unable to write module data to output darshan log.\n");
+            for(j = 0; j < i; j++)
+                if(mod_fds[j])
+                    darshan_log_region_writer_close(mod_fds[j]);
+            darshan_log_close(merge_fd);
+            unlink(outlog_path);
             return(-1);
         }
+    }
 
-        /* read job-level metadata from the input file */
-        ret = darshan_log_get_job(in_fd, &in_job);
-        if(ret < 0)
-        {
-            fprintf(stderr,
-                "Error: unable to read job data from input Darshan log file %s.\n",
-                infile_list[i]);
-            darshan_log_close(in_fd);
-            return(-1);
-        }
+    /* worker threads decode input logs (each opened only once), while
+     * this thread merges them in order
+     */
+    memset(&ms, 0, sizeof(ms));
+    ms.infile_list = infile_list;
+    ms.n_infiles = n_infiles;
+    ms.window = 2 * nthreads;
+    ms.inputs = calloc(ms.window, sizeof(*ms.inputs));
+    threads = calloc(nthreads, sizeof(*threads));
+    if(!ms.inputs || !threads)
+    {
+        fprintf(stderr, "Error: unable to allocate merge state.\n");
+        for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+            if(mod_fds[i])
+                darshan_log_region_writer_close(mod_fds[i]);
+        darshan_log_close(merge_fd);
+        unlink(outlog_path);
+        return(-1);
+    }
+    pthread_mutex_init(&ms.mutex, NULL);
+    pthread_cond_init(&ms.cond, NULL);
+    for(i = 0; i < nthreads; i++)
+    {
+        if(pthread_create(&threads[i], NULL, decode_thread, &ms) != 0)
+            break;
+    }
+    nthreads = i;
+    if(nthreads == 0)
+    {
+        fprintf(stderr, "Error: unable to create decoding threads.\n");
+        ret = -1;
+    }
 
-#if 0
-        /* XXX: the darshan_shutdown tag is never set in darshan-core, currently */
-        /* if the input darshan log has metadata set indicating the darshan
-         * shutdown procedure was called on the log, then we error out. if the
-         * shutdown procedure was started, then it's possible the log has
-         * incomplete or corrupt data, so we just throw out the data for now.
-         */
-        if(strstr(in_job.metadata, "darshan_shutdown=yes"))
+    for(i = 0; i < n_infiles && ret == 0; i++)
+    {
+        input = &ms.inputs[i % ms.window];
+
+        pthread_mutex_lock(&ms.mutex);
+        while(input->status == MERGE_INPUT_EMPTY)
+            pthread_cond_wait(&ms.cond, &ms.mutex);
+        pthread_mutex_unlock(&ms.mutex);
+        if(input->status == MERGE_INPUT_FAILED)
         {
-            fprintf(stderr,
-                "Error: potentially corrupt data found in input log file %s.\n",
-                infile_list[i]);
-            darshan_log_close(in_fd);
-            return(-1);
+            ret = -1;
+            break;
         }
-#endif
 
         if(i == 0)
         {
             /* get job data, exe, & mounts directly from the first input log */
-            memcpy(&merge_job, &in_job, sizeof(struct darshan_job));
-
-            ret = darshan_log_get_exe(in_fd, merge_exe);
-            if(ret < 0)
-            {
-                fprintf(stderr,
-                    "Error: unable to read exe string from input Darshan log file %s.\n",
-                    infile_list[i]);
-                darshan_log_close(in_fd);
-                return(-1);
-            }
-
-            ret = darshan_log_get_mounts(in_fd, &merge_mnt_array, &merge_mnt_count);
-            if(ret < 0)
-            {
-                fprintf(stderr,
-                    "Error: unable to read mount info from input Darshan log file %s.\n",
-                    infile_list[i]);
-                darshan_log_close(in_fd);
-                return(-1);
-            }
+            memcpy(&merge_job, &input->job, sizeof(struct darshan_job));
+            strcpy(merge_exe, input->exe);
+            merge_mnt_array = input->mnt_array;
+            merge_mnt_count = input->mnt_count;
+            input->mnt_array = NULL;
         }
         else
         {
             /* potentially update job timestamps using remaining logs */
-            if((in_job.start_time_sec < merge_job.start_time_sec) ||
-               ((in_job.start_time_sec == merge_job.start_time_sec) &&
-                (in_job.start_time_nsec < merge_job.start_time_nsec)))
+            if((input->job.start_time_sec < merge_job.start_time_sec) ||
+               ((input->job.start_time_sec == merge_job.start_time_sec) &&
+                (input->job.start_time_nsec < merge_job.start_time_nsec)))
             {
-                merge_job.start_time_sec = in_job.start_time_sec;
-                merge_job.start_time_nsec = in_job.start_time_nsec;
+                merge_job.start_time_sec = input->job.start_time_sec;
+                merge_job.start_time_nsec = input->job.start_time_nsec;
             }
-            if((in_job.end_time_sec > merge_job.end_time_sec) ||
-               ((in_job.end_time_sec == merge_job.end_time_sec) &&
-                (in_job.end_time_nsec > merge_job.end_time_nsec)))
+            if((input->job.end_time_sec > merge_job.end_time_sec) ||
+               ((input->job.end_time_sec == merge_job.end_time_sec) &&
+                (input->job.end_time_nsec > merge_job.end_time_nsec)))
             {
-                merge_job.end_time_sec = in_job.end_time_sec;
-                merge_job.end_time_nsec = in_job.end_time_nsec;
+                merge_job.end_time_sec = input->job.end_time_sec;
+                merge_job.end_time_nsec = input->job.end_time_nsec;
             }
         }
 
-        /* read the hash of ids->names for the input log */
-        ret = darshan_log_get_namehash(in_fd, &in_hash);
-        if(ret < 0)
-        {
-            fprintf(stderr,
-                "Error: unable to read job data from input Darshan log file %s.\n",
-                infile_list[i]);
-            darshan_log_close(in_fd);
-            return(-1);
-        }
-
-        /* iterate the input hash, copying over record id->name mappings
+        /* iterate the input hash, moving over record id->name mappings
          * that have not already been copied to the output hash
          */
-        HASH_ITER(hlink, in_hash, ref, tmp)
+        HASH_ITER(hlink, input->name_hash, ref, tmp)
         {
             HASH_FIND(hlink, merge_hash, &(ref->name_record->id),
                 sizeof(darshan_record_id), found);
             if(!found)
             {
+                HASH_DELETE(hlink, input->name_hash, ref);
                 HASH_ADD(hlink, merge_hash, name_record->id,
                     sizeof(darshan_record_id), ref);
             }
@@ -329,12 +596,74 @@ int main(int argc, char *argv[])
             {
                 fprintf(stderr,
                     "Error: invalid Darshan record table entry.\n");
-                darshan_log_close(in_fd);
-                return(-1);
+                ret = -1;
+                break;
             }
         }
 
-        darshan_log_close(in_fd);
+        /* merge module records into the output log */
+        for(j = 0; j < DARSHAN_KNOWN_MODULE_COUNT && ret == 0; j++)
+        {
+            if(!mod_logutils[j]) continue;
+
+            if(shared_redux && mod_logutils[j]->log_agg_records)
+                ret = merge_mod_records(mod_fds[j], j, input, i == 0,
+                    &shared_rec_hash[j]);
+            else
+            {
+                int k;
+
+                for(k = 0; k < input->rec_cnt[j] && ret == 0; k++)
+                    ret = mod_logutils[j]->log_put_record(mod_fds[j],
+                        input->recs[j][k]);
+            }
+            if(ret < 0)
+                fprintf(stderr,
+                    "Error: unable to write %s module record to output log file %s.\n",
+                    darshan_module_names[j], infile_list[i]);
+        }
+
+        /* hand the input slot back to the decoding threads */
+        free_input(input);
+        pthread_mutex_lock(&ms.mutex);
+        input->status = MERGE_INPUT_EMPTY;
+        ms.next_merge++;
+        pthread_cond_broadcast(&ms.cond);
+        pthread_mutex_unlock(&ms.mutex);
+    }
+
+    pthread_mutex_lock(&ms.mutex);
+    ms.abort = 1;
+    pthread_cond_broadcast(&ms.cond);
+    pthread_mutex_unlock(&ms.mutex);
+    for(i = 0; i < nthreads; i++)
+        pthread_join(threads[i], NULL);
+    for(i = 0; i < ms.window; i++)
+        free_input(&ms.inputs[i]);
+    free(ms.inputs);
+    free(threads);
+    pthread_mutex_destroy(&ms.mutex);
+    pthread_cond_destroy(&ms.cond);
+
+    /* write out the records that were candidates for being shared */
+    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
+    {
+        if(put_shared_records(mod_fds[i], i, merge_job.nprocs,
+            &shared_rec_hash[i]) < 0 && ret == 0)
+        {
+            fprintf(stderr,
+                "Error: unable to write %s module record to output darshan log.\n",
+                darshan_module_names[i]);
+            ret = -1;
+        }
+        if(mod_fds[i] && darshan_log_region_writer_close(mod_fds[i]) < 0)
+            ret = -1;
+    }
+    if(ret < 0)
+    {
+        darshan_log_close(merge_fd);
+        unlink(outlog_path);
+        return(-1);
     }
 
     /* if a job end time was passed in, apply it to the output job */
@@ -344,14 +673,6 @@ int main(int argc, char *argv[])
         merge_job.end_time_nsec = 0; /* no nsec precision for manually specified end */
     }
 
-    /* create the output "merged" log */
-    merge_fd = darshan_log_create(outlog_path, DARSHAN_ZLIB_COMP, 1);
-    if(merge_fd == NULL)
-    {
-        fprintf(stderr, "Error: unable to create output darshan log.\n");
-        return(-1);
-    }
-
     /* write the darshan job info, exe string, and mount data to output file */
     ret = darshan_log_put_job(merge_fd, &merge_job);
     if(ret < 0)
@@ -390,124 +711,6 @@ int main(int argc, char *argv[])
         return(-1);
     }
 
-    mod_buf = malloc(DEF_MOD_BUF_SIZE);
-    if(!mod_buf)
-    {
-        fprintf(stderr, "Error: unable to write record table to output darshan log.\n");
-        darshan_log_close(merge_fd);
-        unlink(outlog_path);
-        return(-1);
-    }
-
-    /* iterate over active darshan modules and gather module data to write
-     * to the merged output log
-     */
-    for(i = 0; i < DARSHAN_KNOWN_MODULE_COUNT; i++)
-    {
-        if(!mod_logutils[i]) continue;
-
-        if(shared_redux)
-        {
-            /* build the hash of records shared globally by this module */
-            ret = build_mod_shared_rec_hash(infile_list, n_infiles, i,
-                merge_job.nprocs, mod_buf, &shared_rec_hash);
-            if(ret < 0)
-            {
-                fprintf(stderr,
-                    "Error: unable to build list of %s module's shared records.\n",
-                    darshan_module_names[i]);
-                darshan_log_close(merge_fd);
-                unlink(outlog_path);
-                free(mod_buf);
-                return(-1);
-            }
-
-        }
-
-        for(j = 0; j < n_infiles; j++)
-        {
-            in_fd = darshan_log_open(infile_list[j]);
-            if(in_fd == NULL)
-            {
-                fprintf(stderr,
-                    "Error: unable to open input Darshan log file %s.\n",
-                    infile_list[j]);
-                darshan_log_close(merge_fd);
-                unlink(outlog_path);
-                free(mod_buf);
-                return(-1);
-            }
-
-            if(j == 0 && shared_rec_hash)
-            {
-                /* write out the shared records first */
-                HASH_ITER(hlink, shared_rec_hash, sref, stmp)
-                {
-                    ret = mod_logutils[i]->log_put_record(merge_fd, sref->agg_rec);
-                    if(ret < 0)
-                    {
-                        fprintf(stderr,
-                            "Error: unable to write %s module record to output darshan log.\n",
-                            darshan_module_names[i]);
-                        darshan_log_close(in_fd);
-                        darshan_log_close(merge_fd);
-                        unlink(outlog_path);
-                        free(mod_buf);
-                        return(-1);
-                    }
-                }
-            }
-
-            /* loop over module records and write them to output file */
-            while((ret = mod_logutils[i]->log_get_record(in_fd, (void **)&mod_buf)) == 1)
-            {
-                base_rec = (struct darshan_base_record *)mod_buf;
-
-                HASH_FIND(hlink, shared_rec_hash, &(base_rec->id), sizeof(darshan_record_id), sref);
-                if(sref)
-                    continue; /* skip shared records */
-
-                ret = mod_logutils[i]->log_put_record(merge_fd, mod_buf);
-                if(ret < 0)
-                {
-                    fprintf(stderr,
-                        "Error: unable to write %s module record to output log file %s.\n",
-                        darshan_module_names[i], infile_list[j]);
-                    darshan_log_close(in_fd);
-                    darshan_log_close(merge_fd);
-                    unlink(outlog_path);
-                    free(mod_buf);
-                    return(-1);
-                }
-            }
-            if(ret < 0)
-            {
-                fprintf(stderr,
-                    "Error: unable to read %s module record from input log file %s.\n",
-                    darshan_module_names[i], infile_list[j]);
-                darshan_log_close(in_fd);
-                darshan_log_close(merge_fd);
-                unlink(outlog_path);
-                free(mod_buf);
-                return(-1);
-            }
-
-            darshan_log_close(in_fd);
-        }
-
-        /* clear the shared record hash for the next module */
-        if(shared_redux)
-        {
-            HASH_ITER(hlink, shared_rec_hash, sref, stmp)
-            {
-                HASH_DELETE(hlink, shared_rec_hash, sref);
-                free(sref);
-            }
-        }
-    }
-
-    free(mod_buf);
-
     darshan_log_close(merge_fd);
 
     return(0);
@@ -0,0 +1,325 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "darshan-util-config.h"
+#endif
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "darshan-logutils.h"
+
+/* integer counter name strings for the MMAP module */
+#define X(a) #a,
+char *mmap_counter_names[] = {
+    MMAP_COUNTERS
+};
+
+/* floating point counter name strings for the MMAP module */
+char *mmap_f_counter_names[] = {
+    MMAP_F_COUNTERS
+};
+#undef X
+
+/* prototypes for each of the MMAP module's logutil functions */
+static int darshan_log_get_mmap_record(darshan_fd fd, void** mmap_buf_p);
+static int darshan_log_put_mmap_record(darshan_fd fd, void* mmap_buf);
+static void darshan_log_print_mmap_record(void *file_rec,
+    char *file_name, char *mnt_pt, char *fs_type);
+static void darshan_log_print_mmap_description(int ver);
+static void darshan_log_print_mmap_record_diff(void *file_rec1, char *file_name1,
+    void *file_rec2, char *file_name2);
+static void darshan_log_agg_mmap_records(void *rec, void *agg_rec, int init_flag);
+
+/* structure storing each function needed for implementing the darshan
+ * logutil interface. these functions are used for reading, writing, and
+ * printing module data in a consistent manner.
+ */
+struct darshan_mod_logutil_funcs mmap_logutils =
+{
+    .log_get_record = &darshan_log_get_mmap_record,
+    .log_put_record = &darshan_log_put_mmap_record,
+    .log_print_record = &darshan_log_print_mmap_record,
+    .log_print_description = &darshan_log_print_mmap_description,
+    .log_print_diff = &darshan_log_print_mmap_record_diff,
+    .log_agg_records = &darshan_log_agg_mmap_records
+};
+
+/* retrieve a MMAP record from log file descriptor 'fd', storing the
+ * data in the buffer address pointed to by 'mmap_buf_p'. Return 1 on
+ * successful record read, 0 on no more data, and -1 on error.
+ */
+static int darshan_log_get_mmap_record(darshan_fd fd, void** mmap_buf_p)
+{
+    struct darshan_mmap_record *rec = *((struct darshan_mmap_record **)mmap_buf_p);
+    int ret;
+
+    if(fd->mod_map[DARSHAN_MMAP_MOD].len == 0)
+        return(0);
+
+    if(fd->mod_ver[DARSHAN_MMAP_MOD] == 0 ||
+        fd->mod_ver[DARSHAN_MMAP_MOD] > DARSHAN_MMAP_VER)
+    {
+        fprintf(stderr, "Error: Invalid MMAP module version number (got %d)\n",
+            fd->mod_ver[DARSHAN_MMAP_MOD]);
+        return(-1);
+    }
+
+    if(*mmap_buf_p == NULL)
+    {
+        rec = malloc(sizeof(*rec));
+        if(!rec)
+            return(-1);
+    }
+
+    /* read a MMAP module record from the darshan log file */
+    ret = darshan_log_get_mod(fd, DARSHAN_MMAP_MOD, rec,
+        sizeof(struct darshan_mmap_record));
+
+    if(*mmap_buf_p == NULL)
+    {
+        if(ret == sizeof(struct darshan_mmap_record))
+            *mmap_buf_p = rec;
+        else
+            free(rec);
+    }
+
+    if(ret < 0)
+        return(-1);
+    else if(ret < sizeof(struct darshan_mmap_record))
+        return(0);
+    else
+    {
+        /* if the read was successful, do any necessary byte-swapping */
+        if(fd->swap_flag)
+        {
+            /* records consist only of 64-bit fields */
+            darshan_log_bswap64_array(rec,
+                sizeof(struct darshan_mmap_record) / sizeof(int64_t));
+        }
+
+        return(1);
+    }
+}
+
+/* write the MMAP record stored in 'mmap_buf' to log file descriptor 'fd'.
+ * Return 0 on success, -1 on failure
+ */
+static int darshan_log_put_mmap_record(darshan_fd fd, void* mmap_buf)
+{
+    struct darshan_mmap_record *rec = (struct darshan_mmap_record *)mmap_buf;
+    int ret;
+
+    /* append MMAP record to darshan log file */
+    ret = darshan_log_put_mod(fd, DARSHAN_MMAP_MOD, rec,
+        sizeof(struct darshan_mmap_record), DARSHAN_MMAP_VER);
+    if(ret < 0)
+        return(-1);
+
+    return(0);
+}
+
+/* print all I/O data record statistics for the given MMAP record */
+static void darshan_log_print_mmap_record(void *file_rec, char *file_name,
+    char *mnt_pt, char *fs_type)
+{
+    int i;
+    struct darshan_mmap_record *mmap_rec =
+        (struct darshan_mmap_record *)file_rec;
+
+    /* print each of the integer and floating point counters for the MMAP module */
+    for(i=0; i<MMAP_NUM_INDICES; i++)
+    {
+        /* macro defined in darshan-logutils.h */
+        DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_MMAP_MOD],
+            mmap_rec->base_rec.rank, mmap_rec->base_rec.id,
+            mmap_counter_names[i], mmap_rec->counters[i],
+            file_name, mnt_pt, fs_type);
+    }
+
+    for(i=0; i<MMAP_F_NUM_INDICES; i++)
+    {
+        /* macro defined in darshan-logutils.h */
+        DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_MMAP_MOD],
+            mmap_rec->base_rec.rank, mmap_rec->base_rec.id,
+            mmap_f_counter_names[i], mmap_rec->fcounters[i],
+            file_name, mnt_pt, fs_type);
+    }
+
+    return;
+}
+
+/* print out a description of the MMAP module record fields */
+static void darshan_log_print_mmap_description(int ver)
+{
+    printf("\n# description of MMAP counters:\n");
+    printf("#   records are kept for each file mapped into memory, and count the\n");
+    printf("#   pages of its mappings seen resident by periodic mincore() samples.\n");
+    printf("#   mappings of more than 2^20 pages are tracked in blocks of pages.\n");
+    printf("#   MMAP_MAPS: mappings of the file that were tracked.\n");
+    printf("#   MMAP_UNTRACKED_MAPS: mappings not tracked, as too many were live.\n");
+    printf("#   MMAP_WRITE_MAPS: shared, writable mappings.\n");
+    printf("#   MMAP_MAPPED_BYTES, MMAP_MAX_MAPPED_BYTES: total and largest mapping size.\n");
+    printf("#   MMAP_PAGE_SIZE: page size the residency counters are measured in.\n");
+    printf("#   MMAP_SAMPLES: residency samples taken of the file's mappings.\n");
+    printf("#   MMAP_INITIAL_RESIDENT_BYTES: bytes resident when each mapping was\n");
+    printf("#       first sampled, e.g. from the page cache.\n");
+    printf("#   MMAP_FAULTED_BYTES: bytes that became resident while mapped, an\n");
+    printf("#       estimate of the bytes faulted in through the mappings.\n");
+    printf("#   MMAP_MAX_RESIDENT_BYTES: most bytes of one mapping resident at once.\n");
+    printf("#   MMAP_SEQ_PAGES, MMAP_RANDOM_PAGES: newly resident pages that do and\n");
+    printf("#       do not directly follow a page already seen resident.\n");
+    printf("#   MMAP_RESIDENT_EXTENTS: contiguous extents of pages seen resident,\n");
+    printf("#       summed over the mappings (1 per mapping for one sequential sweep).\n");
+    printf("#   MMAP_F_MAP_START_TIMESTAMP: timestamp of the first mapping.\n");
+    printf("#   MMAP_F_SAMPLE_END_TIMESTAMP: timestamp of the last sample.\n");
+    printf("#   MMAP_F_SAMPLE_TIME: cumulative time spent sampling the mappings.\n");
+
+    return;
+}
+
+/* print a diff of two MMAP records (with the same record id) */
+static void darshan_log_print_mmap_record_diff(void *file_rec1, char *file_name1,
+    void *file_rec2, char *file_name2)
+{
+    struct darshan_mmap_record *file1 = (struct darshan_mmap_record *)file_rec1;
+    struct darshan_mmap_record *file2 = (struct darshan_mmap_record *)file_rec2;
+    int i;
+
+    /* NOTE: we assume that both input records are the same module format version */
+
+    for(i=0; i<MMAP_NUM_INDICES; i++)
+    {
+        if(!file2)
+        {
+            printf("- ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_MMAP_MOD],
+                file1->base_rec.rank, file1->base_rec.id, mmap_counter_names[i],
+                file1->counters[i], file_name1, "", "");
+
+        }
+        else if(!file1)
+        {
+            printf("+ ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_MMAP_MOD],
+                file2->base_rec.rank, file2->base_rec.id, mmap_counter_names[i],
+                file2->counters[i], file_name2, "", "");
+        }
+        else if(file1->counters[i] != file2->counters[i])
+        {
+            printf("- ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_MMAP_MOD],
+                file1->base_rec.rank, file1->base_rec.id, mmap_counter_names[i],
+                file1->counters[i], file_name1, "", "");
+            printf("+ ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_MMAP_MOD],
+                file2->base_rec.rank, file2->base_rec.id, mmap_counter_names[i],
+                file2->counters[i], file_name2, "", "");
+        }
+    }
+
+    for(i=0; i<MMAP_F_NUM_INDICES; i++)
+    {
+        if(!file2)
+        {
+            printf("- ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_MMAP_MOD],
+                file1->base_rec.rank, file1->base_rec.id, mmap_f_counter_names[i],
+                file1->fcounters[i], file_name1, "", "");
+
+        }
+        else if(!file1)
+        {
+            printf("+ ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_MMAP_MOD],
+                file2->base_rec.rank, file2->base_rec.id, mmap_f_counter_names[i],
+                file2->fcounters[i], file_name2, "", "");
+        }
+        else if(file1->fcounters[i] != file2->fcounters[i])
+        {
+            printf("- ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_MMAP_MOD],
+                file1->base_rec.rank, file1->base_rec.id, mmap_f_counter_names[i],
+                file1->fcounters[i], file_name1, "", "");
+            printf("+ ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_MMAP_MOD],
+                file2->base_rec.rank, file2->base_rec.id, mmap_f_counter_names[i],
+                file2->fcounters[i], file_name2, "", "");
+        }
+    }
+
+    return;
+}
+
+/* aggregate the input MMAP record 'rec'  into the output record 'agg_rec' */
+static void darshan_log_agg_mmap_records(void *rec, void *agg_rec, int init_flag)
+{
+    struct darshan_mmap_record *mmap_rec = (struct darshan_mmap_record *)rec;
+    struct darshan_mmap_record *agg_mmap_rec = (struct darshan_mmap_record *)agg_rec;
+    int i;
+
+    for(i = 0; i < MMAP_NUM_INDICES; i++)
+    {
+        switch(i)
+        {
+            case MMAP_MAX_MAPPED_BYTES:
+            case MMAP_PAGE_SIZE:
+            case MMAP_MAX_RESIDENT_BYTES:
+                /* max */
+                if(mmap_rec->counters[i] > agg_mmap_rec->counters[i])
+                    agg_mmap_rec->counters[i] = mmap_rec->counters[i];
+                break;
+            default:
+                /* sum */
+                agg_mmap_rec->counters[i] += mmap_rec->counters[i];
+                break;
+        }
+    }
+
+    for(i = 0; i < MMAP_F_NUM_INDICES; i++)
+    {
+        switch(i)
+        {
+            case MMAP_F_MAP_START_TIMESTAMP:
+                /* min non-zero */
+                if((mmap_rec->fcounters[i] > 0) &&
+                    (init_flag || agg_mmap_rec->fcounters[i] == 0 ||
+                    mmap_rec->fcounters[i] < agg_mmap_rec->fcounters[i]))
+                    agg_mmap_rec->fcounters[i] = mmap_rec->fcounters[i];
+                break;
+            case MMAP_F_SAMPLE_END_TIMESTAMP:
+                /* max */
+                if(mmap_rec->fcounters[i] > agg_mmap_rec->fcounters[i])
+                    agg_mmap_rec->fcounters[i] = mmap_rec->fcounters[i];
+                break;
+            default:
+                /* sum */
+                agg_mmap_rec->fcounters[i] += mmap_rec->fcounters[i];
+                break;
+        }
+    }
+
+    return;
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
@@ -36,6 +36,7 @@ char *mpiio_f_counter_names[] = {
 #undef X
 
 #define DARSHAN_MPIIO_FILE_SIZE_1 544
+#define DARSHAN_MPIIO_FILE_SIZE_3 560
 
 static int darshan_log_get_mpiio_file(darshan_fd fd, void** mpiio_buf_p);
 static int darshan_log_put_mpiio_file(darshan_fd fd, void* mpiio_buf);
@@ -45,7 +46,10 @@ static void darshan_log_print_mpiio_description(int ver);
 static void darshan_log_print_mpiio_file_diff(void *file_rec1, char *file_name1,
     void *file_rec2, char *file_name2);
 static void darshan_log_agg_mpiio_files(void *rec, void *agg_rec, int init_flag);
+static void darshan_log_agg_mpiio_files_batch(void *rec_buf, int count,
+    void *agg_rec, int init_flag);
 static int darshan_log_sizeof_mpiio_file(void* mpiio_buf_p);
+static void darshan_log_swap_mpiio_file(void *mpiio_buf_p);
 static int darshan_log_record_metrics_mpiio_file(void*    mpiio_buf_p,
                                                  uint64_t* rec_id,
                                                  int64_t* r_bytes,
@@ -65,8 +69,10 @@ struct darshan_mod_logutil_funcs mpiio_logutils =
     .log_print_description = &darshan_log_print_mpiio_description,
     .log_print_diff = &darshan_log_print_mpiio_file_diff,
     .log_agg_records = &darshan_log_agg_mpiio_files,
+    .log_agg_records_batch = &darshan_log_agg_mpiio_files_batch,
     .log_sizeof_record = &darshan_log_sizeof_mpiio_file,
-    .log_record_metrics = &darshan_log_record_metrics_mpiio_file
+    .log_record_metrics = &darshan_log_record_metrics_mpiio_file,
+    .log_swap_record = &darshan_log_swap_mpiio_file
 };
 
 static int darshan_log_sizeof_mpiio_file(void* mpiio_buf_p)
@@ -75,6 +81,16 @@ static int darshan_log_sizeof_mpiio_file(void* mpiio_buf_p)
     return(sizeof(struct darshan_mpiio_file));
 }
 
+/* byte swap an MPI-IO record of the current log format version in place */
+static void darshan_log_swap_mpiio_file(void *mpiio_buf_p)
+{
+    /* records consist only of 64-bit fields, so swap them in one pass */
+    darshan_log_bswap64_array(mpiio_buf_p,
+        sizeof(struct darshan_mpiio_file) / sizeof(int64_t));
+
+    return;
+}
+
 static int darshan_log_record_metrics_mpiio_file(void*    mpiio_buf_p,
                                          uint64_t* rec_id,
                                          int64_t* r_bytes,
@@ -161,6 +177,20 @@ static int darshan_log_get_mpiio_file(darshan_fd fd, void** mpiio_buf_p)
         rec_len = sizeof(struct darshan_mpiio_file);
         ret = darshan_log_get_mod(fd, DARSHAN_MPIIO_MOD, file, rec_len);
     }
+    else if(fd->mod_ver[DARSHAN_MPIIO_MOD] == 3)
+    {
+        /* version 3 lacks the trailing collective wait and nonblocking
+         * completion counters
+         */
+        rec_len = DARSHAN_MPIIO_FILE_SIZE_3;
+        ret = darshan_log_get_mod(fd, DARSHAN_MPIIO_MOD, file, rec_len);
+        /* set F_COLL_WAIT_TIME through F_NB_WAIT_TIME to -1 */
+        file->fcounters[MPIIO_F_COLL_WAIT_TIME] = -1;
+        file->fcounters[MPIIO_F_COLL_IO_TIME] = -1;
+        file->fcounters[MPIIO_F_NB_READ_TIME] = -1;
+        file->fcounters[MPIIO_F_NB_WRITE_TIME] = -1;
+        file->fcounters[MPIIO_F_NB_WAIT_TIME] = -1;
+    }
     else
     {
         char scratch[1024] = {0};
@@ -183,6 +213,12 @@ static int darshan_log_get_mpiio_file(darshan_fd fd, void** mpiio_buf_p)
         *((double *)(src_p + sizeof(double))) = -1;
 
         memcpy(file, scratch, sizeof(struct darshan_mpiio_file));
+        /* set F_COLL_WAIT_TIME through F_NB_WAIT_TIME to -1 */
+        file->fcounters[MPIIO_F_COLL_WAIT_TIME] = -1;
+        file->fcounters[MPIIO_F_COLL_IO_TIME] = -1;
+        file->fcounters[MPIIO_F_NB_READ_TIME] = -1;
+        file->fcounters[MPIIO_F_NB_WRITE_TIME] = -1;
+        file->fcounters[MPIIO_F_NB_WAIT_TIME] = -1;
     }
    
 exit:
@@ -201,7 +237,9 @@ exit:
     else
     {
         /* if the read was successful, do any necessary byte-swapping */
-        if(fd->swap_flag)
+        if(fd->swap_flag && fd->mod_ver[DARSHAN_MPIIO_MOD] == DARSHAN_MPIIO_VER)
+            darshan_log_swap_mpiio_file(file);
+        else if(fd->swap_flag)
         {
             DARSHAN_BSWAP64(&(file->base_rec.id));
             DARSHAN_BSWAP64(&(file->base_rec.rank));
@@ -216,6 +254,13 @@ exit:
                     ((i == MPIIO_F_CLOSE_START_TIMESTAMP) ||
                      (i == MPIIO_F_OPEN_END_TIMESTAMP)))
                     continue;
+                if((fd->mod_ver[DARSHAN_MPIIO_MOD] < 4) &&
+                    ((i == MPIIO_F_COLL_WAIT_TIME) ||
+                     (i == MPIIO_F_COLL_IO_TIME) ||
+                     (i == MPIIO_F_NB_READ_TIME) ||
+                     (i == MPIIO_F_NB_WRITE_TIME) ||
+                     (i == MPIIO_F_NB_WAIT_TIME)))
+                    continue;
                 DARSHAN_BSWAP64(&file->fcounters[i]);
             }
         }
@@ -289,6 +334,10 @@ static void darshan_log_print_mpiio_description(int ver)
     printf("#   MPIIO_F_MAX_*_TIME: duration of the slowest MPI-IO read and write operations.\n");
     printf("#   MPIIO_F_*_RANK_TIME: fastest and slowest I/O time for a single rank (for shared files).\n");
     printf("#   MPIIO_F_VARIANCE_RANK_*: variance of total I/O time and bytes moved for all ranks (for shared files).\n");
+    printf("#   MPIIO_F_COLL_WAIT_TIME: cumulative time spent in collective reads and writes waiting for all ranks to enter them (if measured).\n");
+    printf("#   MPIIO_F_COLL_IO_TIME: cumulative time spent in collective reads and writes once all ranks had entered them (if measured).\n");
+    printf("#   MPIIO_F_NB_*_TIME: cumulative time from issuing nonblocking reads and writes to their completion.\n");
+    printf("#   MPIIO_F_NB_WAIT_TIME: cumulative time spent blocked in the MPI_Wait/MPI_Test calls completing nonblocking reads and writes.\n");
 
     if(ver == 1)
     {
@@ -301,6 +350,15 @@ static void darshan_log_print_mpiio_description(int ver)
         printf("# - MPIIO_F_CLOSE_START_TIMESTAMP\n");
         printf("# - MPIIO_F_OPEN_END_TIMESTAMP\n");
     }
+    if(ver <= 3)
+    {
+        printf("\n# WARNING: MPIIO module log format version <=3 does not support the following counters:\n");
+        printf("# - MPIIO_F_COLL_WAIT_TIME\n");
+        printf("# - MPIIO_F_COLL_IO_TIME\n");
+        printf("# - MPIIO_F_NB_READ_TIME\n");
+        printf("# - MPIIO_F_NB_WRITE_TIME\n");
+        printf("# - MPIIO_F_NB_WAIT_TIME\n");
+    }
 
     return;
 }
@@ -385,7 +443,29 @@ struct var_t
     double S;
 };
 
-static void darshan_log_agg_mpiio_files(void *rec, void *agg_rec, int init_flag)
+/* how the MPI-IO counters are aggregated, as runs of consecutive counters;
+ * counters not covered here are handled by darshan_log_agg_mpiio_custom()
+ */
+static const struct darshan_agg_run mpiio_agg_runs[] =
+{
+    {MPIIO_INDEP_OPENS, MPIIO_VIEWS, DARSHAN_AGG_SUM},
+    {MPIIO_MODE, MPIIO_MODE, DARSHAN_AGG_SET},
+    {MPIIO_BYTES_READ, MPIIO_RW_SWITCHES, DARSHAN_AGG_SUM},
+    {MPIIO_SIZE_READ_AGG_0_100, MPIIO_SIZE_WRITE_AGG_1G_PLUS, DARSHAN_AGG_SUM},
+};
+
+static const struct darshan_agg_run mpiio_agg_fruns[] =
+{
+    {MPIIO_F_OPEN_START_TIMESTAMP, MPIIO_F_CLOSE_START_TIMESTAMP, DARSHAN_AGG_MIN_NONZERO},
+    {MPIIO_F_OPEN_END_TIMESTAMP, MPIIO_F_CLOSE_END_TIMESTAMP, DARSHAN_AGG_MAX},
+    {MPIIO_F_READ_TIME, MPIIO_F_META_TIME, DARSHAN_AGG_SUM},
+    {MPIIO_F_COLL_WAIT_TIME, MPIIO_F_NB_WAIT_TIME, DARSHAN_AGG_SUM_VALID},
+};
+
+/* aggregate the counters of a record that are not covered by the tables
+ * above
+ */
+static void darshan_log_agg_mpiio_custom(void *rec, void *agg_rec, int init_flag)
 {
     struct darshan_mpiio_file *mpi_rec = (struct darshan_mpiio_file *)rec;
     struct darshan_mpiio_file *agg_mpi_rec = (struct darshan_mpiio_file *)agg_rec;
@@ -466,321 +546,206 @@ static void darshan_log_agg_mpiio_files(void *rec, void *agg_rec, int init_flag)
     if(agg_mpi_rec->base_rec.rank != mpi_rec->base_rec.rank)
         agg_mpi_rec->base_rec.rank = -1;
 
-    for(i = 0; i < MPIIO_NUM_INDICES; i++)
+    /* increment common value counters */
+    i = MPIIO_ACCESS1_ACCESS;
+    if(mpi_rec->counters[i] != 0)
     {
-        switch(i)
+        /* first, collapse duplicates */
+        for(j = i; j < i + 4; j++)
         {
-            case MPIIO_INDEP_OPENS:
-            case MPIIO_COLL_OPENS:
-            case MPIIO_INDEP_READS:
-            case MPIIO_INDEP_WRITES:
-            case MPIIO_COLL_READS:
-            case MPIIO_COLL_WRITES:
-            case MPIIO_SPLIT_READS:
-            case MPIIO_SPLIT_WRITES:
-            case MPIIO_NB_READS:
-            case MPIIO_NB_WRITES:
-            case MPIIO_SYNCS:
-            case MPIIO_HINTS:
-            case MPIIO_VIEWS:
-            case MPIIO_BYTES_READ:
-            case MPIIO_BYTES_WRITTEN:
-            case MPIIO_RW_SWITCHES:
-            case MPIIO_SIZE_READ_AGG_0_100:
-            case MPIIO_SIZE_READ_AGG_100_1K:
-            case MPIIO_SIZE_READ_AGG_1K_10K:
-            case MPIIO_SIZE_READ_AGG_10K_100K:
-            case MPIIO_SIZE_READ_AGG_100K_1M:
-            case MPIIO_SIZE_READ_AGG_1M_4M:
-            case MPIIO_SIZE_READ_AGG_4M_10M:
-            case MPIIO_SIZE_READ_AGG_10M_100M:
-            case MPIIO_SIZE_READ_AGG_100M_1G:
-            case MPIIO_SIZE_READ_AGG_1G_PLUS:
-            case MPIIO_SIZE_WRITE_AGG_0_100:
-            case MPIIO_SIZE_WRITE_AGG_100_1K:
-            case MPIIO_SIZE_WRITE_AGG_1K_10K:
-            case MPIIO_SIZE_WRITE_AGG_10K_100K:
-            case MPIIO_SIZE_WRITE_AGG_100K_1M:
-            case MPIIO_SIZE_WRITE_AGG_1M_4M:
-            case MPIIO_SIZE_WRITE_AGG_4M_10M:
-            case MPIIO_SIZE_WRITE_AGG_10M_100M:
-            case MPIIO_SIZE_WRITE_AGG_100M_1G:
-            case MPIIO_SIZE_WRITE_AGG_1G_PLUS:
-                /* sum */
-                agg_mpi_rec->counters[i] += mpi_rec->counters[i];
-                break;
-            case MPIIO_MODE:
-                /* just set to the input value */
-                agg_mpi_rec->counters[i] = mpi_rec->counters[i];
-                break;
-            case MPIIO_MAX_READ_TIME_SIZE:
-            case MPIIO_MAX_WRITE_TIME_SIZE:
-            case MPIIO_FASTEST_RANK:
-            case MPIIO_FASTEST_RANK_BYTES:
-            case MPIIO_SLOWEST_RANK:
-            case MPIIO_SLOWEST_RANK_BYTES:
-                /* these are set with the FP counters */
-                break;
-            case MPIIO_ACCESS1_ACCESS:
-                /* increment common value counters */
-                if(mpi_rec->counters[i] == 0) break;
-
-                /* first, collapse duplicates */
-                for(j = i; j < i + 4; j++)
+            for(k = 0; k < 4; k++)
+            {
+                if(agg_mpi_rec->counters[i + k] == mpi_rec->counters[j])
                 {
-                    for(k = 0; k < 4; k++)
-                    {
-                        if(agg_mpi_rec->counters[i + k] == mpi_rec->counters[j])
-                        {
-                            agg_mpi_rec->counters[i + k + 4] += mpi_rec->counters[j + 4];
-                            /* flag that we should ignore this one now */
-                            duplicate_mask[j-i] = 1;
-                        }
-                    }
+                    agg_mpi_rec->counters[i + k + 4] += mpi_rec->counters[j + 4];
+                    /* flag that we should ignore this one now */
+                    duplicate_mask[j-i] = 1;
                 }
-
-                /* second, add new counters */
-                for(j = i; j < i + 4; j++)
-                {
-                    /* skip any that were handled above already */
-                    if(duplicate_mask[j-i])
-                        continue;
-                    tmp_ndx = 0;
-                    memset(tmp_val, 0, 4 * sizeof(int64_t));
-                    memset(tmp_cnt, 0, 4 * sizeof(int64_t));
-
-                    if(mpi_rec->counters[j] == 0) break;
-                    for(k = 0; k < 4; k++)
-                    {
-                        if(agg_mpi_rec->counters[i + k] == mpi_rec->counters[j])
-                        {
-                            total_count = agg_mpi_rec->counters[i + k + 4] +
-                                mpi_rec->counters[j + 4];
-                            break;
-                        }
-                    }
-                    if(k == 4) total_count = mpi_rec->counters[j + 4];
-
-                    for(k = 0; k < 4; k++)
-                    {
-                        if((agg_mpi_rec->counters[i + k + 4] > total_count) ||
-                           ((agg_mpi_rec->counters[i + k + 4] == total_count) &&
-                            (agg_mpi_rec->counters[i + k] > mpi_rec->counters[j])))
-                        {
-                            tmp_val[tmp_ndx] = agg_mpi_rec->counters[i + k];
-                            tmp_cnt[tmp_ndx] = agg_mpi_rec->counters[i + k + 4];
-                            tmp_ndx++;
-                        }
-                        else break;
-                    }
-                    if(tmp_ndx == 4) break;
-
-                    tmp_val[tmp_ndx] = mpi_rec->counters[j];
-                    tmp_cnt[tmp_ndx] = mpi_rec->counters[j + 4];
-                    tmp_ndx++;
-
-                    while(tmp_ndx != 4)
-                    {
-                        if(agg_mpi_rec->counters[i + k] != mpi_rec->counters[j])
-                        {
-                            tmp_val[tmp_ndx] = agg_mpi_rec->counters[i + k];
-                            tmp_cnt[tmp_ndx] = agg_mpi_rec->counters[i + k + 4];
-                            tmp_ndx++;
-                        }
-                        k++;
-                    }
-                    memcpy(&(agg_mpi_rec->counters[i]), tmp_val, 4 * sizeof(int64_t));
-                    memcpy(&(agg_mpi_rec->counters[i + 4]), tmp_cnt, 4 * sizeof(int64_t));
-                }
-                break;
-            case MPIIO_ACCESS2_ACCESS:
-            case MPIIO_ACCESS3_ACCESS:
-            case MPIIO_ACCESS4_ACCESS:
-            case MPIIO_ACCESS1_COUNT:
-            case MPIIO_ACCESS2_COUNT:
-            case MPIIO_ACCESS3_COUNT:
-            case MPIIO_ACCESS4_COUNT:
-                /* these are set all at once with common counters above */
-                break;
-            /* intentionally do not include a default block; we want to
-             * get a compile-time warning in this function when new
-             * counters are added to the enumeration to make sure we
-             * handle them all correctly.
-             */
-#if 0
-            default:
-                agg_mpi_rec->counters[i] = -1;
-                break;
-#endif
+            }
         }
-    }
 
-    for(i = 0; i < MPIIO_F_NUM_INDICES; i++)
-    {
-        switch(i)
+        /* second, add new counters */
+        for(j = i; j < i + 4; j++)
         {
-            case MPIIO_F_READ_TIME:
-            case MPIIO_F_WRITE_TIME:
-            case MPIIO_F_META_TIME:
-                /* sum */
-                agg_mpi_rec->fcounters[i] += mpi_rec->fcounters[i];
-                break;
-            case MPIIO_F_OPEN_START_TIMESTAMP:
-            case MPIIO_F_READ_START_TIMESTAMP:
-            case MPIIO_F_WRITE_START_TIMESTAMP:
-            case MPIIO_F_CLOSE_START_TIMESTAMP:
-                /* minimum non-zero */
-                if((mpi_rec->fcounters[i] > 0)  &&
-                    ((agg_mpi_rec->fcounters[i] == 0) ||
-                    (mpi_rec->fcounters[i] < agg_mpi_rec->fcounters[i])))
-                {
-                    agg_mpi_rec->fcounters[i] = mpi_rec->fcounters[i];
-                }
-                break;
-            case MPIIO_F_OPEN_END_TIMESTAMP:
-            case MPIIO_F_READ_END_TIMESTAMP:
-            case MPIIO_F_WRITE_END_TIMESTAMP:
-            case MPIIO_F_CLOSE_END_TIMESTAMP:
-                /* maximum */
-                if(mpi_rec->fcounters[i] > agg_mpi_rec->fcounters[i])
-                {
-                    agg_mpi_rec->fcounters[i] = mpi_rec->fcounters[i];
-                }
-                break;
-            case MPIIO_F_MAX_READ_TIME:
-                if(mpi_rec->fcounters[i] > agg_mpi_rec->fcounters[i])
-                {
-                    agg_mpi_rec->fcounters[i] = mpi_rec->fcounters[i];
-                    agg_mpi_rec->counters[MPIIO_MAX_READ_TIME_SIZE] =
-                        mpi_rec->counters[MPIIO_MAX_READ_TIME_SIZE];
-                }
-                break;
-            case MPIIO_F_MAX_WRITE_TIME:
-                if(mpi_rec->fcounters[i] > agg_mpi_rec->fcounters[i])
-                {
-                    agg_mpi_rec->fcounters[i] = mpi_rec->fcounters[i];
-                    agg_mpi_rec->counters[MPIIO_MAX_WRITE_TIME_SIZE] =
-                        mpi_rec->counters[MPIIO_MAX_WRITE_TIME_SIZE];
-                }
-                break;
-            case MPIIO_F_FASTEST_RANK_TIME:
-
-                if(!shared_file_flag)
+            /* skip any that were handled above already */
+            if(duplicate_mask[j-i])
+                continue;
+            tmp_ndx = 0;
+            memset(tmp_val, 0, 4 * sizeof(int64_t));
+            memset(tmp_cnt, 0, 4 * sizeof(int64_t));
+
+            if(mpi_rec->counters[j] == 0) break;
+            for(k = 0; k < 4; k++)
+            {
+                if(agg_mpi_rec->counters[i + k] == mpi_rec->counters[j])
                 {
-                    /* The fastest counters are only valid under these
-                     * conditions when aggregating records that all refer to
-                     * the same file.
-                     */
-                    agg_mpi_rec->counters[MPIIO_FASTEST_RANK] = -1;
-                    agg_mpi_rec->counters[MPIIO_FASTEST_RANK_BYTES] = -1;
-                    agg_mpi_rec->fcounters[MPIIO_F_FASTEST_RANK_TIME] = 0.0;
+                    total_count = agg_mpi_rec->counters[i + k + 4] +
+                        mpi_rec->counters[j + 4];
                     break;
                 }
-                if (init_flag ||
-                    mpi_fastest_time < agg_mpi_rec->fcounters[MPIIO_F_FASTEST_RANK_TIME]) {
-                    /* The incoming record wins if a) this is the first
-                     * record we are aggregating or b) it is the fastest
-                     * record we have seen so far.
-                     */
-                    agg_mpi_rec->counters[MPIIO_FASTEST_RANK]
-                        = mpi_fastest_rank;
-                    agg_mpi_rec->counters[MPIIO_FASTEST_RANK_BYTES]
-                        = mpi_fastest_bytes;
-                    agg_mpi_rec->fcounters[MPIIO_F_FASTEST_RANK_TIME]
-                        = mpi_fastest_time;
-                }
-                break;
-            case MPIIO_F_SLOWEST_RANK_TIME:
-                if(!shared_file_flag)
+            }
+            if(k == 4) total_count = mpi_rec->counters[j + 4];
+
+            for(k = 0; k < 4; k++)
+            {
+                if((agg_mpi_rec->counters[i + k + 4] > total_count) ||
+                   ((agg_mpi_rec->counters[i + k + 4] == total_count) &&
+                    (agg_mpi_rec->counters[i + k] > mpi_rec->counters[j])))
                 {
-                    /* The slowest counters are only valid under these
-                     * conditions when aggregating records that all refer to
-                     * the same file.
-                     */
-                    agg_mpi_rec->counters[MPIIO_SLOWEST_RANK] = -1;
-                    agg_mpi_rec->counters[MPIIO_SLOWEST_RANK_BYTES] = -1;
-                    agg_mpi_rec->fcounters[MPIIO_F_SLOWEST_RANK_TIME] = 0.0;
-                    break;
-                }
-                if (init_flag ||
-                    mpi_slowest_time > agg_mpi_rec->fcounters[MPIIO_F_SLOWEST_RANK_TIME]) {
-                    /* The incoming record wins if a) this is the first
-                     * record we are aggregating or b) it is the slowest
-                     * record we have seen so far.
-                     */
-                    agg_mpi_rec->counters[MPIIO_SLOWEST_RANK]
-                        = mpi_slowest_rank;
-                    agg_mpi_rec->counters[MPIIO_SLOWEST_RANK_BYTES]
-                        = mpi_slowest_bytes;
-                    agg_mpi_rec->fcounters[MPIIO_F_SLOWEST_RANK_TIME]
-                        = mpi_slowest_time;
+                    tmp_val[tmp_ndx] = agg_mpi_rec->counters[i + k];
+                    tmp_cnt[tmp_ndx] = agg_mpi_rec->counters[i + k + 4];
+                    tmp_ndx++;
                 }
-                break;
+                else break;
+            }
+            if(tmp_ndx == 4) break;
 
-            case MPIIO_F_VARIANCE_RANK_TIME:
-#if 0
-/* NOTE: see comment at the top of this function about the var_* variables */
-                if(init_flag)
+            tmp_val[tmp_ndx] = mpi_rec->counters[j];
+            tmp_cnt[tmp_ndx] = mpi_rec->counters[j + 4];
+            tmp_ndx++;
+
+            while(tmp_ndx != 4)
+            {
+                if(agg_mpi_rec->counters[i + k] != mpi_rec->counters[j])
                 {
-                    var_time_p->n = 1;
-                    var_time_p->M = mpi_time;
-                    var_time_p->S = 0;
+                    tmp_val[tmp_ndx] = agg_mpi_rec->counters[i + k];
+                    tmp_cnt[tmp_ndx] = agg_mpi_rec->counters[i + k + 4];
+                    tmp_ndx++;
                 }
-                else
-                {
-                    old_M = var_time_p->M;
+                k++;
+            }
+            memcpy(&(agg_mpi_rec->counters[i]), tmp_val, 4 * sizeof(int64_t));
+            memcpy(&(agg_mpi_rec->counters[i + 4]), tmp_cnt, 4 * sizeof(int64_t));
+        }
+    }
 
-                    var_time_p->n++;
-                    var_time_p->M += (mpi_time - var_time_p->M) / var_time_p->n;
-                    var_time_p->S += (mpi_time - var_time_p->M) * (mpi_time - old_M);
+    if(mpi_rec->fcounters[MPIIO_F_MAX_READ_TIME] >
+        agg_mpi_rec->fcounters[MPIIO_F_MAX_READ_TIME])
+    {
+        agg_mpi_rec->fcounters[MPIIO_F_MAX_READ_TIME] =
+            mpi_rec->fcounters[MPIIO_F_MAX_READ_TIME];
+        agg_mpi_rec->counters[MPIIO_MAX_READ_TIME_SIZE] =
+            mpi_rec->counters[MPIIO_MAX_READ_TIME_SIZE];
+    }
+    if(mpi_rec->fcounters[MPIIO_F_MAX_WRITE_TIME] >
+        agg_mpi_rec->fcounters[MPIIO_F_MAX_WRITE_TIME])
+    {
+        agg_mpi_rec->fcounters[MPIIO_F_MAX_WRITE_TIME] =
+            mpi_rec->fcounters[MPIIO_F_MAX_WRITE_TIME];
+        agg_mpi_rec->counters[MPIIO_MAX_WRITE_TIME_SIZE] =
+            mpi_rec->counters[MPIIO_MAX_WRITE_TIME_SIZE];
+    }
+
+    if(!shared_file_flag)
+    {
+        /* The fastest and slowest counters are only valid under these
+         * conditions when aggregating records that all refer to the same
+         * file.
+         */
+        agg_mpi_rec->counters[MPIIO_FASTEST_RANK] = -1;
+        agg_mpi_rec->counters[MPIIO_FASTEST_RANK_BYTES] = -1;
+        agg_mpi_rec->fcounters[MPIIO_F_FASTEST_RANK_TIME] = 0.0;
+        agg_mpi_rec->counters[MPIIO_SLOWEST_RANK] = -1;
+        agg_mpi_rec->counters[MPIIO_SLOWEST_RANK_BYTES] = -1;
+        agg_mpi_rec->fcounters[MPIIO_F_SLOWEST_RANK_TIME] = 0.0;
+    }
+    else
+    {
+        if (init_flag ||
+            mpi_fastest_time < agg_mpi_rec->fcounters[MPIIO_F_FASTEST_RANK_TIME]) {
+            /* The incoming record wins if a) this is the first
+             * record we are aggregating or b) it is the fastest
+             * record we have seen so far.
+             */
+            agg_mpi_rec->counters[MPIIO_FASTEST_RANK]
+                = mpi_fastest_rank;
+            agg_mpi_rec->counters[MPIIO_FASTEST_RANK_BYTES]
+                = mpi_fastest_bytes;
+            agg_mpi_rec->fcounters[MPIIO_F_FASTEST_RANK_TIME]
+                = mpi_fastest_time;
+        }
+        if (init_flag ||
+            mpi_slowest_time > agg_mpi_rec->fcounters[MPIIO_F_SLOWEST_RANK_TIME]) {
+            /* The incoming record wins if a) this is the first
+             * record we are aggregating or b) it is the slowest
+             * record we have seen so far.
+             */
+            agg_mpi_rec->counters[MPIIO_SLOWEST_RANK]
+                = mpi_slowest_rank;
+            agg_mpi_rec->counters[MPIIO_SLOWEST_RANK_BYTES]
+                = mpi_slowest_bytes;
+            agg_mpi_rec->fcounters[MPIIO_F_SLOWEST_RANK_TIME]
+                = mpi_slowest_time;
+        }
+    }
 
-                    agg_mpi_rec->fcounters[MPIIO_F_VARIANCE_RANK_TIME] =
-                        var_time_p->S / var_time_p->n;
-                }
-#else
-                agg_mpi_rec->fcounters[i] = 0;
-#endif
-                break;
-            case MPIIO_F_VARIANCE_RANK_BYTES:
 #if 0
 /* NOTE: see comment at the top of this function about the var_* variables */
-                if(init_flag)
-                {
-                    var_bytes_p->n = 1;
-                    var_bytes_p->M = mpi_bytes;
-                    var_bytes_p->S = 0;
-                }
-                else
-                {
-                    old_M = var_bytes_p->M;
+    if(init_flag)
+    {
+        var_time_p->n = 1;
+        var_time_p->M = mpi_time;
+        var_time_p->S = 0;
+        var_bytes_p->n = 1;
+        var_bytes_p->M = mpi_bytes;
+        var_bytes_p->S = 0;
+    }
+    else
+    {
+        old_M = var_time_p->M;
 
-                    var_bytes_p->n++;
-                    var_bytes_p->M += (mpi_bytes - var_bytes_p->M) / var_bytes_p->n;
-                    var_bytes_p->S += (mpi_bytes - var_bytes_p->M) * (mpi_bytes - old_M);
+        var_time_p->n++;
+        var_time_p->M += (mpi_time - var_time_p->M) / var_time_p->n;
+        var_time_p->S += (mpi_time - var_time_p->M) * (mpi_time - old_M);
 
-                    agg_mpi_rec->fcounters[MPIIO_F_VARIANCE_RANK_BYTES] =
-                        var_bytes_p->S / var_bytes_p->n;
-                }
+        agg_mpi_rec->fcounters[MPIIO_F_VARIANCE_RANK_TIME] =
+            var_time_p->S / var_time_p->n;
+
+        old_M = var_bytes_p->M;
+
+        var_bytes_p->n++;
+        var_bytes_p->M += (mpi_bytes - var_bytes_p->M) / var_bytes_p->n;
+        var_bytes_p->S += (mpi_bytes - var_bytes_p->M) * (mpi_bytes - old_M);
+
+        agg_mpi_rec->fcounters[MPIIO_F_VARIANCE_RANK_BYTES] =
+            var_bytes_p->S / var_bytes_p->n;
+    }
 #else
-                agg_mpi_rec->fcounters[i] = 0;
-#endif
-                break;
-            /* intentionally do not include a default block; we want to
-             * get a compile-time warning in this function when new
-             * counters are added to the enumeration to make sure we
-             * handle them all correctly.
-             */
-#if 0
-            default:
-                agg_mpi_rec->fcounters[i] = -1;
-                break;
+    agg_mpi_rec->fcounters[MPIIO_F_VARIANCE_RANK_TIME] = 0;
+    agg_mpi_rec->fcounters[MPIIO_F_VARIANCE_RANK_BYTES] = 0;
 #endif
-        }
+
+    return;
+}
+
+static void darshan_log_agg_mpiio_files_batch(void *rec_buf, int count,
+    void *agg_rec, int init_flag)
+{
+    struct darshan_mpiio_file *mpi_recs = (struct darshan_mpiio_file *)rec_buf;
+    struct darshan_mpiio_file *agg_mpi_rec = (struct darshan_mpiio_file *)agg_rec;
+    int i;
+
+    for(i = 0; i < count; i++)
+    {
+        darshan_log_agg_counters(agg_mpi_rec->counters,
+            mpi_recs[i].counters, mpiio_agg_runs,
+            sizeof(mpiio_agg_runs) / sizeof(mpiio_agg_runs[0]));
+        darshan_log_agg_fcounters(agg_mpi_rec->fcounters,
+            mpi_recs[i].fcounters, mpiio_agg_fruns,
+            sizeof(mpiio_agg_fruns) / sizeof(mpiio_agg_fruns[0]));
+        darshan_log_agg_mpiio_custom(&mpi_recs[i], agg_rec, init_flag && i == 0);
     }
 
     return;
 }
 
+static void darshan_log_agg_mpiio_files(void *rec, void *agg_rec, int init_flag)
+{
+    darshan_log_agg_mpiio_files_batch(rec, 1, agg_rec, init_flag);
+
+    return;
+}
+
 /*
  * Local variables:
  *  c-indent-level: 4
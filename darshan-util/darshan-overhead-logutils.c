@@ -0,0 +1,321 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "darshan-util-config.h"
+#endif
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "darshan-logutils.h"
+
+/* integer counter name strings for the OVERHEAD module */
+#define X(a) #a,
+char *overhead_counter_names[] = {
+    OVERHEAD_COUNTERS
+};
+
+/* floating point counter name strings for the OVERHEAD module */
+char *overhead_f_counter_names[] = {
+    OVERHEAD_F_COUNTERS
+};
+#undef X
+
+/* prototypes for each of the OVERHEAD module's logutil functions */
+static int darshan_log_get_overhead_record(darshan_fd fd, void** overhead_buf_p);
+static int darshan_log_put_overhead_record(darshan_fd fd, void* overhead_buf);
+static void darshan_log_print_overhead_record(void *file_rec,
+    char *file_name, char *mnt_pt, char *fs_type);
+static void darshan_log_print_overhead_description(int ver);
+static void darshan_log_print_overhead_record_diff(void *file_rec1, char *file_name1,
+    void *file_rec2, char *file_name2);
+static void darshan_log_agg_overhead_records(void *rec, void *agg_rec, int init_flag);
+
+/* structure storing each function needed for implementing the darshan
+ * logutil interface. these functions are used for reading, writing, and
+ * printing module data in a consistent manner.
+ */
+struct darshan_mod_logutil_funcs overhead_logutils =
+{
+    .log_get_record = &darshan_log_get_overhead_record,
+    .log_put_record = &darshan_log_put_overhead_record,
+    .log_print_record = &darshan_log_print_overhead_record,
+    .log_print_description = &darshan_log_print_overhead_description,
+    .log_print_diff = &darshan_log_print_overhead_record_diff,
+    .log_agg_records = &darshan_log_agg_overhead_records
+};
+
+/* retrieve a OVERHEAD record from log file descriptor 'fd', storing the
+ * data in the buffer address pointed to by 'overhead_buf_p'. Return 1 on
+ * successful record read, 0 on no more data, and -1 on error.
+ */
+static int darshan_log_get_overhead_record(darshan_fd fd, void** overhead_buf_p)
+{
+    struct darshan_overhead_record *rec = *((struct darshan_overhead_record **)overhead_buf_p);
+    int ret;
+
+    if(fd->mod_map[DARSHAN_OVERHEAD_MOD].len == 0)
+        return(0);
+
+    if(fd->mod_ver[DARSHAN_OVERHEAD_MOD] == 0 ||
+        fd->mod_ver[DARSHAN_OVERHEAD_MOD] > DARSHAN_OVERHEAD_VER)
+    {
+        fprintf(stderr, "Error: Invalid OVERHEAD module version number (got %d)\n",
+            fd->mod_ver[DARSHAN_OVERHEAD_MOD]);
+        return(-1);
+    }
+
+    if(*overhead_buf_p == NULL)
+    {
+        rec = malloc(sizeof(*rec));
+        if(!rec)
+            return(-1);
+    }
+
+    /* read a OVERHEAD module record from the darshan log file */
+    ret = darshan_log_get_mod(fd, DARSHAN_OVERHEAD_MOD, rec,
+        sizeof(struct darshan_overhead_record));
+
+    if(*overhead_buf_p == NULL)
+    {
+        if(ret == sizeof(struct darshan_overhead_record))
+            *overhead_buf_p = rec;
+        else
+            free(rec);
+    }
+
+    if(ret < 0)
+        return(-1);
+    else if(ret < sizeof(struct darshan_overhead_record))
+        return(0);
+    else
+    {
+        /* if the read was successful, do any necessary byte-swapping */
+        if(fd->swap_flag)
+        {
+            /* records consist only of 64-bit fields */
+            darshan_log_bswap64_array(rec,
+                sizeof(struct darshan_overhead_record) / sizeof(int64_t));
+        }
+
+        return(1);
+    }
+}
+
+/* write the OVERHEAD record stored in 'overhead_buf' to log file descriptor 'fd'.
+ * Return 0 on success, -1 on failure
+ */
+static int darshan_log_put_overhead_record(darshan_fd fd, void* overhead_buf)
+{
+    struct darshan_overhead_record *rec = (struct darshan_overhead_record *)overhead_buf;
+    int ret;
+
+    /* append OVERHEAD record to darshan log file */
+    ret = darshan_log_put_mod(fd, DARSHAN_OVERHEAD_MOD, rec,
+        sizeof(struct darshan_overhead_record), DARSHAN_OVERHEAD_VER);
+    if(ret < 0)
+        return(-1);
+
+    return(0);
+}
+
+/* print all I/O data record statistics for the given OVERHEAD record */
+static void darshan_log_print_overhead_record(void *file_rec, char *file_name,
+    char *mnt_pt, char *fs_type)
+{
+    int i;
+    struct darshan_overhead_record *overhead_rec =
+        (struct darshan_overhead_record *)file_rec;
+
+    /* print each of the integer and floating point counters for the OVERHEAD module */
+    for(i=0; i<OVERHEAD_NUM_INDICES; i++)
+    {
+        /* macro defined in darshan-logutils.h */
+        DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_OVERHEAD_MOD],
+            overhead_rec->base_rec.rank, overhead_rec->base_rec.id,
+            overhead_counter_names[i], overhead_rec->counters[i],
+            file_name, mnt_pt, fs_type);
+    }
+
+    for(i=0; i<OVERHEAD_F_NUM_INDICES; i++)
+    {
+        /* macro defined in darshan-logutils.h */
+        DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_OVERHEAD_MOD],
+            overhead_rec->base_rec.rank, overhead_rec->base_rec.id,
+            overhead_f_counter_names[i], overhead_rec->fcounters[i],
+            file_name, mnt_pt, fs_type);
+    }
+
+    return;
+}
+
+/* print out a description of the OVERHEAD module record fields */
+static void darshan_log_print_overhead_description(int ver)
+{
+    printf("\n# description of OVERHEAD counters:\n");
+    printf("#   records of the cost of Darshan's own instrumentation: one for\n");
+    printf("#   darshan-core (named %s) and one for each instrumentation\n",
+        OVERHEAD_CORE_NAME);
+    printf("#   module (named %s<module>).\n", OVERHEAD_NAME_PREFIX);
+    printf("#   OVERHEAD_PROCS: number of processes folded into the record.\n");
+    printf("#   OVERHEAD_SAMPLE_INTERVAL: one in this many instrumented calls (per\n");
+    printf("#       thread) is timed.\n");
+    printf("#   OVERHEAD_SAMPLED_CALLS: number of instrumented calls timed.\n");
+    printf("#   OVERHEAD_REGISTER_CALLS: records registered with darshan-core.\n");
+    printf("#   OVERHEAD_F_SAMPLED_TIME: time the timed calls spent in Darshan's\n");
+    printf("#       record macros (excluding the wrapped function itself).\n");
+    printf("#   OVERHEAD_F_EST_TIME: estimated time all calls spent in Darshan's\n");
+    printf("#       record macros (OVERHEAD_F_SAMPLED_TIME * OVERHEAD_SAMPLE_INTERVAL).\n");
+    printf("#   OVERHEAD_F_MAX_EST_TIME: largest OVERHEAD_F_EST_TIME of one process.\n");
+    printf("#   OVERHEAD_F_INIT_TIME: time to initialize Darshan.\n");
+    printf("#   OVERHEAD_F_REGISTER_LOCK_TIME: time the darshan-core lock was held\n");
+    printf("#       registering records.\n");
+    printf("#   OVERHEAD_F_SHUTDOWN_TIME: for modules, time to reduce, output and\n");
+    printf("#       write the module's data; for darshan-core, time spent in shutdown\n");
+    printf("#       before the OVERHEAD data itself was written.\n");
+    printf("#   OVERHEAD_F_SHARED_RECS_TIME: shutdown time finding shared records.\n");
+    printf("#   OVERHEAD_F_COMPRESS_TIME: shutdown time compressing log data.\n");
+    printf("#   OVERHEAD_F_WRITE_TIME: shutdown time writing module data.\n");
+    printf("#   NOTE: in records shared by all processes, the init, register lock\n");
+    printf("#       and shutdown phase times are those of the slowest process; the\n");
+    printf("#       other counters are summed.\n");
+
+    return;
+}
+
+/* print a diff of two OVERHEAD records (with the same record id) */
+static void darshan_log_print_overhead_record_diff(void *file_rec1, char *file_name1,
+    void *file_rec2, char *file_name2)
+{
+    struct darshan_overhead_record *file1 = (struct darshan_overhead_record *)file_rec1;
+    struct darshan_overhead_record *file2 = (struct darshan_overhead_record *)file_rec2;
+    int i;
+
+    /* NOTE: we assume that both input records are the same module format version */
+
+    for(i=0; i<OVERHEAD_NUM_INDICES; i++)
+    {
+        if(!file2)
+        {
+            printf("- ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_OVERHEAD_MOD],
+                file1->base_rec.rank, file1->base_rec.id, overhead_counter_names[i],
+                file1->counters[i], file_name1, "", "");
+
+        }
+        else if(!file1)
+        {
+            printf("+ ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_OVERHEAD_MOD],
+                file2->base_rec.rank, file2->base_rec.id, overhead_counter_names[i],
+                file2->counters[i], file_name2, "", "");
+        }
+        else if(file1->counters[i] != file2->counters[i])
+        {
+            printf("- ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_OVERHEAD_MOD],
+                file1->base_rec.rank, file1->base_rec.id, overhead_counter_names[i],
+                file1->counters[i], file_name1, "", "");
+            printf("+ ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_OVERHEAD_MOD],
+                file2->base_rec.rank, file2->base_rec.id, overhead_counter_names[i],
+                file2->counters[i], file_name2, "", "");
+        }
+    }
+
+    for(i=0; i<OVERHEAD_F_NUM_INDICES; i++)
+    {
+        if(!file2)
+        {
+            printf("- ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_OVERHEAD_MOD],
+                file1->base_rec.rank, file1->base_rec.id, overhead_f_counter_names[i],
+                file1->fcounters[i], file_name1, "", "");
+
+        }
+        else if(!file1)
+        {
+            printf("+ ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_OVERHEAD_MOD],
+                file2->base_rec.rank, file2->base_rec.id, overhead_f_counter_names[i],
+                file2->fcounters[i], file_name2, "", "");
+        }
+        else if(file1->fcounters[i] != file2->fcounters[i])
+        {
+            printf("- ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_OVERHEAD_MOD],
+                file1->base_rec.rank, file1->base_rec.id, overhead_f_counter_names[i],
+                file1->fcounters[i], file_name1, "", "");
+            printf("+ ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_OVERHEAD_MOD],
+                file2->base_rec.rank, file2->base_rec.id, overhead_f_counter_names[i],
+                file2->fcounters[i], file_name2, "", "");
+        }
+    }
+
+    return;
+}
+
+/* aggregate the input OVERHEAD record 'rec'  into the output record 'agg_rec' */
+static void darshan_log_agg_overhead_records(void *rec, void *agg_rec, int init_flag)
+{
+    struct darshan_overhead_record *overhead_rec = (struct darshan_overhead_record *)rec;
+    struct darshan_overhead_record *agg_overhead_rec = (struct darshan_overhead_record *)agg_rec;
+    int i;
+
+    for(i = 0; i < OVERHEAD_NUM_INDICES; i++)
+    {
+        switch(i)
+        {
+            case OVERHEAD_SAMPLE_INTERVAL:
+                /* same value */
+                agg_overhead_rec->counters[i] = overhead_rec->counters[i];
+                break;
+            default:
+                /* sum */
+                agg_overhead_rec->counters[i] += overhead_rec->counters[i];
+                break;
+        }
+    }
+
+    for(i = 0; i < OVERHEAD_F_NUM_INDICES; i++)
+    {
+        switch(i)
+        {
+            case OVERHEAD_F_SAMPLED_TIME:
+            case OVERHEAD_F_EST_TIME:
+                /* sum */
+                agg_overhead_rec->fcounters[i] += overhead_rec->fcounters[i];
+                break;
+            default:
+                /* max */
+                if(overhead_rec->fcounters[i] > agg_overhead_rec->fcounters[i])
+                    agg_overhead_rec->fcounters[i] = overhead_rec->fcounters[i];
+                break;
+        }
+    }
+
+    return;
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
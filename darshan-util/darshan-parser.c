@@ -19,10 +19,13 @@
 #include <stdlib.h>
 #include <getopt.h>
 #include <assert.h>
+#include <stddef.h>
+#include <pthread.h>
 
 #include "uthash-1.9.2/src/uthash.h"
 
 #include "darshan-logutils.h"
+#include "darshan-arrow.h"
 
 /*
  * Options
@@ -32,6 +35,8 @@
 #define OPTION_PERF  (1 << 2)  /* derived performance */
 #define OPTION_FILE  (1 << 3)  /* file count totals */
 #define OPTION_SHOW_INCOMPLETE  (1 << 7)  /* show what we have, even if log is incomplete */
+#define OPTION_ARROW (1 << 8)  /* write records as Arrow tables */
+#define OPTION_THREADS (1 << 9)  /* threads reading logs in multi-log mode */
 #define OPTION_ALL (\
   OPTION_BASE|\
   OPTION_TOTAL|\
@@ -45,30 +50,105 @@
 
 #define max(a,b) (((a) > (b)) ? (a) : (b))
 
+/* maximum number of key/value pairs describing the job in Arrow tables */
+#define ARROW_MAX_META (8 + DARSHAN_JOB_METADATA_LEN / 2)
+
+/* layout of the records of modules that can be written as Arrow tables:
+ * a base record, optionally followed by the record id of the containing
+ * file (named as in the text output), then integer and floating point
+ * counters
+ */
+struct arrow_mod_layout
+{
+    char **counter_names;
+    int counter_count;
+    size_t counters_off;
+    char **fcounter_names;
+    int fcounter_count;
+    size_t fcounters_off;
+    const char *file_rec_id_name;
+};
+
+#define ARROW_MOD(__rec, __prefix, __NCOUNTERS, __NFCOUNTERS, __file_rec_id_name) \
+    { __prefix##_counter_names, __NCOUNTERS, offsetof(struct __rec, counters), \
+      __prefix##_f_counter_names, __NFCOUNTERS, offsetof(struct __rec, fcounters), \
+      __file_rec_id_name }
+
+static const struct arrow_mod_layout arrow_mods[DARSHAN_KNOWN_MODULE_COUNT] =
+{
+    [DARSHAN_POSIX_MOD] = ARROW_MOD(darshan_posix_file, posix,
+        POSIX_NUM_INDICES, POSIX_F_NUM_INDICES, NULL),
+    [DARSHAN_MPIIO_MOD] = ARROW_MOD(darshan_mpiio_file, mpiio,
+        MPIIO_NUM_INDICES, MPIIO_F_NUM_INDICES, NULL),
+    [DARSHAN_H5F_MOD] = ARROW_MOD(darshan_hdf5_file, h5f,
+        H5F_NUM_INDICES, H5F_F_NUM_INDICES, NULL),
+    [DARSHAN_H5D_MOD] = ARROW_MOD(darshan_hdf5_dataset, h5d,
+        H5D_NUM_INDICES, H5D_F_NUM_INDICES, "H5D_FILE_REC_ID"),
+    [DARSHAN_PNETCDF_FILE_MOD] = ARROW_MOD(darshan_pnetcdf_file, pnetcdf_file,
+        PNETCDF_FILE_NUM_INDICES, PNETCDF_FILE_F_NUM_INDICES, NULL),
+    [DARSHAN_PNETCDF_VAR_MOD] = ARROW_MOD(darshan_pnetcdf_var, pnetcdf_var,
+        PNETCDF_VAR_NUM_INDICES, PNETCDF_VAR_F_NUM_INDICES, "PNETCDF_VAR_FILE_REC_ID"),
+    [DARSHAN_BGQ_MOD] = ARROW_MOD(darshan_bgq_record, bgq,
+        BGQ_NUM_INDICES, BGQ_F_NUM_INDICES, NULL),
+    [DARSHAN_STDIO_MOD] = ARROW_MOD(darshan_stdio_file, stdio,
+        STDIO_NUM_INDICES, STDIO_F_NUM_INDICES, NULL),
+    [DARSHAN_MDHIM_MOD] = ARROW_MOD(darshan_mdhim_record, mdhim,
+        MDHIM_NUM_INDICES, MDHIM_F_NUM_INDICES, NULL),
+    [DARSHAN_BATCHIO_MOD] = ARROW_MOD(darshan_batchio_record, batchio,
+        BATCHIO_NUM_INDICES, BATCHIO_F_NUM_INDICES, NULL),
+    [DARSHAN_OVERHEAD_MOD] = ARROW_MOD(darshan_overhead_record, overhead,
+        OVERHEAD_NUM_INDICES, OVERHEAD_F_NUM_INDICES, NULL),
+    [DARSHAN_LATENCY_MOD] = ARROW_MOD(darshan_latency_record, latency,
+        LATENCY_NUM_INDICES, LATENCY_F_NUM_INDICES, NULL),
+    [DARSHAN_TIMESERIES_MOD] = ARROW_MOD(darshan_timeseries_record, timeseries,
+        TIMESERIES_NUM_INDICES, TIMESERIES_F_NUM_INDICES, NULL),
+    [DARSHAN_CUFILE_MOD] = ARROW_MOD(darshan_cufile_record, cufile,
+        CUFILE_NUM_INDICES, CUFILE_F_NUM_INDICES, NULL),
+    [DARSHAN_MMAP_MOD] = ARROW_MOD(darshan_mmap_record, mmap,
+        MMAP_NUM_INDICES, MMAP_F_NUM_INDICES, NULL),
+    [DARSHAN_ROLLUP_MOD] = ARROW_MOD(darshan_rollup_record, rollup,
+        ROLLUP_NUM_INDICES, ROLLUP_F_NUM_INDICES, NULL),
+    [DARSHAN_PHASE_MOD] = ARROW_MOD(darshan_phase_record, phase,
+        PHASE_NUM_INDICES, PHASE_F_NUM_INDICES, NULL),
+    [DARSHAN_ATTRIB_MOD] = ARROW_MOD(darshan_attrib_record, attrib,
+        ATTRIB_NUM_INDICES, ATTRIB_F_NUM_INDICES, NULL),
+};
+
 /*
  * Prototypes
  */
 void posix_print_total_file(struct darshan_posix_file *pfile, int posix_ver);
 void mpiio_print_total_file(struct darshan_mpiio_file *mfile, int mpiio_ver);
 void stdio_print_total_file(struct darshan_stdio_file *pfile, int stdio_ver);
+static void print_file_counts(struct darshan_derived_metrics *metrics);
+static void print_perf(struct darshan_derived_metrics *metrics, int multi);
 
 int usage (char *exename)
 {
     fprintf(stderr, "Usage: %s [options] <filename>\n", exename);
+    fprintf(stderr, "       %s [--total] [--perf] [--file] <filename> <filename> ...\n", exename);
     fprintf(stderr, "    --all   : all sub-options are enabled\n");
     fprintf(stderr, "    --base  : darshan log field data [default]\n");
     fprintf(stderr, "    --file  : total file counts\n");
     fprintf(stderr, "    --perf  : derived perf data\n");
     fprintf(stderr, "    --total : aggregated darshan field data\n");
     fprintf(stderr, "    --show-incomplete : display results even if log is incomplete\n");
+    fprintf(stderr, "    --arrow <dir> : write each module's records to <dir>/<module>.arrow\n");
+    fprintf(stderr, "                    (Arrow IPC file format) instead of printing them\n");
+    fprintf(stderr, "    --threads <n> : threads reading logs when summarizing several logs\n");
+    fprintf(stderr, "                    (default: number of cores)\n");
+    fprintf(stderr, "Given several logs, a single summary of all of them is printed\n");
+    fprintf(stderr, "(--total, --perf and --file only; all three by default).\n");
 
     exit(1);
 }
 
-int parse_args (int argc, char **argv, char **filename)
+int parse_args (int argc, char **argv, char ***filenames, int *nfiles,
+                char **arrow_dir, int *nthreads)
 {
     int index;
     int mask;
+    char *check;
     static struct option long_opts[] =
     {
         {"all",   0, NULL, OPTION_ALL},
@@ -77,11 +157,14 @@ int parse_args (int argc, char **argv, char **filename)
         {"perf",  0, NULL, OPTION_PERF},
         {"total", 0, NULL, OPTION_TOTAL},
         {"show-incomplete", 0, NULL, OPTION_SHOW_INCOMPLETE},
+        {"arrow", 1, NULL, OPTION_ARROW},
+        {"threads", 1, NULL, OPTION_THREADS},
         {"help",  0, NULL, 0},
         {0, 0, 0, 0}
     };
 
     mask = 0;
+    *nthreads = sysconf(_SC_NPROCESSORS_ONLN);
 
     while(1)
     {
@@ -99,6 +182,18 @@ int parse_args (int argc, char **argv, char **filename)
             case OPTION_SHOW_INCOMPLETE:
                 mask |= c;
                 break;
+            case OPTION_ARROW:
+                mask |= c;
+                *arrow_dir = optarg;
+                break;
+            case OPTION_THREADS:
+                *nthreads = strtol(optarg, &check, 10);
+                if(optarg == check || *check != '\0' || *nthreads < 1)
+                {
+                    fprintf(stderr, "Error: invalid number of threads.\n");
+                    exit(1);
+                }
+                break;
             case 0:
             case '?':
             default:
@@ -109,15 +204,29 @@ int parse_args (int argc, char **argv, char **filename)
 
     if (optind < argc)
     {
-        *filename = argv[optind];
+        *filenames = &argv[optind];
+        *nfiles = argc - optind;
     }
     else
     {
         usage(argv[0]);
     }
+    if (*nthreads < 1)
+        *nthreads = 1;
 
-    /* default mask value if none specified */
-    if (mask == 0 || mask == OPTION_SHOW_INCOMPLETE)
+    if (*nfiles > 1)
+    {
+        /* several logs are only summarized together */
+        if (mask & (OPTION_BASE|OPTION_ARROW))
+            usage(argv[0]);
+        if ((mask & (OPTION_TOTAL|OPTION_PERF|OPTION_FILE)) == 0)
+            mask |= OPTION_TOTAL|OPTION_PERF|OPTION_FILE;
+    }
+
+    /* default mask value if none specified; records are not printed
+     * when they are written as Arrow tables
+     */
+    if ((mask & ~OPTION_SHOW_INCOMPLETE) == 0)
     {
         mask |= OPTION_BASE;
     }
@@ -125,18 +234,439 @@ int parse_args (int argc, char **argv, char **filename)
     return mask;
 }
 
+static void arrow_add_meta(char **meta, int *nmeta, const char *key,
+    const char *value)
+{
+    if(*nmeta == ARROW_MAX_META)
+        return;
+
+    meta[2 * *nmeta] = strdup(key);
+    meta[2 * *nmeta + 1] = strdup(value);
+    if(meta[2 * *nmeta] && meta[2 * *nmeta + 1])
+        (*nmeta)++;
+    else
+    {
+        free(meta[2 * *nmeta]);
+        free(meta[2 * *nmeta + 1]);
+    }
+}
+
+/* create <dir>/<module>.arrow, holding one row per record of the module */
+static darshan_arrow_writer arrow_create_table(const char *dir, int mod_id,
+    const char * const *meta, int nmeta)
+{
+    const struct arrow_mod_layout *layout = &arrow_mods[mod_id];
+    struct darshan_arrow_column *cols;
+    darshan_arrow_writer w;
+    char path[PATH_MAX];
+    char *p;
+    int ncols = 0;
+    int i;
+
+    cols = malloc((6 + layout->counter_count + layout->fcounter_count) *
+        sizeof(*cols));
+    if(!cols)
+        return(NULL);
+
+    cols[ncols].name = "id";
+    cols[ncols++].type = DARSHAN_ARROW_UINT64;
+    cols[ncols].name = "rank";
+    cols[ncols++].type = DARSHAN_ARROW_INT64;
+    if(layout->file_rec_id_name)
+    {
+        cols[ncols].name = layout->file_rec_id_name;
+        cols[ncols++].type = DARSHAN_ARROW_UINT64;
+    }
+    cols[ncols].name = "file_name";
+    cols[ncols++].type = DARSHAN_ARROW_UTF8;
+    cols[ncols].name = "mount_pt";
+    cols[ncols++].type = DARSHAN_ARROW_UTF8;
+    cols[ncols].name = "fs_type";
+    cols[ncols++].type = DARSHAN_ARROW_UTF8;
+    for(i = 0; i < layout->counter_count; i++)
+    {
+        cols[ncols].name = layout->counter_names[i];
+        /* record ids are unsigned, even when stored as a counter */
+        if(mod_id == DARSHAN_POSIX_MOD && i == POSIX_RENAMED_FROM)
+            cols[ncols++].type = DARSHAN_ARROW_UINT64;
+        else
+            cols[ncols++].type = DARSHAN_ARROW_INT64;
+    }
+    for(i = 0; i < layout->fcounter_count; i++)
+    {
+        cols[ncols].name = layout->fcounter_names[i];
+        cols[ncols++].type = DARSHAN_ARROW_DOUBLE;
+    }
+
+    /* module names may contain a '/' (e.g., "BG/Q") */
+    snprintf(path, sizeof(path), "%s/", dir);
+    p = path + strlen(path);
+    snprintf(p, sizeof(path) - (p - path), "%s.arrow", darshan_module_names[mod_id]);
+    for(; *p; p++)
+        if(*p == '/')
+            *p = '_';
+
+    w = darshan_arrow_create(path, cols, ncols, meta, nmeta);
+    free(cols);
+
+    return(w);
+}
+
+static int arrow_put_record(darshan_arrow_writer w, int mod_id, char *rec,
+    char *rec_name, char *mnt_pt, char *fs_type)
+{
+    const struct arrow_mod_layout *layout = &arrow_mods[mod_id];
+    struct darshan_base_record *base_rec = (struct darshan_base_record *)rec;
+    int col = 0;
+
+    darshan_arrow_put_uint64(w, col++, base_rec->id);
+    darshan_arrow_put_int64(w, col++, base_rec->rank);
+    if(layout->file_rec_id_name)
+        darshan_arrow_put_uint64(w, col++,
+            *(uint64_t *)(rec + sizeof(struct darshan_base_record)));
+    darshan_arrow_put_utf8(w, col++, rec_name ? rec_name : "");
+    darshan_arrow_put_utf8(w, col++, mnt_pt);
+    darshan_arrow_put_utf8(w, col++, fs_type);
+    darshan_arrow_put_int64_array(w, col,
+        (int64_t *)(rec + layout->counters_off), layout->counter_count);
+    col += layout->counter_count;
+    darshan_arrow_put_double_array(w, col,
+        (double *)(rec + layout->fcounters_off), layout->fcounter_count);
+
+    return(darshan_arrow_end_row(w));
+}
+
+/* modules summarized across several logs */
+static const darshan_module_id multi_mods[] =
+{
+    DARSHAN_POSIX_MOD,
+    DARSHAN_MPIIO_MOD,
+    DARSHAN_STDIO_MOD,
+};
+#define MULTI_MOD_COUNT (sizeof(multi_mods) / sizeof(multi_mods[0]))
+
+/* summary of a module's data over one or more logs */
+struct multi_mod_summary
+{
+    int64_t log_count;
+    void *agg_record;
+    struct darshan_derived_metrics metrics;
+    /* range of the aggregate performance of individual logs */
+    double min_perf;
+    double max_perf;
+};
+
+/* state shared by the threads summarizing several logs; each log's summary
+ * is kept separately and combined in log order, so the output does not
+ * depend on the number of threads
+ */
+static struct
+{
+    char **filenames;
+    int nfiles;
+    int next_file;
+    int mask;
+    int *failed;
+    struct multi_mod_summary (*summaries)[MULTI_MOD_COUNT];
+    pthread_mutex_t mutex;
+} multi;
+
+/* add the summary 'src' of a module to 'dst' */
+static void multi_merge_summary(darshan_module_id mod_id,
+    struct multi_mod_summary *dst, struct multi_mod_summary *src)
+{
+    struct darshan_file_category_counters *dcat, *scat;
+    int i;
+
+    if(src->log_count == 0)
+        return;
+    if(dst->log_count == 0)
+    {
+        *dst = *src;
+        src->agg_record = NULL;
+        src->log_count = 0;
+        return;
+    }
+
+    /* aggregate records of different logs are combined like records of
+     * different ranks
+     */
+    mod_logutils[mod_id]->log_agg_records(src->agg_record, dst->agg_record, 0);
+    dst->log_count += src->log_count;
+
+    /* times and volumes add up over consecutive jobs */
+    dst->metrics.total_bytes += src->metrics.total_bytes;
+    dst->metrics.unique_io_total_time_by_slowest +=
+        src->metrics.unique_io_total_time_by_slowest;
+    dst->metrics.unique_rw_only_time_by_slowest +=
+        src->metrics.unique_rw_only_time_by_slowest;
+    dst->metrics.unique_md_only_time_by_slowest +=
+        src->metrics.unique_md_only_time_by_slowest;
+    dst->metrics.shared_io_total_time_by_slowest +=
+        src->metrics.shared_io_total_time_by_slowest;
+    dst->metrics.agg_time_by_slowest += src->metrics.agg_time_by_slowest;
+    if(dst->metrics.agg_time_by_slowest)
+        dst->metrics.agg_perf_by_slowest =
+            ((double)dst->metrics.total_bytes / 1048576.0) /
+            dst->metrics.agg_time_by_slowest;
+    if(src->min_perf < dst->min_perf)
+        dst->min_perf = src->min_perf;
+    if(src->max_perf > dst->max_perf)
+        dst->max_perf = src->max_perf;
+
+    /* files are counted once per log they appear in */
+    for(i = 0; i < DARSHAN_FILE_CATEGORY_MAX; i++)
+    {
+        dcat = &dst->metrics.category_counters[i];
+        scat = &src->metrics.category_counters[i];
+        dcat->count += scat->count;
+        dcat->total_read_volume_bytes += scat->total_read_volume_bytes;
+        dcat->total_write_volume_bytes += scat->total_write_volume_bytes;
+        dcat->max_read_volume_bytes =
+            max(dcat->max_read_volume_bytes, scat->max_read_volume_bytes);
+        dcat->max_write_volume_bytes =
+            max(dcat->max_write_volume_bytes, scat->max_write_volume_bytes);
+        if(dcat->total_max_offset_bytes == -1 || scat->total_max_offset_bytes == -1)
+        {
+            dcat->total_max_offset_bytes = -1;
+            dcat->max_offset_bytes = -1;
+        }
+        else
+        {
+            dcat->total_max_offset_bytes += scat->total_max_offset_bytes;
+            dcat->max_offset_bytes =
+                max(dcat->max_offset_bytes, scat->max_offset_bytes);
+        }
+    }
+
+    return;
+}
+
+/* summarize the modules of one log using the accumulator API */
+static int multi_summarize_log(const char *filename,
+    struct multi_mod_summary *summaries, char *mod_buf)
+{
+    darshan_fd fd;
+    struct darshan_job job;
+    darshan_accumulator acc;
+    darshan_module_id mod_id;
+    int ret;
+    int i;
+
+    fd = darshan_log_open(filename);
+    if(!fd)
+        return(-1);
+
+    ret = darshan_log_get_job(fd, &job);
+    if(ret < 0)
+    {
+        darshan_log_close(fd);
+        return(-1);
+    }
+
+    for(i = 0; i < MULTI_MOD_COUNT; i++)
+    {
+        mod_id = multi_mods[i];
+        if(fd->mod_map[mod_id].len == 0)
+            continue;
+        if(DARSHAN_MOD_FLAG_ISSET(fd->partial_flag, mod_id) &&
+           !(multi.mask & OPTION_SHOW_INCOMPLETE))
+        {
+            fprintf(stderr, "Error: the %s module of log file %s contains "
+                "incomplete data (see --show-incomplete).\n",
+                darshan_module_names[mod_id], filename);
+            darshan_log_close(fd);
+            return(-1);
+        }
+
+        ret = darshan_accumulator_create(mod_id, job.nprocs, &acc);
+        if(ret < 0)
+        {
+            darshan_log_close(fd);
+            return(-1);
+        }
+
+        memset(mod_buf, 0, DEF_MOD_BUF_SIZE);
+        while((ret = mod_logutils[mod_id]->log_get_record(fd, (void **)&mod_buf)) == 1)
+        {
+            ret = darshan_accumulator_inject(acc, mod_buf, 1);
+            if(ret < 0)
+                break;
+        }
+        if(ret < 0)
+        {
+            fprintf(stderr, "Error: failed to parse %s module record.\n",
+                darshan_module_names[mod_id]);
+            darshan_accumulator_destroy(acc);
+            darshan_log_close(fd);
+            return(-1);
+        }
+
+        darshan_accumulator_emit(acc, &summaries[i].metrics, mod_buf);
+        darshan_accumulator_destroy(acc);
+
+        summaries[i].agg_record = malloc(
+            mod_logutils[mod_id]->log_sizeof_record(mod_buf));
+        if(!summaries[i].agg_record)
+        {
+            darshan_log_close(fd);
+            return(-1);
+        }
+        memcpy(summaries[i].agg_record, mod_buf,
+            mod_logutils[mod_id]->log_sizeof_record(mod_buf));
+        summaries[i].log_count = 1;
+        summaries[i].min_perf = summaries[i].metrics.agg_perf_by_slowest;
+        summaries[i].max_perf = summaries[i].metrics.agg_perf_by_slowest;
+    }
+
+    darshan_log_close(fd);
+
+    return(0);
+}
+
+static void *multi_thread_fn(void *arg)
+{
+    char *mod_buf;
+    int idx;
+
+    mod_buf = malloc(DEF_MOD_BUF_SIZE);
+
+    while(1)
+    {
+        pthread_mutex_lock(&multi.mutex);
+        if(multi.next_file == multi.nfiles)
+        {
+            pthread_mutex_unlock(&multi.mutex);
+            break;
+        }
+        idx = multi.next_file++;
+        pthread_mutex_unlock(&multi.mutex);
+
+        if(!mod_buf || multi_summarize_log(multi.filenames[idx],
+            multi.summaries[idx], mod_buf) < 0)
+        {
+            fprintf(stderr, "Error: unable to summarize log file %s.\n",
+                multi.filenames[idx]);
+            multi.failed[idx] = 1;
+        }
+    }
+
+    free(mod_buf);
+
+    return NULL;
+}
+
+/* print a single summary of the POSIX, MPI-IO and STDIO data of several
+ * logs, which are read concurrently by 'nthreads' threads
+ */
+static int multi_summarize(char **filenames, int nfiles, int mask, int nthreads)
+{
+    struct multi_mod_summary total[MULTI_MOD_COUNT];
+    pthread_t *threads;
+    darshan_module_id mod_id;
+    int nfailed = 0;
+    int i, j;
+
+    memset(total, 0, sizeof(total));
+    multi.filenames = filenames;
+    multi.nfiles = nfiles;
+    multi.mask = mask;
+    multi.failed = calloc(nfiles, sizeof(*multi.failed));
+    multi.summaries = calloc(nfiles, sizeof(*multi.summaries));
+    threads = malloc(nthreads * sizeof(*threads));
+    if(!multi.failed || !multi.summaries || !threads)
+    {
+        fprintf(stderr, "Error: unable to allocate memory.\n");
+        free(multi.failed);
+        free(multi.summaries);
+        free(threads);
+        return(-1);
+    }
+
+    pthread_mutex_init(&multi.mutex, NULL);
+    for(i = 0; i < nthreads && i < nfiles; i++)
+    {
+        if(pthread_create(&threads[i], NULL, multi_thread_fn, NULL) != 0)
+            break;
+    }
+    nthreads = i;
+    /* read the logs on this thread if no worker could be started */
+    if(nthreads == 0)
+        multi_thread_fn(NULL);
+    for(i = 0; i < nthreads; i++)
+        pthread_join(threads[i], NULL);
+    pthread_mutex_destroy(&multi.mutex);
+
+    /* combine the logs' summaries in order */
+    for(i = 0; i < nfiles; i++)
+    {
+        if(multi.failed[i])
+            nfailed++;
+        for(j = 0; j < MULTI_MOD_COUNT; j++)
+        {
+            multi_merge_summary(multi_mods[j], &total[j], &multi.summaries[i][j]);
+            free(multi.summaries[i][j].agg_record);
+        }
+    }
+
+    printf("# darshan-parser summary of %d log files (%d failed)\n",
+        nfiles - nfailed, nfailed);
+    printf("# totals are summed over all logs, files are counted once per log\n");
+    printf("# they appear in, and times are summed over the logs' jobs.\n");
+
+    for(j = 0; j < MULTI_MOD_COUNT; j++)
+    {
+        mod_id = multi_mods[j];
+        if(total[j].log_count == 0)
+            continue;
+
+        printf("\n# *******************************************************\n");
+        printf("# %s module data\n", darshan_module_names[mod_id]);
+        printf("# *******************************************************\n");
+        printf("# log files: %" PRId64 "\n", total[j].log_count);
+
+        if(mask & OPTION_TOTAL)
+        {
+            if(mod_id == DARSHAN_POSIX_MOD)
+                posix_print_total_file(total[j].agg_record, DARSHAN_POSIX_VER);
+            else if(mod_id == DARSHAN_MPIIO_MOD)
+                mpiio_print_total_file(total[j].agg_record, DARSHAN_MPIIO_VER);
+            else if(mod_id == DARSHAN_STDIO_MOD)
+                stdio_print_total_file(total[j].agg_record, DARSHAN_STDIO_VER);
+        }
+        if(mask & OPTION_FILE)
+            print_file_counts(&total[j].metrics);
+        if(mask & OPTION_PERF)
+        {
+            print_perf(&total[j].metrics, 1);
+            printf("# per-log agg_perf_by_slowest: min %lf max %lf # MiB/s\n",
+                total[j].min_perf, total[j].max_perf);
+        }
+
+        free(total[j].agg_record);
+    }
+
+    free(multi.failed);
+    free(multi.summaries);
+    free(threads);
+
+    return(nfailed ? -1 : 0);
+}
+
 int main(int argc, char **argv)
 {
     int ret;
     int mask;
     int i, j;
     char *filename;
+    char **filenames;
+    int nfiles;
+    int nthreads;
     char *comp_str;
     char tmp_string[4096] = {0};
     darshan_fd fd;
     struct darshan_job job;
-    struct darshan_name_record_ref *name_hash = NULL;
-    struct darshan_name_record_ref *ref, *tmp_ref;
+    struct darshan_name_table *name_table = NULL;
     int mount_count;
     struct darshan_mnt_info *mnt_data_array;
     time_t tmp_time = 0;
@@ -146,11 +676,20 @@ int main(int argc, char **argv)
     char buffer[DARSHAN_JOB_METADATA_LEN];
     int empty_mods = 0;
     char *mod_buf;
+    char *arrow_dir = NULL;
+    char *arrow_meta[2 * ARROW_MAX_META];
+    char arrow_val[64];
+    int arrow_nmeta = 0;
+    int arrow_ret = 0;
+    darshan_arrow_writer arrow_w = NULL;
 
     darshan_accumulator acc = NULL;
     struct darshan_derived_metrics metrics;
 
-    mask = parse_args(argc, argv, &filename);
+    mask = parse_args(argc, argv, &filenames, &nfiles, &arrow_dir, &nthreads);
+    if(nfiles > 1)
+        return(multi_summarize(filenames, nfiles, mask, nthreads));
+    filename = filenames[0];
 
     fd = darshan_log_open(filename);
     if(!fd)
@@ -180,8 +719,8 @@ int main(int argc, char **argv)
         return(-1);
     }
 
-    /* read hash of darshan records */
-    ret = darshan_log_get_namehash(fd, &name_hash);
+    /* read table of darshan record names */
+    ret = darshan_log_get_name_table(fd, &name_table);
     if(ret < 0)
     {
         darshan_log_close(fd);
@@ -195,6 +734,8 @@ int main(int argc, char **argv)
         comp_str = "ZLIB";
     else if (fd->comp_type == DARSHAN_BZIP2_COMP)
         comp_str = "BZIP2";
+    else if (fd->comp_type == DARSHAN_ZSTD_COMP)
+        comp_str = "ZSTD";
     else if (fd->comp_type == DARSHAN_NO_COMP)
         comp_str = "NONE";
     else
@@ -203,6 +744,8 @@ int main(int argc, char **argv)
     /* print job summary */
     printf("# darshan log version: %s\n", fd->version);
     printf("# compression method: %s\n", comp_str);
+    if(fd->comp_dict_id)
+        printf("# compression dictionary: %u\n", fd->comp_dict_id);
     printf("# exe: %s\n", tmp_string);
     printf("# uid: %" PRId64 "\n", job.uid);
     printf("# jobid: %" PRId64 "\n", job.jobid);
@@ -216,6 +759,24 @@ int main(int argc, char **argv)
     printf("# nprocs: %" PRId64 "\n", job.nprocs);
     darshan_log_get_job_runtime(fd, job, &run_time);
     printf("# run time: %.4lf\n", run_time);
+    if(mask & OPTION_ARROW)
+    {
+        /* describe the job in the metadata of each Arrow table */
+        arrow_add_meta(arrow_meta, &arrow_nmeta, "darshan_log_version", fd->version);
+        arrow_add_meta(arrow_meta, &arrow_nmeta, "exe", tmp_string);
+        snprintf(arrow_val, sizeof(arrow_val), "%" PRId64, job.uid);
+        arrow_add_meta(arrow_meta, &arrow_nmeta, "uid", arrow_val);
+        snprintf(arrow_val, sizeof(arrow_val), "%" PRId64, job.jobid);
+        arrow_add_meta(arrow_meta, &arrow_nmeta, "jobid", arrow_val);
+        snprintf(arrow_val, sizeof(arrow_val), "%" PRId64, job.start_time_sec);
+        arrow_add_meta(arrow_meta, &arrow_nmeta, "start_time", arrow_val);
+        snprintf(arrow_val, sizeof(arrow_val), "%" PRId64, job.end_time_sec);
+        arrow_add_meta(arrow_meta, &arrow_nmeta, "end_time", arrow_val);
+        snprintf(arrow_val, sizeof(arrow_val), "%" PRId64, job.nprocs);
+        arrow_add_meta(arrow_meta, &arrow_nmeta, "nprocs", arrow_val);
+        snprintf(arrow_val, sizeof(arrow_val), "%.4lf", run_time);
+        arrow_add_meta(arrow_meta, &arrow_nmeta, "run_time", arrow_val);
+    }
     for(token=strtok_r(job.metadata, "\n", &save);
         token != NULL;
         token=strtok_r(NULL, "\n", &save))
@@ -235,6 +796,8 @@ int main(int argc, char **argv)
         value[0] = '\0';
         value++;
         printf("# metadata: %s = %s\n", key, value);
+        if(mask & OPTION_ARROW)
+            arrow_add_meta(arrow_meta, &arrow_nmeta, key, value);
     }
 
     /* print breakdown of each log file region's contribution to file size */
@@ -316,13 +879,14 @@ int main(int argc, char **argv)
             continue;
         }
         /* always ignore DXT modules -- those have a standalone parsing utility */
-        else if (i == DXT_POSIX_MOD || i == DXT_MPIIO_MOD)
+        else if (i == DXT_POSIX_MOD || i == DXT_MPIIO_MOD || i == DXT_STDIO_MOD)
             continue;
         /* currently only POSIX, MPIIO, and STDIO modules support non-base
          * parsing
          */
         else if((i != DARSHAN_POSIX_MOD) && (i != DARSHAN_MPIIO_MOD) &&
-                (i != DARSHAN_STDIO_MOD) && !(mask & OPTION_BASE))
+                (i != DARSHAN_STDIO_MOD) && !(mask & OPTION_BASE) &&
+                !((mask & OPTION_ARROW) && arrow_mods[i].counter_names))
             continue;
 
         /* this module has data to be parsed and printed */
@@ -381,6 +945,19 @@ int main(int argc, char **argv)
             }
         }
 
+        if((mask & OPTION_ARROW) && arrow_mods[i].counter_names)
+        {
+            arrow_w = arrow_create_table(arrow_dir, i,
+                (const char * const *)arrow_meta, arrow_nmeta);
+            if(!arrow_w)
+            {
+                fprintf(stderr, "Error: unable to create Arrow table for %s module.\n",
+                    darshan_module_names[i]);
+                ret = -1;
+                goto cleanup;
+            }
+        }
+
         /* create an accumulator, if supported */
         /* no explicit error checking; we will just skip injecting if null */
         darshan_accumulator_create(i, job.nprocs, &acc);
@@ -405,11 +982,10 @@ int main(int argc, char **argv)
             base_rec = (struct darshan_base_record *)mod_buf;
 
             /* get the pathname for this record */
-            HASH_FIND(hlink, name_hash, &(base_rec->id), sizeof(darshan_record_id), ref);
+            rec_name = darshan_name_table_lookup(name_table, base_rec->id);
 
-            if(ref)
+            if(rec_name)
             {
-                rec_name = ref->name_record->name;
 
                 /* get mount point and fs type associated with this record */
                 for(j=0; j<mount_count; j++)
@@ -441,10 +1017,32 @@ int main(int argc, char **argv)
                     mnt_pt, fs_type);
             }
 
+            if(arrow_w && arrow_put_record(arrow_w, i, mod_buf, rec_name,
+                mnt_pt, fs_type) < 0)
+            {
+                arrow_ret = -1;
+                break;
+            }
+
             /* accumulated and derived metrics, if supported */
             if(acc)
                 darshan_accumulator_inject(acc, mod_buf, 1);
         }
+        if(arrow_w)
+        {
+            if(darshan_arrow_close(arrow_w) < 0)
+                arrow_ret = -1;
+            arrow_w = NULL;
+            if(arrow_ret < 0)
+            {
+                fprintf(stderr, "Error: failed to write Arrow table for %s module.\n",
+                    darshan_module_names[i]);
+                if(acc)
+                    darshan_accumulator_destroy(acc);
+                ret = -1;
+                goto cleanup;
+            }
+        }
         if(ret == -1)
             continue; /* move on to the next module if there was an error with this one */
 
@@ -477,78 +1075,11 @@ int main(int argc, char **argv)
 
         /* File Calc */
         if(mask & OPTION_FILE)
-        {
-            printf("\n# Total file counts\n");
-            printf("# -----\n");
-            printf("# <file_type>: type of file access:\n");
-            printf("#    *read_only: file was only read\n");
-            printf("#    *write_only: file was only written\n");
-            printf("#    *read_write: file was read and written\n");
-            printf("#    *unique: file was opened by a single process only\n");
-            printf("#    *shared: file was accessed by a group of processes (maybe all processes)\n");
-            printf("# <file_count> total number of files of this type\n");
-            printf("# <total_bytes> total number of bytes moved to/from files of this type\n");
-            printf("# <max_byte_offset> maximum byte offset accessed for a file of this type\n");
-            printf("\n# <file_type> <file_count> <total_bytes> <max_byte_offset>\n");
-            printf("# total: %" PRId64 " %" PRId64 " %" PRId64 "\n",
-                   metrics.category_counters[DARSHAN_ALL_FILES].count,
-                   metrics.category_counters[DARSHAN_ALL_FILES].total_read_volume_bytes +
-                    metrics.category_counters[DARSHAN_ALL_FILES].total_write_volume_bytes,
-                   metrics.category_counters[DARSHAN_ALL_FILES].max_offset_bytes);
-            printf("# read_only: %" PRId64 " %" PRId64 " %" PRId64 "\n",
-                   metrics.category_counters[DARSHAN_RO_FILES].count,
-                   metrics.category_counters[DARSHAN_RO_FILES].total_read_volume_bytes +
-                    metrics.category_counters[DARSHAN_RO_FILES].total_write_volume_bytes,
-                   metrics.category_counters[DARSHAN_RO_FILES].max_offset_bytes);
-            printf("# write_only: %" PRId64 " %" PRId64 " %" PRId64 "\n",
-                   metrics.category_counters[DARSHAN_WO_FILES].count,
-                   metrics.category_counters[DARSHAN_WO_FILES].total_read_volume_bytes +
-                    metrics.category_counters[DARSHAN_WO_FILES].total_write_volume_bytes,
-                   metrics.category_counters[DARSHAN_WO_FILES].max_offset_bytes);
-            printf("# read_write: %" PRId64 " %" PRId64 " %" PRId64 "\n",
-                   metrics.category_counters[DARSHAN_RW_FILES].count,
-                   metrics.category_counters[DARSHAN_RW_FILES].total_read_volume_bytes +
-                    metrics.category_counters[DARSHAN_RW_FILES].total_write_volume_bytes,
-                   metrics.category_counters[DARSHAN_RW_FILES].max_offset_bytes);
-            printf("# unique: %" PRId64 " %" PRId64 " %" PRId64 "\n",
-                   metrics.category_counters[DARSHAN_UNIQ_FILES].count,
-                   metrics.category_counters[DARSHAN_UNIQ_FILES].total_read_volume_bytes +
-                    metrics.category_counters[DARSHAN_UNIQ_FILES].total_write_volume_bytes,
-                   metrics.category_counters[DARSHAN_UNIQ_FILES].max_offset_bytes);
-            printf("# shared: %" PRId64 " %" PRId64 " %" PRId64 "\n",
-                   metrics.category_counters[DARSHAN_SHARED_FILES].count +
-                    metrics.category_counters[DARSHAN_PART_SHARED_FILES].count,
-                   metrics.category_counters[DARSHAN_SHARED_FILES].total_read_volume_bytes +
-                    metrics.category_counters[DARSHAN_SHARED_FILES].total_write_volume_bytes +
-                    metrics.category_counters[DARSHAN_PART_SHARED_FILES].total_read_volume_bytes +
-                    metrics.category_counters[DARSHAN_PART_SHARED_FILES].total_write_volume_bytes,
-                   metrics.category_counters[DARSHAN_SHARED_FILES].max_offset_bytes +
-                    metrics.category_counters[DARSHAN_PART_SHARED_FILES].max_offset_bytes);
-        }
+            print_file_counts(&metrics);
 
         /* Perf Calc */
         if(mask & OPTION_PERF)
-        {
-            printf("\n# performance\n");
-            printf("# -----------\n");
-            printf("# total_bytes: %" PRId64 "\n", metrics.total_bytes);
-            printf("#\n");
-            printf("# I/O timing for unique files (seconds):\n");
-            printf("# ...........................\n");
-            printf("# unique files: slowest_rank_io_time: %lf\n", metrics.unique_io_total_time_by_slowest);
-            printf("# unique files: slowest_rank_meta_only_time: %lf\n", metrics.unique_md_only_time_by_slowest);
-            printf("# unique files: slowest_rank_rw_only_time: %lf\n", metrics.unique_rw_only_time_by_slowest);
-            printf("# unique files: slowest_rank: %d\n", metrics.unique_io_slowest_rank);
-            printf("#\n");
-            printf("# I/O timing for shared files (seconds):\n");
-            printf("# ...........................\n");
-            printf("# shared files: time_by_slowest: %lf\n", metrics.shared_io_total_time_by_slowest);
-            printf("#\n");
-            printf("# Aggregate performance, including both shared and unique files:\n");
-            printf("# ...........................\n");
-            printf("# agg_time_by_slowest: %lf # seconds\n", metrics.agg_time_by_slowest);
-            printf("# agg_perf_by_slowest: %lf # MiB/s\n", metrics.agg_perf_by_slowest);
-        }
+            print_perf(&metrics, 0);
 
         if(acc) {
             darshan_accumulator_destroy(acc);
@@ -560,16 +1091,14 @@ int main(int argc, char **argv)
         printf("\n# no module data available.\n");
     ret = 0;
 
+cleanup:
     darshan_log_close(fd);
     free(mod_buf);
+    for(i = 0; i < 2 * arrow_nmeta; i++)
+        free(arrow_meta[i]);
 
-    /* free record hash data */
-    HASH_ITER(hlink, name_hash, ref, tmp_ref)
-    {
-        HASH_DELETE(hlink, name_hash, ref);
-        free(ref->name_record);
-        free(ref);
-    }
+    /* free record name data */
+    darshan_name_table_free(name_table);
 
     /* free mount info */
     if(mount_count > 0)
@@ -580,6 +1109,83 @@ int main(int argc, char **argv)
     return(ret);
 }
 
+static void print_file_counts(struct darshan_derived_metrics *metrics)
+{
+    printf("\n# Total file counts\n");
+    printf("# -----\n");
+    printf("# <file_type>: type of file access:\n");
+    printf("#    *read_only: file was only read\n");
+    printf("#    *write_only: file was only written\n");
+    printf("#    *read_write: file was read and written\n");
+    printf("#    *unique: file was opened by a single process only\n");
+    printf("#    *shared: file was accessed by a group of processes (maybe all processes)\n");
+    printf("# <file_count> total number of files of this type\n");
+    printf("# <total_bytes> total number of bytes moved to/from files of this type\n");
+    printf("# <max_byte_offset> maximum byte offset accessed for a file of this type\n");
+    printf("\n# <file_type> <file_count> <total_bytes> <max_byte_offset>\n");
+    printf("# total: %" PRId64 " %" PRId64 " %" PRId64 "\n",
+           metrics->category_counters[DARSHAN_ALL_FILES].count,
+           metrics->category_counters[DARSHAN_ALL_FILES].total_read_volume_bytes +
+            metrics->category_counters[DARSHAN_ALL_FILES].total_write_volume_bytes,
+           metrics->category_counters[DARSHAN_ALL_FILES].max_offset_bytes);
+    printf("# read_only: %" PRId64 " %" PRId64 " %" PRId64 "\n",
+           metrics->category_counters[DARSHAN_RO_FILES].count,
+           metrics->category_counters[DARSHAN_RO_FILES].total_read_volume_bytes +
+            metrics->category_counters[DARSHAN_RO_FILES].total_write_volume_bytes,
+           metrics->category_counters[DARSHAN_RO_FILES].max_offset_bytes);
+    printf("# write_only: %" PRId64 " %" PRId64 " %" PRId64 "\n",
+           metrics->category_counters[DARSHAN_WO_FILES].count,
+           metrics->category_counters[DARSHAN_WO_FILES].total_read_volume_bytes +
+            metrics->category_counters[DARSHAN_WO_FILES].total_write_volume_bytes,
+           metrics->category_counters[DARSHAN_WO_FILES].max_offset_bytes);
+    printf("# read_write: %" PRId64 " %" PRId64 " %" PRId64 "\n",
+           metrics->category_counters[DARSHAN_RW_FILES].count,
+           metrics->category_counters[DARSHAN_RW_FILES].total_read_volume_bytes +
+            metrics->category_counters[DARSHAN_RW_FILES].total_write_volume_bytes,
+           metrics->category_counters[DARSHAN_RW_FILES].max_offset_bytes);
+    printf("# unique: %" PRId64 " %" PRId64 " %" PRId64 "\n",
+           metrics->category_counters[DARSHAN_UNIQ_FILES].count,
+           metrics->category_counters[DARSHAN_UNIQ_FILES].total_read_volume_bytes +
+            metrics->category_counters[DARSHAN_UNIQ_FILES].total_write_volume_bytes,
+           metrics->category_counters[DARSHAN_UNIQ_FILES].max_offset_bytes);
+    printf("# shared: %" PRId64 " %" PRId64 " %" PRId64 "\n",
+           metrics->category_counters[DARSHAN_SHARED_FILES].count +
+            metrics->category_counters[DARSHAN_PART_SHARED_FILES].count,
+           metrics->category_counters[DARSHAN_SHARED_FILES].total_read_volume_bytes +
+            metrics->category_counters[DARSHAN_SHARED_FILES].total_write_volume_bytes +
+            metrics->category_counters[DARSHAN_PART_SHARED_FILES].total_read_volume_bytes +
+            metrics->category_counters[DARSHAN_PART_SHARED_FILES].total_write_volume_bytes,
+           metrics->category_counters[DARSHAN_SHARED_FILES].max_offset_bytes +
+            metrics->category_counters[DARSHAN_PART_SHARED_FILES].max_offset_bytes);
+    return;
+}
+
+static void print_perf(struct darshan_derived_metrics *metrics, int multi)
+{
+    printf("\n# performance\n");
+    printf("# -----------\n");
+    printf("# total_bytes: %" PRId64 "\n", metrics->total_bytes);
+    printf("#\n");
+    printf("# I/O timing for unique files (seconds):\n");
+    printf("# ...........................\n");
+    printf("# unique files: slowest_rank_io_time: %lf\n", metrics->unique_io_total_time_by_slowest);
+    printf("# unique files: slowest_rank_meta_only_time: %lf\n", metrics->unique_md_only_time_by_slowest);
+    printf("# unique files: slowest_rank_rw_only_time: %lf\n", metrics->unique_rw_only_time_by_slowest);
+    /* the slowest rank is only meaningful within a single job */
+    if(!multi)
+        printf("# unique files: slowest_rank: %d\n", metrics->unique_io_slowest_rank);
+    printf("#\n");
+    printf("# I/O timing for shared files (seconds):\n");
+    printf("# ...........................\n");
+    printf("# shared files: time_by_slowest: %lf\n", metrics->shared_io_total_time_by_slowest);
+    printf("#\n");
+    printf("# Aggregate performance, including both shared and unique files:\n");
+    printf("# ...........................\n");
+    printf("# agg_time_by_slowest: %lf # seconds\n", metrics->agg_time_by_slowest);
+    printf("# agg_perf_by_slowest: %lf # MiB/s\n", metrics->agg_perf_by_slowest);
+    return;
+}
+
 void stdio_print_total_file(struct darshan_stdio_file *pfile, int stdio_ver)
 {
     int i;
@@ -0,0 +1,307 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "darshan-util-config.h"
+#endif
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "darshan-logutils.h"
+
+/* integer counter name strings for the PHASE module */
+#define X(a) #a,
+char *phase_counter_names[] = {
+    PHASE_COUNTERS
+};
+
+/* floating point counter name strings for the PHASE module */
+char *phase_f_counter_names[] = {
+    PHASE_F_COUNTERS
+};
+#undef X
+
+/* prototypes for each of the PHASE module's logutil functions */
+static int darshan_log_get_phase_record(darshan_fd fd, void** phase_buf_p);
+static int darshan_log_put_phase_record(darshan_fd fd, void* phase_buf);
+static void darshan_log_print_phase_record(void *file_rec,
+    char *file_name, char *mnt_pt, char *fs_type);
+static void darshan_log_print_phase_description(int ver);
+static void darshan_log_print_phase_record_diff(void *file_rec1, char *file_name1,
+    void *file_rec2, char *file_name2);
+static void darshan_log_agg_phase_records(void *rec, void *agg_rec, int init_flag);
+
+/* structure storing each function needed for implementing the darshan
+ * logutil interface. these functions are used for reading, writing, and
+ * printing module data in a consistent manner.
+ */
+struct darshan_mod_logutil_funcs phase_logutils =
+{
+    .log_get_record = &darshan_log_get_phase_record,
+    .log_put_record = &darshan_log_put_phase_record,
+    .log_print_record = &darshan_log_print_phase_record,
+    .log_print_description = &darshan_log_print_phase_description,
+    .log_print_diff = &darshan_log_print_phase_record_diff,
+    .log_agg_records = &darshan_log_agg_phase_records
+};
+
+/* retrieve a PHASE record from log file descriptor 'fd', storing the
+ * data in the buffer address pointed to by 'phase_buf_p'. Return 1 on
+ * successful record read, 0 on no more data, and -1 on error.
+ */
+static int darshan_log_get_phase_record(darshan_fd fd, void** phase_buf_p)
+{
+    struct darshan_phase_record *rec = *((struct darshan_phase_record **)phase_buf_p);
+    int ret;
+
+    if(fd->mod_map[DARSHAN_PHASE_MOD].len == 0)
+        return(0);
+
+    if(fd->mod_ver[DARSHAN_PHASE_MOD] == 0 ||
+        fd->mod_ver[DARSHAN_PHASE_MOD] > DARSHAN_PHASE_VER)
+    {
+        fprintf(stderr, "Error: Invalid PHASE module version number (got %d)\n",
+            fd->mod_ver[DARSHAN_PHASE_MOD]);
+        return(-1);
+    }
+
+    if(*phase_buf_p == NULL)
+    {
+        rec = malloc(sizeof(*rec));
+        if(!rec)
+            return(-1);
+    }
+
+    /* read a PHASE module record from the darshan log file */
+    ret = darshan_log_get_mod(fd, DARSHAN_PHASE_MOD, rec,
+        sizeof(struct darshan_phase_record));
+
+    if(*phase_buf_p == NULL)
+    {
+        if(ret == sizeof(struct darshan_phase_record))
+            *phase_buf_p = rec;
+        else
+            free(rec);
+    }
+
+    if(ret < 0)
+        return(-1);
+    else if(ret < sizeof(struct darshan_phase_record))
+        return(0);
+    else
+    {
+        /* if the read was successful, do any necessary byte-swapping */
+        if(fd->swap_flag)
+        {
+            /* records consist only of 64-bit fields */
+            darshan_log_bswap64_array(rec,
+                sizeof(struct darshan_phase_record) / sizeof(int64_t));
+        }
+
+        return(1);
+    }
+}
+
+/* write the PHASE record stored in 'phase_buf' to log file descriptor 'fd'.
+ * Return 0 on success, -1 on failure
+ */
+static int darshan_log_put_phase_record(darshan_fd fd, void* phase_buf)
+{
+    struct darshan_phase_record *rec = (struct darshan_phase_record *)phase_buf;
+    int ret;
+
+    /* append PHASE record to darshan log file */
+    ret = darshan_log_put_mod(fd, DARSHAN_PHASE_MOD, rec,
+        sizeof(struct darshan_phase_record), DARSHAN_PHASE_VER);
+    if(ret < 0)
+        return(-1);
+
+    return(0);
+}
+
+/* print all I/O data record statistics for the given PHASE record */
+static void darshan_log_print_phase_record(void *file_rec, char *file_name,
+    char *mnt_pt, char *fs_type)
+{
+    int i;
+    struct darshan_phase_record *phase_rec =
+        (struct darshan_phase_record *)file_rec;
+
+    /* print each of the integer and floating point counters for the PHASE module */
+    for(i=0; i<PHASE_NUM_INDICES; i++)
+    {
+        /* macro defined in darshan-logutils.h */
+        DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_PHASE_MOD],
+            phase_rec->base_rec.rank, phase_rec->base_rec.id,
+            phase_counter_names[i], phase_rec->counters[i],
+            file_name, mnt_pt, fs_type);
+    }
+
+    for(i=0; i<PHASE_F_NUM_INDICES; i++)
+    {
+        /* macro defined in darshan-logutils.h */
+        DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_PHASE_MOD],
+            phase_rec->base_rec.rank, phase_rec->base_rec.id,
+            phase_f_counter_names[i], phase_rec->fcounters[i],
+            file_name, mnt_pt, fs_type);
+    }
+
+    return;
+}
+
+/* print out a description of the PHASE module record fields */
+static void darshan_log_print_phase_description(int ver)
+{
+    printf("\n# description of PHASE counters:\n");
+    printf("#   each record accumulates the occurrences of an application phase, named\n");
+    printf("#   \"phase:\" followed by the name given to darshan_phase_begin(), or by\n");
+    printf("#   \"barrier.<n>\" for the n-th phase delimited by DARSHAN_PHASE_BARRIERS\n");
+    printf("#   calls to MPI_Barrier().  I/O in nested phases counts toward each of them.\n");
+    printf("#   PHASE_PROCS: number of processes that entered the phase.\n");
+    printf("#   PHASE_OCCURRENCES: number of times the phase was entered.\n");
+    printf("#   PHASE_<API>_READS, _WRITES, _META_OPS: operations of each API in the phase.\n");
+    printf("#   PHASE_<API>_BYTES_READ, _BYTES_WRITTEN: bytes moved by each API in the phase.\n");
+    printf("#   PHASE_F_START_TIMESTAMP: timestamp of the first entry into the phase.\n");
+    printf("#   PHASE_F_END_TIMESTAMP: timestamp of the last exit from the phase.\n");
+    printf("#   PHASE_F_TIME: time spent in the phase, summed over processes.\n");
+    printf("#   PHASE_F_SLOWEST_RANK_TIME: time spent in the phase by the slowest process.\n");
+    printf("#   PHASE_F_<API>_READ_TIME, _WRITE_TIME, _META_TIME: time spent in the I/O\n");
+    printf("#       operations of each API in the phase.\n");
+
+    return;
+}
+
+/* print a diff of two PHASE records (with the same record id) */
+static void darshan_log_print_phase_record_diff(void *file_rec1, char *file_name1,
+    void *file_rec2, char *file_name2)
+{
+    struct darshan_phase_record *file1 = (struct darshan_phase_record *)file_rec1;
+    struct darshan_phase_record *file2 = (struct darshan_phase_record *)file_rec2;
+    int i;
+
+    /* NOTE: we assume that both input records are the same module format version */
+
+    for(i=0; i<PHASE_NUM_INDICES; i++)
+    {
+        if(!file2)
+        {
+            printf("- ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_PHASE_MOD],
+                file1->base_rec.rank, file1->base_rec.id, phase_counter_names[i],
+                file1->counters[i], file_name1, "", "");
+
+        }
+        else if(!file1)
+        {
+            printf("+ ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_PHASE_MOD],
+                file2->base_rec.rank, file2->base_rec.id, phase_counter_names[i],
+                file2->counters[i], file_name2, "", "");
+        }
+        else if(file1->counters[i] != file2->counters[i])
+        {
+            printf("- ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_PHASE_MOD],
+                file1->base_rec.rank, file1->base_rec.id, phase_counter_names[i],
+                file1->counters[i], file_name1, "", "");
+            printf("+ ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_PHASE_MOD],
+                file2->base_rec.rank, file2->base_rec.id, phase_counter_names[i],
+                file2->counters[i], file_name2, "", "");
+        }
+    }
+
+    for(i=0; i<PHASE_F_NUM_INDICES; i++)
+    {
+        if(!file2)
+        {
+            printf("- ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_PHASE_MOD],
+                file1->base_rec.rank, file1->base_rec.id, phase_f_counter_names[i],
+                file1->fcounters[i], file_name1, "", "");
+
+        }
+        else if(!file1)
+        {
+            printf("+ ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_PHASE_MOD],
+                file2->base_rec.rank, file2->base_rec.id, phase_f_counter_names[i],
+                file2->fcounters[i], file_name2, "", "");
+        }
+        else if(file1->fcounters[i] != file2->fcounters[i])
+        {
+            printf("- ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_PHASE_MOD],
+                file1->base_rec.rank, file1->base_rec.id, phase_f_counter_names[i],
+                file1->fcounters[i], file_name1, "", "");
+            printf("+ ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_PHASE_MOD],
+                file2->base_rec.rank, file2->base_rec.id, phase_f_counter_names[i],
+                file2->fcounters[i], file_name2, "", "");
+        }
+    }
+
+    return;
+}
+
+/* aggregate the input PHASE record 'rec'  into the output record 'agg_rec' */
+static void darshan_log_agg_phase_records(void *rec, void *agg_rec, int init_flag)
+{
+    struct darshan_phase_record *phase_rec = (struct darshan_phase_record *)rec;
+    struct darshan_phase_record *agg_phase_rec = (struct darshan_phase_record *)agg_rec;
+    int i;
+
+    for(i = 0; i < PHASE_NUM_INDICES; i++)
+    {
+        /* sum */
+        agg_phase_rec->counters[i] += phase_rec->counters[i];
+    }
+
+    for(i = 0; i < PHASE_F_NUM_INDICES; i++)
+    {
+        switch(i)
+        {
+            case PHASE_F_START_TIMESTAMP:
+                /* min non-zero */
+                if((phase_rec->fcounters[i] > 0) &&
+                    (init_flag || agg_phase_rec->fcounters[i] == 0 ||
+                    phase_rec->fcounters[i] < agg_phase_rec->fcounters[i]))
+                    agg_phase_rec->fcounters[i] = phase_rec->fcounters[i];
+                break;
+            case PHASE_F_END_TIMESTAMP:
+            case PHASE_F_SLOWEST_RANK_TIME:
+                /* max */
+                if(phase_rec->fcounters[i] > agg_phase_rec->fcounters[i])
+                    agg_phase_rec->fcounters[i] = phase_rec->fcounters[i];
+                break;
+            default:
+                /* sum */
+                agg_phase_rec->fcounters[i] += phase_rec->fcounters[i];
+                break;
+        }
+    }
+
+    return;
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
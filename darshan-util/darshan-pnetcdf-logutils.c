@@ -43,6 +43,8 @@ char *pnetcdf_var_f_counter_names[] = {
 
 #define DARSHAN_PNETCDF_FILE_SIZE_1 48
 #define DARSHAN_PNETCDF_FILE_SIZE_2 64
+#define DARSHAN_PNETCDF_FILE_SIZE_3 152
+#define DARSHAN_PNETCDF_VAR_SIZE_1 1120
 
 static int darshan_log_get_pnetcdf_file(darshan_fd fd, void** pnetcdf_buf_p);
 static int darshan_log_put_pnetcdf_file(darshan_fd fd, void* pnetcdf_buf);
@@ -189,6 +191,31 @@ static int darshan_log_get_pnetcdf_file(darshan_fd fd, void** pnetcdf_buf_p)
             dest_p += sizeof(double);
             *(double *)dest_p = -1;
         }
+        if(fd->mod_ver[DARSHAN_PNETCDF_FILE_MOD] <= 3)
+        {
+            if(fd->mod_ver[DARSHAN_PNETCDF_FILE_MOD] == 3)
+            {
+                rec_len = DARSHAN_PNETCDF_FILE_SIZE_3;
+                ret = darshan_log_get_mod(fd, DARSHAN_PNETCDF_FILE_MOD, scratch, rec_len);
+                if(ret != rec_len)
+                    goto exit;
+            }
+
+            /* upconvert version 3 to version 4 in-place */
+            /* move floating point counters past the new wait counters */
+            src_p = scratch + sizeof(struct darshan_base_record) +
+                (9 * sizeof(int64_t));
+            dest_p = scratch + sizeof(struct darshan_base_record) +
+                (PNETCDF_FILE_NUM_INDICES * sizeof(int64_t));
+            len = PNETCDF_FILE_F_NUM_INDICES * sizeof(double);
+            memmove(dest_p, src_p, len);
+            /* set new FILE_WAIT_REQS .. FILE_WAIT_REQS_257_PLUS all to -1 */
+            for(i = PNETCDF_FILE_WAIT_REQS; i < PNETCDF_FILE_NUM_INDICES; i++)
+            {
+                *((int64_t *)src_p) = -1;
+                src_p += sizeof(int64_t);
+            }
+        }
 
         memcpy(file, scratch, sizeof(struct darshan_pnetcdf_file));
     }
@@ -209,7 +236,14 @@ exit:
     else
     {
         /* if the read was successful, do any necessary byte-swapping */
-        if(fd->swap_flag)
+        if(fd->swap_flag &&
+            fd->mod_ver[DARSHAN_PNETCDF_FILE_MOD] == DARSHAN_PNETCDF_FILE_VER)
+        {
+            /* current records consist only of 64-bit fields */
+            darshan_log_bswap64_array(file,
+                sizeof(struct darshan_pnetcdf_file) / sizeof(int64_t));
+        }
+        else if(fd->swap_flag)
         {
             DARSHAN_BSWAP64(&(file->base_rec.id));
             DARSHAN_BSWAP64(&(file->base_rec.rank));
@@ -224,6 +258,9 @@ exit:
                      (i == PNETCDF_FILE_SYNCS) || (i == PNETCDF_FILE_BYTES_READ) ||
                      (i == PNETCDF_FILE_BYTES_WRITTEN) || (i == PNETCDF_FILE_WAIT_FAILURES)))
                     continue;
+                if((fd->mod_ver[DARSHAN_PNETCDF_FILE_MOD] < 4) &&
+                    (i >= PNETCDF_FILE_WAIT_REQS))
+                    continue;
                 DARSHAN_BSWAP64(&file->counters[i]);
             }
             for(i=0; i<PNETCDF_FILE_F_NUM_INDICES; i++)
@@ -281,6 +318,19 @@ static int darshan_log_get_pnetcdf_var(darshan_fd fd, void** pnetcdf_buf_p)
         rec_len = sizeof(struct darshan_pnetcdf_var);
         ret = darshan_log_get_mod(fd, DARSHAN_PNETCDF_VAR_MOD, var, rec_len);
     }
+    else
+    {
+        /* upconvert version 1 to version 2: the new NB time counters are
+         * at the end of the record, so read the record in place
+         */
+        rec_len = DARSHAN_PNETCDF_VAR_SIZE_1;
+        ret = darshan_log_get_mod(fd, DARSHAN_PNETCDF_VAR_MOD, var, rec_len);
+        if(ret == rec_len)
+        {
+            var->fcounters[PNETCDF_VAR_F_NB_READ_TIME] = -1;
+            var->fcounters[PNETCDF_VAR_F_NB_WRITE_TIME] = -1;
+        }
+    }
 
 exit:
     if(*pnetcdf_buf_p == NULL)
@@ -298,7 +348,14 @@ exit:
     else
     {
         /* if the read was successful, do any necessary byte-swapping */
-        if(fd->swap_flag)
+        if(fd->swap_flag &&
+            fd->mod_ver[DARSHAN_PNETCDF_VAR_MOD] == DARSHAN_PNETCDF_VAR_VER)
+        {
+            /* current records consist only of 64-bit fields */
+            darshan_log_bswap64_array(var,
+                sizeof(struct darshan_pnetcdf_var) / sizeof(int64_t));
+        }
+        else if(fd->swap_flag)
         {
             DARSHAN_BSWAP64(&(var->base_rec.id));
             DARSHAN_BSWAP64(&(var->base_rec.rank));
@@ -306,7 +363,16 @@ exit:
             for(i=0; i<PNETCDF_VAR_NUM_INDICES; i++)
                 DARSHAN_BSWAP64(&var->counters[i]);
             for(i=0; i<PNETCDF_VAR_F_NUM_INDICES; i++)
+            {
+                /* skip counters we explicitly set to -1 since they don't
+                 * need to be byte swapped
+                 */
+                if((fd->mod_ver[DARSHAN_PNETCDF_VAR_MOD] == 1) &&
+                    ((i == PNETCDF_VAR_F_NB_READ_TIME) ||
+                     (i == PNETCDF_VAR_F_NB_WRITE_TIME)))
+                    continue;
                 DARSHAN_BSWAP64(&var->fcounters[i]);
+            }
         }
 
         return(1);
@@ -408,6 +474,9 @@ static void darshan_log_print_pnetcdf_file_description(int ver)
     printf("#   PNETCDF_FILE_BYTES_READ: PnetCDF total bytes read for all file variables.\n");
     printf("#   PNETCDF_FILE_BYTES_WRITTEN: PnetCDF total bytes written for all file variables.\n");
     printf("#   PNETCDF_FILE_WAIT_FAILURES: PnetCDF file wait operation failure counts.\n");
+    printf("#   PNETCDF_FILE_WAIT_REQS: number of nonblocking requests flushed by PnetCDF file wait operations.\n");
+    printf("#   PNETCDF_FILE_WAIT_BYTES: total bytes moved by nonblocking requests flushed by PnetCDF file wait operations.\n");
+    printf("#   PNETCDF_FILE_WAIT_REQS_*: histogram of the number of nonblocking requests flushed per PnetCDF file wait operation.\n");
     printf("#   PNETCDF_FILE_F_*_START_TIMESTAMP: timestamp of first PnetCDF file open/close/wait operation.\n");
     printf("#   PNETCDF_FILE_F_*_END_TIMESTAMP: timestamp of last PnetCDF file open/close/wait operation.\n");
     printf("#   PNETCDF_FILE_F_META_TIME: Cumulative time spent in file metadata operations.\n");
@@ -435,6 +504,13 @@ static void darshan_log_print_pnetcdf_file_description(int ver)
         printf("# - PNETCDF_FILE_F_META_TIME\n");
         printf("# - PNETCDF_FILE_F_WAIT_TIME\n");
     }
+    if(ver <= 3)
+    {
+        printf("\n# WARNING: PnetCDF file module log format version <=3 does not support the following counters:\n");
+        printf("# - PNETCDF_FILE_WAIT_REQS\n");
+        printf("# - PNETCDF_FILE_WAIT_BYTES\n");
+        printf("# - PNETCDF_FILE_WAIT_REQS_*\n");
+    }
 
     return;
 }
@@ -471,8 +547,16 @@ static void darshan_log_print_pnetcdf_var_description(int ver)
     printf("#   PNETCDF_VAR_F_MAX_*_TIME: duration of the slowest PnetCDF read and write operations.\n");
     printf("#   PNETCDF_VAR_F_*_RANK_TIME: fastest and slowest I/O time for a single rank (for shared datasets).\n");
     printf("#   PNETCDF_VAR_F_VARIANCE_RANK_*: variance of total I/O time and bytes moved for all ranks (for shared datasets).\n");
+    printf("#   PNETCDF_VAR_F_NB_READ/WRITE_TIME: cumulative time spent in PnetCDF file wait operations that flushed nonblocking reads or writes of the variable.\n");
     printf("#   PNETCDF_VAR_FILE_REC_ID: Darshan file record ID of the file the variable belongs to.\n");
 
+    if(ver == 1)
+    {
+        printf("\n# WARNING: PnetCDF variable module log format version 1 does not support the following counters:\n");
+        printf("# - PNETCDF_VAR_F_NB_READ_TIME\n");
+        printf("# - PNETCDF_VAR_F_NB_WRITE_TIME\n");
+    }
+
     return;
 }
 
@@ -639,6 +723,15 @@ static void darshan_log_agg_pnetcdf_files(void *rec, void *agg_rec, int init_fla
             case PNETCDF_FILE_BYTES_READ:
             case PNETCDF_FILE_BYTES_WRITTEN:
             case PNETCDF_FILE_WAIT_FAILURES:
+            case PNETCDF_FILE_WAIT_REQS:
+            case PNETCDF_FILE_WAIT_BYTES:
+            case PNETCDF_FILE_WAIT_REQS_0:
+            case PNETCDF_FILE_WAIT_REQS_1:
+            case PNETCDF_FILE_WAIT_REQS_2_4:
+            case PNETCDF_FILE_WAIT_REQS_5_16:
+            case PNETCDF_FILE_WAIT_REQS_17_64:
+            case PNETCDF_FILE_WAIT_REQS_65_256:
+            case PNETCDF_FILE_WAIT_REQS_257_PLUS:
                 /* sum */
                 agg_pnetcdf_rec->counters[i] += pnetcdf_rec->counters[i];
                 break;
@@ -949,6 +1042,8 @@ static void darshan_log_agg_pnetcdf_vars(void *rec, void *agg_rec, int init_flag
             case PNETCDF_VAR_F_READ_TIME:
             case PNETCDF_VAR_F_WRITE_TIME:
             case PNETCDF_VAR_F_META_TIME:
+            case PNETCDF_VAR_F_NB_READ_TIME:
+            case PNETCDF_VAR_F_NB_WRITE_TIME:
                 /* sum */
                 agg_pnetcdf_rec->fcounters[i] += pnetcdf_rec->fcounters[i];
                 break;
@@ -47,7 +47,10 @@ static void darshan_log_print_posix_description(int ver);
 static void darshan_log_print_posix_file_diff(void *file_rec1, char *file_name1,
     void *file_rec2, char *file_name2);
 static void darshan_log_agg_posix_files(void *rec, void *agg_rec, int init_flag);
+static void darshan_log_agg_posix_files_batch(void *rec_buf, int count,
+    void *agg_rec, int init_flag);
 static int darshan_log_sizeof_posix_file(void* posix_buf_p);
+static void darshan_log_swap_posix_file(void *posix_buf_p);
 static int darshan_log_record_metrics_posix_file(void*    posix_buf_p,
                                                  uint64_t* rec_id,
                                                  int64_t* r_bytes,
@@ -67,8 +70,10 @@ struct darshan_mod_logutil_funcs posix_logutils =
     .log_print_description = &darshan_log_print_posix_description,
     .log_print_diff = &darshan_log_print_posix_file_diff,
     .log_agg_records = &darshan_log_agg_posix_files,
+    .log_agg_records_batch = &darshan_log_agg_posix_files_batch,
     .log_sizeof_record = &darshan_log_sizeof_posix_file,
-    .log_record_metrics = &darshan_log_record_metrics_posix_file
+    .log_record_metrics = &darshan_log_record_metrics_posix_file,
+    .log_swap_record = &darshan_log_swap_posix_file
 };
 
 static int darshan_log_sizeof_posix_file(void* posix_buf_p)
@@ -77,6 +82,16 @@ static int darshan_log_sizeof_posix_file(void* posix_buf_p)
     return(sizeof(struct darshan_posix_file));
 }
 
+/* byte swap a POSIX record of the current log format version in place */
+static void darshan_log_swap_posix_file(void *posix_buf_p)
+{
+    /* records consist only of 64-bit fields, so swap them in one pass */
+    darshan_log_bswap64_array(posix_buf_p,
+        sizeof(struct darshan_posix_file) / sizeof(int64_t));
+
+    return;
+}
+
 static int darshan_log_record_metrics_posix_file(void*    posix_buf_p,
                                          uint64_t* rec_id,
                                          int64_t* r_bytes,
@@ -267,7 +282,9 @@ exit:
     else
     {
         /* if the read was successful, do any necessary byte-swapping */
-        if(fd->swap_flag)
+        if(fd->swap_flag && fd->mod_ver[DARSHAN_POSIX_MOD] == DARSHAN_POSIX_VER)
+            darshan_log_swap_posix_file(file);
+        else if(fd->swap_flag)
         {
             DARSHAN_BSWAP64(&file->base_rec.id);
             DARSHAN_BSWAP64(&file->base_rec.rank);
@@ -504,11 +521,37 @@ struct var_t
     double S;
 };
 
-static void darshan_log_agg_posix_files(void *rec, void *agg_rec, int init_flag)
+/* how the POSIX counters are aggregated, as runs of consecutive counters;
+ * counters not covered here are handled by darshan_log_agg_posix_custom()
+ */
+static const struct darshan_agg_run posix_agg_runs[] =
+{
+    {POSIX_OPENS, POSIX_RENAME_TARGETS, DARSHAN_AGG_SUM_VALID},
+    {POSIX_RENAMED_FROM, POSIX_MODE, DARSHAN_AGG_SET},
+    {POSIX_BYTES_READ, POSIX_BYTES_WRITTEN, DARSHAN_AGG_SUM_VALID},
+    {POSIX_MAX_BYTE_READ, POSIX_MAX_BYTE_WRITTEN, DARSHAN_AGG_MAX},
+    {POSIX_CONSEC_READS, POSIX_MEM_NOT_ALIGNED, DARSHAN_AGG_SUM_VALID},
+    {POSIX_MEM_ALIGNMENT, POSIX_MEM_ALIGNMENT, DARSHAN_AGG_SET},
+    {POSIX_FILE_NOT_ALIGNED, POSIX_FILE_NOT_ALIGNED, DARSHAN_AGG_SUM_VALID},
+    {POSIX_FILE_ALIGNMENT, POSIX_FILE_ALIGNMENT, DARSHAN_AGG_SET},
+    {POSIX_SIZE_READ_0_100, POSIX_SIZE_WRITE_1G_PLUS, DARSHAN_AGG_SUM_VALID},
+};
+
+static const struct darshan_agg_run posix_agg_fruns[] =
+{
+    {POSIX_F_OPEN_START_TIMESTAMP, POSIX_F_CLOSE_START_TIMESTAMP, DARSHAN_AGG_MIN_NONZERO},
+    {POSIX_F_OPEN_END_TIMESTAMP, POSIX_F_CLOSE_END_TIMESTAMP, DARSHAN_AGG_MAX},
+    {POSIX_F_READ_TIME, POSIX_F_META_TIME, DARSHAN_AGG_SUM},
+};
+
+/* aggregate the counters of a record that are not covered by the tables
+ * above
+ */
+static void darshan_log_agg_posix_custom(void *rec, void *agg_rec, int init_flag)
 {
     struct darshan_posix_file *psx_rec = (struct darshan_posix_file *)rec;
     struct darshan_posix_file *agg_psx_rec = (struct darshan_posix_file *)agg_rec;
-    int i, j, k;
+    int i, j, k, n;
     int total_count;
     int64_t tmp_val[4];
     int64_t tmp_cnt[4];
@@ -586,351 +629,215 @@ static void darshan_log_agg_posix_files(void *rec, void *agg_rec, int init_flag)
     if(agg_psx_rec->base_rec.rank != psx_rec->base_rec.rank)
         agg_psx_rec->base_rec.rank = -1;
 
-    for(i = 0; i < POSIX_NUM_INDICES; i++)
+    /* increment common value counters of both the STRIDE and ACCESS
+     * counter sets
+     */
+    for(n = 0; n < 2; n++)
     {
-        switch(i)
+        i = (n == 0) ? POSIX_STRIDE1_STRIDE : POSIX_ACCESS1_ACCESS;
+
+        /* NOTE: this same code block is used to collapse both the ACCESS
+         * and STRIDE counter sets. We therefore have to take care to zero
+         * any stateful variables that might get reused.
+         */
+        memset(duplicate_mask, 0, 4*sizeof(duplicate_mask[0]));
+
+        /* first, collapse duplicates */
+        for(j = i; j < i + 4; j++)
         {
-            case POSIX_OPENS:
-            case POSIX_FILENOS:
-            case POSIX_DUPS:
-            case POSIX_READS:
-            case POSIX_WRITES:
-            case POSIX_SEEKS:
-            case POSIX_STATS:
-            case POSIX_MMAPS:
-            case POSIX_FSYNCS:
-            case POSIX_FDSYNCS:
-            case POSIX_RENAME_SOURCES:
-            case POSIX_RENAME_TARGETS:
-            case POSIX_BYTES_READ:
-            case POSIX_BYTES_WRITTEN:
-            case POSIX_CONSEC_READS:
-            case POSIX_CONSEC_WRITES:
-            case POSIX_SEQ_READS:
-            case POSIX_SEQ_WRITES:
-            case POSIX_RW_SWITCHES:
-            case POSIX_MEM_NOT_ALIGNED:
-            case POSIX_FILE_NOT_ALIGNED:
-            case POSIX_SIZE_READ_0_100:
-            case POSIX_SIZE_READ_100_1K:
-            case POSIX_SIZE_READ_1K_10K:
-            case POSIX_SIZE_READ_10K_100K:
-            case POSIX_SIZE_READ_100K_1M:
-            case POSIX_SIZE_READ_1M_4M:
-            case POSIX_SIZE_READ_4M_10M:
-            case POSIX_SIZE_READ_10M_100M:
-            case POSIX_SIZE_READ_100M_1G:
-            case POSIX_SIZE_READ_1G_PLUS:
-            case POSIX_SIZE_WRITE_0_100:
-            case POSIX_SIZE_WRITE_100_1K:
-            case POSIX_SIZE_WRITE_1K_10K:
-            case POSIX_SIZE_WRITE_10K_100K:
-            case POSIX_SIZE_WRITE_100K_1M:
-            case POSIX_SIZE_WRITE_1M_4M:
-            case POSIX_SIZE_WRITE_4M_10M:
-            case POSIX_SIZE_WRITE_10M_100M:
-            case POSIX_SIZE_WRITE_100M_1G:
-            case POSIX_SIZE_WRITE_1G_PLUS:
-                /* sum */
-                agg_psx_rec->counters[i] += psx_rec->counters[i];
-                if(agg_psx_rec->counters[i] < 0) /* make sure invalid counters are -1 exactly */
-                    agg_psx_rec->counters[i] = -1;
-                break;
-            case POSIX_RENAMED_FROM:
-            case POSIX_MODE:
-            case POSIX_MEM_ALIGNMENT:
-            case POSIX_FILE_ALIGNMENT:
-                /* just set to the input value */
-                agg_psx_rec->counters[i] = psx_rec->counters[i];
-                break;
-            case POSIX_MAX_BYTE_READ:
-            case POSIX_MAX_BYTE_WRITTEN:
-                /* max */
-                if(psx_rec->counters[i] > agg_psx_rec->counters[i])
+            for(k = 0; k < 4; k++)
+            {
+                if(agg_psx_rec->counters[i + k] == psx_rec->counters[j])
                 {
-                    agg_psx_rec->counters[i] = psx_rec->counters[i];
+                    agg_psx_rec->counters[i + k + 4] += psx_rec->counters[j + 4];
+                    /* flag that we should ignore this one now */
+                    duplicate_mask[j-i] = 1;
                 }
-                break;
-            case POSIX_MAX_READ_TIME_SIZE:
-            case POSIX_MAX_WRITE_TIME_SIZE:
-            case POSIX_FASTEST_RANK:
-            case POSIX_FASTEST_RANK_BYTES:
-            case POSIX_SLOWEST_RANK:
-            case POSIX_SLOWEST_RANK_BYTES:
-                /* these are set with the FP counters */
-                break;
-            case POSIX_STRIDE1_STRIDE:
-            case POSIX_ACCESS1_ACCESS:
-                /* NOTE: this same code block is used to collapse both the
-                 * ACCESS and STRIDE counter sets (see the drop through in
-                 * the case above). We therefore have to take care to zero
-                 * any stateful variables that might get reused.
-                 */
-                memset(duplicate_mask, 0, 4*sizeof(duplicate_mask[0]));
-                /* increment common value counters */
+            }
+        }
 
-                /* first, collapse duplicates */
-                for(j = i; j < i + 4; j++)
+        /* second, add new counters */
+        for(j = i; j < i + 4; j++)
+        {
+            /* skip any that were handled above already */
+            if(duplicate_mask[j-i])
+                continue;
+            tmp_ndx = 0;
+            memset(tmp_val, 0, 4 * sizeof(int64_t));
+            memset(tmp_cnt, 0, 4 * sizeof(int64_t));
+
+            if(psx_rec->counters[j] == 0) break;
+            for(k = 0; k < 4; k++)
+            {
+                if(agg_psx_rec->counters[i + k] == psx_rec->counters[j])
                 {
-                    for(k = 0; k < 4; k++)
-                    {
-                        if(agg_psx_rec->counters[i + k] == psx_rec->counters[j])
-                        {
-                            agg_psx_rec->counters[i + k + 4] += psx_rec->counters[j + 4];
-                            /* flag that we should ignore this one now */
-                            duplicate_mask[j-i] = 1;
-                        }
-                    }
+                    total_count = agg_psx_rec->counters[i + k + 4] +
+                        psx_rec->counters[j + 4];
+                    break;
                 }
+            }
+            if(k == 4) total_count = psx_rec->counters[j + 4];
 
-                /* second, add new counters */
-                for(j = i; j < i + 4; j++)
+            for(k = 0; k < 4; k++)
+            {
+                if((agg_psx_rec->counters[i + k + 4] > total_count) ||
+                   ((agg_psx_rec->counters[i + k + 4] == total_count) &&
+                    (agg_psx_rec->counters[i + k] > psx_rec->counters[j])))
                 {
-                    /* skip any that were handled above already */
-                    if(duplicate_mask[j-i])
-                        continue;
-                    tmp_ndx = 0;
-                    memset(tmp_val, 0, 4 * sizeof(int64_t));
-                    memset(tmp_cnt, 0, 4 * sizeof(int64_t));
-
-                    if(psx_rec->counters[j] == 0) break;
-                    for(k = 0; k < 4; k++)
-                    {
-                        if(agg_psx_rec->counters[i + k] == psx_rec->counters[j])
-                        {
-                            total_count = agg_psx_rec->counters[i + k + 4] +
-                                psx_rec->counters[j + 4];
-                            break;
-                        }
-                    }
-                    if(k == 4) total_count = psx_rec->counters[j + 4];
-
-                    for(k = 0; k < 4; k++)
-                    {
-                        if((agg_psx_rec->counters[i + k + 4] > total_count) ||
-                           ((agg_psx_rec->counters[i + k + 4] == total_count) &&
-                            (agg_psx_rec->counters[i + k] > psx_rec->counters[j])))
-                        {
-                            tmp_val[tmp_ndx] = agg_psx_rec->counters[i + k];
-                            tmp_cnt[tmp_ndx] = agg_psx_rec->counters[i + k + 4];
-                            tmp_ndx++;
-                        }
-                        else break;
-                    }
-                    if(tmp_ndx == 4) break;
-
-                    tmp_val[tmp_ndx] = psx_rec->counters[j];
-                    tmp_cnt[tmp_ndx] = psx_rec->counters[j + 4];
+                    tmp_val[tmp_ndx] = agg_psx_rec->counters[i + k];
+                    tmp_cnt[tmp_ndx] = agg_psx_rec->counters[i + k + 4];
                     tmp_ndx++;
+                }
+                else break;
+            }
+            if(tmp_ndx == 4) break;
 
-                    while(tmp_ndx != 4)
-                    {
-                        if(agg_psx_rec->counters[i + k] != psx_rec->counters[j])
-                        {
-                            tmp_val[tmp_ndx] = agg_psx_rec->counters[i + k];
-                            tmp_cnt[tmp_ndx] = agg_psx_rec->counters[i + k + 4];
-                            tmp_ndx++;
-                        }
-                        k++;
-                    }
-                    memcpy(&(agg_psx_rec->counters[i]), tmp_val, 4 * sizeof(int64_t));
-                    memcpy(&(agg_psx_rec->counters[i + 4]), tmp_cnt, 4 * sizeof(int64_t));
+            tmp_val[tmp_ndx] = psx_rec->counters[j];
+            tmp_cnt[tmp_ndx] = psx_rec->counters[j + 4];
+            tmp_ndx++;
+
+            while(tmp_ndx != 4)
+            {
+                if(agg_psx_rec->counters[i + k] != psx_rec->counters[j])
+                {
+                    tmp_val[tmp_ndx] = agg_psx_rec->counters[i + k];
+                    tmp_cnt[tmp_ndx] = agg_psx_rec->counters[i + k + 4];
+                    tmp_ndx++;
                 }
-                break;
-            case POSIX_STRIDE2_STRIDE:
-            case POSIX_STRIDE3_STRIDE:
-            case POSIX_STRIDE4_STRIDE:
-            case POSIX_STRIDE1_COUNT:
-            case POSIX_STRIDE2_COUNT:
-            case POSIX_STRIDE3_COUNT:
-            case POSIX_STRIDE4_COUNT:
-            case POSIX_ACCESS2_ACCESS:
-            case POSIX_ACCESS3_ACCESS:
-            case POSIX_ACCESS4_ACCESS:
-            case POSIX_ACCESS1_COUNT:
-            case POSIX_ACCESS2_COUNT:
-            case POSIX_ACCESS3_COUNT:
-            case POSIX_ACCESS4_COUNT:
-                /* these are set all at once with common counters above */
-                break;
-                /* intentionally do not include a default block; we want to
-                 * get a compile-time warning in this function when new
-                 * counters are added to the enumeration to make sure we
-                 * handle them all correctly.
-                 */
-#if 0
-            default:
-                agg_psx_rec->counters[i] = -1;
-                break;
-#endif
+                k++;
+            }
+            memcpy(&(agg_psx_rec->counters[i]), tmp_val, 4 * sizeof(int64_t));
+            memcpy(&(agg_psx_rec->counters[i + 4]), tmp_cnt, 4 * sizeof(int64_t));
         }
     }
 
-    for(i = 0; i < POSIX_F_NUM_INDICES; i++)
+    if(psx_rec->fcounters[POSIX_F_MAX_READ_TIME] >
+        agg_psx_rec->fcounters[POSIX_F_MAX_READ_TIME])
     {
-        switch(i)
-        {
-            case POSIX_F_READ_TIME:
-            case POSIX_F_WRITE_TIME:
-            case POSIX_F_META_TIME:
-                /* sum */
-                agg_psx_rec->fcounters[i] += psx_rec->fcounters[i];
-                break;
-            case POSIX_F_OPEN_START_TIMESTAMP:
-            case POSIX_F_READ_START_TIMESTAMP:
-            case POSIX_F_WRITE_START_TIMESTAMP:
-            case POSIX_F_CLOSE_START_TIMESTAMP:
-                /* minimum non-zero */
-                if((psx_rec->fcounters[i] > 0)  &&
-                    ((agg_psx_rec->fcounters[i] == 0) ||
-                    (psx_rec->fcounters[i] < agg_psx_rec->fcounters[i])))
-                {
-                    agg_psx_rec->fcounters[i] = psx_rec->fcounters[i];
-                }
-                break;
-            case POSIX_F_OPEN_END_TIMESTAMP:
-            case POSIX_F_READ_END_TIMESTAMP:
-            case POSIX_F_WRITE_END_TIMESTAMP:
-            case POSIX_F_CLOSE_END_TIMESTAMP:
-                /* maximum */
-                if(psx_rec->fcounters[i] > agg_psx_rec->fcounters[i])
-                {
-                    agg_psx_rec->fcounters[i] = psx_rec->fcounters[i];
-                }
-                break;
-            case POSIX_F_MAX_READ_TIME:
-                if(psx_rec->fcounters[i] > agg_psx_rec->fcounters[i])
-                {
-                    agg_psx_rec->fcounters[i] = psx_rec->fcounters[i];
-                    agg_psx_rec->counters[POSIX_MAX_READ_TIME_SIZE] =
-                        psx_rec->counters[POSIX_MAX_READ_TIME_SIZE];
-                }
-                break;
-            case POSIX_F_MAX_WRITE_TIME:
-                if(psx_rec->fcounters[i] > agg_psx_rec->fcounters[i])
-                {
-                    agg_psx_rec->fcounters[i] = psx_rec->fcounters[i];
-                    agg_psx_rec->counters[POSIX_MAX_WRITE_TIME_SIZE] =
-                        psx_rec->counters[POSIX_MAX_WRITE_TIME_SIZE];
-                }
-                break;
-            case POSIX_F_FASTEST_RANK_TIME:
+        agg_psx_rec->fcounters[POSIX_F_MAX_READ_TIME] =
+            psx_rec->fcounters[POSIX_F_MAX_READ_TIME];
+        agg_psx_rec->counters[POSIX_MAX_READ_TIME_SIZE] =
+            psx_rec->counters[POSIX_MAX_READ_TIME_SIZE];
+    }
+    if(psx_rec->fcounters[POSIX_F_MAX_WRITE_TIME] >
+        agg_psx_rec->fcounters[POSIX_F_MAX_WRITE_TIME])
+    {
+        agg_psx_rec->fcounters[POSIX_F_MAX_WRITE_TIME] =
+            psx_rec->fcounters[POSIX_F_MAX_WRITE_TIME];
+        agg_psx_rec->counters[POSIX_MAX_WRITE_TIME_SIZE] =
+            psx_rec->counters[POSIX_MAX_WRITE_TIME_SIZE];
+    }
+
+    if(!shared_file_flag)
+    {
+        /* The fastest and slowest counters are only valid under these
+         * conditions when aggregating records that all refer to the same
+         * file.
+         */
+        agg_psx_rec->counters[POSIX_FASTEST_RANK] = -1;
+        agg_psx_rec->counters[POSIX_FASTEST_RANK_BYTES] = -1;
+        agg_psx_rec->fcounters[POSIX_F_FASTEST_RANK_TIME] = 0.0;
+        agg_psx_rec->counters[POSIX_SLOWEST_RANK] = -1;
+        agg_psx_rec->counters[POSIX_SLOWEST_RANK_BYTES] = -1;
+        agg_psx_rec->fcounters[POSIX_F_SLOWEST_RANK_TIME] = 0.0;
+    }
+    else
+    {
+        if (init_flag ||
+            psx_fastest_time < agg_psx_rec->fcounters[POSIX_F_FASTEST_RANK_TIME]) {
+            /* The incoming record wins if a) this is the first
+             * record we are aggregating or b) it is the fastest
+             * record we have seen so far.
+             */
+            agg_psx_rec->counters[POSIX_FASTEST_RANK]
+                = psx_fastest_rank;
+            agg_psx_rec->counters[POSIX_FASTEST_RANK_BYTES]
+                = psx_fastest_bytes;
+            agg_psx_rec->fcounters[POSIX_F_FASTEST_RANK_TIME]
+                = psx_fastest_time;
+        }
+        if (init_flag ||
+            psx_slowest_time > agg_psx_rec->fcounters[POSIX_F_SLOWEST_RANK_TIME]) {
+            /* The incoming record wins if a) this is the first
+             * record we are aggregating or b) it is the slowest
+             * record we have seen so far.
+             */
+            agg_psx_rec->counters[POSIX_SLOWEST_RANK]
+                = psx_slowest_rank;
+            agg_psx_rec->counters[POSIX_SLOWEST_RANK_BYTES]
+                = psx_slowest_bytes;
+            agg_psx_rec->fcounters[POSIX_F_SLOWEST_RANK_TIME]
+                = psx_slowest_time;
+        }
+    }
 
-                if(!shared_file_flag)
-                {
-                    /* The fastest counters are only valid under these
-                     * conditions when aggregating records that all refer to
-                     * the same file.
-                     */
-                    agg_psx_rec->counters[POSIX_FASTEST_RANK] = -1;
-                    agg_psx_rec->counters[POSIX_FASTEST_RANK_BYTES] = -1;
-                    agg_psx_rec->fcounters[POSIX_F_FASTEST_RANK_TIME] = 0.0;
-                    break;
-                }
-                if (init_flag ||
-                    psx_fastest_time < agg_psx_rec->fcounters[POSIX_F_FASTEST_RANK_TIME]) {
-                    /* The incoming record wins if a) this is the first
-                     * record we are aggregating or b) it is the fastest
-                     * record we have seen so far.
-                     */
-                    agg_psx_rec->counters[POSIX_FASTEST_RANK]
-                        = psx_fastest_rank;
-                    agg_psx_rec->counters[POSIX_FASTEST_RANK_BYTES]
-                        = psx_fastest_bytes;
-                    agg_psx_rec->fcounters[POSIX_F_FASTEST_RANK_TIME]
-                        = psx_fastest_time;
-                }
-                break;
-            case POSIX_F_SLOWEST_RANK_TIME:
-                if(!shared_file_flag)
-                {
-                    /* The slowest counters are only valid under these
-                     * conditions when aggregating records that all refer to
-                     * the same file.
-                     */
-                    agg_psx_rec->counters[POSIX_SLOWEST_RANK] = -1;
-                    agg_psx_rec->counters[POSIX_SLOWEST_RANK_BYTES] = -1;
-                    agg_psx_rec->fcounters[POSIX_F_SLOWEST_RANK_TIME] = 0.0;
-                    break;
-                }
-                if (init_flag ||
-                    psx_slowest_time > agg_psx_rec->fcounters[POSIX_F_SLOWEST_RANK_TIME]) {
-                    /* The incoming record wins if a) this is the first
-                     * record we are aggregating or b) it is the slowest
-                     * record we have seen so far.
-                     */
-                    agg_psx_rec->counters[POSIX_SLOWEST_RANK]
-                        = psx_slowest_rank;
-                    agg_psx_rec->counters[POSIX_SLOWEST_RANK_BYTES]
-                        = psx_slowest_bytes;
-                    agg_psx_rec->fcounters[POSIX_F_SLOWEST_RANK_TIME]
-                        = psx_slowest_time;
-                }
-                break;
-            case POSIX_F_VARIANCE_RANK_TIME:
 #if 0
 /* NOTE: see comment at the top of this function about the var_* variables */
-                if(init_flag)
-                {
-                    var_time_p->n = 1;
-                    var_time_p->M = psx_time;
-                    var_time_p->S = 0;
-                }
-                else
-                {
-                    old_M = var_time_p->M;
+    if(init_flag)
+    {
+        var_time_p->n = 1;
+        var_time_p->M = psx_time;
+        var_time_p->S = 0;
+        var_bytes_p->n = 1;
+        var_bytes_p->M = psx_bytes;
+        var_bytes_p->S = 0;
+    }
+    else
+    {
+        old_M = var_time_p->M;
 
-                    var_time_p->n++;
-                    var_time_p->M += (psx_time - var_time_p->M) / var_time_p->n;
-                    var_time_p->S += (psx_time - var_time_p->M) * (psx_time - old_M);
+        var_time_p->n++;
+        var_time_p->M += (psx_time - var_time_p->M) / var_time_p->n;
+        var_time_p->S += (psx_time - var_time_p->M) * (psx_time - old_M);
 
-                    agg_psx_rec->fcounters[POSIX_F_VARIANCE_RANK_TIME] =
-                        var_time_p->S / var_time_p->n;
-                }
-#else
-                agg_psx_rec->fcounters[i] = 0;
-#endif
-                break;
-            case POSIX_F_VARIANCE_RANK_BYTES:
-#if 0
-/* NOTE: see comment at the top of this function about the var_* variables */
-                if(init_flag)
-                {
-                    var_bytes_p->n = 1;
-                    var_bytes_p->M = psx_bytes;
-                    var_bytes_p->S = 0;
-                }
-                else
-                {
-                    old_M = var_bytes_p->M;
+        agg_psx_rec->fcounters[POSIX_F_VARIANCE_RANK_TIME] =
+            var_time_p->S / var_time_p->n;
 
-                    var_bytes_p->n++;
-                    var_bytes_p->M += (psx_bytes - var_bytes_p->M) / var_bytes_p->n;
-                    var_bytes_p->S += (psx_bytes - var_bytes_p->M) * (psx_bytes - old_M);
+        old_M = var_bytes_p->M;
 
-                    agg_psx_rec->fcounters[POSIX_F_VARIANCE_RANK_BYTES] =
-                        var_bytes_p->S / var_bytes_p->n;
-                }
+        var_bytes_p->n++;
+        var_bytes_p->M += (psx_bytes - var_bytes_p->M) / var_bytes_p->n;
+        var_bytes_p->S += (psx_bytes - var_bytes_p->M) * (psx_bytes - old_M);
+
+        agg_psx_rec->fcounters[POSIX_F_VARIANCE_RANK_BYTES] =
+            var_bytes_p->S / var_bytes_p->n;
+    }
 #else
-                agg_psx_rec->fcounters[i] = 0;
+    agg_psx_rec->fcounters[POSIX_F_VARIANCE_RANK_TIME] = 0;
+    agg_psx_rec->fcounters[POSIX_F_VARIANCE_RANK_BYTES] = 0;
 #endif
-                break;
-                /* intentionally do not include a default block; we want to
-                 * get a compile-time warning in this function when new
-                 * counters are added to the enumeration to make sure we
-                 * handle them all correctly.
-                 */
-#if 0
-            default:
-                agg_psx_rec->fcounters[i] = -1;
-                break;
-#endif
-        }
+
+    return;
+}
+
+static void darshan_log_agg_posix_files_batch(void *rec_buf, int count,
+    void *agg_rec, int init_flag)
+{
+    struct darshan_posix_file *psx_recs = (struct darshan_posix_file *)rec_buf;
+    struct darshan_posix_file *agg_psx_rec = (struct darshan_posix_file *)agg_rec;
+    int i;
+
+    for(i = 0; i < count; i++)
+    {
+        darshan_log_agg_counters(agg_psx_rec->counters,
+            psx_recs[i].counters, posix_agg_runs,
+            sizeof(posix_agg_runs) / sizeof(posix_agg_runs[0]));
+        darshan_log_agg_fcounters(agg_psx_rec->fcounters,
+            psx_recs[i].fcounters, posix_agg_fruns,
+            sizeof(posix_agg_fruns) / sizeof(posix_agg_fruns[0]));
+        darshan_log_agg_posix_custom(&psx_recs[i], agg_rec, init_flag && i == 0);
     }
 
     return;
 }
 
+static void darshan_log_agg_posix_files(void *rec, void *agg_rec, int init_flag)
+{
+    darshan_log_agg_posix_files_batch(rec, 1, agg_rec, init_flag);
+
+    return;
+}
+
 /*
  * Local variables:
  *  c-indent-level: 4
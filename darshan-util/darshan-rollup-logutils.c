@@ -0,0 +1,310 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "darshan-util-config.h"
+#endif
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "darshan-logutils.h"
+
+/* integer counter name strings for the ROLLUP module */
+#define X(a) #a,
+char *rollup_counter_names[] = {
+    ROLLUP_COUNTERS
+};
+
+/* floating point counter name strings for the ROLLUP module */
+char *rollup_f_counter_names[] = {
+    ROLLUP_F_COUNTERS
+};
+#undef X
+
+/* prototypes for each of the ROLLUP module's logutil functions */
+static int darshan_log_get_rollup_record(darshan_fd fd, void** rollup_buf_p);
+static int darshan_log_put_rollup_record(darshan_fd fd, void* rollup_buf);
+static void darshan_log_print_rollup_record(void *file_rec,
+    char *file_name, char *mnt_pt, char *fs_type);
+static void darshan_log_print_rollup_description(int ver);
+static void darshan_log_print_rollup_record_diff(void *file_rec1, char *file_name1,
+    void *file_rec2, char *file_name2);
+static void darshan_log_agg_rollup_records(void *rec, void *agg_rec, int init_flag);
+
+/* structure storing each function needed for implementing the darshan
+ * logutil interface. these functions are used for reading, writing, and
+ * printing module data in a consistent manner.
+ */
+struct darshan_mod_logutil_funcs rollup_logutils =
+{
+    .log_get_record = &darshan_log_get_rollup_record,
+    .log_put_record = &darshan_log_put_rollup_record,
+    .log_print_record = &darshan_log_print_rollup_record,
+    .log_print_description = &darshan_log_print_rollup_description,
+    .log_print_diff = &darshan_log_print_rollup_record_diff,
+    .log_agg_records = &darshan_log_agg_rollup_records
+};
+
+/* retrieve a ROLLUP record from log file descriptor 'fd', storing the
+ * data in the buffer address pointed to by 'rollup_buf_p'. Return 1 on
+ * successful record read, 0 on no more data, and -1 on error.
+ */
+static int darshan_log_get_rollup_record(darshan_fd fd, void** rollup_buf_p)
+{
+    struct darshan_rollup_record *rec = *((struct darshan_rollup_record **)rollup_buf_p);
+    int ret;
+
+    if(fd->mod_map[DARSHAN_ROLLUP_MOD].len == 0)
+        return(0);
+
+    if(fd->mod_ver[DARSHAN_ROLLUP_MOD] == 0 ||
+        fd->mod_ver[DARSHAN_ROLLUP_MOD] > DARSHAN_ROLLUP_VER)
+    {
+        fprintf(stderr, "Error: Invalid ROLLUP module version number (got %d)\n",
+            fd->mod_ver[DARSHAN_ROLLUP_MOD]);
+        return(-1);
+    }
+
+    if(*rollup_buf_p == NULL)
+    {
+        rec = malloc(sizeof(*rec));
+        if(!rec)
+            return(-1);
+    }
+
+    /* read a ROLLUP module record from the darshan log file */
+    ret = darshan_log_get_mod(fd, DARSHAN_ROLLUP_MOD, rec,
+        sizeof(struct darshan_rollup_record));
+
+    if(*rollup_buf_p == NULL)
+    {
+        if(ret == sizeof(struct darshan_rollup_record))
+            *rollup_buf_p = rec;
+        else
+            free(rec);
+    }
+
+    if(ret < 0)
+        return(-1);
+    else if(ret < sizeof(struct darshan_rollup_record))
+        return(0);
+    else
+    {
+        /* if the read was successful, do any necessary byte-swapping */
+        if(fd->swap_flag)
+        {
+            /* records consist only of 64-bit fields */
+            darshan_log_bswap64_array(rec,
+                sizeof(struct darshan_rollup_record) / sizeof(int64_t));
+        }
+
+        return(1);
+    }
+}
+
+/* write the ROLLUP record stored in 'rollup_buf' to log file descriptor 'fd'.
+ * Return 0 on success, -1 on failure
+ */
+static int darshan_log_put_rollup_record(darshan_fd fd, void* rollup_buf)
+{
+    struct darshan_rollup_record *rec = (struct darshan_rollup_record *)rollup_buf;
+    int ret;
+
+    /* append ROLLUP record to darshan log file */
+    ret = darshan_log_put_mod(fd, DARSHAN_ROLLUP_MOD, rec,
+        sizeof(struct darshan_rollup_record), DARSHAN_ROLLUP_VER);
+    if(ret < 0)
+        return(-1);
+
+    return(0);
+}
+
+/* print all I/O data record statistics for the given ROLLUP record */
+static void darshan_log_print_rollup_record(void *file_rec, char *file_name,
+    char *mnt_pt, char *fs_type)
+{
+    int i;
+    struct darshan_rollup_record *rollup_rec =
+        (struct darshan_rollup_record *)file_rec;
+
+    /* print each of the integer and floating point counters for the ROLLUP module */
+    for(i=0; i<ROLLUP_NUM_INDICES; i++)
+    {
+        /* macro defined in darshan-logutils.h */
+        DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_ROLLUP_MOD],
+            rollup_rec->base_rec.rank, rollup_rec->base_rec.id,
+            rollup_counter_names[i], rollup_rec->counters[i],
+            file_name, mnt_pt, fs_type);
+    }
+
+    for(i=0; i<ROLLUP_F_NUM_INDICES; i++)
+    {
+        /* macro defined in darshan-logutils.h */
+        DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_ROLLUP_MOD],
+            rollup_rec->base_rec.rank, rollup_rec->base_rec.id,
+            rollup_f_counter_names[i], rollup_rec->fcounters[i],
+            file_name, mnt_pt, fs_type);
+    }
+
+    return;
+}
+
+/* print out a description of the ROLLUP module record fields */
+static void darshan_log_print_rollup_description(int ver)
+{
+    printf("\n# description of ROLLUP counters:\n");
+    printf("#   once DARSHAN_DIR_ROLLUP_THRESHOLD files of a directory have records of\n");
+    printf("#   their own, the records of any further files of the directory are\n");
+    printf("#   collapsed into one record per module, named by the directory followed\n");
+    printf("#   by \"/*\".  the ROLLUP record of the same name describes those files.\n");
+    printf("#   ROLLUP_THRESHOLD: threshold in effect when the files were collapsed.\n");
+    printf("#   ROLLUP_FILES: estimated number of distinct files collapsed.\n");
+    printf("#   ROLLUP_CLOSES: POSIX closes of collapsed files.\n");
+    printf("#   ROLLUP_CLOSE_BYTES, ROLLUP_MAX_SIZE: total and largest file size at close.\n");
+    printf("#   ROLLUP_SIZE_*: histogram of file sizes at close.\n");
+    printf("#   ROLLUP_F_START_TIMESTAMP: timestamp of the first file collapsed.\n");
+    printf("#   ROLLUP_F_END_TIMESTAMP: timestamp of the last file collapsed.\n");
+
+    return;
+}
+
+/* print a diff of two ROLLUP records (with the same record id) */
+static void darshan_log_print_rollup_record_diff(void *file_rec1, char *file_name1,
+    void *file_rec2, char *file_name2)
+{
+    struct darshan_rollup_record *file1 = (struct darshan_rollup_record *)file_rec1;
+    struct darshan_rollup_record *file2 = (struct darshan_rollup_record *)file_rec2;
+    int i;
+
+    /* NOTE: we assume that both input records are the same module format version */
+
+    for(i=0; i<ROLLUP_NUM_INDICES; i++)
+    {
+        if(!file2)
+        {
+            printf("- ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_ROLLUP_MOD],
+                file1->base_rec.rank, file1->base_rec.id, rollup_counter_names[i],
+                file1->counters[i], file_name1, "", "");
+
+        }
+        else if(!file1)
+        {
+            printf("+ ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_ROLLUP_MOD],
+                file2->base_rec.rank, file2->base_rec.id, rollup_counter_names[i],
+                file2->counters[i], file_name2, "", "");
+        }
+        else if(file1->counters[i] != file2->counters[i])
+        {
+            printf("- ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_ROLLUP_MOD],
+                file1->base_rec.rank, file1->base_rec.id, rollup_counter_names[i],
+                file1->counters[i], file_name1, "", "");
+            printf("+ ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_ROLLUP_MOD],
+                file2->base_rec.rank, file2->base_rec.id, rollup_counter_names[i],
+                file2->counters[i], file_name2, "", "");
+        }
+    }
+
+    for(i=0; i<ROLLUP_F_NUM_INDICES; i++)
+    {
+        if(!file2)
+        {
+            printf("- ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_ROLLUP_MOD],
+                file1->base_rec.rank, file1->base_rec.id, rollup_f_counter_names[i],
+                file1->fcounters[i], file_name1, "", "");
+
+        }
+        else if(!file1)
+        {
+            printf("+ ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_ROLLUP_MOD],
+                file2->base_rec.rank, file2->base_rec.id, rollup_f_counter_names[i],
+                file2->fcounters[i], file_name2, "", "");
+        }
+        else if(file1->fcounters[i] != file2->fcounters[i])
+        {
+            printf("- ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_ROLLUP_MOD],
+                file1->base_rec.rank, file1->base_rec.id, rollup_f_counter_names[i],
+                file1->fcounters[i], file_name1, "", "");
+            printf("+ ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_ROLLUP_MOD],
+                file2->base_rec.rank, file2->base_rec.id, rollup_f_counter_names[i],
+                file2->fcounters[i], file_name2, "", "");
+        }
+    }
+
+    return;
+}
+
+/* aggregate the input ROLLUP record 'rec'  into the output record 'agg_rec' */
+static void darshan_log_agg_rollup_records(void *rec, void *agg_rec, int init_flag)
+{
+    struct darshan_rollup_record *rollup_rec = (struct darshan_rollup_record *)rec;
+    struct darshan_rollup_record *agg_rollup_rec = (struct darshan_rollup_record *)agg_rec;
+    int i;
+
+    for(i = 0; i < ROLLUP_NUM_INDICES; i++)
+    {
+        switch(i)
+        {
+            case ROLLUP_THRESHOLD:
+            case ROLLUP_MAX_SIZE:
+                /* max */
+                if(rollup_rec->counters[i] > agg_rollup_rec->counters[i])
+                    agg_rollup_rec->counters[i] = rollup_rec->counters[i];
+                break;
+            default:
+                /* sum */
+                agg_rollup_rec->counters[i] += rollup_rec->counters[i];
+                break;
+        }
+    }
+
+    for(i = 0; i < ROLLUP_F_NUM_INDICES; i++)
+    {
+        switch(i)
+        {
+            case ROLLUP_F_START_TIMESTAMP:
+                /* min non-zero */
+                if((rollup_rec->fcounters[i] > 0) &&
+                    (init_flag || agg_rollup_rec->fcounters[i] == 0 ||
+                    rollup_rec->fcounters[i] < agg_rollup_rec->fcounters[i]))
+                    agg_rollup_rec->fcounters[i] = rollup_rec->fcounters[i];
+                break;
+            case ROLLUP_F_END_TIMESTAMP:
+                /* max */
+                if(rollup_rec->fcounters[i] > agg_rollup_rec->fcounters[i])
+                    agg_rollup_rec->fcounters[i] = rollup_rec->fcounters[i];
+                break;
+        }
+    }
+
+    return;
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
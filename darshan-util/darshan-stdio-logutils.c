@@ -47,7 +47,10 @@ static void darshan_log_print_stdio_description(int ver);
 static void darshan_log_print_stdio_record_diff(void *file_rec1, char *file_name1,
     void *file_rec2, char *file_name2);
 static void darshan_log_agg_stdio_records(void *rec, void *agg_rec, int init_flag);
+static void darshan_log_agg_stdio_records_batch(void *rec_buf, int count,
+    void *agg_rec, int init_flag);
 static int darshan_log_sizeof_stdio_record(void* stdio_buf_p);
+static void darshan_log_swap_stdio_record(void *stdio_buf_p);
 static int darshan_log_record_metrics_stdio_record(void*  stdio_buf_p,
                                                  uint64_t* rec_id,
                                                  int64_t* r_bytes,
@@ -71,8 +74,10 @@ struct darshan_mod_logutil_funcs stdio_logutils =
     .log_print_description = &darshan_log_print_stdio_description,
     .log_print_diff = &darshan_log_print_stdio_record_diff,
     .log_agg_records = &darshan_log_agg_stdio_records,
+    .log_agg_records_batch = &darshan_log_agg_stdio_records_batch,
     .log_sizeof_record = &darshan_log_sizeof_stdio_record,
-    .log_record_metrics = &darshan_log_record_metrics_stdio_record
+    .log_record_metrics = &darshan_log_record_metrics_stdio_record,
+    .log_swap_record = &darshan_log_swap_stdio_record
 };
 
 static int darshan_log_sizeof_stdio_record(void* stdio_buf_p)
@@ -81,6 +86,16 @@ static int darshan_log_sizeof_stdio_record(void* stdio_buf_p)
     return(sizeof(struct darshan_stdio_file));
 }
 
+/* byte swap a STDIO record of the current log format version in place */
+static void darshan_log_swap_stdio_record(void *stdio_buf_p)
+{
+    /* records consist only of 64-bit fields, so swap them in one pass */
+    darshan_log_bswap64_array(stdio_buf_p,
+        sizeof(struct darshan_stdio_file) / sizeof(int64_t));
+
+    return;
+}
+
 static int darshan_log_record_metrics_stdio_record(void*  stdio_buf_p,
                                                  uint64_t* rec_id,
                                                  int64_t* r_bytes,
@@ -212,7 +227,9 @@ exit:
     else
     {
         /* if the read was successful, do any necessary byte-swapping */
-        if(fd->swap_flag)
+        if(fd->swap_flag && fd->mod_ver[DARSHAN_STDIO_MOD] == DARSHAN_STDIO_VER)
+            darshan_log_swap_stdio_record(file);
+        else if(fd->swap_flag)
         {
             DARSHAN_BSWAP64(&file->base_rec.id);
             DARSHAN_BSWAP64(&file->base_rec.rank);
@@ -390,11 +407,29 @@ struct var_t
     double S;
 };
 
-static void darshan_log_agg_stdio_records(void *rec, void *agg_rec, int init_flag)
+/* how the STDIO counters are aggregated, as runs of consecutive counters;
+ * counters not covered here are handled by darshan_log_agg_stdio_custom()
+ */
+static const struct darshan_agg_run stdio_agg_runs[] =
+{
+    {STDIO_OPENS, STDIO_BYTES_READ, DARSHAN_AGG_SUM},
+    {STDIO_MAX_BYTE_READ, STDIO_MAX_BYTE_WRITTEN, DARSHAN_AGG_MAX},
+};
+
+static const struct darshan_agg_run stdio_agg_fruns[] =
+{
+    {STDIO_F_META_TIME, STDIO_F_READ_TIME, DARSHAN_AGG_SUM},
+    {STDIO_F_OPEN_START_TIMESTAMP, STDIO_F_READ_START_TIMESTAMP, DARSHAN_AGG_MIN_NONZERO},
+    {STDIO_F_OPEN_END_TIMESTAMP, STDIO_F_READ_END_TIMESTAMP, DARSHAN_AGG_MAX},
+};
+
+/* aggregate the counters of a record that are not covered by the tables
+ * above
+ */
+static void darshan_log_agg_stdio_custom(void *rec, void *agg_rec, int init_flag)
 {
     struct darshan_stdio_file *stdio_rec = (struct darshan_stdio_file *)rec;
     struct darshan_stdio_file *agg_stdio_rec = (struct darshan_stdio_file *)agg_rec;
-    int i;
     int64_t stdio_fastest_rank, stdio_slowest_rank,
         stdio_fastest_bytes, stdio_slowest_bytes;
     double stdio_fastest_time, stdio_slowest_time;
@@ -468,197 +503,116 @@ static void darshan_log_agg_stdio_records(void *rec, void *agg_rec, int init_fla
     if(agg_stdio_rec->base_rec.rank != stdio_rec->base_rec.rank)
         agg_stdio_rec->base_rec.rank = -1;
 
-    for(i = 0; i < STDIO_NUM_INDICES; i++)
+    if(!shared_file_flag)
     {
-        switch(i)
-        {
-            case STDIO_OPENS:
-            case STDIO_FDOPENS:
-            case STDIO_READS:
-            case STDIO_WRITES:
-            case STDIO_SEEKS:
-            case STDIO_FLUSHES:
-            case STDIO_BYTES_WRITTEN:
-            case STDIO_BYTES_READ:
-                /* sum */
-                agg_stdio_rec->counters[i] += stdio_rec->counters[i];
-                break;
-            case STDIO_MAX_BYTE_READ:
-            case STDIO_MAX_BYTE_WRITTEN:
-                /* max */
-                if(stdio_rec->counters[i] > agg_stdio_rec->counters[i])
-                {
-                    agg_stdio_rec->counters[i] = stdio_rec->counters[i];
-                }
-                break;
-            case STDIO_FASTEST_RANK:
-            case STDIO_FASTEST_RANK_BYTES:
-            case STDIO_SLOWEST_RANK:
-            case STDIO_SLOWEST_RANK_BYTES:
-                /* these are set with the FP counters */
-                break;
-            /* intentionally do not include a default block; we want to
-             * get a compile-time warning in this function when new
-             * counters are added to the enumeration to make sure we
-             * handle them all correctly.
+        /* The fastest and slowest counters are only valid under these
+         * conditions when aggregating records that all refer to the same
+         * file.
+         */
+        agg_stdio_rec->counters[STDIO_FASTEST_RANK] = -1;
+        agg_stdio_rec->counters[STDIO_FASTEST_RANK_BYTES] = -1;
+        agg_stdio_rec->fcounters[STDIO_F_FASTEST_RANK_TIME] = 0.0;
+        agg_stdio_rec->counters[STDIO_SLOWEST_RANK] = -1;
+        agg_stdio_rec->counters[STDIO_SLOWEST_RANK_BYTES] = -1;
+        agg_stdio_rec->fcounters[STDIO_F_SLOWEST_RANK_TIME] = 0.0;
+    }
+    else
+    {
+        if (init_flag ||
+            stdio_fastest_time < agg_stdio_rec->fcounters[STDIO_F_FASTEST_RANK_TIME]) {
+            /* The incoming record wins if a) this is the first
+             * record we are aggregating or b) it is the fastest
+             * record we have seen so far.
              */
-#if 0
-            default:
-                agg_stdio_rec->counters[i] = -1;
-                break;
-#endif
+            agg_stdio_rec->counters[STDIO_FASTEST_RANK]
+                = stdio_fastest_rank;
+            agg_stdio_rec->counters[STDIO_FASTEST_RANK_BYTES]
+                = stdio_fastest_bytes;
+            agg_stdio_rec->fcounters[STDIO_F_FASTEST_RANK_TIME]
+                = stdio_fastest_time;
+        }
+        if (init_flag ||
+            stdio_slowest_time > agg_stdio_rec->fcounters[STDIO_F_SLOWEST_RANK_TIME]) {
+            /* The incoming record wins if a) this is the first
+             * record we are aggregating or b) it is the slowest
+             * record we have seen so far.
+             */
+            agg_stdio_rec->counters[STDIO_SLOWEST_RANK]
+                = stdio_slowest_rank;
+            agg_stdio_rec->counters[STDIO_SLOWEST_RANK_BYTES]
+                = stdio_slowest_bytes;
+            agg_stdio_rec->fcounters[STDIO_F_SLOWEST_RANK_TIME]
+                = stdio_slowest_time;
         }
     }
 
-    for(i = 0; i < STDIO_F_NUM_INDICES; i++)
-    {
-        switch(i)
-        {
-            case STDIO_F_META_TIME:
-            case STDIO_F_WRITE_TIME:
-            case STDIO_F_READ_TIME:
-                /* sum */
-                agg_stdio_rec->fcounters[i] += stdio_rec->fcounters[i];
-                break;
-            case STDIO_F_OPEN_START_TIMESTAMP:
-            case STDIO_F_CLOSE_START_TIMESTAMP:
-            case STDIO_F_WRITE_START_TIMESTAMP:
-            case STDIO_F_READ_START_TIMESTAMP:
-                /* minimum non-zero */
-                if((stdio_rec->fcounters[i] > 0)  &&
-                    ((agg_stdio_rec->fcounters[i] == 0) ||
-                    (stdio_rec->fcounters[i] < agg_stdio_rec->fcounters[i])))
-                {
-                    agg_stdio_rec->fcounters[i] = stdio_rec->fcounters[i];
-                }
-                break;
-            case STDIO_F_OPEN_END_TIMESTAMP:
-            case STDIO_F_CLOSE_END_TIMESTAMP:
-            case STDIO_F_WRITE_END_TIMESTAMP:
-            case STDIO_F_READ_END_TIMESTAMP:
-                /* maximum */
-                if(stdio_rec->fcounters[i] > agg_stdio_rec->fcounters[i])
-                {
-                    agg_stdio_rec->fcounters[i] = stdio_rec->fcounters[i];
-                }
-                break;
-            case STDIO_F_FASTEST_RANK_TIME:
-                if(!shared_file_flag)
-                {
-                    /* The fastest counters are only valid under these
-                     * conditions when aggregating records that all refer to
-                     * the same file.
-                     */
-                    agg_stdio_rec->counters[STDIO_FASTEST_RANK] = -1;
-                    agg_stdio_rec->counters[STDIO_FASTEST_RANK_BYTES] = -1;
-                    agg_stdio_rec->fcounters[STDIO_F_FASTEST_RANK_TIME] = 0.0;
-                    break;
-                }
-                if (init_flag ||
-                    stdio_fastest_time < agg_stdio_rec->fcounters[STDIO_F_FASTEST_RANK_TIME]) {
-                    /* The incoming record wins if a) this is the first
-                     * record we are aggregating or b) it is the fastest
-                     * record we have seen so far.
-                     */
-                    agg_stdio_rec->counters[STDIO_FASTEST_RANK]
-                        = stdio_fastest_rank;
-                    agg_stdio_rec->counters[STDIO_FASTEST_RANK_BYTES]
-                        = stdio_fastest_bytes;
-                    agg_stdio_rec->fcounters[STDIO_F_FASTEST_RANK_TIME]
-                        = stdio_fastest_time;
-                }
-                break;
-            case STDIO_F_SLOWEST_RANK_TIME:
-                if(!shared_file_flag)
-                {
-                    /* The slowest counters are only valid under these
-                     * conditions when aggregating records that all refer to
-                     * the same file.
-                     */
-                    agg_stdio_rec->counters[STDIO_SLOWEST_RANK] = -1;
-                    agg_stdio_rec->counters[STDIO_SLOWEST_RANK_BYTES] = -1;
-                    agg_stdio_rec->fcounters[STDIO_F_SLOWEST_RANK_TIME] = 0.0;
-                    break;
-                }
-                if (init_flag ||
-                    stdio_slowest_time > agg_stdio_rec->fcounters[STDIO_F_SLOWEST_RANK_TIME]) {
-                    /* The incoming record wins if a) this is the first
-                     * record we are aggregating or b) it is the slowest
-                     * record we have seen so far.
-                     */
-                    agg_stdio_rec->counters[STDIO_SLOWEST_RANK]
-                        = stdio_slowest_rank;
-                    agg_stdio_rec->counters[STDIO_SLOWEST_RANK_BYTES]
-                        = stdio_slowest_bytes;
-                    agg_stdio_rec->fcounters[STDIO_F_SLOWEST_RANK_TIME]
-                        = stdio_slowest_time;
-                }
-                break;
-
-            case STDIO_F_VARIANCE_RANK_TIME:
-#if 0
-/* NOTE: see comment at the top of this function about the var_* variables */
-                if(init_flag)
-                {
-                    var_time_p->n = 1;
-                    var_time_p->M = stdio_time;
-                    var_time_p->S = 0;
-                }
-                else
-                {
-                    old_M = var_time_p->M;
-
-                    var_time_p->n++;
-                    var_time_p->M += (stdio_time - var_time_p->M) / var_time_p->n;
-                    var_time_p->S += (stdio_time - var_time_p->M) * (stdio_time - old_M);
-
-                    agg_stdio_rec->fcounters[STDIO_F_VARIANCE_RANK_TIME] =
-                        var_time_p->S / var_time_p->n;
-                }
-#else
-                agg_stdio_rec->fcounters[i] = 0;
-#endif
-                break;
-            case STDIO_F_VARIANCE_RANK_BYTES:
 #if 0
 /* NOTE: see comment at the top of this function about the var_* variables */
-                if(init_flag)
-                {
-                    var_bytes_p->n = 1;
-                    var_bytes_p->M = stdio_bytes;
-                    var_bytes_p->S = 0;
-                }
-                else
-                {
-                    old_M = var_bytes_p->M;
-
-                    var_bytes_p->n++;
-                    var_bytes_p->M += (stdio_bytes - var_bytes_p->M) / var_bytes_p->n;
-                    var_bytes_p->S += (stdio_bytes - var_bytes_p->M) * (stdio_bytes - old_M);
-
-                    agg_stdio_rec->fcounters[STDIO_F_VARIANCE_RANK_BYTES] =
-                        var_bytes_p->S / var_bytes_p->n;
-                }
+    if(init_flag)
+    {
+        var_time_p->n = 1;
+        var_time_p->M = stdio_time;
+        var_time_p->S = 0;
+        var_bytes_p->n = 1;
+        var_bytes_p->M = stdio_bytes;
+        var_bytes_p->S = 0;
+    }
+    else
+    {
+        old_M = var_time_p->M;
+
+        var_time_p->n++;
+        var_time_p->M += (stdio_time - var_time_p->M) / var_time_p->n;
+        var_time_p->S += (stdio_time - var_time_p->M) * (stdio_time - old_M);
+
+        agg_stdio_rec->fcounters[STDIO_F_VARIANCE_RANK_TIME] =
+            var_time_p->S / var_time_p->n;
+
+        old_M = var_bytes_p->M;
+
+        var_bytes_p->n++;
+        var_bytes_p->M += (stdio_bytes - var_bytes_p->M) / var_bytes_p->n;
+        var_bytes_p->S += (stdio_bytes - var_bytes_p->M) * (stdio_bytes - old_M);
+
+        agg_stdio_rec->fcounters[STDIO_F_VARIANCE_RANK_BYTES] =
+            var_bytes_p->S / var_bytes_p->n;
+    }
 #else
-                agg_stdio_rec->fcounters[i] = 0;
+    agg_stdio_rec->fcounters[STDIO_F_VARIANCE_RANK_TIME] = 0;
+    agg_stdio_rec->fcounters[STDIO_F_VARIANCE_RANK_BYTES] = 0;
 #endif
-                break;
-            /* intentionally do not include a default block; we want to
-             * get a compile-time warning in this function when new
-             * counters are added to the enumeration to make sure we
-             * handle them all correctly.
-             */
-#if 0
-            default:
-                agg_stdio_rec->fcounters[i] = -1;
-                break;
-#endif
-        }
+
+    return;
+}
+
+static void darshan_log_agg_stdio_records_batch(void *rec_buf, int count,
+    void *agg_rec, int init_flag)
+{
+    struct darshan_stdio_file *stdio_recs = (struct darshan_stdio_file *)rec_buf;
+    struct darshan_stdio_file *agg_stdio_rec = (struct darshan_stdio_file *)agg_rec;
+    int i;
+
+    for(i = 0; i < count; i++)
+    {
+        darshan_log_agg_counters(agg_stdio_rec->counters,
+            stdio_recs[i].counters, stdio_agg_runs,
+            sizeof(stdio_agg_runs) / sizeof(stdio_agg_runs[0]));
+        darshan_log_agg_fcounters(agg_stdio_rec->fcounters,
+            stdio_recs[i].fcounters, stdio_agg_fruns,
+            sizeof(stdio_agg_fruns) / sizeof(stdio_agg_fruns[0]));
+        darshan_log_agg_stdio_custom(&stdio_recs[i], agg_rec, init_flag && i == 0);
     }
 
     return;
 }
 
+static void darshan_log_agg_stdio_records(void *rec, void *agg_rec, int init_flag)
+{
+    darshan_log_agg_stdio_records_batch(rec, 1, agg_rec, init_flag);
+
+    return;
+}
+
 /*
  * Local variables:
  *  c-indent-level: 4
@@ -0,0 +1,334 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "darshan-util-config.h"
+#endif
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <inttypes.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "darshan-logutils.h"
+
+/* integer counter name strings for the TIMESERIES module */
+#define X(a) #a,
+char *timeseries_counter_names[] = {
+    TIMESERIES_COUNTERS
+};
+
+/* floating point counter name strings for the TIMESERIES module */
+char *timeseries_f_counter_names[] = {
+    TIMESERIES_F_COUNTERS
+};
+#undef X
+
+/* prototypes for each of the TIMESERIES module's logutil functions */
+static int darshan_log_get_timeseries_record(darshan_fd fd, void** timeseries_buf_p);
+static int darshan_log_put_timeseries_record(darshan_fd fd, void* timeseries_buf);
+static void darshan_log_print_timeseries_record(void *file_rec,
+    char *file_name, char *mnt_pt, char *fs_type);
+static void darshan_log_print_timeseries_description(int ver);
+static void darshan_log_print_timeseries_record_diff(void *file_rec1, char *file_name1,
+    void *file_rec2, char *file_name2);
+static void darshan_log_agg_timeseries_records(void *rec, void *agg_rec, int init_flag);
+
+/* structure storing each function needed for implementing the darshan
+ * logutil interface. these functions are used for reading, writing, and
+ * printing module data in a consistent manner.
+ */
+struct darshan_mod_logutil_funcs timeseries_logutils =
+{
+    .log_get_record = &darshan_log_get_timeseries_record,
+    .log_put_record = &darshan_log_put_timeseries_record,
+    .log_print_record = &darshan_log_print_timeseries_record,
+    .log_print_description = &darshan_log_print_timeseries_description,
+    .log_print_diff = &darshan_log_print_timeseries_record_diff,
+    .log_agg_records = &darshan_log_agg_timeseries_records
+};
+
+/* retrieve a TIMESERIES record from log file descriptor 'fd', storing the
+ * data in the buffer address pointed to by 'timeseries_buf_p'. Return 1 on
+ * successful record read, 0 on no more data, and -1 on error.
+ */
+static int darshan_log_get_timeseries_record(darshan_fd fd, void** timeseries_buf_p)
+{
+    struct darshan_timeseries_record *rec = *((struct darshan_timeseries_record **)timeseries_buf_p);
+    int ret;
+
+    if(fd->mod_map[DARSHAN_TIMESERIES_MOD].len == 0)
+        return(0);
+
+    if(fd->mod_ver[DARSHAN_TIMESERIES_MOD] == 0 ||
+        fd->mod_ver[DARSHAN_TIMESERIES_MOD] > DARSHAN_TIMESERIES_VER)
+    {
+        fprintf(stderr, "Error: Invalid TIMESERIES module version number (got %d)\n",
+            fd->mod_ver[DARSHAN_TIMESERIES_MOD]);
+        return(-1);
+    }
+
+    if(*timeseries_buf_p == NULL)
+    {
+        rec = malloc(sizeof(*rec));
+        if(!rec)
+            return(-1);
+    }
+
+    /* read a TIMESERIES module record from the darshan log file */
+    ret = darshan_log_get_mod(fd, DARSHAN_TIMESERIES_MOD, rec,
+        sizeof(struct darshan_timeseries_record));
+
+    if(*timeseries_buf_p == NULL)
+    {
+        if(ret == sizeof(struct darshan_timeseries_record))
+            *timeseries_buf_p = rec;
+        else
+            free(rec);
+    }
+
+    if(ret < 0)
+        return(-1);
+    else if(ret < sizeof(struct darshan_timeseries_record))
+        return(0);
+    else
+    {
+        /* if the read was successful, do any necessary byte-swapping */
+        if(fd->swap_flag)
+        {
+            /* records consist only of 64-bit fields */
+            darshan_log_bswap64_array(rec,
+                sizeof(struct darshan_timeseries_record) / sizeof(int64_t));
+        }
+
+        return(1);
+    }
+}
+
+/* write the TIMESERIES record stored in 'timeseries_buf' to log file descriptor 'fd'.
+ * Return 0 on success, -1 on failure
+ */
+static int darshan_log_put_timeseries_record(darshan_fd fd, void* timeseries_buf)
+{
+    struct darshan_timeseries_record *rec = (struct darshan_timeseries_record *)timeseries_buf;
+    int ret;
+
+    /* append TIMESERIES record to darshan log file */
+    ret = darshan_log_put_mod(fd, DARSHAN_TIMESERIES_MOD, rec,
+        sizeof(struct darshan_timeseries_record), DARSHAN_TIMESERIES_VER);
+    if(ret < 0)
+        return(-1);
+
+    return(0);
+}
+
+/* print all I/O data record statistics for the given TIMESERIES record */
+static void darshan_log_print_timeseries_record(void *file_rec, char *file_name,
+    char *mnt_pt, char *fs_type)
+{
+    int i;
+    struct darshan_timeseries_record *timeseries_rec =
+        (struct darshan_timeseries_record *)file_rec;
+
+    /* print each of the integer and floating point counters for the TIMESERIES module */
+    for(i=0; i<TIMESERIES_NUM_INDICES; i++)
+    {
+        /* macro defined in darshan-logutils.h */
+        DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_TIMESERIES_MOD],
+            timeseries_rec->base_rec.rank, timeseries_rec->base_rec.id,
+            timeseries_counter_names[i], timeseries_rec->counters[i],
+            file_name, mnt_pt, fs_type);
+    }
+
+    for(i=0; i<TIMESERIES_F_NUM_INDICES; i++)
+    {
+        /* macro defined in darshan-logutils.h */
+        DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_TIMESERIES_MOD],
+            timeseries_rec->base_rec.rank, timeseries_rec->base_rec.id,
+            timeseries_f_counter_names[i], timeseries_rec->fcounters[i],
+            file_name, mnt_pt, fs_type);
+    }
+
+    return;
+}
+
+/* print out a description of the TIMESERIES module record fields */
+static void darshan_log_print_timeseries_description(int ver)
+{
+    printf("\n# description of TIMESERIES counters:\n");
+    printf("#   one record per API (POSIX, MPI-IO and STDIO) holding series of %d\n",
+        TIMESERIES_NUM_BINS);
+    printf("#   intervals; bin i covers [i, i+1) * TIMESERIES_F_INTERVAL seconds after\n");
+    printf("#   the job started, and each operation is accounted to the interval in\n");
+    printf("#   which it completed.\n");
+    printf("#   TIMESERIES_PROCS: number of processes contributing to the series.\n");
+    printf("#   TIMESERIES_BYTES_READ_*, TIMESERIES_BYTES_WRITTEN_*: bytes moved.\n");
+    printf("#   TIMESERIES_READS_*, TIMESERIES_WRITES_*: read and write operations.\n");
+    printf("#   TIMESERIES_META_OPS_*: open, stat, flush and close operations.\n");
+    printf("#   TIMESERIES_F_INTERVAL: width of each interval, in seconds.\n");
+    printf("#   TIMESERIES_F_READ_TIME_*, TIMESERIES_F_WRITE_TIME_*,\n");
+    printf("#       TIMESERIES_F_META_TIME_*: time spent in those operations,\n");
+    printf("#       including overlapping operations.\n");
+
+    return;
+}
+
+/* print a diff of two TIMESERIES records (with the same record id) */
+static void darshan_log_print_timeseries_record_diff(void *file_rec1, char *file_name1,
+    void *file_rec2, char *file_name2)
+{
+    struct darshan_timeseries_record *file1 = (struct darshan_timeseries_record *)file_rec1;
+    struct darshan_timeseries_record *file2 = (struct darshan_timeseries_record *)file_rec2;
+    int i;
+
+    /* NOTE: we assume that both input records are the same module format version */
+
+    for(i=0; i<TIMESERIES_NUM_INDICES; i++)
+    {
+        if(!file2)
+        {
+            printf("- ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_TIMESERIES_MOD],
+                file1->base_rec.rank, file1->base_rec.id, timeseries_counter_names[i],
+                file1->counters[i], file_name1, "", "");
+
+        }
+        else if(!file1)
+        {
+            printf("+ ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_TIMESERIES_MOD],
+                file2->base_rec.rank, file2->base_rec.id, timeseries_counter_names[i],
+                file2->counters[i], file_name2, "", "");
+        }
+        else if(file1->counters[i] != file2->counters[i])
+        {
+            printf("- ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_TIMESERIES_MOD],
+                file1->base_rec.rank, file1->base_rec.id, timeseries_counter_names[i],
+                file1->counters[i], file_name1, "", "");
+            printf("+ ");
+            DARSHAN_D_COUNTER_PRINT(darshan_module_names[DARSHAN_TIMESERIES_MOD],
+                file2->base_rec.rank, file2->base_rec.id, timeseries_counter_names[i],
+                file2->counters[i], file_name2, "", "");
+        }
+    }
+
+    for(i=0; i<TIMESERIES_F_NUM_INDICES; i++)
+    {
+        if(!file2)
+        {
+            printf("- ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_TIMESERIES_MOD],
+                file1->base_rec.rank, file1->base_rec.id, timeseries_f_counter_names[i],
+                file1->fcounters[i], file_name1, "", "");
+
+        }
+        else if(!file1)
+        {
+            printf("+ ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_TIMESERIES_MOD],
+                file2->base_rec.rank, file2->base_rec.id, timeseries_f_counter_names[i],
+                file2->fcounters[i], file_name2, "", "");
+        }
+        else if(file1->fcounters[i] != file2->fcounters[i])
+        {
+            printf("- ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_TIMESERIES_MOD],
+                file1->base_rec.rank, file1->base_rec.id, timeseries_f_counter_names[i],
+                file1->fcounters[i], file_name1, "", "");
+            printf("+ ");
+            DARSHAN_F_COUNTER_PRINT(darshan_module_names[DARSHAN_TIMESERIES_MOD],
+                file2->base_rec.rank, file2->base_rec.id, timeseries_f_counter_names[i],
+                file2->fcounters[i], file_name2, "", "");
+        }
+    }
+
+    return;
+}
+
+/* aggregate the input TIMESERIES record 'rec' into the output record
+ * 'agg_rec', which is brought to the wider of the two intervals first
+ */
+static void darshan_log_agg_timeseries_records(void *rec, void *agg_rec, int init_flag)
+{
+    struct darshan_timeseries_record *timeseries_rec = (struct darshan_timeseries_record *)rec;
+    struct darshan_timeseries_record *agg_timeseries_rec = (struct darshan_timeseries_record *)agg_rec;
+    double interval = timeseries_rec->fcounters[TIMESERIES_F_INTERVAL];
+    int64_t *bins;
+    double *fbins;
+    int ratio;
+    int i, j;
+
+    if(init_flag || agg_timeseries_rec->fcounters[TIMESERIES_F_INTERVAL] <= 0)
+        agg_timeseries_rec->fcounters[TIMESERIES_F_INTERVAL] = interval;
+
+    /* merge adjacent output bins until the output is at least as coarse */
+    while(agg_timeseries_rec->fcounters[TIMESERIES_F_INTERVAL] < interval)
+    {
+        for(i = TIMESERIES_BYTES_READ_0; i < TIMESERIES_NUM_INDICES;
+            i += TIMESERIES_NUM_BINS)
+        {
+            bins = &agg_timeseries_rec->counters[i];
+            for(j = 0; j < TIMESERIES_NUM_BINS; j += 2)
+                bins[j/2] = bins[j] + bins[j+1];
+            memset(&bins[TIMESERIES_NUM_BINS/2], 0,
+                (TIMESERIES_NUM_BINS/2)*sizeof(int64_t));
+        }
+        for(i = TIMESERIES_F_READ_TIME_0; i < TIMESERIES_F_NUM_INDICES;
+            i += TIMESERIES_NUM_BINS)
+        {
+            fbins = &agg_timeseries_rec->fcounters[i];
+            for(j = 0; j < TIMESERIES_NUM_BINS; j += 2)
+                fbins[j/2] = fbins[j] + fbins[j+1];
+            memset(&fbins[TIMESERIES_NUM_BINS/2], 0,
+                (TIMESERIES_NUM_BINS/2)*sizeof(double));
+        }
+        agg_timeseries_rec->fcounters[TIMESERIES_F_INTERVAL] *= 2.0;
+    }
+
+    /* then sum the input, folding its bins if it is finer */
+    ratio = 1;
+    if(interval > 0)
+        ratio = (int)(agg_timeseries_rec->fcounters[TIMESERIES_F_INTERVAL] /
+            interval + 0.5);
+    if(ratio < 1)
+        ratio = 1;
+
+    agg_timeseries_rec->counters[TIMESERIES_PROCS] +=
+        timeseries_rec->counters[TIMESERIES_PROCS];
+    for(i = TIMESERIES_BYTES_READ_0; i < TIMESERIES_NUM_INDICES;
+        i += TIMESERIES_NUM_BINS)
+    {
+        for(j = 0; j < TIMESERIES_NUM_BINS; j++)
+            agg_timeseries_rec->counters[i + j/ratio] +=
+                timeseries_rec->counters[i + j];
+    }
+    for(i = TIMESERIES_F_READ_TIME_0; i < TIMESERIES_F_NUM_INDICES;
+        i += TIMESERIES_NUM_BINS)
+    {
+        for(j = 0; j < TIMESERIES_NUM_BINS; j++)
+            agg_timeseries_rec->fcounters[i + j/ratio] +=
+                timeseries_rec->fcounters[i + j];
+    }
+
+    return;
+}
+
+/*
+ * Local variables:
+ *  c-indent-level: 4
+ *  c-basic-offset: 4
+ * End:
+ *
+ * vim: ts=8 sts=4 sw=4 expandtab
+ */
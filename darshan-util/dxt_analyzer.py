@@ -39,19 +39,25 @@
 dxt_analyzer.py
 To plot the read or write activity from Darshan Extended Trace (DXT) logs.
 
+Darshan logs are read with PyDarshan, which decodes the DXT segments
+straight into numpy arrays and streams them in chunks, so traces larger
+than memory can be analyzed.  Text logs written by darshan-dxt-parser are
+still accepted.
+
 For more information on creating DXT logs, see:
 http://www.mcs.anl.gov/research/projects/darshan/docs/darshan3-util.html#_darshan_dxt_parser 
 
-% ./io_activitity_dxt.py --help
+% ./dxt_analyzer.py --help
 usage: dxt_analyzer.py [-h] -i DXT_LOGNAME [-o SAVEFIG] [--show] [--read]
-                            [--filemode] [-f FNAME]
+                       [--filemode] [-f FNAME] [--summary] [--chunk CHUNK]
+                       [--bins BINS]
 
 io activity plot from dxt log
 
 optional arguments:
   -h, --help            show this help message and exit
   -i DXT_LOGNAME, --input DXT_LOGNAME
-                        dxt log path
+                        darshan log or dxt text log path
   -o SAVEFIG, --save SAVEFIG
                         output file name for the plot
   --show                Show the plot rather than saving to a PDF
@@ -61,8 +67,16 @@ optional arguments:
                         Default is False for all files
   -f FNAME, --fname FNAME
                         name of file to be plotted (must use with --filemode)
+  --summary             Print the I/O totals of each rank and file
+  --chunk CHUNK         Number of segments read from a darshan log at a
+                        time. Default is 1000000
+  --bins BINS           Plot the I/O time of each rank in BINS time bins
+                        rather than one rectangle per segment, which keeps
+                        memory use bounded for large traces
 
 e.g.
+python dxt_analyzer.py -i example.darshan
+python dxt_analyzer.py -i example.darshan --bins 1000 --summary
 python dxt_analyzer.py -i darshan_dxt-a.txt
 python dxt_analyzer.py -i darshan_dxt-a.txt \
         --filemode -f /global/cscratch1/sd/asim/amrex/a24/plt00000.hdf5
@@ -75,8 +89,10 @@ python dxt_analyzer.py -i darshan_dxt-v.txt
 
 from builtins import str
 import numpy as np
+import pandas as pd
 import matplotlib
 #matplotlib.use('PDF')
+import matplotlib.collections
 import matplotlib.pyplot as plt
 import re
 import argparse
@@ -88,7 +104,7 @@ import sys
 global_finfo = {} 
 #'filename':{'rw':[], 'mount':'', 'fs':'', 'stripe_size':-1, 'stripe_width':-1, 'OSTlist':[]}
 #                    Module          rank         write/read      segment               offset                   length                 start                     end                    OST
-POSIX_LOG_PATTERN = ' (X_POSIX)\s+([+-]?\d+(?:\.\d+)?)\s+(\S+)\s+([+-]?\d+(?:\.\d+)?)\s+([+-]?\d+(?:\.\d+)?)\s+([+-]?\d+(?:\.\d+)?)\s+([+-]?\d+(?:\.\d+)?)\s+([+-]?\d+(?:\.\d+)?)\s+\[\s*([+-]?\d+(?:\.\d+)?)\]\.*'
+POSIX_LOG_PATTERN = ' (X_POSIX)\s+([+-]?\d+(?:\.\d+)?)\s+(\S+)\s+([+-]?\d+(?:\.\d+)?)\s+([+-]?\d+(?:\.\d+)?)\s+([+-]?\d+(?:\.\d+)?)\s+([+-]?\d+(?:\.\d+)?)\s+([+-]?\d+(?:\.\d+)?)(?:\s+[+-]?\d+)?\s+\[\s*([+-]?\d+(?:\.\d+)?)\]\.*'
 POSIX_LOG_NO_OSTS = ' (X_POSIX)\s+([+-]?\d+(?:\.\d+)?)\s+(\S+)\s+([+-]?\d+(?:\.\d+)?)\s+([+-]?\d+(?:\.\d+)?)\s+([+-]?\d+(?:\.\d+)?)\s+([+-]?\d+(?:\.\d+)?)\s+([+-]?\d+(?:\.\d+)?)'
 
 #                    Module          rank         write/read      segment               length                   start                     end 
@@ -184,32 +200,124 @@ def parse_dxt_log_line(line, curr_fname, finfo_dict):
     return (curr_fname, (), -1)
 
 
-def get_verts_file(data, module, fname, action):
-    '''make a list of rectangle vertices to plot the posix/mpi read/write activity for each rank for a specific file'''
-    keyword = module+'_'+action
-    filedata = [x[1] for x in [x for x in data if x[0]==fname]]
-    filtered = [x[1] for x in [x for x in filedata if x[0]==keyword]]
-    activities = [(x[0], (x[2], x[3])) for x in filtered]
-    verts = np.zeros((1,4,2))
-    for entry in activities:
-        lx,rx,by,ty = entry[1][0], entry[1][1], entry[0] - 0.5 , entry[0] + 0.5
-        newverts = np.array([((lx,by), (lx,ty), (rx, ty), (rx, by))])
-        verts = np.concatenate((verts, newverts))
-    return verts[1:]
-
-
-def get_verts_all(data, module, action):
-    '''make a list of rectangle vertices to plot the posix/mpi read/write activity for each rank'''
-    keyword = module+'_'+action
-    IOdata = [x[1] for x in data]
-    filtered = [x[1] for x in [x for x in IOdata if x[0]==keyword]]
-    activities = [(x[0], (x[2], x[3])) for x in filtered]
-    verts = np.zeros((1,4,2))
-    for entry in activities:
-        lx,rx,by,ty = entry[1][0], entry[1][1], entry[0] - 0.5 , entry[0] + 0.5
-        newverts = np.array([((lx,by), (lx,ty), (rx, ty), (rx, by))])
-        verts = np.concatenate((verts, newverts))
-    return verts[1:]
+def iter_text_log(dxt_logname, info):
+    '''parses a darshan-dxt-parser text log into a single chunk of segments'''
+    with open(dxt_logname) as infile:
+        try:
+            line = infile.readline()
+            if "# darshan" not in line:
+                raise Exception('Invalid file format')
+        except:
+            print("Error: unable to parse " + dxt_logname + ".", file=sys.stderr)
+            print("   Please make sure that it was generated by the darshan-dxt-parser utility.", file=sys.stderr)
+            sys.exit(1)
+        finfo_dict = {}
+        curr_fname = ''
+        columns = {'file': [], 'module': [], 'op': [], 'rank': [],
+                   'length': [], 'start_time': [], 'end_time': []}
+        for line in infile:
+            curr_fname, data, flag = parse_dxt_log_line(line, curr_fname, finfo_dict)
+            if flag == -11:
+                (k,v) = data
+                info[k] = v
+            elif flag == 1:
+                module, action = data[0].split('_')
+                columns['file'].append(curr_fname)
+                columns['module'].append(module)
+                columns['op'].append(action)
+                columns['rank'].append(data[1][0])
+                columns['length'].append(data[1][1])
+                columns['start_time'].append(data[1][2])
+                columns['end_time'].append(data[1][3])
+    if 'start_time' in info and 'end_time' in info:
+        info['run_time'] = info['end_time'] - info['start_time'] + 1
+    else:
+        info['run_time'] = max(columns['end_time'], default=1)
+    # file names are their own identifiers
+    info['names'] = {f: f for f in set(columns['file'])}
+    yield pd.DataFrame(columns)
+
+
+def iter_darshan_log(dxt_logname, info, chunk):
+    '''streams the DXT segments of a darshan log in chunks of at least 'chunk' segments'''
+    import darshan
+    with darshan.DarshanReport(dxt_logname, read_all=False) as report:
+        info['jobid'] = report.metadata['job']['jobid']
+        info['nprocs'] = report.metadata['job']['nprocs']
+        info['run_time'] = report.metadata['job']['run_time']
+        # files are identified by record id, and named once at the end
+        info['names'] = report._all_name_records()
+        for mod in ['DXT_POSIX', 'DXT_MPIIO']:
+            if mod not in report.modules:
+                continue
+            for seg_df in report.iter_dxt(mod, chunk=chunk):
+                if seg_df.empty:
+                    continue
+                yield pd.DataFrame({
+                    'file': seg_df['id'].values,
+                    'module': mod.replace('DXT_', ''),
+                    'op': seg_df['op'].str.upper().values,
+                    'rank': seg_df['rank'].values,
+                    'length': seg_df['length'].values,
+                    'start_time': seg_df['start_time'].values,
+                    'end_time': seg_df['end_time'].values,
+                })
+
+
+def get_verts(segs):
+    '''make an array of rectangle vertices to plot the activity of each segment on its rank'''
+    lx = segs['start_time'].values
+    rx = segs['end_time'].values
+    by = segs['rank'].values - 0.5
+    ty = segs['rank'].values + 0.5
+    return np.stack([np.stack([lx, by], axis=-1), np.stack([lx, ty], axis=-1),
+                     np.stack([rx, ty], axis=-1), np.stack([rx, by], axis=-1)],
+                    axis=1)
+
+
+class Summary(object):
+    '''accumulates the I/O totals of each rank and file over chunks of segments'''
+
+    def __init__(self):
+        self.rank_bytes = np.zeros(0)
+        self.rank_ops = np.zeros(0, dtype=np.int64)
+        self.rank_time = np.zeros(0)
+        self.files = None
+
+    def add(self, segs):
+        if segs.empty:
+            return
+        ranks = segs['rank'].values
+        durations = (segs['end_time'] - segs['start_time']).values
+        nranks = max(len(self.rank_bytes), int(ranks.max()) + 1)
+        self.rank_bytes = _grow(self.rank_bytes, nranks) + \
+            np.bincount(ranks, weights=segs['length'].values, minlength=nranks)
+        self.rank_ops = _grow(self.rank_ops, nranks) + \
+            np.bincount(ranks, minlength=nranks)
+        self.rank_time = _grow(self.rank_time, nranks) + \
+            np.bincount(ranks, weights=durations, minlength=nranks)
+
+        files = segs.assign(duration=durations).groupby('file').agg(
+            bytes=('length', 'sum'), ops=('length', 'size'), time=('duration', 'sum'))
+        self.files = files if self.files is None else self.files.add(files, fill_value=0)
+
+    def show(self, names, out=sys.stdout):
+        print("# rank bytes ops io_time", file=out)
+        for rank in np.flatnonzero(self.rank_ops):
+            print(rank, int(self.rank_bytes[rank]), self.rank_ops[rank],
+                  self.rank_time[rank], file=out)
+        if self.files is None:
+            return
+        print("# file bytes ops io_time", file=out)
+        files = self.files.sort_values('bytes', ascending=False)
+        for fid, row in files.iterrows():
+            print(names.get(fid, fid), int(row['bytes']), int(row['ops']),
+                  row['time'], file=out)
+
+
+def _grow(arr, n):
+    '''pads an array with zeros to length n'''
+    return np.concatenate([arr, np.zeros(n - len(arr), dtype=arr.dtype)])
 
 
 #------------------------------------------------------------------------------
@@ -233,12 +341,15 @@ showflag = False # If you do not want to save, set this to True.
 savefig = 'dxt_plot.pdf' 
 
 parser = argparse.ArgumentParser(description='io activity plot from dxt log')
-parser.add_argument("-i", "--input", action="store", dest="dxt_logname", required=True, help="dxt log path")
+parser.add_argument("-i", "--input", action="store", dest="dxt_logname", required=True, help="darshan log or dxt text log path")
 parser.add_argument("-o", "--save", action="store", dest="savefig", required=False, help="output file name for the plot")
 parser.add_argument("--show", action="store_true", dest="showflag", required=False, help="Show the plot rather than saving to a PDF")
 parser.add_argument("--read", action="store_true", dest="read_flag", required=False, help="READ I/O action to be plotted. Default is False for WRITE mode.")
 parser.add_argument("--filemode", action="store_true", dest="singlefile_mode", required=False, help="Single file mode (must be used with --fname). Default is False for all files")
 parser.add_argument("-f", "--fname", action="store", dest="fname", required=False, help="name of file to be plotted (must use with --filemode)")
+parser.add_argument("--summary", action="store_true", dest="summary", required=False, help="Print the I/O totals of each rank and file")
+parser.add_argument("--chunk", action="store", dest="chunk", type=int, default=1000000, required=False, help="Number of segments read from a darshan log at a time. Default is 1000000")
+parser.add_argument("--bins", action="store", dest="bins", type=int, required=False, help="Plot the I/O time of each rank in BINS time bins rather than one rectangle per segment")
 
 #args = parser.parse_args(['-l', '/Users/asim/Desktop/simcodes/vpic/runs/ttest/junmin-darshan_dxt-5967365.txt', 
 #'--save', 'dxt_plot.pdf'])
@@ -256,50 +367,68 @@ if (args.singlefile_mode):
     singlefile_mode = True
     mode = 'file'
     fname = args.fname
-    
-
-with open(dxt_logname) as infile:
-    try:
-        line = infile.readline()
-        if "# darshan" not in line:
-            raise Exception('Invalid file format')
-    except:
-        print("Error: unable to parse " + dxt_logname + ".", file=sys.stderr)
-        print("   Please make sure that it was generated by the darshan-dxt-parser utility.", file=sys.stderr)
-        sys.exit(1)
-    finfo_dict = {}
-    curr_fname = ''
-    logdata = []
-    jobid="NO_JOBID"
-    for line in infile:
-        curr_fname, data, flag = parse_dxt_log_line(line, curr_fname, finfo_dict)
-        if flag == -11:
-            (k,v) = data
-            if k == 'jobid': jobid = v
-            elif k == 'start_time': start_time = v
-            elif k == 'end_time': end_time = v
-            elif k == 'nprocs': nprocs = v
-        elif flag == 1:
-            logdata.append((curr_fname, data))
+
+# text logs start with the darshan-dxt-parser header, anything else
+# is read as a darshan log
+with open(dxt_logname, 'rb') as infile:
+    text_log = infile.read(9) == b'# darshan'
+info = {'jobid': 'NO_JOBID'}
+if text_log:
+    chunks = iter_text_log(dxt_logname, info)
+else:
+    chunks = iter_darshan_log(dxt_logname, info, args.chunk)
 
 fig, ax = plt.subplots(dpi=150)
+colors = {'MPIIO': 'blue', 'POSIX': 'red'}
+summary = Summary() if args.summary else None
+grids = {}
+fids = None
+
+for segs in chunks:
+    if fids is None:
+        # the file names are known once the log is open
+        fids = [fid for fid, name in info['names'].items() if name == fname]
+    if summary is not None:
+        summary.add(segs)
+    segs = segs[segs['op'].values == action]
+    if mode == 'file':
+        segs = segs[segs['file'].isin(fids).values]
+    for module, color in colors.items():
+        modsegs = segs[segs['module'].values == module]
+        if modsegs.empty:
+            continue
+        if args.bins:
+            from darshan.experimental.plots.heatmap_handling import bin_dxt_segments
+            nprocs = info.get('nprocs', int(modsegs['rank'].max()) + 1)
+            grids[module] = bin_dxt_segments(ranks=modsegs['rank'].values,
+                start_times=modsegs['start_time'].values,
+                end_times=modsegs['end_time'].values,
+                lengths=(modsegs['end_time'] - modsegs['start_time']).values,
+                xbins=args.bins, nprocs=nprocs, max_time=info['run_time'],
+                out=grids.get(module))
+        else:
+            ax.add_collection(matplotlib.collections.PolyCollection(
+                get_verts(modsegs), facecolor=color, edgecolor=color,
+                rasterized=True))
 
 if mode=='file':
-    mpiio_verts = get_verts_file(logdata, 'MPIIO', fname, action)
-    mpiio_collec = matplotlib.collections.PolyCollection(mpiio_verts, facecolor='blue', edgecolor='blue')
-    posix_verts = get_verts_file(logdata, 'POSIX', fname, action)
-    posix_collec = matplotlib.collections.PolyCollection(posix_verts, facecolor='red', edgecolor='red')
-    title = str(jobid)+'_'+fname.split('/').pop()+'_'+action+'_activity'
+    title = str(info['jobid'])+'_'+fname.split('/').pop()+'_'+action+'_activity'
 else :  # mode=='all'
-    mpiio_verts = get_verts_all(logdata, 'MPIIO', action)
-    mpiio_collec = matplotlib.collections.PolyCollection(mpiio_verts, facecolor='blue', edgecolor='blue')
-    posix_verts = get_verts_all(logdata, 'POSIX', action)
-    posix_collec = matplotlib.collections.PolyCollection(posix_verts, facecolor='red', edgecolor='red')
-    title = str(jobid)+'_'+action+'_activity'
+    title = str(info['jobid'])+'_'+action+'_activity'
+
+if args.bins:
+    # POSIX activity is drawn over MPI-IO activity, as for the rectangles
+    for module in ['MPIIO', 'POSIX']:
+        if module not in grids:
+            continue
+        grid = np.ma.masked_equal(grids[module], 0)
+        ax.imshow(grid, aspect='auto', origin='lower', interpolation='nearest',
+                  cmap=('Blues' if module == 'MPIIO' else 'Reds'),
+                  extent=(0, info['run_time'], -0.5, grid.shape[0] - 0.5))
 
+if summary is not None:
+    summary.show(info['names'])
 
-ax.add_collection(mpiio_collec)
-ax.add_collection(posix_collec)
 ax.autoscale()
 plt.ylabel("MPI rank")
 plt.xlabel("Time (s)")
@@ -308,4 +437,3 @@ if (showflag):
     plt.show()
 else:
     plt.savefig(savefig, format='pdf')
-
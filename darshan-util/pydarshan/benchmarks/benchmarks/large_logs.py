@@ -0,0 +1,160 @@
+"""
+Benchmarks of pydarshan on large synthetic logs (see synthetic_logs.py).
+
+The logs are generated once per benchmark class by setup_cache(), in the
+directory asv runs the class in, and are shared by all of its parameter
+combinations.
+"""
+
+import os
+
+import darshan
+from darshan.backend import cffi_backend as backend
+from darshan.cli import summary
+
+from .synthetic_logs import write_log
+
+
+# number of files (and of records per module) in the record benchmarks
+RECORD_COUNTS = [100000, 1000000]
+# total number of DXT_POSIX segments in the DXT benchmarks
+DXT_SEGMENT_COUNTS = [1000000, 10000000]
+# number of ranks in the heatmap benchmarks
+HEATMAP_RANKS = [1024, 16384]
+# number of files in the summary report benchmarks
+SUMMARY_RECORD_COUNTS = [10000, 100000]
+
+
+class LargeLog:
+    params = [RECORD_COUNTS]
+    param_names = ["records"]
+    timeout = 1200
+    # a fresh report per sample; repeated reads of one report hit its records
+    number = 1
+
+    def setup_cache(self):
+        return {n: write_log(os.path.abspath(f"records-{n}.darshan"), nfiles=n)
+                for n in RECORD_COUNTS}
+
+    def setup(self, logs, records):
+        self.logfile = logs[records]
+
+    def time_open(self, logs, records):
+        darshan.DarshanReport(self.logfile, read_all=False)
+
+    def peakmem_open(self, logs, records):
+        darshan.DarshanReport(self.logfile, read_all=False)
+
+    def time_name_records(self, logs, records):
+        log = backend.log_open(self.logfile)
+        backend.log_get_name_records(log)
+        backend.log_close(log)
+
+    def peakmem_name_records(self, logs, records):
+        log = backend.log_open(self.logfile)
+        backend.log_get_name_records(log)
+        backend.log_close(log)
+
+
+class LargeLogModules:
+    params = [RECORD_COUNTS, ["POSIX", "MPI-IO", "STDIO"], ["numpy", "pandas"]]
+    param_names = ["records", "mod", "dtype"]
+    timeout = 1200
+    number = 1
+
+    def setup_cache(self):
+        return {n: write_log(os.path.abspath(f"modules-{n}.darshan"), nfiles=n)
+                for n in RECORD_COUNTS}
+
+    def setup(self, logs, records, mod, dtype):
+        self.report = darshan.DarshanReport(logs[records], read_all=False,
+                                            lookup_name_records=False)
+
+    def time_mod_read_all_records(self, logs, records, mod, dtype):
+        self.report.mod_read_all_records(mod, dtype=dtype)
+
+    def peakmem_mod_read_all_records(self, logs, records, mod, dtype):
+        self.report.mod_read_all_records(mod, dtype=dtype)
+
+
+class LargeDXTLog:
+    params = [DXT_SEGMENT_COUNTS]
+    param_names = ["segments"]
+    timeout = 1800
+    number = 1
+
+    def setup_cache(self):
+        return {n: write_log(os.path.abspath(f"dxt-{n}.darshan"), nfiles=4096,
+                             mods=("POSIX",), dxt_records=4096, dxt_segments=n)
+                for n in DXT_SEGMENT_COUNTS}
+
+    def setup(self, logs, segments):
+        self.report = darshan.DarshanReport(logs[segments], read_all=False,
+                                            lookup_name_records=False)
+
+    def time_mod_read_dxt_segments(self, logs, segments):
+        self.report.mod_read_dxt_segments("DXT_POSIX")
+
+    def peakmem_mod_read_dxt_segments(self, logs, segments):
+        self.report.mod_read_dxt_segments("DXT_POSIX")
+
+    def time_iter_dxt(self, logs, segments):
+        for chunk in self.report.iter_dxt("DXT_POSIX"):
+            pass
+
+    def peakmem_iter_dxt(self, logs, segments):
+        for chunk in self.report.iter_dxt("DXT_POSIX"):
+            pass
+
+
+class LargeHeatmapLog:
+    params = [HEATMAP_RANKS]
+    param_names = ["ranks"]
+    timeout = 1200
+    number = 1
+
+    def setup_cache(self):
+        return {n: write_log(os.path.abspath(f"heatmap-{n}.darshan"), nprocs=n,
+                             nfiles=n, mods=("POSIX",), heatmap_bins=200)
+                for n in HEATMAP_RANKS}
+
+    def setup(self, logs, ranks):
+        self.report = darshan.DarshanReport(logs[ranks], read_all=False)
+
+    def _build_heatmap(self):
+        self.report.read_all_heatmap_records()
+        self.report.heatmaps["POSIX"].to_df(ops=["read", "write"])
+
+    def time_build_heatmap(self, logs, ranks):
+        self._build_heatmap()
+
+    def peakmem_build_heatmap(self, logs, ranks):
+        self._build_heatmap()
+
+
+class LargeLogSummary:
+    params = [SUMMARY_RECORD_COUNTS]
+    param_names = ["records"]
+    timeout = 1800
+    number = 1
+    repeat = (1, 3, 600.0)
+
+    def setup_cache(self):
+        return {n: write_log(os.path.abspath(f"summary-{n}.darshan"), nfiles=n,
+                             dxt_records=min(n, 1024), dxt_segments=100 * n,
+                             heatmap_bins=200)
+                for n in SUMMARY_RECORD_COUNTS}
+
+    def setup(self, logs, records):
+        self.logfile = logs[records]
+        self.report_filename = f"summary-{records}.html"
+
+    def teardown(self, logs, records):
+        if os.path.exists(self.report_filename):
+            os.remove(self.report_filename)
+
+    def time_summary(self, logs, records):
+        summary.generate_report(self.logfile, self.report_filename)
+
+    def peakmem_summary(self, logs, records):
+        summary.generate_report(self.logfile, self.report_filename)
@@ -0,0 +1,177 @@
+"""
+Generator for large synthetic darshan logs used by the benchmarks.
+
+Logs are written through the darshan-util log writer (the same code path
+darshan-convert uses), so they exercise the regular decoding paths when read
+back. Counter values are random and not meant to be self-consistent; only
+the sizes of the logs (numbers of name records, module records and DXT
+segments) matter for the benchmarks.
+"""
+
+import numpy as np
+
+from darshan.backend.cffi_backend import (ffi, libdutil, mod_name_to_idx,
+                                          _generic_record_dtype,
+                                          _dxt_segment_dtype)
+
+
+START_TIME = 1600000000
+RUN_TIME = 3600
+
+# record id of the POSIX heatmap (darshan_core_gen_record_id("heatmap:POSIX"))
+HEATMAP_POSIX_ID = 16592106915301738621
+
+
+def write_log(path, nprocs=1024, nfiles=10000, mods=("POSIX", "MPI-IO", "STDIO"),
+              dxt_records=0, dxt_segments=0, heatmap_bins=0, seed=0):
+    """
+    Writes a synthetic darshan log.
+
+    Args:
+        path (str): path of the log to create
+        nprocs (int): number of ranks of the job
+        nfiles (int): number of files; each module in ``mods`` gets one
+            record per file, spread round-robin over the ranks
+        mods (tuple): fixed-size record modules to write records for
+        dxt_records (int): number of DXT_POSIX records (the first
+            ``dxt_records`` files)
+        dxt_segments (int): total number of DXT_POSIX trace segments,
+            split evenly over the DXT records
+        heatmap_bins (int): if nonzero, write one POSIX heatmap record with
+            this many bins per rank
+        seed (int): seed for the random counter values
+
+    Returns:
+        str: ``path``
+    """
+    rng = np.random.default_rng(seed)
+
+    fd = libdutil.darshan_log_create(path.encode(), 0, 0)  # DARSHAN_ZLIB_COMP
+    if fd == ffi.NULL:
+        raise RuntimeError(f"Failed to create darshan log {path}")
+    try:
+        _put_header(fd, nprocs)
+
+        ids = (np.arange(nfiles, dtype=np.uint64) * np.uint64(0x9E3779B97F4A7C15)
+               + np.uint64(1))
+        names = [f"/scratch/synthetic/dir{i % 1000}/file{i}.dat" for i in range(nfiles)]
+        if heatmap_bins:
+            ids = np.append(ids, np.uint64(HEATMAP_POSIX_ID))
+            names.append("heatmap:POSIX")
+        _put_name_records(fd, ids, names)
+
+        # module data must be written in order of increasing module id
+        ranks = np.arange(nfiles, dtype=np.int64) % nprocs
+        writers = [(mod_name_to_idx(mod), _put_module, (mod, ids[:nfiles], ranks))
+                   for mod in mods]
+        if dxt_records:
+            writers.append((mod_name_to_idx("DXT_POSIX"), _put_dxt,
+                            (ids[:dxt_records], ranks[:dxt_records], dxt_segments)))
+        if heatmap_bins:
+            writers.append((mod_name_to_idx("HEATMAP"), _put_heatmap,
+                            (nprocs, heatmap_bins)))
+        for mod_idx, writer, args in sorted(writers, key=lambda w: w[0]):
+            writer(fd, mod_idx, rng, *args)
+    finally:
+        libdutil.darshan_log_close(fd)
+
+    return path
+
+
+def _check(ret, what):
+    if ret < 0:
+        raise RuntimeError(f"Failed to write {what}")
+
+
+def _put_header(fd, nprocs):
+    job = ffi.new("struct darshan_job *")
+    job.uid = 1000
+    job.start_time_sec = START_TIME
+    job.end_time_sec = START_TIME + RUN_TIME
+    job.nprocs = nprocs
+    job.jobid = 4242
+    job.metadata = b"lib_ver=3.4.0\nh=romio_no_indep_rw=true;cb_nodes=4\n"
+    _check(libdutil.darshan_log_put_job(fd, job), "job data")
+
+    exe = ffi.new("char[]", b"/scratch/synthetic/app --input /scratch/synthetic/in.dat")
+    _check(libdutil.darshan_log_put_exe(fd, exe), "exe string")
+
+    mnts = ffi.new("struct darshan_mnt_info[2]")
+    mnts[0].mnt_type = b"lustre"
+    mnts[0].mnt_path = b"/scratch"
+    mnts[1].mnt_type = b"ext4"
+    mnts[1].mnt_path = b"/"
+    _check(libdutil.darshan_log_put_mounts(fd, mnts, 2), "mount data")
+
+
+def _put_name_records(fd, ids, names):
+    c_names = [ffi.new("char[]", name.encode()) for name in names]
+    c_ids = np.ascontiguousarray(ids, dtype=np.uint64)
+    _check(libdutil.darshan_log_put_name_records(
+               fd, ffi.cast("darshan_record_id *", ffi.from_buffer(c_ids)),
+               ffi.new("char *[]", c_names), len(names)),
+           "name records")
+
+
+def _put_module(fd, mod_idx, rng, mod, ids, ranks):
+    dtype = _generic_record_dtype(mod)
+    recs = np.zeros(len(ids), dtype=dtype)
+    recs['id'] = ids
+    recs['rank'] = ranks
+    if 'file_rec_id' in dtype.names:
+        recs['file_rec_id'] = ids
+    recs['counters'] = rng.integers(0, 1 << 20, size=recs['counters'].shape)
+    recs['fcounters'] = rng.uniform(0, RUN_TIME / 2, size=recs['fcounters'].shape)
+
+    buf = ffi.cast("char *", ffi.from_buffer(recs))
+    for i in range(len(recs)):
+        _check(libdutil.darshan_log_put_record(fd, mod_idx, buf + i * dtype.itemsize),
+               f"{mod} record")
+
+
+def _put_dxt(fd, mod_idx, rng, ids, ranks, nsegments):
+    seg_dtype = _dxt_segment_dtype()
+    hdr_size = ffi.sizeof("struct dxt_file_record")
+    per_rec = max(nsegments // len(ids), 1)
+    nwrites = per_rec // 2
+    nreads = per_rec - nwrites
+
+    buf = ffi.new("char[]", hdr_size + per_rec * seg_dtype.itemsize)
+    hdr = ffi.cast("struct dxt_file_record *", buf)
+    segs = np.frombuffer(ffi.buffer(buf), dtype=seg_dtype,
+                         count=per_rec, offset=hdr_size)
+    for rec_id, rank in zip(ids, ranks):
+        hdr.base_rec.id = int(rec_id)
+        hdr.base_rec.rank = int(rank)
+        hdr.hostname = b"nid%05d" % (int(rank) // 64)
+        hdr.write_count = nwrites
+        hdr.read_count = nreads
+
+        # sequential accesses, as most traces are
+        length = rng.integers(1, 1 << 20, size=per_rec)
+        start = np.sort(rng.uniform(0, RUN_TIME, size=per_rec))
+        segs['length'] = length
+        segs['offset'] = np.concatenate((np.cumsum(length[:nwrites]) - length[:nwrites],
+                                         np.cumsum(length[nwrites:]) - length[nwrites:]))
+        segs['start_time'] = start
+        segs['end_time'] = start + rng.uniform(0, 0.01, size=per_rec)
+        segs['thread_id'] = -1
+        _check(libdutil.darshan_log_put_record(fd, mod_idx, buf), "DXT_POSIX record")
+
+
+def _put_heatmap(fd, mod_idx, rng, nprocs, nbins):
+    hdr_size = ffi.sizeof("struct darshan_heatmap_record")
+    buf = ffi.new("char[]", hdr_size + 2 * nbins * ffi.sizeof("int64_t"))
+    rec = ffi.cast("struct darshan_heatmap_record *", buf)
+    bins = np.frombuffer(ffi.buffer(buf), dtype=np.int64, count=2 * nbins,
+                         offset=hdr_size)
+    rec.base_rec.id = HEATMAP_POSIX_ID
+    rec.bin_width_seconds = RUN_TIME / nbins
+    rec.nbins = nbins
+    rec.flags = 0
+    rec.write_bins = ffi.cast("int64_t *", buf + hdr_size)
+    rec.read_bins = rec.write_bins + nbins
+    for rank in range(nprocs):
+        rec.base_rec.rank = rank
+        bins[:] = rng.integers(0, 1 << 24, size=2 * nbins)
+        _check(libdutil.darshan_log_put_record(fd, mod_idx, buf), "HEATMAP record")
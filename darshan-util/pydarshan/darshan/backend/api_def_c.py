@@ -59,6 +59,22 @@ typedef struct darshan_accumulator_st* darshan_accumulator;
 int darshan_accumulator_create(int darshan_module_id, int64_t, darshan_accumulator*);
 int darshan_accumulator_inject(darshan_accumulator, void*, int);
 int darshan_accumulator_emit(darshan_accumulator, struct darshan_derived_metrics*, void* aggregation_record);
+int darshan_accumulator_merge(darshan_accumulator, darshan_accumulator);
+
+struct darshan_access_size {
+    int64_t size;
+    int64_t count;
+};
+
+struct darshan_category_io {
+    int64_t bytes_read;
+    int64_t bytes_written;
+    int64_t files_read;
+    int64_t files_written;
+};
+
+int darshan_accumulator_emit_access_sizes(darshan_accumulator, struct darshan_access_size*, int);
+int darshan_accumulator_emit_categories(darshan_accumulator*, int, uint64_t*, int*, int, struct darshan_category_io*, int);
 int darshan_accumulator_destroy(darshan_accumulator);
 
 /* from darshan-log-format.h */
@@ -82,12 +98,36 @@ struct darshan_base_record
     int64_t rank;
 };
 
+struct darshan_log_block
+{
+    darshan_record_id first_id;
+    darshan_record_id last_id;
+    int64_t rank;
+    uint64_t off;
+    uint64_t len;
+    uint32_t mod_id;
+    uint32_t nrecs;
+};
+
 struct darshan_name_record
 {
     darshan_record_id id;
     char *name;
 };
 
+struct darshan_name_table_entry
+{
+    darshan_record_id id;
+    uint64_t name_off;
+};
+
+struct darshan_name_table
+{
+    struct darshan_name_table_entry *entries;
+    int64_t count;
+    char *names;
+};
+
 struct darshan_posix_file
 {
     struct darshan_base_record base_rec;
@@ -102,11 +142,74 @@ struct darshan_stdio_file
     double fcounters[15];
 };
 
+struct darshan_batchio_record
+{
+    struct darshan_base_record base_rec;
+    int64_t counters[23];
+    double fcounters[4];
+};
+
+struct darshan_overhead_record
+{
+    struct darshan_base_record base_rec;
+    int64_t counters[4];
+    double fcounters[9];
+};
+
+struct darshan_latency_record
+{
+    struct darshan_base_record base_rec;
+    int64_t counters[192];
+    double fcounters[6];
+};
+
+struct darshan_timeseries_record
+{
+    struct darshan_base_record base_rec;
+    int64_t counters[321];
+    double fcounters[193];
+};
+
+struct darshan_cufile_record
+{
+    struct darshan_base_record base_rec;
+    int64_t counters[47];
+    double fcounters[13];
+};
+
+struct darshan_mmap_record
+{
+    struct darshan_base_record base_rec;
+    int64_t counters[13];
+    double fcounters[3];
+};
+
+struct darshan_rollup_record
+{
+    struct darshan_base_record base_rec;
+    int64_t counters[10];
+    double fcounters[2];
+};
+
+struct darshan_phase_record
+{
+    struct darshan_base_record base_rec;
+    int64_t counters[17];
+    double fcounters[13];
+};
+
+struct darshan_attrib_record
+{
+    struct darshan_base_record base_rec;
+    int64_t counters[12];
+    double fcounters[6];
+};
+
 struct darshan_mpiio_file
 {
     struct darshan_base_record base_rec;
     int64_t counters[51];
-    double fcounters[17];
+    double fcounters[22];
 };
 
 struct darshan_hdf5_file
@@ -127,7 +230,7 @@ struct darshan_hdf5_dataset
 struct darshan_pnetcdf_file
 {
     struct darshan_base_record base_rec;
-    int64_t counters[9];
+    int64_t counters[18];
     double fcounters[8];
 };
 
@@ -136,7 +239,7 @@ struct darshan_pnetcdf_var
     struct darshan_base_record base_rec;
     uint64_t file_rec_id;
     int64_t counters[120];
-    double fcounters[17];
+    double fcounters[19];
 };
 
 struct darshan_bgq_record
@@ -152,6 +255,12 @@ struct darshan_lustre_component
     char pool_name[16];
 };
 
+struct darshan_lustre_ost_traffic
+{
+    int64_t ost_id;
+    int64_t counters[4];
+};
+
 struct darshan_lustre_record
 {
     struct darshan_base_record base_rec;
@@ -159,6 +268,7 @@ struct darshan_lustre_record
     int64_t num_stripes;
     struct darshan_lustre_component *comps;
     int64_t *ost_ids;
+    struct darshan_lustre_ost_traffic *ost_traffic;
 };
 
 struct darshan_heatmap_record
@@ -168,6 +278,10 @@ struct darshan_heatmap_record
     int64_t nbins;             /* number of bins */
     int64_t *write_bins;       /* pointer to write bin array (trails struct in log */
     int64_t *read_bins;        /* pointer to read bin array (trails write bin array in log */
+    int64_t flags;             /* DARSHAN_HEATMAP_F_* flags */
+    int64_t *write_op_bins;    /* pointer to write op count bin array (NULL if not present) */
+    int64_t *read_op_bins;     /* pointer to read op count bin array (NULL if not present) */
+    int64_t *meta_op_bins;     /* pointer to metadata op count bin array (NULL if not present) */
 };
 
 
@@ -178,6 +292,8 @@ struct dxt_file_record {
 
     int64_t write_count;
     int64_t read_count;
+    int64_t write_dropped;  /* segments overwritten in ring buffer mode */
+    int64_t read_dropped;
 };
 
 typedef struct segment_info {
@@ -185,8 +301,17 @@ typedef struct segment_info {
     int64_t length;
     double start_time;
     double end_time;
+    int64_t thread_id;      /* -1 if unknown */
 } segment_info;
 
+struct dxt_log_filter
+{
+    int64_t *rank_ranges;
+    int rank_range_count;
+    double start_time;
+    double end_time;
+};
+
 /* counter names */
 extern char *bgq_counter_names[];
 extern char *bgq_f_counter_names[];
@@ -195,6 +320,7 @@ extern char *h5d_f_counter_names[];
 extern char *h5f_counter_names[];
 extern char *h5f_f_counter_names[];
 extern char *lustre_comp_counter_names[];
+extern char *lustre_ost_counter_names[];
 extern char *mpiio_counter_names[];
 extern char *mpiio_f_counter_names[];
 extern char *pnetcdf_file_counter_names[];
@@ -205,15 +331,50 @@ extern char *posix_counter_names[];
 extern char *posix_f_counter_names[];
 extern char *stdio_counter_names[];
 extern char *stdio_f_counter_names[];
+extern char *batchio_counter_names[];
+extern char *batchio_f_counter_names[];
+extern char *overhead_counter_names[];
+extern char *overhead_f_counter_names[];
+extern char *latency_counter_names[];
+extern char *latency_f_counter_names[];
+extern char *timeseries_counter_names[];
+extern char *timeseries_f_counter_names[];
+extern char *cufile_counter_names[];
+extern char *cufile_f_counter_names[];
+extern char *mmap_counter_names[];
+extern char *mmap_f_counter_names[];
+extern char *rollup_counter_names[];
+extern char *rollup_f_counter_names[];
+extern char *phase_counter_names[];
+extern char *phase_f_counter_names[];
+extern char *attrib_counter_names[];
+extern char *attrib_f_counter_names[];
 
 /* Supported Functions */
 void* darshan_log_open(char *);
+void* darshan_log_open_mmap(char *);
 int darshan_log_get_job(void *, struct darshan_job *);
+void* darshan_log_create(char *, int, int);
+int darshan_log_put_job(void *, struct darshan_job *);
+int darshan_log_put_exe(void*, char *);
+int darshan_log_put_mounts(void*, struct darshan_mnt_info *, int);
+int darshan_log_put_name_records(void*, darshan_record_id *, char **, int);
+int darshan_log_put_record(void*, int, void *);
 void darshan_log_close(void*);
 int darshan_log_get_exe(void*, char *);
 int darshan_log_get_mounts(void*, struct darshan_mnt_info **, int*);
 void darshan_log_get_modules(void*, struct darshan_mod_info **, int*);
 int darshan_log_get_record(void*, int, void **);
+int darshan_log_get_record_ptr(void*, int, void **);
+int darshan_log_get_blocks(void*, int, struct darshan_log_block **, int*);
+int darshan_log_select_block(void*, int, int);
+int darshan_log_get_record_by_id(void*, int, darshan_record_id, void **);
+int darshan_log_get_records_batch(void*, int, void*, int, int*);
+int darshan_log_get_columns(void*, int, const int*, int, void*, int, int*);
+int darshan_log_prefetch_mods(void*, int);
+int darshan_log_agg_records(int, void*, int, int, void*, int);
+int dxt_log_get_filtered_file(void*, int, const struct dxt_log_filter*, void**);
+int heatmap_log_get_bins(void*, int64_t, int, darshan_record_id*, int64_t*, double*, int64_t*, int64_t*, int64_t*, int*);
 char* darshan_log_get_lib_version(void);
 int darshan_log_get_job_runtime(void *, struct darshan_job job, double *runtime);
 void darshan_free(void *);
@@ -222,6 +383,9 @@ int darshan_log_get_namehash(void*, struct darshan_name_record_ref **hash);
 
 void darshan_log_get_name_records(void*, struct darshan_name_record **, int*);
 void darshan_log_get_filtered_name_records(void*, struct darshan_name_record **, int*, darshan_record_id*, int);
+int darshan_log_get_name_table(void*, struct darshan_name_table **);
+int darshan_log_get_filtered_name_table(void*, struct darshan_name_table **, darshan_record_id*, int);
+void darshan_name_table_free(struct darshan_name_table *);
 
 """
 
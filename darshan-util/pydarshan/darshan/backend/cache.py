@@ -0,0 +1,199 @@
+"""
+On-disk cache of decoded darshan log data.
+
+Decoding a large log (inflating its regions and converting every record
+through cffi) dominates the time it takes to open it. A ``LogCache`` keeps
+the decoded records of modules with fixed-size records, the name records
+and the heatmap records of one log in a sidecar directory, so that later
+opens of the same, unmodified log read them back from plain numpy files.
+Record fields are stored as one ``.npy`` file each and are memory-mapped
+when loaded.
+
+Cache entries are keyed by the log's real path; an entry is discarded and
+rebuilt when the size or modification time of the log, or the pydarshan
+version, no longer match the ones it was built from.
+"""
+
+import os
+import json
+import shutil
+import hashlib
+import tempfile
+
+import numpy as np
+
+import darshan
+
+
+# bump when the layout of cache entries changes
+_CACHE_FORMAT = 2
+
+
+def default_cache_dir():
+    """
+    Returns the default cache location: $DARSHAN_CACHE_DIR if set, and
+    otherwise a ``darshan`` directory in the user's cache directory
+    ($XDG_CACHE_HOME, or ~/.cache).
+    """
+    if os.environ.get("DARSHAN_CACHE_DIR"):
+        return os.environ["DARSHAN_CACHE_DIR"]
+    base = os.environ.get("XDG_CACHE_HOME") or os.path.join(os.path.expanduser("~"), ".cache")
+    return os.path.join(base, "darshan")
+
+
+class LogCache:
+    """
+    Cache entry for the decoded data of a single darshan log.
+
+    Args:
+        log_path (str): path of the darshan log
+        cache_dir (str): directory holding cache entries (default:
+            default_cache_dir())
+    """
+
+    def __init__(self, log_path, cache_dir=None):
+        self.log_path = os.path.realpath(log_path)
+        self.cache_dir = cache_dir if cache_dir else default_cache_dir()
+
+        digest = hashlib.sha1(self.log_path.encode("utf-8")).hexdigest()[:16]
+        self.path = os.path.join(self.cache_dir,
+                                 f"{os.path.basename(self.log_path)}-{digest}")
+
+        st = os.stat(self.log_path)
+        self.source = {
+            "path": self.log_path,
+            "size": st.st_size,
+            "mtime_ns": st.st_mtime_ns,
+            "format": _CACHE_FORMAT,
+            "version": darshan.__version__,
+        }
+        self._validate()
+
+    def _validate(self):
+        """
+        Removes the entry if it was built from a different version of the log.
+        """
+        try:
+            with open(os.path.join(self.path, "source.json")) as f:
+                if json.load(f) == self.source:
+                    return
+        except (OSError, ValueError):
+            if not os.path.exists(self.path):
+                return
+        shutil.rmtree(self.path, ignore_errors=True)
+
+    def _prepare(self):
+        """
+        Creates the entry directory, recording which log it was built from.
+        """
+        source_path = os.path.join(self.path, "source.json")
+        if os.path.exists(source_path):
+            return
+        os.makedirs(self.path, exist_ok=True)
+        fd, tmp_path = tempfile.mkstemp(dir=self.path, prefix=".tmp-")
+        with os.fdopen(fd, "w") as f:
+            json.dump(self.source, f)
+        os.replace(tmp_path, source_path)
+
+    def _publish(self, tmp_path, name):
+        """
+        Moves a fully written file or directory into the entry, so that
+        readers never see partial data; if another process published a
+        directory of the same name first, this copy is discarded.
+        """
+        dest = os.path.join(self.path, name)
+        if os.path.isdir(tmp_path):
+            try:
+                os.rename(tmp_path, dest)
+            except OSError:
+                shutil.rmtree(tmp_path, ignore_errors=True)
+        else:
+            os.replace(tmp_path, dest)
+
+    def has(self, mod):
+        """
+        Returns True if the decoded data of a module is in the cache.
+        """
+        if mod == "HEATMAP":
+            return os.path.exists(os.path.join(self.path, "heatmaps.npz"))
+        return os.path.isdir(os.path.join(self.path, mod))
+
+    def get_records(self, mod):
+        """
+        Returns the cached records of a module, as a dictionary of
+        (memory-mapped, copy-on-write) numpy arrays in the format of
+        backend.log_get_generic_record_arrays(), or None on a cache miss.
+        """
+        mod_path = os.path.join(self.path, mod)
+        if not os.path.isdir(mod_path):
+            return None
+        arr = {}
+        for fname in os.listdir(mod_path):
+            field, ext = os.path.splitext(fname)
+            if ext == ".npy":
+                arr[field] = np.load(os.path.join(mod_path, fname),
+                                     mmap_mode='c').view(np.ndarray)
+        return arr
+
+    def put_records(self, mod, arr):
+        """
+        Stores the records of a module, given as a dictionary of numpy arrays.
+        """
+        try:
+            self._prepare()
+            tmp_path = tempfile.mkdtemp(dir=self.path, prefix=".tmp-")
+            for field, values in arr.items():
+                np.save(os.path.join(tmp_path, field + ".npy"), values)
+            self._publish(tmp_path, mod)
+        except OSError:
+            # the cache is an optimization; an unwritable cache is not an error
+            pass
+
+    def get_name_records(self):
+        """
+        Returns the cached name records of the log, or None on a cache miss.
+        """
+        try:
+            with open(os.path.join(self.path, "name_records.json")) as f:
+                return {int(rec_id): name for rec_id, name in json.load(f).items()}
+        except (OSError, ValueError):
+            return None
+
+    def put_name_records(self, name_records):
+        """
+        Stores all name records of the log.
+        """
+        try:
+            self._prepare()
+            fd, tmp_path = tempfile.mkstemp(dir=self.path, prefix=".tmp-")
+            with os.fdopen(fd, "w") as f:
+                json.dump({str(rec_id): name for rec_id, name in name_records.items()}, f)
+            self._publish(tmp_path, "name_records.json")
+        except OSError:
+            pass
+
+    def get_heatmaps(self):
+        """
+        Returns the cached heatmap records of the log, as a dictionary of
+        numpy arrays in the format of backend.log_get_heatmap_arrays(), or
+        None on a cache miss.
+        """
+        try:
+            with np.load(os.path.join(self.path, "heatmaps.npz")) as npz:
+                return {name: npz[name] for name in npz.files}
+        except (OSError, ValueError):
+            return None
+
+    def put_heatmaps(self, arr):
+        """
+        Stores the heatmap records of the log, given as a dictionary of
+        numpy arrays.
+        """
+        try:
+            self._prepare()
+            fd, tmp_path = tempfile.mkstemp(dir=self.path, prefix=".tmp-", suffix=".npz")
+            with os.fdopen(fd, "wb") as f:
+                np.savez(f, **arr)
+            self._publish(tmp_path, "heatmaps.npz")
+        except OSError:
+            pass
@@ -5,6 +5,7 @@ and is interfaced via the python CFFI module.
 """
 
 import functools
+import concurrent.futures
 
 import cffi
 import ctypes
@@ -70,29 +71,69 @@ _mod_names = [
     "APXC",
     "APMPI",
     "HEATMAP",
+    "DXT_STDIO",
+    "BATCHIO",
+    "OVERHEAD",
+    "LATENCY",
+    "TIMESERIES",
+    "CUFILE",
+    "MMAP",
+    "ROLLUP",
+    "PHASE",
+    "ATTRIB",
 ]
 def mod_name_to_idx(mod_name):
     return _mod_names.index(mod_name)
 
 _structdefs = {
+    "BATCHIO": "struct darshan_batchio_record **",
     "BG/Q": "struct darshan_bgq_record **",
+    "CUFILE": "struct darshan_cufile_record **",
+    "MMAP": "struct darshan_mmap_record **",
+    "ROLLUP": "struct darshan_rollup_record **",
+    "PHASE": "struct darshan_phase_record **",
+    "ATTRIB": "struct darshan_attrib_record **",
     "DXT_MPIIO": "struct dxt_file_record **",
     "DXT_POSIX": "struct dxt_file_record **",
+    "DXT_STDIO": "struct dxt_file_record **",
     "HEATMAP": "struct darshan_heatmap_record **",
     "H5F": "struct darshan_hdf5_file **",
     "H5D": "struct darshan_hdf5_dataset **",
+    "LATENCY": "struct darshan_latency_record **",
     "LUSTRE": "struct darshan_lustre_record **",
     "MPI-IO": "struct darshan_mpiio_file **",
+    "OVERHEAD": "struct darshan_overhead_record **",
     "PNETCDF_FILE": "struct darshan_pnetcdf_file **",
     "PNETCDF_VAR": "struct darshan_pnetcdf_var **",
     "POSIX": "struct darshan_posix_file **",
     "STDIO": "struct darshan_stdio_file **",
+    "TIMESERIES": "struct darshan_timeseries_record **",
     "APXC-HEADER": "struct darshan_apxc_header_record **",
     "APXC-PERF": "struct darshan_apxc_perf_record **",
     "APMPI-HEADER": "struct darshan_apmpi_header_record **",
     "APMPI-PERF": "struct darshan_apmpi_perf_record **",
 }
 
+# modules with fixed-size records, which can be read in batches
+_batch_mods = [
+    "POSIX",
+    "MPI-IO",
+    "H5F",
+    "H5D",
+    "PNETCDF_FILE",
+    "PNETCDF_VAR",
+    "STDIO",
+    "BATCHIO",
+    "OVERHEAD",
+    "LATENCY",
+    "TIMESERIES",
+    "CUFILE",
+    "MMAP",
+    "ROLLUP",
+    "PHASE",
+    "ATTRIB",
+]
+
 
 
 def get_lib_version():
@@ -263,16 +304,12 @@ def log_get_name_records(log):
         return log['name_records']
 
 
-    name_records = {}
-
-    nrecs = ffi.new("struct darshan_name_record **")
-    cnt = ffi.new("int *")
-    libdutil.darshan_log_get_name_records(log['handle'], nrecs, cnt)
-
-    for i in range(0, cnt[0]):
-        name_records[nrecs[0][i].id] = ffi.string(nrecs[0][i].name).decode("utf-8")
-        libdutil.darshan_free(nrecs[0][i].name)
-    libdutil.darshan_free(nrecs[0])
+    table = ffi.new("struct darshan_name_table **")
+    r = libdutil.darshan_log_get_name_table(log['handle'], table)
+    if r < 0:
+        return {}
+    name_records = _name_table_to_dict(table[0])
+    libdutil.darshan_name_table_free(table[0])
 
     # add to cache
     log['name_records'] = name_records
@@ -301,19 +338,73 @@ def log_lookup_name_records(log, ids=[]):
 
     whitelistp = ffi.from_buffer(whitelist)
 
-    nrecs = ffi.new("struct darshan_name_record **")
-    cnt = ffi.new("int *")
-    libdutil.darshan_log_get_filtered_name_records(log['handle'], nrecs, cnt, ffi.cast("darshan_record_id *", whitelistp), whitelist_cnt)
+    table = ffi.new("struct darshan_name_table **")
+    r = libdutil.darshan_log_get_filtered_name_table(log['handle'], table, ffi.cast("darshan_record_id *", whitelistp), whitelist_cnt)
+    if r < 0:
+        return name_records
+    name_records = _name_table_to_dict(table[0])
+    libdutil.darshan_name_table_free(table[0])
 
-    for i in range(0, cnt[0]):
-        name_records[nrecs[0][i].id] = ffi.string(nrecs[0][i].name).decode("utf-8")
-        libdutil.darshan_free(nrecs[0][i].name)
-    libdutil.darshan_free(nrecs[0])
+    return name_records
 
-    # add to cache
-    log['name_records'] = name_records
 
-    return name_records
+def log_get_name_record_arrays(log):
+    """
+    Returns all name records of the log as an array of record ids, sorted
+    ascending, and a list of the matching names.
+
+    Unlike log_get_name_records(), no dictionary is built, and the names
+    are decoded in bulk rather than one at a time.
+
+    Args:
+        log: handle returned by darshan.open
+
+    Return:
+        tuple: (ids, names)
+    """
+    table = ffi.new("struct darshan_name_table **")
+    r = libdutil.darshan_log_get_name_table(log['handle'], table)
+    if r < 0:
+        return np.empty(0, dtype=np.uint64), []
+    ids, names = _name_table_to_arrays(table[0])
+    libdutil.darshan_name_table_free(table[0])
+
+    return ids, names
+
+
+def _name_table_to_arrays(table):
+    """
+    Converts a name table returned by darshan-util into an array of record
+    ids and a list of the matching names.
+    """
+    count = table.count
+    if count == 0:
+        return np.empty(0, dtype=np.uint64), []
+    entries = np.frombuffer(ffi.buffer(table.entries,
+            count * ffi.sizeof("struct darshan_name_table_entry")),
+            dtype=[('id', np.uint64), ('name_off', np.uint64)])
+    offs = entries['name_off'].astype(np.int64)
+
+    # the names are stored back to back, each terminated by a NUL, so
+    # decode them all at once and map each offset to the name starting there
+    last = int(offs.max())
+    size = last + len(ffi.string(table.names + last)) + 1
+    raw = ffi.buffer(table.names, size)[:]
+    nuls = np.flatnonzero(np.frombuffer(raw, dtype=np.uint8) == 0)
+    starts = np.concatenate([[0], nuls[:-1] + 1])
+    parts = raw.decode("utf-8").split('\0')
+    idx = np.searchsorted(starts, offs).tolist()
+
+    return entries['id'].copy(), [parts[i] for i in idx]
+
+
+def _name_table_to_dict(table):
+    """
+    Converts a name table returned by darshan-util into a dictionary
+    mapping record ids to names.
+    """
+    ids, names = _name_table_to_arrays(table)
+    return dict(zip(ids.tolist(), names))
 
 
 
@@ -336,7 +427,7 @@ def log_get_record(log, mod, dtype='numpy'):
         rec = _log_get_lustre_record(log, dtype=dtype)
     elif mod in ['HEATMAP']:
         rec = _log_get_heatmap_record(log)
-    elif mod in ['DXT_POSIX', 'DXT_MPIIO']:
+    elif mod in ['DXT_POSIX', 'DXT_MPIIO', 'DXT_STDIO']:
         rec = log_get_dxt_record(log, mod, dtype=dtype)
     else:
         rec = log_get_generic_record(log, mod, dtype=dtype)
@@ -381,19 +472,302 @@ def log_get_generic_record(log, mod_name, dtype='numpy'):
 
     return rec
 
+def log_get_generic_records(log, mod_name, dtype='numpy', batch_size=4096):
+    """
+    Returns a list of dictionaries holding the remaining generic darshan log
+    records of a module, in the same format as log_get_generic_record().
+
+    Modules with fixed-size records are read batch_size records at a time
+    directly into a numpy structured array, rather than one record per call.
+
+    Args:
+        log: Handle returned by darshan.open
+        mod_name (str): Name of the Darshan module
+        batch_size (int): number of records to read per library call
+
+    Return:
+        list: generic log records
+    """
+    recs = []
+    modules = log_get_modules(log)
+    if mod_name not in modules:
+        return recs
+
+    if mod_name not in _batch_mods:
+        rec = log_get_generic_record(log, mod_name, dtype)
+        while rec is not None:
+            recs.append(rec)
+            rec = log_get_generic_record(log, mod_name, dtype)
+        return recs
+
+    arr = log_get_generic_record_arrays(log, mod_name, batch_size)
+    return _make_generic_records_from_arrays(arr, mod_name, dtype)
+
+def _make_generic_records_from_arrays(arr, mod_name, dtype='numpy'):
+    """
+    Returns a list of record dictionaries for records given as a dictionary
+    of arrays, in the format of log_get_generic_record_arrays().
+    """
+    recs = []
+    for i in range(0, len(arr['id'])):
+        file_rec_id = None
+        if 'file_rec_id' in arr:
+            file_rec_id = arr['file_rec_id'][i]
+        recs.append(_make_generic_record_from_arrays(arr['id'][i],
+            arr['rank'][i], file_rec_id, arr['counters'][i],
+            arr['fcounters'][i], mod_name, dtype))
+
+    return recs
+
+def log_get_generic_record_arrays(log, mod_name, batch_size=16384):
+    """
+    Returns the remaining records of a module with fixed-size records as a
+    dictionary of numpy arrays: 'id' and 'rank' (and 'file_rec_id' for H5D
+    and PNETCDF_VAR) hold one value per record, and 'counters' and
+    'fcounters' hold one row per record.
+
+    The library writes each batch of records directly into a preallocated
+    numpy structured array, so no work is done per record in Python.
+
+    Args:
+        log: Handle returned by darshan.open
+        mod_name (str): Name of the Darshan module
+        batch_size (int): number of records to read per library call
+
+    Return:
+        dict: one array per record field
+    """
+    modules = log_get_modules(log)
+    if mod_name not in modules or mod_name not in _batch_mods:
+        return None
+
+    chunks = list(_iter_generic_record_batches(log, mod_name, batch_size))
+    if chunks:
+        recs = np.concatenate(chunks)
+    else:
+        recs = np.empty(0, dtype=_generic_record_dtype(mod_name))
+    return _split_generic_record_batch(recs)
+
+def log_iter_generic_record_arrays(log, mod_name, batch_size=16384):
+    """
+    Iterates over the remaining records of a module with fixed-size records
+    batch_size records at a time, yielding each batch as a dictionary of
+    numpy arrays in the format of log_get_generic_record_arrays().
+
+    Args:
+        log: Handle returned by darshan.open
+        mod_name (str): Name of the Darshan module
+        batch_size (int): maximum number of records per batch
+
+    Return:
+        iterator of dicts: one array per record field
+    """
+    modules = log_get_modules(log)
+    if mod_name not in modules or mod_name not in _batch_mods:
+        return
+
+    for recs in _iter_generic_record_batches(log, mod_name, batch_size):
+        yield _split_generic_record_batch(recs)
+
+def _iter_generic_record_batches(log, mod_name, batch_size):
+    """
+    Iterates over the remaining records of a module, read by the library
+    directly into preallocated numpy structured arrays of batch_size records.
+    """
+    modules = log_get_modules(log)
+    rec_dtype = _generic_record_dtype(mod_name)
+    n = ffi.new("int *")
+    while True:
+        chunk = np.empty(batch_size, dtype=rec_dtype)
+        r = libdutil.darshan_log_get_records_batch(log['handle'],
+                modules[mod_name]['idx'], ffi.from_buffer(chunk), batch_size, n)
+        if r < 0 or n[0] == 0:
+            return
+        yield chunk[:n[0]]
+
+def _split_generic_record_batch(recs):
+    """
+    Returns a structured array of records as one contiguous array per field.
+    """
+    return {name: np.ascontiguousarray(recs[name]) for name in recs.dtype.names}
+
+@functools.lru_cache(maxsize=32)
+def _generic_record_dtype(mod_name):
+    """
+    Returns a numpy structured dtype matching the layout of a module's
+    record structure.
+    """
+    ctype = ffi.typeof(_structdefs[mod_name].replace(" **", ""))
+    fields = dict(ctype.fields)
+    base_off = fields['base_rec'].offset
+
+    names = ['id', 'rank']
+    formats = [np.uint64, np.int64]
+    offsets = [base_off, base_off + ffi.sizeof("darshan_record_id")]
+    if 'file_rec_id' in fields:
+        names.append('file_rec_id')
+        formats.append(np.uint64)
+        offsets.append(fields['file_rec_id'].offset)
+    names += ['counters', 'fcounters']
+    formats += [(np.int64, fields['counters'].type.length),
+                (np.float64, fields['fcounters'].type.length)]
+    offsets += [fields['counters'].offset, fields['fcounters'].offset]
+
+    return np.dtype({'names': names, 'formats': formats, 'offsets': offsets,
+                     'itemsize': ffi.sizeof(ctype)})
+
+def log_get_columns(log, mod_name, names, batch_size=65536):
+    """
+    Returns the values of the given fields for all remaining records of a
+    module with fixed-size records, as a dictionary of numpy arrays keyed
+    by field name.
+
+    For logs written in the columnar layout (DARSHAN_LOG_COLUMNAR), only
+    the requested counters are decompressed.
+
+    Args:
+        log: Handle returned by darshan.open
+        mod_name (str): Name of the Darshan module
+        names (list): 'id', 'rank', 'file_rec_id' or counter names
+        batch_size (int): number of records to read per library call
+
+    Return:
+        dict: one array per requested field
+    """
+    modules = log_get_modules(log)
+    if mod_name not in modules or mod_name not in _batch_mods:
+        return None
+
+    rec_dtype = _generic_record_dtype(mod_name)
+    cnames = counter_names(mod_name)
+    fnames = fcounter_names(mod_name)
+    cols = []
+    types = []
+    for name in names:
+        if name in rec_dtype.names:
+            off = rec_dtype.fields[name][1]
+            types.append(rec_dtype.fields[name][0])
+        elif name in cnames:
+            off = rec_dtype.fields['counters'][1] + 8 * cnames.index(name)
+            types.append(np.int64)
+        elif name in fnames:
+            off = rec_dtype.fields['fcounters'][1] + 8 * fnames.index(name)
+            types.append(np.float64)
+        else:
+            raise ValueError("unknown {0} field: {1}".format(mod_name, name))
+        cols.append(off // 8)
+
+    c_cols = ffi.new("int[]", cols)
+    buf = ffi.new("char[]", batch_size * len(cols) * 8)
+    n = ffi.new("int *")
+    chunks = []
+    while True:
+        r = libdutil.darshan_log_get_columns(log['handle'],
+                modules[mod_name]['idx'], c_cols, len(cols), buf, batch_size, n)
+        if r < 0 or n[0] == 0:
+            break
+        chunks.append(np.copy(np.frombuffer(ffi.buffer(buf, n[0] * len(cols) * 8),
+                dtype=np.uint64).reshape(n[0], len(cols))))
+
+    vals = np.concatenate(chunks) if chunks else np.empty((0, len(cols)), dtype=np.uint64)
+    return {name: np.ascontiguousarray(vals[:, i]).view(types[i])
+            for i, name in enumerate(names)}
+
+def log_get_generic_record_by_id(log, mod_name, rec_id, dtype='numpy'):
+    """
+    Returns a dictionary holding the generic darshan log record with the
+    given record id, or None if there is no such record.
+
+    Logs written with a block index (DARSHAN_LOG_INDEX_BLOCK_RECS) only
+    decompress the blocks that may hold the record; other logs are scanned.
+    Afterwards, reading records of this module restarts at the first record.
+
+    Args:
+        log: Handle returned by darshan.open
+        mod_name (str): Name of the Darshan module
+        rec_id (int): Darshan record id
+
+    Return:
+        dict: generic log record
+    """
+    modules = log_get_modules(log)
+    if mod_name not in modules:
+        return None
+    mod_type = _structdefs[mod_name]
+
+    buf = ffi.new("void **")
+    r = libdutil.darshan_log_get_record_by_id(log['handle'],
+            modules[mod_name]['idx'], rec_id, buf)
+    if r < 1:
+        libdutil.darshan_free(buf[0])
+        return None
+    rbuf = ffi.cast(mod_type, buf)
+
+    rec = _make_generic_record(rbuf, mod_name, dtype)
+    libdutil.darshan_free(buf[0])
+
+    return rec
+
+def log_rewind_mod(log, mod_name):
+    """
+    Restarts reading the records of a module at its first record.
+
+    Args:
+        log: Handle returned by darshan.open
+        mod_name (str): Name of the Darshan module
+
+    Return:
+        bool: True if the module's records will be read again
+    """
+    modules = log_get_modules(log)
+    if mod_name not in modules:
+        return False
+    r = libdutil.darshan_log_select_block(log['handle'], modules[mod_name]['idx'], -1)
+    return r == 0
+
+def log_prefetch_mods(log, nthreads=0):
+    """
+    Decompresses the data of all modules in the log concurrently, so that
+    subsequent record reads are served from memory.
+
+    Reading records of any module restarts at the first record afterwards.
+
+    Args:
+        log: Handle returned by darshan.open
+        nthreads (int): number of threads to use, 0 for one per processor
+
+    Return:
+        bool: True if all module data was decompressed
+    """
+    r = libdutil.darshan_log_prefetch_mods(log['handle'], nthreads)
+    return r == 0
+
 def _make_generic_record(rbuf, mod_name, dtype='numpy'):
     """
     Returns a record dictionary for an input record buffer for a given module.
     """
-    rec = {}
-    rec['id'] = rbuf[0].base_rec.id
-    rec['rank'] = rbuf[0].base_rec.rank
+    file_rec_id = None
     if mod_name == 'H5D' or mod_name == 'PNETCDF_VAR':
-        rec['file_rec_id'] = rbuf[0].file_rec_id
+        file_rec_id = rbuf[0].file_rec_id
 
     clst = np.copy(np.frombuffer(ffi.buffer(rbuf[0].counters), dtype=np.int64))
     flst = np.copy(np.frombuffer(ffi.buffer(rbuf[0].fcounters), dtype=np.float64))
 
+    return _make_generic_record_from_arrays(rbuf[0].base_rec.id,
+            rbuf[0].base_rec.rank, file_rec_id, clst, flst, mod_name, dtype)
+
+def _make_generic_record_from_arrays(rec_id, rank, file_rec_id, clst, flst,
+        mod_name, dtype='numpy'):
+    """
+    Returns a record dictionary for the given record fields and counter
+    arrays of a given module.
+    """
+    rec = {}
+    rec['id'] = int(rec_id)
+    rec['rank'] = int(rank)
+    if file_rec_id is not None:
+        rec['file_rec_id'] = int(file_rec_id)
+
     c_cols = counter_names(mod_name)
     fc_cols = fcounter_names(mod_name)
 
@@ -426,6 +800,22 @@ def _make_generic_record(rbuf, mod_name, dtype='numpy'):
         rec['fcounters'] = df_fc
     return rec
 
+def _make_generic_records_df(arr, mod_name):
+    """
+    Returns a single record dictionary holding the records of a module,
+    given as arrays by log_get_generic_record_arrays(), as counter and
+    fcounter dataframes with one row per record. The layout is the same as
+    that of concatenated 'pandas' records from _make_generic_record().
+    """
+    df_c = pd.DataFrame(arr['counters'], columns=counter_names(mod_name))
+    df_fc = pd.DataFrame(arr['fcounters'], columns=fcounter_names(mod_name))
+    df_c.insert(0, 'rank', arr['rank'])
+    df_c.insert(0, 'id', arr['id'])
+    df_fc.insert(0, 'rank', arr['rank'].astype(np.float64))
+    df_fc.insert(0, 'id', arr['id'])
+
+    return {'rank': -1, 'id': -1, 'counters': df_c, 'fcounters': df_fc}
+
 @functools.lru_cache(maxsize=32)
 def counter_names(mod_name, fcnts=False, special=''):
     """
@@ -508,6 +898,18 @@ def _log_get_lustre_record(log, dtype='numpy'):
     rec['id'] = rbuf[0].base_rec.id
     rec['rank'] = rbuf[0].base_rec.rank
 
+    # the per-job OST traffic record holds per-OST counters, not components
+    if rbuf[0].num_comps == -1:
+        rec['components'] = []
+        rec['ost_traffic'] = {}
+        for i in range(0, rbuf[0].num_stripes):
+            counters = np.copy(np.frombuffer(ffi.buffer(rbuf[0].ost_traffic[i].counters), dtype=np.int64))
+            if dtype in ["dict", "pandas"]:
+                counters = dict(zip(counter_names('LUSTRE_OST'), counters))
+            rec['ost_traffic'][rbuf[0].ost_traffic[i].ost_id] = counters
+        libdutil.darshan_free(buf[0])
+        return rec
+
     # components
     rec['components'] = []
     ost_ids = ffi.cast("int64_t *", rbuf[0].ost_ids)
@@ -608,42 +1010,235 @@ def log_get_dxt_record(log, mod_name, reads=True, writes=True, dtype='dict'):
 
     rec['write_count'] = wcnt
     rec['read_count'] = rcnt
- 
-    rec['write_segments'] = []
-    rec['read_segments'] = []
+    rec['write_dropped'] = filerec[0].write_dropped
+    rec['read_dropped'] = filerec[0].read_dropped
 
+    segs = _copy_dxt_segments(buf[0], wcnt + rcnt)
+    libdutil.darshan_free(buf[0])
 
-    size_of = ffi.sizeof("struct dxt_file_record")
-    segments = ffi.cast("struct segment_info *", buf[0] + size_of  )
+    # write segments are stored before the read segments
+    wsegs = segs[:wcnt] if writes else segs[:0]
+    rsegs = segs[wcnt:] if reads else segs[:0]
 
+    if dtype == "pandas":
+        rec['write_segments'] = _dxt_segments_to_df(wsegs)
+        rec['read_segments'] = _dxt_segments_to_df(rsegs)
+    else:
+        rec['write_segments'] = _dxt_segments_to_list(wsegs)
+        rec['read_segments'] = _dxt_segments_to_list(rsegs)
 
-    for i in range(wcnt):
-        seg = {
-            "offset": segments[i].offset,
-            "length": segments[i].length,
-            "start_time": segments[i].start_time,
-            "end_time": segments[i].end_time
-        }
-        rec['write_segments'].append(seg)
+    return rec
 
+def log_get_dxt_segments(log, mod_name, reads=True, writes=True):
+    """
+    Returns the trace segments of all remaining records of a DXT module as
+    a single DataFrame.
 
-    for i in range(rcnt):
-        i = i + wcnt
-        seg = {
-            "offset": segments[i].offset,
-            "length": segments[i].length,
-            "start_time": segments[i].start_time,
-            "end_time": segments[i].end_time
-        }
-        rec['read_segments'].append(seg)
+    The segments of each record are copied out of the library's buffer as a
+    numpy structured array, and the DataFrame is built column-wise from the
+    concatenated arrays, without any per-segment Python work.
 
+    Args:
+        log: Handle returned by darshan.open
+        mod_name (str): Name of the DXT module
+        reads (bool): include read segments
+        writes (bool): include write segments
 
-    if dtype == "pandas":
-        rec['read_segments'] = pd.DataFrame(rec['read_segments'])
-        rec['write_segments'] = pd.DataFrame(rec['write_segments'])
+    Return:
+        DataFrame: one row per segment, with columns 'id', 'rank',
+        'hostname', 'op' ('write' or 'read'), 'offset', 'length',
+        'start_time', 'end_time' and 'thread_id'
+    """
+    modules = log_get_modules(log)
+    if mod_name not in modules:
+        return None
 
-    libdutil.darshan_free(buf[0])
-    return rec
+    return next(log_iter_dxt_segments(log, mod_name, reads=reads,
+                                      writes=writes, chunk=None))
+
+def log_iter_dxt_segments(log, mod_name, reads=True, writes=True,
+                          ranks=None, t0=0.0, t1=None, chunk=1000000):
+    """
+    Yields the trace segments of the remaining records of a DXT module as
+    DataFrames in the format of log_get_dxt_segments(), each holding the
+    segments of whole records, until at least 'chunk' segments are
+    collected. Only one chunk is held in memory at a time.
+
+    Records of other ranks, and records without segments in the time
+    window, are skipped by darshan-util, without decoding their segments
+    if the log stores the time range of each record. Segments outside the
+    time window are dropped from the remaining records.
+
+    Args:
+        log: Handle returned by darshan.open
+        mod_name (str): Name of the DXT module
+        reads (bool): include read segments
+        writes (bool): include write segments
+        ranks (iterable): ranks whose records are included (default: all)
+        t0 (float): start of the time window in seconds
+        t1 (float): end of the time window in seconds (default: no end)
+        chunk (int): number of segments per DataFrame (default: 1000000);
+            None collects all segments into a single DataFrame
+
+    Yields:
+        DataFrame: one row per segment; if no segments are read at all, a
+        single empty DataFrame is yielded
+    """
+    modules = log_get_modules(log)
+    if mod_name not in modules:
+        return
+    mod_type = _structdefs[mod_name]
+
+    filt = ffi.new("struct dxt_log_filter *")
+    if ranks is not None:
+        rank_ranges = _rank_ranges(ranks)
+        # keep the C array alive for as long as the filter is used
+        c_rank_ranges = ffi.new("int64_t[]", rank_ranges.tolist())
+        filt.rank_ranges = c_rank_ranges
+        filt.rank_range_count = len(rank_ranges) // 2
+    filt.start_time = t0
+    filt.end_time = -1 if t1 is None else t1
+    window = t0 > 0 or t1 is not None
+
+    chunks = []
+    ids = []
+    rec_ranks = []
+    host_codes = []
+    hostnames = {}
+    # number of write and read segments kept for each record, interleaved
+    counts = []
+    nsegs = 0
+    nframes = 0
+
+    buf = ffi.new("void **")
+    while True:
+        buf[0] = ffi.NULL
+        r = libdutil.dxt_log_get_filtered_file(log['handle'],
+                modules[mod_name]['idx'], filt, buf)
+        if r < 1:
+            break
+        filerec = ffi.cast(mod_type, buf)
+        wcnt = filerec[0].write_count
+        rcnt = filerec[0].read_count
+        hostname = ffi.string(filerec[0].hostname).decode("utf-8")
+        ids.append(filerec[0].base_rec.id)
+        rec_ranks.append(filerec[0].base_rec.rank)
+        host_codes.append(hostnames.setdefault(hostname, len(hostnames)))
+
+        segs = _copy_dxt_segments(buf[0], wcnt + rcnt)
+        libdutil.darshan_free(buf[0])
+        wsegs = segs[:wcnt] if writes else segs[:0]
+        rsegs = segs[wcnt:] if reads else segs[:0]
+        if window:
+            wsegs = wsegs[_dxt_segments_in_window(wsegs, t0, t1)]
+            rsegs = rsegs[_dxt_segments_in_window(rsegs, t0, t1)]
+        chunks += [wsegs, rsegs]
+        counts += [len(wsegs), len(rsegs)]
+        nsegs += len(wsegs) + len(rsegs)
+
+        if chunk is not None and nsegs >= chunk:
+            yield _dxt_segments_frame(chunks, ids, rec_ranks, host_codes,
+                                      hostnames, counts)
+            nframes += 1
+            chunks, ids, rec_ranks, host_codes, counts = [], [], [], [], []
+            nsegs = 0
+
+    if ids or nframes == 0:
+        yield _dxt_segments_frame(chunks, ids, rec_ranks, host_codes,
+                                  hostnames, counts)
+
+def _dxt_segments_frame(chunks, ids, ranks, host_codes, hostnames, counts):
+    """
+    Returns a DataFrame of the segments read from DXT records, given the
+    segment arrays of the records (write and read segments interleaved),
+    and the id, rank, hostname code and segment counts of each record.
+    """
+    if chunks:
+        segs = np.concatenate(chunks)
+    else:
+        segs = np.empty(0, dtype=_dxt_segment_dtype())
+    counts = np.array(counts, dtype=np.int64)
+    rec_counts = counts[0::2] + counts[1::2]
+
+    df = pd.DataFrame({
+        'id': np.repeat(np.array(ids, dtype=np.uint64), rec_counts),
+        'rank': np.repeat(np.array(ranks, dtype=np.int64), rec_counts),
+        'hostname': pd.Categorical.from_codes(
+            np.repeat(np.array(host_codes, dtype=np.int64), rec_counts),
+            categories=list(hostnames)),
+        'op': pd.Categorical.from_codes(
+            np.repeat(np.tile(np.array([0, 1], dtype=np.int64), len(ids)), counts),
+            categories=['write', 'read']),
+    })
+    for name in segs.dtype.names:
+        df[name] = segs[name]
+
+    return df
+
+def _dxt_segments_in_window(segs, t0, t1):
+    """
+    Returns a mask of the segments overlapping the time window from 't0'
+    to 't1' seconds (no upper bound if 't1' is None).
+    """
+    mask = segs['end_time'] >= t0
+    if t1 is not None:
+        mask &= segs['start_time'] <= t1
+    return mask
+
+def _rank_ranges(ranks):
+    """
+    Returns the given ranks as inclusive ranges of consecutive ranks,
+    flattened to [first0, last0, first1, last1, ...].
+    """
+    ranks = np.unique(np.fromiter(ranks, dtype=np.int64))
+    if len(ranks) == 0:
+        # a range that matches no rank
+        return np.array([0, -1], dtype=np.int64)
+    breaks = np.flatnonzero(np.diff(ranks) != 1) + 1
+    firsts = ranks[np.concatenate(([0], breaks))]
+    lasts = ranks[np.concatenate((breaks - 1, [len(ranks) - 1]))]
+    return np.column_stack((firsts, lasts)).ravel()
+
+@functools.lru_cache(maxsize=1)
+def _dxt_segment_dtype():
+    """
+    Returns a numpy structured dtype matching the layout of struct
+    segment_info.
+    """
+    ctype = ffi.typeof("struct segment_info")
+    fields = dict(ctype.fields)
+    names = ['offset', 'length', 'start_time', 'end_time', 'thread_id']
+    formats = [np.int64, np.int64, np.float64, np.float64, np.int64]
+
+    return np.dtype({'names': names, 'formats': formats,
+                     'offsets': [fields[name].offset for name in names],
+                     'itemsize': ffi.sizeof(ctype)})
+
+def _copy_dxt_segments(rec_buf, count):
+    """
+    Returns a copy of the 'count' trace segments following the DXT file
+    record at 'rec_buf' as a numpy structured array.
+    """
+    seg_dtype = _dxt_segment_dtype()
+    if count == 0:
+        return np.empty(0, dtype=seg_dtype)
+    segments = ffi.cast("char *", rec_buf) + ffi.sizeof("struct dxt_file_record")
+
+    return np.copy(np.frombuffer(ffi.buffer(segments, count * seg_dtype.itemsize),
+                   dtype=seg_dtype))
+
+def _dxt_segments_to_df(segs):
+    """
+    Returns a DataFrame built column-wise from a segment array.
+    """
+    return pd.DataFrame({name: segs[name] for name in segs.dtype.names})
+
+def _dxt_segments_to_list(segs):
+    """
+    Returns a segment array as a list of dictionaries, one per segment.
+    """
+    names = segs.dtype.names
+    return [dict(zip(names, seg)) for seg in segs.tolist()]
 
 
 def _log_get_heatmap_record(log):
@@ -690,11 +1285,113 @@ def _log_get_heatmap_record(log):
 
     read_bins = np.copy(np.frombuffer(ffi.buffer(filerec[0].read_bins, sizeof_64*nbins), dtype = np.int64))
     rec['read_bins'] = read_bins
+
+    # optional write/read/metadata op count bins
+    for op in ['write_op_bins', 'read_op_bins', 'meta_op_bins']:
+        op_bins = getattr(filerec[0], op)
+        if op_bins == ffi.NULL:
+            continue
+        rec[op] = np.copy(np.frombuffer(ffi.buffer(op_bins, sizeof_64*nbins), dtype = np.int64))
     libdutil.darshan_free(buf[0])
     
     return rec
 
 
+# heatmap bin arrays, in the order they trail a heatmap record
+_heatmap_bin_names = ['write_bins', 'read_bins', 'write_op_bins', 'read_op_bins', 'meta_op_bins']
+
+def log_get_heatmap_arrays(log, batch_size=1024):
+    """
+    Returns all heatmap records of a log as a dictionary of numpy arrays
+    with one entry per record: 'id', 'rank', 'bin_width_seconds', 'nbins'
+    and 'flags', and a (records x bins) array for each of 'write_bins',
+    'read_bins', 'write_op_bins', 'read_op_bins' and 'meta_op_bins'. Op
+    count bins are zero for records without them (see 'flags'), and the
+    bins of records shorter than the longest record are zero padded.
+
+    Args:
+        log: Handle returned by darshan.open
+        batch_size (int): number of records to read per library call
+
+    Return:
+        dict: one array per field, or None if the log has no heatmap records
+    """
+    first = _log_get_heatmap_record(log)
+    if first is None:
+        return None
+
+    nbins = first['nbins']
+    arr = _log_get_heatmap_batches(log, nbins, batch_size)
+    if len(arr['nbins']) > 0 and arr['nbins'].max() > nbins:
+        # some records were truncated to the bins of the first one; the
+        # reader starts over at the first record, so read all of them again
+        nbins = int(arr['nbins'].max())
+        return _log_get_heatmap_batches(log, nbins, batch_size)
+
+    first_arr = {
+        'id': np.array([first['id']], dtype=np.uint64),
+        'rank': np.array([first['rank']], dtype=np.int64),
+        'bin_width_seconds': np.array([first['bin_width_seconds']], dtype=np.float64),
+        'nbins': np.array([nbins], dtype=np.int64),
+        'flags': np.array([1 if 'write_op_bins' in first else 0], dtype=np.int64),
+    }
+    for name in _heatmap_bin_names:
+        first_arr[name] = first.get(name, np.zeros(nbins, dtype=np.int64))[np.newaxis, :]
+    return {key: np.concatenate((first_arr[key], arr[key])) for key in arr}
+
+
+def _log_get_heatmap_batches(log, nbins, batch_size):
+    """
+    Reads the remaining heatmap records of a log in batches of
+    'batch_size' records, with 'nbins' bins per array, and returns them in
+    the format of log_get_heatmap_arrays().
+    """
+    narrays = len(_heatmap_bin_names)
+    ids = ffi.new("darshan_record_id[]", batch_size)
+    ranks = ffi.new("int64_t[]", batch_size)
+    bin_widths = ffi.new("double[]", batch_size)
+    rec_nbins = ffi.new("int64_t[]", batch_size)
+    flags = ffi.new("int64_t[]", batch_size)
+    bins = ffi.new("int64_t[]", batch_size * narrays * nbins)
+    n = ffi.new("int *")
+
+    chunks = []
+    while True:
+        r = libdutil.heatmap_log_get_bins(log['handle'], nbins, batch_size,
+                ids, ranks, bin_widths, rec_nbins, flags, bins, n)
+        if r < 0:
+            break
+        count = n[0]
+        chunks.append({
+            'id': np.frombuffer(ffi.buffer(ids, 8 * count), dtype=np.uint64).copy(),
+            'rank': np.frombuffer(ffi.buffer(ranks, 8 * count), dtype=np.int64).copy(),
+            'bin_width_seconds': np.frombuffer(ffi.buffer(bin_widths, 8 * count), dtype=np.float64).copy(),
+            'nbins': np.frombuffer(ffi.buffer(rec_nbins, 8 * count), dtype=np.int64).copy(),
+            'flags': np.frombuffer(ffi.buffer(flags, 8 * count), dtype=np.int64).copy(),
+            'bins': np.frombuffer(ffi.buffer(bins, 8 * count * narrays * nbins),
+                                  dtype=np.int64).reshape(count, narrays, nbins).copy(),
+        })
+        # fewer records than requested are only returned at the end of the log
+        if count < batch_size:
+            break
+
+    if chunks:
+        arr = {key: np.concatenate([chunk[key] for chunk in chunks]) for key in chunks[0]}
+    else:
+        arr = {
+            'id': np.empty(0, dtype=np.uint64),
+            'rank': np.empty(0, dtype=np.int64),
+            'bin_width_seconds': np.empty(0, dtype=np.float64),
+            'nbins': np.empty(0, dtype=np.int64),
+            'flags': np.empty(0, dtype=np.int64),
+            'bins': np.empty((0, narrays, nbins), dtype=np.int64),
+        }
+    bins = arr.pop('bins')
+    for i, name in enumerate(_heatmap_bin_names):
+        arr[name] = bins[:, i, :]
+    return arr
+
+
 def _df_to_rec(rec_dict, mod_name, rec_index_of_interest=None):
     """
     Pack the DataFrames-format PyDarshan data back into
@@ -748,7 +1445,7 @@ def _df_to_rec(rec_dict, mod_name, rec_index_of_interest=None):
     return buf
 
 
-def accumulate_records(rec_dict, mod_name, nprocs):
+def accumulate_records(rec_dict, mod_name, nprocs, nthreads=1):
     """
     Passes a set of records (in pandas format) to the Darshan accumulator
     interface, and returns the corresponding derived metrics struct and
@@ -758,39 +1455,158 @@ def accumulate_records(rec_dict, mod_name, nprocs):
         rec_dict: Dictionary containing the counter and fcounter dataframes.
         mod_name: Name of the Darshan module.
         nprocs: Number of processes participating in accumulation.
+        nthreads: Number of threads injecting records; each thread injects
+            a share of the records into its own accumulator, and the
+            accumulators are merged at the end.
 
     Returns:
         namedtuple containing derived_metrics (cdata object) and
         summary_record (dict).
     """
+    darshan_accumulator = _accumulate(rec_dict, mod_name, nprocs, nthreads)
+    try:
+        return _emit_accumulator(darshan_accumulator, mod_name)
+    finally:
+        libdutil.darshan_accumulator_destroy(darshan_accumulator)
+
+
+def summarize_records(rec_dicts, nprocs, file_categories=None,
+                      category_mods=("POSIX", "STDIO"), nthreads=1):
+    """
+    Passes the records of several modules (in pandas format) to the Darshan
+    accumulator interface, and returns all aggregates the summary report
+    derives from them. The records of each module are scanned once.
+
+    Parameters:
+        rec_dicts: Dictionary mapping module names to dictionaries
+            containing the counter and fcounter dataframes.
+        nprocs: Number of processes participating in accumulation.
+        file_categories: Optional tuple ``(ids, categories, ncategories)``
+            assigning the file record ids ``ids`` to the categories
+            ``categories`` (integers in ``range(ncategories)``, e.g. one
+            per file system), by which the data accessed in the files is
+            summed.
+        category_mods: Modules whose records are summed by category; a
+            file accessed through several of them is counted once.
+        nthreads: Number of threads injecting the records of each module
+            (see accumulate_records()).
+
+    Returns:
+        namedtuple containing:
+
+        - modules: dictionary mapping module names to the results of
+          accumulate_records()
+        - access_sizes: dictionary mapping the names of modules recording
+          common access sizes to DataFrames with the columns "Access Size"
+          and "Count", holding the number of accesses of each common access
+          size across all records, in order of increasing access size
+        - categories: DataFrame indexed by category, with the columns
+          bytes_read, bytes_written, files_read and files_written (files
+          with at least one byte read or written), or None if
+          ``file_categories`` is not given
+    """
+    accumulators = {}
+    try:
+        for mod_name, rec_dict in rec_dicts.items():
+            accumulators[mod_name] = _accumulate(rec_dict, mod_name, nprocs, nthreads)
+
+        modules = {}
+        access_sizes = {}
+        for mod_name, acc in accumulators.items():
+            modules[mod_name] = _emit_accumulator(acc, mod_name)
+            sizes = _emit_access_sizes(acc)
+            if sizes is not None:
+                access_sizes[mod_name] = sizes
+
+        categories = None
+        if file_categories is not None:
+            ids, cats, ncats = file_categories
+            cat_accs = [accumulators[mod] for mod in category_mods if mod in accumulators]
+            categories = _emit_categories(cat_accs, ids, cats, ncats)
+    finally:
+        for acc in accumulators.values():
+            libdutil.darshan_accumulator_destroy(acc)
+
+    RecordSummary = namedtuple("RecordSummary", ['modules', 'access_sizes', 'categories'])
+    return RecordSummary(modules, access_sizes, categories)
+
+
+def _accumulate(rec_dict, mod_name, nprocs, nthreads=1):
+    """
+    Injects a set of records (in pandas format) into a new accumulator,
+    using ``nthreads`` threads, and returns the accumulator. The caller
+    must destroy it.
+    """
     mod_idx = mod_name_to_idx(mod_name)
-    darshan_accumulator = ffi.new("darshan_accumulator *")
-    r = libdutil.darshan_accumulator_create(mod_idx, nprocs, darshan_accumulator)
-    if r != 0:
-        raise RuntimeError("A nonzero exit code was received from "
-                           "darshan_accumulator_create() at the C level. "
-                           f"This could mean that the {mod_name} module does not "
-                           "support derived metric calculation, or that "
-                           "another kind of error occurred. It may be possible "
-                           "to retrieve additional information from the stderr "
-                           "stream.")
+    num_recs = rec_dict["fcounters"].shape[0] if rec_dict else 0
+    nshards = max(1, min(nthreads, num_recs))
+    accumulators = []
+    for i in range(nshards):
+        darshan_accumulator = ffi.new("darshan_accumulator *")
+        r = libdutil.darshan_accumulator_create(mod_idx, nprocs, darshan_accumulator)
+        if r != 0:
+            for acc in accumulators:
+                libdutil.darshan_accumulator_destroy(acc)
+            raise RuntimeError("A nonzero exit code was received from "
+                               "darshan_accumulator_create() at the C level. "
+                               f"This could mean that the {mod_name} module does not "
+                               "support derived metric calculation, or that "
+                               "another kind of error occurred. It may be possible "
+                               "to retrieve additional information from the stderr "
+                               "stream.")
+        accumulators.append(darshan_accumulator[0])
 
-    num_recs = rec_dict["fcounters"].shape[0]
     record_array = _df_to_rec(rec_dict, mod_name)
 
-    r_i = libdutil.darshan_accumulator_inject(darshan_accumulator[0], record_array, num_recs)
+    # records of modules supporting the accumulator API have a fixed size,
+    # so the buffer can be split evenly between shards
+    rec_size = len(record_array) // num_recs if num_recs else 0
+    record_view = memoryview(record_array)
+
+    def inject_shard(shard):
+        if nshards == 1:
+            return libdutil.darshan_accumulator_inject(accumulators[0],
+                                                       record_array, num_recs)
+        first = (num_recs * shard) // nshards
+        last = (num_recs * (shard + 1)) // nshards
+        buf = ffi.from_buffer(record_view[first * rec_size:last * rec_size])
+        return libdutil.darshan_accumulator_inject(accumulators[shard], buf,
+                                                   last - first)
+
+    if nshards > 1:
+        # cffi releases the GIL during calls into darshan-util
+        with concurrent.futures.ThreadPoolExecutor(max_workers=nshards) as executor:
+            inject_rets = list(executor.map(inject_shard, range(nshards)))
+    else:
+        inject_rets = [inject_shard(0)]
+
+    # reduce the shards into the first accumulator
+    darshan_accumulator = accumulators[0]
+    r_i = next((r for r in inject_rets if r != 0), 0)
+    for acc in accumulators[1:]:
+        if r_i == 0:
+            r_i = libdutil.darshan_accumulator_merge(darshan_accumulator, acc)
+        libdutil.darshan_accumulator_destroy(acc)
     if r_i != 0:
+        libdutil.darshan_accumulator_destroy(darshan_accumulator)
         raise RuntimeError("A nonzero exit code was received from "
                            "darshan_accumulator_inject() at the C level. "
                            "It may be possible "
                            "to retrieve additional information from the stderr "
                            "stream.")
+    return darshan_accumulator
+
+
+def _emit_accumulator(darshan_accumulator, mod_name):
+    """
+    Returns the derived metrics and summary record of an accumulator, as
+    returned by accumulate_records().
+    """
     derived_metrics = ffi.new("struct darshan_derived_metrics *")
     summary_rbuf = ffi.new(_structdefs[mod_name].replace("**", "*"))
-    r = libdutil.darshan_accumulator_emit(darshan_accumulator[0],
+    r = libdutil.darshan_accumulator_emit(darshan_accumulator,
                                           derived_metrics,
                                           summary_rbuf)
-    libdutil.darshan_accumulator_destroy(darshan_accumulator[0])
     if r != 0:
         raise RuntimeError("A nonzero exit code was received from "
                            "darshan_accumulator_emit() at the C level. "
@@ -803,3 +1619,107 @@ def accumulate_records(rec_dict, mod_name, nprocs):
     # create namedtuple type to hold return values
     AccumulatedRecords = namedtuple("AccumulatedRecords", ['derived_metrics', 'summary_record'])
     return AccumulatedRecords(derived_metrics, summary_rec)
+
+
+def _emit_access_sizes(darshan_accumulator):
+    """
+    Returns the common access size histogram of an accumulator as a
+    DataFrame, or None if its module does not record common access sizes.
+    """
+    n = libdutil.darshan_accumulator_emit_access_sizes(darshan_accumulator, ffi.NULL, 0)
+    if n < 0:
+        return None
+    sizes = np.zeros(n, dtype=[('size', np.int64), ('count', np.int64)])
+    if n > 0:
+        libdutil.darshan_accumulator_emit_access_sizes(
+            darshan_accumulator,
+            ffi.cast("struct darshan_access_size *", ffi.from_buffer(sizes)), n)
+    return pd.DataFrame({"Access Size": sizes['size'], "Count": sizes['count']})
+
+
+def _emit_categories(accumulators, ids, categories, ncategories):
+    """
+    Returns the data accessed in the files seen by a list of accumulators,
+    summed by file category, as a DataFrame.
+    """
+    ids = np.ascontiguousarray(ids, dtype=np.uint64)
+    categories = np.ascontiguousarray(categories, dtype=np.intc)
+    cat_io = np.zeros(ncategories, dtype=[('bytes_read', np.int64),
+                                          ('bytes_written', np.int64),
+                                          ('files_read', np.int64),
+                                          ('files_written', np.int64)])
+    accs = ffi.new("darshan_accumulator[]", accumulators)
+    r = libdutil.darshan_accumulator_emit_categories(
+        accs, len(accumulators),
+        ffi.cast("uint64_t *", ffi.from_buffer(ids)),
+        ffi.cast("int *", ffi.from_buffer(categories)), len(ids),
+        ffi.cast("struct darshan_category_io *", ffi.from_buffer(cat_io)),
+        ncategories)
+    if r != 0:
+        raise RuntimeError("A nonzero exit code was received from "
+                           "darshan_accumulator_emit_categories() at the C level.")
+    return pd.DataFrame({name: cat_io[name] for name in cat_io.dtype.names})
+
+
+def agg_generic_record_arrays(arr, mod_name, by_id=True):
+    """
+    Aggregates records of a module with fixed-size records using the
+    module's darshan-util aggregation rules (the ones darshan-parser uses
+    for its --total output), e.g., counts and times are summed while
+    maximum offsets and access sizes keep their maximum.
+
+    Parameters:
+        arr: Dictionary of record arrays, in the format returned by
+            log_get_generic_record_arrays().
+        mod_name: Name of the Darshan module.
+        by_id: If True, the records of each record id are aggregated
+            separately; otherwise all records are aggregated into a
+            single record with id 0.
+
+    Returns:
+        dict: one array per record field, holding one aggregate record per
+        record id (in ascending id order), or a single aggregate record.
+        The rank of an aggregate record is -1 unless all of its records
+        share the same rank.
+    """
+    rec_dtype = _generic_record_dtype(mod_name)
+    num_recs = len(arr['id'])
+    recs = np.zeros(num_recs, dtype=rec_dtype)
+    for name in rec_dtype.names:
+        if name in arr:
+            recs[name] = arr[name]
+
+    if by_id:
+        recs = recs[np.argsort(recs['id'], kind='stable')]
+        ids, starts = np.unique(recs['id'], return_index=True)
+    elif num_recs > 0:
+        ids = np.zeros(1, dtype=np.uint64)
+        starts = np.zeros(1, dtype=np.int64)
+    else:
+        ids = np.zeros(0, dtype=np.uint64)
+        starts = np.zeros(0, dtype=np.int64)
+    counts = np.diff(np.append(starts, num_recs))
+
+    aggs = np.zeros(len(ids), dtype=rec_dtype)
+    mod_idx = mod_name_to_idx(mod_name)
+    rec_size = rec_dtype.itemsize
+    rec_buf = ffi.from_buffer(recs)
+    agg_buf = ffi.from_buffer(aggs)
+    # each group of records is combined by a single library call
+    for i, (start, count) in enumerate(zip(starts.tolist(), counts.tolist())):
+        r = libdutil.darshan_log_agg_records(mod_idx, rec_buf + start * rec_size,
+                count, rec_size, agg_buf + i * rec_size, 1)
+        if r != 0:
+            raise RuntimeError("A nonzero exit code was received from "
+                               "darshan_log_agg_records() at the C level. "
+                               f"This could mean that the {mod_name} module does "
+                               "not support record aggregation.")
+
+    aggs['id'] = ids
+    if len(ids) > 0:
+        min_rank = np.minimum.reduceat(recs['rank'], starts)
+        max_rank = np.maximum.reduceat(recs['rank'], starts)
+        aggs['rank'] = np.where(min_rank == max_rank, min_rank, -1)
+        if 'file_rec_id' in rec_dtype.names:
+            aggs['file_rec_id'] = recs['file_rec_id'][starts] if by_id else 0
+    return _split_generic_record_batch(aggs)
@@ -2,8 +2,10 @@
 list in the darshan log hash table.
 """
 import sys
+import json
 import argparse
 import darshan
+from darshan.backend import cffi_backend as backend
 
 
 
@@ -15,6 +17,7 @@ def setup_parser(parser=None):
 
     # setup arguments
     parser.add_argument('input', help='darshan log file', nargs='?', default='example.darshan')
+    parser.add_argument('--ndjson', help='write one JSON object per name record', action='store_true')
     parser.add_argument('--verbose', help='', action='store_true')
     parser.add_argument('--debug', help='', action='store_true')
 
@@ -31,10 +34,23 @@ def main(args=None):
     if args.debug:
         print(args)
 
-    report = darshan.DarshanReport(args.input, read_all=True)  # Default behavior
-    
-    for nrec, path in report.name_records.items():
-        print("{:<20} => {}".format(nrec, path))
+    # the name table is read and decoded in bulk, without reading
+    # any records
+    log = backend.log_open(args.input)
+    if not bool(log['handle']):
+        raise RuntimeError(f"Failed to open file {args.input}.")
+    try:
+        ids, names = backend.log_get_name_record_arrays(log)
+    finally:
+        backend.log_close(log)
+
+    if args.ndjson:
+        lines = (json.dumps({"id": nrec, "name": path}) + "\n"
+                 for nrec, path in zip(ids.tolist(), names))
+    else:
+        lines = ("{:<20} => {}\n".format(nrec, path)
+                 for nrec, path in zip(ids.tolist(), names))
+    sys.stdout.writelines(lines)
 
 
 if __name__ == "__main__":
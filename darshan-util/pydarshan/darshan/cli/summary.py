@@ -1,20 +1,25 @@
 import sys
 import os
 import io
+import re
+import time
 import base64
 import argparse
 import datetime
+import functools
+import concurrent.futures
 from collections import OrderedDict
+from contextlib import contextmanager
 import importlib.resources as importlib_resources
 
-from typing import Any, Union, Callable
+from typing import Any, Optional, Union, Callable
 
 import pandas as pd
 from mako.template import Template
 
 import darshan
 import darshan.cli
-from darshan.backend.cffi_backend import accumulate_records
+from darshan.backend.cffi_backend import accumulate_records, summarize_records
 from darshan.lib.accum import log_file_count_summary_table, log_module_overview_table
 from darshan.experimental.plots import (
     plot_dxt_heatmap,
@@ -29,6 +34,65 @@ from darshan.experimental.plots import (
 darshan.enable_experimental()
 
 
+@functools.lru_cache(maxsize=None)
+def _load_stylesheet() -> str:
+    """
+    Reads the report CSS once per process.
+    """
+    with importlib_resources.path(darshan.cli, "style.css") as path:
+        with open(path, "r") as f:
+            return "".join(f.readlines())
+
+
+@functools.lru_cache(maxsize=None)
+def _load_template() -> Template:
+    """
+    Compiles the base report template once per process.
+    """
+    with importlib_resources.path(darshan.cli, "base.html") as base_path:
+        return Template(filename=str(base_path))
+
+
+@contextmanager
+def _timed(timings: dict, stage: str):
+    """
+    Adds the wall time spent in the body of the
+    ``with`` statement to ``timings[stage]``.
+    """
+    start = time.perf_counter()
+    try:
+        yield
+    finally:
+        timings[stage] = timings.get(stage, 0.0) + time.perf_counter() - start
+
+
+def _cache_record_frames(report: darshan.report.DarshanReport):
+    """
+    Memoizes ``to_df()`` on the generic record collections of a report.
+
+    Most figures of a report start by converting the same module records
+    into dataframes; with the frames cached, each module is decoded
+    once and every caller receives its own copy of the frames.
+    """
+    for mod, recs in report.records.items():
+        if mod == "LUSTRE" or mod.startswith("DXT_"):
+            continue
+        recs.to_df = _cached_to_df(recs.to_df)
+
+
+def _cached_to_df(to_df: Callable) -> Callable:
+    cache = {}
+
+    @functools.wraps(to_df)
+    def wrapper(attach="default"):
+        key = tuple(attach) if isinstance(attach, list) else attach
+        if key not in cache:
+            cache[key] = to_df(attach=attach)
+        return {ct_key: df.copy() for ct_key, df in cache[key].items()}
+
+    return wrapper
+
+
 class ReportFigure:
     """
     Stores info for each figure in `ReportData.register_figures`.
@@ -87,6 +151,8 @@ class ReportFigure:
         # text, which doesn't really have an image...
         self.fig_html = None
         self.text_only_color = text_only_color
+        # wall time (in seconds) spent generating the figure
+        self.fig_time = 0.0
         if self.fig_func:
             self.generate_fig()
 
@@ -115,6 +181,7 @@ class ReportFigure:
         """
         # generate the figure using the figure's
         # function and function arguments
+        start = time.perf_counter()
         fig = self.fig_func(**self.fig_args)
         if hasattr(fig, "savefig"):
             # encode the matplotlib figure
@@ -127,6 +194,7 @@ class ReportFigure:
         else:
             err_msg = f"Figure of type {type(fig)} not supported."
             raise NotImplementedError(err_msg)
+        self.fig_time = time.perf_counter() - start
 
 class ReportData:
     """
@@ -138,28 +206,49 @@ class ReportData:
     log_path: path to a darshan log file.
     enable_dxt_heatmap: flag indicating whether DXT heatmaps should be enabled
 
+    Attributes
+    ----------
+    timings: wall time (in seconds) spent in each stage of building
+    the report, in order; figures are listed as ``figure: <title>``.
+
     """
     def __init__(self, log_path: str, enable_dxt_heatmap: bool = False):
         # store the log path and use it to generate the report
         self.log_path = log_path
         self.enable_dxt_heatmap = enable_dxt_heatmap
-        # store the report
-        self.report = darshan.DarshanReport(log_path, read_all=False)
-        # read only generic module data and heatmap data by default
-        self.report.read_all_generic_records()
-        if "HEATMAP" in self.report.data['modules']:
-            self.report.read_all_heatmap_records()
-        # if DXT heatmaps requested, additionally read-in DXT data
-        if self.enable_dxt_heatmap:
-            self.report.read_all_dxt_records()
-        # create the header/footer
-        self.get_header()
-        self.get_footer()
-        # create the metadata and module tables
-        self.get_metadata_table()
-        self.get_module_table()
+        self.timings = OrderedDict()
+        with _timed(self.timings, "read log"):
+            # store the report
+            self.report = darshan.DarshanReport(log_path, read_all=False)
+            # read only generic module data and heatmap data by default
+            self.report.read_all_generic_records()
+            if "HEATMAP" in self.report.data['modules']:
+                self.report.read_all_heatmap_records()
+            # if DXT heatmaps requested, additionally read-in DXT data
+            if self.enable_dxt_heatmap:
+                self.report.read_all_dxt_records()
+        # decode each module's records once for all figures
+        _cache_record_frames(self.report)
+        # and aggregate them once for all figures
+        with _timed(self.timings, "record summary"):
+            self.summarize_records()
+        with _timed(self.timings, "tables"):
+            # create the header/footer
+            self.get_header()
+            self.get_footer()
+            # create the metadata and module tables
+            self.get_metadata_table()
+            self.get_module_table()
         # register the report figures
-        self.register_figures()
+        with _timed(self.timings, "figures"):
+            self.register_figures()
+        for fig in self.figures:
+            if fig.fig_func:
+                title = re.sub(r"<[^>]*>|&nbsp;", " ", fig.fig_title)
+                stage = "figure: " + " ".join(title.split())
+                if fig.section_title.startswith("Per-Module"):
+                    stage += f" ({fig.section_title.split(': ')[-1]})"
+                self.timings[stage] = self.timings.get(stage, 0.0) + fig.fig_time
         # use the figure data to build the report sections
         self.build_sections()
         # collect the CSS stylesheet
@@ -210,6 +299,39 @@ class ReportData:
         runtime = f'{runtime_val:.4f}'
         return runtime
 
+    @staticmethod
+    def get_overhead(report: darshan.report.DarshanReport) -> Optional[str]:
+        """
+        Estimates the time Darshan itself cost the slowest process, from
+        the records of the OVERHEAD module.
+
+        Parameters
+        ----------
+        report: a ``darshan.DarshanReport``.
+
+        Returns
+        -------
+        overhead : the estimated time spent in Darshan's instrumentation,
+        initialization and shutdown, with its share of the run time, or
+        ``None`` for logs without OVERHEAD data.
+
+        """
+        if "OVERHEAD" not in report.modules:
+            return None
+        fcounters = report.records["OVERHEAD"].to_df()["fcounters"]
+        names = [report.name_records.get(int(rec_id)) for rec_id in fcounters["id"]]
+        core = fcounters[[name == "overhead:core" for name in names]]
+        if core.empty:
+            return None
+        overhead_val = (core["OVERHEAD_F_MAX_EST_TIME"].max() +
+                        core["OVERHEAD_F_INIT_TIME"].max() +
+                        core["OVERHEAD_F_SHUTDOWN_TIME"].max())
+        overhead = f"{overhead_val:.4f}"
+        runtime_val = report.metadata["job"]["run_time"]
+        if runtime_val > 0:
+            overhead += f" ({100 * overhead_val / runtime_val:.2f}% of run time)"
+        return overhead
+
     def get_header(self):
         """
         Builds the header string for the summary report.
@@ -247,6 +369,9 @@ class ReportData:
             "End Time": datetime.datetime.fromtimestamp(job_data["end_time_sec"]),
             "Command Line": self.get_full_command(report=self.report),
         }
+        overhead = self.get_overhead(report=self.report)
+        if overhead is not None:
+            metadata_dict["Darshan Overhead (s)"] = overhead
         # convert the dictionary into a dataframe
         metadata_df = pd.DataFrame.from_dict(data=metadata_dict, orient="index")
         # write out the table in html
@@ -288,11 +413,30 @@ class ReportData:
         """
         Retrieves the locally stored CSS.
         """
-        # get the path to the style sheet
-        with importlib_resources.path(darshan.cli, "style.css") as path:
-            # collect the css entries
-            with open(path, "r") as f:
-                self.stylesheet = "".join(f.readlines())
+        # the style sheet is read once and shared by all reports
+        self.stylesheet = _load_stylesheet()
+
+    def summarize_records(self):
+        """
+        Aggregates the POSIX, MPI-IO and STDIO records in a single pass per
+        module: derived metrics, summary records, common access sizes and
+        the data accessed per filesystem, which the figures share. If a
+        module's records cannot be aggregated, the figures compute their
+        data from the records themselves.
+        """
+        self.record_summary = None
+        self.category_io = None
+        try:
+            rec_dicts = {mod: self.report.records[mod].to_df()
+                         for mod in ["POSIX", "MPI-IO", "STDIO"]
+                         if mod in self.report.modules}
+            roots, ids, categories = data_access_by_filesystem.filesystem_categories(self.report)
+            self.record_summary = summarize_records(
+                rec_dicts, self.report.metadata['job']['nprocs'],
+                file_categories=(ids, categories, len(roots)))
+        except (RuntimeError, KeyError):
+            return
+        self.category_io = self.record_summary.categories.set_index(pd.Index(roots))
 
     def register_figures(self):
         """
@@ -380,12 +524,13 @@ class ReportData:
             "distribution across ranks."
         )
         modules_avail = set(self.report.modules)
-        hmap_modules = ["HEATMAP", "DXT_POSIX", "DXT_MPIIO"]
+        hmap_modules = ["HEATMAP", "DXT_POSIX", "DXT_MPIIO", "DXT_STDIO"]
         hmap_grid = OrderedDict([["HEATMAP_MPIIO", None],
                                  ["DXT_MPIIO", None],
                                  ["HEATMAP_POSIX", None],
                                  ["DXT_POSIX", None],
                                  ["HEATMAP_STDIO", None],
+                                 ["DXT_STDIO", None],
                                 ])
         if not set(hmap_modules).isdisjoint(modules_avail):
             for mod in hmap_modules:
@@ -510,8 +655,11 @@ class ReportData:
                     # get the module's record dataframe and then pass to
                     # Darshan accumulator interface to generate a cumulative
                     # record and derived metrics
-                    rec_dict = self.report.records[mod].to_df()
-                    acc = accumulate_records(rec_dict, mod, self.report.metadata['job']['nprocs'])
+                    if self.record_summary is not None:
+                        acc = self.record_summary.modules[mod]
+                    else:
+                        rec_dict = self.report.records[mod].to_df()
+                        acc = accumulate_records(rec_dict, mod, self.report.metadata['job']['nprocs'])
 
                     mod_overview_fig = ReportFigure(
                             section_title=sect_title,
@@ -587,7 +735,8 @@ class ReportData:
                     section_title=sect_title,
                     fig_title="Common Access Sizes",
                     fig_func=plot_common_access_table.plot_common_access_table,
-                    fig_args=dict(report=self.report, mod=mod),
+                    fig_args=dict(report=self.report, mod=mod,
+                                  access_sizes=self._access_sizes(mod)),
                     fig_description=com_acc_tbl_description,
                     fig_width=350,
                     fig_grid_area="common_acc_tbl"
@@ -600,7 +749,8 @@ class ReportData:
                     section_title=sect_title,
                     fig_title="Operation Counts",
                     fig_func=plot_opcounts,
-                    fig_args=dict(report=self.report, mod=mod),
+                    fig_args=dict(report=self.report, mod=mod,
+                                  op_counts=self._op_counts(mod)),
                     fig_description="Histogram of I/O operation frequency.",
                     fig_width=350,
                     fig_grid_area="op_counts"
@@ -615,7 +765,8 @@ class ReportData:
                 section_title="Data Access by Category",
                 fig_title="",
                 fig_func=data_access_by_filesystem.plot_with_report,
-                fig_args=dict(report=self.report, num_cats=8),
+                fig_args=dict(report=self.report, num_cats=8,
+                              category_io=self.category_io),
                 fig_description="Summary of data access volume "
                                 "categorized by storage "
                                 "target (e.g., file system "
@@ -626,6 +777,25 @@ class ReportData:
 
 
 
+    def _access_sizes(self, mod: str) -> Any:
+        """
+        Returns the common access sizes of a module from the record
+        summary, or None if they are not in it.
+        """
+        if self.record_summary is None:
+            return None
+        return self.record_summary.access_sizes.get(mod)
+
+    def _op_counts(self, mod: str) -> Any:
+        """
+        Returns the counter sums of a module from the record summary, or
+        None if they are not in it.
+        """
+        if self.record_summary is None or mod not in self.record_summary.modules:
+            return None
+        counters = self.record_summary.modules[mod].summary_record['counters']
+        return counters.iloc[0].to_dict()
+
     def build_sections(self):
         """
         Uses figure info to generate the unique sections
@@ -658,11 +828,36 @@ def setup_parser(parser: argparse.ArgumentParser):
         type=str,
         help="Specify path to darshan log.",
     )
+    parser.add_argument(
+        "more_log_paths",
+        type=str,
+        nargs="*",
+        metavar="log_path",
+        help="Additional darshan logs, or directories of logs, "
+             "to summarize in batch mode.",
+    )
     parser.add_argument(
         "--output",
         type=str,
         help="Specify output filename."
     )
+    parser.add_argument(
+        "--output-dir",
+        type=str,
+        help="Directory for the reports generated in batch mode "
+             "(default: current directory)."
+    )
+    parser.add_argument(
+        "--jobs",
+        type=int,
+        default=os.cpu_count(),
+        help="Number of processes used to generate reports in batch mode."
+    )
+    parser.add_argument(
+        "--timings",
+        action="store_true",
+        help="Print the time spent in each stage of report generation."
+    )
     # DXT-based heatmap generation can be expensive, so it is opt-in for now
     parser.add_argument(
         "--enable_dxt_heatmap",
@@ -671,6 +866,165 @@ def setup_parser(parser: argparse.ArgumentParser):
     )
 
 
+def get_report_filename(log_path: str) -> str:
+    """
+    Builds the default report filename for a log.
+
+    Parameters
+    ----------
+    log_path : path to a darshan log file.
+
+    Returns
+    -------
+    report_filename : the log file name with its extension
+    replaced by ``_report.html``.
+
+    """
+    log_filename = os.path.splitext(os.path.basename(log_path))[0]
+    return f"{log_filename}_report.html"
+
+
+def generate_report(
+    log_path: str,
+    report_filename: str,
+    enable_dxt_heatmap: bool = False,
+) -> dict:
+    """
+    Generates and saves the summary report of a single log.
+
+    Parameters
+    ----------
+    log_path : path to a darshan log file.
+
+    report_filename : path of the HTML report to write.
+
+    enable_dxt_heatmap : flag indicating whether DXT heatmaps should be enabled
+
+    Returns
+    -------
+    timings : wall time (in seconds) spent in each stage of
+    generating the report (see ``ReportData.timings``).
+
+    """
+    # collect the report data to feed into the template
+    report_data = ReportData(
+        log_path=log_path,
+        enable_dxt_heatmap=enable_dxt_heatmap
+    )
+    timings = report_data.timings
+    with _timed(timings, "render"):
+        # render the base template
+        stream = _load_template().render(report_data=report_data)
+    with open(report_filename, "w") as f:
+        # save the rendered html
+        f.write(stream)
+    return timings
+
+
+def _init_batch_worker():
+    # load the template and stylesheet once per worker
+    # instead of once per report
+    _load_template()
+    _load_stylesheet()
+
+
+def _batch_report(log_path: str, report_filename: str, enable_dxt_heatmap: bool):
+    # errors are passed back so that one bad log does not stop the batch
+    try:
+        return generate_report(log_path, report_filename, enable_dxt_heatmap), None
+    except Exception as err:
+        return None, f"{type(err).__name__}: {err}"
+
+
+def expand_log_paths(paths: list) -> list:
+    """
+    Expands the command line paths into a list of logs.
+
+    Parameters
+    ----------
+    paths : darshan log files and/or directories; directories
+    contribute the ``*.darshan`` files directly inside them.
+
+    Returns
+    -------
+    log_paths : the log files, in command line order.
+
+    """
+    log_paths = []
+    for path in paths:
+        if os.path.isdir(path):
+            log_paths.extend(sorted(
+                os.path.join(path, name) for name in os.listdir(path)
+                if name.endswith(".darshan")
+                and os.path.isfile(os.path.join(path, name))
+            ))
+        else:
+            log_paths.append(path)
+    return log_paths
+
+
+def print_timings(timings: dict, title: str):
+    """
+    Prints report generation timings, slowest stage first.
+    """
+    print(title)
+    for stage, elapsed in sorted(timings.items(), key=lambda x: -x[1]):
+        print(f"  {elapsed:10.4f}  {stage}")
+
+
+def batch_main(args: Any):
+    """
+    Generates the summary reports of several logs in a process pool.
+
+    Parameters
+    ----------
+    args: command line arguments.
+
+    """
+    if args.output is not None:
+        raise ValueError("--output cannot be used with several logs, "
+                         "use --output-dir instead.")
+    log_paths = expand_log_paths([args.log_path] + args.more_log_paths)
+    output_dir = args.output_dir if args.output_dir else os.getcwd()
+    os.makedirs(output_dir, exist_ok=True)
+
+    report_filenames = [os.path.join(output_dir, get_report_filename(log_path))
+                        for log_path in log_paths]
+    if len(set(report_filenames)) != len(report_filenames):
+        raise ValueError("Several logs map to the same report filename.")
+
+    jobs = max(1, min(args.jobs or 1, len(log_paths)))
+    if jobs == 1:
+        _init_batch_worker()
+        results = [_batch_report(log_path, report_filename, args.enable_dxt_heatmap)
+                   for log_path, report_filename in zip(log_paths, report_filenames)]
+    else:
+        with concurrent.futures.ProcessPoolExecutor(
+                max_workers=jobs, initializer=_init_batch_worker) as pool:
+            results = list(pool.map(_batch_report, log_paths, report_filenames,
+                                    [args.enable_dxt_heatmap] * len(log_paths)))
+
+    total_timings = {}
+    failed = 0
+    for log_path, report_filename, (timings, err) in zip(
+            log_paths, report_filenames, results):
+        if err is not None:
+            failed += 1
+            print(f"Failed to generate report for {log_path}: {err}",
+                  file=sys.stderr)
+            continue
+        print(f"Saved report for {log_path} at location: "
+              f"{os.path.abspath(report_filename)}")
+        for stage, elapsed in timings.items():
+            total_timings[stage] = total_timings.get(stage, 0.0) + elapsed
+
+    print(f"Generated {len(log_paths) - failed} reports, {failed} failed.")
+    if args.timings and total_timings:
+        print_timings(total_timings, "Time (s) per stage, summed over all reports:")
+    if failed:
+        sys.exit(1)
+
+
 def main(args: Union[Any, None] = None):
     """
     Generates a Darshan Summary Report.
@@ -685,37 +1039,36 @@ def main(args: Union[Any, None] = None):
         setup_parser(parser)
         args = parser.parse_args()
 
+    # several logs, or a directory of logs, are summarized in batch mode
+    more_log_paths = getattr(args, "more_log_paths", [])
+    if more_log_paths or (args.log_path and os.path.isdir(args.log_path)):
+        args.more_log_paths = more_log_paths
+        batch_main(args)
+        return
+
     log_path = args.log_path
     enable_dxt_heatmap = args.enable_dxt_heatmap
 
     if args.output is None:
         # if no output is provided, use the log file
         # name to create the output filename
-        log_filename = os.path.splitext(os.path.basename(log_path))[0]
-        report_filename = f"{log_filename}_report.html"
+        report_filename = get_report_filename(log_path)
     else:
         report_filename = args.output
 
-    # collect the report data to feed into the template
-    report_data = ReportData(
+    timings = generate_report(
         log_path=log_path,
-        enable_dxt_heatmap=enable_dxt_heatmap
+        report_filename=report_filename,
+        enable_dxt_heatmap=enable_dxt_heatmap,
     )
-
-    with importlib_resources.path(darshan.cli, "base.html") as base_path:
-        # load a template object using the base template
-        template = Template(filename=str(base_path))
-        # render the base template
-        stream = template.render(report_data=report_data)
-        with open(report_filename, "w") as f:
-            # print a message so users know where to look for their report
-            save_path = os.path.join(os.getcwd(), report_filename)
-            print(
-                f"Report generated successfully. \n"
-                f"Saving report at location: {save_path}"
-            )
-            # save the rendered html
-            f.write(stream)
+    # print a message so users know where to look for their report
+    save_path = os.path.join(os.getcwd(), report_filename)
+    print(
+        f"Report generated successfully. \n"
+        f"Saving report at location: {save_path}"
+    )
+    if getattr(args, "timings", False):
+        print_timings(timings, "Time (s) per stage:")
 
 
 if __name__ == "__main__":
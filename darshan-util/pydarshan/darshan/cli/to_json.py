@@ -14,6 +14,10 @@ def setup_parser(parser=None):
 
     # setup arguments
     parser.add_argument('input', help='darshan log file', nargs='?', default='example.darshan')
+    parser.add_argument('--ndjson', help='stream one JSON object per record, in constant memory', action='store_true')
+    parser.add_argument('--modules', help='comma-separated modules to write with --ndjson')
+    parser.add_argument('--counters', help='comma-separated counters to write with --ndjson')
+    parser.add_argument('--no-names', help='omit record names with --ndjson', action='store_true')
     parser.add_argument('--verbose', help='', action='store_true')
     parser.add_argument('--debug', help='', action='store_true')
 
@@ -30,6 +34,14 @@ def main(args=None):
     if args.debug:
         print(args)
 
+    if args.ndjson:
+        from darshan.log_utils import write_ndjson
+        write_ndjson(args.input, sys.stdout,
+                     mods=args.modules.split(',') if args.modules else None,
+                     counters=args.counters.split(',') if args.counters else None,
+                     names=not args.no_names)
+        return
+
     report = darshan.DarshanReport(args.input, read_all=True)  # Default behavior
     print(report.to_json())
 
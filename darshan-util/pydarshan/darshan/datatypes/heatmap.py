@@ -1,4 +1,4 @@
-from typing import Sequence
+from typing import Optional, Sequence
 
 import numpy as np
 import pandas as pd
@@ -7,8 +7,21 @@ class Heatmap():
     """
     The Heatmap class is a convenience wrapper to Darshan Heatmap records.
     The structure can be sparse (e.g., not all ranks need to be populated)
+
+    Besides bytes moved ("read", "write"), records from runtimes that had
+    heatmap op counts enabled also carry the number of operations started
+    in each bin ("read_ops", "write_ops", "meta_ops").
     """
 
+    # map of heatmap operation to the record key holding its bins
+    _op_bins = {
+        "read": "read_bins",
+        "write": "write_bins",
+        "read_ops": "read_op_bins",
+        "write_ops": "write_op_bins",
+        "meta_ops": "meta_op_bins",
+    }
+
     def __init__(self, mod=None):       
         self._mod = mod
         self._ranks = set()
@@ -16,10 +29,11 @@ class Heatmap():
         self._bin_width_seconds = None
         
         self._num_recs = 0
-        self._data = {
-            "read": {},
-            "write": {}
-        }
+        # operations held by the heatmap, and the bins of its records as
+        # (ranks, {op: (records x nbins) array}) chunks, which are joined
+        # into a single chunk on first use
+        self._ops = ["read", "write"]
+        self._chunks = []
    
     def __repr__(self):
         type_ = type(self)
@@ -53,7 +67,7 @@ class Heatmap():
         if plot:
             import matplotlib.pyplot as plt
             print()
-            for op in ['read', 'write']:
+            for op in self._ops:
                 print(op)
                 plt.pcolor(self.to_df(ops=[op]))
                 plt.show()
@@ -68,29 +82,85 @@ class Heatmap():
         rec: a heatmap record dictionary as returned by backend._log_get_heatmap_record
 
         """
-        nbins = rec['nbins']
-        rank = rec['rank']
-              
-        # check data
-        if self._nbins is  None:
+        self._check_bins(rec['nbins'], rec['bin_width_seconds'])
+
+        # actually add data
+        self._ranks.add(rec['rank'])
+        
+        bins = {op: np.asarray(rec[key])[np.newaxis, :]
+                for op, key in self._op_bins.items() if key in rec}
+        self._add_chunk(np.array([rec['rank']], dtype=np.int64), bins)
+
+    def add_records(self, arr: dict):
+        """
+        Add several heatmap records to heatmap.
+
+        Parameters
+        ----------
+
+        arr: heatmap records as a dictionary of numpy arrays, in the format
+        returned by backend.log_get_heatmap_arrays
+
+        """
+        if len(arr['rank']) == 0:
+            return
+        nbins = np.unique(arr['nbins'])
+        bin_widths = np.unique(arr['bin_width_seconds'])
+        if len(nbins) > 1:
+            raise ValueError("Record nbins is not consistent with current heatmap.")
+        if len(bin_widths) > 1:
+            raise ValueError("Record bin_width_seconds is not consistent with current heatmap.")
+        nbins = int(nbins[0])
+        self._check_bins(nbins, float(bin_widths[0]))
+
+        self._ranks.update(arr['rank'].tolist())
+
+        has_op_bins = (arr['flags'] & 1).any()
+        bins = {op: arr[key][:, :nbins] for op, key in self._op_bins.items()
+                if has_op_bins or not op.endswith("_ops")}
+        self._add_chunk(arr['rank'], bins)
+
+    def _check_bins(self, nbins, bin_width_seconds):
+        """
+        Check that records with the given binning can be added.
+        """
+        if self._nbins is None:
             self._nbins = nbins
         if self._nbins != nbins:
             raise ValueError("Record nbins is not consistent with current heatmap.")
            
         if self._bin_width_seconds is None:
-            self._bin_width_seconds = rec['bin_width_seconds']
-        if self._bin_width_seconds != rec['bin_width_seconds']:
+            self._bin_width_seconds = bin_width_seconds
+        if self._bin_width_seconds != bin_width_seconds:
             raise ValueError("Record bin_width_seconds is not consistent with current heatmap.")
 
-        # actually add data
-        self._ranks.add(rec['rank'])
-        
-        self._data['read'][rank] = rec['read_bins']
-        self._data['write'][rank] = rec['write_bins']
-            
-        self._num_recs += 1
+    def _add_chunk(self, ranks, bins):
+        for op in bins:
+            if op not in self._ops:
+                self._ops.append(op)
+        self._chunks.append((ranks, bins))
+        self._num_recs += len(ranks)
 
-    def to_df(self, ops: Sequence[str], interval_index: bool = True):
+    def _get_bins(self):
+        """
+        Return the ranks of all records and their bins for each operation,
+        joining the chunks added so far.
+        """
+        if len(self._chunks) == 0:
+            return np.empty(0, dtype=np.int64), {}
+        if len(self._chunks) > 1 or set(self._chunks[0][1]) != set(self._ops):
+            ranks = np.concatenate([chunk[0] for chunk in self._chunks])
+            bins = {}
+            for op in self._ops:
+                bins[op] = np.concatenate([
+                    chunk[1][op] if op in chunk[1] else
+                    np.zeros((len(chunk[0]), self._nbins), dtype=np.int64)
+                    for chunk in self._chunks])
+            self._chunks = [(ranks, bins)]
+        return self._chunks[0]
+
+    def to_df(self, ops: Sequence[str], interval_index: bool = True,
+              nbins: Optional[int] = None):
         """
         Return heatmap as pandas dataframe.
 
@@ -99,31 +169,64 @@ class Heatmap():
 
         ops: a sequence of keys designating which operations to use
         for data aggregation. If multiple operations are given, their
-        dataframes will be summed. Allowed values: ["read", "write"].
+        dataframes will be summed. Allowed values: ["read", "write"] for
+        bytes moved, and, if the heatmap carries op counts, ["read_ops",
+        "write_ops", "meta_ops"] for operation counts.
 
         interval_index: bool to enable/disable interval indices for columns
 
+        nbins: if given, the maximum number of bins; adjacent bins are
+        merged into wider ones (with a whole multiple of the record bin
+        width) until the heatmap fits.
+
         """
         for op in ops:
-            if op not in self._data:
+            if op not in self._ops:
                 raise ValueError(f"{op} not in heatmap.")
 
-        nbins = self._nbins
+        ranks, bins = self._get_bins()
         bin_width_seconds = self._bin_width_seconds
+        if len(ranks) == 0:
+            data = np.zeros((0, 0), dtype=np.int64)
+        else:
+            data = bins[ops[0]]
+            for op in ops[1:]:
+                data = data + bins[op]
 
+        # a later record of a rank replaces earlier ones
+        ranks, last = np.unique(ranks[::-1], return_index=True)
+        data = data[len(data) - 1 - last]
+
+        if nbins is not None and data.shape[1] > nbins:
+            factor = -(-data.shape[1] // nbins)
+            data = rebin(data, factor)
+            bin_width_seconds = bin_width_seconds * factor
+
+        num_bins = data.shape[1]
         if interval_index:
-            breaks = np.linspace(start=0, stop=nbins*bin_width_seconds, num=nbins+1)
+            breaks = np.linspace(start=0, stop=num_bins*bin_width_seconds, num=num_bins+1)
             columns = pd.IntervalIndex.from_breaks(breaks)
         else:
-            columns = np.arange(nbins)
+            columns = np.arange(num_bins)
 
-        df_list = []
-        for op in ops:
-            data = self._data[op]
-            df = pd.DataFrame.from_dict(data, orient='index', columns=columns)
-            df.index.name = "rank"
-            df_list.append(df)
+        return pd.DataFrame(data, index=pd.Index(ranks, name="rank"), columns=columns)
 
-        # sum the dataframes
-        return sum(df_list)
 
+def rebin(bins: np.ndarray, factor: int) -> np.ndarray:
+    """
+    Merge every ``factor`` adjacent bins of each row of a 2-D bin array,
+    padding the last bin of each row with zeros if needed.
+
+    Parameters
+    ----------
+
+    bins: a (rows x bins) array
+
+    factor: the number of bins merged into each new bin
+
+    """
+    nrows, nbins = bins.shape
+    pad = -nbins % factor
+    if pad:
+        bins = np.pad(bins, ((0, 0), (0, pad)))
+    return bins.reshape(nrows, -1, factor).sum(axis=2)
@@ -0,0 +1,93 @@
+from darshan.report import *
+
+# operation classes of the LATENCY module, in counter order
+_latency_ops = ["POSIX_READ", "POSIX_WRITE", "POSIX_META",
+                "MPIIO_READ", "MPIIO_WRITE", "MPIIO_META"]
+_latency_buckets = 32
+
+
+def latency_bucket_bound(bucket):
+    """
+    Returns the upper bound, in seconds, of a LATENCY histogram bucket:
+    bucket 0 holds operations below 1 microsecond and bucket i those
+    below 2^i microseconds (the last bucket has no upper bound).
+    """
+    if bucket >= _latency_buckets - 1:
+        return float("inf")
+    return (2 ** bucket) / 1e6
+
+
+def latency_percentile(hist, q):
+    """
+    Returns an upper bound, in seconds, on the q-th percentile (0 to 100)
+    of the latencies counted in a LATENCY histogram, or None if the
+    histogram is empty.
+    """
+    total = sum(hist)
+    if total == 0:
+        return None
+    target = total * q / 100.0
+    seen = 0
+    for bucket, count in enumerate(hist):
+        seen += count
+        if count and seen >= target:
+            return latency_bucket_bound(bucket)
+    return latency_bucket_bound(len(hist) - 1)
+
+
+def agg_latency(self, mode='append'):
+    """
+    Sum the LATENCY histograms of all files in the report, and estimate the
+    median, 90th, 99th and 99.9th percentile latency of each operation
+    class.
+
+    Args:
+        mode (str): Whether to 'append' (default) or to 'return' aggregation.
+
+    Return:
+        None or dict: Depending on mode; maps each operation class with
+        counted operations to its summed 'histogram', 'count', total
+        'time' and percentile bounds ('p50', 'p90', 'p99', 'p999') in
+        seconds.
+    """
+
+    # convienience
+    recs = self.records
+    ctx = {}
+
+    # check records for module are present
+    if "LATENCY" not in recs:
+        return ctx
+
+    counters = None
+    fcounters = None
+    for rec in recs["LATENCY"]:
+        if counters is None:
+            counters = np.array(rec['counters'], dtype=np.int64)
+            fcounters = np.array(rec['fcounters'], dtype=np.float64)
+        else:
+            counters = np.add(counters, rec['counters'])
+            fcounters = np.add(fcounters, rec['fcounters'])
+
+    if counters is None:
+        return ctx
+
+    for i, op in enumerate(_latency_ops):
+        hist = counters[i * _latency_buckets:(i + 1) * _latency_buckets].tolist()
+        count = sum(hist)
+        if count == 0:
+            continue
+        ctx[op] = {
+            'histogram': hist,
+            'count': count,
+            'time': float(fcounters[i]),
+            'p50': latency_percentile(hist, 50),
+            'p90': latency_percentile(hist, 90),
+            'p99': latency_percentile(hist, 99),
+            'p999': latency_percentile(hist, 99.9),
+        }
+
+    if mode == 'append':
+        self.summary['agg_latency'] = ctx
+
+    return ctx
@@ -0,0 +1,82 @@
+from darshan.report import *
+
+# series of the TIMESERIES module, in counter order
+_timeseries_counters = ["bytes_read", "bytes_written", "reads", "writes",
+                        "meta_ops"]
+_timeseries_fcounters = ["read_time", "write_time", "meta_time"]
+_timeseries_bins = 64
+
+
+def timeseries_rebin(series, ratio):
+    """
+    Returns a copy of a TIMESERIES series with every 'ratio' adjacent bins
+    summed into one, keeping the number of bins (trailing bins are zero).
+    """
+    out = [0] * len(series)
+    for i, val in enumerate(series):
+        out[i // ratio] += val
+    return out
+
+
+def agg_timeseries(self, mode='append'):
+    """
+    Combine the TIMESERIES records of each API (POSIX, MPIIO, STDIO) in the
+    report into one set of series, at the widest interval found.
+
+    Args:
+        mode (str): Whether to 'append' (default) or to 'return' aggregation.
+
+    Return:
+        None or dict: Depending on mode; maps each API to its 'interval' in
+        seconds, the number of contributing 'procs', the start time of
+        each bin ('time'), and one list per series ('bytes_read',
+        'bytes_written', 'reads', 'writes', 'meta_ops', 'read_time',
+        'write_time', 'meta_time').
+    """
+
+    # convienience
+    recs = self.records
+    ctx = {}
+
+    # check records for module are present
+    if "TIMESERIES" not in recs:
+        return ctx
+
+    # group the records by API, as unreduced logs hold one per process
+    by_api = {}
+    for rec in recs["TIMESERIES"]:
+        name = self.name_records.get(rec['id'], str(rec['id']))
+        api = name.split(":", 1)[-1]
+        by_api.setdefault(api, []).append(rec)
+
+    for api, api_recs in by_api.items():
+        interval = max(float(rec['fcounters'][0]) for rec in api_recs)
+        agg = {'interval': interval, 'procs': 0}
+        for key in _timeseries_counters + _timeseries_fcounters:
+            agg[key] = [0] * _timeseries_bins
+
+        for rec in api_recs:
+            counters = list(rec['counters'])
+            fcounters = list(rec['fcounters'])
+            ratio = 1
+            if fcounters[0] > 0:
+                ratio = max(1, int(round(interval / fcounters[0])))
+            agg['procs'] += int(counters[0])
+            for i, key in enumerate(_timeseries_counters):
+                start = 1 + i * _timeseries_bins
+                series = timeseries_rebin(
+                    counters[start:start + _timeseries_bins], ratio)
+                agg[key] = [a + int(b) for a, b in zip(agg[key], series)]
+            for i, key in enumerate(_timeseries_fcounters):
+                start = 1 + i * _timeseries_bins
+                series = timeseries_rebin(
+                    fcounters[start:start + _timeseries_bins], ratio)
+                agg[key] = [a + float(b) for a, b in zip(agg[key], series)]
+
+        agg['time'] = [i * interval for i in range(_timeseries_bins)]
+        ctx[api] = agg
+
+    if mode == 'append':
+        self.summary['agg_timeseries'] = ctx
+
+    return ctx
@@ -4,15 +4,14 @@ def create_dxttimeline(self, group_by='rank', mode="append"):
     """
     Generate/update a timeline from dxt tracing records of current report.
 
+    The trace segments are streamed from the log in chunks (see
+    DarshanReport.iter_dxt()), so the records need not fit in memory.
+
     Args:
         group_by (str): By which factor to group entries (default: rank)
                         Allowed Parameters: rank, filename
     """
 
-    
-    self.mod_read_all_dxt_records("DXT_POSIX")
-    self.mod_read_all_dxt_records("DXT_MPIIO")
-
 
 
     ctx = {'groups': [], 'items': []}
@@ -20,53 +19,35 @@ def create_dxttimeline(self, group_by='rank', mode="append"):
 
     groups = ctx['groups']
     items = ctx['items']
-    
-
-    start_time = datetime.datetime.fromtimestamp( self.data['metadata']['job']['start_time_sec'] )
-
-
 
-    def groupify(rec, mod):
-        for seg in rec['write_segments']:
-            seg.update( {'type': 'w'} )
 
-        for seg in rec['read_segments']:
-            seg.update( {'type': 'r'} )
+    start_time = datetime.datetime.fromtimestamp( self.data['metadata']['job']['start_time_sec'] )
 
 
-        segments = rec['write_segments'] + rec['read_segments']
-        segments = sorted(segments, key=lambda k: k['start_time'])
-        
-        
-        start = float('inf')
-        end = float('-inf')
 
+    def groupify(rec_id, rank, segs, mod):
+        # segments of a record, writes before reads, as in the record
+        segs = segs.sort_values('start_time', kind='stable')
+        types = np.where(segs['op'] == 'write', 'w', 'r')
 
         trace = []
-        minsize = 0
-        for seg in segments:
-            trace += [ seg['type'], seg['offset'], seg['length'], seg['start_time'], seg['end_time'] ]
-
-            seg_minsize = seg['offset'] + seg['length']
-            if minsize < seg_minsize:
-                minsize = seg_minsize
-
-            if start > seg['start_time']:
-                start = seg['start_time']
+        for seg in zip(types.tolist(), segs['offset'].tolist(), segs['length'].tolist(),
+                       segs['start_time'].tolist(), segs['end_time'].tolist()):
+            trace += seg
 
-            if end < seg['end_time']:
-                end = seg['end_time']
+        # minimal estimated filesize
+        minsize = max(0, int((segs['offset'] + segs['length']).max()))
 
         # reconstruct timestamps
-        start = start_time + datetime.timedelta(seconds=start)
-        end = start_time + datetime.timedelta(seconds=end)
+        start = start_time + datetime.timedelta(seconds=float(segs['start_time'].min()))
+        end = start_time + datetime.timedelta(seconds=float(segs['end_time'].max()))
 
-        rid = "%s:%d:%d" % (mod, rec['id'], rec['rank'])
+        rid = "%s:%d:%d" % (mod, rec_id, rank)
 
         item = {
             "id": rid,
-            "rank": rec['rank'],
-            "hostname": rec['hostname'],
+            "rank": rank,
+            "hostname": segs['hostname'].iloc[0],
             #"filename": rec['filename'],
             "filename": "FIXME: NEED FILENAME",
 
@@ -76,9 +57,9 @@ def create_dxttimeline(self, group_by='rank', mode="append"):
             "limitSize": False,  # required to prevent rendering glitches
             "data": {
                 "duration": (end-start).total_seconds(),
-                "start": segments[0]['start_time'],
+                "start": float(segs['start_time'].iloc[0]),
                 "size": minsize,       # minimal estimated filesize
-                "trace": trace, 
+                "trace": trace,
             }
         }
 
@@ -89,7 +70,7 @@ def create_dxttimeline(self, group_by='rank', mode="append"):
             "id": rid,
             #"content": "[%s] " % (mod) + rec['filename'][-84:],
             "content": "[%s] " % (mod) + "NEED FILENAME",
-            "order": seg['start_time']
+            "order": float(segs['start_time'].iloc[-1])
         }
         groups.append(group)
 
@@ -97,9 +78,11 @@ def create_dxttimeline(self, group_by='rank', mode="append"):
 
     supported = ['DXT_POSIX', 'DXT_MPIIO']
     for mod in supported:
-        if mod in self.data['records']:
-            for rec in self.data['records'][mod]:
-                groupify(rec, mod)
+        if mod in self.data['modules']:
+            # all segments of a record are in the same chunk
+            for seg_df in self.iter_dxt(mod):
+                for (rec_id, rank), segs in seg_df.groupby(['id', 'rank'], sort=False):
+                    groupify(int(rec_id), int(rank), segs, mod)
 
 
 
@@ -109,8 +92,6 @@ def create_dxttimeline(self, group_by='rank', mode="append"):
     # overwrite existing summary entry
     if mode == "append":
         self.summary['timeline'] = ctx
-    
-
-    return ctx
 
 
+    return ctx
@@ -2,35 +2,44 @@ from darshan.report import *
 
 import datetime
 import copy
+import itertools
 
 
-def merge(self, other, reduce_first=False):
+def merge(self, *others, reduce_first=False):
     """
-    Merge two darshan reports and return a new combined report.
+    Merge darshan reports and return a new combined report.
 
     Args:
-        mods:           Name(s) of modules to preserve (reduced)
-        name_records:   Id(s)/Name(s) of name_records to preserve (reduced)
+        others:         Report(s) to merge with this report
+        reduce_first:   Reduce each report to one record per name record
+                        (reduce(operation="agg", name_records="distinct"))
+                        before merging, which keeps merged reports of many
+                        logs small
 
     Return:
-        None
+        DarshanReport: the combined report
     """
 
+    reports = [self] + list(others)
+    if reduce_first:
+        reports = [report.reduce(operation="agg", name_records="distinct")
+                   for report in reports]
+
     # new report
     nr = DarshanReport()
 
     # keep provenance?
-    if self.provenance_enabled or other.provenance_enabled:
+    if any(report.provenance_enabled for report in reports):
         # Currently, assume logs remain in memomry to create prov. tree on demand
         # Alternative: maintain a tree with simpler refs? (modified reports would not work then)
 
         #nr.provenance_reports[self.filename] = copy.copy(self)
         #nr.provenance_reports[other.filename] = copy.copy(other)
 
-        nr.provenance_reports[self.filename] = None
-        nr.provenance_reports[other.filename] = None
+        for report in reports:
+            nr.provenance_reports[report.filename] = None
 
-        nr.provenance_graph.append(("add", self, other, datetime.datetime.now()))
+        nr.provenance_graph.append(("add", *reports, datetime.datetime.now()))
 
 
     # update metadata helper
@@ -47,18 +56,17 @@ def merge(self, other, reduce_first=False):
             nr.end_time = report.end_time
 
 
-    update_metadata(self, force=True)
-    update_metadata(other)
+    update_metadata(reports[0], force=True)
+    for report in reports[1:]:
+        update_metadata(report)
 
 
-    # copy over records (references, under assumption single records are not altered)
-    for report in [self, other]:
+    # copy over records (references, under assumption single records are not altered);
+    # each module's record list is built once, rather than once per merged report
+    mod_records = {}
+    for report in reports:
         for key, records in report.data['records'].items():
-            #print(report, key)
-            if key not in nr.records:
-                nr.records[key] = copy.copy(records)
-            else:
-                nr.records[key]._records = nr.records[key]._records + copy.copy(records._records)
+            mod_records.setdefault(key, []).append(records._records)
 
         for key, mod in report.modules.items():
             if key not in nr.modules:
@@ -70,8 +78,12 @@ def merge(self, other, reduce_first=False):
                 nr.counters[key] = copy.copy(counter)
 
         for key, nrec in report.name_records.items():
-            if key not in nr.counters:
+            if key not in nr.name_records:
                 nr.name_records[key] = copy.copy(nrec)
                 # TODO: verify colliding name_records?
 
+    for key, record_lists in mod_records.items():
+        nr.records[key] = DarshanRecordCollection(mod=key, report=nr)
+        nr.records[key]._records = list(itertools.chain.from_iterable(record_lists))
+
     return nr
@@ -2,26 +2,39 @@ from darshan.report import *
 
 import sys
 
+import darshan.backend.cffi_backend as backend
+
 
 def reduce(self, operation="sum", mods=None, name_records=None, mode='append', data_format="numpy"):
     """
     Reduce records.
 
     Args:
+        operation:      "sum" adds up the counters of the reduced records,
+                        "agg" combines them with the darshan-util rules also
+                        used by darshan-parser --total (e.g., maximum offsets
+                        and access sizes keep their maximum)
         mods:           Name(s) of modules to preserve (reduced)
         name_records:   Id(s)/Name(s) of name_records to preserve (reduced)
 
 
     Return:
-        None
+        DarshanReport: a new report holding the reduced records
+
+    .. note::
+        Modules with fixed-size records (see backend._batch_mods) held in
+        numpy format are reduced with vectorized numpy operations ("sum") or
+        in darshan-util ("agg"). Other modules are summed record by record.
     """
 
+    if operation not in ["sum", "agg"]:
+        raise ValueError(f"Unsupported reduce operation: {operation}")
 
-    r = copy.deepcopy(self)
+    # the records are replaced by the reduced ones, so leave them out of the copy
+    r = copy.deepcopy(self, memo={id(self.records): {}})
 
 
     # convienience
-    recs = r.records
     ctx = {}
 
 
@@ -46,7 +59,7 @@ def reduce(self, operation="sum", mods=None, name_records=None, mode='append', d
 
     # change inputs to whitelists
     if mods is None:
-        mods = r.records.keys()
+        mods = self.records.keys()
 
 
     if name_records is None:
@@ -72,14 +85,25 @@ def reduce(self, operation="sum", mods=None, name_records=None, mode='append', d
     #print(name_records)
 
 
+    result = {}
+
     if name_records is not None:
         # aggragate
-        for mod, recs in r.records.items():
+        for mod, recs in self.records.items():
             if mod not in mods:
                 continue
 
+            arr = _record_arrays(recs)
+            if arr is not None:
+                reduced = _reduce_record_arrays(arr, mod, operation,
+                                                name_records, name_records_wildcard)
+                if reduced is not None:
+                    result[mod] = DarshanRecordCollection(mod=mod, report=r)
+                    result[mod]._records = reduced
+                continue
+
             for i, rec in enumerate(recs):
-                nrec = rec['id'] 
+                nrec = rec['id']
 
                 if nrec in name_records:
                     if mod not in ctx:
@@ -99,13 +123,12 @@ def reduce(self, operation="sum", mods=None, name_records=None, mode='append', d
                             continue
 
                         if counters not in ctx[mod][nrec_pattern]:
-                            ctx[mod][nrec_pattern][counters] = rec[counters]
+                            ctx[mod][nrec_pattern][counters] = np.array(rec[counters])
                         else:
                             ctx[mod][nrec_pattern][counters] = np.add(ctx[mod][nrec_pattern][counters], rec[counters])
 
 
     # convert records back to list
-    result = {}
     for mod, name_records in ctx.items():
         if mod not in result:
             result[mod] = DarshanRecordCollection(mod=mod, report=r)
@@ -118,5 +141,66 @@ def reduce(self, operation="sum", mods=None, name_records=None, mode='append', d
             result[mod].append(rec)
 
     r.records = result
+    r.data['records'] = result
 
     return r
+
+
+def _record_arrays(recs):
+    """
+    Returns the records of a collection as a dictionary of numpy arrays (see
+    backend.log_get_generic_record_arrays()), or None if the records are not
+    fixed-size module records in numpy format.
+    """
+    if recs.mod not in backend._batch_mods or len(recs) == 0:
+        return None
+    records = recs._records
+    if not all(isinstance(rec.get('counters'), np.ndarray) for rec in records):
+        return None
+
+    arr = {
+        'id': np.fromiter((rec['id'] for rec in records), dtype=np.uint64, count=len(records)),
+        'rank': np.fromiter((rec['rank'] for rec in records), dtype=np.int64, count=len(records)),
+        'counters': np.stack([rec['counters'] for rec in records]),
+        'fcounters': np.stack([rec['fcounters'] for rec in records]),
+    }
+    if 'file_rec_id' in records[0]:
+        arr['file_rec_id'] = np.fromiter((rec['file_rec_id'] for rec in records),
+                                         dtype=np.uint64, count=len(records))
+    return arr
+
+
+def _reduce_record_arrays(arr, mod, operation, name_records, name_records_wildcard):
+    """
+    Reduces a module's record arrays to one record per name record, or to a
+    single record with id '*' for wildcard reductions, and returns the
+    reduced records as a list of dictionaries (None if no record is kept).
+    """
+    keep = np.isin(arr['id'], np.asarray(name_records, dtype=np.uint64))
+    if not keep.all():
+        arr = {key: val[keep] for key, val in arr.items()}
+    if len(arr['id']) == 0:
+        return None
+
+    by_id = not name_records_wildcard
+    if operation == "agg":
+        reduced = backend.agg_generic_record_arrays(arr, mod, by_id=by_id)
+        counters = reduced['counters']
+        fcounters = reduced['fcounters']
+        ids = reduced['id']
+    elif by_id:
+        order = np.argsort(arr['id'], kind='stable')
+        ids, starts = np.unique(arr['id'][order], return_index=True)
+        counters = np.add.reduceat(arr['counters'][order], starts)
+        fcounters = np.add.reduceat(arr['fcounters'][order], starts)
+    else:
+        ids = [None]
+        counters = arr['counters'].sum(axis=0, keepdims=True)
+        fcounters = arr['fcounters'].sum(axis=0, keepdims=True)
+
+    records = []
+    for i in range(len(ids)):
+        nrec = '*' if name_records_wildcard else int(ids[i])
+        records.append({"id": nrec, "rank": -1,
+                        "counters": counters[i], "fcounters": fcounters[i]})
+    return records
@@ -384,6 +384,48 @@ def identify_filesystems(file_id_dict: Dict[int, str], verbose: bool = False) ->
         print("filesystem_roots:", filesystem_roots)
     return filesystem_roots
 
+def filesystem_categories(report: Any):
+    """
+    Assigns the POSIX and STDIO files of a report to their filesystem
+    root paths, for summing the data accessed per filesystem in one pass
+    (see ``darshan.backend.cffi_backend.summarize_records()``).
+
+    Parameters
+    ----------
+    report: a darshan.DarshanReport()
+
+    Returns
+    -------
+    A tuple of form ``(filesystem_roots, ids, categories)``, where
+    ``filesystem_roots`` lists the unique filesystem root paths in the
+    order ``identify_filesystems()`` finds them, and ``categories[i]`` is
+    the index in ``filesystem_roots`` of the root of file ``ids[i]``.
+    Files without a name record are left out.
+    """
+    file_id_dict = report.data["name_records"]
+    id_arrays = []
+    for module in ["POSIX", "STDIO"]:
+        if module in report.modules:
+            id_arrays.append(report.records[module].to_df()["counters"]["id"].to_numpy())
+    ids = pd.unique(np.concatenate(id_arrays)) if id_arrays else np.array([], dtype=np.uint64)
+
+    filesystem_roots: List[str] = []
+    root_index: Dict[str, int] = {}
+    file_ids = []
+    categories = []
+    for ident in ids.tolist():
+        if ident not in file_id_dict:
+            continue
+        root = convert_file_path_to_root_path(file_path=file_id_dict[ident])
+        if root not in root_index:
+            root_index[root] = len(filesystem_roots)
+            filesystem_roots.append(root)
+        file_ids.append(ident)
+        categories.append(root_index[root])
+    return (filesystem_roots,
+            np.array(file_ids, dtype=np.uint64),
+            np.array(categories, dtype=np.intc))
+
 def unique_fs_rw_counter(report: Any,
                          filesystem_roots: Sequence[str],
                          file_id_dict: Dict[int, str],
@@ -612,7 +654,8 @@ def plot_data(fig: Any,
 
 def plot_with_report(report: darshan.DarshanReport,
                      verbose: bool = False,
-                     num_cats: Optional[int] = None):
+                     num_cats: Optional[int] = None,
+                     category_io: Optional[Any] = None):
     """
     Plot the data access by category given a darshan ``DarshanReport``
     object.
@@ -629,12 +672,58 @@ def plot_with_report(report: darshan.DarshanReport,
     num_cats: an integer representing the number of categories
     to plot; default ``None`` plots all categories
 
+    category_io: optional ``pd.DataFrame`` indexed by filesystem root
+    path, with the ``bytes_read``, ``bytes_written``, ``files_read`` and
+    ``files_written`` per filesystem (see ``filesystem_categories()``);
+    if not given, they are computed from the POSIX and STDIO records
+
     Returns
     -------
 
     fig: matplotlib figure object
     """
     fig = plt.figure()
+    if category_io is None:
+        (filesystem_roots, file_rd_series, file_wr_series,
+         bytes_rd_series, bytes_wr_series) = _rw_series_from_records(report, verbose)
+    else:
+        filesystem_roots = list(category_io.index)
+        file_rd_series = category_io["files_read"].astype(np.float64)
+        file_wr_series = category_io["files_written"].astype(np.float64)
+        bytes_rd_series = category_io["bytes_read"].astype(np.float64)
+        bytes_wr_series = category_io["bytes_written"].astype(np.float64)
+
+    # reverse sort by total bytes IO per category
+    sort_inds = (bytes_rd_series + bytes_wr_series).argsort()[::-1]
+    if num_cats is None:
+        height = len(file_rd_series)
+    else:
+        height = num_cats
+
+    plot_data(fig,
+              file_rd_series.iloc[sort_inds],
+              file_wr_series.iloc[sort_inds],
+              bytes_rd_series.iloc[sort_inds],
+              bytes_wr_series.iloc[sort_inds],
+              filesystem_roots,
+              num_cats=num_cats)
+
+    # at least this much height seems to
+    # produce a decent aspect ratio
+    if height < 16:
+        height = 16
+    # add additional padding to left margin for annotations
+    fig.subplots_adjust(left=0.2)
+    fig.set_size_inches(12, height)
+    plt.close(fig)
+    return fig
+
+
+def _rw_series_from_records(report: darshan.DarshanReport, verbose: bool = False):
+    """
+    Computes the per-filesystem read/write file and byte counts plotted by
+    ``plot_with_report()`` from the POSIX and STDIO records of a report.
+    """
     file_id_dict = report.data["name_records"]
     allowed_file_id_dict = {}
 
@@ -669,27 +758,5 @@ def plot_with_report(report: darshan.DarshanReport,
                                                             file_id_dict=allowed_file_id_dict,
                                                             processing_func=process_byte_counts,
                                                             mod=default_mod, verbose=verbose)
-    # reverse sort by total bytes IO per category
-    sort_inds = (bytes_rd_series + bytes_wr_series).argsort()[::-1]
-    if num_cats is None:
-        height = len(file_rd_series)
-    else:
-        height = num_cats
-
-    plot_data(fig,
-              file_rd_series.iloc[sort_inds],
-              file_wr_series.iloc[sort_inds],
-              bytes_rd_series.iloc[sort_inds],
-              bytes_wr_series.iloc[sort_inds],
-              filesystem_roots,
-              num_cats=num_cats)
-
-    # at least this much height seems to
-    # produce a decent aspect ratio
-    if height < 16:
-        height = 16
-    # add additional padding to left margin for annotations
-    fig.subplots_adjust(left=0.2)
-    fig.set_size_inches(12, height)
-    plt.close(fig)
-    return fig
+    return (filesystem_roots, file_rd_series, file_wr_series,
+            bytes_rd_series, bytes_wr_series)
@@ -2,6 +2,7 @@
 Module of data pre-processing functions for constructing the heatmap figure.
 """
 
+from __future__ import annotations
 from typing import Dict, Any, Tuple, Sequence, TYPE_CHECKING, Optional
 
 import sys
@@ -414,3 +415,399 @@ def get_heatmap_df(agg_df: pd.DataFrame,
     hmap_df = cats.groupby("rank").sum()
     hmap_df = hmap_df.reindex(index=range(nprocs), fill_value=0.0)
     return hmap_df
+
+
+def get_heatmap_grid_shape(nprocs: int,
+                           xbins: int,
+                           figsize: Tuple[float, float] = (6.5, 4.5),
+                           dpi: Optional[float] = None) -> Tuple[int, int]:
+    """
+    Chooses the heatmap grid for a target figure resolution, so that
+    no more bins are computed than the figure has pixels to draw them.
+
+    Parameters
+    ----------
+
+    nprocs: the number of MPI ranks/processes used at runtime.
+
+    xbins: the requested number of x-axis (time) bins.
+
+    figsize: the figure size in inches. Default is ``(6.5, 4.5)``,
+    the size of the job summary heatmaps.
+
+    dpi: the figure resolution; defaults to matplotlib's
+    ``figure.dpi`` setting.
+
+    Returns
+    -------
+
+    A tuple containing the `xbins`, `ybins` ints, where `ybins`
+    is the number of rank buckets.
+
+    """
+    if dpi is None:
+        import matplotlib
+        dpi = matplotlib.rcParams["figure.dpi"]
+    # the heatmap axis takes up roughly this fraction of each dimension
+    # of the figure, the rest being margins, marginal bars and colorbar
+    ax_fraction = 0.6
+    xpixels = max(1, int(figsize[0] * dpi * ax_fraction))
+    ypixels = max(1, int(figsize[1] * dpi * ax_fraction))
+    return min(xbins, xpixels), min(nprocs, ypixels)
+
+
+def bin_dxt_segments(ranks: npt.ArrayLike,
+                     start_times: npt.ArrayLike,
+                     end_times: npt.ArrayLike,
+                     lengths: npt.ArrayLike,
+                     xbins: int,
+                     nprocs: int,
+                     max_time: float,
+                     ybins: Optional[int] = None,
+                     out: Optional[npt.NDArray[np.float64]] = None,
+                     ) -> npt.NDArray[np.float64]:
+    """
+    Bins DXT segments directly into a (rank bucket x time bin) array.
+
+    Like `get_heatmap_df()`, the data of each segment is distributed over
+    the time bins it overlaps in proportion to the overlap, and segments
+    of zero duration put all of their data in the bin they occur in.
+    Portions of segments outside of ``[0, max_time]`` are dropped.
+
+    Parameters
+    ----------
+
+    ranks, start_times, end_times, lengths: equally sized arrays
+    describing the segments.
+
+    xbins: the number of x-axis (time) bins.
+
+    nprocs: the number of MPI ranks/processes used at runtime.
+
+    max_time: the upper time bound of the last bin.
+
+    ybins: the number of rank buckets; rank ``r`` is counted in bucket
+    ``r * ybins // nprocs``. Default is ``None`` (one bucket per rank).
+
+    out: an array of shape ``(ybins, xbins)`` to add the binned data
+    to, i.e. when binning a trace in chunks.
+
+    Returns
+    -------
+
+    out: the ``(ybins, xbins)`` array of binned data.
+
+    """
+    if ybins is None:
+        ybins = nprocs
+    if out is None:
+        out = np.zeros((ybins, xbins))
+
+    ranks = np.asarray(ranks, dtype=np.int64)
+    starts = np.asarray(start_times, dtype=np.float64)
+    ends = np.asarray(end_times, dtype=np.float64)
+    lengths = np.asarray(lengths, dtype=np.float64)
+    if starts.size == 0 or max_time <= 0:
+        return out
+
+    # restrict the segments to the binned time span, keeping zero
+    # duration segments that occur within it
+    durations = ends - starts
+    instant = durations <= 0
+    s = np.clip(starts, 0.0, max_time)
+    e = np.clip(ends, 0.0, max_time)
+    keep = (e > s) | (instant & (starts >= 0.0) & (starts <= max_time))
+    if not keep.all():
+        ranks, durations, instant = ranks[keep], durations[keep], instant[keep]
+        s, e, lengths = s[keep], e[keep], lengths[keep]
+
+    width = max_time / xbins
+    first = np.minimum((s / width).astype(np.int64), xbins - 1)
+    last = np.minimum((e / width).astype(np.int64), xbins - 1)
+    rows = np.clip(ranks, 0, nprocs - 1) * ybins // nprocs
+    # data moved per second of each segment
+    rate = np.where(instant, 0.0, lengths / np.where(instant, 1.0, durations))
+
+    size = ybins * xbins
+    same = first == last
+    partial = np.bincount(
+        np.concatenate([rows * xbins + first, (rows * xbins + last)[~same]]),
+        weights=np.concatenate([
+            np.where(same,
+                     np.where(instant, lengths, rate * (e - s)),
+                     rate * ((first + 1) * width - s)),
+            (rate * (e - last * width))[~same]]),
+        minlength=size)
+    # the bins strictly between the first and last bins of a segment are
+    # fully overlapped, so add their share as a difference array
+    span = ~same
+    full = rate[span] * width
+    diff = np.bincount(
+        np.concatenate([rows[span] * xbins + first[span] + 1,
+                        rows[span] * xbins + last[span]]),
+        weights=np.concatenate([full, -full]),
+        minlength=size)
+
+    out += partial.reshape(ybins, xbins)
+    out += np.cumsum(diff.reshape(ybins, xbins), axis=1)
+    return out
+
+
+def get_binned_heatmap_df(grid: npt.NDArray[np.float64],
+                          nprocs: int,
+                          max_time: float) -> pd.DataFrame:
+    """
+    Wraps an array from `bin_dxt_segments()` in the layout returned by
+    `get_heatmap_df()`, with time intervals for columns. Rows are indexed
+    by the first rank of each rank bucket.
+
+    Parameters
+    ----------
+
+    grid: the ``(ybins, xbins)`` array of binned data.
+
+    nprocs: the number of MPI ranks/processes used at runtime.
+
+    max_time: the upper time bound of the last bin.
+
+    Returns
+    -------
+
+    hmap_df: dataframe with time intervals for columns and rank
+    index for rows.
+
+    """
+    ybins, xbins = grid.shape
+    columns = pd.IntervalIndex.from_breaks(np.linspace(0.0, max_time, xbins + 1))
+    # the first rank ``r`` with ``r * ybins // nprocs == row``
+    index = pd.Index(-(-np.arange(ybins) * nprocs // ybins), name="rank")
+    return pd.DataFrame(grid, index=index, columns=columns)
+
+
+def get_fast_heatmap_df(agg_df: pd.DataFrame,
+                        xbins: int,
+                        nprocs: int,
+                        max_time: Optional[float] = None,
+                        ybins: Optional[int] = None) -> pd.DataFrame:
+    """
+    Builds the heatmap data array of `get_heatmap_df()` with the
+    vectorized `bin_dxt_segments()`, optionally bucketing ranks.
+
+    Parameters
+    ----------
+
+    agg_df: a ``pd.DataFrame`` containing the aggregated data determined
+    by the input modules and operations.
+
+    xbins: the number of x-axis bins to create.
+
+    nprocs: the number of MPI ranks/processes used at runtime.
+
+    max_time: the maximum time, since input DXT data is not necessarily
+              bounded by wallclock duration
+
+    ybins: the number of rank buckets. Default is ``None``
+    (one bucket per rank).
+
+    Returns
+    -------
+
+    hmap_df: dataframe with time intervals for columns and rank
+    index for rows.
+
+    """
+    if max_time is None:
+        max_time = agg_df["end_time"].max()
+    grid = bin_dxt_segments(ranks=agg_df["rank"].values,
+                            start_times=agg_df["start_time"].values,
+                            end_times=agg_df["end_time"].values,
+                            lengths=agg_df["length"].values,
+                            xbins=xbins,
+                            nprocs=nprocs,
+                            max_time=max_time,
+                            ybins=ybins)
+    return get_binned_heatmap_df(grid=grid, nprocs=nprocs, max_time=max_time)
+
+
+def get_streamed_heatmap_df(
+    report: Any,
+    mod: str,
+    xbins: int,
+    nprocs: int,
+    max_time: float,
+    ops: Sequence[str] = ["read", "write"],
+    chunk: int = 1000000,
+) -> pd.DataFrame:
+    """
+    Builds the heatmap data array of `get_heatmap_df()` from DXT segments
+    streamed from the log in chunks, so that memory use is bounded by the
+    chunk size rather than by the size of the trace.
+
+    Parameters
+    ----------
+
+    report: a ``darshan.DarshanReport`` with an open log.
+
+    mod: the DXT module to do analysis for (i.e. "DXT_POSIX").
+
+    xbins: the number of x-axis bins to create.
+
+    nprocs: the number of MPI ranks/processes used at runtime.
+
+    max_time: the maximum time; unlike for `get_heatmap_df()` it is
+    required, as the bins must be the same for all chunks.
+
+    ops: a sequence of keys designating which Darshan operations to use for
+    data aggregation. Default is ``["read", "write"]``.
+
+    chunk: the number of DXT segments binned at a time.
+
+    Returns
+    -------
+
+    hmap_df: dataframe with time intervals for columns and rank
+    index (0, 1, etc.) for rows.
+
+    Raises
+    ------
+
+    ValueError: raised if the selected module/operations
+    don't contain any data.
+
+    """
+    hmap_df = None
+    # segments starting after the last bin do not contribute to it
+    for seg_df in report.iter_dxt(mod, t1=max_time, chunk=chunk,
+                                  reads="read" in ops, writes="write" in ops):
+        if seg_df.empty:
+            continue
+        chunk_df = get_heatmap_df(agg_df=seg_df, xbins=xbins, nprocs=nprocs,
+                                  max_time=max_time)
+        hmap_df = chunk_df if hmap_df is None else hmap_df + chunk_df
+
+    if hmap_df is None:
+        raise ValueError("No data available for selected module(s) and operation(s).")
+
+    return hmap_df
+
+
+def get_streamed_fast_heatmap_df(
+    report: Any,
+    mod: str,
+    xbins: int,
+    nprocs: int,
+    max_time: float,
+    ops: Sequence[str] = ["read", "write"],
+    chunk: int = 1000000,
+    ybins: Optional[int] = None,
+) -> pd.DataFrame:
+    """
+    Builds the heatmap data array of `get_fast_heatmap_df()` from DXT
+    segments streamed from the log in chunks. Each chunk is binned
+    straight into a single array, so neither memory use nor binning
+    cost grow with anything but the chunk size and the grid.
+
+    Parameters
+    ----------
+
+    report: a ``darshan.DarshanReport`` with an open log.
+
+    mod: the DXT module to do analysis for (i.e. "DXT_POSIX").
+
+    xbins: the number of x-axis bins to create.
+
+    nprocs: the number of MPI ranks/processes used at runtime.
+
+    max_time: the maximum time.
+
+    ops: a sequence of keys designating which Darshan operations to use for
+    data aggregation. Default is ``["read", "write"]``.
+
+    chunk: the number of DXT segments binned at a time.
+
+    ybins: the number of rank buckets. Default is ``None``
+    (one bucket per rank).
+
+    Returns
+    -------
+
+    hmap_df: dataframe with time intervals for columns and rank
+    index for rows.
+
+    Raises
+    ------
+
+    ValueError: raised if the selected module/operations
+    don't contain any data.
+
+    """
+    grid = None
+    for seg_df in report.iter_dxt(mod, t1=max_time, chunk=chunk,
+                                  reads="read" in ops, writes="write" in ops):
+        if seg_df.empty:
+            continue
+        grid = bin_dxt_segments(ranks=seg_df["rank"].values,
+                                start_times=seg_df["start_time"].values,
+                                end_times=seg_df["end_time"].values,
+                                lengths=seg_df["length"].values,
+                                xbins=xbins,
+                                nprocs=nprocs,
+                                max_time=max_time,
+                                ybins=ybins,
+                                out=grid)
+
+    if grid is None:
+        raise ValueError("No data available for selected module(s) and operation(s).")
+
+    return get_binned_heatmap_df(grid=grid, nprocs=nprocs, max_time=max_time)
+
+
+def get_runtime_heatmap_df(
+    report: Any,
+    submodule: str,
+    nprocs: int,
+    ops: Sequence[str] = ["read", "write"],
+    nbins: Optional[int] = None,
+) -> pd.DataFrame:
+    """
+    Builds the heatmap data array from the runtime HEATMAP module,
+    mirroring the layout returned by `get_heatmap_df()` for DXT data.
+
+    Parameters
+    ----------
+
+    report: a ``darshan.DarshanReport``.
+
+    submodule: the source of the runtime heatmap data
+    (i.e. "heatmap:POSIX").
+
+    nprocs: the number of MPI ranks/processes used at runtime.
+
+    ops: a sequence of keys designating which heatmap operations to sum.
+    Either bytes moved (i.e. "read", "write") or, if the runtime recorded
+    op counts, numbers of operations (i.e. "read_ops", "write_ops",
+    "meta_ops"). Default is ``["read", "write"]``.
+
+    nbins: the maximum number of time bins; if the heatmap has more,
+    adjacent bins are merged. Default is ``None`` (keep all bins).
+
+    Returns
+    -------
+
+    hmap_df: dataframe with time intervals for columns and rank
+    index (0, 1, etc.) for rows.
+
+    Raises
+    ------
+
+    ValueError: raised if ``ops`` mixes bytes with op counts, or if the
+    heatmap does not carry a selected operation.
+
+    """
+    if len({op.endswith("_ops") for op in ops}) > 1:
+        raise ValueError("Cannot combine bytes and op counts in one heatmap.")
+    hmap_df = report.heatmaps[submodule].to_df(ops=ops, nbins=nbins)
+    # mirror the DXT approach to heatmaps by
+    # adding all-zero rows for inactive ranks
+    hmap_df = hmap_df.reindex(index=range(nprocs), fill_value=0.0)
+    return hmap_df
@@ -1,4 +1,4 @@
-from typing import Any, List
+from typing import Any, List, Optional
 
 import pandas as pd
 
@@ -122,7 +122,8 @@ class DarshanReportTable:
         self.html = self.df.to_html(**kwargs)
 
 
-def plot_common_access_table(report: darshan.DarshanReport, mod: str, n_rows: int = 4) -> DarshanReportTable:
+def plot_common_access_table(report: darshan.DarshanReport, mod: str, n_rows: int = 4,
+                             access_sizes: Optional[Any] = None) -> DarshanReportTable:
     """
     Creates a table containing the most
     common access sizes and their counts.
@@ -136,6 +137,12 @@ def plot_common_access_table(report: darshan.DarshanReport, mod: str, n_rows: in
 
     n_rows: number of rows to keep.
 
+    access_sizes: optional ``pd.DataFrame`` with the "Access Size" and
+    "Count" of every distinct access size of the module, in order of
+    increasing access size (see
+    ``darshan.backend.cffi_backend.summarize_records()``); if not given,
+    it is computed from the module records.
+
     Returns
     -------
     common_access_table: a ``DarshanReportTable`` containing the `n_rows`
@@ -145,15 +152,17 @@ def plot_common_access_table(report: darshan.DarshanReport, mod: str, n_rows: in
     the `df` or `html` attributes, respectively.
 
     """
-    mod_df = report.records[mod].to_df(attach=None)["counters"]
+    if access_sizes is None:
+        mod_df = report.records[mod].to_df(attach=None)["counters"]
+
+        if mod == "MPI-IO":
+            mod = "MPIIO"
 
-    if mod == "MPI-IO":
-        mod = "MPIIO"
+        df = get_access_count_df(mod_df=mod_df, mod=mod)
+        df = remove_nonzero_rows(df=df)
+        access_sizes = combine_access_sizes(df=df)
 
-    df = get_access_count_df(mod_df=mod_df, mod=mod)
-    df = remove_nonzero_rows(df=df)
-    df = combine_access_sizes(df=df)
-    df = get_most_common_access_sizes(df=df, n_rows=n_rows)
+    df = get_most_common_access_sizes(df=access_sizes, n_rows=n_rows)
     common_access_table = DarshanReportTable(
         # remove index labels and remove border
         df=df, index=False, border=0,
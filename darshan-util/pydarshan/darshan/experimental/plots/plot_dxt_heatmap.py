@@ -22,6 +22,11 @@ import darshan
 from darshan.experimental.plots import heatmap_handling
 
 
+# traces with more segments than this are binned with the vectorized
+# `heatmap_handling.bin_dxt_segments()` rather than in pandas
+FAST_BINNING_SEGMENTS = 100000
+
+
 @functools.lru_cache(maxsize=10)
 def determine_hmap_runtime(report: darshan.DarshanReport) -> Tuple[float, float]:
     """
@@ -46,7 +51,8 @@ def determine_hmap_runtime(report: darshan.DarshanReport) -> Tuple[float, float]
     # leverage higher resolution DXT timing
     # data if available
     if ("DXT_POSIX" in report.records or
-        "DXT_MPIIO" in report.records):
+        "DXT_MPIIO" in report.records or
+        "DXT_STDIO" in report.records):
         tmax = 0.0
         for mod in report.modules:
             if "DXT" in mod:
@@ -313,6 +319,7 @@ def plot_heatmap(
     ops: Sequence[str] = ["read", "write"],
     xbins: int = 200,
     submodule: Optional[str] = None,
+    dpi: Optional[float] = None,
 ) -> Any:
     """
     Creates a heatmap with marginal bar graphs and colorbar.
@@ -326,7 +333,9 @@ def plot_heatmap(
     or "DXT_MPIIO"). Default is ``"DXT_POSIX"``.
 
     ops: a sequence of keys designating which Darshan operations to use for
-    data aggregation. Default is ``["read", "write"]``.
+    data aggregation. Default is ``["read", "write"]``. When `mod` is
+    `HEATMAP`, op counts (``"read_ops"``, ``"write_ops"``, ``"meta_ops"``)
+    may be selected instead if the runtime recorded them.
 
     xbins: the number of x-axis bins to create; it has
            no effect when `mod` is `HEATMAP`
@@ -335,6 +344,11 @@ def plot_heatmap(
                source of the runtime heatmap data, otherwise
                it has no effect
 
+    dpi: the resolution the figure will be rendered at. DXT data is
+         binned no finer than the figure can show, bucketing ranks
+         when there are more of them than pixel rows. Defaults to
+         matplotlib's ``figure.dpi`` setting.
+
     Returns
     -------
 
@@ -359,6 +373,21 @@ def plot_heatmap(
     tmax, runtime = determine_hmap_runtime(report=report)
 
     if "DXT" in mod:
+        xbins, ybins = heatmap_handling.get_heatmap_grid_shape(nprocs=nprocs,
+                                                               xbins=xbins,
+                                                               dpi=dpi)
+
+    if "DXT" in mod and mod not in report.records:
+        # the trace was not read into the report, so bin it
+        # while streaming it from the log
+        hmap_df = heatmap_handling.get_streamed_fast_heatmap_df(report=report,
+                                                                mod=mod,
+                                                                xbins=xbins,
+                                                                nprocs=nprocs,
+                                                                max_time=runtime,
+                                                                ops=ops,
+                                                                ybins=ybins)
+    elif "DXT" in mod:
         # aggregate the data according to the selected modules and operations
         agg_df = heatmap_handling.get_aggregate_data(report=report, mod=mod, ops=ops)
         # get the heatmap data array
@@ -366,25 +395,38 @@ def plot_heatmap(
         # so we are not guaranteed to have data for all time spans
         # as a result, we force the upper time bound for the heatmap data
         # to be the wallclock time
-        hmap_df = heatmap_handling.get_heatmap_df(agg_df=agg_df,
-                                                  xbins=xbins,
-                                                  nprocs=nprocs,
-                                                  max_time=runtime)
+        if ybins < nprocs or len(agg_df) > FAST_BINNING_SEGMENTS:
+            hmap_df = heatmap_handling.get_fast_heatmap_df(agg_df=agg_df,
+                                                           xbins=xbins,
+                                                           nprocs=nprocs,
+                                                           max_time=runtime,
+                                                           ybins=ybins)
+        else:
+            hmap_df = heatmap_handling.get_heatmap_df(agg_df=agg_df,
+                                                      xbins=xbins,
+                                                      nprocs=nprocs,
+                                                      max_time=runtime)
     elif mod == "HEATMAP":
-        hmap_df = report.heatmaps[submodule].to_df(ops=ops)
-        # mirror the DXT approach to heatmaps by
-        # adding all-zero rows for inactive ranks
-        hmap_df = hmap_df.reindex(index=range(nprocs), fill_value=0.0)
+        hmap_df = heatmap_handling.get_runtime_heatmap_df(report=report,
+                                                          submodule=submodule,
+                                                          nprocs=nprocs,
+                                                          ops=ops)
         xbins = hmap_df.shape[1]
 
+    # the heatmap rows are ranks, or buckets of ranks for large jobs
+    nrows = hmap_df.shape[0]
+
     # build the joint plot with marginal histograms
-    jgrid = sns.jointplot(kind="hist", bins=[xbins, nprocs], space=0.05)
+    jgrid = sns.jointplot(kind="hist", bins=[xbins, nrows], space=0.05)
     # clear the x and y axis marginal graphs
     jgrid.ax_marg_x.cla()
     jgrid.ax_marg_y.cla()
 
     # create the label for the colorbar
-    colorbar_label = f"Data (B): {', '.join(ops)}"
+    if all(op.endswith("_ops") for op in ops):
+        colorbar_label = f"Operations: {', '.join(ops)}"
+    else:
+        colorbar_label = f"Data (B): {', '.join(ops)}"
     colorbar_kws = {"label": colorbar_label}
     # create the heatmap object using the heatmap data,
     # and assign it to the jointplot main figure
@@ -417,7 +459,7 @@ def plot_heatmap(
     # create the horizontal bar graph
     if nprocs > 1:
         jgrid.ax_marg_y.barh(
-            y=np.arange(nprocs),
+            y=np.arange(nrows),
             width=hmap_df.sum(axis=1),
             align="edge",
             facecolor="black",
@@ -1,11 +1,13 @@
 # -*- coding: utf-8 -*-
 
 from darshan.report import *
+from darshan.experimental.plots import heatmap_handling
 
 import matplotlib
 import matplotlib.pyplot as plt
 from mpl_toolkits.axes_grid1 import make_axes_locatable 
 import numpy as np
+import pandas as pd
 
 def plot_dxt_heatmap2(report, 
         xbins=10, ybins=None, 
@@ -73,28 +75,46 @@ def plot_dxt_heatmap2(report,
             ylabel = f"Binned Ranks (binsize={int(ranks/ybins)} ranks)"
 
     
-    # heatmap to be populated with event counts
-    events = np.zeros((ybins, xbins))    
-    
+    # heatmap to be populated with event counts; the events of all records
+    # are binned at once, each counted in the bin it starts in
+    rows = []
+    starts = []
     for mod in mods:
         for op in ops:
             for rec in report.records[mod]:
-                
+                segs = pd.DataFrame(rec[f'{op}_segments'])
+                if segs.empty:
+                    continue
                 if group_by in ['hostname', 'node']:
-                    ybin = hostnames[rec['hostname']]
+                    row = hostnames[rec['hostname']]
                 else:
-                    ybin = int((rec['rank'] /ranks) * ybins)
-                    
-                    
-                for event in rec[f'{op}_segments']:
-                    xbin = int((event['start_time'] / runtime) * xbins)
-                    events[ybin][xbin] += 1
-                    if amplify:
-                        rng = amplify
-                        for i in range(rng):
-                            sur = int(rng/2) + i
-                            if sur != 0 and (ybin - sur) > 0:
-                                events[ybin - sur][xbin] += 1
+                    row = rec['rank']
+                rows.append(np.full(len(segs), row))
+                starts.append(segs['start_time'].values)
+
+    if group_by in ['hostname', 'node']:
+        nrows = ybins
+    else:
+        nrows = ranks
+
+    events = np.zeros((ybins, xbins))
+    if rows:
+        starts = np.concatenate(starts)
+        heatmap_handling.bin_dxt_segments(
+                ranks=np.concatenate(rows),
+                start_times=starts, end_times=starts,
+                lengths=np.ones(len(starts)),
+                xbins=xbins, nprocs=nrows, max_time=runtime,
+                ybins=ybins, out=events)
+
+    if amplify:
+        # paint each event into the rows above it as well
+        counts = events.copy()
+        rng = amplify
+        for i in range(rng):
+            sur = int(rng/2) + i
+            if sur != 0 and sur < ybins - 1:
+                events[1:ybins - sur] += counts[1 + sur:]
 
 
     if ax is None:
@@ -20,22 +20,30 @@ def autolabel(ax, rects):
                 rotation=45,
             )
 
-def gather_count_data(report, mod):
+def gather_count_data(report, mod, op_counts=None):
     """
     Collect the module counts and labels
     for the I/O Operation Count plot.
+
+    If given, ``op_counts`` maps counter names of the module to their
+    sums over all records (e.g., the counters of the summary record of
+    ``darshan.backend.cffi_backend.accumulate_records()``), and is used
+    instead of aggregating the records of the report.
     """
-    # TODO: change to report.summary
-    if 'agg_ioops' in dir(report):
-        report.agg_ioops()
+    if op_counts is not None:
+        mod_data = op_counts
     else:
-        print(
-            "Cannot create summary, agg_ioops aggregator is not "
-            "registered with the report class. Be sure to call "
-            "darshan.experimental() once before invoking this plot."
-        )
+        # TODO: change to report.summary
+        if 'agg_ioops' in dir(report):
+            report.agg_ioops()
+        else:
+            print(
+                "Cannot create summary, agg_ioops aggregator is not "
+                "registered with the report class. Be sure to call "
+                "darshan.experimental() once before invoking this plot."
+            )
 
-    mod_data = report.summary['agg_ioops'][mod]
+        mod_data = report.summary['agg_ioops'][mod]
 
     # Gather POSIX
     if mod == 'POSIX':
@@ -156,7 +164,7 @@ def gather_count_data(report, mod):
 
     return labels, counts
 
-def plot_opcounts(report, mod, ax=None):
+def plot_opcounts(report, mod, ax=None, op_counts=None):
     """
     Generates a bar chart summary for operation counts.
 
@@ -169,6 +177,9 @@ def plot_opcounts(report, mod, ax=None):
     "MPI-IO", "STDIO", "H5F", "H5D"). If "H5D" is input the returned
     figure will contain both "H5F" and "H5D" module data.
 
+    op_counts: optional dictionary of the module's counter sums (see
+    ``gather_count_data()``)
+
     """
 
     if ax is None:
@@ -176,7 +187,7 @@ def plot_opcounts(report, mod, ax=None):
     else:
         fig = None
 
-    labels, counts = gather_count_data(report=report, mod=mod)
+    labels, counts = gather_count_data(report=report, mod=mod, op_counts=op_counts)
 
     x = np.arange(len(labels))  # the label locations
     rects = ax.bar(x, counts)
@@ -7,8 +7,11 @@ import math
 
 from operator import itemgetter
 
+import numpy as np
 from PIL import Image, ImageDraw
 
+from darshan.experimental.plots import heatmap_handling
+
 
 def sanitize_size(x):
     """ Ensure segments are at least represented by one pixel. """
@@ -201,6 +204,45 @@ def wallclock(rec):
 
 
 
+def heatmap(segs, nprocs, width=720, height=None, max_time=None):
+    """
+        Renders DXT segments (as yielded by DarshanReport.iter_dxt()) as a
+        ranks x time image with one bin per pixel, rather than drawing
+        every segment. Ranks are bucketed when there are more of them
+        than pixel rows, and brightness is log-scaled by bytes moved.
+    """
+
+    if height is None:
+        height = nprocs
+    height = min(height, nprocs)
+    if max_time is None:
+        max_time = segs['end_time'].max()
+    if not max_time > 0:
+        max_time = 1
+
+    grid = heatmap_handling.bin_dxt_segments(
+            ranks=segs['rank'].values,
+            start_times=segs['start_time'].values,
+            end_times=segs['end_time'].values,
+            lengths=segs['length'].values,
+            xbins=width, nprocs=nprocs, max_time=max_time, ybins=height)
+
+    grid = np.log1p(grid)
+    if grid.max() > 0:
+        grid = grid / grid.max()
+
+    # same palette as the other modes: dark background, write colour
+    background = np.array([33, 33, 33], dtype=np.float64)
+    fill = np.array([66, 222, 222], dtype=np.float64)
+    pixels = background + grid[:, :, np.newaxis] * (fill - background)
+
+    return Image.fromarray(pixels.astype(np.uint8), 'RGB')
+
+
+
+
+
+
 def visualize(data, modes=['wallclock', 'segment'], path="./"):
     """
         alternative mode: wallclock
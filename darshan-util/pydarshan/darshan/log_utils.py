@@ -16,8 +16,12 @@ import functools
 import sys
 import os
 import glob
+import json
+import concurrent.futures
 from typing import Optional, Any
 
+import numpy as np
+
 if "pytest" in sys.modules:
     # only import pytest if used in a testing context
     import pytest
@@ -102,3 +106,162 @@ def get_log_path(filename: str) -> str:
             pytest.skip(err_msg)
         else:
             raise FileNotFoundError(err_msg)
+
+
+def read_logs_concurrently(filenames, mod_name, nthreads=None,
+                           batch_size=16384):
+    """
+    Reads the records of one module from many logs concurrently, with up
+    to nthreads threads each reading its own log.
+
+    Every thread opens its own libdarshan-util handle, and handles are
+    independent of one another, so the logs are decompressed and decoded
+    in parallel: cffi releases the GIL for the duration of each library
+    call, and the library writes records straight into preallocated numpy
+    arrays, leaving no per-record work in Python.
+
+    Parameters
+    ----------
+    filenames: paths of the Darshan logs to read.
+    mod_name: name of a Darshan module with fixed-size records
+    (e.g., "POSIX").
+    nthreads: maximum number of logs to read at once, one per
+    processor if None.
+    batch_size: number of records to read per library call.
+
+    Returns
+    -------
+    recs: dictionary of arrays in the format of
+    `log_get_generic_record_arrays()`, holding the records of all logs in
+    the order of filenames, plus a 'log' array holding the index into
+    filenames of the log each record was read from.
+
+    Raises
+    ------
+    ValueError: if the module does not have fixed-size records.
+    RuntimeError: if a log can not be opened.
+
+    """
+    # imported here so locating logs does not require libdarshan-util
+    from darshan.backend import cffi_backend as backend
+
+    if mod_name not in backend._batch_mods:
+        raise ValueError(f"module {mod_name} does not have fixed-size records")
+
+    def read_log(filename):
+        log = backend.log_open(filename)
+        if not bool(log['handle']):
+            raise RuntimeError(f"Failed to open file {filename}.")
+        try:
+            if mod_name not in backend.log_get_modules(log):
+                return []
+            return list(backend._iter_generic_record_batches(log, mod_name,
+                                                             batch_size))
+        finally:
+            backend.log_close(log)
+
+    with concurrent.futures.ThreadPoolExecutor(max_workers=nthreads) as executor:
+        log_chunks = list(executor.map(read_log, filenames))
+
+    # gather the batches of all logs into one array per field
+    counts = [sum(len(chunk) for chunk in chunks) for chunks in log_chunks]
+    recs = np.empty(sum(counts), dtype=backend._generic_record_dtype(mod_name))
+    off = 0
+    for chunks in log_chunks:
+        for chunk in chunks:
+            recs[off:off + len(chunk)] = chunk
+            off += len(chunk)
+    arrays = backend._split_generic_record_batch(recs)
+    arrays['log'] = np.repeat(np.arange(len(filenames), dtype=np.int32),
+                              counts)
+    return arrays
+
+
+def write_ndjson(filename, out, mods=None, counters=None, names=True,
+                 batch_size=16384):
+    """
+    Writes the records of a log as newline-delimited JSON, one object per
+    record, module by module.
+
+    Records are read in batches with the batch record API and written
+    out before the next batch is read, so memory use does not grow with
+    the number of records. Each object holds the module, job id, record
+    id and rank of the record (plus 'file_rec_id' for H5D and
+    PNETCDF_VAR) and one key per counter.
+
+    Parameters
+    ----------
+    filename: path of the Darshan log.
+    out: text stream the records are written to.
+    mods: names of the modules to write, all modules with fixed-size
+    records if None. Other modules are skipped.
+    counters: names of the counters to write, all counters if None;
+    modules with none of the counters are skipped.
+    names: whether to add the 'name' of each record. The name records
+    are the only data held for the whole log.
+    batch_size: number of records to read per library call.
+
+    Returns
+    -------
+    nrecs: the number of records written.
+
+    Raises
+    ------
+    RuntimeError: if the log can not be opened.
+
+    """
+    # imported here so locating logs does not require libdarshan-util
+    from darshan.backend import cffi_backend as backend
+
+    log = backend.log_open(filename)
+    if not bool(log['handle']):
+        raise RuntimeError(f"Failed to open file {filename}.")
+    try:
+        jobid = backend.log_get_job(log)['jobid']
+        name_records = backend.log_get_name_records(log) if names else None
+        if counters is not None:
+            counters = set(counters)
+
+        nrecs = 0
+        for mod in backend.log_get_modules(log):
+            if mod not in backend._batch_mods:
+                continue
+            if mods is not None and mod not in mods:
+                continue
+            cnames = backend.counter_names(mod)
+            fnames = backend.fcounter_names(mod)
+            ccols = [i for i, c in enumerate(cnames)
+                     if counters is None or c in counters]
+            fcols = [i for i, c in enumerate(fnames)
+                     if counters is None or c in counters]
+            if not ccols and not fcols:
+                continue
+            keys = [cnames[i] for i in ccols] + [fnames[i] for i in fcols]
+
+            for recs in backend._iter_generic_record_batches(log, mod,
+                                                             batch_size):
+                # convert whole columns at once, leaving only the
+                # serialization to be done record by record
+                ids = recs['id'].tolist()
+                ranks = recs['rank'].tolist()
+                file_rec_ids = (recs['file_rec_id'].tolist()
+                                if 'file_rec_id' in recs.dtype.names else None)
+                vals = zip(recs['counters'][:, ccols].tolist(),
+                           recs['fcounters'][:, fcols].tolist())
+                lines = []
+                for i, (cvals, fvals) in enumerate(vals):
+                    obj = {'module': mod, 'jobid': jobid, 'id': ids[i],
+                           'rank': ranks[i]}
+                    if file_rec_ids is not None:
+                        obj['file_rec_id'] = file_rec_ids[i]
+                    if name_records is not None:
+                        obj['name'] = name_records.get(ids[i])
+                    obj.update(zip(keys, cvals + fvals))
+                    lines.append(json.dumps(obj))
+                lines.append('')
+                out.write('\n'.join(lines))
+                nrecs += len(ids)
+    finally:
+        backend.log_close(log)
+
+    return nrecs
@@ -8,6 +8,7 @@ interaction and aggregation of Darshan logs using Python.
 
 
 import darshan.backend.cffi_backend as backend
+from darshan.backend.cache import LogCache
 
 from darshan.datatypes.heatmap import Heatmap
 
@@ -146,7 +147,7 @@ class DarshanRecordCollection(collections.abc.MutableSequence):
         if mod in ['LUSTRE']:
             for i, rec in enumerate(records):
                 pass
-        elif mod in ['DXT_POSIX', 'DXT_MPIIO']:
+        elif mod in ['DXT_POSIX', 'DXT_MPIIO', 'DXT_STDIO']:
             ids = set()
             ranks = set()
             hostnames = set()
@@ -214,7 +215,7 @@ class DarshanRecordCollection(collections.abc.MutableSequence):
 
         if mod in ['LUSTRE']:
             raise NotImplementedError
-        elif mod in ['DXT_POSIX', 'DXT_MPIIO']:
+        elif mod in ['DXT_POSIX', 'DXT_MPIIO', 'DXT_STDIO']:
             raise NotImplementedError
         else:
             for i, rec in enumerate(records):
@@ -228,7 +229,7 @@ class DarshanRecordCollection(collections.abc.MutableSequence):
         counters = self.report.counters[self.mod]
         if mod in ['LUSTRE']:
             raise NotImplementedError
-        elif mod in ['DXT_POSIX', 'DXT_MPIIO']:
+        elif mod in ['DXT_POSIX', 'DXT_MPIIO', 'DXT_STDIO']:
             # format already in a dict format, but may offer switches for expansion
             logger.warn("WARNING: The output of DarshanRecordCollection.to_dict() may change in the future.")
         else:
@@ -267,7 +268,7 @@ class DarshanRecordCollection(collections.abc.MutableSequence):
 
             records = {"components": counter_df}
 
-        elif mod in ['DXT_POSIX', 'DXT_MPIIO']:
+        elif mod in ['DXT_POSIX', 'DXT_MPIIO', 'DXT_STDIO']:
             for rec in records:
                 rec['read_segments'] = pd.DataFrame(rec['read_segments'])
                 rec['write_segments'] = pd.DataFrame(rec['write_segments'])
@@ -294,6 +295,79 @@ class DarshanRecordCollection(collections.abc.MutableSequence):
         return records
 
 
+class _ReportRecords(dict):
+    """
+    Dictionary of the record collections of a DarshanReport, keyed by
+    module name.
+
+    For lazy reports, the records of a module are read from the log the
+    first time they are looked up with ``records[mod]``, and if the report
+    has a memory budget, the least recently used modules are evicted once
+    the loaded records exceed it. Evicted modules are read again on their
+    next lookup. Other dictionary methods (``in``, ``get()``, iteration)
+    only see the modules that are currently loaded.
+    """
+
+    def __init__(self, report):
+        super(_ReportRecords, self).__init__()
+        self._report = report
+        self._nbytes = collections.OrderedDict()   # loaded module => size estimate, LRU first
+
+    def __missing__(self, mod):
+        report = self._report
+        if not report.lazy or getattr(report, 'log', None) is None or mod not in report.modules:
+            raise KeyError(mod)
+
+        report._load_module(mod)
+        if not dict.__contains__(self, mod):
+            raise KeyError(mod)
+        self._track(mod)
+        return dict.__getitem__(self, mod)
+
+    def __getitem__(self, mod):
+        val = super(_ReportRecords, self).__getitem__(mod)
+        if mod in self._nbytes:
+            self._nbytes.move_to_end(mod)
+        return val
+
+    def __delitem__(self, mod):
+        super(_ReportRecords, self).__delitem__(mod)
+        self._nbytes.pop(mod, None)
+
+    def _track(self, mod):
+        """
+        Accounts for the freshly loaded records of 'mod' and evicts the least
+        recently used other modules while over the report's memory budget.
+        """
+        max_memory = self._report.max_memory
+        if max_memory is None:
+            return
+
+        self._nbytes[mod] = _estimate_nbytes(dict.__getitem__(self, mod))
+        self._nbytes.move_to_end(mod)
+        while sum(self._nbytes.values()) > max_memory and len(self._nbytes) > 1:
+            lru_mod = next(iter(self._nbytes))
+            logger.debug(f" Evicting records of mod={lru_mod} from memory")
+            del self[lru_mod]
+
+
+def _estimate_nbytes(obj):
+    """
+    Returns a rough estimate of the memory used by loaded records.
+    """
+    if isinstance(obj, np.ndarray):
+        return obj.nbytes
+    if isinstance(obj, pd.DataFrame):
+        return int(obj.memory_usage(index=True).sum())
+    if isinstance(obj, DarshanRecordCollection):
+        obj = obj._records
+    if isinstance(obj, dict):
+        return sys.getsizeof(obj) + sum(_estimate_nbytes(v) for v in obj.values())
+    if isinstance(obj, (list, tuple)):
+        return sys.getsizeof(obj) + sum(_estimate_nbytes(v) for v in obj)
+    return sys.getsizeof(obj)
+
+
 class DarshanReport(object):
     """
     The DarshanReport class provides a convienient wrapper to access darshan
@@ -309,7 +383,8 @@ class DarshanReport(object):
             filename=None, dtype='numpy', 
             start_time=None, end_time=None,
             automatic_summary=False,
-            read_all=True, lookup_name_records=True):
+            read_all=True, lookup_name_records=True,
+            lazy=False, max_memory=None, cache=None):
         """
         Args:
             filename (str): filename to open (optional)
@@ -317,6 +392,17 @@ class DarshanReport(object):
             automatic_summary (bool): automatically generate summary after loading
             read_all (bool): whether to read all records for log
             lookup_name_records (bool): lookup and update name_records as records are loaded
+            lazy (bool): read the records of each module when first accessed
+                through ``records[mod]`` rather than when opening the log
+                (read_all is ignored)
+            max_memory (int): for lazy reports, approximate number of bytes of
+                loaded records above which the least recently used modules
+                are evicted (default: no limit)
+            cache (bool or str): keep the decoded records of modules with
+                fixed-size records, the name records and the heatmaps in an
+                on-disk cache and reuse them on later opens of the unmodified
+                log; either a cache directory, or True for the default one
+                (see darshan.backend.cache.default_cache_dir())
 
         Return:
             None
@@ -329,6 +415,11 @@ class DarshanReport(object):
         self.dtype = dtype                                  # default dtype to return when viewing records
         self.automatic_summary = automatic_summary
         self.lookup_name_records = lookup_name_records
+        self.lazy = lazy
+        self.max_memory = max_memory
+        self.cache = cache
+        self._cache = None
+        self._cached_name_records = None
 
         # State dependent book-keeping
         self.converted_records = False  # true if convert_records() was called (unnumpyfy)
@@ -345,7 +436,7 @@ class DarshanReport(object):
         self._metadata = {}
         self._modules = {}
         self._counters = {}
-        self.records = {}
+        self.records = _ReportRecords(self)
         self._mounts = {}
         self.name_records = {}
         self._heatmaps = {}
@@ -374,7 +465,7 @@ class DarshanReport(object):
 
 
         if filename:
-            self.open(filename, read_all=read_all)    
+            self.open(filename, read_all=read_all and not lazy)
 
 
     @property
@@ -391,6 +482,11 @@ class DarshanReport(object):
 
     @property
     def heatmaps(self):
+        # lazy reports read the heatmaps on first access
+        if (self.lazy and not self._heatmaps and "HEATMAP" in self._modules and
+                getattr(self, 'log', None) is not None):
+            backend.log_rewind_mod(self.log, "HEATMAP")
+            self.read_all_heatmap_records()
         return self._heatmaps
 
 #    @property
@@ -428,6 +524,10 @@ class DarshanReport(object):
             if not bool(self.log['handle']):
                 raise RuntimeError("Failed to open file.")
 
+            if self.cache:
+                cache_dir = self.cache if isinstance(self.cache, str) else None
+                self._cache = LogCache(self.filename, cache_dir)
+
             self.read_metadata(read_all=read_all)
 
             if read_all:
@@ -489,10 +589,37 @@ class DarshanReport(object):
         self._modules = self.data['modules']
 
         if read_all == True:
-            self.data["name_records"] = backend.log_get_name_records(self.log)
+            self.data["name_records"] = self._all_name_records()
             self.name_records = self.data['name_records']
 
 
+    def _all_name_records(self):
+        """
+        Returns all name records of the log, from the on-disk cache if enabled.
+        """
+        if self._cache is None:
+            return backend.log_get_name_records(self.log)
+
+        if self._cached_name_records is None:
+            name_records = self._cache.get_name_records()
+            if name_records is None:
+                name_records = backend.log_get_name_records(self.log)
+                self._cache.put_name_records(name_records)
+            self._cached_name_records = name_records
+        return self._cached_name_records
+
+
+    def _lookup_name_records(self, ids):
+        """
+        Returns the name records of the given record ids.
+        """
+        if self._cache is None:
+            return backend.log_lookup_name_records(self.log, ids)
+
+        name_records = self._all_name_records()
+        return {rec_id: name_records[rec_id] for rec_id in ids if rec_id in name_records}
+
+
     def update_name_records(self, mod=None):
         """
         Update (and prune unused) name records from resolve table.
@@ -524,7 +651,7 @@ class DarshanReport(object):
                 ids.add(rec['id'])
 
 
-        self.name_records.update(backend.log_lookup_name_records(self.log, ids))
+        self.name_records.update(self._lookup_name_records(ids))
         
 
     def read_all(self, dtype=None):
@@ -538,6 +665,11 @@ class DarshanReport(object):
             None
         """
 
+        # inflate all module regions up front, using every available core,
+        # unless all of them are served from the on-disk cache
+        if self._cache is None or not all(self._cache.has(mod) for mod in self.data['modules']):
+            backend.log_prefetch_mods(self.log)
+
         self.read_all_generic_records(dtype=dtype)
         self.read_all_dxt_records(dtype=dtype)
         if "LUSTRE" in self.data['modules']:
@@ -552,6 +684,77 @@ class DarshanReport(object):
         return
 
 
+    def _load_module(self, mod):
+        """
+        Reads all records of a module from its first record, for lazy
+        reports.
+        """
+        backend.log_rewind_mod(self.log, mod)
+
+        if mod in ['DXT_POSIX', 'DXT_MPIIO', 'DXT_STDIO']:
+            self.mod_read_all_dxt_records(mod, warnings=False)
+        elif mod == "LUSTRE":
+            self.mod_read_all_lustre_records(warnings=False)
+        elif mod == "APMPI":
+            self.mod_read_all_apmpi_records(warnings=False)
+        elif mod == "APXC":
+            self.mod_read_all_apxc_records(warnings=False)
+        elif mod != "HEATMAP":
+            self.mod_read_all_records(mod, warnings=False)
+
+
+    def iter_records(self, mod, chunk_size=65536, dtype=None):
+        """
+        Iterates over the records of a module chunk_size records at a time,
+        without keeping them in the report, for modules too large to hold
+        in memory at once. Reading starts at the module's first record; the
+        records of other modules should not be read until the iteration is
+        complete.
+
+        Args:
+            mod (str): Identifier of module to iterate over
+            chunk_size (int): maximum number of records per chunk
+            dtype (str): 'numpy', 'dict' or 'pandas' (default: report dtype)
+
+        Return:
+            iterator over chunks of records: for 'pandas' and modules with
+            fixed-size records, a single record dictionary holding counter
+            and fcounter dataframes (as in mod_read_all_records()), and
+            otherwise a list of records
+        """
+        if mod not in self.modules:
+            raise ModuleNotInDarshanLog(f"mod {mod} is not available in this DarshanReport object.")
+        if mod in ['LUSTRE', 'APMPI', 'APXC', 'HEATMAP']:
+            raise NotImplementedError(f"iter_records() does not support mod {mod}")
+
+        dtype = dtype if dtype else self.dtype
+        backend.log_rewind_mod(self.log, mod)
+
+        if mod in backend._batch_mods:
+            for arr in backend.log_iter_generic_record_arrays(self.log, mod, chunk_size):
+                if dtype == 'pandas':
+                    yield backend._make_generic_records_df(arr, mod)
+                    continue
+                file_rec_ids = arr.get('file_rec_id')
+                yield [backend._make_generic_record_from_arrays(arr['id'][i],
+                            arr['rank'][i],
+                            None if file_rec_ids is None else file_rec_ids[i],
+                            arr['counters'][i], arr['fcounters'][i], mod, dtype)
+                       for i in range(len(arr['id']))]
+            return
+
+        chunk = []
+        rec = backend.log_get_record(self.log, mod, dtype=dtype)
+        while rec is not None:
+            chunk.append(rec)
+            if len(chunk) == chunk_size:
+                yield chunk
+                chunk = []
+            rec = backend.log_get_record(self.log, mod, dtype=dtype)
+        if chunk:
+            yield chunk
+
+
     def read_all_generic_records(self, counters=True, fcounters=True, dtype=None):
         """
         Read all generic records from darshan log and return as dictionary.
@@ -621,16 +824,21 @@ class DarshanReport(object):
 
         heatmaps = {}
 
-        # fetch records
-        rec = backend._log_get_heatmap_record(self.log)
-        while rec is not None:            
-            mod = heatmap_rec_to_module_name(rec, nrecs=_nrecs_heatmap)
-            if mod not in heatmaps:
+        # fetch all records at once, as arrays with a row of bins per record
+        arr = self._cache.get_heatmaps() if self._cache is not None else None
+        if arr is None:
+            arr = backend.log_get_heatmap_arrays(self.log)
+            if arr is not None and self._cache is not None:
+                self._cache.put_heatmaps(arr)
+
+        if arr is not None:
+            # one heatmap per record id, in the order they appear in the log
+            ids, first = np.unique(arr['id'], return_index=True)
+            for rec_id in ids[np.argsort(first)]:
+                mod = heatmap_rec_to_module_name({'id': int(rec_id)}, nrecs=_nrecs_heatmap)
+                sel = arr['id'] == rec_id
                 heatmaps[mod] = Heatmap(mod)
-            heatmaps[mod].add_record(rec)
-
-            # fetch next
-            rec = backend._log_get_heatmap_record(self.log)
+                heatmaps[mod].add_records({key: val[sel] for key, val in arr.items()})
 
         self._heatmaps = heatmaps
 
@@ -647,7 +855,7 @@ class DarshanReport(object):
             None
 
         """
-        unsupported =  ['DXT_POSIX', 'DXT_MPIIO', 'LUSTRE', 'APMPI', 'APXC', 'HEATMAP']
+        unsupported =  ['DXT_POSIX', 'DXT_MPIIO', 'DXT_STDIO', 'LUSTRE', 'APMPI', 'APXC', 'HEATMAP']
 
         if mod in unsupported:
             if warnings:
@@ -675,15 +883,33 @@ class DarshanReport(object):
             self.counters[mod]['fcounters'] = fcn
 
 
+        # for pandas, records of modules with fixed-size records are read
+        # into numpy arrays in bulk and the frames are built once; with
+        # the on-disk cache enabled, the arrays are cached for all dtypes
+        if mod in backend._batch_mods and (dtype == 'pandas' or self._cache is not None):
+            arr = self._cache.get_records(mod) if self._cache is not None else None
+            if arr is None:
+                arr = backend.log_get_generic_record_arrays(self.log, mod)
+                if self._cache is not None:
+                    self._cache.put_records(mod, arr)
+
+            if dtype == 'pandas':
+                self.records[mod].append(backend._make_generic_records_df(arr, mod))
+            else:
+                for rec in backend._make_generic_records_from_arrays(arr, mod, dtype):
+                    self.records[mod].append(rec)
+            self._modules[mod]['num_records'] = len(arr['id'])
+
+            if self.lookup_name_records:
+                ids = set(arr['id'].tolist())
+                self.name_records.update(self._lookup_name_records(ids))
+            return
+
         # fetch records
-        rec = backend.log_get_generic_record(self.log, mod, dtype=dtype)
-        while rec != None:
+        for rec in backend.log_get_generic_records(self.log, mod, dtype=dtype):
             self.records[mod].append(rec)
             self._modules[mod]['num_records'] += 1
 
-            # fetch next
-            rec = backend.log_get_generic_record(self.log, mod, dtype=dtype)
-
 
         if self.lookup_name_records:
             self.update_name_records(mod=mod)
@@ -693,20 +919,9 @@ class DarshanReport(object):
             combined_c = None
             combined_fc = None
 
-            for rec in self.records[mod]:
-                obj = rec['counters']
-                #print(type(obj))
-                #display(obj)
-                
-                if combined_c is None:
-                    combined_c = rec['counters']
-                else:
-                    combined_c = pd.concat([combined_c, rec['counters']])
-                    
-                if combined_fc is None:
-                    combined_fc = rec['fcounters']
-                else:
-                    combined_fc = pd.concat([combined_fc, rec['fcounters']])
+            if len(self.records[mod]) > 0:
+                combined_c = pd.concat([rec['counters'] for rec in self.records[mod]])
+                combined_fc = pd.concat([rec['fcounters'] for rec in self.records[mod]])
 
             self.records[mod] = [{
                 'rank': -1,
@@ -833,7 +1048,7 @@ class DarshanReport(object):
             return
 
 
-        supported =  ['DXT_POSIX', 'DXT_MPIIO']
+        supported =  ['DXT_POSIX', 'DXT_MPIIO', 'DXT_STDIO']
 
         if mod not in supported:
             if warnings:
@@ -868,6 +1083,71 @@ class DarshanReport(object):
             self.update_name_records(mod=mod)
 
 
+    def mod_read_dxt_segments(self, mod, reads=True, writes=True):
+        """
+        Reads the trace segments of all dxt records of the provided module
+        into a single DataFrame, built column-wise from numpy arrays. This
+        is much faster and uses much less memory than reading the records
+        with mod_read_all_dxt_records() for large traces. The records are
+        not added to the report's records.
+
+        Args:
+            mod (str): Identifier of the DXT module
+            reads (bool): include read segments
+            writes (bool): include write segments
+
+        Return:
+            DataFrame with one row per segment and the columns 'id', 'rank',
+            'hostname', 'op' ('write' or 'read'), 'offset', 'length',
+            'start_time', 'end_time' and 'thread_id', or None if the log
+            does not contain data for the module
+        """
+        if mod not in ['DXT_POSIX', 'DXT_MPIIO', 'DXT_STDIO']:
+            raise ValueError(f"Unsupported module: {mod}")
+
+        return backend.log_get_dxt_segments(self.log, mod, reads=reads, writes=writes)
+
+
+    def iter_dxt(self, mod, ranks=None, t0=0.0, t1=None, chunk=1000000,
+                 reads=True, writes=True):
+        """
+        Streams the trace segments of a dxt module from the log in chunks,
+        so that traces that do not fit in memory can be processed piecewise.
+        Each chunk is a DataFrame in the format of mod_read_dxt_segments(),
+        holding the segments of whole records until at least 'chunk'
+        segments are collected. The records are not added to the report's
+        records.
+
+        Records of other ranks, and records without segments in the time
+        window, are skipped without decoding their segments if the log
+        stores the time range of each record.
+
+        Args:
+            mod (str): Identifier of the DXT module
+            ranks (iterable): ranks whose segments are included (default: all)
+            t0 (float): start of the time window in seconds
+            t1 (float): end of the time window in seconds (default: no end)
+            chunk (int): number of segments per chunk
+            reads (bool): include read segments
+            writes (bool): include write segments
+
+        Return:
+            Iterator over DataFrames with one row per segment (see
+            mod_read_dxt_segments()); nothing is yielded if the log does
+            not contain data for the module
+
+        .. note::
+            The iterator reads from the report's log, so it should be
+            exhausted before other records of the module are read.
+        """
+        if mod not in ['DXT_POSIX', 'DXT_MPIIO', 'DXT_STDIO']:
+            raise ValueError(f"Unsupported module: {mod}")
+
+        return backend.log_iter_dxt_segments(self.log, mod, reads=reads,
+                                             writes=writes, ranks=ranks,
+                                             t0=t0, t1=t1, chunk=chunk)
+
+
 
 
     def mod_read_all_lustre_records(self, mod="LUSTRE", dtype=None, warnings=True):
@@ -1122,6 +1402,26 @@ class DarshanReport(object):
         return json.dumps(data, cls=DarshanReportJSONEncoder)
 
 
+    def to_ndjson(self, out, mods=None, counters=None, names=True):
+        """
+        Write the records of the log to a stream as newline-delimited JSON,
+        one object per record, without loading them into the report.
+        See darshan.log_utils.write_ndjson() for the format.
+
+        Args:
+            out: text stream to write to
+            mods (list): modules to write (default: all with fixed-size records)
+            counters (list): counters to write (default: all)
+            names (bool): add the name of each record
+
+        Return:
+            int: number of records written
+        """
+        from darshan.log_utils import write_ndjson
+        return write_ndjson(self.filename, out, mods=mods, counters=counters,
+                            names=names)
+
+
     def _cleanup(self):
         """
         Cleanup when deleting object.
@@ -162,6 +162,40 @@ def test_log_get_generic_record(dtype):
         assert actual_fcounter_names == expected_fcounter_names
 
 
+@pytest.mark.parametrize("log_name, module", [
+    ("sample.darshan", "POSIX"),
+    ("sample.darshan", "MPI-IO"),
+    ("sample.darshan", "STDIO"),
+    ("imbalanced-io.darshan", "POSIX"),
+    ])
+def test_mod_read_all_records_pandas_bulk(log_name, module):
+    # the dataframes built in bulk for dtype="pandas" should
+    # hold the same values as the individual numpy records
+    log_path = get_log_path(log_name)
+    with darshan.DarshanReport(log_path, read_all=False) as report:
+        report.mod_read_all_records(module, dtype="numpy")
+        recs = report.records[module].to_numpy()
+    with darshan.DarshanReport(log_path, read_all=False) as report:
+        report.mod_read_all_records(module, dtype="pandas")
+        rec_dict = report.records[module][0]
+        num_records = report.modules[module]['num_records']
+
+    counters_df = rec_dict["counters"]
+    fcounters_df = rec_dict["fcounters"]
+    assert num_records == len(recs)
+    assert list(counters_df.columns) == ["id", "rank"] + backend.counter_names(module)
+    assert list(fcounters_df.columns) == ["id", "rank"] + backend.fcounter_names(module)
+    assert counters_df["id"].dtype == np.uint64
+    assert fcounters_df["id"].dtype == np.uint64
+    assert_array_equal(counters_df["id"].values, [rec["id"] for rec in recs])
+    assert_array_equal(counters_df["rank"].values, [rec["rank"] for rec in recs])
+    assert_array_equal(fcounters_df["rank"].values, [rec["rank"] for rec in recs])
+    assert_array_equal(counters_df.iloc[:, 2:].values,
+                       np.stack([rec["counters"] for rec in recs]))
+    assert_array_equal(fcounters_df.iloc[:, 2:].values,
+                       np.stack([rec["fcounters"] for rec in recs]))
+
+
 @pytest.mark.parametrize("log_name", [
     "imbalanced-io.darshan",
     "e3sm_io_heatmap_only.darshan",
@@ -272,3 +306,77 @@ def test_reverse_record_array(python_filter, expected_counts):
                         actual_wo_files,
                         actual_rw_files],
                         expected_counts)
+
+
+@pytest.mark.parametrize("mod", ["POSIX", "STDIO"])
+def test_read_logs_concurrently(mod):
+    # libdarshan-util handles are independent, so reading the same logs
+    # from many threads at once must match reading them one at a time
+    from darshan.log_utils import read_logs_concurrently
+    lognames = ["sample.darshan", "sample-dxt-simple.darshan",
+                "noposix.darshan", "sample-badost.darshan"] * 4
+    paths = [get_log_path(name) for name in lognames]
+
+    actual = read_logs_concurrently(paths, mod, nthreads=8, batch_size=7)
+
+    for i, path in enumerate(paths):
+        log = backend.log_open(path)
+        expected = backend.log_get_generic_record_arrays(log, mod)
+        backend.log_close(log)
+        mask = actual["log"] == i
+        if expected is None:
+            assert not mask.any()
+            continue
+        for field in ("id", "rank", "counters", "fcounters"):
+            assert_array_equal(actual[field][mask], expected[field])
+
+
+def test_write_ndjson():
+    # the streamed NDJSON records must match the records read into a
+    # report, and counter projection must only keep the selected counters
+    import io
+    import json
+    from darshan.log_utils import write_ndjson
+    path = get_log_path("sample.darshan")
+
+    out = io.StringIO()
+    nrecs = write_ndjson(path, out, batch_size=7)
+    lines = out.getvalue().splitlines()
+    assert len(lines) == nrecs
+
+    with darshan.DarshanReport(path, read_all=True) as report:
+        jobid = report.metadata["job"]["jobid"]
+        posix = [json.loads(l) for l in lines if '"module": "POSIX"' in l]
+        expected = report.records["POSIX"].to_df()["counters"]
+        assert len(posix) == len(expected)
+        assert [rec["id"] for rec in posix] == expected["id"].tolist()
+        assert [rec["rank"] for rec in posix] == expected["rank"].tolist()
+        assert ([rec["POSIX_BYTES_READ"] for rec in posix] ==
+                expected["POSIX_BYTES_READ"].tolist())
+        for rec in posix:
+            assert rec["jobid"] == jobid
+            assert rec["name"] == report.name_records[rec["id"]]
+
+    out = io.StringIO()
+    write_ndjson(path, out, counters=["POSIX_BYTES_READ"], names=False)
+    for line in out.getvalue().splitlines():
+        rec = json.loads(line)
+        assert rec["module"] == "POSIX"
+        assert set(rec) == {"module", "jobid", "id", "rank", "POSIX_BYTES_READ"}
+
+
+def test_log_get_name_record_arrays():
+    # the bulk decoded name table must match decoding it name by name
+    log = backend.log_open(get_log_path("sample.darshan"))
+    ids, names = backend.log_get_name_record_arrays(log)
+    # decode the name table one entry at a time for reference
+    table = ffi.new("struct darshan_name_table **")
+    assert libdutil.darshan_log_get_name_table(log['handle'], table) == 0
+    expected = {}
+    for i in range(table[0].count):
+        entry = table[0].entries[i]
+        expected[entry.id] = ffi.string(table[0].names + entry.name_off).decode("utf-8")
+    libdutil.darshan_name_table_free(table[0])
+    backend.log_close(log)
+    assert dict(zip(ids.tolist(), names)) == expected
+    assert np.all(np.diff(ids.astype(np.float64)) >= 0)
@@ -11,6 +11,7 @@ import matplotlib.pyplot as plt
 
 import darshan
 from darshan.experimental.plots import data_access_by_filesystem
+import darshan.backend.cffi_backend as backend
 from darshan.log_utils import get_log_path
 
 @pytest.mark.parametrize("series, expected_series", [
@@ -679,3 +680,31 @@ def test_stdio_basic_inclusion(logname,
     assert_series_equal(file_wr_series, expected_file_wr_series)
     assert_series_equal(bytes_rd_series, expected_bytes_rd_series)
     assert_series_equal(bytes_wr_series, expected_bytes_wr_series)
+
+
+@pytest.mark.parametrize("logname", [
+    "ior_hdf5_example.darshan",
+    "imbalanced-io.darshan",
+    "nonmpi_dxt_anonymized.darshan",
+    ])
+def test_category_io_matches_records(logname):
+    # the per-filesystem data accessed summed by darshan-util in one pass
+    # must match the values computed from the record dataframes
+    log_path = get_log_path(logname)
+    with darshan.DarshanReport(log_path) as report:
+        (filesystem_roots, file_rd_series, file_wr_series,
+         bytes_rd_series, bytes_wr_series) = data_access_by_filesystem._rw_series_from_records(report)
+        roots, ids, categories = data_access_by_filesystem.filesystem_categories(report)
+        rec_dicts = {mod: report.records[mod].to_df()
+                     for mod in ["POSIX", "STDIO"] if mod in report.modules}
+        summary = backend.summarize_records(rec_dicts, report.metadata['job']['nprocs'],
+                                            file_categories=(ids, categories, len(roots)))
+
+    assert roots == filesystem_roots
+    category_io = summary.categories.set_index(pd.Index(roots))
+    for column, expected in [("files_read", file_rd_series),
+                             ("files_written", file_wr_series),
+                             ("bytes_read", bytes_rd_series),
+                             ("bytes_written", bytes_wr_series)]:
+        assert_series_equal(category_io[column].astype(np.float64), expected,
+                            check_names=False, check_index_type=False)
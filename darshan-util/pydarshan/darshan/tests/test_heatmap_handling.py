@@ -4,6 +4,7 @@ from numpy.testing import assert_array_equal, assert_allclose
 import pandas as pd
 
 import darshan
+from darshan.datatypes.heatmap import Heatmap
 from darshan.experimental.plots import heatmap_handling
 from darshan.log_utils import get_log_path
 
@@ -602,3 +603,192 @@ def test_get_heatmap_df(
             assert actual_hmap_data.values.sum() == 4202504
         elif ops[0] == "write":
             assert actual_hmap_data.values.sum() == 4195800
+
+
+def test_get_runtime_heatmap_df_op_counts():
+    # `heatmap_handling.get_runtime_heatmap_df()` should expose the op
+    # count bins of runtime heatmaps, padding inactive ranks with zeros
+    hmap = Heatmap("heatmap:POSIX")
+    hmap.add_record({
+        "id": 1,
+        "rank": 1,
+        "bin_width_seconds": 0.1,
+        "nbins": 3,
+        "write_bins": np.array([100, 0, 50]),
+        "read_bins": np.array([0, 10, 0]),
+        "write_op_bins": np.array([2, 0, 1]),
+        "read_op_bins": np.array([0, 1, 0]),
+        "meta_op_bins": np.array([1, 0, 2]),
+    })
+
+    class MockReport:
+        heatmaps = {"heatmap:POSIX": hmap}
+
+    hmap_df = heatmap_handling.get_runtime_heatmap_df(
+        report=MockReport(), submodule="heatmap:POSIX", nprocs=2,
+        ops=["read_ops", "write_ops"])
+    assert_array_equal(hmap_df.values, [[0, 0, 0], [2, 1, 1]])
+
+    hmap_df = heatmap_handling.get_runtime_heatmap_df(
+        report=MockReport(), submodule="heatmap:POSIX", nprocs=2,
+        ops=["meta_ops"])
+    assert_array_equal(hmap_df.values, [[0, 0, 0], [1, 0, 2]])
+
+    with pytest.raises(ValueError, match="Cannot combine"):
+        heatmap_handling.get_runtime_heatmap_df(
+            report=MockReport(), submodule="heatmap:POSIX", nprocs=2,
+            ops=["read", "read_ops"])
+
+
+def test_runtime_heatmap_rebin():
+    # heatmap records added in bulk should be binned like single records,
+    # and merging bins should sum them and widen the time intervals
+    hmap = Heatmap("heatmap:POSIX")
+    hmap.add_records({
+        "id": np.array([1, 1, 1], dtype=np.uint64),
+        "rank": np.array([2, 0, 2]),
+        "bin_width_seconds": np.full(3, 0.1),
+        "nbins": np.full(3, 5),
+        "flags": np.zeros(3, dtype=np.int64),
+        "write_bins": np.array([[9, 9, 9, 9, 9],
+                                [0, 0, 0, 0, 1],
+                                [5, 4, 3, 2, 1]]),
+        "read_bins": np.ones((3, 5), dtype=np.int64),
+    })
+    hmap.add_record({
+        "id": 1,
+        "rank": 1,
+        "bin_width_seconds": 0.1,
+        "nbins": 5,
+        "write_bins": np.array([1, 0, 0, 0, 0]),
+        "read_bins": np.array([0, 0, 0, 0, 0]),
+        "write_op_bins": np.array([1, 0, 0, 0, 0]),
+        "read_op_bins": np.array([0, 0, 0, 0, 0]),
+        "meta_op_bins": np.array([0, 0, 3, 0, 0]),
+    })
+    assert hmap._num_recs == 4
+
+    # the later record of rank 2 replaces the earlier one
+    hmap_df = hmap.to_df(ops=["write"])
+    assert_array_equal(hmap_df.index, [0, 1, 2])
+    assert_array_equal(hmap_df.values, [[0, 0, 0, 0, 1],
+                                        [1, 0, 0, 0, 0],
+                                        [5, 4, 3, 2, 1]])
+
+    # records added without op counts have none
+    hmap_df = hmap.to_df(ops=["meta_ops"])
+    assert_array_equal(hmap_df.values, [[0, 0, 0, 0, 0],
+                                        [0, 0, 3, 0, 0],
+                                        [0, 0, 0, 0, 0]])
+
+    class MockReport:
+        heatmaps = {"heatmap:POSIX": hmap}
+
+    hmap_df = heatmap_handling.get_runtime_heatmap_df(
+        report=MockReport(), submodule="heatmap:POSIX", nprocs=4,
+        ops=["read", "write"], nbins=2)
+    assert_array_equal(hmap_df.values, [[3, 3],
+                                        [1, 0],
+                                        [15, 5],
+                                        [0, 0]])
+    assert_allclose(hmap_df.columns.right, [0.3, 0.6])
+
+    # no bins are merged if the heatmap already fits
+    hmap_df = hmap.to_df(ops=["write"], nbins=5)
+    assert hmap_df.shape == (3, 5)
+
+
+@pytest.mark.parametrize("filepath, mod", [
+    ("ior_hdf5_example.darshan", "DXT_MPIIO"),
+    ("dxt.darshan", "DXT_POSIX"),
+])
+@pytest.mark.parametrize("ops", [["read", "write"], ["write"]])
+def test_get_streamed_heatmap_df(filepath, mod, ops):
+    # binning the DXT segments streamed from the log in chunks
+    # should match binning all of them at once
+    filepath = get_log_path(filepath)
+    with darshan.DarshanReport(filepath) as report:
+        nprocs = report.metadata["job"]["nprocs"]
+        runtime = report.metadata["job"]["run_time"]
+        agg_df = heatmap_handling.get_aggregate_data(report=report, mod=mod, ops=ops)
+        expected = heatmap_handling.get_heatmap_df(agg_df=agg_df, xbins=50,
+                                                   nprocs=nprocs, max_time=runtime)
+
+    with darshan.DarshanReport(filepath, read_all=False) as report:
+        actual = heatmap_handling.get_streamed_heatmap_df(
+            report=report, mod=mod, xbins=50, nprocs=nprocs,
+            max_time=runtime, ops=ops, chunk=3)
+
+    assert_array_equal(actual.index, expected.index)
+    assert_array_equal(actual.columns, expected.columns)
+    assert_allclose(actual.values, expected.values)
+
+
+def test_bin_dxt_segments():
+    # segments are spread over the bins they overlap, zero-duration
+    # segments land in a single bin, and data outside the time span
+    # is dropped
+    grid = heatmap_handling.bin_dxt_segments(
+        ranks=[0, 3, 2, 1, 1],
+        start_times=[0.5, 1.0, 3.5, 4.5, 2.0],
+        end_times=[2.5, 1.0, 5.5, 5.0, 2.5],
+        lengths=[20, 7, 8, 3, 6],
+        xbins=4, nprocs=4, max_time=4.0, ybins=2)
+    assert_allclose(grid, [[5, 10, 11, 0],
+                           [0, 7, 0, 2]])
+
+    hmap_df = heatmap_handling.get_binned_heatmap_df(grid=grid, nprocs=4,
+                                                     max_time=4.0)
+    assert_array_equal(hmap_df.index, [0, 2])
+    assert_allclose(hmap_df.columns.right, [1, 2, 3, 4])
+
+
+@pytest.mark.parametrize("filepath, mod", [
+    ("ior_hdf5_example.darshan", "DXT_MPIIO"),
+    ("sample-dxt-simple.darshan", "DXT_POSIX"),
+])
+def test_get_fast_heatmap_df(filepath, mod):
+    # the vectorized binning should conserve the data, and bucketing
+    # ranks should only sum rows
+    filepath = get_log_path(filepath)
+    with darshan.DarshanReport(filepath) as report:
+        nprocs = report.metadata["job"]["nprocs"]
+        agg_df = heatmap_handling.get_aggregate_data(report=report, mod=mod,
+                                                     ops=["read", "write"])
+        runtime = report.metadata["job"]["run_time"]
+
+    max_time = agg_df["end_time"].max()
+    hmap_df = heatmap_handling.get_fast_heatmap_df(agg_df=agg_df, xbins=50,
+                                                   nprocs=nprocs,
+                                                   max_time=max_time)
+    assert hmap_df.shape == (nprocs, 50)
+    assert_allclose(hmap_df.values.sum(), agg_df["length"].sum())
+    assert_allclose(hmap_df.sum(axis=1).values,
+                    agg_df.groupby("rank")["length"].sum().reindex(
+                        range(nprocs), fill_value=0).values)
+
+    bucketed = heatmap_handling.get_fast_heatmap_df(agg_df=agg_df, xbins=50,
+                                                    nprocs=nprocs,
+                                                    max_time=max_time,
+                                                    ybins=2)
+    half = nprocs // 2
+    assert_allclose(bucketed.values, [hmap_df.values[:half].sum(axis=0),
+                                      hmap_df.values[half:].sum(axis=0)])
+
+    # the streamed variant bins chunks into the same grid
+    with darshan.DarshanReport(filepath, read_all=False) as report:
+        streamed = heatmap_handling.get_streamed_fast_heatmap_df(
+            report=report, mod=mod, xbins=50, nprocs=nprocs,
+            max_time=runtime, ops=["read", "write"], chunk=3)
+    expected = heatmap_handling.get_fast_heatmap_df(agg_df=agg_df, xbins=50,
+                                                    nprocs=nprocs,
+                                                    max_time=runtime)
+    assert_allclose(streamed.values, expected.values)
+
+
+def test_get_heatmap_grid_shape():
+    # the grid is limited by the pixels of the figure
+    assert heatmap_handling.get_heatmap_grid_shape(
+        nprocs=4, xbins=200, dpi=100) == (200, 4)
+    assert heatmap_handling.get_heatmap_grid_shape(
+        nprocs=100000, xbins=10000, dpi=100) == (390, 270)
@@ -222,3 +222,34 @@ def test_module_overview_table(log_path, mod_name, expected):
                                      "I/O performance estimate"]
 
                 assert_frame_equal(actual_df, expected_df)
+
+
+@pytest.mark.parametrize("log_name, mod_name", [
+    ("imbalanced-io.darshan", "POSIX"),
+    ("imbalanced-io.darshan", "STDIO"),
+    ("snyder_acme.exe_id1253318_9-27-24239-1515303144625770178_2.darshan", "MPI-IO"),
+])
+@pytest.mark.parametrize("nthreads", [2, 7])
+def test_accumulate_records_threads(log_name, mod_name, nthreads):
+    # sharding records across threads and merging the accumulators
+    # must produce the same derived metrics as a single accumulator
+    log_path = get_log_path(log_name)
+    with darshan.DarshanReport(log_path, read_all=True) as report:
+        rec_dict = report.records[mod_name].to_df()
+        nprocs = report.metadata['job']['nprocs']
+
+    expected = accumulate_records(rec_dict, mod_name, nprocs).derived_metrics
+    actual = accumulate_records(rec_dict, mod_name, nprocs,
+                                nthreads=nthreads).derived_metrics
+
+    assert actual.total_bytes == expected.total_bytes
+    assert actual.agg_time_by_slowest == pytest.approx(expected.agg_time_by_slowest)
+    assert actual.agg_perf_by_slowest == pytest.approx(expected.agg_perf_by_slowest)
+    for cat in range(len(expected.category_counters)):
+        actual_cat = actual.category_counters[cat]
+        expected_cat = expected.category_counters[cat]
+        assert actual_cat.count == expected_cat.count
+        assert actual_cat.total_read_volume_bytes == expected_cat.total_read_volume_bytes
+        assert actual_cat.total_write_volume_bytes == expected_cat.total_write_volume_bytes
+        assert actual_cat.max_offset_bytes == expected_cat.max_offset_bytes
+        assert actual_cat.nprocs == expected_cat.nprocs
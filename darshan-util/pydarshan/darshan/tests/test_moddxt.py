@@ -1,6 +1,8 @@
 import os
 
 import pytest
+import pandas as pd
+from pandas.testing import assert_frame_equal
 import darshan.backend.cffi_backend as backend
 from darshan.log_utils import get_log_path
 
@@ -16,20 +18,26 @@ from darshan.log_utils import get_log_path
                    'hostname': 'sn176.localdomain',
                    'write_count': 1,
                    'read_count': 0,
+                   'write_dropped': 0,
+                   'read_dropped': 0,
                    'write_segments': [{'offset': 0,
                                        'length': 40,
                                        'start_time': 0.10337884305045009,
-                                       'end_time': 0.10338771319948137}],
+                                       'end_time': 0.10338771319948137,
+                                       'thread_id': -1}],
                    'read_segments': []}),
     ('DXT_MPIIO', {'id': 9457796068806373448,
                    'rank': 0,
                    'hostname': 'sn176.localdomain',
                    'write_count': 1,
                    'read_count': 0,
+                   'write_dropped': 0,
+                   'read_dropped': 0,
                    'write_segments': [{'offset': 0, 
                                        'length': 4000,
                                        'start_time': 0.10368914622813463,
-                                       'end_time': 0.1053433942142874}], 
+                                       'end_time': 0.1053433942142874,
+                                       'thread_id': -1}], 
                    'read_segments': []})])
 def test_dxt_records(logfile, mod, expected_dict):
     # regression guard for DXT records values
@@ -37,3 +45,84 @@ def test_dxt_records(logfile, mod, expected_dict):
     log = backend.log_open(logfile)
     rec = backend.log_get_record(log, mod)
     assert rec == expected_dict
+
+
+@pytest.mark.parametrize("logfile, mod", [
+    ("sample-dxt-simple.darshan", "DXT_POSIX"),
+    ("sample-dxt-simple.darshan", "DXT_MPIIO"),
+    ("dxt.darshan", "DXT_POSIX"),
+    ])
+@pytest.mark.parametrize("reads, writes", [
+    (True, True),
+    (True, False),
+    (False, True),
+    ])
+def test_dxt_segments(logfile, mod, reads, writes):
+    # the segments of a whole module read into a single DataFrame
+    # should match those of the individual records
+    logfile = get_log_path(logfile)
+    log = backend.log_open(logfile)
+    rows = []
+    rec = backend.log_get_dxt_record(log, mod, dtype="pandas")
+    while rec is not None:
+        for op in ["write", "read"]:
+            if (op == "write" and not writes) or (op == "read" and not reads):
+                continue
+            seg_df = rec[op + "_segments"]
+            for seg in seg_df.itertuples(index=False):
+                rows.append((rec["id"], rec["rank"], rec["hostname"], op) + tuple(seg))
+        rec = backend.log_get_dxt_record(log, mod, dtype="pandas")
+    backend.log_close(log)
+
+    log = backend.log_open(logfile)
+    actual = backend.log_get_dxt_segments(log, mod, reads=reads, writes=writes)
+    backend.log_close(log)
+
+    assert list(actual.columns) == ["id", "rank", "hostname", "op", "offset",
+                                    "length", "start_time", "end_time",
+                                    "thread_id"]
+    assert len(actual) == len(rows)
+    actual_rows = [(row[0], row[1], row[2], row[3]) + tuple(row[4:])
+                   for row in actual.itertuples(index=False)]
+    assert actual_rows == rows
+
+
+@pytest.mark.parametrize("logfile, mod", [
+    ("sample-dxt-simple.darshan", "DXT_POSIX"),
+    ("dxt.darshan", "DXT_POSIX"),
+    ])
+@pytest.mark.parametrize("ranks, t0, t1", [
+    (None, 0.0, None),
+    ([0], 0.0, None),
+    ([1, 2, 3, 5], 0.0, None),
+    ([], 0.0, None),
+    (None, 0.1, None),
+    (None, 0.0, 0.5),
+    ])
+def test_dxt_iter_segments(logfile, mod, ranks, t0, t1):
+    # streaming the segments in chunks should match reading all of them
+    # and then filtering them by rank and time window
+    logfile = get_log_path(logfile)
+    log = backend.log_open(logfile)
+    expected = backend.log_get_dxt_segments(log, mod)
+    backend.log_close(log)
+    mask = expected["end_time"] >= t0
+    if t1 is not None:
+        mask &= expected["start_time"] <= t1
+    if ranks is not None:
+        mask &= expected["rank"].isin(ranks)
+    expected = expected[mask].reset_index(drop=True)
+
+    log = backend.log_open(logfile)
+    chunks = list(backend.log_iter_dxt_segments(log, mod, ranks=ranks,
+                                                t0=t0, t1=t1, chunk=5))
+    backend.log_close(log)
+
+    # chunks hold whole records, so all but the last reach the chunk size
+    assert all(len(chunk) >= 5 for chunk in chunks[:-1])
+    actual = pd.concat(chunks, ignore_index=True)
+    # the categories of each chunk only hold the hostnames it has seen
+    for df in [actual, expected]:
+        df["hostname"] = df["hostname"].astype(str)
+        df["op"] = df["op"].astype(str)
+    assert_frame_equal(actual, expected)
@@ -5,6 +5,7 @@ from pandas.testing import assert_frame_equal
 
 import darshan
 from darshan.experimental.plots import plot_common_access_table
+import darshan.backend.cffi_backend as backend
 from darshan.log_utils import get_log_path
 
 
@@ -234,3 +235,24 @@ def test_collapse_access_cols(input_df, col_name, expected_df):
 def test_get_access_count_df(mod_df, mod, expected_df):
     actual_df = plot_common_access_table.get_access_count_df(mod_df=mod_df, mod=mod)
     assert_frame_equal(actual_df, expected_df)
+
+
+@pytest.mark.parametrize("filename", [
+    "ior_hdf5_example.darshan",
+    "imbalanced-io.darshan",
+    "shane_macsio_id29959_5-22-32552-7035573431850780836_1590156158.darshan",
+])
+@pytest.mark.parametrize("mod", ["POSIX", "MPI-IO"])
+def test_common_access_table_summarized(filename, mod):
+    # the access size histogram accumulated by darshan-util must give
+    # the same table as the one computed from the record dataframes
+    log_path = get_log_path(filename=filename)
+    with darshan.DarshanReport(log_path) as report:
+        if mod not in report.modules:
+            pytest.skip(f"no {mod} data")
+        summary = backend.summarize_records({mod: report.records[mod].to_df()},
+                                            report.metadata['job']['nprocs'])
+        expected_df = plot_common_access_table.plot_common_access_table(report=report, mod=mod).df
+        actual_df = plot_common_access_table.plot_common_access_table(
+            report=report, mod=mod, access_sizes=summary.access_sizes[mod]).df
+    assert_frame_equal(actual_df, expected_df)
@@ -3,15 +3,17 @@
 
 """Tests for `pydarshan` package."""
 
+import os
 import re
 import copy
+import shutil
 import pickle
 import string
 import random
 
 import pytest
 import numpy as np
-from numpy.testing import assert_allclose, assert_array_less
+from numpy.testing import assert_allclose, assert_array_less, assert_array_equal
 import pandas as pd
 from pandas.testing import assert_frame_equal
 
@@ -434,6 +436,38 @@ def test_runtime_heatmap_retrieval(capsys, logname, hmap_types, nbins, bin_width
                 assert element in captured.out
 
 
+@pytest.mark.parametrize("logname", [
+    "runtime_and_dxt_heatmaps_diagonal_write_only.darshan",
+    "e3sm_io_heatmap_only.darshan",
+    ])
+def test_heatmap_arrays(logname):
+    # heatmap records read in bulk should match those read one at a time
+    log_path = get_log_path(logname)
+    log = backend.log_open(log_path)
+    recs = []
+    rec = backend._log_get_heatmap_record(log)
+    while rec is not None:
+        recs.append(rec)
+        rec = backend._log_get_heatmap_record(log)
+    backend.log_close(log)
+
+    log = backend.log_open(log_path)
+    # a small batch size exercises reading in several batches
+    arr = backend.log_get_heatmap_arrays(log, batch_size=7)
+    backend.log_close(log)
+
+    assert len(arr['id']) == len(recs)
+    for i, rec in enumerate(recs):
+        assert arr['id'][i] == rec['id']
+        assert arr['rank'][i] == rec['rank']
+        assert arr['bin_width_seconds'][i] == rec['bin_width_seconds']
+        assert arr['nbins'][i] == rec['nbins']
+        for key in ['write_bins', 'read_bins', 'write_op_bins', 'read_op_bins', 'meta_op_bins']:
+            expected = rec.get(key, np.zeros(rec['nbins'], dtype=np.int64))
+            assert_array_equal(arr[key][i, :rec['nbins']], expected)
+            assert not arr[key][i, rec['nbins']:].any()
+
+
 def test_runtime_dxt_heatmap_similarity():
     # this log file should have a similar "diagonal"
     # data structure in both DXT and runtime HEATMAP forms;
@@ -585,3 +619,270 @@ def test_pnetcdf_hdf5_match():
     # PNETCDF_FILE captures some extra file-format related IO
     # activity vs. the user-level "dataset" IO proper:
     assert pnetcdf_file_data_dict["counters"]["PNETCDF_FILE_BYTES_READ"].values > pnetcdf_var_data_dict["counters"]["PNETCDF_VAR_BYTES_READ"].values
+
+
+def test_lazy_records():
+    # lazy reports only read the records of a module on first access
+    log_path = get_log_path("sample-dxt-simple.darshan")
+    with darshan.DarshanReport(log_path, read_all=True) as report:
+        expected_posix = report.records["POSIX"].to_numpy()
+        expected_dxt = report.records["DXT_POSIX"].to_numpy()
+
+    with darshan.DarshanReport(log_path, lazy=True) as report:
+        assert len(report.records) == 0
+        assert "POSIX" not in report.records
+        actual_posix = report.records["POSIX"].to_numpy()
+        assert list(report.records.keys()) == ["POSIX"]
+        actual_dxt = report.records["DXT_POSIX"].to_numpy()
+        assert report.modules["POSIX"]["num_records"] == len(expected_posix)
+        with pytest.raises(KeyError):
+            report.records["LUSTRE"]
+
+    assert len(actual_posix) == len(expected_posix)
+    for actual, expected in zip(actual_posix, expected_posix):
+        assert actual["id"] == expected["id"]
+        assert_allclose(actual["counters"], expected["counters"])
+        assert_allclose(actual["fcounters"], expected["fcounters"])
+    assert actual_dxt == expected_dxt
+
+
+def test_lazy_records_memory_budget():
+    # with a small memory budget, only the most recently used
+    # module is kept, and evicted modules are read again
+    log_path = get_log_path("sample-dxt-simple.darshan")
+    with darshan.DarshanReport(log_path, lazy=True, max_memory=1) as report:
+        n_posix = len(report.records["POSIX"])
+        assert list(report.records.keys()) == ["POSIX"]
+        report.records["MPI-IO"]
+        assert list(report.records.keys()) == ["MPI-IO"]
+        assert len(report.records["POSIX"]) == n_posix
+        assert list(report.records.keys()) == ["POSIX"]
+
+    # a large budget keeps everything
+    with darshan.DarshanReport(log_path, lazy=True, max_memory=1 << 30) as report:
+        report.records["POSIX"]
+        report.records["MPI-IO"]
+        assert sorted(report.records.keys()) == ["MPI-IO", "POSIX"]
+
+
+@pytest.mark.parametrize("dtype", ["numpy", "pandas"])
+@pytest.mark.parametrize("mod", ["POSIX", "STDIO"])
+def test_iter_records(dtype, mod):
+    # iterating over a module in chunks should visit
+    # the same records as reading it at once
+    log_path = get_log_path("sample.darshan")
+    with darshan.DarshanReport(log_path, read_all=False) as report:
+        report.mod_read_all_records(mod, dtype="numpy")
+        expected = report.records[mod].to_numpy()
+        chunks = list(report.iter_records(mod, chunk_size=2, dtype=dtype))
+
+    if dtype == "pandas":
+        assert all(len(chunk["counters"]) <= 2 for chunk in chunks)
+        counters = pd.concat([chunk["counters"] for chunk in chunks])
+        assert_array_equal(counters["id"].values, [rec["id"] for rec in expected])
+        assert_array_equal(counters.iloc[:, 2:].values,
+                           np.stack([rec["counters"] for rec in expected]))
+    else:
+        assert all(len(chunk) <= 2 for chunk in chunks)
+        actual = [rec for chunk in chunks for rec in chunk]
+        assert [rec["id"] for rec in actual] == [rec["id"] for rec in expected]
+        for act, exp in zip(actual, expected):
+            assert_array_equal(act["counters"], exp["counters"])
+
+
+@pytest.mark.parametrize("logname, mod", [
+    ("ior_hdf5_example.darshan", "POSIX"),
+    ("ior_hdf5_example.darshan", "MPI-IO"),
+    ("ior_hdf5_example.darshan", "H5D"),
+    ("sample.darshan", "STDIO"),
+])
+def test_agg_generic_record_arrays(logname, mod):
+    # aggregating all records in darshan-util should match the
+    # summary record emitted by the accumulator
+    log = backend.log_open(get_log_path(logname))
+    arr = backend.log_get_generic_record_arrays(log, mod)
+    backend.log_close(log)
+
+    actual = backend.agg_generic_record_arrays(arr, mod, by_id=False)
+    assert len(actual["id"]) == 1
+
+    if mod != "H5D":
+        with darshan.DarshanReport(get_log_path(logname)) as report:
+            nprocs = report.metadata["job"]["nprocs"]
+            rec_dict = report.records[mod].to_df()
+        acc = backend.accumulate_records(rec_dict, mod, nprocs)
+        expected = acc.summary_record
+        assert_array_equal(actual["counters"][0],
+                           expected["counters"].iloc[0, 2:].to_numpy())
+        assert_allclose(actual["fcounters"][0],
+                        expected["fcounters"].iloc[0, 2:].to_numpy())
+
+    # aggregating each record id separately leaves single records untouched
+    by_id = backend.agg_generic_record_arrays(arr, mod)
+    ids, counts = np.unique(arr["id"], return_counts=True)
+    assert_array_equal(by_id["id"], ids)
+    for i, rec_id in enumerate(ids):
+        if counts[i] == 1:
+            j = np.flatnonzero(arr["id"] == rec_id)[0]
+            assert by_id["rank"][i] == arr["rank"][j]
+            assert_array_equal(by_id["counters"][i], arr["counters"][j])
+
+
+@pytest.mark.parametrize("operation", ["sum", "agg"])
+def test_reduce(operation):
+    # the vectorized reduction matches summing each name record's
+    # records, and leaves the source report untouched
+    darshan.enable_experimental()
+    logname = get_log_path("ior_hdf5_example.darshan")
+    with darshan.DarshanReport(logname) as report:
+        expected = {}
+        for rec in report.records["POSIX"].to_numpy():
+            if rec["id"] in expected:
+                expected[rec["id"]] += rec["counters"]
+            else:
+                expected[rec["id"]] = rec["counters"].copy()
+        num_recs = len(report.records["POSIX"])
+
+        reduced = report.reduce(operation=operation, mods=["POSIX"],
+                                name_records="distinct")
+        assert len(report.records["POSIX"]) == num_recs
+        assert list(reduced.records.keys()) == ["POSIX"]
+        actual = {rec["id"]: rec["counters"]
+                  for rec in reduced.records["POSIX"].to_numpy()}
+        assert sorted(actual) == sorted(expected)
+        if operation == "sum":
+            for rec_id, counters in expected.items():
+                assert_array_equal(actual[rec_id], counters)
+
+        total = report.reduce(operation=operation, mods=["POSIX"])
+        assert len(total.records["POSIX"]) == 1
+        assert total.records["POSIX"][0]["id"] == "*"
+
+
+def test_agg_latency():
+    # percentile bounds come from the bucket holding the requested rank,
+    # and logs without LATENCY data have nothing to aggregate
+    from darshan.experimental.aggregators.agg_latency import latency_percentile
+    hist = [0] * 32
+    hist[3] = 90
+    hist[10] = 9
+    hist[20] = 1
+    assert latency_percentile(hist, 50) == 8e-6
+    assert latency_percentile(hist, 99) == 1024e-6
+    assert latency_percentile(hist, 100) == 2 ** 20 / 1e6
+    assert latency_percentile([0] * 32, 50) is None
+
+    darshan.enable_experimental()
+    with darshan.DarshanReport(get_log_path("sample.darshan")) as report:
+        assert report.agg_latency(mode='return') == {}
+
+
+def test_agg_timeseries():
+    # rebinning folds adjacent bins while keeping the series length, and
+    # logs without TIMESERIES data have nothing to aggregate
+    from darshan.experimental.aggregators.agg_timeseries import timeseries_rebin
+    series = [1, 2, 3, 4, 5, 6, 7, 8]
+    assert timeseries_rebin(series, 1) == series
+    assert timeseries_rebin(series, 2) == [3, 7, 11, 15, 0, 0, 0, 0]
+    assert timeseries_rebin(series, 4) == [10, 26, 0, 0, 0, 0, 0, 0]
+
+    darshan.enable_experimental()
+    with darshan.DarshanReport(get_log_path("sample.darshan")) as report:
+        assert report.agg_timeseries(mode='return') == {}
+
+
+def test_merge():
+    # merging several reports at once concatenates their records
+    darshan.enable_experimental()
+    lognames = ["ior_hdf5_example.darshan", "sample.darshan", "sample-dxt-simple.darshan"]
+    reports = [darshan.DarshanReport(get_log_path(logname)) for logname in lognames]
+
+    merged = reports[0].merge(*reports[1:])
+    for mod in ["POSIX", "MPI-IO", "STDIO"]:
+        expected = sum(len(report.records[mod]) for report in reports
+                       if mod in report.records)
+        assert len(merged.records[mod]) == expected
+    assert merged.start_time == min(report.start_time for report in reports)
+    assert merged.end_time == max(report.end_time for report in reports)
+
+    # the addition operator is a pairwise merge
+    pairwise = reports[0] + reports[1] + reports[2]
+    assert len(pairwise.records["POSIX"]) == len(merged.records["POSIX"])
+
+    # reducing first keeps one record per name record and report
+    reduced = reports[0].merge(*reports[1:], reduce_first=True)
+    expected = sum(len(set(rec["id"] for rec in report.records["POSIX"].to_numpy()))
+                   for report in reports if "POSIX" in report.records)
+    assert len(reduced.records["POSIX"]) == expected
+
+
+def _record_frames(report, mod, dtype):
+    if dtype == "pandas":
+        rec = report.records[mod][0]
+        return {key: rec[key] for key in ["counters", "fcounters"]}
+    return report.records[mod].to_df()
+
+
+@pytest.mark.parametrize("dtype", ["numpy", "pandas"])
+def test_cache(tmpdir, dtype):
+    # reports opened through the on-disk cache match uncached reports,
+    # on the first (cache filling) and later (cache reading) opens
+    logname = get_log_path("ior_hdf5_example.darshan")
+    cache_dir = str(tmpdir)
+    with darshan.DarshanReport(logname, dtype=dtype) as report:
+        expected = {mod: _record_frames(report, mod, dtype) for mod in report.records
+                    if mod in backend._batch_mods}
+        expected_names = dict(report.name_records)
+
+    for i in range(2):
+        with darshan.DarshanReport(logname, dtype=dtype, cache=cache_dir) as report:
+            assert report.name_records == expected_names
+            assert sorted(mod for mod in report.records
+                          if mod in backend._batch_mods) == sorted(expected)
+            for mod, expected_dfs in expected.items():
+                actual_dfs = _record_frames(report, mod, dtype)
+                for key in ["counters", "fcounters"]:
+                    assert_frame_equal(actual_dfs[key], expected_dfs[key],
+                                       check_dtype=False)
+            entry = report._cache.path
+        for mod in expected:
+            assert os.path.isdir(os.path.join(entry, mod))
+        assert os.path.exists(os.path.join(entry, "name_records.json"))
+
+    # the cached records can be modified without affecting the cache
+    with darshan.DarshanReport(logname, dtype="numpy", cache=cache_dir) as report:
+        report.records["POSIX"][0]["counters"][0] = -42
+    with darshan.DarshanReport(logname, dtype="numpy", cache=cache_dir) as report:
+        assert report.records["POSIX"][0]["counters"][0] != -42
+
+
+def test_cache_invalidation(tmpdir):
+    # a modified log does not reuse the cache entry of its previous content
+    log_path = os.path.join(str(tmpdir), "log.darshan")
+    cache_dir = os.path.join(str(tmpdir), "cache")
+    shutil.copy(get_log_path("sample.darshan"), log_path)
+    with darshan.DarshanReport(log_path, cache=cache_dir) as report:
+        num_posix = len(report.records["POSIX"])
+
+    shutil.copy(get_log_path("ior_hdf5_example.darshan"), log_path)
+    with darshan.DarshanReport(log_path) as report:
+        expected = len(report.records["POSIX"])
+    with darshan.DarshanReport(log_path, cache=cache_dir) as report:
+        assert len(report.records["POSIX"]) == expected
+        assert "H5D" in report.records
+    assert expected != num_posix
+
+
+@pytest.mark.skipif(not pytest.has_log_repo,
+                    reason="missing darshan_logs")
+def test_cache_heatmaps(tmpdir):
+    logname = get_log_path("e3sm_io_heatmap_only.darshan")
+    with darshan.DarshanReport(logname) as report:
+        expected = {mod: report.heatmaps[mod].to_df(ops=["read", "write"])
+                    for mod in report.heatmaps}
+    for i in range(2):
+        with darshan.DarshanReport(logname, cache=str(tmpdir)) as report:
+            assert sorted(report.heatmaps) == sorted(expected)
+            for mod, expected_df in expected.items():
+                assert_frame_equal(report.heatmaps[mod].to_df(ops=["read", "write"]),
+                                   expected_df)
@@ -1,6 +1,7 @@
 import io
 import re
 import os
+import shutil
 import pytest
 import argparse
 from unittest import mock
@@ -592,6 +593,11 @@ class TestReportData:
             actual_runtime = summary.ReportData.get_runtime(report=report)
         assert actual_runtime == expected_runtime
 
+    def test_get_overhead_without_module(self):
+        # logs written before the OVERHEAD module have no overhead estimate
+        with darshan.DarshanReport(get_log_path("sample.darshan")) as report:
+            assert summary.ReportData.get_overhead(report=report) is None
+
 
 class TestReportFigure:
 
@@ -625,3 +631,74 @@ def test_issue_717():
             fig_args=dict(report=report),
         )
     assert not "alt= width" in fig.fig_html
+
+
+@pytest.mark.parametrize("jobs", [1, 2])
+@pytest.mark.parametrize("use_dir", [False, True])
+def test_main_batch(tmpdir, jobs, use_dir):
+    # several logs, or a directory of logs, are summarized
+    # in batch mode, with one report per log
+    lognames = ["sample.darshan", "sample-dxt-simple.darshan"]
+    log_paths = [get_log_path(logname) for logname in lognames]
+    if use_dir:
+        log_dir = os.path.join(str(tmpdir), "logs")
+        os.mkdir(log_dir)
+        for log_path in log_paths:
+            shutil.copy(log_path, log_dir)
+        argv = [log_dir]
+    else:
+        argv = log_paths
+    out_dir = os.path.join(str(tmpdir), "reports")
+    argv = argv + [f"--output-dir={out_dir}", f"--jobs={jobs}", "--timings"]
+
+    with mock.patch("sys.argv", [""] + argv):
+        summary.main()
+
+    for logname, log_path in zip(lognames, log_paths):
+        report_path = os.path.join(out_dir, summary.get_report_filename(logname))
+        with open(report_path) as html_report:
+            batch_str = html_report.read()
+        # the batch reports match the single log reports
+        single_path = os.path.join(str(tmpdir), logname + ".html")
+        summary.generate_report(log_path, single_path)
+        with open(single_path) as html_report:
+            single_str = html_report.read()
+        assert batch_str.count("<img") == single_str.count("<img")
+        assert batch_str.count("<table") == single_str.count("<table")
+
+
+def test_main_batch_output_conflict():
+    # a single output file cannot hold several reports
+    argv = [get_log_path("sample.darshan"),
+            get_log_path("sample-dxt-simple.darshan"),
+            "--output=test.html"]
+    with mock.patch("sys.argv", [""] + argv):
+        with pytest.raises(ValueError, match="--output-dir"):
+            summary.main()
+
+
+def test_report_timings():
+    # every rendered figure is timed, next to the overall stages
+    R = summary.ReportData(log_path=get_log_path("sample.darshan"))
+    stages = list(R.timings)
+    assert stages[:3] == ["read log", "tables", "figures"]
+    fig_stages = [stage for stage in stages if stage.startswith("figure: ")]
+    assert len(fig_stages) > 0
+    assert "figure: I/O Cost" in fig_stages
+    assert "figure: Access Sizes (POSIX)" in fig_stages
+    assert all(elapsed >= 0 for elapsed in R.timings.values())
+    assert R.timings["figures"] >= max(R.timings[stage] for stage in fig_stages)
+
+
+def test_cached_record_frames():
+    # the cached frames are decoded once but handed out as copies
+    R = summary.ReportData(log_path=get_log_path("sample.darshan"))
+    first = R.report.records["POSIX"].to_df(attach=None)
+    first["counters"].iloc[0, 0] = -42
+    second = R.report.records["POSIX"].to_df(attach=None)
+    assert second["counters"].iloc[0, 0] != -42
+    with darshan.DarshanReport(get_log_path("sample.darshan")) as report:
+        expected = report.records["POSIX"].to_df()
+    actual = R.report.records["POSIX"].to_df()
+    for ct_key in ["counters", "fcounters"]:
+        assert_frame_equal(actual[ct_key], expected[ct_key])
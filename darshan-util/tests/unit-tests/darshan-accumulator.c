@@ -11,6 +11,11 @@
 
 static MunitResult inject_shared_file_records(const MunitParameter params[], void* data);
 static MunitResult inject_unique_file_records(const MunitParameter params[], void* data);
+static MunitResult merge_shared_file_records(const MunitParameter params[], void* data);
+static MunitResult merge_unique_file_records(const MunitParameter params[], void* data);
+static MunitResult agg_records_batch(const MunitParameter params[], void* data);
+static MunitResult emit_access_sizes(const MunitParameter params[], void* data);
+static MunitResult emit_categories(const MunitParameter params[], void* data);
 static void* test_context_setup(const MunitParameter params[], void* user_data);
 static void test_context_tear_down(void *data);
 
@@ -35,6 +40,21 @@ static MunitTest tests[]
        {"/inject-unique-file-records", inject_unique_file_records,
         test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE,
         test_params},
+       {"/merge-shared-file-records", merge_shared_file_records,
+        test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE,
+        test_params},
+       {"/merge-unique-file-records", merge_unique_file_records,
+        test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE,
+        test_params},
+       {"/agg-records-batch", agg_records_batch,
+        test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE,
+        test_params},
+       {"/emit-access-sizes", emit_access_sizes,
+        test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE,
+        test_params},
+       {"/emit-categories", emit_categories,
+        test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE,
+        test_params},
        {NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
 
 static const MunitSuite test_suite = {
@@ -59,7 +79,17 @@ void (*set_dummy_fn[DARSHAN_KNOWN_MODULE_COUNT])(void*) = {
     NULL, /* DARSHAN_MDHIM_MOD */
     NULL, /* DARSHAN_APXC_MOD */
     NULL, /* DARSHAN_APMPI_MOD */
-    NULL /* DARSHAN_HEATMAP_MOD */
+    NULL, /* DARSHAN_HEATMAP_MOD */
+    NULL, /* DXT_STDIO_MOD */
+    NULL, /* DARSHAN_BATCHIO_MOD */
+    NULL, /* DARSHAN_OVERHEAD_MOD */
+    NULL, /* DARSHAN_LATENCY_MOD */
+    NULL, /* DARSHAN_TIMESERIES_MOD */
+    NULL, /* DARSHAN_CUFILE_MOD */
+    NULL, /* DARSHAN_MMAP_MOD */
+    NULL, /* DARSHAN_ROLLUP_MOD */
+    NULL, /* DARSHAN_PHASE_MOD */
+    NULL /* DARSHAN_ATTRIB_MOD */
 };
 
 void (*validate_double_dummy_fn[DARSHAN_KNOWN_MODULE_COUNT])(void*, struct darshan_derived_metrics*, int) = {
@@ -78,7 +108,17 @@ void (*validate_double_dummy_fn[DARSHAN_KNOWN_MODULE_COUNT])(void*, struct darsh
     NULL, /* DARSHAN_MDHIM_MOD */
     NULL, /* DARSHAN_APXC_MOD */
     NULL, /* DARSHAN_APMPI_MOD */
-    NULL /* DARSHAN_HEATMAP_MOD */
+    NULL, /* DARSHAN_HEATMAP_MOD */
+    NULL, /* DXT_STDIO_MOD */
+    NULL, /* DARSHAN_BATCHIO_MOD */
+    NULL, /* DARSHAN_OVERHEAD_MOD */
+    NULL, /* DARSHAN_LATENCY_MOD */
+    NULL, /* DARSHAN_TIMESERIES_MOD */
+    NULL, /* DARSHAN_CUFILE_MOD */
+    NULL, /* DARSHAN_MMAP_MOD */
+    NULL, /* DARSHAN_ROLLUP_MOD */
+    NULL, /* DARSHAN_PHASE_MOD */
+    NULL /* DARSHAN_ATTRIB_MOD */
 };
 
 struct test_context {
@@ -237,6 +277,249 @@ static MunitResult inject_unique_file_records(const MunitParameter params[], voi
     return MUNIT_OK;
 }
 
+/* inject each of two example records into its own accumulator, then merge
+ * the accumulators; the result must match injecting both into one
+ */
+static MunitResult merge_file_records(struct test_context* ctx, int shared_file_flag)
+{
+    int ret;
+    darshan_accumulator acc1;
+    darshan_accumulator acc2;
+    struct darshan_derived_metrics metrics;
+    void* record1;
+    void* record2;
+    void* record_agg;
+    struct darshan_base_record* base_rec;
+
+    record1 = malloc(DEF_MOD_BUF_SIZE);
+    munit_assert_not_null(record1);
+    record2 = malloc(DEF_MOD_BUF_SIZE);
+    munit_assert_not_null(record2);
+    record_agg = malloc(DEF_MOD_BUF_SIZE);
+    munit_assert_not_null(record_agg);
+
+    /* make sure we have a function defined to set example records */
+    munit_assert_not_null(set_dummy_fn[ctx->mod_id]);
+
+    /* create example records from different ranks */
+    set_dummy_fn[ctx->mod_id](record1);
+    set_dummy_fn[ctx->mod_id](record2);
+    base_rec = record2;
+    base_rec->rank++;
+    if(!shared_file_flag)
+        base_rec->id++;
+
+    ret = darshan_accumulator_create(ctx->mod_id, 4, &acc1);
+    munit_assert_int(ret, ==, 0);
+    ret = darshan_accumulator_create(ctx->mod_id, 4, &acc2);
+    munit_assert_int(ret, ==, 0);
+
+    ret = darshan_accumulator_inject(acc1, record1, 1);
+    munit_assert_int(ret, ==, 0);
+    ret = darshan_accumulator_inject(acc2, record2, 1);
+    munit_assert_int(ret, ==, 0);
+
+    /* merge and emit results */
+    ret = darshan_accumulator_merge(acc1, acc2);
+    munit_assert_int(ret, ==, 0);
+    ret = darshan_accumulator_emit(acc1, &metrics, record_agg);
+    munit_assert_int(ret, ==, 0);
+
+    /* sanity check */
+    validate_double_dummy_fn[ctx->mod_id](record_agg, &metrics, shared_file_flag);
+
+    ret = darshan_accumulator_destroy(acc1);
+    munit_assert_int(ret, ==, 0);
+    ret = darshan_accumulator_destroy(acc2);
+    munit_assert_int(ret, ==, 0);
+
+    free(record1);
+    free(record2);
+    free(record_agg);
+
+    return MUNIT_OK;
+}
+
+/* test merging accumulators holding records of a shared file */
+static MunitResult merge_shared_file_records(const MunitParameter params[], void* data)
+{
+    return merge_file_records((struct test_context*)data, 1);
+}
+
+/* test merging accumulators holding records of unique files */
+static MunitResult merge_unique_file_records(const MunitParameter params[], void* data)
+{
+    return merge_file_records((struct test_context*)data, 0);
+}
+
+/* test that aggregating an array of records in one batch gives the same
+ * aggregate record as aggregating them one at a time
+ */
+static MunitResult agg_records_batch(const MunitParameter params[], void* data)
+{
+    struct test_context* ctx = (struct test_context*)data;
+    struct darshan_base_record* base_rec;
+    char* records;
+    void* record_agg1;
+    void* record_agg2;
+    int rec_size;
+    int i;
+
+    munit_assert_not_null(set_dummy_fn[ctx->mod_id]);
+    munit_assert_not_null(ctx->mod_fns->log_agg_records_batch);
+
+    record_agg1 = calloc(1, DEF_MOD_BUF_SIZE);
+    munit_assert_not_null(record_agg1);
+    record_agg2 = calloc(1, DEF_MOD_BUF_SIZE);
+    munit_assert_not_null(record_agg2);
+    set_dummy_fn[ctx->mod_id](record_agg1);
+    rec_size = ctx->mod_fns->log_sizeof_record(record_agg1);
+    memset(record_agg1, 0, rec_size);
+    records = malloc(4 * rec_size);
+    munit_assert_not_null(records);
+
+    /* records of one file from two ranks, then of another file */
+    for(i = 0; i < 4; i++) {
+        set_dummy_fn[ctx->mod_id](records + i * rec_size);
+        base_rec = (struct darshan_base_record*)(records + i * rec_size);
+        base_rec->rank = i;
+        if(i > 1)
+            base_rec->id++;
+    }
+
+    for(i = 0; i < 4; i++)
+        ctx->mod_fns->log_agg_records(records + i * rec_size, record_agg1, i == 0);
+    ctx->mod_fns->log_agg_records_batch(records, 4, record_agg2, 1);
+
+    munit_assert_memory_equal(rec_size, record_agg1, record_agg2);
+
+    free(records);
+    free(record_agg1);
+    free(record_agg2);
+
+    return MUNIT_OK;
+}
+
+/* test the histogram of common access sizes across records and merged
+ * accumulators
+ */
+static MunitResult emit_access_sizes(const MunitParameter params[], void* data)
+{
+    struct test_context* ctx = (struct test_context*)data;
+    struct darshan_access_size sizes[4];
+    darshan_accumulator acc1, acc2;
+    void* record;
+    int ret;
+
+    record = calloc(1, DEF_MOD_BUF_SIZE);
+    munit_assert_not_null(record);
+    munit_assert_not_null(set_dummy_fn[ctx->mod_id]);
+    set_dummy_fn[ctx->mod_id](record);
+
+    ret = darshan_accumulator_create(ctx->mod_id, 4, &acc1);
+    munit_assert_int(ret, ==, 0);
+    ret = darshan_accumulator_create(ctx->mod_id, 4, &acc2);
+    munit_assert_int(ret, ==, 0);
+    ret = darshan_accumulator_inject(acc1, record, 1);
+    munit_assert_int(ret, ==, 0);
+    ret = darshan_accumulator_inject(acc2, record, 1);
+    munit_assert_int(ret, ==, 0);
+    ret = darshan_accumulator_merge(acc1, acc2);
+    munit_assert_int(ret, ==, 0);
+
+    ret = darshan_accumulator_emit_access_sizes(acc1, sizes, 4);
+    if(ctx->mod_id == DARSHAN_STDIO_MOD) {
+        /* STDIO does not record common access sizes */
+        munit_assert_int(ret, ==, -1);
+    }
+    else {
+        /* the example records have one common access size */
+        munit_assert_int(ret, ==, 1);
+        munit_assert_int64(sizes[0].size, ==, 16777216);
+        munit_assert_int64(sizes[0].count, ==, 16);
+        /* the count does not depend on the space provided */
+        ret = darshan_accumulator_emit_access_sizes(acc1, sizes, 0);
+        munit_assert_int(ret, ==, 1);
+    }
+
+    darshan_accumulator_destroy(acc1);
+    darshan_accumulator_destroy(acc2);
+    free(record);
+
+    return MUNIT_OK;
+}
+
+/* test summing the data accessed by category, with a file seen by two
+ * accumulators counted once
+ */
+static MunitResult emit_categories(const MunitParameter params[], void* data)
+{
+    struct test_context* ctx = (struct test_context*)data;
+    struct darshan_category_io cat_io[2];
+    struct darshan_base_record* base_rec;
+    darshan_accumulator accs[2];
+    darshan_record_id ids[3];
+    int categories[3] = {0, 1, 1};
+    darshan_record_id rec_id;
+    int64_t r_bytes, w_bytes, max_offset, rank, nprocs;
+    double io_total_time, md_only_time, rw_only_time;
+    void* record;
+    int ret;
+
+    record = calloc(1, DEF_MOD_BUF_SIZE);
+    munit_assert_not_null(record);
+    munit_assert_not_null(set_dummy_fn[ctx->mod_id]);
+    set_dummy_fn[ctx->mod_id](record);
+    base_rec = record;
+    ret = ctx->mod_fns->log_record_metrics(record, &rec_id, &r_bytes,
+        &w_bytes, &max_offset, &io_total_time, &md_only_time,
+        &rw_only_time, &rank, &nprocs);
+    munit_assert_int(ret, ==, 0);
+
+    ret = darshan_accumulator_create(ctx->mod_id, 4, &accs[0]);
+    munit_assert_int(ret, ==, 0);
+    ret = darshan_accumulator_create(ctx->mod_id, 4, &accs[1]);
+    munit_assert_int(ret, ==, 0);
+
+    /* file 0 in category 0; file 1 in category 1, seen by both
+     * accumulators; file 2 in category 1, but never accessed
+     */
+    ids[0] = base_rec->id;
+    ret = darshan_accumulator_inject(accs[0], record, 1);
+    munit_assert_int(ret, ==, 0);
+    base_rec->id++;
+    ids[1] = base_rec->id;
+    ret = darshan_accumulator_inject(accs[0], record, 1);
+    munit_assert_int(ret, ==, 0);
+    ret = darshan_accumulator_inject(accs[1], record, 1);
+    munit_assert_int(ret, ==, 0);
+    ids[2] = base_rec->id + 1;
+
+    ret = darshan_accumulator_emit_categories(accs, 2, ids, categories, 3,
+        cat_io, 2);
+    munit_assert_int(ret, ==, 0);
+
+    munit_assert_int64(cat_io[0].bytes_read, ==, r_bytes);
+    munit_assert_int64(cat_io[0].bytes_written, ==, w_bytes);
+    munit_assert_int64(cat_io[0].files_read, ==, r_bytes > 0);
+    munit_assert_int64(cat_io[0].files_written, ==, w_bytes > 0);
+    munit_assert_int64(cat_io[1].bytes_read, ==, 2 * r_bytes);
+    munit_assert_int64(cat_io[1].bytes_written, ==, 2 * w_bytes);
+    munit_assert_int64(cat_io[1].files_read, ==, r_bytes > 0);
+    munit_assert_int64(cat_io[1].files_written, ==, w_bytes > 0);
+
+    /* categories must be in range */
+    categories[2] = 2;
+    ret = darshan_accumulator_emit_categories(accs, 2, ids, categories, 3,
+        cat_io, 2);
+    munit_assert_int(ret, ==, -1);
+
+    darshan_accumulator_destroy(accs[0]);
+    darshan_accumulator_destroy(accs[1]);
+    free(record);
+
+    return MUNIT_OK;
+}
 
 int main(int argc, char **argv)
 {
@@ -422,7 +705,7 @@ static void mpiio_set_dummy_record(void* buffer)
     /* This function must be updated (or at least checked) if the mpiio
      * module log format changes
      */
-    munit_assert_int(DARSHAN_MPIIO_VER, ==, 3);
+    munit_assert_int(DARSHAN_MPIIO_VER, ==, 4);
 
     mfile->base_rec.id = 15574190512568163195UL;
     mfile->base_rec.rank = 0;
@@ -512,6 +795,11 @@ static void mpiio_set_dummy_record(void* buffer)
     mfile->fcounters[MPIIO_F_VARIANCE_RANK_TIME] = 0;
     mfile->fcounters[MPIIO_F_VARIANCE_RANK_BYTES] = 0;
 #endif
+    mfile->fcounters[MPIIO_F_COLL_WAIT_TIME] = 0.004410;
+    mfile->fcounters[MPIIO_F_COLL_IO_TIME] = 0.011362;
+    mfile->fcounters[MPIIO_F_NB_READ_TIME] = 0;
+    mfile->fcounters[MPIIO_F_NB_WRITE_TIME] = 0.027511;
+    mfile->fcounters[MPIIO_F_NB_WAIT_TIME] = 0.006203;
 
     return;
 }
@@ -656,7 +944,7 @@ static void mpiio_validate_double_dummy_record(void* buffer, struct darshan_deri
     /* This function must be updated (or at least checked) if the mpiio
      * module log format changes
      */
-    munit_assert_int(DARSHAN_MPIIO_VER, ==, 3);
+    munit_assert_int(DARSHAN_MPIIO_VER, ==, 4);
 
     /* check base record */
     if(shared_file_flag)
@@ -683,6 +971,10 @@ static void mpiio_validate_double_dummy_record(void* buffer, struct darshan_deri
 
     /* double */
     munit_assert_double_equal(mfile->fcounters[MPIIO_F_WRITE_TIME], .169246, 6);
+    munit_assert_double_equal(mfile->fcounters[MPIIO_F_COLL_WAIT_TIME], .008820, 6);
+    munit_assert_double_equal(mfile->fcounters[MPIIO_F_COLL_IO_TIME], .022724, 6);
+    munit_assert_double_equal(mfile->fcounters[MPIIO_F_NB_WRITE_TIME], .055022, 6);
+    munit_assert_double_equal(mfile->fcounters[MPIIO_F_NB_WAIT_TIME], .012406, 6);
 
     /* variance should be cleared right now */
     munit_assert_int64(mfile->fcounters[MPIIO_F_VARIANCE_RANK_TIME], ==, 0);
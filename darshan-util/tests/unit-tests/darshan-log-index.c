@@ -0,0 +1,416 @@
+/*
+ * Copyright (C) 2022 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <zlib.h>
+#include "munit/munit.h"
+
+#include <darshan-logutils.h>
+
+static MunitResult read_records_sequential(const MunitParameter params[], void* data);
+static MunitResult read_records_by_block(const MunitParameter params[], void* data);
+static MunitResult read_records_by_id(const MunitParameter params[], void* data);
+static MunitResult read_columns(const MunitParameter params[], void* data);
+static void* test_context_setup(const MunitParameter params[], void* user_data);
+static void test_context_tear_down(void *data);
+
+static void write_indexed_log(const char *path, struct darshan_posix_file *recs,
+    int columnar_flag);
+
+
+/* test definition */
+static char* layout_params[] = {"row", "columnar", NULL};
+
+static MunitParameterEnum test_params[]
+    = {{"layout", layout_params}, {NULL, NULL}};
+
+static MunitTest tests[]
+    = {{"/read-records-sequential", read_records_sequential,
+        test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE,
+        test_params},
+       {"/read-records-by-block", read_records_by_block,
+        test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE,
+        test_params},
+       {"/read-records-by-id", read_records_by_id,
+        test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE,
+        test_params},
+       {"/read-columns", read_columns,
+        test_context_setup, test_context_tear_down, MUNIT_TEST_OPTION_NONE,
+        test_params},
+       {NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+static const MunitSuite test_suite = {
+    "/darshan-log-index", tests, NULL, 1, MUNIT_SUITE_OPTION_NONE
+};
+
+
+/* the example log holds NUM_RECS POSIX records, written as NUM_BLOCKS
+ * blocks by as many ranks; record i belongs to block (i % NUM_BLOCKS), so
+ * that the record id ranges of the blocks overlap
+ */
+#define NUM_RECS 40
+#define NUM_BLOCKS 3
+#define REC_NCOLS (sizeof(struct darshan_posix_file) / sizeof(uint64_t))
+
+struct test_context {
+    char path[64];
+    darshan_fd fd;
+    /* example records, in the order they are stored in the log */
+    struct darshan_posix_file recs[NUM_RECS];
+    /* index into recs of the first record of each block, plus the end */
+    int blk_start[NUM_BLOCKS + 1];
+};
+
+static void* test_context_setup(const MunitParameter params[], void* user_data)
+{
+    (void) user_data;
+    struct test_context* ctx;
+    const char* layout = munit_parameters_get(params, "layout");
+    int tmp_fd;
+    int b, i, k;
+    int n = 0;
+
+    ctx = calloc(1, sizeof(*ctx));
+    munit_assert_not_null(ctx);
+
+    /* records are stored block by block, sorted by id within each block */
+    for(b = 0; b < NUM_BLOCKS; b++)
+    {
+        ctx->blk_start[b] = n;
+        for(i = b; i < NUM_RECS; i += NUM_BLOCKS, n++)
+        {
+            ctx->recs[n].base_rec.id = 1000 + (i * 7);
+            ctx->recs[n].base_rec.rank = b;
+            for(k = 0; k < POSIX_NUM_INDICES; k++)
+                ctx->recs[n].counters[k] = (i * 100) + k;
+            for(k = 0; k < POSIX_F_NUM_INDICES; k++)
+                ctx->recs[n].fcounters[k] = i + (k / 10.0);
+        }
+    }
+    ctx->blk_start[NUM_BLOCKS] = n;
+
+    snprintf(ctx->path, sizeof(ctx->path), "darshan-log-index-XXXXXX");
+    tmp_fd = mkstemp(ctx->path);
+    munit_assert_int(tmp_fd, >=, 0);
+    close(tmp_fd);
+    unlink(ctx->path);
+
+    write_indexed_log(ctx->path, ctx->recs, strcmp(layout, "columnar") == 0);
+
+    ctx->fd = darshan_log_open(ctx->path);
+    munit_assert_not_null(ctx->fd);
+
+    return ctx;
+}
+
+static void test_context_tear_down(void *data)
+{
+    struct test_context *ctx = (struct test_context*)data;
+
+    darshan_log_close(ctx->fd);
+    unlink(ctx->path);
+    free(ctx);
+}
+
+/* append 'len' bytes of 'buf' to the log, compressed as an independent
+ * zlib stream, and return the compressed length
+ */
+static uint64_t append_stream(int fd, void *buf, size_t len)
+{
+    uLongf comp_len = compressBound(len);
+    void *comp_buf;
+    ssize_t ret;
+    int zret;
+
+    comp_buf = malloc(comp_len);
+    munit_assert_not_null(comp_buf);
+    zret = compress2(comp_buf, &comp_len, buf, len, Z_DEFAULT_COMPRESSION);
+    munit_assert_int(zret, ==, Z_OK);
+    ret = write(fd, comp_buf, comp_len);
+    munit_assert_int(ret, ==, (ssize_t)comp_len);
+    free(comp_buf);
+
+    return(comp_len);
+}
+
+/* write a log with the given POSIX records: the log is first written
+ * without any module data, then the records are appended as one
+ * compressed block per rank, followed by the block index, and the header
+ * is updated to point at them, as the runtime library does
+ */
+static void write_indexed_log(const char *path, struct darshan_posix_file *recs,
+    int columnar_flag)
+{
+    struct darshan_job job;
+    struct darshan_header header;
+    struct darshan_log_block blocks[NUM_BLOCKS];
+    struct darshan_log_index_trailer trailer;
+    darshan_record_id ids[NUM_RECS];
+    char names[NUM_RECS][32];
+    char *name_ptrs[NUM_RECS];
+    uint64_t dir[REC_NCOLS + 1];
+    uint64_t col[NUM_RECS];
+    darshan_fd fd;
+    off_t off;
+    ssize_t ret;
+    int log_fd;
+    int b, i, c;
+    int first;
+    int nrecs;
+
+    memset(&job, 0, sizeof(job));
+    job.uid = 1;
+    job.start_time_sec = 100;
+    job.end_time_sec = 200;
+    job.nprocs = NUM_BLOCKS;
+    job.jobid = 42;
+    for(i = 0; i < NUM_RECS; i++)
+    {
+        ids[i] = recs[i].base_rec.id;
+        snprintf(names[i], sizeof(names[i]), "/tmp/file-%d", i);
+        name_ptrs[i] = names[i];
+    }
+
+    fd = darshan_log_create(path, DARSHAN_ZLIB_COMP, 0);
+    munit_assert_not_null(fd);
+    munit_assert_int(darshan_log_put_job(fd, &job), ==, 0);
+    munit_assert_int(darshan_log_put_exe(fd, "./a.out"), ==, 0);
+    munit_assert_int(darshan_log_put_mounts(fd, NULL, 0), ==, 0);
+    munit_assert_int(darshan_log_put_name_records(fd, ids, name_ptrs, NUM_RECS), ==, 0);
+    darshan_log_close(fd);
+
+    munit_assert_int(chmod(path, 0600), ==, 0);
+    log_fd = open(path, O_RDWR);
+    munit_assert_int(log_fd, >=, 0);
+    ret = pread(log_fd, &header, sizeof(header), 0);
+    munit_assert_int(ret, ==, sizeof(header));
+    off = lseek(log_fd, 0, SEEK_END);
+    munit_assert_int(off, >, 0);
+    header.mod_map[DARSHAN_POSIX_MOD].off = off;
+
+    /* one block per rank, i.e., per NUM_BLOCKS records */
+    first = 0;
+    for(b = 0; b < NUM_BLOCKS; b++)
+    {
+        nrecs = (NUM_RECS - b + NUM_BLOCKS - 1) / NUM_BLOCKS;
+        memset(&blocks[b], 0, sizeof(blocks[b]));
+        blocks[b].first_id = recs[first].base_rec.id;
+        blocks[b].last_id = recs[first + nrecs - 1].base_rec.id;
+        blocks[b].rank = b;
+        blocks[b].off = off;
+        blocks[b].mod_id = DARSHAN_POSIX_MOD;
+        blocks[b].nrecs = nrecs;
+
+        if(!columnar_flag)
+            blocks[b].len = append_stream(log_fd, &recs[first],
+                nrecs * sizeof(*recs));
+        else
+        {
+            /* column directory first, then each column as a stream */
+            dir[0] = REC_NCOLS;
+            ret = write(log_fd, dir, sizeof(dir));
+            munit_assert_int(ret, ==, sizeof(dir));
+            blocks[b].len = sizeof(dir);
+            for(c = 0; c < (int)REC_NCOLS; c++)
+            {
+                for(i = 0; i < nrecs; i++)
+                    memcpy(&col[i], (char *)&recs[first + i] +
+                        (c * sizeof(uint64_t)), sizeof(uint64_t));
+                dir[c + 1] = append_stream(log_fd, col,
+                    nrecs * sizeof(uint64_t));
+                blocks[b].len += dir[c + 1];
+            }
+            ret = pwrite(log_fd, dir, sizeof(dir), off);
+            munit_assert_int(ret, ==, sizeof(dir));
+        }
+
+        off += blocks[b].len;
+        first += nrecs;
+    }
+    munit_assert_int(first, ==, NUM_RECS);
+    header.mod_map[DARSHAN_POSIX_MOD].len =
+        off - header.mod_map[DARSHAN_POSIX_MOD].off;
+    header.mod_ver[DARSHAN_POSIX_MOD] = DARSHAN_POSIX_VER;
+    if(columnar_flag)
+        header.mod_ver[DARSHAN_POSIX_MOD] |= DARSHAN_LOG_COLUMNAR_FLAG;
+
+    /* the block index, in no particular order, and its trailer */
+    for(b = 0; b < NUM_BLOCKS / 2; b++)
+    {
+        struct darshan_log_block tmp = blocks[b];
+        blocks[b] = blocks[NUM_BLOCKS - 1 - b];
+        blocks[NUM_BLOCKS - 1 - b] = tmp;
+    }
+    ret = write(log_fd, blocks, sizeof(blocks));
+    munit_assert_int(ret, ==, sizeof(blocks));
+    trailer.off = off;
+    trailer.count = NUM_BLOCKS;
+    trailer.magic_nr = DARSHAN_LOG_INDEX_MAGIC_NR;
+    ret = write(log_fd, &trailer, sizeof(trailer));
+    munit_assert_int(ret, ==, sizeof(trailer));
+
+    ret = pwrite(log_fd, &header, sizeof(header), 0);
+    munit_assert_int(ret, ==, sizeof(header));
+    close(log_fd);
+}
+
+/* test reading all records of an indexed module as a whole */
+static MunitResult read_records_sequential(const MunitParameter params[], void* data)
+{
+    (void) params;
+    struct test_context* ctx = (struct test_context*)data;
+    struct darshan_posix_file rec;
+    void *buf = &rec;
+    int ret;
+    int n;
+
+    /* read the module twice, as reads restart at the end of the region */
+    for(n = 0; n < 2 * NUM_RECS; n++)
+    {
+        ret = darshan_log_get_record(ctx->fd, DARSHAN_POSIX_MOD, &buf);
+        munit_assert_int(ret, ==, 1);
+        munit_assert_memory_equal(sizeof(rec), &rec, &ctx->recs[n % NUM_RECS]);
+        if(n == NUM_RECS - 1)
+        {
+            ret = darshan_log_get_record(ctx->fd, DARSHAN_POSIX_MOD, &buf);
+            munit_assert_int(ret, ==, 0);
+        }
+    }
+
+    return MUNIT_OK;
+}
+
+/* test reading the records of each block of the index on its own */
+static MunitResult read_records_by_block(const MunitParameter params[], void* data)
+{
+    (void) params;
+    struct test_context* ctx = (struct test_context*)data;
+    struct darshan_log_block *blocks;
+    struct darshan_posix_file rec;
+    void *buf = &rec;
+    int count;
+    int ret;
+    int b, n;
+
+    ret = darshan_log_get_blocks(ctx->fd, DARSHAN_POSIX_MOD, &blocks, &count);
+    munit_assert_int(ret, ==, 0);
+    munit_assert_int(count, ==, NUM_BLOCKS);
+
+    /* blocks come back sorted by offset, i.e., in the order written */
+    for(b = 0; b < count; b++)
+    {
+        munit_assert_int(blocks[b].rank, ==, b);
+        munit_assert_int(blocks[b].nrecs, ==,
+            ctx->blk_start[b + 1] - ctx->blk_start[b]);
+        munit_assert_uint64(blocks[b].first_id, ==,
+            ctx->recs[ctx->blk_start[b]].base_rec.id);
+        munit_assert_uint64(blocks[b].last_id, ==,
+            ctx->recs[ctx->blk_start[b + 1] - 1].base_rec.id);
+
+        ret = darshan_log_select_block(ctx->fd, DARSHAN_POSIX_MOD, b);
+        munit_assert_int(ret, ==, 0);
+        for(n = ctx->blk_start[b]; n < ctx->blk_start[b + 1]; n++)
+        {
+            ret = darshan_log_get_record(ctx->fd, DARSHAN_POSIX_MOD, &buf);
+            munit_assert_int(ret, ==, 1);
+            munit_assert_memory_equal(sizeof(rec), &rec, &ctx->recs[n]);
+        }
+        ret = darshan_log_get_record(ctx->fd, DARSHAN_POSIX_MOD, &buf);
+        munit_assert_int(ret, ==, 0);
+    }
+
+    /* lifting the restriction gets us back to the whole module */
+    ret = darshan_log_select_block(ctx->fd, DARSHAN_POSIX_MOD, -1);
+    munit_assert_int(ret, ==, 0);
+    for(n = 0; n < NUM_RECS; n++)
+    {
+        ret = darshan_log_get_record(ctx->fd, DARSHAN_POSIX_MOD, &buf);
+        munit_assert_int(ret, ==, 1);
+        munit_assert_memory_equal(sizeof(rec), &rec, &ctx->recs[n]);
+    }
+
+    return MUNIT_OK;
+}
+
+/* test looking up records by id, which only reads candidate blocks */
+static MunitResult read_records_by_id(const MunitParameter params[], void* data)
+{
+    (void) params;
+    struct test_context* ctx = (struct test_context*)data;
+    struct darshan_posix_file rec;
+    void *buf = &rec;
+    int ret;
+    int n;
+
+    for(n = NUM_RECS - 1; n >= 0; n--)
+    {
+        ret = darshan_log_get_record_by_id(ctx->fd, DARSHAN_POSIX_MOD,
+            ctx->recs[n].base_rec.id, &buf);
+        munit_assert_int(ret, ==, 1);
+        munit_assert_memory_equal(sizeof(rec), &rec, &ctx->recs[n]);
+    }
+
+    /* an id within the range of every block, but not in the log */
+    ret = darshan_log_get_record_by_id(ctx->fd, DARSHAN_POSIX_MOD,
+        ctx->recs[0].base_rec.id + 1, &buf);
+    munit_assert_int(ret, ==, 0);
+
+    /* sequential reads start over afterwards */
+    ret = darshan_log_get_record(ctx->fd, DARSHAN_POSIX_MOD, &buf);
+    munit_assert_int(ret, ==, 1);
+    munit_assert_memory_equal(sizeof(rec), &rec, &ctx->recs[0]);
+
+    return MUNIT_OK;
+}
+
+/* test reading a subset of the record fields as columns */
+static MunitResult read_columns(const MunitParameter params[], void* data)
+{
+    (void) params;
+    struct test_context* ctx = (struct test_context*)data;
+    int cols[3] = {
+        DARSHAN_COLUMN(struct darshan_posix_file, fcounters[POSIX_F_READ_TIME]),
+        DARSHAN_COLUMN(struct darshan_posix_file, base_rec.id),
+        DARSHAN_COLUMN(struct darshan_posix_file, counters[POSIX_BYTES_WRITTEN])};
+    uint64_t vals[NUM_RECS * 3];
+    int ret;
+    int n, j;
+    int got;
+
+    /* read in two batches that don't line up with the blocks */
+    ret = darshan_log_get_columns(ctx->fd, DARSHAN_POSIX_MOD, cols, 3,
+        vals, NUM_RECS / 4, &got);
+    munit_assert_int(ret, ==, 0);
+    munit_assert_int(got, ==, NUM_RECS / 4);
+    ret = darshan_log_get_columns(ctx->fd, DARSHAN_POSIX_MOD, cols, 3,
+        vals + (got * 3), NUM_RECS, &n);
+    munit_assert_int(ret, ==, 0);
+    got += n;
+    munit_assert_int(got, ==, NUM_RECS);
+
+    for(n = 0; n < NUM_RECS; n++)
+        for(j = 0; j < 3; j++)
+            munit_assert_memory_equal(sizeof(uint64_t), &vals[(n * 3) + j],
+                (char *)&ctx->recs[n] + (cols[j] * sizeof(uint64_t)));
+
+    /* the end of the records is reported once */
+    ret = darshan_log_get_columns(ctx->fd, DARSHAN_POSIX_MOD, cols, 3,
+        vals, NUM_RECS, &n);
+    munit_assert_int(ret, ==, 0);
+    munit_assert_int(n, ==, 0);
+
+    return MUNIT_OK;
+}
+
+int main(int argc, char **argv)
+{
+    return munit_suite_main(&test_suite, NULL, argc, argv);
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifndef __DARSHAN_ATTRIB_LOG_FORMAT_H
+#define __DARSHAN_ATTRIB_LOG_FORMAT_H
+
+/* current ATTRIB log format version */
+#define DARSHAN_ATTRIB_VER 1
+
+#define ATTRIB_COUNTERS \
+    /* id of the module of the upper-layer record (H5D, PNETCDF_VAR, or
+     * MPI-IO) that this record attributes lower-layer I/O to */\
+    X(ATTRIB_UPPER_MODULE) \
+    /* number of upper-layer calls that issued lower-layer I/O */\
+    X(ATTRIB_CALLS) \
+    /* MPI-IO operations and bytes issued by those calls */\
+    X(ATTRIB_MPIIO_READS) \
+    X(ATTRIB_MPIIO_WRITES) \
+    X(ATTRIB_MPIIO_META_OPS) \
+    X(ATTRIB_MPIIO_BYTES_READ) \
+    X(ATTRIB_MPIIO_BYTES_WRITTEN) \
+    /* POSIX operations and bytes issued by those calls */\
+    X(ATTRIB_POSIX_READS) \
+    X(ATTRIB_POSIX_WRITES) \
+    X(ATTRIB_POSIX_META_OPS) \
+    X(ATTRIB_POSIX_BYTES_READ) \
+    X(ATTRIB_POSIX_BYTES_WRITTEN) \
+    /* end of counters */\
+    X(ATTRIB_NUM_INDICES)
+
+#define ATTRIB_F_COUNTERS \
+    /* cumulative time spent in the MPI-IO operations issued */\
+    X(ATTRIB_F_MPIIO_READ_TIME) \
+    X(ATTRIB_F_MPIIO_WRITE_TIME) \
+    X(ATTRIB_F_MPIIO_META_TIME) \
+    /* cumulative time spent in the POSIX operations issued */\
+    X(ATTRIB_F_POSIX_READ_TIME) \
+    X(ATTRIB_F_POSIX_WRITE_TIME) \
+    X(ATTRIB_F_POSIX_META_TIME) \
+    /* end of counters */\
+    X(ATTRIB_F_NUM_INDICES)
+
+/* number of counters kept for each lower layer, in the order given above */
+#define ATTRIB_LAYER_COUNTERS 5
+#define ATTRIB_LAYER_F_COUNTERS 3
+
+#define X(a) a,
+/* integer statistics for ATTRIB records */
+enum darshan_attrib_indices
+{
+    ATTRIB_COUNTERS
+};
+
+/* floating point statistics for ATTRIB records */
+enum darshan_attrib_f_indices
+{
+    ATTRIB_F_COUNTERS
+};
+#undef X
+
+/* record of the lower-layer I/O issued on behalf of an upper-layer record.
+ *
+ * An ATTRIB record has the same id (and so the same name) as the H5D,
+ * PNETCDF_VAR, or MPI-IO record whose read and write calls issued the
+ * MPI-IO and POSIX operations it counts.  Only operations issued by the
+ * calling thread, before the upper-layer call returns, are attributed;
+ * I/O of the outermost layer is attributed to it alone.
+ */
+struct darshan_attrib_record
+{
+    struct darshan_base_record base_rec;
+    int64_t counters[ATTRIB_NUM_INDICES];
+    double fcounters[ATTRIB_F_NUM_INDICES];
+};
+
+#endif /* __DARSHAN_ATTRIB_LOG_FORMAT_H */
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2015 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifndef __DARSHAN_BATCHIO_LOG_FORMAT_H
+#define __DARSHAN_BATCHIO_LOG_FORMAT_H
+
+/* current BATCHIO log format version */
+#define DARSHAN_BATCHIO_VER 1
+
+/* names of the records that summarize each submission interface */
+#define BATCHIO_LIBAIO_NAME "<libaio>"
+#define BATCHIO_IO_URING_NAME "<io_uring>"
+
+#define BATCHIO_COUNTERS \
+    /* count of vectored reads (readv, preadv, preadv2 and 64-bit variants) */\
+    X(BATCHIO_VEC_READS) \
+    /* count of vectored writes (writev, pwritev, pwritev2 and 64-bit variants) */\
+    X(BATCHIO_VEC_WRITES) \
+    /* total iovec segments passed to vectored calls and vectored requests */\
+    X(BATCHIO_IOVECS) \
+    /* largest iovec count of a single vectored call or request */\
+    X(BATCHIO_MAX_IOVCNT) \
+    /* histogram of iovec counts per vectored call or request */\
+    X(BATCHIO_IOVCNT_1) \
+    X(BATCHIO_IOVCNT_2_7) \
+    X(BATCHIO_IOVCNT_8_31) \
+    X(BATCHIO_IOVCNT_32_PLUS) \
+    /* count of asynchronous read requests submitted */\
+    X(BATCHIO_ASYNC_READS) \
+    /* count of asynchronous write requests submitted */\
+    X(BATCHIO_ASYNC_WRITES) \
+    /* count of other asynchronous requests submitted (fsync, poll, ...) */\
+    X(BATCHIO_ASYNC_OTHER) \
+    /* count of asynchronous requests whose completion was reaped */\
+    X(BATCHIO_COMPLETIONS) \
+    /* largest number of requests in flight at once */\
+    X(BATCHIO_MAX_QUEUE_DEPTH) \
+    /* sum over submitted requests of the requests in flight (including
+     * the new one) at the time each was submitted */\
+    X(BATCHIO_QUEUE_DEPTH_SUM) \
+    /* count of submission calls (io_submit, io_uring_enter, ...) */\
+    X(BATCHIO_SUBMITS) \
+    /* count of requests accepted by submission calls */\
+    X(BATCHIO_SUBMITTED) \
+    /* count of submission calls that accepted fewer requests than given */\
+    X(BATCHIO_SHORT_SUBMITS) \
+    /* largest number of requests accepted by a single submission call */\
+    X(BATCHIO_MAX_BATCH) \
+    /* histogram of requests accepted per submission call */\
+    X(BATCHIO_BATCH_1) \
+    X(BATCHIO_BATCH_2_7) \
+    X(BATCHIO_BATCH_8_31) \
+    X(BATCHIO_BATCH_32_PLUS) \
+    /* count of calls that waited for or reaped completions */\
+    X(BATCHIO_WAITS) \
+    /* end of counters */\
+    X(BATCHIO_NUM_INDICES)
+
+#define BATCHIO_F_COUNTERS \
+    /* cumulative time spent in submission calls */\
+    X(BATCHIO_F_SUBMIT_TIME) \
+    /* cumulative time spent in calls that wait for or reap completions */\
+    X(BATCHIO_F_WAIT_TIME) \
+    /* sum of submission-to-reap latencies of completed requests */\
+    X(BATCHIO_F_COMPLETION_LATENCY) \
+    /* largest submission-to-reap latency of a completed request */\
+    X(BATCHIO_F_MAX_COMPLETION_LATENCY) \
+    /* end of counters */\
+    X(BATCHIO_F_NUM_INDICES)
+
+#define X(a) a,
+/* integer statistics for BATCHIO records */
+enum darshan_batchio_indices
+{
+    BATCHIO_COUNTERS
+};
+
+/* floating point statistics for BATCHIO records */
+enum darshan_batchio_f_indices
+{
+    BATCHIO_F_COUNTERS
+};
+#undef X
+
+/* record of statistics for vectored and batched asynchronous I/O.
+ *
+ * There is one record per file accessed through these interfaces (sharing
+ * the file's POSIX record id and name), plus one record per submission
+ * interface (named BATCHIO_LIBAIO_NAME or BATCHIO_IO_URING_NAME).  The
+ * submission and wait counters are only kept in the interface records,
+ * since a single call may cover many files.
+ */
+struct darshan_batchio_record
+{
+    struct darshan_base_record base_rec;
+    int64_t counters[BATCHIO_NUM_INDICES];
+    double fcounters[BATCHIO_F_NUM_INDICES];
+};
+
+#endif /* __DARSHAN_BATCHIO_LOG_FORMAT_H */
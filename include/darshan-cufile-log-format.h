@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifndef __DARSHAN_CUFILE_LOG_FORMAT_H
+#define __DARSHAN_CUFILE_LOG_FORMAT_H
+
+/* current CUFILE log format version */
+#define DARSHAN_CUFILE_VER 1
+
+/* name of the record that summarizes buffer registration and batch I/O */
+#define CUFILE_SUMMARY_NAME "<cufile>"
+
+#define CUFILE_COUNTERS \
+    /* count of cuFile handles registered for the file */\
+    X(CUFILE_HANDLE_REGISTERS) \
+    /* count of cuFileRead calls */\
+    X(CUFILE_READS) \
+    /* count of cuFileWrite calls */\
+    X(CUFILE_WRITES) \
+    /* count of read requests submitted in batches */\
+    X(CUFILE_BATCH_READS) \
+    /* count of write requests submitted in batches */\
+    X(CUFILE_BATCH_WRITES) \
+    /* total bytes read and written by cuFileRead and cuFileWrite */\
+    X(CUFILE_BYTES_READ) \
+    X(CUFILE_BYTES_WRITTEN) \
+    /* total bytes requested by batched reads and writes */\
+    X(CUFILE_BATCH_BYTES_READ) \
+    X(CUFILE_BATCH_BYTES_WRITTEN) \
+    /* highest offset in the file that was read or written */\
+    X(CUFILE_MAX_BYTE_READ) \
+    X(CUFILE_MAX_BYTE_WRITTEN) \
+    /* count and bytes of operations on buffers registered with
+     * cuFileBufRegister, which GDS can move without staging */\
+    X(CUFILE_REG_BUF_OPS) \
+    X(CUFILE_REG_BUF_BYTES) \
+    /* count and bytes of operations on unregistered buffers, which GDS
+     * stages through its internal bounce buffers */\
+    X(CUFILE_UNREG_BUF_OPS) \
+    X(CUFILE_UNREG_BUF_BYTES) \
+    /* count of failed calls and failed batch requests */\
+    X(CUFILE_ERRORS) \
+    /* histogram of read access sizes (sync and batched) */\
+    X(CUFILE_SIZE_READ_0_100) \
+    X(CUFILE_SIZE_READ_100_1K) \
+    X(CUFILE_SIZE_READ_1K_10K) \
+    X(CUFILE_SIZE_READ_10K_100K) \
+    X(CUFILE_SIZE_READ_100K_1M) \
+    X(CUFILE_SIZE_READ_1M_4M) \
+    X(CUFILE_SIZE_READ_4M_10M) \
+    X(CUFILE_SIZE_READ_10M_100M) \
+    X(CUFILE_SIZE_READ_100M_1G) \
+    X(CUFILE_SIZE_READ_1G_PLUS) \
+    /* histogram of write access sizes (sync and batched) */\
+    X(CUFILE_SIZE_WRITE_0_100) \
+    X(CUFILE_SIZE_WRITE_100_1K) \
+    X(CUFILE_SIZE_WRITE_1K_10K) \
+    X(CUFILE_SIZE_WRITE_10K_100K) \
+    X(CUFILE_SIZE_WRITE_100K_1M) \
+    X(CUFILE_SIZE_WRITE_1M_4M) \
+    X(CUFILE_SIZE_WRITE_4M_10M) \
+    X(CUFILE_SIZE_WRITE_10M_100M) \
+    X(CUFILE_SIZE_WRITE_100M_1G) \
+    X(CUFILE_SIZE_WRITE_1G_PLUS) \
+    /* count of cuFileBufRegister calls and total bytes registered */\
+    X(CUFILE_BUF_REGISTERS) \
+    X(CUFILE_BUF_REGISTERED_BYTES) \
+    /* count of cuFileBatchIOSubmit calls */\
+    X(CUFILE_BATCH_SUBMITS) \
+    /* count of requests accepted by cuFileBatchIOSubmit */\
+    X(CUFILE_BATCH_SUBMITTED) \
+    /* largest number of requests in a single submission */\
+    X(CUFILE_MAX_BATCH) \
+    /* histogram of requests per submission */\
+    X(CUFILE_BATCH_1) \
+    X(CUFILE_BATCH_2_7) \
+    X(CUFILE_BATCH_8_31) \
+    X(CUFILE_BATCH_32_PLUS) \
+    /* count of cuFileBatchIOGetStatus calls */\
+    X(CUFILE_BATCH_POLLS) \
+    /* count of batch requests reported complete */\
+    X(CUFILE_BATCH_COMPLETIONS) \
+    /* end of counters */\
+    X(CUFILE_NUM_INDICES)
+
+#define CUFILE_F_COUNTERS \
+    /* timestamp of first read */\
+    X(CUFILE_F_READ_START_TIMESTAMP) \
+    /* timestamp of first write */\
+    X(CUFILE_F_WRITE_START_TIMESTAMP) \
+    /* timestamp of last read */\
+    X(CUFILE_F_READ_END_TIMESTAMP) \
+    /* timestamp of last write */\
+    X(CUFILE_F_WRITE_END_TIMESTAMP) \
+    /* cumulative time spent in cuFileRead and cuFileWrite */\
+    X(CUFILE_F_READ_TIME) \
+    X(CUFILE_F_WRITE_TIME) \
+    /* cumulative time spent registering and deregistering handles and
+     * buffers */\
+    X(CUFILE_F_META_TIME) \
+    /* slowest single cuFileRead and cuFileWrite */\
+    X(CUFILE_F_MAX_READ_TIME) \
+    X(CUFILE_F_MAX_WRITE_TIME) \
+    /* cumulative time spent in cuFileBatchIOSubmit */\
+    X(CUFILE_F_BATCH_SUBMIT_TIME) \
+    /* cumulative time spent in cuFileBatchIOGetStatus */\
+    X(CUFILE_F_BATCH_POLL_TIME) \
+    /* sum of submission-to-completion latencies of batch requests */\
+    X(CUFILE_F_BATCH_LATENCY) \
+    /* largest submission-to-completion latency of a batch request */\
+    X(CUFILE_F_MAX_BATCH_LATENCY) \
+    /* end of counters */\
+    X(CUFILE_F_NUM_INDICES)
+
+#define X(a) a,
+/* integer statistics for CUFILE records */
+enum darshan_cufile_indices
+{
+    CUFILE_COUNTERS
+};
+
+/* floating point statistics for CUFILE records */
+enum darshan_cufile_f_indices
+{
+    CUFILE_F_COUNTERS
+};
+#undef X
+
+/* record of statistics for NVIDIA GPUDirect Storage (cuFile) I/O.
+ *
+ * There is one record per file accessed through a cuFile handle, named by
+ * the file's path, plus one record named CUFILE_SUMMARY_NAME.  Buffer
+ * registration and batch submission counters are only kept in the summary
+ * record, since buffers and batches are not tied to a file.  I/O on
+ * handles that were not registered through a wrapped call is counted in
+ * the summary record as well.
+ */
+struct darshan_cufile_record
+{
+    struct darshan_base_record base_rec;
+    int64_t counters[CUFILE_NUM_INDICES];
+    double fcounters[CUFILE_F_NUM_INDICES];
+};
+
+#endif /* __DARSHAN_CUFILE_LOG_FORMAT_H */
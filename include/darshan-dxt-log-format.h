@@ -7,8 +7,9 @@
 #define __DARSHAN_DXT_LOG_FORMAT_H
 
 /* current DXT log format version */
-#define DXT_POSIX_VER 1
-#define DXT_MPIIO_VER 2
+#define DXT_POSIX_VER 2
+#define DXT_MPIIO_VER 3
+#define DXT_STDIO_VER 1
 
 #define HOSTNAME_SIZE 64
 
@@ -21,8 +22,73 @@ typedef struct segment_info {
     int64_t length;
     double start_time;
     double end_time;
+    int64_t thread_id; /* id of the thread that issued the op, -1 if unknown */
 } segment_info;
 
+/*
+ * Starting with DXT_POSIX version 2 and DXT_MPIIO version 3 (and in all
+ * versions of DXT_STDIO), the trace segments following each dxt_file_record
+ * in the log are stored compactly: an int64_t count of encoded bytes and
+ * two int64_t values giving the time range of all of the record's segments,
+ * in ticks (the earliest start time and the latest end time, both 0 if the
+ * record has no segments), followed by the write segments and then the
+ * read segments, each encoded as five zigzag varints:
+ *      - offset, relative to the end of the previous segment
+ *      - length
+ *      - start time, as a delta from the previous segment's start time
+ *      - duration (end time - start time)
+ *      - thread id, as a delta from the previous segment's thread id
+ * Readers can use the time range to skip records that fall outside a time
+ * window without decoding their segments.
+ * Times are encoded in DXT_SEG_TICKS_PER_SEC fixed-point ticks, and the
+ * "previous segment" state (with a thread id of 0) is reset between the
+ * write and read segments.
+ */
+#define DXT_SEG_TICKS_PER_SEC 1000000000.0
+#define DXT_SEG_TIME_TO_TICKS(__t) \
+    ((int64_t)((__t) * DXT_SEG_TICKS_PER_SEC + 0.5))
+#define DXT_SEG_TICKS_TO_TIME(__ticks) \
+    ((double)(__ticks) / DXT_SEG_TICKS_PER_SEC)
+
+/* maximum encoded size of a varint and of a single trace segment */
+#define DXT_VARINT_MAX_BYTES 10
+#define DXT_SEG_MAX_ENCODED_SIZE (5 * DXT_VARINT_MAX_BYTES)
+
+#define DXT_ZIGZAG_ENC(__v) \
+    (((uint64_t)(__v) << 1) ^ (uint64_t)((int64_t)(__v) >> 63))
+#define DXT_ZIGZAG_DEC(__u) \
+    ((int64_t)(((uint64_t)(__u) >> 1) ^ (~((uint64_t)(__u) & 1) + 1)))
+
+/* append unsigned varint '__u' at unsigned char pointer '__p' */
+#define DXT_VARINT_PUT(__p, __u) do { \
+    uint64_t __v = (__u); \
+    while(__v >= 0x80) { \
+        *(__p)++ = (unsigned char)(__v | 0x80); \
+        __v >>= 7; \
+    } \
+    *(__p)++ = (unsigned char)__v; \
+} while(0)
+
+/* read an unsigned varint into '__u' from unsigned char pointer '__p',
+ * not reading past '__end'; '__ok' is set to 0 on truncated input
+ */
+#define DXT_VARINT_GET(__p, __end, __u, __ok) do { \
+    uint64_t __v = 0; \
+    int __shift = 0; \
+    unsigned char __b; \
+    (__ok) = 0; \
+    while(((__p) < (__end)) && (__shift < 64)) { \
+        __b = *(__p)++; \
+        __v |= (uint64_t)(__b & 0x7f) << __shift; \
+        if(!(__b & 0x80)) { \
+            (__ok) = 1; \
+            break; \
+        } \
+        __shift += 7; \
+    } \
+    (__u) = __v; \
+} while(0)
+
 #define X(a) a,
 #undef X
 
@@ -40,6 +106,9 @@ struct dxt_file_record {
 
     int64_t write_count;
     int64_t read_count;
+    /* number of earliest segments overwritten in ring buffer mode */
+    int64_t write_dropped;
+    int64_t read_dropped;
 };
 
 #endif /* __DARSHAN_DXT_LOG_FORMAT_H */
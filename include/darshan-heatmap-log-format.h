@@ -7,11 +7,33 @@
 #define __DARSHAN_HEATMAP_LOG_FORMAT_H
 
 /* current HEATMAP log format version */
-#define DARSHAN_HEATMAP_VER 1
+#define DARSHAN_HEATMAP_VER 2
+
+/* flags indicating which optional bin arrays trail a heatmap record */
+#define DARSHAN_HEATMAP_F_OP_BINS 0x1 /* write, read, and metadata op counts */
+#define DARSHAN_HEATMAP_F_SPARSE  0x2 /* bins are stored sparsely in the log */
+/* bins are summed over the ranks of the node of the record's rank, or over
+ * all ranks if its rank is -1 (see DARSHAN_HEATMAP_REDUCE)
+ */
+#define DARSHAN_HEATMAP_F_REDUCED 0x4
+
+/* number of bin arrays trailing a heatmap record with the given flags */
+#define DARSHAN_HEATMAP_NARRAYS(__flags) \
+    (((__flags) & DARSHAN_HEATMAP_F_OP_BINS) ? 5 : 2)
+
+/* In a record with DARSHAN_HEATMAP_F_SPARSE set (as of version 2), the
+ * dense bin arrays are replaced in the log by an int64_t count of the bins
+ * that are nonzero in any array, followed by an entry for each of those
+ * bins in increasing order: its int64_t index, then its int64_t value in
+ * each bin array (in the order the arrays trail the record).  This is the
+ * size of that encoding for 'nnz' nonzero bins.
+ */
+#define DARSHAN_HEATMAP_SPARSE_SIZE(__flags, __nnz) \
+    ((1 + (__nnz) * (1 + DARSHAN_HEATMAP_NARRAYS(__flags))) * sizeof(int64_t))
 
 /* record structure for a Darshan heatmap.  These should be one per
  * API/category that registers heatmap data.  Each is variable size
- * according to the nbins field.
+ * according to the nbins and flags fields.
  */
 struct darshan_heatmap_record
 {
@@ -20,6 +42,11 @@ struct darshan_heatmap_record
     int64_t nbins;             /* number of bins */
     int64_t *write_bins;       /* pointer to write bin array (trails struct in log */
     int64_t *read_bins;        /* pointer to read bin array (trails write bin array in log */
+    /* the following fields were added in version 2 */
+    int64_t flags;             /* DARSHAN_HEATMAP_F_* flags */
+    int64_t *write_op_bins;    /* pointer to write op count bin array (trails read bin array in log if DARSHAN_HEATMAP_F_OP_BINS is set, NULL otherwise) */
+    int64_t *read_op_bins;     /* pointer to read op count bin array (trails write op count bin array in log) */
+    int64_t *meta_op_bins;     /* pointer to metadata op count bin array (trails read op count bin array in log) */
 };
 
 #endif /* __DARSHAN_HEATMAP_LOG_FORMAT_H */
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifndef __DARSHAN_LATENCY_LOG_FORMAT_H
+#define __DARSHAN_LATENCY_LOG_FORMAT_H
+
+/* current LATENCY log format version */
+#define DARSHAN_LATENCY_VER 1
+
+/* number of buckets in each latency histogram.  Bucket 0 counts operations
+ * that took less than 1 microsecond, bucket i (0 < i < 31) those that took
+ * [2^(i-1), 2^i) microseconds, and bucket 31 those that took 2^30
+ * microseconds (about 18 minutes) or more.
+ */
+#define LATENCY_NUM_BUCKETS 32
+
+/* operation classes with their own histogram, in counter order */
+#define LATENCY_OP_POSIX_READ 0
+#define LATENCY_OP_POSIX_WRITE 1
+#define LATENCY_OP_POSIX_META 2
+#define LATENCY_OP_MPIIO_READ 3
+#define LATENCY_OP_MPIIO_WRITE 4
+#define LATENCY_OP_MPIIO_META 5
+#define LATENCY_OP_COUNT 6
+
+#define LATENCY_HISTOGRAM(__p) \
+    X(__p##_0) X(__p##_1) X(__p##_2) X(__p##_3) \
+    X(__p##_4) X(__p##_5) X(__p##_6) X(__p##_7) \
+    X(__p##_8) X(__p##_9) X(__p##_10) X(__p##_11) \
+    X(__p##_12) X(__p##_13) X(__p##_14) X(__p##_15) \
+    X(__p##_16) X(__p##_17) X(__p##_18) X(__p##_19) \
+    X(__p##_20) X(__p##_21) X(__p##_22) X(__p##_23) \
+    X(__p##_24) X(__p##_25) X(__p##_26) X(__p##_27) \
+    X(__p##_28) X(__p##_29) X(__p##_30) X(__p##_31)
+
+#define LATENCY_COUNTERS \
+    /* histogram of POSIX read latencies */\
+    LATENCY_HISTOGRAM(LATENCY_POSIX_READ) \
+    /* histogram of POSIX write latencies */\
+    LATENCY_HISTOGRAM(LATENCY_POSIX_WRITE) \
+    /* histogram of POSIX open, stat and close latencies */\
+    LATENCY_HISTOGRAM(LATENCY_POSIX_META) \
+    /* histogram of MPI-IO read latencies */\
+    LATENCY_HISTOGRAM(LATENCY_MPIIO_READ) \
+    /* histogram of MPI-IO write latencies */\
+    LATENCY_HISTOGRAM(LATENCY_MPIIO_WRITE) \
+    /* histogram of MPI-IO open and close latencies */\
+    LATENCY_HISTOGRAM(LATENCY_MPIIO_META) \
+    /* end of counters */\
+    X(LATENCY_NUM_INDICES)
+
+#define LATENCY_F_COUNTERS \
+    /* sum of the latencies counted in each histogram; unlike the POSIX and
+     * MPI-IO module times, overlapping operations are all counted */\
+    X(LATENCY_F_POSIX_READ_TIME) \
+    X(LATENCY_F_POSIX_WRITE_TIME) \
+    X(LATENCY_F_POSIX_META_TIME) \
+    X(LATENCY_F_MPIIO_READ_TIME) \
+    X(LATENCY_F_MPIIO_WRITE_TIME) \
+    X(LATENCY_F_MPIIO_META_TIME) \
+    /* end of counters */\
+    X(LATENCY_F_NUM_INDICES)
+
+#define X(a) a,
+/* integer statistics for LATENCY records */
+enum darshan_latency_indices
+{
+    LATENCY_COUNTERS
+};
+
+/* floating point statistics for LATENCY records */
+enum darshan_latency_f_indices
+{
+    LATENCY_F_COUNTERS
+};
+#undef X
+
+/* record of per-file operation latency histograms.
+ *
+ * There is one record per file accessed through POSIX or MPI-IO, sharing
+ * the file's POSIX and MPI-IO record id and name.  The histogram of
+ * operation class 'op' starts at counter op * LATENCY_NUM_BUCKETS, and its
+ * total latency is fcounter 'op'.  Records are reduced by summing.
+ */
+struct darshan_latency_record
+{
+    struct darshan_base_record base_rec;
+    int64_t counters[LATENCY_NUM_INDICES];
+    double fcounters[LATENCY_F_NUM_INDICES];
+};
+
+#endif /* __DARSHAN_LATENCY_LOG_FORMAT_H */
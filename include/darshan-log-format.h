@@ -24,7 +24,7 @@
  * log format version, NOT when a new version of a module record is
  * introduced -- we have module-specific versions to handle that
  */
-#define DARSHAN_LOG_VERSION "3.41"
+#define DARSHAN_LOG_VERSION "3.42"
 
 /* magic number for validating output files and checking byte order */
 #define DARSHAN_MAGIC_NR 6567223
@@ -49,6 +49,7 @@ enum darshan_comp_type
     DARSHAN_ZLIB_COMP,
     DARSHAN_BZIP2_COMP,
     DARSHAN_NO_COMP,
+    DARSHAN_ZSTD_COMP,
 };
 
 typedef uint64_t darshan_record_id;
@@ -72,6 +73,10 @@ struct darshan_header
     char version_string[8];
     int64_t magic_nr;
     unsigned char comp_type;
+    /* id of the trained zstd dictionary the log regions were compressed
+     * with, or 0 if none (log ver 3.42 and later; previously padding)
+     */
+    uint32_t comp_dict_id;
     uint64_t partial_flag;
     struct darshan_log_map name_map;
     struct darshan_log_map mod_map[DARSHAN_MAX_MODS];
@@ -99,6 +104,65 @@ struct darshan_name_record
     char name[1];
 };
 
+/* entry of the name record region, as of log ver 3.42; to avoid repeating
+ * directory prefixes, names are stored as a tree of directory entries.
+ * If DARSHAN_NAME_DIR_FLAG is set in 'dir', the entry defines a directory
+ * with identifier 'id', otherwise it maps record 'id' to a name. In both
+ * cases, 'dir' (without the flag) is the identifier of the parent
+ * directory, and 'name' is relative to it, unless 'dir' is 0, in which
+ * case 'name' is the full name. A directory entry always precedes the
+ * entries that refer to it, and directory identifiers never have
+ * DARSHAN_NAME_DIR_FLAG set. Identifiers are only meaningful within the
+ * part of the region written by one process; a directory defined again
+ * replaces the earlier definition.
+ */
+#define DARSHAN_NAME_DIR_FLAG 1ULL
+
+struct darshan_name_entry
+{
+    darshan_record_id id;
+    uint64_t dir;
+    char name[1];
+};
+
+/* size of a serialized name entry with a name of the given length */
+#define DARSHAN_NAME_ENTRY_SIZE(__name_len) \
+    (sizeof(darshan_record_id) + sizeof(uint64_t) + (__name_len) + 1)
+
+/* trailer stored in the last bytes of each mmap log file (see the
+ * --enable-mmap-logs configure option), so that tools can sample the
+ * counters of a running process without any help from it.  The header,
+ * job record, name region and module regions that precede it are laid
+ * out as in an uncompressed log, with 'name_map' and 'mod_map' of the
+ * header giving the current extent of each region.
+ *
+ * Each generation counter is odd while its region is being extended and
+ * is incremented again once the region (and its extent in the header) is
+ * consistent.  Readers copy a region between two reads of its counter and
+ * retry if the counter was odd or changed.  Counters within records are
+ * updated in place without bumping the generation, so a copy may mix
+ * values from before and after an in-flight operation; records whose id
+ * is still 0 have not been initialized yet.  Once 'state' leaves
+ * DARSHAN_MMAP_LIVE_RUNNING, darshan reorganizes the regions to write
+ * the final log and they must no longer be read.
+ */
+#define DARSHAN_MMAP_LIVE_MAGIC_NR 7567223
+#define DARSHAN_MMAP_LIVE_VER 1
+
+#define DARSHAN_MMAP_LIVE_RUNNING 0
+#define DARSHAN_MMAP_LIVE_SHUTDOWN 1
+
+struct darshan_mmap_live
+{
+    int64_t magic_nr;
+    uint32_t version;
+    uint32_t state;
+    int64_t pid;
+    int64_t rank;
+    uint64_t name_gen;
+    uint64_t mod_gen[DARSHAN_MAX_MODS];
+};
+
 /* base record definition that can be used by modules */
 struct darshan_base_record
 {
@@ -106,6 +170,51 @@ struct darshan_base_record
     int64_t rank;
 };
 
+/* optional block index extension: module regions may be written as a
+ * series of independently decompressable blocks, each described by a
+ * darshan_log_block entry. The array of entries is stored uncompressed
+ * after the last log region and is located using a trailer at the very
+ * end of the log file. Readers that don't know about the index never
+ * look past the regions described in the header, so they are unaffected.
+ */
+#define DARSHAN_LOG_INDEX_MAGIC_NR 6567224
+
+struct darshan_log_block
+{
+    /* smallest and largest record ids in this block; blocks of modules
+     * with variable-size records cover the whole id space
+     */
+    darshan_record_id first_id;
+    darshan_record_id last_id;
+    /* rank that wrote this block */
+    int64_t rank;
+    /* offset and length of the block in the log file, in compressed terms */
+    uint64_t off;
+    uint64_t len;
+    uint32_t mod_id;
+    /* number of records in the block, or 0 if not known */
+    uint32_t nrecs;
+};
+
+struct darshan_log_index_trailer
+{
+    uint64_t off;
+    uint64_t count;
+    int64_t magic_nr;
+};
+
+/* optional columnar layout: if a module's version in the header has
+ * DARSHAN_LOG_COLUMNAR_FLAG set, each of the module's blocks in the block
+ * index stores its records column by column, where every 8-byte field of
+ * the record is a column. A block starts with an uncompressed array of
+ * uint64_t values: the number of columns, then the compressed length of
+ * each column. It is followed by each column's values for all of the
+ * block's records, compressed as an independent stream.
+ * Readers that don't know about the flag treat the module as having an
+ * unsupported version.
+ */
+#define DARSHAN_LOG_COLUMNAR_FLAG (1U << 31)
+
 
 /************************************************
  *** module-specific includes and definitions ***
@@ -129,6 +238,15 @@ struct darshan_base_record
 #include "darshan-apmpi-log-format.h"
 #endif
 #include "darshan-heatmap-log-format.h"
+#include "darshan-batchio-log-format.h"
+#include "darshan-overhead-log-format.h"
+#include "darshan-latency-log-format.h"
+#include "darshan-timeseries-log-format.h"
+#include "darshan-cufile-log-format.h"
+#include "darshan-mmap-log-format.h"
+#include "darshan-rollup-log-format.h"
+#include "darshan-phase-log-format.h"
+#include "darshan-attrib-log-format.h"
 
 /* X-macro for keeping module ordering consistent */
 /* NOTE: first val used to define module enum values,
@@ -175,7 +293,17 @@ struct darshan_base_record
     X(DARSHAN_MDHIM_MOD,    "MDHIM",      DARSHAN_MDHIM_VER,     &mdhim_logutils) \
     X(DARSHAN_APXC_MOD,     "APXC", 	  __APXC_VER,            __apxc_logutils) \
     X(DARSHAN_APMPI_MOD,    "APMPI",      __APMPI_VER,           __apmpi_logutils) \
-    X(DARSHAN_HEATMAP_MOD,  "HEATMAP",    DARSHAN_HEATMAP_VER,   &heatmap_logutils)
+    X(DARSHAN_HEATMAP_MOD,  "HEATMAP",    DARSHAN_HEATMAP_VER,   &heatmap_logutils) \
+    X(DXT_STDIO_MOD,        "DXT_STDIO",  DXT_STDIO_VER,         &dxt_stdio_logutils) \
+    X(DARSHAN_BATCHIO_MOD,  "BATCHIO",    DARSHAN_BATCHIO_VER,   &batchio_logutils) \
+    X(DARSHAN_OVERHEAD_MOD, "OVERHEAD",   DARSHAN_OVERHEAD_VER,  &overhead_logutils) \
+    X(DARSHAN_LATENCY_MOD,  "LATENCY",    DARSHAN_LATENCY_VER,   &latency_logutils) \
+    X(DARSHAN_TIMESERIES_MOD, "TIMESERIES", DARSHAN_TIMESERIES_VER, &timeseries_logutils) \
+    X(DARSHAN_CUFILE_MOD,   "CUFILE",     DARSHAN_CUFILE_VER,    &cufile_logutils) \
+    X(DARSHAN_MMAP_MOD,     "MMAP",       DARSHAN_MMAP_VER,      &mmap_logutils) \
+    X(DARSHAN_ROLLUP_MOD,   "ROLLUP",     DARSHAN_ROLLUP_VER,    &rollup_logutils) \
+    X(DARSHAN_PHASE_MOD,    "PHASE",      DARSHAN_PHASE_VER,     &phase_logutils) \
+    X(DARSHAN_ATTRIB_MOD,   "ATTRIB",     DARSHAN_ATTRIB_VER,    &attrib_logutils)
 
 /* unique identifiers to distinguish between available darshan modules */
 /* NOTES: - valid ids range from [0...DARSHAN_MAX_MODS-1]
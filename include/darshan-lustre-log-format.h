@@ -13,7 +13,7 @@
 typedef int64_t OST_ID;
 
 /* current Lustre log format version */
-#define DARSHAN_LUSTRE_VER 2
+#define DARSHAN_LUSTRE_VER 3
 
 #define LUSTRE_COMP_COUNTERS \
     /* component stripe size */\
@@ -41,6 +41,26 @@ enum darshan_lustre_indices
 };
 #undef X
 
+#define LUSTRE_OST_COUNTERS \
+    /* bytes read from the OST */\
+    X(LUSTRE_OST_BYTES_READ) \
+    /* bytes written to the OST */\
+    X(LUSTRE_OST_BYTES_WRITTEN) \
+    /* number of read calls that accessed the OST */\
+    X(LUSTRE_OST_READS) \
+    /* number of write calls that accessed the OST */\
+    X(LUSTRE_OST_WRITES) \
+    /* end of counters */\
+    X(LUSTRE_OST_NUM_INDICES)
+
+#define X(a) a,
+/* integer statistics for Lustre OST traffic records */
+enum darshan_lustre_ost_indices
+{
+    LUSTRE_OST_COUNTERS
+};
+#undef X
+
 /* detailed counters describing parameters of a Lustre file layout component */
 struct darshan_lustre_component
 {
@@ -48,6 +68,15 @@ struct darshan_lustre_component
     char pool_name[16];
 };
 
+/* POSIX read/write traffic served by a single OST. an OST ID of -1 accounts
+ * for traffic to OSTs that are unknown or beyond LUSTRE_OST_TRAFFIC_MAX_OSTS
+ */
+struct darshan_lustre_ost_traffic
+{
+    OST_ID ost_id;
+    int64_t counters[LUSTRE_OST_NUM_INDICES];
+};
+
 /* file record structure for the Lustre module. a record is created and stored for
  * every file opened that belongs to a Lustre file system. This record includes:
  *      - a corresponding record identifier (created by hashing the file path)
@@ -56,6 +85,12 @@ struct darshan_lustre_component
  *      - total number of file stripes instrumented
  *      - detailed counters describing each file layout component (e.g., stripe width, count, etc.)
  *      - list of OST IDs corresponding to instrumented file layout components
+ *
+ * if per-OST traffic accounting is enabled, the module also stores a single
+ * OST traffic record (named LUSTRE_OST_TRAFFIC_REC_NAME) with num_comps set
+ * to LUSTRE_OST_TRAFFIC_COMPS. its num_stripes gives the number of
+ * darshan_lustre_ost_traffic entries that follow in place of the components
+ * and OST list.
  */
 struct darshan_lustre_record
 {
@@ -64,8 +99,14 @@ struct darshan_lustre_record
     int64_t num_stripes;
     struct darshan_lustre_component *comps;
     OST_ID *ost_ids;
+    struct darshan_lustre_ost_traffic *ost_traffic;
 };
 
+#define LUSTRE_OST_TRAFFIC_REC_NAME "lustre:ost-traffic"
+#define LUSTRE_OST_TRAFFIC_COMPS (-1)
+/* highest OST index (exclusive) given its own entry at runtime */
+#define LUSTRE_OST_TRAFFIC_MAX_OSTS 1024
+
 /*
  *  helper macro to calculate the serialized size of a Lustre record
  *  NOTE: this must be kept in sync with the definitions above
@@ -75,4 +116,9 @@ struct darshan_lustre_record
      (sizeof(struct darshan_lustre_component) * (comps)) + \
      (sizeof(OST_ID) * (stripes)))
 
+/* serialized size of an OST traffic record with 'osts' entries */
+#define LUSTRE_OST_TRAFFIC_RECORD_SIZE(osts) \
+     (sizeof(struct darshan_base_record) + (2*sizeof(int64_t)) + \
+     (sizeof(struct darshan_lustre_ost_traffic) * (osts)))
+
 #endif /* __DARSHAN_LUSTRE_LOG_FORMAT_H */
@@ -8,7 +8,7 @@
 #define __DARSHAN_MDHIM_LOG_FORMAT_H
 
 /* current log format version, to support backwards compatibility */
-#define DARSHAN_MDHIM_VER 1
+#define DARSHAN_MDHIM_VER 2
 
 #define MDHIM_COUNTERS \
     /* number of 'put' function calls */\
@@ -21,6 +21,39 @@
     X(MDHIM_GET_MAX_SIZE) \
     /* how many servers? */ \
     X(MDHIM_SERVERS) \
+    /* number of bulk 'put' and 'get' calls, and keys they carried */ \
+    X(MDHIM_BPUTS) \
+    X(MDHIM_BGETS) \
+    X(MDHIM_BPUT_KEYS) \
+    X(MDHIM_BGET_KEYS) \
+    /* histogram of 'put' latencies */ \
+    X(MDHIM_PUT_LAT_0_10US) \
+    X(MDHIM_PUT_LAT_10US_100US) \
+    X(MDHIM_PUT_LAT_100US_1MS) \
+    X(MDHIM_PUT_LAT_1MS_10MS) \
+    X(MDHIM_PUT_LAT_10MS_100MS) \
+    X(MDHIM_PUT_LAT_100MS_1S) \
+    X(MDHIM_PUT_LAT_1S_PLUS) \
+    /* histogram of 'get' latencies */ \
+    X(MDHIM_GET_LAT_0_10US) \
+    X(MDHIM_GET_LAT_10US_100US) \
+    X(MDHIM_GET_LAT_100US_1MS) \
+    X(MDHIM_GET_LAT_1MS_10MS) \
+    X(MDHIM_GET_LAT_10MS_100MS) \
+    X(MDHIM_GET_LAT_100MS_1S) \
+    X(MDHIM_GET_LAT_1S_PLUS) \
+    /* histogram of the number of keys per bulk 'put' */ \
+    X(MDHIM_BPUT_BATCH_1) \
+    X(MDHIM_BPUT_BATCH_2_10) \
+    X(MDHIM_BPUT_BATCH_11_100) \
+    X(MDHIM_BPUT_BATCH_101_1K) \
+    X(MDHIM_BPUT_BATCH_1K_PLUS) \
+    /* histogram of the number of keys per bulk 'get' */ \
+    X(MDHIM_BGET_BATCH_1) \
+    X(MDHIM_BGET_BATCH_2_10) \
+    X(MDHIM_BGET_BATCH_11_100) \
+    X(MDHIM_BGET_BATCH_101_1K) \
+    X(MDHIM_BGET_BATCH_1K_PLUS) \
     /* end of counters */ \
     X(MDHIM_NUM_INDICES)
 
@@ -31,6 +64,11 @@
     /* timer indicating longest (slowest) call to put/get */\
     X(MDHIM_F_PUT_MAX_DURATION) \
     X(MDHIM_F_GET_MAX_DURATION) \
+    /* cumulative time spent in put/get and bulk put/get calls */\
+    X(MDHIM_F_PUT_TIME) \
+    X(MDHIM_F_GET_TIME) \
+    X(MDHIM_F_BPUT_TIME) \
+    X(MDHIM_F_BGET_TIME) \
     /* end of counters */\
     X(MDHIM_F_NUM_INDICES)
 
@@ -66,9 +104,16 @@ struct darshan_mdhim_record
     /* be mindful of struct alignment here:  If one reads "sizeof(struct
      * darshan_mdhim_record)", one might end up reading more than expected.
      * Second read will then end up reading less than needed */
+    /* the operation counts of the servers are followed by as many doubles
+     * holding the time spent in operations sent to each server (the time
+     * of a bulk call is split over its keys), see MDHIM_SERVER_TIMES() */
     int64_t server_histogram[1];
 };
 
 /* '-1' because d_m_r already allocated with space for one */
-#define MDHIM_RECORD_SIZE(servers) (sizeof(struct darshan_mdhim_record) + sizeof(int64_t) * ((servers) - 1) )
+#define MDHIM_RECORD_SIZE(servers) (sizeof(struct darshan_mdhim_record) + sizeof(int64_t) * ((servers) - 1) + sizeof(double) * (servers))
+
+/* per-server time array following the server histogram of a record */
+#define MDHIM_SERVER_TIMES(rec) \
+    ((double *)&((rec)->server_histogram[(rec)->counters[MDHIM_SERVERS]]))
 #endif /* __DARSHAN_MDHIM_LOG_FORMAT_H */
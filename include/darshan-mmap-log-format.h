@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifndef __DARSHAN_MMAP_LOG_FORMAT_H
+#define __DARSHAN_MMAP_LOG_FORMAT_H
+
+/* current MMAP log format version */
+#define DARSHAN_MMAP_VER 1
+
+#define MMAP_COUNTERS \
+    /* count of mappings of the file that were tracked */\
+    X(MMAP_MAPS) \
+    /* count of mappings that were not tracked, because too many were live */\
+    X(MMAP_UNTRACKED_MAPS) \
+    /* count of shared, writable mappings (stores reach the file) */\
+    X(MMAP_WRITE_MAPS) \
+    /* total and largest size of the tracked mappings */\
+    X(MMAP_MAPPED_BYTES) \
+    X(MMAP_MAX_MAPPED_BYTES) \
+    /* page size the residency counters are measured in */\
+    X(MMAP_PAGE_SIZE) \
+    /* count of residency samples taken of the file's mappings */\
+    X(MMAP_SAMPLES) \
+    /* bytes already resident when each mapping was first sampled */\
+    X(MMAP_INITIAL_RESIDENT_BYTES) \
+    /* bytes that became resident while mapped, an estimate of the bytes
+     * faulted in through the mappings */\
+    X(MMAP_FAULTED_BYTES) \
+    /* largest number of bytes of one mapping resident in a sample */\
+    X(MMAP_MAX_RESIDENT_BYTES) \
+    /* newly resident pages that directly follow a page already seen
+     * resident, and those that do not */\
+    X(MMAP_SEQ_PAGES) \
+    X(MMAP_RANDOM_PAGES) \
+    /* count of contiguous extents of pages seen resident, summed over the
+     * mappings when they were last sampled */\
+    X(MMAP_RESIDENT_EXTENTS) \
+    /* end of counters */\
+    X(MMAP_NUM_INDICES)
+
+#define MMAP_F_COUNTERS \
+    /* timestamp of the first mapping */\
+    X(MMAP_F_MAP_START_TIMESTAMP) \
+    /* timestamp of the last sample of a mapping */\
+    X(MMAP_F_SAMPLE_END_TIMESTAMP) \
+    /* cumulative time spent sampling the file's mappings */\
+    X(MMAP_F_SAMPLE_TIME) \
+    /* end of counters */\
+    X(MMAP_F_NUM_INDICES)
+
+#define X(a) a,
+/* integer statistics for MMAP records */
+enum darshan_mmap_indices
+{
+    MMAP_COUNTERS
+};
+
+/* floating point statistics for MMAP records */
+enum darshan_mmap_f_indices
+{
+    MMAP_F_COUNTERS
+};
+#undef X
+
+/* record of statistics for I/O through memory-mapped files.
+ *
+ * There is one record per mapped file, sharing the record id of the
+ * file's POSIX record.  Page residency of each mapping is sampled with
+ * mincore() while the mapping is live, so pages resident because of other
+ * processes or earlier reads of the file are indistinguishable from those
+ * faulted in by this process, other than through the initial sample.
+ */
+struct darshan_mmap_record
+{
+    struct darshan_base_record base_rec;
+    int64_t counters[MMAP_NUM_INDICES];
+    double fcounters[MMAP_F_NUM_INDICES];
+};
+
+#endif /* __DARSHAN_MMAP_LOG_FORMAT_H */
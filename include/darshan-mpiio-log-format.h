@@ -8,7 +8,7 @@
 #define __DARSHAN_MPIIO_LOG_FORMAT_H
 
 /* current MPI-IO log format version */
-#define DARSHAN_MPIIO_VER 3
+#define DARSHAN_MPIIO_VER 4
 
 /* TODO: maybe use a counter to track cases in which a derived datatype is used? */
 
@@ -124,6 +124,17 @@
     /* NOTE: for shared records only */\
     X(MPIIO_F_VARIANCE_RANK_TIME) \
     X(MPIIO_F_VARIANCE_RANK_BYTES) \
+    /* cumulative time spent in collective reads and writes waiting for */\
+    /* the other ranks to enter them, and the remaining actual I/O time */\
+    /* NOTE: only measured if collective wait measurement is enabled */\
+    X(MPIIO_F_COLL_WAIT_TIME) \
+    X(MPIIO_F_COLL_IO_TIME) \
+    /* cumulative time from issuing nonblocking reads and writes to their */\
+    /* completion, and time spent blocked in the MPI_Wait/MPI_Test calls */\
+    /* that completed them */\
+    X(MPIIO_F_NB_READ_TIME) \
+    X(MPIIO_F_NB_WRITE_TIME) \
+    X(MPIIO_F_NB_WAIT_TIME) \
     /* end of counters*/\
     X(MPIIO_F_NUM_INDICES)
 
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifndef __DARSHAN_OVERHEAD_LOG_FORMAT_H
+#define __DARSHAN_OVERHEAD_LOG_FORMAT_H
+
+/* current OVERHEAD log format version */
+#define DARSHAN_OVERHEAD_VER 1
+
+/* name of the record holding darshan-core costs; the record of each
+ * instrumentation module is named OVERHEAD_NAME_PREFIX<module name>
+ */
+#define OVERHEAD_CORE_NAME "overhead:core"
+#define OVERHEAD_NAME_PREFIX "overhead:"
+
+#define OVERHEAD_COUNTERS \
+    /* number of processes whose costs are folded into this record */\
+    X(OVERHEAD_PROCS) \
+    /* one in this many instrumented calls (per thread) is timed */\
+    X(OVERHEAD_SAMPLE_INTERVAL) \
+    /* number of instrumented calls that were timed */\
+    X(OVERHEAD_SAMPLED_CALLS) \
+    /* number of records registered with darshan-core (core record only) */\
+    X(OVERHEAD_REGISTER_CALLS) \
+    /* end of counters */\
+    X(OVERHEAD_NUM_INDICES)
+
+#define OVERHEAD_F_COUNTERS \
+    /* time spent in Darshan's record macros by the timed calls */\
+    X(OVERHEAD_F_SAMPLED_TIME) \
+    /* estimated time spent in Darshan's record macros by all calls */\
+    X(OVERHEAD_F_EST_TIME) \
+    /* largest estimated time of a single process */\
+    X(OVERHEAD_F_MAX_EST_TIME) \
+    /* time to initialize Darshan (core record only) */\
+    X(OVERHEAD_F_INIT_TIME) \
+    /* time the core lock was held registering records, to grow module
+     * memory (core record only) */\
+    X(OVERHEAD_F_REGISTER_LOCK_TIME) \
+    /* time spent shutting down: for a module, its reduction, output and
+     * write; for the core record, all of shutdown up to writing the
+     * OVERHEAD module itself */\
+    X(OVERHEAD_F_SHUTDOWN_TIME) \
+    /* shutdown time spent finding records shared by all processes */\
+    X(OVERHEAD_F_SHARED_RECS_TIME) \
+    /* shutdown time spent compressing log data */\
+    X(OVERHEAD_F_COMPRESS_TIME) \
+    /* shutdown time spent writing module data */\
+    X(OVERHEAD_F_WRITE_TIME) \
+    /* end of counters */\
+    X(OVERHEAD_F_NUM_INDICES)
+
+#define X(a) a,
+/* integer statistics for OVERHEAD records */
+enum darshan_overhead_indices
+{
+    OVERHEAD_COUNTERS
+};
+
+/* floating point statistics for OVERHEAD records */
+enum darshan_overhead_f_indices
+{
+    OVERHEAD_F_COUNTERS
+};
+#undef X
+
+/* record of the cost of Darshan's own instrumentation.
+ *
+ * Each process keeps one record for darshan-core (OVERHEAD_CORE_NAME) and
+ * one per instrumentation module it used.  Records held by every process
+ * are reduced into one: counters and the sampled and estimated times are
+ * summed, while OVERHEAD_F_MAX_EST_TIME and the init, register lock and
+ * shutdown phase times keep the slowest process.  The sampled and estimated
+ * costs of the core record total those of all modules.
+ */
+struct darshan_overhead_record
+{
+    struct darshan_base_record base_rec;
+    int64_t counters[OVERHEAD_NUM_INDICES];
+    double fcounters[OVERHEAD_F_NUM_INDICES];
+};
+
+#endif /* __DARSHAN_OVERHEAD_LOG_FORMAT_H */
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifndef __DARSHAN_PHASE_LOG_FORMAT_H
+#define __DARSHAN_PHASE_LOG_FORMAT_H
+
+/* current PHASE log format version */
+#define DARSHAN_PHASE_VER 1
+
+/* phase records are named by this prefix followed by the name given to
+ * darshan_phase_begin(), or by PHASE_BARRIER_PREFIX and a sequence number
+ * for phases delimited automatically by MPI_Barrier() calls
+ */
+#define PHASE_NAME_PREFIX "phase:"
+#define PHASE_BARRIER_PREFIX "barrier."
+
+#define PHASE_COUNTERS \
+    /* number of processes that entered the phase */\
+    X(PHASE_PROCS) \
+    /* number of times the phase was entered */\
+    X(PHASE_OCCURRENCES) \
+    /* operations and bytes moved through each API while in the phase */\
+    X(PHASE_POSIX_READS) \
+    X(PHASE_POSIX_WRITES) \
+    X(PHASE_POSIX_META_OPS) \
+    X(PHASE_POSIX_BYTES_READ) \
+    X(PHASE_POSIX_BYTES_WRITTEN) \
+    X(PHASE_MPIIO_READS) \
+    X(PHASE_MPIIO_WRITES) \
+    X(PHASE_MPIIO_META_OPS) \
+    X(PHASE_MPIIO_BYTES_READ) \
+    X(PHASE_MPIIO_BYTES_WRITTEN) \
+    X(PHASE_STDIO_READS) \
+    X(PHASE_STDIO_WRITES) \
+    X(PHASE_STDIO_META_OPS) \
+    X(PHASE_STDIO_BYTES_READ) \
+    X(PHASE_STDIO_BYTES_WRITTEN) \
+    /* end of counters */\
+    X(PHASE_NUM_INDICES)
+
+#define PHASE_F_COUNTERS \
+    /* timestamp of the first entry into the phase */\
+    X(PHASE_F_START_TIMESTAMP) \
+    /* timestamp of the last exit from the phase */\
+    X(PHASE_F_END_TIMESTAMP) \
+    /* cumulative time spent in the phase, summed over processes */\
+    X(PHASE_F_TIME) \
+    /* cumulative time spent in the phase by the slowest process */\
+    X(PHASE_F_SLOWEST_RANK_TIME) \
+    /* cumulative time spent in I/O operations of each API while in the
+     * phase */\
+    X(PHASE_F_POSIX_READ_TIME) \
+    X(PHASE_F_POSIX_WRITE_TIME) \
+    X(PHASE_F_POSIX_META_TIME) \
+    X(PHASE_F_MPIIO_READ_TIME) \
+    X(PHASE_F_MPIIO_WRITE_TIME) \
+    X(PHASE_F_MPIIO_META_TIME) \
+    X(PHASE_F_STDIO_READ_TIME) \
+    X(PHASE_F_STDIO_WRITE_TIME) \
+    X(PHASE_F_STDIO_META_TIME) \
+    /* end of counters */\
+    X(PHASE_F_NUM_INDICES)
+
+/* number of counters kept for each API, in the order given above */
+#define PHASE_API_COUNTERS 5
+#define PHASE_API_F_COUNTERS 3
+
+#define X(a) a,
+/* integer statistics for PHASE records */
+enum darshan_phase_indices
+{
+    PHASE_COUNTERS
+};
+
+/* floating point statistics for PHASE records */
+enum darshan_phase_f_indices
+{
+    PHASE_F_COUNTERS
+};
+#undef X
+
+/* record of statistics for an application phase.
+ *
+ * The PHASE module segments the I/O of the POSIX, MPI-IO, and STDIO
+ * modules by the phases the application marks with darshan_phase_begin()
+ * and darshan_phase_end(), or that are delimited every
+ * DARSHAN_PHASE_BARRIERS calls to MPI_Barrier().  Each record accumulates
+ * every occurrence of a phase of the same name; phases may nest, in which
+ * case I/O is accounted to each of the enclosing phases.
+ */
+struct darshan_phase_record
+{
+    struct darshan_base_record base_rec;
+    int64_t counters[PHASE_NUM_INDICES];
+    double fcounters[PHASE_F_NUM_INDICES];
+};
+
+#endif /* __DARSHAN_PHASE_LOG_FORMAT_H */
@@ -8,8 +8,8 @@
 #define __DARSHAN_PNETCDF_LOG_FORMAT_H
 
 /* current PnetCDF log format version */
-#define DARSHAN_PNETCDF_FILE_VER 3
-#define DARSHAN_PNETCDF_VAR_VER 1
+#define DARSHAN_PNETCDF_FILE_VER 4
+#define DARSHAN_PNETCDF_VAR_VER 2
 
 #define PNETCDF_VAR_MAX_NDIMS 5
 
@@ -33,6 +33,18 @@
     X(PNETCDF_FILE_BYTES_WRITTEN) \
     /* count of file wait failures */\
     X(PNETCDF_FILE_WAIT_FAILURES) \
+    /* number of nonblocking requests flushed by file waits */\
+    X(PNETCDF_FILE_WAIT_REQS) \
+    /* total bytes moved by nonblocking requests flushed by file waits */\
+    X(PNETCDF_FILE_WAIT_BYTES) \
+    /* histogram of the number of requests flushed per file wait */\
+    X(PNETCDF_FILE_WAIT_REQS_0) \
+    X(PNETCDF_FILE_WAIT_REQS_1) \
+    X(PNETCDF_FILE_WAIT_REQS_2_4) \
+    X(PNETCDF_FILE_WAIT_REQS_5_16) \
+    X(PNETCDF_FILE_WAIT_REQS_17_64) \
+    X(PNETCDF_FILE_WAIT_REQS_65_256) \
+    X(PNETCDF_FILE_WAIT_REQS_257_PLUS) \
     /* end of counters */\
     X(PNETCDF_FILE_NUM_INDICES)
 
@@ -271,6 +283,10 @@
     /* NOTE: for shared records only */\
     X(PNETCDF_VAR_F_VARIANCE_RANK_TIME) \
     X(PNETCDF_VAR_F_VARIANCE_RANK_BYTES) \
+    /* cumulative time in file waits that flushed nonblocking reads/writes
+     * of this variable */\
+    X(PNETCDF_VAR_F_NB_READ_TIME) \
+    X(PNETCDF_VAR_F_NB_WRITE_TIME) \
     /* end of counters*/\
     X(PNETCDF_VAR_F_NUM_INDICES)
 
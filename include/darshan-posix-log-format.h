@@ -173,6 +173,12 @@ enum darshan_posix_f_indices
  *      - a darshan_base_record structure, which contains the record id & rank
  *      - integer file I/O statistics (open, read/write counts, etc)
  *      - floating point I/O statistics (timestamps, cumulative timers, etc.)
+ *
+ * If the job metadata includes "POSIX_sample_rate=N", only about one in N
+ * reads and writes was sampled: POSIX_F_READ_TIME, POSIX_F_WRITE_TIME and the
+ * POSIX_ACCESS and POSIX_STRIDE counts are estimates scaled from the samples,
+ * and the read/write timestamps and slowest operation fields only reflect
+ * sampled operations.
  */
 struct darshan_posix_file
 {
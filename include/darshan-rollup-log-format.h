@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifndef __DARSHAN_ROLLUP_LOG_FORMAT_H
+#define __DARSHAN_ROLLUP_LOG_FORMAT_H
+
+/* current ROLLUP log format version */
+#define DARSHAN_ROLLUP_VER 1
+
+/* rollup records are named by the directory they collapse files of,
+ * followed by this suffix
+ */
+#define ROLLUP_NAME_SUFFIX "/*"
+
+#define ROLLUP_COUNTERS \
+    /* number of files of the directory that kept records of their own
+     * before further files were collapsed into the rollup */\
+    X(ROLLUP_THRESHOLD) \
+    /* estimated number of distinct files collapsed into the rollup */\
+    X(ROLLUP_FILES) \
+    /* number of closes of collapsed files, and their total and largest
+     * size at close */\
+    X(ROLLUP_CLOSES) \
+    X(ROLLUP_CLOSE_BYTES) \
+    X(ROLLUP_MAX_SIZE) \
+    /* histogram of the sizes of collapsed files at close */\
+    X(ROLLUP_SIZE_0_4K) \
+    X(ROLLUP_SIZE_4K_64K) \
+    X(ROLLUP_SIZE_64K_1M) \
+    X(ROLLUP_SIZE_1M_16M) \
+    X(ROLLUP_SIZE_16M_PLUS) \
+    /* end of counters */\
+    X(ROLLUP_NUM_INDICES)
+
+#define ROLLUP_F_COUNTERS \
+    /* timestamp of the first file collapsed into the rollup */\
+    X(ROLLUP_F_START_TIMESTAMP) \
+    /* timestamp of the last file collapsed into the rollup */\
+    X(ROLLUP_F_END_TIMESTAMP) \
+    /* end of counters */\
+    X(ROLLUP_F_NUM_INDICES)
+
+#define X(a) a,
+/* integer statistics for ROLLUP records */
+enum darshan_rollup_indices
+{
+    ROLLUP_COUNTERS
+};
+
+/* floating point statistics for ROLLUP records */
+enum darshan_rollup_f_indices
+{
+    ROLLUP_F_COUNTERS
+};
+#undef X
+
+/* record of statistics for a directory rollup.
+ *
+ * Once DARSHAN_DIR_ROLLUP_THRESHOLD files of a directory have records of
+ * their own, darshan-core gives any further file of the directory the
+ * record id of the rollup, named by the directory and ROLLUP_NAME_SUFFIX,
+ * so that the records of every other module sum the I/O of all of those
+ * files.  The ROLLUP record
+ * with the same id counts the files that were collapsed.  ROLLUP_FILES is
+ * a HyperLogLog estimate, typically within 7% of the exact count.
+ */
+struct darshan_rollup_record
+{
+    struct darshan_base_record base_rec;
+    int64_t counters[ROLLUP_NUM_INDICES];
+    double fcounters[ROLLUP_F_NUM_INDICES];
+};
+
+#endif /* __DARSHAN_ROLLUP_LOG_FORMAT_H */
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2024 University of Chicago.
+ * See COPYRIGHT notice in top-level directory.
+ *
+ */
+
+#ifndef __DARSHAN_TIMESERIES_LOG_FORMAT_H
+#define __DARSHAN_TIMESERIES_LOG_FORMAT_H
+
+/* current TIMESERIES log format version */
+#define DARSHAN_TIMESERIES_VER 1
+
+/* number of time bins in each series.  Bin i covers the interval
+ * [i * TIMESERIES_F_INTERVAL, (i+1) * TIMESERIES_F_INTERVAL) seconds after
+ * the job started; once a job outlives all of the bins, adjacent bins are
+ * merged and the interval doubles.
+ */
+#define TIMESERIES_NUM_BINS 64
+
+/* names of the records holding the series of each instrumented API */
+#define TIMESERIES_POSIX_NAME "timeseries:POSIX"
+#define TIMESERIES_MPIIO_NAME "timeseries:MPIIO"
+#define TIMESERIES_STDIO_NAME "timeseries:STDIO"
+
+#define TIMESERIES_SERIES(__p) \
+    X(__p##_0) X(__p##_1) X(__p##_2) X(__p##_3) \
+    X(__p##_4) X(__p##_5) X(__p##_6) X(__p##_7) \
+    X(__p##_8) X(__p##_9) X(__p##_10) X(__p##_11) \
+    X(__p##_12) X(__p##_13) X(__p##_14) X(__p##_15) \
+    X(__p##_16) X(__p##_17) X(__p##_18) X(__p##_19) \
+    X(__p##_20) X(__p##_21) X(__p##_22) X(__p##_23) \
+    X(__p##_24) X(__p##_25) X(__p##_26) X(__p##_27) \
+    X(__p##_28) X(__p##_29) X(__p##_30) X(__p##_31) \
+    X(__p##_32) X(__p##_33) X(__p##_34) X(__p##_35) \
+    X(__p##_36) X(__p##_37) X(__p##_38) X(__p##_39) \
+    X(__p##_40) X(__p##_41) X(__p##_42) X(__p##_43) \
+    X(__p##_44) X(__p##_45) X(__p##_46) X(__p##_47) \
+    X(__p##_48) X(__p##_49) X(__p##_50) X(__p##_51) \
+    X(__p##_52) X(__p##_53) X(__p##_54) X(__p##_55) \
+    X(__p##_56) X(__p##_57) X(__p##_58) X(__p##_59) \
+    X(__p##_60) X(__p##_61) X(__p##_62) X(__p##_63)
+
+#define TIMESERIES_COUNTERS \
+    /* number of processes contributing to the series */\
+    X(TIMESERIES_PROCS) \
+    /* bytes read in each interval */\
+    TIMESERIES_SERIES(TIMESERIES_BYTES_READ) \
+    /* bytes written in each interval */\
+    TIMESERIES_SERIES(TIMESERIES_BYTES_WRITTEN) \
+    /* read operations completed in each interval */\
+    TIMESERIES_SERIES(TIMESERIES_READS) \
+    /* write operations completed in each interval */\
+    TIMESERIES_SERIES(TIMESERIES_WRITES) \
+    /* open, stat, flush and close operations completed in each interval */\
+    TIMESERIES_SERIES(TIMESERIES_META_OPS) \
+    /* end of counters */\
+    X(TIMESERIES_NUM_INDICES)
+
+#define TIMESERIES_F_COUNTERS \
+    /* width of each interval, in seconds */\
+    X(TIMESERIES_F_INTERVAL) \
+    /* time spent in reads completed in each interval */\
+    TIMESERIES_SERIES(TIMESERIES_F_READ_TIME) \
+    /* time spent in writes completed in each interval */\
+    TIMESERIES_SERIES(TIMESERIES_F_WRITE_TIME) \
+    /* time spent in metadata operations completed in each interval */\
+    TIMESERIES_SERIES(TIMESERIES_F_META_TIME) \
+    /* end of counters */\
+    X(TIMESERIES_F_NUM_INDICES)
+
+#define X(a) a,
+/* integer statistics for TIMESERIES records */
+enum darshan_timeseries_indices
+{
+    TIMESERIES_COUNTERS
+};
+
+/* floating point statistics for TIMESERIES records */
+enum darshan_timeseries_f_indices
+{
+    TIMESERIES_F_COUNTERS
+};
+#undef X
+
+/* record of the I/O activity of one API over the lifetime of the job.
+ *
+ * Each operation is accounted, in full, to the interval in which it
+ * completed.  Records of different processes are reduced by bringing them
+ * to the widest interval and summing them bin by bin.
+ */
+struct darshan_timeseries_record
+{
+    struct darshan_base_record base_rec;
+    int64_t counters[TIMESERIES_NUM_INDICES];
+    double fcounters[TIMESERIES_F_NUM_INDICES];
+};
+
+#endif /* __DARSHAN_TIMESERIES_LOG_FORMAT_H */